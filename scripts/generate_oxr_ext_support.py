@@ -58,8 +58,10 @@ EXTENSIONS = (
     ['XR_EXT_hand_tracking'],
     ['XR_EXT_hp_mixed_reality_controller'],
     ['XR_EXT_palm_pose', 'ALWAYS_DISABLED'],
+    ['XR_EXT_performance_settings'],
     ['XR_EXT_samsung_odyssey_controller'],
     ['XR_FB_display_refresh_rate'],
+    ['XR_META_performance_metrics'],
     ['XR_ML_ml2_controller_interaction'],
     ['XR_MND_headless'],
     ['XR_MND_swapchain_usage_input_attachment_bit'],
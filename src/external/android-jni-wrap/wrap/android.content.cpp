@@ -20,6 +20,7 @@ Context::Meta::Meta(bool deferDrop)
           classRef().getMethod("getClassLoader", "()Ljava/lang/ClassLoader;")),
       getExternalFilesDir(classRef().getMethod(
           "getExternalFilesDir", "(Ljava/lang/String;)Ljava/io/File;")),
+      getCacheDir(classRef().getMethod("getCacheDir", "()Ljava/io/File;")),
       startActivity(
           classRef().getMethod("startActivity", "(Landroid/content/Intent;)V")),
       startActivity1(classRef().getMethod(
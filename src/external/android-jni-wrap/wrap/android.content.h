@@ -136,6 +136,17 @@ class Context : public ObjectWrapperBase {
      */
     java::io::File getExternalFilesDir(std::string const &type);
 
+    /*!
+     * Wrapper for the getCacheDir method
+     *
+     * Java prototype:
+     * `public abstract java.io.File getCacheDir();`
+     *
+     * JNI signature: ()Ljava/io/File;
+     *
+     */
+    java::io::File getCacheDir();
+
     /*!
      * Wrapper for the startActivity method
      *
@@ -211,6 +222,7 @@ class Context : public ObjectWrapperBase {
         jni::method_t getApplicationContext;
         jni::method_t getClassLoader;
         jni::method_t getExternalFilesDir;
+        jni::method_t getCacheDir;
         jni::method_t startActivity;
         jni::method_t startActivity1;
         jni::method_t getSystemService;
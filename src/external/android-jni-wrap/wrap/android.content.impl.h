@@ -60,6 +60,11 @@ inline java::io::File Context::getExternalFilesDir(std::string const &type) {
         object().call<jni::Object>(Meta::data().getExternalFilesDir, type));
 }
 
+inline java::io::File Context::getCacheDir() {
+    assert(!isNull());
+    return java::io::File(object().call<jni::Object>(Meta::data().getCacheDir));
+}
+
 inline void Context::startActivity(Intent const &intent) {
     assert(!isNull());
     return object().call<void>(Meta::data().startActivity, intent.object());
@@ -19,6 +19,11 @@
 #ifdef XRT_GRAPHICS_BUFFER_HANDLE_IS_AHARDWAREBUFFER
 #include <android/hardware_buffer.h>
 
+#include <pthread.h>
+
+//! Most buffers kept around for reuse, the memory cap is usually hit first.
+#define POOL_MAX_ENTRIES (32)
+
 DEBUG_GET_ONCE_LOG_OPTION(ahardwarebuffer_log, "AHARDWAREBUFFER_LOG", U_LOGGING_WARN)
 #define AHB_TRACE(...) U_LOG_IFL_T(debug_get_log_option_ahardwarebuffer_log(), __VA_ARGS__)
 #define AHB_DEBUG(...) U_LOG_IFL_D(debug_get_log_option_ahardwarebuffer_log(), __VA_ARGS__)
@@ -26,6 +31,185 @@ DEBUG_GET_ONCE_LOG_OPTION(ahardwarebuffer_log, "AHARDWAREBUFFER_LOG", U_LOGGING_
 #define AHB_WARN(...) U_LOG_IFL_W(debug_get_log_option_ahardwarebuffer_log(), __VA_ARGS__)
 #define AHB_ERROR(...) U_LOG_IFL_E(debug_get_log_option_ahardwarebuffer_log(), __VA_ARGS__)
 
+DEBUG_GET_ONCE_NUM_OPTION(ahardwarebuffer_pool_mb, "AHARDWAREBUFFER_POOL_MB", 128)
+
+/*!
+ * A released buffer waiting to be handed out again.
+ */
+struct pool_entry
+{
+	AHardwareBuffer_Desc desc;
+	AHardwareBuffer *buffer;
+	uint64_t size;
+};
+
+/*!
+ * Process wide pool of released buffers, oldest first. In the service every
+ * client session allocates from the same pool.
+ */
+static struct
+{
+	pthread_mutex_t mutex;
+	struct pool_entry entries[POOL_MAX_ENTRIES];
+	uint32_t count;
+	uint64_t total_size;
+} g_pool = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+
+
+/*
+ *
+ * Pool functions.
+ *
+ */
+
+static uint32_t
+bytes_per_pixel(uint32_t format)
+{
+	switch (format) {
+	case AHARDWAREBUFFER_FORMAT_R16G16B16A16_FLOAT: return 8;
+	case AHARDWAREBUFFER_FORMAT_D32_FLOAT_S8_UINT: return 8;
+	case AHARDWAREBUFFER_FORMAT_R8G8B8_UNORM: return 3;
+	case AHARDWAREBUFFER_FORMAT_R5G6B5_UNORM:
+	case AHARDWAREBUFFER_FORMAT_D16_UNORM: return 2;
+	case AHARDWAREBUFFER_FORMAT_S8_UINT: return 1;
+	default: return 4;
+	}
+}
+
+static bool
+desc_matches(const AHardwareBuffer_Desc *a, const AHardwareBuffer_Desc *b)
+{
+	return a->width == b->width &&   //
+	       a->height == b->height && //
+	       a->layers == b->layers && //
+	       a->format == b->format && //
+	       a->usage == b->usage;
+}
+
+static uint64_t
+pool_get_max_size(void)
+{
+	int64_t mb = debug_get_num_option_ahardwarebuffer_pool_mb();
+	return mb > 0 ? (uint64_t)mb * 1024 * 1024 : 0;
+}
+
+//! Removes entry @p index, returning the buffer, must be called with the lock held.
+static AHardwareBuffer *
+pool_remove_locked(uint32_t index)
+{
+	AHardwareBuffer *buffer = g_pool.entries[index].buffer;
+	g_pool.total_size -= g_pool.entries[index].size;
+	g_pool.count--;
+
+	memmove(&g_pool.entries[index], &g_pool.entries[index + 1],
+	        sizeof(g_pool.entries[0]) * (g_pool.count - index));
+
+	return buffer;
+}
+
+//! Frees the oldest buffers until @p max_size bytes or less are pooled.
+static void
+pool_trim_to(uint64_t max_size)
+{
+	AHardwareBuffer *to_free[POOL_MAX_ENTRIES];
+	uint32_t free_count = 0;
+
+	pthread_mutex_lock(&g_pool.mutex);
+	while (g_pool.count > 0 && g_pool.total_size > max_size) {
+		to_free[free_count++] = pool_remove_locked(0);
+	}
+	pthread_mutex_unlock(&g_pool.mutex);
+
+	// Releasing can take a while, don't hold up the other threads.
+	for (uint32_t i = 0; i < free_count; i++) {
+		u_graphics_buffer_unref(&to_free[i]);
+	}
+
+	if (free_count > 0) {
+		AHB_DEBUG("Freed %u pooled buffers", free_count);
+	}
+}
+
+static AHardwareBuffer *
+pool_take(const AHardwareBuffer_Desc *desc)
+{
+	AHardwareBuffer *buffer = NULL;
+
+	pthread_mutex_lock(&g_pool.mutex);
+
+	// Newest first, it's the most likely to still be warm.
+	for (uint32_t i = g_pool.count; i > 0; i--) {
+		if (desc_matches(&g_pool.entries[i - 1].desc, desc)) {
+			buffer = pool_remove_locked(i - 1);
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&g_pool.mutex);
+
+	return buffer;
+}
+
+static void
+pool_put(AHardwareBuffer **buffer_ptr)
+{
+	AHardwareBuffer *buffer = *buffer_ptr;
+	if (buffer == NULL) {
+		return;
+	}
+	*buffer_ptr = NULL;
+
+	struct pool_entry entry = {.buffer = buffer};
+	AHardwareBuffer_describe(buffer, &entry.desc);
+	entry.size = (uint64_t)entry.desc.stride * entry.desc.height * entry.desc.layers *
+	             bytes_per_pixel(entry.desc.format);
+
+	uint64_t max_size = pool_get_max_size();
+	if (entry.size > max_size) {
+		u_graphics_buffer_unref(&buffer);
+		return;
+	}
+
+	AHardwareBuffer *evicted[POOL_MAX_ENTRIES];
+	uint32_t evicted_count = 0;
+
+	pthread_mutex_lock(&g_pool.mutex);
+	while (g_pool.count > 0 &&
+	       (g_pool.count >= POOL_MAX_ENTRIES || g_pool.total_size + entry.size > max_size)) {
+		evicted[evicted_count++] = pool_remove_locked(0);
+	}
+
+	g_pool.entries[g_pool.count++] = entry;
+	g_pool.total_size += entry.size;
+	pthread_mutex_unlock(&g_pool.mutex);
+
+	for (uint32_t i = 0; i < evicted_count; i++) {
+		u_graphics_buffer_unref(&evicted[i]);
+	}
+}
+
+static int
+allocate_buffer(const AHardwareBuffer_Desc *desc, AHardwareBuffer **out_buffer)
+{
+	AHardwareBuffer *buffer = pool_take(desc);
+	if (buffer != NULL) {
+		AHB_TRACE("Reusing pooled buffer %ux%u", desc->width, desc->height);
+		*out_buffer = buffer;
+		return 0;
+	}
+
+	return AHardwareBuffer_allocate(desc, out_buffer);
+}
+
+
+/*
+ *
+ * Allocator functions.
+ *
+ */
+
 static inline enum AHardwareBuffer_Format
 vk_format_to_ahardwarebuffer(uint64_t format)
 {
@@ -88,7 +272,7 @@ ahardwarebuffer_image_allocate(const struct xrt_swapchain_create_info *xsci, xrt
 	}
 #endif
 
-	int ret = AHardwareBuffer_allocate(&desc, out_image);
+	int ret = allocate_buffer(&desc, out_image);
 	if (ret != 0) {
 		AHB_ERROR("Failed allocating image.");
 		return XRT_ERROR_ALLOCATION;
@@ -137,7 +321,7 @@ ahardwarebuffer_images_allocate(struct xrt_image_native_allocator *xina,
 	memset(out_images, 0, sizeof(*out_images) * image_count);
 	bool failed = false;
 	for (size_t i = 0; i < image_count; ++i) {
-		int ret = AHardwareBuffer_allocate(&desc, &(out_images[i].handle));
+		int ret = allocate_buffer(&desc, &(out_images[i].handle));
 		if (ret != 0) {
 			AHB_ERROR("Failed allocating image %d.", (int)i);
 			failed = true;
@@ -146,7 +330,7 @@ ahardwarebuffer_images_allocate(struct xrt_image_native_allocator *xina,
 	}
 	if (failed) {
 		for (size_t i = 0; i < image_count; ++i) {
-			u_graphics_buffer_unref(&(out_images[i].handle));
+			pool_put(&(out_images[i].handle));
 		}
 		return XRT_ERROR_ALLOCATION;
 	}
@@ -159,10 +343,11 @@ ahardwarebuffer_images_free(struct xrt_image_native_allocator *xina,
                             struct xrt_image_native *images)
 {
 	for (size_t i = 0; i < image_count; ++i) {
-		u_graphics_buffer_unref(&(images[i].handle));
+		pool_put(&(images[i].handle));
 	}
 	return XRT_SUCCESS;
 }
+
 static void
 ahardwarebuffer_destroy(struct xrt_image_native_allocator *xina)
 {
@@ -171,6 +356,65 @@ ahardwarebuffer_destroy(struct xrt_image_native_allocator *xina)
 	}
 }
 
+xrt_result_t
+ahardwarebuffer_image_allocate_scanout(const struct xrt_swapchain_create_info *xsci,
+                                       xrt_graphics_buffer_handle_t *out_image)
+{
+	AHardwareBuffer_Desc desc;
+	U_ZERO(&desc);
+	enum AHardwareBuffer_Format ahb_format = vk_format_to_ahardwarebuffer(xsci->format);
+	if (ahb_format == 0) {
+		AHB_ERROR("Could not convert %04" PRIx64 " to AHardwareBuffer_Format!", (uint64_t)xsci->format);
+		return XRT_ERROR_ALLOCATION;
+	}
+	desc.height = xsci->height;
+	desc.width = xsci->width;
+	desc.format = ahb_format;
+	desc.layers = 1;
+
+	// Rendered to and sampled by the compositor, then scanned out by the display hardware.
+	desc.usage = AHARDWAREBUFFER_USAGE_GPU_FRAMEBUFFER | //
+	             AHARDWAREBUFFER_USAGE_GPU_SAMPLED_IMAGE | //
+	             AHARDWAREBUFFER_USAGE_COMPOSER_OVERLAY;
+	if (0 != (xsci->create & XRT_SWAPCHAIN_CREATE_PROTECTED_CONTENT)) {
+		desc.usage |= AHARDWAREBUFFER_USAGE_PROTECTED_CONTENT;
+	}
+
+#if __ANDROID_API__ >= 29
+	if (0 == AHardwareBuffer_isSupported(&desc)) {
+		AHB_ERROR("Computed scanout AHardwareBuffer_Desc is not supported.");
+		return XRT_ERROR_ALLOCATION;
+	}
+#endif
+
+	// Not from the pool, the composer usage never matches a swapchain buffer.
+	if (AHardwareBuffer_allocate(&desc, out_image) != 0) {
+		AHB_ERROR("Failed allocating scanout image.");
+		return XRT_ERROR_ALLOCATION;
+	}
+
+	return XRT_SUCCESS;
+}
+
+void
+ahardwarebuffer_image_release(xrt_graphics_buffer_handle_t *handle)
+{
+	pool_put(handle);
+}
+
+void
+android_ahardwarebuffer_pool_trim(bool release_all)
+{
+	uint64_t max_size = 0;
+	if (!release_all) {
+		pthread_mutex_lock(&g_pool.mutex);
+		max_size = g_pool.total_size / 2;
+		pthread_mutex_unlock(&g_pool.mutex);
+	}
+
+	pool_trim_to(max_size);
+}
+
 struct xrt_image_native_allocator *
 android_ahardwarebuffer_allocator_create()
 {
@@ -19,12 +19,45 @@ extern "C" {
 
 #ifdef XRT_GRAPHICS_BUFFER_HANDLE_IS_AHARDWAREBUFFER
 
+/*!
+ * Creates an allocator that recycles freed images through a process wide pool
+ * keyed on size, format and usage, so swapchain churn doesn't have to wait on
+ * the gralloc allocator. The pool is capped at `AHARDWAREBUFFER_POOL_MB`
+ * megabytes, set it to zero to disable pooling.
+ */
 struct xrt_image_native_allocator *
 android_ahardwarebuffer_allocator_create();
 
+/*!
+ * Allocates a single buffer for @p xsci, reusing a pooled one if possible.
+ * Return it with @ref ahardwarebuffer_image_release.
+ */
 xrt_result_t
 ahardwarebuffer_image_allocate(const struct xrt_swapchain_create_info *xsci, xrt_graphics_buffer_handle_t *out_image);
 
+/*!
+ * Allocates a single buffer for @p xsci that SurfaceFlinger can also put on a
+ * hardware overlay and scan out directly. These are never pooled, free it
+ * with `AHardwareBuffer_release`.
+ */
+xrt_result_t
+ahardwarebuffer_image_allocate_scanout(const struct xrt_swapchain_create_info *xsci,
+                                       xrt_graphics_buffer_handle_t *out_image);
+
+/*!
+ * Gives the buffer back to the pool, or frees it if it doesn't fit, and sets
+ * @p handle to NULL. The contents are not cleared.
+ */
+void
+ahardwarebuffer_image_release(xrt_graphics_buffer_handle_t *handle);
+
+/*!
+ * Frees pooled buffers in response to memory pressure, the oldest half of the
+ * pool or all of it if @p release_all is set.
+ */
+void
+android_ahardwarebuffer_pool_trim(bool release_all);
+
 #endif // XRT_GRAPHICS_BUFFER_HANDLE_IS_AHARDWAREBUFFER
 
 #ifdef __cplusplus
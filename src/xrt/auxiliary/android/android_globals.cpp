@@ -9,8 +9,13 @@
 
 #include "android_globals.h"
 
+#include "util/u_logging.h"
+
 #include <stddef.h>
+#include <stdio.h>
 #include <wrap/android.app.h>
+#include <wrap/android.content.h>
+#include <wrap/java.io.h>
 
 /*!
  * @todo Do we need locking here?
@@ -81,3 +86,22 @@ android_globals_get_context()
 	return android_globals.context.isNull() ? android_globals.activity.getHandle()
 	                                        : android_globals.context.getHandle();
 }
+
+ssize_t
+android_globals_get_cache_dir(char *out_path, size_t out_path_size)
+{
+	jobject context = (jobject)android_globals_get_context();
+	if (context == nullptr) {
+		return -1;
+	}
+
+	try {
+		wrap::android::content::Context ctx{jni::Object(context)};
+		std::string path = ctx.getCacheDir().getAbsolutePath();
+
+		return snprintf(out_path, out_path_size, "%s", path.c_str());
+	} catch (std::exception const &e) {
+		U_LOG_E("Could not get cache dir: %s", e.what());
+		return -1;
+	}
+}
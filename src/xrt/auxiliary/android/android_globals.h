@@ -11,6 +11,9 @@
 
 #include <xrt/xrt_config_os.h>
 
+#include <stddef.h>
+#include <sys/types.h>
+
 #ifdef XRT_OS_ANDROID
 
 #ifdef __cplusplus
@@ -68,6 +71,13 @@ android_globals_get_activity();
 void *
 android_globals_get_context();
 
+/*!
+ * Get the absolute path of the cache directory of the stored context, returns
+ * the length of the path or negative on failure.
+ */
+ssize_t
+android_globals_get_cache_dir(char *out_path, size_t out_path_size);
+
 
 void
 android_globals_store_window(struct _ANativeWindow *window);
@@ -13,6 +13,7 @@
 
 #include <gst/app/gstappsink.h>
 #include <gst/app/gstappsrc.h>
+#include <gst/video/video-format.h>
 
 
 #ifdef __cplusplus
@@ -72,6 +73,12 @@ struct gstreamer_sink
 
 	//! Cached appsrc element.
 	GstElement *appsrc;
+
+	//! Allocator wrapping DMA-BUF fds, only on sinks created for DMA-BUFs.
+	GstAllocator *dmabuf_allocator;
+
+	//! Format of the pushed DMA-BUFs.
+	GstVideoFormat dmabuf_format;
 };
 
 
@@ -14,12 +14,18 @@
 #include "util/u_debug.h"
 #include "util/u_format.h"
 
+#include "xrt/xrt_config_os.h"
+
 #include "gstreamer/gst_sink.h"
 #include "gstreamer/gst_pipeline.h"
 #include "gstreamer/gst_internal.h"
 #include "gst/video/video-format.h"
 #include "gst/video/gstvideometa.h"
 
+#ifdef XRT_OS_LINUX
+#include "gst/allocators/gstdmabuf.h"
+#endif
+
 #include <assert.h>
 
 
@@ -66,6 +72,28 @@ complain_if_wrong_image_size(struct xrt_frame *xf)
 	}
 }
 
+static void
+set_timestamps_and_push(struct gstreamer_sink *gs, GstBuffer *buffer, uint64_t xtimestamp_ns)
+{
+	// Use the first frame as offset.
+	if (gs->offset_ns == 0) {
+		gs->offset_ns = xtimestamp_ns;
+	}
+
+	// Need to be offset or gstreamer becomes sad.
+	GST_BUFFER_PTS(buffer) = xtimestamp_ns - gs->offset_ns;
+
+	// Duration is measured from last time stamp.
+	GST_BUFFER_DURATION(buffer) = xtimestamp_ns - gs->timestamp_ns;
+	gs->timestamp_ns = xtimestamp_ns;
+
+	// All done, send it to the gstreamer pipeline.
+	GstFlowReturn ret = gst_app_src_push_buffer((GstAppSrc *)gs->appsrc, buffer);
+	if (ret != GST_FLOW_OK) {
+		U_LOG_E("Got GST error '%i'", ret);
+	}
+}
+
 static void
 push_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
 {
@@ -75,7 +103,6 @@ push_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
 	complain_if_wrong_image_size(xf);
 
 	GstBuffer *buffer;
-	GstFlowReturn ret;
 
 	U_LOG_T(
 	    "Called"
@@ -105,27 +132,28 @@ push_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
 	gst_buffer_add_video_meta_full(buffer, GST_VIDEO_FRAME_FLAG_NONE, gst_fmt_from_xf_format(xf->format), xf->width,
 	                               xf->height, 1, offsets, strides);
 
-	//! Get the timestampe from the frame.
-	uint64_t xtimestamp_ns = xf->timestamp;
+	// Timestamp from the frame.
+	set_timestamps_and_push(gs, buffer, xf->timestamp);
+}
 
-	// Use the first frame as offset.
-	if (gs->offset_ns == 0) {
-		gs->offset_ns = xtimestamp_ns;
-	}
+#ifdef XRT_OS_LINUX
+struct dmabuf_release
+{
+	gstreamer_sink_release_func_t func;
+	void *user_data;
+};
 
-	// Need to be offset or gstreamer becomes sad.
-	GST_BUFFER_PTS(buffer) = xtimestamp_ns - gs->offset_ns;
+static void
+dmabuf_buffer_released(gpointer data, GstMiniObject *obj)
+{
+	struct dmabuf_release *release = (struct dmabuf_release *)data;
 
-	// Duration is measured from last time stamp.
-	GST_BUFFER_DURATION(buffer) = xtimestamp_ns - gs->timestamp_ns;
-	gs->timestamp_ns = xtimestamp_ns;
+	U_LOG_T("Called");
 
-	// All done, send it to the gstreamer pipeline.
-	ret = gst_app_src_push_buffer((GstAppSrc *)gs->appsrc, buffer);
-	if (ret != GST_FLOW_OK) {
-		U_LOG_E("Got GST error '%i'", ret);
-	}
+	release->func(release->user_data);
+	free(release);
 }
+#endif
 
 static void
 enough_data(GstElement *appsrc, gpointer udata)
@@ -160,9 +188,41 @@ destroy(struct xrt_frame_node *node)
 	 * be called, it's now safe to destroy and free ourselves.
 	 */
 
+	if (gs->dmabuf_allocator != NULL) {
+		gst_object_unref(gs->dmabuf_allocator);
+		gs->dmabuf_allocator = NULL;
+	}
+
 	free(gs);
 }
 
+static struct gstreamer_sink *
+create_sink(struct gstreamer_pipeline *gp, const char *appsrc_name, GstCaps *caps)
+{
+	struct gstreamer_sink *gs = U_TYPED_CALLOC(struct gstreamer_sink);
+	gs->node.break_apart = break_apart;
+	gs->node.destroy = destroy;
+	gs->gp = gp;
+	gs->appsrc = gst_bin_get_by_name(GST_BIN(gp->pipeline), appsrc_name);
+
+	g_object_set(G_OBJECT(gs->appsrc),                      //
+	             "caps", caps,                              //
+	             "stream-type", GST_APP_STREAM_TYPE_STREAM, //
+	             "format", GST_FORMAT_TIME,                 //
+	             "is-live", TRUE,                           //
+	             NULL);
+
+	g_signal_connect(G_OBJECT(gs->appsrc), "enough-data", G_CALLBACK(enough_data), gs);
+
+	/*
+	 * Add ourselves to the context so we are destroyed.
+	 * This is done once we know everything is completed.
+	 */
+	xrt_frame_context_add(gp->xfctx, &gs->node);
+
+	return gs;
+}
+
 
 /*
  *
@@ -201,37 +261,102 @@ gstreamer_sink_create_with_pipeline(struct gstreamer_pipeline *gp,
 	default: assert(false); break;
 	}
 
-	struct gstreamer_sink *gs = U_TYPED_CALLOC(struct gstreamer_sink);
+	GstCaps *caps = gst_caps_new_simple(      //
+	    "video/x-raw",                        //
+	    "format", G_TYPE_STRING, format_str,  //
+	    "width", G_TYPE_INT, width,           //
+	    "height", G_TYPE_INT, height,         //
+	    "framerate", GST_TYPE_FRACTION, 0, 1, //
+	    NULL);
+
+	struct gstreamer_sink *gs = create_sink(gp, appsrc_name, caps);
 	gs->base.push_frame = push_frame;
-	gs->node.break_apart = break_apart;
-	gs->node.destroy = destroy;
-	gs->gp = gp;
-	gs->appsrc = gst_bin_get_by_name(GST_BIN(gp->pipeline), appsrc_name);
 
+	*out_gs = gs;
+	*out_xfs = &gs->base;
+}
+
+#ifdef XRT_OS_LINUX
+void
+gstreamer_sink_create_dmabuf_with_pipeline(struct gstreamer_pipeline *gp,
+                                           uint32_t width,
+                                           uint32_t height,
+                                           const char *gst_format,
+                                           const char *appsrc_name,
+                                           struct gstreamer_sink **out_gs)
+{
+	GstElement *appsrc = NULL;
+	if (gp->pipeline != NULL) {
+		appsrc = gst_bin_get_by_name(GST_BIN(gp->pipeline), appsrc_name);
+	}
+	if (appsrc == NULL) {
+		U_LOG_E("No appsrc named '%s' in the pipeline!", appsrc_name);
+		*out_gs = NULL;
+		return;
+	}
+	gst_object_unref(appsrc);
 
 	GstCaps *caps = gst_caps_new_simple(      //
 	    "video/x-raw",                        //
-	    "format", G_TYPE_STRING, format_str,  //
+	    "format", G_TYPE_STRING, gst_format,  //
 	    "width", G_TYPE_INT, width,           //
 	    "height", G_TYPE_INT, height,         //
 	    "framerate", GST_TYPE_FRACTION, 0, 1, //
 	    NULL);
 
-	g_object_set(G_OBJECT(gs->appsrc),                      //
-	             "caps", caps,                              //
-	             "stream-type", GST_APP_STREAM_TYPE_STREAM, //
-	             "format", GST_FORMAT_TIME,                 //
-	             "is-live", TRUE,                           //
-	             NULL);
-
-	g_signal_connect(G_OBJECT(gs->appsrc), "enough-data", G_CALLBACK(enough_data), gs);
+	// Elements like vaapi and va import the buffers directly with this.
+	gst_caps_set_features(caps, 0, gst_caps_features_new(GST_CAPS_FEATURE_MEMORY_DMABUF, NULL));
 
-	/*
-	 * Add ourselves to the context so we are destroyed.
-	 * This is done once we know everything is completed.
-	 */
-	xrt_frame_context_add(gp->xfctx, &gs->node);
+	struct gstreamer_sink *gs = create_sink(gp, appsrc_name, caps);
+	gs->dmabuf_allocator = gst_dmabuf_allocator_new();
+	gs->dmabuf_format = gst_video_format_from_string(gst_format);
 
 	*out_gs = gs;
-	*out_xfs = &gs->base;
 }
+
+bool
+gstreamer_sink_push_dmabuf(struct gstreamer_sink *gs,
+                           int fd,
+                           size_t size,
+                           size_t offset,
+                           uint32_t width,
+                           uint32_t height,
+                           uint32_t stride,
+                           uint64_t timestamp_ns,
+                           gstreamer_sink_release_func_t release_func,
+                           void *user_data)
+{
+	SINK_TRACE_MARKER();
+
+	assert(gs->dmabuf_allocator != NULL);
+
+	// The caller owns the fd, keep it open when the memory is freed.
+	GstMemory *mem = gst_dmabuf_allocator_alloc_with_flags( //
+	    gs->dmabuf_allocator,                               //
+	    fd,                                                 //
+	    size,                                               //
+	    GST_FD_MEMORY_FLAG_DONT_CLOSE);                     //
+	if (mem == NULL) {
+		U_LOG_E("gst_dmabuf_allocator_alloc_with_flags failed!");
+		return false;
+	}
+
+	GstBuffer *buffer = gst_buffer_new();
+	gst_buffer_append_memory(buffer, mem);
+
+	gsize offsets[4] = {offset, 0, 0, 0};
+	gint strides[4] = {(gint)stride, 0, 0, 0};
+	gst_buffer_add_video_meta_full(buffer, GST_VIDEO_FRAME_FLAG_NONE, gs->dmabuf_format, width, height, 1,
+	                               offsets, strides);
+
+	// Called once the pipeline is done with the buffer.
+	struct dmabuf_release *release = U_TYPED_CALLOC(struct dmabuf_release);
+	release->func = release_func;
+	release->user_data = user_data;
+	gst_mini_object_weak_ref(GST_MINI_OBJECT(buffer), dmabuf_buffer_released, release);
+
+	set_timestamps_and_push(gs, buffer, timestamp_ns);
+
+	return true;
+}
+#endif
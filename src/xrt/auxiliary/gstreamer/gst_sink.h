@@ -10,6 +10,7 @@
 #pragma once
 
 #include "xrt/xrt_frame.h"
+#include "xrt/xrt_config_os.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -34,6 +35,46 @@ gstreamer_sink_create_with_pipeline(struct gstreamer_pipeline *gp,
                                     struct gstreamer_sink **out_gs,
                                     struct xrt_frame_sink **out_xfs);
 
+#ifdef XRT_OS_LINUX
+
+/*!
+ * Called when the pipeline no longer uses a pushed DMA-BUF.
+ */
+typedef void (*gstreamer_sink_release_func_t)(void *user_data);
+
+/*!
+ * Create a sink that takes DMA-BUFs instead of @ref xrt_frame, the appsrc
+ * caps get the `memory:DMABuf` feature so encoders can import the buffers
+ * without any copy. The @p gst_format is a GStreamer format string like "BGRx".
+ * Sets @p out_gs to NULL if the pipeline failed to parse or has no such appsrc.
+ */
+void
+gstreamer_sink_create_dmabuf_with_pipeline(struct gstreamer_pipeline *gp,
+                                           uint32_t width,
+                                           uint32_t height,
+                                           const char *gst_format,
+                                           const char *appsrc_name,
+                                           struct gstreamer_sink **out_gs);
+
+/*!
+ * Push a single plane DMA-BUF, the caller keeps ownership of @p fd and must
+ * not write to the buffer until @p release_func has been called, it may be
+ * called from any thread.
+ */
+bool
+gstreamer_sink_push_dmabuf(struct gstreamer_sink *gs,
+                           int fd,
+                           size_t size,
+                           size_t offset,
+                           uint32_t width,
+                           uint32_t height,
+                           uint32_t stride,
+                           uint64_t timestamp_ns,
+                           gstreamer_sink_release_func_t release_func,
+                           void *user_data);
+
+#endif // XRT_OS_LINUX
+
 
 #ifdef __cplusplus
 }
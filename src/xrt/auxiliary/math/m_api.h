@@ -304,6 +304,23 @@ math_quat_ensure_normalized(struct xrt_quat *inout);
 void
 math_quat_rotate_vec3(const struct xrt_quat *left, const struct xrt_vec3 *right, struct xrt_vec3 *result);
 
+/*!
+ * Rotate @p count vectors by the same quaternion, batched version of
+ * @ref math_quat_rotate_vec3. The rotation is only converted once and the
+ * vectors are processed in chunks, so this is much faster for many vectors.
+ *
+ * OK if input and output are the same addresses.
+ *
+ * @relates xrt_quat
+ * @see xrt_vec3
+ * @ingroup aux_math
+ */
+void
+math_quat_rotate_vec3_many(const struct xrt_quat *left,
+                           const struct xrt_vec3 *in_vecs,
+                           struct xrt_vec3 *out_vecs,
+                           uint32_t count);
+
 /*!
  * Rotate a quaternion (compose rotations).
  *
@@ -725,6 +742,37 @@ math_pose_transform(const struct xrt_pose *transform, const struct xrt_pose *pos
 void
 math_pose_transform_point(const struct xrt_pose *transform, const struct xrt_vec3 *point, struct xrt_vec3 *out_point);
 
+/*!
+ * Apply a rigid-body transformation to @p count poses, batched version of
+ * @ref math_pose_transform.
+ *
+ * OK if input and output are the same addresses.
+ *
+ * @relates xrt_pose
+ * @ingroup aux_math
+ */
+void
+math_pose_transform_many(const struct xrt_pose *transform,
+                         const struct xrt_pose *in_poses,
+                         struct xrt_pose *out_poses,
+                         uint32_t count);
+
+/*!
+ * Apply a rigid-body transformation to @p count points, batched version of
+ * @ref math_pose_transform_point.
+ *
+ * OK if input and output are the same addresses.
+ *
+ * @relates xrt_pose
+ * @see xrt_vec3
+ * @ingroup aux_math
+ */
+void
+math_pose_transform_point_many(const struct xrt_pose *transform,
+                               const struct xrt_vec3 *in_points,
+                               struct xrt_vec3 *out_points,
+                               uint32_t count);
+
 
 /*
  *
@@ -18,6 +18,7 @@
 #include <Eigen/Geometry>
 
 #include <assert.h>
+#include <algorithm>
 
 using namespace xrt::auxiliary::math;
 
@@ -926,3 +927,126 @@ math_pose_transform_point(const struct xrt_pose *transform, const struct xrt_vec
 
 	map_vec3(*out_point) = transform_point(*transform, *point);
 }
+
+
+/*
+ *
+ * Batch functions.
+ *
+ */
+
+/*!
+ * Number of elements processed per chunk in the batch functions, the
+ * temporaries are fixed size so Eigen can keep them on the stack.
+ */
+static constexpr Eigen::Index BatchChunk = 16;
+
+using BatchStride = Eigen::OuterStride<Eigen::Dynamic>;
+template <int Rows>
+using BatchTemp = Eigen::Matrix<float, Rows, Eigen::Dynamic, Eigen::ColMajor, Rows, BatchChunk>;
+template <int Rows>
+using BatchMap = Eigen::Map<Eigen::Matrix<float, Rows, Eigen::Dynamic>, Eigen::Unaligned, BatchStride>;
+template <int Rows>
+using BatchConstMap = Eigen::Map<const Eigen::Matrix<float, Rows, Eigen::Dynamic>, Eigen::Unaligned, BatchStride>;
+
+/*!
+ * The matrix that does `q * p` when multiplied with `p` stored as a column
+ * vector in XRT (x, y, z, w) order.
+ */
+static inline Eigen::Matrix4f
+quat_left_mul_matrix(const struct xrt_quat &q)
+{
+	Eigen::Matrix4f res;
+	// clang-format off
+	res <<  q.w, -q.z,  q.y,  q.x,
+	        q.z,  q.w, -q.x,  q.y,
+	       -q.y,  q.x,  q.w,  q.z,
+	       -q.x, -q.y, -q.z,  q.w;
+	// clang-format on
+	return res;
+}
+
+/*!
+ * Apply `rot * v + trans` to @p count 3 element columns, @p in and @p out may
+ * be the same as each chunk is evaluated into a temporary first.
+ */
+static inline void
+batch_affine_3(const Eigen::Matrix3f &rot,
+               const Eigen::Vector3f &trans,
+               const float *in,
+               Eigen::Index in_stride,
+               float *out,
+               Eigen::Index out_stride,
+               uint32_t count)
+{
+	for (Eigen::Index i = 0; i < (Eigen::Index)count; i += BatchChunk) {
+		Eigen::Index n = std::min<Eigen::Index>(BatchChunk, (Eigen::Index)count - i);
+		BatchConstMap<3> src(in + i * in_stride, 3, n, BatchStride(in_stride));
+		BatchMap<3> dst(out + i * out_stride, 3, n, BatchStride(out_stride));
+
+		BatchTemp<3> tmp = rot * src;
+		tmp.colwise() += trans;
+		dst = tmp;
+	}
+}
+
+extern "C" void
+math_quat_rotate_vec3_many(const struct xrt_quat *left,
+                           const struct xrt_vec3 *in_vecs,
+                           struct xrt_vec3 *out_vecs,
+                           uint32_t count)
+{
+	assert(left != NULL);
+	assert(count == 0 || (in_vecs != NULL && out_vecs != NULL));
+
+	Eigen::Matrix3f rot = copy(left).toRotationMatrix();
+
+	constexpr Eigen::Index stride = sizeof(struct xrt_vec3) / sizeof(float);
+	batch_affine_3(rot, Eigen::Vector3f::Zero(), &in_vecs->x, stride, &out_vecs->x, stride, count);
+}
+
+extern "C" void
+math_pose_transform_point_many(const struct xrt_pose *transform,
+                               const struct xrt_vec3 *in_points,
+                               struct xrt_vec3 *out_points,
+                               uint32_t count)
+{
+	assert(transform != NULL);
+	assert(count == 0 || (in_points != NULL && out_points != NULL));
+
+	Eigen::Matrix3f rot = copy(transform->orientation).toRotationMatrix();
+	Eigen::Vector3f trans = copy(transform->position);
+
+	constexpr Eigen::Index stride = sizeof(struct xrt_vec3) / sizeof(float);
+	batch_affine_3(rot, trans, &in_points->x, stride, &out_points->x, stride, count);
+}
+
+extern "C" void
+math_pose_transform_many(const struct xrt_pose *transform,
+                         const struct xrt_pose *in_poses,
+                         struct xrt_pose *out_poses,
+                         uint32_t count)
+{
+	assert(transform != NULL);
+	assert(count == 0 || (in_poses != NULL && out_poses != NULL));
+
+	static_assert(sizeof(struct xrt_pose) == 7 * sizeof(float), "Pose must be tightly packed");
+	constexpr Eigen::Index stride = sizeof(struct xrt_pose) / sizeof(float);
+
+	Eigen::Matrix3f rot = copy(transform->orientation).toRotationMatrix();
+	Eigen::Vector3f trans = copy(transform->position);
+	Eigen::Matrix4f quat_mul = quat_left_mul_matrix(transform->orientation);
+
+	// Positions.
+	batch_affine_3(rot, trans, &in_poses->position.x, stride, &out_poses->position.x, stride, count);
+
+	// Orientations, quaternion multiplication from the left is a 4x4 matrix product.
+	for (Eigen::Index i = 0; i < (Eigen::Index)count; i += BatchChunk) {
+		Eigen::Index n = std::min<Eigen::Index>(BatchChunk, (Eigen::Index)count - i);
+		BatchConstMap<4> src(&in_poses[i].orientation.x, 4, n, BatchStride(stride));
+		BatchMap<4> dst(&out_poses[i].orientation.x, 4, n, BatchStride(stride));
+
+		BatchTemp<4> tmp = quat_mul * src;
+		dst = tmp;
+	}
+}
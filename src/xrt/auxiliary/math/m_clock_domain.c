@@ -0,0 +1,237 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Shared registry of device clocks and their offsets to monotonic.
+ * @ingroup aux_math
+ */
+
+#include "os/os_threading.h"
+
+#include "util/u_misc.h"
+#include "util/u_logging.h"
+
+#include "math/m_clock_domain.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <inttypes.h>
+
+
+//! Number of samples the smallest offset is taken from.
+#define WINDOW_SIZE (32)
+
+//! Offsets further than this from the estimate restart it.
+#define RESET_THRESHOLD_NS (U_TIME_1S_IN_NS)
+
+struct m_clock_domain
+{
+	//! Protected by @ref g_mutex.
+	struct m_clock_domain *next;
+	uint32_t refs;
+	char name[64];
+
+	//! Weight of the current estimate when smoothing.
+	double alpha;
+
+	//! Protects everything below.
+	struct os_mutex mutex;
+
+	//! Ring of the latest sampled offsets.
+	time_duration_ns window[WINDOW_SIZE];
+	uint32_t window_count;
+	uint32_t window_next;
+
+	time_duration_ns offset;
+	bool valid;
+};
+
+static struct os_mutex g_mutex;
+static pthread_once_t g_once = PTHREAD_ONCE_INIT;
+static struct m_clock_domain *g_list = NULL;
+
+
+/*
+ *
+ * Helper functions.
+ *
+ */
+
+static void
+init_mutex(void)
+{
+	os_mutex_init(&g_mutex);
+}
+
+static void
+reset_locked(struct m_clock_domain *cd)
+{
+	cd->window_count = 0;
+	cd->window_next = 0;
+	cd->offset = 0;
+	cd->valid = false;
+}
+
+static time_duration_ns
+window_min_locked(struct m_clock_domain *cd)
+{
+	time_duration_ns min = cd->window[0];
+	for (uint32_t i = 1; i < cd->window_count; i++) {
+		if (cd->window[i] < min) {
+			min = cd->window[i];
+		}
+	}
+	return min;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+int
+m_clock_domain_get(const char *name, float freq, struct m_clock_domain **out_cd)
+{
+	pthread_once(&g_once, init_mutex);
+
+	os_mutex_lock(&g_mutex);
+
+	struct m_clock_domain *cd = g_list;
+	while (cd != NULL && strncmp(cd->name, name, sizeof(cd->name) - 1) != 0) {
+		cd = cd->next;
+	}
+
+	if (cd != NULL) {
+		cd->refs++;
+		os_mutex_unlock(&g_mutex);
+
+		*out_cd = cd;
+		return 0;
+	}
+
+	cd = U_TYPED_CALLOC(struct m_clock_domain);
+	int ret = os_mutex_init(&cd->mutex);
+	if (ret != 0) {
+		os_mutex_unlock(&g_mutex);
+		free(cd);
+		return ret;
+	}
+
+	// Same weight as m_clock_offset_a2b, but never all or nothing.
+	double alpha = 1.0 - 12.5 / (double)freq;
+	cd->alpha = alpha < 0.0 ? 0.0 : alpha > 0.999 ? 0.999 : alpha;
+	cd->refs = 1;
+	snprintf(cd->name, sizeof(cd->name), "%s", name);
+	reset_locked(cd);
+
+	cd->next = g_list;
+	g_list = cd;
+
+	os_mutex_unlock(&g_mutex);
+
+	*out_cd = cd;
+
+	return 0;
+}
+
+void
+m_clock_domain_release(struct m_clock_domain **cd_ptr)
+{
+	struct m_clock_domain *cd = *cd_ptr;
+	if (cd == NULL) {
+		return;
+	}
+	*cd_ptr = NULL;
+
+	os_mutex_lock(&g_mutex);
+
+	assert(cd->refs > 0);
+	if (--cd->refs > 0) {
+		os_mutex_unlock(&g_mutex);
+		return;
+	}
+
+	struct m_clock_domain **link = &g_list;
+	while (*link != cd) {
+		link = &(*link)->next;
+	}
+	*link = cd->next;
+
+	os_mutex_unlock(&g_mutex);
+
+	os_mutex_destroy(&cd->mutex);
+	free(cd);
+}
+
+timepoint_ns
+m_clock_domain_update(struct m_clock_domain *cd, timepoint_ns hw_ns, timepoint_ns mono_ns)
+{
+	time_duration_ns got = mono_ns - hw_ns;
+
+	os_mutex_lock(&cd->mutex);
+
+	if (cd->valid && llabs(got - cd->offset) > RESET_THRESHOLD_NS) {
+		U_LOG_W("Clock '%s' jumped by %" PRId64 "ns, restarting the estimate", cd->name, got - cd->offset);
+		reset_locked(cd);
+	}
+
+	cd->window[cd->window_next] = got;
+	cd->window_next = (cd->window_next + 1) % WINDOW_SIZE;
+	if (cd->window_count < WINDOW_SIZE) {
+		cd->window_count++;
+	}
+
+	// The sample with the least latency is closest to the real offset.
+	time_duration_ns min = window_min_locked(cd);
+	if (!cd->valid) {
+		cd->offset = min;
+		cd->valid = true;
+	} else {
+		cd->offset = (time_duration_ns)((double)cd->offset * cd->alpha + (double)min * (1.0 - cd->alpha));
+	}
+
+	timepoint_ns ret = hw_ns + cd->offset;
+
+	os_mutex_unlock(&cd->mutex);
+
+	return ret;
+}
+
+time_duration_ns
+m_clock_domain_get_offset(struct m_clock_domain *cd)
+{
+	os_mutex_lock(&cd->mutex);
+	time_duration_ns offset = cd->offset;
+	os_mutex_unlock(&cd->mutex);
+
+	return offset;
+}
+
+timepoint_ns
+m_clock_domain_to_mono(struct m_clock_domain *cd, timepoint_ns hw_ns)
+{
+	return hw_ns + m_clock_domain_get_offset(cd);
+}
+
+timepoint_ns
+m_clock_domain_from_mono(struct m_clock_domain *cd, timepoint_ns mono_ns)
+{
+	return mono_ns - m_clock_domain_get_offset(cd);
+}
+
+void
+m_clock_domain_to_mono_many(struct m_clock_domain *cd,
+                            const timepoint_ns *in_hw_ns,
+                            uint32_t count,
+                            timepoint_ns *out_mono_ns)
+{
+	time_duration_ns offset = m_clock_domain_get_offset(cd);
+
+	for (uint32_t i = 0; i < count; i++) {
+		out_mono_ns[i] = in_hw_ns[i] + offset;
+	}
+}
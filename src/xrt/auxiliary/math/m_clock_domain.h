@@ -0,0 +1,112 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Shared registry of device clocks and their offsets to monotonic.
+ * @ingroup aux_math
+ */
+
+#pragma once
+
+#include "util/u_time.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * The clock of a device, with a filtered estimate of its offset to the
+ * monotonic clock.
+ *
+ * Clocks are looked up by name, so every part of the code that gets
+ * timestamps from the same hardware clock, like the IMU and the cameras of a
+ * headset or a tracker fused with another device, shares one estimate and
+ * converts timestamps the same way. The name should identify the hardware, for
+ * example include the serial number.
+ *
+ * The estimate uses the smallest offset seen over a short window of samples,
+ * those are the ones with the least transport latency, and then smooths that
+ * to follow the drift between the clocks. A jump of more than a second, like
+ * a device reset, restarts the estimate.
+ *
+ * All functions are thread safe.
+ *
+ * @ingroup aux_math
+ */
+struct m_clock_domain;
+
+/*!
+ * Gets the clock called @p name, creating it if it doesn't exist yet. Every
+ * call must be matched with a @ref m_clock_domain_release.
+ *
+ * @param name Identifies the hardware clock.
+ * @param freq About how many times per second it will be updated.
+ * @param[out] out_cd The clock.
+ *
+ * @ingroup aux_math
+ */
+int
+m_clock_domain_get(const char *name, float freq, struct m_clock_domain **out_cd);
+
+/*!
+ * Releases the reference to a clock, it is destroyed when the last one is
+ * released. Sets @p cd_ptr to NULL.
+ *
+ * @ingroup aux_math
+ */
+void
+m_clock_domain_release(struct m_clock_domain **cd_ptr);
+
+/*!
+ * Updates the estimate with a sample from the device, @p hw_ns and @p mono_ns
+ * should have been sampled as close together as possible, normally @p mono_ns
+ * is when the sample was received. Returns @p hw_ns in the monotonic clock.
+ *
+ * @ingroup aux_math
+ */
+timepoint_ns
+m_clock_domain_update(struct m_clock_domain *cd, timepoint_ns hw_ns, timepoint_ns mono_ns);
+
+/*!
+ * Returns the current offset from the device clock to monotonic, or zero if
+ * there has not been any update yet.
+ *
+ * @ingroup aux_math
+ */
+time_duration_ns
+m_clock_domain_get_offset(struct m_clock_domain *cd);
+
+/*!
+ * Converts a device timestamp to the monotonic clock.
+ *
+ * @ingroup aux_math
+ */
+timepoint_ns
+m_clock_domain_to_mono(struct m_clock_domain *cd, timepoint_ns hw_ns);
+
+/*!
+ * Converts a monotonic timestamp to the device clock.
+ *
+ * @ingroup aux_math
+ */
+timepoint_ns
+m_clock_domain_from_mono(struct m_clock_domain *cd, timepoint_ns mono_ns);
+
+/*!
+ * Converts many device timestamps to the monotonic clock with the same
+ * offset, so that a batch of samples stays consistent. @p in_hw_ns and
+ * @p out_mono_ns may be the same array.
+ *
+ * @ingroup aux_math
+ */
+void
+m_clock_domain_to_mono_many(struct m_clock_domain *cd,
+                            const timepoint_ns *in_hw_ns,
+                            uint32_t count,
+                            timepoint_ns *out_mono_ns);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -21,6 +21,8 @@
 
 #include "m_filter_one_euro.h"
 
+#include <stdlib.h>
+
 
 static double
 calc_smoothing_alpha(double Fc, double dt)
@@ -295,3 +297,88 @@ m_filter_euro_quat_run(struct m_filter_euro_quat *f, uint64_t ts, const struct x
 	f->prev_y = exp_smooth_quat(alpha, *in_y, f->prev_y);
 	*out_y = f->prev_y;
 }
+
+void
+m_filter_euro_vec3_bank_init(
+    struct m_filter_euro_vec3_bank *f, uint32_t count, double fc_min, double fc_min_d, double beta)
+{
+	filter_one_euro_init(&f->base, fc_min, fc_min_d, beta);
+
+	// One allocation, laid out as y.x, y.y, y.z, dy.x, dy.y, dy.z.
+	float *data = U_TYPED_ARRAY_CALLOC(float, (size_t)count * 6);
+	for (int c = 0; c < 3; c++) {
+		f->prev_y[c] = data + (size_t)count * c;
+		f->prev_dy[c] = data + (size_t)count * (3 + c);
+	}
+	f->count = count;
+}
+
+void
+m_filter_euro_vec3_bank_run(struct m_filter_euro_vec3_bank *f,
+                            uint64_t ts,
+                            const struct xrt_vec3 *in_y,
+                            struct xrt_vec3 *out_y)
+{
+	const uint32_t count = f->count;
+	float *y_x = f->prev_y[0];
+	float *y_y = f->prev_y[1];
+	float *y_z = f->prev_y[2];
+	float *dy_x = f->prev_dy[0];
+	float *dy_y = f->prev_dy[1];
+	float *dy_z = f->prev_dy[2];
+
+	if (filter_one_euro_handle_first_sample(&f->base, ts, true)) {
+		/* First sample - no filtering yet */
+		for (uint32_t i = 0; i < count; i++) {
+			y_x[i] = in_y[i].x;
+			y_y[i] = in_y[i].y;
+			y_z[i] = in_y[i].z;
+			dy_x[i] = 0.0f;
+			dy_y[i] = 0.0f;
+			dy_z[i] = 0.0f;
+			out_y[i] = in_y[i];
+		}
+		return;
+	}
+
+	double dt = 0;
+	const float alpha_d = (float)filter_one_euro_compute_alpha_d(&f->base, &dt, ts, true);
+
+	// Hoisted so the loop only has multiplies, adds and one sqrt and divide per channel.
+	const float inv_dt = (float)(1.0 / dt);
+	const float r_min = (float)(2.0 * M_PI * dt * f->base.fc_min);
+	const float r_beta = (float)(2.0 * M_PI * dt * f->base.beta);
+
+	for (uint32_t i = 0; i < count; i++) {
+		const float in_x = in_y[i].x;
+		const float in_y_ = in_y[i].y;
+		const float in_z = in_y[i].z;
+
+		/* Smooth the dy values and use them to calculate the frequency cutoff for the main filter */
+		dy_x[i] += alpha_d * ((in_x - y_x[i]) * inv_dt - dy_x[i]);
+		dy_y[i] += alpha_d * ((in_y_ - y_y[i]) * inv_dt - dy_y[i]);
+		dy_z[i] += alpha_d * ((in_z - y_z[i]) * inv_dt - dy_z[i]);
+
+		const float dy_mag = sqrtf(dy_x[i] * dy_x[i] + dy_y[i] * dy_y[i] + dy_z[i] * dy_z[i]);
+
+		// Same as calc_smoothing_alpha with fc_min + beta * dy_mag.
+		const float r = r_min + r_beta * dy_mag;
+		const float alpha = r / (r + 1.0f);
+
+		y_x[i] += alpha * (in_x - y_x[i]);
+		y_y[i] += alpha * (in_y_ - y_y[i]);
+		y_z[i] += alpha * (in_z - y_z[i]);
+
+		out_y[i].x = y_x[i];
+		out_y[i].y = y_y[i];
+		out_y[i].z = y_z[i];
+	}
+}
+
+void
+m_filter_euro_vec3_bank_fini(struct m_filter_euro_vec3_bank *f)
+{
+	// All state lives in the allocation starting at prev_y[0].
+	free(f->prev_y[0]);
+	U_ZERO(f);
+}
@@ -125,6 +125,32 @@ struct m_filter_euro_quat
 	struct xrt_quat prev_dy;
 };
 
+/*!
+ * @brief One Euro filter for many 3D float measurements sampled together, like
+ * the joints of a hand or the positions of many trackers.
+ *
+ * The state is kept as one array per component, so all channels are updated
+ * in plain loops that the compiler vectorizes. Filtering a whole joint set
+ * costs about as much as a few single filters. Channels share the timestamp
+ * and parameters, each gets its own cutoff from its own speed.
+ *
+ * @ingroup aux_math
+ */
+struct m_filter_euro_vec3_bank
+{
+	/** Base/common data */
+	struct m_filter_one_euro_base base;
+
+	/** Number of channels. */
+	uint32_t count;
+
+	/** The most recent measurements, after filtering, one array per component. */
+	float *prev_y[3];
+
+	/** The most recent sample derivatives, after filtering, one array per component. */
+	float *prev_dy[3];
+};
+
 /**
  * @brief Initialize a 1D filter
  *
@@ -247,6 +273,47 @@ m_filter_euro_quat_init(struct m_filter_euro_quat *f, double fc_min, double fc_m
 void
 m_filter_euro_quat_run(struct m_filter_euro_quat *f, uint64_t ts, const struct xrt_quat *in_y, struct xrt_quat *out_y);
 
+/**
+ * @brief Initialize a bank of 3D filters
+ *
+ * @param f self pointer
+ * @param count Number of channels
+ * @param fc_min Minimum frequency cutoff for filter
+ * @param fc_min_d Minimum frequency cutoff for derivative filter
+ * @param beta Beta value for "responsiveness" of filter
+ *
+ * @public @memberof m_filter_euro_vec3_bank
+ */
+void
+m_filter_euro_vec3_bank_init(
+    struct m_filter_euro_vec3_bank *f, uint32_t count, double fc_min, double fc_min_d, double beta);
+
+/**
+ * @brief Filter one measurement per channel and commit changes to filter state
+ *
+ * @param[in,out] f self pointer
+ * @param ts measurement timestamp
+ * @param in_y raw measurements, @ref m_filter_euro_vec3_bank::count of them
+ * @param[out] out_y filtered measurements, may be the same array as @p in_y
+ *
+ * @public @memberof m_filter_euro_vec3_bank
+ */
+void
+m_filter_euro_vec3_bank_run(struct m_filter_euro_vec3_bank *f,
+                            uint64_t ts,
+                            const struct xrt_vec3 *in_y,
+                            struct xrt_vec3 *out_y);
+
+/**
+ * @brief Free the state of the bank
+ *
+ * @param f self pointer
+ *
+ * @public @memberof m_filter_euro_vec3_bank
+ */
+void
+m_filter_euro_vec3_bank_fini(struct m_filter_euro_vec3_bank *f);
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,384 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Keeps the history of a hand's joint sets, so a hand can be looked up at any time near what was tracked.
+ * @ingroup aux_math
+ */
+
+#include "m_hand_joint_history.h"
+
+#include "math/m_api.h"
+#include "math/m_predict.h"
+#include "math/m_vec3.h"
+#include "os/os_time.h"
+#include "os/os_threading.h"
+#include "util/u_logging.h"
+#include "util/u_trace_marker.h"
+#include "util/u_template_historybuf_impl_helpers.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+using namespace xrt::auxiliary::util;
+namespace os = xrt::auxiliary::os;
+
+//! The only flags kept per joint.
+static constexpr uint32_t kKeptJointFlags =
+    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_POSITION_VALID_BIT |
+    XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT | XRT_SPACE_RELATION_POSITION_TRACKED_BIT;
+
+static constexpr size_t kJoints = XRT_HAND_JOINT_COUNT;
+
+/*!
+ * Ring buffer of joint sets, every per-joint array holds @ref kJoints entries
+ * per set back to back, so one set is contiguous in each array.
+ *
+ * Writers are serialized by the mutex, readers never take it: they copy out
+ * what they need and retry if @ref seq shows a writer changed the history
+ * meanwhile, so a reader on the compositor thread never waits on a driver.
+ */
+struct m_hand_joint_history
+{
+	explicit m_hand_joint_history(size_t capacity)
+	    : timestamps(new uint64_t[capacity]()), hand_poses(new xrt_space_relation[capacity]()),
+	      positions(new xrt_vec3[capacity * kJoints]()), orientations(new xrt_quat[capacity * kJoints]()),
+	      radii(new float[capacity * kJoints]()), flags(new uint8_t[capacity * kJoints]()), helper(capacity)
+	{}
+
+	std::unique_ptr<uint64_t[]> timestamps;
+	std::unique_ptr<xrt_space_relation[]> hand_poses;
+	std::unique_ptr<xrt_vec3[]> positions;
+	std::unique_ptr<xrt_quat[]> orientations;
+	std::unique_ptr<float[]> radii;
+	std::unique_ptr<uint8_t[]> flags;
+	detail::RingBufferHelper helper;
+
+	//! Only taken by writers.
+	os::Mutex mutex;
+
+	//! Odd while a writer changes the history.
+	std::atomic<uint32_t> seq{0};
+};
+
+
+/*
+ *
+ * Helpers, writers call them with the mutex held, readers from within
+ * read_consistent on a copy of the ring buffer helper.
+ *
+ */
+
+static size_t
+inner(const detail::RingBufferHelper &helper, size_t index)
+{
+	size_t inner_index = 0;
+	helper.index_to_inner_index(index, inner_index);
+	return inner_index;
+}
+
+//! Marks the start of a write, call with the mutex held.
+static void
+write_begin(struct m_hand_joint_history *hjh)
+{
+	hjh->seq.store(hjh->seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+//! Marks the end of a write, publishing it to readers.
+static void
+write_end(struct m_hand_joint_history *hjh)
+{
+	hjh->seq.store(hjh->seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+/*!
+ * Calls @p func with a copy of the ring buffer helper until it ran without a
+ * writer changing the history, @p func must only write to its own outputs.
+ * Writers are brief and rare, so this practically never spins.
+ */
+template <typename Func>
+static auto
+read_consistent(const struct m_hand_joint_history *hjh, Func func) -> decltype(func(hjh->helper))
+{
+	while (true) {
+		uint32_t begin = hjh->seq.load(std::memory_order_acquire);
+		if ((begin & 1) != 0) {
+			continue;
+		}
+
+		// The copy keeps the indices in range even if it is torn.
+		detail::RingBufferHelper helper = hjh->helper;
+		auto ret = func(helper);
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (hjh->seq.load(std::memory_order_relaxed) == begin) {
+			return ret;
+		}
+	}
+}
+
+static void
+store(struct m_hand_joint_history *hjh, size_t inner_index, const struct xrt_hand_joint_set *in_set)
+{
+	hjh->hand_poses[inner_index] = in_set->hand_pose;
+
+	size_t base = inner_index * kJoints;
+	for (size_t j = 0; j < kJoints; j++) {
+		const struct xrt_hand_joint_value &v = in_set->values.hand_joint_set_default[j];
+		hjh->positions[base + j] = v.relation.pose.position;
+		hjh->orientations[base + j] = v.relation.pose.orientation;
+		hjh->radii[base + j] = v.radius;
+		hjh->flags[base + j] = (uint8_t)(v.relation.relation_flags & kKeptJointFlags);
+	}
+}
+
+static void
+load(const struct m_hand_joint_history *hjh, size_t inner_index, struct xrt_hand_joint_set *out_set)
+{
+	*out_set = {};
+	out_set->hand_pose = hjh->hand_poses[inner_index];
+	out_set->is_active = true;
+
+	size_t base = inner_index * kJoints;
+	for (size_t j = 0; j < kJoints; j++) {
+		struct xrt_hand_joint_value &v = out_set->values.hand_joint_set_default[j];
+		v.relation.pose.position = hjh->positions[base + j];
+		v.relation.pose.orientation = hjh->orientations[base + j];
+		v.relation.relation_flags = (enum xrt_space_relation_flags)hjh->flags[base + j];
+		v.radius = hjh->radii[base + j];
+	}
+}
+
+static void
+interpolate(const struct m_hand_joint_history *hjh,
+            size_t before,
+            size_t after,
+            float t,
+            struct xrt_hand_joint_set *out_set)
+{
+	*out_set = {};
+	out_set->is_active = true;
+
+	const xrt_space_relation &hp_before = hjh->hand_poses[before];
+	const xrt_space_relation &hp_after = hjh->hand_poses[after];
+	out_set->hand_pose.relation_flags =
+	    (enum xrt_space_relation_flags)(hp_before.relation_flags & hp_after.relation_flags & kKeptJointFlags);
+	out_set->hand_pose.pose.position = m_vec3_lerp(hp_before.pose.position, hp_after.pose.position, t);
+	math_quat_slerp(&hp_before.pose.orientation, &hp_after.pose.orientation, t,
+	                &out_set->hand_pose.pose.orientation);
+
+	size_t b = before * kJoints;
+	size_t a = after * kJoints;
+	for (size_t j = 0; j < kJoints; j++) {
+		struct xrt_hand_joint_value &v = out_set->values.hand_joint_set_default[j];
+		v.relation.pose.position = m_vec3_lerp(hjh->positions[b + j], hjh->positions[a + j], t);
+		math_quat_slerp(&hjh->orientations[b + j], &hjh->orientations[a + j], t, &v.relation.pose.orientation);
+		v.relation.relation_flags = (enum xrt_space_relation_flags)(hjh->flags[b + j] & hjh->flags[a + j]);
+		v.radius = hjh->radii[b + j] + (hjh->radii[a + j] - hjh->radii[b + j]) * t;
+	}
+}
+
+/*!
+ * Moves the newest set rigidly with the wrist, whose velocity is estimated
+ * from the last two sets. The fingers are too noisy to extrapolate one by one.
+ */
+static void
+predict(const struct m_hand_joint_history *hjh,
+        size_t prev,
+        size_t newest,
+        double delta_s,
+        struct xrt_hand_joint_set *out_set)
+{
+	load(hjh, newest, out_set);
+
+	double dt = time_ns_to_s((int64_t)(hjh->timestamps[newest] - hjh->timestamps[prev]));
+	if (dt <= 0.0) {
+		return;
+	}
+
+	size_t w = XRT_HAND_JOINT_WRIST;
+	const xrt_pose wrist = out_set->values.hand_joint_set_default[w].relation.pose;
+
+	struct xrt_space_relation wrist_rel = {};
+	wrist_rel.relation_flags = (enum xrt_space_relation_flags)(
+	    XRT_SPACE_RELATION_POSITION_VALID_BIT | XRT_SPACE_RELATION_ORIENTATION_VALID_BIT |
+	    XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT | XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT);
+	wrist_rel.pose = wrist;
+	wrist_rel.linear_velocity = (wrist.position - hjh->positions[prev * kJoints + w]) / (float)dt;
+	math_quat_finite_difference(&hjh->orientations[prev * kJoints + w], &wrist.orientation, (float)dt,
+	                            &wrist_rel.angular_velocity);
+
+	struct xrt_space_relation predicted_wrist = {};
+	m_predict_relation(&wrist_rel, delta_s, &predicted_wrist);
+
+	// The transform taking the newest wrist to the predicted one.
+	struct xrt_pose wrist_inv;
+	struct xrt_pose delta;
+	math_pose_invert(&wrist, &wrist_inv);
+	math_pose_transform(&predicted_wrist.pose, &wrist_inv, &delta);
+
+	for (size_t j = 0; j < kJoints; j++) {
+		struct xrt_pose &pose = out_set->values.hand_joint_set_default[j].relation.pose;
+		struct xrt_pose tmp = pose;
+		math_pose_transform(&delta, &tmp, &pose);
+	}
+}
+
+static enum m_relation_history_result
+get_impl(const struct m_hand_joint_history *hjh,
+         const detail::RingBufferHelper &helper,
+         uint64_t at_timestamp_ns,
+         struct xrt_hand_joint_set *out_set)
+{
+	size_t size = helper.size();
+	if (size == 0 || at_timestamp_ns == 0) {
+		*out_set = {};
+		return M_RELATION_HISTORY_RESULT_INVALID;
+	}
+
+	// First set not older than the requested time.
+	size_t first = 0;
+	size_t count = size;
+	while (count > 0) {
+		size_t step = count / 2;
+		size_t mid = first + step;
+		if (hjh->timestamps[inner(helper, mid)] < at_timestamp_ns) {
+			first = mid + 1;
+			count -= step + 1;
+		} else {
+			count = step;
+		}
+	}
+
+	if (first == size) {
+		size_t newest = inner(helper, size - 1);
+		if (size == 1) {
+			load(hjh, newest, out_set);
+			return M_RELATION_HISTORY_RESULT_PREDICTED;
+		}
+
+		int64_t diff_ns = (int64_t)(at_timestamp_ns - hjh->timestamps[newest]);
+		predict(hjh, inner(helper, size - 2), newest, time_ns_to_s(diff_ns), out_set);
+		return M_RELATION_HISTORY_RESULT_PREDICTED;
+	}
+
+	size_t after = inner(helper, first);
+	if (hjh->timestamps[after] == at_timestamp_ns) {
+		load(hjh, after, out_set);
+		return M_RELATION_HISTORY_RESULT_EXACT;
+	}
+
+	if (first == 0) {
+		load(hjh, after, out_set);
+		return M_RELATION_HISTORY_RESULT_REVERSE_PREDICTED;
+	}
+
+	size_t before = inner(helper, first - 1);
+	uint64_t diff_before = at_timestamp_ns - hjh->timestamps[before];
+	uint64_t diff_total = hjh->timestamps[after] - hjh->timestamps[before];
+	float t = (float)((double)diff_before / (double)diff_total);
+
+	interpolate(hjh, before, after, t, out_set);
+	return M_RELATION_HISTORY_RESULT_INTERPOLATED;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+void
+m_hand_joint_history_create(struct m_hand_joint_history **hjh_ptr, uint32_t capacity)
+{
+	if (capacity < 2) {
+		U_LOG_W("Capacity %u is too small to interpolate, using 2", capacity);
+		capacity = 2;
+	}
+
+	auto ret = std::make_unique<m_hand_joint_history>(capacity);
+	*hjh_ptr = ret.release();
+}
+
+bool
+m_hand_joint_history_push(struct m_hand_joint_history *hjh,
+                          const struct xrt_hand_joint_set *in_set,
+                          uint64_t timestamp_ns)
+{
+	XRT_TRACE_MARKER();
+
+	std::unique_lock<os::Mutex> lock(hjh->mutex);
+
+	if (!in_set->is_active) {
+		write_begin(hjh);
+		hjh->helper.clear();
+		write_end(hjh);
+		return false;
+	}
+
+	if (!hjh->helper.empty() && timestamp_ns <= hjh->timestamps[hjh->helper.back_inner_index()]) {
+		return false;
+	}
+
+	write_begin(hjh);
+	size_t inner_index = hjh->helper.push_back_location();
+	hjh->timestamps[inner_index] = timestamp_ns;
+	store(hjh, inner_index, in_set);
+	write_end(hjh);
+
+	return true;
+}
+
+enum m_relation_history_result
+m_hand_joint_history_get(struct m_hand_joint_history *hjh,
+                         uint64_t at_timestamp_ns,
+                         struct xrt_hand_joint_set *out_set)
+{
+	XRT_TRACE_MARKER();
+
+	return read_consistent(hjh, [&](const detail::RingBufferHelper &helper) {
+		return get_impl(hjh, helper, at_timestamp_ns, out_set);
+	});
+}
+
+bool
+m_hand_joint_history_get_latest(struct m_hand_joint_history *hjh,
+                                uint64_t *out_time_ns,
+                                struct xrt_hand_joint_set *out_set)
+{
+	return read_consistent(hjh, [&](const detail::RingBufferHelper &helper) {
+		if (helper.empty()) {
+			return false;
+		}
+
+		size_t newest = helper.back_inner_index();
+		*out_time_ns = hjh->timestamps[newest];
+		load(hjh, newest, out_set);
+
+		return true;
+	});
+}
+
+void
+m_hand_joint_history_clear(struct m_hand_joint_history *hjh)
+{
+	std::unique_lock<os::Mutex> lock(hjh->mutex);
+	write_begin(hjh);
+	hjh->helper.clear();
+	write_end(hjh);
+}
+
+void
+m_hand_joint_history_destroy(struct m_hand_joint_history **hjh_ptr)
+{
+	struct m_hand_joint_history *hjh = *hjh_ptr;
+	if (hjh == NULL) {
+		return;
+	}
+
+	delete hjh;
+	*hjh_ptr = NULL;
+}
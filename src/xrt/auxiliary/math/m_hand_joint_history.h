@@ -0,0 +1,105 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Keeps the history of a hand's joint sets, so a hand can be looked up at any time near what was tracked.
+ * @ingroup aux_math
+ */
+#pragma once
+
+#include "xrt/xrt_defines.h"
+#include "math/m_relation_history.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * @brief Opaque type for storing the history of a hand's joint sets in a ring buffer.
+ *
+ * Joints are stored as a struct of arrays, only the pose, radius and the
+ * valid/tracked flags of each joint are kept, velocities are dropped.
+ *
+ * Looking up a time between two sets interpolates every joint, positions and
+ * radii linearly and orientations with slerp. Looking up a time after the
+ * newest set predicts the wrist from the last two sets and moves the whole hand
+ * rigidly with it, finger poses are held. Looking up a time before the oldest
+ * set returns the oldest set.
+ *
+ * Thread safe, pushing and getting may happen from different threads.
+ * Getting is lock-free, it retries if a push changed the history under it.
+ *
+ * @ingroup aux_math
+ */
+struct m_hand_joint_history;
+
+/*!
+ * Creates a hand joint history holding at most @p capacity joint sets,
+ * a capacity smaller than 2 is raised to 2.
+ *
+ * @public @memberof m_hand_joint_history
+ */
+void
+m_hand_joint_history_create(struct m_hand_joint_history **hjh, uint32_t capacity);
+
+/*!
+ * Pushes a new joint set, if the history is full the oldest one is dropped.
+ *
+ * An inactive set clears the history, the hand was lost and nothing should be
+ * interpolated across that gap.
+ *
+ * @return false if the set wasn't stored, because it is inactive or its
+ *         timestamp is not newer than the newest one already stored.
+ *
+ * @public @memberof m_hand_joint_history
+ */
+bool
+m_hand_joint_history_push(struct m_hand_joint_history *hjh,
+                          const struct xrt_hand_joint_set *in_set,
+                          uint64_t timestamp_ns);
+
+/*!
+ * Interpolates or predicts the joint set to @p at_timestamp_ns.
+ *
+ * @return @ref M_RELATION_HISTORY_RESULT_INVALID, with an inactive
+ *         @p out_set, if the history is empty or the timestamp is 0.
+ *
+ * @public @memberof m_hand_joint_history
+ */
+enum m_relation_history_result
+m_hand_joint_history_get(struct m_hand_joint_history *hjh,
+                         uint64_t at_timestamp_ns,
+                         struct xrt_hand_joint_set *out_set);
+
+/*!
+ * Get the newest joint set, if any.
+ *
+ * @return false if the history is empty.
+ *
+ * @public @memberof m_hand_joint_history
+ */
+bool
+m_hand_joint_history_get_latest(struct m_hand_joint_history *hjh,
+                                uint64_t *out_time_ns,
+                                struct xrt_hand_joint_set *out_set);
+
+/*!
+ * Removes all joint sets.
+ *
+ * @public @memberof m_hand_joint_history
+ */
+void
+m_hand_joint_history_clear(struct m_hand_joint_history *hjh);
+
+/*!
+ * Destroys the history and sets the pointer to NULL.
+ *
+ * @public @memberof m_hand_joint_history
+ */
+void
+m_hand_joint_history_destroy(struct m_hand_joint_history **hjh);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -25,6 +25,9 @@
 #define DUR_300MS_IN_NS (300 * 1000 * 1000)
 #define DUR_20MS_IN_NS (20 * 1000 * 1000)
 
+//! Samples processed per block in @ref m_imu_3dof_update_batch.
+#define BATCH_BLOCK_SIZE (16)
+
 
 void
 m_imu_3dof_init(struct m_imu_3dof *f, int flags)
@@ -298,3 +301,143 @@ m_imu_3dof_update(struct m_imu_3dof *f,
 	 */
 	math_quat_normalize(&f->rot);
 }
+
+/*!
+ * Gyro derived values for a block of samples, kept as separate arrays so the
+ * loops filling them vectorize.
+ */
+struct batch_block
+{
+	float dt[BATCH_BLOCK_SIZE];
+	float gx[BATCH_BLOCK_SIZE], gy[BATCH_BLOCK_SIZE], gz[BATCH_BLOCK_SIZE];
+	float gyro_length[BATCH_BLOCK_SIZE];
+	float gyro_biased_length[BATCH_BLOCK_SIZE];
+	float accel_length[BATCH_BLOCK_SIZE];
+	float half_sin[BATCH_BLOCK_SIZE];
+	float half_cos[BATCH_BLOCK_SIZE];
+};
+
+static void
+batch_block_compute(struct m_imu_3dof *f,
+                    struct batch_block *b,
+                    uint64_t last_timestamp_ns,
+                    const uint64_t *timestamps_ns,
+                    const struct xrt_vec3 *accels,
+                    const struct xrt_vec3 *gyros,
+                    uint32_t n)
+{
+	const struct xrt_vec3 bias = f->gyro_bias.value;
+
+	for (uint32_t i = 0; i < n; i++) {
+		uint64_t prev = i == 0 ? last_timestamp_ns : timestamps_ns[i - 1];
+		b->dt[i] = (float)((double)(timestamps_ns[i] - prev) / DUR_1S_IN_NS);
+	}
+
+	for (uint32_t i = 0; i < n; i++) {
+		float x = gyros[i].x;
+		float y = gyros[i].y;
+		float z = gyros[i].z;
+		b->gyro_length[i] = sqrtf(x * x + y * y + z * z);
+
+		b->gx[i] = x - bias.x;
+		b->gy[i] = y - bias.y;
+		b->gz[i] = z - bias.z;
+	}
+
+	for (uint32_t i = 0; i < n; i++) {
+		float x = accels[i].x;
+		float y = accels[i].y;
+		float z = accels[i].z;
+		b->accel_length[i] = sqrtf(x * x + y * y + z * z);
+	}
+
+	for (uint32_t i = 0; i < n; i++) {
+		float x = b->gx[i];
+		float y = b->gy[i];
+		float z = b->gz[i];
+		b->gyro_biased_length[i] = sqrtf(x * x + y * y + z * z);
+	}
+
+	// Half angle of the rotation, the axis is the normalized biased gyro.
+	for (uint32_t i = 0; i < n; i++) {
+		float half_angle = 0.5f * b->gyro_biased_length[i] * b->dt[i];
+		b->half_sin[i] = sinf(half_angle);
+		b->half_cos[i] = cosf(half_angle);
+	}
+}
+
+void
+m_imu_3dof_update_batch(struct m_imu_3dof *f,
+                        const uint64_t *timestamps_ns,
+                        const struct xrt_vec3 *accels,
+                        const struct xrt_vec3 *gyros,
+                        uint32_t count)
+{
+	//! Skip the first sample.
+	if (count > 0 && f->state == M_IMU_3DOF_STATE_START) {
+		m_imu_3dof_update(f, timestamps_ns[0], &accels[0], &gyros[0]);
+		timestamps_ns++;
+		accels++;
+		gyros++;
+		count--;
+	}
+
+	struct batch_block b;
+
+	for (uint32_t start = 0; start < count; start += BATCH_BLOCK_SIZE) {
+		uint32_t n = count - start < BATCH_BLOCK_SIZE ? count - start : BATCH_BLOCK_SIZE;
+		const uint64_t *ts = &timestamps_ns[start];
+		const struct xrt_vec3 *accel = &accels[start];
+		const struct xrt_vec3 *gyro = &gyros[start];
+
+		// This code assumes all timestamps makes some forward progress.
+		assert(ts[0] >= f->last.timestamp_ns);
+
+		batch_block_compute(f, &b, f->last.timestamp_ns, ts, accel, gyro, n);
+
+		// The rest depends on the orientation, so goes one sample at a time.
+		for (uint32_t i = 0; i < n; i++) {
+			struct xrt_vec3 world_accel = {0};
+			math_quat_rotate_vec3(&f->rot, &accel[i], &world_accel);
+
+			m_ff_vec3_f32_push(f->word_accel_ff, &world_accel, ts[i]);
+			m_ff_vec3_f32_push(f->gyro_ff, &gyro[i], ts[i]);
+
+			float gyro_biased_length = b.gyro_biased_length[i];
+			struct xrt_vec3 gyro_biased = {b.gx[i], b.gy[i], b.gz[i]};
+
+			if (gyro_biased_length > 0.0001f) {
+				float s = b.half_sin[i] / gyro_biased_length;
+				struct xrt_quat delta_orient = {
+				    gyro_biased.x * s,
+				    gyro_biased.y * s,
+				    gyro_biased.z * s,
+				    b.half_cos[i],
+				};
+
+				math_quat_rotate(&f->rot, &delta_orient, &f->rot);
+			}
+
+			// Gravity correction.
+			gravity_correction(f, ts[i], &accel[i], &gyro_biased, b.dt[i], gyro_biased_length);
+
+			/*
+			 * Mitigate drift due to floating point
+			 * inprecision with quat multiplication.
+			 */
+			math_quat_normalize(&f->rot);
+		}
+
+		uint32_t last = n - 1;
+		f->last.gyro = gyro[last];
+		f->last.accel = accel[last];
+		f->last.delta_ms = (double)b.dt[last] * 1000.0;
+		f->last.timestamp_ns = ts[last];
+		f->last.accel_length = b.accel_length[last];
+		f->last.gyro_length = b.gyro_length[last];
+		f->last.gyro_biased_length = b.gyro_biased_length[last];
+
+		// Gyro bias calculations.
+		gyro_biasing(f, ts[last]);
+	}
+}
@@ -90,6 +90,22 @@ m_imu_3dof_update(struct m_imu_3dof *f,
                   const struct xrt_vec3 *accel,
                   const struct xrt_vec3 *gyro);
 
+/*!
+ * Same as calling @ref m_imu_3dof_update for each sample in order, for
+ * drivers that get several samples per packet. The per sample math that does
+ * not depend on the orientation is done for a block of samples at a time over
+ * arrays, which the compiler can vectorize.
+ *
+ * The gyro bias is read once per block, so a manually fired bias update lands
+ * at the end of a block instead of right after the sample that fired it.
+ */
+void
+m_imu_3dof_update_batch(struct m_imu_3dof *f,
+                        const uint64_t *timestamps_ns,
+                        const struct xrt_vec3 *accels,
+                        const struct xrt_vec3 *gyros,
+                        uint32_t count);
+
 
 #ifdef __cplusplus
 }
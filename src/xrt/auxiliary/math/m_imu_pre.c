@@ -11,6 +11,93 @@
 #include "math/m_imu_pre.h"
 
 
+//! Samples converted at a time, sized to keep the block arrays on the stack small.
+#define BLOCK_SIZE (16)
+
+/*!
+ * The pre filter of one part folded into `out = mat * raw + offset`.
+ */
+struct folded_part
+{
+	float mat[9];
+	float offset[3];
+};
+
+/*!
+ * Raw samples of one part, one array per axis so the math vectorizes.
+ */
+struct raw_block
+{
+	float x[BLOCK_SIZE];
+	float y[BLOCK_SIZE];
+	float z[BLOCK_SIZE];
+};
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static void
+fold_part(const struct m_imu_pre_filter_part *part, const struct xrt_matrix_3x3 *m, struct folded_part *out)
+{
+	// transform * gain * (raw * ticks_to_float - bias)
+	const float scale[3] = {
+	    part->gain.x * part->ticks_to_float,
+	    part->gain.y * part->ticks_to_float,
+	    part->gain.z * part->ticks_to_float,
+	};
+	const float gained_bias[3] = {
+	    part->gain.x * part->bias.x,
+	    part->gain.y * part->bias.y,
+	    part->gain.z * part->bias.z,
+	};
+
+	for (int r = 0; r < 3; r++) {
+		out->offset[r] = 0.0f;
+		for (int c = 0; c < 3; c++) {
+			out->mat[r * 3 + c] = m->v[r * 3 + c] * scale[c];
+			out->offset[r] -= m->v[r * 3 + c] * gained_bias[c];
+		}
+	}
+}
+
+static void
+apply_block(const struct folded_part *f, const struct raw_block *b, uint32_t count, struct xrt_vec3 *out)
+{
+	float x[BLOCK_SIZE];
+	float y[BLOCK_SIZE];
+	float z[BLOCK_SIZE];
+
+	for (uint32_t i = 0; i < count; i++) {
+		x[i] = f->mat[0] * b->x[i] + f->mat[1] * b->y[i] + f->mat[2] * b->z[i] + f->offset[0];
+		y[i] = f->mat[3] * b->x[i] + f->mat[4] * b->y[i] + f->mat[5] * b->z[i] + f->offset[1];
+		z[i] = f->mat[6] * b->x[i] + f->mat[7] * b->y[i] + f->mat[8] * b->z[i] + f->offset[2];
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		out[i].x = x[i];
+		out[i].y = y[i];
+		out[i].z = z[i];
+	}
+}
+
+static inline float
+read_le16(const uint8_t *data)
+{
+	return (float)(int16_t)((uint16_t)data[0] | ((uint16_t)data[1] << 8));
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+
 void
 m_imu_pre_filter_init(struct m_imu_pre_filter *imu, float ticks_to_float_accel, float ticks_to_float_gyro)
 {
@@ -96,3 +183,70 @@ m_imu_pre_filter_data(struct m_imu_pre_filter *imu,
 	*out_accel = a;
 	*out_gyro = g;
 }
+
+void
+m_imu_pre_filter_data_batch(struct m_imu_pre_filter *imu,
+                            const struct xrt_vec3_i32 *accels,
+                            const struct xrt_vec3_i32 *gyros,
+                            uint32_t count,
+                            struct xrt_vec3 *out_accels,
+                            struct xrt_vec3 *out_gyros)
+{
+	struct folded_part fa;
+	struct folded_part fg;
+	fold_part(&imu->accel, &imu->transform, &fa);
+	fold_part(&imu->gyro, &imu->transform, &fg);
+
+	struct raw_block a;
+	struct raw_block g;
+
+	for (uint32_t start = 0; start < count; start += BLOCK_SIZE) {
+		uint32_t n = count - start < BLOCK_SIZE ? count - start : BLOCK_SIZE;
+
+		for (uint32_t i = 0; i < n; i++) {
+			a.x[i] = (float)accels[start + i].x;
+			a.y[i] = (float)accels[start + i].y;
+			a.z[i] = (float)accels[start + i].z;
+			g.x[i] = (float)gyros[start + i].x;
+			g.y[i] = (float)gyros[start + i].y;
+			g.z[i] = (float)gyros[start + i].z;
+		}
+
+		apply_block(&fa, &a, n, &out_accels[start]);
+		apply_block(&fg, &g, n, &out_gyros[start]);
+	}
+}
+
+void
+m_imu_pre_filter_data_le16(struct m_imu_pre_filter *imu,
+                           const uint8_t *data,
+                           size_t stride,
+                           uint32_t count,
+                           struct xrt_vec3 *out_accels,
+                           struct xrt_vec3 *out_gyros)
+{
+	struct folded_part fa;
+	struct folded_part fg;
+	fold_part(&imu->accel, &imu->transform, &fa);
+	fold_part(&imu->gyro, &imu->transform, &fg);
+
+	struct raw_block a;
+	struct raw_block g;
+
+	for (uint32_t start = 0; start < count; start += BLOCK_SIZE) {
+		uint32_t n = count - start < BLOCK_SIZE ? count - start : BLOCK_SIZE;
+
+		for (uint32_t i = 0; i < n; i++) {
+			const uint8_t *sample = data + (start + i) * stride;
+			a.x[i] = read_le16(sample + 0);
+			a.y[i] = read_le16(sample + 2);
+			a.z[i] = read_le16(sample + 4);
+			g.x[i] = read_le16(sample + 6);
+			g.y[i] = read_le16(sample + 8);
+			g.z[i] = read_le16(sample + 10);
+		}
+
+		apply_block(&fa, &a, n, &out_accels[start]);
+		apply_block(&fg, &g, n, &out_gyros[start]);
+	}
+}
@@ -82,6 +82,34 @@ m_imu_pre_filter_data(struct m_imu_pre_filter *imu,
                       struct xrt_vec3 *out_accel,
                       struct xrt_vec3 *out_gyro);
 
+/*!
+ * Same as calling @ref m_imu_pre_filter_data for each sample, for drivers that
+ * get several samples per packet. The bias, gain, tick scale and transform are
+ * folded into one matrix and offset per part once per call, then applied to
+ * blocks of samples at a time over arrays, which the compiler can vectorize.
+ * Results can differ from the single sample function in the last bits.
+ */
+void
+m_imu_pre_filter_data_batch(struct m_imu_pre_filter *imu,
+                            const struct xrt_vec3_i32 *accels,
+                            const struct xrt_vec3_i32 *gyros,
+                            uint32_t count,
+                            struct xrt_vec3 *out_accels,
+                            struct xrt_vec3 *out_gyros);
+
+/*!
+ * Batch pre-filter straight from a packet, sample @p i starts @p stride bytes
+ * after sample @p i - 1 at @p data and is six signed little endian 16 bit
+ * values: accel x, y, z then gyro x, y, z. No alignment is needed.
+ */
+void
+m_imu_pre_filter_data_le16(struct m_imu_pre_filter *imu,
+                           const uint8_t *data,
+                           size_t stride,
+                           uint32_t count,
+                           struct xrt_vec3 *out_accels,
+                           struct xrt_vec3 *out_gyros);
+
 
 #ifdef __cplusplus
 }
@@ -19,7 +19,7 @@
 #include "util/u_trace_marker.h"
 #include "xrt/xrt_defines.h"
 #include "os/os_threading.h"
-#include "util/u_template_historybuf.hpp"
+#include "util/u_template_historybuf_impl_helpers.hpp"
 
 #include <memory>
 #include <algorithm>
@@ -28,30 +28,333 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <assert.h>
+#include <atomic>
 #include <mutex>
 
 using namespace xrt::auxiliary::util;
 namespace os = xrt::auxiliary::os;
 
-struct relation_history_entry
-{
-	struct xrt_space_relation relation;
-	uint64_t timestamp;
-};
+/*!
+ * How many times a reader retries an optimistic read before giving up and
+ * taking the writer lock, this guarantees progress for readers even when
+ * a writer is pushing at a very high rate.
+ */
+static constexpr int MaxOptimisticReads = 16;
 
-static constexpr size_t BufLen = 4096;
+/*!
+ * How many elements to walk linearly from the last position when doing
+ * batched lookups, before falling back to a binary search of the remainder.
+ */
+static constexpr size_t MaxLinearSteps = 8;
 
+/*!
+ * The history is a ring buffer stored as a struct of arrays: the timestamps
+ * live in their own contiguous array, so searching only touches the 8 bytes
+ * per entry it actually compares against, the relations are only read for
+ * the one or two entries that we end up using.
+ *
+ * It is protected by a sequence lock: writers (push and clear) are serialised
+ * on @ref mutex and bump @ref sequence before and after touching the buffer,
+ * leaving it odd while the buffer is being modified. Readers don't take the
+ * mutex, they take a copy of the ring buffer bookkeeping, do their lookup and
+ * then check that the sequence has not changed, retrying if it has. All
+ * indices are reduced modulo the fixed capacity, so a read racing a write can
+ * return garbage (which is thrown away) but never touches memory outside of
+ * the arrays.
+ */
 struct m_relation_history
 {
-	HistoryBuffer<struct relation_history_entry, BufLen> impl;
+	m_relation_history(size_t capacity)
+	    : timestamps(new uint64_t[capacity]()), relations(new xrt_space_relation[capacity]()), helper(capacity)
+	{}
+
+	std::unique_ptr<uint64_t[]> timestamps;
+	std::unique_ptr<xrt_space_relation[]> relations;
+	detail::RingBufferHelper helper;
+
+	std::atomic<uint64_t> sequence{0};
 	os::Mutex mutex;
 };
 
+/*!
+ * A consistent (as long as the sequence didn't change while it was used) view
+ * of the history, use it to get from chronological to inner indices.
+ */
+struct history_view
+{
+	const struct m_relation_history *rh;
+	detail::RingBufferHelper helper;
+
+	explicit history_view(const struct m_relation_history *rh_) : rh(rh_), helper(rh_->helper) {}
+
+	size_t
+	size() const noexcept
+	{
+		return helper.size();
+	}
+
+	size_t
+	inner(size_t index) const noexcept
+	{
+		size_t inner_index = 0;
+		helper.index_to_inner_index(index, inner_index);
+		return inner_index;
+	}
+
+	uint64_t
+	timestamp(size_t index) const noexcept
+	{
+		return rh->timestamps[inner(index)];
+	}
+
+	const xrt_space_relation &
+	relation(size_t index) const noexcept
+	{
+		return rh->relations[inner(index)];
+	}
+
+	/*!
+	 * Find the first index in [first, size()) whose timestamp is *not less than* @p at_timestamp_ns.
+	 *
+	 * Searches the timestamps as the (at most) two contiguous spans of the ring buffer, so the search runs over
+	 * plain pointers without translating every index.
+	 */
+	size_t
+	find_not_less(size_t first, uint64_t at_timestamp_ns) const noexcept
+	{
+		size_t first_inner = 0;
+		size_t first_count = 0;
+		size_t second_count = 0;
+		helper.spans(first_inner, first_count, second_count);
+
+		const uint64_t *ts = rh->timestamps.get();
+
+		if (first < first_count) {
+			const uint64_t *begin = ts + first_inner;
+			const uint64_t *end = begin + first_count;
+			const uint64_t *found = std::lower_bound(begin + first, end, at_timestamp_ns);
+			if (found != end || second_count == 0) {
+				return static_cast<size_t>(found - begin);
+			}
+			first = first_count;
+		}
+
+		const uint64_t *end = ts + second_count;
+		const uint64_t *found = std::lower_bound(ts + (first - first_count), end, at_timestamp_ns);
+		return first_count + static_cast<size_t>(found - ts);
+	}
+};
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+//! Must be called with the mutex held.
+static inline void
+write_begin(struct m_relation_history *rh)
+{
+	rh->sequence.fetch_add(1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+//! Must be called with the mutex held.
+static inline void
+write_end(struct m_relation_history *rh)
+{
+	rh->sequence.fetch_add(1, std::memory_order_release);
+}
+
+/*!
+ * Run @p func, which must only read from the history and not have any side
+ * effects outside of its own captured temporaries, until it has seen a
+ * consistent state of the buffer. Falls back to taking the lock.
+ */
+template <typename Func>
+static inline auto
+read_consistent(struct m_relation_history *rh, Func &&func) -> decltype(func())
+{
+	for (int i = 0; i < MaxOptimisticReads; i++) {
+		uint64_t before = rh->sequence.load(std::memory_order_acquire);
+		if ((before & 1) != 0) {
+			// A writer is in the middle of modifying the buffer.
+			continue;
+		}
+
+		auto ret = func();
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (rh->sequence.load(std::memory_order_relaxed) == before) {
+			return ret;
+		}
+	}
+
+	std::unique_lock<os::Mutex> lock(rh->mutex);
+	return func();
+}
+
+/*!
+ * Produce the relation for @p at_timestamp_ns given @p index, the first
+ * element not less than it as found by @ref history_view::find_not_less.
+ * The view must not be empty.
+ */
+static enum m_relation_history_result
+get_at_index(const history_view &view, size_t index, uint64_t at_timestamp_ns, struct xrt_space_relation *out_relation)
+{
+	const size_t size = view.size();
+
+	if (index == size) {
+		// lower bound is at the end:
+		// The desired timestamp is after what our buffer contains.
+		// (pose-prediction)
+		int64_t diff_prediction_ns = static_cast<int64_t>(at_timestamp_ns) - view.timestamp(size - 1);
+		double delta_s = time_ns_to_s(diff_prediction_ns);
+
+		U_LOG_T_RATELIMITED("Extrapolating %f s past the back of the buffer!", delta_s);
+
+		m_predict_relation(&view.relation(size - 1), delta_s, out_relation);
+		return M_RELATION_HISTORY_RESULT_PREDICTED;
+	}
+	if (at_timestamp_ns == view.timestamp(index)) {
+		// exact match
+		U_LOG_T("Exact match in the buffer!");
+		*out_relation = view.relation(index);
+		return M_RELATION_HISTORY_RESULT_EXACT;
+	}
+	if (index == 0) {
+		// lower bound is at the beginning (and it's not an exact match):
+		// The desired timestamp is before what our buffer contains.
+		// (an edge case where somebody asks for a really old pose and we do our best)
+		int64_t diff_prediction_ns = static_cast<int64_t>(at_timestamp_ns) - view.timestamp(0);
+		double delta_s = time_ns_to_s(diff_prediction_ns);
+		U_LOG_T_RATELIMITED("Extrapolating %f s before the front of the buffer!", delta_s);
+		m_predict_relation(&view.relation(0), delta_s, out_relation);
+		return M_RELATION_HISTORY_RESULT_REVERSE_PREDICTED;
+	}
+	U_LOG_T("Interpolating within buffer!");
+
+	// We precede index and follow index - 1 (which we know exists because we already handled
+	// the index = 0 case)
+	const auto &predecessor = view.relation(index - 1);
+	const auto &successor = view.relation(index);
+
+	// Do the thing.
+	int64_t diff_before = static_cast<int64_t>(at_timestamp_ns) - view.timestamp(index - 1);
+	int64_t diff_after = static_cast<int64_t>(view.timestamp(index)) - at_timestamp_ns;
+
+	float amount_to_lerp = (float)diff_before / (float)(diff_before + diff_after);
+
+	// Copy relation flags
+	xrt_space_relation result{};
+	result.relation_flags =
+	    (enum xrt_space_relation_flags)(predecessor.relation_flags & successor.relation_flags);
+	// First-order implementation - lerp between the before and after
+	if (0 != (result.relation_flags & XRT_SPACE_RELATION_POSITION_VALID_BIT)) {
+		result.pose.position = m_vec3_lerp(predecessor.pose.position, successor.pose.position, amount_to_lerp);
+	}
+	if (0 != (result.relation_flags & XRT_SPACE_RELATION_ORIENTATION_VALID_BIT)) {
+
+		math_quat_slerp(&predecessor.pose.orientation, &successor.pose.orientation, amount_to_lerp,
+		                &result.pose.orientation);
+	}
+
+	//! @todo Does interpolating the velocities make any sense?
+	if (0 != (result.relation_flags & XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT)) {
+		result.angular_velocity =
+		    m_vec3_lerp(predecessor.angular_velocity, successor.angular_velocity, amount_to_lerp);
+	}
+	if (0 != (result.relation_flags & XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT)) {
+		result.linear_velocity =
+		    m_vec3_lerp(predecessor.linear_velocity, successor.linear_velocity, amount_to_lerp);
+	}
+	*out_relation = result;
+	return M_RELATION_HISTORY_RESULT_INTERPOLATED;
+}
+
+static enum m_relation_history_result
+get_impl(const struct m_relation_history *rh, uint64_t at_timestamp_ns, struct xrt_space_relation *out_relation)
+{
+	const history_view view(rh);
+
+	if (view.size() == 0 || at_timestamp_ns == 0) {
+		// Do nothing. You push nothing to the buffer you get nothing from the buffer.
+		*out_relation = {};
+		return M_RELATION_HISTORY_RESULT_INVALID;
+	}
+
+	size_t index = view.find_not_less(0, at_timestamp_ns);
+
+	return get_at_index(view, index, at_timestamp_ns, out_relation);
+}
+
+static void
+get_many_impl(const struct m_relation_history *rh,
+              const uint64_t *at_timestamps_ns,
+              uint32_t count,
+              struct xrt_space_relation *out_relations,
+              enum m_relation_history_result *out_results)
+{
+	const history_view view(rh);
+	const size_t size = view.size();
+
+	size_t index = 0;
+	uint64_t last_timestamp_ns = 0;
+
+	for (uint32_t i = 0; i < count; i++) {
+		uint64_t ts = at_timestamps_ns[i];
+		enum m_relation_history_result result = M_RELATION_HISTORY_RESULT_INVALID;
+
+		if (size == 0 || ts == 0) {
+			out_relations[i] = {};
+		} else {
+			if (ts < last_timestamp_ns) {
+				// Not sorted, start over from the front.
+				index = 0;
+			}
+
+			// Sorted inputs are usually close to each other, so try a few steps before searching.
+			size_t steps = 0;
+			while (index < size && view.timestamp(index) < ts && steps < MaxLinearSteps) {
+				++index;
+				++steps;
+			}
+			if (index < size && view.timestamp(index) < ts) {
+				index = view.find_not_less(index, ts);
+			}
+
+			last_timestamp_ns = ts;
+			result = get_at_index(view, index, ts, &out_relations[i]);
+		}
+
+		if (out_results != NULL) {
+			out_results[i] = result;
+		}
+	}
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
 
 void
 m_relation_history_create(struct m_relation_history **rh_ptr)
 {
-	auto ret = std::make_unique<m_relation_history>();
+	m_relation_history_create_with_capacity(rh_ptr, M_RELATION_HISTORY_DEFAULT_CAPACITY);
+}
+
+void
+m_relation_history_create_with_capacity(struct m_relation_history **rh_ptr, uint32_t capacity)
+{
+	if (capacity < 2) {
+		U_LOG_W("Capacity %u is too small to interpolate, using 2", capacity);
+		capacity = 2;
+	}
+
+	auto ret = std::make_unique<m_relation_history>(capacity);
 	*rh_ptr = ret.release();
 }
 
@@ -59,18 +362,19 @@ bool
 m_relation_history_push(struct m_relation_history *rh, struct xrt_space_relation const *in_relation, uint64_t timestamp)
 {
 	XRT_TRACE_MARKER();
-	struct relation_history_entry rhe;
-	rhe.relation = *in_relation;
-	rhe.timestamp = timestamp;
 	bool ret = false;
 	std::unique_lock<os::Mutex> lock(rh->mutex);
 	try {
 		// if we aren't empty, we can compare against the latest timestamp.
-		if (rh->impl.empty() || rhe.timestamp > rh->impl.back().timestamp) {
+		if (rh->helper.empty() || timestamp > rh->timestamps[rh->helper.back_inner_index()]) {
 			// Everything explodes if the timestamps in relation_history aren't monotonically increasing. If
 			// we get a timestamp that's before the most recent timestamp in the buffer, don't put it
 			// in the history.
-			rh->impl.push_back(rhe);
+			write_begin(rh);
+			size_t inner_index = rh->helper.push_back_location();
+			rh->timestamps[inner_index] = timestamp;
+			rh->relations[inner_index] = *in_relation;
+			write_end(rh);
 			ret = true;
 		}
 	} catch (std::exception const &e) {
@@ -83,97 +387,43 @@ enum m_relation_history_result
 m_relation_history_get(struct m_relation_history *rh, uint64_t at_timestamp_ns, struct xrt_space_relation *out_relation)
 {
 	XRT_TRACE_MARKER();
-	std::unique_lock<os::Mutex> lock(rh->mutex);
 	try {
-		if (rh->impl.empty() || at_timestamp_ns == 0) {
-			// Do nothing. You push nothing to the buffer you get nothing from the buffer.
-			*out_relation = {};
-			return M_RELATION_HISTORY_RESULT_INVALID;
-		}
-		const auto b = rh->impl.begin();
-		const auto e = rh->impl.end();
-
-		// find the first element *not less than* our value. the lambda we pass is the comparison
-		// function, to compare against timestamps.
-		const auto it =
-		    std::lower_bound(b, e, at_timestamp_ns, [](const relation_history_entry &rhe, uint64_t timestamp) {
-			    return rhe.timestamp < timestamp;
-		    });
-
-		if (it == e) {
-			// lower bound is at the end:
-			// The desired timestamp is after what our buffer contains.
-			// (pose-prediction)
-			int64_t diff_prediction_ns = static_cast<int64_t>(at_timestamp_ns) - rh->impl.back().timestamp;
-			double delta_s = time_ns_to_s(diff_prediction_ns);
-
-			U_LOG_T("Extrapolating %f s past the back of the buffer!", delta_s);
-
-			m_predict_relation(&rh->impl.back().relation, delta_s, out_relation);
-			return M_RELATION_HISTORY_RESULT_PREDICTED;
-		}
-		if (at_timestamp_ns == it->timestamp) {
-			// exact match
-			U_LOG_T("Exact match in the buffer!");
-			*out_relation = it->relation;
-			return M_RELATION_HISTORY_RESULT_EXACT;
-		}
-		if (it == b) {
-			// lower bound is at the beginning (and it's not an exact match):
-			// The desired timestamp is before what our buffer contains.
-			// (an edge case where somebody asks for a really old pose and we do our best)
-			int64_t diff_prediction_ns = static_cast<int64_t>(at_timestamp_ns) - rh->impl.front().timestamp;
-			double delta_s = time_ns_to_s(diff_prediction_ns);
-			U_LOG_T("Extrapolating %f s before the front of the buffer!", delta_s);
-			m_predict_relation(&rh->impl.front().relation, delta_s, out_relation);
-			return M_RELATION_HISTORY_RESULT_REVERSE_PREDICTED;
-		}
-		U_LOG_T("Interpolating within buffer!");
-
-		// We precede *it and follow *(it - 1) (which we know exists because we already handled
-		// the it = begin() case)
-		const auto &predecessor = *(it - 1);
-		const auto &successor = *it;
-
-		// Do the thing.
-		int64_t diff_before = static_cast<int64_t>(at_timestamp_ns) - predecessor.timestamp;
-		int64_t diff_after = static_cast<int64_t>(successor.timestamp) - at_timestamp_ns;
-
-		float amount_to_lerp = (float)diff_before / (float)(diff_before + diff_after);
-
-		// Copy relation flags
-		xrt_space_relation result{};
-		result.relation_flags = (enum xrt_space_relation_flags)(predecessor.relation.relation_flags &
-		                                                        successor.relation.relation_flags);
-		// First-order implementation - lerp between the before and after
-		if (0 != (result.relation_flags & XRT_SPACE_RELATION_POSITION_VALID_BIT)) {
-			result.pose.position = m_vec3_lerp(predecessor.relation.pose.position,
-			                                   successor.relation.pose.position, amount_to_lerp);
-		}
-		if (0 != (result.relation_flags & XRT_SPACE_RELATION_ORIENTATION_VALID_BIT)) {
-
-			math_quat_slerp(&predecessor.relation.pose.orientation, &successor.relation.pose.orientation,
-			                amount_to_lerp, &result.pose.orientation);
-		}
-
-		//! @todo Does interpolating the velocities make any sense?
-		if (0 != (result.relation_flags & XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT)) {
-			result.angular_velocity = m_vec3_lerp(predecessor.relation.angular_velocity,
-			                                      successor.relation.angular_velocity, amount_to_lerp);
-		}
-		if (0 != (result.relation_flags & XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT)) {
-			result.linear_velocity = m_vec3_lerp(predecessor.relation.linear_velocity,
-			                                     successor.relation.linear_velocity, amount_to_lerp);
-		}
-		*out_relation = result;
-		return M_RELATION_HISTORY_RESULT_INTERPOLATED;
-
+		struct xrt_space_relation tmp = XRT_SPACE_RELATION_ZERO;
+		enum m_relation_history_result ret =
+		    read_consistent(rh, [&]() { return get_impl(rh, at_timestamp_ns, &tmp); });
+		*out_relation = tmp;
+		return ret;
 	} catch (std::exception const &e) {
 		U_LOG_E("Caught exception: %s", e.what());
 		return M_RELATION_HISTORY_RESULT_INVALID;
 	}
 }
 
+void
+m_relation_history_get_many(struct m_relation_history *rh,
+                            const uint64_t *at_timestamps_ns,
+                            uint32_t count,
+                            struct xrt_space_relation *out_relations,
+                            enum m_relation_history_result *out_results)
+{
+	XRT_TRACE_MARKER();
+	try {
+		// Outputs are only read by the caller once we return, so retries can just overwrite them.
+		read_consistent(rh, [&]() {
+			get_many_impl(rh, at_timestamps_ns, count, out_relations, out_results);
+			return true;
+		});
+	} catch (std::exception const &e) {
+		U_LOG_E("Caught exception: %s", e.what());
+		for (uint32_t i = 0; i < count; i++) {
+			out_relations[i] = {};
+			if (out_results != NULL) {
+				out_results[i] = M_RELATION_HISTORY_RESULT_INVALID;
+			}
+		}
+	}
+}
+
 bool
 m_relation_history_estimate_motion(struct m_relation_history *rh,
                                    const struct xrt_space_relation *in_relation,
@@ -226,26 +476,45 @@ m_relation_history_get_latest(struct m_relation_history *rh,
                               uint64_t *out_time_ns,
                               struct xrt_space_relation *out_relation)
 {
-	std::unique_lock<os::Mutex> lock(rh->mutex);
-	if (rh->impl.empty()) {
+	uint64_t latest_time_ns = 0;
+	struct xrt_space_relation latest = XRT_SPACE_RELATION_ZERO;
+	bool has_latest = read_consistent(rh, [&]() {
+		const history_view view(rh);
+		if (view.size() == 0) {
+			return false;
+		}
+		latest_time_ns = view.timestamp(view.size() - 1);
+		latest = view.relation(view.size() - 1);
+		return true;
+	});
+
+	if (!has_latest) {
 		return false;
 	}
-	*out_relation = rh->impl.back().relation;
-	*out_time_ns = rh->impl.back().timestamp;
+	*out_relation = latest;
+	*out_time_ns = latest_time_ns;
 	return true;
 }
 
+uint32_t
+m_relation_history_get_capacity(const struct m_relation_history *rh)
+{
+	return (uint32_t)rh->helper.capacity();
+}
+
 uint32_t
 m_relation_history_get_size(const struct m_relation_history *rh)
 {
-	return (uint32_t)rh->impl.size();
+	return (uint32_t)rh->helper.size();
 }
 
 void
 m_relation_history_clear(struct m_relation_history *rh)
 {
 	std::unique_lock<os::Mutex> lock(rh->mutex);
-	rh->impl.clear();
+	write_begin(rh);
+	rh->helper.clear();
+	write_end(rh);
 }
 
 void
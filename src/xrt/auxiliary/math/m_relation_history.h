@@ -15,6 +15,14 @@
 extern "C" {
 #endif
 
+/*!
+ * The capacity used by @ref m_relation_history_create, enough for about 4
+ * seconds of history at 1kHz.
+ *
+ * @relates m_relation_history
+ */
+#define M_RELATION_HISTORY_DEFAULT_CAPACITY (4096)
+
 /**
  * @brief Opaque type for storing the history of a space relation in a ring buffer
  *
@@ -37,13 +45,24 @@ enum m_relation_history_result
 };
 
 /*!
- * Creates an opaque relation_history object.
+ * Creates an opaque relation_history object, with a capacity of
+ * @ref M_RELATION_HISTORY_DEFAULT_CAPACITY.
  *
  * @public @memberof m_relation_history
  */
 void
 m_relation_history_create(struct m_relation_history **rh);
 
+/*!
+ * Creates an opaque relation_history object that holds at most @p capacity
+ * relations, use this for low rate sources that don't need the default
+ * capacity. A capacity smaller than 2 is raised to 2.
+ *
+ * @public @memberof m_relation_history
+ */
+void
+m_relation_history_create_with_capacity(struct m_relation_history **rh, uint32_t capacity);
+
 /*!
  * Pushes a new pose to the history.
  *
@@ -62,7 +81,7 @@ m_relation_history_push(struct m_relation_history *rh,
  * Interpolates or extrapolates to the desired timestamp.
  *
  * Read-only operation - doesn't remove anything from the buffer or anything like that - you can call this as often as
- * you want.
+ * you want. Readers never block @ref m_relation_history_push, they retry if a push happened while they were reading.
  *
  * @public @memberof m_relation_history
  */
@@ -71,6 +90,30 @@ m_relation_history_get(struct m_relation_history *rh,
                        uint64_t at_timestamp_ns,
                        struct xrt_space_relation *out_relation);
 
+/*!
+ * Interpolates or extrapolates to a number of timestamps at once, this gives
+ * the same results as calling @ref m_relation_history_get for each of them,
+ * but all of them are looked up from the same consistent state of the buffer.
+ *
+ * Sorted (ascending) timestamps are the fast path, the buffer is walked
+ * forwards from the last found position instead of being searched from
+ * scratch for every timestamp. Unsorted timestamps work but are slower.
+ *
+ * @param rh self
+ * @param at_timestamps_ns Array of @p count timestamps to look up.
+ * @param count Number of timestamps.
+ * @param[out] out_relations Array of @p count relations to write to.
+ * @param[out] out_results Optional (may be NULL) array of @p count results.
+ *
+ * @public @memberof m_relation_history
+ */
+void
+m_relation_history_get_many(struct m_relation_history *rh,
+                            const uint64_t *at_timestamps_ns,
+                            uint32_t count,
+                            struct xrt_space_relation *out_relations,
+                            enum m_relation_history_result *out_results);
+
 /*!
  * Estimates the movement (velocity and angular velocity) of a new relation based on
  * the latest relation found in the buffer (as returned by m_relation_history_get_latest).
@@ -103,6 +146,14 @@ m_relation_history_get_latest(struct m_relation_history *rh,
                               uint64_t *out_time_ns,
                               struct xrt_space_relation *out_relation);
 
+/*!
+ * Returns the maximum number of items the history can hold.
+ *
+ * @public @memberof m_relation_history
+ */
+uint32_t
+m_relation_history_get_capacity(const struct m_relation_history *rh);
+
 /*!
  * Returns the number of items in the history.
  *
@@ -156,6 +207,7 @@ private:
 public:
 	// clang-format off
 	RelationHistory() noexcept { m_relation_history_create(&mPtr); }
+	explicit RelationHistory(uint32_t capacity) noexcept { m_relation_history_create_with_capacity(&mPtr, capacity); }
 	~RelationHistory() { m_relation_history_destroy(&mPtr); }
 	// clang-format on
 
@@ -186,6 +238,18 @@ public:
 		return m_relation_history_get(mPtr, at_time_ns, out_relation);
 	}
 
+	/*!
+	 * @copydoc m_relation_history_get_many
+	 */
+	void
+	get_many(const uint64_t *at_timestamps_ns,
+	         uint32_t count,
+	         xrt_space_relation *out_relations,
+	         Result *out_results = nullptr) noexcept
+	{
+		m_relation_history_get_many(mPtr, at_timestamps_ns, count, out_relations, out_results);
+	}
+
 	/*!
 	 * @copydoc m_relation_history_get_latest
 	 */
@@ -204,6 +268,15 @@ public:
 		return m_relation_history_get_size(mPtr);
 	}
 
+	/*!
+	 * @copydoc m_relation_history_get_capacity
+	 */
+	size_t
+	capacity() const noexcept
+	{
+		return m_relation_history_get_capacity(mPtr);
+	}
+
 	/*!
 	 * @copydoc m_relation_history_clear
 	 */
@@ -29,6 +29,14 @@ struct os_hid_device
 {
 	int (*read)(struct os_hid_device *hid_dev, uint8_t *data, size_t size, int milliseconds);
 
+	//! Optional, @ref os_hid_read_batch falls back to @ref read if NULL.
+	int (*read_batch)(struct os_hid_device *hid_dev,
+	                  uint8_t *data,
+	                  size_t report_size,
+	                  size_t *out_sizes,
+	                  int max_reports,
+	                  int milliseconds);
+
 	int (*write)(struct os_hid_device *hid_dev, const uint8_t *data, size_t size);
 
 	int (*get_feature)(struct os_hid_device *hid_dev, uint8_t report_num, uint8_t *data, size_t size);
@@ -56,6 +64,37 @@ os_hid_read(struct os_hid_device *hid_dev, uint8_t *data, size_t size, int milli
 	return hid_dev->read(hid_dev, data, size, milliseconds);
 }
 
+/*!
+ * Read all input reports that are available, up to @p max_reports, waiting
+ * for the first one like @ref os_hid_read does.
+ *
+ * Report i is stored at `data + i * report_size` and its size in
+ * `out_sizes[i]`. Returns the number of reports read, 0 on timeout and
+ * negative on error; an error after the first report is returned by the
+ * next call instead.
+ *
+ * @public @memberof os_hid_device
+ */
+static inline int
+os_hid_read_batch(struct os_hid_device *hid_dev,
+                  uint8_t *data,
+                  size_t report_size,
+                  size_t *out_sizes,
+                  int max_reports,
+                  int milliseconds)
+{
+	if (hid_dev->read_batch != NULL) {
+		return hid_dev->read_batch(hid_dev, data, report_size, out_sizes, max_reports, milliseconds);
+	}
+
+	int ret = hid_dev->read(hid_dev, data, report_size, milliseconds);
+	if (ret <= 0) {
+		return ret;
+	}
+	out_sizes[0] = (size_t)ret;
+	return 1;
+}
+
 /*!
  * Write an output report to the given device.
  *
@@ -45,20 +45,19 @@ os_hidraw_read(struct os_hid_device *ohdev, uint8_t *data, size_t length, int mi
 	struct pollfd fds;
 	int ret;
 
-	if (milliseconds >= 0) {
-		fds.fd = hrdev->fd;
-		fds.events = POLLIN;
-		fds.revents = 0;
-		ret = poll(&fds, 1, milliseconds);
-
-		if (ret == -1 || ret == 0) {
-			// Error or timeout.
-			return ret;
-		}
-		if (fds.revents & (POLLERR | POLLHUP | POLLNVAL)) {
-			// Device disconnect?
-			return -1;
-		}
+	// The fd is non-blocking, a negative timeout makes poll block indefinitely.
+	fds.fd = hrdev->fd;
+	fds.events = POLLIN;
+	fds.revents = 0;
+	ret = poll(&fds, 1, milliseconds);
+
+	if (ret == -1 || ret == 0) {
+		// Error or timeout.
+		return ret;
+	}
+	if (fds.revents & (POLLERR | POLLHUP | POLLNVAL)) {
+		// Device disconnect?
+		return -1;
 	}
 
 	ret = read(hrdev->fd, data, length);
@@ -71,6 +70,36 @@ os_hidraw_read(struct os_hid_device *ohdev, uint8_t *data, size_t length, int mi
 	return ret;
 }
 
+static int
+os_hidraw_read_batch(struct os_hid_device *ohdev,
+                     uint8_t *data,
+                     size_t report_size,
+                     size_t *out_sizes,
+                     int max_reports,
+                     int milliseconds)
+{
+	struct hid_hidraw *hrdev = (struct hid_hidraw *)ohdev;
+
+	int ret = os_hidraw_read(ohdev, data, report_size, milliseconds);
+	if (ret <= 0) {
+		return ret;
+	}
+	out_sizes[0] = (size_t)ret;
+
+	// Keep reading until the queue is empty, one syscall per report instead of two.
+	int count = 1;
+	while (count < max_reports) {
+		ret = read(hrdev->fd, data + count * report_size, report_size);
+		if (ret <= 0) {
+			// EAGAIN means it's empty, real errors come back on the next call.
+			break;
+		}
+		out_sizes[count++] = (size_t)ret;
+	}
+
+	return count;
+}
+
 static int
 os_hidraw_write(struct os_hid_device *ohdev, const uint8_t *data, size_t length)
 {
@@ -141,13 +170,14 @@ os_hid_open_hidraw(const char *path, struct os_hid_device **out_hid)
 	struct hid_hidraw *hrdev = U_TYPED_CALLOC(struct hid_hidraw);
 
 	hrdev->base.read = os_hidraw_read;
+	hrdev->base.read_batch = os_hidraw_read_batch;
 	hrdev->base.write = os_hidraw_write;
 	hrdev->base.get_feature = os_hidraw_get_feature;
 	hrdev->base.get_feature_timeout = os_hidraw_get_feature_timeout;
 	hrdev->base.set_feature = os_hidraw_set_feature;
 	hrdev->base.get_physical_address = os_hidraw_get_physical_address;
 	hrdev->base.destroy = os_hidraw_destroy;
-	hrdev->fd = open(path, O_RDWR);
+	hrdev->fd = open(path, O_RDWR | O_NONBLOCK);
 	if (hrdev->fd < 0) {
 		free(hrdev);
 		return -errno;
@@ -0,0 +1,246 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Non-inline OS threading functions, core class pinning.
+ *
+ * @ingroup aux_os
+ */
+
+#include "os/os_threading.h"
+
+#include <string.h>
+
+#if defined(XRT_OS_LINUX)
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#define OS_THREAD_HAVE_AFFINITY
+#endif
+
+
+/*
+ *
+ * Core class detection.
+ *
+ */
+
+#ifdef OS_THREAD_HAVE_AFFINITY
+
+struct core_classes
+{
+	//! Has the system more then one class of cores.
+	bool hybrid;
+
+	cpu_set_t performance;
+
+	cpu_set_t efficiency;
+};
+
+static struct core_classes g_classes;
+static pthread_once_t g_classes_once = PTHREAD_ONCE_INIT;
+
+static bool
+read_u64_file(const char *path, uint64_t *out_value)
+{
+	FILE *file = fopen(path, "r");
+	if (file == NULL) {
+		return false;
+	}
+
+	unsigned long long value = 0;
+	bool ret = fscanf(file, "%llu", &value) == 1;
+	fclose(file);
+
+	*out_value = (uint64_t)value;
+
+	return ret;
+}
+
+/*!
+ * Parses lists like "0-7,16,18-19" as found in sysfs.
+ */
+static bool
+read_cpu_list_file(const char *path, cpu_set_t *out_set)
+{
+	FILE *file = fopen(path, "r");
+	if (file == NULL) {
+		return false;
+	}
+
+	CPU_ZERO(out_set);
+
+	bool found = false;
+	int first = 0;
+	while (fscanf(file, "%d", &first) == 1) {
+		int last = first;
+		int c = fgetc(file);
+		if (c == '-') {
+			if (fscanf(file, "%d", &last) != 1) {
+				break;
+			}
+			c = fgetc(file);
+		}
+
+		for (int i = first; i <= last && i < CPU_SETSIZE; i++) {
+			CPU_SET(i, out_set);
+			found = true;
+		}
+
+		if (c != ',') {
+			break;
+		}
+	}
+
+	fclose(file);
+
+	return found;
+}
+
+/*!
+ * Intel hybrid CPUs expose the two core types as separate PMUs.
+ */
+static bool
+detect_intel_hybrid(struct core_classes *classes)
+{
+	if (!read_cpu_list_file("/sys/devices/cpu_core/cpus", &classes->performance)) {
+		return false;
+	}
+
+	if (!read_cpu_list_file("/sys/devices/cpu_atom/cpus", &classes->efficiency)) {
+		return false;
+	}
+
+	return true;
+}
+
+/*!
+ * ARM big.LITTLE (and anything else) is classified by the per core capacity,
+ * falling back to the max frequency. Cores above the middle of the range are
+ * counted as performance cores, this keeps things like "prime" and "big"
+ * cores together.
+ */
+static bool
+detect_by_capacity(struct core_classes *classes)
+{
+	uint64_t scores[CPU_SETSIZE] = {0};
+	uint64_t min_score = UINT64_MAX;
+	uint64_t max_score = 0;
+	char path[128];
+
+	long count = sysconf(_SC_NPROCESSORS_CONF);
+	if (count <= 0 || count > CPU_SETSIZE) {
+		count = CPU_SETSIZE;
+	}
+
+	for (long i = 0; i < count; i++) {
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%li/cpu_capacity", i);
+		if (!read_u64_file(path, &scores[i])) {
+			snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%li/cpufreq/cpuinfo_max_freq", i);
+			if (!read_u64_file(path, &scores[i])) {
+				continue;
+			}
+		}
+
+		min_score = scores[i] < min_score ? scores[i] : min_score;
+		max_score = scores[i] > max_score ? scores[i] : max_score;
+	}
+
+	// No information or homogeneous.
+	if (max_score == 0 || min_score == max_score) {
+		return false;
+	}
+
+	uint64_t middle = min_score + (max_score - min_score) / 2;
+
+	CPU_ZERO(&classes->performance);
+	CPU_ZERO(&classes->efficiency);
+
+	for (long i = 0; i < count; i++) {
+		if (scores[i] == 0) {
+			continue;
+		}
+
+		if (scores[i] > middle) {
+			CPU_SET(i, &classes->performance);
+		} else {
+			CPU_SET(i, &classes->efficiency);
+		}
+	}
+
+	return true;
+}
+
+static void
+detect_core_classes(void)
+{
+	g_classes.hybrid = detect_intel_hybrid(&g_classes) || detect_by_capacity(&g_classes);
+}
+
+#endif // OS_THREAD_HAVE_AFFINITY
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+enum os_thread_core_class
+os_thread_core_class_from_string(const char *str, enum os_thread_core_class default_class)
+{
+	if (str == NULL) {
+		return default_class;
+	}
+	if (strcmp(str, "any") == 0) {
+		return OS_THREAD_CORE_CLASS_ANY;
+	}
+	if (strcmp(str, "performance") == 0) {
+		return OS_THREAD_CORE_CLASS_PERFORMANCE;
+	}
+	if (strcmp(str, "efficiency") == 0) {
+		return OS_THREAD_CORE_CLASS_EFFICIENCY;
+	}
+
+	return default_class;
+}
+
+int
+os_thread_native_set_core_class(pthread_t thread, enum os_thread_core_class core_class)
+{
+#ifdef OS_THREAD_HAVE_AFFINITY
+	if (core_class == OS_THREAD_CORE_CLASS_ANY) {
+		return 0;
+	}
+
+	pthread_once(&g_classes_once, detect_core_classes);
+
+	// Only one kind of core, nothing to pin to.
+	if (!g_classes.hybrid) {
+		return 0;
+	}
+
+	const cpu_set_t *set = NULL;
+	switch (core_class) {
+	case OS_THREAD_CORE_CLASS_PERFORMANCE: set = &g_classes.performance; break;
+	case OS_THREAD_CORE_CLASS_EFFICIENCY: set = &g_classes.efficiency; break;
+	default: return -1;
+	}
+
+#ifdef XRT_OS_ANDROID
+	// Bionic doesn't have pthread_setaffinity_np.
+	int ret = sched_setaffinity(pthread_gettid_np(thread), sizeof(*set), set);
+	return ret == 0 ? 0 : -1;
+#else
+	int ret = pthread_setaffinity_np(thread, sizeof(*set), set);
+	return ret == 0 ? 0 : -ret;
+#endif
+
+#else
+	(void)thread;
+	(void)core_class;
+
+	return 0;
+#endif
+}
@@ -220,6 +220,18 @@ os_cond_signal(struct os_cond *oc)
 	pthread_cond_signal(&oc->cond);
 }
 
+/*!
+ * Broadcast, wakes all threads waiting on the condition.
+ *
+ * @public @memberof os_cond
+ */
+static inline void
+os_cond_broadcast(struct os_cond *oc)
+{
+	assert(oc->initialized);
+	pthread_cond_broadcast(&oc->cond);
+}
+
 /*!
  * Wait.
  *
@@ -341,6 +353,59 @@ os_thread_name(struct os_thread *ost, const char *name)
 #endif
 }
 
+/*
+ *
+ * Core class.
+ *
+ */
+
+/*!
+ * Class of CPU cores a thread can be pinned to, on hybrid and big.LITTLE
+ * systems the cores have very different performance characteristics.
+ */
+enum os_thread_core_class
+{
+	//! Don't pin, the thread may run on any core.
+	OS_THREAD_CORE_CLASS_ANY = 0,
+
+	//! The faster cores of the system, for frame-time-critical work.
+	OS_THREAD_CORE_CLASS_PERFORMANCE,
+
+	//! The slower cores of the system, for background work.
+	OS_THREAD_CORE_CLASS_EFFICIENCY,
+};
+
+/*!
+ * Parse a core class from a string, accepts "any", "performance" and
+ * "efficiency", returns @p default_class for NULL or unknown strings.
+ *
+ * @ingroup aux_os
+ */
+enum os_thread_core_class
+os_thread_core_class_from_string(const char *str, enum os_thread_core_class default_class);
+
+/*!
+ * Make a best effort to pin the native @p thread to the given core class.
+ *
+ * If the system only has one class of cores, or the platform doesn't support
+ * pinning, nothing is done and zero is returned. Returns negative on error.
+ *
+ * @ingroup aux_os
+ */
+int
+os_thread_native_set_core_class(pthread_t thread, enum os_thread_core_class core_class);
+
+/*!
+ * Make a best effort to pin our thread to the given core class.
+ *
+ * @public @memberof os_thread
+ */
+static inline int
+os_thread_set_core_class(struct os_thread *ost, enum os_thread_core_class core_class)
+{
+	return os_thread_native_set_core_class(ost->thread, core_class);
+}
+
 /*
  *
  * Semaphore.
@@ -701,6 +766,18 @@ os_thread_helper_name(struct os_thread_helper *oth, const char *name)
 #endif
 }
 
+/*!
+ * Make a best effort to pin our thread to the given core class, the thread
+ * must have been started.
+ *
+ * @public @memberof os_thread_helper
+ */
+static inline int
+os_thread_helper_set_core_class(struct os_thread_helper *oth, enum os_thread_core_class core_class)
+{
+	return os_thread_native_set_core_class(oth->thread, core_class);
+}
+
 /*!
  * @}
  */
@@ -15,6 +15,11 @@
 
 #include "xrt/xrt_config_os.h"
 
+#include "os/os_time.h"
+
+#include <algorithm>
+#include <cstdint>
+
 #ifdef XRT_OS_WINDOWS
 
 #include <inttypes.h>
@@ -29,3 +34,110 @@ os_realtime_get_ns(void)
 	return ret;
 }
 #endif
+
+
+/*
+ *
+ * Hybrid sleeping.
+ *
+ */
+
+namespace {
+
+//! Never spin for less than this, covers the cost of reading the clock and entering the sleep.
+constexpr int64_t kMinSpinMarginNs = 20 * U_TIME_1US_IN_NS;
+
+//! Never spin for more than this, a wake-up later than this is the scheduler being busy, not latency.
+constexpr int64_t kMaxSpinMarginNs = 2 * U_TIME_1MS_IN_NS;
+
+//! Length and count of the calibration sleeps.
+constexpr int32_t kCalibrationSleepNs = 100 * U_TIME_1US_IN_NS;
+constexpr int kCalibrationCount = 10;
+
+//! Longest single sleep, os_precise_sleeper_nanosleep takes an int32_t.
+constexpr int64_t kMaxSleepNs = U_TIME_1S_IN_NS;
+
+//! A wait returning this late counts as late in the stats.
+constexpr int64_t kLateNs = 100 * U_TIME_1US_IN_NS;
+
+/*!
+ * Wake-up latency comes in bursts, so jump straight up to cover a new peak
+ * with some headroom but only slowly decay back down.
+ */
+void
+update_spin_margin(struct os_precise_sleeper *ops, int64_t latency_ns)
+{
+	int64_t wanted_ns = latency_ns + latency_ns / 4 + kMinSpinMarginNs;
+	int64_t margin_ns = ops->spin_margin_ns;
+
+	if (wanted_ns > margin_ns) {
+		margin_ns = wanted_ns;
+	} else {
+		margin_ns -= (margin_ns - wanted_ns) / 64;
+	}
+
+	ops->spin_margin_ns = std::clamp(margin_ns, kMinSpinMarginNs, kMaxSpinMarginNs);
+}
+
+void
+update_stats(struct os_precise_sleeper_stats *stats, int64_t oversleep_ns)
+{
+	stats->last_ns = oversleep_ns;
+	stats->max_ns = stats->count == 0 ? oversleep_ns : std::max(stats->max_ns, oversleep_ns);
+	stats->mean_ns = stats->count == 0 ? oversleep_ns : stats->mean_ns + (oversleep_ns - stats->mean_ns) / 16;
+	stats->late_count += oversleep_ns > kLateNs ? 1 : 0;
+	stats->count++;
+}
+
+} // namespace
+
+extern "C" void
+os_precise_sleeper_init_hybrid(struct os_precise_sleeper *ops)
+{
+	os_precise_sleeper_init(ops);
+	ops->spin_margin_ns = kMinSpinMarginNs;
+
+	// Measure how late short sleeps return on this thread.
+	for (int i = 0; i < kCalibrationCount; i++) {
+		uint64_t before_ns = os_monotonic_get_ns();
+		os_precise_sleeper_nanosleep(ops, kCalibrationSleepNs);
+		int64_t slept_ns = (int64_t)(os_monotonic_get_ns() - before_ns);
+
+		update_spin_margin(ops, slept_ns - kCalibrationSleepNs);
+	}
+}
+
+extern "C" void
+os_precise_sleeper_wait_until(struct os_precise_sleeper *ops, uint64_t until_ns)
+{
+	bool hybrid = ops->spin_margin_ns > 0;
+	uint64_t now_ns = os_monotonic_get_ns();
+
+	// Sleep until the margin, in steps in case the deadline is far away.
+	while (true) {
+		int64_t sleep_ns = (int64_t)(until_ns - now_ns) - ops->spin_margin_ns;
+		if (sleep_ns <= 0) {
+			break;
+		}
+
+		sleep_ns = std::min(sleep_ns, kMaxSleepNs);
+		uint64_t wake_ns = now_ns + (uint64_t)sleep_ns;
+
+		os_precise_sleeper_nanosleep(ops, (int32_t)sleep_ns);
+		now_ns = os_monotonic_get_ns();
+
+		if (hybrid) {
+			update_spin_margin(ops, (int64_t)(now_ns - wake_ns));
+		}
+	}
+
+	// And spin the rest of the way.
+	uint64_t spin_start_ns = now_ns;
+	while (hybrid && now_ns < until_ns) {
+		os_cpu_relax();
+		now_ns = os_monotonic_get_ns();
+	}
+
+	ops->stats.last_spin_ns = (int64_t)(now_ns - spin_start_ns);
+	update_stats(&ops->stats, (int64_t)(now_ns - until_ns));
+}
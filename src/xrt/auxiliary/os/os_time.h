@@ -22,6 +22,8 @@
 
 #include "util/u_time.h"
 
+#include <string.h>
+
 #ifdef XRT_OS_LINUX
 #include <time.h>
 #include <sys/time.h>
@@ -125,6 +127,40 @@ os_precise_sleeper_deinit(struct os_precise_sleeper *ops);
 static inline void
 os_precise_sleeper_nanosleep(struct os_precise_sleeper *ops, int32_t nsec);
 
+/*!
+ * Initialize a @ref os_precise_sleeper in hybrid mode: waits sleep until a
+ * margin before the deadline and spin for the rest, trading a little CPU time
+ * for wake-ups that aren't at the mercy of the scheduler's wake-up latency.
+ *
+ * The margin starts out calibrated with a few short sleeps, done on the calling
+ * thread so call it from the thread that will be waiting, after any priority
+ * changes. It then follows the measured wake-up latency of every wait.
+ *
+ * @see os_precise_sleeper_wait_until
+ * @public @memberof os_precise_sleeper
+ */
+void
+os_precise_sleeper_init_hybrid(struct os_precise_sleeper *ops);
+
+/*!
+ * Wait until the given monotonic time, in hybrid mode sleeping then spinning
+ * as described in @ref os_precise_sleeper_init_hybrid, otherwise only
+ * sleeping. Updates @ref os_precise_sleeper::stats.
+ *
+ * @public @memberof os_precise_sleeper
+ */
+void
+os_precise_sleeper_wait_until(struct os_precise_sleeper *ops, uint64_t until_ns);
+
+/*!
+ * Tell the CPU that we are in a spin loop, so that it can save power and give
+ * resources to the other hardware thread of the core.
+ *
+ * @ingroup aux_os_time
+ */
+static inline void
+os_cpu_relax(void);
+
 #if defined(XRT_HAVE_TIMESPEC) || defined(XRT_DOXYGEN)
 /*!
  * Convert a timespec struct to nanoseconds.
@@ -204,18 +240,49 @@ os_nanosleep(int64_t nsec)
 #endif
 }
 
+/*!
+ * How late the waits of a @ref os_precise_sleeper returned, all times are
+ * nanoseconds after the requested deadline.
+ *
+ * @ingroup aux_os_time
+ */
+struct os_precise_sleeper_stats
+{
+	//! Number of waits done with @ref os_precise_sleeper_wait_until.
+	uint64_t count;
+
+	//! Waits that returned more than 100us late.
+	uint64_t late_count;
+
+	int64_t last_ns;
+
+	//! Exponential moving average.
+	int64_t mean_ns;
+
+	int64_t max_ns;
+
+	//! Time spent spinning in the last wait.
+	int64_t last_spin_ns;
+};
+
 struct os_precise_sleeper
 {
 #if defined(XRT_OS_WINDOWS)
 	HANDLE timer;
-#else
-	int unused_;
 #endif
+
+	//! How long before the deadline to stop sleeping and start spinning, zero unless hybrid.
+	int64_t spin_margin_ns;
+
+	//! Oversleep statistics, only updated by @ref os_precise_sleeper_wait_until.
+	struct os_precise_sleeper_stats stats;
 };
 
 static inline void
 os_precise_sleeper_init(struct os_precise_sleeper *ops)
 {
+	memset(ops, 0, sizeof(*ops));
+
 #if defined(XRT_OS_WINDOWS)
 	ops->timer = CreateWaitableTimer(NULL, TRUE, NULL);
 #endif
@@ -257,6 +324,18 @@ os_precise_sleeper_nanosleep(struct os_precise_sleeper *ops, int32_t nsec)
 #endif
 }
 
+static inline void
+os_cpu_relax(void)
+{
+#if defined(_MSC_VER)
+	YieldProcessor();
+#elif defined(__i386__) || defined(__x86_64__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__)
+	__asm__ volatile("yield");
+#endif
+}
+
 #if defined(XRT_HAVE_TIMESPEC)
 static inline uint64_t
 os_timespec_to_ns(const struct timespec *spec)
@@ -15,6 +15,9 @@
 #include "util/u_frame.h"
 #include "util/u_format.h"
 #include "util/u_logging.h"
+#include "util/u_worker.h"
+
+#include "os/os_threading.h"
 
 #include "tracking/t_tracking.h"
 #include "tracking/t_calibration_opencv.hpp"
@@ -85,6 +88,19 @@ struct ViewState
 	cv::Mat map2 = {};
 };
 
+/*!
+ * Copy of the collected samples, so the solver can run while collection goes on.
+ */
+struct SampleSnapshot
+{
+	ArrayOfModelF32s board_models_f32 = {};
+	ArrayOfModelF64s board_models_f64 = {};
+	ArrayOfMeasurementF32s measured_f32[2] = {};
+	ArrayOfMeasurementF64s measured_f64[2] = {};
+	cv::Size image_size = {};
+	bool stereo = false;
+};
+
 /*!
  * Main class for doing calibration.
  */
@@ -92,6 +108,7 @@ class Calibration
 {
 public:
 	struct xrt_frame_sink base = {};
+	struct xrt_frame_node node = {};
 
 	struct
 	{
@@ -127,6 +144,36 @@ public:
 		uint32_t collected_of_part = 0;
 	} state;
 
+	//! Detection and the incremental solver run here, off the sink thread.
+	struct
+	{
+		struct u_worker_thread_pool *pool = nullptr;
+		//! Processes one frame at a time, frames arriving meanwhile are skipped.
+		struct u_worker_group *frame_group = nullptr;
+		//! Detects the two views of a stereo frame in parallel.
+		struct u_worker_group *view_group = nullptr;
+		//! Runs the incremental solver, one solve at a time.
+		struct u_worker_group *solve_group = nullptr;
+
+		//! Protects the fields below.
+		struct os_mutex lock = {};
+		//! Frame being processed on @ref frame_group, holds a reference.
+		struct xrt_frame *frame = nullptr;
+		//! Set when the node is broken apart.
+		bool stopped = false;
+		//! Is a solve running on @ref solve_group.
+		bool solving = false;
+		//! Number of samples given to the latest solve.
+		size_t solved_count = 0;
+		//! Reprojection error of the latest incremental solve, negative if none.
+		double rp_error = -1.0;
+		//! Frames skipped because the previous one was still being processed.
+		uint32_t skipped = 0;
+
+		//! Only touched by the solver while @ref solving is set.
+		SampleSnapshot snapshot = {};
+	} async;
+
 	struct
 	{
 		bool enabled = false;
@@ -221,13 +268,13 @@ ensure_buffers_are_allocated(class Calibration &c, int rows, int cols)
 }
 
 static void
-print_txt(cv::Mat &rgb, const char *text, double fontScale)
+print_txt(cv::Mat &rgb, const char *text, double fontScale, int line = 0)
 {
 	int fontFace = 0;
 	int thickness = 2;
 	cv::Size textSize = cv::getTextSize(text, fontFace, fontScale, thickness, NULL);
 
-	cv::Point textOrg((rgb.cols - textSize.width) / 2, textSize.height * 2);
+	cv::Point textOrg((rgb.cols - textSize.width) / 2, textSize.height * 2 * (line + 1));
 
 	cv::putText(rgb, text, textOrg, fontFace, fontScale, cv::Scalar(192, 192, 192), thickness);
 }
@@ -434,6 +481,23 @@ do_view(class Calibration &c, struct ViewState &view, cv::Mat &gray, cv::Mat &rg
 	return found;
 }
 
+struct ViewTask
+{
+	class Calibration *c;
+	struct ViewState *view;
+	cv::Mat gray;
+	cv::Mat rgb;
+	bool found;
+};
+
+static void
+view_task(void *ptr)
+{
+	struct ViewTask &task = *(struct ViewTask *)ptr;
+
+	task.found = do_view(*task.c, *task.view, task.gray, task.rgb);
+}
+
 static void
 remap_view(class Calibration &c, struct ViewState &view, cv::Mat &rgb)
 {
@@ -567,30 +631,31 @@ moved_state_check(struct ViewState &view)
 
 #define P(...) snprintf(c.text, sizeof(c.text), __VA_ARGS__)
 
-XRT_NO_INLINE static void
-process_stereo_samples(class Calibration &c, int cols, int rows)
+/*!
+ * Runs the stereo solver on the given samples, used both for the final
+ * calibration and the incremental ones.
+ */
+static double
+stereo_calibrate(bool use_fisheye,
+                 const ArrayOfModelF32s &board_models_f32,
+                 const ArrayOfModelF64s &board_models_f64,
+                 const ArrayOfMeasurementF32s &l_measured_f32,
+                 const ArrayOfMeasurementF64s &l_measured_f64,
+                 const ArrayOfMeasurementF32s &r_measured_f32,
+                 const ArrayOfMeasurementF64s &r_measured_f64,
+                 const cv::Size &image_size,
+                 StereoCameraCalibrationWrapper &wrapped)
 {
-	c.state.calibrated = true;
-
-	cv::Size image_size(cols, rows);
-	cv::Size new_image_size(cols, rows);
-
-	StereoCameraCalibrationWrapper wrapped(c.use_fisheye ? T_DISTORTION_FISHEYE_KB4 : T_DISTORTION_OPENCV_RADTAN_5);
-	wrapped.view[0].image_size_pixels.w = image_size.width;
-	wrapped.view[0].image_size_pixels.h = image_size.height;
-	wrapped.view[1].image_size_pixels = wrapped.view[0].image_size_pixels;
-
-
-	float rp_error = 0.0f;
-	if (c.use_fisheye) {
+	double rp_error = 0.0;
+	if (use_fisheye) {
 		int flags = 0;
 		flags |= cv::fisheye::CALIB_FIX_SKEW;
 		flags |= cv::fisheye::CALIB_RECOMPUTE_EXTRINSIC;
 
 		// fisheye version
-		rp_error = cv::fisheye::stereoCalibrate(c.state.board_models_f64,       // objectPoints
-		                                        c.state.view[0].measured_f64,   // inagePoints1
-		                                        c.state.view[1].measured_f64,   // imagePoints2
+		rp_error = cv::fisheye::stereoCalibrate(board_models_f64,               // objectPoints
+		                                        l_measured_f64,                 // inagePoints1
+		                                        r_measured_f64,                 // imagePoints2
 		                                        wrapped.view[0].intrinsics_mat, // cameraMatrix1
 		                                        wrapped.view[0].distortion_mat, // distCoeffs1
 		                                        wrapped.view[1].intrinsics_mat, // cameraMatrix2
@@ -604,9 +669,9 @@ process_stereo_samples(class Calibration &c, int cols, int rows)
 		int flags = 0;
 
 		// Insists on 32-bit floats for object points and image points
-		rp_error = cv::stereoCalibrate(c.state.board_models_f32,       // objectPoints
-		                               c.state.view[0].measured_f32,   // inagePoints1
-		                               c.state.view[1].measured_f32,   // imagePoints2,
+		rp_error = cv::stereoCalibrate(board_models_f32,               // objectPoints
+		                               l_measured_f32,                 // inagePoints1
+		                               r_measured_f32,                 // imagePoints2,
 		                               wrapped.view[0].intrinsics_mat, // cameraMatrix1
 		                               wrapped.view[0].distortion_mat, // distCoeffs1
 		                               wrapped.view[1].intrinsics_mat, // cameraMatrix2
@@ -619,6 +684,32 @@ process_stereo_samples(class Calibration &c, int cols, int rows)
 		                               flags);                         // flags
 	}
 
+	return rp_error;
+}
+
+XRT_NO_INLINE static void
+process_stereo_samples(class Calibration &c, int cols, int rows)
+{
+	c.state.calibrated = true;
+
+	cv::Size image_size(cols, rows);
+	cv::Size new_image_size(cols, rows);
+
+	StereoCameraCalibrationWrapper wrapped(c.use_fisheye ? T_DISTORTION_FISHEYE_KB4 : T_DISTORTION_OPENCV_RADTAN_5);
+	wrapped.view[0].image_size_pixels.w = image_size.width;
+	wrapped.view[0].image_size_pixels.h = image_size.height;
+	wrapped.view[1].image_size_pixels = wrapped.view[0].image_size_pixels;
+
+	float rp_error = (float)stereo_calibrate(c.use_fisheye,                 //
+	                                         c.state.board_models_f32,      //
+	                                         c.state.board_models_f64,      //
+	                                         c.state.view[0].measured_f32,  //
+	                                         c.state.view[0].measured_f64,  //
+	                                         c.state.view[1].measured_f32,  //
+	                                         c.state.view[1].measured_f64,  //
+	                                         image_size,                    //
+	                                         wrapped);                      //
+
 	// Tell the user what has happened.
 	P("CALIBRATION DONE RP ERROR %f", rp_error);
 
@@ -660,6 +751,62 @@ process_stereo_samples(class Calibration &c, int cols, int rows)
 	}
 }
 
+/*!
+ * Runs the single view solver on the given samples, used both for the final
+ * calibration and the incremental ones.
+ */
+static double
+view_calibrate(bool use_fisheye,
+               const ArrayOfModelF32s &board_models_f32,
+               const ArrayOfModelF64s &board_models_f64,
+               const ArrayOfMeasurementF32s &measured_f32,
+               const ArrayOfMeasurementF64s &measured_f64,
+               const cv::Size &image_size,
+               cv::Mat &intrinsics_mat,
+               cv::Mat &distortion_mat)
+{
+	if (use_fisheye) {
+		int crit_flag = 0;
+		crit_flag |= cv::TermCriteria::EPS;
+		crit_flag |= cv::TermCriteria::COUNT;
+		cv::TermCriteria term_criteria = {crit_flag, 100, DBL_EPSILON};
+
+		int flags = 0;
+		flags |= cv::fisheye::CALIB_FIX_SKEW;
+		flags |= cv::fisheye::CALIB_RECOMPUTE_EXTRINSIC;
+#if 0
+		flags |= cv::fisheye::CALIB_FIX_PRINCIPAL_POINT;
+#endif
+
+		return cv::fisheye::calibrate(board_models_f64, // objectPoints
+		                              measured_f64,     // imagePoints
+		                              image_size,       // image_size
+		                              intrinsics_mat,   // K (cameraMatrix 3x3)
+		                              distortion_mat,   // D (distCoeffs 4x1)
+		                              cv::noArray(),    // rvecs
+		                              cv::noArray(),    // tvecs
+		                              flags,            // flags
+		                              term_criteria);   // criteria
+	}
+
+	int flags = 0;
+
+	// Go all out.
+	flags |= cv::CALIB_THIN_PRISM_MODEL;
+	flags |= cv::CALIB_RATIONAL_MODEL;
+	flags |= cv::CALIB_TILTED_MODEL;
+
+	return cv::calibrateCamera( //
+	    board_models_f32,       // objectPoints
+	    measured_f32,           // imagePoints
+	    image_size,             // imageSize
+	    intrinsics_mat,         // cameraMatrix
+	    distortion_mat,         // distCoeffs
+	    cv::noArray(),          // rvecs
+	    cv::noArray(),          // tvecs
+	    flags);                 // flags
+}
+
 static void
 process_view_samples(class Calibration &c, struct ViewState &view, int cols, int rows)
 {
@@ -683,29 +830,16 @@ process_view_samples(class Calibration &c, struct ViewState &view, int cols, int
 		U_LOG_RAW("};");
 	}
 
-	if (c.use_fisheye) {
-		int crit_flag = 0;
-		crit_flag |= cv::TermCriteria::EPS;
-		crit_flag |= cv::TermCriteria::COUNT;
-		cv::TermCriteria term_criteria = {crit_flag, 100, DBL_EPSILON};
-
-		int flags = 0;
-		flags |= cv::fisheye::CALIB_FIX_SKEW;
-		flags |= cv::fisheye::CALIB_RECOMPUTE_EXTRINSIC;
-#if 0
-		flags |= cv::fisheye::CALIB_FIX_PRINCIPAL_POINT;
-#endif
-
-		rp_error = cv::fisheye::calibrate(c.state.board_models_f64, // objectPoints
-		                                  view.measured_f64,        // imagePoints
-		                                  image_size,               // image_size
-		                                  intrinsics_mat,           // K (cameraMatrix 3x3)
-		                                  distortion_mat,           // D (distCoeffs 4x1)
-		                                  cv::noArray(),            // rvecs
-		                                  cv::noArray(),            // tvecs
-		                                  flags,                    // flags
-		                                  term_criteria);           // criteria
+	rp_error = view_calibrate(c.use_fisheye,            //
+	                          c.state.board_models_f32, //
+	                          c.state.board_models_f64, //
+	                          view.measured_f32,        //
+	                          view.measured_f64,        //
+	                          image_size,               //
+	                          intrinsics_mat,           //
+	                          distortion_mat);          //
 
+	if (c.use_fisheye) {
 		double balance = 0.1f;
 
 		cv::fisheye::estimateNewCameraMatrixForUndistortRectify(intrinsics_mat,     // K
@@ -719,23 +853,6 @@ process_view_samples(class Calibration &c, struct ViewState &view, int cols, int
 		new_intrinsics_mat.at<double>(0, 2) = (cols - 1) / 2.0;
 		new_intrinsics_mat.at<double>(1, 2) = (rows - 1) / 2.0;
 	} else {
-		int flags = 0;
-
-		// Go all out.
-		flags |= cv::CALIB_THIN_PRISM_MODEL;
-		flags |= cv::CALIB_RATIONAL_MODEL;
-		flags |= cv::CALIB_TILTED_MODEL;
-
-		rp_error = cv::calibrateCamera( //
-		    c.state.board_models_f32,   // objectPoints
-		    view.measured_f32,          // imagePoints
-		    image_size,                 // imageSize
-		    intrinsics_mat,             // cameraMatrix
-		    distortion_mat,             // distCoeffs
-		    cv::noArray(),              // rvecs
-		    cv::noArray(),              // tvecs
-		    flags);                     // flags
-
 		// Currently see as much as possible of the original image.
 		float alpha = 1.0;
 
@@ -789,6 +906,125 @@ process_view_samples(class Calibration &c, struct ViewState &view, int cols, int
 	c.state.calibrated = true;
 }
 
+
+/*
+ *
+ * Incremental calibration
+ *
+ */
+
+//! Fewest samples to run the incremental solver on.
+#define MIN_SAMPLES_TO_SOLVE (3)
+
+static void
+solve_task(void *ptr)
+{
+	auto &c = *(class Calibration *)ptr;
+	SampleSnapshot &s = c.async.snapshot;
+
+	double rp_error = -1.0;
+
+	try {
+		if (s.stereo) {
+			StereoCameraCalibrationWrapper wrapped(c.use_fisheye ? T_DISTORTION_FISHEYE_KB4
+			                                                     : T_DISTORTION_OPENCV_RADTAN_5);
+
+			rp_error = stereo_calibrate(c.use_fisheye,       //
+			                            s.board_models_f32,  //
+			                            s.board_models_f64,  //
+			                            s.measured_f32[0],   //
+			                            s.measured_f64[0],   //
+			                            s.measured_f32[1],   //
+			                            s.measured_f64[1],   //
+			                            s.image_size,        //
+			                            wrapped);            //
+		} else {
+			cv::Mat intrinsics_mat = {};
+			cv::Mat distortion_mat = {};
+
+			rp_error = view_calibrate(c.use_fisheye,      //
+			                          s.board_models_f32, //
+			                          s.board_models_f64, //
+			                          s.measured_f32[0],  //
+			                          s.measured_f64[0],  //
+			                          s.image_size,       //
+			                          intrinsics_mat,     //
+			                          distortion_mat);    //
+		}
+	} catch (const cv::Exception &e) {
+		// Not enough samples to constrain the model yet, wait for more.
+		U_LOG_D("Incremental calibration failed: %s", e.what());
+	}
+
+	os_mutex_lock(&c.async.lock);
+	if (rp_error >= 0.0) {
+		c.async.rp_error = rp_error;
+	}
+	c.async.solving = false;
+	os_mutex_unlock(&c.async.lock);
+}
+
+/*!
+ * Starts the solver on the samples collected so far, unless it is already
+ * running or has seen all of them. Only the reprojection error is kept, the
+ * final calibration is still done once all samples have been collected.
+ */
+static void
+start_incremental_solve(class Calibration &c, bool stereo, int cols, int rows)
+{
+	size_t count = c.state.board_models_f32.size();
+	if (count < MIN_SAMPLES_TO_SOLVE) {
+		return;
+	}
+
+	os_mutex_lock(&c.async.lock);
+	bool start = !c.async.solving && !c.async.stopped && count > c.async.solved_count;
+	if (start) {
+		c.async.solving = true;
+		c.async.solved_count = count;
+	}
+	os_mutex_unlock(&c.async.lock);
+
+	if (!start) {
+		return;
+	}
+
+	SampleSnapshot &s = c.async.snapshot;
+	s.board_models_f32 = c.state.board_models_f32;
+	s.board_models_f64 = c.state.board_models_f64;
+	s.measured_f32[0] = c.state.view[0].measured_f32;
+	s.measured_f64[0] = c.state.view[0].measured_f64;
+	s.measured_f32[1] = c.state.view[1].measured_f32;
+	s.measured_f64[1] = c.state.view[1].measured_f64;
+	s.image_size = cv::Size(cols, rows);
+	s.stereo = stereo;
+
+	u_worker_group_push(c.async.solve_group, solve_task, &c);
+}
+
+static double
+get_incremental_rp_error(class Calibration &c)
+{
+	os_mutex_lock(&c.async.lock);
+	double rp_error = c.async.rp_error;
+	os_mutex_unlock(&c.async.lock);
+
+	return rp_error;
+}
+
+static void
+print_incremental_rp_error(class Calibration &c, cv::Mat &rgb)
+{
+	double rp_error = get_incremental_rp_error(c);
+	if (rp_error < 0.0) {
+		return;
+	}
+
+	char buf[128];
+	snprintf(buf, sizeof(buf), "RP ERROR %f", rp_error);
+	print_txt(rgb, buf, 1.0, 2);
+}
+
 static void
 update_public_status(class Calibration &c, bool found)
 {
@@ -798,6 +1034,7 @@ update_public_status(class Calibration &c, bool found)
 		c.status->cooldown = c.state.cooldown;
 		c.status->waits_remaining = c.state.waited_for;
 		c.status->found = found;
+		c.status->rp_error = (float)get_incremental_rp_error(c);
 	}
 }
 
@@ -965,10 +1202,13 @@ make_calibration_frame_mono(class Calibration &c)
 
 	if (c.state.board_models_f32.size() >= c.num_collect_total) {
 		process_view_samples(c, c.state.view[0], rgb.cols, rgb.rows);
+	} else {
+		start_incremental_solve(c, false, rgb.cols, rgb.rows);
 	}
 
 	// Draw text and finally send the frame off.
 	print_txt(rgb, c.text, 1.5);
+	print_incremental_rp_error(c, rgb);
 	send_rgb_frame(c);
 }
 
@@ -990,18 +1230,30 @@ make_calibration_frame_sbs(class Calibration &c)
 	cv::Mat l_rgb(rows, cols, CV_8UC3, c.gui.frame->data, c.gui.frame->stride);
 	cv::Mat r_rgb(rows, cols, CV_8UC3, c.gui.frame->data + 3 * cols, c.gui.frame->stride);
 
-	bool found_left = do_view(c, c.state.view[0], l_gray, l_rgb);
-	bool found_right = do_view(c, c.state.view[1], r_gray, r_rgb);
+	// Detect both views in parallel.
+	struct ViewTask tasks[2] = {
+	    {&c, &c.state.view[0], l_gray, l_rgb, false},
+	    {&c, &c.state.view[1], r_gray, r_rgb, false},
+	};
+	u_worker_group_push(c.async.view_group, view_task, &tasks[0]);
+	u_worker_group_push(c.async.view_group, view_task, &tasks[1]);
+	u_worker_group_wait_all(c.async.view_group);
+
+	bool found_left = tasks[0].found;
+	bool found_right = tasks[1].found;
 
 	do_capture_logic_stereo(c, gray, rgb, found_left, c.state.view[0], l_gray, l_rgb, found_right, c.state.view[1],
 	                        r_gray, r_rgb);
 
 	if (c.state.board_models_f32.size() >= c.num_collect_total) {
 		process_stereo_samples(c, cols, rows);
+	} else {
+		start_incremental_solve(c, true, cols, rows);
 	}
 
 	// Draw text and finally send the frame off.
 	print_txt(rgb, c.text, 1.5);
+	print_incremental_rp_error(c, rgb);
 	send_rgb_frame(c);
 }
 
@@ -1200,11 +1452,45 @@ process_load_image(class Calibration &c, struct xrt_frame *xf)
  *
  */
 
+/*!
+ * Detection and capture logic for the frame held in @ref Calibration::async,
+ * runs on the worker pool.
+ */
+static void
+process_frame_task(void *ptr)
+{
+	auto &c = *(class Calibration *)ptr;
+
+	// The sink thread doesn't touch it until we clear it below.
+	struct xrt_frame *xf = c.async.frame;
+
+	make_calibration_frame(c, xf);
+
+	os_mutex_lock(&c.async.lock);
+	xrt_frame_reference(&c.async.frame, NULL);
+	os_mutex_unlock(&c.async.lock);
+}
+
 extern "C" void
 t_calibration_frame(struct xrt_frame_sink *xsink, struct xrt_frame *xf)
 {
 	auto &c = *(class Calibration *)xsink;
 
+	/*
+	 * Detection can take far longer than a frame on big images, skip
+	 * frames while it runs instead of stalling the pipeline.
+	 */
+	os_mutex_lock(&c.async.lock);
+	bool skip = c.async.stopped || c.async.frame != NULL;
+	if (skip) {
+		c.async.skipped++;
+	}
+	os_mutex_unlock(&c.async.lock);
+
+	if (skip) {
+		return;
+	}
+
 	if (c.load.enabled) {
 		process_load_image(c, xf);
 	}
@@ -1238,7 +1524,45 @@ t_calibration_frame(struct xrt_frame_sink *xsink, struct xrt_frame *xf)
 		              cv::Scalar(0, 0, 0), -1, 0);
 	}
 
-	make_calibration_frame(c, xf);
+	// The reference also keeps c.gray valid, it points into L8 frames.
+	os_mutex_lock(&c.async.lock);
+	xrt_frame_reference(&c.async.frame, xf);
+	os_mutex_unlock(&c.async.lock);
+
+	u_worker_group_push(c.async.frame_group, process_frame_task, &c);
+}
+
+extern "C" void
+t_calibration_node_break_apart(struct xrt_frame_node *node)
+{
+	auto &c = *container_of(node, class Calibration, node);
+
+	os_mutex_lock(&c.async.lock);
+	c.async.stopped = true;
+	os_mutex_unlock(&c.async.lock);
+
+	// Nothing may push to the gui sink after this.
+	u_worker_group_wait_all(c.async.frame_group);
+	u_worker_group_wait_all(c.async.solve_group);
+
+	U_LOG_D("Skipped %u frames while detecting.", c.async.skipped);
+}
+
+extern "C" void
+t_calibration_node_destroy(struct xrt_frame_node *node)
+{
+	auto *c_ptr = container_of(node, class Calibration, node);
+
+	u_worker_group_reference(&c_ptr->async.frame_group, NULL);
+	u_worker_group_reference(&c_ptr->async.view_group, NULL);
+	u_worker_group_reference(&c_ptr->async.solve_group, NULL);
+	u_worker_thread_pool_reference(&c_ptr->async.pool, NULL);
+
+	xrt_frame_reference(&c_ptr->async.frame, NULL);
+	xrt_frame_reference(&c_ptr->gui.frame, NULL);
+	os_mutex_destroy(&c_ptr->async.lock);
+
+	delete c_ptr;
 }
 
 
@@ -1273,8 +1597,22 @@ t_calibration_stereo_create(struct xrt_frame_context *xfctx,
 	// Basic setup.
 	c.gui.sink = gui;
 	c.base.push_frame = t_calibration_frame;
+	c.node.break_apart = t_calibration_node_break_apart;
+	c.node.destroy = t_calibration_node_destroy;
 	*out_sink = &c.base;
 
+	/*
+	 * One frame and one solve in flight, the frame task donates its thread
+	 * while waiting on the two view detections.
+	 */
+	os_mutex_init(&c.async.lock);
+	c.async.pool = u_worker_thread_pool_create(2, 4, "Calibration", OS_THREAD_CORE_CLASS_ANY);
+	c.async.frame_group = u_worker_group_create(c.async.pool);
+	c.async.view_group = u_worker_group_create(c.async.pool);
+	c.async.solve_group = u_worker_group_create(c.async.pool);
+
+	xrt_frame_context_add(xfctx, &c.node);
+
 	// Copy the parameters.
 	c.use_fisheye = params->use_fisheye;
 	c.stereo_sbs = params->stereo_sbs;
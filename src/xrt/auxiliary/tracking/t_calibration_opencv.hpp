@@ -179,6 +179,29 @@ calibration_get_undistort_map(t_camera_calibration &calib,
                               cv::InputArray rectify_transform_optional = cv::noArray(),
                               cv::Mat new_camera_matrix_optional = cv::Mat());
 
+/*!
+ * @brief Moves keypoints found in a distorted image to where they would be in
+ * the image remapped by @ref calibration_get_undistort_map with the same
+ * parameters. Much cheaper than remapping the whole image when only a few
+ * points are needed.
+ *
+ * @param intrinsics Camera intrinsics matrix
+ * @param distortion Distortion coefficients for @p distortion_model
+ * @param distortion_model Either fisheye or radtan distortion
+ * @param rectify_transform_optional A rectification transform to apply, if
+ * desired.
+ * @param new_camera_matrix_optional Unlike OpenCV, the default/empty matrix
+ * here uses the input camera matrix as your output camera matrix.
+ * @param[in,out] keypoints Keypoints to undistort in place.
+ */
+void
+calibration_undistort_keypoints(const cv::Matx33d &intrinsics,
+                                const cv::Mat &distortion,
+                                enum t_camera_distortion_model distortion_model,
+                                cv::InputArray rectify_transform_optional,
+                                cv::Mat new_camera_matrix_optional,
+                                std::vector<cv::KeyPoint> &keypoints);
+
 /*!
  * @brief Rectification, rotation, projection data for a single view in a stereo
  * pair.
@@ -0,0 +1,584 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Single file container for recorded tracking datasets.
+ * @ingroup aux_tracking
+ */
+
+#include "t_dataset_container.h"
+
+#include "util/u_logging.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using std::lock_guard;
+using std::mutex;
+using std::vector;
+
+
+/*
+ *
+ * On disk structs.
+ *
+ */
+
+//! Identifies the file and the layout version.
+static constexpr char MAGIC[8] = {'X', 'R', 'T', 'D', 'S', 'C', '0', '1'};
+
+//! Bumped on incompatible layout changes.
+static constexpr uint32_t VERSION = 1;
+
+//! Chunks and their payloads are aligned to this.
+static constexpr uint64_t ALIGNMENT = 8;
+
+struct file_header
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t cam_count;
+	uint64_t index_offset; //!< Zero if the file was never closed
+	uint64_t index_count;
+};
+
+//! Precedes every chunk, also used as the index entry with @ref offset set.
+struct chunk_header
+{
+	uint32_t type; //!< @ref t_dataset_sample_type
+	uint32_t cam_index;
+	int64_t timestamp_ns;
+	uint64_t size;   //!< Payload size, not including padding
+	uint64_t offset; //!< Offset of this header in the file, only used in the index
+};
+
+struct frame_payload
+{
+	uint32_t format;
+	uint32_t width;
+	uint32_t height;
+	uint32_t stride;
+	// Followed by stride * height bytes.
+};
+
+struct imu_payload
+{
+	double accel_m_s2[3];
+	double gyro_rad_secs[3];
+};
+
+struct gt_payload
+{
+	float position[3];
+	float orientation[4]; //!< x, y, z, w
+};
+
+static_assert(sizeof(file_header) == 32, "Unexpected padding");
+static_assert(sizeof(chunk_header) == 32, "Unexpected padding");
+static_assert(sizeof(frame_payload) % ALIGNMENT == 0, "Frame data must stay aligned");
+
+static uint64_t
+align_up(uint64_t v)
+{
+	return (v + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+static uint32_t
+bytes_per_pixel(enum xrt_format format)
+{
+	switch (format) {
+	case XRT_FORMAT_L8: return 1;
+	case XRT_FORMAT_R8G8B8: return 3;
+	default: return 0;
+	}
+}
+
+
+/*
+ *
+ * Writer.
+ *
+ */
+
+struct t_dataset_writer
+{
+	FILE *file;
+	uint32_t cam_count;
+
+	//! Protects everything below and writes to @ref file.
+	mutex lock;
+	uint64_t offset;
+	vector<chunk_header> index;
+	bool failed;
+};
+
+static bool
+writer_write(struct t_dataset_writer *w, const void *data, size_t size)
+{
+	if (size == 0) {
+		return true;
+	}
+
+	if (fwrite(data, 1, size, w->file) != size) {
+		w->failed = true;
+		return false;
+	}
+
+	w->offset += size;
+	return true;
+}
+
+static bool
+writer_pad(struct t_dataset_writer *w)
+{
+	static const uint8_t zeros[ALIGNMENT] = {0};
+	return writer_write(w, zeros, align_up(w->offset) - w->offset);
+}
+
+//! Must be called with the lock held, the payload of @p size follows.
+static bool
+writer_begin_chunk(struct t_dataset_writer *w,
+                   enum t_dataset_sample_type type,
+                   uint32_t cam_index,
+                   int64_t timestamp_ns,
+                   uint64_t size)
+{
+	if (w->failed) {
+		return false;
+	}
+
+	chunk_header ch = {};
+	ch.type = type;
+	ch.cam_index = cam_index;
+	ch.timestamp_ns = timestamp_ns;
+	ch.size = size;
+	ch.offset = w->offset;
+
+	if (!writer_write(w, &ch, sizeof(ch))) {
+		return false;
+	}
+
+	w->index.push_back(ch);
+
+	return true;
+}
+
+//! Must be called with the lock held.
+static bool
+writer_push_chunk(struct t_dataset_writer *w,
+                  enum t_dataset_sample_type type,
+                  int64_t timestamp_ns,
+                  const void *payload,
+                  size_t size)
+{
+	bool ok = writer_begin_chunk(w, type, 0, timestamp_ns, size) && //
+	          writer_write(w, payload, size) &&                     //
+	          writer_pad(w);
+	if (!ok) {
+		U_LOG_E("Failed to write dataset chunk");
+	}
+
+	return ok;
+}
+
+extern "C" bool
+t_dataset_writer_create(const char *path, uint32_t cam_count, struct t_dataset_writer **out_writer)
+{
+	FILE *file = fopen(path, "wb");
+	if (file == NULL) {
+		U_LOG_E("Could not create dataset container '%s'", path);
+		return false;
+	}
+
+	struct t_dataset_writer *w = new t_dataset_writer{};
+	w->file = file;
+	w->cam_count = cam_count;
+
+	// Frames are large, save on syscalls.
+	setvbuf(w->file, NULL, _IOFBF, 1024 * 1024);
+
+	// Index offset is patched in on close.
+	file_header fh = {};
+	memcpy(fh.magic, MAGIC, sizeof(MAGIC));
+	fh.version = VERSION;
+	fh.cam_count = cam_count;
+
+	if (!writer_write(w, &fh, sizeof(fh))) {
+		U_LOG_E("Could not write dataset container header '%s'", path);
+		fclose(w->file);
+		delete w;
+		return false;
+	}
+
+	*out_writer = w;
+
+	return true;
+}
+
+extern "C" bool
+t_dataset_writer_push_frame(struct t_dataset_writer *w, uint32_t cam_index, const struct xrt_frame *xf)
+{
+	uint32_t bpp = bytes_per_pixel(xf->format);
+	if (bpp == 0 || cam_index >= w->cam_count) {
+		U_LOG_E("Unsupported frame for dataset container");
+		return false;
+	}
+
+	frame_payload fp = {};
+	fp.format = xf->format;
+	fp.width = xf->width;
+	fp.height = xf->height;
+	fp.stride = xf->width * bpp;
+
+	size_t row_size = fp.stride;
+	size_t size = row_size * fp.height;
+
+	lock_guard lock{w->lock};
+
+	bool ok = writer_begin_chunk(w, T_DATASET_SAMPLE_FRAME, cam_index, (int64_t)xf->timestamp, sizeof(fp) + size) &&
+	          writer_write(w, &fp, sizeof(fp));
+
+	// Packed already, write it in one go.
+	if (ok && xf->stride == row_size) {
+		ok = writer_write(w, xf->data, size);
+	} else {
+		for (uint32_t y = 0; ok && y < fp.height; y++) {
+			ok = writer_write(w, xf->data + (size_t)y * xf->stride, row_size);
+		}
+	}
+
+	if (!ok || !writer_pad(w)) {
+		U_LOG_E("Failed to write dataset frame");
+		return false;
+	}
+
+	return true;
+}
+
+extern "C" bool
+t_dataset_writer_push_imu(struct t_dataset_writer *w, const struct xrt_imu_sample *sample)
+{
+	imu_payload ip = {
+	    {sample->accel_m_s2.x, sample->accel_m_s2.y, sample->accel_m_s2.z},
+	    {sample->gyro_rad_secs.x, sample->gyro_rad_secs.y, sample->gyro_rad_secs.z},
+	};
+
+	lock_guard lock{w->lock};
+	return writer_push_chunk(w, T_DATASET_SAMPLE_IMU, sample->timestamp_ns, &ip, sizeof(ip));
+}
+
+extern "C" bool
+t_dataset_writer_push_gt(struct t_dataset_writer *w, const struct xrt_pose_sample *sample)
+{
+	const struct xrt_pose &p = sample->pose;
+	gt_payload gp = {
+	    {p.position.x, p.position.y, p.position.z},
+	    {p.orientation.x, p.orientation.y, p.orientation.z, p.orientation.w},
+	};
+
+	lock_guard lock{w->lock};
+	return writer_push_chunk(w, T_DATASET_SAMPLE_GT, sample->timestamp_ns, &gp, sizeof(gp));
+}
+
+extern "C" void
+t_dataset_writer_close(struct t_dataset_writer **writer_ptr)
+{
+	struct t_dataset_writer *w = *writer_ptr;
+	if (w == NULL) {
+		return;
+	}
+
+	{
+		lock_guard lock{w->lock};
+
+		file_header fh = {};
+		memcpy(fh.magic, MAGIC, sizeof(MAGIC));
+		fh.version = VERSION;
+		fh.cam_count = w->cam_count;
+		fh.index_offset = w->offset;
+		fh.index_count = w->index.size();
+
+		bool ok = !w->failed && writer_write(w, w->index.data(), w->index.size() * sizeof(chunk_header)) &&
+		          fseek(w->file, 0, SEEK_SET) == 0 && fwrite(&fh, sizeof(fh), 1, w->file) == 1;
+		if (!ok) {
+			U_LOG_E("Failed to write dataset index, it will be rebuilt on open");
+		}
+
+		fclose(w->file);
+		w->file = NULL;
+	}
+
+	delete w;
+	*writer_ptr = NULL;
+}
+
+
+/*
+ *
+ * Reader.
+ *
+ */
+
+struct t_dataset_reader
+{
+	const uint8_t *map;
+	size_t map_size;
+	uint32_t cam_count;
+
+	//! Chunk offsets per sample type, in recorded order.
+	vector<vector<uint64_t>> frames;
+	vector<uint64_t> imus;
+	vector<uint64_t> gts;
+};
+
+static const chunk_header *
+reader_get_chunk(const struct t_dataset_reader *r, uint64_t offset)
+{
+	return (const chunk_header *)(r->map + offset);
+}
+
+static bool
+reader_add_chunk(struct t_dataset_reader *r, const chunk_header *ch, uint64_t offset)
+{
+	if (offset + sizeof(*ch) + ch->size > r->map_size) {
+		return false;
+	}
+
+	switch (ch->type) {
+	case T_DATASET_SAMPLE_FRAME:
+		if (ch->cam_index >= r->cam_count || ch->size < sizeof(frame_payload)) {
+			return false;
+		}
+		r->frames[ch->cam_index].push_back(offset);
+		return true;
+	case T_DATASET_SAMPLE_IMU:
+		if (ch->size < sizeof(imu_payload)) {
+			return false;
+		}
+		r->imus.push_back(offset);
+		return true;
+	case T_DATASET_SAMPLE_GT:
+		if (ch->size < sizeof(gt_payload)) {
+			return false;
+		}
+		r->gts.push_back(offset);
+		return true;
+	default: return true; // Skip unknown chunks.
+	}
+}
+
+static bool
+reader_load_index(struct t_dataset_reader *r, const file_header *fh)
+{
+	uint64_t index_size = fh->index_count * sizeof(chunk_header);
+	if (fh->index_offset == 0 || fh->index_offset + index_size > r->map_size) {
+		return false;
+	}
+
+	const chunk_header *entries = (const chunk_header *)(r->map + fh->index_offset);
+	for (uint64_t i = 0; i < fh->index_count; i++) {
+		uint64_t offset = entries[i].offset;
+		if (offset + sizeof(chunk_header) > fh->index_offset ||
+		    !reader_add_chunk(r, reader_get_chunk(r, offset), offset)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void
+reader_scan_chunks(struct t_dataset_reader *r, const file_header *fh)
+{
+	for (auto &f : r->frames) {
+		f.clear();
+	}
+	r->imus.clear();
+	r->gts.clear();
+
+	// A broken index might still be there, do not read it as chunks.
+	uint64_t end = r->map_size;
+	if (fh->index_offset != 0 && fh->index_offset < end) {
+		end = fh->index_offset;
+	}
+
+	// Stops at the first truncated or corrupt chunk.
+	uint64_t offset = sizeof(file_header);
+	while (offset + sizeof(chunk_header) <= end) {
+		const chunk_header *ch = reader_get_chunk(r, offset);
+		if (!reader_add_chunk(r, ch, offset)) {
+			break;
+		}
+		offset = align_up(offset + sizeof(*ch) + ch->size);
+	}
+}
+
+extern "C" bool
+t_dataset_is_container(const char *path)
+{
+	FILE *file = fopen(path, "rb");
+	if (file == NULL) {
+		return false;
+	}
+
+	char magic[sizeof(MAGIC)] = {0};
+	bool is = fread(magic, 1, sizeof(magic), file) == sizeof(magic) && memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+
+	fclose(file);
+
+	return is;
+}
+
+extern "C" bool
+t_dataset_reader_open(const char *path, struct t_dataset_reader **out_reader)
+{
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		U_LOG_E("Could not open dataset container '%s'", path);
+		return false;
+	}
+
+	struct stat st = {};
+	if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(file_header)) {
+		U_LOG_E("Dataset container '%s' is too small", path);
+		close(fd);
+		return false;
+	}
+
+	void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd); // The mapping keeps the file alive.
+	if (map == MAP_FAILED) {
+		U_LOG_E("Could not map dataset container '%s'", path);
+		return false;
+	}
+
+	const file_header *fh = (const file_header *)map;
+	if (memcmp(fh->magic, MAGIC, sizeof(MAGIC)) != 0 || fh->version != VERSION) {
+		U_LOG_E("'%s' is not a supported dataset container", path);
+		munmap(map, (size_t)st.st_size);
+		return false;
+	}
+
+	struct t_dataset_reader *r = new t_dataset_reader{};
+	r->map = (const uint8_t *)map;
+	r->map_size = (size_t)st.st_size;
+	r->cam_count = fh->cam_count;
+	r->frames.resize(r->cam_count);
+
+	// Mostly sequential access during playback.
+	madvise(map, r->map_size, MADV_SEQUENTIAL);
+
+	if (!reader_load_index(r, fh)) {
+		U_LOG_W("Dataset container '%s' has no valid index, scanning chunks", path);
+		reader_scan_chunks(r, fh);
+	}
+
+	*out_reader = r;
+
+	return true;
+}
+
+extern "C" uint32_t
+t_dataset_reader_get_cam_count(const struct t_dataset_reader *r)
+{
+	return r->cam_count;
+}
+
+extern "C" size_t
+t_dataset_reader_get_frame_count(const struct t_dataset_reader *r, uint32_t cam_index)
+{
+	return cam_index < r->cam_count ? r->frames[cam_index].size() : 0;
+}
+
+extern "C" size_t
+t_dataset_reader_get_imu_count(const struct t_dataset_reader *r)
+{
+	return r->imus.size();
+}
+
+extern "C" size_t
+t_dataset_reader_get_gt_count(const struct t_dataset_reader *r)
+{
+	return r->gts.size();
+}
+
+extern "C" bool
+t_dataset_reader_get_frame(const struct t_dataset_reader *r,
+                           uint32_t cam_index,
+                           size_t index,
+                           struct t_dataset_frame *out_frame)
+{
+	if (index >= t_dataset_reader_get_frame_count(r, cam_index)) {
+		return false;
+	}
+
+	const chunk_header *ch = reader_get_chunk(r, r->frames[cam_index][index]);
+	const frame_payload *fp = (const frame_payload *)(ch + 1);
+	if ((uint64_t)fp->stride * fp->height > ch->size - sizeof(*fp)) {
+		return false;
+	}
+
+	out_frame->timestamp_ns = ch->timestamp_ns;
+	out_frame->format = (enum xrt_format)fp->format;
+	out_frame->width = fp->width;
+	out_frame->height = fp->height;
+	out_frame->stride = fp->stride;
+	out_frame->data = (const uint8_t *)(fp + 1);
+
+	return true;
+}
+
+extern "C" bool
+t_dataset_reader_get_imu(const struct t_dataset_reader *r, size_t index, struct xrt_imu_sample *out_sample)
+{
+	if (index >= r->imus.size()) {
+		return false;
+	}
+
+	const chunk_header *ch = reader_get_chunk(r, r->imus[index]);
+	const imu_payload *ip = (const imu_payload *)(ch + 1);
+
+	out_sample->timestamp_ns = ch->timestamp_ns;
+	out_sample->accel_m_s2 = {ip->accel_m_s2[0], ip->accel_m_s2[1], ip->accel_m_s2[2]};
+	out_sample->gyro_rad_secs = {ip->gyro_rad_secs[0], ip->gyro_rad_secs[1], ip->gyro_rad_secs[2]};
+
+	return true;
+}
+
+extern "C" bool
+t_dataset_reader_get_gt(const struct t_dataset_reader *r, size_t index, struct xrt_pose_sample *out_sample)
+{
+	if (index >= r->gts.size()) {
+		return false;
+	}
+
+	const chunk_header *ch = reader_get_chunk(r, r->gts[index]);
+	const gt_payload *gp = (const gt_payload *)(ch + 1);
+
+	out_sample->timestamp_ns = ch->timestamp_ns;
+	out_sample->pose.position = {gp->position[0], gp->position[1], gp->position[2]};
+	out_sample->pose.orientation = {gp->orientation[0], gp->orientation[1], gp->orientation[2], gp->orientation[3]};
+
+	return true;
+}
+
+extern "C" void
+t_dataset_reader_destroy(struct t_dataset_reader **reader_ptr)
+{
+	struct t_dataset_reader *r = *reader_ptr;
+	if (r == NULL) {
+		return;
+	}
+
+	munmap((void *)r->map, r->map_size);
+	delete r;
+	*reader_ptr = NULL;
+}
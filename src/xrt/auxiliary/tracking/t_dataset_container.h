@@ -0,0 +1,204 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Single file container for recorded tracking datasets.
+ * @ingroup aux_tracking
+ */
+
+#pragma once
+
+#include "xrt/xrt_defines.h"
+#include "xrt/xrt_frame.h"
+#include "xrt/xrt_tracking.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * @defgroup aux_tracking_dataset Dataset container
+ * @ingroup aux_tracking
+ *
+ * @brief A single file holding raw camera frames, IMU and groundtruth samples.
+ *
+ * An alternative to EuRoC directories, which use one image file per frame and
+ * need every frame decoded on playback. The file is a header followed by
+ * chunks, each chunk is a small header followed by its payload padded to 8
+ * bytes. An index of all chunks is appended when the file is closed, so the
+ * reader can memory map the file and go straight to any sample. A file that
+ * was never closed, for instance after a crash, has its index rebuilt by
+ * walking the chunks.
+ *
+ * All values are stored in host byte order.
+ *
+ * @{
+ */
+
+//! Conventional file extension.
+#define T_DATASET_CONTAINER_EXTENSION ".xrtds"
+
+//! What a chunk or index entry holds.
+enum t_dataset_sample_type
+{
+	T_DATASET_SAMPLE_FRAME = 1,
+	T_DATASET_SAMPLE_IMU = 2,
+	T_DATASET_SAMPLE_GT = 3,
+};
+
+/*!
+ * A frame in a mapped container, @p data points into the mapping and is
+ * valid as long as the reader is.
+ */
+struct t_dataset_frame
+{
+	int64_t timestamp_ns;
+	enum xrt_format format; //!< @ref XRT_FORMAT_L8 or @ref XRT_FORMAT_R8G8B8
+	uint32_t width;
+	uint32_t height;
+	uint32_t stride;
+	const uint8_t *data;
+};
+
+/*!
+ * Writes a container, thread safe so several sink threads can push into it.
+ */
+struct t_dataset_writer;
+
+/*!
+ * A memory mapped container opened for reading.
+ */
+struct t_dataset_reader;
+
+/*!
+ * Is the file at @p path a container, only looks at the header.
+ */
+bool
+t_dataset_is_container(const char *path);
+
+/*!
+ * Create a new container, truncating any existing file.
+ *
+ * @public @memberof t_dataset_writer
+ */
+bool
+t_dataset_writer_create(const char *path, uint32_t cam_count, struct t_dataset_writer **out_writer);
+
+/*!
+ * Append a frame, only @ref XRT_FORMAT_L8 and @ref XRT_FORMAT_R8G8B8 are
+ * supported. Rows are stored packed.
+ *
+ * @public @memberof t_dataset_writer
+ */
+bool
+t_dataset_writer_push_frame(struct t_dataset_writer *writer, uint32_t cam_index, const struct xrt_frame *xf);
+
+/*!
+ * Append an IMU sample.
+ *
+ * @public @memberof t_dataset_writer
+ */
+bool
+t_dataset_writer_push_imu(struct t_dataset_writer *writer, const struct xrt_imu_sample *sample);
+
+/*!
+ * Append a groundtruth sample.
+ *
+ * @public @memberof t_dataset_writer
+ */
+bool
+t_dataset_writer_push_gt(struct t_dataset_writer *writer, const struct xrt_pose_sample *sample);
+
+/*!
+ * Write the index, close the file and free the writer.
+ *
+ * @public @memberof t_dataset_writer
+ */
+void
+t_dataset_writer_close(struct t_dataset_writer **writer_ptr);
+
+/*!
+ * Map a container and load its index.
+ *
+ * @public @memberof t_dataset_reader
+ */
+bool
+t_dataset_reader_open(const char *path, struct t_dataset_reader **out_reader);
+
+/*!
+ * Number of cameras the container was recorded with.
+ *
+ * @public @memberof t_dataset_reader
+ */
+uint32_t
+t_dataset_reader_get_cam_count(const struct t_dataset_reader *reader);
+
+/*!
+ * Number of frames of camera @p cam_index.
+ *
+ * @public @memberof t_dataset_reader
+ */
+size_t
+t_dataset_reader_get_frame_count(const struct t_dataset_reader *reader, uint32_t cam_index);
+
+/*!
+ * Number of IMU samples.
+ *
+ * @public @memberof t_dataset_reader
+ */
+size_t
+t_dataset_reader_get_imu_count(const struct t_dataset_reader *reader);
+
+/*!
+ * Number of groundtruth samples.
+ *
+ * @public @memberof t_dataset_reader
+ */
+size_t
+t_dataset_reader_get_gt_count(const struct t_dataset_reader *reader);
+
+/*!
+ * Get frame @p index of camera @p cam_index, frames are in recorded order.
+ *
+ * @public @memberof t_dataset_reader
+ */
+bool
+t_dataset_reader_get_frame(const struct t_dataset_reader *reader,
+                           uint32_t cam_index,
+                           size_t index,
+                           struct t_dataset_frame *out_frame);
+
+/*!
+ * Get IMU sample @p index.
+ *
+ * @public @memberof t_dataset_reader
+ */
+bool
+t_dataset_reader_get_imu(const struct t_dataset_reader *reader, size_t index, struct xrt_imu_sample *out_sample);
+
+/*!
+ * Get groundtruth sample @p index.
+ *
+ * @public @memberof t_dataset_reader
+ */
+bool
+t_dataset_reader_get_gt(const struct t_dataset_reader *reader, size_t index, struct xrt_pose_sample *out_sample);
+
+/*!
+ * Unmap the container and free the reader.
+ *
+ * @public @memberof t_dataset_reader
+ */
+void
+t_dataset_reader_destroy(struct t_dataset_reader **reader_ptr);
+
+/*!
+ * @}
+ */
+
+
+#ifdef __cplusplus
+}
+#endif
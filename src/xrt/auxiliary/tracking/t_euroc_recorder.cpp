@@ -8,6 +8,7 @@
  */
 
 #include "t_euroc_recorder.h"
+#include "t_dataset_container.h"
 
 #include "os/os_time.h"
 #include "util/u_frame.h"
@@ -17,28 +18,56 @@
 #include "xrt/xrt_defines.h"
 #include "xrt/xrt_tracking.h"
 
+#include <algorithm>
 #include <cassert>
+#include <condition_variable>
 #include <ctime>
+#include <deque>
 #include <filesystem>
 #include <fstream>
 #include <mutex>
 #include <string>
 #include <queue>
 #include <iomanip>
+#include <thread>
 
 #include <opencv2/imgcodecs.hpp>
 
 DEBUG_GET_ONCE_BOOL_OPTION(euroc_recorder_use_jpg, "EUROC_RECORDER_USE_JPG", false)
+DEBUG_GET_ONCE_OPTION(euroc_recorder_format, "EUROC_RECORDER_FORMAT", NULL)
+DEBUG_GET_ONCE_NUM_OPTION(euroc_recorder_threads, "EUROC_RECORDER_THREADS", 4)
+DEBUG_GET_ONCE_NUM_OPTION(euroc_recorder_max_pending, "EUROC_RECORDER_MAX_PENDING", 32)
+DEBUG_GET_ONCE_BOOL_OPTION(euroc_recorder_container, "EUROC_RECORDER_CONTAINER", false)
 
+using std::condition_variable;
+using std::deque;
 using std::lock_guard;
 using std::mutex;
 using std::ofstream;
 using std::queue;
 using std::string;
+using std::thread;
 using std::to_string;
+using std::unique_lock;
 using std::vector;
 using std::filesystem::create_directories;
 
+//! How camera images are stored on disk.
+enum euroc_recorder_image_format
+{
+	EUROC_RECORDER_IMAGE_PNG,      //!< Default OpenCV PNG compression
+	EUROC_RECORDER_IMAGE_PNG_FAST, //!< Lowest PNG compression level, much faster to encode
+	EUROC_RECORDER_IMAGE_JPG,      //!< Lossy, smallest files
+	EUROC_RECORDER_IMAGE_RAW,      //!< Uncompressed PGM/PPM, no encoding cost at all
+};
+
+//! A camera image waiting to be encoded and written by the writer threads.
+struct euroc_recorder_write_job
+{
+	struct xrt_frame *frame; //!< Referenced, released once written
+	string path;
+};
+
 struct euroc_recorder
 {
 	struct xrt_frame_node node;
@@ -49,7 +78,26 @@ struct euroc_recorder
 	bool files_created;                //!< Whether the dataset directory structure has been created
 	struct u_var_button recording_btn; //!< UI button to start/stop `recording`
 
-	bool use_jpg; //! Whether or not we should save images as .jpg files
+	enum euroc_recorder_image_format image_format; //!< How to save camera images
+
+	//! Pool of threads encoding and writing camera images, the sink threads only queue them up
+	struct
+	{
+		vector<thread> threads;
+		deque<euroc_recorder_write_job> jobs; //!< Bounded by @ref max_pending
+		mutex lock;                           //!< Protects everything in here
+		condition_variable has_jobs;          //!< Signalled when a job is added or on stop
+		condition_variable has_room;          //!< Signalled when a job is taken
+		size_t max_pending;                   //!< Max queued jobs before the sink threads block
+		bool stop;                            //!< Threads exit once the queue is drained
+
+		// Stats, shown in the UI.
+		uint64_t written;      //!< Images written to disk
+		uint64_t pending;      //!< Images currently queued
+		uint64_t peak_pending; //!< Most images queued at once
+		uint64_t stalls;       //!< Times a sink thread had to wait for room
+		uint64_t stalled_ms;   //!< Total time sink threads waited for room
+	} writer;
 
 	// Cloner sinks: copy frame to heap for quick release of the original
 	struct xrt_slam_sinks cloner_queues; //!< Queue sinks that write into cloner sinks
@@ -74,6 +122,9 @@ struct euroc_recorder
 	ofstream *imu_csv = nullptr;
 	ofstream *gt_csv = nullptr;
 	ofstream *cams_csv[XRT_TRACKING_MAX_SLAM_CAMS] = {};
+
+	//! If set everything goes into this single file instead, see @ref aux_tracking_dataset
+	struct t_dataset_writer *container = nullptr;
 };
 
 
@@ -94,6 +145,14 @@ euroc_recorder_try_mkfiles(struct euroc_recorder *er)
 
 	string path = er->path;
 
+	if (debug_get_bool_option_euroc_recorder_container()) {
+		string file = path + T_DATASET_CONTAINER_EXTENSION;
+		if (!t_dataset_writer_create(file.c_str(), er->cam_count, &er->container)) {
+			U_LOG_E("Could not create '%s', nothing will be recorded", file.c_str());
+		}
+		return;
+	}
+
 	create_directories(path + "/mav0/imu0");
 	er->imu_csv = new ofstream{path + "/mav0/imu0/data.csv"};
 	*er->imu_csv << std::fixed << std::setprecision(CSV_PRECISION);
@@ -151,6 +210,10 @@ euroc_recorder_flush(struct euroc_recorder *er)
 		xrt_sink_push_pose(&er->writer_gt_sink, &sample);
 	}
 
+	if (er->imu_csv == nullptr) {
+		return; // Container or it failed to be created, nothing to flush.
+	}
+
 	// Flush csv streams. Not necessary, doing it only to increase flush frequency
 	er->imu_csv->flush();
 	er->gt_csv->flush();
@@ -164,6 +227,13 @@ euroc_recorder_save_imu(xrt_imu_sink *sink, struct xrt_imu_sample *sample)
 {
 	euroc_recorder *er = container_of(sink, euroc_recorder, writer_imu_sink);
 
+	if (er->imu_csv == nullptr) {
+		if (er->container != nullptr) {
+			t_dataset_writer_push_imu(er->container, sample);
+		}
+		return;
+	}
+
 	timepoint_ns ts = sample->timestamp_ns;
 	xrt_vec3_f64 a = sample->accel_m_s2;
 	xrt_vec3_f64 w = sample->gyro_rad_secs;
@@ -178,6 +248,13 @@ euroc_recorder_save_gt(xrt_pose_sink *sink, struct xrt_pose_sample *sample)
 {
 	euroc_recorder *er = container_of(sink, euroc_recorder, writer_gt_sink);
 
+	if (er->gt_csv == nullptr) {
+		if (er->container != nullptr) {
+			t_dataset_writer_push_gt(er->container, sample);
+		}
+		return;
+	}
+
 	timepoint_ns ts = sample->timestamp_ns;
 	xrt_vec3 p = sample->pose.position;
 	xrt_quat o = sample->pose.orientation;
@@ -187,6 +264,76 @@ euroc_recorder_save_gt(xrt_pose_sink *sink, struct xrt_pose_sample *sample)
 	*er->gt_csv << o.w << "," << o.x << "," << o.y << "," << o.z << CSV_EOL;
 }
 
+static void
+euroc_recorder_write_image(euroc_recorder *er, const euroc_recorder_write_job &job)
+{
+	struct xrt_frame *frame = job.frame;
+
+	auto img_type = frame->format == XRT_FORMAT_L8 ? CV_8UC1 : CV_8UC3;
+	cv::Mat img{(int)frame->height, (int)frame->width, img_type, frame->data, frame->stride};
+
+	vector<int> params{};
+	if (er->image_format == EUROC_RECORDER_IMAGE_PNG_FAST) {
+		params = {cv::IMWRITE_PNG_COMPRESSION, 1};
+	}
+
+	cv::imwrite(job.path, img, params);
+}
+
+static void
+euroc_recorder_writer_run(euroc_recorder *er)
+{
+	unique_lock lock{er->writer.lock};
+
+	while (true) {
+		er->writer.has_jobs.wait(lock, [er] { return er->writer.stop || !er->writer.jobs.empty(); });
+
+		// Only exit once everything queued has been written.
+		if (er->writer.jobs.empty()) {
+			return;
+		}
+
+		euroc_recorder_write_job job = std::move(er->writer.jobs.front());
+		er->writer.jobs.pop_front();
+		er->writer.pending = er->writer.jobs.size();
+		er->writer.has_room.notify_one();
+
+		lock.unlock();
+		euroc_recorder_write_image(er, job);
+		xrt_frame_reference(&job.frame, NULL);
+		lock.lock();
+
+		er->writer.written++;
+	}
+}
+
+static void
+euroc_recorder_writer_stop(euroc_recorder *er)
+{
+	{
+		lock_guard lock{er->writer.lock};
+		er->writer.stop = true;
+	}
+
+	er->writer.has_jobs.notify_all();
+	er->writer.has_room.notify_all();
+
+	for (thread &t : er->writer.threads) {
+		t.join();
+	}
+	er->writer.threads.clear();
+}
+
+static const char *
+euroc_recorder_file_extension(euroc_recorder *er, struct xrt_frame *frame)
+{
+	switch (er->image_format) {
+	case EUROC_RECORDER_IMAGE_JPG: return ".jpg";
+	case EUROC_RECORDER_IMAGE_RAW: return frame->format == XRT_FORMAT_L8 ? ".pgm" : ".ppm";
+	default: return ".png";
+	}
+}
+
 static void
 euroc_recorder_save_frame(euroc_recorder *er, struct xrt_frame *frame, int cam_index)
 {
@@ -194,14 +341,44 @@ euroc_recorder_save_frame(euroc_recorder *er, struct xrt_frame *frame, int cam_i
 	uint64_t ts = frame->timestamp;
 
 	assert(frame->format == XRT_FORMAT_L8 || frame->format == XRT_FORMAT_R8G8B8); // Only formats supported
-	auto img_type = frame->format == XRT_FORMAT_L8 ? CV_8UC1 : CV_8UC3;
-	string file_extension = er->use_jpg ? ".jpg" : ".png";
-	string filename = std::to_string(ts) + file_extension;
+
+	// Raw frames are written straight away, there is no encoding to offload.
+	if (er->cams_csv[cam_index] == nullptr) {
+		if (er->container != nullptr && t_dataset_writer_push_frame(er->container, cam_index, frame)) {
+			lock_guard lock{er->writer.lock};
+			er->writer.written++;
+		}
+		return;
+	}
+
+	string filename = std::to_string(ts) + euroc_recorder_file_extension(er, frame);
 	string img_path = er->path + "/mav0/" + cam_name + "/data/" + filename;
-	cv::Mat img{(int)frame->height, (int)frame->width, img_type, frame->data, frame->stride};
-	cv::imwrite(img_path, img);
 
 	*er->cams_csv[cam_index] << ts << "," << filename << CSV_EOL;
+
+	// Hand the frame to the writer threads, block if they are too far behind.
+	unique_lock lock{er->writer.lock};
+
+	if (er->writer.jobs.size() >= er->writer.max_pending) {
+		timepoint_ns start_ns = os_monotonic_get_ns();
+		er->writer.stalls++;
+		er->writer.has_room.wait(
+		    lock, [er] { return er->writer.stop || er->writer.jobs.size() < er->writer.max_pending; });
+		er->writer.stalled_ms += (os_monotonic_get_ns() - start_ns) / U_TIME_1MS_IN_NS;
+	}
+
+	if (er->writer.stop) {
+		return;
+	}
+
+	euroc_recorder_write_job job{};
+	xrt_frame_reference(&job.frame, frame);
+	job.path = std::move(img_path);
+
+	er->writer.jobs.push_back(std::move(job));
+	er->writer.pending = er->writer.jobs.size();
+	er->writer.peak_pending = std::max(er->writer.peak_pending, er->writer.pending);
+	er->writer.has_jobs.notify_one();
 }
 
 #define DEFINE_SAVE_CAM(cam_id)                                                                                        \
@@ -322,12 +499,19 @@ static void (*euroc_recorder_receive_cam[XRT_TRACKING_MAX_SLAM_CAMS])(struct xrt
 
 extern "C" void
 euroc_recorder_node_break_apart(struct xrt_frame_node *node)
-{}
+{
+	struct euroc_recorder *er = container_of(node, struct euroc_recorder, node);
+
+	// Writes out everything still queued.
+	euroc_recorder_writer_stop(er);
+}
 
 extern "C" void
 euroc_recorder_node_destroy(struct xrt_frame_node *node)
 {
 	struct euroc_recorder *er = container_of(node, struct euroc_recorder, node);
+	euroc_recorder_writer_stop(er);
+	t_dataset_writer_close(&er->container);
 	delete er->imu_csv;
 	delete er->gt_csv;
 	for (int i = 0; i < er->cam_count; i++) {
@@ -343,6 +527,33 @@ euroc_recorder_node_destroy(struct xrt_frame_node *node)
  *
  */
 
+static enum euroc_recorder_image_format
+euroc_recorder_get_image_format()
+{
+	const char *format = debug_get_option_euroc_recorder_format();
+
+	if (format == nullptr) {
+		// Older option, kept working.
+		return debug_get_bool_option_euroc_recorder_use_jpg() ? EUROC_RECORDER_IMAGE_JPG
+		                                                      : EUROC_RECORDER_IMAGE_PNG;
+	}
+
+	string str{format};
+	if (str == "png") {
+		return EUROC_RECORDER_IMAGE_PNG;
+	} else if (str == "png_fast") {
+		return EUROC_RECORDER_IMAGE_PNG_FAST;
+	} else if (str == "jpg") {
+		return EUROC_RECORDER_IMAGE_JPG;
+	} else if (str == "raw") {
+		return EUROC_RECORDER_IMAGE_RAW;
+	}
+
+	U_LOG_W("Unknown EUROC_RECORDER_FORMAT '%s', valid are png, png_fast, jpg and raw.", format);
+
+	return EUROC_RECORDER_IMAGE_PNG;
+}
+
 extern "C" xrt_slam_sinks *
 euroc_recorder_create(struct xrt_frame_context *xfctx, const char *record_path, int cam_count, bool record_from_start)
 {
@@ -372,7 +583,13 @@ euroc_recorder_create(struct xrt_frame_context *xfctx, const char *record_path,
 		euroc_recorder_try_mkfiles(er);
 	}
 
-	er->use_jpg = debug_get_bool_option_euroc_recorder_use_jpg();
+	er->image_format = euroc_recorder_get_image_format();
+
+	er->writer.max_pending = std::max<int>(1, debug_get_num_option_euroc_recorder_max_pending());
+	int thread_count = std::max<int>(1, debug_get_num_option_euroc_recorder_threads());
+	for (int i = 0; i < thread_count; i++) {
+		er->writer.threads.emplace_back(euroc_recorder_writer_run, er);
+	}
 
 	// Setup sink pipeline
 
@@ -431,4 +648,15 @@ euroc_recorder_add_ui(struct xrt_slam_sinks *public_sinks, void *root, const cha
 	char tmp[256];
 	(void)snprintf(tmp, sizeof(tmp), "%s%s", prefix, er->recording ? "Stop recording" : "Record EuRoC dataset");
 	u_var_add_button(root, &er->recording_btn, tmp);
+
+	(void)snprintf(tmp, sizeof(tmp), "%sImages written", prefix);
+	u_var_add_ro_u64(root, &er->writer.written, tmp);
+	(void)snprintf(tmp, sizeof(tmp), "%sImages pending", prefix);
+	u_var_add_ro_u64(root, &er->writer.pending, tmp);
+	(void)snprintf(tmp, sizeof(tmp), "%sPeak images pending", prefix);
+	u_var_add_ro_u64(root, &er->writer.peak_pending, tmp);
+	(void)snprintf(tmp, sizeof(tmp), "%sWriter stalls", prefix);
+	u_var_add_ro_u64(root, &er->writer.stalls, tmp);
+	(void)snprintf(tmp, sizeof(tmp), "%sWriter stalled (ms)", prefix);
+	u_var_add_ro_u64(root, &er->writer.stalled_ms, tmp);
 }
@@ -109,6 +109,50 @@ calibration_get_undistort_map(t_camera_calibration &calib,
 	return ret;
 }
 
+void
+calibration_undistort_keypoints(const cv::Matx33d &intrinsics,
+                                const cv::Mat &distortion,
+                                enum t_camera_distortion_model distortion_model,
+                                cv::InputArray rectify_transform_optional,
+                                cv::Mat new_camera_matrix_optional,
+                                std::vector<cv::KeyPoint> &keypoints)
+{
+	if (keypoints.empty()) {
+		return;
+	}
+
+	if (new_camera_matrix_optional.empty()) {
+		new_camera_matrix_optional = cv::Mat(intrinsics);
+	}
+
+	std::vector<cv::Point2f> points;
+	cv::KeyPoint::convert(keypoints, points);
+
+	switch (distortion_model) {
+	case (T_DISTORTION_FISHEYE_KB4):
+		cv::fisheye::undistortPoints(points,                      // distorted
+		                             points,                      // undistorted
+		                             intrinsics,                  // K
+		                             distortion,                  // D
+		                             rectify_transform_optional,  // R
+		                             new_camera_matrix_optional); // P
+		break;
+	case T_DISTORTION_OPENCV_RADTAN_5:
+		cv::undistortPoints(points,                      // src
+		                    points,                      // dst
+		                    intrinsics,                  // cameraMatrix
+		                    distortion,                  // distCoeffs
+		                    rectify_transform_optional,  // R
+		                    new_camera_matrix_optional); // P
+		break;
+	default: assert(false);
+	}
+
+	for (size_t i = 0; i < keypoints.size(); i++) {
+		keypoints[i].pt = points[i];
+	}
+}
+
 StereoRectificationMaps::StereoRectificationMaps(t_stereo_camera_calibration *data)
 {
 	CALIB_ASSERT_(data != NULL);
@@ -33,6 +33,9 @@ public:
 	struct u_sink_debug usd = {};
 	struct xrt_frame *frame = {};
 
+	//! Debug frames are recycled, they are the same size every time.
+	struct u_frame_pool *pool = {};
+
 	cv::Mat rgb[2] = {};
 
 
@@ -40,6 +43,7 @@ public:
 	HelperDebugSink(Kind kind)
 	{
 		this->kind = kind;
+		this->pool = u_frame_pool_create(2);
 		u_sink_debug_init(&usd);
 	}
 
@@ -49,6 +53,7 @@ public:
 	{
 		u_sink_debug_destroy(&usd);
 		xrt_frame_reference(&frame, NULL);
+		u_frame_pool_reference(&pool, NULL);
 	}
 
 	void
@@ -89,7 +94,7 @@ public:
 		}
 
 		// Create a new frame and also dereferences the old frame.
-		u_frame_create_one_off(XRT_FORMAT_R8G8B8, width, height, &frame);
+		u_frame_pool_create_frame(pool, XRT_FORMAT_R8G8B8, width, height, &frame);
 
 		// Copy needed info.
 		frame->source_sequence = xf->source_sequence;
@@ -15,6 +15,8 @@
 #include "util/u_format.h"
 #include "util/u_trace_marker.h"
 
+#include "math/m_mathinclude.h"
+
 #include "tracking/t_tracking.h"
 
 #include <stdio.h>
@@ -124,6 +126,45 @@ t_hsv_build_optimized_table(struct t_hsv_filter_params *params, struct t_hsv_fil
 
 #define NUM_CHANNELS 4
 
+//! Biggest blob kept, same as the max area of the PSMV blob detector.
+#define BLOB_MAX_AREA 1000
+
+//! Marks a run that is not yet part of a component.
+#define BLOB_NO_LABEL UINT32_MAX
+
+//! A horizontal run of set pixels on one row, @p end is exclusive.
+struct hsv_blob_run
+{
+	uint32_t start;
+	uint32_t end;
+	uint32_t label;
+};
+
+//! A union-find node, with the stats of the runs labeled with it.
+struct hsv_blob_label
+{
+	uint32_t parent;
+	uint32_t area;
+	uint64_t sum_x;
+	uint64_t sum_y;
+};
+
+//! Connected component state of one channel that has a blob sink.
+struct hsv_blob_channel
+{
+	struct t_hsv_blob_sink *sink;
+
+	//! Runs of the previous and the current row, each big enough for a row.
+	struct hsv_blob_run *prev, *cur;
+	uint32_t prev_count, cur_count;
+	uint32_t run_capacity;
+
+	//! Grows as needed, kept between frames.
+	struct hsv_blob_label *labels;
+	uint32_t label_count;
+	uint32_t label_capacity;
+};
+
 /*!
  * An @ref xrt_frame_sink that splits the input based on hue.
  * @implements xrt_frame_sink
@@ -144,6 +185,16 @@ struct t_hsv_filter
 	struct u_sink_debug usds[NUM_CHANNELS];
 
 	struct t_hsv_filter_optimized_table table;
+
+	//! Channels extracting blobs in the classification pass.
+	struct hsv_blob_channel blobs[NUM_CHANNELS];
+
+	//! Any channel has a blob sink.
+	bool has_blobs;
+
+	//! Classification of one row, one bit per channel per pixel.
+	uint8_t *row_bits;
+	uint32_t row_bits_size;
 };
 
 static void
@@ -256,10 +307,270 @@ ensure_buf_allocated(struct t_hsv_filter *f, struct xrt_frame *xf)
 	uint32_t h = xf->height;
 
 	for (size_t i = 0; i < NUM_CHANNELS; i++) {
+		// Blob channels never get a frame.
+		if (f->blobs[i].sink != NULL) {
+			continue;
+		}
 		u_frame_create_one_off(XRT_FORMAT_L8, w, h, &f->frames[i]);
 	}
 }
 
+
+/*
+ *
+ * Fused blob extraction.
+ *
+ */
+
+static uint32_t
+blob_find(struct hsv_blob_channel *c, uint32_t label)
+{
+	while (c->labels[label].parent != label) {
+		// Path halving.
+		c->labels[label].parent = c->labels[c->labels[label].parent].parent;
+		label = c->labels[label].parent;
+	}
+	return label;
+}
+
+static uint32_t
+blob_union(struct hsv_blob_channel *c, uint32_t a, uint32_t b)
+{
+	a = blob_find(c, a);
+	b = blob_find(c, b);
+	if (a < b) {
+		c->labels[b].parent = a;
+		return a;
+	}
+	c->labels[a].parent = b;
+	return b;
+}
+
+static uint32_t
+blob_new_label(struct hsv_blob_channel *c)
+{
+	if (c->label_count == c->label_capacity) {
+		c->label_capacity = c->label_capacity == 0 ? 256 : c->label_capacity * 2;
+		U_ARRAY_REALLOC_OR_FREE(c->labels, struct hsv_blob_label, c->label_capacity);
+	}
+
+	uint32_t label = c->label_count++;
+	c->labels[label].parent = label;
+	c->labels[label].area = 0;
+	c->labels[label].sum_x = 0;
+	c->labels[label].sum_y = 0;
+	return label;
+}
+
+static void
+blob_channel_begin(struct hsv_blob_channel *c, uint32_t width)
+{
+	// At most one run every other pixel, plus one for the stereo split.
+	uint32_t capacity = width / 2 + 2;
+	if (c->run_capacity < capacity) {
+		c->run_capacity = capacity;
+		U_ARRAY_REALLOC_OR_FREE(c->prev, struct hsv_blob_run, capacity);
+		U_ARRAY_REALLOC_OR_FREE(c->cur, struct hsv_blob_run, capacity);
+	}
+
+	c->prev_count = 0;
+	c->cur_count = 0;
+	c->label_count = 0;
+}
+
+//! Labels the runs of the current row, connecting them (8-connectivity) to the previous row.
+static void
+blob_channel_end_row(struct hsv_blob_channel *c, uint32_t y, uint32_t split_x)
+{
+	uint32_t j = 0;
+	for (uint32_t i = 0; i < c->cur_count; i++) {
+		struct hsv_blob_run *r = &c->cur[i];
+		bool r_right = r->start >= split_x;
+		r->label = BLOB_NO_LABEL;
+
+		// Skip previous runs that end before this one, including diagonally.
+		while (j < c->prev_count && c->prev[j].end < r->start) {
+			j++;
+		}
+
+		for (uint32_t k = j; k < c->prev_count && c->prev[k].start <= r->end; k++) {
+			// Never connect the two views of a stereo frame.
+			if ((c->prev[k].start >= split_x) != r_right) {
+				continue;
+			}
+
+			if (r->label == BLOB_NO_LABEL) {
+				r->label = blob_find(c, c->prev[k].label);
+			} else {
+				r->label = blob_union(c, r->label, c->prev[k].label);
+			}
+		}
+
+		if (r->label == BLOB_NO_LABEL) {
+			r->label = blob_new_label(c);
+		}
+
+		uint32_t len = r->end - r->start;
+		struct hsv_blob_label *l = &c->labels[r->label];
+		l->area += len;
+		l->sum_x += (uint64_t)(r->start + r->end - 1) * len / 2;
+		l->sum_y += (uint64_t)y * len;
+	}
+
+	struct hsv_blob_run *tmp = c->prev;
+	c->prev = c->cur;
+	c->prev_count = c->cur_count;
+	c->cur = tmp;
+	c->cur_count = 0;
+}
+
+//! Collects the components, keeping the biggest ones, and pushes them.
+static void
+blob_channel_end(struct hsv_blob_channel *c, struct xrt_frame *xf)
+{
+	// Move the stats of merged labels to their roots.
+	for (uint32_t i = 0; i < c->label_count; i++) {
+		uint32_t root = blob_find(c, i);
+		if (root == i) {
+			continue;
+		}
+		c->labels[root].area += c->labels[i].area;
+		c->labels[root].sum_x += c->labels[i].sum_x;
+		c->labels[root].sum_y += c->labels[i].sum_y;
+		c->labels[i].area = 0;
+	}
+
+	struct t_hsv_blob blobs[T_HSV_MAX_BLOBS];
+	uint32_t count = 0;
+
+	for (uint32_t i = 0; i < c->label_count; i++) {
+		const struct hsv_blob_label *l = &c->labels[i];
+		if (l->area == 0 || l->area > BLOB_MAX_AREA) {
+			continue;
+		}
+
+		// Smallest kept blob is last, skip if no bigger than it when full.
+		if (count == T_HSV_MAX_BLOBS && blobs[count - 1].area >= l->area) {
+			continue;
+		}
+
+		struct t_hsv_blob b;
+		b.x = (float)((double)l->sum_x / l->area);
+		b.y = (float)((double)l->sum_y / l->area);
+		b.size = 2.0f * sqrtf((float)l->area / (float)M_PI);
+		b.area = l->area;
+
+		// Insertion sort by decreasing area.
+		uint32_t pos = count < T_HSV_MAX_BLOBS ? count++ : count - 1;
+		while (pos > 0 && blobs[pos - 1].area < b.area) {
+			blobs[pos] = blobs[pos - 1];
+			pos--;
+		}
+		blobs[pos] = b;
+	}
+
+	c->sink->push_blobs(c->sink, xf, blobs, count);
+}
+
+/*!
+ * Classifies a row into @ref row_bits, YUV888 is one sample per pixel and
+ * YUYV422 shares the chroma between two pixels.
+ */
+static void
+hsv_classify_row(struct t_hsv_filter *f, struct xrt_frame *xf, uint32_t y)
+{
+	const uint8_t *src = xf->data + y * xf->stride;
+	uint8_t *bits = f->row_bits;
+
+	if (xf->format == XRT_FORMAT_YUV888) {
+		for (uint32_t x = 0; x < xf->width; x++) {
+			bits[x] = t_hsv_filter_sample(&f->table, src[0], src[1], src[2]);
+			src += 3;
+		}
+		return;
+	}
+
+	for (uint32_t x = 0; x < xf->width; x += 2) {
+		uint8_t cb = src[1];
+		uint8_t cr = src[3];
+		bits[x + 0] = t_hsv_filter_sample(&f->table, src[0], cb, cr);
+		bits[x + 1] = t_hsv_filter_sample(&f->table, src[2], cb, cr);
+		src += 4;
+	}
+}
+
+/*!
+ * One scanline pass that classifies pixels once, writes the frames of the
+ * frame channels and extracts runs for the blob channels.
+ */
+XRT_NO_INLINE static void
+hsv_process_frame_blobs(struct t_hsv_filter *f, struct xrt_frame *xf)
+{
+	SINK_TRACE_MARKER();
+
+	uint32_t width = xf->width;
+	uint32_t split_x = xf->stereo_format == XRT_STEREO_FORMAT_SBS ? width / 2 : width;
+
+	if (f->row_bits_size < width) {
+		f->row_bits_size = width;
+		U_ARRAY_REALLOC_OR_FREE(f->row_bits, uint8_t, width);
+	}
+
+	for (size_t i = 0; i < NUM_CHANNELS; i++) {
+		if (f->blobs[i].sink != NULL) {
+			blob_channel_begin(&f->blobs[i], width);
+		}
+	}
+
+	for (uint32_t y = 0; y < xf->height; y++) {
+		hsv_classify_row(f, xf, y);
+		const uint8_t *bits = f->row_bits;
+
+		for (size_t i = 0; i < NUM_CHANNELS; i++) {
+			uint8_t mask = (uint8_t)(1 << i);
+
+			if (f->blobs[i].sink == NULL) {
+				uint8_t *dst = f->frames[i]->data + y * f->frames[i]->stride;
+				for (uint32_t x = 0; x < width; x++) {
+					dst[x] = (bits[x] & mask) ? 0xff : 0x00;
+				}
+				continue;
+			}
+
+			struct hsv_blob_channel *c = &f->blobs[i];
+			uint32_t x = 0;
+			while (x < width) {
+				// Skip unset pixels.
+				while (x < width && (bits[x] & mask) == 0) {
+					x++;
+				}
+				if (x == width) {
+					break;
+				}
+
+				// Runs end at the stereo split.
+				uint32_t limit = x < split_x ? split_x : width;
+				uint32_t start = x;
+				while (x < limit && (bits[x] & mask) != 0) {
+					x++;
+				}
+
+				struct hsv_blob_run *r = &c->cur[c->cur_count++];
+				r->start = start;
+				r->end = x;
+			}
+
+			blob_channel_end_row(c, y, split_x);
+		}
+	}
+
+	for (size_t i = 0; i < NUM_CHANNELS; i++) {
+		if (f->blobs[i].sink != NULL) {
+			blob_channel_end(&f->blobs[i], xf);
+		}
+	}
+}
+
 static void
 push_buf(struct t_hsv_filter *f,
          struct xrt_frame *orig_xf,
@@ -290,17 +601,23 @@ hsv_frame(struct xrt_frame_sink *xsink, struct xrt_frame *xf)
 
 	switch (xf->format) {
 	case XRT_FORMAT_YUV888:
-		ensure_buf_allocated(f, xf);
-		hsv_process_frame_yuv(f, xf);
-		break;
 	case XRT_FORMAT_YUYV422:
 		ensure_buf_allocated(f, xf);
-		hsv_process_frame_yuyv(f, xf);
+		if (f->has_blobs) {
+			hsv_process_frame_blobs(f, xf);
+		} else if (xf->format == XRT_FORMAT_YUV888) {
+			hsv_process_frame_yuv(f, xf);
+		} else {
+			hsv_process_frame_yuyv(f, xf);
+		}
 		break;
 	default: U_LOG_E("Bad format '%s'", u_format_str(xf->format)); return;
 	}
 
 	for (size_t i = 0; i < NUM_CHANNELS; i++) {
+		if (f->blobs[i].sink != NULL) {
+			continue;
+		}
 		push_buf(f, xf, f->sinks[i], &f->usds[i], f->frames[i]);
 		xrt_frame_reference(&f->frames[i], NULL);
 	}
@@ -320,6 +637,12 @@ hsv_destroy(struct xrt_frame_node *node)
 	for (size_t i = 0; i < ARRAY_SIZE(f->usds); i++) {
 		u_sink_debug_destroy(&f->usds[i]);
 	}
+	for (size_t i = 0; i < ARRAY_SIZE(f->blobs); i++) {
+		free(f->blobs[i].prev);
+		free(f->blobs[i].cur);
+		free(f->blobs[i].labels);
+	}
+	free(f->row_bits);
 
 	free(f);
 }
@@ -329,6 +652,17 @@ t_hsv_filter_create(struct xrt_frame_context *xfctx,
                     struct t_hsv_filter_params *params,
                     struct xrt_frame_sink *sinks[4],
                     struct xrt_frame_sink **out_sink)
+{
+	struct t_hsv_blob_sink *blob_sinks[4] = {0};
+	return t_hsv_filter_create_with_blobs(xfctx, params, sinks, blob_sinks, out_sink);
+}
+
+int
+t_hsv_filter_create_with_blobs(struct xrt_frame_context *xfctx,
+                               struct t_hsv_filter_params *params,
+                               struct xrt_frame_sink *sinks[4],
+                               struct t_hsv_blob_sink *blob_sinks[4],
+                               struct xrt_frame_sink **out_sink)
 {
 	struct t_hsv_filter *f = U_TYPED_CALLOC(struct t_hsv_filter);
 	f->base.push_frame = hsv_frame;
@@ -340,6 +674,11 @@ t_hsv_filter_create(struct xrt_frame_context *xfctx,
 	f->sinks[2] = sinks[2];
 	f->sinks[3] = sinks[3];
 
+	for (size_t i = 0; i < NUM_CHANNELS; i++) {
+		f->blobs[i].sink = blob_sinks[i];
+		f->has_blobs |= blob_sinks[i] != NULL;
+	}
+
 	t_hsv_build_optimized_table(&f->params, &f->table);
 
 	xrt_frame_context_add(xfctx, &f->node);
@@ -15,81 +15,171 @@
 #ifdef XRT_HAVE_OPENVR
 #include <openvr.h>
 #include <cstddef>
-#include <map>
 
 #include "math/m_api.h"
+#include "math/m_relation_history.h"
 #include "os/os_threading.h"
 #include "util/u_logging.h"
 #include "util/u_time.h"
 #include "xrt/xrt_defines.h"
 #include "xrt/xrt_tracking.h"
 
+using xrt::auxiliary::math::RelationHistory;
+
+//! Number of device classes, the size of the per class arrays.
+#define DEVICE_CLASS_COUNT (T_OPENVR_DEVICE_TRACKER + 1)
+
+//! Predictions asked of OpenVR are clamped to this.
+#define MAX_PREDICTION_NS (100 * U_TIME_1MS_IN_NS)
+
+static const auto kOrigin = vr::ETrackingUniverseOrigin::TrackingUniverseRawAndUncalibrated;
+
 struct openvr_tracker
 {
 	vr::IVRSystem *vr_system;
 	struct os_thread_helper thread;
-	std::map<enum openvr_device, struct xrt_pose_sink *> sinks;
 	double sample_frequency_hz;
 
-	struct xrt_pose_sink *
-	get_sink_for_device_index(uint64_t i)
+	//! Serializes the calls into OpenVR, made from the polling thread and @ref t_openvr_tracker_get_relation.
+	struct os_mutex vr_mutex;
+
+	//! Where to push the samples of each device class, may be null.
+	struct xrt_pose_sink *sinks[DEVICE_CLASS_COUNT];
+
+	//! Relations of each device class, pushed by the polling thread.
+	RelationHistory histories[DEVICE_CLASS_COUNT];
+
+	//! Class of each OpenVR device index, only refreshed when devices come, go or change roles.
+	enum openvr_device index_to_device[vr::k_unMaxTrackedDeviceCount];
+
+	//! OpenVR device index of each class, protected by @ref vr_mutex.
+	int32_t device_to_index[DEVICE_CLASS_COUNT];
+
+	enum openvr_device
+	classify_device_index(uint32_t i)
 	{
 		vr::ETrackedDeviceClass dev_class = vr_system->GetTrackedDeviceClass(i);
-		struct xrt_pose_sink *sink = nullptr;
-		if (dev_class == vr::TrackedDeviceClass_HMD && sinks.count(T_OPENVR_DEVICE_HMD) > 0) {
-			sink = sinks.at(T_OPENVR_DEVICE_HMD);
-		} else if (dev_class == vr::TrackedDeviceClass_Controller &&
-		           vr_system->GetControllerRoleForTrackedDeviceIndex(i) == vr::TrackedControllerRole_LeftHand &&
-		           sinks.count(T_OPENVR_DEVICE_LEFT_CONTROLLER) > 0) {
-			sink = sinks.at(T_OPENVR_DEVICE_LEFT_CONTROLLER);
-		} else if (dev_class == vr::TrackedDeviceClass_Controller &&
-		           vr_system->GetControllerRoleForTrackedDeviceIndex(i) ==
-		               vr::TrackedControllerRole_RightHand &&
-		           sinks.count(T_OPENVR_DEVICE_RIGHT_CONTROLLER) > 0) {
-			sink = sinks.at(T_OPENVR_DEVICE_RIGHT_CONTROLLER);
-		} else if (dev_class == vr::TrackedDeviceClass_GenericTracker &&
-		           sinks.count(T_OPENVR_DEVICE_TRACKER) > 0) {
-			sink = sinks.at(T_OPENVR_DEVICE_TRACKER);
+		if (dev_class == vr::TrackedDeviceClass_HMD) {
+			return T_OPENVR_DEVICE_HMD;
+		}
+		if (dev_class == vr::TrackedDeviceClass_Controller) {
+			vr::ETrackedControllerRole role = vr_system->GetControllerRoleForTrackedDeviceIndex(i);
+			if (role == vr::TrackedControllerRole_LeftHand) {
+				return T_OPENVR_DEVICE_LEFT_CONTROLLER;
+			}
+			if (role == vr::TrackedControllerRole_RightHand) {
+				return T_OPENVR_DEVICE_RIGHT_CONTROLLER;
+			}
+		}
+		if (dev_class == vr::TrackedDeviceClass_GenericTracker) {
+			return T_OPENVR_DEVICE_TRACKER;
+		}
+		return T_OPENVR_DEVICE_UNKNOWN;
+	}
+
+	//! Only the first device of each class is used, so the histories don't mix devices.
+	void
+	refresh_device_classes_locked()
+	{
+		for (int32_t &index : device_to_index) {
+			index = -1;
+		}
+
+		for (uint32_t i = 0; i < vr::k_unMaxTrackedDeviceCount; i++) {
+			enum openvr_device dev = classify_device_index(i);
+			if (dev != T_OPENVR_DEVICE_UNKNOWN && device_to_index[dev] >= 0) {
+				dev = T_OPENVR_DEVICE_UNKNOWN;
+			}
+
+			index_to_device[i] = dev;
+			if (dev != T_OPENVR_DEVICE_UNKNOWN) {
+				device_to_index[dev] = (int32_t)i;
+			}
 		}
-		return sink;
 	}
 };
 
+static void
+pose_to_relation(const vr::TrackedDevicePose_t &pose, struct xrt_space_relation *out_relation)
+{
+	const auto &m = pose.mDeviceToAbsoluteTracking.m;
+	struct xrt_matrix_3x3 R = {
+	    m[0][0], m[0][1], m[0][2], //
+	    m[1][0], m[1][1], m[1][2], //
+	    m[2][0], m[2][1], m[2][2], //
+	};
+
+	struct xrt_space_relation rel = XRT_SPACE_RELATION_ZERO;
+	math_quat_from_matrix_3x3(&R, &rel.pose.orientation);
+	rel.pose.position = {m[0][3], m[1][3], m[2][3]};
+	rel.linear_velocity = {pose.vVelocity.v[0], pose.vVelocity.v[1], pose.vVelocity.v[2]};
+	rel.angular_velocity = {pose.vAngularVelocity.v[0], pose.vAngularVelocity.v[1], pose.vAngularVelocity.v[2]};
+
+	int flags = XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_POSITION_VALID_BIT |
+	            XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT | XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT;
+	if (pose.eTrackingResult == vr::TrackingResult_Running_OK) {
+		flags |= XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT | XRT_SPACE_RELATION_POSITION_TRACKED_BIT;
+	}
+	rel.relation_flags = (enum xrt_space_relation_flags)flags;
+
+	*out_relation = rel;
+}
+
+static bool
+is_device_change_event(uint32_t event_type)
+{
+	switch (event_type) {
+	case vr::VREvent_TrackedDeviceActivated:
+	case vr::VREvent_TrackedDeviceDeactivated:
+	case vr::VREvent_TrackedDeviceRoleChanged:
+	case vr::VREvent_TrackedDeviceUpdated: return true;
+	default: return false;
+	}
+}
+
 static void *
 tracking_loop(void *ot_ptr)
 {
 	struct openvr_tracker *ovrt = (struct openvr_tracker *)ot_ptr;
 
+	const uint32_t MAX_DEVS = vr::k_unMaxTrackedDeviceCount;
+	vr::TrackedDevicePose_t poses[MAX_DEVS];
+
 	while (os_thread_helper_is_running(&ovrt->thread)) {
 		os_nanosleep(U_TIME_1S_IN_NS / ovrt->sample_frequency_hz);
 
-		// Flush events
+		os_mutex_lock(&ovrt->vr_mutex);
+
+		// Flush events, the device classes only change when devices do.
+		bool refresh = false;
 		vr::VREvent_t event;
 		while (ovrt->vr_system->PollNextEvent(&event, sizeof(event))) {
+			refresh = refresh || is_device_change_event(event.eventType);
+		}
+		if (refresh) {
+			ovrt->refresh_device_classes_locked();
 		}
 
+		// All devices in one call.
 		timepoint_ns now = os_monotonic_get_ns();
+		ovrt->vr_system->GetDeviceToAbsoluteTrackingPose(kOrigin, 0, poses, MAX_DEVS);
 
-		const uint32_t MAX_DEVS = vr::k_unMaxTrackedDeviceCount;
-		auto origin = vr::ETrackingUniverseOrigin::TrackingUniverseRawAndUncalibrated;
-		vr::TrackedDevicePose_t poses[MAX_DEVS];
-		ovrt->vr_system->GetDeviceToAbsoluteTrackingPose(origin, 0, poses, MAX_DEVS);
+		os_mutex_unlock(&ovrt->vr_mutex);
 
 		for (uint32_t i = 0; i < MAX_DEVS; i++) {
-			struct xrt_pose_sink *sink_for_i = ovrt->get_sink_for_device_index(i);
-			if (sink_for_i != nullptr && poses[i].bDeviceIsConnected && poses[i].bPoseIsValid) {
-				const auto &m = poses[i].mDeviceToAbsoluteTracking.m;
-				struct xrt_vec3 p = {m[0][3], m[1][3], m[2][3]};
-				struct xrt_matrix_3x3 R = {
-				    m[0][0], m[0][1], m[0][2], //
-				    m[1][0], m[1][1], m[1][2], //
-				    m[2][0], m[2][1], m[2][2], //
-				};
-				struct xrt_quat q = {};
-				math_quat_from_matrix_3x3(&R, &q);
-
-				struct xrt_pose_sample sample = {now, {q, p}};
-				xrt_sink_push_pose(sink_for_i, &sample);
+			enum openvr_device dev = ovrt->index_to_device[i];
+			if (dev == T_OPENVR_DEVICE_UNKNOWN || !poses[i].bDeviceIsConnected || !poses[i].bPoseIsValid) {
+				continue;
+			}
+
+			struct xrt_space_relation rel;
+			pose_to_relation(poses[i], &rel);
+			ovrt->histories[dev].push(rel, now);
+
+			struct xrt_pose_sink *sink = ovrt->sinks[dev];
+			if (sink != nullptr) {
+				struct xrt_pose_sample sample = {now, rel.pose};
+				xrt_sink_push_pose(sink, &sample);
 			}
 		}
 	}
@@ -104,9 +194,12 @@ t_openvr_tracker_create(double sample_frequency, enum openvr_device *devs, struc
 {
 	struct openvr_tracker *ovrt = new openvr_tracker{};
 	os_thread_helper_init(&ovrt->thread);
+	os_mutex_init(&ovrt->vr_mutex);
 
 	for (int i = 0; i < sink_count; i++) {
-		ovrt->sinks[devs[i]] = sinks[i];
+		if (devs[i] > T_OPENVR_DEVICE_UNKNOWN && devs[i] < DEVICE_CLASS_COUNT) {
+			ovrt->sinks[devs[i]] = sinks[i];
+		}
 	}
 	ovrt->sample_frequency_hz = sample_frequency;
 
@@ -118,8 +211,14 @@ t_openvr_tracker_create(double sample_frequency, enum openvr_device *devs, struc
 		} else {
 			U_LOG_E("Unable to initialize OpenVR, error=%d", e);
 		}
+		os_mutex_destroy(&ovrt->vr_mutex);
+		os_thread_helper_destroy(&ovrt->thread);
+		delete ovrt;
 		return nullptr;
 	}
+
+	ovrt->refresh_device_classes_locked();
+
 	U_LOG(U_LOGGING_INFO, "OpenVR tracker created");
 	return ovrt;
 }
@@ -136,6 +235,59 @@ t_openvr_tracker_stop(struct openvr_tracker *ovrt)
 	os_thread_helper_stop_and_wait(&ovrt->thread);
 }
 
+bool
+t_openvr_tracker_get_relation(struct openvr_tracker *ovrt,
+                              enum openvr_device dev,
+                              int64_t at_timestamp_ns,
+                              struct xrt_space_relation *out_relation)
+{
+	struct xrt_space_relation zero = XRT_SPACE_RELATION_ZERO;
+	*out_relation = zero;
+
+	if (dev <= T_OPENVR_DEVICE_UNKNOWN || dev >= DEVICE_CLASS_COUNT) {
+		return false;
+	}
+
+	RelationHistory &history = ovrt->histories[dev];
+
+	uint64_t latest_ns = 0;
+	struct xrt_space_relation latest;
+	if (!history.get_latest(&latest_ns, &latest)) {
+		return false;
+	}
+
+	// Interpolated between the polled poses.
+	if (at_timestamp_ns <= (int64_t)latest_ns) {
+		history.get((uint64_t)at_timestamp_ns, out_relation);
+		return true;
+	}
+
+	// Newer than the last poll, OpenVR knows the motion of its devices better than extrapolating.
+	int64_t ahead_ns = at_timestamp_ns - (int64_t)os_monotonic_get_ns();
+	ahead_ns = ahead_ns < 0 ? 0 : ahead_ns > MAX_PREDICTION_NS ? MAX_PREDICTION_NS : ahead_ns;
+
+	vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
+	bool valid = false;
+
+	os_mutex_lock(&ovrt->vr_mutex);
+	int32_t index = ovrt->device_to_index[dev];
+	if (index >= 0) {
+		// Only up to the device asked for.
+		ovrt->vr_system->GetDeviceToAbsoluteTrackingPose(kOrigin, (float)time_ns_to_s(ahead_ns), poses,
+		                                                 (uint32_t)index + 1);
+		valid = poses[index].bDeviceIsConnected && poses[index].bPoseIsValid;
+	}
+	os_mutex_unlock(&ovrt->vr_mutex);
+
+	if (valid) {
+		pose_to_relation(poses[index], out_relation);
+	} else {
+		history.get((uint64_t)at_timestamp_ns, out_relation);
+	}
+
+	return true;
+}
+
 void
 t_openvr_tracker_destroy(struct openvr_tracker *ovrt)
 {
@@ -144,6 +296,7 @@ t_openvr_tracker_destroy(struct openvr_tracker *ovrt)
 	}
 	vr::VR_Shutdown();
 	ovrt->vr_system = nullptr;
+	os_mutex_destroy(&ovrt->vr_mutex);
 	os_thread_helper_destroy(&ovrt->thread);
 	delete ovrt;
 }
@@ -169,6 +322,17 @@ void
 t_openvr_tracker_stop(struct openvr_tracker * /*unused*/)
 {}
 
+bool
+t_openvr_tracker_get_relation(struct openvr_tracker * /*unused*/,
+                              enum openvr_device /*unused*/,
+                              int64_t /*unused*/,
+                              struct xrt_space_relation *out_relation)
+{
+	struct xrt_space_relation zero = XRT_SPACE_RELATION_ZERO;
+	*out_relation = zero;
+	return false;
+}
+
 void
 t_openvr_tracker_destroy(struct openvr_tracker * /*unused*/)
 {}
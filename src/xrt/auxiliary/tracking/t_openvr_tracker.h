@@ -31,7 +31,9 @@ struct openvr_tracker;
  *
  * This creates an OpenVR instance in a separate
  * thread, and reports the tracking data of each device class `devs[i]` into the
- * pose sink `sinks[i]` at a rate of `sample_frequency`.
+ * pose sink `sinks[i]` at a rate of `sample_frequency`. The poses of all
+ * devices are fetched with one call per poll and kept in a history, see
+ * @ref t_openvr_tracker_get_relation.
  *
  * @param sample_frequency_hz Sample frequency of the tracking data in hertz
  * @param devs Devices to report tracking data of
@@ -51,6 +53,20 @@ t_openvr_tracker_start(struct openvr_tracker *ovrt);
 void
 t_openvr_tracker_stop(struct openvr_tracker *ovrt);
 
+/*!
+ * Get the relation of the first device of class @p dev at @p at_timestamp_ns
+ * in the monotonic clock. Times up to the latest poll are interpolated between
+ * the polled poses, later ones are predicted by OpenVR for that time. Can be
+ * called from any thread.
+ *
+ * @return false if there has been no pose for the device yet.
+ */
+bool
+t_openvr_tracker_get_relation(struct openvr_tracker *ovrt,
+                              enum openvr_device dev,
+                              int64_t at_timestamp_ns,
+                              struct xrt_space_relation *out_relation);
+
 void
 t_openvr_tracker_destroy(struct openvr_tracker *ovrt);
 
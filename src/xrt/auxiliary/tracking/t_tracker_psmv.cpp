@@ -21,6 +21,7 @@
 #include "util/u_debug.h"
 #include "util/u_frame.h"
 #include "util/u_format.h"
+#include "util/u_worker.h"
 #include "util/u_trace_marker.h"
 
 #include "math/m_api.h"
@@ -35,6 +36,12 @@
 
 using namespace xrt::auxiliary::tracking;
 
+/*!
+ * Find blobs on the distorted frame and only undistort their keypoints,
+ * instead of undistorting and rectifying the whole frame.
+ */
+DEBUG_GET_ONCE_BOOL_OPTION(psmv_undistort_keypoints, "PSMV_UNDISTORT_KEYPOINTS", false)
+
 //! Namespace for PS Move tracking implementation
 namespace xrt::auxiliary::tracking::psmv {
 
@@ -53,48 +60,102 @@ public:
 	cv::Mat distortion; // size may vary
 	enum t_camera_distortion_model distortion_model;
 
+	//! Rectification and projection, to undistort keypoints without remapping the frame.
+	cv::Mat rectify_rotation;
+	cv::Mat rectify_projection;
+
+	//! Keypoints of all targets found in this view, for the current frame.
 	std::vector<cv::KeyPoint> keypoints;
 
+	//! Reused every frame, only reallocated if the frame size changes.
 	cv::Mat frame_undist_rectified;
 
+	//! One per view, the detector keeps state while detecting so the views can't share it.
+	cv::Ptr<cv::SimpleBlobDetector> sbd;
+
 	void
-	populate_from_calib(t_camera_calibration &calib, const RemapPair &rectification)
+	populate_from_calib(t_camera_calibration &calib, const ViewRectification &rectification)
 	{
 		CameraCalibrationWrapper wrap(calib);
 		intrinsics = wrap.intrinsics_mat;
 		distortion = wrap.distortion_mat.clone();
 		distortion_model = wrap.distortion_model;
 
-		undistort_rectify_map_x = rectification.remap_x;
-		undistort_rectify_map_y = rectification.remap_y;
+		undistort_rectify_map_x = rectification.rectify.remap_x;
+		undistort_rectify_map_y = rectification.rectify.remap_y;
+		rectify_rotation = rectification.rotation_mat;
+		rectify_projection = rectification.projection_mat;
+	}
+
+	//! Moves @ref keypoints found on the distorted frame to where they are on the rectified one.
+	void
+	undistort_rectify_keypoints()
+	{
+		calibration_undistort_keypoints(intrinsics, distortion, distortion_model, rectify_rotation,
+		                                rectify_projection, keypoints);
 	}
 };
 
 // Has to be standard layout because is embedded in TrackerPSMV.
 static_assert(std::is_standard_layout<View>::value);
 
+struct TrackerPSMV;
+
 /*!
- * The core object of the PS Move tracking setup.
+ * A single tracked controller, all targets of a @ref TrackerPSMV share its
+ * frames, thread and per view processing.
  *
  * @implements xrt_tracked_psmv
+ */
+struct TargetPSMV
+{
+public:
+	struct xrt_tracked_psmv base = {};
+	struct t_hsv_blob_sink blob_sink = {};
+
+	TrackerPSMV *tracker = nullptr;
+
+	//! Index in @ref TrackerPSMV::targets.
+	uint32_t index = 0;
+
+	//! Blobs found by the HSV filter in @ref TrackerPSMV::frame on this target's channel.
+	struct t_hsv_blob blobs[T_HSV_MAX_BLOBS];
+	uint32_t blob_count;
+
+	//! Keypoints of this target in each view, for the current frame.
+	std::vector<cv::KeyPoint> keypoints[2];
+
+	std::shared_ptr<PSMVFusionInterface> filter;
+
+	xrt_vec3 tracked_object_position;
+};
+
+// Has to be standard layout because is embedded in TrackerPSMV.
+static_assert(std::is_standard_layout<TargetPSMV>::value);
+
+/*!
+ * The core object of the PS Move tracking setup, processes every frame once
+ * for all of its targets.
+ *
  * @implements xrt_frame_sink
  * @implements xrt_frame_node
  */
 struct TrackerPSMV
 {
 public:
-	struct xrt_tracked_psmv base = {};
 	struct xrt_frame_sink sink = {};
 	struct xrt_frame_node node = {};
 
 	//! Frame waiting to be processed.
 	struct xrt_frame *frame;
 
+	//! Bitmask of the targets whose blobs for @ref frame have arrived.
+	uint32_t blobs_arrived;
+	bool frame_has_blobs;
+
 	//! Thread and lock helper.
 	struct os_thread_helper oth;
 
-	bool tracked = false;
-
 	HelperDebugSink debug = {HelperDebugSink::AllAvailable};
 
 	//! Have we received a new IMU sample.
@@ -110,20 +171,34 @@ public:
 
 	bool calibrated;
 
+	//! Only undistort keypoints instead of whole frames, see PSMV_UNDISTORT_KEYPOINTS.
+	bool undistort_keypoints;
+
 	cv::Mat disparity_to_depth;
 	cv::Vec3d r_cam_translation;
 	cv::Matx33d r_cam_rotation;
 
-	cv::Ptr<cv::SimpleBlobDetector> sbd;
-
-	std::shared_ptr<PSMVFusionInterface> filter;
+	//! Runs the two views at the same time, NULL if it couldn't be created.
+	struct u_worker_thread_pool *pool = nullptr;
+	struct u_worker_group *group = nullptr;
 
-	xrt_vec3 tracked_object_position;
+	TargetPSMV targets[T_PSMV_MAX_TARGETS];
+	uint32_t target_count;
 };
 
-// Has to be standard layout because of first element casts we do.
+// Has to be standard layout because of the container_of casts we do.
 static_assert(std::is_standard_layout<TrackerPSMV>::value);
 
+/*!
+ * Blobs of all targets for one frame, copied out of the targets by the tracker
+ * thread so that the next frame can arrive while they are processed.
+ */
+struct FrameBlobs
+{
+	struct t_hsv_blob blobs[T_PSMV_MAX_TARGETS][T_HSV_MAX_BLOBS];
+	uint32_t blob_counts[T_PSMV_MAX_TARGETS];
+};
+
 /*!
  * @brief Perform per-view (two in a stereo camera image) processing on an
  * image, before tracking math is performed.
@@ -135,7 +210,7 @@ do_view(TrackerPSMV &t, View &view, cv::Mat &grey, cv::Mat &rgb)
 {
 	XRT_TRACE_MARKER();
 
-	{
+	if (!t.undistort_keypoints) {
 		XRT_TRACE_IDENT(remap);
 
 		// Undistort and rectify the whole image.
@@ -151,11 +226,12 @@ do_view(TrackerPSMV &t, View &view, cv::Mat &grey, cv::Mat &rgb)
 	{
 		XRT_TRACE_IDENT(threshold);
 
-		cv::threshold(view.frame_undist_rectified, // src
-		              view.frame_undist_rectified, // dst
-		              32.0,                        // thresh
-		              255.0,                       // maxval
-		              0);                          // type
+		// Without the remap, threshold the distorted image directly.
+		cv::threshold(t.undistort_keypoints ? grey : view.frame_undist_rectified, // src
+		              view.frame_undist_rectified,                                 // dst
+		              32.0,                                                        // thresh
+		              255.0,                                                       // maxval
+		              0);                                                          // type
 	}
 
 	{
@@ -163,9 +239,9 @@ do_view(TrackerPSMV &t, View &view, cv::Mat &grey, cv::Mat &rgb)
 
 		// Do blob detection with our masks.
 		//! @todo Re-enable masks.
-		t.sbd->detect(view.frame_undist_rectified, // image
-		              view.keypoints,              // keypoints
-		              cv::noArray());              // mask
+		view.sbd->detect(view.frame_undist_rectified, // image
+		                 view.keypoints,              // keypoints
+		                 cv::noArray());              // mask
 	}
 
 
@@ -177,6 +253,80 @@ do_view(TrackerPSMV &t, View &view, cv::Mat &grey, cv::Mat &rgb)
 		                  cv::Scalar(255, 0, 0),                      // color
 		                  cv::DrawMatchesFlags::DRAW_RICH_KEYPOINTS); // flags
 	}
+
+	// After drawing, so the debug image shows them where they were found.
+	if (t.undistort_keypoints) {
+		XRT_TRACE_IDENT(undistort_keypoints);
+		view.undistort_rectify_keypoints();
+	}
+}
+
+/*!
+ * The grey halves of the stereo frame, for @ref do_views.
+ */
+struct ViewsData
+{
+	TrackerPSMV *t;
+	cv::Mat grey[2];
+};
+
+static void
+do_views(void *ptr, uint32_t begin, uint32_t end)
+{
+	ViewsData &data = *(ViewsData *)ptr;
+	TrackerPSMV &t = *data.t;
+
+	for (uint32_t i = begin; i < end; i++) {
+		do_view(t, t.view[i], data.grey[i], t.debug.rgb[i]);
+	}
+}
+
+/*!
+ * @brief Per-view processing for blobs already found by the HSV filter on the
+ * whole distorted stereo frame, only their keypoints get undistorted. The
+ * keypoints of all targets are undistorted together and then handed out to
+ * the targets.
+ */
+static void
+do_view_blobs(TrackerPSMV &t, uint32_t view_index, const FrameBlobs &fb, int x_min, int x_max)
+{
+	XRT_TRACE_MARKER();
+
+	View &view = t.view[view_index];
+	cv::Mat &rgb = t.debug.rgb[view_index];
+
+	size_t ends[T_PSMV_MAX_TARGETS];
+
+	view.keypoints.clear();
+	for (uint32_t k = 0; k < t.target_count; k++) {
+		for (uint32_t i = 0; i < fb.blob_counts[k]; i++) {
+			const t_hsv_blob &b = fb.blobs[k][i];
+			if (b.x < x_min || b.x >= x_max) {
+				continue;
+			}
+			view.keypoints.emplace_back(b.x - x_min, b.y, b.size);
+		}
+		ends[k] = view.keypoints.size();
+	}
+
+	// Debug is wanted, draw the keypoints where they were found.
+	if (rgb.cols > 0) {
+		cv::drawKeypoints(rgb,                                       // image
+		                  view.keypoints,                            // keypoints
+		                  rgb,                                       // outImage
+		                  cv::Scalar(255, 0, 0),                     // color
+		                  cv::DrawMatchesFlags::DRAW_RICH_KEYPOINTS | // flags
+		                      cv::DrawMatchesFlags::DRAW_OVER_OUTIMG);
+	}
+
+	view.undistort_rectify_keypoints();
+
+	size_t begin = 0;
+	for (uint32_t k = 0; k < t.target_count; k++) {
+		t.targets[k].keypoints[view_index].assign(view.keypoints.begin() + begin,
+		                                          view.keypoints.begin() + ends[k]);
+		begin = ends[k];
+	}
 }
 
 /*!
@@ -252,45 +402,14 @@ world_point_from_blobs(const cv::Point2f &left, const cv::Point2f &right, const
 }
 
 /*!
- * @brief Perform tracking computations on a frame of video data.
+ * @brief Matches the keypoints of a target between the views and feeds the
+ * closest resulting point to its filter.
  */
 static void
-process(TrackerPSMV &t, struct xrt_frame *xf)
+update_target(TrackerPSMV &t, TargetPSMV &target)
 {
-	XRT_TRACE_MARKER();
-
-	// Only IMU data: nothing to do
-	if (xf == NULL) {
-		return;
-	}
-
-	// Wrong type of frame: unreference and return?
-	if (xf->format != XRT_FORMAT_L8) {
-		xrt_frame_reference(&xf, NULL);
-		return;
-	}
-
-	if (!t.calibrated) {
-		return;
-	}
-
-	// Create the debug frame if needed.
-	t.debug.refresh(xf);
-
-	t.view[0].keypoints.clear();
-	t.view[1].keypoints.clear();
-
-	int cols = xf->width / 2;
-	int rows = xf->height;
-	int stride = xf->stride;
-
-	cv::Mat l_grey(rows, cols, CV_8UC1, xf->data, stride);
-	cv::Mat r_grey(rows, cols, CV_8UC1, xf->data + cols, stride);
-
-	do_view(t, t.view[0], l_grey, t.debug.rgb[0]);
-	do_view(t, t.view[1], r_grey, t.debug.rgb[1]);
-
-	cv::Point3f last_point(t.tracked_object_position.x, t.tracked_object_position.y, t.tracked_object_position.z);
+	cv::Point3f last_point(target.tracked_object_position.x, target.tracked_object_position.y,
+	                       target.tracked_object_position.z);
 	auto nearest_world = make_lowest_score_finder<cv::Point3f>([&](const cv::Point3f &world_point) {
 		//! @todo don't really need the square root to be done here.
 		return cv::norm(world_point - last_point);
@@ -299,13 +418,13 @@ process(TrackerPSMV &t, struct xrt_frame *xf)
 
 	const cv::Matx44d disparity_to_depth = static_cast<cv::Matx44d>(t.disparity_to_depth);
 
-	for (const cv::KeyPoint &l_keypoint : t.view[0].keypoints) {
+	for (const cv::KeyPoint &l_keypoint : target.keypoints[0]) {
 		cv::Point2f l_blob = l_keypoint.pt;
 
 		auto nearest_blob = make_lowest_score_finder<cv::Point2f>(
 		    [&](const cv::Point2f &r_blob) { return l_blob.x - r_blob.x; });
 
-		for (const cv::KeyPoint &r_keypoint : t.view[1].keypoints) {
+		for (const cv::KeyPoint &r_keypoint : target.keypoints[1]) {
 			cv::Point2f r_blob = r_keypoint.pt;
 			// find closest point on same-ish scanline
 			if ((l_blob.y < r_blob.y + 3) && (l_blob.y > r_blob.y - 3)) {
@@ -320,12 +439,85 @@ process(TrackerPSMV &t, struct xrt_frame *xf)
 		}
 	}
 
-	if (nearest_world.got_one) {
-		cv::Point3f world_point = nearest_world.best;
-		// update internal state
-		memcpy(&t.tracked_object_position, &world_point.x, sizeof(t.tracked_object_position));
+	if (!nearest_world.got_one) {
+		target.filter->clear_position_tracked_flag();
+		return;
+	}
+
+	cv::Point3f world_point = nearest_world.best;
+	// update internal state
+	memcpy(&target.tracked_object_position, &world_point.x, sizeof(target.tracked_object_position));
+
+#if 0
+	//! @todo something less arbitrary for the lever arm?
+	//! This puts the origin approximately under the PS
+	//! button.
+	xrt_vec3 lever_arm{0.f, 0.09f, 0.f};
+	//! @todo this should depend on distance
+	// Weirdly, this is where *not* applying the
+	// disparity-to-distance/rectification/etc would
+	// simplify things, since the measurement variance is
+	// related to the image sensor. 1.e-4 means 1cm std dev.
+	// Not sure how to estimate the depth variance without
+	// some research.
+	xrt_vec3 variance{1.e-4f, 1.e-4f, 4.e-4f};
+#endif
+	target.filter->process_3d_vision_data(0, &target.tracked_object_position, NULL, NULL,
+	                                      //! @todo tune cutoff for residual arbitrarily "too large"
+	                                      15);
+}
+
+/*!
+ * @brief Perform tracking computations on a frame of video data, @p fb has the
+ * blobs of all targets or is NULL if @p xf is a filtered frame for the only
+ * target.
+ */
+static void
+process(TrackerPSMV &t, struct xrt_frame *xf, const FrameBlobs *fb)
+{
+	XRT_TRACE_MARKER();
+
+	// Only IMU data: nothing to do
+	if (xf == NULL) {
+		return;
+	}
+
+	// Wrong type of frame: unreference and return?
+	if (fb == NULL && xf->format != XRT_FORMAT_L8) {
+		xrt_frame_reference(&xf, NULL);
+		return;
+	}
+
+	if (!t.calibrated) {
+		return;
+	}
+
+	// Create the debug frame if needed.
+	t.debug.refresh(xf);
+
+	int cols = xf->width / 2;
+	int rows = xf->height;
+	int stride = xf->stride;
+
+	if (fb != NULL) {
+		do_view_blobs(t, 0, *fb, 0, cols);
+		do_view_blobs(t, 1, *fb, cols, cols * 2);
 	} else {
-		t.filter->clear_position_tracked_flag();
+		// Only headers pointing into the frame, nothing is allocated.
+		ViewsData data = {&t, {}};
+		data.grey[0] = cv::Mat(rows, cols, CV_8UC1, xf->data, stride);
+		data.grey[1] = cv::Mat(rows, cols, CV_8UC1, xf->data + cols, stride);
+
+		// The views are independent, one is done on the pool and one on this thread.
+		if (t.group != NULL) {
+			u_worker_group_parallel_for(t.group, 2, 1, do_views, &data);
+		} else {
+			do_views(&data, 0, 2);
+		}
+
+		// A filtered frame only has the blobs of one colour.
+		t.targets[0].keypoints[0].assign(t.view[0].keypoints.begin(), t.view[0].keypoints.end());
+		t.targets[0].keypoints[1].assign(t.view[1].keypoints.begin(), t.view[1].keypoints.end());
 	}
 
 	// We are done with the debug frame.
@@ -334,27 +526,22 @@ process(TrackerPSMV &t, struct xrt_frame *xf)
 	// We are done with the frame.
 	xrt_frame_reference(&xf, NULL);
 
-	if (nearest_world.got_one) {
-#if 0
-		//! @todo something less arbitrary for the lever arm?
-		//! This puts the origin approximately under the PS
-		//! button.
-		xrt_vec3 lever_arm{0.f, 0.09f, 0.f};
-		//! @todo this should depend on distance
-		// Weirdly, this is where *not* applying the
-		// disparity-to-distance/rectification/etc would
-		// simplify things, since the measurement variance is
-		// related to the image sensor. 1.e-4 means 1cm std dev.
-		// Not sure how to estimate the depth variance without
-		// some research.
-		xrt_vec3 variance{1.e-4f, 1.e-4f, 4.e-4f};
-#endif
-		t.filter->process_3d_vision_data(0, &t.tracked_object_position, NULL, NULL,
-		                                 //! @todo tune cutoff for residual arbitrarily "too large"
-		                                 15);
-	} else {
-		t.filter->clear_position_tracked_flag();
+	for (uint32_t i = 0; i < t.target_count; i++) {
+		update_target(t, t.targets[i]);
+	}
+}
+
+/*!
+ * Is there a frame to process, frames with blobs wait for those of all targets.
+ */
+static bool
+has_frame_locked(TrackerPSMV &t)
+{
+	if (t.frame == NULL) {
+		return false;
 	}
+
+	return !t.frame_has_blobs || t.blobs_arrived == (1u << t.target_count) - 1;
 }
 
 /*!
@@ -366,13 +553,15 @@ run(TrackerPSMV &t)
 	U_TRACE_SET_THREAD_NAME("PSMV");
 
 	struct xrt_frame *frame = NULL;
+	FrameBlobs fb;
+	bool has_blobs = false;
 
 	os_thread_helper_lock(&t.oth);
 
 	while (os_thread_helper_is_running_locked(&t.oth)) {
 
 		// No data
-		if (!t.has_imu && t.frame == NULL) {
+		if (!t.has_imu && !has_frame_locked(t)) {
 			os_thread_helper_wait_locked(&t.oth);
 
 			/*
@@ -390,10 +579,21 @@ run(TrackerPSMV &t)
 		frame = t.frame;
 		t.frame = NULL;
 
+		// Blobs can be replaced with the frame, so copy them out.
+		has_blobs = t.frame_has_blobs;
+		if (has_blobs) {
+			for (uint32_t i = 0; i < t.target_count; i++) {
+				TargetPSMV &target = t.targets[i];
+				fb.blob_counts[i] = target.blob_count;
+				memcpy(fb.blobs[i], target.blobs, sizeof(t_hsv_blob) * target.blob_count);
+			}
+		}
+		t.blobs_arrived = 0;
+
 		// Unlock the mutex when we do the work.
 		os_thread_helper_unlock(&t.oth);
 
-		process(t, frame);
+		process(t, frame, has_blobs ? &fb : NULL);
 
 		// Have to lock it again.
 		os_thread_helper_lock(&t.oth);
@@ -406,8 +606,13 @@ run(TrackerPSMV &t)
  * @brief Retrieves a pose from the filter.
  */
 static void
-get_pose(TrackerPSMV &t, enum xrt_input_name name, timepoint_ns when_ns, struct xrt_space_relation *out_relation)
+get_pose(TargetPSMV &target,
+         enum xrt_input_name name,
+         timepoint_ns when_ns,
+         struct xrt_space_relation *out_relation)
 {
+	TrackerPSMV &t = *target.tracker;
+
 	os_thread_helper_lock(&t.oth);
 
 	// Don't do anything if we have stopped.
@@ -417,7 +622,7 @@ get_pose(TrackerPSMV &t, enum xrt_input_name name, timepoint_ns when_ns, struct
 	}
 
 	if (name == XRT_INPUT_PSMV_BALL_CENTER_POSE) {
-		out_relation->pose.position = t.tracked_object_position;
+		out_relation->pose.position = target.tracked_object_position;
 		out_relation->pose.orientation.x = 0.0f;
 		out_relation->pose.orientation.y = 0.0f;
 		out_relation->pose.orientation.z = 0.0f;
@@ -430,14 +635,16 @@ get_pose(TrackerPSMV &t, enum xrt_input_name name, timepoint_ns when_ns, struct
 		return;
 	}
 
-	t.filter->get_prediction(when_ns, out_relation);
+	target.filter->get_prediction(when_ns, out_relation);
 
 	os_thread_helper_unlock(&t.oth);
 }
 
 static void
-imu_data(TrackerPSMV &t, timepoint_ns timestamp_ns, struct xrt_tracking_sample *sample)
+imu_data(TargetPSMV &target, timepoint_ns timestamp_ns, struct xrt_tracking_sample *sample)
 {
+	TrackerPSMV &t = *target.tracker;
+
 	os_thread_helper_lock(&t.oth);
 
 	// Don't do anything if we have stopped.
@@ -445,7 +652,7 @@ imu_data(TrackerPSMV &t, timepoint_ns timestamp_ns, struct xrt_tracking_sample *
 		os_thread_helper_unlock(&t.oth);
 		return;
 	}
-	t.filter->process_imu_data(timestamp_ns, sample, NULL);
+	target.filter->process_imu_data(timestamp_ns, sample, NULL);
 
 	os_thread_helper_unlock(&t.oth);
 }
@@ -462,12 +669,48 @@ frame(TrackerPSMV &t, struct xrt_frame *xf)
 	}
 
 	xrt_frame_reference(&t.frame, xf);
+	t.frame_has_blobs = false;
 	// Wake up the thread.
 	os_thread_helper_signal_locked(&t.oth);
 
 	os_thread_helper_unlock(&t.oth);
 }
 
+static void
+frame_blobs(TargetPSMV &target, struct xrt_frame *xf, const t_hsv_blob *blobs, uint32_t blob_count)
+{
+	TrackerPSMV &t = *target.tracker;
+
+	os_thread_helper_lock(&t.oth);
+
+	// Don't do anything if we have stopped.
+	if (!os_thread_helper_is_running_locked(&t.oth)) {
+		os_thread_helper_unlock(&t.oth);
+		return;
+	}
+
+	// The first target to get blobs for a new frame drops the old frame and any blobs that went with it.
+	if (t.frame != xf || !t.frame_has_blobs) {
+		xrt_frame_reference(&t.frame, xf);
+		t.blobs_arrived = 0;
+		for (uint32_t i = 0; i < t.target_count; i++) {
+			t.targets[i].blob_count = 0;
+		}
+	}
+
+	target.blob_count = std::min(blob_count, (uint32_t)T_HSV_MAX_BLOBS);
+	memcpy(target.blobs, blobs, sizeof(t_hsv_blob) * target.blob_count);
+	t.frame_has_blobs = true;
+	t.blobs_arrived |= 1u << target.index;
+
+	// Wake up the thread once the frame has the blobs of all targets.
+	if (has_frame_locked(t)) {
+		os_thread_helper_signal_locked(&t.oth);
+	}
+
+	os_thread_helper_unlock(&t.oth);
+}
+
 static void
 break_apart(TrackerPSMV &t)
 {
@@ -476,6 +719,7 @@ break_apart(TrackerPSMV &t)
 
 } // namespace xrt::auxiliary::tracking::psmv
 
+using xrt::auxiliary::tracking::psmv::TargetPSMV;
 using xrt::auxiliary::tracking::psmv::TrackerPSMV;
 
 /*
@@ -487,8 +731,8 @@ using xrt::auxiliary::tracking::psmv::TrackerPSMV;
 extern "C" void
 t_psmv_push_imu(struct xrt_tracked_psmv *xtmv, timepoint_ns timestamp_ns, struct xrt_tracking_sample *sample)
 {
-	auto &t = *container_of(xtmv, TrackerPSMV, base);
-	imu_data(t, timestamp_ns, sample);
+	auto &target = *container_of(xtmv, TargetPSMV, base);
+	imu_data(target, timestamp_ns, sample);
 }
 
 extern "C" void
@@ -497,15 +741,15 @@ t_psmv_get_tracked_pose(struct xrt_tracked_psmv *xtmv,
                         timepoint_ns when_ns,
                         struct xrt_space_relation *out_relation)
 {
-	auto &t = *container_of(xtmv, TrackerPSMV, base);
-	get_pose(t, name, when_ns, out_relation);
+	auto &target = *container_of(xtmv, TargetPSMV, base);
+	get_pose(target, name, when_ns, out_relation);
 }
 
 extern "C" void
 t_psmv_fake_destroy(struct xrt_tracked_psmv *xtmv)
 {
-	auto &t = *container_of(xtmv, TrackerPSMV, base);
-	(void)t;
+	auto &target = *container_of(xtmv, TargetPSMV, base);
+	(void)target;
 	// Not the real destroy function
 }
 
@@ -516,6 +760,16 @@ t_psmv_sink_push_frame(struct xrt_frame_sink *xsink, struct xrt_frame *xf)
 	frame(t, xf);
 }
 
+extern "C" void
+t_psmv_blob_sink_push_blobs(struct t_hsv_blob_sink *sink,
+                            struct xrt_frame *xf,
+                            const struct t_hsv_blob *blobs,
+                            uint32_t blob_count)
+{
+	auto &target = *container_of(sink, TargetPSMV, blob_sink);
+	frame_blobs(target, xf, blobs, blob_count);
+}
+
 extern "C" void
 t_psmv_node_break_apart(struct xrt_frame_node *node)
 {
@@ -529,6 +783,9 @@ t_psmv_node_destroy(struct xrt_frame_node *node)
 	auto *t_ptr = container_of(node, TrackerPSMV, node);
 	os_thread_helper_destroy(&t_ptr->oth);
 
+	u_worker_group_reference(&t_ptr->group, NULL);
+	u_worker_thread_pool_reference(&t_ptr->pool, NULL);
+
 	// Tidy variable setup.
 	u_var_remove_root(t_ptr);
 
@@ -553,28 +810,34 @@ t_psmv_run(void *ptr)
 extern "C" int
 t_psmv_start(struct xrt_tracked_psmv *xtmv)
 {
-	auto &t = *container_of(xtmv, TrackerPSMV, base);
+	auto &t = *container_of(xtmv, TargetPSMV, base)->tracker;
+
+	// All targets share the thread, started by the first one.
+	if (os_thread_helper_is_running(&t.oth)) {
+		return 0;
+	}
+
 	return os_thread_helper_start(&t.oth, t_psmv_run, &t);
 }
 
-extern "C" int
-t_psmv_create(struct xrt_frame_context *xfctx,
-              struct xrt_colour_rgb_f32 *rgb,
-              struct t_stereo_camera_calibration *data,
-              struct xrt_tracked_psmv **out_xtmv,
-              struct xrt_frame_sink **out_sink)
+extern "C" struct t_hsv_blob_sink *
+t_psmv_get_blob_sink(struct xrt_tracked_psmv *xtmv)
 {
-	XRT_TRACE_MARKER();
+	auto &target = *container_of(xtmv, TargetPSMV, base);
+	return &target.blob_sink;
+}
 
-	U_LOG_D("Creating PSMV tracker.");
+static TrackerPSMV *
+create(struct xrt_frame_context *xfctx,
+       const struct xrt_colour_rgb_f32 *rgbs,
+       uint32_t target_count,
+       struct t_stereo_camera_calibration *data)
+{
+	U_LOG_D("Creating PSMV tracker with %u target(s).", target_count);
 
 	auto &t = *(new TrackerPSMV());
 	int ret;
 
-	t.base.get_tracked_pose = t_psmv_get_tracked_pose;
-	t.base.push_imu = t_psmv_push_imu;
-	t.base.destroy = t_psmv_fake_destroy;
-	t.base.colour = *rgb;
 	t.sink.push_frame = t_psmv_sink_push_frame;
 	t.node.break_apart = t_psmv_node_break_apart;
 	t.node.destroy = t_psmv_node_destroy;
@@ -582,12 +845,24 @@ t_psmv_create(struct xrt_frame_context *xfctx,
 	t.fusion.rot.y = 0.0f;
 	t.fusion.rot.z = 0.0f;
 	t.fusion.rot.w = 1.0f;
-	t.filter = PSMVFusionInterface::create();
+
+	t.target_count = target_count;
+	for (uint32_t i = 0; i < target_count; i++) {
+		TargetPSMV &target = t.targets[i];
+		target.base.get_tracked_pose = t_psmv_get_tracked_pose;
+		target.base.push_imu = t_psmv_push_imu;
+		target.base.destroy = t_psmv_fake_destroy;
+		target.base.colour = rgbs[i];
+		target.blob_sink.push_blobs = t_psmv_blob_sink_push_blobs;
+		target.tracker = &t;
+		target.index = i;
+		target.filter = PSMVFusionInterface::create();
+	}
 
 	ret = os_thread_helper_init(&t.oth);
 	if (ret != 0) {
 		delete (&t);
-		return ret;
+		return NULL;
 	}
 
 	static int hack = 0;
@@ -610,13 +885,14 @@ t_psmv_create(struct xrt_frame_context *xfctx,
 	}
 
 	StereoRectificationMaps rectify(data);
-	t.view[0].populate_from_calib(data->view[0], rectify.view[0].rectify);
-	t.view[1].populate_from_calib(data->view[1], rectify.view[1].rectify);
+	t.view[0].populate_from_calib(data->view[0], rectify.view[0]);
+	t.view[1].populate_from_calib(data->view[1], rectify.view[1]);
 	t.disparity_to_depth = rectify.disparity_to_depth_mat;
 	StereoCameraCalibrationWrapper wrapped(data);
 	t.r_cam_rotation = wrapped.camera_rotation_mat;
 	t.r_cam_translation = wrapped.camera_translation_mat;
 	t.calibrated = true;
+	t.undistort_keypoints = debug_get_bool_option_psmv_undistort_keypoints();
 
 	// clang-format off
 	cv::SimpleBlobDetector::Params blob_params;
@@ -635,16 +911,72 @@ t_psmv_create(struct xrt_frame_context *xfctx,
 	blob_params.minRepeatability = 1; // need this to avoid error?
 	// clang-format on
 
-	t.sbd = cv::SimpleBlobDetector::create(blob_params);
+	t.view[0].sbd = cv::SimpleBlobDetector::create(blob_params);
+	t.view[1].sbd = cv::SimpleBlobDetector::create(blob_params);
+
+	t.pool = u_worker_thread_pool_create(1, 1, "PSMV", OS_THREAD_CORE_CLASS_ANY);
+	if (t.pool != NULL) {
+		t.group = u_worker_group_create(t.pool);
+	}
 	xrt_frame_context_add(xfctx, &t.node);
 
 	// Everything is safe, now setup the variable tracking.
 	u_var_add_root(&t, "PSMV Tracker", true);
-	u_var_add_vec3_f32(&t, &t.tracked_object_position, "last.ball.pos");
+	for (uint32_t i = 0; i < target_count; i++) {
+		char name[32];
+		snprintf(name, sizeof(name), "target%u.last.ball.pos", i);
+		u_var_add_vec3_f32(&t, &t.targets[i].tracked_object_position, name);
+	}
 	u_var_add_sink_debug(&t, &t.debug.usd, "Debug");
 
-	*out_sink = &t.sink;
-	*out_xtmv = &t.base;
+	return &t;
+}
+
+extern "C" int
+t_psmv_create(struct xrt_frame_context *xfctx,
+              struct xrt_colour_rgb_f32 *rgb,
+              struct t_stereo_camera_calibration *data,
+              struct xrt_tracked_psmv **out_xtmv,
+              struct xrt_frame_sink **out_sink)
+{
+	XRT_TRACE_MARKER();
+
+	TrackerPSMV *t = create(xfctx, rgb, 1, data);
+	if (t == NULL) {
+		return -1;
+	}
+
+	*out_sink = &t->sink;
+	*out_xtmv = &t->targets[0].base;
+
+	return 0;
+}
+
+extern "C" int
+t_psmv_create_multi(struct xrt_frame_context *xfctx,
+                    const struct xrt_colour_rgb_f32 *rgbs,
+                    uint32_t count,
+                    struct t_stereo_camera_calibration *data,
+                    struct xrt_tracked_psmv **out_xtmvs,
+                    struct t_hsv_blob_sink **out_blob_sinks)
+{
+	XRT_TRACE_MARKER();
+
+	if (count == 0 || count > T_PSMV_MAX_TARGETS) {
+		U_LOG_E("Can't track %u PS Move controllers with one tracker, at most %u.", count,
+		        (uint32_t)T_PSMV_MAX_TARGETS);
+		return -1;
+	}
+
+	TrackerPSMV *t = create(xfctx, rgbs, count, data);
+	if (t == NULL) {
+		return -1;
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		out_xtmvs[i] = &t->targets[i].base;
+		out_blob_sinks[i] = &t->targets[i].blob_sink;
+	}
 
 	return 0;
 }
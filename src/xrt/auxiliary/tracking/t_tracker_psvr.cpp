@@ -40,6 +40,12 @@
 
 DEBUG_GET_ONCE_LOG_OPTION(psvr_log, "PSVR_TRACKING_LOG", U_LOGGING_WARN)
 
+/*!
+ * Find blobs on the distorted frame and only undistort their keypoints,
+ * instead of undistorting and rectifying the whole frame.
+ */
+DEBUG_GET_ONCE_BOOL_OPTION(psvr_undistort_keypoints, "PSVR_UNDISTORT_KEYPOINTS", false)
+
 #define PSVR_TRACE(...) U_LOG_IFL_T(t.log_level, __VA_ARGS__)
 #define PSVR_DEBUG(...) U_LOG_IFL_D(t.log_level, __VA_ARGS__)
 #define PSVR_INFO(...) U_LOG_IFL_I(t.log_level, __VA_ARGS__)
@@ -139,20 +145,34 @@ struct View
 	cv::Mat distortion; // size may vary
 	enum t_camera_distortion_model distortion_model;
 
+	//! Rectification and projection, to undistort keypoints without remapping the frame.
+	cv::Mat rectify_rotation;
+	cv::Mat rectify_projection;
+
 	std::vector<cv::KeyPoint> keypoints;
 
 	cv::Mat frame_undist_rectified;
 
 	void
-	populate_from_calib(t_camera_calibration &calib, const RemapPair &rectification)
+	populate_from_calib(t_camera_calibration &calib, const ViewRectification &rectification)
 	{
 		CameraCalibrationWrapper wrap(calib);
 		intrinsics = wrap.intrinsics_mat;
 		distortion = wrap.distortion_mat.clone();
 		distortion_model = wrap.distortion_model;
 
-		undistort_rectify_map_x = rectification.remap_x;
-		undistort_rectify_map_y = rectification.remap_y;
+		undistort_rectify_map_x = rectification.rectify.remap_x;
+		undistort_rectify_map_y = rectification.rectify.remap_y;
+		rectify_rotation = rectification.rotation_mat;
+		rectify_projection = rectification.projection_mat;
+	}
+
+	//! Moves @ref keypoints found on the distorted frame to where they are on the rectified one.
+	void
+	undistort_rectify_keypoints()
+	{
+		calibration_undistort_keypoints(intrinsics, distortion, distortion_model, rectify_rotation,
+		                                rectify_projection, keypoints);
 	}
 };
 
@@ -265,6 +285,9 @@ public:
 	View view[2];
 	bool calibrated;
 
+	//! Only undistort keypoints instead of whole frames, see PSVR_UNDISTORT_KEYPOINTS.
+	bool undistort_keypoints;
+
 	HelperDebugSink debug = {HelperDebugSink::AllAvailable};
 
 	cv::Mat disparity_to_depth;
@@ -1227,20 +1250,23 @@ create_match_list(TrackerPSVR &t)
 static void
 do_view(TrackerPSVR &t, View &view, cv::Mat &grey, cv::Mat &rgb)
 {
-	// Undistort and rectify the whole image.
-	cv::remap(grey,                         // src
-	          view.frame_undist_rectified,  // dst
-	          view.undistort_rectify_map_x, // map1
-	          view.undistort_rectify_map_y, // map2
-	          cv::INTER_NEAREST,            // interpolation - LINEAR seems
-	                                        // very slow on my setup
-	          cv::BORDER_CONSTANT,          // borderMode
-	          cv::Scalar(0, 0, 0));         // borderValue
-
-	cv::threshold(view.frame_undist_rectified, // src
-	              view.frame_undist_rectified, // dst
-	              32.0,                        // thresh
-	              255.0,                       // maxval
+	if (!t.undistort_keypoints) {
+		// Undistort and rectify the whole image.
+		cv::remap(grey,                         // src
+		          view.frame_undist_rectified,  // dst
+		          view.undistort_rectify_map_x, // map1
+		          view.undistort_rectify_map_y, // map2
+		          cv::INTER_NEAREST,            // interpolation - LINEAR seems
+		                                        // very slow on my setup
+		          cv::BORDER_CONSTANT,          // borderMode
+		          cv::Scalar(0, 0, 0));         // borderValue
+	}
+
+	// Without the remap, threshold the distorted image directly.
+	cv::threshold(t.undistort_keypoints ? grey : view.frame_undist_rectified, // src
+	              view.frame_undist_rectified,                                 // dst
+	              32.0,                                                        // thresh
+	              255.0,                                                       // maxval
 	              0);
 	t.sbd->detect(view.frame_undist_rectified, // image
 	              view.keypoints,              // keypoints
@@ -1254,6 +1280,11 @@ do_view(TrackerPSVR &t, View &view, cv::Mat &grey, cv::Mat &rgb)
 		                  cv::Scalar(255, 0, 0),                      // color
 		                  cv::DrawMatchesFlags::DRAW_RICH_KEYPOINTS); // flags
 	}
+
+	// After drawing, so the debug image shows them where they were found.
+	if (t.undistort_keypoints) {
+		view.undistort_rectify_keypoints();
+	}
 }
 
 typedef struct blob_data
@@ -2062,13 +2093,14 @@ t_psvr_create(struct xrt_frame_context *xfctx,
 	init_filter(t.pose_filter, PSVR_POSE_PROCESS_NOISE, PSVR_POSE_MEASUREMENT_NOISE, 1.0f);
 
 	StereoRectificationMaps rectify(data);
-	t.view[0].populate_from_calib(data->view[0], rectify.view[0].rectify);
-	t.view[1].populate_from_calib(data->view[1], rectify.view[1].rectify);
+	t.view[0].populate_from_calib(data->view[0], rectify.view[0]);
+	t.view[1].populate_from_calib(data->view[1], rectify.view[1]);
 	t.disparity_to_depth = rectify.disparity_to_depth_mat;
 	StereoCameraCalibrationWrapper wrapped(data);
 	t.r_cam_rotation = wrapped.camera_rotation_mat;
 	t.r_cam_translation = wrapped.camera_translation_mat;
 	t.calibrated = true;
+	t.undistort_keypoints = debug_get_bool_option_psvr_undistort_keypoints();
 
 
 
@@ -12,6 +12,7 @@
 #include "xrt/xrt_tracking.h"
 #include "xrt/xrt_frameserver.h"
 #include "util/u_debug.h"
+#include "util/u_imu_ring.h"
 #include "util/u_logging.h"
 #include "util/u_misc.h"
 #include "util/u_sink.h"
@@ -33,6 +34,7 @@
 #include <opencv2/core/mat.hpp>
 #include <opencv2/core/version.hpp>
 
+#include <algorithm>
 #include <deque>
 #include <filesystem>
 #include <fstream>
@@ -78,6 +80,7 @@ DEBUG_GET_ONCE_OPTION(slam_csv_path, "SLAM_CSV_PATH", "evaluation/")
 DEBUG_GET_ONCE_BOOL_OPTION(slam_timing_stat, "SLAM_TIMING_STAT", true)
 DEBUG_GET_ONCE_BOOL_OPTION(slam_features_stat, "SLAM_FEATURES_STAT", true)
 DEBUG_GET_ONCE_NUM_OPTION(slam_cam_count, "SLAM_CAM_COUNT", 2)
+DEBUG_GET_ONCE_OPTION(slam_core_class, "SLAM_CORE_CLASS", nullptr)
 
 //! Namespace for the interface to the external SLAM tracking system
 namespace xrt::auxiliary::tracking::slam {
@@ -376,7 +379,8 @@ struct TrackerSlam
 	RelationHistory slam_rels{};    //!< A history of relations produced purely from external SLAM tracker data
 	int dbg_pred_every = 1;         //!< Skip X SLAM poses so that you get tracked mostly by the prediction algo
 	int dbg_pred_counter = 0;       //!< SLAM pose counter for prediction debugging
-	struct os_mutex lock_ff;        //!< Lock for gyro_ff and accel_ff.
+	struct u_imu_ring imu_ring;     //!< IMU samples from the sink, drained into gyro_ff and accel_ff
+	struct os_mutex lock_ff;        //!< Lock for gyro_ff and accel_ff, the IMU sink never takes it
 	struct m_ff_vec3_f32 *gyro_ff;  //!< Last gyroscope samples
 	struct m_ff_vec3_f32 *accel_ff; //!< Last accelerometer samples
 	vector<u_sink_debug> ui_sink;   //!< Sink to display frames in UI of each camera
@@ -385,8 +389,18 @@ struct TrackerSlam
 	//! @todo Should be automatically computed instead of required to be filled manually through the UI.
 	xrt_vec3 gravity_correction{0, 0, -MATH_GRAVITY_M_S2};
 
+	//! IMU integration on top of the latest SLAM pose, extended as samples arrive. Protected by @ref lock_ff.
+	struct
+	{
+		bool valid = false;
+		timepoint_ns base_ts = 0;                              //!< Timestamp of the SLAM pose integrated upon
+		xrt_space_relation integ_rel = XRT_SPACE_RELATION_ZERO; //!< SLAM pose with all cached samples applied
+		timepoint_ns integ_ts = 0;                             //!< Timestamp of the last integrated sample
+	} imu_preinteg;
+
 	struct xrt_space_relation last_rel = XRT_SPACE_RELATION_ZERO; //!< Last reported/tracked pose
 	timepoint_ns last_ts;                                         //!< Last reported/tracked pose timestamp
+	uint32_t pose_count = 0;                                      //!< Poses dequeued from the SLAM system
 
 	//! Filters are used to smooth out the resulting trajectory
 	struct
@@ -439,6 +453,9 @@ struct TrackerSlam
 		vector<string> columns;             //!< Column names of the measured timestamps
 		string joined_columns;              //!< Column names as a null separated string
 		struct u_var_button enable_btn;     //!< Toggle tracker timing reports
+		double latency_sum_ms = 0;          //!< Sum of tracker latencies for @ref t_slam_metrics
+		double latency_max_ms = 0;          //!< Maximum tracker latency seen
+		uint32_t latency_count = 0;         //!< Number of latencies summed in @ref latency_sum_ms
 	} timing;
 
 	//! Tracker feature tracking info
@@ -475,6 +492,8 @@ struct TrackerSlam
 	struct
 	{
 		Trajectory *trajectory;               //!< Empty if we've not received groundtruth
+		Trajectory *estimates;                //!< Tracked poses, only kept if there is groundtruth
+		struct os_mutex lock;                 //!< Lock for @ref trajectory and @ref estimates
 		xrt_pose origin;                      //!< First ground truth pose
 		float diffs_mm[UI_GTDIFF_POSE_COUNT]; //!< Positional error wrt ground truth
 		int diff_idx = 0;                     //!< Index of last error in @ref diffs_mm
@@ -570,6 +589,14 @@ timing_ui_push(TrackerSlam &t, const pose &p)
 	constexpr float a = 1.0f / UI_TIMING_POSE_COUNT; // Exponential moving average
 	t.timing.ui.reference_timing = (1 - a) * t.timing.ui.reference_timing + a * tss_ms;
 
+	// Tracker latency, from it receiving the frame to us receiving the pose
+	if (ext) {
+		double latency_ms = double(tss.back() - tss.at(1)) / U_TIME_1MS_IN_NS;
+		t.timing.latency_sum_ms += latency_ms;
+		t.timing.latency_max_ms = std::max(t.timing.latency_max_ms, latency_ms);
+		t.timing.latency_count++;
+	}
+
 	return tss;
 }
 
@@ -780,6 +807,60 @@ gt_ui_push(TrackerSlam &t, timepoint_ns ts, xrt_pose tracked_pose)
 	t.gt.diff_ui.reference_timing = (1 - a) * t.gt.diff_ui.reference_timing + a * len_mm;
 }
 
+//! Keep tracked poses around to compute whole run metrics, only if there is groundtruth to compare against
+static void
+gt_record_estimate(TrackerSlam &t, timepoint_ns ts, xrt_pose tracked_pose)
+{
+	os_mutex_lock(&t.gt.lock);
+	if (!t.gt.trajectory->empty()) {
+		t.gt.estimates->insert_or_assign(ts, tracked_pose);
+	}
+	os_mutex_unlock(&t.gt.lock);
+}
+
+/*!
+ * Computes absolute and relative trajectory errors of the recorded estimates.
+ *
+ * Trajectories are aligned the same way as @ref xr2gt_pose does, so only
+ * positions are compared. RPE compares the translation between pairs of
+ * estimates @p delta_ns apart with the groundtruth translation over the same
+ * timestamps.
+ */
+static void
+gt_compute_errors(TrackerSlam &t, timepoint_ns delta_ns, t_slam_metrics &m)
+{
+	const Trajectory &gt = *t.gt.trajectory;
+	const Trajectory &est = *t.gt.estimates;
+
+	m.gt_count = gt.size();
+	if (gt.empty() || est.empty()) {
+		return;
+	}
+
+	double ate_sq_sum = 0;
+	for (const auto &[ts, pose] : est) {
+		xrt_vec3 diff = xr2gt_pose(t.gt.origin, pose).position - get_gt_pose_at(gt, ts).position;
+		ate_sq_sum += m_vec3_len_sqrd(diff);
+	}
+	m.ate_rmse_m = sqrt(ate_sq_sum / est.size());
+
+	double rpe_sq_sum = 0;
+	uint32_t rpe_count = 0;
+	for (const auto &[ts_a, pose_a] : est) {
+		Trajectory::const_iterator it = est.lower_bound(ts_a + delta_ns);
+		if (it == est.end()) {
+			break;
+		}
+		const auto &[ts_b, pose_b] = *it;
+
+		xrt_vec3 est_delta = xr2gt_pose(t.gt.origin, pose_b).position - xr2gt_pose(t.gt.origin, pose_a).position;
+		xrt_vec3 gt_delta = get_gt_pose_at(gt, ts_b).position - get_gt_pose_at(gt, ts_a).position;
+		rpe_sq_sum += m_vec3_len_sqrd(est_delta - gt_delta);
+		rpe_count++;
+	}
+	m.rpe_rmse_m = rpe_count > 0 ? sqrt(rpe_sq_sum / rpe_count) : 0;
+}
+
 /*
  *
  * Tracker functionality
@@ -827,6 +908,8 @@ flush_poses(TrackerSlam &t)
 		t.dbg_pred_counter = (t.dbg_pred_counter + 1) % t.dbg_pred_every;
 
 		gt_ui_push(t, nts, rel.pose);
+		gt_record_estimate(t, nts, rel.pose);
+		t.pose_count++;
 		t.slam_traj_writer->push(nts, rel.pose);
 		xrt_pose_sample pose_sample = {nts, rel.pose};
 		xrt_sink_push_pose(t.euroc_recorder->gt, &pose_sample);
@@ -850,7 +933,64 @@ flush_poses(TrackerSlam &t)
 	return got_one;
 }
 
-//! Integrates IMU samples on top of a base pose and predicts from that
+//! Moves the IMU samples received since last time into the filter fifos, call with @ref lock_ff held.
+static void
+drain_imu_ring(TrackerSlam &t)
+{
+	xrt_imu_sample samples[64];
+	uint32_t count = 0;
+	do {
+		count = u_imu_ring_drain(&t.imu_ring, samples, ARRAY_SIZE(samples));
+		for (uint32_t i = 0; i < count; i++) {
+			const xrt_imu_sample &s = samples[i];
+			xrt_vec3 gyro = {(float)s.gyro_rad_secs.x, (float)s.gyro_rad_secs.y, (float)s.gyro_rad_secs.z};
+			xrt_vec3 accel = {(float)s.accel_m_s2.x, (float)s.accel_m_s2.y, (float)s.accel_m_s2.z};
+			m_ff_vec3_f32_push(t.gyro_ff, &gyro, s.timestamp_ns);
+			m_ff_vec3_f32_push(t.accel_ff, &accel, s.timestamp_ns);
+		}
+	} while (count == ARRAY_SIZE(samples));
+}
+
+//! Integrates one IMU sample held from @p rel_ts until @p ts into @p rel
+static void
+integrate_imu_sample(const TrackerSlam &t,
+                     xrt_space_relation &rel,
+                     timepoint_ns &rel_ts,
+                     xrt_vec3 g,
+                     xrt_vec3 a,
+                     timepoint_ns ts)
+{
+	xrt_quat &o = rel.pose.orientation;
+	xrt_vec3 &p = rel.pose.position;
+	xrt_vec3 &w = rel.angular_velocity;
+	xrt_vec3 &v = rel.linear_velocity;
+
+	// Update time
+	float dt = (float)time_ns_to_s(ts - rel_ts);
+	rel_ts = ts;
+
+	// Integrate gyroscope
+	xrt_quat angvel_delta{};
+	xrt_vec3 scaled_half_g = g * dt * 0.5f;
+	math_quat_exp(&scaled_half_g, &angvel_delta); // Same as using math_quat_from_angle_vector(g/dt)
+	math_quat_rotate(&o, &angvel_delta, &o);      // Orientation
+	math_quat_rotate_derivative(&o, &g, &w);      // Angular velocity
+
+	// Integrate accelerometer
+	xrt_vec3 world_accel{};
+	math_quat_rotate_vec3(&o, &a, &world_accel);
+	world_accel += t.gravity_correction;
+	v += world_accel * dt;                        // Linear velocity
+	p += v * dt + world_accel * (dt * dt * 0.5f); // Position
+}
+
+/*!
+ * Integrates IMU samples on top of a base pose and predicts from that.
+ *
+ * The integration is cached per base pose, each call only integrates the
+ * samples that arrived since the previous one. Asking for a time older than
+ * what is already integrated starts over from the base pose.
+ */
 static void
 predict_pose_from_imu(TrackerSlam &t,
                       timepoint_ns when_ns,
@@ -860,32 +1000,30 @@ predict_pose_from_imu(TrackerSlam &t,
 {
 	os_mutex_lock(&t.lock_ff);
 
-	// Find oldest imu index i that is newer than latest SLAM pose (or -1)
-	int i = 0;
-	uint64_t imu_ts = UINT64_MAX;
+	auto &c = t.imu_preinteg;
+	if (!c.valid || c.base_ts != base_rel_ts || when_ns < c.integ_ts) {
+		c.valid = true;
+		c.base_ts = base_rel_ts;
+		c.integ_rel = base_rel;
+		c.integ_ts = base_rel_ts;
+	}
+
+	// Count samples newer than what is integrated, index 0 is the newest sample
+	int n = 0;
+	uint64_t imu_ts = 0;
 	xrt_vec3 _;
-	while (m_ff_vec3_f32_get(t.gyro_ff, i, &_, &imu_ts)) {
-		if ((int64_t)imu_ts < base_rel_ts) {
-			i--; // Back to the oldest newer-than-SLAM IMU index (or -1)
-			break;
-		}
-		i++;
+	while (m_ff_vec3_f32_get(t.gyro_ff, n, &_, &imu_ts) && (int64_t)imu_ts > c.integ_ts) {
+		n++;
 	}
 
-	if (i == -1) {
+	bool got_newest = m_ff_vec3_f32_get(t.gyro_ff, 0, &_, &imu_ts);
+	if (!got_newest || (int64_t)imu_ts < base_rel_ts) {
 		SLAM_WARN("No IMU samples received after latest SLAM pose (and frame)");
 	}
 
-	xrt_space_relation integ_rel = base_rel;
-	timepoint_ns integ_rel_ts = base_rel_ts;
-	xrt_quat &o = integ_rel.pose.orientation;
-	xrt_vec3 &p = integ_rel.pose.position;
-	xrt_vec3 &w = integ_rel.angular_velocity;
-	xrt_vec3 &v = integ_rel.linear_velocity;
-	bool clamped = false; // If when_ns is older than the latest IMU ts
-
-	while (i >= 0) { // Decreasing i increases timestamp
-		// Get samples
+	// Append new samples up to when_ns to the cache, decreasing i increases timestamp
+	int i = n - 1;
+	for (; i >= 0; i--) {
 		xrt_vec3 g{};
 		xrt_vec3 a{};
 		uint64_t g_ts{};
@@ -893,42 +1031,28 @@ predict_pose_from_imu(TrackerSlam &t,
 		bool got = true;
 		got &= m_ff_vec3_f32_get(t.gyro_ff, i, &g, &g_ts);
 		got &= m_ff_vec3_f32_get(t.accel_ff, i, &a, &a_ts);
-		timepoint_ns ts = g_ts;
-
-
-		// Checks
-		if (ts > when_ns) {
-			clamped = true;
-			//! @todo Instead of using same a and g values, do an interpolated sample like this:
-			// a = prev_a + ((when_ns - prev_ts) / (ts - prev_ts)) * (a - prev_a);
-			// g = prev_g + ((when_ns - prev_ts) / (ts - prev_ts)) * (g - prev_g);
-			ts = when_ns; // clamp ts to when_ns
-		}
 		SLAM_DASSERT(got && g_ts == a_ts, "Failure getting synced gyro and accel samples");
-		SLAM_DASSERT(ts >= base_rel_ts, "Accessing imu sample that is older than latest SLAM pose");
-
-		// Update time
-		float dt = (float)time_ns_to_s(ts - integ_rel_ts);
-		integ_rel_ts = ts;
-
-		// Integrate gyroscope
-		xrt_quat angvel_delta{};
-		xrt_vec3 scaled_half_g = g * dt * 0.5f;
-		math_quat_exp(&scaled_half_g, &angvel_delta); // Same as using math_quat_from_angle_vector(g/dt)
-		math_quat_rotate(&o, &angvel_delta, &o);      // Orientation
-		math_quat_rotate_derivative(&o, &g, &w);      // Angular velocity
-
-		// Integrate accelerometer
-		xrt_vec3 world_accel{};
-		math_quat_rotate_vec3(&o, &a, &world_accel);
-		world_accel += t.gravity_correction;
-		v += world_accel * dt;                        // Linear velocity
-		p += v * dt + world_accel * (dt * dt * 0.5f); // Position
 
-		if (clamped) {
+		if ((timepoint_ns)g_ts > when_ns) {
 			break;
 		}
-		i--;
+		integrate_imu_sample(t, c.integ_rel, c.integ_ts, g, a, g_ts);
+	}
+
+	xrt_space_relation integ_rel = c.integ_rel;
+	timepoint_ns integ_rel_ts = c.integ_ts;
+
+	// If when_ns is older than the latest IMU ts, hold the next sample until when_ns without caching it
+	if (i >= 0) {
+		//! @todo Instead of using same a and g values, do an interpolated sample like this:
+		// a = prev_a + ((when_ns - prev_ts) / (ts - prev_ts)) * (a - prev_a);
+		// g = prev_g + ((when_ns - prev_ts) / (ts - prev_ts)) * (g - prev_g);
+		xrt_vec3 g{};
+		xrt_vec3 a{};
+		uint64_t ts{};
+		m_ff_vec3_f32_get(t.gyro_ff, i, &g, &ts);
+		m_ff_vec3_f32_get(t.accel_ff, i, &a, &ts);
+		integrate_imu_sample(t, integ_rel, integ_rel_ts, g, a, when_ns);
 	}
 
 	os_mutex_unlock(&t.lock_ff);
@@ -950,6 +1074,11 @@ predict_pose(TrackerSlam &t, timepoint_ns when_ns, struct xrt_space_relation *ou
 	bool valid_pred_type = t.pred_type >= SLAM_PRED_NONE && t.pred_type < SLAM_PRED_COUNT;
 	SLAM_DASSERT(valid_pred_type, "Invalid prediction type (%d)", t.pred_type);
 
+	// Bring the fifos up to date, also keeps their UI graphs alive without IMU prediction
+	os_mutex_lock(&t.lock_ff);
+	drain_imu_ring(t);
+	os_mutex_unlock(&t.lock_ff);
+
 	// Get last relation computed purely from SLAM data
 	xrt_space_relation rel{};
 	uint64_t rel_ts;
@@ -1076,6 +1205,7 @@ setup_ui(TrackerSlam &t)
 		u_sink_debug_init(&t.ui_sink[i]);
 	}
 	os_mutex_init(&t.lock_ff);
+	u_imu_ring_init(&t.imu_ring, 1024);
 	m_ff_vec3_f32_alloc(&t.gyro_ff, 1000);
 	m_ff_vec3_f32_alloc(&t.accel_ff, 1000);
 	m_ff_vec3_f32_alloc(&t.filter.pos_ff, 1000);
@@ -1283,12 +1413,17 @@ t_slam_gt_sink_push(struct xrt_pose_sink *sink, xrt_pose_sample *sample)
 
 	auto &t = *container_of(sink, TrackerSlam, gt_sink);
 
-	if (t.gt.trajectory->empty()) {
+	os_mutex_lock(&t.gt.lock);
+	bool first = t.gt.trajectory->empty();
+	if (first) {
 		t.gt.origin = sample->pose;
-		gt_ui_setup(t);
 	}
-
 	t.gt.trajectory->insert_or_assign(sample->timestamp_ns, sample->pose);
+	os_mutex_unlock(&t.gt.lock);
+
+	if (first) {
+		gt_ui_setup(t);
+	}
 	xrt_sink_push_pose(t.euroc_recorder->gt, sample);
 }
 
@@ -1318,12 +1453,8 @@ t_slam_receive_imu(struct xrt_imu_sink *sink, struct xrt_imu_sample *s)
 
 	xrt_sink_push_imu(t.euroc_recorder->imu, s);
 
-	struct xrt_vec3 gyro = {(float)w.x, (float)w.y, (float)w.z};
-	struct xrt_vec3 accel = {(float)a.x, (float)a.y, (float)a.z};
-	os_mutex_lock(&t.lock_ff);
-	m_ff_vec3_f32_push(t.gyro_ff, &gyro, ts);
-	m_ff_vec3_f32_push(t.accel_ff, &accel, ts);
-	os_mutex_unlock(&t.lock_ff);
+	// Lock-free, the prediction side drains these into the fifos when it needs them
+	u_imu_ring_push(&t.imu_ring, s);
 }
 
 //! Push the frame to the external SLAM system
@@ -1401,6 +1532,8 @@ t_slam_node_destroy(struct xrt_frame_node *node)
 	}
 	os_thread_helper_destroy(&t_ptr->oth);
 	delete t.gt.trajectory;
+	delete t.gt.estimates;
+	os_mutex_destroy(&t.gt.lock);
 	delete t.slam_times_writer;
 	delete t.slam_features_writer;
 	delete t.slam_traj_writer;
@@ -1413,6 +1546,7 @@ t_slam_node_destroy(struct xrt_frame_node *node)
 	m_ff_vec3_f32_free(&t.gyro_ff);
 	m_ff_vec3_f32_free(&t.accel_ff);
 	os_mutex_destroy(&t.lock_ff);
+	u_imu_ring_fini(&t.imu_ring);
 	m_ff_vec3_f32_free(&t.filter.pos_ff);
 	m_ff_vec3_f32_free(&t.filter.rot_ff);
 	delete t_ptr->slam;
@@ -1426,6 +1560,14 @@ t_slam_run(void *ptr)
 {
 	auto &t = *(TrackerSlam *)ptr;
 	SLAM_DEBUG("SLAM tracker starting");
+
+	// Pin before starting, threads created by the SLAM system inherit this.
+	enum os_thread_core_class core_class =
+	    os_thread_core_class_from_string(debug_get_option_slam_core_class(), OS_THREAD_CORE_CLASS_PERFORMANCE);
+	if (os_thread_native_set_core_class(pthread_self(), core_class) != 0) {
+		SLAM_WARN("Failed to pin SLAM thread to core class %d", (int)core_class);
+	}
+
 	t.slam->start();
 	return NULL;
 }
@@ -1441,6 +1583,29 @@ t_slam_start(struct xrt_tracked_slam *xts)
 	return ret;
 }
 
+extern "C" int
+t_slam_get_metrics(struct xrt_tracked_slam *xts, struct t_slam_metrics *out_metrics)
+{
+	auto &t = *container_of(xts, TrackerSlam, base);
+
+	t_slam_metrics m{};
+	m.rpe_delta_s = 1.0;
+
+	os_mutex_lock(&t.gt.lock);
+	m.pose_count = t.pose_count;
+	gt_compute_errors(t, time_s_to_ns(m.rpe_delta_s), m);
+	os_mutex_unlock(&t.gt.lock);
+
+	m.latency_count = t.timing.latency_count;
+	if (m.latency_count > 0) {
+		m.latency_avg_ms = t.timing.latency_sum_ms / m.latency_count;
+		m.latency_max_ms = t.timing.latency_max_ms;
+	}
+
+	*out_metrics = m;
+	return 0;
+}
+
 extern "C" void
 t_slam_fill_default_config(struct t_slam_tracker_config *config)
 {
@@ -1550,6 +1715,9 @@ t_slam_create(struct xrt_frame_context *xfctx,
 	m_filter_euro_quat_init(&t.filter.rot_oe, t.filter.min_cutoff, t.filter.min_dcutoff, t.filter.beta);
 
 	t.gt.trajectory = new Trajectory{};
+	t.gt.estimates = new Trajectory{};
+	ret = os_mutex_init(&t.gt.lock);
+	SLAM_ASSERT(ret == 0, "Unable to initialize groundtruth lock");
 
 	// Setup timing extension
 
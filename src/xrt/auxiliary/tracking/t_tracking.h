@@ -546,6 +546,53 @@ t_hsv_filter_create(struct xrt_frame_context *xfctx,
                     struct xrt_frame_sink *sinks[4],
                     struct xrt_frame_sink **out_sink);
 
+//! Most blobs a @ref t_hsv_blob_sink gets per frame, the largest ones are kept.
+#define T_HSV_MAX_BLOBS (32)
+
+/*!
+ * A blob of connected pixels of the same colour found by the HSV filter.
+ */
+struct t_hsv_blob
+{
+	float x;       //!< Centroid in pixels
+	float y;       //!< Centroid in pixels
+	float size;    //!< Diameter of a circle with the same area, like cv::KeyPoint::size
+	uint32_t area; //!< Pixel count
+};
+
+/*!
+ * Gets the blobs of one HSV filter channel instead of a filtered frame.
+ *
+ * @see t_hsv_filter_create_with_blobs
+ */
+struct t_hsv_blob_sink
+{
+	/*!
+	 * Called from the filter's thread, @p xf is the source frame the blobs
+	 * were found in, @p blobs are sorted by decreasing area.
+	 */
+	void (*push_blobs)(struct t_hsv_blob_sink *sink,
+	                   struct xrt_frame *xf,
+	                   const struct t_hsv_blob *blobs,
+	                   uint32_t blob_count);
+};
+
+/*!
+ * Construct an HSV filter sink where channels with a blob sink get connected
+ * components extracted in the same scanline pass that classifies the pixels,
+ * instead of a filtered frame for a later blob detection pass. Components
+ * never connect across the middle of side by side stereo frames.
+ * @public @memberof t_hsv_filter
+ *
+ * @see xrt_frame_context
+ */
+int
+t_hsv_filter_create_with_blobs(struct xrt_frame_context *xfctx,
+                               struct t_hsv_filter_params *params,
+                               struct xrt_frame_sink *sinks[4],
+                               struct t_hsv_blob_sink *blob_sinks[4],
+                               struct xrt_frame_sink **out_sink);
+
 
 /*
  *
@@ -569,6 +616,36 @@ t_psmv_create(struct xrt_frame_context *xfctx,
               struct xrt_tracked_psmv **out_xtmv,
               struct xrt_frame_sink **out_sink);
 
+/*!
+ * Blob sink of the tracker, for use with @ref t_hsv_filter_create_with_blobs
+ * in place of the frame sink from @ref t_psmv_create.
+ *
+ * @public @memberof xrt_tracked_psmv
+ */
+struct t_hsv_blob_sink *
+t_psmv_get_blob_sink(struct xrt_tracked_psmv *xtmv);
+
+//! Most controllers a tracker from @ref t_psmv_create_multi can follow, one per HSV filter channel.
+#define T_PSMV_MAX_TARGETS (4)
+
+/*!
+ * Creates one tracker for @p count controllers of different colours, each
+ * frame is processed once on a single thread for all of them and every
+ * controller gets its own filter. Connect the blob sinks to the matching
+ * channels of @ref t_hsv_filter_create_with_blobs, the tracker waits for the
+ * blobs of all controllers before processing a frame. Any of the returned
+ * trackers can be started, the others share the thread.
+ *
+ * @public @memberof xrt_tracked_psmv
+ */
+int
+t_psmv_create_multi(struct xrt_frame_context *xfctx,
+                    const struct xrt_colour_rgb_f32 *rgbs,
+                    uint32_t count,
+                    struct t_stereo_camera_calibration *data,
+                    struct xrt_tracked_psmv **out_xtmvs,
+                    struct t_hsv_blob_sink **out_blob_sinks);
+
 /*!
  * @public @memberof xrt_tracked_psvr
  */
@@ -685,6 +762,33 @@ t_slam_create(struct xrt_frame_context *xfctx,
 int
 t_slam_start(struct xrt_tracked_slam *xts);
 
+/*!
+ * Accuracy and latency of a SLAM tracker run, accuracy is computed against the
+ * groundtruth pushed into its `gt` sink and is zero without it.
+ *
+ * @see xrt_tracked_slam
+ */
+struct t_slam_metrics
+{
+	uint32_t pose_count;    //!< Poses produced by the SLAM system
+	uint32_t gt_count;      //!< Groundtruth poses received
+	double ate_rmse_m;      //!< Absolute trajectory error, RMSE of positions in meters
+	double rpe_rmse_m;      //!< Relative pose error, RMSE of translation drift over @ref rpe_delta_s in meters
+	double rpe_delta_s;     //!< Time between the pose pairs compared for the relative pose error
+	uint32_t latency_count; //!< Latency samples, zero if the timing extension is not enabled
+	double latency_avg_ms;  //!< Average time from the tracker receiving a frame to us receiving its pose
+	double latency_max_ms;  //!< Maximum of the above
+};
+
+/*!
+ * Computes the metrics of everything tracked so far, meant to be called at the
+ * end of a dataset run.
+ *
+ * @public @memberof xrt_tracked_slam
+ */
+int
+t_slam_get_metrics(struct xrt_tracked_slam *xts, struct t_slam_metrics *out_metrics);
+
 /*
  *
  * Camera calibration
@@ -715,6 +819,8 @@ struct t_calibration_status
 	int cooldown;
 	//! Number of non-moving frames before capture.
 	int waits_remaining;
+	//! Reprojection error of the solver run on the frames collected so far, negative if not run yet.
+	float rp_error;
 	//! Stereo calibration data that was produced.
 	struct t_stereo_camera_calibration *stereo_data;
 };
@@ -7,6 +7,8 @@
  * @ingroup aux_util
  */
 
+#include "os/os_threading.h"
+
 #include "math/m_api.h"
 #include "util/u_autoexpgain.h"
 #include "util/u_debug.h"
@@ -19,8 +21,10 @@
 #include <math.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
 DEBUG_GET_ONCE_LOG_OPTION(aeg_log, "AEG_LOG", U_LOGGING_WARN)
+DEBUG_GET_ONCE_NUM_OPTION(aeg_update_interval, "AEG_UPDATE_INTERVAL", 1)
 
 #define AEG_TRACE(...) U_LOG_IFL_T(aeg->log_level, __VA_ARGS__)
 #define AEG_DEBUG(...) U_LOG_IFL_D(aeg->log_level, __VA_ARGS__)
@@ -43,6 +47,8 @@ DEBUG_GET_ONCE_LOG_OPTION(aeg_log, "AEG_LOG", U_LOGGING_WARN)
 #define INITIAL_MAX_BRIGHTNESS_STEP 0.1
 #define INITIAL_THRESHOLD 0.1
 #define GRID_COLS 32 //!< Amount of columns for the histogram sample grid
+#define PARTIAL_HISTOGRAMS 4 //!< Consecutive samples go to different histograms to not stall on the same bin
+#define WEIGHTS_CELLS (U_AEG_WEIGHTS_GRID * U_AEG_WEIGHTS_GRID)
 
 //! AEG State machine states
 enum u_aeg_state
@@ -85,7 +91,8 @@ struct u_autoexpgain
 	enum u_aeg_strategy strategy;
 	struct u_var_combo strategy_combo; //!< UI combo box for selecting `strategy`
 
-	float histogram[LEVELS];                 //!< Pixel intensity histogram
+	float histogram[2][LEVELS];              //!< Pixel intensity histogram, double-buffered
+	struct u_var_f32_block histogram_block;  //!< Publishes `histogram` to the UI
 	struct u_var_histogram_f32 histogram_ui; //!< UI for `histogram`
 
 	//! This is a made up scalar that lives in the [0, 1] range. 0 maps to minimum
@@ -110,6 +117,16 @@ struct u_autoexpgain
 	//! brightness changes.
 	int frame_delay;
 
+	//! Only every `update_interval` frames is scored, the ones in between are
+	//! skipped. Setting it to `frame_delay` only looks at settled frames.
+	int update_interval;
+	uint64_t frame_count; //!< Frames seen, to know which ones to score
+
+	//! Protects `weights` and `has_weights`, set from the tracker's thread.
+	struct os_mutex weights_mutex;
+	uint8_t weights[WEIGHTS_CELLS]; //!< Region weights, @see u_autoexpgain_set_weights
+	bool has_weights;
+
 	float exposure; //!< Currently computed exposure value to use
 	float gain;     //!< Currently computed gain value to use
 };
@@ -191,8 +208,9 @@ set_state(struct u_autoexpgain *aeg, enum u_aeg_action action)
 			aeg->overshoots++;
 			new_state = DARKEN;
 		} else if (action == GOOD) {
-			aeg->wait--;
-			new_state = aeg->wait == 0 ? IDLE : STOP_BRIGHTEN;
+			// Skipped frames also count towards the settling time.
+			aeg->wait -= aeg->update_interval;
+			new_state = aeg->wait <= 0 ? IDLE : STOP_BRIGHTEN;
 		} else {
 			AEG_ASSERT_(false);
 		}
@@ -218,8 +236,9 @@ set_state(struct u_autoexpgain *aeg, enum u_aeg_action action)
 		} else if (action == BRIGHT) {
 			new_state = DARKEN;
 		} else if (action == GOOD) {
-			aeg->wait--;
-			new_state = aeg->wait == 0 ? IDLE : STOP_DARKEN;
+			// Skipped frames also count towards the settling time.
+			aeg->wait -= aeg->update_interval;
+			new_state = aeg->wait <= 0 ? IDLE : STOP_DARKEN;
 		} else {
 			AEG_ASSERT_(false);
 		}
@@ -318,39 +337,99 @@ update_expgain(struct u_autoexpgain *aeg)
 	brightness_to_expgain(aeg, brightness, &aeg->exposure, &aeg->gain);
 }
 
+//! Histogram of the sample grid with every sample counting the same.
+static uint32_t
+histogram_even(struct xrt_frame *xf, uint32_t cell, uint32_t histogram[LEVELS])
+{
+	uint32_t partial[PARTIAL_HISTOGRAMS][LEVELS] = {0};
+	uint32_t samples_count = 0;
+	size_t step = cell * u_format_block_size(xf->format);
+
+	for (uint32_t y = 0; y < xf->height; y += cell) {
+		// Note that for multichannel images only the first channel is in use.
+		const uint8_t *row = xf->data + y * xf->stride;
+		uint32_t i = 0;
+		for (uint32_t x = 0; x < xf->width; x += cell, i++) {
+			partial[i % PARTIAL_HISTOGRAMS][*row]++;
+			row += step;
+		}
+		samples_count += i;
+	}
+
+	for (int i = 0; i < LEVELS; i++) {
+		histogram[i] = 0;
+		for (int p = 0; p < PARTIAL_HISTOGRAMS; p++) {
+			histogram[i] += partial[p][i];
+		}
+	}
+
+	return samples_count;
+}
+
+//! Histogram of the sample grid with every sample counting as its region weight.
+static uint32_t
+histogram_weighted(struct xrt_frame *xf,
+                   uint32_t cell,
+                   const uint8_t weights[WEIGHTS_CELLS],
+                   uint32_t histogram[LEVELS])
+{
+	uint32_t samples_count = 0;
+	size_t pixel_size = u_format_block_size(xf->format);
+
+	memset(histogram, 0, sizeof(uint32_t) * LEVELS);
+
+	for (uint32_t y = 0; y < xf->height; y += cell) {
+		const uint8_t *row = xf->data + y * xf->stride;
+		const uint8_t *weights_row = weights + (y * U_AEG_WEIGHTS_GRID / xf->height) * U_AEG_WEIGHTS_GRID;
+		for (uint32_t x = 0; x < xf->width; x += cell) {
+			uint8_t weight = weights_row[x * U_AEG_WEIGHTS_GRID / xf->width];
+			histogram[row[x * pixel_size]] += weight;
+			samples_count += weight;
+		}
+	}
+
+	return samples_count;
+}
+
 //! Returns a value in the range [-1, 1] describing how dark-bright the image
 //! is, 0 means it's alright.
 static float
 get_score(struct u_autoexpgain *aeg, struct xrt_frame *xf)
 {
-	uint32_t w = xf->width;
-	uint32_t h = xf->height;
-	uint32_t s = w / GRID_COLS; // Grid cell size
+	uint32_t cell = MAX(xf->width / GRID_COLS, 1); // Grid cell size
+
+	uint8_t weights[WEIGHTS_CELLS];
+	os_mutex_lock(&aeg->weights_mutex);
+	bool has_weights = aeg->has_weights;
+	if (has_weights) {
+		memcpy(weights, aeg->weights, sizeof(weights));
+	}
+	os_mutex_unlock(&aeg->weights_mutex);
 
 	// Compute histogram (PDF)
-	int histogram[LEVELS] = {0};
-	int samples_count = 0;
-	size_t pixel_size = u_format_block_size(xf->format);
-	for (uint32_t y = 0; y < h; y += s) {
-		for (uint32_t x = 0; x < w; x += s) {
-			// Note that for multichannel images only the first channel is in use.
-			uint8_t intensity = xf->data[y * xf->stride + x * pixel_size];
-			histogram[intensity]++;
-			samples_count++;
-		}
+	uint32_t histogram[LEVELS];
+	uint32_t samples_count = 0;
+	if (has_weights) {
+		samples_count = histogram_weighted(xf, cell, weights, histogram);
+	}
+	if (samples_count == 0) {
+		// Nothing weighted in this image, look at all of it instead.
+		samples_count = histogram_even(xf, cell, histogram);
 	}
 
 	// Draw histogram
+	float *drawn = u_var_f32_block_back(&aeg->histogram_block);
 	for (int i = 0; i < LEVELS; i++) {
-		aeg->histogram[i] = histogram[i];
+		drawn[i] = (float)histogram[i];
 	}
+	u_var_f32_block_publish(&aeg->histogram_block);
 
 	// Compute mean
 	float mean = 0;
 	for (int i = 0; i < LEVELS; i++) {
-		mean += (float)i * histogram[i];
+		mean += (float)i * (float)histogram[i];
 	}
-	mean /= samples_count;
+	mean /= (float)samples_count;
 
 	float score = 0;
 
@@ -435,8 +514,12 @@ u_autoexpgain_create(enum u_aeg_strategy strategy, bool enabled_from_start, int
 	aeg->strategy_combo.options = "Tracking\0Dynamic Range\0\0";
 	aeg->strategy_combo.value = (int *)&aeg->strategy;
 
-	aeg->histogram_ui.values = aeg->histogram;
+	aeg->histogram_block.buffers[0] = aeg->histogram[0];
+	aeg->histogram_block.buffers[1] = aeg->histogram[1];
+	aeg->histogram_block.count = LEVELS;
+	aeg->histogram_ui.values = aeg->histogram[0];
 	aeg->histogram_ui.count = LEVELS;
+	aeg->histogram_ui.block = &aeg->histogram_block;
 
 	aeg->brightness.max = 1;
 	aeg->brightness.min = 0;
@@ -447,6 +530,9 @@ u_autoexpgain_create(enum u_aeg_strategy strategy, bool enabled_from_start, int
 
 	aeg->threshold = INITIAL_THRESHOLD;
 	aeg->frame_delay = frame_delay;
+	aeg->update_interval = MAX((int)debug_get_num_option_aeg_update_interval(), 1);
+
+	os_mutex_init(&aeg->weights_mutex);
 
 	brightness_to_expgain(aeg, INITIAL_BRIGHTNESS, &aeg->exposure, &aeg->gain);
 
@@ -467,6 +553,9 @@ u_autoexpgain_add_vars(struct u_autoexpgain *aeg, void *root, char *prefix)
 	(void)snprintf(tmp, sizeof(tmp), "%sFrame update delay", prefix);
 	u_var_add_i32(root, &aeg->frame_delay, tmp);
 
+	(void)snprintf(tmp, sizeof(tmp), "%sUpdate interval (frames)", prefix);
+	u_var_add_i32(root, &aeg->update_interval, tmp);
+
 	(void)snprintf(tmp, sizeof(tmp), "%sStrategy", prefix);
 	u_var_add_combo(root, &aeg->strategy_combo, tmp);
 
@@ -494,10 +583,27 @@ u_autoexpgain_add_vars(struct u_autoexpgain *aeg, void *root, char *prefix)
 void
 u_autoexpgain_update(struct u_autoexpgain *aeg, struct xrt_frame *xf)
 {
+	// Also guards against the UI setting it to zero.
+	aeg->update_interval = MAX(aeg->update_interval, 1);
+	if (aeg->frame_count++ % (uint64_t)aeg->update_interval != 0) {
+		return;
+	}
+
 	update_brightness(aeg, xf);
 	update_expgain(aeg);
 }
 
+void
+u_autoexpgain_set_weights(struct u_autoexpgain *aeg, const uint8_t *weights)
+{
+	os_mutex_lock(&aeg->weights_mutex);
+	aeg->has_weights = weights != NULL;
+	if (weights != NULL) {
+		memcpy(aeg->weights, weights, sizeof(aeg->weights));
+	}
+	os_mutex_unlock(&aeg->weights_mutex);
+}
+
 float
 u_autoexpgain_get_exposure(struct u_autoexpgain *aeg)
 {
@@ -513,6 +619,11 @@ u_autoexpgain_get_gain(struct u_autoexpgain *aeg)
 void
 u_autoexpgain_destroy(struct u_autoexpgain **aeg)
 {
+	if (*aeg == NULL) {
+		return;
+	}
+
+	os_mutex_destroy(&(*aeg)->weights_mutex);
 	free(*aeg);
 	*aeg = NULL;
 }
@@ -24,6 +24,9 @@ enum u_aeg_strategy
 	U_AEG_STRATEGY_COUNT
 };
 
+//! Cells per side of the region weights grid, see @ref u_autoexpgain_set_weights.
+#define U_AEG_WEIGHTS_GRID 8
+
 struct u_autoexpgain;
 
 /*!
@@ -45,6 +48,19 @@ u_autoexpgain_add_vars(struct u_autoexpgain *aeg, void *root, char *prefix);
 void
 u_autoexpgain_update(struct u_autoexpgain *aeg, struct xrt_frame *xf);
 
+/*!
+ * Weight the regions of the image when scoring its brightness, so that a
+ * tracker can have the exposure favour the parts of the image its features are
+ * in. Can be called from any thread.
+ *
+ * @param weights Row-major grid of @ref U_AEG_WEIGHTS_GRID by
+ * @ref U_AEG_WEIGHTS_GRID cells stretched over the image, a cell with zero
+ * weight is ignored. NULL weights the whole image evenly again, which is also
+ * what happens for images where all sampled cells have zero weight.
+ */
+void
+u_autoexpgain_set_weights(struct u_autoexpgain *aeg, const uint8_t *weights);
+
 //! Get currently computed exposure value in usecs.
 float
 u_autoexpgain_get_exposure(struct u_autoexpgain *aeg);
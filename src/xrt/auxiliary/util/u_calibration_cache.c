@@ -0,0 +1,209 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Caches device calibration blobs on disk.
+ * @ingroup aux_util
+ */
+
+#include "xrt/xrt_config_os.h"
+
+#include "util/u_file.h"
+#include "util/u_misc.h"
+#include "util/u_logging.h"
+#include "util/u_calibration_cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+
+/*!
+ * Bump when the layout of the file changes, files of other versions are
+ * ignored and overwritten.
+ */
+#define CACHE_VERSION 1
+
+//! Largest blob that is loaded, anything bigger is treated as corrupt.
+#define CACHE_MAX_SIZE (16 * 1024 * 1024)
+
+/*!
+ * Written in front of the blob, in host byte order since the cache is never
+ * shared between machines.
+ */
+struct cache_header
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t reserved;
+	uint64_t size;
+
+	//! FNV-1a of the blob, to catch truncated or damaged files.
+	uint64_t hash;
+};
+
+
+#ifdef XRT_OS_LINUX
+
+/*
+ *
+ * Helper functions.
+ *
+ */
+
+static const char cache_magic[8] = {'X', 'R', 'T', 'C', 'A', 'L', 'B', '\0'};
+
+static uint64_t
+hash_data(const uint8_t *data, size_t size)
+{
+	uint64_t hash = UINT64_C(0xcbf29ce484222325);
+	for (size_t i = 0; i < size; i++) {
+		hash ^= data[i];
+		hash *= UINT64_C(0x100000001b3);
+	}
+	return hash;
+}
+
+/*!
+ * Only lets through characters that are safe in a file name.
+ */
+static bool
+make_filename(const char *key, const char *suffix, char *out_name, size_t out_size)
+{
+	int ret = snprintf(out_name, out_size, "calibration_%s%s", key, suffix);
+	if (ret <= 0 || (size_t)ret >= out_size) {
+		return false;
+	}
+
+	for (char *c = out_name; *c != '\0'; c++) {
+		bool ok = (*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') || (*c >= '0' && *c <= '9') ||
+		          *c == '-' || *c == '_' || *c == '.';
+		if (!ok) {
+			*c = '_';
+		}
+	}
+
+	return true;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+uint8_t *
+u_calibration_cache_load(const char *key, size_t *out_size)
+{
+	char name[256];
+	if (!make_filename(key, ".bin", name, sizeof(name))) {
+		return NULL;
+	}
+
+	FILE *file = u_file_open_file_in_cache_dir(name, "rb");
+	if (file == NULL) {
+		return NULL;
+	}
+
+	struct cache_header hdr;
+	if (fread(&hdr, sizeof(hdr), 1, file) != 1 ||                   //
+	    memcmp(hdr.magic, cache_magic, sizeof(cache_magic)) != 0 || //
+	    hdr.version != CACHE_VERSION ||                             //
+	    hdr.size > CACHE_MAX_SIZE) {
+		U_LOG_D("Ignoring calibration cache '%s', wrong header", name);
+		fclose(file);
+		return NULL;
+	}
+
+	size_t size = (size_t)hdr.size;
+	uint8_t *data = U_TYPED_ARRAY_CALLOC(uint8_t, size + 1);
+	if (data == NULL) {
+		fclose(file);
+		return NULL;
+	}
+
+	size_t read = fread(data, 1, size, file);
+	fclose(file);
+
+	if (read != size || hash_data(data, size) != hdr.hash) {
+		U_LOG_W("Ignoring calibration cache '%s', it is damaged", name);
+		free(data);
+		return NULL;
+	}
+
+	*out_size = size;
+
+	return data;
+}
+
+bool
+u_calibration_cache_store(const char *key, const uint8_t *data, size_t size)
+{
+	char name[256];
+	char tmp_name[256];
+	if (!make_filename(key, ".bin", name, sizeof(name)) ||
+	    !make_filename(key, ".bin.tmp", tmp_name, sizeof(tmp_name))) {
+		return false;
+	}
+
+	char dir[PATH_MAX];
+	ssize_t ret = u_file_get_cache_dir(dir, sizeof(dir));
+	if (ret <= 0 || ret >= (ssize_t)sizeof(dir)) {
+		return false;
+	}
+
+	// Written to the side and renamed, so a crash never leaves half a file behind.
+	FILE *file = u_file_open_file_in_cache_dir(tmp_name, "wb");
+	if (file == NULL) {
+		U_LOG_W("Could not create calibration cache '%s'", tmp_name);
+		return false;
+	}
+
+	struct cache_header hdr = {
+	    .version = CACHE_VERSION,
+	    .size = size,
+	    .hash = hash_data(data, size),
+	};
+	memcpy(hdr.magic, cache_magic, sizeof(cache_magic));
+
+	bool ok = fwrite(&hdr, sizeof(hdr), 1, file) == 1 && fwrite(data, 1, size, file) == size;
+	ok = fclose(file) == 0 && ok;
+
+	char tmp_path[PATH_MAX + 256];
+	char path[PATH_MAX + 256];
+	snprintf(tmp_path, sizeof(tmp_path), "%s/%s", dir, tmp_name);
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+
+	if (!ok || rename(tmp_path, path) != 0) {
+		U_LOG_W("Could not write calibration cache '%s'", name);
+		remove(tmp_path);
+		return false;
+	}
+
+	return true;
+}
+
+#else /* XRT_OS_LINUX */
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+uint8_t *
+u_calibration_cache_load(const char *key, size_t *out_size)
+{
+	//! @todo implement the underlying u_file_open_file_in_cache_dir
+	return NULL;
+}
+
+bool
+u_calibration_cache_store(const char *key, const uint8_t *data, size_t size)
+{
+	return false;
+}
+
+#endif /* XRT_OS_LINUX */
@@ -0,0 +1,43 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Caches device calibration blobs on disk.
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * Loads the calibration blob stored under @p key in the cache dir. Returns
+ * NULL if there is none, or if it was written by another version of the cache
+ * or is corrupt. The blob is followed by a zero byte so text can be used
+ * directly, free with free().
+ *
+ * The key must identify the device and anything that can change its
+ * calibration, like the serial number and firmware version.
+ *
+ * @ingroup aux_util
+ */
+uint8_t *
+u_calibration_cache_load(const char *key, size_t *out_size);
+
+/*!
+ * Stores a calibration blob under @p key, see @ref u_calibration_cache_load.
+ *
+ * @ingroup aux_util
+ */
+bool
+u_calibration_cache_store(const char *key, const uint8_t *data, size_t size);
+
+
+#ifdef __cplusplus
+}
+#endif
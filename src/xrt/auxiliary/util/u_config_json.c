@@ -11,6 +11,8 @@
 #include "xrt/xrt_settings.h"
 #include "xrt/xrt_config.h"
 
+#include "os/os_threading.h"
+
 #include "util/u_file.h"
 #include "util/u_json.h"
 #include "util/u_debug.h"
@@ -30,6 +32,124 @@ DEBUG_GET_ONCE_OPTION(active_config, "P_OVERRIDE_ACTIVE_CONFIG", NULL)
 #define CONFIG_FILE_NAME "config_v0.json"
 #define GUI_STATE_FILE_NAME "gui_state_v0.json"
 
+
+/*
+ *
+ * Parsed file cache.
+ *
+ */
+
+#if (defined(XRT_OS_LINUX) || defined(XRT_OS_WINDOWS)) && !defined(XRT_OS_ANDROID)
+
+/*!
+ * Last parsed contents of a file, the main config file is opened by the prober
+ * and by several builders and drivers while probing. It is only read and
+ * parsed again if the modification time or size of the file has changed, or
+ * if it was written by us.
+ */
+struct cached_file
+{
+	char path[1024];
+	int64_t mtime;
+	int64_t size;
+
+	//! Never handed out, callers get a copy that they can change and free.
+	cJSON *root;
+};
+
+static struct os_mutex g_cache_mutex;
+static pthread_once_t g_cache_once = PTHREAD_ONCE_INIT;
+static struct cached_file g_cache[2];
+
+static void
+init_cache_mutex(void)
+{
+	os_mutex_init(&g_cache_mutex);
+}
+
+static struct cached_file *
+find_cached_file_locked(const char *path)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(g_cache); i++) {
+		if (g_cache[i].root != NULL && strcmp(g_cache[i].path, path) == 0) {
+			return &g_cache[i];
+		}
+	}
+
+	return NULL;
+}
+
+/*!
+ * Returns a copy of the cached contents of @p path, NULL if the file changed
+ * or was never parsed.
+ */
+static cJSON *
+get_cached_file(const char *path, const struct stat *st)
+{
+	pthread_once(&g_cache_once, init_cache_mutex);
+	os_mutex_lock(&g_cache_mutex);
+
+	cJSON *root = NULL;
+	struct cached_file *cf = find_cached_file_locked(path);
+	if (cf != NULL && cf->mtime == (int64_t)st->st_mtime && cf->size == (int64_t)st->st_size) {
+		root = cJSON_Duplicate(cf->root, true);
+	}
+
+	os_mutex_unlock(&g_cache_mutex);
+
+	return root;
+}
+
+static void
+set_cached_file(const char *path, const struct stat *st, const cJSON *root)
+{
+	pthread_once(&g_cache_once, init_cache_mutex);
+	os_mutex_lock(&g_cache_mutex);
+
+	struct cached_file *cf = find_cached_file_locked(path);
+	for (size_t i = 0; cf == NULL && i < ARRAY_SIZE(g_cache); i++) {
+		if (g_cache[i].root == NULL) {
+			cf = &g_cache[i];
+		}
+	}
+
+	// All slots taken by other files, replace the first one.
+	if (cf == NULL) {
+		cf = &g_cache[0];
+	}
+
+	if (cf->root != NULL) {
+		cJSON_Delete(cf->root);
+	}
+
+	snprintf(cf->path, sizeof(cf->path), "%s", path);
+	cf->mtime = (int64_t)st->st_mtime;
+	cf->size = (int64_t)st->st_size;
+	cf->root = cJSON_Duplicate(root, true);
+
+	os_mutex_unlock(&g_cache_mutex);
+}
+
+/*!
+ * Our own writes can land within the resolution of the modification time.
+ */
+static void
+invalidate_cached_file(const char *path)
+{
+	pthread_once(&g_cache_once, init_cache_mutex);
+	os_mutex_lock(&g_cache_mutex);
+
+	struct cached_file *cf = find_cached_file_locked(path);
+	if (cf != NULL) {
+		cJSON_Delete(cf->root);
+		cf->root = NULL;
+	}
+
+	os_mutex_unlock(&g_cache_mutex);
+}
+
+#endif
+
 void
 u_config_json_close(struct u_config_json *json)
 {
@@ -54,6 +174,17 @@ u_config_json_open_or_create_file(struct u_config_json *json, const char *filena
 		return;
 	}
 
+	struct stat st;
+	if (stat(tmp, &st) != 0) {
+		return;
+	}
+
+	json->root = get_cached_file(tmp, &st);
+	if (json->root != NULL) {
+		json->file_loaded = true;
+		return;
+	}
+
 	FILE *file = u_file_open_file_in_config_dir(filename, "r");
 	if (file == NULL) {
 		return;
@@ -78,6 +209,8 @@ u_config_json_open_or_create_file(struct u_config_json *json, const char *filena
 	if (json->root == NULL) {
 		U_LOG_E("Failed to parse JSON in '%s':\n%s\n#######", tmp, str);
 		U_LOG_E("'%s'", cJSON_GetErrorPtr());
+	} else {
+		set_cached_file(tmp, &st, json->root);
 	}
 
 	free(str);
@@ -399,6 +532,13 @@ u_config_write(struct u_config_json *json, const char *filename)
 	char *str = cJSON_Print(json->root);
 	U_LOG_D("%s", str);
 
+#if (defined(XRT_OS_LINUX) || defined(XRT_OS_WINDOWS)) && !defined(XRT_OS_ANDROID)
+	char tmp[1024];
+	if (u_file_get_path_in_config_dir(filename, tmp, sizeof(tmp)) > 0) {
+		invalidate_cached_file(tmp);
+	}
+#endif
+
 	FILE *config_file = u_file_open_file_in_config_dir(filename, "w");
 	fprintf(config_file, "%s\n", str);
 	fflush(config_file);
@@ -2,57 +2,171 @@
 // SPDX-License-Identifier: BSL-1.0
 /*!
  * @file
- * @brief  Expose std::deque to C
+ * @brief  Expose a deque to C
  * @author Mateo de Mayo <mateo.demayo@collabora.com>
  * @ingroup aux_util
  */
 
 #include "u_deque.h"
 #include "util/u_time.h"
-#include <deque>
 
-using std::deque;
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+
+namespace {
+
+/*!
+ * Ring buffer deque of trivially copyable elements, the first @p N live inside
+ * the object. The capacity is always a power of two and never shrinks.
+ */
+template <typename T, size_t N> class RingDeque
+{
+public:
+	static_assert((N & (N - 1)) == 0, "The inline count must be a power of two");
+	static_assert(std::is_trivially_copyable<T>::value, "Elements are moved with plain copies");
+
+	void
+	pushBack(T e)
+	{
+		reserve(mCount + 1);
+		mData[(mHead + mCount) & (mCapacity - 1)] = e;
+		mCount++;
+	}
+
+	void
+	pushBackN(const T *elems, size_t count)
+	{
+		reserve(mCount + count);
+		for (size_t i = 0; i < count; i++) {
+			mData[(mHead + mCount + i) & (mCapacity - 1)] = elems[i];
+		}
+		mCount += count;
+	}
+
+	size_t
+	popFrontN(T *out_elems, size_t max_count)
+	{
+		size_t count = std::min(max_count, mCount);
+		for (size_t i = 0; i < count; i++) {
+			out_elems[i] = mData[(mHead + i) & (mCapacity - 1)];
+		}
+		mHead = (mHead + count) & (mCapacity - 1);
+		mCount -= count;
+		return count;
+	}
+
+	T
+	at(size_t i) const
+	{
+		if (i >= mCount) {
+			throw std::out_of_range("u_deque index out of range");
+		}
+		return mData[(mHead + i) & (mCapacity - 1)];
+	}
+
+	size_t
+	size() const noexcept
+	{
+		return mCount;
+	}
+
+	void
+	clear() noexcept
+	{
+		mHead = 0;
+		mCount = 0;
+	}
+
+	void
+	reserve(size_t count)
+	{
+		if (count <= mCapacity) {
+			return;
+		}
+
+		size_t capacity = mCapacity;
+		while (capacity < count) {
+			capacity *= 2;
+		}
+
+		// Unwrap the elements to the start of the new storage.
+		auto heap = std::make_unique<T[]>(capacity);
+		for (size_t i = 0; i < mCount; i++) {
+			heap[i] = mData[(mHead + i) & (mCapacity - 1)];
+		}
+
+		mHeap = std::move(heap);
+		mData = mHeap.get();
+		mCapacity = capacity;
+		mHead = 0;
+	}
+
+private:
+	T mInline[N] = {};
+	std::unique_ptr<T[]> mHeap = {};
+	T *mData = mInline;
+	size_t mCapacity = N;
+	size_t mHead = 0;
+	size_t mCount = 0;
+};
+
+} // namespace
 
 #define U_DEQUE_IMPLEMENTATION(TYPE)                                                                                   \
+	using u_deque_##TYPE##_impl = RingDeque<TYPE, U_DEQUE_INLINE_COUNT>;                                           \
+                                                                                                                       \
 	u_deque_##TYPE u_deque_##TYPE##_create()                                                                       \
 	{                                                                                                              \
-		u_deque_##TYPE ud{new deque<TYPE>};                                                                    \
+		u_deque_##TYPE ud{new u_deque_##TYPE##_impl};                                                          \
 		return ud;                                                                                             \
 	}                                                                                                              \
                                                                                                                        \
 	void u_deque_##TYPE##_push_back(u_deque_##TYPE ud, TYPE e)                                                     \
 	{                                                                                                              \
-		deque<TYPE> *d = static_cast<deque<TYPE> *>(ud.ptr);                                                   \
-		d->push_back(e);                                                                                       \
+		static_cast<u_deque_##TYPE##_impl *>(ud.ptr)->pushBack(e);                                             \
+	}                                                                                                              \
+                                                                                                                       \
+	void u_deque_##TYPE##_push_back_n(u_deque_##TYPE ud, const TYPE *elems, size_t count)                          \
+	{                                                                                                              \
+		static_cast<u_deque_##TYPE##_impl *>(ud.ptr)->pushBackN(elems, count);                                 \
 	}                                                                                                              \
                                                                                                                        \
 	bool u_deque_##TYPE##_pop_front(u_deque_##TYPE ud, TYPE *e)                                                    \
 	{                                                                                                              \
-		deque<TYPE> *d = static_cast<deque<TYPE> *>(ud.ptr);                                                   \
-		bool pop = !d->empty();                                                                                \
-		if (pop) {                                                                                             \
-			*e = d->front();                                                                               \
-			d->erase(d->begin());                                                                          \
-		}                                                                                                      \
-		return pop;                                                                                            \
+		return static_cast<u_deque_##TYPE##_impl *>(ud.ptr)->popFrontN(e, 1) == 1;                             \
+	}                                                                                                              \
+                                                                                                                       \
+	size_t u_deque_##TYPE##_pop_front_n(u_deque_##TYPE ud, TYPE *out_elems, size_t max_count)                      \
+	{                                                                                                              \
+		return static_cast<u_deque_##TYPE##_impl *>(ud.ptr)->popFrontN(out_elems, max_count);                  \
 	}                                                                                                              \
                                                                                                                        \
 	TYPE u_deque_##TYPE##_at(u_deque_##TYPE ud, size_t i)                                                          \
 	{                                                                                                              \
-		deque<TYPE> *d = static_cast<deque<TYPE> *>(ud.ptr);                                                   \
-		return d->at(i);                                                                                       \
+		return static_cast<u_deque_##TYPE##_impl *>(ud.ptr)->at(i);                                            \
 	}                                                                                                              \
                                                                                                                        \
 	size_t u_deque_##TYPE##_size(u_deque_##TYPE ud)                                                                \
 	{                                                                                                              \
-		deque<TYPE> *d = static_cast<deque<TYPE> *>(ud.ptr);                                                   \
-		return d->size();                                                                                      \
+		return static_cast<u_deque_##TYPE##_impl *>(ud.ptr)->size();                                           \
+	}                                                                                                              \
+                                                                                                                       \
+	void u_deque_##TYPE##_reserve(u_deque_##TYPE ud, size_t count)                                                 \
+	{                                                                                                              \
+		static_cast<u_deque_##TYPE##_impl *>(ud.ptr)->reserve(count);                                          \
+	}                                                                                                              \
+                                                                                                                       \
+	void u_deque_##TYPE##_clear(u_deque_##TYPE ud)                                                                 \
+	{                                                                                                              \
+		static_cast<u_deque_##TYPE##_impl *>(ud.ptr)->clear();                                                 \
 	}                                                                                                              \
                                                                                                                        \
 	void u_deque_##TYPE##_destroy(u_deque_##TYPE *ud)                                                              \
 	{                                                                                                              \
-		deque<TYPE> *d = static_cast<deque<TYPE> *>(ud->ptr);                                                  \
-		delete d;                                                                                              \
+		delete static_cast<u_deque_##TYPE##_impl *>(ud->ptr);                                                  \
 		ud->ptr = nullptr;                                                                                     \
 	}
 
@@ -2,9 +2,14 @@
 // SPDX-License-Identifier: BSL-1.0
 /*!
  * @file
- * @brief  Expose std::deque to C
+ * @brief  Expose a deque to C
  * @author Mateo de Mayo <mateo.demayo@collabora.com>
  * @ingroup aux_util
+ *
+ * The deque is a ring buffer that keeps the first @ref U_DEQUE_INLINE_COUNT
+ * elements inside the object itself and only grows, so once it has reached its
+ * working size pushing and popping never allocate. Use `reserve` to get there
+ * up front.
  */
 
 #pragma once
@@ -16,6 +21,9 @@
 extern "C" {
 #endif
 
+//! Number of elements a deque holds before it allocates any storage.
+#define U_DEQUE_INLINE_COUNT 16
+
 #define U_DEQUE_DECLARATION(TYPE)                                                                                      \
 	struct u_deque_##TYPE                                                                                          \
 	{                                                                                                              \
@@ -23,9 +31,13 @@ extern "C" {
 	};                                                                                                             \
 	struct u_deque_##TYPE u_deque_##TYPE##_create(void);                                                           \
 	void u_deque_##TYPE##_push_back(struct u_deque_##TYPE ud, TYPE e);                                             \
+	void u_deque_##TYPE##_push_back_n(struct u_deque_##TYPE ud, const TYPE *elems, size_t count);                  \
 	bool u_deque_##TYPE##_pop_front(struct u_deque_##TYPE ud, TYPE *e);                                            \
+	size_t u_deque_##TYPE##_pop_front_n(struct u_deque_##TYPE ud, TYPE *out_elems, size_t max_count);              \
 	TYPE u_deque_##TYPE##_at(struct u_deque_##TYPE ud, size_t i);                                                  \
 	size_t u_deque_##TYPE##_size(struct u_deque_##TYPE wrap);                                                      \
+	void u_deque_##TYPE##_reserve(struct u_deque_##TYPE ud, size_t count);                                         \
+	void u_deque_##TYPE##_clear(struct u_deque_##TYPE ud);                                                         \
 	void u_deque_##TYPE##_destroy(struct u_deque_##TYPE *ud);
 
 U_DEQUE_DECLARATION(timepoint_ns)
@@ -0,0 +1,221 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Shared pose history and prediction for device drivers.
+ * @ingroup aux_util
+ */
+
+#include "os/os_time.h"
+
+#include "math/m_api.h"
+#include "math/m_vec3.h"
+#include "math/m_predict.h"
+#include "math/m_relation_history.h"
+
+#include "util/u_var.h"
+#include "util/u_misc.h"
+#include "util/u_time.h"
+#include "util/u_device_poses.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+
+/*!
+ * How far back from the newest pose the older velocity used to estimate the
+ * acceleration is taken from, long enough to not just be noise.
+ */
+#define ACCELERATION_WINDOW_NS (20 * U_TIME_1MS_IN_NS)
+
+
+/*
+ *
+ * Helper functions.
+ *
+ */
+
+static struct m_relation_history *
+find_history(struct u_device_poses *udp, enum xrt_input_name name)
+{
+	for (uint32_t i = 0; i < udp->count; i++) {
+		if (udp->names[i] == name) {
+			return udp->histories[i];
+		}
+	}
+
+	return NULL;
+}
+
+static void
+predict_constant_acceleration(struct m_relation_history *rh,
+                              const struct xrt_space_relation *latest,
+                              uint64_t latest_ns,
+                              double delta_s,
+                              struct xrt_space_relation *out_relation)
+{
+	// Rotation and the first order position term.
+	m_predict_relation(latest, delta_s, out_relation);
+
+	if ((latest->relation_flags & XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT) == 0 ||
+	    latest_ns <= ACCELERATION_WINDOW_NS) {
+		return;
+	}
+
+	struct xrt_space_relation older;
+	enum m_relation_history_result ret = m_relation_history_get(rh, latest_ns - ACCELERATION_WINDOW_NS, &older);
+	if (ret != M_RELATION_HISTORY_RESULT_EXACT && ret != M_RELATION_HISTORY_RESULT_INTERPOLATED) {
+		return;
+	}
+	if ((older.relation_flags & XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT) == 0) {
+		return;
+	}
+
+	float window_s = (float)time_ns_to_s(ACCELERATION_WINDOW_NS);
+	float dt = (float)delta_s;
+	struct xrt_vec3 accel = m_vec3_mul_scalar(m_vec3_sub(latest->linear_velocity, older.linear_velocity),
+	                                          1.0f / window_s);
+
+	out_relation->pose.position = m_vec3_add(out_relation->pose.position, m_vec3_mul_scalar(accel, 0.5f * dt * dt));
+	out_relation->linear_velocity = m_vec3_add(latest->linear_velocity, m_vec3_mul_scalar(accel, dt));
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+int
+u_device_poses_init(struct u_device_poses *udp,
+                    const struct u_device_poses_config *config,
+                    const enum xrt_input_name *names,
+                    uint32_t count)
+{
+	U_ZERO(udp);
+
+	int ret = os_mutex_init(&udp->stats_mutex);
+	if (ret != 0) {
+		return ret;
+	}
+
+	udp->config = *config;
+	udp->names = U_TYPED_ARRAY_CALLOC(enum xrt_input_name, count);
+	udp->histories = U_TYPED_ARRAY_CALLOC(struct m_relation_history *, count);
+	udp->count = count;
+
+	for (uint32_t i = 0; i < count; i++) {
+		udp->names[i] = names[i];
+		m_relation_history_create(&udp->histories[i]);
+	}
+
+	return 0;
+}
+
+void
+u_device_poses_push(struct u_device_poses *udp,
+                    enum xrt_input_name name,
+                    const struct xrt_space_relation *relation,
+                    uint64_t timestamp_ns)
+{
+	struct m_relation_history *rh = find_history(udp, name);
+	if (rh == NULL) {
+		return;
+	}
+
+	m_relation_history_push(rh, relation, timestamp_ns);
+}
+
+xrt_result_t
+u_device_poses_get(struct u_device_poses *udp,
+                   enum xrt_input_name name,
+                   uint64_t at_timestamp_ns,
+                   struct xrt_space_relation *out_relation)
+{
+	uint64_t start_ns = os_monotonic_get_ns();
+	struct xrt_space_relation latest;
+	uint64_t latest_ns = 0;
+	bool predicted = false;
+	bool clamped = false;
+
+	struct m_relation_history *rh = find_history(udp, name);
+	if (rh == NULL || !m_relation_history_get_latest(rh, &latest_ns, &latest)) {
+		U_ZERO(out_relation);
+
+		os_mutex_lock(&udp->stats_mutex);
+		udp->stats.invalid++;
+		os_mutex_unlock(&udp->stats_mutex);
+
+		return XRT_ERROR_POSE_NOT_ACTIVE;
+	}
+
+	if (at_timestamp_ns <= latest_ns) {
+		m_relation_history_get(rh, at_timestamp_ns, out_relation);
+	} else {
+		uint64_t delta_ns = at_timestamp_ns - latest_ns;
+		uint64_t max_ns = udp->config.max_prediction_ns;
+		if (max_ns != 0 && delta_ns > max_ns) {
+			delta_ns = max_ns;
+			clamped = true;
+		}
+
+		double delta_s = time_ns_to_s(delta_ns);
+		switch (udp->config.model) {
+		case U_DEVICE_POSES_MODEL_NONE: *out_relation = latest; break;
+		case U_DEVICE_POSES_MODEL_CONSTANT_VELOCITY: m_predict_relation(&latest, delta_s, out_relation); break;
+		case U_DEVICE_POSES_MODEL_CONSTANT_ACCELERATION:
+			predict_constant_acceleration(rh, &latest, latest_ns, delta_s, out_relation);
+			break;
+		default: assert(false); *out_relation = latest; break;
+		}
+		predicted = true;
+	}
+
+	uint64_t cost_ns = os_monotonic_get_ns() - start_ns;
+
+	os_mutex_lock(&udp->stats_mutex);
+	if (!predicted) {
+		udp->stats.interpolated++;
+	} else if (!clamped) {
+		udp->stats.predicted++;
+	} else {
+		udp->stats.clamped++;
+	}
+	udp->stats.total_ns += cost_ns;
+	if (cost_ns > udp->stats.max_ns) {
+		udp->stats.max_ns = cost_ns;
+	}
+	os_mutex_unlock(&udp->stats_mutex);
+
+	return XRT_SUCCESS;
+}
+
+void
+u_device_poses_add_vars(struct u_device_poses *udp, void *root)
+{
+	u_var_add_gui_header(root, NULL, "Poses");
+	u_var_add_u64(root, &udp->config.max_prediction_ns, "Max prediction (ns)");
+	u_var_add_ro_u64(root, &udp->stats.interpolated, "Interpolated");
+	u_var_add_ro_u64(root, &udp->stats.predicted, "Predicted");
+	u_var_add_ro_u64(root, &udp->stats.clamped, "Clamped");
+	u_var_add_ro_u64(root, &udp->stats.invalid, "Invalid");
+	u_var_add_ro_u64(root, &udp->stats.total_ns, "Total get time (ns)");
+	u_var_add_ro_u64(root, &udp->stats.max_ns, "Max get time (ns)");
+}
+
+void
+u_device_poses_fini(struct u_device_poses *udp)
+{
+	for (uint32_t i = 0; i < udp->count; i++) {
+		m_relation_history_destroy(&udp->histories[i]);
+	}
+
+	free(udp->histories);
+	free(udp->names);
+	udp->histories = NULL;
+	udp->names = NULL;
+	udp->count = 0;
+
+	os_mutex_destroy(&udp->stats_mutex);
+}
@@ -0,0 +1,161 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Shared pose history and prediction for device drivers.
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_defines.h"
+
+#include "os/os_threading.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct m_relation_history;
+
+/*!
+ * How a pose is predicted past the newest one pushed.
+ *
+ * @ingroup aux_util
+ */
+enum u_device_poses_model
+{
+	//! Return the newest pose as is, for devices without usable velocities.
+	U_DEVICE_POSES_MODEL_NONE,
+
+	//! Extrapolate with the velocities of the newest pose.
+	U_DEVICE_POSES_MODEL_CONSTANT_VELOCITY,
+
+	/*!
+	 * Like constant velocity, but the linear acceleration is estimated
+	 * from the velocities of the poses in the history.
+	 */
+	U_DEVICE_POSES_MODEL_CONSTANT_ACCELERATION,
+};
+
+/*!
+ * Per device policy for @ref u_device_poses.
+ *
+ * @ingroup aux_util
+ */
+struct u_device_poses_config
+{
+	enum u_device_poses_model model;
+
+	/*!
+	 * Predictions further than this past the newest pose are clamped to
+	 * it, zero means no limit.
+	 */
+	uint64_t max_prediction_ns;
+};
+
+/*!
+ * Counters of how the poses have been returned, readable with u_var.
+ *
+ * @ingroup aux_util
+ */
+struct u_device_poses_stats
+{
+	//! Interpolated, or exactly matched, from the history.
+	uint64_t interpolated;
+
+	//! Predicted past the newest pose.
+	uint64_t predicted;
+
+	//! Predicted, but further than the limit so clamped.
+	uint64_t clamped;
+
+	//! Nothing pushed yet, or an unknown input.
+	uint64_t invalid;
+
+	//! Time spent in @ref u_device_poses_get, to find expensive devices.
+	uint64_t total_ns;
+	uint64_t max_ns;
+};
+
+/*!
+ * One relation history per pose input of a device, with a common policy for
+ * interpolating and predicting from them. Drivers push poses as they get them
+ * and implement @ref xrt_device::get_tracked_pose with @ref u_device_poses_get
+ * so every device behaves the same way.
+ *
+ * Pushing and getting is thread safe.
+ *
+ * @ingroup aux_util
+ */
+struct u_device_poses
+{
+	struct u_device_poses_config config;
+
+	//! Inputs with a pose, indexed the same as @ref histories.
+	enum xrt_input_name *names;
+	struct m_relation_history **histories;
+	uint32_t count;
+
+	//! Protects @ref stats.
+	struct os_mutex stats_mutex;
+	struct u_device_poses_stats stats;
+};
+
+/*!
+ * Creates a history for each of the given inputs, normally the pose inputs
+ * but hand tracking inputs can keep the pose of the hand root here too.
+ *
+ * @ingroup aux_util
+ */
+int
+u_device_poses_init(struct u_device_poses *udp,
+                    const struct u_device_poses_config *config,
+                    const enum xrt_input_name *names,
+                    uint32_t count);
+
+/*!
+ * Pushes a new pose of the input @p name, the velocities should be filled in
+ * and flagged as valid for the prediction models to use them.
+ *
+ * @ingroup aux_util
+ */
+void
+u_device_poses_push(struct u_device_poses *udp,
+                    enum xrt_input_name name,
+                    const struct xrt_space_relation *relation,
+                    uint64_t timestamp_ns);
+
+/*!
+ * Gets the pose of the input @p name at @p at_timestamp_ns, interpolated from
+ * the history or predicted with the configured model.
+ *
+ * @ingroup aux_util
+ */
+xrt_result_t
+u_device_poses_get(struct u_device_poses *udp,
+                   enum xrt_input_name name,
+                   uint64_t at_timestamp_ns,
+                   struct xrt_space_relation *out_relation);
+
+/*!
+ * Adds the config and stats to an existing u_var root.
+ *
+ * @ingroup aux_util
+ */
+void
+u_device_poses_add_vars(struct u_device_poses *udp, void *root);
+
+/*!
+ * Frees all histories, does not free @p udp itself.
+ *
+ * @ingroup aux_util
+ */
+void
+u_device_poses_fini(struct u_device_poses *udp);
+
+
+#ifdef __cplusplus
+}
+#endif
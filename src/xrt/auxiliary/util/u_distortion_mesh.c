@@ -8,32 +8,375 @@
  * @ingroup aux_distortion
  */
 
+#include "xrt/xrt_config_os.h"
+
 #include "util/u_misc.h"
+#include "util/u_file.h"
 #include "util/u_frame.h"
 #include "util/u_debug.h"
 #include "util/u_format.h"
+#include "util/u_worker.h"
+#include "util/u_logging.h"
 #include "util/u_distortion_mesh.h"
 
 #include "math/m_vec2.h"
 #include "math/m_api.h"
+#include "math/m_matrix_2x2.h"
 
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
+#include <inttypes.h>
 
 
 DEBUG_GET_ONCE_NUM_OPTION(mesh_size, "XRT_MESH_SIZE", 64)
+DEBUG_GET_ONCE_BOOL_OPTION(distortion_cache, "XRT_DISTORTION_CACHE", true)
+
+//! "MXDC" in little endian.
+#define CACHE_MAGIC (0x4344584d)
+#define CACHE_VERSION (1)
+
+//! Number of points along each side of the grid the distortion is fingerprinted with.
+#define PROBE_DIM (9)
+
+//! Number of rows given to a worker at a time.
+#define GRID_ROW_GRAIN (4)
+
+#define GRID_THREAD_COUNT (4)
 
 
 typedef bool (*func_calc)(struct xrt_device *xdev, uint32_t view, float u, float v, struct xrt_uv_triplet *result);
 
+/*
+ *
+ * Grid evaluation and on-disk cache.
+ *
+ */
+
+struct cache_header
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t key;
+	uint32_t cols;
+	uint32_t rows;
+	//! Hash of the results following the header.
+	uint64_t checksum;
+};
+
+/*!
+ * Everything the cache key is made from, zeroed before being filled in so the
+ * padding hashes the same every time.
+ */
+struct cache_key_data
+{
+	char str[XRT_DEVICE_NAME_LEN];
+	char serial[XRT_DEVICE_NAME_LEN];
+	uint32_t view;
+	uint32_t cols;
+	uint32_t rows;
+	bool has_rot;
+	struct xrt_matrix_2x2 rot;
+	struct xrt_uv_triplet probe[PROBE_DIM * PROBE_DIM];
+};
+
+struct grid_state
+{
+	struct xrt_device *xdev;
+	func_calc calc;
+	uint32_t view;
+	uint32_t cols;
+	uint32_t rows;
+	const struct xrt_matrix_2x2 *rot;
+	struct xrt_uv_triplet *results;
+	xrt_atomic_s32_t failed;
+};
+
+static struct xrt_vec2
+grid_point(const struct xrt_matrix_2x2 *rot, float u, float v)
+{
+	struct xrt_vec2 uv = {u, v};
+	if (rot == NULL) {
+		return uv;
+	}
+
+	// These need to go from -0.5 to 0.5 for the rotation
+	uv.x -= 0.5f;
+	uv.y -= 0.5f;
+	m_mat2x2_transform_vec2(rot, &uv, &uv);
+	uv.x += 0.5f;
+	uv.y += 0.5f;
+
+	return uv;
+}
+
+/*!
+ * Goes through @ref xrt_device_compute_distortion_batch when evaluating the
+ * device's own function, so devices that can batch, like over IPC, do so.
+ */
+static bool
+compute_points(const struct grid_state *gs, uint32_t count, const struct xrt_vec2 *uvs, struct xrt_uv_triplet *results)
+{
+	if (gs->calc == gs->xdev->compute_distortion) {
+		return xrt_device_compute_distortion_batch(gs->xdev, gs->view, count, uvs, results);
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		if (!gs->calc(gs->xdev, gs->view, uvs[i].x, uvs[i].y, &results[i])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void
+grid_rows_func(void *data, uint32_t begin, uint32_t end)
+{
+	struct grid_state *gs = (struct grid_state *)data;
+
+	uint32_t count = (end - begin) * gs->cols;
+	struct xrt_vec2 *uvs = U_TYPED_ARRAY_CALLOC(struct xrt_vec2, count);
+
+	uint32_t i = 0;
+	for (uint32_t r = begin; r < end; r++) {
+		// This goes from 0 to 1.0 inclusive.
+		float v = (float)r / (float)(gs->rows - 1);
+
+		for (uint32_t c = 0; c < gs->cols; c++) {
+			// This goes from 0 to 1.0 inclusive.
+			float u = (float)c / (float)(gs->cols - 1);
+
+			uvs[i++] = grid_point(gs->rot, u, v);
+		}
+	}
+
+	if (!compute_points(gs, count, uvs, &gs->results[begin * gs->cols])) {
+		xrt_atomic_s32_inc_return(&gs->failed);
+	}
+
+	free(uvs);
+}
+
+static bool
+compute_grid_parallel(struct grid_state *gs)
+{
+	// Not worth spinning up threads for.
+	if (gs->rows <= GRID_ROW_GRAIN) {
+		grid_rows_func(gs, 0, gs->rows);
+		return gs->failed == 0;
+	}
+
+	struct u_worker_thread_pool *pool =
+	    u_worker_thread_pool_create(GRID_THREAD_COUNT - 1, GRID_THREAD_COUNT, "Distortion", OS_THREAD_CORE_CLASS_ANY);
+	struct u_worker_group *group = pool != NULL ? u_worker_group_create(pool) : NULL;
+
+	if (group != NULL) {
+		u_worker_group_parallel_for(group, gs->rows, GRID_ROW_GRAIN, grid_rows_func, gs);
+	} else {
+		grid_rows_func(gs, 0, gs->rows);
+	}
+
+	u_worker_group_reference(&group, NULL);
+	u_worker_thread_pool_reference(&pool, NULL);
+
+	return gs->failed == 0;
+}
+
+/*!
+ * The key covers the distortion function through a sparse probe of it, which
+ * is cheap even when every call is a round trip, and is offset from the grid
+ * so it samples between the points that are cached.
+ */
+static bool
+make_cache_key(const struct grid_state *gs, uint64_t *out_key)
+{
+	struct cache_key_data data;
+	U_ZERO(&data);
+
+	snprintf(data.str, sizeof(data.str), "%s", gs->xdev->str);
+	snprintf(data.serial, sizeof(data.serial), "%s", gs->xdev->serial);
+	data.view = gs->view;
+	data.cols = gs->cols;
+	data.rows = gs->rows;
+	data.has_rot = gs->rot != NULL;
+	if (gs->rot != NULL) {
+		data.rot = *gs->rot;
+	}
+
+	struct xrt_vec2 uvs[PROBE_DIM * PROBE_DIM];
+	for (uint32_t r = 0; r < PROBE_DIM; r++) {
+		float v = ((float)r + 0.37f) / (float)PROBE_DIM;
+
+		for (uint32_t c = 0; c < PROBE_DIM; c++) {
+			float u = ((float)c + 0.61f) / (float)PROBE_DIM;
+
+			uvs[r * PROBE_DIM + c] = grid_point(gs->rot, u, v);
+		}
+	}
+
+	if (!compute_points(gs, PROBE_DIM * PROBE_DIM, uvs, data.probe)) {
+		return false;
+	}
+
+	*out_key = (uint64_t)math_hash_string((const char *)&data, sizeof(data));
+
+	return true;
+}
+
+#ifdef XRT_OS_LINUX
+static FILE *
+open_cache_file(uint64_t key, const char *mode)
+{
+	char filename[64];
+	snprintf(filename, sizeof(filename), "distortion_%016" PRIx64 ".bin", key);
+
+	return u_file_open_file_in_cache_dir(filename, mode);
+}
+
+static bool
+read_cache_file(uint64_t key, struct grid_state *gs)
+{
+	FILE *file = open_cache_file(key, "rb");
+	if (file == NULL) {
+		return false;
+	}
+
+	size_t count = (size_t)gs->cols * gs->rows;
+	struct cache_header header = {0};
+
+	bool ok = fread(&header, sizeof(header), 1, file) == 1 &&    //
+	          header.magic == CACHE_MAGIC &&                      //
+	          header.version == CACHE_VERSION &&                  //
+	          header.key == key &&                                //
+	          header.cols == gs->cols &&                          //
+	          header.rows == gs->rows &&                          //
+	          fread(gs->results, sizeof(*gs->results), count, file) == count;
+	fclose(file);
+
+	if (ok) {
+		uint64_t checksum = math_hash_string((const char *)gs->results, count * sizeof(*gs->results));
+		ok = checksum == header.checksum;
+	}
+
+	if (!ok) {
+		U_LOG_W("Distortion cache for key %016" PRIx64 " is corrupt or stale, ignoring", key);
+	}
+
+	return ok;
+}
+
+static void
+write_cache_file(uint64_t key, const struct grid_state *gs)
+{
+	FILE *file = open_cache_file(key, "wb");
+	if (file == NULL) {
+		return;
+	}
+
+	size_t count = (size_t)gs->cols * gs->rows;
+	struct cache_header header = {
+	    .magic = CACHE_MAGIC,
+	    .version = CACHE_VERSION,
+	    .key = key,
+	    .cols = gs->cols,
+	    .rows = gs->rows,
+	    .checksum = math_hash_string((const char *)gs->results, count * sizeof(*gs->results)),
+	};
+
+	if (fwrite(&header, sizeof(header), 1, file) != 1 ||
+	    fwrite(gs->results, sizeof(*gs->results), count, file) != count) {
+		U_LOG_W("Failed to write distortion cache for key %016" PRIx64, key);
+	}
+
+	fclose(file);
+}
+#else
+static bool
+read_cache_file(uint64_t key, struct grid_state *gs)
+{
+	return false;
+}
+
+static void
+write_cache_file(uint64_t key, const struct grid_state *gs)
+{}
+#endif
+
+static bool
+compute_grid(struct xrt_device *xdev,
+             func_calc calc,
+             uint32_t view,
+             uint32_t cols,
+             uint32_t rows,
+             const struct xrt_matrix_2x2 *rot,
+             bool use_cache,
+             struct xrt_uv_triplet *out_results)
+{
+	assert(calc != NULL);
+	assert(cols >= 2 && rows >= 2);
+
+	struct grid_state gs = {
+	    .xdev = xdev,
+	    .calc = calc,
+	    .view = view,
+	    .cols = cols,
+	    .rows = rows,
+	    .rot = rot,
+	    .results = out_results,
+	    .failed = 0,
+	};
+
+	uint64_t key = 0;
+	if (use_cache && !make_cache_key(&gs, &key)) {
+		return false;
+	}
+
+	if (use_cache && read_cache_file(key, &gs)) {
+		U_LOG_D("Loaded distortion of view %u from cache (key %016" PRIx64 ")", view, key);
+		return true;
+	}
+
+	if (!compute_grid_parallel(&gs)) {
+		return false;
+	}
+
+	if (use_cache) {
+		write_cache_file(key, &gs);
+	}
+
+	return true;
+}
+
+bool
+u_distortion_mesh_compute_grid(struct xrt_device *xdev,
+                               uint32_t view,
+                               uint32_t cols,
+                               uint32_t rows,
+                               const struct xrt_matrix_2x2 *rot,
+                               struct xrt_uv_triplet *out_results)
+{
+	bool use_cache = debug_get_bool_option_distortion_cache();
+
+	return compute_grid(xdev, xdev->compute_distortion, view, cols, rows, rot, use_cache, out_results);
+}
+
 static int
 index_for(int row, int col, uint32_t stride, uint32_t offset)
 {
 	return row * stride + col + offset;
 }
 
+static bool
+is_single_channel(const struct xrt_uv_triplet *result)
+{
+	return result->r.x == result->g.x && result->r.y == result->g.y && //
+	       result->b.x == result->g.x && result->b.y == result->g.y;
+}
+
 static void
-run_func(struct xrt_device *xdev, func_calc calc, int view_count, struct xrt_hmd_parts *target, uint32_t num)
+run_func(
+    struct xrt_device *xdev, func_calc calc, int view_count, struct xrt_hmd_parts *target, uint32_t num, bool use_cache)
 {
 	assert(calc != NULL);
 	assert(view_count == 2);
@@ -55,12 +398,22 @@ run_func(struct xrt_device *xdev, func_calc calc, int view_count, struct xrt_hmd
 	uint32_t float_count = vertex_count * stride_in_floats;
 
 	float *verts = U_TYPED_ARRAY_CALLOC(float, float_count);
+	struct xrt_uv_triplet *results = U_TYPED_ARRAY_CALLOC(struct xrt_uv_triplet, vertex_count_per_view);
+	bool single_channel = true;
 
 	// Setup the vertices for all views.
 	uint32_t i = 0;
 	for (int view = 0; view < view_count; view++) {
 		vertex_offsets[view] = i / stride_in_floats;
 
+		if (!compute_grid(xdev, calc, view, vert_cols, vert_rows, NULL, use_cache, results)) {
+			// bail on error, without updating
+			// distortion.preferred
+			free(results);
+			free(verts);
+			return;
+		}
+
 		for (uint32_t r = 0; r < vert_rows; r++) {
 			// This goes from 0 to 1.0 inclusive.
 			float v = (float)r / (float)cells_rows;
@@ -73,17 +426,18 @@ run_func(struct xrt_device *xdev, func_calc calc, int view_count, struct xrt_hmd
 				verts[i + 0] = u * 2.0f - 1.0f;
 				verts[i + 1] = v * 2.0f - 1.0f;
 
-				if (!calc(xdev, view, u, v, (struct xrt_uv_triplet *)&verts[i + 2])) {
-					// bail on error, without updating
-					// distortion.preferred
-					return;
-				}
+				const struct xrt_uv_triplet *result = &results[r * vert_cols + c];
+				memcpy(&verts[i + 2], result, sizeof(*results));
+
+				single_channel = single_channel && is_single_channel(result);
 
 				i += stride_in_floats;
 			}
 		}
 	}
 
+	free(results);
+
 	uint32_t index_count_per_view = cells_rows * (vert_cols * 2 + 2);
 	uint32_t index_count_total = index_count_per_view * view_count;
 	int *indices = U_TYPED_ARRAY_CALLOC(int, index_count_total);
@@ -115,6 +469,7 @@ run_func(struct xrt_device *xdev, func_calc calc, int view_count, struct xrt_hmd
 	target->distortion.mesh.stride = stride_in_floats * sizeof(float);
 	target->distortion.mesh.vertex_count = vertex_count;
 	target->distortion.mesh.uv_channels_count = uv_channels_count;
+	target->distortion.single_channel = single_channel;
 	target->distortion.mesh.indices = indices;
 	target->distortion.mesh.index_counts[0] = index_count_per_view;
 	target->distortion.mesh.index_counts[1] = index_count_per_view;
@@ -184,6 +539,23 @@ u_compute_distortion_vive(struct u_vive_values *values, float u, float v, struct
 	return true;
 }
 
+void
+u_distortion_set_analytic_vive(struct xrt_device *xdev, uint32_t view, const struct u_vive_values *values)
+{
+	struct xrt_distortion_vive *p = &xdev->hmd->distortion.analytic.views[view].vive;
+
+	p->aspect_x_over_y = values->aspect_x_over_y;
+	p->grow_for_undistort = values->grow_for_undistort;
+	for (uint32_t i = 0; i < 3; i++) {
+		p->center[i] = values->center[i];
+		for (uint32_t k = 0; k < 4; k++) {
+			p->coefficients[i][k] = values->coefficients[i][k];
+		}
+	}
+
+	xdev->hmd->distortion.analytic.model = XRT_DISTORTION_ANALYTIC_MODEL_VIVE;
+}
+
 
 #define mul m_vec2_mul
 #define mul_scalar m_vec2_mul_scalar
@@ -232,6 +604,24 @@ u_compute_distortion_panotools(struct u_panotools_values *values, float u, float
 	return true;
 }
 
+void
+u_distortion_set_analytic_panotools(struct xrt_device *xdev, uint32_t view, const struct u_panotools_values *values)
+{
+	struct xrt_distortion_panotools *p = &xdev->hmd->distortion.analytic.views[view].panotools;
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(p->distortion_k); i++) {
+		p->distortion_k[i] = values->distortion_k[i];
+	}
+	for (uint32_t i = 0; i < ARRAY_SIZE(p->aberration_k); i++) {
+		p->aberration_k[i] = values->aberration_k[i];
+	}
+	p->scale = values->scale;
+	p->lens_center = values->lens_center;
+	p->viewport_size = values->viewport_size;
+
+	xdev->hmd->distortion.analytic.model = XRT_DISTORTION_ANALYTIC_MODEL_PANOTOOLS;
+}
+
 bool
 u_compute_distortion_cardboard(struct u_cardboard_distortion_values *values,
                                float u,
@@ -437,7 +827,7 @@ u_distortion_mesh_fill_in_none(struct xrt_device *xdev)
 	struct xrt_hmd_parts *target = xdev->hmd;
 
 	// Do the generation.
-	run_func(xdev, u_distortion_mesh_none, 2, target, 1);
+	run_func(xdev, u_distortion_mesh_none, 2, target, 1, false);
 
 	// Make the target mostly usable.
 	target->distortion.models |= XRT_DISTORTION_MODEL_NONE;
@@ -457,6 +847,7 @@ u_distortion_mesh_set_none(struct xrt_device *xdev)
 
 	// Make sure that the xdev implements the compute_distortion function.
 	xdev->compute_distortion = u_distortion_mesh_none;
+	target->distortion.analytic.model = XRT_DISTORTION_ANALYTIC_MODEL_IDENTITY;
 
 	// Make the target completely usable.
 	target->distortion.models |= XRT_DISTORTION_MODEL_COMPUTE;
@@ -481,5 +872,5 @@ u_distortion_mesh_fill_in_compute(struct xrt_device *xdev)
 	struct xrt_hmd_parts *target = xdev->hmd;
 
 	uint32_t num = (uint32_t)debug_get_num_option_mesh_size();
-	run_func(xdev, calc, 2, target, num);
+	run_func(xdev, calc, 2, target, num, debug_get_bool_option_distortion_cache());
 }
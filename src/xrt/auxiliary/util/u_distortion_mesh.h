@@ -54,6 +54,16 @@ struct u_panotools_values
 bool
 u_compute_distortion_panotools(struct u_panotools_values *values, float u, float v, struct xrt_uv_triplet *result);
 
+/*!
+ * Describe the distortion of @p view as panotools values, so the compositor
+ * can evaluate it in its shaders, the device's compute function must call
+ * @ref u_compute_distortion_panotools with the same values.
+ *
+ * @ingroup aux_distortion
+ */
+void
+u_distortion_set_analytic_panotools(struct xrt_device *xdev, uint32_t view, const struct u_panotools_values *values);
+
 
 /*
  *
@@ -89,6 +99,16 @@ struct u_vive_values
 bool
 u_compute_distortion_vive(struct u_vive_values *values, float u, float v, struct xrt_uv_triplet *result);
 
+/*!
+ * Describe the distortion of @p view as Vive values, so the compositor can
+ * evaluate it in its shaders, the device's compute function must call
+ * @ref u_compute_distortion_vive with the same values.
+ *
+ * @ingroup aux_distortion
+ */
+void
+u_distortion_set_analytic_vive(struct xrt_device *xdev, uint32_t view, const struct u_vive_values *values);
+
 
 /*
  *
@@ -187,6 +207,30 @@ u_distortion_mesh_none(struct xrt_device *xdev, uint32_t view, float u, float v,
  *
  */
 
+/*!
+ * Evaluates `xdev->compute_distortion()` for @p view on a grid of @p cols by
+ * @p rows points, u and v going from 0 to 1 inclusive. If @p rot is not NULL
+ * the points are rotated by it around the centre before being evaluated.
+ *
+ * The grid is split up over a worker pool and the results are cached on disk,
+ * keyed by a hash of the device, the grid and the distortion function sampled
+ * at a few points, so an unchanged calibration is only evaluated fully once.
+ * Set `XRT_DISTORTION_CACHE=false` to always evaluate it.
+ *
+ * @param out_results Array of @p cols times @p rows triplets, row major.
+ * @return False if `xdev->compute_distortion()` failed for any point.
+ *
+ * @relatesalso xrt_device
+ * @ingroup aux_distortion
+ */
+bool
+u_distortion_mesh_compute_grid(struct xrt_device *xdev,
+                               uint32_t view,
+                               uint32_t cols,
+                               uint32_t rows,
+                               const struct xrt_matrix_2x2 *rot,
+                               struct xrt_uv_triplet *out_results);
+
 /*!
  * Given a @ref xrt_device generates meshes by calling
  * xdev->compute_distortion(), populates `xdev->hmd_parts.distortion.mesh` &
@@ -211,7 +255,8 @@ u_distortion_mesh_fill_in_none(struct xrt_device *xdev);
 /*!
  * Given a @ref xrt_device generates a no distortion mesh, also sets
  * `xdev->compute_distortion()` and populates `xdev->hmd_parts.distortion.mesh`
- * & `xdev->hmd_parts.distortion.models`.
+ * & `xdev->hmd_parts.distortion.models`. The analytic model is set to
+ * identity, reset it if replacing `xdev->compute_distortion()` afterwards.
  *
  * @relatesalso xrt_device
  * @ingroup aux_distortion
@@ -0,0 +1,216 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Open addressing hash map, used to implement the C hashmap and hashset.
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+
+namespace xrt::auxiliary::util {
+
+/*!
+ * Hash for integer keys, most keys are pointers or handles whose low bits are
+ * all the same, so mix them into all bits before they pick a slot.
+ *
+ * @ingroup aux_util
+ */
+struct IntegerHash
+{
+	size_t
+	operator()(uint64_t x) const noexcept
+	{
+		// Finalizer of splitmix64.
+		x = (x ^ (x >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+		x = (x ^ (x >> 27)) * UINT64_C(0x94d049bb133111eb);
+		return (size_t)(x ^ (x >> 31));
+	}
+};
+
+/*!
+ * Hash map that keeps all entries in a single array and resolves collisions
+ * with linear probing, so a lookup is usually one cache line and inserting
+ * only allocates when the table grows. Erasing shifts the following entries
+ * back instead of leaving tombstones, which keeps probe sequences short.
+ *
+ * Keys and values are stored by value and must be cheap to copy, like
+ * integers, pointers or views. Pointers to values are invalidated by any
+ * insert or erase.
+ *
+ * @ingroup aux_util
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename Equal = std::equal_to<Key>>
+class FlatHashMap
+{
+public:
+	/*!
+	 * Value stored for @p key, or nullptr if there is none.
+	 */
+	Value *
+	find(const Key &key)
+	{
+		if (mCount == 0) {
+			return nullptr;
+		}
+
+		size_t i = findIndex(key, tag(Hash{}(key)));
+		return mSlots[i].hash != 0 ? &mSlots[i].value : nullptr;
+	}
+
+	/*!
+	 * Inserts @p key, or replaces both the key and the value if it's already
+	 * in the map, like `map[key] = value` but also storing the new key.
+	 */
+	void
+	insertOrAssign(const Key &key, Value value)
+	{
+		if ((mCount + 1) * 8 > mSlots.size() * 7) {
+			grow();
+		}
+
+		size_t hash = tag(Hash{}(key));
+		size_t i = findIndex(key, hash);
+
+		if (mSlots[i].hash == 0) {
+			mCount++;
+		}
+
+		mSlots[i] = Slot{hash, key, value};
+	}
+
+	/*!
+	 * Returns true if @p key was in the map.
+	 */
+	bool
+	erase(const Key &key)
+	{
+		if (mCount == 0) {
+			return false;
+		}
+
+		size_t i = findIndex(key, tag(Hash{}(key)));
+		if (mSlots[i].hash == 0) {
+			return false;
+		}
+
+		// Shift back any entry that can't be found anymore with the hole at i.
+		size_t mask = mSlots.size() - 1;
+		for (size_t j = (i + 1) & mask; mSlots[j].hash != 0; j = (j + 1) & mask) {
+			size_t home = mSlots[j].hash & mask;
+			if (((j - home) & mask) >= ((j - i) & mask)) {
+				mSlots[i] = mSlots[j];
+				i = j;
+			}
+		}
+
+		mSlots[i] = Slot{};
+		mCount--;
+
+		return true;
+	}
+
+	size_t
+	size() const noexcept
+	{
+		return mCount;
+	}
+
+	bool
+	empty() const noexcept
+	{
+		return mCount == 0;
+	}
+
+	/*!
+	 * Removes all entries, keeps the memory.
+	 */
+	void
+	clear()
+	{
+		for (Slot &s : mSlots) {
+			s = Slot{};
+		}
+		mCount = 0;
+	}
+
+	/*!
+	 * Calls @p func with every key and value, in no particular order.
+	 */
+	template <typename Func>
+	void
+	forEach(Func &&func) const
+	{
+		for (const Slot &s : mSlots) {
+			if (s.hash != 0) {
+				func(s.key, s.value);
+			}
+		}
+	}
+
+private:
+	static_assert(std::is_trivially_copyable<Key>::value, "Keys are moved around with plain copies");
+	static_assert(std::is_trivially_copyable<Value>::value, "Values are moved around with plain copies");
+
+	//! Set on the stored hash of every used slot, so zero means empty.
+	static constexpr size_t kUsedBit = (size_t)1 << (sizeof(size_t) * 8 - 1);
+
+	struct Slot
+	{
+		size_t hash;
+		Key key;
+		Value value;
+	};
+
+	std::vector<Slot> mSlots = {};
+	size_t mCount = 0;
+
+	static size_t
+	tag(size_t hash) noexcept
+	{
+		return hash | kUsedBit;
+	}
+
+	//! Slot holding @p key, or the empty slot where it would go.
+	size_t
+	findIndex(const Key &key, size_t hash) const
+	{
+		size_t mask = mSlots.size() - 1;
+		size_t i = hash & mask;
+
+		while (mSlots[i].hash != 0 && !(mSlots[i].hash == hash && Equal{}(mSlots[i].key, key))) {
+			i = (i + 1) & mask;
+		}
+
+		return i;
+	}
+
+	void
+	grow()
+	{
+		std::vector<Slot> old = std::move(mSlots);
+		mSlots = std::vector<Slot>(old.empty() ? 16 : old.size() * 2, Slot{});
+
+		size_t mask = mSlots.size() - 1;
+		for (const Slot &s : old) {
+			if (s.hash == 0) {
+				continue;
+			}
+
+			size_t i = s.hash & mask;
+			while (mSlots[i].hash != 0) {
+				i = (i + 1) & mask;
+			}
+			mSlots[i] = s;
+		}
+	}
+};
+
+} // namespace xrt::auxiliary::util
@@ -0,0 +1,703 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Row based pixel format conversion, with SIMD implementations.
+ *
+ * The x86 kernels are compiled with per function target attributes and picked
+ * at runtime, so the rest of the code base doesn't need any special flags.
+ *
+ * @ingroup aux_util
+ */
+
+#include "os/os_threading.h"
+
+#include "util/u_debug.h"
+#include "util/u_logging.h"
+#include "util/u_format_convert.h"
+
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define U_FORMAT_CONVERT_HAVE_X86
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#define U_FORMAT_CONVERT_HAVE_NEON
+#endif
+
+
+DEBUG_GET_ONCE_OPTION(format_convert_impl, "U_FORMAT_CONVERT_IMPL", NULL)
+
+typedef void (*row_func_t)(const uint8_t *src, uint8_t *dst, uint32_t width);
+
+struct kernels
+{
+	row_func_t yuyv422_to_r8g8b8;
+	row_func_t uyvy422_to_r8g8b8;
+	row_func_t yuv888_to_r8g8b8;
+	row_func_t yuyv422_to_l8;
+	row_func_t l8_to_r8g8b8;
+};
+
+
+/*
+ *
+ * Scalar kernels.
+ *
+ */
+
+static void
+scalar_yuyv422_to_r8g8b8(const uint8_t *src, uint8_t *dst, uint32_t width)
+{
+	uint32_t x = 0;
+	for (; x + 1 < width; x += 2) {
+		u_format_convert_yuv_to_rgb(src[0], src[1], src[3], dst + 0);
+		u_format_convert_yuv_to_rgb(src[2], src[1], src[3], dst + 3);
+		src += 4;
+		dst += 6;
+	}
+
+	// The last block is always complete in the source.
+	if (x < width) {
+		u_format_convert_yuv_to_rgb(src[0], src[1], src[3], dst);
+	}
+}
+
+static void
+scalar_uyvy422_to_r8g8b8(const uint8_t *src, uint8_t *dst, uint32_t width)
+{
+	uint32_t x = 0;
+	for (; x + 1 < width; x += 2) {
+		u_format_convert_yuv_to_rgb(src[1], src[0], src[2], dst + 0);
+		u_format_convert_yuv_to_rgb(src[3], src[0], src[2], dst + 3);
+		src += 4;
+		dst += 6;
+	}
+
+	if (x < width) {
+		u_format_convert_yuv_to_rgb(src[1], src[0], src[2], dst);
+	}
+}
+
+static void
+scalar_yuv888_to_r8g8b8(const uint8_t *src, uint8_t *dst, uint32_t width)
+{
+	for (uint32_t x = 0; x < width; x++) {
+		u_format_convert_yuv_to_rgb(src[0], src[1], src[2], dst);
+		src += 3;
+		dst += 3;
+	}
+}
+
+static void
+scalar_yuyv422_to_l8(const uint8_t *src, uint8_t *dst, uint32_t width)
+{
+	for (uint32_t x = 0; x < width; x++) {
+		dst[x] = src[x * 2];
+	}
+}
+
+static void
+scalar_l8_to_r8g8b8(const uint8_t *src, uint8_t *dst, uint32_t width)
+{
+	for (uint32_t x = 0; x < width; x++) {
+		dst[x * 3 + 0] = src[x];
+		dst[x * 3 + 1] = src[x];
+		dst[x * 3 + 2] = src[x];
+	}
+}
+
+static const struct kernels scalar_kernels = {
+    .yuyv422_to_r8g8b8 = scalar_yuyv422_to_r8g8b8,
+    .uyvy422_to_r8g8b8 = scalar_uyvy422_to_r8g8b8,
+    .yuv888_to_r8g8b8 = scalar_yuv888_to_r8g8b8,
+    .yuyv422_to_l8 = scalar_yuyv422_to_l8,
+    .l8_to_r8g8b8 = scalar_l8_to_r8g8b8,
+};
+
+
+/*
+ *
+ * SSSE3 kernels.
+ *
+ */
+
+#ifdef U_FORMAT_CONVERT_HAVE_X86
+
+/*!
+ * Does (a0 * k0 + a1 * k1 + 128) >> 8 on interleaved 16 bit pairs, exact
+ * same math as the scalar code.
+ */
+TARGET_SSSE3 static inline __m128i
+ssse3_madd_shift(__m128i a, __m128i k)
+{
+	return _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(a, k), _mm_set1_epi32(128)), 8);
+}
+
+/*!
+ * Converts 8 pixels of 16 bit y, u and v values.
+ */
+TARGET_SSSE3 static inline void
+ssse3_yuv_to_rgb_x8(__m128i y, __m128i u, __m128i v, uint8_t *dst)
+{
+	const __m128i k_r_ce = _mm_setr_epi16(298, 409, 298, 409, 298, 409, 298, 409);
+	const __m128i k_g_cd = _mm_setr_epi16(298, -100, 298, -100, 298, -100, 298, -100);
+	const __m128i k_g_ce = _mm_setr_epi16(0, -209, 0, -209, 0, -209, 0, -209);
+	const __m128i k_b_cd = _mm_setr_epi16(298, 516, 298, 516, 298, 516, 298, 516);
+
+	__m128i c = _mm_sub_epi16(y, _mm_set1_epi16(16));
+	__m128i d = _mm_sub_epi16(u, _mm_set1_epi16(128));
+	__m128i e = _mm_sub_epi16(v, _mm_set1_epi16(128));
+
+	__m128i cd_lo = _mm_unpacklo_epi16(c, d);
+	__m128i cd_hi = _mm_unpackhi_epi16(c, d);
+	__m128i ce_lo = _mm_unpacklo_epi16(c, e);
+	__m128i ce_hi = _mm_unpackhi_epi16(c, e);
+
+	__m128i r_lo = ssse3_madd_shift(ce_lo, k_r_ce);
+	__m128i r_hi = ssse3_madd_shift(ce_hi, k_r_ce);
+	__m128i b_lo = ssse3_madd_shift(cd_lo, k_b_cd);
+	__m128i b_hi = ssse3_madd_shift(cd_hi, k_b_cd);
+
+	// Only round once, the 128 is in the first term.
+	__m128i g_lo = _mm_add_epi32(_mm_madd_epi16(cd_lo, k_g_cd), _mm_madd_epi16(ce_lo, k_g_ce));
+	__m128i g_hi = _mm_add_epi32(_mm_madd_epi16(cd_hi, k_g_cd), _mm_madd_epi16(ce_hi, k_g_ce));
+	g_lo = _mm_srai_epi32(_mm_add_epi32(g_lo, _mm_set1_epi32(128)), 8);
+	g_hi = _mm_srai_epi32(_mm_add_epi32(g_hi, _mm_set1_epi32(128)), 8);
+
+	// The saturating packs do the clamping.
+	__m128i rg = _mm_packus_epi16(_mm_packs_epi32(r_lo, r_hi), _mm_packs_epi32(g_lo, g_hi));
+	__m128i bb = _mm_packs_epi32(b_lo, b_hi);
+	bb = _mm_packus_epi16(bb, bb);
+
+	// rg is r0-r7 g0-g7 and bb is b0-b7, interleave into 24 bytes.
+	const __m128i m_rg0 = _mm_setr_epi8(0, 8, -1, 1, 9, -1, 2, 10, -1, 3, 11, -1, 4, 12, -1, 5);
+	const __m128i m_b0 = _mm_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1);
+	const __m128i m_rg1 = _mm_setr_epi8(13, -1, 6, 14, -1, 7, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i m_b1 = _mm_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, -1, -1, -1, -1, -1, -1);
+
+	__m128i out0 = _mm_or_si128(_mm_shuffle_epi8(rg, m_rg0), _mm_shuffle_epi8(bb, m_b0));
+	__m128i out1 = _mm_or_si128(_mm_shuffle_epi8(rg, m_rg1), _mm_shuffle_epi8(bb, m_b1));
+
+	_mm_storeu_si128((__m128i *)dst, out0);
+	_mm_storel_epi64((__m128i *)(dst + 16), out1);
+}
+
+/*!
+ * Splits 8 pixels of packed 422 into y and per pixel u and v, @p luma_high
+ * selects between YUYV and UYVY.
+ */
+TARGET_SSSE3 static inline void
+ssse3_split_422(__m128i in, bool luma_high, __m128i *out_y, __m128i *out_u, __m128i *out_v)
+{
+	const __m128i m_u = _mm_setr_epi8(0, 1, 0, 1, 4, 5, 4, 5, 8, 9, 8, 9, 12, 13, 12, 13);
+	const __m128i m_v = _mm_setr_epi8(2, 3, 2, 3, 6, 7, 6, 7, 10, 11, 10, 11, 14, 15, 14, 15);
+	const __m128i low = _mm_set1_epi16(0x00FF);
+
+	__m128i y = luma_high ? _mm_srli_epi16(in, 8) : _mm_and_si128(in, low);
+	__m128i uv = luma_high ? _mm_and_si128(in, low) : _mm_srli_epi16(in, 8);
+
+	*out_y = y;
+	*out_u = _mm_shuffle_epi8(uv, m_u);
+	*out_v = _mm_shuffle_epi8(uv, m_v);
+}
+
+TARGET_SSSE3 static void
+ssse3_yuyv422_to_r8g8b8(const uint8_t *src, uint8_t *dst, uint32_t width)
+{
+	uint32_t x = 0;
+	for (; x + 8 <= width; x += 8) {
+		__m128i y, u, v;
+		ssse3_split_422(_mm_loadu_si128((const __m128i *)src), false, &y, &u, &v);
+		ssse3_yuv_to_rgb_x8(y, u, v, dst);
+		src += 16;
+		dst += 24;
+	}
+
+	scalar_yuyv422_to_r8g8b8(src, dst, width - x);
+}
+
+TARGET_SSSE3 static void
+ssse3_uyvy422_to_r8g8b8(const uint8_t *src, uint8_t *dst, uint32_t width)
+{
+	uint32_t x = 0;
+	for (; x + 8 <= width; x += 8) {
+		__m128i y, u, v;
+		ssse3_split_422(_mm_loadu_si128((const __m128i *)src), true, &y, &u, &v);
+		ssse3_yuv_to_rgb_x8(y, u, v, dst);
+		src += 16;
+		dst += 24;
+	}
+
+	scalar_uyvy422_to_r8g8b8(src, dst, width - x);
+}
+
+TARGET_SSSE3 static void
+ssse3_yuyv422_to_l8(const uint8_t *src, uint8_t *dst, uint32_t width)
+{
+	const __m128i low = _mm_set1_epi16(0x00FF);
+
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		__m128i a = _mm_and_si128(_mm_loadu_si128((const __m128i *)(src + 0)), low);
+		__m128i b = _mm_and_si128(_mm_loadu_si128((const __m128i *)(src + 16)), low);
+		_mm_storeu_si128((__m128i *)dst, _mm_packus_epi16(a, b));
+		src += 32;
+		dst += 16;
+	}
+
+	scalar_yuyv422_to_l8(src, dst, width - x);
+}
+
+TARGET_SSSE3 static void
+ssse3_l8_to_r8g8b8(const uint8_t *src, uint8_t *dst, uint32_t width)
+{
+	const __m128i m0 = _mm_setr_epi8(0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 5);
+	const __m128i m1 = _mm_setr_epi8(5, 5, 6, 6, 6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10);
+	const __m128i m2 = _mm_setr_epi8(10, 11, 11, 11, 12, 12, 12, 13, 13, 13, 14, 14, 14, 15, 15, 15);
+
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		__m128i l = _mm_loadu_si128((const __m128i *)src);
+		_mm_storeu_si128((__m128i *)(dst + 0), _mm_shuffle_epi8(l, m0));
+		_mm_storeu_si128((__m128i *)(dst + 16), _mm_shuffle_epi8(l, m1));
+		_mm_storeu_si128((__m128i *)(dst + 32), _mm_shuffle_epi8(l, m2));
+		src += 16;
+		dst += 48;
+	}
+
+	scalar_l8_to_r8g8b8(src, dst, width - x);
+}
+
+static const struct kernels ssse3_kernels = {
+    .yuyv422_to_r8g8b8 = ssse3_yuyv422_to_r8g8b8,
+    .uyvy422_to_r8g8b8 = ssse3_uyvy422_to_r8g8b8,
+    .yuv888_to_r8g8b8 = scalar_yuv888_to_r8g8b8,
+    .yuyv422_to_l8 = ssse3_yuyv422_to_l8,
+    .l8_to_r8g8b8 = ssse3_l8_to_r8g8b8,
+};
+
+
+/*
+ *
+ * AVX2 kernels.
+ *
+ */
+
+TARGET_AVX2 static inline __m256i
+avx2_madd_shift(__m256i a, __m256i k)
+{
+	return _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(a, k), _mm256_set1_epi32(128)), 8);
+}
+
+/*!
+ * Same as the SSSE3 version but on 16 pixels, each 128 bit lane holds 8
+ * consecutive pixels, which the in-lane unpack and pack instructions keep.
+ */
+TARGET_AVX2 static inline void
+avx2_yuv422_to_rgb_x16(__m256i in, bool luma_high, uint8_t *dst)
+{
+	const __m256i m_u = _mm256_setr_epi8(0, 1, 0, 1, 4, 5, 4, 5, 8, 9, 8, 9, 12, 13, 12, 13, //
+	                                     0, 1, 0, 1, 4, 5, 4, 5, 8, 9, 8, 9, 12, 13, 12, 13);
+	const __m256i m_v = _mm256_setr_epi8(2, 3, 2, 3, 6, 7, 6, 7, 10, 11, 10, 11, 14, 15, 14, 15, //
+	                                     2, 3, 2, 3, 6, 7, 6, 7, 10, 11, 10, 11, 14, 15, 14, 15);
+	const __m256i low = _mm256_set1_epi16(0x00FF);
+
+	__m256i y = luma_high ? _mm256_srli_epi16(in, 8) : _mm256_and_si256(in, low);
+	__m256i uv = luma_high ? _mm256_and_si256(in, low) : _mm256_srli_epi16(in, 8);
+
+	__m256i c = _mm256_sub_epi16(y, _mm256_set1_epi16(16));
+	__m256i d = _mm256_sub_epi16(_mm256_shuffle_epi8(uv, m_u), _mm256_set1_epi16(128));
+	__m256i e = _mm256_sub_epi16(_mm256_shuffle_epi8(uv, m_v), _mm256_set1_epi16(128));
+
+	const __m256i k_r_ce = _mm256_set1_epi32((409 << 16) | 298);
+	const __m256i k_g_cd = _mm256_set1_epi32((int32_t)(((uint32_t)(uint16_t)-100 << 16) | 298));
+	const __m256i k_g_ce = _mm256_set1_epi32((int32_t)((uint32_t)(uint16_t)-209 << 16));
+	const __m256i k_b_cd = _mm256_set1_epi32((516 << 16) | 298);
+
+	__m256i cd_lo = _mm256_unpacklo_epi16(c, d);
+	__m256i cd_hi = _mm256_unpackhi_epi16(c, d);
+	__m256i ce_lo = _mm256_unpacklo_epi16(c, e);
+	__m256i ce_hi = _mm256_unpackhi_epi16(c, e);
+
+	__m256i r_lo = avx2_madd_shift(ce_lo, k_r_ce);
+	__m256i r_hi = avx2_madd_shift(ce_hi, k_r_ce);
+	__m256i b_lo = avx2_madd_shift(cd_lo, k_b_cd);
+	__m256i b_hi = avx2_madd_shift(cd_hi, k_b_cd);
+
+	__m256i g_lo = _mm256_add_epi32(_mm256_madd_epi16(cd_lo, k_g_cd), _mm256_madd_epi16(ce_lo, k_g_ce));
+	__m256i g_hi = _mm256_add_epi32(_mm256_madd_epi16(cd_hi, k_g_cd), _mm256_madd_epi16(ce_hi, k_g_ce));
+	g_lo = _mm256_srai_epi32(_mm256_add_epi32(g_lo, _mm256_set1_epi32(128)), 8);
+	g_hi = _mm256_srai_epi32(_mm256_add_epi32(g_hi, _mm256_set1_epi32(128)), 8);
+
+	__m256i rg = _mm256_packus_epi16(_mm256_packs_epi32(r_lo, r_hi), _mm256_packs_epi32(g_lo, g_hi));
+	__m256i bb = _mm256_packs_epi32(b_lo, b_hi);
+	bb = _mm256_packus_epi16(bb, bb);
+
+	const __m256i m_rg0 = _mm256_setr_epi8(0, 8, -1, 1, 9, -1, 2, 10, -1, 3, 11, -1, 4, 12, -1, 5, //
+	                                       0, 8, -1, 1, 9, -1, 2, 10, -1, 3, 11, -1, 4, 12, -1, 5);
+	const __m256i m_b0 = _mm256_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, //
+	                                      -1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1);
+	const __m256i m_rg1 = _mm256_setr_epi8(13, -1, 6, 14, -1, 7, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, //
+	                                       13, -1, 6, 14, -1, 7, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m256i m_b1 = _mm256_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, -1, -1, -1, -1, -1, -1, //
+	                                      -1, 5, -1, -1, 6, -1, -1, 7, -1, -1, -1, -1, -1, -1, -1, -1);
+
+	__m256i out0 = _mm256_or_si256(_mm256_shuffle_epi8(rg, m_rg0), _mm256_shuffle_epi8(bb, m_b0));
+	__m256i out1 = _mm256_or_si256(_mm256_shuffle_epi8(rg, m_rg1), _mm256_shuffle_epi8(bb, m_b1));
+
+	_mm_storeu_si128((__m128i *)(dst + 0), _mm256_castsi256_si128(out0));
+	_mm_storel_epi64((__m128i *)(dst + 16), _mm256_castsi256_si128(out1));
+	_mm_storeu_si128((__m128i *)(dst + 24), _mm256_extracti128_si256(out0, 1));
+	_mm_storel_epi64((__m128i *)(dst + 40), _mm256_extracti128_si256(out1, 1));
+}
+
+TARGET_AVX2 static void
+avx2_yuyv422_to_r8g8b8(const uint8_t *src, uint8_t *dst, uint32_t width)
+{
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		avx2_yuv422_to_rgb_x16(_mm256_loadu_si256((const __m256i *)src), false, dst);
+		src += 32;
+		dst += 48;
+	}
+
+	ssse3_yuyv422_to_r8g8b8(src, dst, width - x);
+}
+
+TARGET_AVX2 static void
+avx2_uyvy422_to_r8g8b8(const uint8_t *src, uint8_t *dst, uint32_t width)
+{
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		avx2_yuv422_to_rgb_x16(_mm256_loadu_si256((const __m256i *)src), true, dst);
+		src += 32;
+		dst += 48;
+	}
+
+	ssse3_uyvy422_to_r8g8b8(src, dst, width - x);
+}
+
+static const struct kernels avx2_kernels = {
+    .yuyv422_to_r8g8b8 = avx2_yuyv422_to_r8g8b8,
+    .uyvy422_to_r8g8b8 = avx2_uyvy422_to_r8g8b8,
+    .yuv888_to_r8g8b8 = scalar_yuv888_to_r8g8b8,
+    .yuyv422_to_l8 = ssse3_yuyv422_to_l8,
+    .l8_to_r8g8b8 = ssse3_l8_to_r8g8b8,
+};
+
+#endif // U_FORMAT_CONVERT_HAVE_X86
+
+
+/*
+ *
+ * NEON kernels.
+ *
+ */
+
+#ifdef U_FORMAT_CONVERT_HAVE_NEON
+
+/*!
+ * Converts 8 pixels, the multiply accumulates are kept in 32 bit and narrowed
+ * with a truncating shift so the result matches the scalar code.
+ */
+static inline void
+neon_yuv_to_rgb_x8(uint8x8_t y, uint8x8_t u, uint8x8_t v, uint8x8_t *out_r, uint8x8_t *out_g, uint8x8_t *out_b)
+{
+	int16x8_t c = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(y)), vdupq_n_s16(16));
+	int16x8_t d = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(u)), vdupq_n_s16(128));
+	int16x8_t e = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(v)), vdupq_n_s16(128));
+
+	int32x4_t c_lo = vmlal_n_s16(vdupq_n_s32(128), vget_low_s16(c), 298);
+	int32x4_t c_hi = vmlal_n_s16(vdupq_n_s32(128), vget_high_s16(c), 298);
+
+	int32x4_t r_lo = vmlal_n_s16(c_lo, vget_low_s16(e), 409);
+	int32x4_t r_hi = vmlal_n_s16(c_hi, vget_high_s16(e), 409);
+	int32x4_t g_lo = vmlsl_n_s16(vmlsl_n_s16(c_lo, vget_low_s16(d), 100), vget_low_s16(e), 209);
+	int32x4_t g_hi = vmlsl_n_s16(vmlsl_n_s16(c_hi, vget_high_s16(d), 100), vget_high_s16(e), 209);
+	int32x4_t b_lo = vmlal_n_s16(c_lo, vget_low_s16(d), 516);
+	int32x4_t b_hi = vmlal_n_s16(c_hi, vget_high_s16(d), 516);
+
+	*out_r = vqmovun_s16(vcombine_s16(vqshrn_n_s32(r_lo, 8), vqshrn_n_s32(r_hi, 8)));
+	*out_g = vqmovun_s16(vcombine_s16(vqshrn_n_s32(g_lo, 8), vqshrn_n_s32(g_hi, 8)));
+	*out_b = vqmovun_s16(vcombine_s16(vqshrn_n_s32(b_lo, 8), vqshrn_n_s32(b_hi, 8)));
+}
+
+/*!
+ * Converts 16 pixels of 422, the even and odd pixels share u and v.
+ */
+static inline void
+neon_yuv422_to_rgb_x16(uint8x8_t y_even, uint8x8_t y_odd, uint8x8_t u, uint8x8_t v, uint8_t *dst)
+{
+	uint8x8_t r[2], g[2], b[2];
+	neon_yuv_to_rgb_x8(y_even, u, v, &r[0], &g[0], &b[0]);
+	neon_yuv_to_rgb_x8(y_odd, u, v, &r[1], &g[1], &b[1]);
+
+	uint8x8x2_t rz = vzip_u8(r[0], r[1]);
+	uint8x8x2_t gz = vzip_u8(g[0], g[1]);
+	uint8x8x2_t bz = vzip_u8(b[0], b[1]);
+
+	uint8x16x3_t rgb;
+	rgb.val[0] = vcombine_u8(rz.val[0], rz.val[1]);
+	rgb.val[1] = vcombine_u8(gz.val[0], gz.val[1]);
+	rgb.val[2] = vcombine_u8(bz.val[0], bz.val[1]);
+	vst3q_u8(dst, rgb);
+}
+
+static void
+neon_yuyv422_to_r8g8b8(const uint8_t *src, uint8_t *dst, uint32_t width)
+{
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		uint8x8x4_t in = vld4_u8(src);
+		neon_yuv422_to_rgb_x16(in.val[0], in.val[2], in.val[1], in.val[3], dst);
+		src += 32;
+		dst += 48;
+	}
+
+	scalar_yuyv422_to_r8g8b8(src, dst, width - x);
+}
+
+static void
+neon_uyvy422_to_r8g8b8(const uint8_t *src, uint8_t *dst, uint32_t width)
+{
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		uint8x8x4_t in = vld4_u8(src);
+		neon_yuv422_to_rgb_x16(in.val[1], in.val[3], in.val[0], in.val[2], dst);
+		src += 32;
+		dst += 48;
+	}
+
+	scalar_uyvy422_to_r8g8b8(src, dst, width - x);
+}
+
+static void
+neon_yuv888_to_r8g8b8(const uint8_t *src, uint8_t *dst, uint32_t width)
+{
+	uint32_t x = 0;
+	for (; x + 8 <= width; x += 8) {
+		uint8x8x3_t in = vld3_u8(src);
+		uint8x8x3_t rgb;
+		neon_yuv_to_rgb_x8(in.val[0], in.val[1], in.val[2], &rgb.val[0], &rgb.val[1], &rgb.val[2]);
+		vst3_u8(dst, rgb);
+		src += 24;
+		dst += 24;
+	}
+
+	scalar_yuv888_to_r8g8b8(src, dst, width - x);
+}
+
+static void
+neon_yuyv422_to_l8(const uint8_t *src, uint8_t *dst, uint32_t width)
+{
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		uint8x16x2_t in = vld2q_u8(src);
+		vst1q_u8(dst, in.val[0]);
+		src += 32;
+		dst += 16;
+	}
+
+	scalar_yuyv422_to_l8(src, dst, width - x);
+}
+
+static void
+neon_l8_to_r8g8b8(const uint8_t *src, uint8_t *dst, uint32_t width)
+{
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		uint8x16_t l = vld1q_u8(src);
+		uint8x16x3_t rgb = {{l, l, l}};
+		vst3q_u8(dst, rgb);
+		src += 16;
+		dst += 48;
+	}
+
+	scalar_l8_to_r8g8b8(src, dst, width - x);
+}
+
+static const struct kernels neon_kernels = {
+    .yuyv422_to_r8g8b8 = neon_yuyv422_to_r8g8b8,
+    .uyvy422_to_r8g8b8 = neon_uyvy422_to_r8g8b8,
+    .yuv888_to_r8g8b8 = neon_yuv888_to_r8g8b8,
+    .yuyv422_to_l8 = neon_yuyv422_to_l8,
+    .l8_to_r8g8b8 = neon_l8_to_r8g8b8,
+};
+
+#endif // U_FORMAT_CONVERT_HAVE_NEON
+
+
+/*
+ *
+ * Selection.
+ *
+ */
+
+static const struct kernels *g_kernels = &scalar_kernels;
+static enum u_format_convert_impl g_impl = U_FORMAT_CONVERT_IMPL_SCALAR;
+static pthread_once_t g_once = PTHREAD_ONCE_INIT;
+
+static const struct kernels *
+kernels_for_impl(enum u_format_convert_impl impl)
+{
+	switch (impl) {
+	case U_FORMAT_CONVERT_IMPL_SCALAR: return &scalar_kernels;
+#ifdef U_FORMAT_CONVERT_HAVE_X86
+	case U_FORMAT_CONVERT_IMPL_SSSE3: return &ssse3_kernels;
+	case U_FORMAT_CONVERT_IMPL_AVX2: return &avx2_kernels;
+#endif
+#ifdef U_FORMAT_CONVERT_HAVE_NEON
+	case U_FORMAT_CONVERT_IMPL_NEON: return &neon_kernels;
+#endif
+	default: return NULL;
+	}
+}
+
+static bool
+impl_from_string(const char *str, enum u_format_convert_impl *out_impl)
+{
+	if (strcmp(str, "scalar") == 0) {
+		*out_impl = U_FORMAT_CONVERT_IMPL_SCALAR;
+	} else if (strcmp(str, "ssse3") == 0) {
+		*out_impl = U_FORMAT_CONVERT_IMPL_SSSE3;
+	} else if (strcmp(str, "avx2") == 0) {
+		*out_impl = U_FORMAT_CONVERT_IMPL_AVX2;
+	} else if (strcmp(str, "neon") == 0) {
+		*out_impl = U_FORMAT_CONVERT_IMPL_NEON;
+	} else {
+		return false;
+	}
+
+	return true;
+}
+
+static void
+select_impl(void)
+{
+	enum u_format_convert_impl impl = U_FORMAT_CONVERT_IMPL_SCALAR;
+
+	if (u_format_convert_impl_is_supported(U_FORMAT_CONVERT_IMPL_NEON)) {
+		impl = U_FORMAT_CONVERT_IMPL_NEON;
+	} else if (u_format_convert_impl_is_supported(U_FORMAT_CONVERT_IMPL_AVX2)) {
+		impl = U_FORMAT_CONVERT_IMPL_AVX2;
+	} else if (u_format_convert_impl_is_supported(U_FORMAT_CONVERT_IMPL_SSSE3)) {
+		impl = U_FORMAT_CONVERT_IMPL_SSSE3;
+	}
+
+	const char *str = debug_get_option_format_convert_impl();
+	enum u_format_convert_impl forced;
+	if (str != NULL) {
+		if (!impl_from_string(str, &forced)) {
+			U_LOG_W("Unknown U_FORMAT_CONVERT_IMPL '%s'", str);
+		} else if (!u_format_convert_impl_is_supported(forced)) {
+			U_LOG_W("U_FORMAT_CONVERT_IMPL '%s' not supported, using '%s'", str,
+			        u_format_convert_impl_str(impl));
+		} else {
+			impl = forced;
+		}
+	}
+
+	g_impl = impl;
+	g_kernels = kernels_for_impl(impl);
+}
+
+static inline const struct kernels *
+get_kernels(void)
+{
+	pthread_once(&g_once, select_impl);
+	return g_kernels;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+const char *
+u_format_convert_impl_str(enum u_format_convert_impl impl)
+{
+	switch (impl) {
+	case U_FORMAT_CONVERT_IMPL_SCALAR: return "scalar";
+	case U_FORMAT_CONVERT_IMPL_SSSE3: return "ssse3";
+	case U_FORMAT_CONVERT_IMPL_AVX2: return "avx2";
+	case U_FORMAT_CONVERT_IMPL_NEON: return "neon";
+	default: return "unknown";
+	}
+}
+
+bool
+u_format_convert_impl_is_supported(enum u_format_convert_impl impl)
+{
+	switch (impl) {
+	case U_FORMAT_CONVERT_IMPL_SCALAR: return true;
+#ifdef U_FORMAT_CONVERT_HAVE_X86
+	case U_FORMAT_CONVERT_IMPL_SSSE3: __builtin_cpu_init(); return __builtin_cpu_supports("ssse3");
+	case U_FORMAT_CONVERT_IMPL_AVX2: __builtin_cpu_init(); return __builtin_cpu_supports("avx2");
+#endif
+#ifdef U_FORMAT_CONVERT_HAVE_NEON
+	case U_FORMAT_CONVERT_IMPL_NEON: return true;
+#endif
+	default: return false;
+	}
+}
+
+enum u_format_convert_impl
+u_format_convert_get_impl(void)
+{
+	pthread_once(&g_once, select_impl);
+	return g_impl;
+}
+
+bool
+u_format_convert_set_impl(enum u_format_convert_impl impl)
+{
+	// Make sure the selection doesn't run later and override this.
+	pthread_once(&g_once, select_impl);
+
+	if (!u_format_convert_impl_is_supported(impl)) {
+		return false;
+	}
+
+	g_impl = impl;
+	g_kernels = kernels_for_impl(impl);
+
+	return true;
+}
+
+void
+u_format_convert_row_yuyv422_to_r8g8b8(const uint8_t *src, uint8_t *dst, uint32_t width)
+{
+	get_kernels()->yuyv422_to_r8g8b8(src, dst, width);
+}
+
+void
+u_format_convert_row_uyvy422_to_r8g8b8(const uint8_t *src, uint8_t *dst, uint32_t width)
+{
+	get_kernels()->uyvy422_to_r8g8b8(src, dst, width);
+}
+
+void
+u_format_convert_row_yuv888_to_r8g8b8(const uint8_t *src, uint8_t *dst, uint32_t width)
+{
+	get_kernels()->yuv888_to_r8g8b8(src, dst, width);
+}
+
+void
+u_format_convert_row_yuyv422_to_l8(const uint8_t *src, uint8_t *dst, uint32_t width)
+{
+	get_kernels()->yuyv422_to_l8(src, dst, width);
+}
+
+void
+u_format_convert_row_l8_to_r8g8b8(const uint8_t *src, uint8_t *dst, uint32_t width)
+{
+	get_kernels()->l8_to_r8g8b8(src, dst, width);
+}
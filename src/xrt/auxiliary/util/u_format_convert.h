@@ -0,0 +1,143 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Row based pixel format conversion, with SIMD implementations.
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * Which set of kernels the conversion functions uses, all of them produce
+ * exactly the same output as the scalar implementation.
+ *
+ * @ingroup aux_util
+ */
+enum u_format_convert_impl
+{
+	U_FORMAT_CONVERT_IMPL_SCALAR,
+	U_FORMAT_CONVERT_IMPL_SSSE3,
+	U_FORMAT_CONVERT_IMPL_AVX2,
+	U_FORMAT_CONVERT_IMPL_NEON,
+};
+
+/*!
+ * Returns a string of the implementation name.
+ *
+ * @ingroup aux_util
+ */
+const char *
+u_format_convert_impl_str(enum u_format_convert_impl impl);
+
+/*!
+ * Is the given implementation compiled in and supported by this CPU.
+ *
+ * @ingroup aux_util
+ */
+bool
+u_format_convert_impl_is_supported(enum u_format_convert_impl impl);
+
+/*!
+ * Returns the implementation in use, selected on first use from the CPU
+ * features, can be overridden with the env variable
+ * `U_FORMAT_CONVERT_IMPL` set to `scalar`, `ssse3`, `avx2` or `neon`.
+ *
+ * @ingroup aux_util
+ */
+enum u_format_convert_impl
+u_format_convert_get_impl(void);
+
+/*!
+ * Force a implementation, mostly for testing, not thread safe against
+ * conversions running at the same time. Returns false if not supported.
+ *
+ * @ingroup aux_util
+ */
+bool
+u_format_convert_set_impl(enum u_format_convert_impl impl);
+
+
+/*
+ *
+ * Scalar helpers.
+ *
+ */
+
+static inline uint8_t
+u_format_convert_clamp_to_byte(int v)
+{
+	if (v < 0) {
+		return 0;
+	}
+	if (v >= 255) {
+		return 255;
+	}
+	return (uint8_t)v;
+}
+
+/*!
+ * BT.601 studio swing YUV to RGB, the reference all kernels match.
+ *
+ * @ingroup aux_util
+ */
+static inline void
+u_format_convert_yuv_to_rgb(int y, int u, int v, uint8_t *dst)
+{
+	int C = y - 16;
+	int D = u - 128;
+	int E = v - 128;
+
+	dst[0] = u_format_convert_clamp_to_byte((298 * C + 409 * E + 128) >> 8);
+	dst[1] = u_format_convert_clamp_to_byte((298 * C - 100 * D - 209 * E + 128) >> 8);
+	dst[2] = u_format_convert_clamp_to_byte((298 * C + 516 * D + 128) >> 8);
+}
+
+
+/*
+ *
+ * Row functions, @p width is in pixels.
+ *
+ */
+
+/*!
+ * @ingroup aux_util
+ */
+void
+u_format_convert_row_yuyv422_to_r8g8b8(const uint8_t *src, uint8_t *dst, uint32_t width);
+
+/*!
+ * @ingroup aux_util
+ */
+void
+u_format_convert_row_uyvy422_to_r8g8b8(const uint8_t *src, uint8_t *dst, uint32_t width);
+
+/*!
+ * @ingroup aux_util
+ */
+void
+u_format_convert_row_yuv888_to_r8g8b8(const uint8_t *src, uint8_t *dst, uint32_t width);
+
+/*!
+ * @ingroup aux_util
+ */
+void
+u_format_convert_row_yuyv422_to_l8(const uint8_t *src, uint8_t *dst, uint32_t width);
+
+/*!
+ * @ingroup aux_util
+ */
+void
+u_format_convert_row_l8_to_r8g8b8(const uint8_t *src, uint8_t *dst, uint32_t width);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -7,6 +7,8 @@
  * @ingroup aux_util
  */
 
+#include "os/os_threading.h"
+
 #include "util/u_misc.h"
 #include "util/u_frame.h"
 #include "util/u_format.h"
@@ -14,6 +16,59 @@
 #include <assert.h>
 
 
+/*!
+ * A frame pool, returned frames are kept on a singly linked free list.
+ */
+struct pool
+{
+	struct u_frame_pool base;
+
+	//! Protects the free list.
+	struct os_mutex mutex;
+
+	//! Frames ready to be reused.
+	struct pooled_frame *free_list;
+
+	//! Number of frames on the free list.
+	uint32_t free_count;
+
+	//! Max number of frames on the free list.
+	uint32_t max_free_count;
+};
+
+struct pooled_frame
+{
+	struct xrt_frame base;
+
+	//! Pool this frame is returned to, holds a reference.
+	struct u_frame_pool *ufp;
+
+	//! Size of the allocated data.
+	size_t capacity;
+
+	//! Next frame in the free list.
+	struct pooled_frame *next;
+};
+
+static void
+copy_frame_fields(struct xrt_frame *xf, const struct xrt_frame *to_copy)
+{
+	// Explicitly only copy the fields we want
+	xf->width = to_copy->width;
+	xf->height = to_copy->height;
+	xf->stride = to_copy->stride;
+	xf->size = to_copy->size;
+
+	xf->format = to_copy->format;
+	xf->stereo_format = to_copy->stereo_format;
+
+	xf->timestamp = to_copy->timestamp;
+	xf->source_timestamp = to_copy->source_timestamp;
+	xf->source_sequence = to_copy->source_sequence;
+	xf->source_id = to_copy->source_id;
+}
+
+
 static void
 free_one_off(struct xrt_frame *xf)
 {
@@ -56,19 +111,7 @@ u_frame_clone(struct xrt_frame *to_copy, struct xrt_frame **out_frame)
 {
 	struct xrt_frame *xf = U_TYPED_CALLOC(struct xrt_frame);
 
-	// Explicitly only copy the fields we want
-	xf->width = to_copy->width;
-	xf->height = to_copy->height;
-	xf->stride = to_copy->stride;
-	xf->size = to_copy->size;
-
-	xf->format = to_copy->format;
-	xf->stereo_format = to_copy->stereo_format;
-
-	xf->timestamp = to_copy->timestamp;
-	xf->source_timestamp = to_copy->source_timestamp;
-	xf->source_sequence = to_copy->source_sequence;
-	xf->source_id = to_copy->source_id;
+	copy_frame_fields(xf, to_copy);
 
 	xf->destroy = free_clone;
 
@@ -141,5 +184,201 @@ u_frame_create_roi(struct xrt_frame *original, struct xrt_rect roi, struct xrt_f
 	xf->source_sequence = original->source_sequence;
 	xf->source_id = original->source_id;
 
+	// Still the same memory, so still importable.
+	xf->buffer_handle = original->buffer_handle;
+	xf->buffer_offset = original->buffer_offset + offset;
+	xf->has_buffer_handle = original->has_buffer_handle;
+
+	xrt_frame_reference(out_frame, xf);
+}
+
+static void
+free_stereo_pair(struct xrt_frame *xf)
+{
+	xrt_frame_reference(&xf->views[0], NULL);
+	xrt_frame_reference(&xf->views[1], NULL);
+	xrt_frame_reference((struct xrt_frame **)&xf->owner, NULL);
+	free(xf);
+}
+
+void
+u_frame_create_stereo_pair(struct xrt_frame *left,
+                           struct xrt_frame *right,
+                           struct xrt_frame *sbs,
+                           struct xrt_frame **out_frame)
+{
+	assert(left != NULL && right != NULL && sbs != NULL);
+	assert(sbs->stereo_format == XRT_STEREO_FORMAT_SBS);
+
+	struct xrt_frame *xf = U_TYPED_CALLOC(struct xrt_frame);
+
+	copy_frame_fields(xf, sbs);
+
+	xf->destroy = free_stereo_pair;
+	xf->data = sbs->data;
+	xrt_frame_reference((struct xrt_frame **)&xf->owner, sbs);
+
+	// Still the same memory, so still importable.
+	xf->buffer_handle = sbs->buffer_handle;
+	xf->buffer_offset = sbs->buffer_offset;
+	xf->has_buffer_handle = sbs->has_buffer_handle;
+
+	xrt_frame_reference(&xf->views[0], left);
+	xrt_frame_reference(&xf->views[1], right);
+
+	xrt_frame_reference(out_frame, xf);
+}
+
+
+/*
+ *
+ * Frame pool functions.
+ *
+ */
+
+static void
+return_pooled(struct xrt_frame *xf)
+{
+	assert(xf->reference.count == 0);
+
+	struct pooled_frame *pf = (struct pooled_frame *)xf;
+	struct u_frame_pool *ufp = pf->ufp;
+	struct pool *p = (struct pool *)ufp;
+
+	os_mutex_lock(&p->mutex);
+
+	bool keep = p->free_count < p->max_free_count;
+	if (keep) {
+		pf->next = p->free_list;
+		p->free_list = pf;
+		p->free_count++;
+	}
+
+	os_mutex_unlock(&p->mutex);
+
+	if (!keep) {
+		free(pf->base.data);
+		free(pf);
+	}
+
+	// Might be the last reference to the pool.
+	u_frame_pool_reference(&ufp, NULL);
+}
+
+static struct pooled_frame *
+get_pooled(struct pool *p, size_t size)
+{
+	struct pooled_frame *pf = NULL;
+
+	os_mutex_lock(&p->mutex);
+
+	// First fit, the list is short and frames are mostly of the same size.
+	for (struct pooled_frame **ptr = &p->free_list; *ptr != NULL; ptr = &(*ptr)->next) {
+		if ((*ptr)->capacity >= size) {
+			pf = *ptr;
+			*ptr = pf->next;
+			p->free_count--;
+			break;
+		}
+	}
+
+	os_mutex_unlock(&p->mutex);
+
+	if (pf == NULL) {
+		pf = U_TYPED_CALLOC(struct pooled_frame);
+	}
+
+	if (pf->capacity < size) {
+		free(pf->base.data);
+		pf->base.data = (uint8_t *)malloc(size);
+		pf->capacity = size;
+	}
+
+	// Reset everything but the data.
+	uint8_t *data = pf->base.data;
+	U_ZERO(&pf->base);
+	pf->base.data = data;
+	pf->base.destroy = return_pooled;
+	pf->next = NULL;
+	pf->ufp = NULL;
+
+	// Each frame handed out keeps the pool alive.
+	u_frame_pool_reference(&pf->ufp, &p->base);
+
+	return pf;
+}
+
+struct u_frame_pool *
+u_frame_pool_create(uint32_t max_free_count)
+{
+	struct pool *p = U_TYPED_CALLOC(struct pool);
+
+	int ret = os_mutex_init(&p->mutex);
+	if (ret != 0) {
+		free(p);
+		return NULL;
+	}
+
+	p->base.reference.count = 1;
+	p->max_free_count = max_free_count;
+
+	return &p->base;
+}
+
+void
+u_frame_pool_destroy(struct u_frame_pool *ufp)
+{
+	struct pool *p = (struct pool *)ufp;
+
+	// No frames are out, they hold references, only free ones left.
+	while (p->free_list != NULL) {
+		struct pooled_frame *pf = p->free_list;
+		p->free_list = pf->next;
+
+		free(pf->base.data);
+		free(pf);
+	}
+
+	os_mutex_destroy(&p->mutex);
+	free(p);
+}
+
+void
+u_frame_pool_create_frame(struct u_frame_pool *ufp,
+                          enum xrt_format f,
+                          uint32_t width,
+                          uint32_t height,
+                          struct xrt_frame **out_frame)
+{
+	assert(width > 0);
+	assert(height > 0);
+	assert(u_format_is_blocks(f));
+
+	size_t stride = 0;
+	size_t size = 0;
+	u_format_size_for_dimensions(f, width, height, &stride, &size);
+
+	struct pooled_frame *pf = get_pooled((struct pool *)ufp, size);
+	struct xrt_frame *xf = &pf->base;
+
+	xf->format = f;
+	xf->width = width;
+	xf->height = height;
+	xf->stride = stride;
+	xf->size = size;
+
+	xrt_frame_reference(out_frame, xf);
+}
+
+void
+u_frame_pool_clone(struct u_frame_pool *ufp, struct xrt_frame *to_copy, struct xrt_frame **out_frame)
+{
+	struct pooled_frame *pf = get_pooled((struct pool *)ufp, to_copy->size);
+	struct xrt_frame *xf = &pf->base;
+
+	copy_frame_fields(xf, to_copy);
+
+	memcpy(xf->data, to_copy->data, xf->size);
+
 	xrt_frame_reference(out_frame, xf);
 }
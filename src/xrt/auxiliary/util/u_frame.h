@@ -37,6 +37,92 @@ u_frame_clone(struct xrt_frame *to_copy, struct xrt_frame **out_frame);
 void
 u_frame_create_roi(struct xrt_frame *original, struct xrt_rect roi, struct xrt_frame **out_frame);
 
+/*!
+ * Creates a stereo pair frame that references both @p left and @p right in
+ * @ref xrt_frame::views, so consumers that want the views separately get them
+ * without any copy. The pair exposes the data of @p sbs, a frame that holds
+ * both views side by side, and holds a reference to it for consumers that need
+ * them in one buffer.
+ */
+void
+u_frame_create_stereo_pair(struct xrt_frame *left,
+                           struct xrt_frame *right,
+                           struct xrt_frame *sbs,
+                           struct xrt_frame **out_frame);
+
+
+/*
+ *
+ * Frame pool.
+ *
+ */
+
+/*!
+ * A pool of frames, frames handed out are returned to the pool when their
+ * reference reaches zero instead of freeing the memory, which is reused by
+ * the next frame of the same or smaller size. Every frame keeps a reference
+ * to the pool, so the frames may outlive the creator of the pool.
+ */
+struct u_frame_pool
+{
+	struct xrt_reference reference;
+};
+
+/*!
+ * Creates a frame pool that keeps at most @p max_free_count returned frames
+ * around for reuse, frames returned beyond that are freed.
+ */
+struct u_frame_pool *
+u_frame_pool_create(uint32_t max_free_count);
+
+/*!
+ * Internal function, only called by reference.
+ */
+void
+u_frame_pool_destroy(struct u_frame_pool *ufp);
+
+/*!
+ * Standard Monado reference function.
+ */
+static inline void
+u_frame_pool_reference(struct u_frame_pool **dst, struct u_frame_pool *src)
+{
+	struct u_frame_pool *old_dst = *dst;
+
+	if (old_dst == src) {
+		return;
+	}
+
+	if (src) {
+		xrt_reference_inc(&src->reference);
+	}
+
+	*dst = src;
+
+	if (old_dst) {
+		if (xrt_reference_dec(&old_dst->reference)) {
+			u_frame_pool_destroy(old_dst);
+		}
+	}
+}
+
+/*!
+ * Like @ref u_frame_create_one_off but reuses a returned frame if one with a
+ * large enough buffer is available, the contents of the data is undefined.
+ */
+void
+u_frame_pool_create_frame(struct u_frame_pool *ufp,
+                          enum xrt_format f,
+                          uint32_t width,
+                          uint32_t height,
+                          struct xrt_frame **out_frame);
+
+/*!
+ * Like @ref u_frame_clone but draws the frame from the pool.
+ */
+void
+u_frame_pool_clone(struct u_frame_pool *ufp, struct xrt_frame *to_copy, struct xrt_frame **out_frame);
+
 #ifdef __cplusplus
 }
 #endif
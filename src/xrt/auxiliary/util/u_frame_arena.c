@@ -0,0 +1,155 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Bump allocator for scratch data that only lives for one frame.
+ * @ingroup aux_util
+ */
+
+#include "util/u_misc.h"
+#include "util/u_frame_arena.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/*!
+ * Header of a block, the memory handed out follows it.
+ */
+struct u_frame_arena_block
+{
+	//! The block that was full before this one was added, freed on reset.
+	struct u_frame_arena_block *prev;
+
+	//! Usable bytes after the header.
+	size_t size;
+
+	//! Bytes handed out this frame.
+	size_t used;
+
+	//! Bytes handed out by this and all previous blocks this frame, including padding.
+	size_t total;
+};
+
+//! Keeps the memory after the header aligned to the default alignment.
+#define HEADER_SIZE ((sizeof(struct u_frame_arena_block) + 15) & ~(size_t)15)
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static struct u_frame_arena_block *
+block_create(size_t size)
+{
+	struct u_frame_arena_block *block = (struct u_frame_arena_block *)malloc(HEADER_SIZE + size);
+	if (block == NULL) {
+		return NULL;
+	}
+
+	block->prev = NULL;
+	block->size = size;
+	block->used = 0;
+	block->total = 0;
+
+	return block;
+}
+
+static void
+free_chain(struct u_frame_arena_block *block)
+{
+	while (block != NULL) {
+		struct u_frame_arena_block *prev = block->prev;
+		free(block);
+		block = prev;
+	}
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+void
+u_frame_arena_init(struct u_frame_arena *arena, size_t block_size)
+{
+	arena->block = NULL;
+	arena->block_size = block_size > 0 ? block_size : 4096;
+}
+
+void *
+u_frame_arena_alloc(struct u_frame_arena *arena, size_t size, size_t alignment)
+{
+	assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+	assert(alignment <= U_FRAME_ARENA_DEFAULT_ALIGNMENT);
+
+	struct u_frame_arena_block *block = arena->block;
+
+	size_t offset = 0;
+	if (block != NULL) {
+		offset = (block->used + alignment - 1) & ~(alignment - 1);
+	}
+
+	if (block == NULL || offset > block->size || size > block->size - offset) {
+		size_t new_size = arena->block_size;
+		while (new_size < size) {
+			new_size *= 2;
+		}
+
+		struct u_frame_arena_block *new_block = block_create(new_size);
+		if (new_block == NULL) {
+			return NULL;
+		}
+
+		new_block->prev = block;
+		new_block->total = block != NULL ? block->total : 0;
+		arena->block = block = new_block;
+		offset = 0;
+	}
+
+	block->total += offset - block->used + size;
+	block->used = offset + size;
+
+	void *ptr = (uint8_t *)block + HEADER_SIZE + offset;
+	memset(ptr, 0, size);
+
+	return ptr;
+}
+
+void
+u_frame_arena_reset(struct u_frame_arena *arena)
+{
+	struct u_frame_arena_block *block = arena->block;
+	if (block == NULL) {
+		return;
+	}
+
+	if (block->prev == NULL) {
+		block->used = 0;
+		block->total = 0;
+		return;
+	}
+
+	// The frame didn't fit, make one block that fits all of it next time.
+	size_t new_size = arena->block_size;
+	while (new_size < block->total) {
+		new_size *= 2;
+	}
+
+	free_chain(block);
+	arena->block = block_create(new_size);
+	arena->block_size = new_size;
+}
+
+void
+u_frame_arena_fini(struct u_frame_arena *arena)
+{
+	free_chain(arena->block);
+	arena->block = NULL;
+}
@@ -0,0 +1,100 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Bump allocator for scratch data that only lives for one frame.
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+
+#include <stddef.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+struct u_frame_arena_block;
+
+/*!
+ * Bump allocator for scratch data that lives for one frame, owned by whatever
+ * runs the frame loop. Allocating is a pointer bump, and everything is freed
+ * at once with @ref u_frame_arena_reset at the start of the next frame.
+ *
+ * When a frame needs more than the current block, more blocks are chained on;
+ * the next reset replaces them with a single block big enough for the whole
+ * frame, so after the first few frames there are no heap allocations at all.
+ *
+ * Not thread safe, each thread or frame loop should have its own.
+ *
+ * @ingroup aux_util
+ */
+struct u_frame_arena
+{
+	//! Block being allocated from, earlier blocks of this frame are chained behind it.
+	struct u_frame_arena_block *block;
+
+	//! Minimum size of a block, grows when a frame doesn't fit in one block.
+	size_t block_size;
+};
+
+/*!
+ * Sets up the arena, no memory is allocated until the first allocation.
+ *
+ * @public @memberof u_frame_arena
+ * @ingroup aux_util
+ */
+void
+u_frame_arena_init(struct u_frame_arena *arena, size_t block_size);
+
+/*!
+ * Returns @p size bytes of zeroed memory, aligned to @p alignment which must
+ * be a power of two, valid until the next reset.
+ *
+ * @public @memberof u_frame_arena
+ * @ingroup aux_util
+ */
+void *
+u_frame_arena_alloc(struct u_frame_arena *arena, size_t size, size_t alignment);
+
+/*!
+ * Frees everything allocated from the arena, keeps the memory for the next frame.
+ *
+ * @public @memberof u_frame_arena
+ * @ingroup aux_util
+ */
+void
+u_frame_arena_reset(struct u_frame_arena *arena);
+
+/*!
+ * Frees all memory of the arena.
+ *
+ * @public @memberof u_frame_arena
+ * @ingroup aux_util
+ */
+void
+u_frame_arena_fini(struct u_frame_arena *arena);
+
+/*!
+ * Alignment of @ref U_FRAME_ARENA_ALLOC_ARRAY, enough for any type like malloc.
+ *
+ * @ingroup aux_util
+ */
+#define U_FRAME_ARENA_DEFAULT_ALIGNMENT (16)
+
+/*!
+ * Allocates a zeroed array of @p COUNT elements of @p TYPE from @p ARENA.
+ *
+ * @ingroup aux_util
+ */
+#define U_FRAME_ARENA_ALLOC_ARRAY(ARENA, TYPE, COUNT)                                                                  \
+	((TYPE *)u_frame_arena_alloc(ARENA, sizeof(TYPE) * (COUNT), U_FRAME_ARENA_DEFAULT_ALIGNMENT))
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -10,12 +10,15 @@
  */
 
 #include "math/m_mathinclude.h"
+#include "os/os_threading.h"
 #include "util/u_hand_tracking.h"
 #include "xrt/xrt_defines.h"
 #include "u_hand_simulation.h"
 #include "math/m_api.h"
 #include "u_trace_marker.h"
 
+#include <string.h>
+
 #define HAND_SIM_NUM_FINGERS 5
 
 // This is a lie for the thumb; we usually do the hidden metacarpal trick there
@@ -34,6 +37,30 @@ struct orientations54
 
 #define DEG_TO_RAD(DEG) (DEG * M_PI / 180.)
 
+//! Number of evaluated hands remembered, a couple of devices per hand.
+#define HAND_SIM_CACHE_SIZE 4
+
+/*!
+ * An evaluated hand, the joints only depend on the shape of the hand and not
+ * on where it is, so several devices or clients asking for the same hand
+ * shape share it.
+ */
+struct cache_entry
+{
+	bool valid;
+	struct u_hand_sim_hand hand;
+	struct xrt_hand_joint_set set;
+};
+
+static struct
+{
+	struct os_mutex mutex;
+	struct cache_entry entries[HAND_SIM_CACHE_SIZE];
+	uint32_t next; //!< Entry to replace next.
+} g_cache;
+
+static pthread_once_t g_cache_once = PTHREAD_ONCE_INIT;
+
 // For debugging.
 #if 0
 #include <iostream>
@@ -49,6 +76,34 @@ struct orientations54
 #define assert_quat_length_1(q)
 #endif
 
+//! Same as @ref math_quat_rotate but inlined, so the finger chains can be interleaved.
+static inline void
+quat_mul(const struct xrt_quat *l, const struct xrt_quat *r, struct xrt_quat *out)
+{
+	struct xrt_quat q;
+	q.w = l->w * r->w - l->x * r->x - l->y * r->y - l->z * r->z;
+	q.x = l->w * r->x + l->x * r->w + l->y * r->z - l->z * r->y;
+	q.y = l->w * r->y - l->x * r->z + l->y * r->w + l->z * r->x;
+	q.z = l->w * r->z + l->x * r->y - l->y * r->x + l->z * r->w;
+	*out = q;
+}
+
+//! Same as @ref math_quat_rotate_vec3 for unit quaternions, but inlined.
+static inline void
+quat_rotate_vec3(const struct xrt_quat *q, const struct xrt_vec3 *v, struct xrt_vec3 *out)
+{
+	// t = 2 * cross(q.xyz, v), v' = v + w * t + cross(q.xyz, t)
+	float tx = 2.f * (q->y * v->z - q->z * v->y);
+	float ty = 2.f * (q->z * v->x - q->x * v->z);
+	float tz = 2.f * (q->x * v->y - q->y * v->x);
+
+	struct xrt_vec3 r;
+	r.x = v->x + q->w * tx + (q->y * tz - q->z * ty);
+	r.y = v->y + q->w * ty + (q->z * tx - q->x * tz);
+	r.z = v->z + q->w * tz + (q->x * ty - q->y * tx);
+	*out = r;
+}
+
 static void
 eval_hand_set_rel_orientations(const struct u_hand_sim_hand *opt, struct orientations54 *rel_orientations)
 {
@@ -187,54 +242,46 @@ eval_hand_with_orientation(const struct u_hand_sim_hand *opt,
 
 	eval_hand_set_rel_translations(opt, &rel_translations);
 
-	struct xrt_quat orientation_root = XRT_QUAT_IDENTITY;
+	// The fingers are independent chains, walk them bone by bone with the
+	// fingers in the inner loop so the compiler can vectorise across them.
 
 	// Get each joint's tracking-relative orientation by rotating its parent-relative orientation by the
-	// tracking-relative orientation of its parent.
+	// tracking-relative orientation of its parent, the root is identity.
 	for (size_t finger = 0; finger < HAND_SIM_NUM_FINGERS; finger++) {
-		struct xrt_quat *last_orientation = &orientation_root;
-		for (size_t bone = 0; bone < HAND_SIM_NUM_ORIENTATIONS_IN_FINGER; bone++) {
-			struct xrt_quat *rel_orientation = &rel_orientations.q[finger][bone];
-			struct xrt_quat *out_orientation = &orientations_absolute->q[finger][bone];
-
-			math_quat_rotate(last_orientation, rel_orientation, out_orientation);
-			last_orientation = out_orientation;
+		orientations_absolute->q[finger][0] = rel_orientations.q[finger][0];
+	}
+	for (size_t bone = 1; bone < HAND_SIM_NUM_ORIENTATIONS_IN_FINGER; bone++) {
+		for (size_t finger = 0; finger < HAND_SIM_NUM_FINGERS; finger++) {
+			quat_mul(&orientations_absolute->q[finger][bone - 1], &rel_orientations.q[finger][bone],
+			         &orientations_absolute->q[finger][bone]);
 		}
 	}
 
 	// Get each joint's tracking-relative position by rotating its parent-relative translation by the
 	// tracking-relative orientation of its parent, then adding that to its parent's tracking-relative position.
-	struct xrt_vec3 zero = XRT_VEC3_ZERO;
+	float mirror = is_right ? -1.f : 1.f;
 	for (size_t finger = 0; finger < HAND_SIM_NUM_FINGERS; finger++) {
-		const struct xrt_vec3 *last_translation = &zero;
-		const struct xrt_quat *last_orientation = &orientation_root;
-		for (size_t bone = 0; bone < HAND_SIM_NUM_JOINTS_IN_FINGER; bone++) {
-			struct xrt_vec3 *out_translation = &translations_absolute->t[finger][bone];
-			struct xrt_vec3 *rel_translation = &rel_translations.t[finger][bone];
-
-			// rotate and scale
-			math_quat_rotate_vec3(last_orientation, rel_translation, out_translation);
-			math_vec3_scalar_mul(opt->hand_size, out_translation);
-
-			// If this is a right hand, mirror it.
-			if (is_right) {
-				out_translation->x *= -1;
-			}
+		// The root has identity orientation and is at the origin.
+		struct xrt_vec3 *out_translation = &translations_absolute->t[finger][0];
+		const struct xrt_vec3 *rel_translation = &rel_translations.t[finger][0];
 
-			out_translation->x += last_translation->x;
-			out_translation->y += last_translation->y;
-			out_translation->z += last_translation->z;
+		out_translation->x = rel_translation->x * opt->hand_size * mirror;
+		out_translation->y = rel_translation->y * opt->hand_size;
+		out_translation->z = rel_translation->z * opt->hand_size;
+	}
+	for (size_t bone = 1; bone < HAND_SIM_NUM_JOINTS_IN_FINGER; bone++) {
+		for (size_t finger = 0; finger < HAND_SIM_NUM_FINGERS; finger++) {
+			const struct xrt_quat *last_orientation = &orientations_absolute->q[finger][bone - 1];
+			const struct xrt_vec3 *last_translation = &translations_absolute->t[finger][bone - 1];
+			struct xrt_vec3 *out_translation = &translations_absolute->t[finger][bone];
 
-			// Next iteration, the orientation to rotate by should be the tracking-relative orientation of
-			// this joint.
+			// Rotate, scale and if this is a right hand mirror it.
+			struct xrt_vec3 v;
+			quat_rotate_vec3(last_orientation, &rel_translations.t[finger][bone], &v);
 
-			// If bone < 4 so we don't go over the end of orientations_absolute. I hope this gets optimized
-			// out anyway.
-			if (bone < 4) {
-				last_orientation = &orientations_absolute->q[finger][bone];
-				// Ditto for translation
-				last_translation = out_translation;
-			}
+			out_translation->x = v.x * opt->hand_size * mirror + last_translation->x;
+			out_translation->y = v.y * opt->hand_size + last_translation->y;
+			out_translation->z = v.z * opt->hand_size + last_translation->z;
 		}
 	}
 }
@@ -294,8 +341,6 @@ our_eval_to_viz_hand(struct u_hand_sim_hand *opt,
 {
 	XRT_TRACE_MARKER();
 
-	eval_hand_with_orientation(opt, is_right, translations_absolute, orientations_absolute);
-
 	struct xrt_quat final_wrist_orientation = XRT_QUAT_IDENTITY;
 
 	int joint_acc_idx = 0;
@@ -371,17 +416,71 @@ hand_sim_hand_init(struct u_hand_sim_hand *out_opt, enum xrt_hand xhand, const s
 }
 
 
+static void
+init_cache_mutex(void)
+{
+	os_mutex_init(&g_cache.mutex);
+}
+
+//! Does @p a have the same joints as @p b, the poses of the hands don't matter.
+static bool
+same_hand_shape(const struct u_hand_sim_hand *a, const struct u_hand_sim_hand *b)
+{
+	return a->is_right == b->is_right && a->hand_size == b->hand_size &&
+	       memcmp(&a->wrist_pose.pose.position, &b->wrist_pose.pose.position, sizeof(struct xrt_vec3)) == 0 &&
+	       memcmp(&a->thumb, &b->thumb, sizeof(a->thumb)) == 0 &&
+	       memcmp(&a->finger, &b->finger, sizeof(a->finger)) == 0;
+}
+
+static bool
+cache_lookup(const struct u_hand_sim_hand *hand, struct xrt_hand_joint_set *out_set)
+{
+	bool found = false;
+
+	os_mutex_lock(&g_cache.mutex);
+	for (uint32_t i = 0; i < HAND_SIM_CACHE_SIZE; i++) {
+		struct cache_entry *e = &g_cache.entries[i];
+		if (e->valid && same_hand_shape(&e->hand, hand)) {
+			out_set->values = e->set.values;
+			found = true;
+			break;
+		}
+	}
+	os_mutex_unlock(&g_cache.mutex);
+
+	return found;
+}
+
+static void
+cache_store(const struct u_hand_sim_hand *hand, const struct xrt_hand_joint_set *set)
+{
+	os_mutex_lock(&g_cache.mutex);
+	struct cache_entry *e = &g_cache.entries[g_cache.next];
+	g_cache.next = (g_cache.next + 1) % HAND_SIM_CACHE_SIZE;
+
+	e->valid = true;
+	e->hand = *hand;
+	e->set.values = set->values;
+	os_mutex_unlock(&g_cache.mutex);
+}
+
 void
 u_hand_sim_simulate(struct u_hand_sim_hand *hand_ptr, struct xrt_hand_joint_set *out_set)
 {
-	struct translations55 translations;
-	struct orientations54 orientations;
+	pthread_once(&g_cache_once, init_cache_mutex);
 
-	eval_hand_with_orientation(hand_ptr, hand_ptr->is_right, &translations, &orientations);
+	if (!cache_lookup(hand_ptr, out_set)) {
+		struct translations55 translations;
+		struct orientations54 orientations;
 
-	our_eval_to_viz_hand(hand_ptr, &translations, &orientations, hand_ptr->is_right, out_set);
+		eval_hand_with_orientation(hand_ptr, hand_ptr->is_right, &translations, &orientations);
 
-	u_hand_joints_apply_joint_width(out_set);
+		our_eval_to_viz_hand(hand_ptr, &translations, &orientations, hand_ptr->is_right, out_set);
+
+		u_hand_joints_apply_joint_width(out_set);
+
+		cache_store(hand_ptr, out_set);
+	}
 
 	out_set->hand_pose = hand_ptr->hand_pose;
 
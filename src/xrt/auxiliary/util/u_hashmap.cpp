@@ -8,10 +8,13 @@
  */
 
 #include "util/u_hashmap.h"
+#include "util/u_flat_hash_map.hpp"
 
-#include <unordered_map>
 #include <vector>
 
+using xrt::auxiliary::util::FlatHashMap;
+using xrt::auxiliary::util::IntegerHash;
+
 
 /*
  *
@@ -21,7 +24,7 @@
 
 struct u_hashmap_int
 {
-	std::unordered_map<uint64_t, void *> map = {};
+	FlatHashMap<uint64_t, void *, IntegerHash> map = {};
 };
 
 
@@ -50,10 +53,10 @@ u_hashmap_int_destroy(struct u_hashmap_int **hmi)
 int
 u_hashmap_int_find(struct u_hashmap_int *hmi, uint64_t key, void **out_item)
 {
-	auto search = hmi->map.find(key);
+	void **search = hmi->map.find(key);
 
-	if (search != hmi->map.end()) {
-		*out_item = search->second;
+	if (search != nullptr) {
+		*out_item = *search;
 		return 0;
 	}
 	return -1;
@@ -62,7 +65,7 @@ u_hashmap_int_find(struct u_hashmap_int *hmi, uint64_t key, void **out_item)
 extern "C" int
 u_hashmap_int_insert(struct u_hashmap_int *hmi, uint64_t key, void *value)
 {
-	hmi->map[key] = value;
+	hmi->map.insertOrAssign(key, value);
 	return 0;
 }
 
@@ -85,9 +88,7 @@ u_hashmap_int_clear_and_call_for_each(struct u_hashmap_int *hmi, u_hashmap_int_c
 	std::vector<void *> tmp;
 	tmp.reserve(hmi->map.size());
 
-	for (auto &n : hmi->map) {
-		tmp.push_back(n.second);
-	}
+	hmi->map.forEach([&](uint64_t /*key*/, void *value) { tmp.push_back(value); });
 
 	hmi->map.clear();
 
@@ -9,12 +9,14 @@
 
 #include "util/u_misc.h"
 #include "util/u_hashset.h"
+#include "util/u_flat_hash_map.hpp"
 
 #include <cstring>
-#include <string>
-#include <unordered_map>
+#include <string_view>
 #include <vector>
 
+using xrt::auxiliary::util::FlatHashMap;
+
 
 /*
  *
@@ -22,9 +24,13 @@
  *
  */
 
+/*!
+ * The keys are views of the strings in the items, so looking up a string never
+ * allocates and the items must outlive their time in the set, as before.
+ */
 struct u_hashset
 {
-	std::unordered_map<std::string, struct u_hashset_item *> map = {};
+	FlatHashMap<std::string_view, struct u_hashset_item *> map = {};
 };
 
 
@@ -53,11 +59,10 @@ u_hashset_destroy(struct u_hashset **hs)
 extern "C" int
 u_hashset_find_str(struct u_hashset *hs, const char *str, size_t length, struct u_hashset_item **out_item)
 {
-	std::string key = std::string(str, length);
-	auto search = hs->map.find(key);
+	struct u_hashset_item **search = hs->map.find(std::string_view(str, length));
 
-	if (search != hs->map.end()) {
-		*out_item = search->second;
+	if (search != nullptr) {
+		*out_item = *search;
 		return 0;
 	}
 	return -1;
@@ -73,8 +78,7 @@ u_hashset_find_c_str(struct u_hashset *hs, const char *c_str, struct u_hashset_i
 extern "C" int
 u_hashset_insert_item(struct u_hashset *hs, struct u_hashset_item *item)
 {
-	std::string key = std::string(item->c_str(), item->length);
-	hs->map[key] = item;
+	hs->map.insertOrAssign(std::string_view(item->c_str(), item->length), item);
 	return 0;
 }
 
@@ -109,8 +113,7 @@ u_hashset_create_and_insert_str(struct u_hashset *hs, const char *str, size_t le
 	}
 	store[length] = '\0';
 
-	std::string key = std::string(item->c_str(), item->length);
-	hs->map[key] = item;
+	hs->map.insertOrAssign(std::string_view(item->c_str(), item->length), item);
 
 	*out_item = item;
 
@@ -127,16 +130,14 @@ u_hashset_create_and_insert_str_c(struct u_hashset *hs, const char *c_str, struc
 extern "C" int
 u_hashset_erase_item(struct u_hashset *hs, struct u_hashset_item *item)
 {
-	std::string key = std::string(item->c_str(), item->length);
-	hs->map.erase(key);
+	hs->map.erase(std::string_view(item->c_str(), item->length));
 	return 0;
 }
 
 extern "C" int
 u_hashset_erase_str(struct u_hashset *hs, const char *str, size_t length)
 {
-	std::string key = std::string(str, length);
-	hs->map.erase(key);
+	hs->map.erase(std::string_view(str, length));
 	return 0;
 }
 
@@ -153,9 +154,7 @@ u_hashset_clear_and_call_for_each(struct u_hashset *hs, u_hashset_callback cb, v
 	std::vector<struct u_hashset_item *> tmp;
 	tmp.reserve(hs->map.size());
 
-	for (auto &n : hs->map) {
-		tmp.push_back(n.second);
-	}
+	hs->map.forEach([&](std::string_view /*key*/, struct u_hashset_item *item) { tmp.push_back(item); });
 
 	hs->map.clear();
 
@@ -0,0 +1,88 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Lock-free single producer single consumer ring of IMU samples.
+ * @ingroup aux_util
+ */
+
+#include "util/u_imu_ring.h"
+#include "util/u_misc.h"
+
+
+static inline uint32_t
+seq_diff(int32_t a, int32_t b)
+{
+	// Positions wrap around, avoid signed overflow.
+	return (uint32_t)a - (uint32_t)b;
+}
+
+void
+u_imu_ring_init(struct u_imu_ring *ring, uint32_t size)
+{
+	// Round up to a power of two, the ring needs at least two samples.
+	uint32_t n = 2;
+	while (n < size) {
+		n *= 2;
+	}
+
+	U_ZERO(ring);
+	ring->samples = U_TYPED_ARRAY_CALLOC(struct xrt_imu_sample, n);
+	ring->mask = n - 1;
+}
+
+void
+u_imu_ring_fini(struct u_imu_ring *ring)
+{
+	free(ring->samples);
+	U_ZERO(ring);
+}
+
+uint32_t
+u_imu_ring_drain(struct u_imu_ring *ring, struct xrt_imu_sample *out_samples, uint32_t max)
+{
+	uint32_t size = ring->mask + 1;
+
+	int32_t head = ring->head;
+	xrt_atomic_thread_fence();
+
+	// Skip what the producer has already overwritten.
+	if (seq_diff(head, ring->tail) > size) {
+		ring->dropped += seq_diff(head, ring->tail) - size;
+		ring->tail = (int32_t)((uint32_t)head - size);
+	}
+
+	uint32_t count = seq_diff(head, ring->tail);
+	if (count > max) {
+		count = max;
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t pos = (uint32_t)ring->tail + i;
+		out_samples[i] = ring->samples[pos & ring->mask];
+	}
+
+	/*
+	 * The producer might have lapped us while copying, any sample a full
+	 * ring behind the one it has started writing might be overwritten or
+	 * torn, drop those from the front.
+	 */
+	xrt_atomic_thread_fence();
+	int32_t reserve = ring->reserve;
+
+	uint32_t lost = 0;
+	while (lost < count && seq_diff(reserve, (int32_t)((uint32_t)ring->tail + lost)) > size) {
+		lost++;
+	}
+
+	if (lost > 0) {
+		ring->dropped += lost;
+		for (uint32_t i = lost; i < count; i++) {
+			out_samples[i - lost] = out_samples[i];
+		}
+	}
+
+	ring->tail = (int32_t)((uint32_t)ring->tail + count);
+
+	return count - lost;
+}
@@ -0,0 +1,99 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Lock-free single producer single consumer ring of IMU samples.
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+#include "xrt/xrt_tracking.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * A ring of IMU samples written by one producer, usually a driver thread, and
+ * drained in batches by one consumer.
+ *
+ * Pushing never blocks nor fails: when the consumer falls behind the producer
+ * overwrites the oldest samples, as for IMU data the latest samples are the
+ * ones that matter. The consumer detects the samples it lost and skips them.
+ *
+ * @ingroup aux_util
+ */
+struct u_imu_ring
+{
+	//! Samples, size of the ring is a power of two.
+	struct xrt_imu_sample *samples;
+
+	//! Size of the ring minus one.
+	uint32_t mask;
+
+	//! Number of samples pushed, only written by the producer.
+	xrt_atomic_s32_t head;
+
+	//! Number of samples the producer has started writing, one ahead of @ref head while it writes.
+	xrt_atomic_s32_t reserve;
+
+	//! Number of samples consumed, only used by the consumer.
+	int32_t tail;
+
+	//! Samples overwritten before the consumer got to them.
+	uint32_t dropped;
+};
+
+/*!
+ * Allocates room for at least @p size samples, rounded up to a power of two.
+ *
+ * @public @memberof u_imu_ring
+ */
+void
+u_imu_ring_init(struct u_imu_ring *ring, uint32_t size);
+
+/*!
+ * @public @memberof u_imu_ring
+ */
+void
+u_imu_ring_fini(struct u_imu_ring *ring);
+
+/*!
+ * Pushes a sample, only call from the producer.
+ *
+ * @public @memberof u_imu_ring
+ */
+static inline void
+u_imu_ring_push(struct u_imu_ring *ring, const struct xrt_imu_sample *sample)
+{
+	int32_t head = ring->head;
+	int32_t next = (int32_t)((uint32_t)head + 1);
+
+	// Tell the consumer which sample is about to be overwritten.
+	ring->reserve = next;
+	xrt_atomic_thread_fence();
+
+	ring->samples[(uint32_t)head & ring->mask] = *sample;
+
+	// Publish the sample before moving the head.
+	xrt_atomic_thread_fence();
+	ring->head = next;
+}
+
+/*!
+ * Copies up to @p max of the oldest samples not yet consumed into
+ * @p out_samples, in push order, only call from the consumer.
+ *
+ * @return The number of samples copied.
+ * @public @memberof u_imu_ring
+ */
+uint32_t
+u_imu_ring_drain(struct u_imu_ring *ring, struct xrt_imu_sample *out_samples, uint32_t max);
+
+
+#ifdef __cplusplus
+}
+#endif
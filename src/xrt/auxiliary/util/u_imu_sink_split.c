@@ -7,8 +7,19 @@
  * @ingroup aux_util
  */
 
+#include "os/os_threading.h"
+
+#include "util/u_imu_ring.h"
+#include "util/u_misc.h"
 #include "util/u_sink.h"
 #include "util/u_trace_marker.h"
+#include "util/u_var.h"
+
+#include <stdio.h>
+
+
+//! Samples the ring to the queued downstream can hold, about a second at 1kHz.
+#define U_IMU_SINK_SPLIT_RING_SIZE (1024)
 
 
 /*!
@@ -23,8 +34,51 @@ struct u_imu_sink_split
 
 	struct xrt_imu_sink *downstream_one;
 	struct xrt_imu_sink *downstream_two;
+
+	//! Only used if queued, samples for @ref downstream_two.
+	struct
+	{
+		bool enabled;
+		struct u_imu_ring ring;
+		struct os_thread thread;
+		//! Posted once per pushed sample, so we can wake the thread up.
+		struct os_semaphore sem;
+		volatile bool running;
+		//! For the debug UI, samples pushed and handed to @ref downstream_two.
+		uint64_t pushed;
+		uint64_t consumed;
+	} queue;
 };
 
+static void *
+split_queue_mainloop(void *ptr)
+{
+	U_TRACE_SET_THREAD_NAME("IMU Sink Queue");
+
+	struct u_imu_sink_split *s = (struct u_imu_sink_split *)ptr;
+	struct xrt_imu_sample samples[64];
+
+	while (true) {
+		os_semaphore_wait(&s->queue.sem, 0);
+
+		if (!s->queue.running) {
+			break;
+		}
+
+		// Samples pushed while we were busy are handled in one batch.
+		uint32_t count = 0;
+		do {
+			count = u_imu_ring_drain(&s->queue.ring, samples, ARRAY_SIZE(samples));
+			for (uint32_t i = 0; i < count; i++) {
+				xrt_sink_push_imu(s->downstream_two, &samples[i]);
+			}
+			s->queue.consumed += count;
+		} while (count == ARRAY_SIZE(samples));
+	}
+
+	return NULL;
+}
+
 static void
 split_sample(struct xrt_imu_sink *xfs, struct xrt_imu_sample *sample)
 {
@@ -33,13 +87,34 @@ split_sample(struct xrt_imu_sink *xfs, struct xrt_imu_sample *sample)
 	struct u_imu_sink_split *s = (struct u_imu_sink_split *)xfs;
 
 	xrt_sink_push_imu(s->downstream_one, sample);
-	xrt_sink_push_imu(s->downstream_two, sample);
+
+	if (!s->queue.enabled) {
+		xrt_sink_push_imu(s->downstream_two, sample);
+		return;
+	}
+
+	if (!s->queue.running) {
+		return;
+	}
+
+	// Never blocks, wakes the thread up only entering the kernel if it is sleeping.
+	u_imu_ring_push(&s->queue.ring, sample);
+	s->queue.pushed++;
+	os_semaphore_release(&s->queue.sem);
 }
 
 static void
 split_break_apart(struct xrt_frame_node *node)
 {
-	// Noop
+	struct u_imu_sink_split *s = container_of(node, struct u_imu_sink_split, node);
+
+	if (!s->queue.enabled) {
+		return;
+	}
+
+	s->queue.running = false;
+	os_semaphore_release(&s->queue.sem);
+	os_thread_join(&s->queue.thread);
 }
 
 static void
@@ -47,9 +122,28 @@ split_destroy(struct xrt_frame_node *node)
 {
 	struct u_imu_sink_split *s = container_of(node, struct u_imu_sink_split, node);
 
+	if (s->queue.enabled) {
+		os_thread_destroy(&s->queue.thread);
+		os_semaphore_destroy(&s->queue.sem);
+		u_imu_ring_fini(&s->queue.ring);
+	}
+
 	free(s);
 }
 
+static struct u_imu_sink_split *
+split_alloc(struct xrt_imu_sink *downstream_one, struct xrt_imu_sink *downstream_two)
+{
+	struct u_imu_sink_split *s = U_TYPED_CALLOC(struct u_imu_sink_split);
+	s->base.push_imu = split_sample;
+	s->node.break_apart = split_break_apart;
+	s->node.destroy = split_destroy;
+	s->downstream_one = downstream_one;
+	s->downstream_two = downstream_two;
+
+	return s;
+}
+
 /*
  *
  * Exported functions.
@@ -63,13 +157,70 @@ u_imu_sink_split_create(struct xrt_frame_context *xfctx,
                         struct xrt_imu_sink **out_imu_sink)
 {
 
-	struct u_imu_sink_split *s = U_TYPED_CALLOC(struct u_imu_sink_split);
-	s->base.push_imu = split_sample;
-	s->node.break_apart = split_break_apart;
-	s->node.destroy = split_destroy;
-	s->downstream_one = downstream_one;
-	s->downstream_two = downstream_two;
+	struct u_imu_sink_split *s = split_alloc(downstream_one, downstream_two);
 
 	xrt_frame_context_add(xfctx, &s->node);
 	*out_imu_sink = &s->base;
 }
+
+bool
+u_imu_sink_split_create_queued(struct xrt_frame_context *xfctx,
+                               struct xrt_imu_sink *downstream_one,
+                               struct xrt_imu_sink *downstream_two,
+                               struct xrt_imu_sink **out_imu_sink)
+{
+	struct u_imu_sink_split *s = split_alloc(downstream_one, downstream_two);
+	int ret = 0;
+
+	u_imu_ring_init(&s->queue.ring, U_IMU_SINK_SPLIT_RING_SIZE);
+
+	ret = os_semaphore_init(&s->queue.sem, 0);
+	if (ret != 0) {
+		u_imu_ring_fini(&s->queue.ring);
+		free(s);
+		return false;
+	}
+
+	ret = os_thread_init(&s->queue.thread);
+	if (ret != 0) {
+		os_semaphore_destroy(&s->queue.sem);
+		u_imu_ring_fini(&s->queue.ring);
+		free(s);
+		return false;
+	}
+
+	s->queue.enabled = true;
+	s->queue.running = true;
+
+	ret = os_thread_start(&s->queue.thread, split_queue_mainloop, s);
+	if (ret != 0) {
+		os_thread_destroy(&s->queue.thread);
+		os_semaphore_destroy(&s->queue.sem);
+		u_imu_ring_fini(&s->queue.ring);
+		free(s);
+		return false;
+	}
+
+	xrt_frame_context_add(xfctx, &s->node);
+	*out_imu_sink = &s->base;
+
+	return true;
+}
+
+void
+u_imu_sink_split_add_vars(struct xrt_imu_sink *imu_sink, void *root, const char *prefix)
+{
+	struct u_imu_sink_split *s = (struct u_imu_sink_split *)imu_sink;
+	char name[64];
+
+	if (!s->queue.enabled) {
+		return;
+	}
+
+	snprintf(name, sizeof(name), "%s samples pushed", prefix);
+	u_var_add_ro_u64(root, &s->queue.pushed, name);
+	snprintf(name, sizeof(name), "%s samples consumed", prefix);
+	u_var_add_ro_u64(root, &s->queue.consumed, name);
+	snprintf(name, sizeof(name), "%s samples dropped", prefix);
+	u_var_add_ro_u32(root, &s->queue.ring.dropped, name);
+}
@@ -14,6 +14,10 @@
 #include "util/u_debug.h"
 #include "u_json.h"
 #include "util/u_truncate_printf.h"
+#include "util/u_time.h"
+#include "util/u_mpsc_ring.h"
+
+#include "os/os_threading.h"
 
 #include <assert.h>
 #include <stddef.h>
@@ -50,6 +54,11 @@
  */
 #define LOG_HEX_LINE_BUF_SIZE (128)
 
+/*
+ * Number of records in the async ring.
+ */
+#define LOG_ASYNC_RECORD_COUNT (128)
+
 /*
  *
  * Global log level functions.
@@ -58,6 +67,7 @@
 
 DEBUG_GET_ONCE_LOG_OPTION(global_log, "XRT_LOG", U_LOGGING_WARN)
 DEBUG_GET_ONCE_BOOL_OPTION(json_log, "XRT_JSON_LOG", false)
+DEBUG_GET_ONCE_BOOL_OPTION(async_log, "XRT_LOG_ASYNC", false)
 
 enum u_logging_level
 u_log_get_global_level(void)
@@ -66,6 +76,51 @@ u_log_get_global_level(void)
 }
 
 
+/*
+ *
+ * Rate limiting.
+ *
+ */
+
+bool
+u_log_ratelimit_check(struct u_log_ratelimit *state,
+                      int32_t interval_ms,
+                      const char *file,
+                      int line,
+                      const char *func,
+                      enum u_logging_level level)
+{
+	// Wraps after 49 days, only the difference is used. Zero means never.
+	uint32_t now_ms = (uint32_t)(os_monotonic_get_ns() / U_TIME_1MS_IN_NS);
+	if (now_ms == 0) {
+		now_ms = 1;
+	}
+
+	int32_t last_ms = state->last_ms;
+	if (last_ms != 0 && now_ms - (uint32_t)last_ms < (uint32_t)interval_ms) {
+		xrt_atomic_s32_inc_return(&state->suppressed);
+		return false;
+	}
+
+	// Only one of the threads racing past the interval gets to log.
+	if (xrt_atomic_s32_cmpxchg(&state->last_ms, last_ms, (int32_t)now_ms) != last_ms) {
+		xrt_atomic_s32_inc_return(&state->suppressed);
+		return false;
+	}
+
+	int32_t suppressed;
+	do {
+		suppressed = state->suppressed;
+	} while (xrt_atomic_s32_cmpxchg(&state->suppressed, suppressed, 0) != suppressed);
+
+	if (suppressed > 0) {
+		u_log(file, line, func, level, "Suppressed %d similar messages", suppressed);
+	}
+
+	return true;
+}
+
+
 /*
  *
  * Logging sink.
@@ -406,6 +461,194 @@ do_print(const char *file, int line, const char *func, enum u_logging_level leve
 }
 
 
+static void
+log_direct(const char *file, int line, const char *func, enum u_logging_level level, const char *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	DISPATCH_SINK(file, line, func, level, format, args);
+	do_print(file, line, func, level, format, args);
+	va_end(args);
+}
+
+
+/*
+ *
+ * Async logging.
+ *
+ */
+
+enum log_async_state
+{
+	LOG_ASYNC_NOT_STARTED = 0,
+	LOG_ASYNC_STARTING,
+	LOG_ASYNC_RUNNING,
+	LOG_ASYNC_STOPPED,
+};
+
+/*!
+ * A message formatted by the thread that logged it, printed and passed on to
+ * the sink by the logger thread.
+ */
+struct log_record
+{
+	const char *file;
+	int line;
+	const char *func;
+	enum u_logging_level level;
+
+	char text[LOG_BUFFER_SIZE];
+};
+
+/*!
+ * Ring of records, any thread can log while only the logger thread prints.
+ * Started on the first message if `XRT_LOG_ASYNC` is set, when the ring is
+ * full messages are dropped and counted rather than blocking the thread that
+ * logs.
+ */
+static struct
+{
+	xrt_atomic_s32_t state;
+
+	struct u_mpsc_ring ring;
+
+	//! One per slot of the ring.
+	struct log_record *records;
+
+	//! Messages dropped because the ring was full.
+	xrt_atomic_s32_t dropped;
+
+	//! Dropped messages already reported, only used by the logger thread.
+	int32_t dropped_reported;
+
+	//! Released once per record written, and to stop.
+	struct os_semaphore sem;
+
+	struct os_thread thread;
+} g_async;
+
+static void
+async_drain(void)
+{
+	uint32_t slot;
+	while (u_mpsc_ring_peek(&g_async.ring, &slot)) {
+		struct log_record *rec = &g_async.records[slot];
+		log_direct(rec->file, rec->line, rec->func, rec->level, "%s", rec->text);
+		u_mpsc_ring_release(&g_async.ring);
+	}
+
+	int32_t dropped = g_async.dropped;
+	if (dropped != g_async.dropped_reported) {
+		log_direct(__FILE__, __LINE__, __func__, U_LOGGING_WARN, "Dropped %u messages, logging fell behind",
+		           (uint32_t)dropped - (uint32_t)g_async.dropped_reported);
+		g_async.dropped_reported = dropped;
+	}
+}
+
+static void *
+async_run(void *ptr)
+{
+	(void)ptr;
+
+	while (g_async.state == LOG_ASYNC_RUNNING) {
+		os_semaphore_wait(&g_async.sem, 0);
+		async_drain();
+	}
+
+	// Producers that got in before the stop.
+	async_drain();
+
+	return NULL;
+}
+
+static void
+async_stop(void)
+{
+	g_async.state = LOG_ASYNC_STOPPED;
+	os_semaphore_release(&g_async.sem);
+	os_thread_join(&g_async.thread);
+}
+
+static void
+async_start(void)
+{
+	u_mpsc_ring_init(&g_async.ring, LOG_ASYNC_RECORD_COUNT);
+	g_async.records = U_TYPED_ARRAY_CALLOC(struct log_record, u_mpsc_ring_size(&g_async.ring));
+
+	os_semaphore_init(&g_async.sem, 0);
+	os_thread_init(&g_async.thread);
+
+	// Set before starting, the thread exits if it isn't running.
+	g_async.state = LOG_ASYNC_RUNNING;
+	xrt_atomic_thread_fence();
+
+	if (os_thread_start(&g_async.thread, async_run, NULL) != 0) {
+		g_async.state = LOG_ASYNC_STOPPED;
+		return;
+	}
+	os_thread_name(&g_async.thread, "Logging");
+
+	// Print what is left when the program exits.
+	atexit(async_stop);
+}
+
+static bool
+async_is_running(void)
+{
+	int32_t state = g_async.state;
+	if (state == LOG_ASYNC_RUNNING) {
+		return true;
+	}
+	if (state != LOG_ASYNC_NOT_STARTED || !debug_get_bool_option_async_log()) {
+		return false;
+	}
+
+	// Only one thread starts it, messages are printed directly meanwhile.
+	if (xrt_atomic_s32_cmpxchg(&g_async.state, LOG_ASYNC_NOT_STARTED, LOG_ASYNC_STARTING) !=
+	    LOG_ASYNC_NOT_STARTED) {
+		return false;
+	}
+
+	async_start();
+
+	return g_async.state == LOG_ASYNC_RUNNING;
+}
+
+/*!
+ * Formats the message straight into a record of the ring.
+ *
+ * @return false if async logging isn't running and the message needs to be
+ *         printed directly.
+ */
+static bool
+async_push(const char *file, int line, const char *func, enum u_logging_level level, const char *format, va_list args)
+{
+	if (!async_is_running()) {
+		return false;
+	}
+
+	uint32_t ticket;
+	if (!u_mpsc_ring_claim(&g_async.ring, &ticket)) {
+		// The logger thread is behind.
+		xrt_atomic_s32_inc_return(&g_async.dropped);
+		return true;
+	}
+
+	struct log_record *rec = &g_async.records[u_mpsc_ring_slot(&g_async.ring, ticket)];
+	rec->file = file;
+	rec->line = line;
+	rec->func = func;
+	rec->level = level;
+	u_truncate_vsnprintf(rec->text, sizeof(rec->text), format, args);
+
+	u_mpsc_ring_publish(&g_async.ring, ticket);
+
+	os_semaphore_release(&g_async.sem);
+
+	return true;
+}
+
+
 /*
  *
  * 'Exported' functions.
@@ -417,8 +660,10 @@ u_log(const char *file, int line, const char *func, enum u_logging_level level,
 {
 	va_list args;
 	va_start(args, format);
-	DISPATCH_SINK(file, line, func, level, format, args);
-	do_print(file, line, func, level, format, args);
+	if (!async_push(file, line, func, level, format, args)) {
+		DISPATCH_SINK(file, line, func, level, format, args);
+		do_print(file, line, func, level, format, args);
+	}
 	va_end(args);
 }
 
@@ -433,7 +678,9 @@ u_log_xdev(const char *file,
 {
 	va_list args;
 	va_start(args, format);
-	DISPATCH_SINK(file, line, func, level, format, args);
-	do_print(file, line, func, level, format, args);
+	if (!async_push(file, line, func, level, format, args)) {
+		DISPATCH_SINK(file, line, func, level, format, args);
+		do_print(file, line, func, level, format, args);
+	}
 	va_end(args);
 }
@@ -11,6 +11,7 @@
 #pragma once
 
 #include "xrt/xrt_compiler.h"
+#include "xrt/xrt_config_build.h"
 
 #include <stdarg.h>
 
@@ -46,6 +47,36 @@ enum u_logging_level
 	U_LOGGING_RAW,   //!< Special level for raw printing, prints a new-line.
 };
 
+#ifndef XRT_LOG_MIN_LEVEL
+/*!
+ * Messages below this level are compiled out, arguments and all. Set with the
+ * `XRT_LOG_MIN_LEVEL` CMake option, defaults to keeping everything.
+ */
+#define XRT_LOG_MIN_LEVEL U_LOGGING_TRACE
+#endif
+
+/*!
+ * True if messages at @p level are compiled in, a constant for the constant
+ * levels the macros use so the compiler drops the calls below the minimum.
+ */
+#define U_LOG_LEVEL_ENABLED(level) ((level) >= XRT_LOG_MIN_LEVEL)
+
+//! Default minimum time between messages of a rate limited call site.
+#define U_LOG_RATELIMIT_INTERVAL_MS (1000)
+
+/*!
+ * State of a rate limited logging call site, zero initialised, see
+ * U_LOG_IFL_RATELIMITED().
+ */
+struct u_log_ratelimit
+{
+	//! Milliseconds since the first check when a message was last let through, plus one.
+	xrt_atomic_s32_t last_ms;
+
+	//! Messages suppressed since then.
+	xrt_atomic_s32_t suppressed;
+};
+
 /*!
  * Function typedef for setting the logging sink.
  *
@@ -87,7 +118,9 @@ typedef void (*u_log_sink_func_t)(const char *file,
  */
 #define U_LOG(level, ...)                                                                                              \
 	do {                                                                                                           \
-		u_log(__FILE__, __LINE__, __func__, level, __VA_ARGS__);                                               \
+		if (U_LOG_LEVEL_ENABLED(level)) {                                                                      \
+			u_log(__FILE__, __LINE__, __func__, level, __VA_ARGS__);                                       \
+		}                                                                                                      \
 	} while (false)
 
 /*!
@@ -101,10 +134,32 @@ typedef void (*u_log_sink_func_t)(const char *file,
  */
 #define U_LOG_IFL(level, cond_level, ...)                                                                              \
 	do {                                                                                                           \
-		if (cond_level <= level) {                                                                             \
+		if (U_LOG_LEVEL_ENABLED(level) && cond_level <= level) {                                               \
+			u_log(__FILE__, __LINE__, __func__, level, __VA_ARGS__);                                       \
+		}                                                                                                      \
+	} while (false)
+
+/*!
+ * @brief Like U_LOG_IFL() but lets at most one message a second through from
+ * this call site, for warnings in hot loops.
+ *
+ * The number of messages suppressed in between is logged before the next one
+ * that is let through.
+ *
+ * @param level A @ref u_logging_level value for this message.
+ * @param cond_level The minimum @ref u_logging_level that will be actually output.
+ * @param ... Format string and optional format arguments.
+ */
+#define U_LOG_IFL_RATELIMITED(level, cond_level, ...)                                                                  \
+	do {                                                                                                           \
+		static struct u_log_ratelimit u_log_ratelimit_state_;                                                  \
+		if (U_LOG_LEVEL_ENABLED(level) && cond_level <= level &&                                               \
+		    u_log_ratelimit_check(&u_log_ratelimit_state_, U_LOG_RATELIMIT_INTERVAL_MS, __FILE__, __LINE__,    \
+		                          __func__, level)) {                                                          \
 			u_log(__FILE__, __LINE__, __func__, level, __VA_ARGS__);                                       \
 		}                                                                                                      \
 	} while (false)
+
 /*!
  * @brief Log at @p level for a given @ref xrt_device - typically wrapped in a helper macro.
  *
@@ -118,7 +173,9 @@ typedef void (*u_log_sink_func_t)(const char *file,
  */
 #define U_LOG_XDEV(level, xdev, ...)                                                                                   \
 	do {                                                                                                           \
-		u_log_xdev(__FILE__, __LINE__, __func__, level, xdev, __VA_ARGS__);                                    \
+		if (U_LOG_LEVEL_ENABLED(level)) {                                                                      \
+			u_log_xdev(__FILE__, __LINE__, __func__, level, xdev, __VA_ARGS__);                            \
+		}                                                                                                      \
 	} while (false)
 /*!
  * @brief Log at @p level for a given @ref xrt_device, only if the level is at least @p cond_level - typically wrapped
@@ -132,7 +189,7 @@ typedef void (*u_log_sink_func_t)(const char *file,
  */
 #define U_LOG_XDEV_IFL(level, cond_level, xdev, ...)                                                                   \
 	do {                                                                                                           \
-		if (cond_level <= level) {                                                                             \
+		if (U_LOG_LEVEL_ENABLED(level) && cond_level <= level) {                                               \
 			u_log_xdev(__FILE__, __LINE__, __func__, level, xdev, __VA_ARGS__);                            \
 		}                                                                                                      \
 	} while (false)
@@ -150,7 +207,7 @@ typedef void (*u_log_sink_func_t)(const char *file,
  */
 #define U_LOG_IFL_HEX(level, cond_level, data, data_size)                                                              \
 	do {                                                                                                           \
-		if (cond_level <= level) {                                                                             \
+		if (U_LOG_LEVEL_ENABLED(level) && cond_level <= level) {                                               \
 			u_log_hex(__FILE__, __LINE__, __func__, level, data, data_size);                               \
 		}                                                                                                      \
 	} while (false)
@@ -168,7 +225,7 @@ typedef void (*u_log_sink_func_t)(const char *file,
  */
 #define U_LOG_XDEV_IFL_HEX(level, cond_level, xdev, data, data_size)                                                   \
 	do {                                                                                                           \
-		if (cond_level <= level) {                                                                             \
+		if (U_LOG_LEVEL_ENABLED(level) && cond_level <= level) {                                               \
 			u_log_xdev_hex(__FILE__, __LINE__, __func__, level, xdev, data, data_size);                    \
 		}                                                                                                      \
 	} while (false)
@@ -180,6 +237,29 @@ typedef void (*u_log_sink_func_t)(const char *file,
 enum u_logging_level
 u_log_get_global_level(void);
 
+/*!
+ * @brief Rate limit check for a call site: do not call directly, use a macro
+ * that wraps it, like U_LOG_IFL_RATELIMITED().
+ *
+ * Thread safe. If messages were suppressed since the last one let through
+ * their number is logged first.
+ *
+ * @param state Call site state.
+ * @param interval_ms Minimum time between messages.
+ * @param file Source file name of the call site
+ * @param line Source file line of the call site
+ * @param func Function name of the call site
+ * @param level Level of the message
+ * @return true if the message should be logged.
+ */
+bool
+u_log_ratelimit_check(struct u_log_ratelimit *state,
+                      int32_t interval_ms,
+                      const char *file,
+                      int line,
+                      const char *func,
+                      enum u_logging_level level);
+
 /*!
  * @brief Main non-device-related log implementation function: do not call directly, use a macro that wraps it.
  *
@@ -263,6 +343,10 @@ u_log_xdev_hex(const char *file,
  * Sets the logging sink, log is still passed on to the platform defined output
  * as well as the sink.
  *
+ * With `XRT_LOG_ASYNC` set messages are formatted on the calling thread and
+ * both printed and passed to the sink from a logger thread, the sink then gets
+ * the formatted message with a `"%s"` format.
+ *
  * @param func Logging function for the calls to be sent to.
  * @param data User data to be passed into @p func.
  */
@@ -300,6 +384,21 @@ u_log_set_sink(u_log_sink_func_t func, void *data);
 //! Log a message at U_LOGGING_ERROR level, conditional on the global log level
 #define U_LOG_E(...) U_LOG_IFL_E(u_log_get_global_level(), __VA_ARGS__)
 
+//! Log a rate limited message at U_LOGGING_TRACE level, conditional on the global log level
+#define U_LOG_T_RATELIMITED(...) U_LOG_IFL_RATELIMITED(U_LOGGING_TRACE, u_log_get_global_level(), __VA_ARGS__)
+
+//! Log a rate limited message at U_LOGGING_DEBUG level, conditional on the global log level
+#define U_LOG_D_RATELIMITED(...) U_LOG_IFL_RATELIMITED(U_LOGGING_DEBUG, u_log_get_global_level(), __VA_ARGS__)
+
+//! Log a rate limited message at U_LOGGING_INFO level, conditional on the global log level
+#define U_LOG_I_RATELIMITED(...) U_LOG_IFL_RATELIMITED(U_LOGGING_INFO, u_log_get_global_level(), __VA_ARGS__)
+
+//! Log a rate limited message at U_LOGGING_WARN level, conditional on the global log level
+#define U_LOG_W_RATELIMITED(...) U_LOG_IFL_RATELIMITED(U_LOGGING_WARN, u_log_get_global_level(), __VA_ARGS__)
+
+//! Log a rate limited message at U_LOGGING_ERROR level, conditional on the global log level
+#define U_LOG_E_RATELIMITED(...) U_LOG_IFL_RATELIMITED(U_LOGGING_ERROR, u_log_get_global_level(), __VA_ARGS__)
+
 /*!
  * @}
  */
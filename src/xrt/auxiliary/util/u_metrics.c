@@ -9,24 +9,95 @@
 
 #include "os/os_threading.h"
 
+#include "xrt/xrt_config_os.h"
+
 #include "util/u_metrics.h"
 #include "util/u_debug.h"
+#include "util/u_file.h"
+#include "util/u_misc.h"
+#include "util/u_mpsc_ring.h"
+#include "util/u_time.h"
 
 #include "monado_metrics.pb.h"
 #include "pb_encode.h"
 
 #include <stdio.h>
+#include <string.h>
+
+#ifdef XRT_OS_LINUX
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
 
 #define VERSION_MAJOR 1
 #define VERSION_MINOR 1
 
+//! Encoded records that can be waiting for the writer thread.
+#define QUEUE_RECORD_COUNT (256)
+
+//! Records are gathered into writes of up to this size.
+#define BATCH_SIZE (16 * 1024)
+
+//! Name of the live stream socket in the runtime dir.
+#define STREAM_SOCKET_FILENAME "monado_metrics"
+
+#define STREAM_MAX_SUBSCRIBERS (8)
+
+//! How often the writer thread checks for new subscribers.
+#define STREAM_ACCEPT_INTERVAL_NS (250 * U_TIME_1MS_IN_NS)
+
+/*!
+ * An encoded record, waiting for the writer thread.
+ */
+struct queued_record
+{
+	size_t size;
+	uint8_t data[monado_metrics_Record_size + 10]; // Including submessage
+};
+
+// Only touched by the writer thread once it has been started.
 static FILE *g_file = NULL;
-static struct os_mutex g_file_mutex;
+static uint8_t g_batch[BATCH_SIZE];
+
 static bool g_metrics_initialized = false;
 static bool g_metrics_early_flush = false;
 
+//! Records are only collected when there is a file or a subscriber to take them.
+static volatile bool g_metrics_active = false;
+
+/*
+ * Records are encoded on the calling thread, usually the compositor or a
+ * client thread, and written out by the writer thread so that they never wait
+ * on I/O. If the writer falls behind records are dropped.
+ */
+static struct u_mpsc_ring g_queue;
+static struct queued_record *g_records;
+static struct os_semaphore g_sem;
+static struct os_thread g_writer;
+static volatile bool g_writer_running;
+static xrt_atomic_s32_t g_dropped;
+
+#ifdef XRT_OS_LINUX
+/*
+ * Live stream of the same records to local subscribers, over a seqpacket
+ * socket so each batch arrives whole or not at all: a subscriber that doesn't
+ * keep up loses batches but always sees complete records. Only touched by the
+ * writer thread, which also accepts new subscribers.
+ */
+static struct
+{
+	int listen_fd;
+	int fds[STREAM_MAX_SUBSCRIBERS];
+	uint32_t fd_count;
+	char path[sizeof(((struct sockaddr_un *)NULL)->sun_path)];
+} g_stream = {.listen_fd = -1};
+#endif
+
 DEBUG_GET_ONCE_OPTION(metrics_file, "XRT_METRICS_FILE", NULL)
 DEBUG_GET_ONCE_BOOL_OPTION(metrics_early_flush, "XRT_METRICS_EARLY_FLUSH", false)
+DEBUG_GET_ONCE_BOOL_OPTION(metrics_stream, "XRT_METRICS_STREAM", true)
 
 
 
@@ -36,45 +107,237 @@ DEBUG_GET_ONCE_BOOL_OPTION(metrics_early_flush, "XRT_METRICS_EARLY_FLUSH", false
  *
  */
 
+static bool
+encode_record(monado_metrics_Record *r, struct queued_record *qr)
+{
+	pb_ostream_t stream = pb_ostream_from_buffer(qr->data, sizeof(qr->data));
+	bool ret = pb_encode_submessage(&stream, &monado_metrics_Record_msg, r);
+
+	qr->size = ret ? stream.bytes_written : 0;
+
+	return ret;
+}
+
 static void
-write_record(monado_metrics_Record *r)
+encode_version(struct queued_record *qr)
 {
-	uint8_t buffer[monado_metrics_Record_size + 10]; // Including submessage
+	monado_metrics_Record record = monado_metrics_Record_init_default;
 
+	// Select which filed is used.
+	record.which_record = monado_metrics_Record_version_tag;
+	record.record.version.major = VERSION_MAJOR;
+	record.record.version.minor = VERSION_MINOR;
 
-	pb_ostream_t stream = pb_ostream_from_buffer(buffer, sizeof(buffer));
-	bool ret = pb_encode_submessage(&stream, &monado_metrics_Record_msg, r);
-	if (!ret) {
-		U_LOG_E("Failed to encode metrics message!");
-		return;
+	encode_record(&record, qr);
+}
+
+static void
+update_active(void)
+{
+	bool have_subscribers = false;
+#ifdef XRT_OS_LINUX
+	have_subscribers = g_stream.fd_count > 0;
+#endif
+
+	g_metrics_active = g_file != NULL || have_subscribers;
+}
+
+#ifdef XRT_OS_LINUX
+static void
+stream_remove(uint32_t index)
+{
+	close(g_stream.fds[index]);
+	g_stream.fds[index] = g_stream.fds[--g_stream.fd_count];
+
+	update_active();
+}
+
+static bool
+stream_open(void)
+{
+	ssize_t ret = u_file_get_path_in_runtime_dir(STREAM_SOCKET_FILENAME, g_stream.path, sizeof(g_stream.path));
+	if (ret <= 0 || (size_t)ret >= sizeof(g_stream.path)) {
+		U_LOG_E("Could not get metrics socket path!");
+		return false;
+	}
+
+	int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		U_LOG_E("socket: %s", strerror(errno));
+		return false;
+	}
+
+	struct sockaddr_un addr = {.sun_family = AF_UNIX};
+	snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", g_stream.path);
+
+	// Left behind by a service that didn't exit cleanly.
+	unlink(g_stream.path);
+
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, STREAM_MAX_SUBSCRIBERS) < 0) {
+		U_LOG_E("Could not listen on '%s': %s", g_stream.path, strerror(errno));
+		close(fd);
+		return false;
+	}
+
+	g_stream.listen_fd = fd;
+
+	return true;
+}
+
+static void
+stream_accept(void)
+{
+	while (true) {
+		int fd = accept4(g_stream.listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd < 0) {
+			return;
+		}
+
+		if (g_stream.fd_count >= STREAM_MAX_SUBSCRIBERS) {
+			U_LOG_W("Too many metrics subscribers, closing new one");
+			close(fd);
+			continue;
+		}
+
+		// Every subscriber starts with the version, like the file.
+		struct queued_record version;
+		encode_version(&version);
+		if (send(fd, version.data, version.size, MSG_NOSIGNAL) < 0) {
+			close(fd);
+			continue;
+		}
+
+		g_stream.fds[g_stream.fd_count++] = fd;
+		U_LOG_I("New metrics subscriber (%u total)", g_stream.fd_count);
+	}
+}
+
+static void
+stream_send(const uint8_t *data, size_t size)
+{
+	for (uint32_t i = 0; i < g_stream.fd_count;) {
+		ssize_t ret = send(g_stream.fds[i], data, size, MSG_NOSIGNAL);
+		if (ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+			// Gone, or unable to take this big a batch.
+			U_LOG_I("Metrics subscriber left: %s", strerror(errno));
+			stream_remove(i);
+			continue;
+		}
+		i++;
+	}
+}
+
+static void
+stream_close(void)
+{
+	while (g_stream.fd_count > 0) {
+		stream_remove(0);
+	}
+
+	if (g_stream.listen_fd >= 0) {
+		close(g_stream.listen_fd);
+		unlink(g_stream.path);
+		g_stream.listen_fd = -1;
+	}
+}
+#endif
+
+static void
+write_batch(const uint8_t *data, size_t size)
+{
+	if (g_file != NULL) {
+		fwrite(data, size, 1, g_file);
+	}
+
+#ifdef XRT_OS_LINUX
+	stream_send(data, size);
+#endif
+}
+
+static void
+write_queued(void)
+{
+	size_t used = 0;
+	uint32_t slot;
+
+	while (u_mpsc_ring_peek(&g_queue, &slot)) {
+		struct queued_record *qr = &g_records[slot];
+
+		if (used + qr->size > sizeof(g_batch)) {
+			write_batch(g_batch, used);
+			used = 0;
+		}
+
+		memcpy(g_batch + used, qr->data, qr->size);
+		used += qr->size;
+
+		u_mpsc_ring_release(&g_queue);
 	}
 
-	os_mutex_lock(&g_file_mutex);
+	if (used == 0) {
+		return;
+	}
 
-	fwrite(buffer, stream.bytes_written, 1, g_file);
+	write_batch(g_batch, used);
 
-	if (g_metrics_early_flush) {
+	if (g_metrics_early_flush && g_file != NULL) {
 		fflush(g_file);
 	}
+}
+
+static void *
+writer_run(void *ptr)
+{
+	(void)ptr;
+
+	uint64_t last_accept_ns = 0;
+
+	while (g_writer_running) {
+		uint64_t timeout_ns = 0;
+#ifdef XRT_OS_LINUX
+		// Wake up now and then to let new subscribers in, not for every batch.
+		uint64_t now_ns = os_monotonic_get_ns();
+		if (g_stream.listen_fd >= 0 && now_ns - last_accept_ns >= STREAM_ACCEPT_INTERVAL_NS) {
+			stream_accept();
+			update_active();
+			last_accept_ns = now_ns;
+		}
+		if (g_stream.listen_fd >= 0) {
+			timeout_ns = STREAM_ACCEPT_INTERVAL_NS;
+		}
+#endif
+
+		os_semaphore_wait(&g_sem, timeout_ns);
+
+		write_queued();
+	}
+
+	// Anything queued before the stop.
+	write_queued();
 
-	os_mutex_unlock(&g_file_mutex);
+	return NULL;
 }
 
 static void
-write_version(uint32_t major, uint32_t minor)
+write_record(monado_metrics_Record *r)
 {
-	if (!g_metrics_initialized) {
+	uint32_t ticket;
+	if (!u_mpsc_ring_claim(&g_queue, &ticket)) {
+		xrt_atomic_s32_inc_return(&g_dropped);
+		U_LOG_W_RATELIMITED("Metrics writer is behind, dropping records!");
 		return;
 	}
 
-	monado_metrics_Record record = monado_metrics_Record_init_default;
+	struct queued_record *qr = &g_records[u_mpsc_ring_slot(&g_queue, ticket)];
 
-	// Select which filed is used.
-	record.which_record = monado_metrics_Record_version_tag;
-	record.record.version.major = major;
-	record.record.version.minor = minor;
+	// The slot is claimed, publish it empty if this fails.
+	if (!encode_record(r, qr)) {
+		U_LOG_E("Failed to encode metrics message!");
+	}
 
-	write_record(&record);
+	u_mpsc_ring_publish(&g_queue, ticket);
+
+	os_semaphore_release(&g_sem);
 }
 
 
@@ -88,25 +351,75 @@ void
 u_metrics_init(void)
 {
 	const char *str = debug_get_option_metrics_file();
-	if (str == NULL) {
+	if (str != NULL) {
+		g_file = fopen(str, "wb");
+		if (g_file == NULL) {
+			U_LOG_E("Could not open '%s'!", str);
+		}
+	} else {
 		U_LOG_D("No metrics file!");
-		return;
 	}
 
-	g_file = fopen(str, "wb");
-	if (g_file == NULL) {
-		U_LOG_E("Could not open '%s'!", str);
+	bool have_stream = false;
+#ifdef XRT_OS_LINUX
+	if (debug_get_bool_option_metrics_stream()) {
+		have_stream = stream_open();
+	}
+#endif
+
+	if (g_file == NULL && !have_stream) {
 		return;
 	}
 
-	os_mutex_init(&g_file_mutex);
+	u_mpsc_ring_init(&g_queue, QUEUE_RECORD_COUNT);
+	g_records = U_TYPED_ARRAY_CALLOC(struct queued_record, u_mpsc_ring_size(&g_queue));
+	g_dropped = 0;
+
+	if (g_file != NULL) {
+		// The version record starts the file, subscribers get their own.
+		struct queued_record version;
+		encode_version(&version);
+		fwrite(version.data, version.size, 1, g_file);
+	}
+
+	os_semaphore_init(&g_sem, 0);
+	os_thread_init(&g_writer);
 
-	g_metrics_initialized = true;
 	g_metrics_early_flush = debug_get_bool_option_metrics_early_flush();
+	g_writer_running = true;
+
+	if (os_thread_start(&g_writer, writer_run, NULL) != 0) {
+		U_LOG_E("Could not start metrics writer thread!");
+		g_writer_running = false;
+		os_thread_destroy(&g_writer);
+		os_semaphore_destroy(&g_sem);
+		free(g_records);
+		g_records = NULL;
+		u_mpsc_ring_fini(&g_queue);
+#ifdef XRT_OS_LINUX
+		stream_close();
+#endif
+		if (g_file != NULL) {
+			fclose(g_file);
+			g_file = NULL;
+		}
+		return;
+	}
+	os_thread_name(&g_writer, "Metrics Writer");
+
+	g_metrics_initialized = true;
 
-	write_version(VERSION_MAJOR, VERSION_MINOR);
+	if (g_file != NULL) {
+		U_LOG_I("Opened metrics file: '%s'", str);
+	}
+
+#ifdef XRT_OS_LINUX
+	if (have_stream) {
+		U_LOG_I("Streaming metrics on: '%s'", g_stream.path);
+	}
+#endif
 
-	U_LOG_I("Opened metrics file: '%s'", str);
+	update_active();
 }
 
 void
@@ -116,30 +429,47 @@ u_metrics_close(void)
 		return;
 	}
 
-	U_LOG_I("Closing metrics file: '%s'", debug_get_option_metrics_file());
+	g_metrics_active = false;
+	g_metrics_initialized = false;
+
+	// The writer writes out what is queued before exiting.
+	g_writer_running = false;
+	os_semaphore_release(&g_sem);
+	os_thread_join(&g_writer);
+	os_thread_destroy(&g_writer);
+	os_semaphore_destroy(&g_sem);
+
+	if (g_dropped > 0) {
+		U_LOG_W("Dropped %d metrics records, the writer fell behind", g_dropped);
+	}
 
-	// At least try to avoid races.
-	os_mutex_lock(&g_file_mutex);
-	fflush(g_file);
-	fclose(g_file);
-	g_file = NULL;
-	os_mutex_unlock(&g_file_mutex);
+#ifdef XRT_OS_LINUX
+	stream_close();
+#endif
 
-	os_mutex_destroy(&g_file_mutex);
+	if (g_file != NULL) {
+		U_LOG_I("Closing metrics file: '%s'", debug_get_option_metrics_file());
 
-	g_metrics_initialized = false;
+		fflush(g_file);
+		fclose(g_file);
+		g_file = NULL;
+	}
+
+	free(g_records);
+	g_records = NULL;
+	u_mpsc_ring_fini(&g_queue);
 }
 
 bool
 u_metrics_is_active(void)
 {
-	return g_metrics_initialized;
+	return g_metrics_active;
 }
 
 void
 u_metrics_write_session_frame(struct u_metrics_session_frame *umsf)
 {
-	if (!g_metrics_initialized) {
+	if (!g_metrics_active) {
 		return;
 	}
 
@@ -159,7 +489,7 @@ u_metrics_write_session_frame(struct u_metrics_session_frame *umsf)
 void
 u_metrics_write_used(struct u_metrics_used *umu)
 {
-	if (!g_metrics_initialized) {
+	if (!g_metrics_active) {
 		return;
 	}
 
@@ -179,7 +509,7 @@ u_metrics_write_used(struct u_metrics_used *umu)
 void
 u_metrics_write_system_frame(struct u_metrics_system_frame *umsf)
 {
-	if (!g_metrics_initialized) {
+	if (!g_metrics_active) {
 		return;
 	}
 
@@ -199,7 +529,7 @@ u_metrics_write_system_frame(struct u_metrics_system_frame *umsf)
 void
 u_metrics_write_system_gpu_info(struct u_metrics_system_gpu_info *umgi)
 {
-	if (!g_metrics_initialized) {
+	if (!g_metrics_active) {
 		return;
 	}
 
@@ -219,7 +549,7 @@ u_metrics_write_system_gpu_info(struct u_metrics_system_gpu_info *umgi)
 void
 u_metrics_write_system_present_info(struct u_metrics_system_present_info *umpi)
 {
-	if (!g_metrics_initialized) {
+	if (!g_metrics_active) {
 		return;
 	}
 
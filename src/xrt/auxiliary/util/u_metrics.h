@@ -80,12 +80,22 @@ struct u_metrics_system_present_info
 };
 
 
+/*!
+ * Opens the `XRT_METRICS_FILE` file if set and, on Linux, the live stream
+ * socket `monado_metrics` in the runtime dir unless `XRT_METRICS_STREAM` is
+ * false. Subscribers to the socket get the same delimited records as the file,
+ * starting with the version record, in seqpacket sized batches.
+ */
 void
 u_metrics_init(void);
 
 void
 u_metrics_close(void);
 
+/*!
+ * True if there is a file or a stream subscriber to take records, there is no
+ * need to collect them otherwise.
+ */
 bool
 u_metrics_is_active(void);
 
@@ -0,0 +1,112 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Bounded lock-free multiple producer single consumer ring.
+ * @ingroup aux_util
+ */
+
+#include "util/u_mpsc_ring.h"
+#include "util/u_misc.h"
+
+
+static inline int32_t
+seq_diff(int32_t a, int32_t b)
+{
+	// Tickets wrap around, avoid signed overflow.
+	return (int32_t)((uint32_t)a - (uint32_t)b);
+}
+
+static inline int32_t
+seq_add(int32_t a, uint32_t b)
+{
+	return (int32_t)((uint32_t)a + b);
+}
+
+void
+u_mpsc_ring_init(struct u_mpsc_ring *ring, uint32_t size)
+{
+	// Round up to a power of two, the ring needs at least two slots.
+	uint32_t n = 2;
+	while (n < size) {
+		n *= 2;
+	}
+
+	U_ZERO(ring);
+	ring->seqs = U_TYPED_ARRAY_CALLOC(xrt_atomic_s32_t, n);
+	ring->mask = n - 1;
+
+	for (uint32_t i = 0; i < n; i++) {
+		ring->seqs[i] = (int32_t)i;
+	}
+}
+
+void
+u_mpsc_ring_fini(struct u_mpsc_ring *ring)
+{
+	free((void *)ring->seqs);
+	U_ZERO(ring);
+}
+
+bool
+u_mpsc_ring_claim(struct u_mpsc_ring *ring, uint32_t *out_ticket)
+{
+	int32_t pos = ring->head;
+
+	while (true) {
+		int32_t diff = seq_diff(ring->seqs[(uint32_t)pos & ring->mask], pos);
+
+		if (diff < 0) {
+			// Still holds the payload from the last lap, full.
+			return false;
+		}
+
+		if (diff > 0) {
+			// Another producer got it, try again with a fresh head.
+			pos = ring->head;
+			continue;
+		}
+
+		int32_t old = xrt_atomic_s32_cmpxchg(&ring->head, pos, seq_add(pos, 1));
+		if (old == pos) {
+			*out_ticket = (uint32_t)pos;
+			return true;
+		}
+		pos = old;
+	}
+}
+
+void
+u_mpsc_ring_publish(struct u_mpsc_ring *ring, uint32_t ticket)
+{
+	// The payload must be visible before the slot is.
+	xrt_atomic_thread_fence();
+	ring->seqs[ticket & ring->mask] = seq_add((int32_t)ticket, 1);
+}
+
+bool
+u_mpsc_ring_peek(struct u_mpsc_ring *ring, uint32_t *out_slot)
+{
+	uint32_t slot = (uint32_t)ring->tail & ring->mask;
+
+	if (ring->seqs[slot] != seq_add(ring->tail, 1)) {
+		return false;
+	}
+
+	// Don't read the payload before the slot was published.
+	xrt_atomic_thread_fence();
+
+	*out_slot = slot;
+	return true;
+}
+
+void
+u_mpsc_ring_release(struct u_mpsc_ring *ring)
+{
+	uint32_t slot = (uint32_t)ring->tail & ring->mask;
+
+	// Done with the payload before handing it back, one lap later.
+	xrt_atomic_thread_fence();
+	ring->seqs[slot] = seq_add(ring->tail, ring->mask + 1);
+	ring->tail = seq_add(ring->tail, 1);
+}
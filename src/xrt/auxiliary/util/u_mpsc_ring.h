@@ -0,0 +1,123 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Bounded lock-free multiple producer single consumer ring.
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * A bounded lock-free ring that hands out slots to any number of producers and
+ * gives them back to one consumer in claim order. It only tracks the slots,
+ * the user keeps an array of @ref u_mpsc_ring_size payloads and indexes it
+ * with @ref u_mpsc_ring_slot.
+ *
+ * A producer claims a ticket, fills in the payload of its slot and publishes
+ * it. Claiming fails instead of blocking when the consumer has fallen behind
+ * and all slots are in use. The consumer peeks at the oldest slot, which is
+ * only available once published, and releases it when done with the payload.
+ *
+ * @ingroup aux_util
+ */
+struct u_mpsc_ring
+{
+	/*!
+	 * Per slot turn: the ticket that may claim it when free, that ticket
+	 * plus one once published.
+	 */
+	xrt_atomic_s32_t *seqs;
+
+	//! Number of slots minus one, the number is a power of two.
+	uint32_t mask;
+
+	//! Next ticket to be claimed.
+	xrt_atomic_s32_t head;
+
+	//! Next ticket the consumer waits for, only used by the consumer.
+	int32_t tail;
+};
+
+/*!
+ * Allocates at least @p size slots, rounded up to a power of two.
+ *
+ * @public @memberof u_mpsc_ring
+ */
+void
+u_mpsc_ring_init(struct u_mpsc_ring *ring, uint32_t size);
+
+/*!
+ * @public @memberof u_mpsc_ring
+ */
+void
+u_mpsc_ring_fini(struct u_mpsc_ring *ring);
+
+/*!
+ * Number of slots, the size of the payload array.
+ *
+ * @public @memberof u_mpsc_ring
+ */
+static inline uint32_t
+u_mpsc_ring_size(const struct u_mpsc_ring *ring)
+{
+	return ring->mask + 1;
+}
+
+/*!
+ * Slot of a ticket, an index into the payload array.
+ *
+ * @public @memberof u_mpsc_ring
+ */
+static inline uint32_t
+u_mpsc_ring_slot(const struct u_mpsc_ring *ring, uint32_t ticket)
+{
+	return ticket & ring->mask;
+}
+
+/*!
+ * Claims a slot for a producer, safe to call from any thread.
+ *
+ * @return false if the ring is full.
+ * @public @memberof u_mpsc_ring
+ */
+bool
+u_mpsc_ring_claim(struct u_mpsc_ring *ring, uint32_t *out_ticket);
+
+/*!
+ * Hands a claimed and filled in slot over to the consumer.
+ *
+ * @public @memberof u_mpsc_ring
+ */
+void
+u_mpsc_ring_publish(struct u_mpsc_ring *ring, uint32_t ticket);
+
+/*!
+ * Gets the oldest slot if it has been published, only call from the consumer.
+ *
+ * @return false if there is nothing to consume.
+ * @public @memberof u_mpsc_ring
+ */
+bool
+u_mpsc_ring_peek(struct u_mpsc_ring *ring, uint32_t *out_slot);
+
+/*!
+ * Gives the slot from @ref u_mpsc_ring_peek back to the producers, only call
+ * from the consumer.
+ *
+ * @public @memberof u_mpsc_ring
+ */
+void
+u_mpsc_ring_release(struct u_mpsc_ring *ring);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -326,6 +326,29 @@ u_pc_destroy(struct u_pacing_compositor **upc_ptr)
  *
  */
 
+/*!
+ * Measured timings of the frames of a client, see @ref u_pacing_app::get_stats.
+ *
+ * @ingroup aux_pacing
+ */
+struct u_pacing_app_stats
+{
+	//! Filtered CPU time, from the app waking up until it delivered the frame.
+	uint64_t cpu_time_ns;
+
+	//! Filtered GPU time, from the frame being delivered until the GPU completed it.
+	uint64_t gpu_time_ns;
+
+	//! Filtered time from the app waking up until the frame is to be displayed.
+	uint64_t latency_ns;
+
+	//! Frames that were delivered or discarded.
+	uint64_t frame_count;
+
+	//! Frames that were discarded or missed the time they needed to be done by.
+	uint64_t missed_count;
+};
+
 /*!
  * This application pacing helper is designed to schedule the rendering time of
  * clients that submit frames to a compositor, which runs its own render loop
@@ -448,6 +471,34 @@ struct u_pacing_app
 	             uint64_t predicted_display_period_ns,
 	             uint64_t extra_ns);
 
+	/*!
+	 * Get the measured time the client's GPU work takes, from the frame being
+	 * delivered to the GPU completing it. Used by the thing driving this
+	 * helper to arbitrate between multiple clients sharing the GPU.
+	 *
+	 * @param upa                 Self pointer
+	 * @param[out] out_gpu_time_ns Measured GPU time of the client's frames.
+	 */
+	void (*get_gpu_time)(struct u_pacing_app *upa, uint64_t *out_gpu_time_ns);
+
+	/*!
+	 * Get the measured timings of the client's frames, for reporting them
+	 * back to the client.
+	 *
+	 * @param upa            Self pointer
+	 * @param[out] out_stats Measured timings.
+	 */
+	void (*get_stats)(struct u_pacing_app *upa, struct u_pacing_app_stats *out_stats);
+
+	/*!
+	 * Limit the rate the client is paced at, it will only be given every
+	 * @p rate_divisor display period to render for, one is full rate.
+	 *
+	 * @param upa          Self pointer
+	 * @param rate_divisor Divisor of the display rate, zero is treated as one.
+	 */
+	void (*set_rate_divisor)(struct u_pacing_app *upa, uint32_t rate_divisor);
+
 	/*!
 	 * Destroy this u_pacing_app.
 	 */
@@ -547,6 +598,48 @@ u_pa_info(struct u_pacing_app *upa,
 	upa->info(upa, predicted_display_time_ns, predicted_display_period_ns, extra_ns);
 }
 
+/*!
+ * @copydoc u_pacing_app::get_gpu_time
+ *
+ * Helper for calling through the function pointer.
+ *
+ * @public @memberof u_pacing_app
+ * @ingroup aux_pacing
+ */
+static inline void
+u_pa_get_gpu_time(struct u_pacing_app *upa, uint64_t *out_gpu_time_ns)
+{
+	upa->get_gpu_time(upa, out_gpu_time_ns);
+}
+
+/*!
+ * @copydoc u_pacing_app::get_stats
+ *
+ * Helper for calling through the function pointer.
+ *
+ * @public @memberof u_pacing_app
+ * @ingroup aux_pacing
+ */
+static inline void
+u_pa_get_stats(struct u_pacing_app *upa, struct u_pacing_app_stats *out_stats)
+{
+	upa->get_stats(upa, out_stats);
+}
+
+/*!
+ * @copydoc u_pacing_app::set_rate_divisor
+ *
+ * Helper for calling through the function pointer.
+ *
+ * @public @memberof u_pacing_app
+ * @ingroup aux_pacing
+ */
+static inline void
+u_pa_set_rate_divisor(struct u_pacing_app *upa, uint32_t rate_divisor)
+{
+	upa->set_rate_divisor(upa, rate_divisor);
+}
+
 /*!
  * @copydoc u_pacing_app::latched
  *
@@ -659,6 +752,107 @@ u_paf_destroy(struct u_pacing_app_factory **upaf_ptr)
 }
 
 
+/*
+ *
+ * Compositor frame timing records.
+ *
+ */
+
+/*!
+ * Number of records kept by the process wide ring, see
+ * @ref u_pc_frame_records_read.
+ *
+ * @ingroup aux_pacing
+ */
+#define U_PC_FRAME_RECORD_COUNT (256)
+
+/*!
+ * What is valid in a @ref u_pc_frame_record.
+ *
+ * @ingroup aux_pacing
+ */
+enum u_pc_frame_record_flags
+{
+	//! The CPU begin and end times are valid.
+	U_PC_FRAME_RECORD_CPU_BIT = (1u << 0u),
+	//! The GPU start and end times are valid.
+	U_PC_FRAME_RECORD_GPU_BIT = (1u << 1u),
+	//! The actual vblank time is valid, from display timing.
+	U_PC_FRAME_RECORD_VBLANK_BIT = (1u << 2u),
+	//! The frame missed the desired present time.
+	U_PC_FRAME_RECORD_MISSED_BIT = (1u << 3u),
+};
+
+/*!
+ * Timing of one compositor frame, pushed by the @ref u_pacing_compositor
+ * implementations once all information they get about a frame has arrived.
+ * This struct is sent as is over IPC, so only append fields to it.
+ *
+ * @ingroup aux_pacing
+ */
+struct u_pc_frame_record
+{
+	int64_t frame_id;
+
+	//! Began and submitted the CPU side work for the GPU.
+	uint64_t cpu_begin_ns;
+	uint64_t cpu_end_ns;
+
+	//! When the GPU work started and stopped.
+	uint64_t gpu_start_ns;
+	uint64_t gpu_end_ns;
+
+	//! When the GPU should start scanning out, what the compositor aimed for.
+	uint64_t desired_present_time_ns;
+
+	//! When the GPU actually started scanning out.
+	uint64_t actual_vblank_ns;
+
+	//! Bitmask of @ref u_pc_frame_record_flags.
+	uint32_t flags;
+};
+
+/*!
+ * Push a record into the process wide ring, only one thread may push at a
+ * time, which is the compositor thread. Never blocks, readers don't hold up
+ * the writer, if they fall behind they lose the oldest records.
+ *
+ * @ingroup aux_pacing
+ */
+void
+u_pc_frame_records_push(const struct u_pc_frame_record *record);
+
+/*!
+ * Copy out records in the order they were pushed, starting at sequence
+ * number @p inout_next which is updated to continue from on the next call,
+ * start with zero. If the records have been overwritten reading starts at the
+ * oldest available one. Lock-free and safe to call from any thread.
+ *
+ * @return The number of records copied, at most @p max_count.
+ *
+ * @ingroup aux_pacing
+ */
+uint32_t
+u_pc_frame_records_read(uint32_t *inout_next, struct u_pc_frame_record *out_records, uint32_t max_count);
+
+/*!
+ * Process wide switch for the in headset overlay that the compositor draws
+ * from the frame records, set over IPC by `monado-ctl`.
+ *
+ * @ingroup aux_pacing
+ */
+void
+u_pc_overlay_set_enabled(bool enabled);
+
+/*!
+ * See @ref u_pc_overlay_set_enabled, safe to call from any thread.
+ *
+ * @ingroup aux_pacing
+ */
+bool
+u_pc_overlay_get_enabled(void);
+
+
 /*
  *
  * Configuration struct
@@ -692,6 +886,14 @@ struct u_pc_display_timing_config
 	/*!
 	 * @}
 	 */
+
+	/*!
+	 * Fraction of frames allowed to miss in parts per million. If not zero
+	 * the compositor time is learned from the statistics of the CPU, GPU
+	 * and present stages of the frames, aiming for this miss rate, instead
+	 * of using the adjust values. `U_PACING_COMP_ADAPTIVE=false` disables.
+	 */
+	uint32_t target_miss_ppm;
 };
 
 /*!
@@ -24,6 +24,7 @@
 
 DEBUG_GET_ONCE_LOG_OPTION(log_level, "U_PACING_APP_LOG", U_LOGGING_WARN)
 DEBUG_GET_ONCE_FLOAT_OPTION(min_app_time_ms, "U_PACING_APP_MIN_TIME_MS", 1.0f)
+DEBUG_GET_ONCE_NUM_OPTION(half_rate_miss_percent, "U_PACING_APP_HALF_RATE_MISS_PERCENT", 0)
 
 #define UPA_LOG_T(...) U_LOG_IFL_T(debug_get_log_option_log_level(), __VA_ARGS__)
 #define UPA_LOG_D(...) U_LOG_IFL_D(debug_get_log_option_log_level(), __VA_ARGS__)
@@ -52,6 +53,9 @@ DEBUG_GET_ONCE_FLOAT_OPTION(min_app_time_ms, "U_PACING_APP_MIN_TIME_MS", 1.0f)
  */
 #define FRAME_COUNT (128)
 
+//! Number of frames the miss rate is measured over before switching to or from half rate.
+#define HALF_RATE_WINDOW (90)
+
 enum u_pa_state
 {
 	U_PA_READY,
@@ -139,6 +143,11 @@ struct pacing_app
 		uint64_t wait_time_ns;
 		//! Extra time between end of draw time and when the compositor wakes up.
 		uint64_t margin_ns;
+		//! Time between wait returning and the frame being displayed.
+		uint64_t latency_ns;
+		//! Frames delivered or discarded, and how many of them missed.
+		uint64_t frame_count;
+		uint64_t missed_count;
 	} app; //!< App statistics.
 
 	struct
@@ -149,9 +158,29 @@ struct pacing_app
 		uint64_t predicted_display_period_ns;
 		//! The extra time needed by the thing driving this helper.
 		uint64_t extra_ns;
+		//! Only every this many display periods is used, set by the thing driving this helper.
+		uint32_t rate_divisor;
 	} last_input;
 
 	uint64_t last_returned_ns;
+
+	/*!
+	 * When too many frames miss their deadline the app is paced at half the
+	 * rate, the compositor reprojects every frame twice which looks much
+	 * better than a frame repeated at random. Goes back to full rate once
+	 * the app comfortably fits in a single period again.
+	 */
+	struct
+	{
+		//! Late frames in percent that switches to half rate, zero disables it.
+		uint32_t threshold_percent;
+
+		//! Frames and late frames in the current window.
+		uint32_t frames;
+		uint32_t late;
+
+		bool active;
+	} half_rate;
 };
 
 
@@ -215,7 +244,9 @@ do_iir_filter(uint64_t *target, double alpha_lt, double alpha_gt, uint64_t sampl
 static uint64_t
 min_period(const struct pacing_app *pa)
 {
-	return pa->last_input.predicted_display_period_ns;
+	uint64_t period_ns = pa->last_input.predicted_display_period_ns * pa->last_input.rate_divisor;
+
+	return pa->half_rate.active ? period_ns * 2 : period_ns;
 }
 
 static uint64_t
@@ -314,6 +345,43 @@ predict_display_time(const struct pacing_app *pa, uint64_t now_ns, uint64_t peri
 }
 
 
+static void
+update_half_rate(struct pacing_app *pa, bool late)
+{
+	if (pa->half_rate.threshold_percent == 0) {
+		return;
+	}
+
+	pa->half_rate.frames++;
+	pa->half_rate.late += late ? 1 : 0;
+
+	if (pa->half_rate.frames < HALF_RATE_WINDOW) {
+		return;
+	}
+
+	uint32_t late_percent = pa->half_rate.late * 100 / pa->half_rate.frames;
+	pa->half_rate.frames = 0;
+	pa->half_rate.late = 0;
+
+	if (!pa->half_rate.active) {
+		if (late_percent >= pa->half_rate.threshold_percent) {
+			UPA_LOG_I("%u%% of frames late, switching to half rate", late_percent);
+			pa->half_rate.active = true;
+		}
+		return;
+	}
+
+	// Leave some headroom so it doesn't flip back and forth.
+	uint64_t full_period_ns = pa->last_input.predicted_display_period_ns * pa->last_input.rate_divisor;
+	uint64_t headroom_ns = full_period_ns * 3 / 4;
+	if (pa->app.cpu_time_ns < headroom_ns && pa->app.draw_time_ns < headroom_ns &&
+	    pa->app.wait_time_ns < headroom_ns) {
+		UPA_LOG_I("App fits in a period again, switching to full rate");
+		pa->half_rate.active = false;
+	}
+}
+
+
 /*
  *
  * Metrics and tracing.
@@ -512,6 +580,11 @@ pa_mark_discarded(struct u_pacing_app *upa, int64_t frame_id, uint64_t when_ns)
 	// Update all data.
 	f->when.delivered_ns = when_ns;
 
+	// A discarded frame was never shown.
+	update_half_rate(pa, true);
+	pa->app.frame_count++;
+	pa->app.missed_count++;
+
 	// Write out metrics data.
 	do_metrics(pa, f, true);
 
@@ -588,6 +661,14 @@ pa_mark_gpu_done(struct u_pacing_app *upa, int64_t frame_id, uint64_t when_ns)
 	do_iir_filter(&pa->app.cpu_time_ns, IIR_ALPHA_LT, IIR_ALPHA_GT, diff_cpu_ns);
 	do_iir_filter(&pa->app.draw_time_ns, IIR_ALPHA_LT, IIR_ALPHA_GT, diff_draw_ns);
 	do_iir_filter(&pa->app.wait_time_ns, IIR_ALPHA_LT, IIR_ALPHA_GT, diff_wait_ns);
+	if (f->display_time_ns > f->when.wait_woke_ns) {
+		uint64_t diff_latency_ns = f->display_time_ns - f->when.wait_woke_ns;
+		do_iir_filter(&pa->app.latency_ns, IIR_ALPHA_LT, IIR_ALPHA_GT, diff_latency_ns);
+	}
+
+	update_half_rate(pa, late);
+	pa->app.frame_count++;
+	pa->app.missed_count += late ? 1 : 0;
 
 	// Write out metrics and tracing data.
 	do_metrics(pa, f, false);
@@ -658,6 +739,34 @@ pa_info(struct u_pacing_app *upa,
 	pa->last_input.extra_ns = extra_ns;
 }
 
+static void
+pa_get_gpu_time(struct u_pacing_app *upa, uint64_t *out_gpu_time_ns)
+{
+	struct pacing_app *pa = pacing_app(upa);
+
+	*out_gpu_time_ns = pa->app.wait_time_ns;
+}
+
+static void
+pa_get_stats(struct u_pacing_app *upa, struct u_pacing_app_stats *out_stats)
+{
+	struct pacing_app *pa = pacing_app(upa);
+
+	out_stats->cpu_time_ns = pa->app.cpu_time_ns + pa->app.draw_time_ns;
+	out_stats->gpu_time_ns = pa->app.wait_time_ns;
+	out_stats->latency_ns = pa->app.latency_ns;
+	out_stats->frame_count = pa->app.frame_count;
+	out_stats->missed_count = pa->app.missed_count;
+}
+
+static void
+pa_set_rate_divisor(struct u_pacing_app *upa, uint32_t rate_divisor)
+{
+	struct pacing_app *pa = pacing_app(upa);
+
+	pa->last_input.rate_divisor = rate_divisor > 0 ? rate_divisor : 1;
+}
+
 static void
 pa_destroy(struct u_pacing_app *upa)
 {
@@ -678,11 +787,16 @@ pa_create(int64_t session_id, struct u_pacing_app **out_upa)
 	pa->base.latched = pa_latched;
 	pa->base.retired = pa_retired;
 	pa->base.info = pa_info;
+	pa->base.get_gpu_time = pa_get_gpu_time;
+	pa->base.get_stats = pa_get_stats;
+	pa->base.set_rate_divisor = pa_set_rate_divisor;
 	pa->base.destroy = pa_destroy;
 	pa->session_id = session_id;
 	pa->app.cpu_time_ns = U_TIME_1MS_IN_NS * 2;
 	pa->app.draw_time_ns = U_TIME_1MS_IN_NS * 2;
 	pa->app.margin_ns = U_TIME_1MS_IN_NS * 2;
+	pa->last_input.rate_divisor = 1;
+	pa->half_rate.threshold_percent = (uint32_t)debug_get_num_option_half_rate_miss_percent();
 	pa->min_app_time_ms = (struct u_var_draggable_f32){
 	    .val = (float)debug_get_float_option_min_app_time_ms(),
 	    .min = 1.0, // This can never be negative.
@@ -701,6 +815,10 @@ pa_create(int64_t session_id, struct u_pacing_app **out_upa)
 	u_var_add_ro_u64(pa, &pa->app.cpu_time_ns, "CPU time(ns)");
 	u_var_add_ro_u64(pa, &pa->app.draw_time_ns, "Draw time(ns)");
 	u_var_add_ro_u64(pa, &pa->app.wait_time_ns, "GPU time(ns)");
+	u_var_add_ro_u64(pa, &pa->app.latency_ns, "Latency(ns)");
+	u_var_add_ro_u64(pa, &pa->app.missed_count, "Missed frames");
+	u_var_add_ro_u32(pa, &pa->half_rate.threshold_percent, "Half rate miss threshold(%)");
+	u_var_add_bool(pa, &pa->half_rate.active, "Half rate");
 
 	*out_upa = &pa->base;
 
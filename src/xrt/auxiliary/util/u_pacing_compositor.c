@@ -9,6 +9,8 @@
 
 #include "os/os_time.h"
 
+#include "math/m_api.h"
+
 #include "util/u_time.h"
 #include "util/u_misc.h"
 #include "util/u_debug.h"
@@ -17,11 +19,13 @@
 #include "util/u_logging.h"
 #include "util/u_trace_marker.h"
 
+#include <math.h>
 #include <stdio.h>
 #include <assert.h>
 #include <inttypes.h>
 
 DEBUG_GET_ONCE_LOG_OPTION(log_level, "U_PACING_COMPOSITOR_LOG", U_LOGGING_WARN)
+DEBUG_GET_ONCE_BOOL_OPTION(adaptive, "U_PACING_COMP_ADAPTIVE", true)
 
 #define UPC_LOG_T(...) U_LOG_IFL_T(debug_get_log_option_log_level(), __VA_ARGS__)
 #define UPC_LOG_D(...) U_LOG_IFL_D(debug_get_log_option_log_level(), __VA_ARGS__)
@@ -33,6 +37,15 @@ DEBUG_GET_ONCE_LOG_OPTION(log_level, "U_PACING_COMPOSITOR_LOG", U_LOGGING_WARN)
 
 #define PRESENT_SLOP_NS (U_TIME_HALF_MS_IN_NS)
 
+//! Weight of a new sample in the per stage statistics.
+#define ADAPTIVE_ALPHA (1.0 / 16.0)
+
+//! How much the safety factor grows on a missed frame, in standard deviations.
+#define ADAPTIVE_FACTOR_STEP (0.25)
+
+//! Upper limit of the safety factor, in standard deviations.
+#define ADAPTIVE_FACTOR_MAX (10.0)
+
 
 /*
  *
@@ -85,9 +98,40 @@ struct frame
 	uint64_t actual_present_time_ns;
 	uint64_t earliest_present_time_ns;
 
+	//! GPU work of this frame, set in `pc_info_gpu` if the compositor has timestamps.
+	uint64_t gpu_start_ns;
+	uint64_t gpu_end_ns;
+	bool has_gpu_info;
+
 	enum frame_state state;
 };
 
+/*!
+ * Exponentially weighted mean and variance of the duration of one stage of
+ * the compositor's frame.
+ */
+struct stage_stats
+{
+	double mean_ns;
+	double variance_ns2;
+	bool valid;
+};
+
+/*!
+ * The stages a frame goes through before it can be presented, the
+ * compositor time is budgeted from their statistics.
+ */
+enum stage
+{
+	//! From the predicted wake up, so it includes oversleeping, to GPU submit.
+	STAGE_CPU,
+	//! From submit to the GPU finishing, includes queueing on the GPU.
+	STAGE_GPU,
+	//! From the GPU finishing to the present being processed.
+	STAGE_PRESENT,
+	STAGE_COUNT,
+};
+
 struct pacing_compositor
 {
 	struct u_pacing_compositor base;
@@ -135,6 +179,27 @@ struct pacing_compositor
 	 */
 	uint64_t margin_ns;
 
+	/*!
+	 * Learn the compositor time from the per stage statistics, instead of
+	 * adjusting it in fixed steps.
+	 */
+	bool adaptive;
+
+	struct
+	{
+		struct stage_stats stages[STAGE_COUNT];
+
+		//! Fraction of frames we are fine with missing.
+		double target_miss_rate;
+
+		/*!
+		 * How many standard deviations of headroom are added to the
+		 * mean, adjusted on every frame so that the miss rate settles
+		 * at the target whatever the distribution of the stages.
+		 */
+		double factor;
+	} learned;
+
 	/*!
 	 * Frame store.
 	 */
@@ -227,6 +292,7 @@ create_frame(struct pacing_compositor *pc, enum frame_state state)
 
 	f->frame_id = frame_id;
 	f->state = state;
+	f->has_gpu_info = false;
 
 	return f;
 }
@@ -354,15 +420,22 @@ predict_next_frame(struct pacing_compositor *pc, uint64_t now_ns)
 	return f;
 }
 
+static bool
+is_frame_missed(const struct frame *f)
+{
+	return f->actual_present_time_ns > f->desired_present_time_ns &&
+	       !is_within_half_ms(f->actual_present_time_ns, f->desired_present_time_ns);
+}
+
 static void
 adjust_comp_time(struct pacing_compositor *pc, struct frame *f)
 {
 	uint64_t comp_time_ns = pc->comp_time_ns;
 
-	if (f->actual_present_time_ns > f->desired_present_time_ns &&
-	    !is_within_half_ms(f->actual_present_time_ns, f->desired_present_time_ns)) {
+	if (is_frame_missed(f)) {
 		double missed_ms = ns_to_ms(f->actual_present_time_ns - f->desired_present_time_ns);
 		UPC_LOG_W("Frame %" PRIu64 " missed by %.2f!", f->frame_id, missed_ms);
+		u_trace_recorder_request_dump("missed frame");
 
 		comp_time_ns += pc->adjust_missed_ns;
 		if (comp_time_ns > pc->comp_time_max_ns) {
@@ -393,6 +466,108 @@ adjust_comp_time(struct pacing_compositor *pc, struct frame *f)
 	}
 }
 
+/*!
+ * Inverse of the upper tail of the standard normal distribution, Abramowitz
+ * and Stegun 26.2.23, good to 4.5e-4 which is plenty for a starting point.
+ */
+static double
+normal_upper_tail_quantile(double p)
+{
+	double t = sqrt(-2.0 * log(p));
+	double num = 2.515517 + 0.802853 * t + 0.010328 * t * t;
+	double den = 1.0 + 1.432788 * t + 0.189269 * t * t + 0.001308 * t * t * t;
+	return t - num / den;
+}
+
+static void
+stage_stats_update(struct pacing_compositor *pc, enum stage stage, uint64_t sample_ns)
+{
+	struct stage_stats *s = &pc->learned.stages[stage];
+
+	// A stage taking longer than a frame tells us nothing more, don't let it blow up the variance.
+	double sample = (double)MIN(sample_ns, pc->frame_period_ns);
+
+	if (!s->valid) {
+		s->mean_ns = sample;
+		s->variance_ns2 = 0.0;
+		s->valid = true;
+		return;
+	}
+
+	double diff = sample - s->mean_ns;
+	double incr = ADAPTIVE_ALPHA * diff;
+	s->mean_ns += incr;
+	s->variance_ns2 = (1.0 - ADAPTIVE_ALPHA) * (s->variance_ns2 + diff * incr);
+}
+
+static uint64_t
+duration_or_zero(uint64_t start_ns, uint64_t end_ns)
+{
+	return end_ns > start_ns ? end_ns - start_ns : 0;
+}
+
+/*!
+ * Learn the time each stage of the frame took, and budget the compositor
+ * time as the sum of the means plus a safety factor times their combined
+ * standard deviation. The stages are treated as independent, the feedback on
+ * the factor corrects for it not being so.
+ */
+static void
+adjust_comp_time_learned(struct pacing_compositor *pc, struct frame *f)
+{
+	/*
+	 * When the present could first have been processed, the GPU was done
+	 * at the latest then. Not from the actual present time, that is held
+	 * back to the desired present time if the frame was early.
+	 */
+	uint64_t processed_ns = f->earliest_present_time_ns - f->present_margin_ns;
+
+	uint64_t gpu_done_ns = f->has_gpu_info ? f->gpu_end_ns : processed_ns;
+
+	stage_stats_update(pc, STAGE_CPU, duration_or_zero(f->wake_up_time_ns, f->when_submitted_ns));
+	stage_stats_update(pc, STAGE_GPU, duration_or_zero(f->when_submitted_ns, gpu_done_ns));
+	stage_stats_update(pc, STAGE_PRESENT, duration_or_zero(gpu_done_ns, processed_ns));
+
+	/*
+	 * Stochastic approximation of the quantile: stepping up on a miss and
+	 * down by the odds of the target otherwise is stable exactly when the
+	 * miss rate equals the target.
+	 */
+	double p = pc->learned.target_miss_rate;
+	if (is_frame_missed(f)) {
+		pc->learned.factor += ADAPTIVE_FACTOR_STEP;
+	} else {
+		pc->learned.factor -= ADAPTIVE_FACTOR_STEP * p / (1.0 - p);
+	}
+	pc->learned.factor = CLAMP(pc->learned.factor, 0.0, ADAPTIVE_FACTOR_MAX);
+
+	double mean_ns = 0.0;
+	double variance_ns2 = 0.0;
+	for (uint32_t i = 0; i < STAGE_COUNT; i++) {
+		mean_ns += pc->learned.stages[i].mean_ns;
+		variance_ns2 += pc->learned.stages[i].variance_ns2;
+	}
+
+	double comp_time_ns = mean_ns + pc->learned.factor * sqrt(variance_ns2);
+	pc->comp_time_ns = (uint64_t)fmin(comp_time_ns, (double)pc->comp_time_max_ns);
+
+	UPC_LOG_T(
+	    "Learned"
+	    "\n\tcpu_ms:       %.2f +- %.2f"                            //
+	    "\n\tgpu_ms:       %.2f +- %.2f"                            //
+	    "\n\tpresent_ms:   %.2f +- %.2f"                            //
+	    "\n\tfactor:       %.2f"                                    //
+	    "\n\tcomp_time_ms: %.2f",                                   //
+	    pc->learned.stages[STAGE_CPU].mean_ns / 1e6,                //
+	    sqrt(pc->learned.stages[STAGE_CPU].variance_ns2) / 1e6,     //
+	    pc->learned.stages[STAGE_GPU].mean_ns / 1e6,                //
+	    sqrt(pc->learned.stages[STAGE_GPU].variance_ns2) / 1e6,     //
+	    pc->learned.stages[STAGE_PRESENT].mean_ns / 1e6,            //
+	    sqrt(pc->learned.stages[STAGE_PRESENT].variance_ns2) / 1e6, //
+	    pc->learned.factor,                                         //
+	    ns_to_ms(pc->comp_time_ns));                                //
+}
+
 
 /*
  *
@@ -428,6 +603,31 @@ do_metrics(struct pacing_compositor *pc, struct frame *f)
 	u_metrics_write_system_present_info(&umpi);
 }
 
+static void
+do_record(struct pacing_compositor *pc, struct frame *f)
+{
+	struct u_pc_frame_record record = {
+	    .frame_id = f->frame_id,
+	    .cpu_begin_ns = f->when_began_ns,
+	    .cpu_end_ns = f->when_submitted_ns,
+	    .desired_present_time_ns = f->desired_present_time_ns,
+	    .actual_vblank_ns = f->actual_present_time_ns,
+	    .flags = U_PC_FRAME_RECORD_CPU_BIT | U_PC_FRAME_RECORD_VBLANK_BIT,
+	};
+
+	if (f->has_gpu_info) {
+		record.gpu_start_ns = f->gpu_start_ns;
+		record.gpu_end_ns = f->gpu_end_ns;
+		record.flags |= U_PC_FRAME_RECORD_GPU_BIT;
+	}
+
+	if (is_frame_missed(f)) {
+		record.flags |= U_PC_FRAME_RECORD_MISSED_BIT;
+	}
+
+	u_pc_frame_records_push(&record);
+}
+
 static void
 do_tracing(struct pacing_compositor *pc, struct frame *f)
 {
@@ -656,7 +856,11 @@ pc_info(struct u_pacing_compositor *upc,
 	}
 
 	// Adjust the frame timing.
-	adjust_comp_time(pc, f);
+	if (pc->adaptive) {
+		adjust_comp_time_learned(pc, f);
+	} else {
+		adjust_comp_time(pc, f);
+	}
 
 	double present_margin_ms = ns_to_ms(present_margin_ns);
 	double since_last_frame_ms = ns_to_ms(since_last_frame_ns);
@@ -689,12 +893,23 @@ pc_info(struct u_pacing_compositor *upc,
 	// Write out metrics and tracing data.
 	do_metrics(pc, f);
 	do_tracing(pc, f);
+	do_record(pc, f);
 }
 
 static void
 pc_info_gpu(
     struct u_pacing_compositor *upc, int64_t frame_id, uint64_t gpu_start_ns, uint64_t gpu_end_ns, uint64_t when_ns)
 {
+	struct pacing_compositor *pc = pacing_compositor(upc);
+
+	// The display timing info arrives later, kept until then for the record.
+	struct frame *f = get_frame(pc, frame_id);
+	if (f->frame_id == frame_id) {
+		f->gpu_start_ns = gpu_start_ns;
+		f->gpu_end_ns = gpu_end_ns;
+		f->has_gpu_info = true;
+	}
+
 	if (u_metrics_is_active()) {
 		struct u_metrics_system_gpu_info umgi = {
 		    .frame_id = frame_id,
@@ -745,6 +960,8 @@ const struct u_pc_display_timing_config U_PC_DISPLAY_TIMING_CONFIG_DEFAULT = {
     .comp_time_max_fraction = 30,
     .adjust_missed_fraction = 4,
     .adjust_non_miss_fraction = 2,
+    // Miss one frame in a thousand.
+    .target_miss_ppm = 1000,
 };
 
 xrt_result_t
@@ -777,6 +994,13 @@ u_pc_display_timing_create(uint64_t estimated_frame_period_ns,
 	// Extra margin that is added to compositor time.
 	pc->margin_ns = config->margin_ns;
 
+	// Learns the stages of the frame if the target is set, the fixed steps above are otherwise used.
+	pc->adaptive = config->target_miss_ppm > 0 && debug_get_bool_option_adaptive();
+	if (pc->adaptive) {
+		pc->learned.target_miss_rate = CLAMP(config->target_miss_ppm, 1, 500000) / 1e6;
+		pc->learned.factor = normal_upper_tail_quantile(pc->learned.target_miss_rate);
+	}
+
 	*out_upc = &pc->base;
 
 	double estimated_frame_period_ms = ns_to_ms(estimated_frame_period_ns);
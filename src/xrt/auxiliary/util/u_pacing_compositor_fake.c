@@ -63,6 +63,12 @@ struct fake_timing
 
 	//! This won't run out, trust me.
 	int64_t frame_id_generator;
+
+	//! Record of the current frame, pushed once the GPU info or the next frame arrives.
+	struct u_pc_frame_record record;
+
+	//! Has the current frame been submitted but its record not been pushed.
+	bool record_pending;
 };
 
 
@@ -106,6 +112,28 @@ get_percent_of_time(uint64_t time_ns, uint32_t fraction_percent)
 	return time_s_to_ns(time_ns_to_s(time_ns) * fraction);
 }
 
+/*!
+ * There is no display timing, so the vblank is unknown and missing is judged
+ * by when the work finished compared to the desired present time.
+ */
+static void
+push_record(struct fake_timing *ft)
+{
+	struct u_pc_frame_record *record = &ft->record;
+
+	uint64_t done_ns = record->cpu_end_ns;
+	if ((record->flags & U_PC_FRAME_RECORD_GPU_BIT) != 0) {
+		done_ns = record->gpu_end_ns;
+	}
+
+	if (done_ns > record->desired_present_time_ns) {
+		record->flags |= U_PC_FRAME_RECORD_MISSED_BIT;
+	}
+
+	u_pc_frame_records_push(record);
+	ft->record_pending = false;
+}
+
 
 /*
  *
@@ -126,6 +154,11 @@ pc_predict(struct u_pacing_compositor *upc,
 {
 	struct fake_timing *ft = fake_timing(upc);
 
+	// The compositor didn't give us any GPU info for the last frame.
+	if (ft->record_pending) {
+		push_record(ft);
+	}
+
 	int64_t frame_id = ft->frame_id_generator++;
 	uint64_t desired_present_time_ns = predict_next_frame_present_time(ft, now_ns);
 	uint64_t predicted_display_time_ns = calc_display_time(ft, desired_present_time_ns);
@@ -143,6 +176,10 @@ pc_predict(struct u_pacing_compositor *upc,
 	*out_predicted_display_period_ns = predicted_display_period_ns;
 	*out_min_display_period_ns = min_display_period_ns;
 
+	U_ZERO(&ft->record);
+	ft->record.frame_id = frame_id;
+	ft->record.desired_present_time_ns = desired_present_time_ns;
+
 	if (!u_metrics_is_active()) {
 		return;
 	}
@@ -162,6 +199,8 @@ pc_predict(struct u_pacing_compositor *upc,
 static void
 pc_mark_point(struct u_pacing_compositor *upc, enum u_timing_point point, int64_t frame_id, uint64_t when_ns)
 {
+	struct fake_timing *ft = fake_timing(upc);
+
 	// To help validate calling code.
 	switch (point) {
 	case U_TIMING_POINT_WAKE_UP: break;
@@ -169,6 +208,20 @@ pc_mark_point(struct u_pacing_compositor *upc, enum u_timing_point point, int64_
 	case U_TIMING_POINT_SUBMIT: break;
 	default: assert(false);
 	}
+
+	if (ft->record.frame_id != frame_id) {
+		return;
+	}
+
+	switch (point) {
+	case U_TIMING_POINT_BEGIN: ft->record.cpu_begin_ns = when_ns; break;
+	case U_TIMING_POINT_SUBMIT:
+		ft->record.cpu_end_ns = when_ns;
+		ft->record.flags |= U_PC_FRAME_RECORD_CPU_BIT;
+		ft->record_pending = true;
+		break;
+	default: break;
+	}
 }
 
 static void
@@ -190,6 +243,15 @@ static void
 pc_info_gpu(
     struct u_pacing_compositor *upc, int64_t frame_id, uint64_t gpu_start_ns, uint64_t gpu_end_ns, uint64_t when_ns)
 {
+	struct fake_timing *ft = fake_timing(upc);
+
+	if (ft->record_pending && ft->record.frame_id == frame_id) {
+		ft->record.gpu_start_ns = gpu_start_ns;
+		ft->record.gpu_end_ns = gpu_end_ns;
+		ft->record.flags |= U_PC_FRAME_RECORD_GPU_BIT;
+		push_record(ft);
+	}
+
 	if (u_metrics_is_active()) {
 		struct u_metrics_system_gpu_info umgi = {
 		    .frame_id = frame_id,
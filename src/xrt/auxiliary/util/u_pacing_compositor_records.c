@@ -0,0 +1,143 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Process wide ring of compositor frame timing records.
+ * @ingroup aux_util
+ */
+
+#include "xrt/xrt_compiler.h"
+
+#include "util/u_pacing.h"
+
+
+/*
+ *
+ * Structs and defines.
+ *
+ */
+
+/*!
+ * Protected by a sequence lock: the writer increments @ref sequence before and
+ * after updating the record, so an odd value means an update is in progress.
+ */
+struct record_slot
+{
+	//! Sequence counter, odd while being written.
+	xrt_atomic_s32_t sequence;
+
+	//! Which record this is, readers use it to detect being lapped.
+	uint32_t number;
+
+	struct u_pc_frame_record record;
+};
+
+static struct
+{
+	//! Total number of records pushed, the newest is at (write_count - 1) % U_PC_FRAME_RECORD_COUNT.
+	xrt_atomic_s32_t write_count;
+
+	struct record_slot slots[U_PC_FRAME_RECORD_COUNT];
+} g_ring;
+
+//! Non-zero if the compositor should show the overlay.
+static xrt_atomic_s32_t g_overlay_enabled;
+
+
+/*
+ *
+ * Helper functions.
+ *
+ */
+
+static inline uint32_t
+atomic_read(xrt_atomic_s32_t *p)
+{
+	// Full barrier.
+	return (uint32_t)xrt_atomic_s32_cmpxchg(p, 0, 0);
+}
+
+static bool
+try_read_slot(uint32_t number, struct u_pc_frame_record *out_record)
+{
+	struct record_slot *slot = &g_ring.slots[number % U_PC_FRAME_RECORD_COUNT];
+
+	uint32_t before = atomic_read(&slot->sequence);
+	uint32_t slot_number = slot->number;
+	struct u_pc_frame_record record = slot->record;
+	uint32_t after = atomic_read(&slot->sequence);
+
+	// Torn read or the slot has already been reused for a newer record.
+	if ((before & 1) != 0 || before != after || slot_number != number) {
+		return false;
+	}
+
+	*out_record = record;
+
+	return true;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+void
+u_pc_frame_records_push(const struct u_pc_frame_record *record)
+{
+	uint32_t number = atomic_read(&g_ring.write_count);
+	struct record_slot *slot = &g_ring.slots[number % U_PC_FRAME_RECORD_COUNT];
+
+	// Odd sequence, readers will skip it. Full barrier.
+	xrt_atomic_s32_inc_return(&slot->sequence);
+
+	slot->number = number;
+	slot->record = *record;
+
+	// Even sequence again, full barrier.
+	xrt_atomic_s32_inc_return(&slot->sequence);
+
+	// Publish the record.
+	xrt_atomic_s32_inc_return(&g_ring.write_count);
+}
+
+uint32_t
+u_pc_frame_records_read(uint32_t *inout_next, struct u_pc_frame_record *out_records, uint32_t max_count)
+{
+	uint32_t write_count = atomic_read(&g_ring.write_count);
+	uint32_t next = *inout_next;
+
+	// Fallen behind, or ahead from a previous run, start at the oldest record.
+	if (write_count - next > U_PC_FRAME_RECORD_COUNT) {
+		next = write_count > U_PC_FRAME_RECORD_COUNT ? write_count - U_PC_FRAME_RECORD_COUNT : 0;
+	}
+
+	uint32_t count = 0;
+	for (; next != write_count && count < max_count; next++) {
+		// Records overwritten while reading are lost.
+		if (try_read_slot(next, &out_records[count])) {
+			count++;
+		}
+	}
+
+	*inout_next = next;
+
+	return count;
+}
+
+void
+u_pc_overlay_set_enabled(bool enabled)
+{
+	int32_t value = enabled ? 1 : 0;
+
+	// Full barrier.
+	xrt_atomic_s32_cmpxchg(&g_overlay_enabled, 1 - value, value);
+}
+
+bool
+u_pc_overlay_get_enabled(void)
+{
+	return atomic_read(&g_overlay_enabled) != 0;
+}
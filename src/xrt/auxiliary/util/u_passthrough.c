@@ -0,0 +1,104 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Process wide hub routing camera frames to a passthrough consumer.
+ * @ingroup aux_util
+ */
+
+#include "os/os_threading.h"
+
+#include "util/u_frame.h"
+#include "util/u_passthrough.h"
+
+
+static struct os_mutex g_mutex;
+static pthread_once_t g_once = PTHREAD_ONCE_INIT;
+static struct xrt_frame_sink *g_sinks[2] = {NULL, NULL};
+static volatile bool g_active = false;
+
+
+/*
+ *
+ * Helper functions.
+ *
+ */
+
+static void
+init_mutex(void)
+{
+	os_mutex_init(&g_mutex);
+}
+
+static void
+push_locked(uint32_t view_index, struct xrt_frame *xf)
+{
+	struct xrt_frame_sink *xfs = g_sinks[view_index];
+	if (xfs != NULL) {
+		xrt_sink_push_frame(xfs, xf);
+	}
+}
+
+static void
+push_sbs_locked(struct xrt_frame *xf)
+{
+	uint32_t half_width = xf->width / 2;
+
+	for (uint32_t i = 0; i < 2; i++) {
+		struct xrt_rect roi = {
+		    .offset = {.w = (int)(half_width * i), .h = 0},
+		    .extent = {.w = (int)half_width, .h = (int)xf->height},
+		};
+
+		struct xrt_frame *view = NULL;
+		u_frame_create_roi(xf, roi, &view);
+		view->stereo_format = XRT_STEREO_FORMAT_NONE;
+
+		push_locked(i, view);
+
+		xrt_frame_reference(&view, NULL);
+	}
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+void
+u_passthrough_set_sinks(struct xrt_frame_sink *left, struct xrt_frame_sink *right)
+{
+	pthread_once(&g_once, init_mutex);
+
+	os_mutex_lock(&g_mutex);
+	g_sinks[0] = left;
+	g_sinks[1] = right;
+	g_active = left != NULL || right != NULL;
+	os_mutex_unlock(&g_mutex);
+}
+
+bool
+u_passthrough_is_active(void)
+{
+	return g_active;
+}
+
+void
+u_passthrough_push_frame(uint32_t view_index, struct xrt_frame *xf)
+{
+	if (!g_active || xf == NULL || view_index >= 2) {
+		return;
+	}
+
+	pthread_once(&g_once, init_mutex);
+
+	os_mutex_lock(&g_mutex);
+	if (xf->stereo_format == XRT_STEREO_FORMAT_SBS) {
+		push_sbs_locked(xf);
+	} else {
+		push_locked(view_index, xf);
+	}
+	os_mutex_unlock(&g_mutex);
+}
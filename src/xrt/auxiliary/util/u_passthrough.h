@@ -0,0 +1,49 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Process wide hub routing camera frames to a passthrough consumer.
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * Set the sinks that receive passthrough camera frames, one per view, this is
+ * normally done by the compositor. Pass NULL for both to clear them, once this
+ * function returns the old sinks will not receive any more frames.
+ *
+ * @ingroup aux_util
+ */
+void
+u_passthrough_set_sinks(struct xrt_frame_sink *left, struct xrt_frame_sink *right);
+
+/*!
+ * Is there any consumer of passthrough frames, lets producers skip work.
+ *
+ * @ingroup aux_util
+ */
+bool
+u_passthrough_is_active(void);
+
+/*!
+ * Push a camera frame for the given view, 0 is left and 1 is right. Frames
+ * with a @ref XRT_STEREO_FORMAT_SBS stereo format are split and sent to both
+ * views regardless of @p view_index. Does nothing if there is no consumer.
+ *
+ * @ingroup aux_util
+ */
+void
+u_passthrough_push_frame(uint32_t view_index, struct xrt_frame *xf);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -11,6 +11,7 @@
 #pragma once
 
 #include "os/os_threading.h"
+#include "util/u_time.h"
 #include "xrt/xrt_frame.h"
 #include "xrt/xrt_tracking.h"
 
@@ -39,6 +40,43 @@ u_sink_create_format_converter(struct xrt_frame_context *xfctx,
                                struct xrt_frame_sink *downstream,
                                struct xrt_frame_sink **out_xfs);
 
+/*!
+ * Same as @ref u_sink_create_format_converter but only converts the @p roi
+ * part of each frame and then downscales it by the integer factor
+ * @p downscale, using nearest sampling. A zero sized @p roi means the whole
+ * frame, it is clamped to the frame and aligned to the format's blocks.
+ * MJPEG frames are decoded in full before cropping, and formats that can't be
+ * sampled per pixel (like Bayer) are converted without the downscale.
+ *
+ * @public @memberof xrt_frame_sink
+ * @see xrt_frame_context
+ */
+void
+u_sink_create_format_converter_roi(struct xrt_frame_context *xfctx,
+                                   enum xrt_format f,
+                                   struct xrt_rect roi,
+                                   uint32_t downscale,
+                                   struct xrt_frame_sink *downstream,
+                                   struct xrt_frame_sink **out_xfs);
+
+/*!
+ * Decodes MJPEG frames straight to @p f, either XRT_FORMAT_L8 or
+ * XRT_FORMAT_R8G8B8, at 1/@p scale_denom of the size. The scaling happens
+ * inside the decoder, and L8 decoding skips the chroma components, which is
+ * much cheaper than a full RGB decode followed by a conversion. Supported
+ * scales are 1, 2, 4 and 8, other values are rounded down. Frames in other
+ * formats are converted like @ref u_sink_create_format_converter does.
+ *
+ * @public @memberof xrt_frame_sink
+ * @see xrt_frame_context
+ */
+void
+u_sink_create_mjpeg_decoder(struct xrt_frame_context *xfctx,
+                            enum xrt_format f,
+                            uint32_t scale_denom,
+                            struct xrt_frame_sink *downstream,
+                            struct xrt_frame_sink **out_xfs);
+
 /*!
  * @public @memberof xrt_frame_sink
  * @see xrt_frame_context
@@ -102,6 +140,23 @@ u_sink_deinterleaver_create(struct xrt_frame_context *xfctx,
                             struct xrt_frame_sink **out_xfs);
 
 /*!
+ * What a @ref u_sink_queue does with frames pushed when it is full.
+ *
+ * @ingroup aux_util
+ */
+enum u_sink_queue_policy
+{
+	//! Drop the frame being pushed, keeps the queued frames in order.
+	U_SINK_QUEUE_DROP_NEWEST,
+
+	//! Drop the oldest queued frame, the consumer always sees the latest.
+	U_SINK_QUEUE_DROP_OLDEST,
+};
+
+/*!
+ * Creates a queue that drops newly pushed frames when full, see
+ * @ref u_sink_queue_create_with_policy.
+ *
  * @public @memberof xrt_frame_sink
  * @see xrt_frame_context
  */
@@ -111,6 +166,33 @@ u_sink_queue_create(struct xrt_frame_context *xfctx,
                     struct xrt_frame_sink *downstream,
                     struct xrt_frame_sink **out_xfs);
 
+/*!
+ * Creates a queue that pushes frames to @p downstream from its own thread.
+ * Pushing frames never allocates or blocks. The @p max_size is rounded up to
+ * a power of two, zero gives a large queue that in practice never drops. A
+ * @p max_size of one always hands the consumer the latest frame.
+ *
+ * @public @memberof xrt_frame_sink
+ * @see xrt_frame_context
+ */
+bool
+u_sink_queue_create_with_policy(struct xrt_frame_context *xfctx,
+                                uint64_t max_size,
+                                enum u_sink_queue_policy policy,
+                                struct xrt_frame_sink *downstream,
+                                struct xrt_frame_sink **out_xfs);
+
+/*!
+ * Adds the depth and push, drop counters of a queue to the debug UI under
+ * @p root, each named starting with @p prefix. The @p xfs must have been
+ * created by @ref u_sink_queue_create_with_policy or
+ * @ref u_sink_queue_create, and @p root removed before the queue is destroyed.
+ *
+ * @public @memberof xrt_frame_sink
+ */
+void
+u_sink_queue_add_vars(struct xrt_frame_sink *xfs, void *root, const char *prefix);
+
 
 /*!
  * @public @memberof xrt_frame_sink
@@ -161,6 +243,9 @@ u_sink_combiner_create(struct xrt_frame_context *xfctx,
                        struct xrt_frame_sink **out_left_xfs,
                        struct xrt_frame_sink **out_right_xfs);
 
+//! How far apart the timestamps of frames pushed together by the genlock sinks may be by default.
+#define U_SINK_FORCE_GENLOCK_DEFAULT_TOLERANCE_NS (U_TIME_1MS_IN_NS)
+
 /*!
  * Enforces left-right push order on frames and forces them to be within a reasonable amount of time from each other
  */
@@ -171,6 +256,39 @@ u_sink_force_genlock_create(struct xrt_frame_context *xfctx,
                             struct xrt_frame_sink **out_left_xfs,
                             struct xrt_frame_sink **out_right_xfs);
 
+/*!
+ * Same as @ref u_sink_force_genlock_create but for @p count cameras, up to
+ * @ref XRT_TRACKING_MAX_SLAM_CAMS. Waits until it has a frame from every camera
+ * that are all within @p tolerance_ns of each other, then gives them the same
+ * timestamp and pushes them in camera order. Frames too old to be matched are
+ * dropped.
+ *
+ * @p downstreams and @p out_xfss may be the same array.
+ */
+bool
+u_sink_force_genlock_create_many(struct xrt_frame_context *xfctx,
+                                 uint32_t count,
+                                 int64_t tolerance_ns,
+                                 struct xrt_frame_sink **downstreams,
+                                 struct xrt_frame_sink **out_xfss);
+
+/*!
+ * Puts a @ref u_sink_force_genlock_create_many in front of the cameras of
+ * @p downstream, the IMU and ground truth sinks are passed through as is.
+ */
+bool
+u_sink_force_genlock_create_slam(struct xrt_frame_context *xfctx,
+                                 int64_t tolerance_ns,
+                                 const struct xrt_slam_sinks *downstream,
+                                 struct xrt_slam_sinks *out_sinks);
+
+/*!
+ * Adds the sync statistics to a u_var root, @p xfs is any of the sinks created
+ * by the genlock functions.
+ */
+void
+u_sink_force_genlock_add_vars(struct xrt_frame_sink *xfs, void *root, const char *prefix);
+
 
 /*
  *
@@ -242,6 +360,28 @@ u_imu_sink_split_create(struct xrt_frame_context *xfctx,
                         struct xrt_imu_sink *downstream_two,
                         struct xrt_imu_sink **out_imu_sink);
 
+/*!
+ * @public @memberof xrt_imu_sink
+ * @see xrt_frame_context
+ * Like @ref u_imu_sink_split_create but @p downstream_two is fed from a
+ * lock-free ring in batches on its own thread, so a slow consumer like a SLAM
+ * system never delays the producer nor @p downstream_one.
+ */
+bool
+u_imu_sink_split_create_queued(struct xrt_frame_context *xfctx,
+                               struct xrt_imu_sink *downstream_one,
+                               struct xrt_imu_sink *downstream_two,
+                               struct xrt_imu_sink **out_imu_sink);
+
+/*!
+ * @public @memberof xrt_imu_sink
+ * Adds the sample counters of the queue in a sink created by
+ * @ref u_imu_sink_split_create_queued to the debug UI under @p root, each
+ * named starting with @p prefix. Remove @p root before the sink is destroyed.
+ */
+void
+u_imu_sink_split_add_vars(struct xrt_imu_sink *imu_sink, void *root, const char *prefix);
+
 
 /*!
  * @public @memberof xrt_imu_sink
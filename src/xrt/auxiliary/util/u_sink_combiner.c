@@ -15,13 +15,20 @@
 #include "util/u_trace_marker.h"
 
 #include <stdio.h>
+#include <string.h>
 #include <pthread.h>
 
 
+//! Number of combined frames kept around for reuse.
+#define COMBINER_POOL_SIZE (4)
+
 /*!
  * An @ref xrt_frame_sink combiner, frames pushed to the left and right side will be combined into one @ref xrt_frame
  * with format XRT_STEREO_FORMAT_SBS. Will drop stale frames if the combining work takes too long.
  *
+ * The combined frame also references both source frames in @ref xrt_frame::views, see
+ * @ref u_frame_create_stereo_pair.
+ *
  * @implements xrt_frame_sink
  * @implements xrt_frame_node
  */
@@ -42,6 +49,9 @@ struct u_sink_combiner
 	//! The current queued frame.
 	struct xrt_frame *frames[2];
 
+	//! Buffers for the side by side frames.
+	struct u_frame_pool *pool;
+
 	pthread_t thread;
 	pthread_mutex_t mutex;
 	pthread_cond_t cond;
@@ -51,54 +61,24 @@ struct u_sink_combiner
 };
 
 static void
-combine_frames_l8(struct xrt_frame *l, struct xrt_frame *r, struct xrt_frame *f)
-{
-	SINK_TRACE_MARKER();
-
-
-	uint32_t height = l->height;
-
-	for (uint32_t y = 0; y < height; y++) {
-		uint8_t *dst = f->data + f->stride * y;
-		uint8_t *src = l->data + l->stride * y;
-
-		for (uint32_t x = 0; x < l->width; x++) {
-			*dst++ = *src++;
-		}
-
-		dst = f->data + f->stride * y + l->width;
-		src = r->data + r->stride * y;
-		for (uint32_t x = 0; x < r->width; x++) {
-			*dst++ = *src++;
-		}
-	}
-}
-
-static void
-combine_frames_r8g8b8(struct xrt_frame *l, struct xrt_frame *r, struct xrt_frame *f)
+combine_rows(struct xrt_frame *l, struct xrt_frame *r, struct xrt_frame *f, size_t pixel_size)
 {
 	SINK_TRACE_MARKER();
 
-	uint32_t height = l->height;
+	size_t l_row = l->width * pixel_size;
+	size_t r_row = r->width * pixel_size;
 
-	for (uint32_t y = 0; y < height; y++) {
+	// Both views share the rows of the output, one memcpy per view and row.
+	for (uint32_t y = 0; y < l->height; y++) {
 		uint8_t *dst = f->data + f->stride * y;
-		uint8_t *src = l->data + l->stride * y;
 
-		for (uint32_t x = 0; x < l->width * 3; x++) {
-			*dst++ = *src++;
-		}
-
-		dst = f->data + f->stride * y + l->width * 3;
-		src = r->data + r->stride * y;
-		for (uint32_t x = 0; x < r->width * 3; x++) {
-			*dst++ = *src++;
-		}
+		memcpy(dst, l->data + l->stride * y, l_row);
+		memcpy(dst + l_row, r->data + r->stride * y, r_row);
 	}
 }
 
 static void
-combine_frames(struct xrt_frame *l, struct xrt_frame *r, struct xrt_frame **out_frame)
+combine_frames(struct u_sink_combiner *q, struct xrt_frame *l, struct xrt_frame *r, struct xrt_frame **out_frame)
 {
 	SINK_TRACE_MARKER();
 
@@ -112,28 +92,26 @@ combine_frames(struct xrt_frame *l, struct xrt_frame *r, struct xrt_frame **out_
 	uint32_t width = l->width + r->width;
 	enum xrt_format format = l->format;
 
-	u_frame_create_one_off(format, width, height, out_frame);
+	struct xrt_frame *sbs = NULL;
+	u_frame_pool_create_frame(q->pool, format, width, height, &sbs);
 
-	struct xrt_frame *f = *out_frame;
-	f->timestamp = l->timestamp - (diff_ns / 2); // Middle of both frames.
-	f->stereo_format = XRT_STEREO_FORMAT_SBS;
-	f->source_sequence = l->source_sequence;
+	sbs->timestamp = l->timestamp - (diff_ns / 2); // Middle of both frames.
+	sbs->stereo_format = XRT_STEREO_FORMAT_SBS;
+	sbs->source_sequence = l->source_sequence;
 
 	switch (l->format) {
-	case XRT_FORMAT_L8: {
-		combine_frames_l8(l, r, f);
-		break;
-	}
-	case XRT_FORMAT_R8G8B8: {
-		combine_frames_r8g8b8(l, r, f);
-		break;
-	}
+	case XRT_FORMAT_L8: combine_rows(l, r, sbs, 1); break;
+	case XRT_FORMAT_R8G8B8: combine_rows(l, r, sbs, 3); break;
 	default: assert(!"Unimplemented!");
 	}
 #if 0
 	// So that we can test if this works on a really slow computer
 	os_nanosleep(0.1f * U_TIME_1S_IN_NS);
 #endif
+
+	// Consumers that want the views separately can skip the copy above.
+	u_frame_create_stereo_pair(l, r, sbs, out_frame);
+	xrt_frame_reference(&sbs, NULL);
 }
 
 static void
@@ -192,7 +170,7 @@ combiner_right_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
 		assert(!(diff_ns < -U_TIME_1MS_IN_NS || diff_ns > U_TIME_1MS_IN_NS));
 
 		struct xrt_frame *frame = NULL;
-		combine_frames(frames[0], frames[1], &frame);
+		combine_frames(q, frames[0], frames[1], &frame);
 
 		// Send to the consumer that does the work.
 		xrt_sink_push_frame(q->consumer, frame);
@@ -236,7 +214,8 @@ combiner_destroy(struct xrt_frame_node *node)
 {
 	struct u_sink_combiner *q = container_of(node, struct u_sink_combiner, node);
 
-	// Destroy resources.
+	// Destroy resources, frames still out keep the pool alive.
+	u_frame_pool_reference(&q->pool, NULL);
 	pthread_mutex_destroy(&q->mutex);
 	pthread_cond_destroy(&q->cond);
 	free(q);
@@ -275,6 +254,8 @@ u_sink_combiner_create(struct xrt_frame_context *xfctx,
 		return false;
 	}
 
+	q->pool = u_frame_pool_create(COMBINER_POOL_SIZE);
+
 	xrt_frame_context_add(xfctx, &q->node);
 
 
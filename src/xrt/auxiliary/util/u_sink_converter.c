@@ -14,8 +14,11 @@
 #include "util/u_sink.h"
 #include "util/u_frame.h"
 #include "util/u_format.h"
+#include "util/u_format_convert.h"
 #include "util/u_trace_marker.h"
 
+#include "math/m_api.h"
+
 #include <stdio.h>
 
 #ifdef XRT_HAVE_JPEG
@@ -29,6 +32,9 @@
  *
  */
 
+//! Number of returned frames a converter keeps around for reuse.
+#define CONVERTER_POOL_SIZE (4)
+
 /*!
  * An @ref xrt_frame_sink that converts frames.
  * @implements xrt_frame_sink
@@ -42,6 +48,18 @@ struct u_sink_converter
 	struct xrt_frame_sink *downstream;
 
 	enum xrt_format format;
+
+	//! Converted frames are drawn from this pool.
+	struct u_frame_pool *pool;
+
+	//! Region to convert, zero extent means the whole frame.
+	struct xrt_rect roi;
+
+	//! Integer downscale applied after the ROI, or the MJPEG scale denominator.
+	uint32_t downscale;
+
+	//! Regular conversion used by the ROI path for full size frames.
+	void (*convert)(struct xrt_frame_sink *xs, struct xrt_frame *xf);
 };
 
 
@@ -57,14 +75,10 @@ from_L8_to_R8G8B8(struct xrt_frame *dst_frame, uint32_t w, uint32_t h, size_t st
 	SINK_TRACE_MARKER();
 
 	for (uint32_t y = 0; y < h; y++) {
-		for (uint32_t x = 0; x < w; x += 1) {
-			const uint8_t *src = data;
-			uint8_t *dst = dst_frame->data;
+		const uint8_t *src = data + (y * stride);
+		uint8_t *dst = dst_frame->data + (y * dst_frame->stride);
 
-			src = src + (y * stride) + x;
-			dst = dst + (y * dst_frame->stride) + (x * 3);
-			dst[2] = dst[1] = dst[0] = src[0];
-		}
+		u_format_convert_row_l8_to_r8g8b8(src, dst, w);
 	}
 }
 
@@ -75,159 +89,16 @@ from_L8_to_R8G8B8(struct xrt_frame *dst_frame, uint32_t w, uint32_t h, size_t st
  *
  */
 
-static inline int
-clamp_to_byte(int v)
-{
-	if (v < 0) {
-		return 0;
-	}
-	if (v >= 255) {
-		return 255;
-	}
-	return v;
-}
-
-static inline uint32_t
-YUV444_to_RGBX8888(int y, int u, int v)
-{
-	int C = y - 16;
-	int D = u - 128;
-	int E = v - 128;
-
-	int R = clamp_to_byte((298 * C + 409 * E + 128) >> 8);
-	int G = clamp_to_byte((298 * C - 100 * D - 209 * E + 128) >> 8);
-	int B = clamp_to_byte((298 * C + 516 * D + 128) >> 8);
-
-	return B << 16 | G << 8 | R;
-}
-
-#undef USE_TABLE
-#ifdef USE_TABLE
-static uint32_t lookup_YUV_to_RGBX[256][256][256] = {0};
-
-static void
-generate_lookup_YUV_to_RGBX()
-{
-	if (lookup_YUV_to_RGBX[255][255][255] != 0) {
-		return;
-	}
-
-	int y;
-	int u;
-	int v;
-
-	for (y = 0; y < 256; y++) {
-		for (u = 0; u < 256; u++) {
-			for (v = 0; v < 256; v++) {
-				lookup_YUV_to_RGBX[y][u][v] = YUV444_to_RGBX8888(y, u, v);
-			}
-		}
-	}
-}
-#endif
-
-XRT_MAYBE_UNUSED inline static void
-YUYV422_to_R8G8B8X8(const uint8_t *input, uint32_t *rgb1, uint32_t *rgb2)
-{
-	uint8_t y0 = input[0];
-	uint8_t u = input[1];
-	uint8_t y1 = input[2];
-	uint8_t v = input[3];
-
-#ifdef USE_TABLE
-	*rgb1 = lookup_YUV_to_RGBX[y0][u][v];
-	*rgb2 = lookup_YUV_to_RGBX[y1][u][v];
-#else
-	*rgb1 = YUV444_to_RGBX8888(y0, u, v);
-	*rgb2 = YUV444_to_RGBX8888(y1, u, v);
-#endif
-}
-
-inline static void
-YUYV422_to_R8G8B8(const uint8_t *input, uint8_t *dst)
-{
-	uint8_t y0 = input[0];
-	uint8_t u = input[1];
-	uint8_t y1 = input[2];
-	uint8_t v = input[3];
-
-#ifdef USE_TABLE
-	uint8_t *rgb1 = (uint8_t *)&lookup_YUV_to_RGBX[y0][u][v];
-	uint8_t *rgb2 = (uint8_t *)&lookup_YUV_to_RGBX[y1][u][v];
-#else
-	uint32_t rgb1v = YUV444_to_RGBX8888(y0, u, v);
-	uint32_t rgb2v = YUV444_to_RGBX8888(y1, u, v);
-	uint8_t *rgb1 = (uint8_t *)&rgb1v;
-	uint8_t *rgb2 = (uint8_t *)&rgb2v;
-#endif
-
-	dst[0] = rgb1[0];
-	dst[1] = rgb1[1];
-	dst[2] = rgb1[2];
-	dst[3] = rgb2[0];
-	dst[4] = rgb2[1];
-	dst[5] = rgb2[2];
-}
-
-inline static void
-UYVY422_to_R8G8B8(const uint8_t *input, uint8_t *dst)
-{
-	uint8_t u = input[0];
-	uint8_t y0 = input[1];
-	uint8_t v = input[2];
-	uint8_t y1 = input[3];
-
-#ifdef USE_TABLE
-	uint8_t *rgb1 = (uint8_t *)&lookup_YUV_to_RGBX[y0][u][v];
-	uint8_t *rgb2 = (uint8_t *)&lookup_YUV_to_RGBX[y1][u][v];
-#else
-	uint32_t rgb1v = YUV444_to_RGBX8888(y0, u, v);
-	uint32_t rgb2v = YUV444_to_RGBX8888(y1, u, v);
-	uint8_t *rgb1 = (uint8_t *)&rgb1v;
-	uint8_t *rgb2 = (uint8_t *)&rgb2v;
-#endif
-
-	dst[0] = rgb1[0];
-	dst[1] = rgb1[1];
-	dst[2] = rgb1[2];
-	dst[3] = rgb2[0];
-	dst[4] = rgb2[1];
-	dst[5] = rgb2[2];
-}
-
-inline static void
-YUV444_to_R8G8B8(const uint8_t *input, uint8_t *dst)
-{
-	uint8_t y = input[0];
-	uint8_t u = input[1];
-	uint8_t v = input[2];
-
-#ifdef USE_TABLE
-	uint8_t *rgb = (uint8_t *)&lookup_YUV_to_RGBX[y][u][v];
-#else
-	uint32_t rgbv = YUV444_to_RGBX8888(y, u, v);
-	uint8_t *rgb = (uint8_t *)&rgbv;
-#endif
-
-	dst[0] = rgb[0];
-	dst[1] = rgb[1];
-	dst[2] = rgb[2];
-}
-
 static void
 from_YUYV422_to_R8G8B8(struct xrt_frame *dst_frame, uint32_t w, uint32_t h, size_t stride, const uint8_t *data)
 {
 	SINK_TRACE_MARKER();
 
 	for (uint32_t y = 0; y < h; y++) {
-		for (uint32_t x = 0; x < w; x += 2) {
-			const uint8_t *src = data;
-			uint8_t *dst = dst_frame->data;
+		const uint8_t *src = data + (y * stride);
+		uint8_t *dst = dst_frame->data + (y * dst_frame->stride);
 
-			src = src + (y * stride) + (x * 2);
-			dst = dst + (y * dst_frame->stride) + (x * 3);
-			YUYV422_to_R8G8B8(src, dst);
-		}
+		u_format_convert_row_yuyv422_to_r8g8b8(src, dst, w);
 	}
 }
 
@@ -240,9 +111,7 @@ from_YUYV422_to_L8(struct xrt_frame *dst_frame, uint32_t w, uint32_t h, size_t s
 		const uint8_t *src = data + (y * stride);
 		uint8_t *dst = dst_frame->data + (y * dst_frame->stride);
 
-		for (uint32_t x = 0; x < w; x++) {
-			dst[x] = src[x * 2];
-		}
+		u_format_convert_row_yuyv422_to_l8(src, dst, w);
 	}
 }
 
@@ -252,32 +121,23 @@ from_UYVY422_to_R8G8B8(struct xrt_frame *dst_frame, uint32_t w, uint32_t h, size
 	SINK_TRACE_MARKER();
 
 	for (uint32_t y = 0; y < h; y++) {
-		for (uint32_t x = 0; x < w; x += 2) {
-			const uint8_t *src = data;
-			uint8_t *dst = dst_frame->data;
+		const uint8_t *src = data + (y * stride);
+		uint8_t *dst = dst_frame->data + (y * dst_frame->stride);
 
-			src = src + (y * stride) + (x * 2);
-			dst = dst + (y * dst_frame->stride) + (x * 3);
-			UYVY422_to_R8G8B8(src, dst);
-		}
+		u_format_convert_row_uyvy422_to_r8g8b8(src, dst, w);
 	}
 }
 
-
 static void
 from_YUV888_to_R8G8B8(struct xrt_frame *dst_frame, uint32_t w, uint32_t h, size_t stride, const uint8_t *data)
 {
 	SINK_TRACE_MARKER();
 
 	for (uint32_t y = 0; y < h; y++) {
-		for (uint32_t x = 0; x < w; x++) {
-			const uint8_t *src = data;
-			uint8_t *dst = dst_frame->data;
+		const uint8_t *src = data + (y * stride);
+		uint8_t *dst = dst_frame->data + (y * dst_frame->stride);
 
-			src = src + (y * stride) + (x * 3);
-			dst = dst + (y * dst_frame->stride) + (x * 3);
-			YUV444_to_R8G8B8(src, dst);
-		}
+		u_format_convert_row_yuv888_to_r8g8b8(src, dst, w);
 	}
 }
 
@@ -336,7 +196,8 @@ from_MJPEG_to_R8G8B8(struct xrt_frame *dst_frame, size_t size, const uint8_t *da
 
 	uint32_t scanlines_read = 0;
 	while (scanlines_read < cinfo.image_height) {
-		int read_count = jpeg_read_scanlines(&cinfo, &moving_ptr, 16);
+		// Only one row pointer, so only ask for one row at a time.
+		int read_count = jpeg_read_scanlines(&cinfo, &moving_ptr, 1);
 		moving_ptr += read_count * dst_frame->stride;
 		scanlines_read += read_count;
 	}
@@ -378,7 +239,8 @@ from_MJPEG_to_YUV888(struct xrt_frame *dst_frame, size_t size, const uint8_t *da
 
 	uint32_t scanlines_read = 0;
 	while (scanlines_read < cinfo.image_height) {
-		int read_count = jpeg_read_scanlines(&cinfo, &moving_ptr, 16);
+		// Only one row pointer, so only ask for one row at a time.
+		int read_count = jpeg_read_scanlines(&cinfo, &moving_ptr, 1);
 		moving_ptr += read_count * dst_frame->stride;
 		scanlines_read += read_count;
 	}
@@ -440,15 +302,17 @@ from_BAYER_GR8_to_R8G8B8(struct xrt_frame *dst_frame, uint32_t w, uint32_t h, si
 
 /*!
  * Creates a frame that the conversion should happen to, allows to set the size.
- *
- * @todo Allocate from a pool of frames.
  */
 static bool
-create_frame_with_format_of_size(
-    struct xrt_frame *xf, uint32_t w, uint32_t h, enum xrt_format format, struct xrt_frame **out_frame)
+create_frame_with_format_of_size(struct u_sink_converter *s,
+                                 struct xrt_frame *xf,
+                                 uint32_t w,
+                                 uint32_t h,
+                                 enum xrt_format format,
+                                 struct xrt_frame **out_frame)
 {
 	struct xrt_frame *frame = NULL;
-	u_frame_create_one_off(format, w, h, &frame);
+	u_frame_pool_create_frame(s->pool, format, w, h, &frame);
 	if (frame == NULL) {
 		U_LOG_E("Failed to create target frame!");
 		*out_frame = NULL;
@@ -470,11 +334,85 @@ create_frame_with_format_of_size(
  * Creates a frame that the conversion should happen to.
  */
 static bool
-create_frame_with_format(struct xrt_frame *xf, enum xrt_format format, struct xrt_frame **out_frame)
+create_frame_with_format(struct u_sink_converter *s,
+                         struct xrt_frame *xf,
+                         enum xrt_format format,
+                         struct xrt_frame **out_frame)
 {
-	return create_frame_with_format_of_size(xf, xf->width, xf->height, format, out_frame);
+	return create_frame_with_format_of_size(s, xf, xf->width, xf->height, format, out_frame);
 }
 
+#ifdef XRT_HAVE_JPEG
+/*!
+ * Decodes into a frame created after the header has been read, so libjpeg can
+ * do a scaled decode in the DCT domain, and for L8 skip the chroma components
+ * entirely.
+ */
+static bool
+decode_MJPEG(struct u_sink_converter *s,
+             struct xrt_frame *xf,
+             enum xrt_format format,
+             uint32_t scale_denom,
+             struct xrt_frame **out_frame)
+{
+	SINK_TRACE_MARKER();
+
+	if (!check_header(xf->size, xf->data)) {
+		return false;
+	}
+
+	struct jpeg_decompress_struct cinfo = {0};
+	struct jpeg_error_mgr jerr = {0};
+
+	cinfo.err = jpeg_std_error(&jerr);
+	jerr.trace_level = 0;
+
+	jpeg_create_decompress(&cinfo);
+	jpeg_mem_src(&cinfo, xf->data, xf->size);
+
+	int ret = jpeg_read_header(&cinfo, TRUE);
+	if (ret != JPEG_HEADER_OK) {
+		jpeg_destroy_decompress(&cinfo);
+		return false;
+	}
+
+	switch (format) {
+	case XRT_FORMAT_L8: cinfo.out_color_space = JCS_GRAYSCALE; break;
+	case XRT_FORMAT_R8G8B8: cinfo.out_color_space = JCS_RGB; break;
+	default: assert(false); jpeg_destroy_decompress(&cinfo); return false;
+	}
+
+	cinfo.scale_num = 1;
+	cinfo.scale_denom = scale_denom;
+	jpeg_calc_output_dimensions(&cinfo);
+
+	struct xrt_frame *frame = NULL;
+	if (!create_frame_with_format_of_size(s, xf, cinfo.output_width, cinfo.output_height, format, &frame)) {
+		jpeg_destroy_decompress(&cinfo);
+		return false;
+	}
+
+	jpeg_start_decompress(&cinfo);
+
+	uint8_t *moving_ptr = frame->data;
+
+	uint32_t scanlines_read = 0;
+	while (scanlines_read < cinfo.output_height) {
+		// Only one row pointer, so only ask for one row at a time.
+		int read_count = jpeg_read_scanlines(&cinfo, &moving_ptr, 1);
+		moving_ptr += read_count * frame->stride;
+		scanlines_read += read_count;
+	}
+
+	jpeg_finish_decompress(&cinfo);
+	jpeg_destroy_decompress(&cinfo);
+
+	*out_frame = frame;
+
+	return true;
+}
+#endif
+
 static void
 convert_frame_l8(struct xrt_frame_sink *xs, struct xrt_frame *xf)
 {
@@ -487,11 +425,18 @@ convert_frame_l8(struct xrt_frame_sink *xs, struct xrt_frame *xf)
 	switch (xf->format) {
 	case XRT_FORMAT_L8: s->downstream->push_frame(s->downstream, xf); return;
 	case XRT_FORMAT_YUYV422:
-		if (!create_frame_with_format(xf, XRT_FORMAT_L8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_L8, &converted)) {
 			return;
 		}
 		from_YUYV422_to_L8(converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
+#ifdef XRT_HAVE_JPEG
+	case XRT_FORMAT_MJPEG:
+		if (!decode_MJPEG(s, xf, XRT_FORMAT_L8, 1, &converted)) {
+			return;
+		}
+		break;
+#endif
 	default: U_LOG_E("Cannot convert from '%s' to L8!", u_format_str(xf->format)); return;
 	}
 
@@ -516,32 +461,32 @@ convert_frame_r8g8b8_or_l8(struct xrt_frame_sink *xs, struct xrt_frame *xf)
 	case XRT_FORMAT_BAYER_GR8:;
 		uint32_t w = xf->width / 2;
 		uint32_t h = xf->height / 2;
-		if (!create_frame_with_format_of_size(xf, w, h, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format_of_size(s, xf, w, h, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		from_BAYER_GR8_to_R8G8B8(converted, w, h, xf->stride, xf->data);
 		break;
 	case XRT_FORMAT_YUYV422:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		from_YUYV422_to_R8G8B8(converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
 	case XRT_FORMAT_UYVY422:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		from_UYVY422_to_R8G8B8(converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
 	case XRT_FORMAT_YUV888:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		from_YUV888_to_R8G8B8(converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
 #ifdef XRT_HAVE_JPEG
 	case XRT_FORMAT_MJPEG:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		if (!from_MJPEG_to_R8G8B8(converted, xf->size, xf->data)) {
@@ -590,26 +535,26 @@ convert_frame_r8g8b8_bayer_or_l8(struct xrt_frame_sink *xs, struct xrt_frame *xf
 	case XRT_FORMAT_R8G8B8:
 	case XRT_FORMAT_BAYER_GR8:; s->downstream->push_frame(s->downstream, xf); return;
 	case XRT_FORMAT_YUYV422:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		from_YUYV422_to_R8G8B8(converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
 	case XRT_FORMAT_UYVY422:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		from_UYVY422_to_R8G8B8(converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
 	case XRT_FORMAT_YUV888:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		from_YUV888_to_R8G8B8(converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
 #ifdef XRT_HAVE_JPEG
 	case XRT_FORMAT_MJPEG:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		if (!from_MJPEG_to_R8G8B8(converted, xf->size, xf->data)) {
@@ -640,7 +585,7 @@ convert_frame_r8g8b8(struct xrt_frame_sink *xs, struct xrt_frame *xf)
 	switch (xf->format) {
 	case XRT_FORMAT_R8G8B8: s->downstream->push_frame(s->downstream, xf); return;
 	case XRT_FORMAT_L8:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		from_L8_to_R8G8B8(converted, xf->width, xf->height, xf->stride, xf->data);
@@ -648,32 +593,32 @@ convert_frame_r8g8b8(struct xrt_frame_sink *xs, struct xrt_frame *xf)
 	case XRT_FORMAT_BAYER_GR8:;
 		uint32_t w = xf->width / 2;
 		uint32_t h = xf->height / 2;
-		if (!create_frame_with_format_of_size(xf, w, h, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format_of_size(s, xf, w, h, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		from_BAYER_GR8_to_R8G8B8(converted, w, h, xf->stride, xf->data);
 		break;
 	case XRT_FORMAT_YUYV422:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		from_YUYV422_to_R8G8B8(converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
 	case XRT_FORMAT_UYVY422:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		from_UYVY422_to_R8G8B8(converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
 	case XRT_FORMAT_YUV888:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		from_YUV888_to_R8G8B8(converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
 #ifdef XRT_HAVE_JPEG
 	case XRT_FORMAT_MJPEG:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		if (!from_MJPEG_to_R8G8B8(converted, xf->size, xf->data)) {
@@ -709,7 +654,7 @@ convert_frame_rgb_yuv_yuyv_uyvy_or_l8(struct xrt_frame_sink *xs, struct xrt_fram
 	case XRT_FORMAT_YUV888: s->downstream->push_frame(s->downstream, xf); return;
 #ifdef XRT_HAVE_JPEG
 	case XRT_FORMAT_MJPEG:
-		if (!create_frame_with_format(xf, XRT_FORMAT_YUV888, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_YUV888, &converted)) {
 			return;
 		}
 		if (!from_MJPEG_to_YUV888(converted, xf->size, xf->data)) {
@@ -744,7 +689,7 @@ convert_frame_yuv_yuyv_uyvy_or_l8(struct xrt_frame_sink *xs, struct xrt_frame *x
 	case XRT_FORMAT_YUV888: s->downstream->push_frame(s->downstream, xf); return;
 #ifdef XRT_HAVE_JPEG
 	case XRT_FORMAT_MJPEG:
-		if (!create_frame_with_format(xf, XRT_FORMAT_YUV888, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_YUV888, &converted)) {
 			return;
 		}
 		if (!from_MJPEG_to_YUV888(converted, xf->size, xf->data)) {
@@ -780,7 +725,7 @@ convert_frame_yuv_or_yuyv(struct xrt_frame_sink *xs, struct xrt_frame *xf)
 	case XRT_FORMAT_YUV888: s->downstream->push_frame(s->downstream, xf); return;
 #ifdef XRT_HAVE_JPEG
 	case XRT_FORMAT_MJPEG:
-		if (!create_frame_with_format(xf, XRT_FORMAT_YUV888, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_YUV888, &converted)) {
 			return;
 		}
 		if (!from_MJPEG_to_YUV888(converted, xf->size, xf->data)) {
@@ -808,7 +753,7 @@ convert_frame_bayer(struct xrt_frame_sink *xs, struct xrt_frame *xf)
 	uint32_t h = xf->height / 2;
 	struct xrt_frame *converted = NULL;
 
-	if (!create_frame_with_format_of_size(xf, w, h, XRT_FORMAT_R8G8B8, &converted)) {
+	if (!create_frame_with_format_of_size(s, xf, w, h, XRT_FORMAT_R8G8B8, &converted)) {
 		return;
 	}
 
@@ -820,6 +765,218 @@ convert_frame_bayer(struct xrt_frame_sink *xs, struct xrt_frame *xf)
 	xrt_frame_reference(&converted, NULL);
 }
 
+/*
+ *
+ * ROI and downscale functions.
+ *
+ */
+
+/*!
+ * Makes a zero copy view of the ROI, clamped to the frame and aligned so the
+ * conversion functions always get whole blocks.
+ */
+static bool
+crop_to_roi(struct u_sink_converter *s, struct xrt_frame *xf, struct xrt_frame **out_frame)
+{
+	if (s->roi.extent.w <= 0 || s->roi.extent.h <= 0 || !u_format_is_blocks(xf->format)) {
+		xrt_frame_reference(out_frame, xf);
+		return true;
+	}
+
+	// Bayer is converted in quads.
+	bool bayer = xf->format == XRT_FORMAT_BAYER_GR8;
+	int32_t align_x = bayer ? 2 : (int32_t)u_format_block_width(xf->format);
+	int32_t align_y = bayer ? 2 : (int32_t)u_format_block_height(xf->format);
+
+	int32_t x0 = MAX(s->roi.offset.w, 0);
+	int32_t y0 = MAX(s->roi.offset.h, 0);
+	int32_t x1 = MIN(s->roi.offset.w + s->roi.extent.w, (int32_t)xf->width);
+	int32_t y1 = MIN(s->roi.offset.h + s->roi.extent.h, (int32_t)xf->height);
+
+	x0 -= x0 % align_x;
+	y0 -= y0 % align_y;
+	x1 -= x1 % align_x;
+	y1 -= y1 % align_y;
+
+	if (x1 <= x0 || y1 <= y0) {
+		return false;
+	}
+
+	if (x0 == 0 && y0 == 0 && x1 == (int32_t)xf->width && y1 == (int32_t)xf->height) {
+		xrt_frame_reference(out_frame, xf);
+		return true;
+	}
+
+	struct xrt_rect rect = {
+	    .offset = {x0, y0},
+	    .extent = {x1 - x0, y1 - y0},
+	};
+
+	u_frame_create_roi(xf, rect, out_frame);
+
+	// Keep the stereo format if it still makes sense.
+	if (x0 == 0 && x1 == (int32_t)xf->width) {
+		(*out_frame)->stereo_format = xf->stereo_format;
+	}
+
+	return true;
+}
+
+static bool
+can_downscale(enum xrt_format from, enum xrt_format to)
+{
+	switch (from) {
+	case XRT_FORMAT_L8:
+	case XRT_FORMAT_YUYV422:
+	case XRT_FORMAT_UYVY422:
+	case XRT_FORMAT_YUV888: return to == XRT_FORMAT_R8G8B8 || to == XRT_FORMAT_L8;
+	case XRT_FORMAT_R8G8B8: return to == XRT_FORMAT_R8G8B8;
+	default: return false;
+	}
+}
+
+/*!
+ * Nearest sampling, picks every n-th pixel of every n-th row.
+ */
+static void
+downscale_row(enum xrt_format from, enum xrt_format to, const uint8_t *src, uint8_t *dst, uint32_t w, uint32_t n)
+{
+	bool rgb = to == XRT_FORMAT_R8G8B8;
+
+	for (uint32_t x = 0; x < w; x++) {
+		uint32_t sx = x * n;
+		const uint8_t *pair = src + (sx & ~1u) * 2;
+		uint8_t *out = dst + x * (rgb ? 3 : 1);
+		uint8_t y = 0, u = 128, v = 128;
+
+		switch (from) {
+		case XRT_FORMAT_L8: y = src[sx]; break;
+		case XRT_FORMAT_YUYV422:
+			y = src[sx * 2];
+			u = pair[1];
+			v = pair[3];
+			break;
+		case XRT_FORMAT_UYVY422:
+			y = src[sx * 2 + 1];
+			u = pair[0];
+			v = pair[2];
+			break;
+		case XRT_FORMAT_YUV888:
+			y = src[sx * 3 + 0];
+			u = src[sx * 3 + 1];
+			v = src[sx * 3 + 2];
+			break;
+		case XRT_FORMAT_R8G8B8:
+			out[0] = src[sx * 3 + 0];
+			out[1] = src[sx * 3 + 1];
+			out[2] = src[sx * 3 + 2];
+			continue;
+		default: assert(false); return;
+		}
+
+		if (!rgb) {
+			out[0] = y;
+		} else if (from == XRT_FORMAT_L8) {
+			out[0] = out[1] = out[2] = y;
+		} else {
+			u_format_convert_yuv_to_rgb(y, u, v, out);
+		}
+	}
+}
+
+static void
+convert_frame_downscaled(struct u_sink_converter *s, struct xrt_frame *xf)
+{
+	SINK_TRACE_MARKER();
+
+	uint32_t n = s->downscale;
+	uint32_t w = MAX(xf->width / n, 1);
+	uint32_t h = MAX(xf->height / n, 1);
+
+	struct xrt_frame *converted = NULL;
+	if (!create_frame_with_format_of_size(s, xf, w, h, s->format, &converted)) {
+		return;
+	}
+
+	for (uint32_t y = 0; y < h; y++) {
+		const uint8_t *src = xf->data + (size_t)y * n * xf->stride;
+		uint8_t *dst = converted->data + (size_t)y * converted->stride;
+		downscale_row(xf->format, s->format, src, dst, w, n);
+	}
+
+	s->downstream->push_frame(s->downstream, converted);
+
+	// Refcount in case it's being held downstream.
+	xrt_frame_reference(&converted, NULL);
+}
+
+static void
+convert_frame_roi(struct xrt_frame_sink *xs, struct xrt_frame *xf)
+{
+	SINK_TRACE_MARKER();
+
+	struct u_sink_converter *s = (struct u_sink_converter *)xs;
+
+	struct xrt_frame *decoded = NULL;
+	struct xrt_frame *cropped = NULL;
+
+#ifdef XRT_HAVE_JPEG
+	// Can't crop compressed frames, decode the whole frame first.
+	if (xf->format == XRT_FORMAT_MJPEG && s->format == XRT_FORMAT_R8G8B8) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &decoded)) {
+			return;
+		}
+		if (!from_MJPEG_to_R8G8B8(decoded, xf->size, xf->data)) {
+			xrt_frame_reference(&decoded, NULL);
+			return;
+		}
+		xf = decoded;
+	}
+#endif
+
+	if (!crop_to_roi(s, xf, &cropped)) {
+		xrt_frame_reference(&decoded, NULL);
+		return;
+	}
+
+	if (s->downscale > 1 && can_downscale(cropped->format, s->format)) {
+		convert_frame_downscaled(s, cropped);
+	} else {
+		s->convert(xs, cropped);
+	}
+
+	xrt_frame_reference(&cropped, NULL);
+	xrt_frame_reference(&decoded, NULL);
+}
+
+static void
+convert_frame_mjpeg(struct xrt_frame_sink *xs, struct xrt_frame *xf)
+{
+	SINK_TRACE_MARKER();
+
+	struct u_sink_converter *s = (struct u_sink_converter *)xs;
+
+	// Other formats get the regular full size conversion.
+	if (xf->format != XRT_FORMAT_MJPEG) {
+		s->convert(xs, xf);
+		return;
+	}
+
+#ifdef XRT_HAVE_JPEG
+	struct xrt_frame *converted = NULL;
+	if (!decode_MJPEG(s, xf, s->format, s->downscale, &converted)) {
+		return;
+	}
+
+	s->downstream->push_frame(s->downstream, converted);
+
+	// Refcount in case it's being held downstream.
+	xrt_frame_reference(&converted, NULL);
+#else
+	U_LOG_E("Cannot decode MJPEG, built without JPEG support!");
+#endif
+}
+
 static void
 break_apart(struct xrt_frame_node *node)
 {}
@@ -829,6 +986,9 @@ destroy(struct xrt_frame_node *node)
 {
 	struct u_sink_converter *s = container_of(node, struct u_sink_converter, node);
 
+	// Frames still held downstream keep the pool alive.
+	u_frame_pool_reference(&s->pool, NULL);
+
 	free(s);
 }
 
@@ -855,11 +1015,8 @@ u_sink_create_format_converter(struct xrt_frame_context *xfctx,
 	default: U_LOG_E("Format '%s' not supported", u_format_str(format)); return;
 	}
 
-#ifdef USE_TABLE
-	generate_lookup_YUV_to_RGBX();
-#endif
-
 	struct u_sink_converter *s = U_TYPED_CALLOC(struct u_sink_converter);
+	s->pool = u_frame_pool_create(CONVERTER_POOL_SIZE);
 	s->base.push_frame = func;
 	s->node.break_apart = break_apart;
 	s->node.destroy = destroy;
@@ -870,6 +1027,82 @@ u_sink_create_format_converter(struct xrt_frame_context *xfctx,
 	*out_xfs = &s->base;
 }
 
+void
+u_sink_create_format_converter_roi(struct xrt_frame_context *xfctx,
+                                   enum xrt_format format,
+                                   struct xrt_rect roi,
+                                   uint32_t downscale,
+                                   struct xrt_frame_sink *downstream,
+                                   struct xrt_frame_sink **out_xfs)
+{
+	assert(downstream != NULL);
+
+	void (*func)(struct xrt_frame_sink *, struct xrt_frame *);
+
+	switch (format) {
+	case XRT_FORMAT_R8G8B8: func = convert_frame_r8g8b8; break;
+	case XRT_FORMAT_L8: func = convert_frame_l8; break;
+	default: U_LOG_E("Format '%s' not supported", u_format_str(format)); return;
+	}
+
+	struct u_sink_converter *s = U_TYPED_CALLOC(struct u_sink_converter);
+	s->pool = u_frame_pool_create(CONVERTER_POOL_SIZE);
+	s->base.push_frame = convert_frame_roi;
+	s->node.break_apart = break_apart;
+	s->node.destroy = destroy;
+	s->downstream = downstream;
+	s->format = format;
+	s->roi = roi;
+	s->downscale = MAX(downscale, 1);
+	s->convert = func;
+
+	xrt_frame_context_add(xfctx, &s->node);
+
+	*out_xfs = &s->base;
+}
+
+void
+u_sink_create_mjpeg_decoder(struct xrt_frame_context *xfctx,
+                            enum xrt_format format,
+                            uint32_t scale_denom,
+                            struct xrt_frame_sink *downstream,
+                            struct xrt_frame_sink **out_xfs)
+{
+	assert(downstream != NULL);
+
+	void (*func)(struct xrt_frame_sink *, struct xrt_frame *);
+
+	switch (format) {
+	case XRT_FORMAT_R8G8B8: func = convert_frame_r8g8b8; break;
+	case XRT_FORMAT_L8: func = convert_frame_l8; break;
+	default: U_LOG_E("Format '%s' not supported", u_format_str(format)); return;
+	}
+
+	// Scales libjpeg supports everywhere.
+	uint32_t denom = 1;
+	while (denom < 8 && denom * 2 <= scale_denom) {
+		denom *= 2;
+	}
+
+	if (denom != scale_denom) {
+		U_LOG_W("MJPEG scale 1/%u not supported, using 1/%u", scale_denom, denom);
+	}
+
+	struct u_sink_converter *s = U_TYPED_CALLOC(struct u_sink_converter);
+	s->pool = u_frame_pool_create(CONVERTER_POOL_SIZE);
+	s->base.push_frame = convert_frame_mjpeg;
+	s->node.break_apart = break_apart;
+	s->node.destroy = destroy;
+	s->downstream = downstream;
+	s->format = format;
+	s->downscale = denom;
+	s->convert = func;
+
+	xrt_frame_context_add(xfctx, &s->node);
+
+	*out_xfs = &s->base;
+}
+
 void
 u_sink_create_to_r8g8b8_or_l8(struct xrt_frame_context *xfctx,
                               struct xrt_frame_sink *downstream,
@@ -878,15 +1111,12 @@ u_sink_create_to_r8g8b8_or_l8(struct xrt_frame_context *xfctx,
 	assert(downstream != NULL);
 
 	struct u_sink_converter *s = U_TYPED_CALLOC(struct u_sink_converter);
+	s->pool = u_frame_pool_create(CONVERTER_POOL_SIZE);
 	s->base.push_frame = convert_frame_r8g8b8_or_l8;
 	s->node.break_apart = break_apart;
 	s->node.destroy = destroy;
 	s->downstream = downstream;
 
-#ifdef USE_TABLE
-	generate_lookup_YUV_to_RGBX();
-#endif
-
 	xrt_frame_context_add(xfctx, &s->node);
 
 	*out_xfs = &s->base;
@@ -900,15 +1130,12 @@ u_sink_create_to_r8g8b8_r8g8b8a8_r8g8b8x8_or_l8(struct xrt_frame_context *xfctx,
 	assert(downstream != NULL);
 
 	struct u_sink_converter *s = U_TYPED_CALLOC(struct u_sink_converter);
+	s->pool = u_frame_pool_create(CONVERTER_POOL_SIZE);
 	s->base.push_frame = convert_frame_r8g8b8_r8g8b8a8_r8g8b8x8_or_l8;
 	s->node.break_apart = break_apart;
 	s->node.destroy = destroy;
 	s->downstream = downstream;
 
-#ifdef USE_TABLE
-	generate_lookup_YUV_to_RGBX();
-#endif
-
 	xrt_frame_context_add(xfctx, &s->node);
 
 	*out_xfs = &s->base;
@@ -922,6 +1149,7 @@ u_sink_create_to_r8g8b8_bayer_or_l8(struct xrt_frame_context *xfctx,
 	assert(downstream != NULL);
 
 	struct u_sink_converter *s = U_TYPED_CALLOC(struct u_sink_converter);
+	s->pool = u_frame_pool_create(CONVERTER_POOL_SIZE);
 	s->base.push_frame = convert_frame_r8g8b8_bayer_or_l8;
 	s->node.break_apart = break_apart;
 	s->node.destroy = destroy;
@@ -940,6 +1168,7 @@ u_sink_create_to_rgb_yuv_yuyv_uyvy_or_l8(struct xrt_frame_context *xfctx,
 	assert(downstream != NULL);
 
 	struct u_sink_converter *s = U_TYPED_CALLOC(struct u_sink_converter);
+	s->pool = u_frame_pool_create(CONVERTER_POOL_SIZE);
 	s->base.push_frame = convert_frame_rgb_yuv_yuyv_uyvy_or_l8;
 	s->node.break_apart = break_apart;
 	s->node.destroy = destroy;
@@ -958,6 +1187,7 @@ u_sink_create_to_yuv_yuyv_uyvy_or_l8(struct xrt_frame_context *xfctx,
 	assert(downstream != NULL);
 
 	struct u_sink_converter *s = U_TYPED_CALLOC(struct u_sink_converter);
+	s->pool = u_frame_pool_create(CONVERTER_POOL_SIZE);
 	s->base.push_frame = convert_frame_yuv_yuyv_uyvy_or_l8;
 	s->node.break_apart = break_apart;
 	s->node.destroy = destroy;
@@ -976,6 +1206,7 @@ u_sink_create_to_yuv_or_yuyv(struct xrt_frame_context *xfctx,
 	assert(downstream != NULL);
 
 	struct u_sink_converter *s = U_TYPED_CALLOC(struct u_sink_converter);
+	s->pool = u_frame_pool_create(CONVERTER_POOL_SIZE);
 	s->base.push_frame = convert_frame_yuv_or_yuyv;
 	s->node.break_apart = break_apart;
 	s->node.destroy = destroy;
@@ -2,12 +2,14 @@
 // SPDX-License-Identifier: BSL-1.0
 /*!
  * @file
- * @brief  An @ref xrt_frame_sink that takes two frames, enforces gen-lock and pushes downstream in left-right order
+ * @brief  An @ref xrt_frame_sink that takes frames from several cameras, enforces gen-lock and pushes downstream in
+ *         camera order
  * @author Moses Turner <moses@collabora.com>
  * @author Jakob Bornecrantz <jakob@collabora.com>
  * @ingroup aux_util
  */
 
+#include "util/u_var.h"
 #include "util/u_misc.h"
 #include "util/u_sink.h"
 #include "util/u_frame.h"
@@ -15,34 +17,60 @@
 #include "util/u_trace_marker.h"
 
 #include <stdio.h>
+#include <assert.h>
 #include <pthread.h>
 #include <inttypes.h>
 
 
+struct u_sink_force_genlock;
+
 /*!
- * An @ref xrt_frame_sink that takes two frames in any order, and pushes downstream in left-right order once it
- * has two frames that are close enough together. Shouldn't ever drop frames.
+ * One of the inputs of a @ref u_sink_force_genlock.
  *
  * @implements xrt_frame_sink
+ */
+struct u_sink_force_genlock_input
+{
+	struct xrt_frame_sink base;
+
+	struct u_sink_force_genlock *q;
+
+	//! Index of this input, and of its frame slot and consumer.
+	uint32_t index;
+};
+
+/*!
+ * An @ref xrt_frame_sink that takes one frame per camera in any order, and pushes downstream in camera order once it
+ * has a frame from every camera and they are all close enough together. Frames that are too old to be matched are
+ * dropped.
+ *
  * @implements xrt_frame_node
  */
 struct u_sink_force_genlock
 {
-	//! Base sink for left.
-	struct xrt_frame_sink left;
-
-	//! Base sink for right.
-	struct xrt_frame_sink right;
+	//! Base sinks, one per camera.
+	struct u_sink_force_genlock_input inputs[XRT_TRACKING_MAX_SLAM_CAMS];
 
 	//! For tracking on the frame context.
 	struct xrt_frame_node node;
 
-	//! The consumer of the frames that are queued.
-	struct xrt_frame_sink *consumer_left;
-	struct xrt_frame_sink *consumer_right;
+	//! The consumers of the frames that are queued.
+	struct xrt_frame_sink *consumers[XRT_TRACKING_MAX_SLAM_CAMS];
+
+	//! Number of cameras.
+	uint32_t count;
+
+	//! How far apart the timestamps of a frameset may be.
+	int64_t tolerance_ns;
 
-	//! The current queued frame.
-	struct xrt_frame *frames[2];
+	/*!
+	 * The latest frame from each camera, only a pointer swap is done with
+	 * the mutex held so pushing never waits on the downstream sinks.
+	 */
+	struct xrt_frame *frames[XRT_TRACKING_MAX_SLAM_CAMS];
+
+	//! Number of non-NULL entries in @ref frames.
+	uint32_t frame_count;
 
 	pthread_t thread;
 	pthread_mutex_t mutex;
@@ -54,21 +82,78 @@ struct u_sink_force_genlock
 	//! Should we keep running?
 	//! currently, true upon startup, false as we're exiting.
 	bool running;
+
+	struct
+	{
+		//! Framesets pushed downstream.
+		uint64_t pushed;
+
+		//! Framesets that were too far apart and had frames dropped.
+		uint64_t misses;
+
+		//! Frames dropped, both unmatched and replaced before being matched.
+		uint64_t dropped;
+
+		//! Spread of the timestamps of the last pushed frameset.
+		int64_t spread_ns;
+	} stats;
 };
 
+
+/*
+ *
+ * Helper functions.
+ *
+ */
+
+static void
+release_frames(struct xrt_frame **frames, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++) {
+		xrt_frame_reference(&frames[i], NULL);
+	}
+}
+
+/*!
+ * Puts back the frames that can still be matched with a newer frameset, the
+ * ones within the tolerance of the newest frame, drops the others.
+ */
+static void
+keep_matchable_locked(struct u_sink_force_genlock *q, struct xrt_frame **frames, int64_t newest_ts)
+{
+	for (uint32_t i = 0; i < q->count; i++) {
+		if (newest_ts - (int64_t)frames[i]->timestamp > q->tolerance_ns) {
+			q->stats.dropped++;
+			continue;
+		}
+
+		// Move the reference back into the slot.
+		q->frames[i] = frames[i];
+		frames[i] = NULL;
+		q->frame_count++;
+	}
+}
+
+
+/*
+ *
+ * Sink and node functions.
+ *
+ */
+
 static void *
 force_genlock_mainloop(void *ptr)
 {
 	U_TRACE_SET_THREAD_NAME("Sink Genlock");
 
 	struct u_sink_force_genlock *q = (struct u_sink_force_genlock *)ptr;
-	struct xrt_frame *frames[2] = {NULL, NULL};
+	struct xrt_frame *frames[XRT_TRACKING_MAX_SLAM_CAMS] = {0};
 
 	pthread_mutex_lock(&q->mutex);
 
 	while (q->running) {
-		// Wait for both frames.
-		if (q->frames[0] == NULL || q->frames[1] == NULL) {
+		// Wait for all frames.
+		if (q->frame_count < q->count) {
 			pthread_cond_wait(&q->cond, &q->mutex);
 		}
 
@@ -78,42 +163,51 @@ force_genlock_mainloop(void *ptr)
 			break;
 		}
 
-		if (q->frames[0] == NULL || q->frames[1] == NULL) {
+		if (q->frame_count < q->count) {
 			continue;
 		}
 
 		SINK_TRACE_IDENT(force_genlock_frame);
 
 		/*
-		 * We need to take a reference on the current frame, this is to
-		 * keep it alive during the call to the consumer should it be
-		 * replaced. But we no longer need to hold onto the frame on the
-		 * queue so we move the pointer.
+		 * We need to take a reference on the current frames, this is to
+		 * keep them alive during the call to the consumers should they be
+		 * replaced. But we no longer need to hold onto the frames on the
+		 * queue so we move the pointers.
 		 */
-		frames[0] = q->frames[0];
-		frames[1] = q->frames[1];
-		q->frames[0] = NULL;
-		q->frames[1] = NULL;
+		for (uint32_t i = 0; i < q->count; i++) {
+			frames[i] = q->frames[i];
+			q->frames[i] = NULL;
+		}
+		q->frame_count = 0;
 
 		/*
 		 * Check timestamps.
 		 */
-		int64_t diff_ns = frames[0]->timestamp - frames[1]->timestamp;
-		if (diff_ns < -U_TIME_1MS_IN_NS || diff_ns > U_TIME_1MS_IN_NS) {
+		int64_t oldest_ts = (int64_t)frames[0]->timestamp;
+		int64_t newest_ts = (int64_t)frames[0]->timestamp;
+		for (uint32_t i = 1; i < q->count; i++) {
+			int64_t frame_ts = (int64_t)frames[i]->timestamp;
+			if (frame_ts < oldest_ts) {
+				oldest_ts = frame_ts;
+			}
+			if (frame_ts > newest_ts) {
+				newest_ts = frame_ts;
+			}
+		}
 
-			U_LOG_W("Frame differ in timestamps too much! (%lli)", (long long)diff_ns);
+		int64_t spread_ns = newest_ts - oldest_ts;
+		if (spread_ns > q->tolerance_ns) {
+			U_LOG_W("Frame differ in timestamps too much! (%lli)", (long long)spread_ns);
 
-			// Save the most recent frame.
-			if (diff_ns > 0) {
-				xrt_frame_reference(&q->frames[0], frames[0]);
-			} else {
-				xrt_frame_reference(&q->frames[1], frames[1]);
-			}
+			q->stats.misses++;
+
+			// Save the most recent frames.
+			keep_matchable_locked(q, frames, newest_ts);
 			pthread_mutex_unlock(&q->mutex);
 
 			// Don't hold the lock while releasing the frames.
-			xrt_frame_reference(&frames[0], NULL);
-			xrt_frame_reference(&frames[1], NULL);
+			release_frames(frames, q->count);
 
 			pthread_mutex_lock(&q->mutex);
 			continue;
@@ -128,18 +222,18 @@ force_genlock_mainloop(void *ptr)
 		/*
 		 * Average the timestamps, SLAM systems break if they don't have the exact same timestamp.
 		 * (This is not great, because on DepthAI the images *are* taken like 0.1ms apart, and we *could* expose
-		 * that, but oh well.)
+		 * that, but oh well.) Summing the offsets from the first one doesn't overflow.
 		 */
+		int64_t offset_sum = 0;
+		for (uint32_t i = 1; i < q->count; i++) {
+			offset_sum += (int64_t)(frames[i]->timestamp - frames[0]->timestamp);
+		}
 
-		int64_t ts_1 = frames[0]->timestamp;
-		int64_t ts_2 = frames[1]->timestamp;
-
-		int64_t diff = (ts_2 - ts_1);
-
-		int64_t ts = ts_1 + (diff / 2);
+		int64_t ts = (int64_t)frames[0]->timestamp + offset_sum / (int64_t)q->count;
 
-		frames[0]->timestamp = ts;
-		frames[1]->timestamp = ts;
+		for (uint32_t i = 0; i < q->count; i++) {
+			frames[i]->timestamp = ts;
+		}
 
 		if (ts == q->last_ts) {
 			U_LOG_W("Got an image frame with a duplicate timestamp! Old: %" PRId64 "; New: %" PRId64,
@@ -149,16 +243,20 @@ force_genlock_mainloop(void *ptr)
 			        "; New: %" PRId64,
 			        q->last_ts, ts);
 		} else {
-			// Send to the consumer, in left-right order.
-			xrt_sink_push_frame(q->consumer_left, frames[0]);
-			xrt_sink_push_frame(q->consumer_right, frames[1]);
+			// Send to the consumers, in camera order.
+			for (uint32_t i = 0; i < q->count; i++) {
+				xrt_sink_push_frame(q->consumers[i], frames[i]);
+			}
+
+			q->last_ts = ts;
+			q->stats.pushed++;
+			q->stats.spread_ns = spread_ns;
 		}
 		/*
-		 * Drop our reference - we don't need it anymore. If the consumer wants to keep it, they will have
-		 * referenced it in their push_frame handler.
+		 * Drop our references - we don't need them anymore. If the consumers want to keep them, they will
+		 * have referenced them in their push_frame handler.
 		 */
-		xrt_frame_reference(&frames[0], NULL);
-		xrt_frame_reference(&frames[1], NULL);
+		release_frames(frames, q->count);
 
 		// Have to lock it again.
 		pthread_mutex_lock(&q->mutex);
@@ -170,47 +268,43 @@ force_genlock_mainloop(void *ptr)
 }
 
 static void
-force_genlock_left_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
+force_genlock_push_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
 {
 	SINK_TRACE_MARKER();
 
-	struct u_sink_force_genlock *q = container_of(xfs, struct u_sink_force_genlock, left);
-
-	pthread_mutex_lock(&q->mutex);
-
-	// Only schedule new frames if we are running.
-	if (q->running) {
-		xrt_frame_reference(&q->frames[0], xf);
-	}
-
-	// Wake up the thread, if both frames are here.
-	if (q->frames[0] != NULL && q->frames[1] != NULL) {
-		pthread_cond_signal(&q->cond);
-	}
-
-	pthread_mutex_unlock(&q->mutex);
-}
-
-static void
-force_genlock_right_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
-{
-	SINK_TRACE_MARKER();
+	struct u_sink_force_genlock_input *input = (struct u_sink_force_genlock_input *)xfs;
+	struct u_sink_force_genlock *q = input->q;
+	struct xrt_frame *old = NULL;
+	struct xrt_frame *new_frame = NULL;
 
-	struct u_sink_force_genlock *q = container_of(xfs, struct u_sink_force_genlock, right);
+	// Take the reference before locking, the lock only covers the swap.
+	xrt_frame_reference(&new_frame, xf);
 
 	pthread_mutex_lock(&q->mutex);
 
 	// Only schedule new frames if we are running.
 	if (q->running) {
-		xrt_frame_reference(&q->frames[1], xf);
+		old = q->frames[input->index];
+		q->frames[input->index] = new_frame;
+		new_frame = NULL;
+
+		if (old != NULL) {
+			q->stats.dropped++;
+		} else {
+			q->frame_count++;
+		}
 	}
 
-	// Wake up the thread, if both frames are here.
-	if (q->frames[0] != NULL && q->frames[1] != NULL) {
+	// Wake up the thread, if all frames are here.
+	if (q->frame_count == q->count) {
 		pthread_cond_signal(&q->cond);
 	}
 
 	pthread_mutex_unlock(&q->mutex);
+
+	// Don't hold the lock while releasing the frames.
+	xrt_frame_reference(&old, NULL);
+	xrt_frame_reference(&new_frame, NULL);
 }
 
 static void
@@ -226,8 +320,8 @@ force_genlock_break_apart(struct xrt_frame_node *node)
 	q->running = false;
 
 	// Release any frame waiting for submission.
-	xrt_frame_reference(&q->frames[0], NULL);
-	xrt_frame_reference(&q->frames[1], NULL);
+	release_frames(q->frames, q->count);
+	q->frame_count = 0;
 
 	// Wake up the thread.
 	pthread_cond_signal(&q->cond);
@@ -258,21 +352,30 @@ force_genlock_destroy(struct xrt_frame_node *node)
  */
 
 bool
-u_sink_force_genlock_create(struct xrt_frame_context *xfctx,
-                            struct xrt_frame_sink *downstream_left,
-                            struct xrt_frame_sink *downstream_right,
-                            struct xrt_frame_sink **out_left_xfs,
-                            struct xrt_frame_sink **out_right_xfs)
+u_sink_force_genlock_create_many(struct xrt_frame_context *xfctx,
+                                 uint32_t count,
+                                 int64_t tolerance_ns,
+                                 struct xrt_frame_sink **downstreams,
+                                 struct xrt_frame_sink **out_xfss)
 {
+	if (count == 0 || count > XRT_TRACKING_MAX_SLAM_CAMS) {
+		U_LOG_E("Invalid camera count %u, max is %u", count, XRT_TRACKING_MAX_SLAM_CAMS);
+		return false;
+	}
+
 	struct u_sink_force_genlock *q = U_TYPED_CALLOC(struct u_sink_force_genlock);
 	int ret = 0;
 
-	q->left.push_frame = force_genlock_left_frame;
-	q->right.push_frame = force_genlock_right_frame;
+	for (uint32_t i = 0; i < count; i++) {
+		q->inputs[i].base.push_frame = force_genlock_push_frame;
+		q->inputs[i].q = q;
+		q->inputs[i].index = i;
+		q->consumers[i] = downstreams[i];
+	}
 	q->node.break_apart = force_genlock_break_apart;
 	q->node.destroy = force_genlock_destroy;
-	q->consumer_left = downstream_left;
-	q->consumer_right = downstream_right;
+	q->count = count;
+	q->tolerance_ns = tolerance_ns;
 	q->running = true;
 
 	ret = pthread_mutex_init(&q->mutex, NULL);
@@ -298,8 +401,66 @@ u_sink_force_genlock_create(struct xrt_frame_context *xfctx,
 
 	xrt_frame_context_add(xfctx, &q->node);
 
-	*out_left_xfs = &q->left;
-	*out_right_xfs = &q->right;
+	for (uint32_t i = 0; i < count; i++) {
+		out_xfss[i] = &q->inputs[i].base;
+	}
 
 	return true;
 }
+
+bool
+u_sink_force_genlock_create(struct xrt_frame_context *xfctx,
+                            struct xrt_frame_sink *downstream_left,
+                            struct xrt_frame_sink *downstream_right,
+                            struct xrt_frame_sink **out_left_xfs,
+                            struct xrt_frame_sink **out_right_xfs)
+{
+	struct xrt_frame_sink *downstreams[2] = {downstream_left, downstream_right};
+	struct xrt_frame_sink *xfss[2] = {NULL, NULL};
+
+	if (!u_sink_force_genlock_create_many(xfctx, 2, U_SINK_FORCE_GENLOCK_DEFAULT_TOLERANCE_NS, downstreams,
+	                                      xfss)) {
+		return false;
+	}
+
+	*out_left_xfs = xfss[0];
+	*out_right_xfs = xfss[1];
+
+	return true;
+}
+
+bool
+u_sink_force_genlock_create_slam(struct xrt_frame_context *xfctx,
+                                 int64_t tolerance_ns,
+                                 const struct xrt_slam_sinks *downstream,
+                                 struct xrt_slam_sinks *out_sinks)
+{
+	struct xrt_slam_sinks sinks = *downstream;
+
+	if (!u_sink_force_genlock_create_many(xfctx, (uint32_t)downstream->cam_count, tolerance_ns,
+	                                      sinks.cams, sinks.cams)) {
+		return false;
+	}
+
+	*out_sinks = sinks;
+
+	return true;
+}
+
+void
+u_sink_force_genlock_add_vars(struct xrt_frame_sink *xfs, void *root, const char *prefix)
+{
+	struct u_sink_force_genlock *q = ((struct u_sink_force_genlock_input *)xfs)->q;
+	char name[64];
+
+	snprintf(name, sizeof(name), "%s framesets pushed", prefix);
+	u_var_add_ro_u64(root, &q->stats.pushed, name);
+	snprintf(name, sizeof(name), "%s sync misses", prefix);
+	u_var_add_ro_u64(root, &q->stats.misses, name);
+	snprintf(name, sizeof(name), "%s frames dropped", prefix);
+	u_var_add_ro_u64(root, &q->stats.dropped, name);
+	snprintf(name, sizeof(name), "%s timestamp spread (ns)", prefix);
+	u_var_add_ro_i64(root, &q->stats.spread_ns, name);
+	snprintf(name, sizeof(name), "%s tolerance (ns)", prefix);
+	u_var_add_i64(root, &q->tolerance_ns, name);
+}
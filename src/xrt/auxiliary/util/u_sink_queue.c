@@ -7,23 +7,38 @@
  * @ingroup aux_util
  */
 
+#include "os/os_threading.h"
+
+#include "util/u_debug.h"
 #include "util/u_misc.h"
 #include "util/u_sink.h"
 #include "util/u_trace_marker.h"
+#include "util/u_var.h"
 
 #include <stdio.h>
-#include <pthread.h>
 
-struct u_sink_queue_elem
+
+DEBUG_GET_ONCE_OPTION(sink_queue_core_class, "U_SINK_QUEUE_CORE_CLASS", NULL)
+
+//! Ring size used when the queue is created as unbounded.
+#define U_SINK_QUEUE_UNBOUNDED_SIZE (1024)
+
+/*!
+ * Cell in the ring buffer, the sequence number tells producers and the
+ * consumer who owns the cell.
+ */
+struct u_sink_queue_cell
 {
+	xrt_atomic_s32_t sequence;
+
 	struct xrt_frame *frame;
-	struct u_sink_queue_elem *next;
 };
 
 /*!
  * An @ref xrt_frame_sink queue, any frames received will be pushed to the
- * downstream consumer on the queue thread. Will drop frames should multiple
- * frames be queued up.
+ * downstream consumer on the queue thread. Frames are held in a lock-free
+ * ring buffer, so pushing never allocates and never blocks. What frame is
+ * dropped when the ring is full depends on the @ref u_sink_queue_policy.
  *
  * @implements xrt_frame_sink
  * @implements xrt_frame_node
@@ -38,94 +53,163 @@ struct u_sink_queue
 	//! The consumer of the frames that are queued.
 	struct xrt_frame_sink *consumer;
 
-	//! Front of the queue (oldest frame, first to be consumed)
-	struct u_sink_queue_elem *front;
+	//! What to do when the ring is full.
+	enum u_sink_queue_policy policy;
+
+	//! Ring of frames, size is a power of two.
+	struct u_sink_queue_cell *cells;
+
+	//! Size of the ring minus one.
+	uint32_t mask;
 
-	//! Back of the queue (newest frame, back->next is always null)
-	struct u_sink_queue_elem *back;
+	//! Created with a max size of one, only the latest frame is consumed.
+	bool latest_only;
 
-	//! Number of currently enqueued frames
-	uint64_t size;
+	//! Next position to push to, shared between producers.
+	xrt_atomic_s32_t enqueue_pos;
 
-	//! Max amount of frames before dropping new ones. 0 means unbounded.
-	uint64_t max_size;
+	//! Next position to pop from, producers pop too when dropping oldest.
+	xrt_atomic_s32_t dequeue_pos;
 
-	pthread_t thread;
-	pthread_mutex_t mutex;
+	struct os_thread thread;
 
-	//! So we can wake the mainloop up
-	pthread_cond_t cond;
+	//! Posted once per pushed frame, so we can wake the mainloop up.
+	struct os_semaphore sem;
 
 	//! Should we keep running.
-	bool running;
+	volatile bool running;
+
+	/*!
+	 * For the debug UI, written without locking so only exact with a
+	 * single producer.
+	 */
+	struct
+	{
+		//! Frames pushed by producers, including dropped ones.
+		uint64_t pushed;
+		//! Frames dropped by producers because the ring was full.
+		uint64_t dropped;
+		//! Frames the consumer skipped to get to the latest one.
+		uint64_t skipped;
+		//! Frames in the ring, as last seen by a producer or the consumer.
+		int32_t depth;
+	} stats;
 };
 
-//! Call with q->mutex locked.
-static bool
-queue_is_empty(struct u_sink_queue *q)
+
+/*
+ *
+ * Ring functions.
+ *
+ */
+
+static inline int32_t
+seq_add(int32_t value, uint32_t add)
 {
-	return q->size == 0;
+	// Sequence numbers wrap around, avoid signed overflow.
+	return (int32_t)((uint32_t)value + add);
 }
 
-//! Call with q->mutex locked.
-static bool
-queue_is_full(struct u_sink_queue *q)
+static inline int32_t
+seq_diff(int32_t a, int32_t b)
 {
-	bool is_unbounded = q->max_size == 0;
-	return q->size >= q->max_size && !is_unbounded;
+	return (int32_t)((uint32_t)a - (uint32_t)b);
 }
 
-//! Pops the oldest frame, reference counting unchanged.
-//! Call with q->mutex locked.
-static struct xrt_frame *
-queue_pop(struct u_sink_queue *q)
+//! Tries to push a frame, takes ownership of the reference on success.
+static bool
+ring_try_push(struct u_sink_queue *q, struct xrt_frame *xf)
 {
-	assert(!queue_is_empty(q));
-	struct xrt_frame *frame = q->front->frame;
-	struct u_sink_queue_elem *old_front = q->front;
-	q->front = q->front->next;
-	free(old_front);
-	q->size--;
-	if (q->front == NULL) {
-		assert(queue_is_empty(q));
-		q->back = NULL;
+	struct u_sink_queue_cell *cell = NULL;
+	int32_t pos = q->enqueue_pos;
+
+	while (true) {
+		cell = &q->cells[(uint32_t)pos & q->mask];
+		int32_t diff = seq_diff(cell->sequence, pos);
+
+		if (diff == 0) {
+			int32_t old = xrt_atomic_s32_cmpxchg(&q->enqueue_pos, pos, seq_add(pos, 1));
+			if (old == pos) {
+				break;
+			}
+			pos = old;
+		} else if (diff < 0) {
+			// Full.
+			return false;
+		} else {
+			pos = q->enqueue_pos;
+		}
 	}
-	return frame;
+
+	cell->frame = xf;
+
+	// Publish the frame before handing the cell over.
+	xrt_atomic_thread_fence();
+	cell->sequence = seq_add(pos, 1);
+
+	return true;
 }
 
-//! Tries to push a frame and increases its reference count.
-//! Call with q->mutex locked.
+//! Pops the oldest frame, reference counting unchanged.
 static bool
-queue_try_refpush(struct u_sink_queue *q, struct xrt_frame *xf)
+ring_try_pop(struct u_sink_queue *q, struct xrt_frame **out_xf)
 {
-	if (queue_is_full(q)) {
-		return false;
-	}
-	struct u_sink_queue_elem *elem = U_TYPED_CALLOC(struct u_sink_queue_elem);
-	xrt_frame_reference(&elem->frame, xf);
-	elem->next = NULL;
-	if (q->back == NULL) { // First frame
-		q->front = elem;
-	} else { // Next frame
-		q->back->next = elem;
+	struct u_sink_queue_cell *cell = NULL;
+	int32_t pos = q->dequeue_pos;
+
+	while (true) {
+		cell = &q->cells[(uint32_t)pos & q->mask];
+		int32_t diff = seq_diff(cell->sequence, seq_add(pos, 1));
+
+		if (diff == 0) {
+			// The compare and swap is a full barrier, orders the frame read.
+			int32_t old = xrt_atomic_s32_cmpxchg(&q->dequeue_pos, pos, seq_add(pos, 1));
+			if (old == pos) {
+				break;
+			}
+			pos = old;
+		} else if (diff < 0) {
+			// Empty.
+			return false;
+		} else {
+			pos = q->dequeue_pos;
+		}
 	}
-	q->back = elem;
-	q->size++;
+
+	*out_xf = cell->frame;
+	cell->frame = NULL;
+
+	// Done with the cell, hand it back to the producers.
+	xrt_atomic_thread_fence();
+	cell->sequence = seq_add(pos, q->mask + 1);
+
 	return true;
 }
 
 //! Clears the queue and unreferences all of its frames.
-//! Call with q->mutex locked.
 static void
-queue_refclear(struct u_sink_queue *q)
+ring_refclear(struct u_sink_queue *q)
 {
-	while (!queue_is_empty(q)) {
-		assert((q->size > 1) ^ (q->front == q->back));
-		struct xrt_frame *xf = queue_pop(q);
+	struct xrt_frame *xf = NULL;
+	while (ring_try_pop(q, &xf)) {
 		xrt_frame_reference(&xf, NULL);
 	}
 }
 
+
+static inline void
+update_depth(struct u_sink_queue *q)
+{
+	q->stats.depth = seq_diff(q->enqueue_pos, q->dequeue_pos);
+}
+
+
+/*
+ *
+ * Sink and node functions.
+ *
+ */
+
 static void *
 queue_mainloop(void *ptr)
 {
@@ -134,40 +218,32 @@ queue_mainloop(void *ptr)
 	struct u_sink_queue *q = (struct u_sink_queue *)ptr;
 	struct xrt_frame *frame = NULL;
 
-	pthread_mutex_lock(&q->mutex);
-
-	while (q->running) {
-
+	while (true) {
 		// No new frame, wait.
-		if (queue_is_empty(q)) {
-			pthread_cond_wait(&q->cond, &q->mutex);
-		}
+		os_semaphore_wait(&q->sem, 0);
 
 		// In this case, queue_break_apart woke us up to turn us off.
 		if (!q->running) {
 			break;
 		}
 
-		if (queue_is_empty(q)) {
+		// The frame might have been dropped by a producer.
+		if (!ring_try_pop(q, &frame)) {
 			continue;
 		}
 
-		SINK_TRACE_IDENT(queue_frame);
+		// Skip straight to the latest frame, the ring has room for two.
+		struct xrt_frame *newer = NULL;
+		while (q->latest_only && ring_try_pop(q, &newer)) {
+			xrt_frame_reference(&frame, NULL);
+			frame = newer;
+			newer = NULL;
+			q->stats.skipped++;
+		}
 
-		/*
-		 * Dequeue frame.
-		 * We need to take a reference on the current frame, this is to
-		 * keep it alive during the call to the consumer should it be
-		 * replaced. But we no longer need to hold onto the frame on the
-		 * queue so we dequeue it.
-		 */
-		frame = queue_pop(q);
+		update_depth(q);
 
-		/*
-		 * Unlock the mutex when we do the work, so a new frame can be
-		 * queued.
-		 */
-		pthread_mutex_unlock(&q->mutex);
+		SINK_TRACE_IDENT(queue_frame);
 
 		// Send to the consumer that does the work.
 		q->consumer->push_frame(q->consumer, frame);
@@ -177,13 +253,8 @@ queue_mainloop(void *ptr)
 		 * the consumer.
 		 */
 		xrt_frame_reference(&frame, NULL);
-
-		// Have to lock it again.
-		pthread_mutex_lock(&q->mutex);
 	}
 
-	pthread_mutex_unlock(&q->mutex);
-
 	return NULL;
 }
 
@@ -194,42 +265,53 @@ queue_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
 
 	struct u_sink_queue *q = (struct u_sink_queue *)xfs;
 
-	pthread_mutex_lock(&q->mutex);
-
 	// Only schedule new frames if we are running.
-	if (q->running) {
-		queue_try_refpush(q, xf);
+	if (!q->running) {
+		return;
 	}
 
-	// Wake up the thread.
-	pthread_cond_signal(&q->cond);
+	struct xrt_frame *ref = NULL;
+	xrt_frame_reference(&ref, xf);
+
+	q->stats.pushed++;
 
-	pthread_mutex_unlock(&q->mutex);
+	while (!ring_try_push(q, ref)) {
+		if (q->policy == U_SINK_QUEUE_DROP_NEWEST) {
+			xrt_frame_reference(&ref, NULL);
+			q->stats.dropped++;
+			return;
+		}
+
+		// Make room by dropping the oldest frame.
+		struct xrt_frame *old = NULL;
+		if (ring_try_pop(q, &old)) {
+			xrt_frame_reference(&old, NULL);
+			q->stats.dropped++;
+		}
+	}
+
+	update_depth(q);
+
+	// Wake up the thread, only enters the kernel if it is sleeping.
+	os_semaphore_release(&q->sem);
 }
 
 static void
 queue_break_apart(struct xrt_frame_node *node)
 {
 	struct u_sink_queue *q = container_of(node, struct u_sink_queue, node);
-	void *retval = NULL;
-
-	// The fields are protected.
-	pthread_mutex_lock(&q->mutex);
 
 	// Stop the thread and inhibit any new frames to be added to the queue.
 	q->running = false;
 
-	// Release any frame waiting for submission.
-	queue_refclear(q);
-
 	// Wake up the thread.
-	pthread_cond_signal(&q->cond);
-
-	// No longer need to protect fields.
-	pthread_mutex_unlock(&q->mutex);
+	os_semaphore_release(&q->sem);
 
 	// Wait for thread to finish.
-	pthread_join(q->thread, &retval);
+	os_thread_join(&q->thread);
+
+	// Release any frame waiting for submission.
+	ring_refclear(q);
 }
 
 static void
@@ -237,9 +319,13 @@ queue_destroy(struct xrt_frame_node *node)
 {
 	struct u_sink_queue *q = container_of(node, struct u_sink_queue, node);
 
+	// A frame might have snuck in while breaking apart.
+	ring_refclear(q);
+
 	// Destroy resources.
-	pthread_mutex_destroy(&q->mutex);
-	pthread_cond_destroy(&q->cond);
+	os_thread_destroy(&q->thread);
+	os_semaphore_destroy(&q->sem);
+	free(q->cells);
 	free(q);
 }
 
@@ -251,10 +337,11 @@ queue_destroy(struct xrt_frame_node *node)
  */
 
 bool
-u_sink_queue_create(struct xrt_frame_context *xfctx,
-                    uint64_t max_size,
-                    struct xrt_frame_sink *downstream,
-                    struct xrt_frame_sink **out_xfs)
+u_sink_queue_create_with_policy(struct xrt_frame_context *xfctx,
+                                uint64_t max_size,
+                                enum u_sink_queue_policy policy,
+                                struct xrt_frame_sink *downstream,
+                                struct xrt_frame_sink **out_xfs)
 {
 	struct u_sink_queue *q = U_TYPED_CALLOC(struct u_sink_queue);
 	int ret = 0;
@@ -263,35 +350,85 @@ u_sink_queue_create(struct xrt_frame_context *xfctx,
 	q->node.break_apart = queue_break_apart;
 	q->node.destroy = queue_destroy;
 	q->consumer = downstream;
+	q->policy = policy;
 	q->running = true;
 
-	q->size = 0;
-	q->max_size = max_size;
+	if (max_size == 0 || max_size > U_SINK_QUEUE_UNBOUNDED_SIZE) {
+		max_size = U_SINK_QUEUE_UNBOUNDED_SIZE;
+	}
+
+	// Round up to a power of two, the ring needs at least two cells.
+	uint32_t size = 2;
+	while (size < max_size) {
+		size *= 2;
+	}
+
+	q->mask = size - 1;
+	q->latest_only = max_size == 1;
+	q->cells = U_TYPED_ARRAY_CALLOC(struct u_sink_queue_cell, size);
+	for (uint32_t i = 0; i < size; i++) {
+		q->cells[i].sequence = (int32_t)i;
+	}
 
-	ret = pthread_mutex_init(&q->mutex, NULL);
+	ret = os_semaphore_init(&q->sem, 0);
 	if (ret != 0) {
+		free(q->cells);
 		free(q);
 		return false;
 	}
 
-	ret = pthread_cond_init(&q->cond, NULL);
-	if (ret) {
-		pthread_mutex_destroy(&q->mutex);
+	ret = os_thread_init(&q->thread);
+	if (ret != 0) {
+		os_semaphore_destroy(&q->sem);
+		free(q->cells);
 		free(q);
 		return false;
 	}
 
-	ret = pthread_create(&q->thread, NULL, queue_mainloop, q);
+	ret = os_thread_start(&q->thread, queue_mainloop, q);
 	if (ret != 0) {
-		pthread_cond_destroy(&q->cond);
-		pthread_mutex_destroy(&q->mutex);
+		os_thread_destroy(&q->thread);
+		os_semaphore_destroy(&q->sem);
+		free(q->cells);
 		free(q);
 		return false;
 	}
 
+	// Best effort, the queue works fine unpinned.
+	enum os_thread_core_class core_class =
+	    os_thread_core_class_from_string(debug_get_option_sink_queue_core_class(), OS_THREAD_CORE_CLASS_ANY);
+	os_thread_set_core_class(&q->thread, core_class);
+
 	xrt_frame_context_add(xfctx, &q->node);
 
 	*out_xfs = &q->base;
 
 	return true;
 }
+
+void
+u_sink_queue_add_vars(struct xrt_frame_sink *xfs, void *root, const char *prefix)
+{
+	struct u_sink_queue *q = (struct u_sink_queue *)xfs;
+	char name[64];
+
+	snprintf(name, sizeof(name), "%s queue depth", prefix);
+	u_var_add_ro_i32(root, &q->stats.depth, name);
+	snprintf(name, sizeof(name), "%s frames pushed", prefix);
+	u_var_add_ro_u64(root, &q->stats.pushed, name);
+	snprintf(name, sizeof(name), "%s frames dropped", prefix);
+	u_var_add_ro_u64(root, &q->stats.dropped, name);
+	if (q->latest_only) {
+		snprintf(name, sizeof(name), "%s frames skipped", prefix);
+		u_var_add_ro_u64(root, &q->stats.skipped, name);
+	}
+}
+
+bool
+u_sink_queue_create(struct xrt_frame_context *xfctx,
+                    uint64_t max_size,
+                    struct xrt_frame_sink *downstream,
+                    struct xrt_frame_sink **out_xfs)
+{
+	return u_sink_queue_create_with_policy(xfctx, max_size, U_SINK_QUEUE_DROP_NEWEST, downstream, out_xfs);
+}
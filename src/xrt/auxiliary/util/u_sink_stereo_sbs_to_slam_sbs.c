@@ -36,6 +36,13 @@ split_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
 
 	struct u_sink_stereo_sbs_to_slam_sbs *s = (struct u_sink_stereo_sbs_to_slam_sbs *)xfs;
 
+	// Combined from two frames, hand those out directly.
+	if (xf->views[0] != NULL && xf->views[1] != NULL) {
+		xrt_sink_push_frame(s->downstream_left, xf->views[0]);
+		xrt_sink_push_frame(s->downstream_right, xf->views[1]);
+		return;
+	}
+
 	assert(xf->width % 2 == 0);
 
 	int one_frame_width = xf->width / 2;
@@ -14,10 +14,13 @@
 
 #include "math/m_space.h"
 
+#include "os/os_time.h"
+
 #include "util/u_misc.h"
 #include "util/u_hashmap.h"
 #include "util/u_logging.h"
 #include "util/u_space_overseer.h"
+#include "util/u_time.h"
 
 #include <assert.h>
 #include <pthread.h>
@@ -72,6 +75,37 @@ struct u_space
 	};
 };
 
+/*!
+ * Number of entries in the located relation cache, must be a power of two.
+ */
+#define U_SPACE_OVERSEER_CACHE_SIZE (64)
+
+/*!
+ * How long a cached relation is used for, this is well below a frame at any
+ * refresh rate we support, so it only ever deduplicates locates done for the
+ * same frame. Later locates get fresh data from the devices.
+ */
+#define U_SPACE_OVERSEER_CACHE_MAX_AGE_NS (4 * U_TIME_1MS_IN_NS)
+
+/*!
+ * A resolved relation between two spaces at a given time, without any of the
+ * offsets passed into the locate functions applied.
+ */
+struct u_space_overseer_cache_entry
+{
+	//! Generation of the graph when this was inserted, zero means unused.
+	uint64_t generation;
+
+	//! When was this entry inserted, used to age out entries.
+	uint64_t inserted_ns;
+
+	struct u_space *base;
+	struct u_space *target;
+	uint64_t at_timestamp_ns;
+
+	struct xrt_space_relation relation;
+};
+
 /*!
  * Default implementation of the xrt_space_overseer object.
  */
@@ -84,6 +118,22 @@ struct u_space_overseer
 
 	//! Map from xdev to space, each entry holds a reference.
 	struct u_hashmap_int *xdev_map;
+
+	/*!
+	 * Small direct mapped cache of located relations keyed on base space,
+	 * target space and time. Everybody locating through this overseer, the
+	 * compositor and all of the IPC clients, share it.
+	 */
+	struct
+	{
+		//! Protects the cache, never held while calling into devices.
+		pthread_mutex_t mutex;
+
+		//! Bumped on any change to the graph, entries from older generations are misses.
+		uint64_t generation;
+
+		struct u_space_overseer_cache_entry entries[U_SPACE_OVERSEER_CACHE_SIZE];
+	} cache;
 };
 
 
@@ -157,6 +207,91 @@ find_xdev_space_read_locked(struct u_space_overseer *uso, struct xrt_device *xde
 }
 
 
+/*
+ *
+ * Cache functions.
+ *
+ */
+
+static inline uint32_t
+cache_index(struct u_space *base, struct u_space *target, uint64_t at_timestamp_ns)
+{
+	uint64_t h = (uint64_t)(intptr_t)base;
+	h = h * 31 + (uint64_t)(intptr_t)target;
+	h = (h ^ at_timestamp_ns) * 0x9E3779B97F4A7C15ULL;
+
+	return (uint32_t)(h >> 32) & (U_SPACE_OVERSEER_CACHE_SIZE - 1);
+}
+
+/*!
+ * Returns the current generation, pass it to @ref cache_insert so results
+ * computed while the graph changed are not inserted.
+ */
+static uint64_t
+cache_find(struct u_space_overseer *uso,
+           struct u_space *base,
+           struct u_space *target,
+           uint64_t at_timestamp_ns,
+           struct xrt_space_relation *out_relation,
+           bool *out_found)
+{
+	struct u_space_overseer_cache_entry *e = &uso->cache.entries[cache_index(base, target, at_timestamp_ns)];
+	uint64_t now_ns = os_monotonic_get_ns();
+
+	pthread_mutex_lock(&uso->cache.mutex);
+
+	uint64_t generation = uso->cache.generation;
+	bool found = e->generation == generation &&                               //
+	             e->base == base &&                                           //
+	             e->target == target &&                                       //
+	             e->at_timestamp_ns == at_timestamp_ns &&                     //
+	             now_ns - e->inserted_ns < U_SPACE_OVERSEER_CACHE_MAX_AGE_NS; //
+	if (found) {
+		*out_relation = e->relation;
+	}
+
+	pthread_mutex_unlock(&uso->cache.mutex);
+
+	*out_found = found;
+
+	return generation;
+}
+
+static void
+cache_insert(struct u_space_overseer *uso,
+             uint64_t generation,
+             struct u_space *base,
+             struct u_space *target,
+             uint64_t at_timestamp_ns,
+             const struct xrt_space_relation *relation)
+{
+	struct u_space_overseer_cache_entry *e = &uso->cache.entries[cache_index(base, target, at_timestamp_ns)];
+	uint64_t now_ns = os_monotonic_get_ns();
+
+	pthread_mutex_lock(&uso->cache.mutex);
+
+	// The graph changed while we were building the chain.
+	if (generation == uso->cache.generation) {
+		e->generation = generation;
+		e->inserted_ns = now_ns;
+		e->base = base;
+		e->target = target;
+		e->at_timestamp_ns = at_timestamp_ns;
+		e->relation = *relation;
+	}
+
+	pthread_mutex_unlock(&uso->cache.mutex);
+}
+
+static void
+cache_invalidate(struct u_space_overseer *uso)
+{
+	pthread_mutex_lock(&uso->cache.mutex);
+	uso->cache.generation++;
+	pthread_mutex_unlock(&uso->cache.mutex);
+}
+
+
 /*
  *
  * Graph traversing functions.
@@ -242,18 +377,6 @@ build_relation_chain_read_locked(struct u_space_overseer *uso,
 	traverse_then_push_inverse(xrc, base, at_timestamp_ns);
 }
 
-static void
-build_relation_chain(struct u_space_overseer *uso,
-                     struct xrt_relation_chain *xrc,
-                     struct u_space *base,
-                     struct u_space *target,
-                     uint64_t at_timestamp_ns)
-{
-	pthread_rwlock_rdlock(&uso->lock);
-	build_relation_chain_read_locked(uso, xrc, base, target, at_timestamp_ns);
-	pthread_rwlock_unlock(&uso->lock);
-}
-
 static inline void
 special_resolve(struct xrt_relation_chain *xrc, struct xrt_space_relation *out_relation)
 {
@@ -270,6 +393,46 @@ special_resolve(struct xrt_relation_chain *xrc, struct xrt_space_relation *out_r
 	}
 }
 
+/*!
+ * Get the relation of @p target in @p base at the given time, from the cache
+ * if possible, does not take the graph lock if it's a hit. If @p xdev is not
+ * NULL, @p target is ignored and the space of that device is used.
+ */
+static void
+locate_cached(struct u_space_overseer *uso,
+              struct u_space *base,
+              struct u_space *target,
+              struct xrt_device *xdev,
+              uint64_t at_timestamp_ns,
+              struct xrt_space_relation *out_relation)
+{
+	struct xrt_relation_chain xrc = {0};
+	bool found = false;
+	uint64_t generation = 0;
+
+	pthread_rwlock_rdlock(&uso->lock);
+
+	if (xdev != NULL) {
+		target = find_xdev_space_read_locked(uso, xdev);
+	}
+
+	generation = cache_find(uso, base, target, at_timestamp_ns, out_relation, &found);
+	if (!found) {
+		build_relation_chain_read_locked(uso, &xrc, base, target, at_timestamp_ns);
+	}
+
+	pthread_rwlock_unlock(&uso->lock);
+
+	if (found) {
+		return;
+	}
+
+	// Do as much work outside of the lock.
+	special_resolve(&xrc, out_relation);
+
+	cache_insert(uso, generation, base, target, at_timestamp_ns, out_relation);
+}
+
 
 /*
  *
@@ -334,9 +497,13 @@ create_offset_space(struct xrt_space_overseer *xso,
 	assert(out_space != NULL);
 	assert(*out_space == NULL);
 
+	struct u_space_overseer *uso = u_space_overseer(xso);
 	struct u_space *uparent = u_space(parent);
 	struct u_space *us = NULL;
 
+	// Space memory might be reused, make sure we never return stale relations.
+	cache_invalidate(uso);
+
 	if (m_pose_is_identity(offset)) { // Small optimisation.
 		us = create_space(U_SPACE_TYPE_NULL, uparent);
 	} else {
@@ -361,6 +528,9 @@ create_pose_space(struct xrt_space_overseer *xso,
 
 	struct u_space_overseer *uso = u_space_overseer(xso);
 
+	// Space memory might be reused, make sure we never return stale relations.
+	cache_invalidate(uso);
+
 	// Only need the read lock.
 	pthread_rwlock_rdlock(&uso->lock);
 
@@ -379,6 +549,30 @@ create_pose_space(struct xrt_space_overseer *xso,
 	return XRT_SUCCESS;
 }
 
+/*!
+ * Apply the offsets of the located space and base space to a cached relation.
+ */
+static void
+apply_offsets(const struct xrt_space_relation *xsr,
+              const struct xrt_pose *offset,
+              const struct xrt_pose *base_offset,
+              struct xrt_space_relation *out_relation)
+{
+	// Nothing to apply, avoid touching the relation.
+	if (m_pose_is_identity(offset) && m_pose_is_identity(base_offset)) {
+		*out_relation = *xsr;
+		return;
+	}
+
+	struct xrt_relation_chain xrc = {0};
+
+	m_relation_chain_push_pose_if_not_identity(&xrc, offset);
+	m_relation_chain_push_relation(&xrc, xsr);
+	m_relation_chain_push_inverted_pose_if_not_identity(&xrc, base_offset);
+
+	m_relation_chain_resolve(&xrc, out_relation);
+}
+
 static xrt_result_t
 locate_space(struct xrt_space_overseer *xso,
              struct xrt_space *base_space,
@@ -393,14 +587,37 @@ locate_space(struct xrt_space_overseer *xso,
 	struct u_space *ubase_space = u_space(base_space);
 	struct u_space *uspace = u_space(space);
 
-	struct xrt_relation_chain xrc = {0};
+	struct xrt_space_relation xsr;
+	locate_cached(uso, ubase_space, uspace, NULL, at_timestamp_ns, &xsr);
 
-	m_relation_chain_push_pose_if_not_identity(&xrc, offset);
-	build_relation_chain(uso, &xrc, ubase_space, uspace, at_timestamp_ns);
-	m_relation_chain_push_inverted_pose_if_not_identity(&xrc, base_offset);
+	apply_offsets(&xsr, offset, base_offset, out_relation);
 
-	// For base_space =~= space (approx equals).
-	special_resolve(&xrc, out_relation);
+	return XRT_SUCCESS;
+}
+
+static xrt_result_t
+locate_spaces(struct xrt_space_overseer *xso,
+              struct xrt_space *base_space,
+              const struct xrt_pose *base_offset,
+              uint64_t at_timestamp_ns,
+              struct xrt_space **spaces,
+              uint32_t space_count,
+              const struct xrt_pose *offsets,
+              struct xrt_space_relation *out_relations)
+{
+	struct u_space_overseer *uso = u_space_overseer(xso);
+
+	struct u_space *ubase_space = u_space(base_space);
+	const struct xrt_pose identity = XRT_POSE_IDENTITY;
+
+	for (uint32_t i = 0; i < space_count; i++) {
+		const struct xrt_pose *offset = offsets != NULL ? &offsets[i] : &identity;
+
+		struct xrt_space_relation xsr;
+		locate_cached(uso, ubase_space, u_space(spaces[i]), NULL, at_timestamp_ns, &xsr);
+
+		apply_offsets(&xsr, offset, base_offset, &out_relations[i]);
+	}
 
 	return XRT_SUCCESS;
 }
@@ -417,20 +634,31 @@ locate_device(struct xrt_space_overseer *xso,
 
 	struct u_space *ubase_space = u_space(base_space);
 
-	struct xrt_relation_chain xrc = {0};
+	struct xrt_space_relation xsr;
+	locate_cached(uso, ubase_space, NULL, xdev, at_timestamp_ns, &xsr);
 
-	// Only need the read lock.
-	pthread_rwlock_rdlock(&uso->lock);
+	const struct xrt_pose identity = XRT_POSE_IDENTITY;
+	apply_offsets(&xsr, &identity, base_offset, out_relation);
 
-	struct u_space *uspace = find_xdev_space_read_locked(uso, xdev);
-	build_relation_chain_read_locked(uso, &xrc, ubase_space, uspace, at_timestamp_ns);
+	return XRT_SUCCESS;
+}
 
-	// Safe to unlock now.
-	pthread_rwlock_unlock(&uso->lock);
+static xrt_result_t
+add_device(struct xrt_space_overseer *xso, struct xrt_device *xdev)
+{
+	struct u_space_overseer *uso = u_space_overseer(xso);
+	struct xrt_space *xs = NULL;
 
-	// Do as much work outside of the lock.
-	m_relation_chain_push_inverted_pose_if_not_identity(&xrc, base_offset);
-	special_resolve(&xrc, out_relation);
+	// Like the legacy setup, the device is placed at its tracking origin.
+	xrt_result_t xret = create_offset_space(xso, uso->base.semantic.root, &xdev->tracking_origin->offset, &xs);
+	if (xret != XRT_SUCCESS) {
+		return xret;
+	}
+
+	u_space_overseer_link_space_to_device(uso, xs, xdev);
+
+	// The device holds a reference of its own now.
+	xrt_space_reference(&xs, NULL);
 
 	return XRT_SUCCESS;
 }
@@ -450,6 +678,7 @@ destroy(struct xrt_space_overseer *xso)
 	u_hashmap_int_clear_and_call_for_each(uso->xdev_map, hashmap_unreference_space_items, uso);
 	u_hashmap_int_destroy(&uso->xdev_map);
 
+	pthread_mutex_destroy(&uso->cache.mutex);
 	pthread_rwlock_destroy(&uso->lock);
 
 	free(uso);
@@ -469,7 +698,9 @@ u_space_overseer_create(void)
 	uso->base.create_offset_space = create_offset_space;
 	uso->base.create_pose_space = create_pose_space;
 	uso->base.locate_space = locate_space;
+	uso->base.locate_spaces = locate_spaces;
 	uso->base.locate_device = locate_device;
+	uso->base.add_device = add_device;
 	uso->base.destroy = destroy;
 
 	XRT_MAYBE_UNUSED int ret = 0;
@@ -477,6 +708,12 @@ u_space_overseer_create(void)
 	ret = pthread_rwlock_init(&uso->lock, NULL);
 	assert(ret == 0);
 
+	ret = pthread_mutex_init(&uso->cache.mutex, NULL);
+	assert(ret == 0);
+
+	// Zero generation in entries means unused, so start at one.
+	uso->cache.generation = 1;
+
 	ret = u_hashmap_int_create(&uso->xdev_map);
 	assert(ret == 0);
 
@@ -542,6 +779,9 @@ u_space_overseer_create_null_space(struct u_space_overseer *uso, struct xrt_spac
 	assert(out_space != NULL);
 	assert(*out_space == NULL);
 
+	// Space memory might be reused, make sure we never return stale relations.
+	cache_invalidate(uso);
+
 	struct u_space *uparent = u_space(parent);
 	struct u_space *us = create_space(U_SPACE_TYPE_NULL, uparent);
 
@@ -567,6 +807,9 @@ u_space_overseer_link_space_to_device(struct u_space_overseer *uso, struct xrt_s
 
 	u_hashmap_int_insert(uso->xdev_map, (uint64_t)(intptr_t)xdev, new_space);
 
+	// Graph changed, done while holding the write lock so no locate can insert an old relation.
+	cache_invalidate(uso);
+
 	pthread_rwlock_unlock(&uso->lock);
 
 	// Dereferrence old space outside of lock.
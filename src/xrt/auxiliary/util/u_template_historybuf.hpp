@@ -129,6 +129,22 @@ public:
 	const T *
 	get_at_index(size_t index) const noexcept;
 
+	/*!
+	 * @brief Get the elements as at most two contiguous spans, in chronological order: everything in the first
+	 * span is older than everything in the second, which is empty unless the elements wrap around.
+	 *
+	 * Scans over these compile to plain pointer loops, unlike going through the iterators.
+	 */
+	void
+	get_spans(const T *&out_first, size_t &out_first_size, const T *&out_second, size_t &out_second_size) const
+	    noexcept
+	{
+		size_t first_inner_index = 0;
+		helper_.spans(first_inner_index, out_first_size, out_second_size);
+		out_first = internalBuffer.data() + first_inner_index;
+		out_second = internalBuffer.data();
+	}
+
 	using iterator = detail::HistoryBufIterator<T, MaxSize>;
 	using const_iterator = detail::HistoryBufConstIterator<T, MaxSize>;
 
@@ -44,7 +44,9 @@ class RingBufferHelper
 {
 public:
 	//! Construct for a given size
-	explicit constexpr RingBufferHelper(size_t capacity) : capacity_(capacity) {}
+	explicit constexpr RingBufferHelper(size_t capacity)
+	    : capacity_(capacity), pow2_(capacity != 0 && (capacity & (capacity - 1)) == 0)
+	{}
 	RingBufferHelper(RingBufferHelper const &) = default;
 	RingBufferHelper(RingBufferHelper &&) = default;
 	RingBufferHelper &
@@ -78,6 +80,13 @@ public:
 		return length_;
 	}
 
+	//! How many elements can the buffer hold?
+	size_t
+	capacity() const noexcept
+	{
+		return capacity_;
+	}
+
 	/*!
 	 * @brief Update internal state for pushing an element to the back, and return the inner index to store
 	 * the element at.
@@ -113,6 +122,17 @@ public:
 	size_t
 	back_inner_index() const noexcept;
 
+	/*!
+	 * @brief Get the elements as at most two contiguous ranges of inner indices, in chronological order.
+	 *
+	 * The first range starts at @p out_first_inner_idx and holds the oldest @p out_first_count elements, the
+	 * second always starts at inner index 0 and holds the remaining @p out_second_count, it is empty unless the
+	 * elements wrap around the end of the backing array. Lets scans like std::lower_bound run over plain
+	 * pointers instead of going through the index translation for every element.
+	 */
+	void
+	spans(size_t &out_first_inner_idx, size_t &out_first_count, size_t &out_second_count) const noexcept;
+
 	void
 	clear();
 
@@ -120,6 +140,9 @@ private:
 	// Would be const, but that would mess up our ability to copy/move containers using this.
 	size_t capacity_;
 
+	//! Capacity is a power of two, so indices can be wrapped with a mask instead of a division.
+	bool pow2_;
+
 	//! The inner index containing the most recently added element, if any
 	size_t latest_inner_idx_ = 0;
 
@@ -135,6 +158,13 @@ private:
 	 */
 	size_t
 	front_impl_() const noexcept;
+
+	//! Reduce an index modulo capacity_.
+	size_t
+	wrap_(size_t idx) const noexcept
+	{
+		return pow2_ ? (idx & (capacity_ - 1)) : (idx % capacity_);
+	}
 };
 
 
@@ -150,7 +180,7 @@ RingBufferHelper::front_impl_() const noexcept
 {
 	assert(!empty());
 	// length will not exceed capacity_, so this will not underflow
-	return (latest_inner_idx_ + capacity_ - length_ + 1) % capacity_;
+	return wrap_(latest_inner_idx_ + capacity_ - length_ + 1);
 }
 
 inline bool
@@ -165,7 +195,7 @@ RingBufferHelper::age_to_inner_index(size_t age, size_t &out_inner_idx) const no
 	}
 	// latest_inner_idx_ is the same as (latest_inner_idx_ + capacity_) % capacity_ so we add capacity_ to
 	// prevent underflow with unsigned values
-	out_inner_idx = (latest_inner_idx_ + capacity_ - age) % capacity_;
+	out_inner_idx = wrap_(latest_inner_idx_ + capacity_ - age);
 	return true;
 }
 
@@ -189,7 +219,7 @@ RingBufferHelper::index_to_inner_index(size_t index, size_t &out_inner_idx) cons
 		return false;
 	}
 	// add to the front (oldest) index and take modulo capacity_
-	out_inner_idx = (front_impl_() + index) % capacity_;
+	out_inner_idx = wrap_(front_impl_() + index);
 	return true;
 }
 
@@ -197,7 +227,7 @@ inline size_t
 RingBufferHelper::push_back_location() noexcept
 {
 	// We always increment the latest inner index modulo capacity_
-	latest_inner_idx_ = (latest_inner_idx_ + 1) % capacity_;
+	latest_inner_idx_ = wrap_(latest_inner_idx_ + 1);
 	// Length cannot exceed capacity_. If it already was capacity_, that means we're overwriting something at
 	// latest_inner_idx_
 	length_ = std::min(length_ + 1, capacity_);
@@ -218,7 +248,7 @@ RingBufferHelper::pop_back() noexcept
 		return false;
 	}
 	// adding capacity before -1 to avoid overflow
-	latest_inner_idx_ = (latest_inner_idx_ + capacity_ - 1) % capacity_;
+	latest_inner_idx_ = wrap_(latest_inner_idx_ + capacity_ - 1);
 	length_--;
 	return true;
 }
@@ -240,4 +270,20 @@ RingBufferHelper::back_inner_index() const noexcept
 	return latest_inner_idx_;
 }
 
+inline void
+RingBufferHelper::spans(size_t &out_first_inner_idx, size_t &out_first_count, size_t &out_second_count) const noexcept
+{
+	if (empty()) {
+		out_first_inner_idx = 0;
+		out_first_count = 0;
+		out_second_count = 0;
+		return;
+	}
+
+	size_t front = front_impl_();
+	out_first_inner_idx = front;
+	out_first_count = (std::min)(length_, capacity_ - front);
+	out_second_count = length_ - out_first_count;
+}
+
 } // namespace xrt::auxiliary::util::detail
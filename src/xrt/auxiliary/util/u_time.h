@@ -60,6 +60,13 @@ extern "C" {
  */
 #define U_TIME_HALF_MS_IN_NS (U_TIME_1MS_IN_NS / 2)
 
+/*!
+ * The number of nanoseconds in a microsecond.
+ *
+ * @see timepoint_ns
+ */
+#define U_TIME_1US_IN_NS (1000)
+
 /*!
  * Integer timestamp type.
  *
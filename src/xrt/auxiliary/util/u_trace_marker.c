@@ -113,7 +113,9 @@ u_trace_marker_setup(enum u_trace_which which)
 void
 u_trace_marker_init(void)
 {
-	// Noop
+#ifdef XRT_FEATURE_TRACE_RECORDER
+	u_trace_recorder_init();
+#endif
 }
 
 #endif // !U_TRACE_PERCETTO
@@ -14,6 +14,8 @@
 #include "xrt/xrt_config_have.h"
 #include "xrt/xrt_config_build.h"
 
+#include "util/u_trace_recorder.h"
+
 #include <stdio.h>
 
 #if defined(__cplusplus) && (defined(__clang__) || defined(__GNUC__))
@@ -146,6 +148,25 @@ u_trace_marker_init(void);
 
 #ifndef XRT_FEATURE_TRACING
 
+#ifdef XRT_FEATURE_TRACE_RECORDER // Record into the in-memory rings, see u_trace_recorder.h.
+
+#define U_TRACE_FUNC(CATEGORY)                                                                                         \
+	bool __attribute__((cleanup(u_trace_recorder_scope_cleanup))) __trace_func =                                  \
+	    u_trace_recorder_begin(#CATEGORY, __func__);                                                               \
+	(void)__trace_func
+
+#define U_TRACE_IDENT(CATEGORY, IDENT)                                                                                 \
+	bool __attribute__((cleanup(u_trace_recorder_scope_cleanup))) __trace_scope_##IDENT =                         \
+	    u_trace_recorder_begin(#CATEGORY, #IDENT);                                                                 \
+	(void)__trace_scope_##IDENT
+
+#define U_TRACE_BEGIN(CATEGORY, IDENT) bool __trace_##IDENT = u_trace_recorder_begin(#CATEGORY, #IDENT)
+
+#define U_TRACE_END(CATEGORY, IDENT) u_trace_recorder_end(__trace_##IDENT)
+
+#define U_TRACE_SET_THREAD_NAME(STRING) u_trace_recorder_set_thread_name(STRING)
+
+#else // !XRT_FEATURE_TRACE_RECORDER
 
 #define U_TRACE_FUNC(CATEGORY)                                                                                         \
 	do {                                                                                                           \
@@ -165,6 +186,13 @@ u_trace_marker_init(void);
 		(void)__trace_##IDENT; /* To ensure they are balanced */                                               \
 	} while (false)
 
+#define U_TRACE_SET_THREAD_NAME(STRING)                                                                                \
+	do {                                                                                                           \
+		(void)STRING;                                                                                          \
+	} while (false)
+
+#endif // !XRT_FEATURE_TRACE_RECORDER
+
 #define U_TRACE_EVENT_BEGIN_ON_TRACK(CATEGORY, TRACK, TIME, NAME)                                                      \
 	do {                                                                                                           \
 	} while (false)
@@ -183,11 +211,6 @@ u_trace_marker_init(void);
 
 #define U_TRACE_CATEGORY_IS_ENABLED(_) (false)
 
-#define U_TRACE_SET_THREAD_NAME(STRING)                                                                                \
-	do {                                                                                                           \
-		(void)STRING;                                                                                          \
-	} while (false)
-
 /*!
  * Add to target c file to enable tracing, see @ref tracing.
  *
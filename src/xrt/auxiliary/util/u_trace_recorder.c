@@ -0,0 +1,407 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  In-memory flight recorder for trace markers.
+ * @ingroup aux_util
+ */
+
+#include "xrt/xrt_compiler.h"
+#include "xrt/xrt_config_os.h"
+
+#include "os/os_threading.h"
+#include "os/os_time.h"
+
+#include "util/u_debug.h"
+#include "util/u_file.h"
+#include "util/u_logging.h"
+#include "util/u_misc.h"
+#include "util/u_time.h"
+#include "util/u_trace_recorder.h"
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+
+//! Events per thread, a power of two, a busy compositor thread fills it in about half a second.
+#define RING_SIZE (4096)
+
+//! Threads that can have a ring at the same time, rings of exited threads are reused.
+#define MAX_RINGS (128)
+
+//! Minimum time between two dumps, a miss often comes with a few more.
+#define DUMP_INTERVAL_NS (10 * (uint64_t)U_TIME_1S_IN_NS)
+
+DEBUG_GET_ONCE_BOOL_OPTION(trace_recorder, "XRT_TRACE_RECORDER", true)
+DEBUG_GET_ONCE_NUM_OPTION(trace_recorder_dump_ms, "XRT_TRACE_RECORDER_DUMP_MS", 500)
+DEBUG_GET_ONCE_NUM_OPTION(trace_recorder_max_dumps, "XRT_TRACE_RECORDER_MAX_DUMPS", 4)
+
+/*!
+ * A single begin or end event, end events have no name.
+ */
+struct event
+{
+	uint64_t timestamp_ns;
+	const char *category;
+	const char *name;
+};
+
+/*!
+ * Written only by the owning thread, read by the dump thread without locking:
+ * the reader copies events out and throws away any that @ref head shows were
+ * overwritten while it was copying.
+ */
+struct ring
+{
+	//! Total events ever written, wraps around.
+	volatile uint32_t head;
+
+	//! Events before this belong to a previous owner of the ring.
+	volatile uint32_t first;
+
+	//! Set while a live thread owns the ring.
+	xrt_atomic_s32_t owned;
+
+	pid_t tid;
+	char name[32];
+
+	struct event events[RING_SIZE];
+};
+
+bool u_trace_recorder_enabled = false;
+
+static struct ring *g_rings[MAX_RINGS];
+static xrt_atomic_s32_t g_ring_count;
+static xrt_atomic_s32_t g_initialized;
+
+static __thread struct ring *t_ring;
+static __thread bool t_no_ring;
+static pthread_key_t g_ring_key;
+
+static struct os_thread g_dumper;
+static struct os_semaphore g_sem;
+static const char *volatile g_dump_reason;
+
+//! Only touched by the dump thread.
+static struct event g_scratch[RING_SIZE];
+
+
+/*
+ *
+ * Ring helpers.
+ *
+ */
+
+static void
+ring_release(void *ptr)
+{
+	struct ring *r = (struct ring *)ptr;
+
+	xrt_atomic_thread_fence();
+	r->owned = 0;
+}
+
+static void
+ring_claim(struct ring *r)
+{
+	r->tid = (pid_t)syscall(SYS_gettid);
+	r->name[0] = '\0';
+	r->first = r->head;
+
+	pthread_setspecific(g_ring_key, r);
+	t_ring = r;
+}
+
+static struct ring *
+get_ring(void)
+{
+	if (t_ring != NULL || t_no_ring) {
+		return t_ring;
+	}
+
+	// Reuse the ring of a thread that has exited.
+	int32_t count = g_ring_count;
+	for (int32_t i = 0; i < count && i < MAX_RINGS; i++) {
+		struct ring *r = g_rings[i];
+		if (r != NULL && xrt_atomic_s32_cmpxchg(&r->owned, 0, 1) == 0) {
+			ring_claim(r);
+			return r;
+		}
+	}
+
+	int32_t index = xrt_atomic_s32_inc_return(&g_ring_count) - 1;
+	if (index >= MAX_RINGS) {
+		t_no_ring = true;
+		return NULL;
+	}
+
+	struct ring *r = U_TYPED_CALLOC(struct ring);
+	r->owned = 1;
+	ring_claim(r);
+
+	// Publish the ring only once it has an owner.
+	xrt_atomic_thread_fence();
+	g_rings[index] = r;
+
+	return r;
+}
+
+static void
+get_thread_name(struct ring *r, char *out, size_t out_size)
+{
+	if (r->name[0] != '\0') {
+		snprintf(out, out_size, "%s", r->name);
+		return;
+	}
+
+	// Not named through the trace macros, ask the kernel while the thread is still around.
+	char path[64];
+	snprintf(path, sizeof(path), "/proc/self/task/%i/comm", (int)r->tid);
+
+	FILE *file = fopen(path, "r");
+	if (file != NULL) {
+		bool got = fgets(out, (int)out_size, file) != NULL;
+		fclose(file);
+		if (got) {
+			out[strcspn(out, "\n")] = '\0';
+			return;
+		}
+	}
+
+	snprintf(out, out_size, "Thread %i", (int)r->tid);
+}
+
+
+/*
+ *
+ * Dumping.
+ *
+ */
+
+static void
+write_json_string(FILE *file, const char *str)
+{
+	fputc('"', file);
+	for (; *str != '\0'; str++) {
+		char c = *str;
+		if (c == '"' || c == '\\') {
+			fputc('\\', file);
+			fputc(c, file);
+		} else if ((unsigned char)c < 0x20) {
+			fputc(' ', file);
+		} else {
+			fputc(c, file);
+		}
+	}
+	fputc('"', file);
+}
+
+static void
+write_event(FILE *file, bool *first, int pid, pid_t tid, const struct event *ev)
+{
+	// Microseconds, the unit of the trace event format.
+	uint64_t us = ev->timestamp_ns / 1000;
+	uint32_t frac = (uint32_t)(ev->timestamp_ns % 1000);
+
+	fprintf(file, "%s\n{\"ph\":\"%c\",\"pid\":%i,\"tid\":%i,\"ts\":%" PRIu64 ".%03u", *first ? "" : ",",
+	        ev->name != NULL ? 'B' : 'E', pid, (int)tid, us, frac);
+
+	if (ev->name != NULL) {
+		fprintf(file, ",\"cat\":");
+		write_json_string(file, ev->category);
+		fprintf(file, ",\"name\":");
+		write_json_string(file, ev->name);
+	}
+
+	fputc('}', file);
+	*first = false;
+}
+
+static void
+dump_ring(FILE *file, bool *first, int pid, struct ring *r, uint64_t from_ns)
+{
+	uint32_t head = r->head;
+	xrt_atomic_thread_fence();
+
+	uint32_t start = r->first;
+	if (head - start > RING_SIZE) {
+		start = head - RING_SIZE;
+	}
+
+	for (uint32_t i = start; i != head; i++) {
+		g_scratch[i - start] = r->events[i & (RING_SIZE - 1)];
+	}
+
+	// Anything the owner wrote over while we were copying is not valid.
+	xrt_atomic_thread_fence();
+	uint32_t new_head = r->head;
+	uint32_t valid = start;
+	if (new_head - start > RING_SIZE) {
+		valid = new_head - RING_SIZE;
+	}
+
+	char name[64];
+	get_thread_name(r, name, sizeof(name));
+
+	fprintf(file, "%s\n{\"ph\":\"M\",\"pid\":%i,\"tid\":%i,\"name\":\"thread_name\",\"args\":{\"name\":",
+	        *first ? "" : ",", pid, (int)r->tid);
+	write_json_string(file, name);
+	fprintf(file, "}}");
+	*first = false;
+
+	for (uint32_t i = start; i != head; i++) {
+		if ((int32_t)(i - valid) < 0) {
+			continue;
+		}
+
+		const struct event *ev = &g_scratch[i - start];
+		if (ev->timestamp_ns < from_ns) {
+			continue;
+		}
+
+		write_event(file, first, pid, r->tid, ev);
+	}
+}
+
+static void
+dump(const char *reason, uint32_t index)
+{
+	uint64_t now_ns = os_monotonic_get_ns();
+	uint64_t window_ns = (uint64_t)debug_get_num_option_trace_recorder_dump_ms() * U_TIME_1MS_IN_NS;
+	uint64_t from_ns = now_ns > window_ns ? now_ns - window_ns : 0;
+	int pid = (int)getpid();
+
+	char filename[64];
+	snprintf(filename, sizeof(filename), "trace_%i_%u.json", pid, index);
+
+	FILE *file = u_file_open_file_in_cache_dir(filename, "w");
+	if (file == NULL) {
+		U_LOG_E("Could not open '%s' in the cache dir for the trace dump", filename);
+		return;
+	}
+
+	bool first = true;
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+	int32_t count = g_ring_count;
+	for (int32_t i = 0; i < count && i < MAX_RINGS; i++) {
+		struct ring *r = g_rings[i];
+		if (r != NULL) {
+			dump_ring(file, &first, pid, r, from_ns);
+		}
+	}
+
+	fprintf(file, "\n]}\n");
+	fclose(file);
+
+	U_LOG_W("Dumped the last %" PRIu64 "ms of trace markers to '%s' (%s)", window_ns / U_TIME_1MS_IN_NS, filename,
+	        reason);
+}
+
+static void *
+dumper_thread(void *ptr)
+{
+	(void)ptr;
+
+	uint32_t dumps = 0;
+	uint32_t max_dumps = (uint32_t)debug_get_num_option_trace_recorder_max_dumps();
+	uint64_t last_dump_ns = 0;
+
+	while (dumps < max_dumps) {
+		os_semaphore_wait(&g_sem, 0);
+
+		uint64_t now_ns = os_monotonic_get_ns();
+		if (last_dump_ns != 0 && now_ns - last_dump_ns < DUMP_INTERVAL_NS) {
+			continue;
+		}
+
+		last_dump_ns = now_ns;
+		dump(g_dump_reason, dumps++);
+	}
+
+	return NULL;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+void
+u_trace_recorder_init(void)
+{
+	if (xrt_atomic_s32_cmpxchg(&g_initialized, 0, 1) != 0) {
+		return;
+	}
+
+	if (!debug_get_bool_option_trace_recorder() || debug_get_num_option_trace_recorder_max_dumps() <= 0) {
+		return;
+	}
+
+	pthread_key_create(&g_ring_key, ring_release);
+
+	os_semaphore_init(&g_sem, 0);
+	os_thread_init(&g_dumper);
+
+	int ret = os_thread_start(&g_dumper, dumper_thread, NULL);
+	if (ret != 0) {
+		U_LOG_E("Failed to start the trace recorder dump thread!");
+		os_thread_destroy(&g_dumper);
+		os_semaphore_destroy(&g_sem);
+		return;
+	}
+
+	os_thread_name(&g_dumper, "Trace Recorder");
+
+	xrt_atomic_thread_fence();
+	u_trace_recorder_enabled = true;
+}
+
+void
+u_trace_recorder_record(const char *category, const char *name)
+{
+	struct ring *r = get_ring();
+	if (r == NULL) {
+		return;
+	}
+
+	uint32_t head = r->head;
+	struct event *ev = &r->events[head & (RING_SIZE - 1)];
+	ev->timestamp_ns = os_monotonic_get_ns();
+	ev->category = category;
+	ev->name = name;
+
+	// The event must be complete before the dump thread can see it.
+	xrt_atomic_thread_fence();
+	r->head = head + 1;
+}
+
+void
+u_trace_recorder_set_thread_name(const char *name)
+{
+	if (!u_trace_recorder_enabled) {
+		return;
+	}
+
+	struct ring *r = get_ring();
+	if (r != NULL) {
+		snprintf(r->name, sizeof(r->name), "%s", name);
+	}
+}
+
+void
+u_trace_recorder_request_dump(const char *reason)
+{
+	if (!u_trace_recorder_enabled) {
+		return;
+	}
+
+	g_dump_reason = reason;
+	os_semaphore_release(&g_sem);
+}
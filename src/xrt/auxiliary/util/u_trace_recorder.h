@@ -0,0 +1,114 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  In-memory flight recorder for trace markers, see @ref tracing.
+ * @ingroup aux_util
+ *
+ * When full tracing is not built in, the trace marker macros record their
+ * begin and end events into a small per-thread ring instead of being compiled
+ * out. Nothing is written anywhere until a dump is requested, typically by the
+ * compositor pacer when it detects a missed frame, at which point the last
+ * `XRT_TRACE_RECORDER_DUMP_MS` milliseconds of every thread are written to
+ * the cache dir as a Chrome JSON trace that the Perfetto UI can open.
+ *
+ * Recording is controlled with `XRT_TRACE_RECORDER`, at most
+ * `XRT_TRACE_RECORDER_MAX_DUMPS` dumps are written per process.
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+#include "xrt/xrt_config_build.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#ifdef XRT_FEATURE_TRACE_RECORDER
+
+/*!
+ * Set by @ref u_trace_recorder_init, checked inline by every marker so that a
+ * disabled recorder only costs a load and a branch.
+ *
+ * @ingroup aux_util
+ */
+extern bool u_trace_recorder_enabled;
+
+/*!
+ * Reads the options and starts the dump thread if recording is enabled, called
+ * from @ref u_trace_marker_init.
+ *
+ * @ingroup aux_util
+ */
+void
+u_trace_recorder_init(void);
+
+/*!
+ * Records a begin event, if @p name is NULL an end event, for the calling
+ * thread. Use the trace marker macros instead of calling this directly.
+ *
+ * @ingroup aux_util
+ */
+void
+u_trace_recorder_record(const char *category, const char *name);
+
+/*!
+ * Names the calling thread in dumps, see @ref U_TRACE_SET_THREAD_NAME.
+ *
+ * @ingroup aux_util
+ */
+void
+u_trace_recorder_set_thread_name(const char *name);
+
+/*!
+ * Asks the dump thread to write out the recent events, @p reason is logged.
+ * Only wakes a thread, so it's safe to call from the compositor thread.
+ *
+ * @ingroup aux_util
+ */
+void
+u_trace_recorder_request_dump(const char *reason);
+
+static inline bool
+u_trace_recorder_begin(const char *category, const char *name)
+{
+	if (!u_trace_recorder_enabled) {
+		return false;
+	}
+
+	u_trace_recorder_record(category, name);
+
+	return true;
+}
+
+static inline void
+u_trace_recorder_end(bool began)
+{
+	if (began) {
+		u_trace_recorder_record(NULL, NULL);
+	}
+}
+
+static inline void
+u_trace_recorder_scope_cleanup(bool *began_ptr)
+{
+	u_trace_recorder_end(*began_ptr);
+}
+
+#else // !XRT_FEATURE_TRACE_RECORDER
+
+static inline void
+u_trace_recorder_request_dump(const char *reason)
+{
+	(void)reason;
+}
+
+#endif // !XRT_FEATURE_TRACE_RECORDER
+
+
+#ifdef __cplusplus
+}
+#endif
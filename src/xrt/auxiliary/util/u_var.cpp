@@ -12,8 +12,14 @@
 
 #include <string>
 #include <sstream>
+#include <algorithm>
 #include <vector>
 #include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <cstring>
 
 
 namespace xrt::auxiliary::util {
@@ -26,7 +32,8 @@ namespace xrt::auxiliary::util {
  */
 
 /*!
- * Simple container for the variable information.
+ * Simple container for the variable information, shared between snapshots so
+ * that the GUI state kept on it survives new variables being added.
  */
 class Var
 {
@@ -35,25 +42,48 @@ public:
 };
 
 /*!
- * Object that has a series of tracked variables.
+ * Name information of a root object, the info points into the strings.
  */
-class Obj
+class Root
 {
 public:
 	std::string name = {};
 	std::string raw_name = {};
 	struct u_var_root_info info = {};
-	std::vector<Var> vars = {};
 };
 
+/*!
+ * Object that has a series of tracked variables, never changed once it is in a
+ * published snapshot, adding a variable makes a new one.
+ */
+class Obj
+{
+public:
+	ptrdiff_t key = 0;
+	std::shared_ptr<Root> root = {};
+	std::vector<std::shared_ptr<Var>> vars = {};
+};
+
+/*!
+ * Immutable list of all objects, in the order they were added.
+ */
+using Snapshot = std::vector<std::shared_ptr<const Obj>>;
+
 /*!
  * Object that has a series of tracked variables.
+ *
+ * Changes are made by copying the current snapshot under @ref mutex and
+ * atomically publishing the new one. The visitor only loads the latest
+ * snapshot, so it never takes a lock that the drivers adding and removing
+ * variables take.
  */
 class Tracker
 {
 public:
+	//! Only taken by writers.
+	std::mutex mutex = {};
 	std::unordered_map<std::string, uint32_t> counters = {};
-	std::unordered_map<ptrdiff_t, Obj> map = {};
+	std::shared_ptr<const Snapshot> snapshot = std::make_shared<const Snapshot>();
 	bool on = false;
 	bool tested = false;
 
@@ -67,6 +97,18 @@ public:
 
 		return count;
 	}
+
+	std::shared_ptr<const Snapshot>
+	load()
+	{
+		return std::atomic_load(&snapshot);
+	}
+
+	void
+	publish(std::shared_ptr<const Snapshot> new_snapshot)
+	{
+		std::atomic_store(&snapshot, std::move(new_snapshot));
+	}
 };
 
 /*!
@@ -74,6 +116,12 @@ public:
  */
 static class Tracker gTracker;
 
+/*!
+ * Set while this thread is in @ref u_var_visit, a button callback may remove a
+ * root and must not wait on the visit it is being called from.
+ */
+static thread_local bool tVisiting = false;
+
 
 /*
  *
@@ -96,17 +144,27 @@ get_on()
 static void
 add_var(void *root, void *ptr, u_var_kind kind, const char *c_name)
 {
-	auto s = gTracker.map.find((ptrdiff_t)root);
-	if (s == gTracker.map.end()) {
+	std::unique_lock<std::mutex> lock(gTracker.mutex);
+
+	auto old = gTracker.load();
+	auto s = std::find_if(old->begin(), old->end(),
+	                      [root](const std::shared_ptr<const Obj> &o) { return o->key == (ptrdiff_t)root; });
+	if (s == old->end()) {
 		return;
 	}
 
-	Var var;
-	snprintf(var.info.name, U_VAR_NAME_STRING_SIZE, "%s", c_name);
-	var.info.kind = kind;
-	var.info.ptr = ptr;
+	auto var = std::make_shared<Var>();
+	snprintf(var->info.name, U_VAR_NAME_STRING_SIZE, "%s", c_name);
+	var->info.kind = kind;
+	var->info.ptr = ptr;
+
+	auto obj = std::make_shared<Obj>(**s);
+	obj->vars.push_back(std::move(var));
+
+	auto snapshot = std::make_shared<Snapshot>(*old);
+	(*snapshot)[s - old->begin()] = std::move(obj);
 
-	s->second.vars.push_back(var);
+	gTracker.publish(std::move(snapshot));
 }
 
 
@@ -130,6 +188,8 @@ u_var_add_root(void *root, const char *c_name, bool suffix_with_number)
 		return;
 	}
 
+	std::unique_lock<std::mutex> lock(gTracker.mutex);
+
 	auto name = std::string(c_name);
 	auto raw_name = name;
 	uint32_t count = 0; // Zero means no number.
@@ -142,12 +202,30 @@ u_var_add_root(void *root, const char *c_name, bool suffix_with_number)
 		name = ss.str();
 	}
 
-	auto &obj = gTracker.map[(ptrdiff_t)root] = Obj();
-	obj.name = name;
-	obj.raw_name = raw_name;
-	obj.info.name = obj.name.c_str();
-	obj.info.raw_name = obj.raw_name.c_str();
-	obj.info.number = count;
+	auto r = std::make_shared<Root>();
+	r->name = name;
+	r->raw_name = raw_name;
+	r->info.name = r->name.c_str();
+	r->info.raw_name = r->raw_name.c_str();
+	r->info.number = count;
+
+	auto obj = std::make_shared<Obj>();
+	obj->key = (ptrdiff_t)root;
+	obj->root = std::move(r);
+
+	auto old = gTracker.load();
+	auto snapshot = std::make_shared<Snapshot>();
+	snapshot->reserve(old->size() + 1);
+
+	// Adding the same root again replaces it.
+	for (auto &o : *old) {
+		if (o->key != obj->key) {
+			snapshot->push_back(o);
+		}
+	}
+	snapshot->push_back(std::move(obj));
+
+	gTracker.publish(std::move(snapshot));
 }
 
 extern "C" void
@@ -157,12 +235,41 @@ u_var_remove_root(void *root)
 		return;
 	}
 
-	auto s = gTracker.map.find((ptrdiff_t)root);
-	if (s == gTracker.map.end()) {
+	std::unique_lock<std::mutex> lock(gTracker.mutex);
+
+	auto old = gTracker.load();
+	auto snapshot = std::make_shared<Snapshot>();
+	snapshot->reserve(old->size());
+
+	std::shared_ptr<Root> removed = {};
+	for (auto &o : *old) {
+		if (o->key != (ptrdiff_t)root) {
+			snapshot->push_back(o);
+		} else {
+			removed = o->root;
+		}
+	}
+
+	if (!removed) {
+		return;
+	}
+
+	gTracker.publish(std::move(snapshot));
+	old.reset();
+	lock.unlock();
+
+	if (tVisiting) {
 		return;
 	}
 
-	gTracker.map.erase(s);
+	/*
+	 * The caller is about to free the object, wait for any visit that
+	 * might still be looking at it through an older snapshot to finish,
+	 * every version of the object in those shares the same root.
+	 */
+	while (removed.use_count() > 1) {
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
 }
 
 extern "C" void
@@ -172,22 +279,59 @@ u_var_visit(u_var_root_cb enter_cb, u_var_root_cb exit_cb, u_var_elm_cb elem_cb,
 		return;
 	}
 
-	std::vector<Obj *> tmp;
-	tmp.reserve(gTracker.map.size());
+	auto snapshot = gTracker.load();
+	tVisiting = true;
 
-	for (auto &n : gTracker.map) {
-		tmp.push_back(&n.second);
-	}
-
-	for (Obj *obj : tmp) {
-		enter_cb(&obj->info, priv);
+	for (auto &obj : *snapshot) {
+		enter_cb(&obj->root->info, priv);
 
 		for (auto &var : obj->vars) {
-			elem_cb(&var.info, priv);
+			elem_cb(&var->info, priv);
 		}
 
-		exit_cb(&obj->info, priv);
+		exit_cb(&obj->root->info, priv);
 	}
+
+	tVisiting = false;
+}
+
+extern "C" float *
+u_var_f32_block_back(struct u_var_f32_block *block)
+{
+	return block->buffers[(block->seq + 1) & 1];
+}
+
+extern "C" void
+u_var_f32_block_publish(struct u_var_f32_block *block)
+{
+	// The values must be written before the buffer is made the front one.
+	xrt_atomic_thread_fence();
+	xrt_atomic_s32_inc_return(&block->seq);
+}
+
+extern "C" int
+u_var_f32_block_read(struct u_var_f32_block *block, float *out_values, int out_count)
+{
+	int count = block->count < out_count ? block->count : out_count;
+
+	/*
+	 * The owner only starts writing into the front buffer after publishing
+	 * the other one, so the copy is good if no publish happened during it.
+	 * Give up retrying eventually and use the possibly mixed copy.
+	 */
+	for (int tries = 0; tries < 4; tries++) {
+		int32_t seq = block->seq;
+		xrt_atomic_thread_fence();
+
+		memcpy(out_values, block->buffers[seq & 1], sizeof(float) * count);
+
+		xrt_atomic_thread_fence();
+		if (block->seq == seq) {
+			break;
+		}
+	}
+
+	return count;
 }
 
 #define ADD_FUNC(SUFFIX, TYPE, ENUM)                                                                                   \
@@ -9,6 +9,7 @@
 
 #pragma once
 
+#include "xrt/xrt_compiler.h"
 #include "xrt/xrt_defines.h"
 
 #include "util/u_logging.h"
@@ -140,6 +141,32 @@ struct u_var_draggable_u16
 	uint16_t max;
 };
 
+/*!
+ * A versioned, double-buffered block of values that are rewritten as a whole,
+ * like the bins of a histogram. The owner fills in the back buffer and
+ * publishes it, the debug GUI copies out the front buffer and retries if a
+ * publish raced it, neither side ever waits on the other.
+ *
+ * ```c
+ * float *values = u_var_f32_block_back(&block);
+ * // Fill in block.count values.
+ * u_var_f32_block_publish(&block);
+ * ```
+ *
+ * @ingroup aux_util
+ */
+struct u_var_f32_block
+{
+	//! Two buffers of @ref count values each, owned by the user.
+	float *buffers[2];
+
+	//! Number of values in each buffer.
+	int count;
+
+	//! Bumped on every publish, the low bit selects the front buffer.
+	xrt_atomic_s32_t seq;
+};
+
 /*!
  * Histogram based on single precision bars.
  *
@@ -151,6 +178,9 @@ struct u_var_histogram_f32
 	int count;     //!< Number of bins
 	float width;   //!< Widget width or 0 for auto
 	float height;  //!< Widget height or 0 for auto
+
+	//! If not NULL the bin heights are read from here instead of @ref values.
+	struct u_var_f32_block *block;
 };
 
 /*!
@@ -315,7 +345,12 @@ typedef void (*u_var_elm_cb)(struct u_var_info *info, void *);
  *
  * This is intended only for debugging and is turned off by default, as this all
  * very very unsafe. It is only pointers straight into objects, completely
- * ignores ownership or any safe practices.
+ * ignores ownership or any safe practices. Values that are rewritten as a whole
+ * can be published through a @ref u_var_f32_block to keep the GUI from seeing
+ * half written ones.
+ *
+ * Roots and variables can be added and removed from any thread, the GUI walks
+ * an immutable snapshot of them and never takes the lock that those calls take.
  *
  * The parameter @p suffix_with_number makes the variable tracking code suffix
  * the name of the object with with a number. This allows multiple objects of
@@ -341,7 +376,8 @@ void
 u_var_add_root(void *root, const char *c_name, bool suffix_with_number);
 
 /*!
- * Remove the root node.
+ * Remove the root node, waits for any @ref u_var_visit still looking at it to
+ * return so the object can be freed right after.
  *
  * @ingroup aux_util
  */
@@ -356,6 +392,32 @@ u_var_remove_root(void *root);
 void
 u_var_visit(u_var_root_cb enter_cb, u_var_root_cb exit_cb, u_var_elm_cb elem_cb, void *priv);
 
+/*!
+ * The buffer to fill in before calling @ref u_var_f32_block_publish, only
+ * called by the owner of the block.
+ *
+ * @public @memberof u_var_f32_block
+ */
+float *
+u_var_f32_block_back(struct u_var_f32_block *block);
+
+/*!
+ * Makes the back buffer the front one.
+ *
+ * @public @memberof u_var_f32_block
+ */
+void
+u_var_f32_block_publish(struct u_var_f32_block *block);
+
+/*!
+ * Copies out the latest published values, used by the debug GUI.
+ *
+ * @return The number of values copied, at most @p out_count.
+ * @public @memberof u_var_f32_block
+ */
+int
+u_var_f32_block_read(struct u_var_f32_block *block, float *out_values, int out_count);
+
 /*!
  * This forces the variable tracking code to on, it is disabled by default.
  *
@@ -2,39 +2,169 @@
 // SPDX-License-Identifier: BSL-1.0
 /*!
  * @file
- * @brief  Expose std::vector to C
+ * @brief  Expose a vector to C
  * @author Mateo de Mayo <mateo.demayo@collabora.com>
  * @ingroup aux_util
  */
 
 #include "u_vector.h"
-#include <vector>
 
-using std::vector;
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+
+namespace {
+
+/*!
+ * Vector of trivially copyable elements, the first @p N live inside the
+ * object. The capacity never shrinks.
+ */
+template <typename T, size_t N> class SmallVector
+{
+public:
+	static_assert(std::is_trivially_copyable<T>::value, "Elements are moved with plain copies");
+
+	void
+	pushBack(T e)
+	{
+		reserve(mCount + 1);
+		mData[mCount++] = e;
+	}
+
+	void
+	pushBackN(const T *elems, size_t count)
+	{
+		if (count == 0) {
+			return;
+		}
+
+		reserve(mCount + count);
+		memcpy(mData + mCount, elems, count * sizeof(T));
+		mCount += count;
+	}
+
+	bool
+	popBack(T *e)
+	{
+		if (mCount == 0) {
+			return false;
+		}
+
+		*e = mData[--mCount];
+		return true;
+	}
+
+	T
+	at(size_t i) const
+	{
+		if (i >= mCount) {
+			throw std::out_of_range("u_vector index out of range");
+		}
+		return mData[i];
+	}
+
+	T *
+	data() noexcept
+	{
+		return mData;
+	}
+
+	size_t
+	size() const noexcept
+	{
+		return mCount;
+	}
+
+	void
+	clear() noexcept
+	{
+		mCount = 0;
+	}
+
+	void
+	reserve(size_t count)
+	{
+		if (count <= mCapacity) {
+			return;
+		}
+
+		size_t capacity = mCapacity;
+		while (capacity < count) {
+			capacity *= 2;
+		}
+
+		auto heap = std::make_unique<T[]>(capacity);
+		memcpy(heap.get(), mData, mCount * sizeof(T));
+
+		mHeap = std::move(heap);
+		mData = mHeap.get();
+		mCapacity = capacity;
+	}
+
+private:
+	T mInline[N] = {};
+	std::unique_ptr<T[]> mHeap = {};
+	T *mData = mInline;
+	size_t mCapacity = N;
+	size_t mCount = 0;
+};
+
+} // namespace
 
 #define U_VECTOR_IMPLEMENTATION(TYPE)                                                                                  \
+	using u_vector_##TYPE##_impl = SmallVector<TYPE, U_VECTOR_INLINE_COUNT>;                                       \
+                                                                                                                       \
 	u_vector_##TYPE u_vector_##TYPE##_create()                                                                     \
 	{                                                                                                              \
-		u_vector_##TYPE uv{new vector<TYPE>};                                                                  \
+		u_vector_##TYPE uv{new u_vector_##TYPE##_impl};                                                        \
 		return uv;                                                                                             \
 	}                                                                                                              \
                                                                                                                        \
 	void u_vector_##TYPE##_push_back(u_vector_##TYPE uv, TYPE e)                                                   \
 	{                                                                                                              \
-		vector<TYPE> *v = static_cast<vector<TYPE> *>(uv.ptr);                                                 \
-		v->push_back(e);                                                                                       \
+		static_cast<u_vector_##TYPE##_impl *>(uv.ptr)->pushBack(e);                                            \
+	}                                                                                                              \
+                                                                                                                       \
+	void u_vector_##TYPE##_push_back_n(u_vector_##TYPE uv, const TYPE *elems, size_t count)                        \
+	{                                                                                                              \
+		static_cast<u_vector_##TYPE##_impl *>(uv.ptr)->pushBackN(elems, count);                                \
+	}                                                                                                              \
+                                                                                                                       \
+	bool u_vector_##TYPE##_pop_back(u_vector_##TYPE uv, TYPE *e)                                                   \
+	{                                                                                                              \
+		return static_cast<u_vector_##TYPE##_impl *>(uv.ptr)->popBack(e);                                      \
 	}                                                                                                              \
                                                                                                                        \
 	TYPE u_vector_##TYPE##_at(u_vector_##TYPE uv, size_t i)                                                        \
 	{                                                                                                              \
-		vector<TYPE> *v = static_cast<vector<TYPE> *>(uv.ptr);                                                 \
-		return v->at(i);                                                                                       \
+		return static_cast<u_vector_##TYPE##_impl *>(uv.ptr)->at(i);                                           \
+	}                                                                                                              \
+                                                                                                                       \
+	TYPE *u_vector_##TYPE##_data(u_vector_##TYPE uv)                                                               \
+	{                                                                                                              \
+		return static_cast<u_vector_##TYPE##_impl *>(uv.ptr)->data();                                          \
+	}                                                                                                              \
+                                                                                                                       \
+	size_t u_vector_##TYPE##_size(u_vector_##TYPE uv)                                                              \
+	{                                                                                                              \
+		return static_cast<u_vector_##TYPE##_impl *>(uv.ptr)->size();                                          \
+	}                                                                                                              \
+                                                                                                                       \
+	void u_vector_##TYPE##_reserve(u_vector_##TYPE uv, size_t count)                                               \
+	{                                                                                                              \
+		static_cast<u_vector_##TYPE##_impl *>(uv.ptr)->reserve(count);                                         \
+	}                                                                                                              \
+                                                                                                                       \
+	void u_vector_##TYPE##_clear(u_vector_##TYPE uv)                                                               \
+	{                                                                                                              \
+		static_cast<u_vector_##TYPE##_impl *>(uv.ptr)->clear();                                                \
 	}                                                                                                              \
                                                                                                                        \
 	void u_vector_##TYPE##_destroy(u_vector_##TYPE *uv)                                                            \
 	{                                                                                                              \
-		vector<TYPE> *v = static_cast<vector<TYPE> *>(uv->ptr);                                                \
-		delete v;                                                                                              \
+		delete static_cast<u_vector_##TYPE##_impl *>(uv->ptr);                                                 \
 		uv->ptr = nullptr;                                                                                     \
 	}
 
@@ -2,19 +2,27 @@
 // SPDX-License-Identifier: BSL-1.0
 /*!
  * @file
- * @brief  Expose std::vector to C
+ * @brief  Expose a vector to C
  * @author Mateo de Mayo <mateo.demayo@collabora.com>
  * @ingroup aux_util
+ *
+ * The first @ref U_VECTOR_INLINE_COUNT elements are kept inside the object
+ * itself and clearing keeps the storage, so a scratch list that is cleared and
+ * refilled every frame stops allocating once it has reached its working size.
  */
 
 #pragma once
 
+#include <stdbool.h>
 #include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+//! Number of elements a vector holds before it allocates any storage.
+#define U_VECTOR_INLINE_COUNT 16
+
 #define U_VECTOR_DECLARATION(TYPE)                                                                                     \
 	struct u_vector_##TYPE                                                                                         \
 	{                                                                                                              \
@@ -22,7 +30,13 @@ extern "C" {
 	};                                                                                                             \
 	struct u_vector_##TYPE u_vector_##TYPE##_create();                                                             \
 	void u_vector_##TYPE##_push_back(struct u_vector_##TYPE uv, TYPE e);                                           \
+	void u_vector_##TYPE##_push_back_n(struct u_vector_##TYPE uv, const TYPE *elems, size_t count);                \
+	bool u_vector_##TYPE##_pop_back(struct u_vector_##TYPE uv, TYPE *e);                                           \
 	TYPE u_vector_##TYPE##_at(struct u_vector_##TYPE uv, size_t i);                                                \
+	TYPE *u_vector_##TYPE##_data(struct u_vector_##TYPE uv);                                                       \
+	size_t u_vector_##TYPE##_size(struct u_vector_##TYPE uv);                                                      \
+	void u_vector_##TYPE##_reserve(struct u_vector_##TYPE uv, size_t count);                                       \
+	void u_vector_##TYPE##_clear(struct u_vector_##TYPE uv);                                                       \
 	void u_vector_##TYPE##_destroy(struct u_vector_##TYPE *uv);
 
 U_VECTOR_DECLARATION(int)
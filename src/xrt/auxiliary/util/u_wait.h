@@ -32,13 +32,20 @@
 
 
 /*!
- * Waits until the given time using the @ref os_precise_sleeper.
+ * Waits until the given time using the @ref os_precise_sleeper, a hybrid
+ * sleeper (see @ref os_precise_sleeper_init_hybrid) waits until exactly the
+ * given time, otherwise it can return up to a millisecond early.
  *
  * @ingroup aux_util
  */
 static inline void
 u_wait_until(struct os_precise_sleeper *sleeper, uint64_t until_ns)
 {
+	if (sleeper->spin_margin_ns > 0) {
+		os_precise_sleeper_wait_until(sleeper, until_ns);
+		return;
+	}
+
 	uint64_t now_ns = os_monotonic_get_ns();
 
 	// Lets hope its not to late.
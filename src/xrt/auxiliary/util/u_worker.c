@@ -10,14 +10,23 @@
 
 #include "os/os_threading.h"
 
+#include "util/u_debug.h"
 #include "util/u_logging.h"
 #include "util/u_worker.h"
 #include "util/u_trace_marker.h"
 
 
-#define MAX_TASK_COUNT (64)
 #define MAX_THREAD_COUNT (16)
 
+DEBUG_GET_ONCE_OPTION(worker_core_class, "U_WORKER_CORE_CLASS", NULL)
+
+//! Size of the shared submission queue, must be a power of two.
+#define INJECT_QUEUE_SIZE (256)
+#define INJECT_QUEUE_MASK (INJECT_QUEUE_SIZE - 1)
+
+//! Size of each worker thread's own deque.
+#define LOCAL_QUEUE_SIZE (64)
+
 struct group;
 struct pool;
 
@@ -33,6 +42,34 @@ struct task
 	void *data;
 };
 
+/*!
+ * Cell in the bounded multi-producer multi-consumer submission queue, the
+ * sequence number tells producers and consumers who owns the cell.
+ */
+struct inject_cell
+{
+	xrt_atomic_s32_t sequence;
+
+	struct task task;
+};
+
+/*!
+ * Per thread deque, the owning thread pushes and pops at the back while other
+ * threads steal from the front. The lock is only ever contended when stealing.
+ */
+struct local_queue
+{
+	struct os_mutex mutex;
+
+	struct task tasks[LOCAL_QUEUE_SIZE];
+
+	//! Index of the front (oldest) task.
+	uint32_t first;
+
+	//! Number of tasks, may be read without the lock as a hint.
+	volatile uint32_t count;
+};
+
 struct thread
 {
 	//! Pool this thread belongs to.
@@ -41,6 +78,9 @@ struct thread
 	// Native thread.
 	struct os_thread thread;
 
+	//! Tasks pushed from this thread.
+	struct local_queue local;
+
 	//! Thread name.
 	char name[64];
 };
@@ -49,29 +89,38 @@ struct pool
 {
 	struct u_worker_thread_pool base;
 
-	//! Big contenious mutex.
+	/*!
+	 * Only used for sleeping and waking threads, never taken when
+	 * submitting or picking up tasks unless some thread is sleeping.
+	 */
 	struct os_mutex mutex;
 
-	//! Array of tasks.
-	struct task tasks[MAX_TASK_COUNT];
+	struct
+	{
+		struct inject_cell cells[INJECT_QUEUE_SIZE];
+
+		xrt_atomic_s32_t enqueue_pos;
+
+		xrt_atomic_s32_t dequeue_pos;
+	} inject; //!< Submission queue for threads outside of the pool.
 
-	//! Number of tasks in array.
-	size_t tasks_in_array_count;
+	//! Number of tasks in the submission queue and all local queues.
+	xrt_atomic_s32_t queued_count;
 
 	struct
 	{
-		size_t count;
+		xrt_atomic_s32_t count;
 		struct os_cond cond;
 	} available; //!< For worker threads.
 
 	//! Given at creation.
-	uint32_t initial_worker_limit;
+	int32_t initial_worker_limit;
 
 	//! Currently the number of works that can work, waiting increases this.
-	uint32_t worker_limit;
+	xrt_atomic_s32_t worker_limit;
 
 	//! Number of threads working on tasks.
-	size_t working_count;
+	xrt_atomic_s32_t working_count;
 
 	//! Number of created threads.
 	size_t thread_count;
@@ -80,7 +129,10 @@ struct pool
 	struct thread threads[MAX_THREAD_COUNT];
 
 	//! Is the pool up and running?
-	bool running;
+	volatile bool running;
+
+	//! Class of cores the worker threads are pinned to.
+	enum os_thread_core_class core_class;
 
 	//! Prefix to use for thread names.
 	char prefix[32];
@@ -94,11 +146,11 @@ struct group
 	//! Pointer to poll of threads.
 	struct u_worker_thread_pool *uwtp;
 
-	//! Number of tasks that is pending or being worked on in this group.
-	size_t current_submitted_tasks_count;
-
-	//! Number of threads that have been released or newly entered wait.
-	size_t released_count;
+	/*!
+	 * Number of tasks that is pending or being worked on in this group,
+	 * only the transition to zero is done under the pool mutex.
+	 */
+	xrt_atomic_s32_t current_submitted_tasks_count;
 
 	struct
 	{
@@ -108,6 +160,29 @@ struct group
 };
 
 
+/*!
+ * State for a single u_worker_group_parallel_for call, lives on the stack
+ * of the calling thread.
+ */
+struct parallel_for
+{
+	u_worker_group_range_func_t func;
+	void *data;
+
+	//! Number of indices in the range.
+	uint32_t count;
+
+	//! Number of indices per chunk.
+	uint32_t grain;
+
+	//! Number of chunks in total.
+	uint32_t chunk_count;
+
+	//! Next chunk to be taken by any thread.
+	xrt_atomic_s32_t next_chunk;
+};
+
+
 /*
  *
  * Helper functions.
@@ -126,177 +201,302 @@ pool(struct u_worker_thread_pool *uwtp)
 	return (struct pool *)uwtp;
 }
 
+static inline int32_t
+seq_add(int32_t value, uint32_t add)
+{
+	// Sequence numbers wrap around, avoid signed overflow.
+	return (int32_t)((uint32_t)value + add);
+}
+
+static inline int32_t
+seq_diff(int32_t a, int32_t b)
+{
+	return (int32_t)((uint32_t)a - (uint32_t)b);
+}
+
+static inline int32_t
+atomic_read(xrt_atomic_s32_t *p)
+{
+	return xrt_atomic_s32_cmpxchg(p, 0, 0);
+}
+
 
 /*
  *
- * Internal pool functions.
+ * Submission queue functions.
  *
  */
 
 static void
-locked_pool_pop_task(struct pool *p, struct task *out_task)
+inject_init(struct pool *p)
 {
-	assert(p->tasks_in_array_count > 0);
+	for (int32_t i = 0; i < INJECT_QUEUE_SIZE; i++) {
+		p->inject.cells[i].sequence = i;
+	}
+}
 
-	for (size_t i = 0; i < MAX_TASK_COUNT; i++) {
-		if (p->tasks[i].func == NULL) {
-			continue;
+static bool
+inject_push(struct pool *p, const struct task *task)
+{
+	struct inject_cell *cell = NULL;
+	int32_t pos = p->inject.enqueue_pos;
+
+	while (true) {
+		cell = &p->inject.cells[(uint32_t)pos & INJECT_QUEUE_MASK];
+		int32_t diff = seq_diff(cell->sequence, pos);
+
+		if (diff == 0) {
+			int32_t old = xrt_atomic_s32_cmpxchg(&p->inject.enqueue_pos, pos, seq_add(pos, 1));
+			if (old == pos) {
+				break;
+			}
+			pos = old;
+		} else if (diff < 0) {
+			// Full.
+			return false;
+		} else {
+			pos = p->inject.enqueue_pos;
 		}
-
-		*out_task = p->tasks[i];
-		p->tasks[i] = (struct task){NULL, NULL, NULL};
-		p->tasks_in_array_count--;
-		return;
 	}
 
-	assert(false);
+	cell->task = *task;
+
+	// Publish the task before handing the cell over to consumers.
+	xrt_atomic_thread_fence();
+	cell->sequence = seq_add(pos, 1);
+
+	return true;
 }
 
-static void
-locked_pool_push_task(struct pool *p, struct group *g, u_worker_group_func_t func, void *data)
+static bool
+inject_pop(struct pool *p, struct task *out_task)
 {
-	assert(p->tasks_in_array_count < MAX_TASK_COUNT);
-
-	for (size_t i = 0; i < MAX_TASK_COUNT; i++) {
-		if (p->tasks[i].func != NULL) {
-			continue;
+	struct inject_cell *cell = NULL;
+	int32_t pos = p->inject.dequeue_pos;
+
+	while (true) {
+		cell = &p->inject.cells[(uint32_t)pos & INJECT_QUEUE_MASK];
+		int32_t diff = seq_diff(cell->sequence, seq_add(pos, 1));
+
+		if (diff == 0) {
+			// The compare and swap is a full barrier, orders the task read.
+			int32_t old = xrt_atomic_s32_cmpxchg(&p->inject.dequeue_pos, pos, seq_add(pos, 1));
+			if (old == pos) {
+				break;
+			}
+			pos = old;
+		} else if (diff < 0) {
+			// Empty.
+			return false;
+		} else {
+			pos = p->inject.dequeue_pos;
 		}
+	}
 
-		p->tasks[i] = (struct task){g, func, data};
-		p->tasks_in_array_count++;
-		g->current_submitted_tasks_count++;
-		return;
+	*out_task = cell->task;
+
+	// Done reading the task, hand the cell back to producers.
+	xrt_atomic_thread_fence();
+	cell->sequence = seq_add(pos, INJECT_QUEUE_SIZE);
+
+	return true;
+}
+
+
+/*
+ *
+ * Local queue functions.
+ *
+ */
+
+static bool
+local_push(struct local_queue *lq, const struct task *task)
+{
+	os_mutex_lock(&lq->mutex);
+
+	if (lq->count >= LOCAL_QUEUE_SIZE) {
+		os_mutex_unlock(&lq->mutex);
+		return false;
 	}
 
-	assert(false);
+	lq->tasks[(lq->first + lq->count) % LOCAL_QUEUE_SIZE] = *task;
+	lq->count++;
+
+	os_mutex_unlock(&lq->mutex);
+
+	return true;
 }
 
-static void
-locked_pool_wake_worker_if_allowed(struct pool *p)
+static bool
+local_pop_back(struct local_queue *lq, struct task *out_task)
 {
-	// No tasks in array, don't wake any thread.
-	if (p->tasks_in_array_count == 0) {
-		return;
+	if (lq->count == 0) {
+		return false;
 	}
 
-	// The number of working threads is at the limit.
-	if (p->working_count >= p->worker_limit) {
-		return;
+	os_mutex_lock(&lq->mutex);
+
+	bool ret = lq->count > 0;
+	if (ret) {
+		lq->count--;
+		*out_task = lq->tasks[(lq->first + lq->count) % LOCAL_QUEUE_SIZE];
 	}
 
-	// No waiting thread.
-	if (p->available.count == 0) {
-		//! @todo Is this a error?
-		return;
+	os_mutex_unlock(&lq->mutex);
+
+	return ret;
+}
+
+static bool
+local_steal_front(struct local_queue *lq, struct task *out_task)
+{
+	// Cheap check so idle threads doesn't hammer the locks.
+	if (lq->count == 0) {
+		return false;
 	}
 
-	os_cond_signal(&p->available.cond);
+	os_mutex_lock(&lq->mutex);
+
+	bool ret = lq->count > 0;
+	if (ret) {
+		*out_task = lq->tasks[lq->first];
+		lq->first = (lq->first + 1) % LOCAL_QUEUE_SIZE;
+		lq->count--;
+	}
+
+	os_mutex_unlock(&lq->mutex);
+
+	return ret;
 }
 
 
 /*
  *
- * Thread group functions.
+ * Internal pool functions.
  *
  */
 
+static struct thread *
+pool_current_thread(struct pool *p)
+{
+	pthread_t self = pthread_self();
+
+	for (size_t i = 0; i < p->thread_count; i++) {
+		if (pthread_equal(p->threads[i].thread.thread, self)) {
+			return &p->threads[i];
+		}
+	}
+
+	return NULL;
+}
+
 static bool
-locked_group_should_enter_wait_loop(struct pool *p, struct group *g)
+pool_push_task(struct pool *p, struct group *g, u_worker_group_func_t func, void *data)
 {
-	if (g->current_submitted_tasks_count == 0) {
+	struct task task = {g, func, data};
+
+	// Count it before any thread can pick it up and complete it.
+	xrt_atomic_s32_inc_return(&g->current_submitted_tasks_count);
+
+	// Tasks pushed from a worker goes on its own deque, good for locality.
+	struct thread *t = pool_current_thread(p);
+	if ((t == NULL || !local_push(&t->local, &task)) && !inject_push(p, &task)) {
+		xrt_atomic_s32_dec_return(&g->current_submitted_tasks_count);
 		return false;
 	}
 
-	// Enter the loop as a released thread.
-	g->released_count++;
+	// Also a full barrier, pairs with the one in locked_thread_wait_for_work.
+	xrt_atomic_s32_inc_return(&p->queued_count);
 
 	return true;
 }
 
 static bool
-locked_group_should_wait(struct pool *p, struct group *g)
+pool_take_task(struct pool *p, struct thread *t, struct task *out_task)
 {
-	/*
-	 * There are several cases that needs to be covered by this function.
-	 *
-	 * A thread is entering the wait_all function for the first time, and
-	 * work is outstanding what we should do then is increase the worker
-	 * limit and wait on the conditional.
-	 *
-	 * Similar to preceding, we were woken up, there are more work outstanding
-	 * on the group and we had been released, remove one released and up the
-	 * worker limit, then wait on the conditional.
-	 *
-	 * A thread (or more) has been woken up and no new tasks has been
-	 * submitted, then break out of the loop and decrement the released
-	 * count.
-	 *
-	 * As preceding, but we were one of many woken up but only one thread had
-	 * been released and that released count had been taken, then we should
-	 * do nothing and wait again.
-	 */
-
-	// Tasks available.
-	if (g->current_submitted_tasks_count > 0) {
+	bool found = local_pop_back(&t->local, out_task) || inject_pop(p, out_task);
 
-		// We have been released or newly entered the loop.
-		if (g->released_count > 0) {
-			g->released_count--;
-			p->worker_limit++;
-
-			// Wake a worker with the new worker limit.
-			locked_pool_wake_worker_if_allowed(p);
-		}
-
-		return true;
+	// Steal the oldest task of another thread, start with the next one.
+	size_t index = (size_t)(t - p->threads);
+	for (size_t i = 1; !found && i < p->thread_count; i++) {
+		found = local_steal_front(&p->threads[(index + i) % p->thread_count].local, out_task);
 	}
 
-	// No tasks, and we have been released, party!
-	if (g->released_count > 0) {
-		g->released_count--;
-		return false;
+	if (found) {
+		xrt_atomic_s32_dec_return(&p->queued_count);
 	}
 
-	// We where woken up, but nothing had been released, loop again.
-	return true;
+	return found;
 }
 
 static void
-locked_group_wake_waiter_if_allowed(struct pool *p, struct group *g)
+pool_wake_worker_if_sleeping(struct pool *p)
 {
-	// Are there still outstanding tasks?
-	if (g->current_submitted_tasks_count > 0) {
+	if (atomic_read(&p->available.count) == 0) {
 		return;
 	}
 
-	// Is there a thread waiting or not?
-	if (g->waiting.count == 0) {
-		return;
-	}
+	os_mutex_lock(&p->mutex);
+	os_cond_signal(&p->available.cond);
+	os_mutex_unlock(&p->mutex);
+}
 
-	// Wake one waiting thread.
-	os_cond_signal(&g->waiting.cond);
 
-	assert(p->worker_limit > p->initial_worker_limit);
+/*
+ *
+ * Thread group functions.
+ *
+ */
+
+static void
+group_task_done(struct pool *p, struct group *g)
+{
+	int32_t count = g->current_submitted_tasks_count;
+
+	// Not the last task, no need to involve the mutex.
+	while (count > 1) {
+		int32_t old = xrt_atomic_s32_cmpxchg(&g->current_submitted_tasks_count, count, count - 1);
+		if (old == count) {
+			return;
+		}
+		count = old;
+	}
 
-	// Remove one waiting threads.
-	p->worker_limit--;
+	/*
+	 * The last task, hitting zero is done under the mutex so that a thread
+	 * in wait_all can't return and destroy the group under our feet.
+	 */
+	os_mutex_lock(&p->mutex);
 
-	// We have released one thread.
-	g->released_count++;
+	if (xrt_atomic_s32_dec_return(&g->current_submitted_tasks_count) == 0 && g->waiting.count > 0) {
+		os_cond_broadcast(&g->waiting.cond);
+	}
+
+	os_mutex_unlock(&p->mutex);
 }
 
+
 static void
-locked_group_wait(struct pool *p, struct group *g)
+parallel_for_run_chunks(struct parallel_for *pf)
 {
-	// Update tracking.
-	g->waiting.count++;
+	while (true) {
+		// Each thread overshoots by at most one, no risk of overflowing.
+		int32_t chunk = xrt_atomic_s32_inc_return(&pf->next_chunk) - 1;
+		if (chunk >= (int32_t)pf->chunk_count) {
+			return;
+		}
 
-	// The wait, also unlocks the mutex.
-	os_cond_wait(&g->waiting.cond, &p->mutex);
+		uint32_t begin = (uint32_t)chunk * pf->grain;
+		uint32_t end = pf->count - begin > pf->grain ? begin + pf->grain : pf->count;
 
-	// Update tracking.
-	g->waiting.count--;
+		pf->func(pf->data, begin, end);
+	}
+}
+
+static void
+parallel_for_task(void *ptr)
+{
+	parallel_for_run_chunks((struct parallel_for *)ptr);
 }
 
 
@@ -307,15 +507,30 @@ locked_group_wait(struct pool *p, struct group *g)
  */
 
 static bool
-locked_thread_allowed_to_work(struct pool *p)
+thread_try_claim_work_slot(struct pool *p)
 {
-	// No work for you!
-	if (p->tasks_in_array_count == 0) {
+	int32_t working = p->working_count;
+
+	while (working < p->worker_limit) {
+		int32_t old = xrt_atomic_s32_cmpxchg(&p->working_count, working, working + 1);
+		if (old == working) {
+			return true;
+		}
+		working = old;
+	}
+
+	return false;
+}
+
+static bool
+locked_thread_should_wait(struct pool *p)
+{
+	if (!p->running) {
 		return false;
 	}
 
-	// Reached the limit.
-	if (p->working_count >= p->worker_limit) {
+	// Work to do and allowed to do it.
+	if (p->queued_count > 0 && p->working_count < p->worker_limit) {
 		return false;
 	}
 
@@ -325,14 +540,16 @@ locked_thread_allowed_to_work(struct pool *p)
 static void
 locked_thread_wait_for_work(struct pool *p)
 {
-	// Update tracking.
-	p->available.count++;
+	// Update tracking, full barrier so we see any task pushed before this.
+	xrt_atomic_s32_inc_return(&p->available.count);
 
-	// The wait, also unlocks the mutex.
-	os_cond_wait(&p->available.cond, &p->mutex);
+	if (locked_thread_should_wait(p)) {
+		// The wait, also unlocks the mutex.
+		os_cond_wait(&p->available.cond, &p->mutex);
+	}
 
 	// Update tracking.
-	p->available.count--;
+	xrt_atomic_s32_dec_return(&p->available.count);
 }
 
 static void *
@@ -344,47 +561,38 @@ run_func(void *ptr)
 	snprintf(t->name, sizeof(t->name), "%s: Worker", p->prefix);
 	U_TRACE_SET_THREAD_NAME(t->name);
 
-	os_mutex_lock(&p->mutex);
+	// The thread field might not have been written yet, use self.
+	int ret = os_thread_native_set_core_class(pthread_self(), p->core_class);
+	if (ret != 0) {
+		U_LOG_W("Failed to pin thread '%s' to core class %i: %i", t->name, (int)p->core_class, ret);
+	}
 
 	while (p->running) {
-
-		if (!locked_thread_allowed_to_work(p)) {
-			locked_thread_wait_for_work(p);
-
-			// Check running first when woken up.
-			continue;
-		}
-
-		// Pop a task from the pool.
 		struct task task = {NULL, NULL, NULL};
-		locked_pool_pop_task(p, &task);
 
-		// We are now counting as working, needed for wake below.
-		p->working_count++;
+		// We are now counting as working if we get a slot.
+		if (p->queued_count > 0 && thread_try_claim_work_slot(p)) {
+			if (pool_take_task(p, t, &task)) {
+				// Do the actual work here.
+				task.func(task.data);
 
-		// Signal another thread if conditions are met.
-		locked_pool_wake_worker_if_allowed(p);
+				// No longer working.
+				xrt_atomic_s32_dec_return(&p->working_count);
 
-		// Do the actual work here.
-		os_mutex_unlock(&p->mutex);
-		task.func(task.data);
-		os_mutex_lock(&p->mutex);
-
-		// No longer working.
-		p->working_count--;
+				// Only now decrement the task count on the owning group.
+				group_task_done(p, task.g);
+				continue;
+			}
 
-		// Only now decrement the task count on the owning group.
-		task.g->current_submitted_tasks_count--;
+			// Lost the race for the task.
+			xrt_atomic_s32_dec_return(&p->working_count);
+		}
 
-		// Wake up any waiter.
-		locked_group_wake_waiter_if_allowed(p, task.g);
+		os_mutex_lock(&p->mutex);
+		locked_thread_wait_for_work(p);
+		os_mutex_unlock(&p->mutex);
 	}
 
-	// Make sure all threads are woken up.
-	os_cond_signal(&p->available.cond);
-
-	os_mutex_unlock(&p->mutex);
-
 	return NULL;
 }
 
@@ -396,7 +604,10 @@ run_func(void *ptr)
  */
 
 struct u_worker_thread_pool *
-u_worker_thread_pool_create(uint32_t starting_worker_count, uint32_t thread_count, const char *prefix)
+u_worker_thread_pool_create(uint32_t starting_worker_count,
+                            uint32_t thread_count,
+                            const char *prefix,
+                            enum os_thread_core_class core_class)
 {
 	XRT_TRACE_MARKER();
 	int ret;
@@ -413,11 +624,13 @@ u_worker_thread_pool_create(uint32_t starting_worker_count, uint32_t thread_coun
 
 	struct pool *p = U_TYPED_CALLOC(struct pool);
 	p->base.reference.count = 1;
-	p->initial_worker_limit = starting_worker_count;
-	p->worker_limit = starting_worker_count;
+	p->initial_worker_limit = (int32_t)starting_worker_count;
+	p->worker_limit = (int32_t)starting_worker_count;
 	p->thread_count = thread_count;
 	p->running = true;
+	p->core_class = os_thread_core_class_from_string(debug_get_option_worker_core_class(), core_class);
 	snprintf(p->prefix, sizeof(p->prefix), "%s", prefix);
+	inject_init(p);
 
 	ret = os_mutex_init(&p->mutex);
 	if (ret != 0) {
@@ -429,6 +642,14 @@ u_worker_thread_pool_create(uint32_t starting_worker_count, uint32_t thread_coun
 		goto err_mutex;
 	}
 
+	size_t local_count = 0;
+	for (; local_count < thread_count; local_count++) {
+		ret = os_mutex_init(&p->threads[local_count].local.mutex);
+		if (ret != 0) {
+			goto err_local;
+		}
+	}
+
 	for (size_t i = 0; i < thread_count; i++) {
 		p->threads[i].p = p;
 		os_thread_init(&p->threads[i].thread);
@@ -438,6 +659,12 @@ u_worker_thread_pool_create(uint32_t starting_worker_count, uint32_t thread_coun
 	return (struct u_worker_thread_pool *)p;
 
 
+err_local:
+	for (size_t i = 0; i < local_count; i++) {
+		os_mutex_destroy(&p->threads[i].local.mutex);
+	}
+	os_cond_destroy(&p->available.cond);
+
 err_mutex:
 	os_mutex_destroy(&p->mutex);
 
@@ -457,13 +684,14 @@ u_worker_thread_pool_destroy(struct u_worker_thread_pool *uwtp)
 	os_mutex_lock(&p->mutex);
 
 	p->running = false;
-	os_cond_signal(&p->available.cond);
+	os_cond_broadcast(&p->available.cond);
 	os_mutex_unlock(&p->mutex);
 
 	// Wait for all threads.
 	for (size_t i = 0; i < p->thread_count; i++) {
 		os_thread_join(&p->threads[i].thread);
 		os_thread_destroy(&p->threads[i].thread);
+		os_mutex_destroy(&p->threads[i].local.mutex);
 	}
 
 	os_mutex_destroy(&p->mutex);
@@ -501,49 +729,108 @@ u_worker_group_push(struct u_worker_group *uwg, u_worker_group_func_t f, void *d
 	struct group *g = group(uwg);
 	struct pool *p = pool(g->uwtp);
 
-	os_mutex_lock(&p->mutex);
-	while (p->tasks_in_array_count >= MAX_TASK_COUNT) {
-		os_mutex_unlock(&p->mutex);
-
+	while (!pool_push_task(p, g, f, data)) {
 		//! @todo Don't wait all, wait one.
 		u_worker_group_wait_all(uwg);
+	}
 
-		os_mutex_lock(&p->mutex);
+	// There are worker threads sleeping, wake one up.
+	pool_wake_worker_if_sleeping(p);
+}
+
+void
+u_worker_group_wait_all(struct u_worker_group *uwg)
+{
+	XRT_TRACE_MARKER();
+
+	struct group *g = group(uwg);
+	struct pool *p = pool(g->uwtp);
+
+	/*
+	 * Always take the mutex, the last task of the group is completed under
+	 * it so this makes sure that thread is done touching the group.
+	 */
+	os_mutex_lock(&p->mutex);
+
+	// Can we early out?
+	if (g->current_submitted_tasks_count == 0) {
+		os_mutex_unlock(&p->mutex);
+		return;
 	}
 
-	locked_pool_push_task(p, g, f, data);
+	// Let another worker run in the place of this waiting thread.
+	xrt_atomic_s32_inc_return(&p->worker_limit);
 
-	// There are worker threads available, wake one up.
 	if (p->available.count > 0) {
 		os_cond_signal(&p->available.cond);
 	}
 
+	// Wait here until all work been started and completed.
+	while (g->current_submitted_tasks_count > 0) {
+		g->waiting.count++;
+
+		// The wait, also unlocks the mutex.
+		os_cond_wait(&g->waiting.cond, &p->mutex);
+
+		g->waiting.count--;
+	}
+
+	xrt_atomic_s32_dec_return(&p->worker_limit);
+	assert(p->worker_limit >= p->initial_worker_limit);
+
 	os_mutex_unlock(&p->mutex);
 }
 
 void
-u_worker_group_wait_all(struct u_worker_group *uwg)
+u_worker_group_parallel_for(
+    struct u_worker_group *uwg, uint32_t count, uint32_t grain, u_worker_group_range_func_t func, void *data)
 {
 	XRT_TRACE_MARKER();
 
 	struct group *g = group(uwg);
 	struct pool *p = pool(g->uwtp);
 
-	os_mutex_lock(&p->mutex);
+	if (count == 0) {
+		return;
+	}
 
-	// Can we early out?
-	if (!locked_group_should_enter_wait_loop(p, g)) {
-		os_mutex_unlock(&p->mutex);
+	// Keep the chunk index in range of the atomic.
+	uint32_t min_grain = count / INT32_MAX + 1;
+	if (grain < min_grain) {
+		grain = min_grain;
+	}
+
+	uint32_t chunk_count = count / grain + (count % grain != 0 ? 1 : 0);
+
+	// Not worth going wide for.
+	if (chunk_count == 1) {
+		func(data, 0, count);
 		return;
 	}
 
-	// Wait here until all work been started and completed.
-	while (locked_group_should_wait(p, g)) {
-		// Do the wait.
-		locked_group_wait(p, g);
+	struct parallel_for pf = {
+	    .func = func,
+	    .data = data,
+	    .count = count,
+	    .grain = grain,
+	    .chunk_count = chunk_count,
+	    .next_chunk = 0,
+	};
+
+	// The calling thread takes chunks too, so one helper less is needed.
+	uint32_t helper_count = chunk_count - 1;
+	if (helper_count > p->thread_count) {
+		helper_count = (uint32_t)p->thread_count;
 	}
 
-	os_mutex_unlock(&p->mutex);
+	for (uint32_t i = 0; i < helper_count; i++) {
+		u_worker_group_push(uwg, parallel_for_task, &pf);
+	}
+
+	parallel_for_run_chunks(&pf);
+
+	// Helpers that didn't get any chunks returns straight away.
+	u_worker_group_wait_all(uwg);
 }
 
 void
@@ -11,6 +11,13 @@
 #include "util/u_worker.hpp"
 
 
+void
+xrt::auxiliary::util::SharedThreadGroup::cRangeCallback(void *data_ptr, uint32_t begin, uint32_t end)
+{
+	auto &f = *static_cast<RangeFunctor const *>(data_ptr);
+	f(begin, end);
+}
+
 void
 xrt::auxiliary::util::TaskCollection::cCallback(void *data_ptr)
 {
@@ -12,6 +12,8 @@
 
 #include "xrt/xrt_defines.h"
 
+#include "os/os_threading.h"
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -44,11 +46,17 @@ struct u_worker_thread_pool
  *                              flight at the same time.
  * @param prefix                Prefix to used when naming threads, used for
  *                              tracing and debugging.
+ * @param core_class            Class of cores the threads are pinned to, can
+ *                              be overridden with the U_WORKER_CORE_CLASS
+ *                              environment variable.
  *
  * @ingroup aux_util
  */
 struct u_worker_thread_pool *
-u_worker_thread_pool_create(uint32_t starting_worker_count, uint32_t thread_count, const char *prefix);
+u_worker_thread_pool_create(uint32_t starting_worker_count,
+                            uint32_t thread_count,
+                            const char *prefix,
+                            enum os_thread_core_class core_class);
 
 /*!
  * Internal function, only called by reference.
@@ -135,6 +143,32 @@ u_worker_group_push(struct u_worker_group *uwg, u_worker_group_func_t f, void *d
 void
 u_worker_group_wait_all(struct u_worker_group *uwg);
 
+/*!
+ * Function typedef for parallel for, called with the half open range of
+ * indices [begin, end) that it should process.
+ *
+ * @ingroup aux_util
+ */
+typedef void (*u_worker_group_range_func_t)(void *data, uint32_t begin, uint32_t end);
+
+/*!
+ * Calls @p func over the range [0, count) split up into chunks of @p grain
+ * indices, the chunks are run on the pool and on the calling thread. Returns
+ * when all of the range has been processed, like @ref u_worker_group_wait_all
+ * this also waits for any other tasks pushed to the group.
+ *
+ * @param uwg   Group to run the chunks on.
+ * @param count Number of indices in the range.
+ * @param grain Number of indices per chunk, zero is treated as one.
+ * @param func  Function called for each chunk.
+ * @param data  Data passed to @p func.
+ *
+ * @ingroup aux_util
+ */
+void
+u_worker_group_parallel_for(
+    struct u_worker_group *uwg, uint32_t count, uint32_t grain, u_worker_group_range_func_t func, void *data);
+
 /*!
  * Destroy a worker pool.
  *
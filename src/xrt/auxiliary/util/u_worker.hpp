@@ -51,9 +51,12 @@ public:
 	/*!
 	 * @copydoc u_worker_thread_pool_create
 	 */
-	SharedThreadPool(uint32_t starting_worker_count, uint32_t thread_count, const char *prefix)
+	SharedThreadPool(uint32_t starting_worker_count,
+	                 uint32_t thread_count,
+	                 const char *prefix,
+	                 enum os_thread_core_class core_class = OS_THREAD_CORE_CLASS_ANY)
 	{
-		mPool = u_worker_thread_pool_create(starting_worker_count, thread_count, prefix);
+		mPool = u_worker_thread_pool_create(starting_worker_count, thread_count, prefix, core_class);
 	}
 
 	~SharedThreadPool()
@@ -90,6 +93,10 @@ public:
  */
 class SharedThreadGroup
 {
+public:
+	typedef std::function<void(uint32_t begin, uint32_t end)> RangeFunctor;
+
+
 private:
 	u_worker_group *mGroup = nullptr;
 
@@ -105,6 +112,18 @@ public:
 		u_worker_group_reference(&mGroup, nullptr);
 	}
 
+	/*!
+	 * Calls @p func with chunks of at most @p grain indices of the range
+	 * [0, count), with the calling thread taking part in the work.
+	 *
+	 * @copydetails u_worker_group_parallel_for
+	 */
+	void
+	parallelFor(uint32_t count, uint32_t grain, RangeFunctor const &func)
+	{
+		u_worker_group_parallel_for(mGroup, count, grain, &cRangeCallback, const_cast<RangeFunctor *>(&func));
+	}
+
 	friend TaskCollection;
 
 	// No default constructor.
@@ -116,6 +135,11 @@ public:
 	operator=(SharedThreadGroup const &) = delete;
 	SharedThreadGroup &
 	operator=(SharedThreadGroup &&) = delete;
+
+
+private:
+	static void
+	cRangeCallback(void *data_ptr, uint32_t begin, uint32_t end);
 };
 
 /*!
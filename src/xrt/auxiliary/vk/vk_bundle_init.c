@@ -730,6 +730,7 @@ fill_in_has_device_extensions(struct vk_bundle *vk, struct u_string_list *ext_li
 	vk->has_EXT_external_memory_dma_buf = false;
 	vk->has_EXT_global_priority = false;
 	vk->has_EXT_image_drm_format_modifier = false;
+	vk->has_EXT_memory_budget = false;
 	vk->has_EXT_robustness2 = false;
 	vk->has_GOOGLE_display_timing = false;
 
@@ -851,6 +852,13 @@ fill_in_has_device_extensions(struct vk_bundle *vk, struct u_string_list *ext_li
 		}
 #endif // defined(VK_EXT_image_drm_format_modifier)
 
+#if defined(VK_EXT_memory_budget)
+		if (strcmp(ext, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0) {
+			vk->has_EXT_memory_budget = true;
+			continue;
+		}
+#endif // defined(VK_EXT_memory_budget)
+
 #if defined(VK_EXT_robustness2)
 		if (strcmp(ext, VK_EXT_ROBUSTNESS_2_EXTENSION_NAME) == 0) {
 			vk->has_EXT_robustness2 = true;
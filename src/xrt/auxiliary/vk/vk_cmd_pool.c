@@ -26,9 +26,12 @@ vk_cmd_pool_init(struct vk_bundle *vk, struct vk_cmd_pool *pool, VkCommandPoolCr
 	XRT_MAYBE_UNUSED int iret = os_mutex_init(&pool->mutex);
 	assert(iret == 0);
 
+	pool->recycled_count = 0;
+	pool->fence = VK_NULL_HANDLE;
+
 	VkCommandPoolCreateInfo cmd_pool_info = {
 	    .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
-	    .flags = flags,
+	    .flags = flags | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
 	    .queueFamilyIndex = vk->queue_family_index,
 	};
 
@@ -49,8 +52,15 @@ vk_cmd_pool_destroy(struct vk_bundle *vk, struct vk_cmd_pool *pool)
 		return;
 	}
 
+	if (pool->fence != VK_NULL_HANDLE) {
+		vk->vkDestroyFence(vk->device, pool->fence, NULL);
+		pool->fence = VK_NULL_HANDLE;
+	}
+
+	// Also frees any recycled command buffers.
 	vk->vkDestroyCommandPool(vk->device, pool->pool, NULL);
 	pool->pool = VK_NULL_HANDLE;
+	pool->recycled_count = 0;
 
 	os_mutex_destroy(&pool->mutex);
 }
@@ -61,6 +71,12 @@ vk_cmd_pool_create_cmd_buffer_locked(struct vk_bundle *vk, struct vk_cmd_pool *p
 	VkCommandBuffer cmd_buffer;
 	VkResult ret;
 
+	// Begin implicitly resets it, the pool has the reset bit set.
+	if (pool->recycled_count > 0) {
+		*out_cmd_buffer = pool->recycled[--pool->recycled_count];
+		return VK_SUCCESS;
+	}
+
 	// Allocate the command buffer.
 	VkCommandBufferAllocateInfo cmd_buffer_info = {
 	    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
@@ -141,3 +157,77 @@ vk_cmd_pool_submit_cmd_buffer_locked(struct vk_bundle *vk, struct vk_cmd_pool *p
 
 	return ret;
 }
+
+XRT_CHECK_RESULT VkResult
+vk_cmd_pool_end_submit_wait_and_free_cmd_buffer_locked(struct vk_bundle *vk,
+                                                       struct vk_cmd_pool *pool,
+                                                       VkCommandBuffer cmd_buffer)
+{
+	VkResult ret;
+
+	// Finish the command buffer first, the command buffer pool lock needs to be held.
+	ret = vk->vkEndCommandBuffer(cmd_buffer);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkEndCommandBuffer: %s", vk_result_string(ret));
+		goto out_free;
+	}
+
+	if (pool->fence == VK_NULL_HANDLE) {
+		VkFenceCreateInfo fence_info = {
+		    .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+		};
+
+		ret = vk->vkCreateFence(vk->device, &fence_info, NULL, &pool->fence);
+		if (ret != VK_SUCCESS) {
+			VK_ERROR(vk, "vkCreateFence: %s", vk_result_string(ret));
+			pool->fence = VK_NULL_HANDLE;
+			goto out_free;
+		}
+
+		VK_NAME_OBJECT(vk, FENCE, pool->fence, "VK Cmd Pool Submit And Wait");
+	}
+
+	// Do the submit.
+	VkSubmitInfo submitInfo = {
+	    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+	    .commandBufferCount = 1,
+	    .pCommandBuffers = &cmd_buffer,
+	};
+
+	ret = vk_cmd_submit_locked(vk, 1, &submitInfo, pool->fence);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vk_cmd_submit_locked: %s", vk_result_string(ret));
+		goto out_destroy_fence;
+	}
+
+	// Then wait for the fence.
+	ret = vk->vkWaitForFences(vk->device, 1, &pool->fence, VK_TRUE, 1000000000);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkWaitForFences: %s", vk_result_string(ret));
+		goto out_destroy_fence;
+	}
+
+	ret = vk->vkResetFences(vk->device, 1, &pool->fence);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkResetFences: %s", vk_result_string(ret));
+		goto out_destroy_fence;
+	}
+
+	// The commands have completed, keep the command buffer around for reuse.
+	if (pool->recycled_count < ARRAY_SIZE(pool->recycled)) {
+		pool->recycled[pool->recycled_count++] = cmd_buffer;
+		return VK_SUCCESS;
+	}
+
+	goto out_free;
+
+out_destroy_fence:
+	// The fence may still be pending, same for the command buffer on timeout.
+	vk->vkDestroyFence(vk->device, pool->fence, NULL);
+	pool->fence = VK_NULL_HANDLE;
+out_free:
+	// Destroy the command buffer, the command buffer pool lock needs to be held.
+	vk->vkFreeCommandBuffers(vk->device, pool->pool, 1, &cmd_buffer);
+
+	return ret;
+}
@@ -24,6 +24,9 @@ extern "C" {
  *
  */
 
+//! Number of completed one-shot command buffers kept for reuse.
+#define VK_CMD_POOL_MAX_RECYCLED_CMD_BUFFERS 4
+
 /*!
  * Small helper to manage lock around a command pool.
  *
@@ -33,6 +36,16 @@ struct vk_cmd_pool
 {
 	VkCommandPool pool;
 	struct os_mutex mutex;
+
+	/*!
+	 * Command buffers that have completed, reused by
+	 * @ref vk_cmd_pool_create_cmd_buffer_locked instead of allocating.
+	 */
+	VkCommandBuffer recycled[VK_CMD_POOL_MAX_RECYCLED_CMD_BUFFERS];
+	uint32_t recycled_count;
+
+	//! Fence reused by @ref vk_cmd_pool_end_submit_wait_and_free_cmd_buffer_locked.
+	VkFence fence;
 };
 
 
@@ -43,7 +56,9 @@ struct vk_cmd_pool
  */
 
 /*!
- * Create a command buffer pool.
+ * Create a command buffer pool, it is always created with
+ * `VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT` so that command buffers
+ * can be recycled.
  *
  * @public @memberof vk_cmd_pool
  */
@@ -60,7 +75,9 @@ void
 vk_cmd_pool_destroy(struct vk_bundle *vk, struct vk_cmd_pool *pool);
 
 /*!
- * Create a command buffer, call with the pool mutex held.
+ * Create a command buffer, call with the pool mutex held. Reuses a command
+ * buffer recycled by @ref vk_cmd_pool_end_submit_wait_and_free_cmd_buffer_locked
+ * if there is one.
  *
  * @pre Command pool lock must be held, see @ref vk_cmd_pool_lock.
  *
@@ -93,28 +110,25 @@ XRT_CHECK_RESULT VkResult
 vk_cmd_pool_submit_cmd_buffer_locked(struct vk_bundle *vk, struct vk_cmd_pool *pool, VkCommandBuffer cmd_buffer);
 
 /*!
- * A do everything submit function, will take the queue mutex. Will create a
- * fence and wait on the commands to complete. Will also end and destroy the
- * passed in command buffer.
+ * A do everything submit function, will take the queue mutex. Will wait on the
+ * commands to complete using the fence of the pool. Will also end the passed
+ * in command buffer and give it back to the pool to be reused.
  *
  * @pre Command pool lock must be held, see @ref vk_cmd_pool_lock.
  *
  * Calls:
  * * vkEndCommandBuffer
- * * vkCreateFence
+ * * vkCreateFence (first time only)
  * * vkWaitForFences
- * * vkDestroyFence
- * * vkFreeCommandBuffers
+ * * vkResetFences
+ * * vkFreeCommandBuffers (if not recycled)
  *
  * @public @memberof vk_cmd_pool
  */
-XRT_CHECK_RESULT static inline VkResult
+XRT_CHECK_RESULT VkResult
 vk_cmd_pool_end_submit_wait_and_free_cmd_buffer_locked(struct vk_bundle *vk,
                                                        struct vk_cmd_pool *pool,
-                                                       VkCommandBuffer cmd_buffer)
-{
-	return vk_cmd_end_submit_wait_and_free_cmd_buffer_locked(vk, pool->pool, cmd_buffer);
-}
+                                                       VkCommandBuffer cmd_buffer);
 
 /*!
  * Lock the command pool, needed for creating command buffers, filling out
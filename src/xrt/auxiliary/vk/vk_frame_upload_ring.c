@@ -0,0 +1,580 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Ring of staging buffers and images to upload xrt_frames to the gpu
+ *
+ * @ingroup aux_vk
+ */
+
+#include "os/os_threading.h"
+
+#include "util/u_misc.h"
+#include "util/u_format.h"
+#include "util/u_logging.h"
+#include "util/u_trace_marker.h"
+
+#include "vk/vk_cmd_pool.h"
+#include "vk/vk_frame_upload_ring.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <assert.h>
+
+
+struct vk_frame_upload_slot
+{
+	//! Persistently mapped, host coherent.
+	struct vk_buffer staging;
+
+	VkImage image;
+	VkImageView view;
+	VkDeviceMemory image_memory;
+
+	//! Command buffer of the last upload, freed when the slot is reused.
+	VkCommandBuffer cmd;
+
+	//! Signaled when the last upload completes, created signaled.
+	VkFence fence;
+
+	//! Value the timeline semaphore reaches when the last upload completes.
+	uint64_t value;
+
+	uint64_t timestamp_ns;
+
+	//! Has a upload been submitted, image contents are valid.
+	bool submitted;
+
+	//! Held by the consumer.
+	bool held;
+};
+
+struct vk_frame_upload_ring
+{
+	//! Protects held, submitted and latest.
+	struct os_mutex mutex;
+
+	struct vk_cmd_pool pool;
+
+	//! Only if timeline semaphores are enabled on the bundle.
+	VkSemaphore timeline;
+	uint64_t timeline_value;
+
+	VkExtent2D extent;
+	enum xrt_format xrt_format;
+	VkFormat vk_format;
+	size_t row_size;
+
+	//! Latest submitted slot, negative if none.
+	int32_t latest;
+
+	//! Where to search for a free slot from.
+	uint32_t next;
+
+	struct vk_frame_upload_slot slots[VK_FRAME_UPLOAD_RING_SIZE];
+};
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+#define D(TYPE, THING)                                                                                                 \
+	if (THING != VK_NULL_HANDLE) {                                                                                 \
+		vk->vkDestroy##TYPE(vk->device, THING, NULL);                                                          \
+		THING = VK_NULL_HANDLE;                                                                                \
+	}
+
+#define DF(TYPE, THING)                                                                                                \
+	if (THING != VK_NULL_HANDLE) {                                                                                 \
+		vk->vkFree##TYPE(vk->device, THING, NULL);                                                             \
+		THING = VK_NULL_HANDLE;                                                                                \
+	}
+
+static VkResult
+create_timeline(struct vk_bundle *vk, VkSemaphore *out_sem)
+{
+#ifdef VK_KHR_timeline_semaphore
+	if (!vk->features.timeline_semaphore) {
+		return VK_SUCCESS;
+	}
+
+	VkSemaphoreTypeCreateInfo type_info = {
+	    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+	    .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+	    .initialValue = 0,
+	};
+
+	VkSemaphoreCreateInfo create_info = {
+	    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+	    .pNext = &type_info,
+	};
+
+	VkResult ret = vk->vkCreateSemaphore(vk->device, &create_info, NULL, out_sem);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkCreateSemaphore: %s", vk_result_string(ret));
+	}
+
+	return ret;
+#else
+	return VK_SUCCESS;
+#endif
+}
+
+static VkResult
+slot_init(struct vk_bundle *vk, struct vk_frame_upload_ring *ring, struct vk_frame_upload_slot *slot)
+{
+	VkResult ret;
+
+	VkDeviceSize size = (VkDeviceSize)ring->row_size * ring->extent.height;
+	VkMemoryPropertyFlags memory_property_flags = //
+	    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |     //
+	    VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;     //
+
+	bool bret = vk_buffer_init(           //
+	    vk,                               //
+	    size,                             //
+	    VK_BUFFER_USAGE_TRANSFER_SRC_BIT, //
+	    memory_property_flags,            //
+	    &slot->staging.handle,            //
+	    &slot->staging.memory);           //
+	if (!bret) {
+		return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+	}
+	slot->staging.size = (uint32_t)size;
+
+	// Keep it mapped for the life time of the ring.
+	ret = vk->vkMapMemory(    //
+	    vk->device,           // device
+	    slot->staging.memory, // memory
+	    0,                    // offset
+	    VK_WHOLE_SIZE,        // size
+	    0,                    // flags
+	    &slot->staging.data); // ppData
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkMapMemory: %s", vk_result_string(ret));
+		return ret;
+	}
+
+	VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+	ret = vk_create_image_simple( //
+	    vk,                       // vk_bundle
+	    ring->extent,             // extent
+	    ring->vk_format,          // format
+	    usage,                    // usage
+	    &slot->image_memory,      // out_mem
+	    &slot->image);            // out_image
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vk_create_image_simple: %s", vk_result_string(ret));
+		return ret;
+	}
+
+	VkImageSubresourceRange subresource_range = {
+	    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	    .baseMipLevel = 0,
+	    .levelCount = 1,
+	    .baseArrayLayer = 0,
+	    .layerCount = 1,
+	};
+
+	ret = vk_create_view(      //
+	    vk,                    // vk_bundle
+	    slot->image,           // image
+	    VK_IMAGE_VIEW_TYPE_2D, // type
+	    ring->vk_format,       // format
+	    subresource_range,     // subresource_range
+	    &slot->view);          // out_view
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vk_create_view: %s", vk_result_string(ret));
+		return ret;
+	}
+
+	// Created signaled, so the first upload doesn't have to special case it.
+	VkFenceCreateInfo fence_info = {
+	    .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+	    .flags = VK_FENCE_CREATE_SIGNALED_BIT,
+	};
+
+	ret = vk->vkCreateFence(vk->device, &fence_info, NULL, &slot->fence);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkCreateFence: %s", vk_result_string(ret));
+		return ret;
+	}
+
+	return VK_SUCCESS;
+}
+
+static void
+slot_fini(struct vk_bundle *vk, struct vk_frame_upload_ring *ring, struct vk_frame_upload_slot *slot)
+{
+	if (slot->fence != VK_NULL_HANDLE) {
+		vk->vkWaitForFences(vk->device, 1, &slot->fence, VK_TRUE, UINT64_MAX);
+	}
+
+	if (slot->cmd != VK_NULL_HANDLE) {
+		vk_cmd_pool_lock(&ring->pool);
+		vk->vkFreeCommandBuffers(vk->device, ring->pool.pool, 1, &slot->cmd);
+		vk_cmd_pool_unlock(&ring->pool);
+		slot->cmd = VK_NULL_HANDLE;
+	}
+
+	D(Fence, slot->fence);
+	D(ImageView, slot->view);
+	D(Image, slot->image);
+	DF(Memory, slot->image_memory);
+	D(Buffer, slot->staging.handle);
+	DF(Memory, slot->staging.memory); // Implicitly unmaps.
+	slot->staging.data = NULL;
+}
+
+static bool
+slot_is_complete(struct vk_bundle *vk, struct vk_frame_upload_slot *slot)
+{
+	return vk->vkGetFenceStatus(vk->device, slot->fence) == VK_SUCCESS;
+}
+
+//! Called with the ring lock held, never picks the latest so it stays valid.
+static int32_t
+find_free_slot_locked(struct vk_frame_upload_ring *ring)
+{
+	for (uint32_t i = 0; i < VK_FRAME_UPLOAD_RING_SIZE; i++) {
+		uint32_t index = (ring->next + i) % VK_FRAME_UPLOAD_RING_SIZE;
+		struct vk_frame_upload_slot *slot = &ring->slots[index];
+
+		if (slot->held || (int32_t)index == ring->latest) {
+			continue;
+		}
+
+		ring->next = (index + 1) % VK_FRAME_UPLOAD_RING_SIZE;
+
+		return (int32_t)index;
+	}
+
+	return -1;
+}
+
+static void
+write_frame(struct vk_frame_upload_ring *ring, struct vk_frame_upload_slot *slot, struct xrt_frame *xf)
+{
+	uint8_t *dst = (uint8_t *)slot->staging.data;
+
+	if (xf->stride == ring->row_size) {
+		memcpy(dst, xf->data, ring->row_size * xf->height);
+		return;
+	}
+
+	for (uint32_t y = 0; y < xf->height; y++) {
+		memcpy(dst + y * ring->row_size, xf->data + y * xf->stride, ring->row_size);
+	}
+}
+
+static VkResult
+record_and_submit(struct vk_bundle *vk, struct vk_frame_upload_ring *ring, struct vk_frame_upload_slot *slot)
+{
+	VkCommandBuffer cmd = VK_NULL_HANDLE;
+	VkResult ret;
+
+	vk_cmd_pool_lock(&ring->pool);
+
+	// The fence has been waited on, so the old command buffer is done.
+	if (slot->cmd != VK_NULL_HANDLE) {
+		vk->vkFreeCommandBuffers(vk->device, ring->pool.pool, 1, &slot->cmd);
+		slot->cmd = VK_NULL_HANDLE;
+	}
+
+	ret = vk_cmd_pool_create_and_begin_cmd_buffer_locked( //
+	    vk,                                               //
+	    &ring->pool,                                      //
+	    VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,      //
+	    &cmd);                                            //
+	if (ret != VK_SUCCESS) {
+		vk_cmd_pool_unlock(&ring->pool);
+		return ret;
+	}
+
+	VkImageSubresourceRange subresource_range = {
+	    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	    .baseMipLevel = 0,
+	    .levelCount = 1,
+	    .baseArrayLayer = 0,
+	    .layerCount = 1,
+	};
+
+	// Old content is not needed, the whole image is overwritten.
+	vk_cmd_image_barrier_gpu_locked(          //
+	    vk,                                   //
+	    cmd,                                  //
+	    slot->image,                          //
+	    0,                                    //
+	    VK_ACCESS_TRANSFER_WRITE_BIT,         //
+	    VK_IMAGE_LAYOUT_UNDEFINED,            //
+	    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, //
+	    subresource_range);                   //
+
+	VkBufferImageCopy region = {
+	    .bufferOffset = 0,
+	    .bufferRowLength = 0,
+	    .bufferImageHeight = 0,
+	    .imageSubresource =
+	        {
+	            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	            .mipLevel = 0,
+	            .baseArrayLayer = 0,
+	            .layerCount = 1,
+	        },
+	    .imageOffset = {0, 0, 0},
+	    .imageExtent = {ring->extent.width, ring->extent.height, 1},
+	};
+
+	vk->vkCmdCopyBufferToImage(               //
+	    cmd,                                  // commandBuffer
+	    slot->staging.handle,                 // srcBuffer
+	    slot->image,                          // dstImage
+	    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, // dstImageLayout
+	    1,                                    // regionCount
+	    &region);                             // pRegions
+
+	vk_cmd_image_barrier_gpu_locked(              //
+	    vk,                                       //
+	    cmd,                                      //
+	    slot->image,                              //
+	    VK_ACCESS_TRANSFER_WRITE_BIT,             //
+	    VK_ACCESS_SHADER_READ_BIT,                //
+	    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,     //
+	    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, //
+	    subresource_range);                       //
+
+	ret = vk->vkEndCommandBuffer(cmd);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkEndCommandBuffer: %s", vk_result_string(ret));
+		vk->vkFreeCommandBuffers(vk->device, ring->pool.pool, 1, &cmd);
+		vk_cmd_pool_unlock(&ring->pool);
+		return ret;
+	}
+
+	const void *next = NULL;
+	uint32_t signal_count = 0;
+	uint64_t value = ring->timeline_value + 1;
+
+#ifdef VK_KHR_timeline_semaphore
+	VkTimelineSemaphoreSubmitInfoKHR timeline_info = {
+	    .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR,
+	    .signalSemaphoreValueCount = 1,
+	    .pSignalSemaphoreValues = &value,
+	};
+
+	if (ring->timeline != VK_NULL_HANDLE) {
+		next = &timeline_info;
+		signal_count = 1;
+	}
+#endif
+
+	VkSubmitInfo submit_info = {
+	    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+	    .pNext = next,
+	    .commandBufferCount = 1,
+	    .pCommandBuffers = &cmd,
+	    .signalSemaphoreCount = signal_count,
+	    .pSignalSemaphores = &ring->timeline,
+	};
+
+	vk->vkResetFences(vk->device, 1, &slot->fence);
+
+	// Only takes the queue lock for the submit itself, nothing is waited on.
+	ret = vk_cmd_submit_locked(vk, 1, &submit_info, slot->fence);
+
+	vk_cmd_pool_unlock(&ring->pool);
+
+	if (ret != VK_SUCCESS) {
+		vk_cmd_pool_lock(&ring->pool);
+		vk->vkFreeCommandBuffers(vk->device, ring->pool.pool, 1, &cmd);
+		vk_cmd_pool_unlock(&ring->pool);
+
+		// Nothing will signal the fence, replace it with a signaled one.
+		VkFenceCreateInfo fence_info = {
+		    .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+		    .flags = VK_FENCE_CREATE_SIGNALED_BIT,
+		};
+		D(Fence, slot->fence);
+		vk->vkCreateFence(vk->device, &fence_info, NULL, &slot->fence);
+
+		return ret;
+	}
+
+	slot->cmd = cmd;
+	slot->value = value;
+	ring->timeline_value = value;
+
+	return VK_SUCCESS;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+VkResult
+vk_frame_upload_ring_create(struct vk_bundle *vk,
+                            VkExtent2D extent,
+                            enum xrt_format xrt_format,
+                            VkFormat vk_format,
+                            struct vk_frame_upload_ring **out_ring)
+{
+	assert(!u_format_is_blocks(xrt_format));
+
+	struct vk_frame_upload_ring *ring = U_TYPED_CALLOC(struct vk_frame_upload_ring);
+	VkResult ret;
+
+	ring->extent = extent;
+	ring->xrt_format = xrt_format;
+	ring->vk_format = vk_format;
+	ring->row_size = u_format_block_size(xrt_format) * extent.width;
+	ring->latest = -1;
+
+	int iret = os_mutex_init(&ring->mutex);
+	if (iret != 0) {
+		free(ring);
+		return VK_ERROR_INITIALIZATION_FAILED;
+	}
+
+	// Command buffers are short lived and used once.
+	ret = vk_cmd_pool_init(vk, &ring->pool, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+	if (ret != VK_SUCCESS) {
+		os_mutex_destroy(&ring->mutex);
+		free(ring);
+		return ret;
+	}
+
+	ret = create_timeline(vk, &ring->timeline);
+	if (ret != VK_SUCCESS) {
+		vk_frame_upload_ring_destroy(vk, &ring);
+		return ret;
+	}
+
+	for (uint32_t i = 0; i < VK_FRAME_UPLOAD_RING_SIZE; i++) {
+		ret = slot_init(vk, ring, &ring->slots[i]);
+		if (ret != VK_SUCCESS) {
+			vk_frame_upload_ring_destroy(vk, &ring);
+			return ret;
+		}
+	}
+
+	*out_ring = ring;
+
+	return VK_SUCCESS;
+}
+
+bool
+vk_frame_upload_ring_upload(struct vk_bundle *vk, struct vk_frame_upload_ring *ring, struct xrt_frame *xf)
+{
+	XRT_TRACE_MARKER();
+
+	if (xf->format != ring->xrt_format || xf->width != ring->extent.width || xf->height != ring->extent.height) {
+		U_LOG_W("Frame doesn't match upload ring!");
+		return false;
+	}
+
+	os_mutex_lock(&ring->mutex);
+	int32_t index = find_free_slot_locked(ring);
+	if (index >= 0) {
+		// Not visible to the consumer until submitted.
+		ring->slots[index].submitted = false;
+	}
+	os_mutex_unlock(&ring->mutex);
+
+	if (index < 0) {
+		U_LOG_W("Out of upload slots!");
+		return false;
+	}
+
+	struct vk_frame_upload_slot *slot = &ring->slots[index];
+
+	// The slot was submitted at least a full ring ago, so this rarely waits.
+	vk->vkWaitForFences(vk->device, 1, &slot->fence, VK_TRUE, UINT64_MAX);
+
+	write_frame(ring, slot, xf);
+
+	VkResult ret = record_and_submit(vk, ring, slot);
+	if (ret != VK_SUCCESS) {
+		return false;
+	}
+
+	os_mutex_lock(&ring->mutex);
+	slot->timestamp_ns = xf->timestamp;
+	slot->submitted = true;
+	ring->latest = index;
+	os_mutex_unlock(&ring->mutex);
+
+	return true;
+}
+
+bool
+vk_frame_upload_ring_acquire_latest(struct vk_bundle *vk,
+                                    struct vk_frame_upload_ring *ring,
+                                    struct vk_frame_upload *out_upload)
+{
+	os_mutex_lock(&ring->mutex);
+
+	int32_t index = ring->latest;
+	if (index < 0 || !ring->slots[index].submitted) {
+		os_mutex_unlock(&ring->mutex);
+		return false;
+	}
+
+	struct vk_frame_upload_slot *slot = &ring->slots[index];
+
+	// Without a semaphore to wait on only completed uploads can be used.
+	if (ring->timeline == VK_NULL_HANDLE && !slot_is_complete(vk, slot)) {
+		os_mutex_unlock(&ring->mutex);
+		return false;
+	}
+
+	slot->held = true;
+
+	out_upload->index = (uint32_t)index;
+	out_upload->image = slot->image;
+	out_upload->view = slot->view;
+	out_upload->timestamp_ns = slot->timestamp_ns;
+	out_upload->wait_semaphore = ring->timeline;
+	out_upload->wait_value = slot->value;
+
+	os_mutex_unlock(&ring->mutex);
+
+	return true;
+}
+
+void
+vk_frame_upload_ring_release(struct vk_frame_upload_ring *ring, uint32_t index)
+{
+	assert(index < VK_FRAME_UPLOAD_RING_SIZE);
+
+	os_mutex_lock(&ring->mutex);
+	ring->slots[index].held = false;
+	os_mutex_unlock(&ring->mutex);
+}
+
+void
+vk_frame_upload_ring_destroy(struct vk_bundle *vk, struct vk_frame_upload_ring **ring_ptr)
+{
+	struct vk_frame_upload_ring *ring = *ring_ptr;
+	if (ring == NULL) {
+		return;
+	}
+
+	for (uint32_t i = 0; i < VK_FRAME_UPLOAD_RING_SIZE; i++) {
+		slot_fini(vk, ring, &ring->slots[i]);
+	}
+
+	D(Semaphore, ring->timeline);
+
+	vk_cmd_pool_destroy(vk, &ring->pool);
+	os_mutex_destroy(&ring->mutex);
+
+	free(ring);
+	*ring_ptr = NULL;
+}
@@ -0,0 +1,111 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Ring of staging buffers and images to upload xrt_frames to the gpu
+ *
+ * @ingroup aux_vk
+ */
+
+#pragma once
+
+#include "xrt/xrt_frame.h"
+#include "xrt/xrt_vulkan_includes.h"
+
+#include "vk/vk_helpers.h"
+
+
+#define VK_FRAME_UPLOAD_RING_SIZE 4
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// Opaque handle
+struct vk_frame_upload_ring;
+
+/*!
+ * A uploaded frame, the image is in the
+ * `VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL` layout once the upload has
+ * completed.
+ *
+ * @ingroup aux_vk
+ */
+struct vk_frame_upload
+{
+	//! Index into the ring, give back to @ref vk_frame_upload_ring_release.
+	uint32_t index;
+
+	VkImage image;
+	VkImageView view;
+
+	//! Timestamp of the uploaded frame.
+	uint64_t timestamp_ns;
+
+	/*!
+	 * If not `VK_NULL_HANDLE` the consumer must wait on this timeline
+	 * semaphore reaching @p wait_value in the submit that reads the image.
+	 */
+	VkSemaphore wait_semaphore;
+	uint64_t wait_value;
+};
+
+/*!
+ * Create the ring, all images have the given extent and format, @p xrt_format
+ * must not be a block format and match @p vk_format in size.
+ *
+ * @ingroup aux_vk
+ */
+VkResult
+vk_frame_upload_ring_create(struct vk_bundle *vk,
+                            VkExtent2D extent,
+                            enum xrt_format xrt_format,
+                            VkFormat vk_format,
+                            struct vk_frame_upload_ring **out_ring);
+
+/*!
+ * Copy the frame into the persistently mapped staging memory of a free slot
+ * and submit the copy to the image, the function does not wait for the copy
+ * to complete. Returns false if the frame doesn't match the ring or if all
+ * slots are held by the consumer, the frame is then dropped.
+ *
+ * Can be called from any thread, only one thread at a time.
+ *
+ * @ingroup aux_vk
+ */
+bool
+vk_frame_upload_ring_upload(struct vk_bundle *vk, struct vk_frame_upload_ring *ring, struct xrt_frame *xf);
+
+/*!
+ * Get the latest submitted upload, the slot is held until given back with
+ * @ref vk_frame_upload_ring_release. Without timeline semaphores only
+ * completed uploads are returned, so it never stalls either way.
+ *
+ * @ingroup aux_vk
+ */
+bool
+vk_frame_upload_ring_acquire_latest(struct vk_bundle *vk,
+                                    struct vk_frame_upload_ring *ring,
+                                    struct vk_frame_upload *out_upload);
+
+/*!
+ * Give back a slot, the gpu work reading the image must have completed.
+ *
+ * @ingroup aux_vk
+ */
+void
+vk_frame_upload_ring_release(struct vk_frame_upload_ring *ring, uint32_t index);
+
+/*!
+ * Destroy the ring, waits for any uploads in flight.
+ *
+ * @ingroup aux_vk
+ */
+void
+vk_frame_upload_ring_destroy(struct vk_bundle *vk, struct vk_frame_upload_ring **ring_ptr);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -553,6 +553,45 @@ vk_get_memory_type(struct vk_bundle *vk, uint32_t type_bits, VkMemoryPropertyFla
 	return false;
 }
 
+VkResult
+vk_get_memory_budget(struct vk_bundle *vk, uint64_t *out_budget, uint64_t *out_usage)
+{
+#ifdef VK_EXT_memory_budget
+	if (!vk->has_EXT_memory_budget) {
+		return VK_ERROR_EXTENSION_NOT_PRESENT;
+	}
+
+	VkPhysicalDeviceMemoryBudgetPropertiesEXT budget_props = {
+	    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT,
+	};
+
+	VkPhysicalDeviceMemoryProperties2 props = {
+	    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2,
+	    .pNext = &budget_props,
+	};
+
+	vk->vkGetPhysicalDeviceMemoryProperties2(vk->physical_device, &props);
+
+	uint64_t budget = 0;
+	uint64_t usage = 0;
+	for (uint32_t i = 0; i < props.memoryProperties.memoryHeapCount; i++) {
+		if ((props.memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) == 0) {
+			continue;
+		}
+
+		budget += budget_props.heapBudget[i];
+		usage += budget_props.heapUsage[i];
+	}
+
+	*out_budget = budget;
+	*out_usage = usage;
+
+	return VK_SUCCESS;
+#else
+	return VK_ERROR_EXTENSION_NOT_PRESENT;
+#endif
+}
+
 XRT_CHECK_RESULT VkResult
 vk_alloc_and_bind_image_memory(struct vk_bundle *vk,
                                VkImage image,
@@ -1411,3 +1450,37 @@ vk_cmd_image_barrier_gpu_locked(struct vk_bundle *vk,
 	    VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, // dst_stage_mask
 	    subresource_range);                 // subresource_range
 }
+
+void
+vk_cmd_image_barrier_acquire_external_locked(struct vk_bundle *vk,
+                                             VkCommandBuffer cmd_buffer,
+                                             VkImage image,
+                                             VkAccessFlags dst_access_mask,
+                                             VkImageLayout layout,
+                                             VkPipelineStageFlags dst_stage_mask,
+                                             VkImageSubresourceRange subresource_range)
+{
+	VkImageMemoryBarrier image_memory_barrier = {
+	    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+	    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_EXTERNAL,
+	    .dstQueueFamilyIndex = vk->queue_family_index,
+	    .srcAccessMask = 0, // Ignored for acquire operations.
+	    .dstAccessMask = dst_access_mask,
+	    .oldLayout = layout,
+	    .newLayout = layout,
+	    .image = image,
+	    .subresourceRange = subresource_range,
+	};
+
+	vk->vkCmdPipelineBarrier(              //
+	    cmd_buffer,                        // commandBuffer
+	    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, // srcStageMask
+	    dst_stage_mask,                    // dstStageMask
+	    0,                                 // dependencyFlags
+	    0,                                 // memoryBarrierCount
+	    NULL,                              // pMemoryBarriers
+	    0,                                 // bufferMemoryBarrierCount
+	    NULL,                              // pBufferMemoryBarriers
+	    1,                                 // imageMemoryBarrierCount
+	    &image_memory_barrier);            // pImageMemoryBarriers
+}
@@ -135,6 +135,7 @@ struct vk_bundle
 	bool has_EXT_external_memory_dma_buf;
 	bool has_EXT_global_priority;
 	bool has_EXT_image_drm_format_modifier;
+	bool has_EXT_memory_budget;
 	bool has_EXT_robustness2;
 	bool has_GOOGLE_display_timing;
 	// end of GENERATED device extension code - do not modify - used by scripts
@@ -187,6 +188,7 @@ struct vk_bundle
 	PFN_vkGetPhysicalDeviceProperties2 vkGetPhysicalDeviceProperties2;
 	PFN_vkGetPhysicalDeviceFeatures2 vkGetPhysicalDeviceFeatures2;
 	PFN_vkGetPhysicalDeviceMemoryProperties vkGetPhysicalDeviceMemoryProperties;
+	PFN_vkGetPhysicalDeviceMemoryProperties2 vkGetPhysicalDeviceMemoryProperties2;
 	PFN_vkGetPhysicalDeviceQueueFamilyProperties vkGetPhysicalDeviceQueueFamilyProperties;
 	PFN_vkGetPhysicalDeviceSurfaceCapabilitiesKHR vkGetPhysicalDeviceSurfaceCapabilitiesKHR;
 	PFN_vkGetPhysicalDeviceSurfaceFormatsKHR vkGetPhysicalDeviceSurfaceFormatsKHR;
@@ -330,6 +332,7 @@ struct vk_bundle
 
 	PFN_vkCreatePipelineCache vkCreatePipelineCache;
 	PFN_vkDestroyPipelineCache vkDestroyPipelineCache;
+	PFN_vkGetPipelineCacheData vkGetPipelineCacheData;
 
 	PFN_vkResetDescriptorPool vkResetDescriptorPool;
 	PFN_vkCreateDescriptorPool vkCreateDescriptorPool;
@@ -814,6 +817,20 @@ vk_init_from_given(struct vk_bundle *vk,
 bool
 vk_get_memory_type(struct vk_bundle *vk, uint32_t type_bits, VkMemoryPropertyFlags memory_props, uint32_t *out_type_id);
 
+/*!
+ * Get how much device local memory this process may use before the driver
+ * starts to evict or fail allocations, and how much it is using now, summed
+ * over all device local heaps. Includes memory allocated by other processes
+ * from memory exported by this one, like swapchain images.
+ *
+ * Requires VK_EXT_memory_budget, returns VK_ERROR_EXTENSION_NOT_PRESENT
+ * without it.
+ *
+ * @ingroup aux_vk
+ */
+VkResult
+vk_get_memory_budget(struct vk_bundle *vk, uint64_t *out_budget, uint64_t *out_usage);
+
 /*!
  * Allocate memory for an image and bind it to that image.
  *
@@ -1077,6 +1094,25 @@ vk_cmd_image_barrier_gpu_locked(struct vk_bundle *vk,
                                 VkImageLayout new_layout,
                                 VkImageSubresourceRange subresource_range);
 
+/*!
+ * Inserts a barrier that acquires ownership of a image, that was released to
+ * `VK_QUEUE_FAMILY_EXTERNAL` by another device or API, to the queue family of
+ * the bundle. The image stays in @p layout. Needed when the image is used on a
+ * queue family other than the one that produced it, like a compute only queue
+ * consuming images rendered by an application on a graphics queue. Doesn't
+ * take any locks, same rules as @ref vk_cmd_image_barrier_locked.
+ *
+ * @ingroup aux_vk
+ */
+void
+vk_cmd_image_barrier_acquire_external_locked(struct vk_bundle *vk,
+                                             VkCommandBuffer cmd_buffer,
+                                             VkImage image,
+                                             VkAccessFlags dst_access_mask,
+                                             VkImageLayout layout,
+                                             VkPipelineStageFlags dst_stage_mask,
+                                             VkImageSubresourceRange subresource_range);
+
 
 /*
  *
@@ -1140,6 +1176,26 @@ vk_create_pipeline_layout(struct vk_bundle *vk,
 VkResult
 vk_create_pipeline_cache(struct vk_bundle *vk, VkPipelineCache *out_pipeline_cache);
 
+/*!
+ * Creates a pipeline cache, seeded with the data saved by
+ * @ref vk_save_pipeline_cache under the same @p name if it was saved for the
+ * same device and driver. Falls back to a empty cache, can be turned off with
+ * the env variable `XRT_VK_PIPELINE_CACHE_DISK`.
+ *
+ * Does error logging.
+ */
+VkResult
+vk_create_pipeline_cache_from_disk(struct vk_bundle *vk, const char *name, VkPipelineCache *out_pipeline_cache);
+
+/*!
+ * Saves the contents of the pipeline cache to the cache directory, the XDG
+ * cache dir or the application cache dir on Android.
+ *
+ * Does error logging.
+ */
+void
+vk_save_pipeline_cache(struct vk_bundle *vk, VkPipelineCache pipeline_cache, const char *name);
+
 /*!
  * Creates a compute pipeline, assumes entry function is called 'main'.
  *
@@ -89,14 +89,15 @@ create_image(struct vk_bundle *vk, const struct xrt_swapchain_create_info *info,
 	};
 
 	ret = vk->vkGetAndroidHardwareBufferPropertiesANDROID(vk->device, a_buffer, &a_buffer_props);
+
+	//! @todo Actually use this buffer for something other then getting the format.
+	// Goes back to the pool, so the next image of this swapchain gets the same buffer.
+	ahardwarebuffer_image_release(&a_buffer);
+
 	if (ret != VK_SUCCESS) {
 		U_LOG_E("vkGetAndroidHardwareBufferPropertiesANDROID: %s", vk_result_string(ret));
 		return ret;
 	}
-
-	//! @todo Actually use this buffer for something other then getting the format.
-	// Does null-check, validity check and clears.
-	u_graphics_buffer_unref(&a_buffer);
 #endif
 
 	/*
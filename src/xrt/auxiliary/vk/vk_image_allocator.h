@@ -48,6 +48,10 @@ struct vk_image_collection
 /*!
  * Allocates image(s) using the information specified in the swapchain create
  * info.
+ *
+ * Each image gets its own exportable `VkDeviceMemory`, the memory is handed to
+ * clients as one native handle per image without any offset, so the images
+ * can not be suballocated from a shared allocation.
  */
 VkResult
 vk_ic_allocate(struct vk_bundle *vk,
@@ -9,8 +9,168 @@
  * @ingroup aux_vk
  */
 
+#include "xrt/xrt_config_os.h"
+
+#include "util/u_debug.h"
+#include "util/u_file.h"
+
 #include "vk/vk_helpers.h"
 
+#ifdef XRT_OS_ANDROID
+#include "android/android_globals.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+DEBUG_GET_ONCE_BOOL_OPTION(pipeline_cache_disk, "XRT_VK_PIPELINE_CACHE_DISK", true)
+
+//! "MVPC" in little endian.
+#define PIPELINE_CACHE_MAGIC (0x4350564d)
+#define PIPELINE_CACHE_VERSION (1)
+
+/*!
+ * Written before the data from vkGetPipelineCacheData, some drivers don't
+ * cope well with data from other drivers so we validate it ourselves.
+ */
+struct pipeline_cache_file_header
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t vendor_id;
+	uint32_t device_id;
+	uint32_t driver_version;
+	uint32_t padding;
+	uint8_t pipeline_cache_uuid[VK_UUID_SIZE];
+	uint64_t data_size;
+	uint64_t data_hash;
+};
+
+
+/*
+ *
+ * Pipeline cache file helpers.
+ *
+ */
+
+//! FNV-1a, catches truncated and partially written files.
+static uint64_t
+hash_data(const uint8_t *data, size_t size)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= data[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+static void
+fill_in_header(struct vk_bundle *vk, struct pipeline_cache_file_header *header)
+{
+	VkPhysicalDeviceProperties pdp;
+	vk->vkGetPhysicalDeviceProperties(vk->physical_device, &pdp);
+
+	header->magic = PIPELINE_CACHE_MAGIC;
+	header->version = PIPELINE_CACHE_VERSION;
+	header->vendor_id = pdp.vendorID;
+	header->device_id = pdp.deviceID;
+	header->driver_version = pdp.driverVersion;
+	memcpy(header->pipeline_cache_uuid, pdp.pipelineCacheUUID, VK_UUID_SIZE);
+}
+
+static FILE *
+open_cache_file(const char *name, const char *mode)
+{
+	char filename[256];
+	int ret = snprintf(filename, sizeof(filename), "vk_pipeline_cache_%s.bin", name);
+	if (ret <= 0 || ret >= (int)sizeof(filename)) {
+		return NULL;
+	}
+
+#if defined(XRT_OS_ANDROID)
+	char dir[1024];
+	ssize_t i = android_globals_get_cache_dir(dir, sizeof(dir));
+	if (i <= 0 || i >= (ssize_t)sizeof(dir)) {
+		return NULL;
+	}
+
+	char path[1024 + 256];
+	ret = snprintf(path, sizeof(path), "%s/%s", dir, filename);
+	if (ret <= 0 || ret >= (int)sizeof(path)) {
+		return NULL;
+	}
+
+	return fopen(path, mode);
+#elif defined(XRT_OS_LINUX)
+	return u_file_open_file_in_cache_dir(filename, mode);
+#else
+	return NULL;
+#endif
+}
+
+//! Returns the validated cache data, or NULL, free with free().
+static uint8_t *
+read_cache_file(struct vk_bundle *vk, const char *name, size_t *out_size)
+{
+	struct pipeline_cache_file_header expected = {0};
+	struct pipeline_cache_file_header header = {0};
+	uint8_t *data = NULL;
+
+	FILE *file = open_cache_file(name, "rb");
+	if (file == NULL) {
+		return NULL;
+	}
+
+	fill_in_header(vk, &expected);
+
+	if (fread(&header, sizeof(header), 1, file) != 1) {
+		goto err_close;
+	}
+
+	bool valid = header.magic == expected.magic &&                   //
+	             header.version == expected.version &&               //
+	             header.vendor_id == expected.vendor_id &&           //
+	             header.device_id == expected.device_id &&           //
+	             header.driver_version == expected.driver_version && //
+	             memcmp(header.pipeline_cache_uuid, expected.pipeline_cache_uuid, VK_UUID_SIZE) == 0;
+	if (!valid) {
+		VK_DEBUG(vk, "Pipeline cache '%s' is for a different device or driver, ignoring", name);
+		goto err_close;
+	}
+
+	if (header.data_size == 0 || header.data_size > (64 * 1024 * 1024)) {
+		VK_WARN(vk, "Pipeline cache '%s' has a bogus size, ignoring", name);
+		goto err_close;
+	}
+
+	data = malloc(header.data_size);
+	if (data == NULL) {
+		goto err_close;
+	}
+
+	if (fread(data, header.data_size, 1, file) != 1 || hash_data(data, header.data_size) != header.data_hash) {
+		VK_WARN(vk, "Pipeline cache '%s' is corrupt, ignoring", name);
+		goto err_free;
+	}
+
+	fclose(file);
+
+	*out_size = header.data_size;
+
+	return data;
+
+err_free:
+	free(data);
+err_close:
+	fclose(file);
+
+	return NULL;
+}
+
+
 
 VkResult
 vk_create_descriptor_pool(struct vk_bundle *vk,
@@ -168,6 +328,98 @@ vk_create_pipeline_cache(struct vk_bundle *vk, VkPipelineCache *out_pipeline_cac
 	return VK_SUCCESS;
 }
 
+VkResult
+vk_create_pipeline_cache_from_disk(struct vk_bundle *vk, const char *name, VkPipelineCache *out_pipeline_cache)
+{
+	VkResult ret;
+	size_t size = 0;
+	uint8_t *data = NULL;
+
+	if (debug_get_bool_option_pipeline_cache_disk()) {
+		data = read_cache_file(vk, name, &size);
+	}
+
+	VkPipelineCacheCreateInfo pipeline_cache_info = {
+	    .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+	    .initialDataSize = size,
+	    .pInitialData = data,
+	};
+
+	VkPipelineCache pipeline_cache;
+	ret = vk->vkCreatePipelineCache( //
+	    vk->device,                  // device
+	    &pipeline_cache_info,        // pCreateInfo
+	    NULL,                        // pAllocator
+	    &pipeline_cache);            // pPipelineCache
+
+	free(data);
+
+	if (ret != VK_SUCCESS && size > 0) {
+		VK_WARN(vk, "vkCreatePipelineCache with '%s' data failed: %s", name, vk_result_string(ret));
+		return vk_create_pipeline_cache(vk, out_pipeline_cache);
+	}
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkCreatePipelineCache failed: %s", vk_result_string(ret));
+		return ret;
+	}
+
+	if (size > 0) {
+		VK_DEBUG(vk, "Loaded pipeline cache '%s' (%zu bytes)", name, size);
+	}
+
+	*out_pipeline_cache = pipeline_cache;
+
+	return VK_SUCCESS;
+}
+
+void
+vk_save_pipeline_cache(struct vk_bundle *vk, VkPipelineCache pipeline_cache, const char *name)
+{
+	VkResult ret;
+	size_t size = 0;
+
+	if (pipeline_cache == VK_NULL_HANDLE || !debug_get_bool_option_pipeline_cache_disk()) {
+		return;
+	}
+
+	ret = vk->vkGetPipelineCacheData(vk->device, pipeline_cache, &size, NULL);
+	if (ret != VK_SUCCESS || size == 0) {
+		VK_ERROR(vk, "vkGetPipelineCacheData failed: %s", vk_result_string(ret));
+		return;
+	}
+
+	uint8_t *data = malloc(size);
+	if (data == NULL) {
+		return;
+	}
+
+	ret = vk->vkGetPipelineCacheData(vk->device, pipeline_cache, &size, data);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkGetPipelineCacheData failed: %s", vk_result_string(ret));
+		free(data);
+		return;
+	}
+
+	struct pipeline_cache_file_header header = {0};
+	fill_in_header(vk, &header);
+	header.data_size = size;
+	header.data_hash = hash_data(data, size);
+
+	FILE *file = open_cache_file(name, "wb");
+	if (file == NULL) {
+		VK_DEBUG(vk, "Could not open pipeline cache '%s' for writing", name);
+		free(data);
+		return;
+	}
+
+	if (fwrite(&header, sizeof(header), 1, file) != 1 || fwrite(data, size, 1, file) != 1) {
+		VK_WARN(vk, "Failed to write pipeline cache '%s'", name);
+	}
+
+	fclose(file);
+	free(data);
+}
+
 VkResult
 vk_create_compute_pipeline(struct vk_bundle *vk,
                            VkPipelineCache pipeline_cache,
@@ -44,6 +44,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <chrono>
+#include <deque>
+#include <mutex>
 
 using namespace std::chrono_literals;
 using namespace std::chrono;
@@ -51,6 +53,7 @@ using namespace std::chrono;
 using xrt::compositor::client::unique_swapchain_ref;
 
 DEBUG_GET_ONCE_LOG_OPTION(log, "D3D_COMPOSITOR_LOG", U_LOGGING_INFO)
+DEBUG_GET_ONCE_NUM_OPTION(swapchain_pool_size, "D3D_SWAPCHAIN_POOL_SIZE", 4)
 
 /*!
  * Spew level logging.
@@ -97,6 +100,8 @@ static constexpr uint64_t kKeyedMutexKey = 0;
 // Timeout to wait for completion
 static constexpr auto kFenceTimeout = 500ms;
 
+struct client_d3d11_swapchain_pool;
+
 /*!
  * @class client_d3d11_compositor
  *
@@ -165,12 +170,14 @@ struct client_d3d11_compositor
 	 * The value most recently signaled on the timeline semaphore
 	 */
 	uint64_t timeline_semaphore_value = 0;
+
+	//! Backings of destroyed swapchains for reuse.
+	std::unique_ptr<client_d3d11_swapchain_pool> swapchain_pool;
 };
 
 static_assert(std::is_standard_layout<client_d3d11_compositor>::value);
 
 struct client_d3d11_swapchain;
-
 static inline DWORD
 convertTimeoutToWindowsMilliseconds(uint64_t timeout_ns)
 {
@@ -187,6 +194,12 @@ struct client_d3d11_swapchain_data
 
 	xrt::compositor::client::KeyedMutexCollection keyed_mutex_collection;
 
+	/*!
+	 * Are the images synchronized with keyed mutexes, not needed when the
+	 * native compositor waits on client_d3d11_compositor::timeline_semaphore.
+	 */
+	bool use_keyed_mutex = true;
+
 	//! The shared DXGI handles for our images
 	std::vector<HANDLE> dxgi_handles;
 
@@ -195,6 +208,12 @@ struct client_d3d11_swapchain_data
 
 	//! Images associated with client_d3d11_compositor::comp_device
 	std::vector<wil::com_ptr<ID3D11Texture2D1>> comp_images;
+
+	//! Create info the images were allocated with, after adding the extra bits.
+	struct xrt_swapchain_create_info xinfo = {};
+
+	//! Images acquired and not yet released by the app.
+	uint32_t held_images = 0;
 };
 
 /*!
@@ -219,6 +238,37 @@ struct client_d3d11_swapchain
 
 static_assert(std::is_standard_layout<client_d3d11_swapchain>::value);
 
+/*!
+ * The backing of a destroyed swapchain: the shared textures, their imports on
+ * the app device and the swapchain imported into the native compositor.
+ */
+struct client_d3d11_pooled_swapchain
+{
+	struct xrt_swapchain_create_info xinfo;
+	uint32_t image_count;
+
+	unique_swapchain_ref xsc;
+	std::unique_ptr<client_d3d11_swapchain_data> data;
+};
+
+/*!
+ * Destroyed swapchains kept around, so that a new swapchain with the same
+ * description takes one over instead of allocating and importing everything
+ * again. Apps that resize or change resolution often go back and forth between
+ * a few sizes. The backings are only released when pushed out of the pool or
+ * when the compositor is destroyed.
+ */
+struct client_d3d11_swapchain_pool
+{
+	std::mutex mutex;
+
+	//! Oldest first.
+	std::deque<client_d3d11_pooled_swapchain> entries;
+
+	//! Max number of entries, zero disables the pool.
+	size_t max_size = 0;
+};
+
 /*!
  * Down-cast helper.
  * @private @memberof client_d3d11_swapchain
@@ -272,7 +322,12 @@ client_d3d11_swapchain_acquire_image(struct xrt_swapchain *xsc, uint32_t *out_in
 	struct client_d3d11_swapchain *sc = as_client_d3d11_swapchain(xsc);
 
 	// Pipe down call into imported swapchain in native compositor.
-	return xrt_swapchain_acquire_image(sc->xsc.get(), out_index);
+	xrt_result_t xret = xrt_swapchain_acquire_image(sc->xsc.get(), out_index);
+	if (xret == XRT_SUCCESS) {
+		sc->data->held_images++;
+	}
+
+	return xret;
 }
 
 static xrt_result_t
@@ -283,7 +338,7 @@ client_d3d11_swapchain_wait_image(struct xrt_swapchain *xsc, uint64_t timeout_ns
 	// Pipe down call into imported swapchain in native compositor.
 	xrt_result_t xret = xrt_swapchain_wait_image(sc->xsc.get(), timeout_ns, index);
 
-	if (xret == XRT_SUCCESS) {
+	if (xret == XRT_SUCCESS && sc->data->use_keyed_mutex) {
 		// OK, we got the image in the native compositor, now need the keyed mutex in d3d11.
 		xret = sc->data->keyed_mutex_collection.waitKeyedMutex(index, timeout_ns);
 	}
@@ -307,6 +362,10 @@ client_d3d11_swapchain_release_image(struct xrt_swapchain *xsc, uint32_t index)
 	xrt_result_t xret = xrt_swapchain_release_image(sc->xsc.get(), index);
 
 	if (xret == XRT_SUCCESS) {
+		sc->data->held_images--;
+	}
+
+	if (xret == XRT_SUCCESS && sc->data->use_keyed_mutex) {
 		// Release the keyed mutex
 		xret = sc->data->keyed_mutex_collection.releaseKeyedMutex(index);
 	}
@@ -316,8 +375,26 @@ client_d3d11_swapchain_release_image(struct xrt_swapchain *xsc, uint32_t index)
 static void
 client_d3d11_swapchain_destroy(struct xrt_swapchain *xsc)
 {
-	// letting destruction do it all
 	std::unique_ptr<client_d3d11_swapchain> sc(as_client_d3d11_swapchain(xsc));
+	client_d3d11_swapchain_pool *pool = sc->c->swapchain_pool.get();
+
+	// Images still held by the app are in an unknown state, let destruction do it all.
+	if (pool->max_size == 0 || sc->data->held_images != 0) {
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(pool->mutex);
+
+	pool->entries.push_back({sc->data->xinfo, sc->base.base.image_count, std::move(sc->xsc), std::move(sc->data)});
+
+	// Release the oldest ones outside of the lock.
+	std::deque<client_d3d11_pooled_swapchain> evicted;
+	while (pool->entries.size() > pool->max_size) {
+		evicted.push_back(std::move(pool->entries.front()));
+		pool->entries.pop_front();
+	}
+
+	lock.unlock();
 }
 
 /*
@@ -350,6 +427,48 @@ import_image_dxgi(ID3D11Device1 &device, HANDLE h)
 	return tex;
 }
 
+static bool
+is_same_swapchain_info(const struct xrt_swapchain_create_info &a, const struct xrt_swapchain_create_info &b)
+{
+	return a.create == b.create &&             //
+	       a.bits == b.bits &&                 //
+	       a.format == b.format &&             //
+	       a.sample_count == b.sample_count && //
+	       a.width == b.width &&               //
+	       a.height == b.height &&             //
+	       a.face_count == b.face_count &&     //
+	       a.array_size == b.array_size &&     //
+	       a.mip_count == b.mip_count;
+}
+
+/*!
+ * Takes the backing of a destroyed swapchain with the same description out of
+ * the pool, returns false if there is none.
+ */
+static bool
+take_pooled_swapchain(struct client_d3d11_compositor *c,
+                      const struct xrt_swapchain_create_info &xinfo,
+                      uint32_t image_count,
+                      client_d3d11_swapchain &sc)
+{
+	client_d3d11_swapchain_pool *pool = c->swapchain_pool.get();
+	std::unique_lock<std::mutex> lock(pool->mutex);
+
+	// Newest first, the most likely to be asked for again.
+	for (auto it = pool->entries.rbegin(); it != pool->entries.rend(); ++it) {
+		if (it->image_count != image_count || !is_same_swapchain_info(it->xinfo, xinfo)) {
+			continue;
+		}
+
+		sc.xsc = std::move(it->xsc);
+		sc.data = std::move(it->data);
+		pool->entries.erase(std::next(it).base());
+		return true;
+	}
+
+	return false;
+}
+
 static wil::com_ptr<ID3D11Fence>
 import_fence(ID3D11Device5 &device, HANDLE h)
 {
@@ -363,6 +482,70 @@ import_fence(ID3D11Device5 &device, HANDLE h)
 }
 
 
+/*!
+ * Allocates the shared images of a new swapchain, imports them on the app device
+ * and into the native compositor.
+ */
+static xrt_result_t
+client_d3d11_swapchain_allocate(struct client_d3d11_compositor *c,
+                                const struct xrt_swapchain_create_info &xinfo,
+                                const struct xrt_swapchain_create_info &vkinfo,
+                                uint32_t image_count,
+                                client_d3d11_swapchain &sc)
+{
+	xrt_result_t xret = XRT_SUCCESS;
+
+	sc.data = std::make_unique<client_d3d11_swapchain_data>(c->log_level);
+	sc.data->xinfo = xinfo;
+
+	/*
+	 * The native compositor waits on the timeline semaphore value of the
+	 * commit before reading the images, so the keyed mutexes would only
+	 * add an acquire and release per image every frame.
+	 */
+	sc.data->use_keyed_mutex = !c->timeline_semaphore;
+
+	xret = xrt::auxiliary::d3d::d3d11::allocateSharedImages(*(c->comp_device), xinfo, image_count,
+	                                                        sc.data->use_keyed_mutex, sc.data->comp_images,
+	                                                        sc.data->dxgi_handles);
+	if (xret != XRT_SUCCESS) {
+		return xret;
+	}
+
+	sc.data->app_images.reserve(image_count);
+
+	// Import from the handle for the app.
+	for (uint32_t i = 0; i < image_count; ++i) {
+		wil::com_ptr<ID3D11Texture2D1> image = import_image_dxgi(*(c->app_device), sc.data->dxgi_handles[i]);
+
+		// Put the image where the OpenXR state tracker can get it
+		sc.base.images[i] = image.get();
+
+		// Store the owning pointer for lifetime management
+		sc.data->app_images.emplace_back(std::move(image));
+	}
+
+	// Cache the keyed mutex interface
+	if (sc.data->use_keyed_mutex) {
+		xret = sc.data->keyed_mutex_collection.init(sc.data->app_images);
+		if (xret != XRT_SUCCESS) {
+			D3D_ERROR(c, "Error retrieving keyex mutex interfaces");
+			return xret;
+		}
+	}
+
+	// Import into the native compositor, to create the corresponding swapchain which we wrap.
+	xret = xrt::compositor::client::importFromDxgiHandles(
+	    *(c->xcn), sc.data->dxgi_handles, vkinfo, false /** @todo not sure - dedicated allocation */, sc.xsc);
+
+	if (xret != XRT_SUCCESS) {
+		D3D_ERROR(c, "Error importing D3D11 swapchain into native compositor");
+		return xret;
+	}
+
+	return XRT_SUCCESS;
+}
+
 xrt_result_t
 client_d3d11_create_swapchain(struct xrt_compositor *xc,
                               const struct xrt_swapchain_create_info *info,
@@ -402,41 +585,18 @@ try {
 	vkinfo.bits = (enum xrt_swapchain_usage_bits)(xsccp.extra_bits | vkinfo.bits);
 
 	std::unique_ptr<struct client_d3d11_swapchain> sc = std::make_unique<struct client_d3d11_swapchain>();
-	sc->data = std::make_unique<client_d3d11_swapchain_data>(c->log_level);
-	auto &data = sc->data;
-	xret = xrt::auxiliary::d3d::d3d11::allocateSharedImages(*(c->comp_device), xinfo, image_count, true,
-	                                                        data->comp_images, data->dxgi_handles);
-	if (xret != XRT_SUCCESS) {
-		return xret;
-	}
-
-	data->app_images.reserve(image_count);
-
-	// Import from the handle for the app.
-	for (uint32_t i = 0; i < image_count; ++i) {
-		wil::com_ptr<ID3D11Texture2D1> image = import_image_dxgi(*(c->app_device), data->dxgi_handles[i]);
-
-		// Put the image where the OpenXR state tracker can get it
-		sc->base.images[i] = image.get();
-
-		// Store the owning pointer for lifetime management
-		data->app_images.emplace_back(std::move(image));
-	}
 
-	// Cache the keyed mutex interface
-	xret = data->keyed_mutex_collection.init(data->app_images);
-	if (xret != XRT_SUCCESS) {
-		D3D_ERROR(c, "Error retrieving keyex mutex interfaces");
-		return xret;
-	}
+	if (take_pooled_swapchain(c, xinfo, image_count, *sc)) {
+		D3D_DEBUG(c, "Reusing the images of a destroyed swapchain");
 
-	// Import into the native compositor, to create the corresponding swapchain which we wrap.
-	xret = xrt::compositor::client::importFromDxgiHandles(
-	    *(c->xcn), data->dxgi_handles, vkinfo, false /** @todo not sure - dedicated allocation */, sc->xsc);
-
-	if (xret != XRT_SUCCESS) {
-		D3D_ERROR(c, "Error importing D3D11 swapchain into native compositor");
-		return xret;
+		for (uint32_t i = 0; i < image_count; ++i) {
+			sc->base.images[i] = sc->data->app_images[i].get();
+		}
+	} else {
+		xret = client_d3d11_swapchain_allocate(c, xinfo, vkinfo, image_count, *sc);
+		if (xret != XRT_SUCCESS) {
+			return xret;
+		}
 	}
 
 	sc->base.base.destroy = client_d3d11_swapchain_destroy;
@@ -727,6 +887,9 @@ static void
 client_d3d11_compositor_destroy(struct xrt_compositor *xc)
 {
 	std::unique_ptr<struct client_d3d11_compositor> c{as_client_d3d11_compositor(xc)};
+
+	// Release the pooled swapchains while the native compositor is still around.
+	c->swapchain_pool.reset();
 }
 
 static void
@@ -799,6 +962,8 @@ try {
 	std::unique_ptr<struct client_d3d11_compositor> c = std::make_unique<struct client_d3d11_compositor>();
 	c->log_level = debug_get_log_option_log();
 	c->xcn = xcn;
+	c->swapchain_pool = std::make_unique<client_d3d11_swapchain_pool>();
+	c->swapchain_pool->max_size = (size_t)debug_get_num_option_swapchain_pool_size();
 
 	wil::com_ptr<ID3D11Device> app_dev{device};
 	if (!app_dev.try_query_to(c->app_device.put())) {
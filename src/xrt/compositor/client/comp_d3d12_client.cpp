@@ -189,6 +189,12 @@ struct client_d3d12_swapchain_data
 
 	xrt::compositor::client::KeyedMutexCollection keyed_mutex_collection;
 
+	/*!
+	 * Are the images synchronized with keyed mutexes, not needed when the
+	 * native compositor waits on client_d3d12_compositor::timeline_semaphore.
+	 */
+	bool use_keyed_mutex = true;
+
 	//! The shared DXGI handles for our images
 	std::vector<HANDLE> dxgi_handles;
 
@@ -353,7 +359,7 @@ client_d3d12_swapchain_wait_image(struct xrt_swapchain *xsc, uint64_t timeout_ns
 	// Pipe down call into imported swapchain in native compositor.
 	xrt_result_t xret = xrt_swapchain_wait_image(sc->xsc.get(), timeout_ns, index);
 
-	if (xret == XRT_SUCCESS) {
+	if (xret == XRT_SUCCESS && sc->data->use_keyed_mutex) {
 		// OK, we got the image in the native compositor, now need the keyed mutex in d3d11.
 		xret = sc->data->keyed_mutex_collection.waitKeyedMutex(index, timeout_ns);
 	}
@@ -385,7 +391,7 @@ client_d3d12_swapchain_release_image(struct xrt_swapchain *xsc, uint32_t index)
 	// Pipe down call into imported swapchain in native compositor.
 	xrt_result_t xret = xrt_swapchain_release_image(sc->xsc.get(), index);
 
-	if (xret == XRT_SUCCESS) {
+	if (xret == XRT_SUCCESS && sc->data->use_keyed_mutex) {
 		// Release the keyed mutex
 		xret = sc->data->keyed_mutex_collection.releaseKeyedMutex(index);
 	}
@@ -459,9 +465,17 @@ try {
 	sc->data = std::make_unique<client_d3d12_swapchain_data>(c->log_level);
 	auto &data = sc->data;
 
+	/*
+	 * The native compositor waits on the timeline semaphore value of the
+	 * commit before reading the images, so the keyed mutexes would only
+	 * add an acquire and release per image every frame.
+	 */
+	data->use_keyed_mutex = !c->timeline_semaphore;
+
 	// Make images with D3D11
-	xret = xrt::auxiliary::d3d::d3d11::allocateSharedImages(*(c->d3d11_device), xinfo, image_count, true,
-	                                                        data->d3d11_images, data->dxgi_handles);
+	xret = xrt::auxiliary::d3d::d3d11::allocateSharedImages(*(c->d3d11_device), xinfo, image_count,
+	                                                        data->use_keyed_mutex, data->d3d11_images,
+	                                                        data->dxgi_handles);
 	if (xret != XRT_SUCCESS) {
 		return xret;
 	}
@@ -544,10 +558,12 @@ try {
 	}
 
 	// Cache the keyed mutex interface
-	xret = data->keyed_mutex_collection.init(data->d3d11_images);
-	if (xret != XRT_SUCCESS) {
-		D3D_ERROR(c, "Error retrieving keyex mutex interfaces");
-		return xret;
+	if (data->use_keyed_mutex) {
+		xret = data->keyed_mutex_collection.init(data->d3d11_images);
+		if (xret != XRT_SUCCESS) {
+			D3D_ERROR(c, "Error retrieving keyex mutex interfaces");
+			return xret;
+		}
 	}
 
 	// Import into the native compositor, to create the corresponding swapchain which we wrap.
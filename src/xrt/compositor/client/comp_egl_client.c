@@ -187,17 +187,37 @@ ensure_native_fence_is_loaded(EGLDisplay dpy, PFNEGLGETPROCADDRESSPROC get_gl_pr
 	eglQueryStringImplementationANDROID =
 	    (PFNEGLQUERYSTRINGIMPLEMENTATIONANDROIDPROC)get_gl_procaddr("eglQueryStringImplementationANDROID");
 
-	// On Android, EGL_ANDROID_native_fence_sync only shows up in this
-	// extension list, not the normal one.
-	const char *ext = eglQueryStringImplementationANDROID(dpy, EGL_EXTENSIONS);
-	if (!has_extension(ext, "EGL_ANDROID_native_fence_sync")) {
+	// On Android, EGL_ANDROID_native_fence_sync often only shows up in
+	// this extension list, not the normal one, which glad has looked at.
+	if (!GLAD_EGL_ANDROID_native_fence_sync && eglQueryStringImplementationANDROID != NULL) {
+		const char *ext = eglQueryStringImplementationANDROID(dpy, EGL_EXTENSIONS);
+		GLAD_EGL_ANDROID_native_fence_sync = has_extension(ext, "EGL_ANDROID_native_fence_sync");
+	}
+
+	if (!GLAD_EGL_ANDROID_native_fence_sync) {
 		return;
 	}
 
-	GLAD_EGL_ANDROID_native_fence_sync = true;
-	glad_eglDupNativeFenceFDANDROID =
-	    (PFNEGLDUPNATIVEFENCEFDANDROIDPROC)get_gl_procaddr("eglDupNativeFenceFDANDROID");
+	// Same for the sync functions it builds on.
+	if (glad_eglDupNativeFenceFDANDROID == NULL) {
+		glad_eglDupNativeFenceFDANDROID =
+		    (PFNEGLDUPNATIVEFENCEFDANDROIDPROC)get_gl_procaddr("eglDupNativeFenceFDANDROID");
+	}
+	if (glad_eglCreateSyncKHR == NULL) {
+		glad_eglCreateSyncKHR = (PFNEGLCREATESYNCKHRPROC)get_gl_procaddr("eglCreateSyncKHR");
+	}
+	if (glad_eglDestroySyncKHR == NULL) {
+		glad_eglDestroySyncKHR = (PFNEGLDESTROYSYNCKHRPROC)get_gl_procaddr("eglDestroySyncKHR");
+	}
 #endif
+
+	// Without these every frame would silently fall back to glFinish.
+	if (GLAD_EGL_ANDROID_native_fence_sync &&
+	    (glad_eglDupNativeFenceFDANDROID == NULL || glad_eglCreateSyncKHR == NULL ||
+	     glad_eglDestroySyncKHR == NULL)) {
+		EGL_WARN("EGL_ANDROID_native_fence_sync is advertised but its functions are missing, not using it");
+		GLAD_EGL_ANDROID_native_fence_sync = false;
+	}
 }
 
 static xrt_result_t
@@ -410,7 +430,8 @@ client_egl_insert_fence(struct xrt_compositor *xc, xrt_graphics_sync_handle_t *o
 	*out_handle = fence_fd;
 
 #else
-	(void)cglc;
+	(void)ceglc;
+	(void)dpy;
 #endif
 
 	return XRT_SUCCESS;
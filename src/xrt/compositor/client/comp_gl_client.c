@@ -27,6 +27,7 @@
 
 #include "client/comp_gl_client.h"
 
+#include "util/u_handles.h"
 #include "util/u_logging.h"
 #include "util/u_trace_marker.h"
 
@@ -98,6 +99,111 @@ vk_format_to_gl(int64_t format)
 	}
 }
 
+/*!
+ * Imports a timeline semaphore from the native compositor, only tried once.
+ * Called with the right context made current.
+ */
+static bool
+setup_semaphore(struct client_gl_compositor *c)
+{
+	if (c->sync.tried) {
+		return c->sync.xcsem != NULL;
+	}
+	c->sync.tried = true;
+
+#if defined(XRT_GRAPHICS_SYNC_HANDLE_IS_FD) || defined(XRT_GRAPHICS_SYNC_HANDLE_IS_WIN32_HANDLE)
+	if (!GLAD_GL_EXT_semaphore || !GLAD_GL_NV_timeline_semaphore) {
+		return false;
+	}
+#if defined(XRT_GRAPHICS_SYNC_HANDLE_IS_FD)
+	if (!GLAD_GL_EXT_semaphore_fd) {
+		return false;
+	}
+#else
+	if (!GLAD_GL_EXT_semaphore_win32) {
+		return false;
+	}
+#endif
+
+	// Not all native compositors support semaphores.
+	if (c->xcn->base.create_semaphore == NULL) {
+		return false;
+	}
+
+	xrt_graphics_sync_handle_t handle = XRT_GRAPHICS_SYNC_HANDLE_INVALID;
+	struct xrt_compositor_semaphore *xcsem = NULL;
+
+	xrt_result_t xret = xrt_comp_create_semaphore(&c->xcn->base, &handle, &xcsem);
+	if (xret != XRT_SUCCESS) {
+		U_LOG_W("Failed to create semaphore, falling back to glFinish");
+		return false;
+	}
+
+	// Clear any old errors.
+	while (glGetError() != GL_NO_ERROR) {
+	}
+
+	// The type needs to be set before importing, so can't use glGenSemaphoresEXT.
+	GLuint semaphore = 0;
+	GLint type = GL_SEMAPHORE_TYPE_TIMELINE_NV;
+	glCreateSemaphoresNV(1, &semaphore);
+	glSemaphoreParameterivNV(semaphore, GL_SEMAPHORE_TYPE_NV, &type);
+
+#if defined(XRT_GRAPHICS_SYNC_HANDLE_IS_FD)
+	glImportSemaphoreFdEXT(semaphore, GL_HANDLE_TYPE_OPAQUE_FD_EXT, handle);
+#else
+	glImportSemaphoreWin32HandleEXT(semaphore, GL_HANDLE_TYPE_OPAQUE_WIN32_EXT, handle);
+#endif
+
+	GLenum err = glGetError();
+	if (err != GL_NO_ERROR) {
+		U_LOG_W("Failed to import semaphore (0x%04x), falling back to glFinish", err);
+		glDeleteSemaphoresEXT(1, &semaphore);
+		u_graphics_sync_unref(&handle);
+		xrt_compositor_semaphore_reference(&xcsem, NULL);
+		return false;
+	}
+
+#if defined(XRT_GRAPHICS_SYNC_HANDLE_IS_WIN32_HANDLE)
+	// Importing a handle doesn't transfer ownership of it, unlike a fd.
+	u_graphics_sync_unref(&handle);
+#endif
+
+	c->sync.gl_semaphore = semaphore;
+	c->sync.xcsem = xcsem; // No need to reference.
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+/*!
+ * Signals the next value of the timeline semaphore in the app's command
+ * stream, returns false if there is no semaphore to use.
+ * Called with the right context made current.
+ */
+static bool
+handle_semaphore(struct client_gl_compositor *c, uint64_t *out_value)
+{
+	if (!setup_semaphore(c)) {
+		return false;
+	}
+
+	COMP_TRACE_IDENT(signal_semaphore);
+
+	GLuint64 value = ++c->sync.value;
+	glSemaphoreParameterui64vEXT(c->sync.gl_semaphore, GL_TIMELINE_SEMAPHORE_VALUE_NV, &value);
+	glSignalSemaphoreEXT(c->sync.gl_semaphore, 0, NULL, 0, NULL, NULL);
+
+	// Make sure the signal gets submitted, the compositor waits on it.
+	glFlush();
+
+	*out_value = value;
+
+	return true;
+}
+
 /*!
  * Called with the right context made current.
  */
@@ -221,14 +327,47 @@ client_gl_compositor_discard_frame(struct xrt_compositor *xc, int64_t frame_id)
 	return xrt_comp_discard_frame(&c->xcn->base, frame_id);
 }
 
+/*!
+ * OpenGL has the origin in the bottom left, flip the layer data either in the
+ * storage of the native compositor, if it was handed out by layer_reserve, or
+ * into @p tmp.
+ */
+static const struct xrt_layer_data *
+flip_layer_data(struct client_gl_compositor *c, const struct xrt_layer_data *data, struct xrt_layer_data *tmp)
+{
+	struct xrt_layer_data *d = c->reserved_layer;
+	c->reserved_layer = NULL;
+
+	if (d != data) {
+		*tmp = *data;
+		d = tmp;
+	}
+
+	d->flip_y = !d->flip_y;
+
+	return d;
+}
+
 static xrt_result_t
 client_gl_compositor_layer_begin(struct xrt_compositor *xc, const struct xrt_layer_frame_data *data)
 {
 	struct client_gl_compositor *c = client_gl_compositor(xc);
 
+	c->reserved_layer = NULL;
+
 	return xrt_comp_layer_begin(&c->xcn->base, data);
 }
 
+static struct xrt_layer_data *
+client_gl_compositor_layer_reserve(struct xrt_compositor *xc)
+{
+	struct client_gl_compositor *c = client_gl_compositor(xc);
+
+	c->reserved_layer = xrt_comp_layer_reserve(&c->xcn->base);
+
+	return c->reserved_layer;
+}
+
 static xrt_result_t
 client_gl_compositor_layer_stereo_projection(struct xrt_compositor *xc,
                                              struct xrt_device *xdev,
@@ -245,10 +384,10 @@ client_gl_compositor_layer_stereo_projection(struct xrt_compositor *xc,
 	l_xscn = &client_gl_swapchain(l_xsc)->xscn->base;
 	r_xscn = &client_gl_swapchain(r_xsc)->xscn->base;
 
-	struct xrt_layer_data d = *data;
-	d.flip_y = !d.flip_y;
+	struct xrt_layer_data tmp;
+	const struct xrt_layer_data *d = flip_layer_data(c, data, &tmp);
 
-	return xrt_comp_layer_stereo_projection(&c->xcn->base, xdev, l_xscn, r_xscn, &d);
+	return xrt_comp_layer_stereo_projection(&c->xcn->base, xdev, l_xscn, r_xscn, d);
 }
 
 static xrt_result_t
@@ -273,10 +412,10 @@ client_gl_compositor_layer_stereo_projection_depth(struct xrt_compositor *xc,
 	l_d_xscn = &client_gl_swapchain(l_d_xsc)->xscn->base;
 	r_d_xscn = &client_gl_swapchain(r_d_xsc)->xscn->base;
 
-	struct xrt_layer_data d = *data;
-	d.flip_y = !d.flip_y;
+	struct xrt_layer_data tmp;
+	const struct xrt_layer_data *d = flip_layer_data(c, data, &tmp);
 
-	return xrt_comp_layer_stereo_projection_depth(&c->xcn->base, xdev, l_xscn, r_xscn, l_d_xscn, r_d_xscn, &d);
+	return xrt_comp_layer_stereo_projection_depth(&c->xcn->base, xdev, l_xscn, r_xscn, l_d_xscn, r_d_xscn, d);
 }
 
 static xrt_result_t
@@ -292,10 +431,10 @@ client_gl_compositor_layer_quad(struct xrt_compositor *xc,
 
 	xscfb = &client_gl_swapchain(xsc)->xscn->base;
 
-	struct xrt_layer_data d = *data;
-	d.flip_y = !d.flip_y;
+	struct xrt_layer_data tmp;
+	const struct xrt_layer_data *d = flip_layer_data(c, data, &tmp);
 
-	return xrt_comp_layer_quad(&c->xcn->base, xdev, xscfb, &d);
+	return xrt_comp_layer_quad(&c->xcn->base, xdev, xscfb, d);
 }
 
 static xrt_result_t
@@ -311,10 +450,10 @@ client_gl_compositor_layer_cube(struct xrt_compositor *xc,
 
 	xscfb = &client_gl_swapchain(xsc)->xscn->base;
 
-	struct xrt_layer_data d = *data;
-	d.flip_y = !d.flip_y;
+	struct xrt_layer_data tmp;
+	const struct xrt_layer_data *d = flip_layer_data(c, data, &tmp);
 
-	return xrt_comp_layer_cube(&c->xcn->base, xdev, xscfb, &d);
+	return xrt_comp_layer_cube(&c->xcn->base, xdev, xscfb, d);
 }
 
 static xrt_result_t
@@ -330,10 +469,10 @@ client_gl_compositor_layer_cylinder(struct xrt_compositor *xc,
 
 	xscfb = &client_gl_swapchain(xsc)->xscn->base;
 
-	struct xrt_layer_data d = *data;
-	d.flip_y = !d.flip_y;
+	struct xrt_layer_data tmp;
+	const struct xrt_layer_data *d = flip_layer_data(c, data, &tmp);
 
-	return xrt_comp_layer_cylinder(&c->xcn->base, xdev, xscfb, &d);
+	return xrt_comp_layer_cylinder(&c->xcn->base, xdev, xscfb, d);
 }
 
 static xrt_result_t
@@ -349,10 +488,10 @@ client_gl_compositor_layer_equirect1(struct xrt_compositor *xc,
 
 	xscfb = &client_gl_swapchain(xsc)->xscn->base;
 
-	struct xrt_layer_data d = *data;
-	d.flip_y = !d.flip_y;
+	struct xrt_layer_data tmp;
+	const struct xrt_layer_data *d = flip_layer_data(c, data, &tmp);
 
-	return xrt_comp_layer_equirect1(&c->xcn->base, xdev, xscfb, &d);
+	return xrt_comp_layer_equirect1(&c->xcn->base, xdev, xscfb, d);
 }
 
 static xrt_result_t
@@ -368,10 +507,10 @@ client_gl_compositor_layer_equirect2(struct xrt_compositor *xc,
 
 	xscfb = &client_gl_swapchain(xsc)->xscn->base;
 
-	struct xrt_layer_data d = *data;
-	d.flip_y = !d.flip_y;
+	struct xrt_layer_data tmp;
+	const struct xrt_layer_data *d = flip_layer_data(c, data, &tmp);
 
-	return xrt_comp_layer_equirect2(&c->xcn->base, xdev, xscfb, &d);
+	return xrt_comp_layer_equirect2(&c->xcn->base, xdev, xscfb, d);
 }
 
 static xrt_result_t
@@ -385,13 +524,27 @@ client_gl_compositor_layer_commit(struct xrt_compositor *xc, xrt_graphics_sync_h
 	assert(!xrt_graphics_sync_handle_is_valid(sync_handle));
 
 	sync_handle = XRT_GRAPHICS_SYNC_HANDLE_INVALID;
+	bool use_semaphore = false;
+	uint64_t value = 0;
 
 	xrt_result_t xret = client_gl_compositor_context_begin(xc, CLIENT_GL_CONTEXT_REASON_SYNCHRONIZE);
 	if (xret == XRT_SUCCESS) {
-		sync_handle = handle_fencing_or_finish(c);
+		// Prefer fences, they are native to the window system.
+		if (c->insert_fence == NULL) {
+			use_semaphore = handle_semaphore(c, &value);
+		}
+		if (!use_semaphore) {
+			sync_handle = handle_fencing_or_finish(c);
+		}
 		client_gl_compositor_context_end(xc, CLIENT_GL_CONTEXT_REASON_SYNCHRONIZE);
 	}
 
+	if (use_semaphore) {
+		COMP_TRACE_IDENT(layer_commit_with_semaphore);
+
+		return xrt_comp_layer_commit_with_semaphore(&c->xcn->base, c->sync.xcsem, value);
+	}
+
 	COMP_TRACE_IDENT(layer_commit);
 
 	return xrt_comp_layer_commit(&c->xcn->base, sync_handle);
@@ -527,6 +680,15 @@ client_gl_compositor_poll_events(struct xrt_compositor *xc, union xrt_compositor
 	return xrt_comp_poll_events(&c->xcn->base, out_xce);
 }
 
+static xrt_result_t
+client_gl_compositor_get_frame_stats(struct xrt_compositor *xc, struct xrt_compositor_frame_stats *out_stats)
+{
+	struct client_gl_compositor *c = client_gl_compositor(xc);
+
+	// Pipe down call into native compositor.
+	return xrt_comp_get_frame_stats(&c->xcn->base, out_stats);
+}
+
 static void
 client_gl_compositor_destroy(struct xrt_compositor *xc)
 {
@@ -543,6 +705,18 @@ client_gl_compositor_destroy(struct xrt_compositor *xc)
 void
 client_gl_compositor_close(struct client_gl_compositor *c)
 {
+	if (c->sync.gl_semaphore != 0) {
+		xrt_result_t xret = client_gl_compositor_context_begin(&c->base.base, CLIENT_GL_CONTEXT_REASON_OTHER);
+		if (xret == XRT_SUCCESS) {
+			GLuint semaphore = c->sync.gl_semaphore;
+			glDeleteSemaphoresEXT(1, &semaphore);
+			client_gl_compositor_context_end(&c->base.base, CLIENT_GL_CONTEXT_REASON_OTHER);
+		}
+		c->sync.gl_semaphore = 0;
+	}
+
+	xrt_compositor_semaphore_reference(&c->sync.xcsem, NULL);
+
 	os_mutex_destroy(&c->context_mutex);
 }
 
@@ -565,6 +739,7 @@ client_gl_compositor_init(struct client_gl_compositor *c,
 	c->base.base.begin_frame = client_gl_compositor_begin_frame;
 	c->base.base.discard_frame = client_gl_compositor_discard_frame;
 	c->base.base.layer_begin = client_gl_compositor_layer_begin;
+	c->base.base.layer_reserve = client_gl_compositor_layer_reserve;
 	c->base.base.layer_stereo_projection = client_gl_compositor_layer_stereo_projection;
 	c->base.base.layer_stereo_projection_depth = client_gl_compositor_layer_stereo_projection_depth;
 	c->base.base.layer_quad = client_gl_compositor_layer_quad;
@@ -575,6 +750,7 @@ client_gl_compositor_init(struct client_gl_compositor *c,
 	c->base.base.layer_commit = client_gl_compositor_layer_commit;
 	c->base.base.destroy = client_gl_compositor_destroy;
 	c->base.base.poll_events = client_gl_compositor_poll_events;
+	c->base.base.get_frame_stats = client_gl_compositor_get_frame_stats;
 	c->context_begin_locked = context_begin_locked;
 	c->context_end_locked = context_end_locked;
 	c->create_swapchain = create_swapchain;
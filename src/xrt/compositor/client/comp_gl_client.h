@@ -165,6 +165,29 @@ struct client_gl_compositor
 	 */
 	client_gl_insert_fence_func_t insert_fence;
 
+	/*!
+	 * Timeline semaphore signalled from the app's command stream on
+	 * xrt_compositor::layer_commit when there is no @ref insert_fence,
+	 * lazily set up on the first commit. Avoids a glFinish per frame.
+	 */
+	struct
+	{
+		//! The semaphore from the native compositor, NULL if not available.
+		struct xrt_compositor_semaphore *xcsem;
+
+		//! The imported GL semaphore object.
+		uint32_t gl_semaphore;
+
+		//! Last signalled value.
+		uint64_t value;
+
+		//! Has setting up the semaphore been attempted.
+		bool tried;
+	} sync;
+
+	//! Layer data handed out by the native compositor's layer_reserve, flipped in place.
+	struct xrt_layer_data *reserved_layer;
+
 	/*!
 	 * @ref client_gl_xlib_compositor::app_context can only be current on one thread; block other threads while we
 	 * know it is bound to a thread.
@@ -48,7 +48,7 @@ client_vk_compositor(struct xrt_compositor *xc)
  */
 
 static xrt_result_t
-submit_image_barrier(struct client_vk_swapchain *sc, VkCommandBuffer cmd_buffer)
+submit_image_barrier(struct client_vk_swapchain *sc, VkCommandBuffer cmd_buffer, uint64_t wait_value)
 {
 	COMP_TRACE_MARKER();
 
@@ -56,6 +56,37 @@ submit_image_barrier(struct client_vk_swapchain *sc, VkCommandBuffer cmd_buffer)
 	struct vk_bundle *vk = &c->vk;
 	VkResult ret;
 
+#ifdef VK_KHR_timeline_semaphore
+	if (sc->release_semaphore != VK_NULL_HANDLE && wait_value > 0) {
+		VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+		VkTimelineSemaphoreSubmitInfoKHR timeline_info = {
+		    .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR,
+		    .waitSemaphoreValueCount = 1,
+		    .pWaitSemaphoreValues = &wait_value,
+		};
+
+		VkSubmitInfo submit_info = {
+		    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+		    .pNext = &timeline_info,
+		    .waitSemaphoreCount = 1,
+		    .pWaitSemaphores = &sc->release_semaphore,
+		    .pWaitDstStageMask = &wait_stage,
+		    .commandBufferCount = 1,
+		    .pCommandBuffers = &cmd_buffer,
+		};
+
+		// Note we do not submit a fence here, it's not needed.
+		ret = vk_cmd_pool_submit(vk, &c->pool, 1, &submit_info, VK_NULL_HANDLE);
+		if (ret != VK_SUCCESS) {
+			VK_ERROR(vk, "vk_cmd_pool_submit: %s %u", vk_result_string(ret), ret);
+			return XRT_ERROR_FAILED_TO_SUBMIT_VULKAN_COMMANDS;
+		}
+
+		return XRT_SUCCESS;
+	}
+#endif
+
 	// Note we do not submit a fence here, it's not needed.
 	ret = vk_cmd_pool_submit_cmd_buffer(vk, &c->pool, cmd_buffer);
 	if (ret != VK_SUCCESS) {
@@ -106,6 +137,34 @@ setup_semaphore(struct client_vk_compositor *c)
 #endif
 
 
+#ifdef VK_KHR_timeline_semaphore
+static void
+import_release_semaphore(struct client_vk_swapchain *sc)
+{
+	struct vk_bundle *vk = &sc->c->vk;
+	xrt_graphics_sync_handle_t handle = XRT_GRAPHICS_SYNC_HANDLE_INVALID;
+	xrt_result_t xret;
+	VkResult ret;
+
+	xret = xrt_swapchain_get_release_semaphore(&sc->xscn->base, &handle);
+	if (xret != XRT_SUCCESS) {
+		// Not fatal, falls back to waiting on the CPU.
+		return;
+	}
+
+	// The native swapchain keeps ownership, importing consumes the handle.
+	xrt_graphics_sync_handle_t dup = u_graphics_sync_ref(handle);
+
+	ret = vk_create_timeline_semaphore_from_native(vk, dup, &sc->release_semaphore);
+	if (ret != VK_SUCCESS) {
+		VK_WARN(vk, "vk_create_timeline_semaphore_from_native: %s", vk_result_string(ret));
+		u_graphics_sync_unref(&dup);
+		sc->release_semaphore = VK_NULL_HANDLE;
+	}
+}
+#endif
+
+
 /*
  *
  * Frame submit helpers.
@@ -268,6 +327,11 @@ client_vk_swapchain_destroy(struct xrt_swapchain *xsc)
 		}
 	}
 
+	if (sc->release_semaphore != VK_NULL_HANDLE) {
+		vk->vkDestroySemaphore(vk->device, sc->release_semaphore, NULL);
+		sc->release_semaphore = VK_NULL_HANDLE;
+	}
+
 	// Drop our reference, does NULL checking.
 	xrt_swapchain_native_reference(&sc->xscn, NULL);
 
@@ -302,6 +366,11 @@ client_vk_swapchain_wait_image(struct xrt_swapchain *xsc, uint64_t timeout_ns, u
 
 	struct client_vk_swapchain *sc = client_vk_swapchain(xsc);
 
+	// With a release semaphore the acquire barrier waits on the GPU instead.
+	if (sc->release_semaphore != VK_NULL_HANDLE) {
+		return XRT_SUCCESS;
+	}
+
 	// Pipe down call into native swapchain.
 	return xrt_swapchain_wait_image(&sc->xscn->base, timeout_ns, index);
 }
@@ -313,6 +382,7 @@ client_vk_swapchain_barrier_image(struct xrt_swapchain *xsc, enum xrt_barrier_di
 
 	struct client_vk_swapchain *sc = client_vk_swapchain(xsc);
 	VkCommandBuffer cmd_buffer = VK_NULL_HANDLE;
+	uint64_t wait_value = 0;
 
 	switch (direction) {
 	case XRT_BARRIER_TO_APP: cmd_buffer = sc->acquire[index]; break;
@@ -320,7 +390,22 @@ client_vk_swapchain_barrier_image(struct xrt_swapchain *xsc, enum xrt_barrier_di
 	default: assert(false);
 	}
 
-	return submit_image_barrier(sc, cmd_buffer);
+	/*
+	 * Wait on the GPU for the compositor to be done reading the image, if
+	 * the value can't be fetched fall back to waiting on the CPU.
+	 */
+	if (direction == XRT_BARRIER_TO_APP && sc->release_semaphore != VK_NULL_HANDLE) {
+		xrt_result_t xret = xrt_swapchain_get_release_value(&sc->xscn->base, index, &wait_value);
+		if (xret != XRT_SUCCESS) {
+			wait_value = 0;
+			xret = xrt_swapchain_wait_image(&sc->xscn->base, XRT_INFINITE_DURATION, index);
+			if (xret != XRT_SUCCESS) {
+				return xret;
+			}
+		}
+	}
+
+	return submit_image_barrier(sc, cmd_buffer, wait_value);
 }
 
 static xrt_result_t
@@ -352,6 +437,17 @@ client_vk_compositor_poll_events(struct xrt_compositor *xc, union xrt_compositor
 	return xrt_comp_poll_events(&c->xcn->base, out_xce);
 }
 
+static xrt_result_t
+client_vk_compositor_get_frame_stats(struct xrt_compositor *xc, struct xrt_compositor_frame_stats *out_stats)
+{
+	COMP_TRACE_MARKER();
+
+	struct client_vk_compositor *c = client_vk_compositor(xc);
+
+	// Pipe down call into native compositor.
+	return xrt_comp_get_frame_stats(&c->xcn->base, out_stats);
+}
+
 static void
 client_vk_compositor_destroy(struct xrt_compositor *xc)
 {
@@ -446,6 +542,15 @@ client_vk_compositor_layer_begin(struct xrt_compositor *xc, const struct xrt_lay
 	return xrt_comp_layer_begin(&c->xcn->base, data);
 }
 
+static struct xrt_layer_data *
+client_vk_compositor_layer_reserve(struct xrt_compositor *xc)
+{
+	struct client_vk_compositor *c = client_vk_compositor(xc);
+
+	// Data is passed through unchanged, so the native storage can be used directly.
+	return xrt_comp_layer_reserve(&c->xcn->base);
+}
+
 static xrt_result_t
 client_vk_compositor_layer_stereo_projection(struct xrt_compositor *xc,
                                              struct xrt_device *xdev,
@@ -747,6 +852,11 @@ client_vk_swapchain_create(struct xrt_compositor *xc,
 	}
 	vk_cmd_pool_unlock(&c->pool);
 
+#ifdef VK_KHR_timeline_semaphore
+	if (xsc->get_release_semaphore != NULL && vk->features.timeline_semaphore) {
+		import_release_semaphore(sc);
+	}
+#endif
 
 	*out_xsc = &sc->base.base;
 
@@ -779,6 +889,7 @@ client_vk_compositor_create(struct xrt_compositor_native *xcn,
 	c->base.base.begin_frame = client_vk_compositor_begin_frame;
 	c->base.base.discard_frame = client_vk_compositor_discard_frame;
 	c->base.base.layer_begin = client_vk_compositor_layer_begin;
+	c->base.base.layer_reserve = client_vk_compositor_layer_reserve;
 	c->base.base.layer_stereo_projection = client_vk_compositor_layer_stereo_projection;
 	c->base.base.layer_stereo_projection_depth = client_vk_compositor_layer_stereo_projection_depth;
 	c->base.base.layer_quad = client_vk_compositor_layer_quad;
@@ -789,6 +900,7 @@ client_vk_compositor_create(struct xrt_compositor_native *xcn,
 	c->base.base.layer_commit = client_vk_compositor_layer_commit;
 	c->base.base.destroy = client_vk_compositor_destroy;
 	c->base.base.poll_events = client_vk_compositor_poll_events;
+	c->base.base.get_frame_stats = client_vk_compositor_get_frame_stats;
 
 	c->xcn = xcn;
 	// passthrough our formats from the native compositor to the client
@@ -51,6 +51,13 @@ struct client_vk_swapchain
 	// Prerecorded swapchain image ownership/layout transition barriers
 	VkCommandBuffer acquire[XRT_MAX_SWAPCHAIN_IMAGES];
 	VkCommandBuffer release[XRT_MAX_SWAPCHAIN_IMAGES];
+
+	/*!
+	 * Imported release timeline semaphore of the native swapchain, the
+	 * acquire barrier waits on it instead of waiting on the CPU, is
+	 * VK_NULL_HANDLE if the native swapchain doesn't have one.
+	 */
+	VkSemaphore release_semaphore;
 };
 
 /*!
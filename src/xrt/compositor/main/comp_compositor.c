@@ -58,8 +58,10 @@
 #include "util/u_verify.h"
 
 #include "util/comp_vulkan.h"
+#include "util/comp_cross_gpu.h"
 #include "main/comp_compositor.h"
 #include "main/comp_frame.h"
+#include "main/comp_target_offscreen.h"
 
 #ifdef XRT_FEATURE_WINDOW_PEEK
 #include "main/comp_window_peek.h"
@@ -381,14 +383,21 @@ compositor_layer_commit(struct xrt_compositor *xc, xrt_graphics_sync_handle_t sy
 
 	/*
 	 * We have a fast path for single projection layer that goes directly
-	 * to the distortion shader, so no need to use the layer renderer.
+	 * to the distortion shader, so no need to use the layer renderer. The
+	 * mirror only needs the squashed image if someone is looking at it.
 	 */
-	bool fast_path = can_do_one_projection_layer_fast_path(c) && !c->mirroring_to_debug_gui && !c->peek;
+	bool mirroring = c->r != NULL && comp_renderer_is_mirroring_to_debug_gui(c->r);
+	bool fast_path = can_do_one_projection_layer_fast_path(c) && !mirroring && !c->peek;
 	c->base.slot.one_projection_layer_fast_path = fast_path;
 
 
 	u_graphics_sync_unref(&sync_handle);
 
+	// Before anything samples the images.
+	if (c->base.cscs.cross != NULL) {
+		comp_cross_gpu_transfer_layers(c->base.cscs.cross, c->base.slot.layers, c->base.slot.layer_count);
+	}
+
 	if (!c->settings.use_compute) {
 		do_graphics_layers(c);
 	}
@@ -410,6 +419,40 @@ compositor_layer_commit(struct xrt_compositor *xc, xrt_graphics_sync_handle_t sy
 	return XRT_SUCCESS;
 }
 
+static xrt_result_t
+compositor_get_frame_stats(struct xrt_compositor *xc, struct xrt_compositor_frame_stats *out_stats)
+{
+	COMP_TRACE_MARKER();
+
+	struct comp_compositor *c = comp_compositor(xc);
+
+	// Only the compositor's own timings, there are no sessions here.
+	U_ZERO(out_stats);
+	out_stats->compositor_gpu_time_ns = c->gpu_time.total_ns;
+	out_stats->display_period_ns = c->settings.nominal_frame_interval_ns;
+	out_stats->rate_divisor = 1;
+	out_stats->recommended_render_scale = 1.0f;
+
+	return XRT_SUCCESS;
+}
+
+static xrt_result_t
+compositor_get_memory_budget(struct xrt_compositor *xc, struct xrt_compositor_memory_budget *out_budget)
+{
+	COMP_TRACE_MARKER();
+
+	struct comp_compositor *c = comp_compositor(xc);
+	struct vk_bundle *vk = get_vk(c);
+
+	// Only queries the physical device, needs no locking.
+	VkResult ret = vk_get_memory_budget(vk, &out_budget->budget_bytes, &out_budget->usage_bytes);
+	if (ret != VK_SUCCESS) {
+		return XRT_ERROR_COMPOSITOR_FUNCTION_NOT_IMPLEMENTED;
+	}
+
+	return XRT_SUCCESS;
+}
+
 static xrt_result_t
 compositor_poll_events(struct xrt_compositor *xc, union xrt_compositor_event *out_xce)
 {
@@ -457,6 +500,9 @@ compositor_destroy(struct xrt_compositor *xc)
 	// Make sure we don't have anything to destroy.
 	comp_swapchain_shared_garbage_collect(&c->base.cscs);
 
+	// Must be destroyed after the swapchains and before Vulkan.
+	comp_cross_gpu_destroy(&c->base.cscs.cross);
+
 	// Must be destroyed before Vulkan.
 	comp_swapchain_shared_destroy(&c->base.cscs, vk);
 
@@ -645,9 +691,15 @@ static const char *optional_device_extensions[] = {
 #ifdef VK_EXT_robustness2
     VK_EXT_ROBUSTNESS_2_EXTENSION_NAME,
 #endif
+#ifdef VK_EXT_memory_budget
+    VK_EXT_MEMORY_BUDGET_EXTENSION_NAME,
+#endif
 #ifdef VK_EXT_display_control
     VK_EXT_DISPLAY_CONTROL_EXTENSION_NAME,
 #endif
+#if defined VK_EXT_external_memory_dma_buf && defined XRT_GRAPHICS_BUFFER_HANDLE_IS_FD
+    VK_EXT_EXTERNAL_MEMORY_DMA_BUF_EXTENSION_NAME,
+#endif
 };
 
 static bool
@@ -725,14 +777,16 @@ compositor_init_vulkan(struct comp_compositor *c)
 	};
 
 	struct comp_vulkan_results vk_res = {0};
+	uint64_t bundle_start_ns = os_monotonic_get_ns();
 	bool bundle_ret = comp_vulkan_init_bundle(vk, &vk_args, &vk_res);
+	COMP_DEBUG(c, "Vulkan bundle init took %.1fms", time_ns_to_ms_f(os_monotonic_get_ns() - bundle_start_ns));
 
 	u_string_list_destroy(&required_instance_ext_list);
 	u_string_list_destroy(&optional_instance_ext_list);
-	u_string_list_destroy(&required_device_extension_list);
-	u_string_list_destroy(&optional_device_extension_list);
 
 	if (!bundle_ret) {
+		u_string_list_destroy(&required_device_extension_list);
+		u_string_list_destroy(&optional_device_extension_list);
 		return false;
 	}
 
@@ -755,9 +809,30 @@ compositor_init_vulkan(struct comp_compositor *c)
 	// Tie the lifetimes of swapchains to Vulkan.
 	xrt_result_t xret = comp_swapchain_shared_init(&c->base.cscs, vk);
 	if (xret != XRT_SUCCESS) {
+		u_string_list_destroy(&required_device_extension_list);
+		u_string_list_destroy(&optional_device_extension_list);
 		return false;
 	}
 
+	// Applications render on another GPU, copy their images over instead of sharing them.
+	if (c->settings.cross_gpu && vk_res.client_gpu_index != vk_res.selected_gpu_index) {
+		xret = comp_cross_gpu_create(       //
+		    vk,                             //
+		    vk_res.client_gpu_index,        //
+		    required_device_extension_list, //
+		    optional_device_extension_list, //
+		    &c->base.cscs.cross);           //
+		if (xret != XRT_SUCCESS) {
+			COMP_WARN(c, "Could not open the client GPU, clients will use the selected GPU.");
+			c->settings.client_gpu_deviceUUID = vk_res.selected_gpu_deviceUUID;
+			c->settings.client_gpu_index = vk_res.selected_gpu_index;
+			c->settings.client_gpu_deviceLUID_valid = false;
+		}
+	}
+
+	u_string_list_destroy(&required_device_extension_list);
+	u_string_list_destroy(&optional_device_extension_list);
+
 	return true;
 }
 
@@ -784,6 +859,9 @@ const struct comp_target_factory *ctfs[] = {
 #ifdef XRT_OS_ANDROID
     &comp_target_factory_android,
 #endif
+#ifdef COMP_HAVE_ANDROID_SURFACE_CONTROL
+    &comp_target_factory_android_surface_control,
+#endif
 #ifdef XRT_OS_WINDOWS
     &comp_target_factory_mswin,
 #endif
@@ -793,6 +871,7 @@ const struct comp_target_factory *ctfs[] = {
 #ifdef VK_USE_PLATFORM_DISPLAY_KHR
     &comp_target_factory_vk_display,
 #endif
+    &comp_target_factory_offscreen,
 };
 
 static void
@@ -906,6 +985,17 @@ compositor_init_window_pre_vulkan(struct comp_compositor *c, const struct comp_t
 	}
 
 	if (selected_ctf != NULL) {
+		/*
+		 * Everything but the target is created now, so that the first
+		 * session starts quickly while the display is left alone until then.
+		 */
+		if (c->settings.standby) {
+			COMP_INFO(c, "Selected %s backend, in standby until the first session!", selected_ctf->name);
+			c->target_factory = selected_ctf;
+			c->deferred_surface = true;
+			return true;
+		}
+
 		// We have selected a target factory, but it needs Vulkan.
 		if (selected_ctf->requires_vulkan_for_create) {
 			COMP_INFO(c, "Selected %s backend!", selected_ctf->name);
@@ -925,6 +1015,10 @@ compositor_init_window_pre_vulkan(struct comp_compositor *c, const struct comp_t
 		return true;
 	}
 
+	if (c->settings.standby) {
+		COMP_WARN(c, "Standby needs a target that is forced or detected, trying all targets now!");
+	}
+
 	for (size_t i = 0; i < ARRAY_SIZE(ctfs); i++) {
 		const struct comp_target_factory *ctf = ctfs[i];
 
@@ -990,9 +1084,11 @@ compositor_init_render_resources(struct comp_compositor *c)
 
 	struct vk_bundle *vk = get_vk(c);
 
+	uint64_t shaders_start_ns = os_monotonic_get_ns();
 	if (!render_shaders_load(&c->shaders, vk)) {
 		return false;
 	}
+	COMP_DEBUG(c, "Shader loading took %.1fms", time_ns_to_ms_f(os_monotonic_get_ns() - shaders_start_ns));
 
 	if (!render_resources_init(&c->nr, &c->shaders, get_vk(c), c->xdev)) {
 		return false;
@@ -1019,11 +1115,14 @@ compositor_init_renderer(struct comp_compositor *c)
 
 xrt_result_t
 comp_main_create_system_compositor(struct xrt_device *xdev,
+                                   struct xrt_device *eyes,
                                    const struct comp_target_factory *ctf,
                                    struct xrt_system_compositor **out_xsysc)
 {
 	COMP_TRACE_MARKER();
 
+	uint64_t start_ns = os_monotonic_get_ns();
+
 	struct comp_compositor *c = U_TYPED_CALLOC(struct comp_compositor);
 
 	c->base.base.base.begin_session = compositor_begin_session;
@@ -1033,11 +1132,14 @@ comp_main_create_system_compositor(struct xrt_device *xdev,
 	c->base.base.base.begin_frame = compositor_begin_frame;
 	c->base.base.base.discard_frame = compositor_discard_frame;
 	c->base.base.base.layer_commit = compositor_layer_commit;
+	c->base.base.base.get_frame_stats = compositor_get_frame_stats;
+	c->base.base.base.get_memory_budget = compositor_get_memory_budget;
 	c->base.base.base.poll_events = compositor_poll_events;
 	c->base.base.base.destroy = compositor_destroy;
 	c->frame.waited.id = -1;
 	c->frame.rendering.id = -1;
 	c->xdev = xdev;
+	c->eyes = eyes;
 
 	COMP_DEBUG(c, "Doing init %p", (void *)c);
 
@@ -1085,6 +1187,8 @@ comp_main_create_system_compositor(struct xrt_device *xdev,
 		return XRT_ERROR_VULKAN;
 	}
 
+	uint64_t resources_done_ns = os_monotonic_get_ns();
+
 	if (!c->deferred_surface) {
 		if (!compositor_init_window_post_vulkan(c) ||
 		    !compositor_init_swapchain(c) ||
@@ -1098,6 +1202,10 @@ comp_main_create_system_compositor(struct xrt_device *xdev,
 	}
 	// clang-format on
 
+	uint64_t done_ns = os_monotonic_get_ns();
+	COMP_INFO(c, "Init took %.1fms, %.1fms of it for the window, swapchain and renderer",
+	          time_ns_to_ms_f(done_ns - start_ns), time_ns_to_ms_f(done_ns - resources_done_ns));
+
 	COMP_DEBUG(c, "Done %p", (void *)c);
 
 	/*!
@@ -1125,8 +1233,8 @@ comp_main_create_system_compositor(struct xrt_device *xdev,
 	struct xrt_system_compositor_info sys_info_storage = {0};
 	struct xrt_system_compositor_info *sys_info = &sys_info_storage;
 
-	// Required by OpenXR spec.
-	sys_info->max_layers = 16;
+	// The OpenXR spec requires at least 16, the compute path squashes more in several passes.
+	sys_info->max_layers = COMP_MAX_LAYERS;
 	sys_info->compositor_vk_deviceUUID = c->settings.selected_gpu_deviceUUID;
 	sys_info->client_vk_deviceUUID = c->settings.client_gpu_deviceUUID;
 	sys_info->client_d3d_deviceLUID = c->settings.client_gpu_deviceLUID;
@@ -1165,6 +1273,9 @@ comp_main_create_system_compositor(struct xrt_device *xdev,
 	u_frame_times_widget_init(&c->compositor_frame_times, target_frame_time_ms, 10.f);
 
 	u_var_add_ro_f32(c, &c->compositor_frame_times.fps, "FPS (Compositor)");
+	u_var_add_ro_u64(c, &c->gpu_time.total_ns, "GPU time(ns)");
+	u_var_add_ro_u64(c, &c->gpu_time.layers_ns, "GPU time layers(ns)");
+	u_var_add_ro_u64(c, &c->gpu_time.distortion_ns, "GPU time distortion(ns)");
 	u_var_add_bool(c, &c->debug.atw_off, "Debug: ATW OFF");
 	u_var_add_f32_timing(c, c->compositor_frame_times.debug_var, "Frame Times (Compositor)");
 
@@ -102,6 +102,9 @@ struct comp_compositor
 	//! The device we are displaying to.
 	struct xrt_device *xdev;
 
+	//! Optional eye tracker, the foveated region follows its gaze.
+	struct xrt_device *eyes;
+
 	//! Vulkan shaders that the compositor (renderer) uses.
 	struct render_shaders shaders;
 
@@ -144,6 +147,19 @@ struct comp_compositor
 
 	struct u_frame_times_widget compositor_frame_times;
 
+	//! GPU times of the last frames, filtered, see @ref xrt_compositor::get_frame_stats.
+	struct
+	{
+		//! All of the rendering of a frame.
+		uint64_t total_ns;
+
+		//! Squashing the layers, compute path only.
+		uint64_t layers_ns;
+
+		//! Distortion, or the fast path, compute path only.
+		uint64_t distortion_ns;
+	} gpu_time;
+
 	struct
 	{
 		struct comp_frame waited;
@@ -0,0 +1,501 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Hands the compositor output to a GStreamer encoder without copying.
+ * @ingroup comp_main
+ */
+
+#include "os/os_threading.h"
+#include "os/os_time.h"
+
+#include "util/u_misc.h"
+#include "util/u_logging.h"
+#include "util/u_time.h"
+#include "util/u_trace_marker.h"
+
+#include "gstreamer/gst_sink.h"
+#include "gstreamer/gst_pipeline.h"
+
+#include "main/comp_encoder_tap.h"
+
+#include <assert.h>
+#include <unistd.h>
+
+
+/*
+ *
+ * Structs and defines.
+ *
+ */
+
+//! Name of the appsrc element in the pipeline string.
+#define COMP_ENCODER_TAP_APPSRC_NAME "comp_src"
+
+//! Given to the sink so the release callback knows which image it was.
+struct tap_release
+{
+	struct comp_encoder_tap *tap;
+	uint32_t index;
+};
+
+struct comp_encoder_tap
+{
+	struct vk_bundle *vk;
+
+	uint32_t width, height;
+
+	struct comp_encoder_tap_image images[COMP_ENCODER_TAP_MAX_IMAGES];
+	struct tap_release releases[COMP_ENCODER_TAP_MAX_IMAGES];
+	uint32_t image_count;
+
+	struct xrt_frame_context xfctx;
+	struct gstreamer_pipeline *gp;
+	struct gstreamer_sink *gs;
+
+	//! Waits for the GPU and pushes into the pipeline.
+	struct os_thread_helper oth;
+
+	//! Image waiting for the GPU, protected by the thread helper lock.
+	struct
+	{
+		bool valid;
+		uint32_t index;
+		VkSemaphore timeline;
+		uint64_t value;
+		uint64_t timestamp_ns;
+	} pending;
+
+	/*!
+	 * Protects @ref held, separate from the thread helper because the
+	 * pipeline can release buffers while the thread is being stopped.
+	 */
+	struct os_mutex held_mutex;
+
+	//! Images that are pending or in the pipeline.
+	bool held[COMP_ENCODER_TAP_MAX_IMAGES];
+};
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static const char *
+gst_format_from_vk_format(VkFormat format)
+{
+	switch (format) {
+	case VK_FORMAT_B8G8R8A8_UNORM:
+	case VK_FORMAT_B8G8R8A8_SRGB: return "BGRx";
+	case VK_FORMAT_R8G8B8A8_UNORM:
+	case VK_FORMAT_R8G8B8A8_SRGB: return "RGBx";
+	default: return NULL;
+	}
+}
+
+static void
+set_held(struct comp_encoder_tap *tap, uint32_t index, bool held)
+{
+	os_mutex_lock(&tap->held_mutex);
+	tap->held[index] = held;
+	os_mutex_unlock(&tap->held_mutex);
+}
+
+static void
+release_image(void *user_data)
+{
+	struct tap_release *release = (struct tap_release *)user_data;
+
+	set_held(release->tap, release->index, false);
+}
+
+static bool
+check_dmabuf_export(struct vk_bundle *vk, VkFormat format, VkImageUsageFlags usage)
+{
+	VkPhysicalDeviceExternalImageFormatInfo external_format_info = {
+	    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_IMAGE_FORMAT_INFO,
+	    .handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT,
+	};
+
+	VkPhysicalDeviceImageFormatInfo2 format_info = {
+	    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_IMAGE_FORMAT_INFO_2,
+	    .pNext = &external_format_info,
+	    .format = format,
+	    .type = VK_IMAGE_TYPE_2D,
+	    .tiling = VK_IMAGE_TILING_LINEAR,
+	    .usage = usage,
+	};
+
+	VkExternalImageFormatProperties external_format_properties = {
+	    .sType = VK_STRUCTURE_TYPE_EXTERNAL_IMAGE_FORMAT_PROPERTIES,
+	};
+
+	VkImageFormatProperties2 format_properties = {
+	    .sType = VK_STRUCTURE_TYPE_IMAGE_FORMAT_PROPERTIES_2,
+	    .pNext = &external_format_properties,
+	};
+
+	VkResult ret = vk->vkGetPhysicalDeviceImageFormatProperties2( //
+	    vk->physical_device,                                      //
+	    &format_info,                                             //
+	    &format_properties);                                      //
+	if (ret != VK_SUCCESS) {
+		VK_DEBUG(vk, "vkGetPhysicalDeviceImageFormatProperties2: %s", vk_result_string(ret));
+		return false;
+	}
+
+	VkExternalMemoryFeatureFlags features =
+	    external_format_properties.externalMemoryProperties.externalMemoryFeatures;
+
+	return (features & VK_EXTERNAL_MEMORY_FEATURE_EXPORTABLE_BIT) != 0;
+}
+
+/*!
+ * Linear so that consumers can import it without knowing any format modifier.
+ */
+static VkResult
+create_image(struct vk_bundle *vk,
+             uint32_t width,
+             uint32_t height,
+             VkFormat format,
+             VkImageUsageFlags usage,
+             struct comp_encoder_tap_image *out_image)
+{
+	VkResult ret;
+
+	VkExternalMemoryImageCreateInfo external_create_info = {
+	    .sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO,
+	    .handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT,
+	};
+
+	VkImageCreateInfo create_info = {
+	    .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+	    .pNext = &external_create_info,
+	    .imageType = VK_IMAGE_TYPE_2D,
+	    .format = format,
+	    .extent = {.width = width, .height = height, .depth = 1},
+	    .mipLevels = 1,
+	    .arrayLayers = 1,
+	    .samples = VK_SAMPLE_COUNT_1_BIT,
+	    .tiling = VK_IMAGE_TILING_LINEAR,
+	    .usage = usage,
+	    .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+	    .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+	};
+
+	VkImage image = VK_NULL_HANDLE;
+	ret = vk->vkCreateImage(vk->device, &create_info, NULL, &image);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkCreateImage: %s", vk_result_string(ret));
+		return ret;
+	}
+
+	// Importers of a DMA-BUF expect one allocation per buffer.
+	VkMemoryDedicatedAllocateInfoKHR dedicated_memory_info = {
+	    .sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO_KHR,
+	    .image = image,
+	    .buffer = VK_NULL_HANDLE,
+	};
+
+	VkExportMemoryAllocateInfo export_alloc_info = {
+	    .sType = VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO_KHR,
+	    .pNext = &dedicated_memory_info,
+	    .handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT,
+	};
+
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	VkDeviceSize size = 0;
+	ret = vk_alloc_and_bind_image_memory( //
+	    vk,                               // vk_bundle
+	    image,                            // image
+	    SIZE_MAX,                         // max_size
+	    &export_alloc_info,               // pNext_for_allocate
+	    "comp_encoder_tap::create_image", // caller_name
+	    &memory,                          // out_mem
+	    &size);                           // out_size
+	if (ret != VK_SUCCESS) {
+		vk->vkDestroyImage(vk->device, image, NULL);
+		return ret;
+	}
+
+	VkMemoryGetFdInfoKHR get_fd_info = {
+	    .sType = VK_STRUCTURE_TYPE_MEMORY_GET_FD_INFO_KHR,
+	    .memory = memory,
+	    .handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT,
+	};
+
+	int fd = -1;
+	ret = vk->vkGetMemoryFdKHR(vk->device, &get_fd_info, &fd);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkGetMemoryFdKHR: %s", vk_result_string(ret));
+		vk->vkFreeMemory(vk->device, memory, NULL);
+		vk->vkDestroyImage(vk->device, image, NULL);
+		return ret;
+	}
+
+	VkImageSubresource subresource = {
+	    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	    .mipLevel = 0,
+	    .arrayLayer = 0,
+	};
+
+	VkSubresourceLayout layout = {0};
+	vk->vkGetImageSubresourceLayout(vk->device, image, &subresource, &layout);
+
+	out_image->handle = image;
+	out_image->memory = memory;
+	out_image->size = size;
+	out_image->fd = fd;
+	out_image->offset = layout.offset;
+	out_image->row_pitch = layout.rowPitch;
+
+	return VK_SUCCESS;
+}
+
+static void
+destroy_image(struct vk_bundle *vk, struct comp_encoder_tap_image *image)
+{
+	if (image->fd >= 0) {
+		close(image->fd);
+		image->fd = -1;
+	}
+	if (image->handle != VK_NULL_HANDLE) {
+		vk->vkDestroyImage(vk->device, image->handle, NULL);
+		image->handle = VK_NULL_HANDLE;
+	}
+	if (image->memory != VK_NULL_HANDLE) {
+		vk->vkFreeMemory(vk->device, image->memory, NULL);
+		image->memory = VK_NULL_HANDLE;
+	}
+}
+
+static void
+push_image(struct comp_encoder_tap *tap, uint32_t index, VkSemaphore timeline, uint64_t value, uint64_t timestamp_ns)
+{
+	COMP_TRACE_MARKER();
+
+	struct vk_bundle *vk = tap->vk;
+
+	VkSemaphoreWaitInfo wait_info = {
+	    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+	    .semaphoreCount = 1,
+	    .pSemaphores = &timeline,
+	    .pValues = &value,
+	};
+
+	// Something is very wrong if a frame takes this long.
+	VkResult ret = vk->vkWaitSemaphores(vk->device, &wait_info, U_TIME_1S_IN_NS);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkWaitSemaphores: %s", vk_result_string(ret));
+		set_held(tap, index, false);
+		return;
+	}
+
+	const struct comp_encoder_tap_image *image = &tap->images[index];
+
+	bool pushed = gstreamer_sink_push_dmabuf( //
+	    tap->gs,                              //
+	    image->fd,                            //
+	    (size_t)image->size,                  //
+	    (size_t)image->offset,                //
+	    tap->width,                           //
+	    tap->height,                          //
+	    (uint32_t)image->row_pitch,           //
+	    timestamp_ns,                         //
+	    release_image,                        //
+	    &tap->releases[index]);               //
+	if (!pushed) {
+		set_held(tap, index, false);
+	}
+}
+
+static void *
+run_thread(void *ptr)
+{
+	struct comp_encoder_tap *tap = (struct comp_encoder_tap *)ptr;
+
+	U_TRACE_SET_THREAD_NAME("Encoder Tap");
+	os_thread_helper_name(&tap->oth, "Encoder Tap");
+
+	os_thread_helper_lock(&tap->oth);
+
+	while (os_thread_helper_is_running_locked(&tap->oth)) {
+		if (!tap->pending.valid) {
+			os_thread_helper_wait_locked(&tap->oth);
+			continue;
+		}
+
+		uint32_t index = tap->pending.index;
+		VkSemaphore timeline = tap->pending.timeline;
+		uint64_t value = tap->pending.value;
+		uint64_t timestamp_ns = tap->pending.timestamp_ns;
+		tap->pending.valid = false;
+
+		// Don't hold the lock while waiting on the GPU.
+		os_thread_helper_unlock(&tap->oth);
+
+		push_image(tap, index, timeline, value, timestamp_ns);
+
+		os_thread_helper_lock(&tap->oth);
+	}
+
+	os_thread_helper_unlock(&tap->oth);
+
+	return NULL;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+bool
+comp_encoder_tap_create(struct vk_bundle *vk,
+                        const char *pipeline_string,
+                        uint32_t width,
+                        uint32_t height,
+                        VkFormat format,
+                        VkImageUsageFlags usage,
+                        uint32_t image_count,
+                        struct comp_encoder_tap **out_tap)
+{
+	VkResult ret;
+
+	assert(image_count <= COMP_ENCODER_TAP_MAX_IMAGES);
+
+	const char *gst_format = gst_format_from_vk_format(format);
+	if (gst_format == NULL) {
+		VK_WARN(vk, "Encoder tap: Format %s not supported.", vk_format_string(format));
+		return false;
+	}
+
+	if (!vk->has_EXT_external_memory_dma_buf || !vk->features.timeline_semaphore) {
+		VK_WARN(vk, "Encoder tap: Needs VK_EXT_external_memory_dma_buf and timeline semaphores.");
+		return false;
+	}
+
+	if (!check_dmabuf_export(vk, format, usage)) {
+		VK_WARN(vk, "Encoder tap: Can not export linear %s images as DMA-BUF.", vk_format_string(format));
+		return false;
+	}
+
+	struct comp_encoder_tap *tap = U_TYPED_CALLOC(struct comp_encoder_tap);
+	tap->vk = vk;
+	tap->width = width;
+	tap->height = height;
+
+	for (uint32_t i = 0; i < COMP_ENCODER_TAP_MAX_IMAGES; i++) {
+		tap->images[i].fd = -1;
+		tap->releases[i].tap = tap;
+		tap->releases[i].index = i;
+	}
+
+	os_mutex_init(&tap->held_mutex);
+	os_thread_helper_init(&tap->oth);
+
+	for (uint32_t i = 0; i < image_count; i++) {
+		ret = create_image(vk, width, height, format, usage, &tap->images[i]);
+		if (ret != VK_SUCCESS) {
+			comp_encoder_tap_destroy(&tap);
+			return false;
+		}
+		tap->image_count++;
+	}
+
+	gstreamer_pipeline_create_from_string(&tap->xfctx, pipeline_string, &tap->gp);
+
+	gstreamer_sink_create_dmabuf_with_pipeline( //
+	    tap->gp,                                //
+	    width,                                  //
+	    height,                                 //
+	    gst_format,                             //
+	    COMP_ENCODER_TAP_APPSRC_NAME,           //
+	    &tap->gs);                              //
+	if (tap->gs == NULL) {
+		VK_ERROR(vk, "Encoder tap: Failed to create pipeline '%s'", pipeline_string);
+		comp_encoder_tap_destroy(&tap);
+		return false;
+	}
+
+	gstreamer_pipeline_play(tap->gp);
+
+	os_thread_helper_start(&tap->oth, run_thread, tap);
+
+	VK_INFO(vk, "Encoder tap: Pushing %ux%u %s DMA-BUFs into '%s'", width, height, gst_format, pipeline_string);
+
+	*out_tap = tap;
+
+	return true;
+}
+
+const struct comp_encoder_tap_image *
+comp_encoder_tap_get_image(struct comp_encoder_tap *tap, uint32_t index)
+{
+	assert(index < tap->image_count);
+
+	return &tap->images[index];
+}
+
+bool
+comp_encoder_tap_is_held(struct comp_encoder_tap *tap, uint32_t index)
+{
+	os_mutex_lock(&tap->held_mutex);
+	bool held = tap->held[index];
+	os_mutex_unlock(&tap->held_mutex);
+
+	return held;
+}
+
+void
+comp_encoder_tap_push(
+    struct comp_encoder_tap *tap, uint32_t index, VkSemaphore timeline, uint64_t value, uint64_t timestamp_ns)
+{
+	set_held(tap, index, true);
+
+	os_thread_helper_lock(&tap->oth);
+
+	// The encoder is behind, drop the frame it hasn't gotten to yet.
+	if (tap->pending.valid) {
+		set_held(tap, tap->pending.index, false);
+	}
+
+	tap->pending.valid = true;
+	tap->pending.index = index;
+	tap->pending.timeline = timeline;
+	tap->pending.value = value;
+	tap->pending.timestamp_ns = timestamp_ns;
+
+	os_thread_helper_signal_locked(&tap->oth);
+	os_thread_helper_unlock(&tap->oth);
+}
+
+void
+comp_encoder_tap_destroy(struct comp_encoder_tap **tap_ptr)
+{
+	struct comp_encoder_tap *tap = *tap_ptr;
+	if (tap == NULL) {
+		return;
+	}
+
+	// Stops the thread first.
+	os_thread_helper_destroy(&tap->oth);
+
+	// Stopping the pipeline releases all buffers.
+	if (tap->gs != NULL) {
+		gstreamer_pipeline_stop(tap->gp);
+	}
+	xrt_frame_context_destroy_nodes(&tap->xfctx);
+
+	for (uint32_t i = 0; i < tap->image_count; i++) {
+		destroy_image(tap->vk, &tap->images[i]);
+	}
+
+	os_mutex_destroy(&tap->held_mutex);
+
+	free(tap);
+	*tap_ptr = NULL;
+}
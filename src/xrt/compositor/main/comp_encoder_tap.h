@@ -0,0 +1,120 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Hands the compositor output to a GStreamer encoder without copying.
+ * @ingroup comp_main
+ */
+
+#pragma once
+
+#include "xrt/xrt_config_have.h"
+#include "xrt/xrt_config_os.h"
+
+#if !defined(XRT_HAVE_GST) || !defined(XRT_OS_LINUX)
+#error "The encoder tap needs GStreamer and Linux"
+#endif
+
+#include "vk/vk_helpers.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+//! Max number of images a tap can hold.
+#define COMP_ENCODER_TAP_MAX_IMAGES (4)
+
+/*!
+ * A image the target renders into, exported as a linear DMA-BUF.
+ *
+ * @ingroup comp_main
+ */
+struct comp_encoder_tap_image
+{
+	VkImage handle;
+	VkDeviceMemory memory;
+	VkDeviceSize size;
+
+	//! The exported DMA-BUF, owned by the tap.
+	int fd;
+
+	//! Layout of the single plane.
+	VkDeviceSize offset;
+	VkDeviceSize row_pitch;
+};
+
+/*!
+ * Owns a set of DMA-BUF backed images and a GStreamer pipeline, images given
+ * to @ref comp_encoder_tap_push are pushed into the pipeline once the GPU is
+ * done with them and are held until the pipeline releases them.
+ *
+ * @ingroup comp_main
+ */
+struct comp_encoder_tap;
+
+/*!
+ * Create the images and pipeline, the pipeline string must contain an appsrc
+ * named `comp_src`, for instance
+ * `appsrc name=comp_src ! vapostproc ! vah264enc ! h264parse ! mp4mux ! filesink location=out.mp4`.
+ *
+ * Needs `VK_EXT_external_memory_dma_buf` and timeline semaphores, returns
+ * false if not supported so the caller can fall back.
+ *
+ * @public @memberof comp_encoder_tap
+ * @ingroup comp_main
+ */
+bool
+comp_encoder_tap_create(struct vk_bundle *vk,
+                        const char *pipeline_string,
+                        uint32_t width,
+                        uint32_t height,
+                        VkFormat format,
+                        VkImageUsageFlags usage,
+                        uint32_t image_count,
+                        struct comp_encoder_tap **out_tap);
+
+/*!
+ * Get one of the images, valid until the tap is destroyed.
+ *
+ * @public @memberof comp_encoder_tap
+ * @ingroup comp_main
+ */
+const struct comp_encoder_tap_image *
+comp_encoder_tap_get_image(struct comp_encoder_tap *tap, uint32_t index);
+
+/*!
+ * Is the image still used by the pipeline, or waiting to be pushed to it. The
+ * target must not render to it then.
+ *
+ * @public @memberof comp_encoder_tap
+ * @ingroup comp_main
+ */
+bool
+comp_encoder_tap_is_held(struct comp_encoder_tap *tap, uint32_t index);
+
+/*!
+ * Hand a rendered image to the tap, it is pushed once @p timeline reaches
+ * @p value. Replaces any image not yet pushed, which is then dropped.
+ *
+ * @public @memberof comp_encoder_tap
+ * @ingroup comp_main
+ */
+void
+comp_encoder_tap_push(
+    struct comp_encoder_tap *tap, uint32_t index, VkSemaphore timeline, uint64_t value, uint64_t timestamp_ns);
+
+/*!
+ * Stop the pipeline and free all images, the GPU must be done with them.
+ *
+ * @public @memberof comp_encoder_tap
+ * @ingroup comp_main
+ */
+void
+comp_encoder_tap_destroy(struct comp_encoder_tap **tap_ptr);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -165,11 +165,7 @@ _init_pipeline_cache(struct comp_layer_renderer *self)
 {
 	struct vk_bundle *vk = self->vk;
 
-	VkPipelineCacheCreateInfo info = {
-	    .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
-	};
-
-	VkResult res = vk->vkCreatePipelineCache(vk->device, &info, NULL, &self->pipeline_cache);
+	VkResult res = vk_create_pipeline_cache_from_disk(vk, "layer_renderer", &self->pipeline_cache);
 
 	vk_check_error("vkCreatePipelineCache", res, false);
 
@@ -545,6 +541,8 @@ _init(struct comp_layer_renderer *self,
 	}
 #endif
 
+	vk_save_pipeline_cache(vk, self->pipeline_cache, "layer_renderer");
+
 	if (!_init_vertex_buffer(self))
 		return false;
 
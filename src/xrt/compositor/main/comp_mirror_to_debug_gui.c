@@ -8,10 +8,25 @@
  * @ingroup comp_main
  */
 
+#include "util/u_debug.h"
+
 #include "math/m_mathinclude.h"
 #include "main/comp_mirror_to_debug_gui.h"
 
 
+/*
+ *
+ * Defines and options.
+ *
+ */
+
+//! Height of the mirrored image, the width follows the aspect ratio of the view.
+DEBUG_GET_ONCE_NUM_OPTION(mirror_height, "XRT_COMPOSITOR_MIRROR_HEIGHT", 1080)
+
+//! Frames per second pushed to the debug sink, zero pushes every other frame.
+DEBUG_GET_ONCE_NUM_OPTION(mirror_fps, "XRT_COMPOSITOR_MIRROR_FPS", 0)
+
+
 /*
  *
  * Helper functions.
@@ -232,6 +247,114 @@ update_blit_descriptor_set(struct vk_bundle *vk,
 	    NULL);
 }
 
+static VkResult
+create_readback_timeline(struct vk_bundle *vk, VkSemaphore *out_sem)
+{
+#ifdef VK_KHR_timeline_semaphore
+	if (!vk->features.timeline_semaphore) {
+		return VK_SUCCESS;
+	}
+
+	VkSemaphoreTypeCreateInfo type_info = {
+	    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+	    .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+	    .initialValue = 0,
+	};
+
+	VkSemaphoreCreateInfo create_info = {
+	    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+	    .pNext = &type_info,
+	};
+
+	VkResult ret = vk->vkCreateSemaphore(vk->device, &create_info, NULL, out_sem);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkCreateSemaphore: %s", vk_result_string(ret));
+	}
+
+	return ret;
+#else
+	return VK_SUCCESS;
+#endif
+}
+
+/*!
+ * Ends and submits the command buffer, signaling the readback timeline instead
+ * of waiting on it, only takes the queue lock for the submit itself.
+ *
+ * @pre Command pool lock must be held.
+ */
+static VkResult
+submit_readback_locked(struct comp_mirror_to_debug_gui *m, struct vk_bundle *vk, VkCommandBuffer cmd)
+{
+#ifdef VK_KHR_timeline_semaphore
+	VkResult ret = vk->vkEndCommandBuffer(cmd);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkEndCommandBuffer: %s", vk_result_string(ret));
+		return ret;
+	}
+
+	uint64_t value = m->readback.value + 1;
+
+	VkTimelineSemaphoreSubmitInfoKHR timeline_info = {
+	    .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR,
+	    .signalSemaphoreValueCount = 1,
+	    .pSignalSemaphoreValues = &value,
+	};
+
+	VkSubmitInfo submit_info = {
+	    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+	    .pNext = &timeline_info,
+	    .commandBufferCount = 1,
+	    .pCommandBuffers = &cmd,
+	    .signalSemaphoreCount = 1,
+	    .pSignalSemaphores = &m->readback.semaphore,
+	};
+
+	ret = vk_cmd_submit_locked(vk, 1, &submit_info, VK_NULL_HANDLE);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vk_cmd_submit_locked: %s", vk_result_string(ret));
+		return ret;
+	}
+
+	m->readback.value = value;
+
+	return VK_SUCCESS;
+#else
+	assert(false && "Timeline semaphores not available");
+	return VK_ERROR_FEATURE_NOT_PRESENT;
+#endif
+}
+
+/*!
+ * Hands the read back frame to the sink, or drops it if @p success is false,
+ * and frees what the blit used.
+ */
+static void
+finish_readback(struct comp_mirror_to_debug_gui *m,
+                struct vk_bundle *vk,
+                struct vk_image_readback_to_xf *wrap,
+                VkCommandBuffer cmd,
+                bool success)
+{
+	if (cmd != VK_NULL_HANDLE) {
+		vk_cmd_pool_lock(&m->cmd_pool);
+		vk->vkFreeCommandBuffers(vk->device, m->cmd_pool.pool, 1, &cmd);
+		vk_cmd_pool_unlock(&m->cmd_pool);
+	}
+
+	// Tidies the descriptor the blit used.
+	vk->vkResetDescriptorPool(vk->device, m->blit.descriptor_pool, 0);
+
+	struct xrt_frame *frame = &wrap->base_frame;
+
+	if (success) {
+		u_sink_debug_push_frame(&m->debug_sink, frame);
+		u_frame_times_widget_push_sample(&m->push_frame_times, frame->timestamp);
+	}
+
+	xrt_frame_reference(&frame, NULL);
+}
+
 /*
  * For dispatching compute to the blit target, calculate the number of groups.
  */
@@ -269,7 +392,9 @@ comp_mirror_init(struct comp_mirror_to_debug_gui *m,
 	double orig_width = extent.width;
 	double orig_height = extent.height;
 
-	double target_height = 1080;
+	// Keep it even, see below.
+	int64_t height = debug_get_num_option_mirror_height();
+	double target_height = (double)(height < 2 ? 2 : height & ~(int64_t)1);
 
 	double mul = target_height / orig_height;
 
@@ -297,6 +422,8 @@ comp_mirror_init(struct comp_mirror_to_debug_gui *m,
 		return ret;
 	}
 
+	C(create_readback_timeline(vk, &m->readback.semaphore));
+
 	struct vk_descriptor_pool_info blit_pool_info = {
 	    .uniform_per_descriptor_count = 0,
 	    .sampler_per_descriptor_count = 1,
@@ -338,6 +465,12 @@ comp_mirror_add_debug_vars(struct comp_mirror_to_debug_gui *m, struct comp_compo
 	// Reset state.
 	m->push_every_frame_out_of_X = 2;
 
+	int64_t fps = debug_get_num_option_mirror_fps();
+	if (fps > 0 && c->settings.nominal_frame_interval_ns > 0) {
+		double display_hz = (double)U_TIME_1S_IN_NS / (double)c->settings.nominal_frame_interval_ns;
+		m->push_every_frame_out_of_X = (int)round(display_hz / (double)fps);
+	}
+
 	// Init widigts.
 	u_frame_times_widget_init(&m->push_frame_times, 0.f, 0.f);
 	comp_mirror_fixup_ui_state(m, c);
@@ -380,6 +513,11 @@ comp_mirror_is_ready_and_active(struct comp_mirror_to_debug_gui *m,
 		return false;
 	}
 
+	// Never stall the compositor on the mirror, drop this one instead.
+	if (m->readback.wrap != NULL) {
+		return false;
+	}
+
 	double diff_ms = time_ns_to_ms_f(predicted_display_time_ns - m->last_push_ts_ns);
 
 	// Completely unscientific - lower values probably works fine too.
@@ -396,6 +534,50 @@ comp_mirror_is_ready_and_active(struct comp_mirror_to_debug_gui *m,
 	return true;
 }
 
+void
+comp_mirror_poll_readback(struct comp_mirror_to_debug_gui *m, struct vk_bundle *vk, bool wait)
+{
+	if (m->readback.wrap == NULL) {
+		return;
+	}
+
+	VkResult ret = VK_SUCCESS;
+
+#ifdef VK_KHR_timeline_semaphore
+	if (wait) {
+		VkSemaphoreWaitInfo wait_info = {
+		    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+		    .semaphoreCount = 1,
+		    .pSemaphores = &m->readback.semaphore,
+		    .pValues = &m->readback.value,
+		};
+
+		ret = vk->vkWaitSemaphores(vk->device, &wait_info, U_TIME_1S_IN_NS);
+	}
+
+	uint64_t value = 0;
+	if (ret == VK_SUCCESS) {
+		ret = vk->vkGetSemaphoreCounterValue(vk->device, m->readback.semaphore, &value);
+	}
+
+	if (ret == VK_SUCCESS && value < m->readback.value) {
+		// Still in flight.
+		return;
+	}
+
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "Waiting on mirror readback: %s", vk_result_string(ret));
+	}
+#endif
+
+	struct vk_image_readback_to_xf *wrap = m->readback.wrap;
+	VkCommandBuffer cmd = m->readback.cmd;
+	m->readback.wrap = NULL;
+	m->readback.cmd = VK_NULL_HANDLE;
+
+	finish_readback(m, vk, wrap, cmd, ret == VK_SUCCESS);
+}
+
 void
 comp_mirror_do_blit(struct comp_mirror_to_debug_gui *m,
                     struct vk_bundle *vk,
@@ -601,6 +783,24 @@ comp_mirror_do_blit(struct comp_mirror_to_debug_gui *m,
 	    VK_PIPELINE_STAGE_HOST_BIT,           // dstStageMask
 	    first_color_level_subresource_range); // subresourceRange
 
+	wrap->base_frame.source_timestamp = wrap->base_frame.timestamp = predicted_display_time_ns;
+	wrap->base_frame.source_sequence = frame_id;
+
+	if (m->readback.semaphore != VK_NULL_HANDLE) {
+		// Picked up by comp_mirror_poll_readback once the GPU is done.
+		ret = submit_readback_locked(m, vk, cmd);
+		vk_cmd_pool_unlock(pool);
+
+		if (ret != VK_SUCCESS) {
+			finish_readback(m, vk, wrap, cmd, false);
+			return;
+		}
+
+		m->readback.wrap = wrap;
+		m->readback.cmd = cmd;
+		return;
+	}
+
 	// Done writing commands, submit to queue, waits for command to finish.
 	ret = vk_cmd_pool_end_submit_wait_and_free_cmd_buffer_locked(vk, pool, cmd);
 
@@ -613,20 +813,8 @@ comp_mirror_do_blit(struct comp_mirror_to_debug_gui *m,
 		VK_ERROR(vk, "vk_cmd_pool_end_submit_wait_and_free_cmd_buffer_locked: %s", vk_result_string(ret));
 	}
 
-	wrap->base_frame.source_timestamp = wrap->base_frame.timestamp = predicted_display_time_ns;
-	wrap->base_frame.source_sequence = frame_id;
-
-	struct xrt_frame *frame = &wrap->base_frame;
-	wrap = NULL;
-
-	u_sink_debug_push_frame(&m->debug_sink, frame);
-
-	u_frame_times_widget_push_sample(&m->push_frame_times, predicted_display_time_ns);
-
-	xrt_frame_reference(&frame, NULL);
-
-	// Tidies the descriptor we created.
-	vk->vkResetDescriptorPool(vk->device, m->blit.descriptor_pool, 0);
+	// The command buffer has already been freed.
+	finish_readback(m, vk, wrap, VK_NULL_HANDLE, true);
 }
 
 void
@@ -635,6 +823,10 @@ comp_mirror_fini(struct comp_mirror_to_debug_gui *m, struct vk_bundle *vk)
 	// Remove u_var root as early as possible.
 	u_var_remove_root(m);
 
+	// Must be done before the pools it uses are destroyed.
+	comp_mirror_poll_readback(m, vk, true);
+	D(Semaphore, m->readback.semaphore);
+
 	// Left eye readback
 	vk_image_readback_to_xf_pool_destroy(vk, &m->pool);
 
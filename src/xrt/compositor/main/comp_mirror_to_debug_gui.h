@@ -44,6 +44,25 @@ struct comp_mirror_to_debug_gui
 
 	struct vk_image_readback_to_xf_pool *pool;
 
+	/*!
+	 * Readback in flight, submitted without waiting and picked up by
+	 * @ref comp_mirror_poll_readback once the GPU is done with it.
+	 */
+	struct
+	{
+		//! Timeline semaphore, VK_NULL_HANDLE if not supported.
+		VkSemaphore semaphore;
+
+		//! Value signaled by the last submitted readback.
+		uint64_t value;
+
+		//! Command buffer of the readback in flight.
+		VkCommandBuffer cmd;
+
+		//! Frame being read back, NULL if nothing is in flight.
+		struct vk_image_readback_to_xf *wrap;
+	} readback;
+
 	struct
 	{
 		VkImage image;
@@ -111,7 +130,17 @@ comp_mirror_is_ready_and_active(struct comp_mirror_to_debug_gui *m,
                                 uint64_t predicted_display_time_ns);
 
 /*!
- * Do the blit.
+ * Pushes the frame of a finished readback to the debug sink, if @p wait is
+ * true blocks until the readback in flight is done. Call every frame.
+ *
+ * @public @memberof comp_mirror_to_debug_gui
+ */
+void
+comp_mirror_poll_readback(struct comp_mirror_to_debug_gui *m, struct vk_bundle *vk, bool wait);
+
+/*!
+ * Do the blit, the readback completes asynchronously when timeline semaphores
+ * are supported, see @ref comp_mirror_poll_readback.
  *
  * @public @memberof comp_mirror_to_debug_gui
  */
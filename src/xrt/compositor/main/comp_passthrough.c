@@ -0,0 +1,457 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Compositor camera passthrough code.
+ * @ingroup comp_main
+ */
+
+#include "xrt/xrt_device.h"
+
+#include "os/os_time.h"
+
+#include "math/m_api.h"
+#include "math/m_space.h"
+#include "math/m_mathinclude.h"
+
+#include "util/u_debug.h"
+#include "util/u_misc.h"
+#include "util/u_sink.h"
+#include "util/u_time.h"
+#include "util/u_var.h"
+#include "util/u_passthrough.h"
+#include "util/u_trace_marker.h"
+
+#include "vk/vk_helpers.h"
+
+#include "main/comp_passthrough.h"
+
+#include <string.h>
+
+
+DEBUG_GET_ONCE_BOOL_OPTION(passthrough, "XRT_COMPOSITOR_PASSTHROUGH", false)
+DEBUG_GET_ONCE_FLOAT_OPTION(passthrough_fov_deg, "XRT_COMPOSITOR_PASSTHROUGH_FOV_DEG", 0.0f)
+
+//! Frames older then this are shown without reprojection.
+#define MAX_FRAME_AGE_NS (U_TIME_1S_IN_NS)
+
+//! All frames are uploaded as this.
+#define IMAGE_FORMAT (VK_FORMAT_R8G8B8A8_SRGB)
+
+
+/*
+ *
+ * Helper functions.
+ *
+ */
+
+/*!
+ * Calls `vkDestroy##TYPE` on `THING` if it is not `VK_NULL_HANDLE`, sets it to
+ * `VK_NULL_HANDLE` afterwards.
+ */
+#define D(TYPE, THING)                                                                                                 \
+	if (THING != VK_NULL_HANDLE) {                                                                                 \
+		vk->vkDestroy##TYPE(vk->device, THING, NULL);                                                          \
+		THING = VK_NULL_HANDLE;                                                                                \
+	}
+
+/*!
+ * Calls `vkFree##TYPE` on `THING` if it is not `VK_NULL_HANDLE`, sets it to
+ * `VK_NULL_HANDLE` afterwards.
+ */
+#define DF(TYPE, THING)                                                                                                \
+	if (THING != VK_NULL_HANDLE) {                                                                                 \
+		vk->vkFree##TYPE(vk->device, THING, NULL);                                                             \
+		THING = VK_NULL_HANDLE;                                                                                \
+	}
+
+static void
+image_fini(struct comp_passthrough_image *img, struct vk_bundle *vk)
+{
+	D(ImageView, img->view);
+	D(Image, img->image);
+	DF(Memory, img->mem);
+	render_buffer_close(vk, &img->staging);
+
+	U_ZERO(img);
+}
+
+static VkResult
+image_ensure(struct comp_passthrough_image *img, struct vk_bundle *vk, VkExtent2D extent)
+{
+	VkResult ret;
+
+	if (img->image != VK_NULL_HANDLE && img->extent.width == extent.width && img->extent.height == extent.height) {
+		return VK_SUCCESS;
+	}
+
+	// The renderer waits for the queue to be idle after each frame.
+	image_fini(img, vk);
+
+	VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+	VkImageSubresourceRange subresource_range = {
+	    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	    .baseMipLevel = 0,
+	    .levelCount = 1,
+	    .baseArrayLayer = 0,
+	    .layerCount = 1,
+	};
+
+	ret = vk_create_image_simple( //
+	    vk,                       // vk_bundle
+	    extent,                   // extent
+	    IMAGE_FORMAT,             // format
+	    usage,                    // usage
+	    &img->mem,                // out_mem
+	    &img->image);             // out_image
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vk_create_image_simple: %s", vk_result_string(ret));
+		image_fini(img, vk);
+		return ret;
+	}
+
+	ret = vk_create_view(      //
+	    vk,                    // vk_bundle
+	    img->image,            // image
+	    VK_IMAGE_VIEW_TYPE_2D, // type
+	    IMAGE_FORMAT,          // format
+	    subresource_range,     // subresource_range
+	    &img->view);           // out_view
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vk_create_view: %s", vk_result_string(ret));
+		image_fini(img, vk);
+		return ret;
+	}
+
+	VkBufferUsageFlags buffer_usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	VkMemoryPropertyFlags memory_property_flags =
+	    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	VkDeviceSize size = (VkDeviceSize)extent.width * extent.height * 4;
+
+	ret = render_buffer_init(vk, &img->staging, buffer_usage, memory_property_flags, size);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "render_buffer_init: %s", vk_result_string(ret));
+		image_fini(img, vk);
+		return ret;
+	}
+
+	ret = render_buffer_map(vk, &img->staging);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "render_buffer_map: %s", vk_result_string(ret));
+		image_fini(img, vk);
+		return ret;
+	}
+
+	img->extent = extent;
+
+	return VK_SUCCESS;
+}
+
+//! Expands the frame to RGBA into the mapped staging buffer.
+static void
+image_write_frame(struct comp_passthrough_image *img, struct xrt_frame *xf)
+{
+	uint8_t *dst = (uint8_t *)img->staging.mapped;
+
+	for (uint32_t y = 0; y < xf->height; y++) {
+		const uint8_t *src = xf->data + y * xf->stride;
+		uint8_t *row = dst + (size_t)y * xf->width * 4;
+
+		if (xf->format == XRT_FORMAT_L8) {
+			for (uint32_t x = 0; x < xf->width; x++) {
+				row[x * 4 + 0] = src[x];
+				row[x * 4 + 1] = src[x];
+				row[x * 4 + 2] = src[x];
+				row[x * 4 + 3] = 255;
+			}
+		} else {
+			for (uint32_t x = 0; x < xf->width; x++) {
+				row[x * 4 + 0] = src[x * 3 + 0];
+				row[x * 4 + 1] = src[x * 3 + 1];
+				row[x * 4 + 2] = src[x * 3 + 2];
+				row[x * 4 + 3] = 255;
+			}
+		}
+	}
+
+	img->timestamp_ns = xf->timestamp;
+}
+
+static void
+image_record_upload_locked(struct comp_passthrough_image *img, struct vk_bundle *vk, VkCommandBuffer cmd)
+{
+	VkImageSubresourceRange subresource_range = {
+	    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	    .baseMipLevel = 0,
+	    .levelCount = 1,
+	    .baseArrayLayer = 0,
+	    .layerCount = 1,
+	};
+
+	// Old content is not needed, the whole image is overwritten.
+	vk_cmd_image_barrier_gpu_locked(          //
+	    vk,                                   //
+	    cmd,                                  //
+	    img->image,                           //
+	    0,                                    //
+	    VK_ACCESS_TRANSFER_WRITE_BIT,         //
+	    VK_IMAGE_LAYOUT_UNDEFINED,            //
+	    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, //
+	    subresource_range);                   //
+
+	VkBufferImageCopy region = {
+	    .bufferOffset = 0,
+	    .bufferRowLength = 0,
+	    .bufferImageHeight = 0,
+	    .imageSubresource =
+	        {
+	            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	            .mipLevel = 0,
+	            .baseArrayLayer = 0,
+	            .layerCount = 1,
+	        },
+	    .imageOffset = {0, 0, 0},
+	    .imageExtent = {img->extent.width, img->extent.height, 1},
+	};
+
+	vk->vkCmdCopyBufferToImage(               //
+	    cmd,                                  // commandBuffer
+	    img->staging.buffer,                  // srcBuffer
+	    img->image,                           // dstImage
+	    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, // dstImageLayout
+	    1,                                    // regionCount
+	    &region);                             // pRegions
+
+	vk_cmd_image_barrier_gpu_locked(              //
+	    vk,                                       //
+	    cmd,                                      //
+	    img->image,                               //
+	    VK_ACCESS_TRANSFER_WRITE_BIT,             //
+	    VK_ACCESS_SHADER_READ_BIT,                //
+	    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,     //
+	    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, //
+	    subresource_range);                       //
+}
+
+static void
+view_upload_locked(struct comp_passthrough *p, struct comp_passthrough_view *v, struct vk_bundle *vk, VkCommandBuffer cmd)
+{
+	struct xrt_frame *xf = NULL;
+
+	// Grab the latest frame, keep the lock short as the producer waits on it.
+	os_mutex_lock(&p->mutex);
+	xf = v->frame;
+	v->frame = NULL;
+	os_mutex_unlock(&p->mutex);
+
+	if (xf == NULL) {
+		return;
+	}
+
+	// Never write into the image that was last shown.
+	int32_t next = (v->current + 1) % COMP_PASSTHROUGH_RING_SIZE;
+	struct comp_passthrough_image *img = &v->images[next];
+
+	VkExtent2D extent = {xf->width, xf->height};
+	VkResult ret = image_ensure(img, vk, extent);
+	if (ret != VK_SUCCESS) {
+		xrt_frame_reference(&xf, NULL);
+		return;
+	}
+
+	image_write_frame(img, xf);
+	image_record_upload_locked(img, vk, cmd);
+
+	v->current = next;
+
+	xrt_frame_reference(&xf, NULL);
+}
+
+static void
+get_pose_at(struct comp_compositor *c, uint32_t view_index, uint64_t at_timestamp_ns, struct xrt_pose *out_pose)
+{
+	struct xrt_vec3 default_eye_relation = {
+	    0.063000f, /*! @todo get actual ipd_meters */
+	    0.0f,
+	    0.0f,
+	};
+
+	struct xrt_space_relation head_relation = XRT_SPACE_RELATION_ZERO;
+	struct xrt_fov fovs[2] = {0};
+	struct xrt_pose poses[2] = {0};
+
+	xrt_device_get_view_poses( //
+	    c->xdev,               //
+	    &default_eye_relation, //
+	    at_timestamp_ns,       //
+	    2,                     //
+	    &head_relation,        //
+	    fovs,                  //
+	    poses);                //
+
+	struct xrt_space_relation result = {0};
+	struct xrt_relation_chain xrc = {0};
+	m_relation_chain_push_pose_if_not_identity(&xrc, &poses[view_index]);
+	m_relation_chain_push_relation(&xrc, &head_relation);
+	m_relation_chain_resolve(&xrc, &result);
+
+	*out_pose = result.pose;
+}
+
+
+/*
+ *
+ * Sink functions.
+ *
+ */
+
+static void
+push_frame(struct comp_passthrough *p, struct comp_passthrough_view *v, struct xrt_frame *xf)
+{
+	SINK_TRACE_MARKER();
+
+	if (xf->format != XRT_FORMAT_L8 && xf->format != XRT_FORMAT_R8G8B8) {
+		return;
+	}
+
+	// Only keep the latest, older frames are simply replaced.
+	os_mutex_lock(&p->mutex);
+	xrt_frame_reference(&v->frame, xf);
+	os_mutex_unlock(&p->mutex);
+}
+
+static void
+receive_left(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
+{
+	struct comp_passthrough *p = container_of(xfs, struct comp_passthrough, views[0].sink);
+	push_frame(p, &p->views[0], xf);
+}
+
+static void
+receive_right(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
+{
+	struct comp_passthrough *p = container_of(xfs, struct comp_passthrough, views[1].sink);
+	push_frame(p, &p->views[1], xf);
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+VkResult
+comp_passthrough_init(struct comp_passthrough *p, struct vk_bundle *vk)
+{
+	p->enabled = debug_get_bool_option_passthrough();
+	p->fov_deg = debug_get_float_option_passthrough_fov_deg();
+
+	int ret = os_mutex_init(&p->mutex);
+	if (ret != 0) {
+		return VK_ERROR_INITIALIZATION_FAILED;
+	}
+
+	p->views[0].sink.push_frame = receive_left;
+	p->views[1].sink.push_frame = receive_right;
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(p->views); i++) {
+		struct comp_passthrough_view *v = &p->views[i];
+
+		v->current = -1;
+		u_sink_create_to_r8g8b8_or_l8(&p->xfctx, &v->sink, &v->converter);
+	}
+
+	// Don't make the drivers do any work unless asked for, one compositor per process.
+	if (p->enabled) {
+		u_passthrough_set_sinks(p->views[0].converter, p->views[1].converter);
+	}
+
+	return VK_SUCCESS;
+}
+
+void
+comp_passthrough_add_debug_vars(struct comp_passthrough *p, struct comp_compositor *c)
+{
+	u_var_add_root(p, "Passthrough", true);
+	u_var_add_bool(p, &p->enabled, "Show camera passthrough");
+	u_var_add_f32(p, &p->fov_deg, "Source FoV in degrees (0 = device)");
+}
+
+bool
+comp_passthrough_upload_locked(struct comp_passthrough *p, struct vk_bundle *vk, VkCommandBuffer cmd)
+{
+	COMP_TRACE_MARKER();
+
+	if (!p->enabled) {
+		return false;
+	}
+
+	bool ready = true;
+	for (uint32_t i = 0; i < ARRAY_SIZE(p->views); i++) {
+		view_upload_locked(p, &p->views[i], vk, cmd);
+		ready = ready && p->views[i].current >= 0;
+	}
+
+	return ready;
+}
+
+void
+comp_passthrough_get_view(struct comp_passthrough *p,
+                          struct comp_compositor *c,
+                          uint32_t view_index,
+                          VkImageView *out_view,
+                          struct xrt_pose *out_pose,
+                          struct xrt_fov *out_fov)
+{
+	struct comp_passthrough_view *v = &p->views[view_index];
+	struct comp_passthrough_image *img = &v->images[v->current];
+
+	// Without a usable timestamp the frame is shown head locked.
+	uint64_t now_ns = os_monotonic_get_ns();
+	uint64_t at_ns = img->timestamp_ns;
+	if (at_ns == 0 || at_ns > now_ns || at_ns + MAX_FRAME_AGE_NS < now_ns) {
+		at_ns = c->frame.rendering.predicted_display_time_ns;
+	}
+
+	get_pose_at(c, view_index, at_ns, out_pose);
+
+	if (p->fov_deg > 0.0f) {
+		float half = p->fov_deg * (float)M_PI / 360.0f;
+		float aspect = (float)img->extent.height / (float)img->extent.width;
+		float half_v = atanf(tanf(half) * aspect);
+
+		out_fov->angle_left = -half;
+		out_fov->angle_right = half;
+		out_fov->angle_up = half_v;
+		out_fov->angle_down = -half_v;
+	} else {
+		*out_fov = c->base.slot.fovs[view_index];
+	}
+
+	*out_view = img->view;
+}
+
+void
+comp_passthrough_fini(struct comp_passthrough *p, struct vk_bundle *vk)
+{
+	// Remove u_var root as early as possible.
+	u_var_remove_root(p);
+
+	// No more frames after this.
+	u_passthrough_set_sinks(NULL, NULL);
+	xrt_frame_context_destroy_nodes(&p->xfctx);
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(p->views); i++) {
+		struct comp_passthrough_view *v = &p->views[i];
+
+		xrt_frame_reference(&v->frame, NULL);
+
+		for (uint32_t k = 0; k < COMP_PASSTHROUGH_RING_SIZE; k++) {
+			image_fini(&v->images[k], vk);
+		}
+	}
+
+	os_mutex_destroy(&p->mutex);
+}
@@ -0,0 +1,145 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Compositor camera passthrough code.
+ * @ingroup comp_main
+ */
+#pragma once
+
+#include "xrt/xrt_frame.h"
+#include "os/os_threading.h"
+#include "render/render_interface.h"
+#include "main/comp_compositor.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+//! Number of images per view the camera frames are uploaded into.
+#define COMP_PASSTHROUGH_RING_SIZE (3)
+
+
+/*!
+ * One image in the upload ring of a view.
+ *
+ * @ingroup comp_main
+ */
+struct comp_passthrough_image
+{
+	VkImage image;
+	VkImageView view;
+	VkDeviceMemory mem;
+	VkExtent2D extent;
+
+	//! Host visible staging buffer, persistently mapped.
+	struct render_buffer staging;
+
+	//! Capture time of the frame in this image.
+	uint64_t timestamp_ns;
+};
+
+/*!
+ * Per view state, the left and right camera frames arrive independently.
+ *
+ * @ingroup comp_main
+ */
+struct comp_passthrough_view
+{
+	//! Receives frames converted to R8G8B8 or L8.
+	struct xrt_frame_sink sink;
+
+	//! Converts frames before passing them onto @ref sink.
+	struct xrt_frame_sink *converter;
+
+	//! Latest received frame, protected by comp_passthrough::mutex.
+	struct xrt_frame *frame;
+
+	struct comp_passthrough_image images[COMP_PASSTHROUGH_RING_SIZE];
+
+	//! Last uploaded image, negative if there is none.
+	int32_t current;
+};
+
+/*!
+ * Takes camera frames from @ref u_passthrough_set_sinks and uploads them into
+ * a ring of images, so that they can be composited under the application
+ * layers with reprojection. Currently embedded in @ref comp_renderer.
+ *
+ * The images are not undistorted, the cameras are treated as sitting at the
+ * eyes with a configurable field of view.
+ *
+ * @ingroup comp_main
+ */
+struct comp_passthrough
+{
+	//! Frame context for the converters.
+	struct xrt_frame_context xfctx;
+
+	//! Protects the frames in the views.
+	struct os_mutex mutex;
+
+	struct comp_passthrough_view views[2];
+
+	//! Should passthrough be shown, debug gui toggleable.
+	bool enabled;
+
+	//! Source field of view in degrees, zero means use the one of the device.
+	float fov_deg;
+};
+
+/*!
+ * Initialise the struct and registers it as the passthrough consumer if
+ * enabled with `XRT_COMPOSITOR_PASSTHROUGH`.
+ *
+ * @public @memberof comp_passthrough
+ */
+VkResult
+comp_passthrough_init(struct comp_passthrough *p, struct vk_bundle *vk);
+
+/*!
+ * One time adding of the debug variables.
+ *
+ * @public @memberof comp_passthrough
+ */
+void
+comp_passthrough_add_debug_vars(struct comp_passthrough *p, struct comp_compositor *c);
+
+/*!
+ * Upload any new frames, the commands are recorded into @p cmd which needs to
+ * be submitted before the images are sampled. Returns true if there is a image
+ * for both views, and @ref comp_passthrough_get_view can be called.
+ *
+ * @public @memberof comp_passthrough
+ */
+bool
+comp_passthrough_upload_locked(struct comp_passthrough *p, struct vk_bundle *vk, VkCommandBuffer cmd);
+
+/*!
+ * Get the source of a view, the pose is in the same space as the device's
+ * view poses at the time of capture.
+ *
+ * @public @memberof comp_passthrough
+ */
+void
+comp_passthrough_get_view(struct comp_passthrough *p,
+                          struct comp_compositor *c,
+                          uint32_t view_index,
+                          VkImageView *out_view,
+                          struct xrt_pose *out_pose,
+                          struct xrt_fov *out_fov);
+
+/*!
+ * Finalise the struct, frees and resources.
+ *
+ * @public @memberof comp_passthrough
+ */
+void
+comp_passthrough_fini(struct comp_passthrough *p, struct vk_bundle *vk);
+
+
+#ifdef __cplusplus
+}
+#endif
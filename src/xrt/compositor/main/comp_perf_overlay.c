@@ -0,0 +1,504 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  In headset frame timing overlay.
+ * @ingroup comp_main
+ */
+
+#include "os/os_time.h"
+
+#include "util/u_debug.h"
+#include "util/u_misc.h"
+#include "util/u_time.h"
+#include "util/u_pacing.h"
+#include "util/u_trace_marker.h"
+
+#include "vk/vk_helpers.h"
+
+#include "main/comp_perf_overlay.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+
+DEBUG_GET_ONCE_BOOL_OPTION(perf_overlay, "XRT_COMPOSITOR_PERF_OVERLAY", false)
+
+//! The image is written with sRGB values.
+#define IMAGE_FORMAT (VK_FORMAT_R8G8B8A8_SRGB)
+
+//! Height of the label and graph of each row.
+#define ROW_HEIGHT (COMP_PERF_OVERLAY_HEIGHT / COMP_PERF_OVERLAY_GRAPH_COUNT)
+#define LABEL_HEIGHT (14)
+#define GRAPH_HEIGHT (ROW_HEIGHT - LABEL_HEIGHT - 2)
+
+//! The glyphs are 3x5 pixels, drawn at twice the size with a pixel between them.
+#define GLYPH_SCALE (2)
+#define GLYPH_ADVANCE (4 * GLYPH_SCALE)
+
+//! Number of frame records read at a time.
+#define RECORD_BATCH (32)
+
+enum graph_index
+{
+	GRAPH_CPU = 0,
+	GRAPH_GPU = 1,
+	GRAPH_APP = 2,
+	GRAPH_PREDICTION = 3,
+};
+
+struct rgba
+{
+	uint8_t r, g, b, a;
+};
+
+// Premultiplied, the layer is composited as such.
+static const struct rgba background = {0, 0, 0, 170};
+static const struct rgba reference_line = {110, 110, 110, 255};
+static const struct rgba text_colour = {255, 255, 255, 255};
+static const struct rgba missed_colour = {255, 60, 60, 255};
+
+static const struct rgba graph_colours[COMP_PERF_OVERLAY_GRAPH_COUNT] = {
+    [GRAPH_CPU] = {80, 220, 80, 255},
+    [GRAPH_GPU] = {80, 160, 255, 255},
+    [GRAPH_APP] = {230, 200, 60, 255},
+    [GRAPH_PREDICTION] = {220, 100, 220, 255},
+};
+
+static const char *graph_names[COMP_PERF_OVERLAY_GRAPH_COUNT] = {
+    [GRAPH_CPU] = "CPU",
+    [GRAPH_GPU] = "GPU",
+    [GRAPH_APP] = "APP",
+    [GRAPH_PREDICTION] = "PRED",
+};
+
+
+/*
+ *
+ * Helper functions.
+ *
+ */
+
+/*!
+ * Calls `vkDestroy##TYPE` on `THING` if it is not `VK_NULL_HANDLE`, sets it to
+ * `VK_NULL_HANDLE` afterwards.
+ */
+#define D(TYPE, THING)                                                                                                 \
+	if (THING != VK_NULL_HANDLE) {                                                                                 \
+		vk->vkDestroy##TYPE(vk->device, THING, NULL);                                                          \
+		THING = VK_NULL_HANDLE;                                                                                \
+	}
+
+/*!
+ * Calls `vkFree##TYPE` on `THING` if it is not `VK_NULL_HANDLE`, sets it to
+ * `VK_NULL_HANDLE` afterwards.
+ */
+#define DF(TYPE, THING)                                                                                                \
+	if (THING != VK_NULL_HANDLE) {                                                                                 \
+		vk->vkFree##TYPE(vk->device, THING, NULL);                                                             \
+		THING = VK_NULL_HANDLE;                                                                                \
+	}
+
+/*!
+ * Rows of a 3x5 glyph, the high bit of the three is the left most pixel, only
+ * the characters used by the labels are there.
+ */
+static const uint8_t *
+get_glyph(char ch)
+{
+	static const uint8_t digits[10][5] = {
+	    {7, 5, 5, 5, 7}, {2, 6, 2, 2, 7}, {7, 1, 7, 4, 7}, {7, 1, 7, 1, 7}, {5, 5, 7, 1, 1},
+	    {7, 4, 7, 1, 7}, {7, 4, 7, 5, 7}, {7, 1, 1, 1, 1}, {7, 5, 7, 5, 7}, {7, 5, 7, 1, 7},
+	};
+	static const uint8_t dot[5] = {0, 0, 0, 0, 2};
+	static const uint8_t minus[5] = {0, 0, 7, 0, 0};
+	static const uint8_t letter_a[5] = {7, 5, 7, 5, 5};
+	static const uint8_t letter_c[5] = {7, 4, 4, 4, 7};
+	static const uint8_t letter_d[5] = {6, 5, 5, 5, 6};
+	static const uint8_t letter_e[5] = {7, 4, 7, 4, 7};
+	static const uint8_t letter_g[5] = {7, 4, 5, 5, 7};
+	static const uint8_t letter_i[5] = {7, 2, 2, 2, 7};
+	static const uint8_t letter_m[5] = {5, 7, 7, 5, 5};
+	static const uint8_t letter_p[5] = {7, 5, 7, 4, 4};
+	static const uint8_t letter_r[5] = {6, 5, 6, 5, 5};
+	static const uint8_t letter_s[5] = {7, 4, 7, 1, 7};
+	static const uint8_t letter_u[5] = {5, 5, 5, 5, 7};
+
+	if (ch >= '0' && ch <= '9') {
+		return digits[ch - '0'];
+	}
+
+	switch (ch) {
+	case '.': return dot;
+	case '-': return minus;
+	case 'A': return letter_a;
+	case 'C': return letter_c;
+	case 'D': return letter_d;
+	case 'E': return letter_e;
+	case 'G': return letter_g;
+	case 'I': return letter_i;
+	case 'M': return letter_m;
+	case 'P': return letter_p;
+	case 'R': return letter_r;
+	case 'S': return letter_s;
+	case 'U': return letter_u;
+	default: return NULL;
+	}
+}
+
+static inline void
+put_pixel(uint8_t *pixels, int32_t x, int32_t y, struct rgba colour)
+{
+	if (x < 0 || y < 0 || x >= COMP_PERF_OVERLAY_WIDTH || y >= COMP_PERF_OVERLAY_HEIGHT) {
+		return;
+	}
+
+	uint8_t *p = pixels + ((size_t)y * COMP_PERF_OVERLAY_WIDTH + (size_t)x) * 4;
+	p[0] = colour.r;
+	p[1] = colour.g;
+	p[2] = colour.b;
+	p[3] = colour.a;
+}
+
+static void
+draw_text(uint8_t *pixels, int32_t x, int32_t y, const char *str, struct rgba colour)
+{
+	for (; *str != '\0'; str++, x += GLYPH_ADVANCE) {
+		const uint8_t *glyph = get_glyph(*str);
+		if (glyph == NULL) {
+			continue;
+		}
+
+		for (int32_t row = 0; row < 5 * GLYPH_SCALE; row++) {
+			for (int32_t col = 0; col < 3 * GLYPH_SCALE; col++) {
+				if ((glyph[row / GLYPH_SCALE] & (4 >> (col / GLYPH_SCALE))) != 0) {
+					put_pixel(pixels, x + col, y + row, colour);
+				}
+			}
+		}
+	}
+}
+
+static void
+graph_push(struct comp_perf_overlay_graph *graph, float value_ms, bool missed)
+{
+	graph->values_ms[graph->next] = value_ms;
+	graph->missed[graph->next] = missed;
+	graph->next = (graph->next + 1) % COMP_PERF_OVERLAY_WIDTH;
+}
+
+static float
+graph_latest(const struct comp_perf_overlay_graph *graph)
+{
+	return graph->values_ms[(graph->next + COMP_PERF_OVERLAY_WIDTH - 1) % COMP_PERF_OVERLAY_WIDTH];
+}
+
+static float
+duration_ms(uint64_t start_ns, uint64_t end_ns)
+{
+	if (end_ns <= start_ns) {
+		return 0.0f;
+	}
+
+	return (float)time_ns_to_ms_f((time_duration_ns)(end_ns - start_ns));
+}
+
+/*!
+ * Adds the compositor frames that have finished since the last call and the
+ * app and prediction values of the frame about to be rendered.
+ */
+static void
+update_graphs(struct comp_perf_overlay *po, struct comp_compositor *c)
+{
+	struct u_pc_frame_record records[RECORD_BATCH];
+	uint32_t count;
+
+	do {
+		count = u_pc_frame_records_read(&po->next_record, records, ARRAY_SIZE(records));
+
+		for (uint32_t i = 0; i < count; i++) {
+			const struct u_pc_frame_record *rec = &records[i];
+			bool missed = (rec->flags & U_PC_FRAME_RECORD_MISSED_BIT) != 0;
+			float cpu_ms = 0.0f;
+			float gpu_ms = 0.0f;
+
+			if ((rec->flags & U_PC_FRAME_RECORD_CPU_BIT) != 0) {
+				cpu_ms = duration_ms(rec->cpu_begin_ns, rec->cpu_end_ns);
+			}
+			if ((rec->flags & U_PC_FRAME_RECORD_GPU_BIT) != 0) {
+				gpu_ms = duration_ms(rec->gpu_start_ns, rec->gpu_end_ns);
+			}
+			if (missed) {
+				po->miss_count++;
+			}
+
+			graph_push(&po->graphs[GRAPH_CPU], cpu_ms, missed);
+			graph_push(&po->graphs[GRAPH_GPU], gpu_ms, missed);
+		}
+	} while (count == RECORD_BATCH);
+
+	uint64_t now_ns = os_monotonic_get_ns();
+
+	// A new frame from the app, the interval since the last one.
+	int64_t app_frame_id = c->base.slot.data.frame_id;
+	if (app_frame_id != po->last_app_frame_id) {
+		if (po->last_app_frame_ns != 0) {
+			graph_push(&po->graphs[GRAPH_APP], duration_ms(po->last_app_frame_ns, now_ns), false);
+		}
+		po->last_app_frame_id = app_frame_id;
+		po->last_app_frame_ns = now_ns;
+	}
+
+	// How far ahead the poses of this frame are predicted.
+	float horizon_ms = duration_ms(now_ns, c->frame.rendering.predicted_display_time_ns);
+	graph_push(&po->graphs[GRAPH_PREDICTION], horizon_ms, false);
+}
+
+static void
+draw(struct comp_perf_overlay *po, struct comp_compositor *c)
+{
+	uint8_t *pixels = (uint8_t *)po->staging.mapped;
+
+	for (int32_t y = 0; y < COMP_PERF_OVERLAY_HEIGHT; y++) {
+		for (int32_t x = 0; x < COMP_PERF_OVERLAY_WIDTH; x++) {
+			put_pixel(pixels, x, y, background);
+		}
+	}
+
+	// The graphs go up to two frame intervals, with a line at one.
+	float interval_ms = (float)time_ns_to_ms_f((time_duration_ns)c->settings.nominal_frame_interval_ns);
+	float full_scale_ms = interval_ms > 0.0f ? interval_ms * 2.0f : 22.0f;
+
+	for (uint32_t g = 0; g < COMP_PERF_OVERLAY_GRAPH_COUNT; g++) {
+		const struct comp_perf_overlay_graph *graph = &po->graphs[g];
+		int32_t top = (int32_t)g * ROW_HEIGHT;
+		int32_t bottom = top + LABEL_HEIGHT + GRAPH_HEIGHT;
+		char str[32];
+
+		snprintf(str, sizeof(str), "%s %.1f", graph_names[g], graph_latest(graph));
+		draw_text(pixels, 4, top + 2, str, graph_colours[g]);
+
+		if (g == GRAPH_CPU) {
+			snprintf(str, sizeof(str), "MISS %" PRIu64, po->miss_count);
+			int32_t x = COMP_PERF_OVERLAY_WIDTH - 4 - (int32_t)strlen(str) * GLYPH_ADVANCE;
+			draw_text(pixels, x, top + 2, str, po->miss_count > 0 ? missed_colour : text_colour);
+		}
+
+		// Oldest on the left.
+		for (int32_t x = 0; x < COMP_PERF_OVERLAY_WIDTH; x++) {
+			uint32_t index = (graph->next + (uint32_t)x) % COMP_PERF_OVERLAY_WIDTH;
+			float fraction = graph->values_ms[index] / full_scale_ms;
+			fraction = fraction < 0.0f ? 0.0f : fraction > 1.0f ? 1.0f : fraction;
+
+			struct rgba colour = graph->missed[index] ? missed_colour : graph_colours[g];
+			int32_t height = (int32_t)(fraction * (float)GRAPH_HEIGHT + 0.5f);
+
+			for (int32_t y = bottom - height; y < bottom; y++) {
+				put_pixel(pixels, x, y, colour);
+			}
+
+			put_pixel(pixels, x, bottom - GRAPH_HEIGHT / 2, reference_line);
+		}
+	}
+}
+
+static void
+image_fini(struct comp_perf_overlay *po, struct vk_bundle *vk)
+{
+	D(ImageView, po->view);
+	D(Image, po->image);
+	DF(Memory, po->mem);
+	render_buffer_close(vk, &po->staging);
+}
+
+static VkResult
+image_ensure(struct comp_perf_overlay *po, struct vk_bundle *vk)
+{
+	VkResult ret;
+
+	if (po->image != VK_NULL_HANDLE) {
+		return VK_SUCCESS;
+	}
+
+	VkExtent2D extent = {COMP_PERF_OVERLAY_WIDTH, COMP_PERF_OVERLAY_HEIGHT};
+	VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+	VkImageSubresourceRange subresource_range = {
+	    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	    .baseMipLevel = 0,
+	    .levelCount = 1,
+	    .baseArrayLayer = 0,
+	    .layerCount = 1,
+	};
+
+	ret = vk_create_image_simple( //
+	    vk,                       // vk_bundle
+	    extent,                   // extent
+	    IMAGE_FORMAT,             // format
+	    usage,                    // usage
+	    &po->mem,                 // out_mem
+	    &po->image);              // out_image
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vk_create_image_simple: %s", vk_result_string(ret));
+		image_fini(po, vk);
+		return ret;
+	}
+
+	ret = vk_create_view(      //
+	    vk,                    // vk_bundle
+	    po->image,             // image
+	    VK_IMAGE_VIEW_TYPE_2D, // type
+	    IMAGE_FORMAT,          // format
+	    subresource_range,     // subresource_range
+	    &po->view);            // out_view
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vk_create_view: %s", vk_result_string(ret));
+		image_fini(po, vk);
+		return ret;
+	}
+
+	VkBufferUsageFlags buffer_usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	VkMemoryPropertyFlags memory_property_flags =
+	    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	VkDeviceSize size = (VkDeviceSize)extent.width * extent.height * 4;
+
+	ret = render_buffer_init(vk, &po->staging, buffer_usage, memory_property_flags, size);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "render_buffer_init: %s", vk_result_string(ret));
+		image_fini(po, vk);
+		return ret;
+	}
+
+	ret = render_buffer_map(vk, &po->staging);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "render_buffer_map: %s", vk_result_string(ret));
+		image_fini(po, vk);
+		return ret;
+	}
+
+	return VK_SUCCESS;
+}
+
+static void
+image_record_upload_locked(struct comp_perf_overlay *po, struct vk_bundle *vk, VkCommandBuffer cmd)
+{
+	VkImageSubresourceRange subresource_range = {
+	    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	    .baseMipLevel = 0,
+	    .levelCount = 1,
+	    .baseArrayLayer = 0,
+	    .layerCount = 1,
+	};
+
+	// Old content is not needed, the whole image is overwritten.
+	vk_cmd_image_barrier_gpu_locked(          //
+	    vk,                                   //
+	    cmd,                                  //
+	    po->image,                            //
+	    0,                                    //
+	    VK_ACCESS_TRANSFER_WRITE_BIT,         //
+	    VK_IMAGE_LAYOUT_UNDEFINED,            //
+	    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, //
+	    subresource_range);                   //
+
+	VkBufferImageCopy region = {
+	    .bufferOffset = 0,
+	    .bufferRowLength = 0,
+	    .bufferImageHeight = 0,
+	    .imageSubresource =
+	        {
+	            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	            .mipLevel = 0,
+	            .baseArrayLayer = 0,
+	            .layerCount = 1,
+	        },
+	    .imageOffset = {0, 0, 0},
+	    .imageExtent = {COMP_PERF_OVERLAY_WIDTH, COMP_PERF_OVERLAY_HEIGHT, 1},
+	};
+
+	vk->vkCmdCopyBufferToImage(               //
+	    cmd,                                  // commandBuffer
+	    po->staging.buffer,                   // srcBuffer
+	    po->image,                            // dstImage
+	    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, // dstImageLayout
+	    1,                                    // regionCount
+	    &region);                             // pRegions
+
+	vk_cmd_image_barrier_gpu_locked(              //
+	    vk,                                       //
+	    cmd,                                      //
+	    po->image,                                //
+	    VK_ACCESS_TRANSFER_WRITE_BIT,             //
+	    VK_ACCESS_SHADER_READ_BIT,                //
+	    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,     //
+	    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, //
+	    subresource_range);                       //
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+void
+comp_perf_overlay_init(struct comp_perf_overlay *po)
+{
+	if (debug_get_bool_option_perf_overlay()) {
+		u_pc_overlay_set_enabled(true);
+	}
+
+	// The views are pointed at the image once it is created.
+	po->sc.images[0].views.alpha = &po->view;
+	po->sc.images[0].views.no_alpha = &po->view;
+	po->sc.images[0].array_size = 1;
+
+	// Head locked, a bit below the centre of the view.
+	struct xrt_layer_data *data = &po->layer.data;
+	data->type = XRT_LAYER_QUAD;
+	data->flags = XRT_LAYER_COMPOSITION_VIEW_SPACE_BIT | XRT_LAYER_COMPOSITION_BLEND_TEXTURE_SOURCE_ALPHA_BIT;
+	data->flip_y = false;
+	data->quad.visibility = XRT_LAYER_EYE_VISIBILITY_BOTH;
+	data->quad.sub.image_index = 0;
+	data->quad.sub.array_index = 0;
+	data->quad.sub.norm_rect = (struct xrt_normalized_rect){0.0f, 0.0f, 1.0f, 1.0f};
+	data->quad.pose = (struct xrt_pose){XRT_QUAT_IDENTITY, {0.0f, -0.15f, -0.8f}};
+	data->quad.size = (struct xrt_vec2){0.32f, 0.2f};
+	po->layer.sc_array[0] = &po->sc;
+
+	po->last_app_frame_id = -1;
+}
+
+const struct comp_layer *
+comp_perf_overlay_update_locked(struct comp_perf_overlay *po,
+                                struct comp_compositor *c,
+                                struct vk_bundle *vk,
+                                VkCommandBuffer cmd)
+{
+	COMP_TRACE_MARKER();
+
+	// Always keep the graphs going, so there is something to see when turned on.
+	update_graphs(po, c);
+
+	if (!u_pc_overlay_get_enabled()) {
+		return NULL;
+	}
+
+	if (image_ensure(po, vk) != VK_SUCCESS) {
+		return NULL;
+	}
+
+	// The renderer waits for the queue to be idle after each frame, so the buffer is free.
+	draw(po, c);
+	image_record_upload_locked(po, vk, cmd);
+
+	return &po->layer;
+}
+
+void
+comp_perf_overlay_fini(struct comp_perf_overlay *po, struct vk_bundle *vk)
+{
+	image_fini(po, vk);
+}
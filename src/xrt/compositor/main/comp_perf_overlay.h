@@ -0,0 +1,122 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  In headset frame timing overlay.
+ * @ingroup comp_main
+ */
+#pragma once
+
+#include "render/render_interface.h"
+#include "util/comp_swapchain.h"
+#include "main/comp_compositor.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+//! Size of the overlay image in pixels, one column of the graphs per frame.
+#define COMP_PERF_OVERLAY_WIDTH (256)
+#define COMP_PERF_OVERLAY_HEIGHT (160)
+
+//! Number of graphs on the overlay.
+#define COMP_PERF_OVERLAY_GRAPH_COUNT (4)
+
+
+/*!
+ * The latest values of one of the graphs, one per column.
+ *
+ * @ingroup comp_main
+ */
+struct comp_perf_overlay_graph
+{
+	float values_ms[COMP_PERF_OVERLAY_WIDTH];
+
+	//! Frames that missed their present time are drawn in red.
+	bool missed[COMP_PERF_OVERLAY_WIDTH];
+
+	//! Where the next value goes, the oldest one is there.
+	uint32_t next;
+};
+
+/*!
+ * Draws graphs of the compositor CPU and GPU time, the frame interval of the
+ * app and the pose prediction horizon into an image that is composited as a
+ * view space quad on top of all of the layers. Turned on and off with
+ * @ref u_pc_overlay_set_enabled, for example from `monado-ctl`, or with
+ * `XRT_COMPOSITOR_PERF_OVERLAY`. Currently embedded in @ref comp_renderer.
+ *
+ * The graphs are drawn on the CPU into a persistently mapped staging buffer
+ * and uploaded every frame, they are tiny compared to the views.
+ *
+ * @ingroup comp_main
+ */
+struct comp_perf_overlay
+{
+	VkImage image;
+	VkImageView view;
+	VkDeviceMemory mem;
+
+	//! Host visible staging buffer, persistently mapped.
+	struct render_buffer staging;
+
+	/*!
+	 * Only the views of the first image are set, lets the overlay go
+	 * through the same code as the quad layers of apps.
+	 */
+	struct comp_swapchain sc;
+
+	//! The layer returned by @ref comp_perf_overlay_update_locked.
+	struct comp_layer layer;
+
+	//! CPU, GPU, app and prediction graphs.
+	struct comp_perf_overlay_graph graphs[COMP_PERF_OVERLAY_GRAPH_COUNT];
+
+	//! Next frame record to read.
+	uint32_t next_record;
+
+	//! Total number of frames that missed their present time.
+	uint64_t miss_count;
+
+	//! To detect new frames from the app.
+	int64_t last_app_frame_id;
+	uint64_t last_app_frame_ns;
+};
+
+/*!
+ * Initialise the struct, the Vulkan resources are only created once the
+ * overlay is first shown.
+ *
+ * @public @memberof comp_perf_overlay
+ */
+void
+comp_perf_overlay_init(struct comp_perf_overlay *po);
+
+/*!
+ * Update the graphs and if the overlay is enabled draw and upload them, the
+ * commands are recorded into @p cmd which needs to be submitted before the
+ * image is sampled. Returns the layer to composite on top of all others, or
+ * NULL if the overlay is not shown.
+ *
+ * @public @memberof comp_perf_overlay
+ */
+const struct comp_layer *
+comp_perf_overlay_update_locked(struct comp_perf_overlay *po,
+                                struct comp_compositor *c,
+                                struct vk_bundle *vk,
+                                VkCommandBuffer cmd);
+
+/*!
+ * Finalise the struct, frees and resources.
+ *
+ * @public @memberof comp_perf_overlay
+ */
+void
+comp_perf_overlay_fini(struct comp_perf_overlay *po, struct vk_bundle *vk);
+
+
+#ifdef __cplusplus
+}
+#endif
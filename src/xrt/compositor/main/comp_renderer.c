@@ -31,6 +31,8 @@
 #include "main/comp_layer_renderer.h"
 #include "main/comp_frame.h"
 #include "main/comp_mirror_to_debug_gui.h"
+#include "main/comp_passthrough.h"
+#include "main/comp_perf_overlay.h"
 
 #ifdef XRT_FEATURE_WINDOW_PEEK
 #include "main/comp_window_peek.h"
@@ -46,6 +48,7 @@
 #include <stdio.h>
 #include <assert.h>
 #include <math.h>
+#include <float.h>
 #include <inttypes.h>
 
 
@@ -61,6 +64,9 @@
 		NEXT = (VkBaseInStructure *)&(STRUCT);                                                                 \
 	} while (false)
 
+//! Number of frames a layer must be unchanged for before it is squashed into the layer cache.
+#define COMP_RENDERER_LAYER_CACHE_STABLE_FRAMES (4)
+
 
 /*
  *
@@ -68,6 +74,44 @@
  *
  */
 
+/*!
+ * A timewarp matrix in a mapped UBO, recalculated with a new pose right before
+ * the command buffer reading it is submitted.
+ */
+struct comp_renderer_late_latch_entry
+{
+	//! Matrix to rewrite, points into the mapped memory of a UBO.
+	struct xrt_matrix_4x4 *transform;
+
+	//! Which view the matrix is for.
+	uint32_t view_index;
+
+	//! Pose and fov the application rendered the source with.
+	struct xrt_pose src_pose;
+	struct xrt_fov src_fov;
+
+	//! Positional timewarp matrix to also rewrite, may be NULL.
+	struct xrt_matrix_4x4 *reprojection;
+};
+
+/*!
+ * What a layer squashed into the layer cache was made from, if any of it
+ * changes the layer needs to be squashed again.
+ */
+struct comp_renderer_layer_cache_key
+{
+	//! Release count changes when the application renders to the swapchain.
+	const struct comp_swapchain *sc;
+	uint64_t release_count;
+
+	//! The sampled image view, guards against reused swapchain pointers.
+	VkImageView view;
+
+	enum xrt_layer_composition_flags flags;
+	bool flip_y;
+	struct xrt_layer_quad_data quad;
+};
+
 /*!
  * Holds associated vulkan objects and state to render with a distortion.
  *
@@ -85,6 +129,44 @@ struct comp_renderer
 
 	struct comp_mirror_to_debug_gui mirror_to_debug_gui;
 
+	//! Camera frames composited under the layers, compute path only.
+	struct comp_passthrough passthrough;
+
+	//! Frame timing graphs composited over the layers, compute path only.
+	struct comp_perf_overlay perf_overlay;
+
+	//! Timewarp matrices of the frame being recorded, compute path only.
+	struct
+	{
+		struct comp_renderer_late_latch_entry entries[COMP_MAX_LAYERS * COMP_VIEWS_PER_LAYER];
+		uint32_t entry_count;
+	} late_latch;
+
+	/*!
+	 * View space quad layers on top of all other layers that have not
+	 * changed for a while are squashed into render_resources::scratch::cache
+	 * and sampled as one layer, compute path only.
+	 */
+	struct
+	{
+		//! Keys of the layers of the last frame.
+		struct comp_renderer_layer_cache_key keys[COMP_MAX_LAYERS];
+		//! Number of frames each layer has been unchanged for.
+		uint32_t stable_frames[COMP_MAX_LAYERS];
+		uint32_t key_count;
+
+		//! Eye poses relative to the head of the last frame.
+		struct xrt_pose eye_poses[2];
+
+		//! Does the cache image hold the layers [first, first + count).
+		bool valid;
+		uint32_t first;
+		uint32_t count;
+
+		//! Cache image squashed into, it's recreated with the scratch image.
+		VkImage image;
+	} layer_cache;
+
 	//! @}
 
 	//! @name Image-dependent members
@@ -129,6 +211,82 @@ struct comp_renderer
  *
  */
 
+/*!
+ * The swapchain images read by @p layer, returns the number of them written to
+ * @p out_scs and @p out_indices, which must both hold four elements.
+ */
+static uint32_t
+get_layer_images(const struct comp_layer *layer, struct comp_swapchain **out_scs, uint32_t *out_indices)
+{
+	const struct xrt_layer_data *data = &layer->data;
+	uint32_t count = 0;
+
+#define ADD(INDEX, SUB)                                                                                                \
+	do {                                                                                                           \
+		out_scs[count] = layer->sc_array[INDEX];                                                               \
+		out_indices[count] = (SUB).image_index;                                                                \
+		count++;                                                                                               \
+	} while (false)
+
+	switch (data->type) {
+	case XRT_LAYER_STEREO_PROJECTION:
+		ADD(0, data->stereo.l.sub);
+		ADD(1, data->stereo.r.sub);
+		break;
+	case XRT_LAYER_STEREO_PROJECTION_DEPTH:
+		ADD(0, data->stereo_depth.l.sub);
+		ADD(1, data->stereo_depth.r.sub);
+		ADD(2, data->stereo_depth.l_d.sub);
+		ADD(3, data->stereo_depth.r_d.sub);
+		break;
+	case XRT_LAYER_QUAD: ADD(0, data->quad.sub); break;
+	case XRT_LAYER_CYLINDER: ADD(0, data->cylinder.sub); break;
+	case XRT_LAYER_EQUIRECT2: ADD(0, data->equirect2.sub); break;
+	case XRT_LAYER_CUBE: ADD(0, data->cube.sub); break;
+	default: break;
+	}
+
+#undef ADD
+
+	return count;
+}
+
+/*!
+ * Sets the value the release semaphore of every swapchain image read by this
+ * frame will reach, and collects those semaphores, each only once, into
+ * @p out_sems which must hold COMP_MAX_LAYERS * 4 elements.
+ */
+static uint32_t
+mark_layer_images_read(struct comp_renderer *r, uint64_t value, VkSemaphore *out_sems)
+{
+	const struct comp_layer *layers = r->c->base.slot.layers;
+	uint32_t layer_count = r->c->base.slot.layer_count;
+	uint32_t sem_count = 0;
+
+	for (uint32_t i = 0; i < layer_count; i++) {
+		struct comp_swapchain *scs[4];
+		uint32_t indices[4];
+		uint32_t count = get_layer_images(&layers[i], scs, indices);
+
+		for (uint32_t k = 0; k < count; k++) {
+			if (scs[k] == NULL || !comp_swapchain_mark_image_read(scs[k], indices[k], value)) {
+				continue;
+			}
+
+			bool found = false;
+			for (uint32_t n = 0; n < sem_count && !found; n++) {
+				found = out_sems[n] == scs[k]->release.semaphore;
+			}
+
+			if (!found) {
+				out_sems[sem_count++] = scs[k]->release.semaphore;
+			}
+		}
+	}
+
+	return sem_count;
+}
+
 static void
 renderer_wait_queue_idle(struct comp_renderer *r)
 {
@@ -468,6 +626,24 @@ renderer_create_layer_renderer(struct comp_renderer *r)
  * @private @memberof comp_renderer
  * @ingroup comp_main
  */
+/*!
+ * The present mode for the selected latency mode, the target falls back to
+ * FIFO if the surface doesn't support it.
+ *
+ * @private @memberof comp_renderer
+ * @ingroup comp_main
+ */
+static VkPresentModeKHR
+renderer_select_present_mode(struct comp_renderer *r)
+{
+	switch (r->settings->latency_mode) {
+	case COMP_LATENCY_MODE_FIFO: return VK_PRESENT_MODE_FIFO_KHR;
+	case COMP_LATENCY_MODE_MAILBOX: return VK_PRESENT_MODE_MAILBOX_KHR;
+	case COMP_LATENCY_MODE_FIFO_RELAXED: return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+	default: return r->settings->present_mode;
+	}
+}
+
 static bool
 renderer_ensure_images_and_renderings(struct comp_renderer *r, bool force_recreate)
 {
@@ -509,14 +685,14 @@ renderer_ensure_images_and_renderings(struct comp_renderer *r, bool force_recrea
 		image_usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
 	}
 
-	comp_target_create_images(           //
-	    r->c->target,                    //
-	    r->c->settings.preferred.width,  //
-	    r->c->settings.preferred.height, //
-	    r->settings->color_format,       //
-	    r->settings->color_space,        //
-	    image_usage,                     //
-	    r->settings->present_mode);      //
+	comp_target_create_images(            //
+	    r->c->target,                     //
+	    r->c->settings.preferred.width,   //
+	    r->c->settings.preferred.height,  //
+	    r->settings->color_format,        //
+	    r->settings->color_space,         //
+	    image_usage,                      //
+	    renderer_select_present_mode(r)); //
 
 	bool pre_rotate = false;
 	if (r->c->target->surface_transform & VK_SURFACE_TRANSFORM_ROTATE_90_BIT_KHR ||
@@ -559,6 +735,14 @@ renderer_init(struct comp_renderer *r, struct comp_compositor *c)
 		COMP_ERROR(c, "comp_mirror_init: %s", vk_result_string(ret));
 		assert(false && "Whelp, can't return a error. But should never really fail.");
 	}
+
+	ret = comp_passthrough_init(&r->passthrough, vk);
+	if (ret != VK_SUCCESS) {
+		COMP_ERROR(c, "comp_passthrough_init: %s", vk_result_string(ret));
+		assert(false && "Whelp, can't return a error. But should never really fail.");
+	}
+
+	comp_perf_overlay_init(&r->perf_overlay);
 }
 
 static void
@@ -627,21 +811,34 @@ renderer_submit_queue(struct comp_renderer *r, VkCommandBuffer cmd, VkPipelineSt
 	// Next pointer for VkSubmitInfo
 	const void *next = NULL;
 
+	// The render complete semaphore first, then the release semaphores of the swapchains.
+	VkSemaphore signal_sems[1 + COMP_MAX_LAYERS * 4] = {ct->semaphores.render_complete};
+	uint32_t signal_sem_count = 1;
+
 #ifdef VK_KHR_timeline_semaphore
 	assert(!comp_frame_is_invalid_locked(&r->c->frame.rendering));
-	uint64_t render_complete_signal_values[WAIT_SEMAPHORE_COUNT] = {(uint64_t)r->c->frame.rendering.id};
+	uint64_t frame_value = (uint64_t)r->c->frame.rendering.id;
+
+	/*
+	 * Marked before the submit so an application acquiring the image again
+	 * never sees the value of an older read, waiting before the signal has
+	 * been submitted is allowed for timeline semaphores.
+	 */
+	signal_sem_count += mark_layer_images_read(r, frame_value, &signal_sems[1]);
+
+	// Binary semaphores ignore their value.
+	uint64_t signal_values[1 + COMP_MAX_LAYERS * 4];
+	for (uint32_t i = 0; i < signal_sem_count; i++) {
+		signal_values[i] = frame_value;
+	}
 
 	VkTimelineSemaphoreSubmitInfoKHR timeline_info = {
 	    .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR,
+	    .signalSemaphoreValueCount = signal_sem_count,
+	    .pSignalSemaphoreValues = signal_values,
 	};
 
-	if (ct->semaphores.render_complete_is_timeline) {
-		timeline_info = (VkTimelineSemaphoreSubmitInfoKHR){
-		    .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR,
-		    .signalSemaphoreValueCount = WAIT_SEMAPHORE_COUNT,
-		    .pSignalSemaphoreValues = render_complete_signal_values,
-		};
-
+	if (ct->semaphores.render_complete_is_timeline || signal_sem_count > 1) {
 		CHAIN(timeline_info, next);
 	}
 #endif
@@ -655,8 +852,8 @@ renderer_submit_queue(struct comp_renderer *r, VkCommandBuffer cmd, VkPipelineSt
 	    .waitSemaphoreCount = wait_sem_count,
 	    .commandBufferCount = 1,
 	    .pCommandBuffers = &cmd,
-	    .signalSemaphoreCount = 1,
-	    .pSignalSemaphores = &ct->semaphores.render_complete,
+	    .signalSemaphoreCount = signal_sem_count,
+	    .pSignalSemaphores = signal_sems,
 	};
 
 	/*
@@ -807,6 +1004,8 @@ renderer_fini(struct comp_renderer *r)
 
 	// Do before layer render just in case it holds any references.
 	comp_mirror_fini(&r->mirror_to_debug_gui, vk);
+	comp_passthrough_fini(&r->passthrough, vk);
+	comp_perf_overlay_fini(&r->perf_overlay, vk);
 
 	// Do this after the mirror struct.
 	comp_layer_renderer_destroy(&(r->lr));
@@ -1005,6 +1204,166 @@ get_view_poses(struct comp_renderer *r, struct xrt_pose out_world[2], struct xrt
 	}
 }
 
+/*!
+ * Projects the gaze of the eye tracker into the view uv of both views, the
+ * space the foveation centres are given in. For the distortion pass this
+ * ignores the distortion, which is small around the gaze.
+ */
+static bool
+calc_gaze_centers(struct comp_renderer *r, struct xrt_vec2 out_centers[2])
+{
+	struct comp_compositor *c = r->c;
+	uint64_t display_time_ns = c->frame.rendering.predicted_display_time_ns;
+
+	// Without a common origin the gaze can't be related to the head.
+	if (c->eyes->tracking_origin != c->xdev->tracking_origin) {
+		return false;
+	}
+
+	struct xrt_space_relation gaze_relation = XRT_SPACE_RELATION_ZERO;
+	xrt_device_get_tracked_pose(c->eyes, XRT_INPUT_GENERIC_EYE_GAZE_POSE, display_time_ns, &gaze_relation);
+	if ((gaze_relation.relation_flags & XRT_SPACE_RELATION_ORIENTATION_VALID_BIT) == 0) {
+		return false;
+	}
+
+	struct xrt_vec3 default_eye_relation = {
+	    0.063000f, /*! @todo get actual ipd_meters */
+	    0.0f,
+	    0.0f,
+	};
+
+	struct xrt_space_relation head_relation = XRT_SPACE_RELATION_ZERO;
+	struct xrt_fov fovs[2] = {0};
+	struct xrt_pose eye_poses[2] = {0};
+
+	xrt_device_get_view_poses( //
+	    c->xdev,               //
+	    &default_eye_relation, //
+	    display_time_ns,       //
+	    2,                     //
+	    &head_relation,        //
+	    fovs,                  //
+	    eye_poses);            //
+
+	if ((head_relation.relation_flags & XRT_SPACE_RELATION_ORIENTATION_VALID_BIT) == 0) {
+		return false;
+	}
+
+	// Gaze direction in head space, far enough away to ignore where the eyes are.
+	struct xrt_vec3 forward = {0.0f, 0.0f, -1.0f};
+	struct xrt_vec3 gaze_dir;
+	struct xrt_vec3 head_dir;
+	struct xrt_quat head_inv;
+	math_quat_rotate_vec3(&gaze_relation.pose.orientation, &forward, &gaze_dir);
+	math_quat_invert(&head_relation.pose.orientation, &head_inv);
+	math_quat_rotate_vec3(&head_inv, &gaze_dir, &head_dir);
+
+	for (uint32_t i = 0; i < 2; i++) {
+		struct xrt_vec3 dir;
+		struct xrt_quat eye_inv;
+		math_quat_invert(&eye_poses[i].orientation, &eye_inv);
+		math_quat_rotate_vec3(&eye_inv, &head_dir, &dir);
+
+		// Looking behind the view.
+		if (dir.z >= -0.001f) {
+			return false;
+		}
+
+		float tan_x = dir.x / -dir.z;
+		float tan_y = dir.y / -dir.z;
+		float tan_left = tanf(fovs[i].angle_left);
+		float tan_right = tanf(fovs[i].angle_right);
+		float tan_up = tanf(fovs[i].angle_up);
+		float tan_down = tanf(fovs[i].angle_down);
+
+		// View uv has y going down.
+		out_centers[i].x = CLAMP((tan_x - tan_left) / (tan_right - tan_left), 0.0f, 1.0f);
+		out_centers[i].y = CLAMP((tan_up - tan_y) / (tan_up - tan_down), 0.0f, 1.0f);
+	}
+
+	return true;
+}
+
+/*!
+ * Moves the full rate region of the foveated layer and distortion shaders to
+ * where the user is looking at display time, or back to the fixed centres if
+ * the gaze isn't known.
+ */
+static void
+update_foveation_centers(struct comp_renderer *r)
+{
+	struct render_resources *nr = &r->c->nr;
+	if (!nr->compute.foveation.enabled) {
+		return;
+	}
+
+	struct xrt_vec2 centers[2];
+	if (r->c->eyes == NULL || !calc_gaze_centers(r, centers)) {
+		centers[0] = nr->compute.foveation.fixed_centers[0];
+		centers[1] = nr->compute.foveation.fixed_centers[1];
+	}
+
+	nr->compute.foveation.views[0].center = centers[0];
+	nr->compute.foveation.views[1].center = centers[1];
+}
+
+static struct comp_renderer_late_latch_entry *
+late_latch_add(struct comp_renderer *r,
+               struct xrt_matrix_4x4 *transform,
+               uint32_t view_index,
+               const struct xrt_pose *src_pose,
+               const struct xrt_fov *src_fov)
+{
+	if (r->late_latch.entry_count >= ARRAY_SIZE(r->late_latch.entries)) {
+		return NULL;
+	}
+
+	struct comp_renderer_late_latch_entry *e = &r->late_latch.entries[r->late_latch.entry_count++];
+	e->transform = transform;
+	e->view_index = view_index;
+	e->src_pose = *src_pose;
+	e->src_fov = *src_fov;
+	e->reprojection = NULL;
+
+	return e;
+}
+
+/*!
+ * The GPU reads the timewarp matrices from host coherent UBOs when it
+ * executes the commands, so sample the pose again and rewrite them as late as
+ * possible, right before submit. The GPU is idle, so the UBOs are not in use.
+ */
+static void
+late_latch_timewarp(struct comp_renderer *r)
+{
+	COMP_TRACE_MARKER();
+
+	if (!r->settings->late_latch || r->late_latch.entry_count == 0) {
+		return;
+	}
+
+	struct xrt_pose world_poses[2];
+	struct xrt_pose unused[2]; // New eye poses, unused.
+	get_view_poses(r, world_poses, unused);
+
+	for (uint32_t i = 0; i < r->late_latch.entry_count; i++) {
+		struct comp_renderer_late_latch_entry *e = &r->late_latch.entries[i];
+
+		render_calc_time_warp_matrix(    //
+		    &e->src_pose,                //
+		    &e->src_fov,                 //
+		    &world_poses[e->view_index], //
+		    e->transform);               //
+
+		if (e->reprojection != NULL) {
+			render_calc_reprojection_matrix( //
+			    &e->src_pose,                //
+			    &world_poses[e->view_index], //
+			    e->reprojection);            //
+		}
+	}
+}
+
 static void
 ensure_scratch_image(struct comp_renderer *r,
                      struct render_viewport_data *out_l_viewport_data,
@@ -1046,300 +1405,1103 @@ ensure_scratch_image(struct comp_renderer *r,
 	*out_r_viewport_data = r_viewport_data;
 }
 
+/*!
+ * Fills in the first layer with the camera images, it is treated like a
+ * projection layer rendered from the pose of the eyes at capture time.
+ */
 static void
-do_layers(struct comp_renderer *r,
-          struct render_compute *crc,
-          const struct comp_layer *layers,
-          const uint32_t layer_count)
+do_passthrough_layer(struct comp_renderer *r,
+                     struct render_compute_layer_ubo_data *ubo_data,
+                     const struct xrt_pose world_poses[2],
+                     VkSampler sampler,
+                     VkSampler src_samplers[RENDER_MAX_IMAGES],
+                     VkImageView src_image_views[RENDER_MAX_IMAGES],
+                     uint32_t *inout_cur_image)
 {
-	struct render_viewport_data views[2];
+	uint32_t cur_image = *inout_cur_image;
 
-	// Create scratch image and get target views.
-	ensure_scratch_image(r, &views[0], &views[1]);
+	ubo_data->layer_type[0].val = XRT_LAYER_STEREO_PROJECTION;
+	ubo_data->layer_type[0].unpremultiplied = false;
+	ubo_data->layer_type[0].depth_reprojection = false;
 
-	struct render_compute_layer_ubo_data *ubo_data =
-	    (struct render_compute_layer_ubo_data *)crc->r->compute.layer.ubo.mapped;
+	set_full_view_bounds(ubo_data, 0);
 
-	for (uint32_t i = 0; i < 2; i++) {
-		ubo_data->views[i] = views[i];
+	for (uint32_t view_i = 0; view_i < 2; view_i++) {
+		struct xrt_pose pose;
+		struct xrt_fov fov;
+		VkImageView view = VK_NULL_HANDLE;
+
+		comp_passthrough_get_view(&r->passthrough, r->c, view_i, &view, &pose, &fov);
+
+		src_samplers[cur_image] = sampler;
+		src_image_views[cur_image] = view;
+		ubo_data->images_samplers[view_i].images[0] = cur_image++;
+
+		ubo_data->post_transforms[view_i] = (struct xrt_normalized_rect){0.0f, 0.0f, 1.0f, 1.0f};
+
+		// unused if timewarp is off
+		if (!r->c->debug.atw_off) {
+			render_calc_time_warp_matrix(       //
+			    &pose,                          //
+			    &fov,                           //
+			    &world_poses[view_i],           //
+			    &ubo_data->transforms[view_i]); //
+		}
 	}
 
-	ubo_data->pre_transforms[0] = crc->r->distortion.uv_to_tanangle[0];
-	ubo_data->pre_transforms[1] = crc->r->distortion.uv_to_tanangle[1];
+	*inout_cur_image = cur_image;
+}
 
-	VkSampler clamp_to_edge = crc->r->samplers.clamp_to_edge;
-	VkSampler clamp_to_border_black = crc->r->samplers.clamp_to_border_black;
+/*!
+ * Transform from view space to the space of a layer at @p pose, for each view.
+ */
+static void
+calc_inverse_layer_transforms(const struct xrt_pose *pose,
+                              const struct xrt_matrix_4x4 view_mats[2],
+                              struct xrt_matrix_4x4 out_inverse[2])
+{
+	struct xrt_vec3 scale = {1.f, 1.f, 1.f};
+	struct xrt_matrix_4x4 model;
+	math_matrix_4x4_model(pose, &scale, &model);
+
+	for (uint32_t view_i = 0; view_i < 2; view_i++) {
+		struct xrt_matrix_4x4 layer_view_space;
+		math_matrix_4x4_multiply(&view_mats[view_i], &model, &layer_view_space);
+		math_matrix_4x4_inverse(&layer_view_space, &out_inverse[view_i]);
+	}
+}
 
-	VkImage target_image = crc->r->scratch.color.image;
-	VkImageView target_image_view = crc->r->scratch.color.unorm_view; // Have to write in linear
+/*!
+ * The layer may cover any part of the views, the shader can't skip it for any
+ * tiles.
+ */
+static void
+set_full_view_bounds(struct render_compute_layer_ubo_data *ubo_data, uint32_t view_index_for_layer)
+{
+	for (uint32_t view_i = 0; view_i < 2; view_i++) {
+		float *bounds = ubo_data->view_bounds[view_index_for_layer + view_i].values;
+		bounds[0] = -FLT_MAX;
+		bounds[1] = -FLT_MAX;
+		bounds[2] = FLT_MAX;
+		bounds[3] = FLT_MAX;
+	}
+}
 
-	struct xrt_pose world_poses[2], eye_poses[2];
-	get_view_poses(r, world_poses, eye_poses);
+/*!
+ * Rectangle in view uv space, for each view, that contains the projection of
+ * the @p point_count points given in layer space. The layer must be inside of
+ * the convex hull of the points, and inverse_quad_transform must already have
+ * been set. If any point is at or behind the eye the view is fully covered.
+ */
+static void
+calc_layer_view_bounds(struct render_compute_layer_ubo_data *ubo_data,
+                       uint32_t view_index_for_layer,
+                       const struct xrt_vec3 *points,
+                       uint32_t point_count)
+{
+	// Leaves some room for precision differences with the shader.
+	const float margin = 0.001f;
+
+	for (uint32_t view_i = 0; view_i < 2; view_i++) {
+		uint32_t index = view_index_for_layer + view_i;
+		const struct xrt_normalized_rect *pre = &ubo_data->pre_transforms[view_i];
+
+		struct xrt_matrix_4x4 layer_view_space;
+		math_matrix_4x4_inverse(&ubo_data->inverse_quad_transform[index], &layer_view_space);
+
+		float min_x = FLT_MAX;
+		float min_y = FLT_MAX;
+		float max_x = -FLT_MAX;
+		float max_y = -FLT_MAX;
+		bool behind = false;
+
+		for (uint32_t i = 0; i < point_count; i++) {
+			struct xrt_vec3 p;
+			math_matrix_4x4_transform_vec3(&layer_view_space, &points[i], &p);
+			if (!(p.z < -0.0001f)) {
+				behind = true;
+				break;
+			}
 
-	// Not the transform of the views, but the inverse: actual view matrices.
-	struct xrt_matrix_4x4 world_view_mats[2], eye_view_mats[2];
-	math_matrix_4x4_view_from_pose(&world_poses[0], &world_view_mats[0]);
-	math_matrix_4x4_view_from_pose(&world_poses[1], &world_view_mats[1]);
-	math_matrix_4x4_view_from_pose(&eye_poses[0], &eye_view_mats[0]);
-	math_matrix_4x4_view_from_pose(&eye_poses[1], &eye_view_mats[1]);
+			// Inverse of get_direction in the shader, y is flipped from OpenXR.
+			float x = (p.x / -p.z - pre->x) / pre->w;
+			float y = (-p.y / -p.z - pre->y) / pre->h;
 
-	// Tightly pack color and optional depth images.
-	uint32_t cur_image = 0;
-	VkSampler src_samplers[COMP_MAX_IMAGES];
-	VkImageView src_image_views[COMP_MAX_IMAGES];
-
-	for (uint32_t layer_i = 0; layer_i < layer_count; layer_i++) {
-		const struct xrt_layer_data *data = &layers[layer_i].data;
-		const struct comp_layer *layer = &layers[layer_i];
-
-		ubo_data->layer_type[layer_i].val = data->type;
-		ubo_data->layer_type[layer_i].unpremultiplied =
-		    (data->flags & XRT_LAYER_COMPOSITION_UNPREMULTIPLIED_ALPHA_BIT) != 0;
-
-		// Base index into arrays that have a value per view & per layer.
-		uint32_t view_index_for_layer = layer_i * COMP_VIEWS_PER_LAYER;
-
-		//! Stop compositing layers if device's sampled image limit is reached.
-		//! This is necessary until composition can be split in multiple passes.
-		//! @todo: remove this after multi-pass composition is implemented.
-		uint32_t required_image_samplers;
-		switch (data->type) {
-		case XRT_LAYER_STEREO_PROJECTION: required_image_samplers = 2; break;
-		case XRT_LAYER_STEREO_PROJECTION_DEPTH: required_image_samplers = 4; break;
-		case XRT_LAYER_QUAD: required_image_samplers = 1; break;
-		default: required_image_samplers = 0;
+			min_x = fminf(min_x, x);
+			min_y = fminf(min_y, y);
+			max_x = fmaxf(max_x, x);
+			max_y = fmaxf(max_y, y);
 		}
-		//! Exit loop if shader cannot receive more image samplers
-		if (cur_image + required_image_samplers >
-		    crc->r->vk->features.max_per_stage_descriptor_sampled_images) {
-			for (uint32_t i = layer_i; i < layer_count; i++) {
-				ubo_data->layer_type[i].val = UINT32_MAX; //! @todo make this not needed.
-			}
-			break;
+
+		float *bounds = ubo_data->view_bounds[index].values;
+		if (behind) {
+			bounds[0] = -FLT_MAX;
+			bounds[1] = -FLT_MAX;
+			bounds[2] = FLT_MAX;
+			bounds[3] = FLT_MAX;
+		} else {
+			bounds[0] = min_x - margin;
+			bounds[1] = min_y - margin;
+			bounds[2] = max_x + margin;
+			bounds[3] = max_y + margin;
 		}
+	}
+}
 
+/*!
+ * Bounds of a quad layer, the corners of the quad in plane space.
+ */
+static void
+calc_quad_view_bounds(struct render_compute_layer_ubo_data *ubo_data,
+                      uint32_t view_index_for_layer,
+                      const struct xrt_vec2 *size)
+{
+	float hw = size->x / 2.0f;
+	float hh = size->y / 2.0f;
+
+	struct xrt_vec3 corners[4] = {
+	    {-hw, -hh, 0.0f},
+	    {hw, -hh, 0.0f},
+	    {hw, hh, 0.0f},
+	    {-hw, hh, 0.0f},
+	};
 
-		switch (data->type) {
-		case XRT_LAYER_STEREO_PROJECTION_DEPTH:
-		case XRT_LAYER_STEREO_PROJECTION: {
-			const struct xrt_layer_projection_view_data *lvd = NULL;
-			const struct xrt_layer_projection_view_data *rvd = NULL;
-			const struct xrt_layer_depth_data *l_dvd = NULL;
-			const struct xrt_layer_depth_data *r_dvd = NULL;
-
-			if (data->type == XRT_LAYER_STEREO_PROJECTION) {
-				const struct xrt_layer_stereo_projection_data *stereo = &layer->data.stereo;
-				lvd = &stereo->l;
-				rvd = &stereo->r;
-			} else {
-				const struct xrt_layer_stereo_projection_depth_data *stereo = &layer->data.stereo_depth;
-				lvd = &stereo->l;
-				rvd = &stereo->r;
-				l_dvd = &stereo->l_d;
-				r_dvd = &stereo->r_d;
-			}
+	calc_layer_view_bounds(ubo_data, view_index_for_layer, corners, ARRAY_SIZE(corners));
+}
 
-			uint32_t left_array_index = lvd->sub.array_index;
-			uint32_t right_array_index = rvd->sub.array_index;
-			const struct comp_swapchain_image *left = &layer->sc_array[0]->images[lvd->sub.image_index];
-			const struct comp_swapchain_image *right = &layer->sc_array[1]->images[rvd->sub.image_index];
-
-			// Left
-			src_samplers[cur_image] = clamp_to_border_black;
-			src_image_views[cur_image] = get_image_view(left, data->flags, left_array_index);
-			ubo_data->images_samplers[view_index_for_layer + 0].images[0] = cur_image++;
-
-			// Right
-			src_samplers[cur_image] = clamp_to_border_black;
-			src_image_views[cur_image] = get_image_view(right, data->flags, right_array_index);
-			ubo_data->images_samplers[view_index_for_layer + 1].images[0] = cur_image++;
-
-			// Depth
-			if (data->type == XRT_LAYER_STEREO_PROJECTION_DEPTH) {
-				uint32_t d_left_array_index = lvd->sub.array_index;
-				uint32_t d_right_array_index = rvd->sub.array_index;
-				const struct comp_swapchain_image *d_left =
-				    &layer->sc_array[2]->images[l_dvd->sub.image_index];
-				const struct comp_swapchain_image *d_right =
-				    &layer->sc_array[3]->images[r_dvd->sub.image_index];
-
-
-				// Depth left
-				src_samplers[cur_image] = clamp_to_edge; // Edge to keep depth stable at edges.
-				src_image_views[cur_image] = get_image_view(d_left, data->flags, d_left_array_index);
-				ubo_data->images_samplers[view_index_for_layer + 0].images[1] = cur_image++;
-
-				// Depth right
-				src_samplers[cur_image] = clamp_to_edge; // Edge to keep depth stable at edges.
-				src_image_views[cur_image] = get_image_view(d_right, data->flags, d_right_array_index);
-				ubo_data->images_samplers[view_index_for_layer + 1].images[1] = cur_image++;
-			}
+/*!
+ * Bounds of a cylinder layer, the arc is replaced with a polyline around it so
+ * that the cylinder is inside of the convex hull of the points.
+ */
+static void
+calc_cylinder_view_bounds(struct render_compute_layer_ubo_data *ubo_data,
+                          uint32_t view_index_for_layer,
+                          const struct xrt_layer_cylinder_data *cyl)
+{
+	enum
+	{
+		SEGMENTS = 8,
+		POINT_COUNT = (SEGMENTS * 2 + 1) * 2,
+	};
 
-			struct xrt_normalized_rect *post_transforms = &ubo_data->post_transforms[view_index_for_layer];
-			post_transforms[0] = lvd->sub.norm_rect;
-			post_transforms[1] = rvd->sub.norm_rect;
-			if (data->flip_y) {
-				post_transforms[0].h = -post_transforms[0].h;
-				post_transforms[0].y = 1.0f + post_transforms[0].y;
-				post_transforms[1].h = -post_transforms[1].h;
-				post_transforms[1].y = 1.0f + post_transforms[1].y;
-			}
+	float height = cyl->radius * cyl->central_angle / cyl->aspect_ratio;
+	if (!(cyl->radius > 0.0f) || !(cyl->aspect_ratio > 0.0f) || !isfinite(height) || !isfinite(cyl->radius)) {
+		set_full_view_bounds(ubo_data, view_index_for_layer);
+		return;
+	}
 
-			// unused if timewarp is off
-			if (!r->c->debug.atw_off) {
-				render_calc_time_warp_matrix(                         //
-				    &lvd->pose,                                       //
-				    &lvd->fov,                                        //
-				    &world_poses[0],                                  //
-				    &ubo_data->transforms[view_index_for_layer + 0]); //
-				render_calc_time_warp_matrix(                         //
-				    &rvd->pose,                                       //
-				    &rvd->fov,                                        //
-				    &world_poses[1],                                  //
-				    &ubo_data->transforms[view_index_for_layer + 1]); //
-			}
+	float step = cyl->central_angle / SEGMENTS;
 
-		} break;
-		case XRT_LAYER_QUAD: {
-			const struct xrt_layer_quad_data *q = &layer->data.quad;
-			const struct comp_swapchain_image *image = &layer->sc_array[0]->images[q->sub.image_index];
-			uint32_t array_index = q->sub.array_index;
-
-			// Same image for both views
-			src_samplers[cur_image] = clamp_to_edge;
-			src_image_views[cur_image] = get_image_view(image, layer->data.flags, array_index);
-			ubo_data->images_samplers[view_index_for_layer + 0].images[0] = cur_image;
-			ubo_data->images_samplers[view_index_for_layer + 1].images[0] = cur_image;
-			cur_image++;
+	// The middle of each segment is pushed out to where the tangents at its ends meet.
+	float outer_radius = cyl->radius / cosf(step / 2.0f);
 
+	struct xrt_vec3 points[POINT_COUNT];
+	uint32_t count = 0;
 
-			struct xrt_normalized_rect *post_transforms = &ubo_data->post_transforms[view_index_for_layer];
+	for (uint32_t i = 0; i <= SEGMENTS * 2; i++) {
+		float angle = -cyl->central_angle / 2.0f + (float)i * step / 2.0f;
+		float radius = (i % 2) != 0 ? outer_radius : cyl->radius;
 
-			// Same image for both views
-			post_transforms[0] = q->sub.norm_rect;
-			post_transforms[1] = q->sub.norm_rect;
+		// Around the y axis centred on -z, same as the shader.
+		float x = radius * sinf(angle);
+		float z = -radius * cosf(angle);
 
-			// quad layers calculated in flipped space than projection layers.
-			// Note: different y flip logic compared to projection layers.
-			if (!data->flip_y) {
-				post_transforms[0].h = -post_transforms[0].h;
-				post_transforms[0].y = post_transforms[0].y - post_transforms[0].h;
-				post_transforms[1].h = -post_transforms[1].h;
-				post_transforms[1].y = post_transforms[1].y - post_transforms[1].h;
-			}
+		points[count++] = (struct xrt_vec3){x, height / 2.0f, z};
+		points[count++] = (struct xrt_vec3){x, -height / 2.0f, z};
+	}
 
-			ubo_data->quad_extent[layer_i].val = data->quad.size;
-
-			// Is this layer viewspace or not.
-			const struct xrt_matrix_4x4 *view_mats =
-			    (layer->data.flags & XRT_LAYER_COMPOSITION_VIEW_SPACE_BIT) ? eye_view_mats
-			                                                               : world_view_mats;
-
-			for (uint32_t view_i = 0; view_i < 2; view_i++) {
-				// transform quad pose into view space for each view
-				math_matrix_4x4_transform_vec3(
-				    &view_mats[view_i], &data->quad.pose.position,
-				    &ubo_data->quad_position[view_index_for_layer + view_i].val);
-
-				// neutral quad layer faces +z, towards the user
-				struct xrt_vec3 normal = (struct xrt_vec3){.x = 0, .y = 0, .z = 1};
-
-				// rotation of the quad normal in world space
-				struct xrt_quat rotation = data->quad.pose.orientation;
-				math_quat_rotate_vec3(&rotation, &normal, &normal);
-
-				/*
-				 * normal is a vector that originates on the plane, not on the origin.
-				 * Instead of using the inverse quad transform to transform it into view space we can
-				 * simply add up vectors:
-				 *
-				 * combined_normal [in world space] = plane_origin [in world space] + normal [in plane
-				 * space] [with plane in world space]
-				 *
-				 * Then combined_normal can be transformed to view space via view matrix and a new
-				 * normal_view_space retrieved:
-				 *
-				 * normal_view_space = combined_normal [in view space] - plane_origin [in view space]
-				 */
-				struct xrt_vec3 normal_view_space = normal;
-				math_vec3_accum(&data->quad.pose.position, &normal_view_space);
-				math_matrix_4x4_transform_vec3(&view_mats[view_i], &normal_view_space,
-				                               &normal_view_space);
-				math_vec3_subtract(&ubo_data->quad_position[view_index_for_layer + view_i].val,
-				                   &normal_view_space);
-				ubo_data->quad_normal[view_index_for_layer + view_i].val = normal_view_space;
-
-
-				struct xrt_vec3 scale = {1.f, 1.f, 1.f};
-				struct xrt_matrix_4x4 plane_transform_view_space;
-				math_matrix_4x4_model(&data->quad.pose, &scale, &plane_transform_view_space);
-				math_matrix_4x4_multiply(&view_mats[view_i], &plane_transform_view_space,
-				                         &plane_transform_view_space);
-				math_matrix_4x4_inverse(
-				    &plane_transform_view_space,
-				    &ubo_data->inverse_quad_transform[view_index_for_layer + view_i]);
-			}
+	calc_layer_view_bounds(ubo_data, view_index_for_layer, points, count);
+}
 
-			// hide a quad layer by pointing its normal away from the camera in view space
-			struct xrt_vec3 hidden_normal = {.x = 0, .y = 0, .z = -1};
-			switch (q->visibility) {
-			case XRT_LAYER_EYE_VISIBILITY_NONE:
-				ubo_data->quad_normal[view_index_for_layer + 0].val = hidden_normal;
-				ubo_data->quad_normal[view_index_for_layer + 1].val = hidden_normal;
-				break;
-			case XRT_LAYER_EYE_VISIBILITY_LEFT_BIT:
-				ubo_data->quad_normal[view_index_for_layer + 1].val = hidden_normal;
-				break;
-			case XRT_LAYER_EYE_VISIBILITY_RIGHT_BIT:
-				ubo_data->quad_normal[view_index_for_layer + 0].val = hidden_normal;
-				break;
-			case XRT_LAYER_EYE_VISIBILITY_BOTH: break;
-			}
+static uint32_t
+visibility_to_view_mask(enum xrt_layer_eye_visibility visibility)
+{
+	switch (visibility) {
+	case XRT_LAYER_EYE_VISIBILITY_LEFT_BIT: return 1;
+	case XRT_LAYER_EYE_VISIBILITY_RIGHT_BIT: return 2;
+	case XRT_LAYER_EYE_VISIBILITY_BOTH: return 3;
+	default: return 0;
+	}
+}
 
-		} break;
-		default:
-			COMP_ERROR(r->c, "Layer type %d not supported by compute shader, skipping", data->type);
-			ubo_data->layer_type[layer_i].val = UINT32_MAX;
+/*!
+ * Cylinder and equirect2 layers use the same image for both views, the shader
+ * computes the coordinates in the same space as projection layers.
+ */
+static void
+set_surface_post_transforms(const struct xrt_layer_data *data,
+                            const struct xrt_sub_image *sub,
+                            struct xrt_normalized_rect post_transforms[2])
+{
+	for (uint32_t view_i = 0; view_i < 2; view_i++) {
+		post_transforms[view_i] = sub->norm_rect;
+		if (data->flip_y) {
+			post_transforms[view_i].h = -post_transforms[view_i].h;
+			post_transforms[view_i].y = 1.0f + post_transforms[view_i].y;
 		}
 	}
+}
 
-	for (uint32_t i = layer_count; i < COMP_MAX_LAYERS; i++) {
-		ubo_data->layer_type[i].val = UINT32_MAX;
-	}
+/*!
+ * Sets up positional timewarp for one view of a projection depth layer, the
+ * shader walks the ray of the new eye to the depth rendered from @p vd.
+ */
+static void
+do_depth_reprojection(struct render_compute_layer_ubo_data *ubo_data,
+                      uint32_t index,
+                      const struct xrt_layer_projection_view_data *vd,
+                      const struct xrt_layer_depth_data *dvd,
+                      const struct xrt_pose *world_pose,
+                      struct comp_renderer_late_latch_entry *latch)
+{
+	ubo_data->src_tangents[index] = (struct xrt_normalized_rect){
+	    .x = tanf(vd->fov.angle_left),
+	    .y = tanf(vd->fov.angle_up),
+	    .w = tanf(vd->fov.angle_right) - tanf(vd->fov.angle_left),
+	    .h = tanf(vd->fov.angle_down) - tanf(vd->fov.angle_up),
+	};
 
-	//! @todo: If Vulkan 1.2, use VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT and skip this
-	while (cur_image < crc->r->compute.layer.image_array_size) {
-		src_samplers[cur_image] = clamp_to_edge;
-		src_image_views[cur_image] = crc->r->mock.color.image_view;
-		cur_image++;
-	}
+	render_calc_depth_params(dvd, ubo_data->depth_params[index].values);
+	render_calc_reprojection_matrix(&vd->pose, world_pose, &ubo_data->inverse_quad_transform[index]);
 
-	render_compute_layers(                        //
-	    crc,                                      //
-	    src_samplers,                             //
-	    src_image_views,                          //
-	    cur_image,                                //
-	    target_image,                             //
-	    target_image_view,                        //
-	    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, //
-	    !r->c->debug.atw_off);                    //
+	if (latch != NULL) {
+		latch->reprojection = &ubo_data->inverse_quad_transform[index];
+	}
 }
 
-static void
-do_distortion(struct comp_renderer *r, struct render_compute *crc, const struct render_viewport_data views[2])
+/*!
+ * Fills in the UBO data of one layer at @p ubo_i, returns false without
+ * touching the UBO if the shader can not receive more image samplers.
+ */
+static bool
+do_layer(struct comp_renderer *r,
+         struct render_compute *crc,
+         struct render_compute_layer_ubo_data *ubo_data,
+         uint32_t ubo_i,
+         const struct comp_layer *layer,
+         const struct xrt_pose world_poses[2],
+         const struct xrt_matrix_4x4 world_view_mats[2],
+         const struct xrt_matrix_4x4 eye_view_mats[2],
+         VkSampler src_samplers[RENDER_MAX_IMAGES],
+         VkImageView src_image_views[RENDER_MAX_IMAGES],
+         uint32_t *inout_cur_image)
 {
-	VkImage target_image = r->c->target->images[r->acquired_buffer].handle;
-	VkImageView target_image_view = r->c->target->images[r->acquired_buffer].view;
+	const struct xrt_layer_data *data = &layer->data;
+	uint32_t cur_image = *inout_cur_image;
 
-	VkImageView view = crc->r->scratch.color.srgb_view; // Read with gamma curve.
-	VkSampler sampler = crc->r->samplers.clamp_to_border_black;
+	VkSampler clamp_to_edge = crc->r->samplers.clamp_to_edge;
+	VkSampler clamp_to_border_black = crc->r->samplers.clamp_to_border_black;
+	VkSampler clamp_to_edge_mip = crc->r->samplers.clamp_to_edge_mip;
+
+	// The caller carries on in a new pass if the layer doesn't fit in this one.
+	uint32_t required_image_samplers;
+	switch (data->type) {
+	case XRT_LAYER_STEREO_PROJECTION: required_image_samplers = 2; break;
+	case XRT_LAYER_STEREO_PROJECTION_DEPTH: required_image_samplers = 4; break;
+	case XRT_LAYER_QUAD: required_image_samplers = 1; break;
+	case XRT_LAYER_CYLINDER: required_image_samplers = 1; break;
+	case XRT_LAYER_EQUIRECT2: required_image_samplers = 1; break;
+	case XRT_LAYER_CUBE: required_image_samplers = 6; break;
+	default: required_image_samplers = 0;
+	}
+	// Exit if shader cannot receive more image samplers.
+	if (cur_image + required_image_samplers > crc->r->compute.layer.image_array_size) {
+		return false;
+	}
 
-	VkImageView src_image_views[2] = {view, view};
-	VkSampler src_samplers[2] = {sampler, sampler};
+	ubo_data->layer_type[ubo_i].val = data->type;
+	ubo_data->layer_type[ubo_i].unpremultiplied =
+	    (data->flags & XRT_LAYER_COMPOSITION_UNPREMULTIPLIED_ALPHA_BIT) != 0;
+	ubo_data->layer_type[ubo_i].depth_reprojection = false;
 
-	struct xrt_normalized_rect src_norm_rects[2] = {
-	    {
-	        // Left, takes up half the screen.
+	// Base index into arrays that have a value per view & per layer.
+	uint32_t view_index_for_layer = ubo_i * COMP_VIEWS_PER_LAYER;
+
+	// Only quad and cylinder layers have tighter bounds.
+	set_full_view_bounds(ubo_data, view_index_for_layer);
+
+	switch (data->type) {
+	case XRT_LAYER_STEREO_PROJECTION_DEPTH:
+	case XRT_LAYER_STEREO_PROJECTION: {
+		const struct xrt_layer_projection_view_data *lvd = NULL;
+		const struct xrt_layer_projection_view_data *rvd = NULL;
+		const struct xrt_layer_depth_data *l_dvd = NULL;
+		const struct xrt_layer_depth_data *r_dvd = NULL;
+
+		if (data->type == XRT_LAYER_STEREO_PROJECTION) {
+			const struct xrt_layer_stereo_projection_data *stereo = &layer->data.stereo;
+			lvd = &stereo->l;
+			rvd = &stereo->r;
+		} else {
+			const struct xrt_layer_stereo_projection_depth_data *stereo = &layer->data.stereo_depth;
+			lvd = &stereo->l;
+			rvd = &stereo->r;
+			l_dvd = &stereo->l_d;
+			r_dvd = &stereo->r_d;
+		}
+
+		uint32_t left_array_index = lvd->sub.array_index;
+		uint32_t right_array_index = rvd->sub.array_index;
+		const struct comp_swapchain_image *left = &layer->sc_array[0]->images[lvd->sub.image_index];
+		const struct comp_swapchain_image *right = &layer->sc_array[1]->images[rvd->sub.image_index];
+
+		// Left
+		src_samplers[cur_image] = clamp_to_border_black;
+		src_image_views[cur_image] = get_image_view(left, data->flags, left_array_index);
+		ubo_data->images_samplers[view_index_for_layer + 0].images[0] = cur_image++;
+
+		// Right
+		src_samplers[cur_image] = clamp_to_border_black;
+		src_image_views[cur_image] = get_image_view(right, data->flags, right_array_index);
+		ubo_data->images_samplers[view_index_for_layer + 1].images[0] = cur_image++;
+
+		// Depth
+		if (data->type == XRT_LAYER_STEREO_PROJECTION_DEPTH) {
+			uint32_t d_left_array_index = lvd->sub.array_index;
+			uint32_t d_right_array_index = rvd->sub.array_index;
+			const struct comp_swapchain_image *d_left = &layer->sc_array[2]->images[l_dvd->sub.image_index];
+			const struct comp_swapchain_image *d_right =
+			    &layer->sc_array[3]->images[r_dvd->sub.image_index];
+
+
+			// Depth left
+			src_samplers[cur_image] = clamp_to_edge; // Edge to keep depth stable at edges.
+			src_image_views[cur_image] = get_image_view(d_left, data->flags, d_left_array_index);
+			ubo_data->images_samplers[view_index_for_layer + 0].images[1] = cur_image++;
+
+			// Depth right
+			src_samplers[cur_image] = clamp_to_edge; // Edge to keep depth stable at edges.
+			src_image_views[cur_image] = get_image_view(d_right, data->flags, d_right_array_index);
+			ubo_data->images_samplers[view_index_for_layer + 1].images[1] = cur_image++;
+		}
+
+		struct xrt_normalized_rect *post_transforms = &ubo_data->post_transforms[view_index_for_layer];
+		post_transforms[0] = lvd->sub.norm_rect;
+		post_transforms[1] = rvd->sub.norm_rect;
+		if (data->flip_y) {
+			post_transforms[0].h = -post_transforms[0].h;
+			post_transforms[0].y = 1.0f + post_transforms[0].y;
+			post_transforms[1].h = -post_transforms[1].h;
+			post_transforms[1].y = 1.0f + post_transforms[1].y;
+		}
+
+		// unused if timewarp is off
+		if (!r->c->debug.atw_off) {
+			render_calc_time_warp_matrix(                         //
+			    &lvd->pose,                                       //
+			    &lvd->fov,                                        //
+			    &world_poses[0],                                  //
+			    &ubo_data->transforms[view_index_for_layer + 0]); //
+			render_calc_time_warp_matrix(                         //
+			    &rvd->pose,                                       //
+			    &rvd->fov,                                        //
+			    &world_poses[1],                                  //
+			    &ubo_data->transforms[view_index_for_layer + 1]); //
+
+			struct comp_renderer_late_latch_entry *l_latch =
+			    late_latch_add(r, &ubo_data->transforms[view_index_for_layer + 0], 0, &lvd->pose, &lvd->fov);
+			struct comp_renderer_late_latch_entry *r_latch =
+			    late_latch_add(r, &ubo_data->transforms[view_index_for_layer + 1], 1, &rvd->pose, &rvd->fov);
+
+			// The rotation only matrices above are still the first guess.
+			if (data->type == XRT_LAYER_STEREO_PROJECTION_DEPTH && r->settings->depth_timewarp) {
+				ubo_data->layer_type[ubo_i].depth_reprojection = true;
+				do_depth_reprojection(ubo_data, view_index_for_layer + 0, lvd, l_dvd, &world_poses[0],
+				                      l_latch);
+				do_depth_reprojection(ubo_data, view_index_for_layer + 1, rvd, r_dvd, &world_poses[1],
+				                      r_latch);
+			}
+		}
+
+	} break;
+	case XRT_LAYER_QUAD: {
+		const struct xrt_layer_quad_data *q = &layer->data.quad;
+		const struct comp_swapchain_image *image = &layer->sc_array[0]->images[q->sub.image_index];
+		uint32_t array_index = q->sub.array_index;
+
+		// Same image for both views
+		src_samplers[cur_image] = clamp_to_edge;
+		src_image_views[cur_image] = get_image_view(image, layer->data.flags, array_index);
+		ubo_data->images_samplers[view_index_for_layer + 0].images[0] = cur_image;
+		ubo_data->images_samplers[view_index_for_layer + 1].images[0] = cur_image;
+		cur_image++;
+
+
+		struct xrt_normalized_rect *post_transforms = &ubo_data->post_transforms[view_index_for_layer];
+
+		// Same image for both views
+		post_transforms[0] = q->sub.norm_rect;
+		post_transforms[1] = q->sub.norm_rect;
+
+		// quad layers calculated in flipped space than projection layers.
+		// Note: different y flip logic compared to projection layers.
+		if (!data->flip_y) {
+			post_transforms[0].h = -post_transforms[0].h;
+			post_transforms[0].y = post_transforms[0].y - post_transforms[0].h;
+			post_transforms[1].h = -post_transforms[1].h;
+			post_transforms[1].y = post_transforms[1].y - post_transforms[1].h;
+		}
+
+		ubo_data->quad_extent[ubo_i].val = data->quad.size;
+
+		// Is this layer viewspace or not.
+		const struct xrt_matrix_4x4 *view_mats =
+		    (layer->data.flags & XRT_LAYER_COMPOSITION_VIEW_SPACE_BIT) ? eye_view_mats : world_view_mats;
+
+		for (uint32_t view_i = 0; view_i < 2; view_i++) {
+			// transform quad pose into view space for each view
+			math_matrix_4x4_transform_vec3(
+			    &view_mats[view_i], &data->quad.pose.position,
+			    &ubo_data->quad_position[view_index_for_layer + view_i].val);
+
+			// neutral quad layer faces +z, towards the user
+			struct xrt_vec3 normal = (struct xrt_vec3){.x = 0, .y = 0, .z = 1};
+
+			// rotation of the quad normal in world space
+			struct xrt_quat rotation = data->quad.pose.orientation;
+			math_quat_rotate_vec3(&rotation, &normal, &normal);
+
+			/*
+			 * normal is a vector that originates on the plane, not on the origin.
+			 * Instead of using the inverse quad transform to transform it into view space we can
+			 * simply add up vectors:
+			 *
+			 * combined_normal [in world space] = plane_origin [in world space] + normal [in plane
+			 * space] [with plane in world space]
+			 *
+			 * Then combined_normal can be transformed to view space via view matrix and a new
+			 * normal_view_space retrieved:
+			 *
+			 * normal_view_space = combined_normal [in view space] - plane_origin [in view space]
+			 */
+			struct xrt_vec3 normal_view_space = normal;
+			math_vec3_accum(&data->quad.pose.position, &normal_view_space);
+			math_matrix_4x4_transform_vec3(&view_mats[view_i], &normal_view_space, &normal_view_space);
+			math_vec3_subtract(&ubo_data->quad_position[view_index_for_layer + view_i].val,
+			                   &normal_view_space);
+			ubo_data->quad_normal[view_index_for_layer + view_i].val = normal_view_space;
+
+
+			struct xrt_vec3 scale = {1.f, 1.f, 1.f};
+			struct xrt_matrix_4x4 plane_transform_view_space;
+			math_matrix_4x4_model(&data->quad.pose, &scale, &plane_transform_view_space);
+			math_matrix_4x4_multiply(&view_mats[view_i], &plane_transform_view_space,
+			                         &plane_transform_view_space);
+			math_matrix_4x4_inverse(
+			    &plane_transform_view_space,
+			    &ubo_data->inverse_quad_transform[view_index_for_layer + view_i]);
+		}
+
+		// hide a quad layer by pointing its normal away from the camera in view space
+		struct xrt_vec3 hidden_normal = {.x = 0, .y = 0, .z = -1};
+		switch (q->visibility) {
+		case XRT_LAYER_EYE_VISIBILITY_NONE:
+			ubo_data->quad_normal[view_index_for_layer + 0].val = hidden_normal;
+			ubo_data->quad_normal[view_index_for_layer + 1].val = hidden_normal;
+			break;
+		case XRT_LAYER_EYE_VISIBILITY_LEFT_BIT:
+			ubo_data->quad_normal[view_index_for_layer + 1].val = hidden_normal;
+			break;
+		case XRT_LAYER_EYE_VISIBILITY_RIGHT_BIT:
+			ubo_data->quad_normal[view_index_for_layer + 0].val = hidden_normal;
+			break;
+		case XRT_LAYER_EYE_VISIBILITY_BOTH: break;
+		}
+
+		calc_quad_view_bounds(ubo_data, view_index_for_layer, &data->quad.size);
+
+	} break;
+	case XRT_LAYER_CYLINDER:
+	case XRT_LAYER_EQUIRECT2: {
+		const struct xrt_sub_image *sub = NULL;
+		const struct xrt_pose *pose = NULL;
+		enum xrt_layer_eye_visibility visibility;
+		float *shape = ubo_data->shape[ubo_i].values;
+
+		if (data->type == XRT_LAYER_CYLINDER) {
+			const struct xrt_layer_cylinder_data *cyl = &data->cylinder;
+			sub = &cyl->sub;
+			pose = &cyl->pose;
+			visibility = cyl->visibility;
+
+			shape[0] = cyl->radius;
+			shape[1] = cyl->central_angle;
+			shape[2] = cyl->aspect_ratio;
+			shape[3] = 0.0f;
+		} else {
+			const struct xrt_layer_equirect2_data *eq2 = &data->equirect2;
+			sub = &eq2->sub;
+			pose = &eq2->pose;
+			visibility = eq2->visibility;
+
+			// Infinite radius means only the direction matters.
+			shape[0] = isfinite(eq2->radius) ? eq2->radius : 0.0f;
+			shape[1] = eq2->central_horizontal_angle;
+			shape[2] = eq2->upper_vertical_angle;
+			shape[3] = eq2->lower_vertical_angle;
+		}
+
+		const struct comp_swapchain_image *image = &layer->sc_array[0]->images[sub->image_index];
+
+		// Same image for both views, mip levels are picked in the shader.
+		src_samplers[cur_image] = clamp_to_edge_mip;
+		src_image_views[cur_image] = get_image_view(image, data->flags, sub->array_index);
+		ubo_data->images_samplers[view_index_for_layer + 0].images[0] = cur_image;
+		ubo_data->images_samplers[view_index_for_layer + 1].images[0] = cur_image;
+		cur_image++;
+
+		set_surface_post_transforms(data, sub, &ubo_data->post_transforms[view_index_for_layer]);
+
+		ubo_data->layer_type[ubo_i].view_mask = visibility_to_view_mask(visibility);
+
+		// Is this layer viewspace or not.
+		const struct xrt_matrix_4x4 *view_mats =
+		    (data->flags & XRT_LAYER_COMPOSITION_VIEW_SPACE_BIT) ? eye_view_mats : world_view_mats;
+
+		calc_inverse_layer_transforms(pose, view_mats, &ubo_data->inverse_quad_transform[view_index_for_layer]);
+
+		if (data->type == XRT_LAYER_CYLINDER) {
+			calc_cylinder_view_bounds(ubo_data, view_index_for_layer, &data->cylinder);
+		}
+
+	} break;
+	case XRT_LAYER_CUBE: {
+		const struct xrt_layer_cube_data *cube = &data->cube;
+		const struct comp_swapchain_image *image = &layer->sc_array[0]->images[cube->sub.image_index];
+		bool source_alpha = (data->flags & XRT_LAYER_COMPOSITION_BLEND_TEXTURE_SOURCE_ALPHA_BIT) != 0;
+		VkImageView *faces = source_alpha ? image->views.face_alpha : image->views.face_no_alpha;
+
+		// Not created with a cube swapchain.
+		if (faces == NULL) {
+			COMP_ERROR(r->c, "Cube layer without a cube swapchain, skipping");
+			ubo_data->layer_type[ubo_i].val = UINT32_MAX;
+			break;
+		}
+
+		// The shader picks the face, it needs them in consecutive slots.
+		uint32_t first = cur_image;
+		for (uint32_t face = 0; face < 6; face++) {
+			src_samplers[cur_image] = clamp_to_edge_mip;
+			src_image_views[cur_image] = faces[cube->sub.array_index * 6 + face];
+			cur_image++;
+		}
+		ubo_data->images_samplers[view_index_for_layer + 0].images[0] = first;
+		ubo_data->images_samplers[view_index_for_layer + 1].images[0] = first;
+
+		ubo_data->layer_type[ubo_i].view_mask = visibility_to_view_mask(cube->visibility);
+
+		// Only the orientation is used, the cube is infinitely far away.
+		const struct xrt_matrix_4x4 *view_mats =
+		    (data->flags & XRT_LAYER_COMPOSITION_VIEW_SPACE_BIT) ? eye_view_mats : world_view_mats;
+
+		calc_inverse_layer_transforms(&cube->pose, view_mats,
+		                              &ubo_data->inverse_quad_transform[view_index_for_layer]);
+
+	} break;
+	default:
+		COMP_ERROR(r->c, "Layer type %d not supported by compute shader, skipping", data->type);
+		ubo_data->layer_type[ubo_i].val = UINT32_MAX;
+	}
+
+	*inout_cur_image = cur_image;
+
+	return true;
+}
+
+/*!
+ * Fills the remaining image slots with the mock image.
+ */
+static void
+fill_unused_images(struct render_compute *crc,
+                   VkSampler src_samplers[RENDER_MAX_IMAGES],
+                   VkImageView src_image_views[RENDER_MAX_IMAGES],
+                   uint32_t *inout_cur_image)
+{
+	uint32_t cur_image = *inout_cur_image;
+
+	//! @todo: If Vulkan 1.2, use VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT and skip this
+	while (cur_image < crc->r->compute.layer.image_array_size) {
+		src_samplers[cur_image] = crc->r->samplers.clamp_to_edge;
+		src_image_views[cur_image] = crc->r->mock.color.image_view;
+		cur_image++;
+	}
+
+	*inout_cur_image = cur_image;
+}
+
+static void
+layer_cache_make_key(const struct comp_layer *layer, struct comp_renderer_layer_cache_key *out_key)
+{
+	const struct xrt_layer_quad_data *q = &layer->data.quad;
+	const struct comp_swapchain *sc = layer->sc_array[0];
+
+	U_ZERO(out_key);
+	out_key->sc = sc;
+	out_key->release_count = sc->release_count;
+	out_key->view = get_image_view(&sc->images[q->sub.image_index], layer->data.flags, q->sub.array_index);
+	out_key->flags = layer->data.flags;
+	out_key->flip_y = layer->data.flip_y;
+	out_key->quad = *q;
+}
+
+static bool
+layer_cache_key_equal(const struct comp_renderer_layer_cache_key *a, const struct comp_renderer_layer_cache_key *b)
+{
+	return a->sc == b->sc &&                       //
+	       a->release_count == b->release_count && //
+	       a->view == b->view &&                   //
+	       a->flags == b->flags &&                 //
+	       a->flip_y == b->flip_y &&               //
+	       memcmp(&a->quad, &b->quad, sizeof(a->quad)) == 0;
+}
+
+/*!
+ * Only view space quads look the same regardless of the head pose, world space
+ * layers would need to be squashed again every frame.
+ */
+static bool
+layer_cache_is_cacheable(const struct comp_layer *layer)
+{
+	return layer->data.type == XRT_LAYER_QUAD &&                                //
+	       (layer->data.flags & XRT_LAYER_COMPOSITION_VIEW_SPACE_BIT) != 0 && //
+	       layer->sc_array[0] != NULL;
+}
+
+/*!
+ * Tracks how many frames each layer has been unchanged for, and returns the
+ * first layer of the run of cacheable layers at the top that have all been
+ * unchanged long enough. Returns @p layer_count if there is no such layer.
+ *
+ * Blending premultiplied layers "over" each other is associative, so the run
+ * can be squashed on its own and blended as one layer over the layers below.
+ */
+static uint32_t
+layer_cache_update(struct comp_renderer *r,
+                   const struct comp_layer *layers,
+                   uint32_t layer_count,
+                   const struct xrt_pose eye_poses[2])
+{
+	// The view space quads move with the eyes relative to the head.
+	bool eyes_moved = memcmp(r->layer_cache.eye_poses, eye_poses, sizeof(r->layer_cache.eye_poses)) != 0;
+	memcpy(r->layer_cache.eye_poses, eye_poses, sizeof(r->layer_cache.eye_poses));
+
+	for (uint32_t i = 0; i < layer_count; i++) {
+		struct comp_renderer_layer_cache_key key;
+		U_ZERO(&key);
+
+		bool cacheable = layer_cache_is_cacheable(&layers[i]);
+		if (cacheable) {
+			layer_cache_make_key(&layers[i], &key);
+		}
+
+		bool same = cacheable &&                    //
+		            !eyes_moved &&                  //
+		            i < r->layer_cache.key_count && //
+		            layer_cache_key_equal(&key, &r->layer_cache.keys[i]);
+
+		r->layer_cache.stable_frames[i] = same ? r->layer_cache.stable_frames[i] + 1 : 0;
+		r->layer_cache.keys[i] = key;
+	}
+	r->layer_cache.key_count = layer_count;
+
+	// The cache is squashed in a single dispatch.
+	uint32_t first = layer_count;
+	while (first > 0 && layer_count - first < RENDER_MAX_LAYERS &&
+	       r->layer_cache.stable_frames[first - 1] >= COMP_RENDERER_LAYER_CACHE_STABLE_FRAMES) {
+		first--;
+	}
+
+	return first;
+}
+
+/*!
+ * Squashes the layers [first, layer_count) into the layer cache if it doesn't
+ * already hold them, returns false if the layers can not be cached.
+ */
+static bool
+layer_cache_ensure(struct comp_renderer *r,
+                   struct render_compute *crc,
+                   const struct comp_layer *layers,
+                   uint32_t first,
+                   uint32_t layer_count,
+                   const struct render_viewport_data views[2],
+                   const struct xrt_pose world_poses[2],
+                   const struct xrt_matrix_4x4 world_view_mats[2],
+                   const struct xrt_matrix_4x4 eye_view_mats[2])
+{
+	uint32_t count = layer_count - first;
+	VkImage image = crc->r->scratch.cache.image;
+
+	if (r->layer_cache.valid &&          //
+	    r->layer_cache.first == first && //
+	    r->layer_cache.count == count && //
+	    r->layer_cache.image == image) {
+		return true;
+	}
+
+	COMP_TRACE_MARKER();
+
+	r->layer_cache.valid = false;
+
+	struct render_compute_layer_ubo_data *ubo_data =
+	    (struct render_compute_layer_ubo_data *)crc->r->compute.layer.cache_ubo.mapped;
+
+	for (uint32_t i = 0; i < 2; i++) {
+		ubo_data->views[i] = views[i];
+	}
+
+	ubo_data->pre_transforms[0] = crc->r->distortion.uv_to_tanangle[0];
+	ubo_data->pre_transforms[1] = crc->r->distortion.uv_to_tanangle[1];
+
+	uint32_t cur_image = 0;
+	VkSampler src_samplers[RENDER_MAX_IMAGES];
+	VkImageView src_image_views[RENDER_MAX_IMAGES];
+
+	for (uint32_t i = 0; i < count; i++) {
+		bool ok = do_layer(     //
+		    r,                  //
+		    crc,                //
+		    ubo_data,           //
+		    i,                  //
+		    &layers[first + i], //
+		    world_poses,        //
+		    world_view_mats,    //
+		    eye_view_mats,      //
+		    src_samplers,       //
+		    src_image_views,    //
+		    &cur_image);        //
+		if (!ok) {
+			return false;
+		}
+	}
+
+	for (uint32_t i = count; i < RENDER_MAX_LAYERS; i++) {
+		ubo_data->layer_type[i].val = UINT32_MAX;
+	}
+
+	fill_unused_images(crc, src_samplers, src_image_views, &cur_image);
+
+	render_compute_layers_to_cache( //
+	    crc,                        //
+	    src_samplers,               //
+	    src_image_views,            //
+	    cur_image);                 //
+
+	r->layer_cache.valid = true;
+	r->layer_cache.first = first;
+	r->layer_cache.count = count;
+	r->layer_cache.image = image;
+
+	return true;
+}
+
+/*!
+ * Fills in the layer at @p ubo_i to sample the layer cache, the cache has the
+ * same layout as the scratch image so the views map straight onto it.
+ */
+static void
+do_cached_layer(struct render_compute *crc,
+                struct render_compute_layer_ubo_data *ubo_data,
+                uint32_t ubo_i,
+                const struct render_viewport_data views[2],
+                VkSampler src_samplers[RENDER_MAX_IMAGES],
+                VkImageView src_image_views[RENDER_MAX_IMAGES],
+                uint32_t *inout_cur_image)
+{
+	uint32_t cur_image = *inout_cur_image;
+	uint32_t view_index_for_layer = ubo_i * COMP_VIEWS_PER_LAYER;
+	VkExtent2D extent = crc->r->scratch.extent;
+
+	ubo_data->layer_type[ubo_i].val = RENDER_COMPUTE_LAYER_TYPE_CACHED;
+	ubo_data->layer_type[ubo_i].unpremultiplied = false;
+	ubo_data->layer_type[ubo_i].depth_reprojection = false;
+
+	set_full_view_bounds(ubo_data, view_index_for_layer);
+
+	src_samplers[cur_image] = crc->r->samplers.clamp_to_edge;
+	src_image_views[cur_image] = crc->r->scratch.cache.srgb_view; // Read with gamma curve.
+	ubo_data->images_samplers[view_index_for_layer + 0].images[0] = cur_image;
+	ubo_data->images_samplers[view_index_for_layer + 1].images[0] = cur_image;
+	cur_image++;
+
+	for (uint32_t view_i = 0; view_i < 2; view_i++) {
+		ubo_data->post_transforms[view_index_for_layer + view_i] = (struct xrt_normalized_rect){
+		    .x = (float)views[view_i].x / (float)extent.width,
+		    .y = (float)views[view_i].y / (float)extent.height,
+		    .w = (float)views[view_i].w / (float)extent.width,
+		    .h = (float)views[view_i].h / (float)extent.height,
+		};
+	}
+
+	*inout_cur_image = cur_image;
+}
+
+/*!
+ * The layers squashed by one dispatch of the layer shader, see do_layers.
+ */
+struct comp_renderer_layer_pass
+{
+	struct render_compute_layer_ubo_data *ubo_data;
+
+	// Tightly pack color and optional depth images.
+	VkSampler src_samplers[RENDER_MAX_IMAGES];
+	VkImageView src_image_views[RENDER_MAX_IMAGES];
+	uint32_t cur_image;
+
+	//! Used elements of the arrays in the UBO that have a value per layer.
+	uint32_t ubo_count;
+
+	//! Layers added to this pass, not counting the result of the previous pass.
+	uint32_t layer_count;
+};
+
+/*!
+ * Starts a new pass, all passes but the first start with a layer that samples
+ * the result of the previous pass. Returns NULL if there are no more passes.
+ */
+static struct comp_renderer_layer_pass *
+begin_layer_pass(struct render_compute *crc,
+                 struct comp_renderer_layer_pass passes[RENDER_MAX_LAYER_PASSES],
+                 uint32_t *inout_pass_count,
+                 const struct render_viewport_data views[2])
+{
+	uint32_t pass_index = *inout_pass_count;
+	if (pass_index >= RENDER_MAX_LAYER_PASSES) {
+		return NULL;
+	}
+
+	struct render_buffer *ubo = &crc->r->compute.layer.ubo;
+	if (pass_index > 0) {
+		ubo = &crc->r->compute.layer.pass_ubos[pass_index - 1];
+	}
+
+	struct comp_renderer_layer_pass *pass = &passes[pass_index];
+	pass->ubo_data = (struct render_compute_layer_ubo_data *)ubo->mapped;
+	pass->cur_image = 0;
+	pass->ubo_count = 0;
+	pass->layer_count = 0;
+
+	for (uint32_t i = 0; i < 2; i++) {
+		pass->ubo_data->views[i] = views[i];
+	}
+
+	pass->ubo_data->pre_transforms[0] = crc->r->distortion.uv_to_tanangle[0];
+	pass->ubo_data->pre_transforms[1] = crc->r->distortion.uv_to_tanangle[1];
+
+	if (pass_index > 0) {
+		// Has the same layout as the cache, the image view is set once the targets are known.
+		do_cached_layer(crc, pass->ubo_data, 0, views, pass->src_samplers, pass->src_image_views,
+		                &pass->cur_image);
+		pass->ubo_count = 1;
+	}
+
+	*inout_pass_count = pass_index + 1;
+
+	return pass;
+}
+
+/*!
+ * Adds @p layer to @p pass, returns false if it doesn't fit.
+ */
+static bool
+add_layer_to_pass(struct comp_renderer *r,
+                  struct render_compute *crc,
+                  struct comp_renderer_layer_pass *pass,
+                  const struct comp_layer *layer,
+                  const struct xrt_pose world_poses[2],
+                  const struct xrt_matrix_4x4 world_view_mats[2],
+                  const struct xrt_matrix_4x4 eye_view_mats[2])
+{
+	if (pass->ubo_count >= RENDER_MAX_LAYERS) {
+		return false;
+	}
+
+	bool ok = do_layer(        //
+	    r,                     //
+	    crc,                   //
+	    pass->ubo_data,        //
+	    pass->ubo_count,       //
+	    layer,                 //
+	    world_poses,           //
+	    world_view_mats,       //
+	    eye_view_mats,         //
+	    pass->src_samplers,    //
+	    pass->src_image_views, //
+	    &pass->cur_image);     //
+	if (!ok) {
+		return false;
+	}
+
+	pass->ubo_count++;
+	pass->layer_count++;
+
+	return true;
+}
+
+/*!
+ * Squashes all layers into the scratch image. If they don't fit in one
+ * dispatch, because of the layer count or the number of images they sample,
+ * they are split over several passes. Premultiplied "over" blending is
+ * associative, so each pass blends its layers over the result of the previous
+ * one, ping-ponging between the scratch pass and color images so that the last
+ * pass always writes the scratch color image.
+ */
+static void
+do_layers(struct comp_renderer *r,
+          struct render_compute *crc,
+          const struct comp_layer *layers,
+          uint32_t layer_count,
+          bool passthrough,
+          const struct comp_layer *overlay)
+{
+	struct render_viewport_data views[2];
+
+	// Create scratch image and get target views.
+	ensure_scratch_image(r, &views[0], &views[1]);
+
+	VkSampler clamp_to_border_black = crc->r->samplers.clamp_to_border_black;
+
+	struct xrt_pose world_poses[2], eye_poses[2];
+	get_view_poses(r, world_poses, eye_poses);
+
+	// Not the transform of the views, but the inverse: actual view matrices.
+	struct xrt_matrix_4x4 world_view_mats[2], eye_view_mats[2];
+	math_matrix_4x4_view_from_pose(&world_poses[0], &world_view_mats[0]);
+	math_matrix_4x4_view_from_pose(&world_poses[1], &world_view_mats[1]);
+	math_matrix_4x4_view_from_pose(&eye_poses[0], &eye_view_mats[0]);
+	math_matrix_4x4_view_from_pose(&eye_poses[1], &eye_view_mats[1]);
+
+	// Squash the unchanged layers at the top first, recorded before they are sampled.
+	uint32_t cache_first = layer_count;
+	if (r->settings->layer_cache) {
+		cache_first = layer_cache_update(r, layers, layer_count, eye_poses);
+	}
+	if (cache_first < layer_count &&
+	    !layer_cache_ensure(r, crc, layers, cache_first, layer_count, views, world_poses, world_view_mats,
+	                        eye_view_mats)) {
+		cache_first = layer_count;
+	}
+	if (cache_first >= layer_count) {
+		r->layer_cache.valid = false;
+	}
+
+	struct comp_renderer_layer_pass passes[RENDER_MAX_LAYER_PASSES];
+	uint32_t pass_count = 0;
+
+	struct comp_renderer_layer_pass *pass = begin_layer_pass(crc, passes, &pass_count, views);
+
+	// The passthrough layer goes under all of the application layers.
+	if (passthrough) {
+		do_passthrough_layer(r, pass->ubo_data, world_poses, clamp_to_border_black, pass->src_samplers,
+		                     pass->src_image_views, &pass->cur_image);
+		pass->ubo_count = 1;
+	}
+
+	// Set to false if we run out of passes, the layers above are then dropped.
+	bool complete = true;
+
+	for (uint32_t layer_i = 0; layer_i < cache_first; layer_i++) {
+		bool ok = add_layer_to_pass(r, crc, pass, &layers[layer_i], world_poses, world_view_mats, eye_view_mats);
+
+		// A layer that doesn't fit in an empty pass never will, skip it.
+		if (!ok && pass->layer_count > 0) {
+			pass = begin_layer_pass(crc, passes, &pass_count, views);
+			if (pass == NULL) {
+				pass = &passes[pass_count - 1];
+				complete = false;
+				break;
+			}
+
+			add_layer_to_pass(r, crc, pass, &layers[layer_i], world_poses, world_view_mats, eye_view_mats);
+		}
+	}
+
+	// The cached layers are replaced by a single layer.
+	if (cache_first < layer_count && complete) {
+		if (pass->ubo_count >= RENDER_MAX_LAYERS || pass->cur_image >= crc->r->compute.layer.image_array_size) {
+			pass = begin_layer_pass(crc, passes, &pass_count, views);
+		}
+
+		if (pass != NULL) {
+			do_cached_layer(crc, pass->ubo_data, pass->ubo_count, views, pass->src_samplers,
+			                pass->src_image_views, &pass->cur_image);
+			pass->ubo_count++;
+			pass->layer_count++;
+		}
+	}
+
+	// The overlay goes over all of the application layers.
+	if (overlay != NULL && pass != NULL && complete &&
+	    !add_layer_to_pass(r, crc, pass, overlay, world_poses, world_view_mats, eye_view_mats)) {
+		pass = begin_layer_pass(crc, passes, &pass_count, views);
+		if (pass != NULL) {
+			add_layer_to_pass(r, crc, pass, overlay, world_poses, world_view_mats, eye_view_mats);
+		}
+	}
+
+	// Fall back to only the first pass if the extra image can't be created.
+	if (pass_count > 1 && !render_ensure_scratch_pass_image(crc->r)) {
+		COMP_ERROR(r->c, "Could not create the scratch pass image, dropping layers!");
+		pass_count = 1;
+	}
+
+	VkImageView prev_srgb_view = VK_NULL_HANDLE;
+
+	for (uint32_t pass_i = 0; pass_i < pass_count; pass_i++) {
+		pass = &passes[pass_i];
+
+		for (uint32_t i = pass->ubo_count; i < RENDER_MAX_LAYERS; i++) {
+			pass->ubo_data->layer_type[i].val = UINT32_MAX; //! @todo make this not needed.
+		}
+
+		if (pass_i > 0) {
+			pass->src_image_views[0] = prev_srgb_view;
+		}
+
+		fill_unused_images(crc, pass->src_samplers, pass->src_image_views, &pass->cur_image);
+
+		// Counted from the last pass, which writes the scratch color image.
+		bool to_color = (pass_count - 1 - pass_i) % 2 == 0;
+
+		VkImage target_image = to_color ? crc->r->scratch.color.image : crc->r->scratch.pass.image;
+		VkImageView target_image_view =
+		    to_color ? crc->r->scratch.color.unorm_view : crc->r->scratch.pass.unorm_view; // Have to write in linear
+		prev_srgb_view = to_color ? crc->r->scratch.color.srgb_view : crc->r->scratch.pass.srgb_view;
+
+		// The common case of a lone projection layer doesn't need the layer loop.
+		uint32_t first_type = pass->ubo_data->layer_type[0].val;
+		bool single_projection = pass->ubo_count == 1 && (first_type == XRT_LAYER_STEREO_PROJECTION ||
+		                                                   first_type == XRT_LAYER_STEREO_PROJECTION_DEPTH);
+
+		render_compute_layers_pass(                   //
+		    crc,                                      //
+		    pass_i,                                   //
+		    pass->src_samplers,                       //
+		    pass->src_image_views,                    //
+		    pass->cur_image,                          //
+		    target_image,                             //
+		    target_image_view,                        //
+		    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, //
+		    !r->c->debug.atw_off,                     //
+		    single_projection);                       //
+	}
+}
+
+static void
+do_distortion(struct comp_renderer *r, struct render_compute *crc, const struct render_viewport_data views[2])
+{
+	VkImage target_image = r->c->target->images[r->acquired_buffer].handle;
+	VkImageView target_image_view = r->c->target->images[r->acquired_buffer].view;
+
+	VkImageView view = crc->r->scratch.color.srgb_view; // Read with gamma curve.
+	VkSampler sampler = crc->r->samplers.clamp_to_border_black;
+
+	VkImageView src_image_views[2] = {view, view};
+	VkSampler src_samplers[2] = {sampler, sampler};
+
+	struct xrt_normalized_rect src_norm_rects[2] = {
+	    {
+	        // Left, takes up half the screen.
 	        .x = 0.0f,
 	        .y = 0.0f,
 	        .w = 0.5f,
@@ -1438,6 +2600,62 @@ do_projection_layers(struct comp_renderer *r,
 		    target_image,                   //
 		    target_image_view,              //
 		    views);                         //
+
+		struct render_compute_distortion_ubo_data *ubo_data =
+		    (struct render_compute_distortion_ubo_data *)crc->r->compute.distortion.ubo.mapped;
+		late_latch_add(r, &ubo_data->transforms[0], 0, &src_poses[0], &src_fovs[0]);
+		late_latch_add(r, &ubo_data->transforms[1], 1, &src_poses[1], &src_fovs[1]);
+	}
+}
+
+static void
+acquire_swapchain_image_locked(struct vk_bundle *vk,
+                               VkCommandBuffer cmd,
+                               const struct comp_swapchain *sc,
+                               uint32_t image_index)
+{
+	if (sc == NULL || image_index >= sc->vkic.image_count) {
+		return;
+	}
+
+	VkImageSubresourceRange subresource_range = {
+	    .aspectMask = vk_csci_get_barrier_aspect_mask((VkFormat)sc->vkic.info.format),
+	    .baseMipLevel = 0,
+	    .levelCount = VK_REMAINING_MIP_LEVELS,
+	    .baseArrayLayer = 0,
+	    .layerCount = VK_REMAINING_ARRAY_LAYERS,
+	};
+
+	vk_cmd_image_barrier_acquire_external_locked( //
+	    vk,                                       // vk_bundle
+	    cmd,                                      // cmd_buffer
+	    sc->vkic.images[image_index].handle,      // image
+	    VK_ACCESS_SHADER_READ_BIT,                // dst_access_mask
+	    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, // layout
+	    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,     // dst_stage_mask
+	    subresource_range);                       // subresource_range
+}
+
+/*!
+ * The compute path runs on a compute only queue family when available, while
+ * the application rendered the images on its graphics queue, so take
+ * ownership of the images released to the external queue family.
+ */
+static void
+acquire_layer_images_locked(struct comp_renderer *r, VkCommandBuffer cmd)
+{
+	struct vk_bundle *vk = &r->c->base.vk;
+	const struct comp_layer *layers = r->c->base.slot.layers;
+	uint32_t layer_count = r->c->base.slot.layer_count;
+
+	for (uint32_t i = 0; i < layer_count; i++) {
+		struct comp_swapchain *scs[4];
+		uint32_t indices[4];
+		uint32_t count = get_layer_images(&layers[i], scs, indices);
+
+		for (uint32_t k = 0; k < count; k++) {
+			acquire_swapchain_image_locked(vk, cmd, scs[k], indices[k]);
+		}
 	}
 }
 
@@ -1454,14 +2672,29 @@ dispatch_compute(struct comp_renderer *r, struct render_compute *crc)
 
 	render_compute_begin(crc);
 
+	r->late_latch.entry_count = 0;
+
+	acquire_layer_images_locked(r, crc->r->cmd);
+
+	// Recorded first so the images are ready when the layers are squashed.
+	bool passthrough = comp_passthrough_upload_locked(&r->passthrough, &c->base.vk, crc->r->cmd);
+	const struct comp_layer *overlay =
+	    comp_perf_overlay_update_locked(&r->perf_overlay, c, &c->base.vk, crc->r->cmd);
+
 	struct render_viewport_data views[2];
 	calc_viewport_data(r, &views[0], &views[1]);
 
+	// Before any of the foveated shaders have their UBOs filled in.
+	update_foveation_centers(r);
+
 	VkImage target_image = r->c->target->images[r->acquired_buffer].handle;
 	VkImageView target_image_view = r->c->target->images[r->acquired_buffer].view;
 
 	uint32_t layer_count = c->base.slot.layer_count;
-	bool fast_path = c->base.slot.one_projection_layer_fast_path;
+	bool fast_path = c->base.slot.one_projection_layer_fast_path && !passthrough && overlay == NULL;
+
+	// The fast path only does rotation, the layer squasher can use the depth.
+	bool depth_timewarp = r->settings->depth_timewarp && !r->c->debug.atw_off;
 
 	if (fast_path && c->base.slot.layers[0].data.type == XRT_LAYER_STEREO_PROJECTION) {
 		int i = 0;
@@ -1471,7 +2704,9 @@ dispatch_compute(struct comp_renderer *r, struct render_compute *crc)
 		const struct xrt_layer_projection_view_data *rvd = &stereo->r;
 
 		do_projection_layers(r, crc, layer, lvd, rvd);
-	} else if (fast_path && c->base.slot.layers[0].data.type == XRT_LAYER_STEREO_PROJECTION_DEPTH) {
+		render_resources_write_timestamp(crc->r, crc->r->cmd, RENDER_TIMESTAMP_POINT_DISTORTION);
+	} else if (fast_path && !depth_timewarp &&
+	           c->base.slot.layers[0].data.type == XRT_LAYER_STEREO_PROJECTION_DEPTH) {
 		int i = 0;
 		const struct comp_layer *layer = &c->base.slot.layers[i];
 		const struct xrt_layer_stereo_projection_depth_data *stereo = &layer->data.stereo_depth;
@@ -1479,10 +2714,13 @@ dispatch_compute(struct comp_renderer *r, struct render_compute *crc)
 		const struct xrt_layer_projection_view_data *rvd = &stereo->r;
 
 		do_projection_layers(r, crc, layer, lvd, rvd);
-	} else if (layer_count > 0) {
-		do_layers(r, crc, c->base.slot.layers, layer_count);
+		render_resources_write_timestamp(crc->r, crc->r->cmd, RENDER_TIMESTAMP_POINT_DISTORTION);
+	} else if (layer_count > 0 || passthrough || overlay != NULL) {
+		do_layers(r, crc, c->base.slot.layers, layer_count, passthrough, overlay);
+		render_resources_write_timestamp(crc->r, crc->r->cmd, RENDER_TIMESTAMP_POINT_LAYERS);
 
 		do_distortion(r, crc, views);
+		render_resources_write_timestamp(crc->r, crc->r->cmd, RENDER_TIMESTAMP_POINT_DISTORTION);
 	} else {
 		render_compute_clear(  //
 		    crc,               //
@@ -1493,6 +2731,8 @@ dispatch_compute(struct comp_renderer *r, struct render_compute *crc)
 
 	render_compute_end(crc);
 
+	late_latch_timewarp(r);
+
 	comp_target_mark_submit(ct, c->frame.rendering.id, os_monotonic_get_ns());
 
 	renderer_submit_queue(r, crc->r->cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
@@ -1766,6 +3006,42 @@ comp_renderer_set_cube_layer(struct comp_renderer *r,
 }
 #endif
 
+/*!
+ * Smooths the GPU times over a few frames.
+ */
+static void
+filter_gpu_time(uint64_t *value_ns, uint64_t sample_ns)
+{
+	*value_ns = *value_ns == 0 ? sample_ns : (*value_ns * 7 + sample_ns) / 8;
+}
+
+static void
+update_gpu_times(struct comp_compositor *c, struct comp_target *ct, const struct render_frame_timestamps *timestamps)
+{
+	const uint64_t *points_ns = timestamps->points_ns;
+	uint64_t begin_ns = points_ns[RENDER_TIMESTAMP_POINT_BEGIN];
+	uint64_t end_ns = points_ns[RENDER_TIMESTAMP_POINT_END];
+	bool has_layers = (timestamps->written & (1u << RENDER_TIMESTAMP_POINT_LAYERS)) != 0;
+	bool has_distortion = (timestamps->written & (1u << RENDER_TIMESTAMP_POINT_DISTORTION)) != 0;
+
+	if (timestamps->host_time) {
+		uint64_t now_ns = os_monotonic_get_ns();
+		comp_target_info_gpu(ct, timestamps->frame_id, begin_ns, end_ns, now_ns);
+	}
+
+	// Used for the apps' render scale.
+	filter_gpu_time(&c->gpu_time.total_ns, end_ns - begin_ns);
+
+	// Per pass breakdown, only the compute path writes these.
+	if (has_layers) {
+		filter_gpu_time(&c->gpu_time.layers_ns, points_ns[RENDER_TIMESTAMP_POINT_LAYERS] - begin_ns);
+	}
+	if (has_distortion) {
+		uint64_t from_ns = has_layers ? points_ns[RENDER_TIMESTAMP_POINT_LAYERS] : begin_ns;
+		filter_gpu_time(&c->gpu_time.distortion_ns, points_ns[RENDER_TIMESTAMP_POINT_DISTORTION] - from_ns);
+	}
+}
+
 void
 comp_renderer_draw(struct comp_renderer *r)
 {
@@ -1784,6 +3060,9 @@ comp_renderer_draw(struct comp_renderer *r)
 	// Tell the target we are starting to render, for frame timing.
 	comp_target_mark_begin(ct, c->frame.rendering.id, os_monotonic_get_ns());
 
+	// The GPU timestamps are read back frames later, tag them with the frame.
+	c->nr.timestamps.frame_id = c->frame.rendering.id;
+
 	// Are we ready to render? No - skip rendering.
 	if (!comp_target_check_ready(r->c->target)) {
 		// Need to emulate rendering for the timing.
@@ -1799,6 +3078,16 @@ comp_renderer_draw(struct comp_renderer *r)
 
 	comp_target_update_timings(ct);
 
+	// The device changed its optics, regenerate the distortion once the GPU is done with it.
+	struct xrt_hmd_parts *hmd = c->xdev->hmd;
+	if (hmd->distortion.ellipsoid.valid &&
+	    hmd->distortion.ellipsoid.generation != c->nr.distortion.ellipsoid_generation) {
+		renderer_wait_queue_idle(r);
+		if (!render_distortion_images_ensure(&c->nr, &c->base.vk, c->xdev, c->nr.distortion.pre_rotated)) {
+			COMP_ERROR(c, "Failed to regenerate distortion images");
+		}
+	}
+
 	if (r->acquired_buffer < 0) {
 		// Ensures that renderings are created.
 		renderer_acquire_swapchain_image(r);
@@ -1848,6 +3137,9 @@ comp_renderer_draw(struct comp_renderer *r)
 	// Clear the rendered frame.
 	comp_frame_clear_locked(&c->frame.rendering);
 
+	// Pushes the previous readback, if it's done.
+	comp_mirror_poll_readback(&r->mirror_to_debug_gui, &c->base.vk, false);
+
 	comp_mirror_fixup_ui_state(&r->mirror_to_debug_gui, c);
 	if (comp_mirror_is_ready_and_active(&r->mirror_to_debug_gui, c, predicted_display_time_ns)) {
 
@@ -1896,13 +3188,12 @@ comp_renderer_draw(struct comp_renderer *r)
 
 
 	/*
-	 * Get timestamps of GPU work (if available).
+	 * Get timestamps of GPU work of this or an earlier frame (if available).
 	 */
 
-	uint64_t gpu_start_ns, gpu_end_ns;
-	if (render_resources_get_timestamps(&c->nr, &gpu_start_ns, &gpu_end_ns)) {
-		uint64_t now_ns = os_monotonic_get_ns();
-		comp_target_info_gpu(ct, frame_id, gpu_start_ns, gpu_end_ns, now_ns);
+	struct render_frame_timestamps timestamps;
+	if (render_resources_get_frame_timestamps(&c->nr, &timestamps)) {
+		update_gpu_times(c, ct, &timestamps);
 	}
 
 
@@ -1993,10 +3284,17 @@ comp_renderer_destroy(struct comp_renderer **ptr_r)
 	*ptr_r = NULL;
 }
 
+bool
+comp_renderer_is_mirroring_to_debug_gui(struct comp_renderer *self)
+{
+	return self->c->mirroring_to_debug_gui && u_sink_debug_is_active(&self->mirror_to_debug_gui.debug_sink);
+}
+
 void
 comp_renderer_add_debug_vars(struct comp_renderer *self)
 {
 	struct comp_renderer *r = self;
 
 	comp_mirror_add_debug_vars(&r->mirror_to_debug_gui, r->c);
+	comp_passthrough_add_debug_vars(&r->passthrough, r->c);
 }
@@ -143,6 +143,17 @@ comp_renderer_destroy_layers(struct comp_renderer *self);
 void
 comp_renderer_add_debug_vars(struct comp_renderer *self);
 
+/*!
+ * Is the left eye being mirrored to a debug gui sink that someone listens to,
+ * the mirror reads from the squashed layer image that the one projection layer
+ * fast path skips.
+ *
+ * @public @memberof comp_renderer
+ * @ingroup comp_main
+ */
+bool
+comp_renderer_is_mirroring_to_debug_gui(struct comp_renderer *self);
+
 #ifdef __cplusplus
 }
 #endif
@@ -10,6 +10,8 @@
 #include "util/u_debug.h"
 #include "comp_settings.h"
 
+#include <string.h>
+
 // clang-format off
 DEBUG_GET_ONCE_LOG_OPTION(log, "XRT_COMPOSITOR_LOG", U_LOGGING_INFO)
 DEBUG_GET_ONCE_BOOL_OPTION(print_modes, "XRT_COMPOSITOR_PRINT_MODES", false)
@@ -20,16 +22,43 @@ DEBUG_GET_ONCE_OPTION(nvidia_display, "XRT_COMPOSITOR_FORCE_NVIDIA_DISPLAY", NUL
 DEBUG_GET_ONCE_NUM_OPTION(vk_display, "XRT_COMPOSITOR_FORCE_VK_DISPLAY", -1)
 DEBUG_GET_ONCE_BOOL_OPTION(force_xcb, "XRT_COMPOSITOR_FORCE_XCB", false)
 DEBUG_GET_ONCE_BOOL_OPTION(force_wayland, "XRT_COMPOSITOR_FORCE_WAYLAND", false)
+DEBUG_GET_ONCE_BOOL_OPTION(force_offscreen, "XRT_COMPOSITOR_FORCE_OFFSCREEN", false)
 DEBUG_GET_ONCE_NUM_OPTION(force_gpu_index, "XRT_COMPOSITOR_FORCE_GPU_INDEX", -1)
 DEBUG_GET_ONCE_NUM_OPTION(force_client_gpu_index, "XRT_COMPOSITOR_FORCE_CLIENT_GPU_INDEX", -1)
+DEBUG_GET_ONCE_BOOL_OPTION(cross_gpu, "XRT_COMPOSITOR_CROSS_GPU", true)
 DEBUG_GET_ONCE_NUM_OPTION(desired_mode, "XRT_COMPOSITOR_DESIRED_MODE", -1)
 DEBUG_GET_ONCE_NUM_OPTION(scale_percentage, "XRT_COMPOSITOR_SCALE_PERCENTAGE", 140)
 DEBUG_GET_ONCE_BOOL_OPTION(xcb_fullscreen, "XRT_COMPOSITOR_XCB_FULLSCREEN", false)
 DEBUG_GET_ONCE_NUM_OPTION(xcb_display, "XRT_COMPOSITOR_XCB_DISPLAY", -1)
 DEBUG_GET_ONCE_NUM_OPTION(default_framerate, "XRT_COMPOSITOR_DEFAULT_FRAMERATE", 60)
 DEBUG_GET_ONCE_BOOL_OPTION(compute, "XRT_COMPOSITOR_COMPUTE", false)
+DEBUG_GET_ONCE_BOOL_OPTION(late_latch, "XRT_COMPOSITOR_LATE_LATCH", true)
+DEBUG_GET_ONCE_BOOL_OPTION(depth_timewarp, "XRT_COMPOSITOR_DEPTH_TIMEWARP", true)
+DEBUG_GET_ONCE_BOOL_OPTION(layer_cache, "XRT_COMPOSITOR_LAYER_CACHE", true)
+DEBUG_GET_ONCE_BOOL_OPTION(vblank_timing, "XRT_COMPOSITOR_VBLANK_DISPLAY_TIMING", false)
+DEBUG_GET_ONCE_BOOL_OPTION(standby, "XRT_COMPOSITOR_STANDBY", false)
+DEBUG_GET_ONCE_OPTION(latency_mode, "XRT_COMPOSITOR_LATENCY_MODE", NULL)
 // clang-format on
 
+static enum comp_latency_mode
+get_latency_mode(void)
+{
+	const char *option = debug_get_option_latency_mode();
+	if (option == NULL || strcmp(option, "default") == 0) {
+		return COMP_LATENCY_MODE_DEFAULT;
+	} else if (strcmp(option, "fifo") == 0) {
+		return COMP_LATENCY_MODE_FIFO;
+	} else if (strcmp(option, "mailbox") == 0) {
+		return COMP_LATENCY_MODE_MAILBOX;
+	} else if (strcmp(option, "fifo_relaxed") == 0) {
+		return COMP_LATENCY_MODE_FIFO_RELAXED;
+	}
+
+	U_LOG_W("Unknown XRT_COMPOSITOR_LATENCY_MODE '%s', valid are default, fifo, mailbox and fifo_relaxed.", option);
+
+	return COMP_LATENCY_MODE_DEFAULT;
+}
+
 void
 comp_settings_init(struct comp_settings *s, struct xrt_device *xdev)
 {
@@ -41,6 +70,11 @@ comp_settings_init(struct comp_settings *s, struct xrt_device *xdev)
 	}
 
 	s->use_compute = debug_get_bool_option_compute();
+	s->late_latch = debug_get_bool_option_late_latch();
+	s->depth_timewarp = debug_get_bool_option_depth_timewarp();
+	s->layer_cache = debug_get_bool_option_layer_cache();
+	s->vblank_timing = debug_get_bool_option_vblank_timing();
+	s->standby = debug_get_bool_option_standby();
 
 	if (s->use_compute) {
 		s->color_format = VK_FORMAT_B8G8R8A8_UNORM;
@@ -68,6 +102,7 @@ comp_settings_init(struct comp_settings *s, struct xrt_device *xdev)
 	s->display = debug_get_num_option_xcb_display();
 	s->color_space = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
 	s->present_mode = VK_PRESENT_MODE_FIFO_KHR;
+	s->latency_mode = get_latency_mode();
 	s->fullscreen = debug_get_bool_option_xcb_fullscreen();
 	s->preferred.width = xdev->hmd->screens[0].w_pixels;
 	s->preferred.height = xdev->hmd->screens[0].h_pixels;
@@ -76,6 +111,7 @@ comp_settings_init(struct comp_settings *s, struct xrt_device *xdev)
 	s->print_modes = debug_get_bool_option_print_modes();
 	s->selected_gpu_index = debug_get_num_option_force_gpu_index();
 	s->client_gpu_index = debug_get_num_option_force_client_gpu_index();
+	s->cross_gpu = debug_get_bool_option_cross_gpu();
 	s->desired_mode = debug_get_num_option_desired_mode();
 	s->viewport_scale = debug_get_num_option_scale_percentage() / 100.0;
 
@@ -112,4 +148,7 @@ comp_settings_init(struct comp_settings *s, struct xrt_device *xdev)
 		s->preferred.width /= 2;
 		s->preferred.height /= 2;
 	}
+	if (debug_get_bool_option_force_offscreen()) {
+		s->target_identifier = "offscreen";
+	}
 }
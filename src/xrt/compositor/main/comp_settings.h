@@ -39,6 +39,24 @@ XRT_MAYBE_UNUSED static const char *NV_DIRECT_ALLOWLIST[] = {
     "PNP",                         // NorthStar (Generic)
 };
 
+/*!
+ * How deep the queue of presented images on the target is allowed to be,
+ * trading latency against safety from missed frames.
+ *
+ * @ingroup comp_main
+ */
+enum comp_latency_mode
+{
+	//! Use the present mode the target asks for, with at least two images.
+	COMP_LATENCY_MODE_DEFAULT,
+	//! FIFO with two images and a tighter pacing margin.
+	COMP_LATENCY_MODE_FIFO,
+	//! MAILBOX with three images, newer frames replace queued ones.
+	COMP_LATENCY_MODE_MAILBOX,
+	//! FIFO_RELAXED with two images, late frames tear instead of waiting.
+	COMP_LATENCY_MODE_FIFO_RELAXED,
+};
+
 /*!
  * Settings for the compositor.
  *
@@ -50,10 +68,28 @@ struct comp_settings
 
 	bool use_compute;
 
+	//! Recalculate the timewarp matrices with a new pose right before submit, compute path only.
+	bool late_latch;
+
+	//! Also correct for translation with the depth of projection depth layers, compute path only.
+	bool depth_timewarp;
+
+	//! Squash unchanged view space quad layers ahead of time, compute path only.
+	bool layer_cache;
+
+	//! Make display timing from vblank events on direct mode displays without VK_GOOGLE_display_timing.
+	bool vblank_timing;
+
+	//! Only create the target, and take the display, when the first session begins.
+	bool standby;
+
 	VkFormat color_format;
 	VkColorSpaceKHR color_space;
 	VkPresentModeKHR present_mode;
 
+	//! Selects present mode and image count, falls back to @ref present_mode if not supported.
+	enum comp_latency_mode latency_mode;
+
 	//! Preferred window type to use, not actual used.
 	const char *target_identifier;
 
@@ -91,6 +127,9 @@ struct comp_settings
 	//! Vulkan physical device index for clients to use, forced by user
 	int client_gpu_index;
 
+	//! Copy swapchains to the selected GPU if clients use another one, instead of requiring the same GPU.
+	bool cross_gpu;
+
 
 	//! Vulkan device UUID selected by comp_settings_check_vulkan_caps, valid across Vulkan instances
 	xrt_uuid_t selected_gpu_deviceUUID;
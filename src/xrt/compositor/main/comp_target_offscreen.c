@@ -0,0 +1,597 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Offscreen target that renders into exportable images.
+ * @ingroup comp_main
+ */
+
+#include "xrt/xrt_config_have.h"
+#include "xrt/xrt_config_os.h"
+
+#include "os/os_time.h"
+
+#include "util/u_debug.h"
+#include "util/u_misc.h"
+#include "util/u_pacing.h"
+#include "util/u_time.h"
+
+#include "vk/vk_cmd.h"
+
+#include "main/comp_compositor.h"
+#include "main/comp_target_offscreen.h"
+
+#if defined(XRT_HAVE_GST) && defined(XRT_OS_LINUX)
+#define COMP_HAVE_ENCODER_TAP
+#include "main/comp_encoder_tap.h"
+#endif
+
+#include <assert.h>
+#include <inttypes.h>
+
+
+DEBUG_GET_ONCE_NUM_OPTION(offscreen_framerate, "XRT_COMPOSITOR_OFFSCREEN_FRAMERATE", 0)
+DEBUG_GET_ONCE_OPTION(encoder_pipeline, "XRT_COMPOSITOR_ENCODER_PIPELINE", NULL)
+
+
+/*!
+ * Calls `vkDestroy##TYPE` on `THING` if it is not `VK_NULL_HANDLE`, sets it to
+ * `VK_NULL_HANDLE` afterwards.
+ */
+#define D(TYPE, THING)                                                                                                 \
+	if (THING != VK_NULL_HANDLE) {                                                                                 \
+		vk->vkDestroy##TYPE(vk->device, THING, NULL);                                                          \
+		THING = VK_NULL_HANDLE;                                                                                \
+	}
+
+
+/*
+ *
+ * Helper functions.
+ *
+ */
+
+static inline struct vk_bundle *
+get_vk(struct comp_target_offscreen *cto)
+{
+	return &cto->base.c->base.vk;
+}
+
+static enum xrt_swapchain_usage_bits
+usage_to_xrt_bits(VkImageUsageFlags image_usage)
+{
+	// Sampled and transfer source so that a consumer can read the images.
+	enum xrt_swapchain_usage_bits bits = XRT_SWAPCHAIN_USAGE_SAMPLED | XRT_SWAPCHAIN_USAGE_TRANSFER_SRC;
+
+	if ((image_usage & VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT) != 0) {
+		bits |= XRT_SWAPCHAIN_USAGE_COLOR;
+	}
+	if ((image_usage & VK_IMAGE_USAGE_STORAGE_BIT) != 0) {
+		bits |= XRT_SWAPCHAIN_USAGE_UNORDERED_ACCESS;
+	}
+	if ((image_usage & VK_IMAGE_USAGE_TRANSFER_DST_BIT) != 0) {
+		bits |= XRT_SWAPCHAIN_USAGE_TRANSFER_DST;
+	}
+
+	return bits;
+}
+
+static void
+destroy_images(struct comp_target_offscreen *cto)
+{
+	struct vk_bundle *vk = get_vk(cto);
+
+	if (cto->base.images != NULL) {
+		for (uint32_t i = 0; i < cto->base.image_count; i++) {
+			D(ImageView, cto->base.images[i].view);
+		}
+
+		free(cto->base.images);
+		cto->base.images = NULL;
+	}
+
+	vk_ic_destroy(vk, &cto->vkic);
+	U_ZERO(&cto->vkic);
+
+#ifdef COMP_HAVE_ENCODER_TAP
+	comp_encoder_tap_destroy(&cto->tap);
+#endif
+
+	cto->base.image_count = 0;
+
+	os_mutex_lock(&cto->mutex);
+	cto->latest.valid = false;
+	os_mutex_unlock(&cto->mutex);
+}
+
+static void
+destroy_semaphores(struct comp_target_offscreen *cto)
+{
+	struct vk_bundle *vk = get_vk(cto);
+
+	D(Semaphore, cto->base.semaphores.render_complete);
+	cto->base.semaphores.render_complete_is_timeline = false;
+}
+
+static VkResult
+create_semaphores(struct comp_target_offscreen *cto)
+{
+	struct vk_bundle *vk = get_vk(cto);
+	const void *next = NULL;
+
+	destroy_semaphores(cto);
+
+#ifdef VK_KHR_timeline_semaphore
+	/*
+	 * With a timeline consumers can wait for any given frame without the
+	 * target having to consume the signal, use it when we have it.
+	 */
+	VkSemaphoreTypeCreateInfo type_info = {
+	    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+	    .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+	    .initialValue = 0,
+	};
+
+	if (vk->features.timeline_semaphore) {
+		next = &type_info;
+	}
+#endif
+
+	VkSemaphoreCreateInfo info = {
+	    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+	    .pNext = next,
+	};
+
+	VkResult ret = vk->vkCreateSemaphore(vk->device, &info, NULL, &cto->base.semaphores.render_complete);
+	if (ret != VK_SUCCESS) {
+		COMP_ERROR(cto->base.c, "vkCreateSemaphore: %s", vk_result_string(ret));
+		return ret;
+	}
+
+	cto->base.semaphores.render_complete_is_timeline = next != NULL;
+
+	return VK_SUCCESS;
+}
+
+/*!
+ * A binary semaphore must be waited on before it can be signaled again, with
+ * no presentation engine to do that we wait on it with an empty submit.
+ */
+static VkResult
+consume_binary_semaphore(struct comp_target_offscreen *cto, VkQueue queue)
+{
+	struct vk_bundle *vk = get_vk(cto);
+
+	VkPipelineStageFlags stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+	VkSubmitInfo submit_info = {
+	    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+	    .waitSemaphoreCount = 1,
+	    .pWaitSemaphores = &cto->base.semaphores.render_complete,
+	    .pWaitDstStageMask = &stage,
+	};
+
+	assert(queue == vk->queue);
+
+	// Takes the queue lock.
+	VkResult ret = vk_cmd_submit_locked(vk, 1, &submit_info, VK_NULL_HANDLE);
+	if (ret != VK_SUCCESS) {
+		COMP_ERROR(cto->base.c, "vk_cmd_submit_locked: %s", vk_result_string(ret));
+	}
+
+	return ret;
+}
+
+
+/*
+ *
+ * Member functions.
+ *
+ */
+
+static bool
+target_init_pre_vulkan(struct comp_target *ct)
+{
+	return true;
+}
+
+static bool
+target_init_post_vulkan(struct comp_target *ct, uint32_t preferred_width, uint32_t preferred_height)
+{
+	struct comp_target_offscreen *cto = (struct comp_target_offscreen *)ct;
+
+	u_pc_fake_create(cto->frame_interval_ns, os_monotonic_get_ns(), &cto->upc);
+
+	return create_semaphores(cto) == VK_SUCCESS;
+}
+
+static bool
+target_check_ready(struct comp_target *ct)
+{
+	struct comp_target_offscreen *cto = (struct comp_target_offscreen *)ct;
+	return cto->base.semaphores.render_complete != VK_NULL_HANDLE;
+}
+
+static void
+target_create_images(struct comp_target *ct,
+                     uint32_t preferred_width,
+                     uint32_t preferred_height,
+                     VkFormat color_format,
+                     VkColorSpaceKHR color_space,
+                     VkImageUsageFlags image_usage,
+                     VkPresentModeKHR present_mode)
+{
+	struct comp_target_offscreen *cto = (struct comp_target_offscreen *)ct;
+	struct vk_bundle *vk = get_vk(cto);
+	VkImage images[COMP_TARGET_OFFSCREEN_IMAGE_COUNT];
+	VkResult ret;
+
+	// The renderer has waited for the queue to go idle.
+	destroy_images(cto);
+
+	const char *pipeline_string = debug_get_option_encoder_pipeline();
+
+#ifdef COMP_HAVE_ENCODER_TAP
+	if (pipeline_string != NULL) {
+		comp_encoder_tap_create(               //
+		    vk,                                //
+		    pipeline_string,                   //
+		    preferred_width,                   //
+		    preferred_height,                  //
+		    color_format,                      //
+		    image_usage,                       //
+		    COMP_TARGET_OFFSCREEN_IMAGE_COUNT, //
+		    &cto->tap);                        //
+	}
+
+	if (cto->tap != NULL) {
+		for (uint32_t i = 0; i < COMP_TARGET_OFFSCREEN_IMAGE_COUNT; i++) {
+			images[i] = comp_encoder_tap_get_image(cto->tap, i)->handle;
+		}
+	}
+#endif
+
+	if (cto->tap == NULL) {
+		if (pipeline_string != NULL) {
+			COMP_WARN(ct->c, "Could not create the encoder tap, images are only exported as opaque handles.");
+		}
+
+		struct xrt_swapchain_create_info info = {
+		    .create = 0,
+		    .bits = usage_to_xrt_bits(image_usage),
+		    .format = color_format,
+		    .sample_count = 1,
+		    .width = preferred_width,
+		    .height = preferred_height,
+		    .face_count = 1,
+		    .array_size = 1,
+		    .mip_count = 1,
+		};
+
+		ret = vk_ic_allocate(vk, &info, COMP_TARGET_OFFSCREEN_IMAGE_COUNT, &cto->vkic);
+		if (ret != VK_SUCCESS) {
+			COMP_ERROR(ct->c, "vk_ic_allocate: %s", vk_result_string(ret));
+			return;
+		}
+
+		for (uint32_t i = 0; i < COMP_TARGET_OFFSCREEN_IMAGE_COUNT; i++) {
+			images[i] = cto->vkic.images[i].handle;
+		}
+	}
+
+	VkImageSubresourceRange subresource_range = {
+	    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	    .baseMipLevel = 0,
+	    .levelCount = 1,
+	    .baseArrayLayer = 0,
+	    .layerCount = 1,
+	};
+
+	cto->base.images = U_TYPED_ARRAY_CALLOC(struct comp_target_image, COMP_TARGET_OFFSCREEN_IMAGE_COUNT);
+	cto->base.image_count = COMP_TARGET_OFFSCREEN_IMAGE_COUNT;
+
+	for (uint32_t i = 0; i < cto->base.image_count; i++) {
+		cto->base.images[i].handle = images[i];
+		vk_create_view(                 //
+		    vk,                         // vk_bundle
+		    cto->base.images[i].handle, // image
+		    VK_IMAGE_VIEW_TYPE_2D,      // type
+		    color_format,               // format
+		    subresource_range,          // subresource_range
+		    &cto->base.images[i].view); // out_view
+	}
+
+	cto->base.width = preferred_width;
+	cto->base.height = preferred_height;
+	cto->base.format = color_format;
+	cto->base.surface_transform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+	cto->next_index = 0;
+
+	COMP_INFO(ct->c, "Created %u offscreen images %ux%u.", cto->base.image_count, preferred_width, preferred_height);
+}
+
+static bool
+target_has_images(struct comp_target *ct)
+{
+	struct comp_target_offscreen *cto = (struct comp_target_offscreen *)ct;
+	return cto->base.image_count > 0;
+}
+
+static VkResult
+target_acquire(struct comp_target *ct, uint32_t *out_index)
+{
+	struct comp_target_offscreen *cto = (struct comp_target_offscreen *)ct;
+
+	if (!target_has_images(ct)) {
+		return VK_ERROR_INITIALIZATION_FAILED;
+	}
+
+	/*
+	 * The renderer waits for the previous frame before submitting a new
+	 * one, so the images are just handed out in order.
+	 */
+	uint32_t index = cto->next_index;
+
+#ifdef COMP_HAVE_ENCODER_TAP
+	// Skip images the encoder still reads, if all are held render over the oldest.
+	for (uint32_t i = 0; cto->tap != NULL && i < cto->base.image_count; i++) {
+		uint32_t candidate = (cto->next_index + i) % cto->base.image_count;
+		if (!comp_encoder_tap_is_held(cto->tap, candidate)) {
+			index = candidate;
+			break;
+		}
+	}
+#endif
+
+	*out_index = index;
+	cto->next_index = (index + 1) % cto->base.image_count;
+
+	return VK_SUCCESS;
+}
+
+static VkResult
+target_present(struct comp_target *ct,
+               VkQueue queue,
+               uint32_t index,
+               uint64_t timeline_semaphore_value,
+               uint64_t desired_present_time_ns,
+               uint64_t present_slop_ns)
+{
+	struct comp_target_offscreen *cto = (struct comp_target_offscreen *)ct;
+
+	if (!cto->base.semaphores.render_complete_is_timeline) {
+		VkResult ret = consume_binary_semaphore(cto, queue);
+		if (ret != VK_SUCCESS) {
+			return ret;
+		}
+	}
+
+	os_mutex_lock(&cto->mutex);
+	cto->latest.valid = true;
+	cto->latest.index = index;
+	cto->latest.timeline_value = timeline_semaphore_value;
+	cto->latest.desired_present_time_ns = desired_present_time_ns;
+	os_mutex_unlock(&cto->mutex);
+
+#ifdef COMP_HAVE_ENCODER_TAP
+	if (cto->tap != NULL) {
+		comp_encoder_tap_push(                    //
+		    cto->tap,                             //
+		    index,                                //
+		    cto->base.semaphores.render_complete, //
+		    timeline_semaphore_value,             //
+		    desired_present_time_ns);             //
+	}
+#endif
+
+	cto->presented_count++;
+
+	return VK_SUCCESS;
+}
+
+static void
+target_flush(struct comp_target *ct)
+{
+	// Nothing to do.
+}
+
+static void
+target_calc_frame_pacing(struct comp_target *ct,
+                         int64_t *out_frame_id,
+                         uint64_t *out_wake_up_time_ns,
+                         uint64_t *out_desired_present_time_ns,
+                         uint64_t *out_present_slop_ns,
+                         uint64_t *out_predicted_display_time_ns)
+{
+	struct comp_target_offscreen *cto = (struct comp_target_offscreen *)ct;
+
+	int64_t frame_id = -1;
+	uint64_t wake_up_time_ns = 0;
+	uint64_t desired_present_time_ns = 0;
+	uint64_t present_slop_ns = 0;
+	uint64_t predicted_display_time_ns = 0;
+	uint64_t predicted_display_period_ns = 0;
+	uint64_t min_display_period_ns = 0;
+	uint64_t now_ns = os_monotonic_get_ns();
+
+	u_pc_predict(cto->upc,                     //
+	             now_ns,                       //
+	             &frame_id,                    //
+	             &wake_up_time_ns,             //
+	             &desired_present_time_ns,     //
+	             &present_slop_ns,             //
+	             &predicted_display_time_ns,   //
+	             &predicted_display_period_ns, //
+	             &min_display_period_ns);      //
+
+	cto->current_frame_id = frame_id;
+
+	*out_frame_id = frame_id;
+	*out_wake_up_time_ns = wake_up_time_ns;
+	*out_desired_present_time_ns = desired_present_time_ns;
+	*out_predicted_display_time_ns = predicted_display_time_ns;
+	*out_present_slop_ns = present_slop_ns;
+}
+
+static void
+target_mark_timing_point(struct comp_target *ct,
+                         enum comp_target_timing_point point,
+                         int64_t frame_id,
+                         uint64_t when_ns)
+{
+	struct comp_target_offscreen *cto = (struct comp_target_offscreen *)ct;
+	assert(frame_id == cto->current_frame_id);
+
+	switch (point) {
+	case COMP_TARGET_TIMING_POINT_WAKE_UP:
+		u_pc_mark_point(cto->upc, U_TIMING_POINT_WAKE_UP, frame_id, when_ns);
+		break;
+	case COMP_TARGET_TIMING_POINT_BEGIN:
+		u_pc_mark_point(cto->upc, U_TIMING_POINT_BEGIN, frame_id, when_ns);
+		break;
+	case COMP_TARGET_TIMING_POINT_SUBMIT:
+		u_pc_mark_point(cto->upc, U_TIMING_POINT_SUBMIT, frame_id, when_ns);
+		break;
+	default: assert(false);
+	}
+}
+
+static VkResult
+target_update_timings(struct comp_target *ct)
+{
+	// No display to get timings from.
+	return VK_SUCCESS;
+}
+
+static void
+target_info_gpu(struct comp_target *ct, int64_t frame_id, uint64_t gpu_start_ns, uint64_t gpu_end_ns, uint64_t when_ns)
+{
+	struct comp_target_offscreen *cto = (struct comp_target_offscreen *)ct;
+
+	u_pc_info_gpu(cto->upc, frame_id, gpu_start_ns, gpu_end_ns, when_ns);
+}
+
+static void
+target_set_title(struct comp_target *ct, const char *title)
+{
+	// No window.
+}
+
+static void
+target_destroy(struct comp_target *ct)
+{
+	struct comp_target_offscreen *cto = (struct comp_target_offscreen *)ct;
+
+	COMP_INFO(ct->c, "Offscreen target presented %" PRIu64 " frames.", cto->presented_count);
+
+	// Vulkan is not always initialized if creation failed.
+	if (ct->c->base.vk.device != VK_NULL_HANDLE) {
+		destroy_images(cto);
+		destroy_semaphores(cto);
+	}
+
+	u_pc_destroy(&cto->upc);
+
+	os_mutex_destroy(&cto->mutex);
+
+	free(cto);
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+struct comp_target *
+comp_target_offscreen_create(struct comp_compositor *c)
+{
+	struct comp_target_offscreen *cto = U_TYPED_CALLOC(struct comp_target_offscreen);
+
+	if (os_mutex_init(&cto->mutex) != 0) {
+		free(cto);
+		return NULL;
+	}
+
+	int64_t framerate = debug_get_num_option_offscreen_framerate();
+	cto->frame_interval_ns = c->settings.nominal_frame_interval_ns;
+	if (framerate > 0) {
+		cto->frame_interval_ns = U_TIME_1S_IN_NS / (uint64_t)framerate;
+	}
+
+	cto->current_frame_id = -1;
+	cto->base.name = "offscreen";
+	cto->base.c = c;
+	cto->base.init_pre_vulkan = target_init_pre_vulkan;
+	cto->base.init_post_vulkan = target_init_post_vulkan;
+	cto->base.check_ready = target_check_ready;
+	cto->base.create_images = target_create_images;
+	cto->base.has_images = target_has_images;
+	cto->base.acquire = target_acquire;
+	cto->base.present = target_present;
+	cto->base.flush = target_flush;
+	cto->base.calc_frame_pacing = target_calc_frame_pacing;
+	cto->base.mark_timing_point = target_mark_timing_point;
+	cto->base.update_timings = target_update_timings;
+	cto->base.info_gpu = target_info_gpu;
+	cto->base.set_title = target_set_title;
+	cto->base.destroy = target_destroy;
+
+	return &cto->base;
+}
+
+bool
+comp_target_offscreen_get_latest(struct comp_target_offscreen *cto,
+                                 uint32_t *out_index,
+                                 uint64_t *out_timeline_value,
+                                 uint64_t *out_desired_present_time_ns)
+{
+	os_mutex_lock(&cto->mutex);
+	bool valid = cto->latest.valid;
+	if (valid) {
+		*out_index = cto->latest.index;
+		*out_timeline_value = cto->latest.timeline_value;
+		*out_desired_present_time_ns = cto->latest.desired_present_time_ns;
+	}
+	os_mutex_unlock(&cto->mutex);
+
+	return valid;
+}
+
+
+/*
+ *
+ * Factory
+ *
+ */
+
+static bool
+detect(const struct comp_target_factory *ctf, struct comp_compositor *c)
+{
+	return false;
+}
+
+static bool
+create_target(const struct comp_target_factory *ctf, struct comp_compositor *c, struct comp_target **out_ct)
+{
+	struct comp_target *ct = comp_target_offscreen_create(c);
+	if (ct == NULL) {
+		return false;
+	}
+
+	*out_ct = ct;
+
+	return true;
+}
+
+const struct comp_target_factory comp_target_factory_offscreen = {
+    .name = "Offscreen",
+    .identifier = "offscreen",
+    // Only when selected, keeps it out of the fallback list tried before Vulkan.
+    .requires_vulkan_for_create = true,
+    .is_deferred = false,
+    .required_instance_extensions = NULL,
+    .required_instance_extension_count = 0,
+    .detect = detect,
+    .create_target = create_target,
+};
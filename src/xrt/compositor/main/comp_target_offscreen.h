@@ -0,0 +1,114 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Offscreen target that renders into exportable images.
+ * @ingroup comp_main
+ */
+
+#pragma once
+
+#include "os/os_threading.h"
+
+#include "vk/vk_image_allocator.h"
+
+#include "main/comp_target.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+struct u_pacing_compositor;
+struct comp_encoder_tap;
+
+//! Number of images in the offscreen target.
+#define COMP_TARGET_OFFSCREEN_IMAGE_COUNT (3)
+
+/*!
+ * A target with no display, runs the full renderer at a fixed rate and
+ * renders into images that can be exported to a consumer like a video
+ * encoder, or just thrown away when benchmarking.
+ *
+ * @ingroup comp_main
+ * @implements comp_target
+ */
+struct comp_target_offscreen
+{
+	//! Base target.
+	struct comp_target base;
+
+	//! Compositor frame pacing helper, always fake as there is no display.
+	struct u_pacing_compositor *upc;
+
+	//! Interval between frames.
+	uint64_t frame_interval_ns;
+
+	//! The exportable images, see @ref vk_ic_get_handles, not used with @ref tap.
+	struct vk_image_collection vkic;
+
+	//! Optional, owns the images and pushes them to a encoder as DMA-BUFs.
+	struct comp_encoder_tap *tap;
+
+	//! Index of the next image to hand out in acquire.
+	uint32_t next_index;
+
+	//! Frame id returned from the last pacing prediction.
+	int64_t current_frame_id;
+
+	//! Protects @ref latest.
+	struct os_mutex mutex;
+
+	//! The last presented image.
+	struct
+	{
+		//! Has any image been presented yet.
+		bool valid;
+
+		//! Index into comp_target::images.
+		uint32_t index;
+
+		//! Value comp_target::semaphores::render_complete reaches when rendering is done, if a timeline.
+		uint64_t timeline_value;
+
+		//! When the image was meant to be presented.
+		uint64_t desired_present_time_ns;
+	} latest;
+
+	//! Number of presented images, for throughput measurements.
+	uint64_t presented_count;
+};
+
+/*!
+ * Create a offscreen target.
+ *
+ * @public @memberof comp_target_offscreen
+ * @ingroup comp_main
+ */
+struct comp_target *
+comp_target_offscreen_create(struct comp_compositor *c);
+
+/*!
+ * Get the latest presented image, the consumer has to finish reading the
+ * image before the target has gone around all of its images and renders to
+ * it again, that is within `COMP_TARGET_OFFSCREEN_IMAGE_COUNT - 1` frames.
+ *
+ * If comp_target::semaphores::render_complete_is_timeline is true the
+ * consumer must wait for the semaphore to reach @p out_timeline_value.
+ *
+ * @public @memberof comp_target_offscreen
+ * @ingroup comp_main
+ */
+bool
+comp_target_offscreen_get_latest(struct comp_target_offscreen *cto,
+                                 uint32_t *out_index,
+                                 uint64_t *out_timeline_value,
+                                 uint64_t *out_desired_present_time_ns);
+
+extern const struct comp_target_factory comp_target_factory_offscreen;
+
+
+#ifdef __cplusplus
+}
+#endif
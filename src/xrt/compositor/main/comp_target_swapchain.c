@@ -13,6 +13,7 @@
 #include "util/u_misc.h"
 #include "util/u_pacing.h"
 #include "util/u_pretty_print.h"
+#include "util/u_time.h"
 
 #include "vk/vk_surface_info.h"
 
@@ -212,6 +213,21 @@ check_surface_present_mode(struct comp_target_swapchain *cts,
 	return false;
 }
 
+static VkPresentModeKHR
+select_surface_present_mode(struct comp_target_swapchain *cts,
+                            const struct vk_surface_info *info,
+                            VkPresentModeKHR present_mode)
+{
+	if (present_mode == VK_PRESENT_MODE_FIFO_KHR || check_surface_present_mode(cts, info, present_mode)) {
+		return present_mode;
+	}
+
+	// FIFO is required to be supported by all surfaces.
+	COMP_WARN(cts->base.c, "Falling back to VK_PRESENT_MODE_FIFO_KHR.");
+
+	return VK_PRESENT_MODE_FIFO_KHR;
+}
+
 static bool
 find_surface_format(struct comp_target_swapchain *cts, const struct vk_surface_info *info, VkSurfaceFormatKHR *format)
 {
@@ -352,6 +368,39 @@ do_update_timings_google_display_timing(struct comp_target_swapchain *cts)
 	free(timings);
 }
 
+/*!
+ * Direct mode displays flip on the first vblank after the present, unless the
+ * GPU work completes after it, then on the first vblank after the GPU is done.
+ * Turn that into the information that `VK_GOOGLE_display_timing` would give.
+ */
+static void
+do_info_from_vblank(struct comp_target_swapchain *cts, const struct comp_target_swapchain_vblank_frame *frame)
+{
+	uint64_t period_ns = cts->base.c->settings.nominal_frame_interval_ns;
+	uint64_t actual_present_time_ns = frame->vblank_ns;
+	uint64_t present_margin_ns = 0;
+
+	uint32_t index = (uint32_t)(frame->frame_id % COMP_TARGET_SWAPCHAIN_VBLANK_FRAMES);
+	if (cts->vblank.gpu[index].frame_id == frame->frame_id) {
+		uint64_t gpu_end_ns = cts->vblank.gpu[index].end_ns;
+
+		if (gpu_end_ns <= actual_present_time_ns) {
+			present_margin_ns = actual_present_time_ns - gpu_end_ns;
+		} else if (period_ns > 0) {
+			uint64_t missed = (gpu_end_ns - actual_present_time_ns) / period_ns + 1;
+			actual_present_time_ns += missed * period_ns;
+		}
+	}
+
+	u_pc_info(cts->upc,                       //
+	          frame->frame_id,                //
+	          frame->desired_present_time_ns, //
+	          actual_present_time_ns,         //
+	          actual_present_time_ns,         // earliest_present_time_ns
+	          present_margin_ns,              //
+	          os_monotonic_get_ns());         //
+}
+
 static void
 do_update_timings_vblank_thread(struct comp_target_swapchain *cts)
 {
@@ -360,15 +409,41 @@ do_update_timings_vblank_thread(struct comp_target_swapchain *cts)
 	}
 
 	uint64_t last_vblank_ns;
+	struct comp_target_swapchain_vblank_frame presented[COMP_TARGET_SWAPCHAIN_VBLANK_FRAMES];
 
 	os_thread_helper_lock(&cts->vblank.event_thread);
 	last_vblank_ns = cts->vblank.last_vblank_ns;
 	cts->vblank.last_vblank_ns = 0;
+	for (uint32_t i = 0; i < COMP_TARGET_SWAPCHAIN_VBLANK_FRAMES; i++) {
+		presented[i] = cts->vblank.presented[i];
+		cts->vblank.presented[i].frame_id = -1;
+	}
 	os_thread_helper_unlock(&cts->vblank.event_thread);
 
 	if (last_vblank_ns) {
 		u_pc_update_vblank_from_display_control(cts->upc, last_vblank_ns);
 	}
+
+	if (!cts->vblank.use_for_timing) {
+		return;
+	}
+
+	// Oldest first, the slots are indexed by frame id.
+	while (true) {
+		struct comp_target_swapchain_vblank_frame *oldest = NULL;
+		for (uint32_t i = 0; i < COMP_TARGET_SWAPCHAIN_VBLANK_FRAMES; i++) {
+			if (presented[i].frame_id >= 0 && (oldest == NULL || presented[i].frame_id < oldest->frame_id)) {
+				oldest = &presented[i];
+			}
+		}
+
+		if (oldest == NULL) {
+			break;
+		}
+
+		do_info_from_vblank(cts, oldest);
+		oldest->frame_id = -1;
+	}
 }
 
 #if defined(VK_EXT_display_surface_counter) && defined(VK_EXT_display_control)
@@ -526,6 +601,10 @@ run_vblank_event_thread(void *ptr)
 		// We should wait for a vblank event.
 		cts->vblank.should_wait = false;
 
+		// The frame that will be displayed on this vblank.
+		struct comp_target_swapchain_vblank_frame frame = cts->vblank.pending;
+		cts->vblank.pending.frame_id = -1;
+
 		// Unlock while waiting.
 		os_thread_helper_unlock(&cts->vblank.event_thread);
 
@@ -538,6 +617,11 @@ run_vblank_event_thread(void *ptr)
 		if (valid) {
 			cts->vblank.last_vblank_ns = when_ns;
 		}
+
+		if (valid && frame.frame_id >= 0) {
+			frame.vblank_ns = when_ns;
+			cts->vblank.presented[frame.frame_id % COMP_TARGET_SWAPCHAIN_VBLANK_FRAMES] = frame;
+		}
 	}
 
 	os_thread_helper_unlock(&cts->vblank.event_thread);
@@ -632,9 +716,30 @@ comp_target_swapchain_create_images(struct comp_target *ct,
 	uint64_t now_ns = os_monotonic_get_ns();
 	// Some platforms really don't like the pacing_compositor code.
 	bool use_display_timing_if_available = cts->timing_usage == COMP_TARGET_USE_DISPLAY_IF_AVAILABLE;
-	if (cts->upc == NULL && use_display_timing_if_available && vk->has_GOOGLE_display_timing) {
-		u_pc_display_timing_create(ct->c->settings.nominal_frame_interval_ns,
-		                           &U_PC_DISPLAY_TIMING_CONFIG_DEFAULT, &cts->upc);
+
+	// Direct mode displays without the google extension can use the vblank events.
+	bool use_vblank_timing = cts->upc == NULL &&                //
+	                         use_display_timing_if_available && //
+	                         !vk->has_GOOGLE_display_timing &&  //
+	                         vk->has_EXT_display_control &&     //
+	                         cts->display != VK_NULL_HANDLE &&  //
+	                         ct->c->settings.vblank_timing;
+	if (use_vblank_timing) {
+		COMP_INFO(ct->c, "Using vblank events as display timing.");
+		cts->vblank.use_for_timing = true;
+	}
+
+	if (cts->upc == NULL && use_display_timing_if_available &&
+	    (vk->has_GOOGLE_display_timing || use_vblank_timing)) {
+		struct u_pc_display_timing_config config = U_PC_DISPLAY_TIMING_CONFIG_DEFAULT;
+
+		// Selecting a latency mode asks for latency over frame safety.
+		if (ct->c->settings.latency_mode != COMP_LATENCY_MODE_DEFAULT) {
+			config.margin_ns = U_TIME_HALF_MS_IN_NS;
+			config.target_miss_ppm = 10000;
+		}
+
+		u_pc_display_timing_create(ct->c->settings.nominal_frame_interval_ns, &config, &cts->upc);
 	} else if (cts->upc == NULL) {
 		u_pc_fake_create(ct->c->settings.nominal_frame_interval_ns, now_ns, &cts->upc);
 	}
@@ -689,12 +794,7 @@ comp_target_swapchain_create_images(struct comp_target *ct,
 		}
 	}
 
-	if (!check_surface_present_mode(cts, &info, cts->present_mode)) {
-		// Free old.
-		destroy_old(cts, old_swapchain_handle);
-		vk_surface_info_destroy(&info);
-		return;
-	}
+	cts->present_mode = select_surface_present_mode(cts, &info, cts->present_mode);
 
 	// Find the correct format.
 	if (!find_surface_format(cts, &info, &cts->surface.format)) {
@@ -735,8 +835,14 @@ comp_target_swapchain_create_images(struct comp_target *ct,
 	 * When not in direct mode and display to a composited window we
 	 * probably want 3, but most compositors on Linux sets the minImageCount
 	 * to 3 anyways so we get what we want.
+	 *
+	 * With MAILBOX the acquire doesn't block, so use a third image for the
+	 * presentation engine to hold while one is queued and one rendered to.
 	 */
-	const uint32_t preferred_at_least_image_count = 2;
+	uint32_t preferred_at_least_image_count = 2;
+	if (cts->present_mode == VK_PRESENT_MODE_MAILBOX_KHR) {
+		preferred_at_least_image_count = 3;
+	}
 
 	// Get the image count.
 	uint32_t image_count = select_image_count(cts, surface_caps, preferred_at_least_image_count);
@@ -879,6 +985,10 @@ comp_target_swapchain_present(struct comp_target *ct,
 #ifdef VK_EXT_display_control
 	if (cts->vblank.has_started) {
 		os_thread_helper_lock(&cts->vblank.event_thread);
+		cts->vblank.pending = (struct comp_target_swapchain_vblank_frame){
+		    .frame_id = cts->current_frame_id,
+		    .desired_present_time_ns = desired_present_time_ns - present_slop_ns,
+		};
 		if (!cts->vblank.should_wait) {
 			cts->vblank.should_wait = true;
 			os_thread_helper_signal_locked(&cts->vblank.event_thread);
@@ -986,6 +1096,10 @@ comp_target_swapchain_info_gpu(
 
 	struct comp_target_swapchain *cts = (struct comp_target_swapchain *)ct;
 
+	uint32_t index = (uint32_t)(frame_id % COMP_TARGET_SWAPCHAIN_VBLANK_FRAMES);
+	cts->vblank.gpu[index].frame_id = frame_id;
+	cts->vblank.gpu[index].end_ns = gpu_end_ns;
+
 	u_pc_info_gpu(cts->upc, frame_id, gpu_start_ns, gpu_end_ns, when_ns);
 }
 
@@ -1045,5 +1159,10 @@ comp_target_swapchain_init_and_set_fnptrs(struct comp_target_swapchain *cts,
 	cts->base.mark_timing_point = comp_target_swapchain_mark_timing_point;
 	cts->base.update_timings = comp_target_swapchain_update_timings;
 	cts->base.info_gpu = comp_target_swapchain_info_gpu;
+	cts->vblank.pending.frame_id = -1;
+	for (uint32_t i = 0; i < COMP_TARGET_SWAPCHAIN_VBLANK_FRAMES; i++) {
+		cts->vblank.presented[i].frame_id = -1;
+		cts->vblank.gpu[i].frame_id = -1;
+	}
 	os_thread_helper_init(&cts->vblank.event_thread);
 }
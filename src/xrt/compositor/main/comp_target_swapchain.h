@@ -28,6 +28,28 @@ extern "C" {
 
 struct u_pacing_compositor;
 
+//! Number of presented frames and GPU timings kept for @ref comp_target_swapchain::vblank.
+#define COMP_TARGET_SWAPCHAIN_VBLANK_FRAMES (4)
+
+/*!
+ * A frame that has been presented on a direct mode display, tracked by the
+ * vblank thread to create display timing information when there is no
+ * `VK_GOOGLE_display_timing`.
+ *
+ * @ingroup comp_main
+ */
+struct comp_target_swapchain_vblank_frame
+{
+	//! Frame id, negative if the slot is empty.
+	int64_t frame_id;
+
+	//! Passed to present, minus the slop.
+	uint64_t desired_present_time_ns;
+
+	//! First vblank (first pixel out) after the present.
+	uint64_t vblank_ns;
+};
+
 /*!
  * Wraps and manage VkSwapchainKHR and VkSurfaceKHR, used by @ref comp code.
  *
@@ -84,6 +106,22 @@ struct comp_target_swapchain
 		//! Protected by event_thread lock.
 		uint64_t last_vblank_ns;
 
+		//! Last presented frame not yet picked up by the thread, protected by event_thread lock.
+		struct comp_target_swapchain_vblank_frame pending;
+
+		//! Frames with a vblank time not yet given to the pacer, protected by event_thread lock.
+		struct comp_target_swapchain_vblank_frame presented[COMP_TARGET_SWAPCHAIN_VBLANK_FRAMES];
+
+		//! Feed the vblank times as display timing to the pacer, main compositor thread only.
+		bool use_for_timing;
+
+		//! GPU end times indexed by frame id, main compositor thread only.
+		struct
+		{
+			int64_t frame_id;
+			uint64_t end_ns;
+		} gpu[COMP_TARGET_SWAPCHAIN_VBLANK_FRAMES];
+
 		//! Thread waiting on vblank_event_fence (first pixel out).
 		struct os_thread_helper event_thread;
 	} vblank;
@@ -113,7 +113,35 @@ extern const struct comp_target_factory comp_target_factory_vk_display;
 struct comp_target *
 comp_window_android_create(struct comp_compositor *c);
 
+struct ANativeWindow;
+struct android_custom_surface;
+
+/*!
+ * Get the window to render to on Android, either attaching our own custom
+ * surface, which is returned in @p out_custom_surface, or waiting for the
+ * one created by the client.
+ *
+ * @ingroup comp_main
+ */
+struct ANativeWindow *
+comp_window_android_get_native_window(struct comp_compositor *c, struct android_custom_surface **out_custom_surface);
+
 extern const struct comp_target_factory comp_target_factory_android;
+
+#if __ANDROID_API__ >= 29
+#define COMP_HAVE_ANDROID_SURFACE_CONTROL
+/*!
+ * Create a target that renders into AHardwareBuffers and hands them to
+ * SurfaceFlinger through a SurfaceControl, paced by the Choreographer.
+ *
+ * @ingroup comp_main
+ * @public @memberof comp_window_android_surface_control
+ */
+struct comp_target *
+comp_window_android_surface_control_create(struct comp_compositor *c);
+
+extern const struct comp_target_factory comp_target_factory_android_surface_control;
+#endif // __ANDROID_API__ >= 29
 #endif // XRT_OS_ANDROID
 
 #ifdef XRT_OS_WINDOWS
@@ -85,19 +85,47 @@ comp_window_android_update_window_title(struct comp_target *ct, const char *titl
 }
 
 static struct ANativeWindow *
-_create_android_window(struct comp_window_android *cwa)
+_create_android_window(struct comp_compositor *c, struct android_custom_surface **out_custom_surface)
 {
 	// 0 means default display
-	cwa->custom_surface =
+	*out_custom_surface =
 	    android_custom_surface_async_start(android_globals_get_vm(), android_globals_get_context(), 0);
-	if (cwa->custom_surface == NULL) {
-		COMP_ERROR(cwa->base.base.c,
+	if (*out_custom_surface == NULL) {
+		COMP_ERROR(c,
 		           "comp_window_android_create_surface: could not "
 		           "start asynchronous attachment of our custom surface");
 		return NULL;
 	}
 
-	return android_custom_surface_wait_get_surface(cwa->custom_surface, 2000);
+	return android_custom_surface_wait_get_surface(*out_custom_surface, 2000);
+}
+
+struct ANativeWindow *
+comp_window_android_get_native_window(struct comp_compositor *c, struct android_custom_surface **out_custom_surface)
+{
+	struct ANativeWindow *window = NULL;
+
+	if (android_globals_get_activity() != NULL) {
+		/* In process: Creating surface from activity */
+		window = _create_android_window(c, out_custom_surface);
+	} else if (android_custom_surface_can_draw_overlays(android_globals_get_vm(), android_globals_get_context())) {
+		/* Out of process: Create surface */
+		window = _create_android_window(c, out_custom_surface);
+	} else {
+		/* Out of process: Getting cached surface.
+		 * This loop polls for a surface created by Client.java in blockingConnect.
+		 * TODO: change java code to callback native code to notify Session lifecycle progress, instead
+		 * of polling here
+		 */
+		for (int i = 0; i < 100; i++) {
+			window = (struct ANativeWindow *)android_globals_get_window();
+			if (window)
+				break;
+			os_nanosleep(20 * U_TIME_1MS_IN_NS);
+		}
+	}
+
+	return window;
 }
 
 static VkResult
@@ -133,28 +161,7 @@ comp_window_android_init_swapchain(struct comp_target *ct, uint32_t width, uint3
 	struct comp_window_android *cwa = (struct comp_window_android *)ct;
 	VkResult ret;
 
-	struct ANativeWindow *window = NULL;
-
-	if (android_globals_get_activity() != NULL) {
-		/* In process: Creating surface from activity */
-		window = _create_android_window(cwa);
-	} else if (android_custom_surface_can_draw_overlays(android_globals_get_vm(), android_globals_get_context())) {
-		/* Out of process: Create surface */
-		window = _create_android_window(cwa);
-	} else {
-		/* Out of process: Getting cached surface.
-		 * This loop polls for a surface created by Client.java in blockingConnect.
-		 * TODO: change java code to callback native code to notify Session lifecycle progress, instead
-		 * of polling here
-		 */
-		for (int i = 0; i < 100; i++) {
-			window = (struct ANativeWindow *)android_globals_get_window();
-			if (window)
-				break;
-			os_nanosleep(20 * U_TIME_1MS_IN_NS);
-		}
-	}
-
+	struct ANativeWindow *window = comp_window_android_get_native_window(ct->c, &cwa->custom_surface);
 
 	if (window == NULL) {
 		COMP_ERROR(cwa->base.base.c, "could not get ANativeWindow");
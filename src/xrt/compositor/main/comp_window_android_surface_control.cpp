@@ -0,0 +1,1135 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Android target that hands AHardwareBuffers to a SurfaceControl.
+ *
+ * C++ only because the NDK SurfaceControl header uses references.
+ *
+ * @ingroup comp_main
+ */
+
+#include "xrt/xrt_compiler.h"
+#include "xrt/xrt_handles.h"
+
+#include "os/os_time.h"
+#include "os/os_threading.h"
+
+#include "util/u_misc.h"
+#include "util/u_pacing.h"
+#include "util/u_time.h"
+
+#include "vk/vk_cmd.h"
+#include "vk/vk_image_allocator.h"
+
+#include "android/android_custom_surface.h"
+#include "android/android_ahardwarebuffer_allocator.h"
+
+#include "main/comp_compositor.h"
+#include "main/comp_window.h"
+
+#ifdef COMP_HAVE_ANDROID_SURFACE_CONTROL
+
+#include <android/choreographer.h>
+#include <android/hardware_buffer.h>
+#include <android/looper.h>
+#include <android/native_window.h>
+#include <android/surface_control.h>
+
+#include <poll.h>
+#include <errno.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+//! Number of buffers, one on screen, one queued in SurfaceFlinger and one being rendered to.
+#define IMAGE_COUNT (3)
+
+//! Frame timelines kept from the last Choreographer callback.
+#define MAX_FRAME_TIMELINES (8)
+
+//! Presented frames not yet given to the pacer.
+#define MAX_PRESENTED_FRAMES (8)
+
+//! How long acquire waits for SurfaceFlinger to release a buffer.
+#define RELEASE_TIMEOUT_MS (100)
+
+/*!
+ * Calls `vkDestroy##TYPE` on `THING` if it is not `VK_NULL_HANDLE`, sets it to
+ * `VK_NULL_HANDLE` afterwards.
+ */
+#define D(TYPE, THING)                                                                                                 \
+	if (THING != VK_NULL_HANDLE) {                                                                                 \
+		vk->vkDestroy##TYPE(vk->device, THING, NULL);                                                          \
+		THING = VK_NULL_HANDLE;                                                                                \
+	}
+
+
+/*
+ *
+ * Private structs.
+ *
+ */
+
+/*!
+ * One of the buffers handed to SurfaceFlinger.
+ */
+struct sc_image
+{
+	//! Our reference to the buffer, the Vulkan image has its own.
+	AHardwareBuffer *buffer;
+
+	//! Given to SurfaceFlinger and not released yet, protected by the vsync thread lock.
+	bool in_use;
+
+	//! Fence to wait on before rendering to it again, -1 if none, protected by the vsync thread lock.
+	int release_fence;
+};
+
+/*!
+ * A frame that SurfaceFlinger has latched, from the transaction callback.
+ */
+struct sc_presented_frame
+{
+	int64_t frame_id;
+	uint64_t desired_present_time_ns;
+	uint64_t latch_time_ns;
+};
+
+/*!
+ * Android target that skips the Vulkan swapchain, the compositor renders into
+ * AHardwareBuffers that are given to SurfaceFlinger with a SurfaceControl
+ * transaction. The transaction carries the present time and, when available,
+ * the Choreographer frame timeline, so SurfaceFlinger can scan out the buffer
+ * directly on a hardware overlay at the right vsync instead of queueing it.
+ *
+ * @implements comp_target
+ */
+struct comp_window_android_surface_control
+{
+	struct comp_target base;
+
+	struct android_custom_surface *custom_surface;
+
+	//! Child of the window surface that the buffers are set on.
+	ASurfaceControl *surface_control;
+
+	//! Size of the window, the buffers are scaled to it.
+	int32_t window_width, window_height;
+
+	//! The geometry needs to be set with the next transaction.
+	bool geometry_dirty;
+
+	//! Compositor frame pacing helper.
+	struct u_pacing_compositor *upc;
+
+	//! The imported buffers.
+	struct vk_image_collection vkic;
+	struct sc_image images[IMAGE_COUNT];
+
+	//! Index of the next image to hand out in acquire.
+	uint32_t next_index;
+
+	//! Index of the image given with the last transaction, -1 if none.
+	int32_t displayed_index;
+
+	//! Frame id returned from the last pacing prediction.
+	int64_t current_frame_id;
+
+	struct
+	{
+		//! Runs the looper for the Choreographer, the lock protects everything below.
+		struct os_thread_helper thread;
+
+		//! Looper of the thread, to wake it up when stopping.
+		ALooper *looper;
+
+		//! Set before waking up the looper to stop the thread.
+		bool stopping;
+
+		//! Only used from the thread.
+		AChoreographer *choreographer;
+
+		//! Latest vsync from the Choreographer.
+		uint64_t last_vblank_ns;
+
+		//! A new vsync since the last update_timings.
+		bool has_new_vblank;
+
+		//! Measured between callbacks.
+		uint64_t period_ns;
+
+		//! Upcoming frame timelines, from the last callback.
+		struct
+		{
+			int64_t vsync_id;
+			uint64_t expected_present_time_ns;
+		} timelines[MAX_FRAME_TIMELINES];
+		uint32_t timeline_count;
+
+		//! Latched frames for the pacer.
+		struct sc_presented_frame presented[MAX_PRESENTED_FRAMES];
+		uint32_t presented_count;
+
+		//! Transactions whose callback has not been called yet.
+		uint32_t pending_transactions;
+	} vsync;
+};
+
+/*!
+ * Context given to the transaction callback.
+ */
+struct sc_transaction
+{
+	struct comp_window_android_surface_control *cwasc;
+	int64_t frame_id;
+	uint64_t desired_present_time_ns;
+
+	//! The image this transaction replaces, -1 if none.
+	int32_t previous_index;
+};
+
+
+/*
+ *
+ * Helper functions.
+ *
+ */
+
+static inline struct vk_bundle *
+get_vk(struct comp_window_android_surface_control *cwasc)
+{
+	return &cwasc->base.c->base.vk;
+}
+
+static enum xrt_swapchain_usage_bits
+usage_to_xrt_bits(VkImageUsageFlags image_usage)
+{
+	uint32_t bits = XRT_SWAPCHAIN_USAGE_SAMPLED;
+
+	if ((image_usage & VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT) != 0) {
+		bits |= XRT_SWAPCHAIN_USAGE_COLOR;
+	}
+	if ((image_usage & VK_IMAGE_USAGE_STORAGE_BIT) != 0) {
+		bits |= XRT_SWAPCHAIN_USAGE_UNORDERED_ACCESS;
+	}
+	if ((image_usage & VK_IMAGE_USAGE_TRANSFER_DST_BIT) != 0) {
+		bits |= XRT_SWAPCHAIN_USAGE_TRANSFER_DST;
+	}
+
+	return (enum xrt_swapchain_usage_bits)bits;
+}
+
+static void
+close_fence(int *fence_ptr)
+{
+	if (*fence_ptr >= 0) {
+		close(*fence_ptr);
+	}
+	*fence_ptr = -1;
+}
+
+/*!
+ * Presented frames are shown on the first vsync after SurfaceFlinger latched
+ * them, the Choreographer vsync is offset from the hardware one but has the
+ * same period.
+ */
+static uint64_t
+latch_to_present_time(uint64_t latch_time_ns, uint64_t vblank_ns, uint64_t period_ns)
+{
+	if (period_ns == 0 || vblank_ns == 0) {
+		return latch_time_ns;
+	}
+
+	if (latch_time_ns <= vblank_ns) {
+		return vblank_ns - ((vblank_ns - latch_time_ns) / period_ns) * period_ns;
+	}
+
+	uint64_t periods = (latch_time_ns - vblank_ns + period_ns - 1) / period_ns;
+
+	return vblank_ns + periods * period_ns;
+}
+
+
+/*
+ *
+ * Choreographer thread.
+ *
+ */
+
+static void
+post_vsync_callback(struct comp_window_android_surface_control *cwasc);
+
+static void
+record_vblank_locked(struct comp_window_android_surface_control *cwasc, uint64_t frame_time_ns)
+{
+	uint64_t last_ns = cwasc->vsync.last_vblank_ns;
+	if (last_ns != 0 && frame_time_ns > last_ns && frame_time_ns - last_ns < U_TIME_1S_IN_NS / 10) {
+		cwasc->vsync.period_ns = frame_time_ns - last_ns;
+	}
+
+	cwasc->vsync.last_vblank_ns = frame_time_ns;
+	cwasc->vsync.has_new_vblank = true;
+}
+
+#if __ANDROID_API__ >= 33
+static void
+on_vsync(const AChoreographerFrameCallbackData *data, void *ptr)
+{
+	struct comp_window_android_surface_control *cwasc = (struct comp_window_android_surface_control *)ptr;
+
+	size_t count = AChoreographerFrameCallbackData_getFrameTimelinesLength(data);
+	if (count > MAX_FRAME_TIMELINES) {
+		count = MAX_FRAME_TIMELINES;
+	}
+
+	os_thread_helper_lock(&cwasc->vsync.thread);
+
+	record_vblank_locked(cwasc, (uint64_t)AChoreographerFrameCallbackData_getFrameTimeNanos(data));
+
+	for (size_t i = 0; i < count; i++) {
+		cwasc->vsync.timelines[i].vsync_id = AChoreographerFrameCallbackData_getFrameTimelineVsyncId(data, i);
+		cwasc->vsync.timelines[i].expected_present_time_ns =
+		    (uint64_t)AChoreographerFrameCallbackData_getFrameTimelineExpectedPresentationTimeNanos(data, i);
+	}
+	cwasc->vsync.timeline_count = (uint32_t)count;
+
+	os_thread_helper_unlock(&cwasc->vsync.thread);
+
+	post_vsync_callback(cwasc);
+}
+#else
+static void
+on_frame(int64_t frame_time_ns, void *ptr)
+{
+	struct comp_window_android_surface_control *cwasc = (struct comp_window_android_surface_control *)ptr;
+
+	os_thread_helper_lock(&cwasc->vsync.thread);
+	record_vblank_locked(cwasc, (uint64_t)frame_time_ns);
+	os_thread_helper_unlock(&cwasc->vsync.thread);
+
+	post_vsync_callback(cwasc);
+}
+#endif
+
+static void
+post_vsync_callback(struct comp_window_android_surface_control *cwasc)
+{
+	os_thread_helper_lock(&cwasc->vsync.thread);
+	bool stopping = cwasc->vsync.stopping;
+	os_thread_helper_unlock(&cwasc->vsync.thread);
+
+	if (stopping) {
+		return;
+	}
+
+#if __ANDROID_API__ >= 33
+	AChoreographer_postVsyncCallback(cwasc->vsync.choreographer, on_vsync, cwasc);
+#else
+	AChoreographer_postFrameCallback64(cwasc->vsync.choreographer, on_frame, cwasc);
+#endif
+}
+
+static void *
+run_vsync_thread(void *ptr)
+{
+	struct comp_window_android_surface_control *cwasc = (struct comp_window_android_surface_control *)ptr;
+
+	os_thread_helper_name(&cwasc->vsync.thread, "Choreographer");
+
+	// The Choreographer delivers its callbacks on the looper of the thread it was got on.
+	ALooper *looper = ALooper_prepare(0);
+	ALooper_acquire(looper);
+
+	cwasc->vsync.choreographer = AChoreographer_getInstance();
+
+	os_thread_helper_lock(&cwasc->vsync.thread);
+	cwasc->vsync.looper = looper;
+	os_thread_helper_unlock(&cwasc->vsync.thread);
+
+	post_vsync_callback(cwasc);
+
+	os_thread_helper_lock(&cwasc->vsync.thread);
+	while (!cwasc->vsync.stopping) {
+		os_thread_helper_unlock(&cwasc->vsync.thread);
+		ALooper_pollOnce(RELEASE_TIMEOUT_MS, NULL, NULL, NULL);
+		os_thread_helper_lock(&cwasc->vsync.thread);
+	}
+	cwasc->vsync.looper = NULL;
+	os_thread_helper_unlock(&cwasc->vsync.thread);
+
+	ALooper_release(looper);
+
+	return NULL;
+}
+
+static void
+stop_vsync_thread(struct comp_window_android_surface_control *cwasc)
+{
+	os_thread_helper_lock(&cwasc->vsync.thread);
+	cwasc->vsync.stopping = true;
+	if (cwasc->vsync.looper != NULL) {
+		ALooper_wake(cwasc->vsync.looper);
+	}
+	os_thread_helper_unlock(&cwasc->vsync.thread);
+
+	os_thread_helper_stop_and_wait(&cwasc->vsync.thread);
+}
+
+
+/*
+ *
+ * Transactions.
+ *
+ */
+
+static void
+on_transaction_complete(void *ptr, ASurfaceTransactionStats *stats)
+{
+	struct sc_transaction *sct = (struct sc_transaction *)ptr;
+	struct comp_window_android_surface_control *cwasc = sct->cwasc;
+
+	int release_fence = -1;
+	if (sct->previous_index >= 0) {
+		release_fence = ASurfaceTransactionStats_getPreviousReleaseFenceFd(stats, cwasc->surface_control);
+	}
+
+	int64_t latch_time_ns = ASurfaceTransactionStats_getLatchTime(stats);
+
+	os_thread_helper_lock(&cwasc->vsync.thread);
+
+	if (sct->previous_index >= 0) {
+		struct sc_image *image = &cwasc->images[sct->previous_index];
+		close_fence(&image->release_fence);
+		image->release_fence = release_fence;
+		image->in_use = false;
+	}
+
+	if (latch_time_ns > 0) {
+		// Drop the oldest if the compositor thread hasn't picked them up.
+		if (cwasc->vsync.presented_count >= MAX_PRESENTED_FRAMES) {
+			memmove(&cwasc->vsync.presented[0], &cwasc->vsync.presented[1],
+			        sizeof(cwasc->vsync.presented[0]) * (MAX_PRESENTED_FRAMES - 1));
+			cwasc->vsync.presented_count--;
+		}
+
+		struct sc_presented_frame *frame = &cwasc->vsync.presented[cwasc->vsync.presented_count++];
+		frame->frame_id = sct->frame_id;
+		frame->desired_present_time_ns = sct->desired_present_time_ns;
+		frame->latch_time_ns = (uint64_t)latch_time_ns;
+	}
+
+	cwasc->vsync.pending_transactions--;
+
+	os_thread_helper_unlock(&cwasc->vsync.thread);
+
+	free(sct);
+}
+
+/*!
+ * Wait for all transaction callbacks, they reference the target.
+ */
+static void
+wait_for_transactions(struct comp_window_android_surface_control *cwasc)
+{
+	for (uint32_t i = 0; i < 1000; i++) {
+		os_thread_helper_lock(&cwasc->vsync.thread);
+		uint32_t pending = cwasc->vsync.pending_transactions;
+		os_thread_helper_unlock(&cwasc->vsync.thread);
+
+		if (pending == 0) {
+			return;
+		}
+
+		os_nanosleep(U_TIME_1MS_IN_NS);
+	}
+
+	COMP_WARN(cwasc->base.c, "Timed out waiting for SurfaceFlinger transactions.");
+}
+
+static void
+hide_surface(struct comp_window_android_surface_control *cwasc)
+{
+	if (cwasc->surface_control == NULL) {
+		return;
+	}
+
+	ASurfaceTransaction *transaction = ASurfaceTransaction_create();
+	ASurfaceTransaction_setVisibility(transaction, cwasc->surface_control, ASURFACE_TRANSACTION_VISIBILITY_HIDE);
+	ASurfaceTransaction_apply(transaction);
+	ASurfaceTransaction_delete(transaction);
+}
+
+
+/*
+ *
+ * Vulkan helpers.
+ *
+ */
+
+static void
+destroy_images(struct comp_window_android_surface_control *cwasc)
+{
+	struct vk_bundle *vk = get_vk(cwasc);
+
+	// The buffers might still be on screen.
+	hide_surface(cwasc);
+	wait_for_transactions(cwasc);
+
+	if (cwasc->base.images != NULL) {
+		for (uint32_t i = 0; i < cwasc->base.image_count; i++) {
+			D(ImageView, cwasc->base.images[i].view);
+		}
+
+		free(cwasc->base.images);
+		cwasc->base.images = NULL;
+	}
+
+	vk_ic_destroy(vk, &cwasc->vkic);
+	U_ZERO(&cwasc->vkic);
+
+	os_thread_helper_lock(&cwasc->vsync.thread);
+	for (uint32_t i = 0; i < IMAGE_COUNT; i++) {
+		struct sc_image *image = &cwasc->images[i];
+		if (image->buffer != NULL) {
+			AHardwareBuffer_release(image->buffer);
+			image->buffer = NULL;
+		}
+		close_fence(&image->release_fence);
+		image->in_use = false;
+	}
+	os_thread_helper_unlock(&cwasc->vsync.thread);
+
+	cwasc->base.image_count = 0;
+	cwasc->displayed_index = -1;
+}
+
+static void
+destroy_semaphores(struct comp_window_android_surface_control *cwasc)
+{
+	struct vk_bundle *vk = get_vk(cwasc);
+
+	D(Semaphore, cwasc->base.semaphores.present_complete);
+	D(Semaphore, cwasc->base.semaphores.render_complete);
+	cwasc->base.semaphores.render_complete_is_timeline = false;
+}
+
+static VkResult
+create_semaphores(struct comp_window_android_surface_control *cwasc)
+{
+	struct vk_bundle *vk = get_vk(cwasc);
+	const void *next = NULL;
+	VkResult ret;
+
+	destroy_semaphores(cwasc);
+
+#ifdef VK_KHR_timeline_semaphore
+	// With a timeline the semaphore doesn't need to be waited on before the next frame signals it.
+	VkSemaphoreTypeCreateInfo type_info = {
+	    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+	    .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+	    .initialValue = 0,
+	};
+
+	if (vk->features.timeline_semaphore) {
+		next = &type_info;
+	}
+#endif
+
+	VkSemaphoreCreateInfo info = {
+	    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+	    .pNext = next,
+	};
+
+	ret = vk->vkCreateSemaphore(vk->device, &info, NULL, &cwasc->base.semaphores.render_complete);
+	if (ret != VK_SUCCESS) {
+		COMP_ERROR(cwasc->base.c, "vkCreateSemaphore: %s", vk_result_string(ret));
+		return ret;
+	}
+
+	cwasc->base.semaphores.render_complete_is_timeline = next != NULL;
+
+	/*
+	 * The release fences are imported into this so the GPU waits for
+	 * them, otherwise acquire waits for them on the CPU.
+	 */
+	if (!vk->has_KHR_external_semaphore_fd || !vk->external.binary_semaphore_sync_fd) {
+		return VK_SUCCESS;
+	}
+
+	VkSemaphoreCreateInfo present_info = {
+	    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+	};
+
+	ret = vk->vkCreateSemaphore(vk->device, &present_info, NULL, &cwasc->base.semaphores.present_complete);
+	if (ret != VK_SUCCESS) {
+		COMP_ERROR(cwasc->base.c, "vkCreateSemaphore: %s", vk_result_string(ret));
+		return ret;
+	}
+
+	return VK_SUCCESS;
+}
+
+/*!
+ * A binary semaphore must be waited on before it can be signaled again, with
+ * no presentation engine to do that we wait on it with an empty submit.
+ */
+static VkResult
+consume_binary_semaphore(struct comp_window_android_surface_control *cwasc, VkQueue queue)
+{
+	struct vk_bundle *vk = get_vk(cwasc);
+
+	VkPipelineStageFlags stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+	VkSubmitInfo submit_info = {
+	    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+	    .waitSemaphoreCount = 1,
+	    .pWaitSemaphores = &cwasc->base.semaphores.render_complete,
+	    .pWaitDstStageMask = &stage,
+	};
+
+	assert(queue == vk->queue);
+
+	// Takes the queue lock.
+	VkResult ret = vk_cmd_submit_locked(vk, 1, &submit_info, VK_NULL_HANDLE);
+	if (ret != VK_SUCCESS) {
+		COMP_ERROR(cwasc->base.c, "vk_cmd_submit_locked: %s", vk_result_string(ret));
+	}
+
+	return ret;
+}
+
+/*!
+ * Makes the next frame wait for @p release_fence, takes ownership of it.
+ */
+static VkResult
+wait_for_release_fence(struct comp_window_android_surface_control *cwasc, int release_fence)
+{
+	struct vk_bundle *vk = get_vk(cwasc);
+
+	if (cwasc->base.semaphores.present_complete == VK_NULL_HANDLE) {
+		if (release_fence >= 0) {
+			struct pollfd fds = {.fd = release_fence, .events = POLLIN};
+			if (poll(&fds, 1, RELEASE_TIMEOUT_MS) <= 0) {
+				COMP_WARN(cwasc->base.c, "Release fence not signaled in time: %s", strerror(errno));
+			}
+		}
+
+		close_fence(&release_fence);
+		return VK_SUCCESS;
+	}
+
+	// The renderer waits on the semaphore every frame, -1 imports it as already signaled.
+	VkImportSemaphoreFdInfoKHR import_info = {
+	    .sType = VK_STRUCTURE_TYPE_IMPORT_SEMAPHORE_FD_INFO_KHR,
+	    .semaphore = cwasc->base.semaphores.present_complete,
+	    .flags = VK_SEMAPHORE_IMPORT_TEMPORARY_BIT,
+	    .handleType = VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_SYNC_FD_BIT,
+	    .fd = release_fence,
+	};
+
+	VkResult ret = vk->vkImportSemaphoreFdKHR(vk->device, &import_info);
+	if (ret != VK_SUCCESS) {
+		COMP_ERROR(cwasc->base.c, "vkImportSemaphoreFdKHR: %s", vk_result_string(ret));
+		close_fence(&release_fence);
+	}
+
+	return ret;
+}
+
+
+/*
+ *
+ * Member functions.
+ *
+ */
+
+static bool
+target_init_pre_vulkan(struct comp_target *ct)
+{
+	return true;
+}
+
+static bool
+target_init_post_vulkan(struct comp_target *ct, uint32_t preferred_width, uint32_t preferred_height)
+{
+	struct comp_window_android_surface_control *cwasc = (struct comp_window_android_surface_control *)ct;
+
+	struct ANativeWindow *window = comp_window_android_get_native_window(ct->c, &cwasc->custom_surface);
+	if (window == NULL) {
+		COMP_ERROR(ct->c, "could not get ANativeWindow");
+		return false;
+	}
+
+	cwasc->window_width = ANativeWindow_getWidth(window);
+	cwasc->window_height = ANativeWindow_getHeight(window);
+
+	cwasc->surface_control = ASurfaceControl_createFromWindow(window, "Monado");
+	if (cwasc->surface_control == NULL) {
+		COMP_ERROR(ct->c, "ASurfaceControl_createFromWindow failed");
+		return false;
+	}
+
+	int ret = os_thread_helper_start(&cwasc->vsync.thread, run_vsync_thread, cwasc);
+	if (ret != 0) {
+		COMP_ERROR(ct->c, "Failed to start Choreographer thread: %d", ret);
+		return false;
+	}
+
+	struct u_pc_display_timing_config config = U_PC_DISPLAY_TIMING_CONFIG_DEFAULT;
+
+	// Selecting a latency mode asks for latency over frame safety.
+	if (ct->c->settings.latency_mode != COMP_LATENCY_MODE_DEFAULT) {
+		config.margin_ns = U_TIME_HALF_MS_IN_NS;
+		config.target_miss_ppm = 10000;
+	}
+
+	u_pc_display_timing_create(ct->c->settings.nominal_frame_interval_ns, &config, &cwasc->upc);
+
+	return create_semaphores(cwasc) == VK_SUCCESS;
+}
+
+static bool
+target_check_ready(struct comp_target *ct)
+{
+	struct comp_window_android_surface_control *cwasc = (struct comp_window_android_surface_control *)ct;
+	return cwasc->surface_control != NULL && cwasc->base.semaphores.render_complete != VK_NULL_HANDLE;
+}
+
+static void
+target_create_images(struct comp_target *ct,
+                     uint32_t preferred_width,
+                     uint32_t preferred_height,
+                     VkFormat color_format,
+                     VkColorSpaceKHR color_space,
+                     VkImageUsageFlags image_usage,
+                     VkPresentModeKHR present_mode)
+{
+	struct comp_window_android_surface_control *cwasc = (struct comp_window_android_surface_control *)ct;
+	struct vk_bundle *vk = get_vk(cwasc);
+	struct xrt_image_native natives[IMAGE_COUNT] = {};
+	VkResult ret;
+
+	// The renderer has waited for the queue to go idle.
+	destroy_images(cwasc);
+
+	struct xrt_swapchain_create_info info = {
+	    .create = (enum xrt_swapchain_create_flags)0,
+	    .bits = usage_to_xrt_bits(image_usage),
+	    .format = color_format,
+	    .sample_count = 1,
+	    .width = preferred_width,
+	    .height = preferred_height,
+	    .face_count = 1,
+	    .array_size = 1,
+	    .mip_count = 1,
+	};
+
+	for (uint32_t i = 0; i < IMAGE_COUNT; i++) {
+		xrt_result_t xret = ahardwarebuffer_image_allocate_scanout(&info, &cwasc->images[i].buffer);
+		if (xret != XRT_SUCCESS) {
+			COMP_ERROR(ct->c, "Failed to allocate scanout buffer %u", i);
+			destroy_images(cwasc);
+			return;
+		}
+
+		natives[i].handle = cwasc->images[i].buffer;
+		cwasc->images[i].release_fence = -1;
+	}
+
+	// Takes its own references to the buffers.
+	ret = vk_ic_from_natives(vk, &info, natives, IMAGE_COUNT, &cwasc->vkic);
+	if (ret != VK_SUCCESS) {
+		COMP_ERROR(ct->c, "vk_ic_from_natives: %s", vk_result_string(ret));
+		destroy_images(cwasc);
+		return;
+	}
+
+	VkImageSubresourceRange subresource_range = {
+	    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	    .baseMipLevel = 0,
+	    .levelCount = 1,
+	    .baseArrayLayer = 0,
+	    .layerCount = 1,
+	};
+
+	cwasc->base.images = U_TYPED_ARRAY_CALLOC(struct comp_target_image, IMAGE_COUNT);
+	cwasc->base.image_count = IMAGE_COUNT;
+
+	for (uint32_t i = 0; i < cwasc->base.image_count; i++) {
+		cwasc->base.images[i].handle = cwasc->vkic.images[i].handle;
+		vk_create_view(                   //
+		    vk,                           // vk_bundle
+		    cwasc->base.images[i].handle, // image
+		    VK_IMAGE_VIEW_TYPE_2D,        // type
+		    color_format,                 // format
+		    subresource_range,            // subresource_range
+		    &cwasc->base.images[i].view); // out_view
+	}
+
+	cwasc->base.width = preferred_width;
+	cwasc->base.height = preferred_height;
+	cwasc->base.format = color_format;
+	cwasc->base.surface_transform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+	cwasc->next_index = 0;
+	cwasc->displayed_index = -1;
+	cwasc->geometry_dirty = true;
+
+	COMP_INFO(ct->c, "Created %u scanout buffers %ux%u.", IMAGE_COUNT, preferred_width, preferred_height);
+}
+
+static bool
+target_has_images(struct comp_target *ct)
+{
+	struct comp_window_android_surface_control *cwasc = (struct comp_window_android_surface_control *)ct;
+	return cwasc->base.image_count > 0;
+}
+
+static VkResult
+target_acquire(struct comp_target *ct, uint32_t *out_index)
+{
+	struct comp_window_android_surface_control *cwasc = (struct comp_window_android_surface_control *)ct;
+
+	if (!target_has_images(ct)) {
+		return VK_ERROR_INITIALIZATION_FAILED;
+	}
+
+	uint32_t index = cwasc->next_index;
+	struct sc_image *image = &cwasc->images[index];
+
+	/*
+	 * The release comes with the callback of the transaction that
+	 * replaced the buffer, normally long before we go around to it.
+	 */
+	os_thread_helper_lock(&cwasc->vsync.thread);
+	for (uint32_t i = 0; image->in_use && i < RELEASE_TIMEOUT_MS; i++) {
+		os_thread_helper_unlock(&cwasc->vsync.thread);
+		os_nanosleep(U_TIME_1MS_IN_NS);
+		os_thread_helper_lock(&cwasc->vsync.thread);
+	}
+
+	bool timed_out = image->in_use;
+	int release_fence = image->release_fence;
+	image->release_fence = -1;
+	image->in_use = false;
+	os_thread_helper_unlock(&cwasc->vsync.thread);
+
+	if (timed_out) {
+		COMP_WARN(ct->c, "SurfaceFlinger did not release buffer %u in time, rendering to it anyway.", index);
+	}
+
+	VkResult ret = wait_for_release_fence(cwasc, release_fence);
+	if (ret != VK_SUCCESS) {
+		return ret;
+	}
+
+	*out_index = index;
+	cwasc->next_index = (index + 1) % cwasc->base.image_count;
+
+	return VK_SUCCESS;
+}
+
+static VkResult
+target_present(struct comp_target *ct,
+               VkQueue queue,
+               uint32_t index,
+               uint64_t timeline_semaphore_value,
+               uint64_t desired_present_time_ns,
+               uint64_t present_slop_ns)
+{
+	struct comp_window_android_surface_control *cwasc = (struct comp_window_android_surface_control *)ct;
+	struct vk_bundle *vk = get_vk(cwasc);
+	VkResult ret;
+
+	if (!cwasc->base.semaphores.render_complete_is_timeline) {
+		ret = consume_binary_semaphore(cwasc, queue);
+		if (ret != VK_SUCCESS) {
+			return ret;
+		}
+	}
+
+	// Signaled when the rendering is done, SurfaceFlinger waits on it instead of us.
+	xrt_graphics_sync_handle_t acquire_fence = XRT_GRAPHICS_SYNC_HANDLE_INVALID;
+	ret = vk_create_and_submit_fence_native(vk, &acquire_fence);
+	if (ret != VK_SUCCESS) {
+		COMP_ERROR(ct->c, "vk_create_and_submit_fence_native: %s", vk_result_string(ret));
+		return ret;
+	}
+
+	struct sc_transaction *sct = U_TYPED_CALLOC(struct sc_transaction);
+	sct->cwasc = cwasc;
+	sct->frame_id = cwasc->current_frame_id;
+	sct->desired_present_time_ns = desired_present_time_ns;
+	sct->previous_index = cwasc->displayed_index;
+
+	ASurfaceTransaction *transaction = ASurfaceTransaction_create();
+
+	if (cwasc->geometry_dirty) {
+		ARect source = {0, 0, (int32_t)cwasc->base.width, (int32_t)cwasc->base.height};
+		ARect destination = {0, 0, cwasc->window_width, cwasc->window_height};
+		ASurfaceTransaction_setGeometry(transaction, cwasc->surface_control, source, destination, 0);
+		ASurfaceTransaction_setVisibility(transaction, cwasc->surface_control,
+		                                  ASURFACE_TRANSACTION_VISIBILITY_SHOW);
+		cwasc->geometry_dirty = false;
+	}
+
+	// Takes ownership of the fence.
+	ASurfaceTransaction_setBuffer(transaction, cwasc->surface_control, cwasc->images[index].buffer, acquire_fence);
+	ASurfaceTransaction_setDesiredPresentTime(transaction, (int64_t)desired_present_time_ns);
+	ASurfaceTransaction_setOnComplete(transaction, sct, on_transaction_complete);
+
+	os_thread_helper_lock(&cwasc->vsync.thread);
+
+#if __ANDROID_API__ >= 33
+	// The first timeline that presents at or after the time we asked for.
+	for (uint32_t i = 0; i < cwasc->vsync.timeline_count; i++) {
+		if (cwasc->vsync.timelines[i].expected_present_time_ns + present_slop_ns >= desired_present_time_ns) {
+			ASurfaceTransaction_setFrameTimeline(transaction, cwasc->vsync.timelines[i].vsync_id);
+			break;
+		}
+	}
+#endif
+
+	cwasc->images[index].in_use = true;
+	cwasc->vsync.pending_transactions++;
+
+	os_thread_helper_unlock(&cwasc->vsync.thread);
+
+	ASurfaceTransaction_apply(transaction);
+	ASurfaceTransaction_delete(transaction);
+
+	cwasc->displayed_index = (int32_t)index;
+
+	return VK_SUCCESS;
+}
+
+static void
+target_flush(struct comp_target *ct)
+{
+	// Nothing to do.
+}
+
+static void
+target_calc_frame_pacing(struct comp_target *ct,
+                         int64_t *out_frame_id,
+                         uint64_t *out_wake_up_time_ns,
+                         uint64_t *out_desired_present_time_ns,
+                         uint64_t *out_present_slop_ns,
+                         uint64_t *out_predicted_display_time_ns)
+{
+	struct comp_window_android_surface_control *cwasc = (struct comp_window_android_surface_control *)ct;
+
+	int64_t frame_id = -1;
+	uint64_t wake_up_time_ns = 0;
+	uint64_t desired_present_time_ns = 0;
+	uint64_t present_slop_ns = 0;
+	uint64_t predicted_display_time_ns = 0;
+	uint64_t predicted_display_period_ns = 0;
+	uint64_t min_display_period_ns = 0;
+	uint64_t now_ns = os_monotonic_get_ns();
+
+	u_pc_predict(cwasc->upc,                   //
+	             now_ns,                       //
+	             &frame_id,                    //
+	             &wake_up_time_ns,             //
+	             &desired_present_time_ns,     //
+	             &present_slop_ns,             //
+	             &predicted_display_time_ns,   //
+	             &predicted_display_period_ns, //
+	             &min_display_period_ns);      //
+
+	cwasc->current_frame_id = frame_id;
+
+	*out_frame_id = frame_id;
+	*out_wake_up_time_ns = wake_up_time_ns;
+	*out_desired_present_time_ns = desired_present_time_ns;
+	*out_predicted_display_time_ns = predicted_display_time_ns;
+	*out_present_slop_ns = present_slop_ns;
+}
+
+static void
+target_mark_timing_point(struct comp_target *ct,
+                         enum comp_target_timing_point point,
+                         int64_t frame_id,
+                         uint64_t when_ns)
+{
+	struct comp_window_android_surface_control *cwasc = (struct comp_window_android_surface_control *)ct;
+	assert(frame_id == cwasc->current_frame_id);
+
+	switch (point) {
+	case COMP_TARGET_TIMING_POINT_WAKE_UP:
+		u_pc_mark_point(cwasc->upc, U_TIMING_POINT_WAKE_UP, frame_id, when_ns);
+		break;
+	case COMP_TARGET_TIMING_POINT_BEGIN:
+		u_pc_mark_point(cwasc->upc, U_TIMING_POINT_BEGIN, frame_id, when_ns);
+		break;
+	case COMP_TARGET_TIMING_POINT_SUBMIT:
+		u_pc_mark_point(cwasc->upc, U_TIMING_POINT_SUBMIT, frame_id, when_ns);
+		break;
+	default: assert(false);
+	}
+}
+
+static VkResult
+target_update_timings(struct comp_target *ct)
+{
+	struct comp_window_android_surface_control *cwasc = (struct comp_window_android_surface_control *)ct;
+	struct sc_presented_frame presented[MAX_PRESENTED_FRAMES];
+
+	os_thread_helper_lock(&cwasc->vsync.thread);
+	bool has_new_vblank = cwasc->vsync.has_new_vblank;
+	uint64_t last_vblank_ns = cwasc->vsync.last_vblank_ns;
+	uint64_t period_ns = cwasc->vsync.period_ns;
+	uint32_t presented_count = cwasc->vsync.presented_count;
+	for (uint32_t i = 0; i < presented_count; i++) {
+		presented[i] = cwasc->vsync.presented[i];
+	}
+	cwasc->vsync.has_new_vblank = false;
+	cwasc->vsync.presented_count = 0;
+	os_thread_helper_unlock(&cwasc->vsync.thread);
+
+	if (has_new_vblank) {
+		u_pc_update_vblank_from_display_control(cwasc->upc, last_vblank_ns);
+	}
+
+	uint64_t now_ns = os_monotonic_get_ns();
+	for (uint32_t i = 0; i < presented_count; i++) {
+		uint64_t actual_present_time_ns = latch_to_present_time( //
+		    presented[i].latch_time_ns,                          //
+		    last_vblank_ns,                                      //
+		    period_ns);                                          //
+
+		u_pc_info(cwasc->upc,                           //
+		          presented[i].frame_id,                //
+		          presented[i].desired_present_time_ns, //
+		          actual_present_time_ns,               //
+		          actual_present_time_ns,               // earliest_present_time_ns
+		          0,                                    // present_margin_ns
+		          now_ns);                              //
+	}
+
+	return VK_SUCCESS;
+}
+
+static void
+target_info_gpu(struct comp_target *ct, int64_t frame_id, uint64_t gpu_start_ns, uint64_t gpu_end_ns, uint64_t when_ns)
+{
+	struct comp_window_android_surface_control *cwasc = (struct comp_window_android_surface_control *)ct;
+
+	u_pc_info_gpu(cwasc->upc, frame_id, gpu_start_ns, gpu_end_ns, when_ns);
+}
+
+static void
+target_set_title(struct comp_target *ct, const char *title)
+{
+	// No window title.
+}
+
+static void
+target_destroy(struct comp_target *ct)
+{
+	struct comp_window_android_surface_control *cwasc = (struct comp_window_android_surface_control *)ct;
+
+	// Vulkan is not always initialized if creation failed.
+	if (ct->c->base.vk.device != VK_NULL_HANDLE) {
+		destroy_images(cwasc);
+		destroy_semaphores(cwasc);
+	}
+
+	stop_vsync_thread(cwasc);
+	os_thread_helper_destroy(&cwasc->vsync.thread);
+
+	if (cwasc->surface_control != NULL) {
+		ASurfaceControl_release(cwasc->surface_control);
+		cwasc->surface_control = NULL;
+	}
+
+	android_custom_surface_destroy(&cwasc->custom_surface);
+
+	u_pc_destroy(&cwasc->upc);
+
+	free(cwasc);
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+struct comp_target *
+comp_window_android_surface_control_create(struct comp_compositor *c)
+{
+	struct comp_window_android_surface_control *cwasc = U_TYPED_CALLOC(struct comp_window_android_surface_control);
+
+	if (os_thread_helper_init(&cwasc->vsync.thread) != 0) {
+		free(cwasc);
+		return NULL;
+	}
+
+	for (uint32_t i = 0; i < IMAGE_COUNT; i++) {
+		cwasc->images[i].release_fence = -1;
+	}
+
+	cwasc->displayed_index = -1;
+	cwasc->current_frame_id = -1;
+	cwasc->base.name = "Android SurfaceControl";
+	cwasc->base.c = c;
+	cwasc->base.init_pre_vulkan = target_init_pre_vulkan;
+	cwasc->base.init_post_vulkan = target_init_post_vulkan;
+	cwasc->base.check_ready = target_check_ready;
+	cwasc->base.create_images = target_create_images;
+	cwasc->base.has_images = target_has_images;
+	cwasc->base.acquire = target_acquire;
+	cwasc->base.present = target_present;
+	cwasc->base.flush = target_flush;
+	cwasc->base.calc_frame_pacing = target_calc_frame_pacing;
+	cwasc->base.mark_timing_point = target_mark_timing_point;
+	cwasc->base.update_timings = target_update_timings;
+	cwasc->base.info_gpu = target_info_gpu;
+	cwasc->base.set_title = target_set_title;
+	cwasc->base.destroy = target_destroy;
+
+	return &cwasc->base;
+}
+
+
+/*
+ *
+ * Factory
+ *
+ */
+
+static bool
+detect(const struct comp_target_factory *ctf, struct comp_compositor *c)
+{
+	return false;
+}
+
+static bool
+create_target(const struct comp_target_factory *ctf, struct comp_compositor *c, struct comp_target **out_ct)
+{
+	struct comp_target *ct = comp_window_android_surface_control_create(c);
+	if (ct == NULL) {
+		return false;
+	}
+
+	*out_ct = ct;
+
+	return true;
+}
+
+const struct comp_target_factory comp_target_factory_android_surface_control = {
+    .name = "Android SurfaceControl",
+    .identifier = "android_surface_control",
+    .requires_vulkan_for_create = false,
+    .is_deferred = true,
+    .required_instance_extensions = NULL,
+    .required_instance_extension_count = 0,
+    .detect = detect,
+    .create_target = create_target,
+};
+
+#endif // COMP_HAVE_ANDROID_SURFACE_CONTROL
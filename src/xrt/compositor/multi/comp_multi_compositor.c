@@ -19,6 +19,8 @@
 #include "util/u_trace_marker.h"
 #include "util/u_distortion_mesh.h"
 
+#include "math/m_api.h"
+
 #include "multi/comp_multi_private.h"
 
 #include <math.h>
@@ -142,6 +144,59 @@ drain_events(struct multi_compositor *mc)
 }
 
 
+/*
+ *
+ * Render scale functions.
+ *
+ */
+
+//! Share of the frame budget the GPU work of the app and the compositor should fit in.
+#define RENDER_SCALE_GPU_TARGET (0.8)
+
+//! Headroom needed before scaling back up, so the scale doesn't flip flop.
+#define RENDER_SCALE_UP_THRESHOLD (1.2)
+
+//! Largest change per frame, goes down faster than up so overloads are short.
+#define RENDER_SCALE_STEP_DOWN (0.95f)
+#define RENDER_SCALE_STEP_UP (1.01f)
+
+#define RENDER_SCALE_MIN (0.5f)
+#define RENDER_SCALE_MAX (1.0f)
+
+/*!
+ * Update the recommended render scale from the GPU headroom left in the frame
+ * budget, need to have the list_and_timing_lock held.
+ *
+ * The GPU time of the app goes with the number of pixels it renders, so with
+ * the square of the scale, and is assumed to have been measured at the scale
+ * recommended so far.
+ */
+static void
+update_render_scale_locked(struct multi_compositor *mc)
+{
+	struct u_pacing_app_stats stats = {0};
+	u_pa_get_stats(mc->upa, &stats);
+
+	uint64_t budget_ns = mc->msc->last_timings.predicted_display_period_ns * mc->state.rate_divisor;
+	if (budget_ns == 0 || stats.gpu_time_ns == 0) {
+		return;
+	}
+
+	double available_ns = (double)budget_ns * RENDER_SCALE_GPU_TARGET;
+	available_ns -= (double)mc->msc->last_timings.compositor_gpu_time_ns;
+	double ratio = available_ns > 0.0 ? available_ns / (double)stats.gpu_time_ns : 0.0;
+
+	float scale = mc->state.render_scale;
+	if (ratio < 1.0) {
+		scale *= fmaxf(sqrtf((float)ratio), RENDER_SCALE_STEP_DOWN);
+	} else if (ratio > RENDER_SCALE_UP_THRESHOLD) {
+		scale *= fminf(sqrtf((float)ratio), RENDER_SCALE_STEP_UP);
+	}
+
+	mc->state.render_scale = CLAMP(scale, RENDER_SCALE_MIN, RENDER_SCALE_MAX);
+}
+
+
 /*
  *
  * Wait helper thread.
@@ -333,6 +388,7 @@ run_func(void *ptr)
 
 		os_mutex_lock(&mc->msc->list_and_timing_lock);
 		u_pa_mark_gpu_done(mc->upa, frame_id, now_ns);
+		update_render_scale_locked(mc);
 		os_mutex_unlock(&mc->msc->list_and_timing_lock);
 
 		// Wait for the delivery slot.
@@ -840,6 +896,7 @@ multi_compositor_layer_commit(struct xrt_compositor *xc, xrt_graphics_sync_handl
 
 		os_mutex_lock(&mc->msc->list_and_timing_lock);
 		u_pa_mark_gpu_done(mc->upa, frame_id, now_ns);
+		update_render_scale_locked(mc);
 		os_mutex_unlock(&mc->msc->list_and_timing_lock);
 
 		wait_for_scheduled_free(mc);
@@ -863,6 +920,42 @@ multi_compositor_layer_commit_with_semaphore(struct xrt_compositor *xc,
 	return XRT_SUCCESS;
 }
 
+static xrt_result_t
+multi_compositor_get_frame_stats(struct xrt_compositor *xc, struct xrt_compositor_frame_stats *out_stats)
+{
+	COMP_TRACE_MARKER();
+
+	struct multi_compositor *mc = multi_compositor(xc);
+	struct u_pacing_app_stats stats = {0};
+
+	os_mutex_lock(&mc->msc->list_and_timing_lock);
+	u_pa_get_stats(mc->upa, &stats);
+	out_stats->compositor_gpu_time_ns = mc->msc->last_timings.compositor_gpu_time_ns;
+	out_stats->display_period_ns = mc->msc->last_timings.predicted_display_period_ns;
+	out_stats->rate_divisor = mc->state.rate_divisor;
+	out_stats->recommended_render_scale = mc->state.render_scale;
+	os_mutex_unlock(&mc->msc->list_and_timing_lock);
+
+	out_stats->app_cpu_time_ns = stats.cpu_time_ns;
+	out_stats->app_gpu_time_ns = stats.gpu_time_ns;
+	out_stats->app_latency_ns = stats.latency_ns;
+	out_stats->app_frame_count = stats.frame_count;
+	out_stats->app_missed_frame_count = stats.missed_count;
+
+	return XRT_SUCCESS;
+}
+
+static xrt_result_t
+multi_compositor_get_memory_budget(struct xrt_compositor *xc, struct xrt_compositor_memory_budget *out_budget)
+{
+	COMP_TRACE_MARKER();
+
+	struct multi_compositor *mc = multi_compositor(xc);
+
+	// All sessions allocate their swapchains from the native compositor.
+	return xrt_comp_get_memory_budget(&mc->msc->xcn->base, out_budget);
+}
+
 static xrt_result_t
 multi_compositor_poll_events(struct xrt_compositor *xc, union xrt_compositor_event *out_xce)
 {
@@ -1000,10 +1093,14 @@ multi_compositor_create(struct multi_system_compositor *msc,
 	mc->base.base.layer_equirect2 = multi_compositor_layer_equirect2;
 	mc->base.base.layer_commit = multi_compositor_layer_commit;
 	mc->base.base.layer_commit_with_semaphore = multi_compositor_layer_commit_with_semaphore;
+	mc->base.base.get_frame_stats = multi_compositor_get_frame_stats;
+	mc->base.base.get_memory_budget = multi_compositor_get_memory_budget;
 	mc->base.base.destroy = multi_compositor_destroy;
 	mc->base.base.poll_events = multi_compositor_poll_events;
 	mc->msc = msc;
 	mc->xsi = *xsi;
+	mc->state.rate_divisor = 1;
+	mc->state.render_scale = 1.0f;
 
 	os_mutex_init(&mc->event.mutex);
 	os_mutex_init(&mc->slot_lock);
@@ -17,6 +17,7 @@
 #include "os/os_threading.h"
 
 #include "util/u_pacing.h"
+#include "util/u_frame_arena.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -24,7 +25,7 @@ extern "C" {
 
 
 #define MULTI_MAX_CLIENTS 64
-#define MULTI_MAX_LAYERS 16
+#define MULTI_MAX_LAYERS 64
 
 
 /*
@@ -120,6 +121,12 @@ struct multi_compositor
 
 		int64_t z_order;
 
+		//! Paced at every this many display periods, protected by list_and_timing_lock.
+		uint32_t rate_divisor;
+
+		//! Recommended render scale, protected by list_and_timing_lock.
+		float render_scale;
+
 		bool session_active;
 	} state;
 
@@ -315,6 +322,9 @@ struct multi_system_compositor
 	//! Render loop thread.
 	struct os_thread_helper oth;
 
+	//! For waiting for the wake up time of each frame, only used on the render loop thread.
+	struct os_precise_sleeper sleeper;
+
 	struct
 	{
 		/*!
@@ -340,9 +350,25 @@ struct multi_system_compositor
 		uint64_t predicted_display_time_ns;
 		uint64_t predicted_display_period_ns;
 		uint64_t diff_ns;
+
+		//! Measured GPU time of the native compositor, zero if unknown.
+		uint64_t compositor_gpu_time_ns;
 	} last_timings;
 
+	//! Pacing arbitration between the clients, protected by list_and_timing_lock.
+	struct
+	{
+		//! Stagger the clients by their GPU time, XRT_COMPOSITOR_PACING_ARBITRATION.
+		bool arbitration;
+
+		//! The clients' GPU time doesn't fit in a display period, overlays are at half rate.
+		bool over_budget;
+	} pacing;
+
 	struct multi_compositor *clients[MULTI_MAX_CLIENTS];
+
+	//! Scratch memory for transferring layers, reset every frame, only used on the render thread.
+	struct u_frame_arena frame_arena;
 };
 
 /*!
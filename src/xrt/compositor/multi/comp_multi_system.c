@@ -14,6 +14,8 @@
 #include "os/os_time.h"
 #include "os/os_threading.h"
 
+#include "math/m_api.h"
+
 #include "util/u_var.h"
 #include "util/u_misc.h"
 #include "util/u_time.h"
@@ -30,6 +32,7 @@
 #include "multi/comp_multi_interface.h"
 
 #include <math.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <assert.h>
 #include <stdarg.h>
@@ -41,6 +44,11 @@
 #endif
 
 
+DEBUG_GET_ONCE_OPTION(compositor_core_class, "XRT_COMPOSITOR_CORE_CLASS", NULL)
+DEBUG_GET_ONCE_BOOL_OPTION(pacing_arbitration, "XRT_COMPOSITOR_PACING_ARBITRATION", true)
+DEBUG_GET_ONCE_BOOL_OPTION(hybrid_sleep, "XRT_COMPOSITOR_HYBRID_SLEEP", true)
+
+
 /*
  *
  * Render thread.
@@ -225,13 +233,21 @@ transfer_layers_locked(struct multi_system_compositor *msc, uint64_t display_tim
 
 	struct xrt_compositor *xc = &msc->xcn->base;
 
-	struct multi_compositor *array[MULTI_MAX_CLIENTS] = {0};
+	// Everything from last frame is done with.
+	u_frame_arena_reset(&msc->frame_arena);
+
+	struct multi_compositor **array =
+	    U_FRAME_ARENA_ALLOC_ARRAY(&msc->frame_arena, struct multi_compositor *, ARRAY_SIZE(msc->clients));
+	if (array == NULL) {
+		U_LOG_E("Out of memory for the client list, dropping layers!");
+		return;
+	}
 
 	// To mark latching.
 	uint64_t now_ns = os_monotonic_get_ns();
 
 	size_t count = 0;
-	for (size_t k = 0; k < ARRAY_SIZE(array); k++) {
+	for (size_t k = 0; k < ARRAY_SIZE(msc->clients); k++) {
 		struct multi_compositor *mc = msc->clients[k];
 
 		// Array can be empty
@@ -269,7 +285,7 @@ transfer_layers_locked(struct multi_system_compositor *msc, uint64_t display_tim
 		array[count++] = msc->clients[k];
 	}
 
-	// Sort the stack array
+	// Sort the array
 	qsort(array, count, sizeof(struct multi_compositor *), overlay_sort_func);
 
 	// Copy all active layers.
@@ -315,27 +331,129 @@ broadcast_timings_to_clients(struct multi_system_compositor *msc, uint64_t predi
 	os_mutex_unlock(&msc->list_and_timing_lock);
 }
 
+/*!
+ * Highest priority first: visible before hidden clients, the focused client,
+ * primary apps before overlays and last the z-order.
+ */
+static int
+arbitration_sort_func(const void *a, const void *b)
+{
+	struct multi_compositor *mc_a = *(struct multi_compositor **)a;
+	struct multi_compositor *mc_b = *(struct multi_compositor **)b;
+
+	if (mc_a->state.visible != mc_b->state.visible) {
+		return mc_a->state.visible ? -1 : 1;
+	}
+
+	if (mc_a->state.focused != mc_b->state.focused) {
+		return mc_a->state.focused ? -1 : 1;
+	}
+
+	if (mc_a->xsi.is_overlay != mc_b->xsi.is_overlay) {
+		return mc_a->xsi.is_overlay ? 1 : -1;
+	}
+
+	if (mc_a->state.z_order > mc_b->state.z_order) {
+		return -1;
+	}
+
+	if (mc_a->state.z_order < mc_b->state.z_order) {
+		return 1;
+	}
+
+	return 0;
+}
+
+/*!
+ * Stagger the clients so they don't all wake up at the same time and compete
+ * for the GPU. The highest priority client is paced closest to the compositor,
+ * each following client wakes up earlier by the GPU time of the clients before
+ * it. If the GPU time of all visible clients doesn't fit in a display period
+ * the overlays are paced at half rate, until it fits again with some margin.
+ *
+ * The list_and_timing_lock must be held.
+ */
+static void
+arbitrate_pacers_locked(struct multi_system_compositor *msc,
+                        uint64_t predicted_display_time_ns,
+                        uint64_t predicted_display_period_ns,
+                        uint64_t diff_ns)
+{
+	struct multi_compositor *array[MULTI_MAX_CLIENTS] = {0};
+	uint64_t gpu_time_ns[MULTI_MAX_CLIENTS] = {0};
+
+	size_t count = 0;
+	for (size_t k = 0; k < ARRAY_SIZE(msc->clients); k++) {
+		if (msc->clients[k] != NULL) {
+			array[count++] = msc->clients[k];
+		}
+	}
+
+	qsort(array, count, sizeof(struct multi_compositor *), arbitration_sort_func);
+
+	uint64_t total_ns = diff_ns;
+	for (size_t i = 0; i < count; i++) {
+		// Hidden clients don't submit any layers, don't make room for them.
+		if (array[i]->state.visible) {
+			u_pa_get_gpu_time(array[i]->upa, &gpu_time_ns[i]);
+		}
+		// Rate limited clients only need the GPU part of the time.
+		total_ns += gpu_time_ns[i] / array[i]->state.rate_divisor;
+	}
+
+	if (total_ns > predicted_display_period_ns) {
+		msc->pacing.over_budget = true;
+	} else if (total_ns < predicted_display_period_ns * 3 / 4) {
+		msc->pacing.over_budget = false;
+	}
+
+	uint64_t offset_ns = 0;
+	for (size_t i = 0; i < count; i++) {
+		struct multi_compositor *mc = array[i];
+
+		bool half_rate = msc->pacing.over_budget && mc->xsi.is_overlay && !mc->state.focused;
+		u_pa_set_rate_divisor(mc->upa, MAX(mc->state.rate_divisor, half_rate ? 2 : 1));
+
+		u_pa_info(                       //
+		    mc->upa,                     //
+		    predicted_display_time_ns,   //
+		    predicted_display_period_ns, //
+		    diff_ns + offset_ns);        //
+
+		// Never push clients more than a display period earlier.
+		offset_ns = MIN(offset_ns + gpu_time_ns[i], predicted_display_period_ns);
+	}
+}
+
 static void
 broadcast_timings_to_pacers(struct multi_system_compositor *msc,
                             uint64_t predicted_display_time_ns,
                             uint64_t predicted_display_period_ns,
+                            uint64_t compositor_gpu_time_ns,
                             uint64_t diff_ns)
 {
 	COMP_TRACE_MARKER();
 
 	os_mutex_lock(&msc->list_and_timing_lock);
 
+	if (msc->pacing.arbitration) {
+		arbitrate_pacers_locked(msc, predicted_display_time_ns, predicted_display_period_ns, diff_ns);
+	}
+
 	for (size_t i = 0; i < ARRAY_SIZE(msc->clients); i++) {
 		struct multi_compositor *mc = msc->clients[i];
 		if (mc == NULL) {
 			continue;
 		}
 
-		u_pa_info(                       //
-		    mc->upa,                     //
-		    predicted_display_time_ns,   //
-		    predicted_display_period_ns, //
-		    diff_ns);                    //
+		if (!msc->pacing.arbitration) {
+			u_pa_set_rate_divisor(mc->upa, mc->state.rate_divisor);
+			u_pa_info(                       //
+			    mc->upa,                     //
+			    predicted_display_time_ns,   //
+			    predicted_display_period_ns, //
+			    diff_ns);                    //
+		}
 
 		os_mutex_lock(&mc->slot_lock);
 		mc->slot_next_frame_display = predicted_display_time_ns;
@@ -345,6 +463,7 @@ broadcast_timings_to_pacers(struct multi_system_compositor *msc,
 	msc->last_timings.predicted_display_time_ns = predicted_display_time_ns;
 	msc->last_timings.predicted_display_period_ns = predicted_display_period_ns;
 	msc->last_timings.diff_ns = diff_ns;
+	msc->last_timings.compositor_gpu_time_ns = compositor_gpu_time_ns;
 
 	os_mutex_unlock(&msc->list_and_timing_lock);
 }
@@ -436,11 +555,22 @@ multi_main_loop(struct multi_system_compositor *msc)
 	u_linux_try_to_set_realtime_priority_on_thread(U_LOGGING_INFO, "Multi Client Module");
 #endif
 
+	// Keep frame timing critical work off of efficiency cores.
+	enum os_thread_core_class core_class =
+	    os_thread_core_class_from_string(debug_get_option_compositor_core_class(), OS_THREAD_CORE_CLASS_PERFORMANCE);
+	if (os_thread_helper_set_core_class(&msc->oth, core_class) != 0) {
+		U_LOG_W("Failed to pin 'Multi Client Module' thread to core class %d", (int)core_class);
+	}
+
 	struct xrt_compositor *xc = &msc->xcn->base;
 
-	// For wait frame.
-	struct os_precise_sleeper sleeper = {0};
-	os_precise_sleeper_init(&sleeper);
+	// For wait frame, calibrated here as the latency depends on the thread priority.
+	if (debug_get_bool_option_hybrid_sleep()) {
+		os_precise_sleeper_init_hybrid(&msc->sleeper);
+		U_LOG_I("Hybrid frame wait, spinning the last %" PRIi64 "us.", msc->sleeper.spin_margin_ns / 1000);
+	} else {
+		os_precise_sleeper_init(&msc->sleeper);
+	}
 
 	// Protect the thread state and the sessions state.
 	os_thread_helper_lock(&msc->oth);
@@ -480,13 +610,22 @@ multi_main_loop(struct multi_system_compositor *msc)
 		broadcast_timings_to_clients(msc, predicted_display_time_ns);
 
 		// Now we can wait.
-		wait_frame(&sleeper, xc, frame_id, wake_up_time_ns);
+		wait_frame(&msc->sleeper, xc, frame_id, wake_up_time_ns);
 
 		uint64_t now_ns = os_monotonic_get_ns();
 		uint64_t diff_ns = predicted_display_time_ns - now_ns;
 
+		// The native compositor's GPU time of the last frame, if it measures it.
+		struct xrt_compositor_frame_stats native_stats = {0};
+		xrt_comp_get_frame_stats(xc, &native_stats);
+
 		// Now we know the diff, broadcast to pacers.
-		broadcast_timings_to_pacers(msc, predicted_display_time_ns, predicted_display_period_ns, diff_ns);
+		broadcast_timings_to_pacers(             //
+		    msc,                                 //
+		    predicted_display_time_ns,           //
+		    predicted_display_period_ns,         //
+		    native_stats.compositor_gpu_time_ns, //
+		    diff_ns);                            //
 
 		xrt_comp_begin_frame(xc, frame_id);
 
@@ -528,7 +667,7 @@ multi_main_loop(struct multi_system_compositor *msc)
 
 	os_thread_helper_unlock(&msc->oth);
 
-	os_precise_sleeper_deinit(&sleeper);
+	os_precise_sleeper_deinit(&msc->sleeper);
 
 	return 0;
 }
@@ -582,6 +721,20 @@ system_compositor_set_z_order(struct xrt_system_compositor *xsc, struct xrt_comp
 	return XRT_SUCCESS;
 }
 
+static xrt_result_t
+system_compositor_set_rate_divisor(struct xrt_system_compositor *xsc, struct xrt_compositor *xc, uint32_t rate_divisor)
+{
+	struct multi_system_compositor *msc = multi_system_compositor(xsc);
+	struct multi_compositor *mc = multi_compositor(xc);
+
+	// Picked up by the pacer on the next broadcast.
+	os_mutex_lock(&msc->list_and_timing_lock);
+	mc->state.rate_divisor = MAX(rate_divisor, 1);
+	os_mutex_unlock(&msc->list_and_timing_lock);
+
+	return XRT_SUCCESS;
+}
+
 static xrt_result_t
 system_compositor_set_main_app_visibility(struct xrt_system_compositor *xsc, struct xrt_compositor *xc, bool visible)
 {
@@ -653,6 +806,8 @@ system_compositor_destroy(struct xrt_system_compositor *xsc)
 {
 	struct multi_system_compositor *msc = multi_system_compositor(xsc);
 
+	u_var_remove_root(msc);
+
 	// Destroy the render thread first, destroy also stops the thread.
 	os_thread_helper_destroy(&msc->oth);
 
@@ -662,6 +817,8 @@ system_compositor_destroy(struct xrt_system_compositor *xsc)
 
 	os_mutex_destroy(&msc->list_and_timing_lock);
 
+	u_frame_arena_fini(&msc->frame_arena);
+
 	free(msc);
 }
 
@@ -703,6 +860,7 @@ comp_multi_create_system_compositor(struct xrt_compositor_native *xcn,
 	msc->base.destroy = system_compositor_destroy;
 	msc->xmcc.set_state = system_compositor_set_state;
 	msc->xmcc.set_z_order = system_compositor_set_z_order;
+	msc->xmcc.set_rate_divisor = system_compositor_set_rate_divisor;
 	msc->xmcc.set_main_app_visibility = system_compositor_set_main_app_visibility;
 	msc->xmcc.notify_loss_pending = system_compositor_notify_loss_pending;
 	msc->xmcc.notify_lost = system_compositor_notify_lost;
@@ -712,8 +870,10 @@ comp_multi_create_system_compositor(struct xrt_compositor_native *xcn,
 	msc->xcn = xcn;
 	msc->sessions.active_count = 0;
 	msc->sessions.state = do_warm_start ? MULTI_SYSTEM_STATE_INIT_WARM_START : MULTI_SYSTEM_STATE_STOPPED;
+	msc->pacing.arbitration = debug_get_bool_option_pacing_arbitration();
 
 	os_mutex_init(&msc->list_and_timing_lock);
+	u_frame_arena_init(&msc->frame_arena, 4096);
 
 	//! @todo Make the clients not go from IDLE to READY before we have completed a first frame.
 	// Make sure there is at least some sort of valid frame data here.
@@ -721,6 +881,15 @@ comp_multi_create_system_compositor(struct xrt_compositor_native *xcn,
 	msc->last_timings.predicted_display_period_ns = U_TIME_1MS_IN_NS * 16; // Just a wild guess.
 	msc->last_timings.diff_ns = U_TIME_1MS_IN_NS * 5;                      // Make sure it's not zero at least.
 
+	u_var_add_root(msc, "Multi-client system compositor", false);
+	u_var_add_ro_i64(msc, &msc->sleeper.spin_margin_ns, "Frame wait spin margin (ns)");
+	u_var_add_ro_u64(msc, &msc->sleeper.stats.count, "Frame waits");
+	u_var_add_ro_u64(msc, &msc->sleeper.stats.late_count, "Frame waits >100us late");
+	u_var_add_ro_i64(msc, &msc->sleeper.stats.last_ns, "Last oversleep (ns)");
+	u_var_add_ro_i64(msc, &msc->sleeper.stats.mean_ns, "Mean oversleep (ns)");
+	u_var_add_ro_i64(msc, &msc->sleeper.stats.max_ns, "Max oversleep (ns)");
+	u_var_add_ro_i64(msc, &msc->sleeper.stats.last_spin_ns, "Last spin (ns)");
+
 	int ret = os_thread_helper_init(&msc->oth);
 	if (ret < 0) {
 		return XRT_ERROR_THREADING_INIT_FAILURE;
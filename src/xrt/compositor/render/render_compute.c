@@ -61,7 +61,10 @@ vk_from_crc(struct render_compute *crc)
  * For dispatching compute to the view, calculate the number of groups.
  */
 static void
-calc_dispatch_dims(const struct render_viewport_data views[2], uint32_t *out_w, uint32_t *out_h)
+calc_dispatch_dims_tiled(const struct render_viewport_data views[2],
+                         uint32_t tile_size,
+                         uint32_t *out_w,
+                         uint32_t *out_h)
 {
 #define IMAX(a, b) ((a) > (b) ? (a) : (b))
 	uint32_t w = IMAX(views[0].w, views[1].w);
@@ -70,14 +73,35 @@ calc_dispatch_dims(const struct render_viewport_data views[2], uint32_t *out_w,
 
 	// Power of two divide and round up.
 #define P2_DIVIDE_ROUND_UP(v, div) ((v + (div - 1)) / div)
-	w = P2_DIVIDE_ROUND_UP(w, 8);
-	h = P2_DIVIDE_ROUND_UP(h, 8);
+	w = P2_DIVIDE_ROUND_UP(w, tile_size);
+	h = P2_DIVIDE_ROUND_UP(h, tile_size);
 #undef P2_DIVIDE_ROUND_UP
 
 	*out_w = w;
 	*out_h = h;
 }
 
+static void
+calc_dispatch_dims(const struct render_viewport_data views[2], uint32_t *out_w, uint32_t *out_h)
+{
+	calc_dispatch_dims_tiled(views, 8, out_w, out_h);
+}
+
+/*
+ * The foveated layer and distortion shaders cover a larger tile per group,
+ * must match FOVEATION_TILE_SIZE in foveation.inc.glsl.
+ */
+static void
+calc_dispatch_dims_foveated(struct render_resources *r,
+                            const struct render_viewport_data views[2],
+                            uint32_t *out_w,
+                            uint32_t *out_h)
+{
+	uint32_t tile_size = r->compute.foveation.enabled ? 32 : 8;
+
+	calc_dispatch_dims_tiled(views, tile_size, out_w, out_h);
+}
+
 
 /*
  *
@@ -88,8 +112,8 @@ calc_dispatch_dims(const struct render_viewport_data views[2], uint32_t *out_w,
 XRT_MAYBE_UNUSED static void
 update_compute_layer_descriptor_set(struct vk_bundle *vk,
                                     uint32_t src_binding,
-                                    VkSampler src_samplers[COMP_MAX_IMAGES],
-                                    VkImageView src_image_views[COMP_MAX_IMAGES],
+                                    VkSampler src_samplers[RENDER_MAX_IMAGES],
+                                    VkImageView src_image_views[RENDER_MAX_IMAGES],
                                     uint32_t image_count,
                                     uint32_t target_binding,
                                     VkImageView target_image_view,
@@ -98,9 +122,9 @@ update_compute_layer_descriptor_set(struct vk_bundle *vk,
                                     VkDeviceSize ubo_size,
                                     VkDescriptorSet descriptor_set)
 {
-	assert(image_count <= COMP_MAX_IMAGES);
+	assert(image_count <= RENDER_MAX_IMAGES);
 
-	VkDescriptorImageInfo src_image_info[COMP_MAX_IMAGES];
+	VkDescriptorImageInfo src_image_info[RENDER_MAX_IMAGES];
 	for (uint32_t i = 0; i < image_count; i++) {
 		src_image_info[i].sampler = src_samplers[i];
 		src_image_info[i].imageView = src_image_views[i];
@@ -153,8 +177,45 @@ update_compute_layer_descriptor_set(struct vk_bundle *vk,
 	    NULL);                             // pDescriptorCopies
 }
 
+/*!
+ * Returns true if the distortion image and UBO bindings of the shared
+ * distortion descriptor set needs to be written, and records what they will be
+ * written with.
+ */
+static bool
+distortion_bindings_need_write(struct render_resources *r,
+                               VkSampler distortion_samplers[6],
+                               VkImageView distortion_image_views[6],
+                               VkBuffer ubo_buffer)
+{
+	bool unchanged = r->compute.distortion.written.valid && //
+	                 r->compute.distortion.written.ubo_buffer == ubo_buffer;
+
+	for (uint32_t i = 0; i < 6 && unchanged; i++) {
+		unchanged = r->compute.distortion.written.samplers[i] == distortion_samplers[i] &&
+		            r->compute.distortion.written.image_views[i] == distortion_image_views[i];
+	}
+
+	if (unchanged) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < 6; i++) {
+		r->compute.distortion.written.samplers[i] = distortion_samplers[i];
+		r->compute.distortion.written.image_views[i] = distortion_image_views[i];
+	}
+	r->compute.distortion.written.ubo_buffer = ubo_buffer;
+	r->compute.distortion.written.valid = true;
+
+	return true;
+}
+
+/*!
+ * Writes the distortion descriptor set, the distortion image and UBO bindings
+ * are skipped if they are the same as the last time the set was written.
+ */
 XRT_MAYBE_UNUSED static void
-update_compute_distortion_descriptor_set(struct vk_bundle *vk,
+update_compute_distortion_descriptor_set(struct render_resources *r,
                                          uint32_t src_binding,
                                          VkSampler src_samplers[2],
                                          VkImageView src_image_views[2],
@@ -168,6 +229,11 @@ update_compute_distortion_descriptor_set(struct vk_bundle *vk,
                                          VkDeviceSize ubo_size,
                                          VkDescriptorSet descriptor_set)
 {
+	struct vk_bundle *vk = r->vk;
+
+	// Only the shared set is tracked.
+	assert(descriptor_set == r->compute.distortion.descriptor_set);
+
 	VkDescriptorImageInfo src_image_info[2] = {
 	    {
 	        .sampler = src_samplers[0],
@@ -225,6 +291,7 @@ update_compute_distortion_descriptor_set(struct vk_bundle *vk,
 	    .range = ubo_size,
 	};
 
+	// Ordered so that the bindings that are tracked are last.
 	VkWriteDescriptorSet write_descriptor_sets[4] = {
 	    {
 	        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
@@ -234,14 +301,6 @@ update_compute_distortion_descriptor_set(struct vk_bundle *vk,
 	        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
 	        .pImageInfo = src_image_info,
 	    },
-	    {
-	        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-	        .dstSet = descriptor_set,
-	        .dstBinding = distortion_binding,
-	        .descriptorCount = ARRAY_SIZE(distortion_image_info),
-	        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-	        .pImageInfo = distortion_image_info,
-	    },
 	    {
 	        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
 	        .dstSet = descriptor_set,
@@ -250,6 +309,14 @@ update_compute_distortion_descriptor_set(struct vk_bundle *vk,
 	        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
 	        .pImageInfo = &target_image_info,
 	    },
+	    {
+	        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+	        .dstSet = descriptor_set,
+	        .dstBinding = distortion_binding,
+	        .descriptorCount = ARRAY_SIZE(distortion_image_info),
+	        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+	        .pImageInfo = distortion_image_info,
+	    },
 	    {
 	        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
 	        .dstSet = descriptor_set,
@@ -260,12 +327,17 @@ update_compute_distortion_descriptor_set(struct vk_bundle *vk,
 	    },
 	};
 
-	vk->vkUpdateDescriptorSets(            //
-	    vk->device,                        //
-	    ARRAY_SIZE(write_descriptor_sets), // descriptorWriteCount
-	    write_descriptor_sets,             // pDescriptorWrites
-	    0,                                 // descriptorCopyCount
-	    NULL);                             // pDescriptorCopies
+	uint32_t write_count = ARRAY_SIZE(write_descriptor_sets);
+	if (!distortion_bindings_need_write(r, distortion_samplers, distortion_image_views, ubo_buffer)) {
+		write_count = 2;
+	}
+
+	vk->vkUpdateDescriptorSets( //
+	    vk->device,             //
+	    write_count,            // descriptorWriteCount
+	    write_descriptor_sets,  // pDescriptorWrites
+	    0,                      // descriptorCopyCount
+	    NULL);                  // pDescriptorCopies
 }
 
 XRT_MAYBE_UNUSED static void
@@ -336,11 +408,22 @@ render_compute_init(struct render_compute *crc, struct render_resources *r)
 	    r->compute.layer.descriptor_set_layout, // descriptor_set_layout
 	    &crc->descriptor_set));                 // descriptor_set
 
-	C(vk_create_descriptor_set(                      //
-	    vk,                                          //
-	    r->compute.descriptor_pool,                  // descriptor_pool
-	    r->compute.distortion.descriptor_set_layout, // descriptor_set_layout
-	    &crc->distortion_descriptor_set));           // descriptor_set
+	// Lives across frames, the update only writes what has changed.
+	crc->distortion_descriptor_set = r->compute.distortion.descriptor_set;
+
+	C(vk_create_descriptor_set(                 //
+	    vk,                                     //
+	    r->compute.descriptor_pool,             // descriptor_pool
+	    r->compute.layer.descriptor_set_layout, // descriptor_set_layout
+	    &crc->cache_descriptor_set));           // descriptor_set
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(crc->pass_descriptor_sets); i++) {
+		C(vk_create_descriptor_set(                 //
+		    vk,                                     //
+		    r->compute.descriptor_pool,             // descriptor_pool
+		    r->compute.layer.descriptor_set_layout, // descriptor_set_layout
+		    &crc->pass_descriptor_sets[i]));        // descriptor_set
+	}
 
 	return true;
 }
@@ -361,17 +444,7 @@ render_compute_begin(struct render_compute *crc)
 	    crc->r->cmd,            // commandBuffer
 	    &begin_info));          // pBeginInfo
 
-	vk->vkCmdResetQueryPool( //
-	    crc->r->cmd,         // commandBuffer
-	    crc->r->query_pool,  // queryPool
-	    0,                   // firstQuery
-	    2);                  // queryCount
-
-	vk->vkCmdWriteTimestamp(               //
-	    crc->r->cmd,                       // commandBuffer
-	    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, // pipelineStage
-	    crc->r->query_pool,                // queryPool
-	    0);                                // query
+	render_resources_begin_timestamps(crc->r, crc->r->cmd);
 
 	return true;
 }
@@ -381,11 +454,7 @@ render_compute_end(struct render_compute *crc)
 {
 	struct vk_bundle *vk = vk_from_crc(crc);
 
-	vk->vkCmdWriteTimestamp(                  //
-	    crc->r->cmd,                          // commandBuffer
-	    VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, // pipelineStage
-	    crc->r->query_pool,                   // queryPool
-	    1);                                   // query
+	render_resources_write_timestamp(crc->r, crc->r->cmd, RENDER_TIMESTAMP_POINT_END);
 
 	C(vk->vkEndCommandBuffer(crc->r->cmd));
 
@@ -401,6 +470,12 @@ render_compute_close(struct render_compute *crc)
 
 	// Reclaimed by vkResetDescriptorPool.
 	crc->descriptor_set = VK_NULL_HANDLE;
+	crc->cache_descriptor_set = VK_NULL_HANDLE;
+	for (uint32_t i = 0; i < ARRAY_SIZE(crc->pass_descriptor_sets); i++) {
+		crc->pass_descriptor_sets[i] = VK_NULL_HANDLE;
+	}
+
+	// Owned by render_resources.
 	crc->distortion_descriptor_set = VK_NULL_HANDLE;
 
 	vk->vkResetDescriptorPool(vk->device, crc->r->compute.descriptor_pool, 0);
@@ -408,23 +483,28 @@ render_compute_close(struct render_compute *crc)
 	crc->r = NULL;
 }
 
-void
-render_compute_layers(struct render_compute *crc,
-                      VkSampler src_samplers[COMP_MAX_IMAGES],
-                      VkImageView src_image_views[COMP_MAX_IMAGES],
-                      uint32_t image_count,
-                      VkImage target_image,
-                      VkImageView target_image_view,
-                      VkImageLayout transition_to,
-                      bool timewarp)
+static void
+do_compute_layers(struct render_compute *crc,
+                  VkDescriptorSet descriptor_set,
+                  struct render_buffer *ubo,
+                  VkPipeline pipeline,
+                  VkSampler src_samplers[RENDER_MAX_IMAGES],
+                  VkImageView src_image_views[RENDER_MAX_IMAGES],
+                  uint32_t image_count,
+                  VkImage target_image,
+                  VkImageView target_image_view,
+                  VkImageLayout transition_to,
+                  VkPipelineStageFlags dst_stage_mask,
+                  VkAccessFlags dst_access_mask)
 {
 	assert(crc->r != NULL);
 
 	struct vk_bundle *vk = vk_from_crc(crc);
 	struct render_resources *r = crc->r;
 
-	struct render_compute_layer_ubo_data *ubo_data =
-	    (struct render_compute_layer_ubo_data *)crc->r->compute.layer.ubo.mapped;
+	struct render_compute_layer_ubo_data *ubo_data = (struct render_compute_layer_ubo_data *)ubo->mapped;
+	ubo_data->foveation[0] = r->compute.foveation.views[0];
+	ubo_data->foveation[1] = r->compute.foveation.views[1];
 
 	/*
 	 * Source, target and distortion images.
@@ -457,14 +537,14 @@ render_compute_layers(struct render_compute *crc,
 	    r->compute.target_binding,       //
 	    target_image_view,               //
 	    r->compute.ubo_binding,          //
-	    r->compute.layer.ubo.buffer,     //
+	    ubo->buffer,                     //
 	    VK_WHOLE_SIZE,                   //
-	    crc->descriptor_set);            //
+	    descriptor_set);                 //
 
 	vk->vkCmdBindPipeline(              //
-	    crc->r->cmd,                    // commandBuffer
+	    r->cmd,                         // commandBuffer
 	    VK_PIPELINE_BIND_POINT_COMPUTE, // pipelineBindPoint
-	    timewarp ? r->compute.layer.timewarp_pipeline : r->compute.layer.non_timewarp_pipeline); // pipeline
+	    pipeline);                      // pipeline
 
 	vk->vkCmdBindDescriptorSets(          //
 	    r->cmd,                           // commandBuffer
@@ -472,13 +552,13 @@ render_compute_layers(struct render_compute *crc,
 	    r->compute.layer.pipeline_layout, // layout
 	    0,                                // firstSet
 	    1,                                // descriptorSetCount
-	    &crc->descriptor_set,             // pDescriptorSets
+	    &descriptor_set,                  // pDescriptorSets
 	    0,                                // dynamicOffsetCount
 	    NULL);                            // pDynamicOffsets
 
 
 	uint32_t w = 0, h = 0;
-	calc_dispatch_dims(ubo_data->views, &w, &h);
+	calc_dispatch_dims_foveated(r, ubo_data->views, &w, &h);
 	assert(w != 0 && h != 0);
 
 	vk->vkCmdDispatch( //
@@ -490,7 +570,7 @@ render_compute_layers(struct render_compute *crc,
 	VkImageMemoryBarrier memoryBarrier = {
 	    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
 	    .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
-	    .dstAccessMask = VK_ACCESS_MEMORY_READ_BIT,
+	    .dstAccessMask = dst_access_mask,
 	    .oldLayout = VK_IMAGE_LAYOUT_GENERAL,
 	    .newLayout = transition_to,
 	    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
@@ -502,7 +582,7 @@ render_compute_layers(struct render_compute *crc,
 	vk->vkCmdPipelineBarrier(                 //
 	    r->cmd,                               //
 	    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, //
-	    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,    //
+	    dst_stage_mask,                       //
 	    0,                                    //
 	    0,                                    //
 	    NULL,                                 //
@@ -512,6 +592,104 @@ render_compute_layers(struct render_compute *crc,
 	    &memoryBarrier);                      //
 }
 
+void
+render_compute_layers(struct render_compute *crc,
+                      VkSampler src_samplers[RENDER_MAX_IMAGES],
+                      VkImageView src_image_views[RENDER_MAX_IMAGES],
+                      uint32_t image_count,
+                      VkImage target_image,
+                      VkImageView target_image_view,
+                      VkImageLayout transition_to,
+                      bool timewarp)
+{
+	struct render_resources *r = crc->r;
+
+	VkPipeline pipeline = timewarp ? r->compute.layer.timewarp_pipeline : r->compute.layer.non_timewarp_pipeline;
+
+	do_compute_layers(                     //
+	    crc,                               //
+	    crc->descriptor_set,               //
+	    &r->compute.layer.ubo,             //
+	    pipeline,                          //
+	    src_samplers,                      //
+	    src_image_views,                   //
+	    image_count,                       //
+	    target_image,                      //
+	    target_image_view,                 //
+	    transition_to,                     //
+	    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, //
+	    VK_ACCESS_MEMORY_READ_BIT);        //
+}
+
+void
+render_compute_layers_to_cache(struct render_compute *crc,
+                               VkSampler src_samplers[RENDER_MAX_IMAGES],
+                               VkImageView src_image_views[RENDER_MAX_IMAGES],
+                               uint32_t image_count)
+{
+	struct render_resources *r = crc->r;
+
+	// The cache is sampled by the next layer squashing dispatch.
+	do_compute_layers(                            //
+	    crc,                                      //
+	    crc->cache_descriptor_set,                //
+	    &r->compute.layer.cache_ubo,              //
+	    r->compute.layer.non_timewarp_pipeline,   //
+	    src_samplers,                             //
+	    src_image_views,                          //
+	    image_count,                              //
+	    r->scratch.cache.image,                   //
+	    r->scratch.cache.unorm_view,              //
+	    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, //
+	    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,     //
+	    VK_ACCESS_SHADER_READ_BIT);               //
+}
+
+void
+render_compute_layers_pass(struct render_compute *crc,
+                           uint32_t pass_index,
+                           VkSampler src_samplers[RENDER_MAX_IMAGES],
+                           VkImageView src_image_views[RENDER_MAX_IMAGES],
+                           uint32_t image_count,
+                           VkImage target_image,
+                           VkImageView target_image_view,
+                           VkImageLayout transition_to,
+                           bool timewarp,
+                           bool single_projection)
+{
+	struct render_resources *r = crc->r;
+
+	assert(pass_index <= ARRAY_SIZE(crc->pass_descriptor_sets));
+
+	VkPipeline pipeline = timewarp ? r->compute.layer.timewarp_pipeline : r->compute.layer.non_timewarp_pipeline;
+	if (single_projection) {
+		pipeline = timewarp ? r->compute.layer.single_projection_timewarp_pipeline
+		                    : r->compute.layer.single_projection_pipeline;
+	}
+
+	VkDescriptorSet descriptor_set = crc->descriptor_set;
+	struct render_buffer *ubo = &r->compute.layer.ubo;
+	if (pass_index > 0) {
+		descriptor_set = crc->pass_descriptor_sets[pass_index - 1];
+		ubo = &r->compute.layer.pass_ubos[pass_index - 1];
+	}
+
+	// Sampled by the next pass or the distortion.
+	do_compute_layers(                        //
+	    crc,                                  //
+	    descriptor_set,                       //
+	    ubo,                                  //
+	    pipeline,                             //
+	    src_samplers,                         //
+	    src_image_views,                      //
+	    image_count,                          //
+	    target_image,                         //
+	    target_image_view,                    //
+	    transition_to,                        //
+	    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, //
+	    VK_ACCESS_SHADER_READ_BIT);           //
+}
+
 void
 render_compute_projection_timewarp(struct render_compute *crc,
                                    VkSampler src_samplers[2],
@@ -556,6 +734,10 @@ render_compute_projection_timewarp(struct render_compute *crc,
 	data->transforms[1] = time_warp_matrix[1];
 	data->post_transforms[0] = src_norm_rects[0];
 	data->post_transforms[1] = src_norm_rects[1];
+	data->foveation[0] = r->compute.foveation.views[0];
+	data->foveation[1] = r->compute.foveation.views[1];
+	data->analytic[0] = r->distortion.analytic[0];
+	data->analytic[1] = r->distortion.analytic[1];
 
 
 	/*
@@ -586,7 +768,7 @@ render_compute_projection_timewarp(struct render_compute *crc,
 	};
 
 	update_compute_distortion_descriptor_set( //
-	    vk,                                   //
+	    r,                                    //
 	    r->compute.src_binding,               //
 	    src_samplers,                         //
 	    src_image_views,                      //
@@ -617,7 +799,7 @@ render_compute_projection_timewarp(struct render_compute *crc,
 
 
 	uint32_t w = 0, h = 0;
-	calc_dispatch_dims(views, &w, &h);
+	calc_dispatch_dims_foveated(r, views, &w, &h);
 	assert(w != 0 && h != 0);
 
 	vk->vkCmdDispatch( //
@@ -676,6 +858,10 @@ render_compute_projection(struct render_compute *crc,
 	data->views[1] = views[1];
 	data->post_transforms[0] = src_norm_rects[0];
 	data->post_transforms[1] = src_norm_rects[1];
+	data->foveation[0] = r->compute.foveation.views[0];
+	data->foveation[1] = r->compute.foveation.views[1];
+	data->analytic[0] = r->distortion.analytic[0];
+	data->analytic[1] = r->distortion.analytic[1];
 
 
 	/*
@@ -706,7 +892,7 @@ render_compute_projection(struct render_compute *crc,
 	};
 
 	update_compute_distortion_descriptor_set( //
-	    vk,                                   //
+	    r,                                    //
 	    r->compute.src_binding,               //
 	    src_samplers,                         //
 	    src_image_views,                      //
@@ -737,7 +923,7 @@ render_compute_projection(struct render_compute *crc,
 
 
 	uint32_t w = 0, h = 0;
-	calc_dispatch_dims(views, &w, &h);
+	calc_dispatch_dims_foveated(r, views, &w, &h);
 	assert(w != 0 && h != 0);
 
 	vk->vkCmdDispatch( //
@@ -827,7 +1013,7 @@ render_compute_clear(struct render_compute *crc,                 //
 	VkSampler distortion_samplers[6] = {sampler, sampler, sampler, sampler, sampler, sampler};
 
 	update_compute_distortion_descriptor_set( //
-	    vk,                                   // vk_bundle
+	    r,                                    // r
 	    r->compute.src_binding,               // src_binding
 	    src_samplers,                         // src_samplers[2]
 	    src_image_views,                      // src_image_views[2]
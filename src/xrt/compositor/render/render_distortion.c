@@ -9,6 +9,10 @@
 
 #include "xrt/xrt_device.h"
 
+#include "util/u_misc.h"
+#include "util/u_debug.h"
+#include "util/u_distortion_mesh.h"
+
 #include "math/m_api.h"
 #include "math/m_matrix_2x2.h"
 #include "math/m_vec2.h"
@@ -16,6 +20,9 @@
 #include "render/render_interface.h"
 
 
+DEBUG_GET_ONCE_BOOL_OPTION(gpu_distortion, "XRT_COMPOSITOR_GPU_DISTORTION", true)
+
+
 /*
  *
  * Helper defines.
@@ -263,19 +270,9 @@ calc_uv_to_tanangle(struct xrt_device *xdev, uint32_t view, struct xrt_normalize
 	*out_rect = transform;
 }
 
-static XRT_CHECK_RESULT VkResult
-create_and_fill_in_distortion_buffer_for_view(struct vk_bundle *vk,
-                                              struct xrt_device *xdev,
-                                              struct render_buffer *r_buffer,
-                                              struct render_buffer *g_buffer,
-                                              struct render_buffer *b_buffer,
-                                              uint32_t view,
-                                              bool pre_rotate)
+static void
+calc_view_rot(struct xrt_device *xdev, uint32_t view, bool pre_rotate, struct xrt_matrix_2x2 *out_rot)
 {
-	VkBufferUsageFlags usage_flags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-	VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
-	VkResult ret;
-
 	struct xrt_matrix_2x2 rot = xdev->hmd->views[view].rot;
 
 	const struct xrt_matrix_2x2 rotation_90_cw = {{
@@ -290,6 +287,25 @@ create_and_fill_in_distortion_buffer_for_view(struct vk_bundle *vk,
 		m_mat2x2_multiply(&rot, &rotation_90_cw, &rot);
 	}
 
+	*out_rot = rot;
+}
+
+static XRT_CHECK_RESULT VkResult
+create_and_fill_in_distortion_buffer_for_view(struct vk_bundle *vk,
+                                              struct xrt_device *xdev,
+                                              struct render_buffer *r_buffer,
+                                              struct render_buffer *g_buffer,
+                                              struct render_buffer *b_buffer,
+                                              uint32_t view,
+                                              bool pre_rotate)
+{
+	VkBufferUsageFlags usage_flags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+	VkResult ret;
+
+	struct xrt_matrix_2x2 rot;
+	calc_view_rot(xdev, view, pre_rotate, &rot);
+
 	VkDeviceSize size = sizeof(struct texture);
 
 	ret = render_buffer_init(vk, r_buffer, usage_flags, properties, size);
@@ -310,31 +326,24 @@ create_and_fill_in_distortion_buffer_for_view(struct vk_bundle *vk,
 	struct texture *g = g_buffer->mapped;
 	struct texture *b = b_buffer->mapped;
 
-	const double dim_minus_one_f64 = COMP_DISTORTION_IMAGE_DIMENSIONS - 1;
-
-	for (int row = 0; row < COMP_DISTORTION_IMAGE_DIMENSIONS; row++) {
-		// This goes from 0 to 1.0 inclusive.
-		float v = (float)(row / dim_minus_one_f64);
+	const uint32_t dim = COMP_DISTORTION_IMAGE_DIMENSIONS;
+	struct xrt_uv_triplet *results = U_TYPED_ARRAY_CALLOC(struct xrt_uv_triplet, dim * dim);
 
-		for (int col = 0; col < COMP_DISTORTION_IMAGE_DIMENSIONS; col++) {
-			// This goes from 0 to 1.0 inclusive.
-			float u = (float)(col / dim_minus_one_f64);
+	// Evaluated on a worker pool, or loaded from the disk cache.
+	u_distortion_mesh_compute_grid(xdev, view, dim, dim, &rot, results);
 
-			// These need to go from -0.5 to 0.5 for the rotation
-			struct xrt_vec2 uv = {u - 0.5f, v - 0.5f};
-			m_mat2x2_transform_vec2(&rot, &uv, &uv);
-			uv.x += 0.5f;
-			uv.y += 0.5f;
+	for (uint32_t row = 0; row < dim; row++) {
+		for (uint32_t col = 0; col < dim; col++) {
+			const struct xrt_uv_triplet *result = &results[row * dim + col];
 
-			struct xrt_uv_triplet result;
-			xrt_device_compute_distortion(xdev, view, uv.x, uv.y, &result);
-
-			r->pixels[row][col] = result.r;
-			g->pixels[row][col] = result.g;
-			b->pixels[row][col] = result.b;
+			r->pixels[row][col] = result->r;
+			g->pixels[row][col] = result->g;
+			b->pixels[row][col] = result->b;
 		}
 	}
 
+	free(results);
+
 	render_buffer_unmap(vk, r_buffer);
 	render_buffer_unmap(vk, g_buffer);
 	render_buffer_unmap(vk, b_buffer);
@@ -349,16 +358,378 @@ err_buffers:
 	return ret;
 }
 
+
+/*
+ *
+ * Analytic distortion evaluated in the compute shader.
+ *
+ */
+
+static void
+set_params(struct render_compute_distortion_analytic_data *data, uint32_t index, float x, float y, float z, float w)
+{
+	data->params[index].values[0] = x;
+	data->params[index].values[1] = y;
+	data->params[index].values[2] = z;
+	data->params[index].values[3] = w;
+}
+
+/*!
+ * Packs the parameters of the device's analytic model the way distortion.comp
+ * reads them, the rotation is the same as the distortion images get.
+ */
+static void
+calc_analytic_view(struct xrt_device *xdev,
+                   uint32_t view,
+                   bool pre_rotate,
+                   struct render_compute_distortion_analytic_data *out_data)
+{
+	U_ZERO(out_data);
+
+	calc_view_rot(xdev, view, pre_rotate, &out_data->rot);
+
+	const union xrt_distortion_analytic_view *a = &xdev->hmd->distortion.analytic.views[view];
+
+	switch (xdev->hmd->distortion.analytic.model) {
+	case XRT_DISTORTION_ANALYTIC_MODEL_PANOTOOLS: {
+		const struct xrt_distortion_panotools *p = &a->panotools;
+		set_params(out_data, 0, p->distortion_k[0], p->distortion_k[1], p->distortion_k[2], p->distortion_k[3]);
+		set_params(out_data, 1, p->distortion_k[4], p->scale, 0.0f, 0.0f);
+		set_params(out_data, 2, p->aberration_k[0], p->aberration_k[1], p->aberration_k[2], 0.0f);
+		set_params(out_data, 3, p->lens_center.x, p->lens_center.y, p->viewport_size.x, p->viewport_size.y);
+		break;
+	}
+	case XRT_DISTORTION_ANALYTIC_MODEL_VIVE: {
+		const struct xrt_distortion_vive *v = &a->vive;
+		set_params(out_data, 0, v->aspect_x_over_y, v->grow_for_undistort, 0.0f, 0.0f);
+		set_params(out_data, 1, v->center[0].x, v->center[0].y, v->center[1].x, v->center[1].y);
+		set_params(out_data, 2, v->center[2].x, v->center[2].y, 0.0f, 0.0f);
+		for (uint32_t i = 0; i < 3; i++) {
+			const float *k = v->coefficients[i];
+			set_params(out_data, 3 + i, k[0], k[1], k[2], k[3]);
+		}
+		break;
+	}
+	default: break;
+	}
+}
+
+
+/*
+ *
+ * Ellipsoid distortion generated on the GPU.
+ *
+ */
+
+/*!
+ * Matches the Config UBO in distortion_ellipsoid.comp.
+ */
+struct ellipsoid_ubo_data
+{
+	struct xrt_matrix_4x4 clip_to_world;
+	struct xrt_matrix_4x4 world_to_sphere;
+	struct xrt_matrix_4x4 sphere_to_world;
+	struct xrt_matrix_4x4 world_to_screen;
+	struct xrt_vec3 eye_position;
+	float _pad0;
+	struct xrt_vec3 screen_position;
+	float _pad1;
+	struct xrt_vec3 screen_forward;
+	float _pad2;
+	float axes[4];
+	struct xrt_matrix_2x2 rot;
+};
+
+struct ellipsoid_specialization_data
+{
+	int32_t distortion_texel_count;
+	int32_t iterations;
+};
+
+/*!
+ * Transient state for generating the distortion of both views on the GPU,
+ * only lives while the distortion images are created.
+ */
+struct ellipsoid_state
+{
+	VkDescriptorSetLayout descriptor_set_layout;
+	VkPipelineLayout pipeline_layout;
+	VkPipeline pipeline;
+	VkDescriptorPool descriptor_pool;
+	VkDescriptorSet descriptor_sets[2];
+
+	struct render_buffer ubos[2];
+
+	//! Render uv per texel, copied to the images of all channels.
+	struct render_buffer results[2];
+};
+
+static void
+ellipsoid_close(struct vk_bundle *vk, struct ellipsoid_state *es)
+{
+	// Frees the descriptor sets.
+	D(DescriptorPool, es->descriptor_pool);
+	D(Pipeline, es->pipeline);
+	D(PipelineLayout, es->pipeline_layout);
+	D(DescriptorSetLayout, es->descriptor_set_layout);
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(es->ubos); i++) {
+		render_buffer_close(vk, &es->ubos[i]);
+		render_buffer_close(vk, &es->results[i]);
+	}
+}
+
+static XRT_CHECK_RESULT VkResult
+ellipsoid_create_pipeline(struct render_resources *r, struct vk_bundle *vk, struct ellipsoid_state *es)
+{
+	VkResult ret;
+
+	VkDescriptorSetLayoutBinding set_layout_bindings[2] = {
+	    {
+	        .binding = 0,
+	        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+	        .descriptorCount = 1,
+	        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+	    },
+	    {
+	        .binding = 1,
+	        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+	        .descriptorCount = 1,
+	        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+	    },
+	};
+
+	VkDescriptorSetLayoutCreateInfo set_layout_info = {
+	    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+	    .bindingCount = ARRAY_SIZE(set_layout_bindings),
+	    .pBindings = set_layout_bindings,
+	};
+
+	ret = vk->vkCreateDescriptorSetLayout(vk->device, &set_layout_info, NULL, &es->descriptor_set_layout);
+	CG(vk, ret, "vkCreateDescriptorSetLayout", err);
+
+	ret = vk_create_pipeline_layout(vk, es->descriptor_set_layout, &es->pipeline_layout);
+	CG(vk, ret, "vk_create_pipeline_layout", err);
+
+	struct ellipsoid_specialization_data data = {
+	    .distortion_texel_count = COMP_DISTORTION_IMAGE_DIMENSIONS,
+	    .iterations = 50, // Same as the North Star driver.
+	};
+
+	VkSpecializationMapEntry entries[2] = {
+	    {
+	        .constantID = 0,
+	        .offset = offsetof(struct ellipsoid_specialization_data, distortion_texel_count),
+	        .size = sizeof(data.distortion_texel_count),
+	    },
+	    {
+	        .constantID = 1,
+	        .offset = offsetof(struct ellipsoid_specialization_data, iterations),
+	        .size = sizeof(data.iterations),
+	    },
+	};
+
+	VkSpecializationInfo specialization_info = {
+	    .mapEntryCount = ARRAY_SIZE(entries),
+	    .pMapEntries = entries,
+	    .dataSize = sizeof(data),
+	    .pData = &data,
+	};
+
+	ret = vk_create_compute_pipeline(          //
+	    vk,                                    // vk_bundle
+	    r->pipeline_cache,                     // pipeline_cache
+	    r->shaders->distortion_ellipsoid_comp, // shader
+	    es->pipeline_layout,                   // pipeline_layout
+	    &specialization_info,                  // specialization_info
+	    &es->pipeline);                        // out_compute_pipeline
+	CG(vk, ret, "vk_create_compute_pipeline", err);
+
+	struct vk_descriptor_pool_info pool_info = {
+	    .uniform_per_descriptor_count = 1,
+	    .storage_buffer_per_descriptor_count = 1,
+	    .descriptor_count = ARRAY_SIZE(es->descriptor_sets),
+	    .freeable = false,
+	};
+
+	ret = vk_create_descriptor_pool(vk, &pool_info, &es->descriptor_pool);
+	CG(vk, ret, "vk_create_descriptor_pool", err);
+
+	return VK_SUCCESS;
+
+err:
+	ellipsoid_close(vk, es);
+
+	return ret;
+}
+
+static XRT_CHECK_RESULT VkResult
+ellipsoid_init_view(
+    struct vk_bundle *vk, struct xrt_device *xdev, struct ellipsoid_state *es, uint32_t view, bool pre_rotate)
+{
+	const struct xrt_distortion_ellipsoid *e = &xdev->hmd->distortion.ellipsoid.views[view];
+	struct render_buffer *ubo = &es->ubos[view];
+	struct render_buffer *results = &es->results[view];
+	VkResult ret;
+
+	ret = render_buffer_init(                                                       //
+	    vk,                                                                         // vk_bundle
+	    ubo,                                                                        // buffer
+	    VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,                                         // usage_flags
+	    VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, // memory_property_flags
+	    sizeof(struct ellipsoid_ubo_data));                                         // size
+	CG(vk, ret, "render_buffer_init", err);
+
+	ret = render_buffer_init(                                                  //
+	    vk,                                                                    // vk_bundle
+	    results,                                                               // buffer
+	    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, // usage_flags
+	    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,                                   // memory_property_flags
+	    sizeof(struct texture));                                               // size
+	CG(vk, ret, "render_buffer_init", err);
+
+	struct ellipsoid_ubo_data data = {
+	    .clip_to_world = e->clip_to_world,
+	    .world_to_sphere = e->world_to_sphere,
+	    .sphere_to_world = e->sphere_to_world,
+	    .world_to_screen = e->world_to_screen,
+	    .eye_position = e->eye_position,
+	    .screen_position = e->screen_position,
+	    .screen_forward = e->screen_forward,
+	    .axes = {e->minor_axis, e->major_axis, 0.0f, 0.0f},
+	};
+	calc_view_rot(xdev, view, pre_rotate, &data.rot);
+
+	ret = render_buffer_write(vk, ubo, &data, sizeof(data));
+	CG(vk, ret, "render_buffer_write", err);
+
+	ret = vk_create_descriptor_set(vk, es->descriptor_pool, es->descriptor_set_layout, &es->descriptor_sets[view]);
+	CG(vk, ret, "vk_create_descriptor_set", err);
+
+	VkDescriptorBufferInfo buffer_infos[2] = {
+	    {
+	        .buffer = ubo->buffer,
+	        .offset = 0,
+	        .range = sizeof(struct ellipsoid_ubo_data),
+	    },
+	    {
+	        .buffer = results->buffer,
+	        .offset = 0,
+	        .range = sizeof(struct texture),
+	    },
+	};
+
+	VkWriteDescriptorSet write_descriptor_sets[2] = {
+	    {
+	        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+	        .dstSet = es->descriptor_sets[view],
+	        .dstBinding = 0,
+	        .descriptorCount = 1,
+	        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+	        .pBufferInfo = &buffer_infos[0],
+	    },
+	    {
+	        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+	        .dstSet = es->descriptor_sets[view],
+	        .dstBinding = 1,
+	        .descriptorCount = 1,
+	        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+	        .pBufferInfo = &buffer_infos[1],
+	    },
+	};
+
+	vk->vkUpdateDescriptorSets(            //
+	    vk->device,                        // device
+	    ARRAY_SIZE(write_descriptor_sets), // descriptorWriteCount
+	    write_descriptor_sets,             // pDescriptorWrites
+	    0,                                 // descriptorCopyCount
+	    NULL);                             // pDescriptorCopies
+
+	return VK_SUCCESS;
+
+err:
+	// The caller closes the state.
+	return ret;
+}
+
+static XRT_CHECK_RESULT VkResult
+ellipsoid_init(struct render_resources *r,
+               struct vk_bundle *vk,
+               struct xrt_device *xdev,
+               bool pre_rotate,
+               struct ellipsoid_state *es)
+{
+	VkResult ret;
+
+	ret = ellipsoid_create_pipeline(r, vk, es);
+	if (ret != VK_SUCCESS) {
+		return ret;
+	}
+
+	for (uint32_t view = 0; view < 2; view++) {
+		ret = ellipsoid_init_view(vk, xdev, es, view, pre_rotate);
+		if (ret != VK_SUCCESS) {
+			ellipsoid_close(vk, es);
+			return ret;
+		}
+	}
+
+	return VK_SUCCESS;
+}
+
+static void
+ellipsoid_dispatch_locked(struct vk_bundle *vk, VkCommandBuffer cmd, struct ellipsoid_state *es)
+{
+	const uint32_t groups = (COMP_DISTORTION_IMAGE_DIMENSIONS + 7) / 8;
+
+	vk->vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, es->pipeline);
+
+	for (uint32_t view = 0; view < 2; view++) {
+		vk->vkCmdBindDescriptorSets(        //
+		    cmd,                            // commandBuffer
+		    VK_PIPELINE_BIND_POINT_COMPUTE, // pipelineBindPoint
+		    es->pipeline_layout,            // layout
+		    0,                              // firstSet
+		    1,                              // descriptorSetCount
+		    &es->descriptor_sets[view],     // pDescriptorSets
+		    0,                              // dynamicOffsetCount
+		    NULL);                          // pDynamicOffsets
+
+		vk->vkCmdDispatch(cmd, groups, groups, 1);
+	}
+
+	// The results are copied into the images next.
+	VkMemoryBarrier memory_barrier = {
+	    .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+	    .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+	    .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+	};
+
+	vk->vkCmdPipelineBarrier(                 //
+	    cmd,                                  // commandBuffer
+	    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, // srcStageMask
+	    VK_PIPELINE_STAGE_TRANSFER_BIT,       // dstStageMask
+	    0,                                    // dependencyFlags
+	    1,                                    // memoryBarrierCount
+	    &memory_barrier,                      // pMemoryBarriers
+	    0,                                    // bufferMemoryBarrierCount
+	    NULL,                                 // pBufferMemoryBarriers
+	    0,                                    // imageMemoryBarrierCount
+	    NULL);                                // pImageMemoryBarriers
+}
+
 static bool
 render_distortion_buffer_init(struct render_resources *r,
                               struct vk_bundle *vk,
                               struct xrt_device *xdev,
                               bool pre_rotate)
 {
-	struct render_buffer bufs[COMP_DISTORTION_NUM_IMAGES];
-	VkDeviceMemory device_memories[COMP_DISTORTION_NUM_IMAGES];
-	VkImage images[COMP_DISTORTION_NUM_IMAGES];
-	VkImageView image_views[COMP_DISTORTION_NUM_IMAGES];
+	struct render_buffer bufs[COMP_DISTORTION_NUM_IMAGES] = {0};
+	VkDeviceMemory device_memories[COMP_DISTORTION_NUM_IMAGES] = {0};
+	VkImage images[COMP_DISTORTION_NUM_IMAGES] = {0};
+	VkImageView image_views[COMP_DISTORTION_NUM_IMAGES] = {0};
+	VkBuffer src_buffers[COMP_DISTORTION_NUM_IMAGES] = {0};
+	struct ellipsoid_state es = {0};
 	VkCommandBuffer upload_buffer = VK_NULL_HANDLE;
 	VkResult ret;
 
@@ -374,14 +745,37 @@ render_distortion_buffer_init(struct render_resources *r,
 
 
 	/*
-	 * Buffers with data to upload.
+	 * Buffers with data to upload, either generated on the GPU, which
+	 * takes milliseconds where the CPU can take seconds, or on the CPU.
 	 */
 
-	ret = create_and_fill_in_distortion_buffer_for_view(vk, xdev, &bufs[0], &bufs[2], &bufs[4], 0, pre_rotate);
-	CG(vk, ret, "create_and_fill_in_distortion_buffer_for_view", err_resources);
+	bool use_gpu = xdev->hmd->distortion.ellipsoid.valid && debug_get_bool_option_gpu_distortion();
+	if (use_gpu) {
+		ret = ellipsoid_init(r, vk, xdev, pre_rotate, &es);
+		if (ret != VK_SUCCESS) {
+			VK_WARN(vk, "Failed to generate distortion on the GPU, falling back to the CPU");
+			use_gpu = false;
+		}
+	}
 
-	ret = create_and_fill_in_distortion_buffer_for_view(vk, xdev, &bufs[1], &bufs[3], &bufs[5], 1, pre_rotate);
-	CG(vk, ret, "create_and_fill_in_distortion_buffer_for_view", err_resources);
+	if (use_gpu) {
+		// No chromatic aberration, all channels come from the same results.
+		for (uint32_t i = 0; i < COMP_DISTORTION_NUM_IMAGES; i++) {
+			src_buffers[i] = es.results[i % 2].buffer;
+		}
+	} else {
+		ret = create_and_fill_in_distortion_buffer_for_view(vk, xdev, &bufs[0], &bufs[2], &bufs[4], 0,
+		                                                    pre_rotate);
+		CG(vk, ret, "create_and_fill_in_distortion_buffer_for_view", err_resources);
+
+		ret = create_and_fill_in_distortion_buffer_for_view(vk, xdev, &bufs[1], &bufs[3], &bufs[5], 1,
+		                                                    pre_rotate);
+		CG(vk, ret, "create_and_fill_in_distortion_buffer_for_view", err_resources);
+
+		for (uint32_t i = 0; i < COMP_DISTORTION_NUM_IMAGES; i++) {
+			src_buffers[i] = bufs[i].buffer;
+		}
+	}
 
 
 	/*
@@ -395,12 +789,16 @@ render_distortion_buffer_init(struct render_resources *r,
 	ret = vk_cmd_pool_create_and_begin_cmd_buffer_locked(vk, pool, 0, &upload_buffer);
 	CG(vk, ret, "vk_cmd_pool_create_and_begin_cmd_buffer_locked", err_unlock);
 
+	if (use_gpu) {
+		ellipsoid_dispatch_locked(vk, upload_buffer, &es);
+	}
+
 	for (uint32_t i = 0; i < COMP_DISTORTION_NUM_IMAGES; i++) {
 		ret = create_and_queue_upload_locked( //
 		    vk,                               // vk_bundle
 		    pool,                             // pool
 		    upload_buffer,                    // cmd
-		    bufs[i].buffer,                   // src_buffer
+		    src_buffers[i],                   // src_buffer
 		    &device_memories[i],              // out_image_device_memory
 		    &images[i],                       // out_image
 		    &image_views[i]);                 // out_image_view
@@ -417,6 +815,9 @@ render_distortion_buffer_init(struct render_resources *r,
 	 */
 
 	r->distortion.pre_rotated = pre_rotate;
+	r->distortion.ellipsoid_generation = xdev->hmd->distortion.ellipsoid.generation;
+	calc_analytic_view(xdev, 0, pre_rotate, &r->distortion.analytic[0]);
+	calc_analytic_view(xdev, 1, pre_rotate, &r->distortion.analytic[1]);
 
 	for (uint32_t i = 0; i < COMP_DISTORTION_NUM_IMAGES; i++) {
 		r->distortion.device_memories[i] = device_memories[i];
@@ -432,6 +833,7 @@ render_distortion_buffer_init(struct render_resources *r,
 	for (uint32_t i = 0; i < COMP_DISTORTION_NUM_IMAGES; i++) {
 		render_buffer_close(vk, &bufs[i]);
 	}
+	ellipsoid_close(vk, &es);
 
 	return true;
 
@@ -449,6 +851,7 @@ err_resources:
 		DF(Memory, device_memories[i]);
 		render_buffer_close(vk, &bufs[i]);
 	}
+	ellipsoid_close(vk, &es);
 
 	return false;
 }
@@ -474,6 +877,9 @@ render_distortion_images_close(struct render_resources *r)
 		D(Image, r->distortion.images[i]);
 		DF(Memory, r->distortion.device_memories[i]);
 	}
+
+	// New views can get the same handles, make sure they are written.
+	r->compute.distortion.written.valid = false;
 }
 
 bool
@@ -482,7 +888,11 @@ render_distortion_images_ensure(struct render_resources *r,
                                 struct xrt_device *xdev,
                                 bool pre_rotate)
 {
-	if (r->distortion.image_views[0] == VK_NULL_HANDLE || pre_rotate != r->distortion.pre_rotated) {
+	bool ellipsoid_changed = xdev->hmd->distortion.ellipsoid.valid &&
+	                         xdev->hmd->distortion.ellipsoid.generation != r->distortion.ellipsoid_generation;
+
+	if (r->distortion.image_views[0] == VK_NULL_HANDLE || pre_rotate != r->distortion.pre_rotated ||
+	    ellipsoid_changed) {
 		render_distortion_images_close(r);
 		return render_distortion_buffer_init(r, vk, xdev, pre_rotate);
 	}
@@ -218,6 +218,7 @@ create_mesh_pipeline(struct vk_bundle *vk,
                      uint32_t src_binding,
                      uint32_t mesh_index_count_total,
                      uint32_t mesh_stride,
+                     bool single_channel,
                      VkShaderModule mesh_vert,
                      VkShaderModule mesh_frag,
                      VkPipeline *out_mesh_pipeline)
@@ -330,6 +331,24 @@ create_mesh_pipeline(struct vk_bundle *vk,
 	};
 	// clang-format on
 
+	// Sample the source once instead of per channel, see mesh.frag.
+	VkBool32 frag_single_channel = single_channel;
+
+	VkSpecializationMapEntry frag_entries[1] = {
+	    {
+	        .constantID = 0,
+	        .offset = 0,
+	        .size = sizeof(frag_single_channel),
+	    },
+	};
+
+	VkSpecializationInfo frag_specialization_info = {
+	    .mapEntryCount = ARRAY_SIZE(frag_entries),
+	    .pMapEntries = frag_entries,
+	    .dataSize = sizeof(frag_single_channel),
+	    .pData = &frag_single_channel,
+	};
+
 	VkPipelineShaderStageCreateInfo shader_stages[2] = {
 	    {
 	        .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
@@ -342,6 +361,7 @@ create_mesh_pipeline(struct vk_bundle *vk,
 	        .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
 	        .module = mesh_frag,
 	        .pName = "main",
+	        .pSpecializationInfo = &frag_specialization_info,
 	    },
 	};
 
@@ -453,16 +473,17 @@ render_gfx_target_resources_init(struct render_gfx_target_resources *rtr,
 	    data->format,              // target_format
 	    &rtr->render_pass));       // out_render_pass
 
-	C(create_mesh_pipeline(vk,                        // vk_bundle
-	                       rtr->render_pass,          // render_pass
-	                       r->mesh.pipeline_layout,   // pipeline_layout
-	                       r->pipeline_cache,         // pipeline_cache
-	                       r->mesh.src_binding,       // src_binding
-	                       r->mesh.index_count_total, // mesh_index_count_total
-	                       r->mesh.stride,            // mesh_stride
-	                       r->shaders->mesh_vert,     // mesh_vert
-	                       r->shaders->mesh_frag,     // mesh_frag
-	                       &rtr->mesh.pipeline));     // out_mesh_pipeline
+	C(create_mesh_pipeline(vk,                           // vk_bundle
+	                       rtr->render_pass,             // render_pass
+	                       r->mesh.pipeline_layout,      // pipeline_layout
+	                       r->pipeline_cache,            // pipeline_cache
+	                       r->mesh.src_binding,          // src_binding
+	                       r->mesh.index_count_total,    // mesh_index_count_total
+	                       r->mesh.stride,               // mesh_stride
+	                       r->distortion.single_channel, // single_channel
+	                       r->shaders->mesh_vert,        // mesh_vert
+	                       r->shaders->mesh_frag,        // mesh_frag
+	                       &rtr->mesh.pipeline));        // out_mesh_pipeline
 
 	C(create_framebuffer(vk,                  // vk_bundle,
 	                     target,              // image_view,
@@ -533,17 +554,7 @@ render_gfx_begin(struct render_gfx *rr)
 	    rr->r->cmd,             // commandBuffer
 	    &begin_info));          // pBeginInfo
 
-	vk->vkCmdResetQueryPool( //
-	    rr->r->cmd,          // commandBuffer
-	    rr->r->query_pool,   // queryPool
-	    0,                   // firstQuery
-	    2);                  // queryCount
-
-	vk->vkCmdWriteTimestamp(               //
-	    rr->r->cmd,                        // commandBuffer
-	    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, // pipelineStage
-	    rr->r->query_pool,                 // queryPool
-	    0);                                // query
+	render_resources_begin_timestamps(rr->r, rr->r->cmd);
 
 	return true;
 }
@@ -553,11 +564,7 @@ render_gfx_end(struct render_gfx *rr)
 {
 	struct vk_bundle *vk = vk_from_rr(rr);
 
-	vk->vkCmdWriteTimestamp(                  //
-	    rr->r->cmd,                           // commandBuffer
-	    VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, // pipelineStage
-	    rr->r->query_pool,                    // queryPool
-	    1);                                   // query
+	render_resources_write_timestamp(rr->r, rr->r->cmd, RENDER_TIMESTAMP_POINT_END);
 
 	C(vk->vkEndCommandBuffer(rr->r->cmd));
 
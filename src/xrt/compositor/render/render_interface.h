@@ -10,12 +10,18 @@
 
 #pragma once
 
-#define COMP_MAX_LAYERS 16
+//! Max layers squashed by a single dispatch of the compute layer shader.
+#define RENDER_MAX_LAYERS 16
 #define COMP_VIEWS_PER_LAYER 2
-#define COMP_MAX_IMAGES 32
+//! Max images sampled by a single dispatch of the compute layer shader.
+#define RENDER_MAX_IMAGES 32
+//! Max dispatches the compute layer squasher splits the layers of a frame over.
+#define RENDER_MAX_LAYER_PASSES 8
 
 #include "xrt/xrt_compiler.h"
 #include "xrt/xrt_defines.h"
+#include "xrt/xrt_device.h"
+#include "xrt/xrt_compositor.h"
 
 #include "vk/vk_helpers.h"
 #include "vk/vk_cmd_pool.h"
@@ -67,6 +73,24 @@ render_calc_time_warp_matrix(const struct xrt_pose *src_pose,
                              const struct xrt_pose *new_pose,
                              struct xrt_matrix_4x4 *matrix);
 
+/*!
+ * Calculates a matrix that takes points in the space of the eye at
+ * @p new_pose to the space of the eye at @p src_pose, includes translation.
+ * Used together with the depth of the source for positional timewarp.
+ */
+void
+render_calc_reprojection_matrix(const struct xrt_pose *src_pose,
+                                const struct xrt_pose *new_pose,
+                                struct xrt_matrix_4x4 *matrix);
+
+/*!
+ * Packs the depth range of a depth layer so the shader can turn a sampled
+ * depth value d into a positive linear depth with `x / (y + d * z)`, handles
+ * reversed and infinite ranges.
+ */
+void
+render_calc_depth_params(const struct xrt_layer_depth_data *depth, float out_params[4]);
+
 
 /*
  *
@@ -83,6 +107,7 @@ struct render_shaders
 	VkShaderModule clear_comp;
 	VkShaderModule layer_comp;
 	VkShaderModule distortion_comp;
+	VkShaderModule distortion_ellipsoid_comp;
 
 	VkShaderModule mesh_vert;
 	VkShaderModule mesh_frag;
@@ -199,6 +224,76 @@ render_buffer_write(struct vk_bundle *vk, struct render_buffer *buffer, void *da
  *
  */
 
+/*!
+ * Fixed foveation parameters of one view, a std140 vec4 in the compute shader
+ * UBOs, see @ref xrt_hmd_parts::foveation.
+ */
+struct render_compute_foveation_data
+{
+	struct xrt_vec2 center;
+	float inner_radius;
+	float outer_radius;
+};
+
+/*!
+ * Parameters of an analytic distortion model for one view, packed the way
+ * distortion.comp reads them, see @ref xrt_distortion_analytic_model.
+ */
+struct render_compute_distortion_analytic_data
+{
+	//! Rotation of the view around its centre, row major.
+	struct xrt_matrix_2x2 rot;
+
+	//! Model specific, see distortion.comp.
+	struct
+	{
+		float values[4];
+	} params[6];
+};
+
+//! Frames of GPU timestamps in flight, they can be read back this many frames later at most.
+#define RENDER_TIMESTAMP_FRAME_COUNT (4)
+
+/*!
+ * Points in the command buffer of a frame that GPU timestamps are written at.
+ */
+enum render_timestamp_point
+{
+	//! Start of the command buffer, written by the begin functions.
+	RENDER_TIMESTAMP_POINT_BEGIN,
+
+	//! The layers have been squashed into the scratch images.
+	RENDER_TIMESTAMP_POINT_LAYERS,
+
+	//! The distortion, or the fast path, has been written to the target.
+	RENDER_TIMESTAMP_POINT_DISTORTION,
+
+	//! End of the command buffer, written by the end functions.
+	RENDER_TIMESTAMP_POINT_END,
+
+	RENDER_TIMESTAMP_POINT_COUNT,
+};
+
+/*!
+ * GPU timestamps of one frame, see @ref render_resources_get_frame_timestamps.
+ */
+struct render_frame_timestamps
+{
+	//! The @ref render_resources::timestamps frame id when the frame was begun.
+	int64_t frame_id;
+
+	//! Bitmask of the points that were written, the others are zero.
+	uint32_t written;
+
+	/*!
+	 * Are the points in the time domain of @ref os_monotonic_get_ns,
+	 * otherwise only the differences between them are meaningful.
+	 */
+	bool host_time;
+
+	uint64_t points_ns[RENDER_TIMESTAMP_POINT_COUNT];
+};
+
 /*!
  * Holds all pools and static resources for rendering.
  */
@@ -227,7 +322,32 @@ struct render_resources
 
 	VkCommandPool cmd_pool;
 
-	VkQueryPool query_pool;
+	//! GPU timestamps of the last few frames, read back without waiting.
+	struct
+	{
+		//! @ref RENDER_TIMESTAMP_POINT_COUNT queries for each of the frames.
+		VkQueryPool pool;
+
+		//! Set by the user before the begin functions, given back with the timestamps.
+		int64_t frame_id;
+
+		//! Frames begun, the slot of a frame is this modulo @ref RENDER_TIMESTAMP_FRAME_COUNT.
+		uint64_t frame_count;
+
+		//! Raw begin timestamp of the frame last read back, to spot stale results.
+		uint64_t last_begin_ticks;
+
+		struct
+		{
+			int64_t frame_id;
+
+			//! Bitmask of the points written.
+			uint32_t written;
+
+			//! Recorded but not read back yet.
+			bool pending;
+		} slots[RENDER_TIMESTAMP_FRAME_COUNT];
+	} timestamps;
 
 
 	/*
@@ -250,6 +370,13 @@ struct render_resources
 
 		//! Sampler that clamps color samples to black in all directions.
 		VkSampler clamp_to_border_black;
+
+		/*!
+		 * Sampler that clamps to the edge and can use all mip levels, the
+		 * others are limited to the first one. The shader has to give the
+		 * level explicitly, there are no derivatives in compute.
+		 */
+		VkSampler clamp_to_edge_mip;
 	} samplers;
 
 	struct
@@ -296,6 +423,35 @@ struct render_resources
 			VkImageView srgb_view;
 			VkImageView unorm_view;
 		} color;
+
+		/*!
+		 * Layers that have not changed squashed ahead of time, same
+		 * layout as @p color. Holds premultiplied alpha, written
+		 * through the unorm view with sRGB encoding and sampled
+		 * through the sRGB view, to keep the precision in the darks.
+		 */
+		struct
+		{
+			VkDeviceMemory memory;
+			VkImage image;
+			VkImageView srgb_view;
+			VkImageView unorm_view;
+		} cache;
+
+		/*!
+		 * When the layers don't fit in one dispatch they are squashed
+		 * in passes, each pass samples the result of the previous one
+		 * the same way as @p cache, ping-ponging between this image
+		 * and @p color. Only created when first needed, see
+		 * @ref render_ensure_scratch_pass_image.
+		 */
+		struct
+		{
+			VkDeviceMemory memory;
+			VkImage image;
+			VkImageView srgb_view;
+			VkImageView unorm_view;
+		} pass;
 	} scratch;
 
 	/*!
@@ -343,11 +499,23 @@ struct render_resources
 			//! Doesn't depend on target so is static.
 			VkPipeline timewarp_pipeline;
 
+			//! Only samples a single projection layer, skips the layer loop and blending.
+			VkPipeline single_projection_pipeline;
+
+			//! Same as @ref single_projection_pipeline but with timewarp.
+			VkPipeline single_projection_timewarp_pipeline;
+
 			//! Size of combined image sampler array
 			uint32_t image_array_size;
 
 			//! Target info.
 			struct render_buffer ubo;
+
+			//! Target info for squashing into the layer cache.
+			struct render_buffer cache_ubo;
+
+			//! Target info for all but the first pass, see @ref render_compute_layers_pass.
+			struct render_buffer pass_ubos[RENDER_MAX_LAYER_PASSES - 1];
 		} layer;
 
 		struct
@@ -366,6 +534,30 @@ struct render_resources
 
 			//! Target info.
 			struct render_buffer ubo;
+
+			//! Pool for @ref descriptor_set, not reset every frame.
+			VkDescriptorPool descriptor_pool;
+
+			/*!
+			 * Descriptor set shared between distortion and clear that
+			 * lives across frames, so the distortion image and UBO
+			 * bindings only need to be written when they change.
+			 */
+			VkDescriptorSet descriptor_set;
+
+			/*!
+			 * What the distortion image and UBO bindings of
+			 * @ref descriptor_set were last written with, the source
+			 * and target bindings are always written as their views
+			 * come from swapchains whose handles can be reused.
+			 */
+			struct
+			{
+				VkSampler samplers[6];
+				VkImageView image_views[6];
+				VkBuffer ubo_buffer;
+				bool valid;
+			} written;
 		} distortion;
 
 		struct
@@ -378,6 +570,19 @@ struct render_resources
 
 			//! @todo other resources
 		} clear;
+
+		//! Foveation of the layer and distortion shaders.
+		struct
+		{
+			//! Are the pipelines created with foveation enabled.
+			bool enabled;
+
+			//! Copied into the UBOs, the centres may be moved every frame to follow the gaze.
+			struct render_compute_foveation_data views[2];
+
+			//! The centres from the device or env variables, used when there is no gaze.
+			struct xrt_vec2 fixed_centers[2];
+		} foveation;
 	} compute;
 
 	struct
@@ -396,6 +601,24 @@ struct render_resources
 
 		//! Whether distortion images have been pre-rotated 90 degrees.
 		bool pre_rotated;
+
+		//! The xrt_hmd_parts ellipsoid generation the images were made from.
+		uint32_t ellipsoid_generation;
+
+		/*!
+		 * Model the compute distortion pipelines evaluate in the shader,
+		 * none if they sample the distortion images.
+		 */
+		enum xrt_distortion_analytic_model analytic_model;
+
+		//! Parameters of @ref analytic_model, for the current rotation.
+		struct render_compute_distortion_analytic_data analytic[2];
+
+		/*!
+		 * The device has no chromatic aberration, the distortion and
+		 * mesh pipelines sample the source once instead of per channel.
+		 */
+		bool single_channel;
 	} distortion;
 };
 
@@ -442,14 +665,50 @@ bool
 render_ensure_scratch_image(struct render_resources *r, VkExtent2D extent);
 
 /*!
- * Returns the timestamps for when the latest GPU work started and stopped that
- * was submitted using @ref render_gfx or @ref render_compute cmd buf builders.
+ * Ensure that the scratch pass image is created, with the same extent as the
+ * scratch image which must already have been created.
+ */
+bool
+render_ensure_scratch_pass_image(struct render_resources *r);
+
+/*!
+ * Starts the timestamps of a new frame in @p cmd, reusing the slot of the
+ * oldest frame in the ring and writing @ref RENDER_TIMESTAMP_POINT_BEGIN.
+ * Called by the begin functions of @ref render_gfx and @ref render_compute.
+ *
+ * @public @memberof render_resources
+ */
+void
+render_resources_begin_timestamps(struct render_resources *r, VkCommandBuffer cmd);
+
+/*!
+ * Writes the timestamp of @p point of the current frame into @p cmd, taken
+ * when all of the commands recorded before it have completed.
+ *
+ * @public @memberof render_resources
+ */
+void
+render_resources_write_timestamp(struct render_resources *r, VkCommandBuffer cmd, enum render_timestamp_point point);
+
+/*!
+ * Gets the timestamps of the newest frame that the GPU has completed and
+ * that hasn't been returned before, older frames are skipped. Never waits on
+ * the GPU, so the timestamps of a frame show up one or a few frames after it
+ * was submitted. Returns false if there is no such frame.
+ *
+ * See the limitations mentioned for @ref vk_convert_timestamps_to_host_ns.
+ *
+ * @public @memberof render_resources
+ */
+bool
+render_resources_get_frame_timestamps(struct render_resources *r, struct render_frame_timestamps *out_timestamps);
+
+/*!
+ * Returns the timestamps for when the newest completed GPU work started and
+ * stopped that was submitted using @ref render_gfx or @ref render_compute cmd
+ * buf builders, see @ref render_resources_get_frame_timestamps.
  *
  * Returned in the same time domain as returned by @ref os_monotonic_get_ns .
- * Behaviour for this function is undefined if the GPU has not completed before
- * calling this function, so make sure to call vkQueueWaitIdle or wait on the
- * fence that the work was submitted with have fully completed. See other
- * limitation mentioned for @ref vk_convert_timestamps_to_host_ns .
  *
  * @see vk_convert_timestamps_to_host_ns
  *
@@ -459,12 +718,9 @@ bool
 render_resources_get_timestamps(struct render_resources *r, uint64_t *out_gpu_start_ns, uint64_t *out_gpu_end_ns);
 
 /*!
- * Returns the duration for the latest GPU work that was submitted using
- * @ref render_gfx or @ref render_compute cmd buf builders.
- *
- * Behaviour for this function is undefined if the GPU has not completed before
- * calling this function, so make sure to call vkQueueWaitIdle or wait on the
- * fence that the work was submitted with have fully completed.
+ * Returns the duration for the newest completed GPU work that was submitted
+ * using @ref render_gfx or @ref render_compute cmd buf builders, see
+ * @ref render_resources_get_frame_timestamps.
  *
  * @public @memberof render_resources
  */
@@ -740,6 +996,12 @@ struct render_compute
 
 	//! Descriptor set for distortion.
 	VkDescriptorSet distortion_descriptor_set;
+
+	//! Descriptor set for squashing into the layer cache.
+	VkDescriptorSet cache_descriptor_set;
+
+	//! Descriptor sets for all but the first layer squashing pass.
+	VkDescriptorSet pass_descriptor_sets[RENDER_MAX_LAYER_PASSES - 1];
 };
 
 /*!
@@ -751,6 +1013,12 @@ struct render_compute_blit_push_data
 	struct xrt_rect target_rect;
 };
 
+/*!
+ * Not a @ref xrt_layer_type, the layer samples the layer cache image with the
+ * same layout as the target, must match LAYER_CACHED in layer.comp.
+ */
+#define RENDER_COMPUTE_LAYER_TYPE_CACHED (255)
+
 /*!
  * UBO data that is sent to the compute layer shaders.
  *
@@ -760,15 +1028,20 @@ struct render_compute_layer_ubo_data
 {
 	struct render_viewport_data views[2];
 	struct xrt_normalized_rect pre_transforms[2];
-	struct xrt_normalized_rect post_transforms[COMP_MAX_LAYERS * COMP_VIEWS_PER_LAYER];
+	struct xrt_normalized_rect post_transforms[RENDER_MAX_LAYERS * COMP_VIEWS_PER_LAYER];
 
-	//! std140 uvec2, corresponds to enum xrt_layer_type and unpremultiplied alpha.
+	//! std140 uvec4, corresponds to enum xrt_layer_type, unpremultiplied alpha and view mask.
 	struct
 	{
 		uint32_t val;
 		uint32_t unpremultiplied;
-		uint32_t padding[2];
-	} layer_type[COMP_MAX_LAYERS];
+
+		//! Bit per view the layer is visible in, only used by cylinder, equirect2 and cube layers.
+		uint32_t view_mask;
+
+		//! Projection depth layer with positional timewarp, only used with the timewarp pipeline.
+		uint32_t depth_reprojection;
+	} layer_type[RENDER_MAX_LAYERS];
 
 	//! Which image/sampler(s) correspond to each layer.
 	struct
@@ -776,7 +1049,7 @@ struct render_compute_layer_ubo_data
 		uint32_t images[2];
 		//! @todo Implement separated samplers and images (and change to samplers[2])
 		uint32_t padding[2];
-	} images_samplers[COMP_MAX_LAYERS * 2];
+	} images_samplers[RENDER_MAX_LAYERS * 2];
 
 
 	/*!
@@ -784,7 +1057,7 @@ struct render_compute_layer_ubo_data
 	 */
 
 	//! Timewarp matrices
-	struct xrt_matrix_4x4 transforms[COMP_MAX_LAYERS * COMP_VIEWS_PER_LAYER];
+	struct xrt_matrix_4x4 transforms[RENDER_MAX_LAYERS * COMP_VIEWS_PER_LAYER];
 
 
 	/*!
@@ -796,20 +1069,62 @@ struct render_compute_layer_ubo_data
 	{
 		struct xrt_vec3 val;
 		float padding;
-	} quad_position[COMP_MAX_LAYERS * 2];
+	} quad_position[RENDER_MAX_LAYERS * 2];
 	struct
 	{
 		struct xrt_vec3 val;
 		float padding;
-	} quad_normal[COMP_MAX_LAYERS * 2];
-	struct xrt_matrix_4x4 inverse_quad_transform[COMP_MAX_LAYERS * 2];
+	} quad_normal[RENDER_MAX_LAYERS * 2];
+	struct xrt_matrix_4x4 inverse_quad_transform[RENDER_MAX_LAYERS * 2];
 
 	//! Quad extent in world scale
 	struct
 	{
 		struct xrt_vec2 val;
 		float padding[2];
-	} quad_extent[COMP_MAX_LAYERS];
+	} quad_extent[RENDER_MAX_LAYERS];
+
+	/*!
+	 * Cylinder: radius, central angle and aspect ratio.
+	 * Equirect2: radius, zero if infinite, central horizontal, upper vertical
+	 * and lower vertical angles.
+	 *
+	 * Cylinder, equirect2 and cube layers also use inverse_quad_transform to
+	 * go from view space to layer space.
+	 */
+	struct
+	{
+		float values[4];
+	} shape[RENDER_MAX_LAYERS];
+
+	/*!
+	 * Tangents of the source fov: left, up, right - left and down - up.
+	 *
+	 * Projection depth layers with depth_reprojection set also use
+	 * inverse_quad_transform to go from the new eye to the source eye.
+	 */
+	struct xrt_normalized_rect src_tangents[RENDER_MAX_LAYERS * COMP_VIEWS_PER_LAYER];
+
+	/*!
+	 * Linear depth from the sampled depth value d is x / (y + d * z), see
+	 * @ref render_calc_depth_params.
+	 */
+	struct
+	{
+		float values[4];
+	} depth_params[RENDER_MAX_LAYERS * COMP_VIEWS_PER_LAYER];
+
+	/*!
+	 * Rectangle in view uv space outside of which the layer is transparent:
+	 * min x, min y, max x and max y. Work groups outside of it skip the layer.
+	 */
+	struct
+	{
+		float values[4];
+	} view_bounds[RENDER_MAX_LAYERS * COMP_VIEWS_PER_LAYER];
+
+	//! Only used if foveation is enabled.
+	struct render_compute_foveation_data foveation[2];
 };
 
 /*!
@@ -823,6 +1138,12 @@ struct render_compute_distortion_ubo_data
 	struct xrt_normalized_rect pre_transforms[2];
 	struct xrt_normalized_rect post_transforms[2];
 	struct xrt_matrix_4x4 transforms[2];
+
+	//! Only used if foveation is enabled.
+	struct render_compute_foveation_data foveation[2];
+
+	//! Only used if the distortion is evaluated analytically.
+	struct render_compute_distortion_analytic_data analytic[2];
 };
 
 /*!
@@ -863,14 +1184,55 @@ render_compute_end(struct render_compute *crc);
  * @public @memberof render_compute
  */
 void
-render_compute_layers(struct render_compute *crc,                   //
-                      VkSampler src_samplers[COMP_MAX_IMAGES],      //
-                      VkImageView src_image_views[COMP_MAX_IMAGES], //
-                      uint32_t image_count,                         //
-                      VkImage target_image,                         //
-                      VkImageView target_image_view,                //
-                      VkImageLayout transition_to,                  //
-                      bool timewarp);                               //
+render_compute_layers(struct render_compute *crc,                     //
+                      VkSampler src_samplers[RENDER_MAX_IMAGES],      //
+                      VkImageView src_image_views[RENDER_MAX_IMAGES], //
+                      uint32_t image_count,                           //
+                      VkImage target_image,                           //
+                      VkImageView target_image_view,                  //
+                      VkImageLayout transition_to,                    //
+                      bool timewarp);                                 //
+
+/*!
+ * Squash the layers described by the
+ * @ref render_resources::compute::layer::cache_ubo into the
+ * @ref render_resources::scratch::cache image, ready to be sampled by a
+ * following @ref render_compute_layers using the @ref
+ * RENDER_COMPUTE_LAYER_TYPE_CACHED layer type. Never does timewarp.
+ *
+ * @public @memberof render_compute
+ */
+void
+render_compute_layers_to_cache(struct render_compute *crc,                     //
+                               VkSampler src_samplers[RENDER_MAX_IMAGES],      //
+                               VkImageView src_image_views[RENDER_MAX_IMAGES], //
+                               uint32_t image_count);                          //
+
+/*!
+ * Squash the layers described by the UBO of pass @p pass_index into
+ * @p target_image, for when the layers of a frame don't fit in one dispatch.
+ * Pass zero uses the same UBO and descriptor set as @ref render_compute_layers,
+ * the others use @ref render_resources::compute::layer::pass_ubos at
+ * @p pass_index minus one. The target is transitioned to @p transition_to and
+ * made visible to later compute shaders, so the next pass can sample it with
+ * the @ref RENDER_COMPUTE_LAYER_TYPE_CACHED layer type.
+ *
+ * If @p single_projection is set the only layer in the UBO is a projection
+ * layer at index zero, a pipeline specialised for that is used.
+ *
+ * @public @memberof render_compute
+ */
+void
+render_compute_layers_pass(struct render_compute *crc,                     //
+                           uint32_t pass_index,                            //
+                           VkSampler src_samplers[RENDER_MAX_IMAGES],      //
+                           VkImageView src_image_views[RENDER_MAX_IMAGES], //
+                           uint32_t image_count,                           //
+                           VkImage target_image,                           //
+                           VkImageView target_image_view,                  //
+                           VkImageLayout transition_to,                    //
+                           bool timewarp,                                  //
+                           bool single_projection);                        //
 
 /*!
  * @public @memberof render_compute
@@ -12,9 +12,26 @@
 #include "math/m_api.h"
 #include "math/m_matrix_2x2.h"
 #include "math/m_vec2.h"
+#include "os/os_time.h"
+#include "util/u_debug.h"
+#include "util/u_time.h"
+#include "util/u_worker.h"
 #include "render/render_interface.h"
 
 #include <stdio.h>
+#include <assert.h>
+#include <string.h>
+
+
+DEBUG_GET_ONCE_BOOL_OPTION(compute_foveation, "XRT_COMPOSITOR_COMPUTE_FOVEATION", true)
+DEBUG_GET_ONCE_FLOAT_OPTION(compute_foveation_inner, "XRT_COMPOSITOR_COMPUTE_FOVEATION_INNER_RADIUS", 0.0f)
+DEBUG_GET_ONCE_FLOAT_OPTION(compute_foveation_outer, "XRT_COMPOSITOR_COMPUTE_FOVEATION_OUTER_RADIUS", 0.0f)
+DEBUG_GET_ONCE_BOOL_OPTION(parallel_pipelines, "XRT_COMPOSITOR_PARALLEL_PIPELINES", true)
+DEBUG_GET_ONCE_BOOL_OPTION(analytic_distortion, "XRT_COMPOSITOR_ANALYTIC_DISTORTION", true)
+DEBUG_GET_ONCE_BOOL_OPTION(single_channel_distortion, "XRT_COMPOSITOR_SINGLE_CHANNEL_DISTORTION", true)
+
+//! Threads used to build the compute pipelines, including the calling one.
+#define PIPELINE_THREAD_COUNT (4)
 
 
 /*!
@@ -319,6 +336,35 @@ create_compute_distortion_descriptor_set_layout(struct vk_bundle *vk,
 	return VK_SUCCESS;
 }
 
+/*!
+ * Like the samplers from vk_create_sampler but not limited to the first mip
+ * level, for layers that are often minified like cylinders and equirects.
+ */
+static VkResult
+create_mip_sampler(struct vk_bundle *vk, VkSampler *out_sampler)
+{
+	VkSamplerCreateInfo info = {
+	    .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+	    .magFilter = VK_FILTER_LINEAR,
+	    .minFilter = VK_FILTER_LINEAR,
+	    .mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
+	    .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+	    .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+	    .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+	    .borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK,
+	    .minLod = 0.0f,
+	    .maxLod = VK_LOD_CLAMP_NONE,
+	    .unnormalizedCoordinates = VK_FALSE,
+	};
+
+	VkResult ret = vk->vkCreateSampler(vk->device, &info, NULL, out_sampler);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkCreateSampler: %s", vk_result_string(ret));
+	}
+
+	return ret;
+}
+
 struct compute_layer_params
 {
 	VkBool32 do_timewarp;
@@ -326,14 +372,82 @@ struct compute_layer_params
 	uint32_t max_layers;
 	uint32_t views_per_layer;
 	uint32_t image_array_size;
+	VkBool32 do_foveation;
+	VkBool32 single_projection;
 };
 
 struct compute_distortion_params
 {
 	uint32_t distortion_texel_count;
 	VkBool32 do_timewarp;
+	VkBool32 do_foveation;
+	int32_t distortion_model;
+	VkBool32 single_channel;
 };
 
+/*!
+ * Evaluating the distortion in the shader saves the three reads of the
+ * distortion images per pixel, which matters on bandwidth bound tile based
+ * GPUs, but only some devices can describe their distortion like that.
+ */
+static void
+init_analytic_distortion(struct render_resources *r, const struct xrt_hmd_parts *parts)
+{
+	r->distortion.analytic_model = XRT_DISTORTION_ANALYTIC_MODEL_NONE;
+
+	if (!debug_get_bool_option_analytic_distortion()) {
+		return;
+	}
+
+	switch (parts->distortion.analytic.model) {
+	case XRT_DISTORTION_ANALYTIC_MODEL_IDENTITY:
+	case XRT_DISTORTION_ANALYTIC_MODEL_PANOTOOLS:
+	case XRT_DISTORTION_ANALYTIC_MODEL_VIVE: break;
+	default: return;
+	}
+
+	r->distortion.analytic_model = parts->distortion.analytic.model;
+
+	VK_INFO(r->vk, "Evaluating distortion model %d in the compute shader", r->distortion.analytic_model);
+}
+
+/*!
+ * Takes the foveation from the hmd parts, the env variables can override the
+ * radii, centred in the views, or turn it off.
+ */
+static void
+init_foveation(struct render_resources *r, const struct xrt_hmd_parts *parts)
+{
+	r->compute.foveation.enabled = false;
+
+	struct xrt_vec2 centers[2] = {parts->foveation.centers[0], parts->foveation.centers[1]};
+	float inner = parts->foveation.inner_radius;
+	float outer = parts->foveation.outer_radius;
+
+	float env_outer = debug_get_float_option_compute_foveation_outer();
+	if (env_outer > 0.0f) {
+		centers[0] = (struct xrt_vec2){0.5f, 0.5f};
+		centers[1] = (struct xrt_vec2){0.5f, 0.5f};
+		inner = debug_get_float_option_compute_foveation_inner();
+		outer = env_outer;
+	}
+
+	if (!debug_get_bool_option_compute_foveation() || outer <= 0.0f) {
+		return;
+	}
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(r->compute.foveation.views); i++) {
+		r->compute.foveation.views[i].center = centers[i];
+		r->compute.foveation.fixed_centers[i] = centers[i];
+		r->compute.foveation.views[i].inner_radius = inner;
+		r->compute.foveation.views[i].outer_radius = outer > inner ? outer : inner;
+	}
+
+	r->compute.foveation.enabled = true;
+
+	VK_INFO(r->vk, "Compute foveation enabled, inner radius %f outer radius %f", inner, outer);
+}
+
 static VkResult
 create_compute_layer_pipeline(struct vk_bundle *vk,
                               VkPipelineCache pipeline_cache,
@@ -355,6 +469,8 @@ create_compute_layer_pipeline(struct vk_bundle *vk,
 	    ENTRY(3, max_layers),          //
 	    ENTRY(4, views_per_layer),     //
 	    ENTRY(5, image_array_size),    //
+	    ENTRY(6, do_foveation),        //
+	    ENTRY(7, single_projection),   //
 	};
 #undef ENTRY
 
@@ -389,9 +505,12 @@ create_compute_distortion_pipeline(struct vk_bundle *vk,
 	    sizeof(params->FIELD),                                                                                     \
 	}
 
-	VkSpecializationMapEntry entries[2] = {
+	VkSpecializationMapEntry entries[5] = {
 	    ENTRY(0, distortion_texel_count),
 	    ENTRY(1, do_timewarp),
+	    ENTRY(2, do_foveation),
+	    ENTRY(3, distortion_model),
+	    ENTRY(4, single_channel),
 	};
 #undef ENTRY
 
@@ -525,10 +644,110 @@ teardown_scratch_image(struct render_resources *r)
 	D(ImageView, r->scratch.color.srgb_view);
 	D(Image, r->scratch.color.image);
 	DF(Memory, r->scratch.color.memory);
+	D(ImageView, r->scratch.cache.unorm_view);
+	D(ImageView, r->scratch.cache.srgb_view);
+	D(Image, r->scratch.cache.image);
+	DF(Memory, r->scratch.cache.memory);
+	D(ImageView, r->scratch.pass.unorm_view);
+	D(ImageView, r->scratch.pass.srgb_view);
+	D(Image, r->scratch.pass.image);
+	DF(Memory, r->scratch.pass.memory);
 	U_ZERO(&r->scratch.extent);
 }
 
 
+/*!
+ * One compute pipeline to be built, @p layer_params or @p distortion_params
+ * select the specialisation, with neither it has none.
+ */
+struct pipeline_job
+{
+	struct vk_bundle *vk;
+	VkPipelineCache pipeline_cache;
+	VkShaderModule shader;
+	VkPipelineLayout pipeline_layout;
+	const struct compute_layer_params *layer_params;
+	const struct compute_distortion_params *distortion_params;
+	VkPipeline *out_pipeline;
+	VkResult ret;
+};
+
+static void
+pipeline_job_func(void *ptr)
+{
+	struct pipeline_job *job = (struct pipeline_job *)ptr;
+
+	if (job->layer_params != NULL) {
+		job->ret = create_compute_layer_pipeline( //
+		    job->vk,                              // vk_bundle
+		    job->pipeline_cache,                  // pipeline_cache
+		    job->shader,                          // shader
+		    job->pipeline_layout,                 // pipeline_layout
+		    job->layer_params,                    // params
+		    job->out_pipeline);                   // out_compute_pipeline
+	} else if (job->distortion_params != NULL) {
+		job->ret = create_compute_distortion_pipeline( //
+		    job->vk,                                   // vk_bundle
+		    job->pipeline_cache,                       // pipeline_cache
+		    job->shader,                               // shader
+		    job->pipeline_layout,                      // pipeline_layout
+		    job->distortion_params,                    // params
+		    job->out_pipeline);                        // out_compute_pipeline
+	} else {
+		job->ret = vk_create_compute_pipeline( //
+		    job->vk,                           // vk_bundle
+		    job->pipeline_cache,               // pipeline_cache
+		    job->shader,                       // shader
+		    job->pipeline_layout,              // pipeline_layout
+		    NULL,                              // specialization_info
+		    job->out_pipeline);                // out_compute_pipeline
+	}
+}
+
+/*!
+ * Builds the pipelines on a small worker pool, the driver does the shader
+ * compilation inside of the create call and the pipeline cache is internally
+ * synchronised, so they don't depend on each other. Falls back to building
+ * them one after another if the pool can't be made.
+ */
+static bool
+create_pipelines(struct vk_bundle *vk, struct pipeline_job *jobs, uint32_t count)
+{
+	struct u_worker_thread_pool *pool = NULL;
+	struct u_worker_group *group = NULL;
+
+	if (debug_get_bool_option_parallel_pipelines()) {
+		pool = u_worker_thread_pool_create(PIPELINE_THREAD_COUNT - 1, PIPELINE_THREAD_COUNT, "Pipelines",
+		                                   OS_THREAD_CORE_CLASS_ANY);
+		group = pool != NULL ? u_worker_group_create(pool) : NULL;
+	}
+
+	if (group != NULL) {
+		for (uint32_t i = 0; i < count; i++) {
+			u_worker_group_push(group, pipeline_job_func, &jobs[i]);
+		}
+		u_worker_group_wait_all(group);
+	} else {
+		for (uint32_t i = 0; i < count; i++) {
+			pipeline_job_func(&jobs[i]);
+		}
+	}
+
+	u_worker_group_reference(&group, NULL);
+	u_worker_thread_pool_reference(&pool, NULL);
+
+	bool success = true;
+	for (uint32_t i = 0; i < count; i++) {
+		if (jobs[i].ret != VK_SUCCESS) {
+			VK_ERROR(vk, "Failed to create compute pipeline %u: %s", i, vk_result_string(jobs[i].ret));
+			success = false;
+		}
+	}
+
+	return success;
+}
+
+
 /*
  *
  * 'Exported' renderer functions.
@@ -541,6 +760,9 @@ render_resources_init(struct render_resources *r,
                       struct vk_bundle *vk,
                       struct xrt_device *xdev)
 {
+	uint64_t start_ns = os_monotonic_get_ns();
+
+
 	/*
 	 * Main pointers.
 	 */
@@ -569,9 +791,19 @@ render_resources_init(struct render_resources *r,
 	r->compute.target_binding = 2;
 	r->compute.ubo_binding = 3;
 
+	init_foveation(r, parts);
+	init_analytic_distortion(r, parts);
+
+	// Without chromatic aberration one sample per pixel is enough.
+	r->distortion.single_channel = parts->distortion.single_channel && //
+	                               debug_get_bool_option_single_channel_distortion();
+	if (r->distortion.single_channel) {
+		VK_INFO(vk, "No chromatic aberration, sampling the source once per pixel");
+	}
+
 	r->compute.layer.image_array_size = vk->features.max_per_stage_descriptor_sampled_images;
-	if (r->compute.layer.image_array_size > COMP_MAX_IMAGES) {
-		r->compute.layer.image_array_size = COMP_MAX_IMAGES;
+	if (r->compute.layer.image_array_size > RENDER_MAX_IMAGES) {
+		r->compute.layer.image_array_size = RENDER_MAX_IMAGES;
 	}
 
 
@@ -599,6 +831,10 @@ render_resources_init(struct render_resources *r,
 	    VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER, // clamp_mode
 	    &r->samplers.clamp_to_border_black));    // out_sampler
 
+	C(create_mip_sampler(                 //
+	    vk,                               // vk_bundle
+	    &r->samplers.clamp_to_edge_mip)); // out_sampler
+
 
 	/*
 	 * Command buffer pool, needs to go first.
@@ -667,7 +903,7 @@ render_resources_init(struct render_resources *r,
 	 * Shared
 	 */
 
-	C(vk_create_pipeline_cache(vk, &r->pipeline_cache));
+	C(vk_create_pipeline_cache_from_disk(vk, "render_resources", &r->pipeline_cache));
 
 	VkCommandBufferAllocateInfo cmd_buffer_info = {
 	    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
@@ -743,7 +979,8 @@ render_resources_init(struct render_resources *r,
 	    .sampler_per_descriptor_count = r->compute.layer.image_array_size + 6,
 	    .storage_image_per_descriptor_count = 1,
 	    .storage_buffer_per_descriptor_count = 0,
-	    .descriptor_count = 2,
+	    // Layers, distortion, layer cache and all but the last layer pass.
+	    .descriptor_count = 3 + RENDER_MAX_LAYER_PASSES - 1,
 	    .freeable = false,
 	};
 
@@ -770,38 +1007,6 @@ render_resources_init(struct render_resources *r,
 	    r->compute.layer.descriptor_set_layout, // descriptor_set_layout
 	    &r->compute.layer.pipeline_layout));    // out_pipeline_layout
 
-	struct compute_layer_params layer_params = {
-	    .do_timewarp = false,
-	    .do_color_correction = true,
-	    .max_layers = COMP_MAX_LAYERS,
-	    .views_per_layer = COMP_VIEWS_PER_LAYER,
-	    .image_array_size = r->compute.layer.image_array_size,
-	};
-
-	C(create_compute_layer_pipeline(               //
-	    vk,                                        // vk_bundle
-	    r->pipeline_cache,                         // pipeline_cache
-	    r->shaders->layer_comp,                    // shader
-	    r->compute.layer.pipeline_layout,          // pipeline_layout
-	    &layer_params,                             // params
-	    &r->compute.layer.non_timewarp_pipeline)); // out_compute_pipeline
-
-	struct compute_layer_params layer_timewarp_params = {
-	    .do_timewarp = true,
-	    .do_color_correction = true,
-	    .max_layers = COMP_MAX_LAYERS,
-	    .views_per_layer = COMP_VIEWS_PER_LAYER,
-	    .image_array_size = r->compute.layer.image_array_size,
-	};
-
-	C(create_compute_layer_pipeline(           //
-	    vk,                                    // vk_bundle
-	    r->pipeline_cache,                     // pipeline_cache
-	    r->shaders->layer_comp,                // shader
-	    r->compute.layer.pipeline_layout,      // pipeline_layout
-	    &layer_timewarp_params,                // params
-	    &r->compute.layer.timewarp_pipeline)); // out_compute_pipeline
-
 	size_t layer_ubo_size = sizeof(struct render_compute_layer_ubo_data);
 
 	C(render_buffer_init(        //
@@ -814,6 +1019,28 @@ render_resources_init(struct render_resources *r,
 	    vk,                      // vk_bundle
 	    &r->compute.layer.ubo)); // buffer
 
+	C(render_buffer_init(            //
+	    vk,                          // vk_bundle
+	    &r->compute.layer.cache_ubo, // buffer
+	    ubo_usage_flags,             // usage_flags
+	    memory_property_flags,       // memory_property_flags
+	    layer_ubo_size));            // size
+	C(render_buffer_map(               //
+	    vk,                            // vk_bundle
+	    &r->compute.layer.cache_ubo)); // buffer
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(r->compute.layer.pass_ubos); i++) {
+		C(render_buffer_init(               //
+		    vk,                             // vk_bundle
+		    &r->compute.layer.pass_ubos[i], // buffer
+		    ubo_usage_flags,                // usage_flags
+		    memory_property_flags,          // memory_property_flags
+		    layer_ubo_size));               // size
+		C(render_buffer_map(                  //
+		    vk,                               // vk_bundle
+		    &r->compute.layer.pass_ubos[i])); // buffer
+	}
+
 
 	/*
 	 * Distortion pipeline
@@ -832,32 +1059,6 @@ render_resources_init(struct render_resources *r,
 	    r->compute.distortion.descriptor_set_layout, // descriptor_set_layout
 	    &r->compute.distortion.pipeline_layout));    // out_pipeline_layout
 
-	struct compute_distortion_params distortion_params = {
-	    .distortion_texel_count = COMP_DISTORTION_IMAGE_DIMENSIONS,
-	    .do_timewarp = false,
-	};
-
-	C(create_compute_distortion_pipeline(      //
-	    vk,                                    // vk_bundle
-	    r->pipeline_cache,                     // pipeline_cache
-	    r->shaders->distortion_comp,           // shader
-	    r->compute.distortion.pipeline_layout, // pipeline_layout
-	    &distortion_params,                    // params
-	    &r->compute.distortion.pipeline));     // out_compute_pipeline
-
-	struct compute_distortion_params distortion_timewarp_params = {
-	    .distortion_texel_count = COMP_DISTORTION_IMAGE_DIMENSIONS,
-	    .do_timewarp = true,
-	};
-
-	C(create_compute_distortion_pipeline(           //
-	    vk,                                         // vk_bundle
-	    r->pipeline_cache,                          // pipeline_cache
-	    r->shaders->distortion_comp,                // shader
-	    r->compute.distortion.pipeline_layout,      // pipeline_layout
-	    &distortion_timewarp_params,                // params
-	    &r->compute.distortion.timewarp_pipeline)); // out_compute_pipeline
-
 	size_t distortion_ubo_size = sizeof(struct render_compute_distortion_ubo_data);
 
 	C(render_buffer_init(             //
@@ -870,19 +1071,34 @@ render_resources_init(struct render_resources *r,
 	    vk,                           // vk_bundle
 	    &r->compute.distortion.ubo)); // buffer
 
+	struct vk_descriptor_pool_info distortion_pool_info = {
+	    .uniform_per_descriptor_count = 1,
+	    // source and distortion images
+	    .sampler_per_descriptor_count = 2 + 6,
+	    .storage_image_per_descriptor_count = 1,
+	    .storage_buffer_per_descriptor_count = 0,
+	    .descriptor_count = 1,
+	    .freeable = false,
+	};
+
+	C(vk_create_descriptor_pool(                  //
+	    vk,                                       // vk_bundle
+	    &distortion_pool_info,                    // info
+	    &r->compute.distortion.descriptor_pool)); // out_descriptor_pool
+
+	C(vk_create_descriptor_set(                      //
+	    vk,                                          //
+	    r->compute.distortion.descriptor_pool,       // descriptor_pool
+	    r->compute.distortion.descriptor_set_layout, // descriptor_set_layout
+	    &r->compute.distortion.descriptor_set));     // descriptor_set
+
+	r->compute.distortion.written.valid = false;
+
 
 	/*
-	 * Clear pipeline.
+	 * Clear
 	 */
 
-	C(vk_create_compute_pipeline(              //
-	    vk,                                    // vk_bundle
-	    r->pipeline_cache,                     // pipeline_cache
-	    r->shaders->clear_comp,                // shader
-	    r->compute.distortion.pipeline_layout, // pipeline_layout
-	    NULL,                                  // specialization_info
-	    &r->compute.clear.pipeline));          // out_compute_pipeline
-
 	size_t clear_ubo_size = sizeof(struct render_compute_distortion_ubo_data);
 
 	C(render_buffer_init(        //
@@ -896,6 +1112,98 @@ render_resources_init(struct render_resources *r,
 	    &r->compute.clear.ubo)); // buffer
 
 
+	/*
+	 * Compute pipelines, all layouts above are done so they can be built at the same time.
+	 */
+
+	struct compute_layer_params layer_params = {
+	    .do_timewarp = false,
+	    .do_color_correction = true,
+	    .max_layers = RENDER_MAX_LAYERS,
+	    .views_per_layer = COMP_VIEWS_PER_LAYER,
+	    .image_array_size = r->compute.layer.image_array_size,
+	    .do_foveation = r->compute.foveation.enabled,
+	    .single_projection = false,
+	};
+
+	struct compute_layer_params layer_timewarp_params = layer_params;
+	layer_timewarp_params.do_timewarp = true;
+
+	struct compute_layer_params layer_single_params = layer_params;
+	layer_single_params.single_projection = true;
+
+	struct compute_layer_params layer_single_timewarp_params = layer_timewarp_params;
+	layer_single_timewarp_params.single_projection = true;
+
+	struct compute_distortion_params distortion_params = {
+	    .distortion_texel_count = COMP_DISTORTION_IMAGE_DIMENSIONS,
+	    .do_timewarp = false,
+	    .do_foveation = r->compute.foveation.enabled,
+	    .distortion_model = (int32_t)r->distortion.analytic_model,
+	    .single_channel = r->distortion.single_channel,
+	};
+
+	struct compute_distortion_params distortion_timewarp_params = distortion_params;
+	distortion_timewarp_params.do_timewarp = true;
+
+	struct pipeline_job jobs[] = {
+	    {
+	        .shader = r->shaders->layer_comp,
+	        .pipeline_layout = r->compute.layer.pipeline_layout,
+	        .layer_params = &layer_params,
+	        .out_pipeline = &r->compute.layer.non_timewarp_pipeline,
+	    },
+	    {
+	        .shader = r->shaders->layer_comp,
+	        .pipeline_layout = r->compute.layer.pipeline_layout,
+	        .layer_params = &layer_timewarp_params,
+	        .out_pipeline = &r->compute.layer.timewarp_pipeline,
+	    },
+	    {
+	        .shader = r->shaders->layer_comp,
+	        .pipeline_layout = r->compute.layer.pipeline_layout,
+	        .layer_params = &layer_single_params,
+	        .out_pipeline = &r->compute.layer.single_projection_pipeline,
+	    },
+	    {
+	        .shader = r->shaders->layer_comp,
+	        .pipeline_layout = r->compute.layer.pipeline_layout,
+	        .layer_params = &layer_single_timewarp_params,
+	        .out_pipeline = &r->compute.layer.single_projection_timewarp_pipeline,
+	    },
+	    {
+	        .shader = r->shaders->distortion_comp,
+	        .pipeline_layout = r->compute.distortion.pipeline_layout,
+	        .distortion_params = &distortion_params,
+	        .out_pipeline = &r->compute.distortion.pipeline,
+	    },
+	    {
+	        .shader = r->shaders->distortion_comp,
+	        .pipeline_layout = r->compute.distortion.pipeline_layout,
+	        .distortion_params = &distortion_timewarp_params,
+	        .out_pipeline = &r->compute.distortion.timewarp_pipeline,
+	    },
+	    {
+	        .shader = r->shaders->clear_comp,
+	        .pipeline_layout = r->compute.distortion.pipeline_layout,
+	        .out_pipeline = &r->compute.clear.pipeline,
+	    },
+	};
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(jobs); i++) {
+		jobs[i].vk = vk;
+		jobs[i].pipeline_cache = r->pipeline_cache;
+	}
+
+	uint64_t pipelines_start_ns = os_monotonic_get_ns();
+
+	if (!create_pipelines(vk, jobs, ARRAY_SIZE(jobs))) {
+		return false;
+	}
+
+	VK_DEBUG(vk, "Compute pipelines took %.1fms", time_ns_to_ms_f(os_monotonic_get_ns() - pipelines_start_ns));
+
+
 	/*
 	 * Compute distortion textures, not created until later.
 	 */
@@ -920,22 +1228,25 @@ render_resources_init(struct render_resources *r,
 	    .pNext = NULL,
 	    .flags = 0, // Reserved.
 	    .queryType = VK_QUERY_TYPE_TIMESTAMP,
-	    .queryCount = 2,         // Start & end
+	    .queryCount = RENDER_TIMESTAMP_FRAME_COUNT * RENDER_TIMESTAMP_POINT_COUNT,
 	    .pipelineStatistics = 0, // Not used.
 	};
 
-	vk->vkCreateQueryPool( //
-	    vk->device,        // device
-	    &poolInfo,         // pCreateInfo
-	    NULL,              // pAllocator
-	    &r->query_pool);   // pQueryPool
+	vk->vkCreateQueryPool(    //
+	    vk->device,           // device
+	    &poolInfo,            // pCreateInfo
+	    NULL,                 // pAllocator
+	    &r->timestamps.pool); // pQueryPool
 
 
 	/*
 	 * Done
 	 */
 
-	U_LOG_I("New renderer initialized!");
+	// All pipelines have been created, store them for the next start.
+	vk_save_pipeline_cache(vk, r->pipeline_cache, "render_resources");
+
+	U_LOG_I("New renderer initialized in %.1fms!", time_ns_to_ms_f(os_monotonic_get_ns() - start_ns));
 
 	return true;
 }
@@ -965,11 +1276,41 @@ render_ensure_scratch_image(struct render_resources *r, VkExtent2D extent)
 		return false;
 	}
 
+	bret = create_scratch_image_and_view( //
+	    r->vk,                            //
+	    extent,                           //
+	    &r->scratch.cache.memory,         //
+	    &r->scratch.cache.image,          //
+	    &r->scratch.cache.srgb_view,      //
+	    &r->scratch.cache.unorm_view);    //
+	if (!bret) {
+		teardown_scratch_image(r);
+		return false;
+	}
+
 	r->scratch.extent = extent;
 
 	return true;
 }
 
+bool
+render_ensure_scratch_pass_image(struct render_resources *r)
+{
+	if (r->scratch.pass.srgb_view != VK_NULL_HANDLE && //
+	    r->scratch.pass.unorm_view != VK_NULL_HANDLE) {
+		return true;
+	}
+
+	// Same extent as the scratch image, so the post transforms of the views match.
+	return create_scratch_image_and_view( //
+	    r->vk,                            //
+	    r->scratch.extent,                //
+	    &r->scratch.pass.memory,          //
+	    &r->scratch.pass.image,           //
+	    &r->scratch.pass.srgb_view,       //
+	    &r->scratch.pass.unorm_view);     //
+}
+
 void
 render_resources_close(struct render_resources *r)
 {
@@ -984,15 +1325,17 @@ render_resources_close(struct render_resources *r)
 	D(Sampler, r->samplers.repeat);
 	D(Sampler, r->samplers.clamp_to_edge);
 	D(Sampler, r->samplers.clamp_to_border_black);
+	D(Sampler, r->samplers.clamp_to_edge_mip);
 
 	D(ImageView, r->mock.color.image_view);
 	D(Image, r->mock.color.image);
 	DF(Memory, r->mock.color.memory);
 	D(DescriptorSetLayout, r->mesh.descriptor_set_layout);
 	D(PipelineLayout, r->mesh.pipeline_layout);
+	vk_save_pipeline_cache(vk, r->pipeline_cache, "render_resources");
 	D(PipelineCache, r->pipeline_cache);
 	D(DescriptorPool, r->mesh.descriptor_pool);
-	D(QueryPool, r->query_pool);
+	D(QueryPool, r->timestamps.pool);
 	render_buffer_close(vk, &r->mesh.vbo);
 	render_buffer_close(vk, &r->mesh.ibo);
 	render_buffer_close(vk, &r->mesh.ubos[0]);
@@ -1000,9 +1343,16 @@ render_resources_close(struct render_resources *r)
 
 	D(DescriptorPool, r->compute.descriptor_pool);
 
+	// Frees the descriptor set.
+	D(DescriptorPool, r->compute.distortion.descriptor_pool);
+	r->compute.distortion.descriptor_set = VK_NULL_HANDLE;
+	r->compute.distortion.written.valid = false;
+
 	D(DescriptorSetLayout, r->compute.layer.descriptor_set_layout);
 	D(Pipeline, r->compute.layer.non_timewarp_pipeline);
 	D(Pipeline, r->compute.layer.timewarp_pipeline);
+	D(Pipeline, r->compute.layer.single_projection_pipeline);
+	D(Pipeline, r->compute.layer.single_projection_timewarp_pipeline);
 	D(PipelineLayout, r->compute.layer.pipeline_layout);
 
 	D(DescriptorSetLayout, r->compute.distortion.descriptor_set_layout);
@@ -1015,6 +1365,10 @@ render_resources_close(struct render_resources *r)
 	render_distortion_images_close(r);
 	render_buffer_close(vk, &r->compute.clear.ubo);
 	render_buffer_close(vk, &r->compute.layer.ubo);
+	render_buffer_close(vk, &r->compute.layer.cache_ubo);
+	for (uint32_t i = 0; i < ARRAY_SIZE(r->compute.layer.pass_ubos); i++) {
+		render_buffer_close(vk, &r->compute.layer.pass_ubos[i]);
+	}
 	render_buffer_close(vk, &r->compute.distortion.ubo);
 
 	teardown_scratch_image(r);
@@ -1026,93 +1380,155 @@ render_resources_close(struct render_resources *r)
 	r->vk = NULL;
 }
 
-bool
-render_resources_get_timestamps(struct render_resources *r, uint64_t *out_gpu_start_ns, uint64_t *out_gpu_end_ns)
+void
+render_resources_begin_timestamps(struct render_resources *r, VkCommandBuffer cmd)
 {
 	struct vk_bundle *vk = r->vk;
-	VkResult ret = VK_SUCCESS;
-
-	// Simple pre-check, needed by vk_convert_timestamps_to_host_ns.
-	if (!vk->has_EXT_calibrated_timestamps) {
-		return false;
-	}
-
-
-	/*
-	 * Query how long things took.
-	 */
-
-	VkQueryResultFlags flags = VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT;
-	uint64_t timestamps[2] = {0};
 
-	vk->vkGetQueryPoolResults( //
-	    vk->device,            // device
-	    r->query_pool,         // queryPool
-	    0,                     // firstQuery
-	    2,                     // queryCount
-	    sizeof(uint64_t) * 2,  // dataSize
-	    timestamps,            // pData
-	    sizeof(uint64_t),      // stride
-	    flags);                // flags
+	uint32_t slot = (uint32_t)(r->timestamps.frame_count++ % RENDER_TIMESTAMP_FRAME_COUNT);
+	r->timestamps.slots[slot].frame_id = r->timestamps.frame_id;
+	r->timestamps.slots[slot].written = 0;
+	r->timestamps.slots[slot].pending = true;
 
+	vk->vkCmdResetQueryPool(                 //
+	    cmd,                                 // commandBuffer
+	    r->timestamps.pool,                  // queryPool
+	    slot * RENDER_TIMESTAMP_POINT_COUNT, // firstQuery
+	    RENDER_TIMESTAMP_POINT_COUNT);       // queryCount
 
-	/*
-	 * Convert from GPU context to CPU context, has to be
-	 * done fairly quickly after timestamps has been made.
-	 */
-	ret = vk_convert_timestamps_to_host_ns(vk, 2, timestamps);
-	if (ret != VK_SUCCESS) {
-		return false;
-	}
+	render_resources_write_timestamp(r, cmd, RENDER_TIMESTAMP_POINT_BEGIN);
+}
 
-	uint64_t gpu_start_ns = timestamps[0];
-	uint64_t gpu_end_ns = timestamps[1];
+void
+render_resources_write_timestamp(struct render_resources *r, VkCommandBuffer cmd, enum render_timestamp_point point)
+{
+	struct vk_bundle *vk = r->vk;
 
+	assert(r->timestamps.frame_count > 0);
+	uint32_t slot = (uint32_t)((r->timestamps.frame_count - 1) % RENDER_TIMESTAMP_FRAME_COUNT);
 
-	/*
-	 * Done
-	 */
+	// The first one is when the GPU starts on the commands, the others when it's done with them.
+	VkPipelineStageFlagBits stage = point == RENDER_TIMESTAMP_POINT_BEGIN ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT
+	                                                                      : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
 
-	*out_gpu_start_ns = gpu_start_ns;
-	*out_gpu_end_ns = gpu_end_ns;
+	vk->vkCmdWriteTimestamp(                          //
+	    cmd,                                          // commandBuffer
+	    stage,                                        // pipelineStage
+	    r->timestamps.pool,                           // queryPool
+	    slot * RENDER_TIMESTAMP_POINT_COUNT + point); // query
 
-	return true;
+	r->timestamps.slots[slot].written |= 1u << point;
 }
 
 bool
-render_resources_get_duration(struct render_resources *r, uint64_t *out_gpu_duration_ns)
+render_resources_get_frame_timestamps(struct render_resources *r, struct render_frame_timestamps *out_timestamps)
 {
 	struct vk_bundle *vk = r->vk;
-	VkResult ret = VK_SUCCESS;
+	uint64_t frame_count = r->timestamps.frame_count;
+
+	// Newest first, so no latency is added when the GPU is already done.
+	for (uint32_t age = 0; age < RENDER_TIMESTAMP_FRAME_COUNT && age < frame_count; age++) {
+		uint32_t slot = (uint32_t)((frame_count - 1 - age) % RENDER_TIMESTAMP_FRAME_COUNT);
+		uint32_t written = r->timestamps.slots[slot].written;
+		if (!r->timestamps.slots[slot].pending) {
+			// Everything older has been read, or skipped, already.
+			return false;
+		}
+
+		// Pairs of value and availability, without waiting not all of them might be ready.
+		VkQueryResultFlags flags = VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT;
+		uint64_t results[RENDER_TIMESTAMP_POINT_COUNT][2] = {0};
+
+		VkResult ret = vk->vkGetQueryPoolResults( //
+		    vk->device,                           // device
+		    r->timestamps.pool,                   // queryPool
+		    slot * RENDER_TIMESTAMP_POINT_COUNT,  // firstQuery
+		    RENDER_TIMESTAMP_POINT_COUNT,         // queryCount
+		    sizeof(results),                      // dataSize
+		    results,                              // pData
+		    sizeof(results[0]),                   // stride
+		    flags);                               // flags
+		if (ret != VK_SUCCESS && ret != VK_NOT_READY) {
+			return false;
+		}
+
+		bool ready = written != 0;
+		uint64_t ticks[RENDER_TIMESTAMP_POINT_COUNT];
+		uint32_t tick_count = 0;
+		for (uint32_t i = 0; i < RENDER_TIMESTAMP_POINT_COUNT; i++) {
+			if ((written & (1u << i)) == 0) {
+				continue;
+			}
+			ready = ready && results[i][1] != 0;
+			ticks[tick_count++] = results[i][0];
+		}
+
+		/*
+		 * The reset of the newest frames might not have executed yet,
+		 * their queries still hold the results of an older frame.
+		 */
+		if (!ready || ticks[0] <= r->timestamps.last_begin_ticks) {
+			continue;
+		}
+		r->timestamps.last_begin_ticks = ticks[0];
+
+		// Done with this and the older frames, the newer ones are still in flight.
+		for (uint32_t older = age; older < RENDER_TIMESTAMP_FRAME_COUNT && older < frame_count; older++) {
+			r->timestamps.slots[(frame_count - 1 - older) % RENDER_TIMESTAMP_FRAME_COUNT].pending = false;
+		}
+
+		// Convert from GPU context to CPU context if possible.
+		uint64_t converted[RENDER_TIMESTAMP_POINT_COUNT];
+		memcpy(converted, ticks, sizeof(converted));
+		bool host_time = vk->has_EXT_calibrated_timestamps &&
+		                 vk_convert_timestamps_to_host_ns(vk, tick_count, converted) == VK_SUCCESS;
+		for (uint32_t i = 0; i < tick_count; i++) {
+			double gpu_ns = (double)ticks[i] * vk->features.timestamp_period;
+			ticks[i] = host_time ? converted[i] : (uint64_t)gpu_ns;
+		}
+
+		U_ZERO(out_timestamps);
+		out_timestamps->frame_id = r->timestamps.slots[slot].frame_id;
+		out_timestamps->written = written;
+		out_timestamps->host_time = host_time;
+
+		tick_count = 0;
+		for (uint32_t i = 0; i < RENDER_TIMESTAMP_POINT_COUNT; i++) {
+			if ((written & (1u << i)) != 0) {
+				out_timestamps->points_ns[i] = ticks[tick_count++];
+			}
+		}
 
-	/*
-	 * Query how long things took.
-	 */
-
-	VkQueryResultFlags flags = VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT;
-	uint64_t timestamps[2] = {0};
+		return true;
+	}
 
-	ret = vk->vkGetQueryPoolResults( //
-	    vk->device,                  // device
-	    r->query_pool,               // queryPool
-	    0,                           // firstQuery
-	    2,                           // queryCount
-	    sizeof(uint64_t) * 2,        // dataSize
-	    timestamps,                  // pData
-	    sizeof(uint64_t),            // stride
-	    flags);                      // flags
+	return false;
+}
 
-	if (ret != VK_SUCCESS) {
+bool
+render_resources_get_timestamps(struct render_resources *r, uint64_t *out_gpu_start_ns, uint64_t *out_gpu_end_ns)
+{
+	struct render_frame_timestamps timestamps;
+	if (!render_resources_get_frame_timestamps(r, &timestamps) || !timestamps.host_time) {
 		return false;
 	}
 
+	*out_gpu_start_ns = timestamps.points_ns[RENDER_TIMESTAMP_POINT_BEGIN];
+	*out_gpu_end_ns = timestamps.points_ns[RENDER_TIMESTAMP_POINT_END];
 
-	/*
-	 * Convert from ticks to nanoseconds
-	 */
+	return true;
+}
+
+bool
+render_resources_get_duration(struct render_resources *r, uint64_t *out_gpu_duration_ns)
+{
+	struct render_frame_timestamps timestamps;
+	if (!render_resources_get_frame_timestamps(r, &timestamps)) {
+		return false;
+	}
 
-	double duration_ticks = (double)(timestamps[1] - timestamps[0]);
-	*out_gpu_duration_ns = (uint64_t)(duration_ticks * vk->features.timestamp_period);
+	*out_gpu_duration_ns =
+	    timestamps.points_ns[RENDER_TIMESTAMP_POINT_END] - timestamps.points_ns[RENDER_TIMESTAMP_POINT_BEGIN];
 
 	return true;
 }
@@ -27,6 +27,7 @@
 #include "shaders/clear.comp.h"
 #include "shaders/layer.comp.h"
 #include "shaders/distortion.comp.h"
+#include "shaders/distortion_ellipsoid.comp.h"
 #include "shaders/layer.frag.h"
 #include "shaders/layer.vert.h"
 #include "shaders/equirect1.frag.h"
@@ -110,6 +111,11 @@ render_shaders_load(struct render_shaders *s, struct vk_bundle *vk)
 	              sizeof(shaders_distortion_comp), // size
 	              &s->distortion_comp));           // out
 
+	C(shader_load(vk,                                        // vk_bundle
+	              shaders_distortion_ellipsoid_comp,         // data
+	              sizeof(shaders_distortion_ellipsoid_comp), // size
+	              &s->distortion_ellipsoid_comp));           // out
+
 	C(shader_load(vk,                        // vk_bundle
 	              shaders_mesh_vert,         // data
 	              sizeof(shaders_mesh_vert), // size
@@ -174,6 +180,7 @@ render_shaders_close(struct render_shaders *s, struct vk_bundle *vk)
 	D(blit_comp);
 	D(clear_comp);
 	D(distortion_comp);
+	D(distortion_ellipsoid_comp);
 	D(layer_comp);
 	D(mesh_vert);
 	D(mesh_frag);
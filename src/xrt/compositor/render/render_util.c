@@ -12,6 +12,8 @@
 
 #include "render/render_interface.h"
 
+#include <math.h>
+
 
 /*!
  * Create a simplified projection matrix for timewarp.
@@ -109,3 +111,64 @@ render_calc_time_warp_matrix(const struct xrt_pose *src_pose,
 		matrix->v[i] = (float)result.v[i];
 	}
 }
+
+void
+render_calc_reprojection_matrix(const struct xrt_pose *src_pose,
+                                const struct xrt_pose *new_pose,
+                                struct xrt_matrix_4x4 *matrix)
+{
+	struct xrt_vec3 scale = {1, 1, 1};
+
+	// From the new eye to world space.
+	struct xrt_matrix_4x4_f64 new_model;
+	m_mat4_f64_model(new_pose, &scale, &new_model);
+
+	// From world space to the source eye.
+	struct xrt_matrix_4x4_f64 src_model, src_view;
+	m_mat4_f64_model(src_pose, &scale, &src_model);
+	m_mat4_f64_invert(&src_model, &src_view);
+
+	struct xrt_matrix_4x4_f64 result;
+	m_mat4_f64_multiply(&src_view, &new_model, &result);
+
+	// Convert from f64 to f32.
+	for (int i = 0; i < 16; i++) {
+		matrix->v[i] = (float)result.v[i];
+	}
+}
+
+void
+render_calc_depth_params(const struct xrt_layer_depth_data *depth, float out_params[4])
+{
+	double near_z = depth->near_z;
+	double far_z = depth->far_z;
+	double range = depth->max_depth - depth->min_depth;
+	if (range <= 0.0) {
+		range = 1.0;
+	}
+
+	/*
+	 * Linear depth is near * far / (far + n * (near - far)) where n is the
+	 * depth normalized to [0, 1], divide everything by the infinite one.
+	 */
+	double num, c0, c1;
+	if (isinf(far_z)) {
+		num = near_z;
+		c0 = 1.0;
+		c1 = -1.0;
+	} else if (isinf(near_z)) {
+		num = far_z;
+		c0 = 0.0;
+		c1 = 1.0;
+	} else {
+		num = near_z * far_z;
+		c0 = far_z;
+		c1 = near_z - far_z;
+	}
+
+	// Fold in n = (d - min_depth) / range.
+	out_params[0] = (float)num;
+	out_params[1] = (float)(c0 - c1 * depth->min_depth / range);
+	out_params[2] = (float)(c1 / range);
+	out_params[3] = 0.0f;
+}
@@ -0,0 +1,35 @@
+// Copyright 2023, Collabora Ltd.
+// SPDX-License-Identifier: BSL-1.0
+
+// Fixed foveation helpers for the compute shaders, with foveation enabled each
+// work group of 8x8 invocations covers a tile of 32x32 pixels. Each invocation
+// covers 4x4 pixels, sampling 16, 4 or 1 times depending on the tile's rate.
+
+#define FOVEATION_TILE_SIZE 32
+#define FOVEATION_INVOCATION_PIXELS 4
+
+
+/*
+ * Returns the shading rate, 1, 2 or 4, of the tile spanning the pixels
+ * [tile_min .. tile_max), the tile gets the highest rate of any pixel in it.
+ * @p params is the foveation centre in view uv in xy, the radius of the full
+ * rate region in z and of the half rate region in w.
+ */
+int foveation_rate(vec4 params, ivec2 extent, ivec2 tile_min, ivec2 tile_max)
+{
+	vec2 extent_pixel_size = vec2(1.0 / float(extent.x), 1.0 / float(extent.y));
+	vec2 tile_uv_min = vec2(tile_min) * extent_pixel_size;
+	vec2 tile_uv_max = vec2(tile_max) * extent_pixel_size;
+
+	// Closest point of the tile to the centre.
+	vec2 closest = clamp(params.xy, tile_uv_min, tile_uv_max);
+	float dist = distance(closest, params.xy);
+
+	if (dist <= params.z) {
+		return 1;
+	} else if (dist <= params.w) {
+		return 2;
+	} else {
+		return 4;
+	}
+}
@@ -10,6 +10,9 @@
 #version 450
 
 
+// No chromatic aberration, all uvs are the same so only sample once.
+layout (constant_id = 0) const bool single_channel = false;
+
 layout (binding = 0) uniform sampler2D tex_sampler;
 
 layout (location = 0)  in vec2 in_ruv;
@@ -20,6 +23,11 @@ layout (location = 0) out vec4 out_color;
 
 void main()
 {
+	if (single_channel) {
+		out_color = vec4(texture(tex_sampler, in_guv).rgb, 1.0);
+		return;
+	}
+
 	float r = texture(tex_sampler, in_ruv).x;
 	float g = texture(tex_sampler, in_guv).y;
 	float b = texture(tex_sampler, in_buv).z;
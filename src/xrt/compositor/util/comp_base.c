@@ -21,6 +21,20 @@
  *
  */
 
+/*!
+ * Returns the next free layer, or NULL if they are all used. Several clients
+ * can together submit more layers than fit, the ones on top are then dropped.
+ */
+static struct comp_layer *
+reserve_layer(struct comp_base *cb)
+{
+	if (cb->slot.layer_count >= COMP_MAX_LAYERS) {
+		return NULL;
+	}
+
+	return &cb->slot.layers[cb->slot.layer_count++];
+}
+
 static xrt_result_t
 do_single_layer(struct xrt_compositor *xc,
                 struct xrt_device *xdev,
@@ -29,15 +43,15 @@ do_single_layer(struct xrt_compositor *xc,
 {
 	struct comp_base *cb = comp_base(xc);
 
-	uint32_t layer_id = cb->slot.layer_count;
+	struct comp_layer *layer = reserve_layer(cb);
+	if (layer == NULL) {
+		return XRT_SUCCESS;
+	}
 
-	struct comp_layer *layer = &cb->slot.layers[layer_id];
 	layer->sc_array[0] = comp_swapchain(xsc);
 	layer->sc_array[1] = NULL;
 	layer->data = *data;
 
-	cb->slot.layer_count++;
-
 	return XRT_SUCCESS;
 }
 
@@ -123,15 +137,15 @@ base_layer_stereo_projection(struct xrt_compositor *xc,
 {
 	struct comp_base *cb = comp_base(xc);
 
-	uint32_t layer_id = cb->slot.layer_count;
+	struct comp_layer *layer = reserve_layer(cb);
+	if (layer == NULL) {
+		return XRT_SUCCESS;
+	}
 
-	struct comp_layer *layer = &cb->slot.layers[layer_id];
 	layer->sc_array[0] = comp_swapchain(l_xsc);
 	layer->sc_array[1] = comp_swapchain(r_xsc);
 	layer->data = *data;
 
-	cb->slot.layer_count++;
-
 	return XRT_SUCCESS;
 }
 
@@ -146,17 +160,17 @@ base_layer_stereo_projection_depth(struct xrt_compositor *xc,
 {
 	struct comp_base *cb = comp_base(xc);
 
-	uint32_t layer_id = cb->slot.layer_count;
+	struct comp_layer *layer = reserve_layer(cb);
+	if (layer == NULL) {
+		return XRT_SUCCESS;
+	}
 
-	struct comp_layer *layer = &cb->slot.layers[layer_id];
 	layer->sc_array[0] = comp_swapchain(l_xsc);
 	layer->sc_array[1] = comp_swapchain(r_xsc);
 	layer->sc_array[2] = comp_swapchain(l_d_xsc);
 	layer->sc_array[3] = comp_swapchain(r_d_xsc);
 	layer->data = *data;
 
-	cb->slot.layer_count++;
-
 	return XRT_SUCCESS;
 }
 
@@ -0,0 +1,668 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Copies swapchain images rendered on another GPU to the compositor GPU.
+ * @ingroup comp_util
+ */
+
+#include "util/u_misc.h"
+#include "util/u_trace_marker.h"
+
+#include "util/comp_base.h"
+#include "util/comp_swapchain.h"
+#include "util/comp_cross_gpu.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+#define D(TYPE, THING)                                                                                                 \
+	if (THING != VK_NULL_HANDLE) {                                                                                 \
+		vk->vkDestroy##TYPE(vk->device, THING, NULL);                                                          \
+		THING = VK_NULL_HANDLE;                                                                                \
+	}
+
+#define DF(TYPE, THING)                                                                                                \
+	if (THING != VK_NULL_HANDLE) {                                                                                 \
+		vk->vkFree##TYPE(vk->device, THING, NULL);                                                             \
+		THING = VK_NULL_HANDLE;                                                                                \
+	}
+
+static VkResult
+create_timeline(struct vk_bundle *vk, VkSemaphore *out_sem)
+{
+#ifdef VK_KHR_timeline_semaphore
+	if (!vk->features.timeline_semaphore) {
+		return VK_SUCCESS;
+	}
+
+	VkSemaphoreTypeCreateInfo type_info = {
+	    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+	    .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+	    .initialValue = 0,
+	};
+
+	VkSemaphoreCreateInfo create_info = {
+	    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+	    .pNext = &type_info,
+	};
+
+	VkResult ret = vk->vkCreateSemaphore(vk->device, &create_info, NULL, out_sem);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkCreateSemaphore: %s", vk_result_string(ret));
+	}
+
+	return ret;
+#else
+	return VK_SUCCESS;
+#endif
+}
+
+static void
+wait_frame(struct comp_cross_gpu *ccg, uint32_t index)
+{
+	struct vk_bundle *vk = ccg->display_vk;
+
+	if (ccg->frames[index].cmd == VK_NULL_HANDLE) {
+		return;
+	}
+
+#ifdef VK_KHR_timeline_semaphore
+	if (ccg->display_timeline != VK_NULL_HANDLE) {
+		VkSemaphoreWaitInfo wait_info = {
+		    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+		    .semaphoreCount = 1,
+		    .pSemaphores = &ccg->display_timeline,
+		    .pValues = &ccg->frames[index].value,
+		};
+
+		VkResult ret = vk->vkWaitSemaphores(vk->device, &wait_info, UINT64_MAX);
+		if (ret != VK_SUCCESS) {
+			VK_ERROR(vk, "vkWaitSemaphores: %s", vk_result_string(ret));
+		}
+	}
+#endif
+
+	vk_cmd_pool_lock(&ccg->display_pool);
+	vk->vkFreeCommandBuffers(vk->device, ccg->display_pool.pool, 1, &ccg->frames[index].cmd);
+	vk_cmd_pool_unlock(&ccg->display_pool);
+
+	ccg->frames[index].cmd = VK_NULL_HANDLE;
+}
+
+//! Host visible, coherent and mapped for the life time of the buffer.
+static VkResult
+staging_init(struct vk_bundle *vk, VkDeviceSize size, VkBufferUsageFlags usage, bool readback, struct vk_buffer *buf)
+{
+	VkMemoryPropertyFlags memory_property_flags = //
+	    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |     //
+	    VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;     //
+
+	// Reading uncached memory with the CPU is very slow, use cached if there is any.
+	uint32_t type_id = 0;
+	VkMemoryPropertyFlags cached = memory_property_flags | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+	if (readback && vk_get_memory_type(vk, UINT32_MAX, cached, &type_id)) {
+		memory_property_flags = cached;
+	}
+
+	bool bret = vk_buffer_init( //
+	    vk,                     //
+	    size,                   //
+	    usage,                  //
+	    memory_property_flags,  //
+	    &buf->handle,           //
+	    &buf->memory);          //
+	if (!bret) {
+		return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+	}
+	buf->size = (uint32_t)size;
+
+	VkResult ret = vk->vkMapMemory( //
+	    vk->device,                 // device
+	    buf->memory,                // memory
+	    0,                          // offset
+	    VK_WHOLE_SIZE,              // size
+	    0,                          // flags
+	    &buf->data);                // ppData
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkMapMemory: %s", vk_result_string(ret));
+	}
+
+	return ret;
+}
+
+static void
+staging_fini(struct vk_bundle *vk, struct vk_buffer *buf)
+{
+	D(Buffer, buf->handle);
+	DF(Memory, buf->memory); // Implicitly unmaps.
+	buf->data = NULL;
+}
+
+static VkBufferImageCopy
+get_copy_region(const struct comp_cross_gpu_swapchain *ccgs)
+{
+	// The same tightly packed layout is used for both copies.
+	VkBufferImageCopy region = {
+	    .bufferOffset = 0,
+	    .bufferRowLength = 0,
+	    .bufferImageHeight = 0,
+	    .imageSubresource =
+	        {
+	            .aspectMask = ccgs->aspect,
+	            .mipLevel = 0,
+	            .baseArrayLayer = 0,
+	            .layerCount = ccgs->layer_count,
+	        },
+	    .imageOffset = {0, 0, 0},
+	    .imageExtent = {ccgs->vkic.info.width, ccgs->vkic.info.height, 1},
+	};
+
+	return region;
+}
+
+static VkImageSubresourceRange
+get_barrier_range(const struct comp_cross_gpu_swapchain *ccgs)
+{
+	VkImageSubresourceRange subresource_range = {
+	    .aspectMask = vk_csci_get_barrier_aspect_mask((VkFormat)ccgs->vkic.info.format),
+	    .baseMipLevel = 0,
+	    .levelCount = 1,
+	    .baseArrayLayer = 0,
+	    .layerCount = ccgs->layer_count,
+	};
+
+	return subresource_range;
+}
+
+static void
+record_render_copy(struct vk_bundle *vk, VkCommandBuffer cmd, struct comp_cross_gpu_swapchain *ccgs, uint32_t index)
+{
+	VkImage image = ccgs->vkic.images[index].handle;
+	VkImageSubresourceRange subresource_range = get_barrier_range(ccgs);
+	VkBufferImageCopy region = get_copy_region(ccgs);
+
+	// Same as the renderer does when it samples the images directly.
+	vk_cmd_image_barrier_acquire_external_locked( //
+	    vk,                                       //
+	    cmd,                                      //
+	    image,                                    //
+	    VK_ACCESS_TRANSFER_READ_BIT,              //
+	    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, //
+	    VK_PIPELINE_STAGE_TRANSFER_BIT,           //
+	    subresource_range);                       //
+
+	vk_cmd_image_barrier_locked(                  //
+	    vk,                                       //
+	    cmd,                                      //
+	    image,                                    //
+	    VK_ACCESS_TRANSFER_READ_BIT,              //
+	    VK_ACCESS_TRANSFER_READ_BIT,              //
+	    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, //
+	    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,     //
+	    VK_PIPELINE_STAGE_TRANSFER_BIT,           //
+	    VK_PIPELINE_STAGE_TRANSFER_BIT,           //
+	    subresource_range);                       //
+
+	vk->vkCmdCopyImageToBuffer(                    //
+	    cmd,                                       // commandBuffer
+	    image,                                     // srcImage
+	    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,      // srcImageLayout
+	    ccgs->images[index].render_staging.handle, // dstBuffer
+	    1,                                         // regionCount
+	    &region);                                  // pRegions
+
+	// Back to the layout the application left it in.
+	vk_cmd_image_barrier_locked(                  //
+	    vk,                                       //
+	    cmd,                                      //
+	    image,                                    //
+	    VK_ACCESS_TRANSFER_READ_BIT,              //
+	    0,                                        //
+	    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,     //
+	    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, //
+	    VK_PIPELINE_STAGE_TRANSFER_BIT,           //
+	    VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,     //
+	    subresource_range);                       //
+}
+
+static void
+record_display_copy(struct vk_bundle *vk,
+                    VkCommandBuffer cmd,
+                    struct comp_swapchain *sc,
+                    uint32_t index,
+                    struct vk_buffer *staging)
+{
+	struct comp_cross_gpu_swapchain *ccgs = sc->cross;
+	VkImage image = sc->vkic.images[index].handle;
+	VkImageSubresourceRange subresource_range = get_barrier_range(ccgs);
+	VkBufferImageCopy region = get_copy_region(ccgs);
+
+	// Old content is not needed, mip zero of all layers is overwritten.
+	vk_cmd_image_barrier_locked(              //
+	    vk,                                   //
+	    cmd,                                  //
+	    image,                                //
+	    0,                                    //
+	    VK_ACCESS_TRANSFER_WRITE_BIT,         //
+	    VK_IMAGE_LAYOUT_UNDEFINED,            //
+	    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, //
+	    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,    //
+	    VK_PIPELINE_STAGE_TRANSFER_BIT,       //
+	    subresource_range);                   //
+
+	vk->vkCmdCopyBufferToImage(               //
+	    cmd,                                  // commandBuffer
+	    staging->handle,                      // srcBuffer
+	    image,                                // dstImage
+	    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, // dstImageLayout
+	    1,                                    // regionCount
+	    &region);                             // pRegions
+
+	vk_cmd_image_barrier_gpu_locked(              //
+	    vk,                                       //
+	    cmd,                                      //
+	    image,                                    //
+	    VK_ACCESS_TRANSFER_WRITE_BIT,             //
+	    VK_ACCESS_SHADER_READ_BIT,                //
+	    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,     //
+	    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, //
+	    subresource_range);                       //
+}
+
+//! Called with the render pool locked, returns the number of images recorded.
+static uint32_t
+record_render_copies_locked(struct comp_cross_gpu *ccg,
+                            VkCommandBuffer cmd,
+                            const struct comp_layer *layers,
+                            uint32_t layer_count)
+{
+	struct vk_bundle *vk = &ccg->render_vk;
+	uint32_t count = 0;
+
+	for (uint32_t l = 0; l < layer_count; l++) {
+		for (uint32_t s = 0; s < ARRAY_SIZE(layers[l].sc_array); s++) {
+			struct comp_swapchain *sc = layers[l].sc_array[s];
+			if (sc == NULL || sc->cross == NULL) {
+				continue;
+			}
+
+			// Images released since the last copy are the ones the frame uses.
+			for (uint32_t i = 0; i < sc->vkic.image_count; i++) {
+				struct comp_cross_gpu_image *image = &sc->cross->images[i];
+				if (!image->dirty) {
+					continue;
+				}
+
+				// Also makes swapchains used by several layers only copy once.
+				image->dirty = false;
+				image->pending = true;
+
+				record_render_copy(vk, cmd, sc->cross, i);
+				count++;
+			}
+		}
+	}
+
+	return count;
+}
+
+static VkResult
+submit_display_locked(struct comp_cross_gpu *ccg, VkCommandBuffer cmd, uint64_t value)
+{
+	struct vk_bundle *vk = ccg->display_vk;
+
+	const void *next = NULL;
+	uint32_t signal_count = 0;
+
+#ifdef VK_KHR_timeline_semaphore
+	VkTimelineSemaphoreSubmitInfoKHR timeline_info = {
+	    .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR,
+	    .signalSemaphoreValueCount = 1,
+	    .pSignalSemaphoreValues = &value,
+	};
+
+	if (ccg->display_timeline != VK_NULL_HANDLE) {
+		next = &timeline_info;
+		signal_count = 1;
+	}
+#endif
+
+	VkSubmitInfo submit_info = {
+	    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+	    .pNext = next,
+	    .commandBufferCount = 1,
+	    .pCommandBuffers = &cmd,
+	    .signalSemaphoreCount = signal_count,
+	    .pSignalSemaphores = &ccg->display_timeline,
+	};
+
+	return vk_cmd_submit_locked(vk, 1, &submit_info, VK_NULL_HANDLE);
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+xrt_result_t
+comp_cross_gpu_create(struct vk_bundle *display_vk,
+                      int render_gpu_index,
+                      struct u_string_list *required_device_extensions,
+                      struct u_string_list *optional_device_extensions,
+                      struct comp_cross_gpu **out_ccg)
+{
+	struct comp_cross_gpu *ccg = U_TYPED_CALLOC(struct comp_cross_gpu);
+	struct vk_bundle *vk = &ccg->render_vk;
+	VkResult ret;
+
+	ccg->display_vk = display_vk;
+
+	// Shares the instance and its functions, the device functions are replaced.
+	*vk = *display_vk;
+	vk->device = VK_NULL_HANDLE;
+	vk->queue = VK_NULL_HANDLE;
+
+	struct vk_device_features device_features = {
+	    .timeline_semaphore = display_vk->features.timeline_semaphore,
+	};
+
+	ret = vk_create_device(                  //
+	    vk,                                  //
+	    render_gpu_index,                    //
+	    false,                               // compute_only
+	    VK_QUEUE_GLOBAL_PRIORITY_MEDIUM_EXT, // global_priority
+	    required_device_extensions,          //
+	    optional_device_extensions,          //
+	    &device_features);                   // optional_device_features
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(display_vk, "vk_create_device: %s", vk_result_string(ret));
+		free(ccg);
+		return XRT_ERROR_VULKAN;
+	}
+
+	ret = vk_init_mutex(vk);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vk_init_mutex: %s", vk_result_string(ret));
+		vk->vkDestroyDevice(vk->device, NULL);
+		free(ccg);
+		return XRT_ERROR_VULKAN;
+	}
+
+	ret = vk_cmd_pool_init(vk, &ccg->render_pool, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vk_cmd_pool_init: %s", vk_result_string(ret));
+		goto err_destroy;
+	}
+
+	ret = vk_cmd_pool_init(display_vk, &ccg->display_pool, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(display_vk, "vk_cmd_pool_init: %s", vk_result_string(ret));
+		goto err_destroy;
+	}
+
+	ret = create_timeline(display_vk, &ccg->display_timeline);
+	if (ret != VK_SUCCESS) {
+		goto err_destroy;
+	}
+
+	VK_INFO(vk, "Applications render on GPU %i, images are copied to the compositor GPU through host memory.",
+	        render_gpu_index);
+	vk_print_opened_device_info(vk, U_LOGGING_INFO);
+
+	*out_ccg = ccg;
+
+	return XRT_SUCCESS;
+
+err_destroy:
+	comp_cross_gpu_destroy(&ccg);
+
+	return XRT_ERROR_VULKAN;
+}
+
+void
+comp_cross_gpu_destroy(struct comp_cross_gpu **ccg_ptr)
+{
+	struct comp_cross_gpu *ccg = *ccg_ptr;
+	if (ccg == NULL) {
+		return;
+	}
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(ccg->frames); i++) {
+		wait_frame(ccg, i);
+	}
+
+	struct vk_bundle *vk = ccg->display_vk;
+	D(Semaphore, ccg->display_timeline);
+	vk_cmd_pool_destroy(vk, &ccg->display_pool);
+
+	vk = &ccg->render_vk;
+	if (vk->device != VK_NULL_HANDLE) {
+		vk->vkDeviceWaitIdle(vk->device);
+		vk_cmd_pool_destroy(vk, &ccg->render_pool);
+		vk->vkDestroyDevice(vk->device, NULL);
+		vk->device = VK_NULL_HANDLE;
+	}
+	vk_deinit_mutex(vk);
+
+	free(ccg);
+	*ccg_ptr = NULL;
+}
+
+xrt_result_t
+comp_cross_gpu_swapchain_create(struct comp_cross_gpu *ccg,
+                                const struct xrt_swapchain_create_info *info,
+                                struct xrt_image_native *native_images,
+                                uint32_t image_count,
+                                struct comp_cross_gpu_swapchain **out_ccgs)
+{
+	struct comp_cross_gpu_swapchain *ccgs = U_TYPED_CALLOC(struct comp_cross_gpu_swapchain);
+	struct vk_bundle *vk = &ccg->render_vk;
+	VkResult ret;
+
+	// The images are the copy source.
+	struct xrt_swapchain_create_info render_info = *info;
+	render_info.bits |= XRT_SWAPCHAIN_USAGE_TRANSFER_SRC;
+
+	if (native_images != NULL) {
+		ret = vk_ic_from_natives(vk, &render_info, native_images, image_count, &ccgs->vkic);
+	} else {
+		ret = vk_ic_allocate(vk, &render_info, image_count, &ccgs->vkic);
+	}
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "Failed to create images on the render GPU: %s", vk_result_string(ret));
+		free(ccgs);
+		return ret == VK_ERROR_FORMAT_NOT_SUPPORTED ? XRT_ERROR_SWAPCHAIN_FORMAT_UNSUPPORTED : XRT_ERROR_VULKAN;
+	}
+
+	VkFormat format = (VkFormat)info->format;
+	ccgs->aspect = vk_csci_get_image_view_aspect(format, info->bits);
+	ccgs->layer_count = info->array_size * info->face_count;
+
+	for (uint32_t i = 0; i < ccgs->vkic.image_count; i++) {
+		struct comp_cross_gpu_image *image = &ccgs->images[i];
+
+		// Never smaller than the tightly packed mip zero of all layers.
+		VkDeviceSize size = ccgs->vkic.images[i].size;
+
+		ret = staging_init(vk, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, true, &image->render_staging);
+		if (ret != VK_SUCCESS) {
+			goto err_destroy;
+		}
+
+		for (uint32_t k = 0; k < ARRAY_SIZE(image->display_staging); k++) {
+			ret = staging_init(ccg->display_vk, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, false,
+			                   &image->display_staging[k]);
+			if (ret != VK_SUCCESS) {
+				goto err_destroy;
+			}
+		}
+	}
+
+	*out_ccgs = ccgs;
+
+	return XRT_SUCCESS;
+
+err_destroy:
+	comp_cross_gpu_swapchain_destroy(ccg, &ccgs);
+
+	return XRT_ERROR_VULKAN;
+}
+
+void
+comp_cross_gpu_swapchain_destroy(struct comp_cross_gpu *ccg, struct comp_cross_gpu_swapchain **ccgs_ptr)
+{
+	struct comp_cross_gpu_swapchain *ccgs = *ccgs_ptr;
+	if (ccgs == NULL) {
+		return;
+	}
+
+	// Any copy from the staging buffers might still be running.
+	for (uint32_t i = 0; i < ARRAY_SIZE(ccg->frames); i++) {
+		wait_frame(ccg, i);
+	}
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(ccgs->images); i++) {
+		struct comp_cross_gpu_image *image = &ccgs->images[i];
+
+		staging_fini(&ccg->render_vk, &image->render_staging);
+		for (uint32_t k = 0; k < ARRAY_SIZE(image->display_staging); k++) {
+			staging_fini(ccg->display_vk, &image->display_staging[k]);
+		}
+	}
+
+	vk_ic_destroy(&ccg->render_vk, &ccgs->vkic);
+
+	free(ccgs);
+	*ccgs_ptr = NULL;
+}
+
+void
+comp_cross_gpu_transfer_layers(struct comp_cross_gpu *ccg, const struct comp_layer *layers, uint32_t layer_count)
+{
+	COMP_TRACE_MARKER();
+
+	struct vk_bundle *rvk = &ccg->render_vk;
+	struct vk_bundle *dvk = ccg->display_vk;
+	VkCommandBuffer cmd = VK_NULL_HANDLE;
+	VkResult ret;
+
+	if (layer_count > COMP_MAX_LAYERS) {
+		layer_count = COMP_MAX_LAYERS;
+	}
+
+
+	/*
+	 * Render GPU, copy into host memory and wait for it.
+	 */
+
+	vk_cmd_pool_lock(&ccg->render_pool);
+
+	ret = vk_cmd_pool_create_and_begin_cmd_buffer_locked( //
+	    rvk,                                              //
+	    &ccg->render_pool,                                //
+	    VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,      //
+	    &cmd);                                            //
+	if (ret != VK_SUCCESS) {
+		vk_cmd_pool_unlock(&ccg->render_pool);
+		return;
+	}
+
+	uint32_t count = record_render_copies_locked(ccg, cmd, layers, layer_count);
+	if (count == 0) {
+		rvk->vkEndCommandBuffer(cmd);
+		rvk->vkFreeCommandBuffers(rvk->device, ccg->render_pool.pool, 1, &cmd);
+		vk_cmd_pool_unlock(&ccg->render_pool);
+		return;
+	}
+
+	// The display copy below needs the data, so this has to be waited on.
+	ret = vk_cmd_pool_end_submit_wait_and_free_cmd_buffer_locked(rvk, &ccg->render_pool, cmd);
+	vk_cmd_pool_unlock(&ccg->render_pool);
+	if (ret != VK_SUCCESS) {
+		return;
+	}
+
+
+	/*
+	 * Host memory bounce, the ring slot is reused every other frame.
+	 */
+
+	uint32_t frame = ccg->next_frame;
+	ccg->next_frame = (frame + 1) % COMP_CROSS_GPU_RING_SIZE;
+
+	wait_frame(ccg, frame);
+
+	vk_cmd_pool_lock(&ccg->display_pool);
+
+	ret = vk_cmd_pool_create_and_begin_cmd_buffer_locked( //
+	    dvk,                                              //
+	    &ccg->display_pool,                               //
+	    VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,      //
+	    &cmd);                                            //
+	if (ret != VK_SUCCESS) {
+		vk_cmd_pool_unlock(&ccg->display_pool);
+		return;
+	}
+
+	for (uint32_t l = 0; l < layer_count; l++) {
+		for (uint32_t s = 0; s < ARRAY_SIZE(layers[l].sc_array); s++) {
+			struct comp_swapchain *sc = layers[l].sc_array[s];
+			if (sc == NULL || sc->cross == NULL) {
+				continue;
+			}
+
+			for (uint32_t i = 0; i < sc->vkic.image_count; i++) {
+				struct comp_cross_gpu_image *image = &sc->cross->images[i];
+				if (!image->pending) {
+					continue;
+				}
+
+				struct vk_buffer *staging = &image->display_staging[frame];
+				memcpy(staging->data, image->render_staging.data, staging->size);
+				record_display_copy(dvk, cmd, sc, i, staging);
+
+				image->pending = false;
+			}
+		}
+	}
+
+	// Without timeline semaphores there is nothing to wait on later, so wait now.
+	if (ccg->display_timeline == VK_NULL_HANDLE) {
+		vk_cmd_pool_end_submit_wait_and_free_cmd_buffer_locked(dvk, &ccg->display_pool, cmd);
+		vk_cmd_pool_unlock(&ccg->display_pool);
+		return;
+	}
+
+	ret = dvk->vkEndCommandBuffer(cmd);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(dvk, "vkEndCommandBuffer: %s", vk_result_string(ret));
+		dvk->vkFreeCommandBuffers(dvk->device, ccg->display_pool.pool, 1, &cmd);
+		vk_cmd_pool_unlock(&ccg->display_pool);
+		return;
+	}
+
+	uint64_t value = ccg->display_timeline_value + 1;
+	ret = submit_display_locked(ccg, cmd, value);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(dvk, "vk_cmd_submit_locked: %s", vk_result_string(ret));
+		dvk->vkFreeCommandBuffers(dvk->device, ccg->display_pool.pool, 1, &cmd);
+		vk_cmd_pool_unlock(&ccg->display_pool);
+		return;
+	}
+
+	vk_cmd_pool_unlock(&ccg->display_pool);
+
+	ccg->frames[frame].cmd = cmd;
+	ccg->frames[frame].value = value;
+	ccg->display_timeline_value = value;
+}
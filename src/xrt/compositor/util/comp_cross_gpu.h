@@ -0,0 +1,166 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Copies swapchain images rendered on another GPU to the compositor GPU.
+ * @ingroup comp_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_compositor.h"
+
+#include "vk/vk_helpers.h"
+#include "vk/vk_cmd_pool.h"
+#include "vk/vk_image_allocator.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct comp_layer;
+struct u_string_list;
+
+//! Number of frames the copies to the compositor GPU can be in flight for.
+#define COMP_CROSS_GPU_RING_SIZE (2)
+
+/*!
+ * Staging state for one swapchain image.
+ *
+ * @ingroup comp_util
+ */
+struct comp_cross_gpu_image
+{
+	//! On the render GPU, the image is copied into it, mapped.
+	struct vk_buffer render_staging;
+
+	//! On the compositor GPU, one per in flight frame, mapped.
+	struct vk_buffer display_staging[COMP_CROSS_GPU_RING_SIZE];
+
+	//! The application has released the image since it was last copied.
+	bool dirty;
+
+	//! Copied to @ref render_staging, waiting to be copied to the compositor GPU.
+	bool pending;
+};
+
+/*!
+ * The render GPU side of a @ref comp_swapchain, the images given to the
+ * application live on the render GPU and are copied to the images of the
+ * swapchain, on the compositor GPU, when a frame that uses them is committed.
+ *
+ * @ingroup comp_util
+ */
+struct comp_cross_gpu_swapchain
+{
+	//! Images on the render GPU, the ones handed to the application.
+	struct vk_image_collection vkic;
+
+	//! Aspect that is copied, depth only for depth stencil formats.
+	VkImageAspectFlags aspect;
+
+	//! All array layers and faces.
+	uint32_t layer_count;
+
+	struct comp_cross_gpu_image images[XRT_MAX_SWAPCHAIN_IMAGES];
+};
+
+/*!
+ * A second device on the GPU applications render on, sharing the instance with
+ * the compositor, for systems where the display is on a different GPU like
+ * laptops with hybrid graphics.
+ *
+ * The images are copied through host memory: the render GPU copies them into
+ * a mapped buffer, the CPU copies that into a buffer on the compositor GPU,
+ * which then copies it into the image of the swapchain. The last copy is not
+ * waited on, a ring of staging buffers lets it run while the next frame is
+ * being copied on the render GPU.
+ *
+ * @ingroup comp_util
+ */
+struct comp_cross_gpu
+{
+	//! The compositor device, not owned.
+	struct vk_bundle *display_vk;
+
+	//! Device on the render GPU, shares the instance with @ref display_vk.
+	struct vk_bundle render_vk;
+
+	//! For copies on the render GPU.
+	struct vk_cmd_pool render_pool;
+
+	//! For copies on the compositor GPU.
+	struct vk_cmd_pool display_pool;
+
+	//! Signaled by the copies on the compositor GPU, only if timeline semaphores are enabled.
+	VkSemaphore display_timeline;
+	uint64_t display_timeline_value;
+
+	//! Copies on the compositor GPU in flight, indexed the same as the display staging buffers.
+	struct
+	{
+		VkCommandBuffer cmd;
+		uint64_t value;
+	} frames[COMP_CROSS_GPU_RING_SIZE];
+
+	//! Frame ring index of the next transfer.
+	uint32_t next_frame;
+};
+
+/*!
+ * Creates the device on the GPU with index @p render_gpu_index, it is created
+ * with the same extensions as the compositor device so images can be exported.
+ *
+ * @ingroup comp_util
+ */
+xrt_result_t
+comp_cross_gpu_create(struct vk_bundle *display_vk,
+                      int render_gpu_index,
+                      struct u_string_list *required_device_extensions,
+                      struct u_string_list *optional_device_extensions,
+                      struct comp_cross_gpu **out_ccg);
+
+/*!
+ * Waits for all copies and destroys the device.
+ *
+ * @ingroup comp_util
+ */
+void
+comp_cross_gpu_destroy(struct comp_cross_gpu **ccg_ptr);
+
+/*!
+ * Allocates the render GPU images and staging buffers for a swapchain. If
+ * @p native_images is not NULL the images are imported instead of allocated.
+ *
+ * @ingroup comp_util
+ */
+xrt_result_t
+comp_cross_gpu_swapchain_create(struct comp_cross_gpu *ccg,
+                                const struct xrt_swapchain_create_info *info,
+                                struct xrt_image_native *native_images,
+                                uint32_t image_count,
+                                struct comp_cross_gpu_swapchain **out_ccgs);
+
+/*!
+ * Frees the render GPU images and staging buffers.
+ *
+ * @ingroup comp_util
+ */
+void
+comp_cross_gpu_swapchain_destroy(struct comp_cross_gpu *ccg, struct comp_cross_gpu_swapchain **ccgs_ptr);
+
+/*!
+ * Copies all images used by @p layers that have been released since they were
+ * last copied to the compositor GPU. The copies are submitted to the queue of
+ * the compositor before this returns, so any later submission sees them.
+ *
+ * @ingroup comp_util
+ */
+void
+comp_cross_gpu_transfer_layers(struct comp_cross_gpu *ccg, const struct comp_layer *layers, uint32_t layer_count);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -15,6 +15,7 @@
 #include "util/u_trace_marker.h"
 
 #include "util/comp_swapchain.h"
+#include "util/comp_cross_gpu.h"
 #include "vk/vk_cmd_pool.h"
 
 #include <stdio.h>
@@ -98,6 +99,37 @@ swapchain_dec_image_use(struct xrt_swapchain *xsc, uint32_t index)
 	return XRT_SUCCESS;
 }
 
+static xrt_result_t
+wait_release_semaphore(struct comp_swapchain *sc, uint64_t timeout_ns, uint32_t index)
+{
+#ifdef VK_KHR_timeline_semaphore
+	struct vk_bundle *vk = sc->vk;
+	uint64_t value = sc->images[index].release_value;
+
+	if (sc->release.semaphore == VK_NULL_HANDLE || value == 0) {
+		return XRT_SUCCESS;
+	}
+
+	VkSemaphoreWaitInfo wait_info = {
+	    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+	    .semaphoreCount = 1,
+	    .pSemaphores = &sc->release.semaphore,
+	    .pValues = &value,
+	};
+
+	VkResult ret = vk->vkWaitSemaphores(vk->device, &wait_info, timeout_ns);
+	if (ret == VK_TIMEOUT) {
+		return XRT_TIMEOUT;
+	}
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkWaitSemaphores: %s", vk_result_string(ret));
+		return XRT_ERROR_VULKAN;
+	}
+#endif
+
+	return XRT_SUCCESS;
+}
+
 static xrt_result_t
 swapchain_wait_image(struct xrt_swapchain *xsc, uint64_t timeout_ns, uint32_t index)
 {
@@ -105,6 +137,13 @@ swapchain_wait_image(struct xrt_swapchain *xsc, uint64_t timeout_ns, uint32_t in
 
 	SWAPCHAIN_TRACE_BEGIN(swapchain_wait_image);
 
+	// The compositor might still be reading the image on the GPU.
+	xrt_result_t xret = wait_release_semaphore(sc, timeout_ns, index);
+	if (xret != XRT_SUCCESS) {
+		SWAPCHAIN_TRACE_END(swapchain_wait_image);
+		return xret;
+	}
+
 	VK_TRACE(sc->vk, "%p WAIT_IMAGE %d (use %d)", (void *)sc, index, sc->images[index].use_count);
 
 	os_mutex_lock(&sc->images[index].use_mutex);
@@ -191,6 +230,30 @@ swapchain_wait_image(struct xrt_swapchain *xsc, uint64_t timeout_ns, uint32_t in
 	return XRT_SUCCESS;
 }
 
+static xrt_result_t
+swapchain_get_release_semaphore(struct xrt_swapchain *xsc, xrt_graphics_sync_handle_t *out_handle)
+{
+	struct comp_swapchain *sc = comp_swapchain(xsc);
+
+	if (!xrt_graphics_sync_handle_is_valid(sc->release.handle)) {
+		return XRT_ERROR_VULKAN;
+	}
+
+	*out_handle = sc->release.handle;
+
+	return XRT_SUCCESS;
+}
+
+static xrt_result_t
+swapchain_get_release_value(struct xrt_swapchain *xsc, uint32_t index, uint64_t *out_value)
+{
+	struct comp_swapchain *sc = comp_swapchain(xsc);
+
+	*out_value = sc->images[index].release_value;
+
+	return XRT_SUCCESS;
+}
+
 static xrt_result_t
 swapchain_release_image(struct xrt_swapchain *xsc, uint32_t index)
 {
@@ -198,9 +261,15 @@ swapchain_release_image(struct xrt_swapchain *xsc, uint32_t index)
 
 	VK_TRACE(sc->vk, "RELEASE_IMAGE");
 
+	// Has new content that needs to be copied to this GPU.
+	if (sc->cross != NULL) {
+		sc->cross->images[index].dirty = true;
+	}
+
 	int res = u_index_fifo_push(&sc->fifo, index);
 
 	if (res >= 0) {
+		sc->release_count++;
 		return XRT_SUCCESS;
 	}
 	// FIFO full
@@ -232,6 +301,8 @@ set_common_fields(struct comp_swapchain *sc,
 	sc->base.base.inc_image_use = swapchain_inc_image_use;
 	sc->base.base.dec_image_use = swapchain_dec_image_use;
 	sc->base.base.wait_image = swapchain_wait_image;
+	sc->base.base.get_release_semaphore = swapchain_get_release_semaphore;
+	sc->base.base.get_release_value = swapchain_get_release_value;
 	sc->base.base.release_image = swapchain_release_image;
 	sc->base.base.image_count = image_count;
 	sc->real_destroy = destroy_func;
@@ -242,6 +313,7 @@ set_common_fields(struct comp_swapchain *sc,
 	for (uint32_t i = 0; i < ARRAY_SIZE(sc->base.images); i++) {
 		sc->base.images[i].handle = XRT_GRAPHICS_BUFFER_HANDLE_INVALID;
 	}
+	sc->release.handle = XRT_GRAPHICS_SYNC_HANDLE_INVALID;
 
 	return sc;
 }
@@ -274,10 +346,11 @@ do_post_create_vulkan_setup(struct vk_bundle *vk,
 		sc->images[i].array_size = info->array_size;
 
 		for (uint32_t layer = 0; layer < info->array_size; ++layer) {
+			// All levels, the samplers decide if the mips are used.
 			VkImageSubresourceRange subresource_range = {
 			    .aspectMask = image_view_aspect,
 			    .baseMipLevel = 0,
-			    .levelCount = 1,
+			    .levelCount = VK_REMAINING_MIP_LEVELS,
 			    .baseArrayLayer = layer * info->face_count,
 			    .layerCount = info->face_count,
 			};
@@ -299,6 +372,42 @@ do_post_create_vulkan_setup(struct vk_bundle *vk,
 			    components,                            // components
 			    &sc->images[i].views.no_alpha[layer]); // out_view
 		}
+
+		if (info->face_count != 6) {
+			continue;
+		}
+
+		// The compute compositor samples cube layers one face at a time.
+		uint32_t face_view_count = info->array_size * 6;
+		sc->images[i].views.face_alpha = U_TYPED_ARRAY_CALLOC(VkImageView, face_view_count);
+		sc->images[i].views.face_no_alpha = U_TYPED_ARRAY_CALLOC(VkImageView, face_view_count);
+
+		for (uint32_t face = 0; face < face_view_count; ++face) {
+			VkImageSubresourceRange subresource_range = {
+			    .aspectMask = image_view_aspect,
+			    .baseMipLevel = 0,
+			    .levelCount = VK_REMAINING_MIP_LEVELS,
+			    .baseArrayLayer = face,
+			    .layerCount = 1,
+			};
+
+			vk_create_view(                             //
+			    vk,                                     // vk
+			    sc->vkic.images[i].handle,              // image
+			    VK_IMAGE_VIEW_TYPE_2D,                  // type
+			    image_view_format,                      // format
+			    subresource_range,                      // subresource_range
+			    &sc->images[i].views.face_alpha[face]); // out_view
+
+			vk_create_view_swizzle(                        //
+			    vk,                                        // vk
+			    sc->vkic.images[i].handle,                 // image
+			    VK_IMAGE_VIEW_TYPE_2D,                     // type
+			    image_view_format,                         // format
+			    subresource_range,                         // subresource_range
+			    components,                                // components
+			    &sc->images[i].views.face_no_alpha[face]); // out_view
+		}
 	}
 
 	// Prime the fifo
@@ -377,6 +486,76 @@ do_post_create_vulkan_setup(struct vk_bundle *vk,
 
 		sc->images[i].use_count = 0;
 	}
+
+
+	/*
+	 *
+	 * Release semaphore.
+	 *
+	 */
+
+#ifdef VK_KHR_timeline_semaphore
+	// Can't be waited on by a device on another GPU.
+	if (!vk->features.timeline_semaphore || sc->cross != NULL) {
+		return;
+	}
+
+	ret = vk_create_timeline_semaphore_and_native(vk, &sc->release.semaphore, &sc->release.handle);
+	if (ret != VK_SUCCESS) {
+		VK_WARN(vk, "Could not create release semaphore, clients will wait on the CPU: %s",
+		        vk_result_string(ret));
+		sc->release.semaphore = VK_NULL_HANDLE;
+		sc->release.handle = XRT_GRAPHICS_SYNC_HANDLE_INVALID;
+	}
+#endif
+}
+
+/*!
+ * The application renders on another GPU, the images handed out live there and
+ * are copied to the ones allocated here, which are only sampled by the
+ * compositor. Only mip zero is copied so these images only have that.
+ */
+static xrt_result_t
+do_cross_gpu_setup(struct vk_bundle *vk,
+                   const struct xrt_swapchain_create_info *info,
+                   struct xrt_image_native *native_images,
+                   uint32_t image_count,
+                   struct comp_swapchain *sc)
+{
+	struct comp_cross_gpu *ccg = sc->cscs->cross;
+	VkResult ret;
+
+	xrt_result_t xret = comp_cross_gpu_swapchain_create(ccg, info, native_images, image_count, &sc->cross);
+	if (xret != XRT_SUCCESS) {
+		return xret;
+	}
+
+	struct xrt_swapchain_create_info display_info = *info;
+	display_info.bits |= XRT_SWAPCHAIN_USAGE_TRANSFER_DST;
+	display_info.mip_count = 1;
+
+	ret = vk_ic_allocate(vk, &display_info, image_count, &sc->vkic);
+	if (ret != VK_SUCCESS) {
+		comp_cross_gpu_swapchain_destroy(ccg, &sc->cross);
+		return XRT_ERROR_VULKAN;
+	}
+
+	// Imported images are already owned by the application.
+	if (native_images == NULL) {
+		struct vk_image_collection *render_vkic = &sc->cross->vkic;
+		xrt_graphics_buffer_handle_t handles[ARRAY_SIZE(render_vkic->images)];
+
+		vk_ic_get_handles(&ccg->render_vk, render_vkic, ARRAY_SIZE(handles), handles);
+		for (uint32_t i = 0; i < render_vkic->image_count; i++) {
+			sc->base.images[i].handle = handles[i];
+			sc->base.images[i].size = render_vkic->images[i].size;
+			sc->base.images[i].use_dedicated_allocation = render_vkic->images[i].use_dedicated_allocation;
+		}
+	}
+
+	do_post_create_vulkan_setup(vk, &display_info, sc);
+
+	return XRT_SUCCESS;
 }
 
 static void
@@ -420,6 +599,8 @@ image_cleanup(struct vk_bundle *vk, struct comp_swapchain_image *image)
 
 	clean_image_views(vk, image->array_size, &image->views.alpha);
 	clean_image_views(vk, image->array_size, &image->views.no_alpha);
+	clean_image_views(vk, image->array_size * 6, &image->views.face_alpha);
+	clean_image_views(vk, image->array_size * 6, &image->views.face_no_alpha);
 }
 
 /*!
@@ -469,6 +650,10 @@ comp_swapchain_create_init(struct comp_swapchain *sc,
 
 	set_common_fields(sc, destroy_func, vk, cscs, xsccp->image_count);
 
+	if (cscs->cross != NULL) {
+		return do_cross_gpu_setup(vk, info, NULL, xsccp->image_count, sc);
+	}
+
 	// Use the image helper to allocate the images.
 	ret = vk_ic_allocate(vk, info, xsccp->image_count, &sc->vkic);
 	if (ret == VK_ERROR_FEATURE_NOT_PRESENT) {
@@ -513,6 +698,10 @@ comp_swapchain_import_init(struct comp_swapchain *sc,
 
 	set_common_fields(sc, destroy_func, vk, cscs, native_image_count);
 
+	if (cscs->cross != NULL) {
+		return do_cross_gpu_setup(vk, info, native_images, native_image_count, sc);
+	}
+
 	// Use the image helper to get the images.
 	ret = vk_ic_from_natives(vk, info, native_images, native_image_count, &sc->vkic);
 	if (ret != VK_SUCCESS) {
@@ -552,6 +741,25 @@ comp_swapchain_teardown(struct comp_swapchain *sc)
 	}
 
 	vk_ic_destroy(vk, &sc->vkic);
+
+	D(Semaphore, sc->release.semaphore);
+	u_graphics_sync_unref(&sc->release.handle);
+
+	if (sc->cross != NULL) {
+		comp_cross_gpu_swapchain_destroy(sc->cscs->cross, &sc->cross);
+	}
+}
+
+bool
+comp_swapchain_mark_image_read(struct comp_swapchain *sc, uint32_t index, uint64_t value)
+{
+	if (sc->release.semaphore == VK_NULL_HANDLE || index >= sc->vkic.image_count) {
+		return false;
+	}
+
+	sc->images[index].release_value = value;
+
+	return true;
 }
 
 
@@ -46,6 +46,9 @@ struct comp_swapchain_shared
 	struct u_threading_stack destroy_swapchains;
 
 	struct vk_cmd_pool pool;
+
+	//! Set when applications render on another GPU than the compositor, swapchains are then copied over.
+	struct comp_cross_gpu *cross;
 };
 
 /*!
@@ -61,6 +64,10 @@ struct comp_swapchain_image
 	{
 		VkImageView *alpha;
 		VkImageView *no_alpha;
+
+		//! Only for cube swapchains, a 2D view of each face, six per array layer.
+		VkImageView *face_alpha;
+		VkImageView *face_no_alpha;
 	} views;
 	//! The number of array slices in a texture, 1 == regular 2D texture.
 	size_t array_size;
@@ -73,6 +80,9 @@ struct comp_swapchain_image
 
 	//! A mutex per swapchain image that is used with @ref use_cond.
 	struct os_mutex use_mutex;
+
+	//! Value @ref comp_swapchain::release reaches once the compositor is done reading this image.
+	uint64_t release_value;
 };
 
 /*!
@@ -104,6 +114,28 @@ struct comp_swapchain
 	 */
 	struct u_index_fifo fifo;
 
+	/*!
+	 * Incremented on every release, the app has written new content to the
+	 * swapchain if this changed, used by the renderer to skip work.
+	 */
+	uint64_t release_count;
+
+	/*!
+	 * Timeline semaphore signaled as the compositor finishes reading the
+	 * images, lets applications wait for images on the GPU. Only created if
+	 * timeline semaphores are enabled and can be exported.
+	 */
+	struct
+	{
+		VkSemaphore semaphore;
+
+		//! Exported handle, owned by the swapchain.
+		xrt_graphics_sync_handle_t handle;
+	} release;
+
+	//! The images the application renders to if it is on another GPU, @ref vkic is then only a copy.
+	struct comp_cross_gpu_swapchain *cross;
+
 	//! Virtual real destroy function.
 	comp_swapchain_destroy_func_t real_destroy;
 };
@@ -173,6 +205,14 @@ comp_swapchain_import_init(struct comp_swapchain *sc,
 void
 comp_swapchain_teardown(struct comp_swapchain *sc);
 
+/*!
+ * Record that the compositor reads image @p index in work that signals the
+ * release semaphore of @p sc with @p value, returns false if the swapchain
+ * has no release semaphore.
+ */
+bool
+comp_swapchain_mark_image_read(struct comp_swapchain *sc, uint32_t index, uint64_t value);
+
 
 /*
  *
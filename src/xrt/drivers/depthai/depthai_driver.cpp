@@ -61,6 +61,7 @@ DEBUG_GET_ONCE_NUM_OPTION(depthai_startup_wait_frames, "DEPTHAI_STARTUP_WAIT_FRA
 DEBUG_GET_ONCE_NUM_OPTION(depthai_imu_hz, "DEPTHAI_IMU_HZ", 500)
 DEBUG_GET_ONCE_NUM_OPTION(depthai_imu_batch_size, "DEPTHAI_IMU_BATCH_SIZE", 2)
 DEBUG_GET_ONCE_NUM_OPTION(depthai_imu_max_batch_size, "DEPTHAI_IMU_MAX_BATCH_SIZE", 2)
+DEBUG_GET_ONCE_NUM_OPTION(depthai_rgb_downscale, "DEPTHAI_RGB_DOWNSCALE", 1)
 
 
 
@@ -731,6 +732,22 @@ depthai_setup_monocular_pipeline(struct depthai_fs *depthai, enum depthai_camera
 	default: assert(false);
 	}
 
+	/*
+	 * Have the ISP scale colour frames down on the device, instead of
+	 * sending full size frames over USB that the host then shrinks.
+	 */
+	uint32_t downscale = 1;
+	if (depthai->format == XRT_FORMAT_R8G8B8) {
+		long option = debug_get_num_option_depthai_rgb_downscale();
+		if (option < 1 || option > 4) {
+			DEPTHAI_WARN(depthai, "Downscale of %ld not in 1-4, not downscaling.", option);
+		} else {
+			downscale = (uint32_t)option;
+		}
+		depthai->width /= downscale;
+		depthai->height /= downscale;
+	}
+
 	dai::Pipeline p = {};
 
 	auto xlinkOut = p.create<dai::node::XLinkOut>();
@@ -743,6 +760,9 @@ depthai_setup_monocular_pipeline(struct depthai_fs *depthai, enum depthai_camera
 		colorCam = p.create<dai::node::ColorCamera>();
 		colorCam->setPreviewSize(depthai->width, depthai->height);
 		colorCam->setResolution(depthai->color_sensor_resolution);
+		if (downscale > 1) {
+			colorCam->setIspScale(1, (int)downscale);
+		}
 		colorCam->setImageOrientation(depthai->image_orientation);
 		colorCam->setInterleaved(depthai->interleaved);
 		colorCam->setFps(depthai->fps);
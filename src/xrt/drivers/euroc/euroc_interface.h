@@ -10,6 +10,7 @@
 #pragma once
 
 #include "util/u_logging.h"
+#include "tracking/t_tracking.h"
 #include "xrt/xrt_frameserver.h"
 
 #ifdef __cplusplus
@@ -47,6 +48,9 @@ struct euroc_player_playback_config
 	bool use_source_ts;       //!< If true, use the original timestamps from the dataset
 	bool play_from_start;     //!< If set, the euroc player does not wait for user input to start
 	bool print_progress;      //!< Whether to print progress to stdout (useful for CLI runs)
+	int prefetch_count;       //!< Frames decoded ahead on worker threads, 0 decodes on the playback thread
+	bool prefetch_all;        //!< Decode the whole dataset into RAM before playing, ignores @ref prefetch_count
+	int decode_threads;       //!< Number of worker threads decoding frames when prefetching
 };
 
 /*!
@@ -59,7 +63,8 @@ struct euroc_player_dataset_info
 	char path[256];
 	int cam_count;
 	bool is_colored;
-	bool has_gt; //!< Whether this dataset has groundtruth data available
+	bool has_gt;       //!< Whether this dataset has groundtruth data available
+	bool is_container; //!< Whether `path` is a single file container, see @ref aux_tracking_dataset
 	const char *gt_device_name;
 	uint32_t width;
 	uint32_t height;
@@ -101,13 +106,44 @@ euroc_player_create(struct xrt_frame_context *xfctx, const char *path, struct eu
 struct xrt_auto_prober *
 euroc_create_auto_prober(void);
 
+/*!
+ * Convert the EuRoC dataset directory @p euroc_path into a single file
+ * container at @p out_path, images are decoded once and stored raw.
+ *
+ * @ingroup drv_euroc
+ */
+bool
+euroc_convert_to_container(const char *euroc_path, const char *out_path);
+
+/*!
+ * Convert the container at @p in_path back into a EuRoC dataset directory at
+ * @p out_path, images are saved as PNG.
+ *
+ * @ingroup drv_euroc
+ */
+bool
+euroc_convert_from_container(const char *in_path, const char *out_path);
+
+/*!
+ * Outcome of a @ref euroc_run_dataset call.
+ *
+ * @ingroup drv_euroc
+ */
+struct euroc_run_result
+{
+	bool completed;                //!< False if the run was cut short by its exit condition
+	double duration_s;             //!< Wall time from tracker creation to the end of tracking
+	struct t_slam_metrics metrics; //!< Accuracy and latency against the dataset groundtruth
+};
+
 /*!
  * Tracks an euroc dataset with the SLAM tracker.
  *
  * @param should_exit External exit condition, the run will end if it becomes true
- * @param euroc_path Dataset path
+ * @param euroc_path Dataset path, either a EuRoC directory or a container file
  * @param slam_config Path to config file for the SLAM system
  * @param output_path Path to write resulting tracking data to
+ * @param out_result If not NULL, gets the timing and accuracy of the run
  *
  * @ingroup drv_euroc
  */
@@ -115,7 +151,8 @@ void
 euroc_run_dataset(const char *euroc_path,
                   const char *slam_config,
                   const char *output_path,
-                  const volatile bool *should_exit);
+                  const volatile bool *should_exit,
+                  struct euroc_run_result *out_result);
 
 /*!
  * @dir drivers/euroc
@@ -16,7 +16,10 @@
 #include "util/u_time.h"
 #include "util/u_var.h"
 #include "util/u_sink.h"
+#include "util/u_worker.h"
 #include "tracking/t_frame_cv_mat_wrapper.hpp"
+#include "tracking/t_dataset_container.h"
+#include "tracking/t_euroc_recorder.h"
 #include "math/m_api.h"
 #include "math/m_filter_fifo.h"
 
@@ -25,12 +28,17 @@
 
 #include <algorithm>
 #include <chrono>
+#include <condition_variable>
 #include <cstring>
 #include <stdint.h>
 #include <stdio.h>
+#include <filesystem>
 #include <fstream>
 #include <future>
+#include <iomanip>
+#include <mutex>
 #include <thread>
+#include <unordered_map>
 #include <inttypes.h>
 
 //! @see euroc_player_playback_config
@@ -48,6 +56,9 @@ DEBUG_GET_ONCE_BOOL_OPTION(send_all_imus_first, "EUROC_SEND_ALL_IMUS_FIRST", fal
 DEBUG_GET_ONCE_BOOL_OPTION(use_source_ts, "EUROC_USE_SOURCE_TS", false)
 DEBUG_GET_ONCE_BOOL_OPTION(play_from_start, "EUROC_PLAY_FROM_START", false)
 DEBUG_GET_ONCE_BOOL_OPTION(print_progress, "EUROC_PRINT_PROGRESS", false)
+DEBUG_GET_ONCE_NUM_OPTION(prefetch, "EUROC_PREFETCH", 16)
+DEBUG_GET_ONCE_BOOL_OPTION(prefetch_all, "EUROC_PREFETCH_ALL", false)
+DEBUG_GET_ONCE_NUM_OPTION(decode_threads, "EUROC_DECODE_THREADS", 4)
 
 #define EUROC_PLAYER_STR "Euroc Player"
 
@@ -55,15 +66,21 @@ DEBUG_GET_ONCE_BOOL_OPTION(print_progress, "EUROC_PRINT_PROGRESS", false)
 #define EUROC_MAX_CAMS XRT_TRACKING_MAX_SLAM_CAMS
 
 using std::async;
+using std::condition_variable;
 using std::find_if;
 using std::ifstream;
+using std::ofstream;
 using std::is_same_v;
 using std::launch;
+using std::lock_guard;
 using std::max_element;
+using std::mutex;
 using std::pair;
 using std::stof;
 using std::string;
 using std::to_string;
+using std::unique_lock;
+using std::unordered_map;
 using std::vector;
 
 using img_sample = pair<timepoint_ns, string>;
@@ -72,6 +89,39 @@ using imu_samples = vector<xrt_imu_sample>;
 using img_samples = vector<img_sample>;
 using gt_trajectory = vector<xrt_pose_sample>;
 
+//! Decoded images of one frame number, one per camera.
+struct euroc_player_decoded
+{
+	bool ready;            //!< Set by the worker once @ref imgs are decoded
+	vector<cv::Mat> imgs; //!< Ready to be wrapped, already converted and scaled
+};
+
+struct euroc_player;
+
+//! Look-ahead cache of decoded frames, filled by a worker pool.
+struct euroc_player_prefetch
+{
+	struct u_worker_thread_pool *pool;
+	struct u_worker_group *group;
+
+	mutex lock;                                           //!< Protects @ref frames
+	condition_variable decoded;                           //!< Signalled when a frame becomes ready
+	unordered_map<uint64_t, euroc_player_decoded> frames; //!< Scheduled frames by frame number
+	uint64_t next_seq;                                    //!< Next frame number to schedule
+	bool cancel;                                          //!< Set on stream stop, skips queued decoding
+
+	// Stats, shown in the UI.
+	uint64_t hits;   //!< Frames that were ready when needed
+	uint64_t misses; //!< Frames the playback thread had to wait for
+};
+
+//! Data passed to a decode task, freed by it.
+struct euroc_player_decode_task
+{
+	struct euroc_player *ep;
+	uint64_t seq;
+};
+
 enum euroc_player_ui_state
 {
 	UNINITIALIZED = 0,
@@ -115,6 +165,14 @@ struct euroc_player
 	vector<img_samples> *imgs; //!< List of all image names to read from the dataset per camera
 	gt_trajectory *gt;         //!< List of all groundtruth poses read from the dataset
 
+	//! Open if the dataset is a container, frames are then read from its mapping instead of image files
+	struct t_dataset_reader *container;
+	//! Index in the container of the first frame in `imgs[i]`, the cameras may have been trimmed to match
+	size_t container_first_frame[EUROC_MAX_CAMS];
+
+	//! Decoded frames cache, only used while streaming if prefetching is enabled
+	struct euroc_player_prefetch *prefetch;
+
 	// Timestamp correction fields (can be disabled through `use_source_ts`)
 	timepoint_ns base_ts;   //!< First sample timestamp, stream timestamps are relative to this
 	timepoint_ns start_ts;  //!< When did the dataset started to be played
@@ -304,9 +362,55 @@ euroc_player_match_cams_seqs(struct euroc_player *ep)
 	}
 }
 
+static void
+euroc_player_preload_container(struct euroc_player *ep)
+{
+	struct t_dataset_reader *r = ep->container;
+
+	ep->imus->resize(t_dataset_reader_get_imu_count(r));
+	for (size_t i = 0; i < ep->imus->size(); i++) {
+		t_dataset_reader_get_imu(r, i, &ep->imus->at(i));
+	}
+
+	for (size_t i = 0; i < ep->imgs->size(); i++) {
+		img_samples &imgs = ep->imgs->at(i);
+		size_t frame_count = t_dataset_reader_get_frame_count(r, i);
+		imgs.clear();
+		imgs.reserve(frame_count);
+		for (size_t j = 0; j < frame_count; j++) {
+			t_dataset_frame frame;
+			t_dataset_reader_get_frame(r, i, j, &frame);
+			imgs.push_back({frame.timestamp_ns, ""}); // No file, loaded by index
+		}
+	}
+
+	euroc_player_match_cams_seqs(ep);
+
+	for (size_t i = 0; i < ep->imgs->size(); i++) {
+		t_dataset_frame frame = {};
+		size_t j = 0;
+		while (t_dataset_reader_get_frame(r, i, j, &frame) && frame.timestamp_ns != ep->imgs->at(i).front().first) {
+			j++;
+		}
+		ep->container_first_frame[i] = j;
+	}
+
+	if (ep->dataset.has_gt) {
+		ep->gt->resize(t_dataset_reader_get_gt_count(r));
+		for (size_t i = 0; i < ep->gt->size(); i++) {
+			t_dataset_reader_get_gt(r, i, &ep->gt->at(i));
+		}
+	}
+}
+
 static void
 euroc_player_preload(struct euroc_player *ep)
 {
+	if (ep->container != nullptr) {
+		euroc_player_preload_container(ep);
+		return;
+	}
+
 	ep->imus->clear();
 	euroc_player_preload_imu_data(ep->dataset.path, ep->imus);
 
@@ -352,12 +456,44 @@ euroc_player_user_skip(struct euroc_player *ep)
 	ep->offset_ts -= skip_first_ns / ep->playback.speed;
 }
 
+//! Same as @ref euroc_player_fill_dataset_info but for a container file
+static void
+euroc_player_fill_container_info(const char *path, euroc_player_dataset_info *dataset)
+{
+	struct t_dataset_reader *r = nullptr;
+	bool opened = t_dataset_reader_open(path, &r);
+	EUROC_ASSERT(opened, "Invalid dataset container %s", path);
+
+	size_t cam_count = t_dataset_reader_get_cam_count(r);
+	EUROC_ASSERT(cam_count <= EUROC_MAX_CAMS, "Increase EUROC_MAX_CAMS (dataset with %zu cams)", cam_count);
+
+	t_dataset_frame first_cam0_frame = {};
+	bool has_frames = cam_count > 0 && t_dataset_reader_get_frame(r, 0, 0, &first_cam0_frame);
+	bool is_valid_dataset = has_frames && t_dataset_reader_get_imu_count(r) > 0;
+	EUROC_ASSERT(is_valid_dataset, "Invalid dataset %s", path);
+
+	dataset->cam_count = (int)cam_count;
+	dataset->is_colored = first_cam0_frame.format == XRT_FORMAT_R8G8B8;
+	dataset->has_gt = t_dataset_reader_get_gt_count(r) > 0;
+	dataset->is_container = true;
+	dataset->width = first_cam0_frame.width;
+	dataset->height = first_cam0_frame.height;
+
+	t_dataset_reader_destroy(&r);
+}
+
 //! Determine and fill attributes of the dataset pointed by `path`
 //! Assertion fails if `path` does not point to an euroc dataset
 static void
 euroc_player_fill_dataset_info(const char *path, euroc_player_dataset_info *dataset)
 {
 	(void)snprintf(dataset->path, sizeof(dataset->path), "%s", path);
+
+	if (t_dataset_is_container(path)) {
+		euroc_player_fill_container_info(path, dataset);
+		return;
+	}
+
 	img_samples samples;
 	imu_samples _1;
 	gt_trajectory _2;
@@ -422,23 +558,43 @@ euroc_player_mapped_playback_ts(struct euroc_player *ep, timepoint_ns ts)
 	return euroc_player_mapped_ts(ep, ts);
 }
 
-static void
-euroc_player_load_next_frame(struct euroc_player *ep, int cam_index, struct xrt_frame *&xf)
+//! Load, convert and scale image @p seq of camera @p cam_index, safe to call from any thread.
+static cv::Mat
+euroc_player_decode_image(struct euroc_player *ep, int cam_index, uint64_t seq)
 {
-	using xrt::auxiliary::tracking::FrameMat;
-	img_sample sample = ep->imgs->at(cam_index).at(ep->img_seq);
-	ep->playback.scale = CLAMP(ep->playback.scale, 1.0 / 16, 4);
+	const img_sample &sample = ep->imgs->at(cam_index).at(seq);
 
 	// Load will be influenced by these playback options
 	bool allow_color = ep->playback.color;
 	float scale = ep->playback.scale;
 
-	// Load image from disk
-	timepoint_ns timestamp = euroc_player_mapped_playback_ts(ep, sample.first);
-	string img_name = sample.second;
-	EUROC_TRACE(ep, "cam%d img t = %ld filename = %s", cam_index, timestamp, img_name.c_str());
-	cv::ImreadModes read_mode = allow_color ? cv::IMREAD_ANYCOLOR : cv::IMREAD_GRAYSCALE;
-	cv::Mat img = cv::imread(img_name, read_mode); // If colored, reads in BGR order
+	cv::Mat img;
+
+	if (ep->container != nullptr) {
+		// Already decoded, only needs a copy out of the mapping
+		size_t index = ep->container_first_frame[cam_index] + seq;
+		EUROC_TRACE(ep, "cam%d img t = %ld container index = %zu", cam_index, sample.first, index);
+
+		t_dataset_frame frame;
+		bool got = t_dataset_reader_get_frame(ep->container, cam_index, index, &frame);
+		EUROC_ASSERT(got, "Missing frame %zu of cam%d in container", index, cam_index);
+
+		int type = frame.format == XRT_FORMAT_R8G8B8 ? CV_8UC3 : CV_8UC1;
+		cv::Mat mapped(frame.height, frame.width, type, (void *)frame.data, frame.stride);
+		if (!allow_color && mapped.channels() == 3) {
+			cv::cvtColor(mapped, img, cv::COLOR_BGR2GRAY);
+		} else if (scale == 1.0) {
+			img = mapped.clone();
+		} else {
+			img = mapped; // Resize below makes the copy
+		}
+	} else {
+		// Load image from disk
+		const string &img_name = sample.second;
+		EUROC_TRACE(ep, "cam%d img t = %ld filename = %s", cam_index, sample.first, img_name.c_str());
+		cv::ImreadModes read_mode = allow_color ? cv::IMREAD_ANYCOLOR : cv::IMREAD_GRAYSCALE;
+		img = cv::imread(img_name, read_mode); // If colored, reads in BGR order
+	}
 
 	if (scale != 1.0) {
 		cv::Mat tmp;
@@ -446,6 +602,146 @@ euroc_player_load_next_frame(struct euroc_player *ep, int cam_index, struct xrt_
 		img = tmp;
 	}
 
+	return img;
+}
+
+
+// Prefetching functionality
+
+static void
+euroc_player_decode_task(void *ptr)
+{
+	struct euroc_player_decode_task *task = (struct euroc_player_decode_task *)ptr;
+	struct euroc_player *ep = task->ep;
+	struct euroc_player_prefetch *pf = ep->prefetch;
+
+	// Nobody will wait for it if the stream was stopped
+	vector<cv::Mat> imgs(ep->playback.cam_count);
+	for (int i = 0; i < ep->playback.cam_count && !pf->cancel; i++) {
+		imgs[i] = euroc_player_decode_image(ep, i, task->seq);
+	}
+
+	{
+		lock_guard lock{pf->lock};
+		euroc_player_decoded &decoded = pf->frames[task->seq];
+		decoded.imgs = std::move(imgs);
+		decoded.ready = true;
+	}
+	pf->decoded.notify_all();
+
+	free(task);
+}
+
+//! Queue frames for decoding until @p until is reached or the end of the dataset.
+static void
+euroc_player_prefetch_schedule(struct euroc_player *ep, uint64_t until)
+{
+	struct euroc_player_prefetch *pf = ep->prefetch;
+	until = MIN(until, ep->imgs->at(0).size());
+
+	while (pf->next_seq < until) {
+		{
+			lock_guard lock{pf->lock};
+			pf->frames[pf->next_seq].ready = false;
+		}
+
+		struct euroc_player_decode_task *task = U_TYPED_CALLOC(struct euroc_player_decode_task);
+		task->ep = ep;
+		task->seq = pf->next_seq++;
+		u_worker_group_push(pf->group, euroc_player_decode_task, task);
+	}
+}
+
+//! Create the cache and start decoding, only returns after all frames are decoded with prefetch_all.
+static void
+euroc_player_prefetch_start(struct euroc_player *ep)
+{
+	if (!ep->playback.prefetch_all && ep->playback.prefetch_count <= 0) {
+		return;
+	}
+
+	uint32_t thread_count = MAX(1, ep->playback.decode_threads);
+
+	struct euroc_player_prefetch *pf = ep->prefetch;
+	pf->pool = u_worker_thread_pool_create(thread_count, thread_count, "EuRoC Decode", OS_THREAD_CORE_CLASS_ANY);
+	pf->group = u_worker_group_create(pf->pool);
+	pf->next_seq = ep->img_seq;
+	pf->cancel = false;
+	pf->hits = 0;
+	pf->misses = 0;
+
+	if (!ep->playback.prefetch_all) {
+		euroc_player_prefetch_schedule(ep, ep->img_seq + ep->playback.prefetch_count);
+		return;
+	}
+
+	EUROC_INFO(ep, "Decoding %zu frames into memory", ep->imgs->at(0).size() - ep->img_seq);
+	timepoint_ns start_ns = os_monotonic_get_ts();
+	euroc_player_prefetch_schedule(ep, ep->imgs->at(0).size());
+	u_worker_group_wait_all(pf->group);
+	EUROC_INFO(ep, "Decoded all frames in %.2fs", time_ns_to_s(os_monotonic_get_ts() - start_ns));
+}
+
+//! Waits for any queued decoding and frees all cached frames.
+static void
+euroc_player_prefetch_stop(struct euroc_player *ep)
+{
+	struct euroc_player_prefetch *pf = ep->prefetch;
+	if (pf->group == nullptr) {
+		return;
+	}
+
+	u_worker_group_wait_all(pf->group);
+	u_worker_group_reference(&pf->group, nullptr);
+	u_worker_thread_pool_reference(&pf->pool, nullptr);
+	pf->frames.clear();
+}
+
+//! Take the decoded images of frame @p seq out of the cache, waits for them if needed.
+static bool
+euroc_player_prefetch_take(struct euroc_player *ep, uint64_t seq, vector<cv::Mat> &out_imgs)
+{
+	struct euroc_player_prefetch *pf = ep->prefetch;
+	if (pf->group == nullptr) {
+		return false;
+	}
+
+	{
+		unique_lock lock{pf->lock};
+		auto it = pf->frames.find(seq);
+		if (it == pf->frames.end()) {
+			return false;
+		}
+
+		if (it->second.ready) {
+			pf->hits++;
+		} else {
+			pf->misses++;
+			pf->decoded.wait(lock, [&it] { return it->second.ready; });
+		}
+
+		out_imgs = std::move(it->second.imgs);
+		pf->frames.erase(it);
+	}
+
+	// Keep the look-ahead window full.
+	if (!ep->playback.prefetch_all) {
+		euroc_player_prefetch_schedule(ep, seq + 1 + ep->playback.prefetch_count);
+	}
+
+	return true;
+}
+
+
+// Frame pushing functionality
+
+static void
+euroc_player_load_next_frame(struct euroc_player *ep, int cam_index, const cv::Mat &img, struct xrt_frame *&xf)
+{
+	using xrt::auxiliary::tracking::FrameMat;
+	const img_sample &sample = ep->imgs->at(cam_index).at(ep->img_seq);
+	timepoint_ns timestamp = euroc_player_mapped_playback_ts(ep, sample.first);
+
 	// Create xrt_frame, it will be freed by FrameMat destructor
 	EUROC_ASSERT(xf == NULL || xf->reference.count > 0, "Must be given a valid or NULL frame ptr");
 	EUROC_ASSERT(timestamp >= 0, "Unexpected negative timestamp");
@@ -467,9 +763,17 @@ euroc_player_push_next_frame(struct euroc_player *ep)
 {
 	int cam_count = ep->playback.cam_count;
 
+	vector<cv::Mat> imgs;
+	if (!euroc_player_prefetch_take(ep, ep->img_seq, imgs)) {
+		imgs.resize(cam_count);
+		for (int i = 0; i < cam_count; i++) {
+			imgs[i] = euroc_player_decode_image(ep, i, ep->img_seq);
+		}
+	}
+
 	vector<xrt_frame *> xfs(cam_count, nullptr);
 	for (int i = 0; i < cam_count; i++) {
-		euroc_player_load_next_frame(ep, i, xfs[i]);
+		euroc_player_load_next_frame(ep, i, imgs[i], xfs[i]);
 	}
 
 	// TODO: Some SLAM systems expect synced frames, but that's not an
@@ -607,9 +911,13 @@ euroc_player_stream(void *ptr)
 
 	euroc_player_preload(ep);
 	ep->base_ts = MIN(ep->imgs->at(0).at(0).first, ep->imus->at(0).timestamp_ns);
-	ep->start_ts = os_monotonic_get_ts();
+	ep->playback.scale = CLAMP(ep->playback.scale, 1.0 / 16, 4);
 	euroc_player_user_skip(ep);
 
+	// Before start_ts, so decoding everything first does not count as playback time.
+	euroc_player_prefetch_start(ep);
+	ep->start_ts = os_monotonic_get_ts();
+
 	// Push all IMU samples now if requested
 	if (ep->playback.send_all_imus_first) {
 		while (ep->imu_seq < ep->imus->size()) {
@@ -634,6 +942,10 @@ euroc_player_stream(void *ptr)
 
 	ep->is_running = false;
 
+	EUROC_INFO(ep, "Prefetched frames ready: %" PRIu64 ", waited for: %" PRIu64, ep->prefetch->hits,
+	           ep->prefetch->misses);
+	euroc_player_prefetch_stop(ep);
+
 	EUROC_INFO(ep, "Euroc dataset playback finished");
 	euroc_player_set_ui_state(ep, STREAM_ENDED);
 
@@ -769,6 +1081,7 @@ euroc_player_stream_stop(struct xrt_fs *xfs)
 {
 	struct euroc_player *ep = euroc_player(xfs);
 	ep->is_running = false;
+	ep->prefetch->cancel = true;
 
 	// Destroy also stops the thread.
 	os_thread_helper_destroy(&ep->play_thread);
@@ -801,6 +1114,8 @@ euroc_player_destroy(struct xrt_frame_node *node)
 	delete ep->gt;
 	delete ep->imus;
 	delete ep->imgs;
+	delete ep->prefetch;
+	t_dataset_reader_destroy(&ep->container);
 
 	u_var_remove_root(ep);
 	for (int i = 0; i < ep->dataset.cam_count; i++) {
@@ -910,10 +1225,15 @@ euroc_player_setup_gui(struct euroc_player *ep)
 	u_var_add_f64(ep, &ep->playback.speed, "Speed");
 	u_var_add_bool(ep, &ep->playback.send_all_imus_first, "Send all IMU samples first");
 	u_var_add_bool(ep, &ep->playback.use_source_ts, "Use original timestamps");
+	u_var_add_i32(ep, &ep->playback.prefetch_count, "Frames to decode ahead");
+	u_var_add_bool(ep, &ep->playback.prefetch_all, "Decode all frames before playing");
+	u_var_add_i32(ep, &ep->playback.decode_threads, "Decoding threads");
 
 	u_var_add_gui_header(ep, NULL, "Streams");
 	u_var_add_ro_ff_vec3_f32(ep, ep->gyro_ff, "Gyroscope");
 	u_var_add_ro_ff_vec3_f32(ep, ep->accel_ff, "Accelerometer");
+	u_var_add_ro_u64(ep, &ep->prefetch->hits, "Prefetched frames ready");
+	u_var_add_ro_u64(ep, &ep->prefetch->misses, "Prefetched frames waited for");
 	for (int i = 0; i < ep->dataset.cam_count; i++) {
 		char label[] = "Camera NNNNNNNNNN";
 		(void)snprintf(label, sizeof(label), "Camera %d", i);
@@ -946,12 +1266,156 @@ euroc_player_fill_default_config_for(struct euroc_player_config *config, const c
 	playback.use_source_ts = debug_get_bool_option_use_source_ts();
 	playback.play_from_start = debug_get_bool_option_play_from_start();
 	playback.print_progress = debug_get_bool_option_print_progress();
+	playback.prefetch_count = (int)debug_get_num_option_prefetch();
+	playback.prefetch_all = debug_get_bool_option_prefetch_all();
+	playback.decode_threads = (int)debug_get_num_option_decode_threads();
 
 	config->log_level = debug_get_log_option_euroc_log();
 	config->dataset = dataset;
 	config->playback = playback;
 }
 
+
+// Dataset conversion
+
+extern "C" bool
+euroc_convert_to_container(const char *euroc_path, const char *out_path)
+{
+	euroc_player_dataset_info dataset = {};
+	dataset.gt_device_name = debug_get_option_gt_device_name();
+	euroc_player_fill_dataset_info(euroc_path, &dataset);
+	EUROC_ASSERT(!dataset.is_container, "%s is already a container", euroc_path);
+
+	imu_samples imus;
+	gt_trajectory gt;
+	vector<img_samples> imgs(dataset.cam_count);
+	euroc_player_preload_imu_data(euroc_path, &imus);
+	if (dataset.has_gt) {
+		euroc_player_preload_gt_data(euroc_path, &dataset.gt_device_name, &gt);
+	}
+	size_t max_frame_count = 0;
+	for (int i = 0; i < dataset.cam_count; i++) {
+		euroc_player_preload_img_data(euroc_path, imgs[i], i);
+		max_frame_count = MAX(max_frame_count, imgs[i].size());
+	}
+
+	struct t_dataset_writer *w = nullptr;
+	if (!t_dataset_writer_create(out_path, dataset.cam_count, &w)) {
+		return false;
+	}
+
+	bool ok = true;
+	for (size_t i = 0; i < imus.size() && ok; i++) {
+		ok = t_dataset_writer_push_imu(w, &imus[i]);
+	}
+	for (size_t i = 0; i < gt.size() && ok; i++) {
+		ok = t_dataset_writer_push_gt(w, &gt[i]);
+	}
+
+	// Interleave cameras so playback reads the file front to back.
+	for (size_t j = 0; j < max_frame_count && ok; j++) {
+		for (int i = 0; i < dataset.cam_count && ok; i++) {
+			if (j >= imgs[i].size()) {
+				continue;
+			}
+
+			const img_sample &sample = imgs[i][j];
+			cv::Mat img = cv::imread(sample.second, cv::IMREAD_ANYCOLOR); // If colored, reads in BGR order
+			if (img.empty() || (img.channels() != 1 && img.channels() != 3)) {
+				U_LOG_E("Unable to load image %s", sample.second.c_str());
+				ok = false;
+				break;
+			}
+
+			struct xrt_frame xf = {};
+			xf.width = img.cols;
+			xf.height = img.rows;
+			xf.stride = img.step;
+			xf.format = img.channels() == 3 ? XRT_FORMAT_R8G8B8 : XRT_FORMAT_L8;
+			xf.timestamp = sample.first;
+			xf.data = img.data;
+			ok = t_dataset_writer_push_frame(w, i, &xf);
+		}
+
+		if (j % 100 == 0) {
+			printf("Converting frame %zu/%zu\r", j, max_frame_count);
+			(void)fflush(stdout);
+		}
+	}
+
+	t_dataset_writer_close(&w);
+	printf("Converted %zu frames\n", max_frame_count);
+
+	return ok;
+}
+
+extern "C" bool
+euroc_convert_from_container(const char *in_path, const char *out_path)
+{
+	using std::filesystem::create_directories;
+
+	struct t_dataset_reader *r = nullptr;
+	if (!t_dataset_reader_open(in_path, &r)) {
+		return false;
+	}
+
+	string path = out_path;
+
+	create_directories(path + "/mav0/imu0");
+	ofstream imu_csv{path + "/mav0/imu0/data.csv"};
+	imu_csv << std::fixed << std::setprecision(CSV_PRECISION);
+	imu_csv << "#timestamp [ns],w_RS_S_x [rad s^-1],w_RS_S_y [rad s^-1],w_RS_S_z [rad s^-1],"
+	           "a_RS_S_x [m s^-2],a_RS_S_y [m s^-2],a_RS_S_z [m s^-2]" CSV_EOL;
+	for (size_t i = 0; i < t_dataset_reader_get_imu_count(r); i++) {
+		xrt_imu_sample s;
+		t_dataset_reader_get_imu(r, i, &s);
+		xrt_vec3_f64 a = s.accel_m_s2;
+		xrt_vec3_f64 w = s.gyro_rad_secs;
+		imu_csv << s.timestamp_ns << "," << w.x << "," << w.y << "," << w.z << ",";
+		imu_csv << a.x << "," << a.y << "," << a.z << CSV_EOL;
+	}
+
+	if (t_dataset_reader_get_gt_count(r) > 0) {
+		create_directories(path + "/mav0/gt");
+		ofstream gt_csv{path + "/mav0/gt/data.csv"};
+		gt_csv << std::fixed << std::setprecision(CSV_PRECISION);
+		gt_csv << "#timestamp [ns],p_RS_R_x [m],p_RS_R_y [m],p_RS_R_z [m],"
+		          "q_RS_w [],q_RS_x [],q_RS_y [],q_RS_z []" CSV_EOL;
+		for (size_t i = 0; i < t_dataset_reader_get_gt_count(r); i++) {
+			xrt_pose_sample s;
+			t_dataset_reader_get_gt(r, i, &s);
+			xrt_vec3 p = s.pose.position;
+			xrt_quat o = s.pose.orientation;
+			gt_csv << s.timestamp_ns << "," << p.x << "," << p.y << "," << p.z << ",";
+			gt_csv << o.w << "," << o.x << "," << o.y << "," << o.z << CSV_EOL;
+		}
+	}
+
+	bool ok = true;
+	for (uint32_t i = 0; i < t_dataset_reader_get_cam_count(r) && ok; i++) {
+		string data_path = path + "/mav0/cam" + to_string(i) + "/data";
+		create_directories(data_path);
+		ofstream cam_csv{data_path + ".csv"};
+		cam_csv << "#timestamp [ns],filename" CSV_EOL;
+
+		for (size_t j = 0; j < t_dataset_reader_get_frame_count(r, i) && ok; j++) {
+			t_dataset_frame frame;
+			t_dataset_reader_get_frame(r, i, j, &frame);
+
+			string filename = to_string(frame.timestamp_ns) + ".png";
+			int type = frame.format == XRT_FORMAT_R8G8B8 ? CV_8UC3 : CV_8UC1;
+			cv::Mat img(frame.height, frame.width, type, (void *)frame.data, frame.stride);
+			ok = cv::imwrite(data_path + "/" + filename, img);
+			cam_csv << frame.timestamp_ns << "," << filename << CSV_EOL;
+		}
+	}
+
+	t_dataset_reader_destroy(&r);
+
+	return ok;
+}
+
+
 // Euroc driver creation
 
 extern "C" struct xrt_fs *
@@ -990,6 +1454,12 @@ euroc_player_create(struct xrt_frame_context *xfctx, const char *path, struct eu
 	ep->gt = new gt_trajectory{};
 	ep->imus = new imu_samples{};
 	ep->imgs = new vector<img_samples>(ep->dataset.cam_count);
+	ep->prefetch = new euroc_player_prefetch{};
+
+	if (ep->dataset.is_container) {
+		bool opened = t_dataset_reader_open(ep->dataset.path, &ep->container);
+		EUROC_ASSERT(opened, "Unable to open dataset container %s", ep->dataset.path);
+	}
 
 	euroc_player_setup_gui(ep);
 
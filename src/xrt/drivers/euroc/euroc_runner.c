@@ -27,8 +27,13 @@ void
 euroc_run_dataset(const char *euroc_path,
                   const char *slam_config,
                   const char *output_path,
-                  const volatile bool *should_exit)
-{}
+                  const volatile bool *should_exit,
+                  struct euroc_run_result *out_result)
+{
+	if (out_result != NULL) {
+		U_ZERO(out_result);
+	}
+}
 
 #else
 
@@ -88,8 +93,11 @@ void
 euroc_run_dataset(const char *euroc_path,
                   const char *slam_config,
                   const char *output_path,
-                  const volatile bool *should_exit)
+                  const volatile bool *should_exit,
+                  struct euroc_run_result *out_result)
 {
+	timepoint_ns start_ns = os_monotonic_get_ns();
+
 	struct euroc_player_config *ep_config = make_euroc_player_config(euroc_path);
 	struct t_slam_tracker_config *st_config = make_slam_tracker_config(slam_config, output_path);
 	st_config->cam_count = ep_config->dataset.cam_count;
@@ -125,6 +133,14 @@ euroc_run_dataset(const char *euroc_path,
 		streaming = xrt_fs_is_running(xfs);
 	}
 
+	// Tracker is destroyed with the frame context, so gather its metrics first
+	if (out_result != NULL) {
+		U_ZERO(out_result);
+		out_result->completed = !*should_exit;
+		out_result->duration_s = time_ns_to_s(os_monotonic_get_ns() - start_ns);
+		t_slam_get_metrics(xts, &out_result->metrics);
+	}
+
 	xrt_frame_context_destroy_nodes(&xfctx);
 	free(st_config);
 	free(ep_config);
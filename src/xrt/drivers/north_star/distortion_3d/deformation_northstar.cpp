@@ -105,6 +105,39 @@ OpticalSystem::RegenerateMesh()
 	}
 }
 
+static void
+matrix_to_xrt(const Matrix4x4 &m, struct xrt_matrix_4x4 *out)
+{
+	// Matrix4x4 is row major, xrt_matrix_4x4 column major.
+	const float rows[4][4] = {
+	    {m.m00, m.m01, m.m02, m.m03},
+	    {m.m10, m.m11, m.m12, m.m13},
+	    {m.m20, m.m21, m.m22, m.m23},
+	    {m.m30, m.m31, m.m32, m.m33},
+	};
+
+	for (int col = 0; col < 4; col++) {
+		for (int row = 0; row < 4; row++) {
+			out->v[col * 4 + row] = rows[row][col];
+		}
+	}
+}
+
+void
+OpticalSystem::GetEllipsoid(struct xrt_distortion_ellipsoid *out) const
+{
+	out->eye_position = {eyePosition.x, eyePosition.y, eyePosition.z};
+	out->screen_position = {screenPosition.x, screenPosition.y, screenPosition.z};
+	out->screen_forward = {screenForward.x, screenForward.y, screenForward.z};
+	out->minor_axis = ellipseMinorAxis;
+	out->major_axis = ellipseMajorAxis;
+
+	matrix_to_xrt(clipToWorld, &out->clip_to_world);
+	matrix_to_xrt(worldToSphereSpace, &out->world_to_sphere);
+	matrix_to_xrt(sphereToWorldSpace, &out->sphere_to_world);
+	matrix_to_xrt(worldToScreenSpace, &out->world_to_screen);
+}
+
 Vector2
 OpticalSystem::RenderUVToDisplayUV(const Vector2 &inputUV)
 {
@@ -284,3 +317,19 @@ ns_3d_display_uv_to_render_uv(struct xrt_vec2 in, struct xrt_vec2 *out, struct n
 	out->x = outUV.x;
 	out->y = outUV.y;
 }
+
+extern "C" void
+ns_3d_update_eye_position(struct ns_3d_eye *eye)
+{
+	OpticalSystem *opticalSystem = (OpticalSystem *)eye->optical_system;
+	const struct xrt_vec3 &pos = eye->eye_pose.position;
+	opticalSystem->UpdateEyePosition(Vector3(pos.x, pos.y, pos.z));
+	opticalSystem->UpdateClipToWorld(Matrix4x4::Identity());
+}
+
+extern "C" void
+ns_3d_get_ellipsoid(struct ns_3d_eye *eye, struct xrt_distortion_ellipsoid *out)
+{
+	OpticalSystem *opticalSystem = (OpticalSystem *)eye->optical_system;
+	opticalSystem->GetEllipsoid(out);
+}
@@ -48,6 +48,9 @@ public:
 		eyePosition.z = pos.z;
 	}
 
+	void
+	GetEllipsoid(struct xrt_distortion_ellipsoid *out) const;
+
 	Vector4
 	GetCameraProjection()
 	{
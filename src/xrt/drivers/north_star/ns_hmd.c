@@ -240,6 +240,36 @@ cleanup_l3d:
 }
 
 
+static void
+ns_3d_fill_in_ellipsoid(struct ns_hmd *ns)
+{
+	struct ns_3d_values *values = &ns->config.dist_3d;
+
+	ns_3d_get_ellipsoid(&values->eyes[0], &ns->base.hmd->distortion.ellipsoid.views[0]);
+	ns_3d_get_ellipsoid(&values->eyes[1], &ns->base.hmd->distortion.ellipsoid.views[1]);
+
+	ns->base.hmd->distortion.ellipsoid.valid = true;
+	ns->base.hmd->distortion.ellipsoid.generation++;
+}
+
+static void
+ns_3d_apply_eye_positions(void *ptr)
+{
+	struct ns_hmd *ns = (struct ns_hmd *)ptr;
+	struct ns_3d_values *values = &ns->config.dist_3d;
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(values->eyes); i++) {
+		ns_3d_update_eye_position(&values->eyes[i]);
+		ns->config.head_pose_to_eye[i].position = values->eyes[i].eye_pose.position;
+	}
+
+	// The compositor regenerates its distortion on the GPU.
+	ns_3d_fill_in_ellipsoid(ns);
+
+	NS_INFO(ns, "Applied new eye positions");
+}
+
+
 /*
  *
  * Moshi Turner's meshgrid-based distortion correction
@@ -511,6 +541,16 @@ ns_hmd_create(const cJSON *config_json)
 	// Setup variable tracker.
 	u_var_add_root(ns, "North Star", true);
 	u_var_add_pose(ns, &ns->no_tracker_relation.pose, "pose");
+
+	if (ns->config.distortion_type == NS_DISTORTION_TYPE_GEOMETRIC_3D) {
+		ns_3d_fill_in_ellipsoid(ns);
+
+		ns->apply_eye_positions_btn.cb = ns_3d_apply_eye_positions;
+		ns->apply_eye_positions_btn.ptr = ns;
+		u_var_add_vec3_f32(ns, &ns->config.dist_3d.eyes[0].eye_pose.position, "Left eye position");
+		u_var_add_vec3_f32(ns, &ns->config.dist_3d.eyes[1].eye_pose.position, "Right eye position");
+		u_var_add_button(ns, &ns->apply_eye_positions_btn, "Apply eye positions");
+	}
 	ns->base.orientation_tracking_supported = true;
 	ns->base.device_type = XRT_DEVICE_TYPE_HMD;
 
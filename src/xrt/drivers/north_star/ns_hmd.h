@@ -20,6 +20,7 @@
 #include "util/u_logging.h"
 #include "os/os_threading.h"
 #include "util/u_distortion_mesh.h"
+#include "util/u_var.h"
 
 #include <stdio.h>
 
@@ -110,6 +111,9 @@ struct ns_hmd
 	const cJSON *config_json;
 	struct ns_optics_config config;
 
+	//! Only for 3D distortion, applies edited eye positions.
+	struct u_var_button apply_eye_positions_btn;
+
 	enum u_logging_level log_level;
 };
 
@@ -146,6 +150,22 @@ ns_3d_create_optical_system(struct ns_3d_eye *eye);
 void
 ns_3d_free_optical_system(struct ns_optical_system **system);
 
+/*!
+ * Moves the eye of the optical system to `eye->eye_pose.position`.
+ *
+ * @ingroup drv_ns
+ */
+void
+ns_3d_update_eye_position(struct ns_3d_eye *eye);
+
+/*!
+ * Gets the optical system of the eye for the compositor to evaluate.
+ *
+ * @ingroup drv_ns
+ */
+void
+ns_3d_get_ellipsoid(struct ns_3d_eye *eye, struct xrt_distortion_ellipsoid *out);
+
 
 #ifdef __cplusplus
 }
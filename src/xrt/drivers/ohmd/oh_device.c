@@ -910,6 +910,8 @@ create_hmd(ohmd_context *ctx, int device_idx, int device_flags)
 		// clang-format on
 
 		ohd->base.compute_distortion = compute_distortion_vive;
+		u_distortion_set_analytic_vive(&ohd->base, 0, &ohd->distortion.vive[0]);
+		u_distortion_set_analytic_vive(&ohd->base, 1, &ohd->distortion.vive[1]);
 	}
 
 	if (info.quirks.video_distortion_none) {
@@ -8,7 +8,9 @@
  */
 
 #include <string>
-#include <stdexcept>
+#include <cstring>
+#include <iterator>
+#include <algorithm>
 
 #include <map>
 #include "util/u_logging.h"
@@ -82,15 +84,13 @@ enum opengloves_alpha_encoding_key
 
 #define OPENGLOVES_ALPHA_ENCODING_VAL_IN_MAP_E_0
 
-static const std::string opengloves_alpha_encoding_key_characters = "ABCDEFGHIJKLMNOPQRSTUVWXYZ()";
-
-static bool
-opengloves_alpha_encoding_is_key_character(const char character)
+struct opengloves_alpha_encoding_key_string
 {
-	return opengloves_alpha_encoding_key_characters.find(character) != std::string::npos;
-}
+	const char *str;
+	int key;
+};
 
-static const std::map<std::string, int> opengloves_alpha_encoding_input_key_string{
+static const opengloves_alpha_encoding_key_string opengloves_alpha_encoding_input_key_strings[] = {
     {"A", OPENGLOVES_ALPHA_ENCODING_FinThumb},         // whole thumb curl (default curl value for thumb joints)
     {"(AB)", OPENGLOVES_ALPHA_ENCODING_FinSplayThumb}, // whole thumb splay thumb joint 3 (doesn't exist, but keeps
                                                        // consistency with the other fingers
@@ -137,7 +137,6 @@ static const std::map<std::string, int> opengloves_alpha_encoding_input_key_stri
     {"N", OPENGLOVES_ALPHA_ENCODING_BtnMenu},             // system button pressed (opens SteamVR menu)
     {"O", OPENGLOVES_ALPHA_ENCODING_BtnCalib},            // calibration button
     {"P", OPENGLOVES_ALPHA_ENCODING_TrgValue},            // analog trigger value
-    {"", OPENGLOVES_ALPHA_ENCODING_MAX}                   // Junk key
 };
 
 static const std::map<int, std::string> opengloves_alpha_encoding_output_key_string{
@@ -148,113 +147,152 @@ static const std::map<int, std::string> opengloves_alpha_encoding_output_key_str
     {OPENGLOVES_ALPHA_ENCODING_FinPinky, "E"},  // pinky force feedback
 };
 
-static std::map<int, std::string>
-opengloves_alpha_encoding_parse_to_map(const std::string &str)
+//! Value of a key that was sent without any digits, like a pressed button.
+#define OPENGLOVES_ALPHA_ENCODING_NO_VALUE -1
+
+/*!
+ * The values of one packet, indexed by key, parsed straight out of the packet
+ * without any allocations.
+ */
+struct opengloves_alpha_encoding_values
+{
+	bool present[OPENGLOVES_ALPHA_ENCODING_MAX];
+	int value[OPENGLOVES_ALPHA_ENCODING_MAX];
+
+	bool
+	has(int key) const
+	{
+		return present[key];
+	}
+
+	//! Only true if the key also has digits.
+	bool
+	has_value(int key) const
+	{
+		return present[key] && value[key] != OPENGLOVES_ALPHA_ENCODING_NO_VALUE;
+	}
+
+	float
+	analog(int key) const
+	{
+		return (float)value[key] / OPENGLOVES_ENCODING_MAX_ANALOG_VALUE;
+	}
+};
+
+static bool
+opengloves_alpha_encoding_is_key_character(const char character)
 {
-	std::map<int, std::string> result;
+	return (character >= 'A' && character <= 'Z') || character == '(' || character == ')';
+}
 
+static int
+opengloves_alpha_encoding_find_key(const char *str, size_t length)
+{
+	for (const opengloves_alpha_encoding_key_string &entry : opengloves_alpha_encoding_input_key_strings) {
+		if (strncmp(entry.str, str, length) == 0 && entry.str[length] == '\0') {
+			return entry.key;
+		}
+	}
+
+	return OPENGLOVES_ALPHA_ENCODING_MAX;
+}
+
+static void
+opengloves_alpha_encoding_tokenize(const char *data, size_t size, opengloves_alpha_encoding_values *out)
+{
 	size_t i = 0;
-	while (i < str.length()) {
-		// Advance until we get an alphabetic character (no point in looking at values that don't have a key
+	while (i < size) {
+		// Advance until we get a key character (no point in looking at values that don't have a key
 		// associated with them)
-
-		if (str[i] >= 0 && opengloves_alpha_encoding_is_key_character(str[i])) {
-			std::string key = {str[i]};
+		if (!opengloves_alpha_encoding_is_key_character(data[i])) {
 			i++;
+			continue;
+		}
 
-			// we're going to be parsing a "long key", i.e. (AB) for thumb finger splay. Long keys must
-			// always be enclosed in brackets
-			if (key[0] == '(') {
-				while (str[i] >= 0 && opengloves_alpha_encoding_is_key_character(str[i]) &&
-				       i < str.length()) {
-					key += str[i];
-					i++;
-				}
-			}
+		size_t key_start = i++;
 
-			std::string value;
-			while (str[i] >= 0 && isdigit(str[i]) && i < str.length()) {
-				value += str[i];
+		// we're going to be parsing a "long key", i.e. (AB) for thumb finger splay. Long keys must always be
+		// enclosed in brackets
+		if (data[key_start] == '(') {
+			while (i < size && opengloves_alpha_encoding_is_key_character(data[i])) {
 				i++;
 			}
+		}
+		size_t key_length = i - key_start;
 
-			// Even if the value is empty we still want to use the key, it means that we have a button that
-			// is pressed (it only appears in the packet if it is)
-			if (opengloves_alpha_encoding_input_key_string.find(key) !=
-			    opengloves_alpha_encoding_input_key_string.end())
-				result.insert_or_assign(opengloves_alpha_encoding_input_key_string.at(key), value);
-			else
-				U_LOG_W("Unable to insert key: %s into input map as it was not found", key.c_str());
-		} else
+		int value = OPENGLOVES_ALPHA_ENCODING_NO_VALUE;
+		while (i < size && data[i] >= '0' && data[i] <= '9') {
+			int digit = data[i] - '0';
+			value = value == OPENGLOVES_ALPHA_ENCODING_NO_VALUE ? digit : value * 10 + digit;
 			i++;
-	}
+		}
 
-	return result;
+		// Even if the value is empty we still want to use the key, it means that we have a button that is
+		// pressed (it only appears in the packet if it is)
+		int key = opengloves_alpha_encoding_find_key(data + key_start, key_length);
+		if (key == OPENGLOVES_ALPHA_ENCODING_MAX) {
+			U_LOG_W("Unable to find key: %.*s", (int)key_length, data + key_start);
+			continue;
+		}
+
+		out->present[key] = true;
+		out->value[key] = value;
+	}
 }
 
 
 void
-opengloves_alpha_encoding_decode(const char *data, struct opengloves_input *out)
+opengloves_alpha_encoding_decode(const char *data, size_t size, struct opengloves_input *out)
 {
-	std::map<int, std::string> input_map = opengloves_alpha_encoding_parse_to_map(data);
-
-	try {
-		// five fingers, 2 (curl + splay)
-		for (int i = 0; i < 5; i++) {
-			int enum_position = i * 2;
-			// curls
-			if (input_map.find(enum_position) != input_map.end()) {
-				float fin_curl_value = std::stof(input_map.at(enum_position));
-				std::fill(std::begin(out->flexion[i]), std::begin(out->flexion[i]) + 4,
-				          fin_curl_value / OPENGLOVES_ENCODING_MAX_ANALOG_VALUE);
-			}
+	opengloves_alpha_encoding_values values = {};
+	opengloves_alpha_encoding_tokenize(data, size, &values);
+
+	// five fingers, 2 (curl + splay)
+	for (int i = 0; i < 5; i++) {
+		int enum_position = i * 2;
+		// curls
+		if (values.has_value(enum_position)) {
+			std::fill(std::begin(out->flexion[i]), std::begin(out->flexion[i]) + 4,
+			          values.analog(enum_position));
+		}
 
-			// splay
-			if (input_map.find(enum_position + 1) != input_map.end())
-				out->splay[i] =
-				    (std::stof(input_map.at(enum_position + 1)) / OPENGLOVES_ENCODING_MAX_ANALOG_VALUE -
-				     0.5f) *
-				    2.0f;
+		// splay
+		if (values.has_value(enum_position + 1)) {
+			out->splay[i] = (values.analog(enum_position + 1) - 0.5f) * 2.0f;
 		}
+	}
 
-		int current_finger_joint = OPENGLOVES_ALPHA_ENCODING_FinJointThumb0;
-		for (int i = 0; i < 5; i++) {
-			for (int j = 0; j < 4; j++) {
-				// individual joint curls
-				out->flexion[i][j] = input_map.find(current_finger_joint) != input_map.end()
-				                         ? (std::stof(input_map.at(current_finger_joint)) /
-				                            OPENGLOVES_ENCODING_MAX_ANALOG_VALUE)
-				                         // use the curl of the previous joint
-				                         : out->flexion[i][j > 0 ? j - 1 : 0];
-				current_finger_joint++;
-			}
+	int current_finger_joint = OPENGLOVES_ALPHA_ENCODING_FinJointThumb0;
+	for (int i = 0; i < 5; i++) {
+		for (int j = 0; j < 4; j++) {
+			// individual joint curls
+			out->flexion[i][j] = values.has_value(current_finger_joint)
+			                         ? values.analog(current_finger_joint)
+			                         // use the curl of the previous joint
+			                         : out->flexion[i][j > 0 ? j - 1 : 0];
+			current_finger_joint++;
 		}
+	}
 
-		// joysticks
-		if (input_map.find(OPENGLOVES_ALPHA_ENCODING_JoyX) != input_map.end())
-			out->joysticks.main.x = 2 * std::stof(input_map.at(OPENGLOVES_ALPHA_ENCODING_JoyX)) /
-			                            OPENGLOVES_ENCODING_MAX_ANALOG_VALUE -
-			                        1;
-		if (input_map.find(OPENGLOVES_ALPHA_ENCODING_JoyY) != input_map.end())
-			out->joysticks.main.y = 2 * std::stof(input_map.at(OPENGLOVES_ALPHA_ENCODING_JoyY)) /
-			                            OPENGLOVES_ENCODING_MAX_ANALOG_VALUE -
-			                        1;
-		out->joysticks.main.pressed = input_map.find(OPENGLOVES_ALPHA_ENCODING_JoyBtn) != input_map.end();
-
-	} catch (std::invalid_argument &e) {
-		U_LOG_E("Error parsing input string: %s", e.what());
+	// joysticks
+	if (values.has_value(OPENGLOVES_ALPHA_ENCODING_JoyX)) {
+		out->joysticks.main.x = 2 * values.analog(OPENGLOVES_ALPHA_ENCODING_JoyX) - 1;
 	}
+	if (values.has_value(OPENGLOVES_ALPHA_ENCODING_JoyY)) {
+		out->joysticks.main.y = 2 * values.analog(OPENGLOVES_ALPHA_ENCODING_JoyY) - 1;
+	}
+	out->joysticks.main.pressed = values.has(OPENGLOVES_ALPHA_ENCODING_JoyBtn);
 
-	if (input_map.find(OPENGLOVES_ALPHA_ENCODING_TrgValue) != input_map.end())
-		out->buttons.trigger.value =
-		    std::stof(input_map.at(OPENGLOVES_ALPHA_ENCODING_TrgValue)) / OPENGLOVES_ENCODING_MAX_ANALOG_VALUE;
-	out->buttons.trigger.pressed = input_map.find(OPENGLOVES_ALPHA_ENCODING_BtnTrg) != input_map.end();
+	if (values.has_value(OPENGLOVES_ALPHA_ENCODING_TrgValue)) {
+		out->buttons.trigger.value = values.analog(OPENGLOVES_ALPHA_ENCODING_TrgValue);
+	}
+	out->buttons.trigger.pressed = values.has(OPENGLOVES_ALPHA_ENCODING_BtnTrg);
 
-	out->buttons.A.pressed = input_map.find(OPENGLOVES_ALPHA_ENCODING_BtnA) != input_map.end();
-	out->buttons.B.pressed = input_map.find(OPENGLOVES_ALPHA_ENCODING_BtnB) != input_map.end();
-	out->gestures.grab.activated = input_map.find(OPENGLOVES_ALPHA_ENCODING_GesGrab) != input_map.end();
-	out->gestures.pinch.activated = input_map.find(OPENGLOVES_ALPHA_ENCODING_GesPinch) != input_map.end();
-	out->buttons.menu.pressed = input_map.find(OPENGLOVES_ALPHA_ENCODING_BtnMenu) != input_map.end();
+	out->buttons.A.pressed = values.has(OPENGLOVES_ALPHA_ENCODING_BtnA);
+	out->buttons.B.pressed = values.has(OPENGLOVES_ALPHA_ENCODING_BtnB);
+	out->gestures.grab.activated = values.has(OPENGLOVES_ALPHA_ENCODING_GesGrab);
+	out->gestures.pinch.activated = values.has(OPENGLOVES_ALPHA_ENCODING_GesPinch);
+	out->buttons.menu.pressed = values.has(OPENGLOVES_ALPHA_ENCODING_BtnMenu);
 }
 
 void
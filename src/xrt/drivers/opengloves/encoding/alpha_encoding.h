@@ -10,12 +10,19 @@
 #pragma once
 #include "encoding.h"
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/*!
+ * Decodes the @p size bytes of one packet, which doesn't need to be null
+ * terminated. Fields that are not in the packet keep their value in @p out,
+ * except for buttons and gestures which are only sent while pressed.
+ */
 void
-opengloves_alpha_encoding_decode(const char *data, struct opengloves_input *out_kv);
+opengloves_alpha_encoding_decode(const char *data, size_t size, struct opengloves_input *out);
 
 void
 opengloves_alpha_encoding_encode(const struct opengloves_output *output, char *out_buff);
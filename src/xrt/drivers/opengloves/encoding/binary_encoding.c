@@ -0,0 +1,144 @@
+// Copyright 2019-2022, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  OpenGloves binary encoding decoding implementation.
+ * @ingroup drv_opengloves
+ */
+
+#include "binary_encoding.h"
+
+
+/*
+ *
+ * Version 1 payload, all fields are uint16_t.
+ *
+ */
+
+enum opengloves_binary_encoding_field
+{
+	//! Curl of the four joints of each finger, thumb first.
+	OPENGLOVES_BINARY_ENCODING_FLEXION = 0,
+	//! Splay of each finger, thumb first.
+	OPENGLOVES_BINARY_ENCODING_SPLAY = OPENGLOVES_BINARY_ENCODING_FLEXION + 5 * 4,
+	OPENGLOVES_BINARY_ENCODING_JOY_X = OPENGLOVES_BINARY_ENCODING_SPLAY + 5,
+	OPENGLOVES_BINARY_ENCODING_JOY_Y,
+	OPENGLOVES_BINARY_ENCODING_TRIGGER,
+	//! Bitmask of @ref opengloves_binary_encoding_button.
+	OPENGLOVES_BINARY_ENCODING_BUTTONS,
+
+	OPENGLOVES_BINARY_ENCODING_V1_FIELD_COUNT,
+};
+
+enum opengloves_binary_encoding_button
+{
+	OPENGLOVES_BINARY_ENCODING_BUTTON_JOY = 1 << 0,
+	OPENGLOVES_BINARY_ENCODING_BUTTON_TRIGGER = 1 << 1,
+	OPENGLOVES_BINARY_ENCODING_BUTTON_A = 1 << 2,
+	OPENGLOVES_BINARY_ENCODING_BUTTON_B = 1 << 3,
+	OPENGLOVES_BINARY_ENCODING_BUTTON_GRAB = 1 << 4,
+	OPENGLOVES_BINARY_ENCODING_BUTTON_PINCH = 1 << 5,
+	OPENGLOVES_BINARY_ENCODING_BUTTON_MENU = 1 << 6,
+	OPENGLOVES_BINARY_ENCODING_BUTTON_CALIB = 1 << 7,
+};
+
+#define OPENGLOVES_BINARY_ENCODING_V1_PAYLOAD_SIZE (OPENGLOVES_BINARY_ENCODING_V1_FIELD_COUNT * 2)
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static inline uint16_t
+read_field(const uint8_t *payload, int field)
+{
+	return (uint16_t)(payload[field * 2] | (payload[field * 2 + 1] << 8));
+}
+
+static inline float
+read_analog(const uint8_t *payload, int field)
+{
+	return (float)read_field(payload, field) / OPENGLOVES_ENCODING_MAX_ANALOG_VALUE;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+int
+opengloves_binary_encoding_frame_size(const uint8_t *data, size_t size)
+{
+	if (size < 1) {
+		return 0;
+	}
+
+	if (data[0] != OPENGLOVES_BINARY_ENCODING_MAGIC) {
+		return -1;
+	}
+
+	if (size < OPENGLOVES_BINARY_ENCODING_HEADER_SIZE) {
+		return 0;
+	}
+
+	uint8_t version = data[1];
+	uint8_t payload_size = data[2];
+	if (version < 1 || payload_size < OPENGLOVES_BINARY_ENCODING_V1_PAYLOAD_SIZE) {
+		return -1;
+	}
+
+	// Header, payload and checksum.
+	int frame_size = OPENGLOVES_BINARY_ENCODING_HEADER_SIZE + payload_size + 1;
+	if (size < (size_t)frame_size) {
+		return 0;
+	}
+
+	return frame_size;
+}
+
+bool
+opengloves_binary_encoding_decode(const uint8_t *data, size_t size, struct opengloves_input *out)
+{
+	int frame_size = opengloves_binary_encoding_frame_size(data, size);
+	if (frame_size <= 0) {
+		return false;
+	}
+
+	const uint8_t *payload = data + OPENGLOVES_BINARY_ENCODING_HEADER_SIZE;
+	uint8_t payload_size = data[2];
+
+	uint8_t checksum = 0;
+	for (uint8_t i = 0; i < payload_size; i++) {
+		checksum ^= payload[i];
+	}
+	if (checksum != payload[payload_size]) {
+		return false;
+	}
+
+	for (int i = 0; i < 5; i++) {
+		for (int j = 0; j < 4; j++) {
+			out->flexion[i][j] = read_analog(payload, OPENGLOVES_BINARY_ENCODING_FLEXION + i * 4 + j);
+		}
+
+		out->splay[i] = (read_analog(payload, OPENGLOVES_BINARY_ENCODING_SPLAY + i) - 0.5f) * 2.0f;
+	}
+
+	out->joysticks.main.x = 2 * read_analog(payload, OPENGLOVES_BINARY_ENCODING_JOY_X) - 1;
+	out->joysticks.main.y = 2 * read_analog(payload, OPENGLOVES_BINARY_ENCODING_JOY_Y) - 1;
+	out->buttons.trigger.value = read_analog(payload, OPENGLOVES_BINARY_ENCODING_TRIGGER);
+
+	uint16_t buttons = read_field(payload, OPENGLOVES_BINARY_ENCODING_BUTTONS);
+	out->joysticks.main.pressed = (buttons & OPENGLOVES_BINARY_ENCODING_BUTTON_JOY) != 0;
+	out->buttons.trigger.pressed = (buttons & OPENGLOVES_BINARY_ENCODING_BUTTON_TRIGGER) != 0;
+	out->buttons.A.pressed = (buttons & OPENGLOVES_BINARY_ENCODING_BUTTON_A) != 0;
+	out->buttons.B.pressed = (buttons & OPENGLOVES_BINARY_ENCODING_BUTTON_B) != 0;
+	out->gestures.grab.activated = (buttons & OPENGLOVES_BINARY_ENCODING_BUTTON_GRAB) != 0;
+	out->gestures.pinch.activated = (buttons & OPENGLOVES_BINARY_ENCODING_BUTTON_PINCH) != 0;
+	out->buttons.menu.pressed = (buttons & OPENGLOVES_BINARY_ENCODING_BUTTON_MENU) != 0;
+
+	return true;
+}
@@ -0,0 +1,56 @@
+// Copyright 2019-2022, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  OpenGloves binary encoding interface.
+ * @ingroup drv_opengloves
+ *
+ * A compact alternative to the alpha encoding for firmware that supports it,
+ * every value is quantized to a little endian uint16_t in the same 0 to
+ * @ref OPENGLOVES_ENCODING_MAX_ANALOG_VALUE range the alpha encoding uses.
+ *
+ * A frame is the @ref OPENGLOVES_BINARY_ENCODING_MAGIC byte, the version, the
+ * payload size in bytes, the payload and a xor checksum of the payload. Newer
+ * versions may only append to the payload, so any version can be decoded as
+ * far as this one knows about.
+ */
+
+#pragma once
+#include "encoding.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! Starts every binary frame, never a character in the alpha encoding.
+#define OPENGLOVES_BINARY_ENCODING_MAGIC 0xf7
+
+//! The version this decoder implements.
+#define OPENGLOVES_BINARY_ENCODING_VERSION 1
+
+//! Magic, version and payload size.
+#define OPENGLOVES_BINARY_ENCODING_HEADER_SIZE 3
+
+/*!
+ * Size of the binary frame at the start of @p data.
+ *
+ * @return The frame size, 0 if more data is needed to tell or negative if
+ *         @p data doesn't start with a valid frame.
+ */
+int
+opengloves_binary_encoding_frame_size(const uint8_t *data, size_t size);
+
+/*!
+ * Decodes a whole frame, as sized by @ref opengloves_binary_encoding_frame_size.
+ *
+ * @return False if the frame is invalid, @p out is left untouched then.
+ */
+bool
+opengloves_binary_encoding_decode(const uint8_t *data, size_t size, struct opengloves_input *out);
+
+#ifdef __cplusplus
+}
+#endif
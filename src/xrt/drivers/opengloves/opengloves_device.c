@@ -8,6 +8,8 @@
  */
 
 #include <stdio.h>
+#include <errno.h>
+#include <string.h>
 
 #include "xrt/xrt_device.h"
 #include "xrt/xrt_defines.h"
@@ -25,11 +27,13 @@
 
 #include "communication/opengloves_communication.h"
 #include "encoding/alpha_encoding.h"
+#include "encoding/binary_encoding.h"
 
 DEBUG_GET_ONCE_LOG_OPTION(opengloves_log, "OPENGLOVES_LOG", U_LOGGING_INFO)
 
 
 #include "os/os_threading.h"
+#include "os/os_time.h"
 #include "util/u_hand_simulation.h"
 
 #define OPENGLOVES_TRACE(d, ...) U_LOG_XDEV_IFL_T(&d->base, d->log_level, __VA_ARGS__)
@@ -60,6 +64,19 @@ enum opengloves_output_index
 	OPENGLOVES_OUTPUT_INDEX_COUNT
 };
 
+/*!
+ * Everything decoded from one packet, published as a whole.
+ */
+struct opengloves_snapshot
+{
+	struct opengloves_input input;
+
+	//! Simulated from the input, relative to the hand.
+	struct xrt_hand_joint_set joints;
+
+	uint64_t timestamp_ns;
+};
+
 /*!
  * @implements xrt_device
  */
@@ -69,9 +86,29 @@ struct opengloves_device
 	struct opengloves_communication_device *ocd;
 
 	struct os_thread_helper oth;
+
+	//! Only protects swapping and copying out of @ref snapshots.
 	struct os_mutex lock;
 
-	struct opengloves_input *last_input;
+	/*!
+	 * Double buffered, the device thread fills in the one not pointed to
+	 * by @ref front and then swaps them. So readers only ever wait for a
+	 * swap, never for reading or decoding a packet.
+	 */
+	struct opengloves_snapshot snapshots[2];
+
+	//! The latest whole snapshot, protected by @ref lock.
+	struct opengloves_snapshot *front;
+
+	//! Only touched by the device thread, fields not in a packet keep their values.
+	struct opengloves_input decoded;
+
+	//! Received bytes not yet decoded, only touched by the device thread.
+	struct
+	{
+		uint8_t data[OPENGLOVES_ENCODING_MAX_PACKET_SIZE * 2];
+		size_t size;
+	} rx;
 
 	enum xrt_hand hand;
 
@@ -95,42 +132,9 @@ opengloves_device_get_hand_tracking(struct xrt_device *xdev,
 {
 	struct opengloves_device *od = opengloves_device(xdev);
 
-	enum xrt_hand hand = od->hand;
-
-	struct u_hand_tracking_values values = {.little =
-	                                            {
-	                                                .splay = od->last_input->splay[4],
-	                                                .joint_count = 5,
-	                                            },
-	                                        .ring =
-	                                            {
-	                                                .splay = od->last_input->splay[3],
-	                                                .joint_count = 5,
-	                                            },
-	                                        .middle =
-	                                            {
-	                                                .splay = od->last_input->splay[2],
-	                                                .joint_count = 5,
-	                                            },
-	                                        .index =
-	                                            {
-	                                                .splay = od->last_input->splay[1],
-	                                                .joint_count = 5,
-	                                            },
-	                                        .thumb = {
-	                                            .splay = od->last_input->splay[0],
-	                                            .joint_count = 4,
-	                                        }};
-	// copy in the curls
-	memcpy(values.little.joint_curls, od->last_input->flexion[4], sizeof(od->last_input->flexion[4]));
-	memcpy(values.ring.joint_curls, od->last_input->flexion[3], sizeof(od->last_input->flexion[3]));
-	memcpy(values.middle.joint_curls, od->last_input->flexion[2], sizeof(od->last_input->flexion[2]));
-	memcpy(values.index.joint_curls, od->last_input->flexion[1], sizeof(od->last_input->flexion[1]));
-	memcpy(values.thumb.joint_curls, od->last_input->flexion[0], sizeof(od->last_input->flexion[0]));
-
-	struct xrt_space_relation ident;
-	m_space_relation_ident(&ident);
-	u_hand_sim_simulate_generic(&values, hand, &ident, out_joint_set);
+	os_mutex_lock(&od->lock);
+	*out_joint_set = od->front->joints;
+	os_mutex_unlock(&od->lock);
 
 	*out_timestamp_ns = requested_timestamp_ns;
 	out_joint_set->is_active = true;
@@ -140,21 +144,29 @@ static void
 opengloves_device_update_inputs(struct xrt_device *xdev)
 {
 	struct opengloves_device *od = opengloves_device(xdev);
+	struct opengloves_input input;
+	uint64_t timestamp_ns;
 
 	os_mutex_lock(&od->lock);
+	input = od->front->input;
+	timestamp_ns = od->front->timestamp_ns;
+	os_mutex_unlock(&od->lock);
 
-	od->base.inputs[OPENGLOVES_INPUT_INDEX_A_CLICK].value.boolean = od->last_input->buttons.A.pressed;
-	od->base.inputs[OPENGLOVES_INPUT_INDEX_B_CLICK].value.boolean = od->last_input->buttons.B.pressed;
+	struct xrt_input *inputs = od->base.inputs;
 
-	od->base.inputs[OPENGLOVES_INPUT_INDEX_TRIGGER_CLICK].value.boolean = od->last_input->buttons.trigger.pressed;
-	od->base.inputs[OPENGLOVES_INPUT_INDEX_TRIGGER_VALUE].value.vec1.x = od->last_input->buttons.trigger.value;
+	inputs[OPENGLOVES_INPUT_INDEX_A_CLICK].value.boolean = input.buttons.A.pressed;
+	inputs[OPENGLOVES_INPUT_INDEX_B_CLICK].value.boolean = input.buttons.B.pressed;
 
-	od->base.inputs[OPENGLOVES_INPUT_INDEX_JOYSTICK_MAIN].value.vec2.x = od->last_input->joysticks.main.x;
-	od->base.inputs[OPENGLOVES_INPUT_INDEX_JOYSTICK_MAIN].value.vec2.y = od->last_input->joysticks.main.y;
-	od->base.inputs[OPENGLOVES_INPUT_INDEX_JOYSTICK_MAIN_CLICK].value.boolean =
-	    od->last_input->joysticks.main.pressed;
+	inputs[OPENGLOVES_INPUT_INDEX_TRIGGER_CLICK].value.boolean = input.buttons.trigger.pressed;
+	inputs[OPENGLOVES_INPUT_INDEX_TRIGGER_VALUE].value.vec1.x = input.buttons.trigger.value;
 
-	os_mutex_unlock(&od->lock);
+	inputs[OPENGLOVES_INPUT_INDEX_JOYSTICK_MAIN].value.vec2.x = input.joysticks.main.x;
+	inputs[OPENGLOVES_INPUT_INDEX_JOYSTICK_MAIN].value.vec2.y = input.joysticks.main.y;
+	inputs[OPENGLOVES_INPUT_INDEX_JOYSTICK_MAIN_CLICK].value.boolean = input.joysticks.main.pressed;
+
+	for (uint32_t i = OPENGLOVES_INPUT_INDEX_TRIGGER_CLICK; i < OPENGLOVES_INPUT_INDEX_COUNT; i++) {
+		inputs[i].timestamp = (int64_t)timestamp_ns;
+	}
 }
 
 static void
@@ -207,45 +219,147 @@ opengloves_device_destroy(struct xrt_device *xdev)
 
 	opengloves_communication_device_destory(od->ocd);
 
-	free(od->last_input);
 	free(od);
 }
 
 
+enum opengloves_packet_type
+{
+	OPENGLOVES_PACKET_ALPHA,
+	OPENGLOVES_PACKET_BINARY,
+};
+
 /*!
- * Reads the next packet from the device, finishing successfully when reaching a newline
- * Returns true if finished at a newline, or false if there was an error
+ * Finds the first whole packet in the received bytes, dropping any bytes that
+ * can't be the start of one.
+ *
+ * @return The packet size, 0 if there isn't a whole one yet.
+ */
+static size_t
+opengloves_find_packet(struct opengloves_device *od, enum opengloves_packet_type *out_type, size_t *out_consumed)
+{
+	while (od->rx.size > 0) {
+		const uint8_t *data = od->rx.data;
+
+		// Firmware that supports it sends binary frames, tell them apart by the magic byte.
+		if (data[0] == OPENGLOVES_BINARY_ENCODING_MAGIC) {
+			int frame_size = opengloves_binary_encoding_frame_size(data, od->rx.size);
+			if (frame_size == 0) {
+				return 0;
+			}
+			if (frame_size < 0) {
+				// Not a valid header, resync on the next byte.
+				memmove(od->rx.data, od->rx.data + 1, --od->rx.size);
+				continue;
+			}
+
+			*out_type = OPENGLOVES_PACKET_BINARY;
+			*out_consumed = (size_t)frame_size;
+			return (size_t)frame_size;
+		}
+
+		const uint8_t *newline = memchr(data, '\n', od->rx.size);
+		if (newline == NULL) {
+			if (od->rx.size == sizeof(od->rx.data)) {
+				OPENGLOVES_WARN(od, "Packet too long, dropping it");
+				od->rx.size = 0;
+			}
+			return 0;
+		}
+
+		size_t size = (size_t)(newline - data);
+
+		*out_type = OPENGLOVES_PACKET_ALPHA;
+		*out_consumed = size + 1;
+		return size;
+	}
+
+	return 0;
+}
+
+/*!
+ * Reads from the device until there is a whole packet, in either encoding, and
+ * decodes it into od->decoded.
+ * Returns true if a packet was decoded, or false if there was an error
  */
 static bool
-opengloves_read_next_packet(struct opengloves_device *od, char *buffer, int buffer_len)
+opengloves_read_next_packet(struct opengloves_device *od)
 {
-	os_thread_helper_lock(&od->oth);
+	while (os_thread_helper_is_running(&od->oth)) {
+		enum opengloves_packet_type type;
+		size_t consumed = 0;
+		size_t size = opengloves_find_packet(od, &type, &consumed);
+
+		if (consumed > 0) {
+			bool decoded = true;
+			if (type == OPENGLOVES_PACKET_BINARY) {
+				decoded = opengloves_binary_encoding_decode(od->rx.data, size, &od->decoded);
+				if (!decoded) {
+					OPENGLOVES_DEBUG(od, "Dropping binary frame with bad checksum");
+				}
+			} else if (size > 0) {
+				OPENGLOVES_TRACE(od, "%.*s -> len %zu", (int)size, (const char *)od->rx.data, size);
+				opengloves_alpha_encoding_decode((const char *)od->rx.data, size, &od->decoded);
+			} else {
+				// Empty line.
+				decoded = false;
+			}
+
+			od->rx.size -= consumed;
+			memmove(od->rx.data, od->rx.data + consumed, od->rx.size);
+
+			if (decoded) {
+				return true;
+			}
+			continue;
+		}
 
-	char next_char = 0;
-	int i = 0;
-	do {
-		// try read one byte
-		int ret = opengloves_communication_device_read(od->ocd, &next_char, 1);
+		// Read as much as there is room for, instead of one byte at a time.
+		int ret = opengloves_communication_device_read(od->ocd, (char *)od->rx.data + od->rx.size,
+		                                               sizeof(od->rx.data) - od->rx.size);
 		if (ret < 0) {
-			OPENGLOVES_ERROR(od, "Failed to read from device! %s", strerror(ret));
-			os_thread_helper_unlock(&od->oth);
+			OPENGLOVES_ERROR(od, "Failed to read from device! %s", strerror(errno));
 			return false;
 		}
 
-		if (next_char == 0 || next_char == '\n')
-			continue;
+		od->rx.size += (size_t)ret;
+	}
+
+	return false;
+}
 
-		buffer[i++] = next_char;
-	} while (next_char != '\n' && i < buffer_len);
+static void
+opengloves_publish_snapshot(struct opengloves_device *od, uint64_t timestamp_ns)
+{
+	// Only this thread swaps, so the back one can be filled in without the lock.
+	struct opengloves_snapshot *back = od->front == &od->snapshots[0] ? &od->snapshots[1] : &od->snapshots[0];
+	const struct opengloves_input *input = &od->decoded;
+
+	struct u_hand_tracking_values values = {
+	    .little = {.splay = input->splay[4], .joint_count = 5},
+	    .ring = {.splay = input->splay[3], .joint_count = 5},
+	    .middle = {.splay = input->splay[2], .joint_count = 5},
+	    .index = {.splay = input->splay[1], .joint_count = 5},
+	    .thumb = {.splay = input->splay[0], .joint_count = 4},
+	};
 
-	// null terminate
-	buffer[i] = '\0';
+	// copy in the curls
+	memcpy(values.little.joint_curls, input->flexion[4], sizeof(input->flexion[4]));
+	memcpy(values.ring.joint_curls, input->flexion[3], sizeof(input->flexion[3]));
+	memcpy(values.middle.joint_curls, input->flexion[2], sizeof(input->flexion[2]));
+	memcpy(values.index.joint_curls, input->flexion[1], sizeof(input->flexion[1]));
+	memcpy(values.thumb.joint_curls, input->flexion[0], sizeof(input->flexion[0]));
 
-	OPENGLOVES_DEBUG(od, "%s -> len %i", buffer, i);
+	struct xrt_space_relation ident;
+	m_space_relation_ident(&ident);
+	u_hand_sim_simulate_generic(&values, od->hand, &ident, &back->joints);
 
-	os_thread_helper_unlock(&od->oth);
+	back->input = *input;
+	back->timestamp_ns = timestamp_ns;
 
-	return true;
+	os_mutex_lock(&od->lock);
+	od->front = back;
+	os_mutex_unlock(&od->lock);
 }
 
 /*!
@@ -256,13 +370,8 @@ opengloves_run_thread(void *ptr)
 {
 	struct opengloves_device *od = (struct opengloves_device *)ptr;
 
-	char buffer[OPENGLOVES_ENCODING_MAX_PACKET_SIZE];
-
-	while (opengloves_read_next_packet(od, buffer, OPENGLOVES_ENCODING_MAX_PACKET_SIZE) &&
-	       os_thread_helper_is_running(&od->oth)) {
-		os_mutex_lock(&od->lock);
-		opengloves_alpha_encoding_decode(buffer, od->last_input);
-		os_mutex_unlock(&od->lock);
+	while (opengloves_read_next_packet(od)) {
+		opengloves_publish_snapshot(od, os_monotonic_get_ns());
 	}
 
 	return 0;
@@ -293,7 +402,8 @@ opengloves_device_create(struct opengloves_communication_device *ocd, enum xrt_h
 
 	// inputs
 	od->base.update_inputs = opengloves_device_update_inputs;
-	od->last_input = U_TYPED_CALLOC(struct opengloves_input);
+	od->front = &od->snapshots[0];
+	opengloves_publish_snapshot(od, os_monotonic_get_ns());
 
 	od->base.inputs[OPENGLOVES_INPUT_INDEX_A_CLICK].name = XRT_INPUT_INDEX_A_CLICK;
 	od->base.inputs[OPENGLOVES_INPUT_INDEX_B_CLICK].name = XRT_INPUT_INDEX_B_CLICK;
@@ -633,7 +633,8 @@ psmv_led_and_trigger_update(struct psmv_device *psmv, int64_t time)
 
 static void
 update_fusion(struct psmv_device *psmv,
-              struct psmv_parsed_sample *sample,
+              const struct xrt_vec3 *accel,
+              const struct xrt_vec3 *gyro,
               timepoint_ns timestamp_ns,
               time_duration_ns delta_ns)
 {
@@ -641,11 +642,8 @@ update_fusion(struct psmv_device *psmv,
 
 	(void)mag;
 
-
-	struct xrt_vec3_i32 *ra = &sample->accel;
-	struct xrt_vec3_i32 *rg = &sample->gyro;
-
-	m_imu_pre_filter_data(&psmv->calibration.prefilter, ra, rg, &psmv->read.accel, &psmv->read.gyro);
+	psmv->read.accel = *accel;
+	psmv->read.gyro = *gyro;
 
 	if (psmv->ball != NULL) {
 		// We have positional tracking
@@ -749,13 +747,25 @@ psmv_run_thread(void *ptr)
 
 		// Process the parsed data.
 		if (num == 2) {
-			// ZCM1
-			update_fusion(psmv, &input.samples[0], now_ns - (delta_ns / 2.0), (delta_ns / 2.0));
-			update_fusion(psmv, &input.samples[1], now_ns, (delta_ns / 2.0));
+			// ZCM1, pre-filter both samples of the packet in one go.
+			struct xrt_vec3_i32 raw_accels[2] = {input.samples[0].accel, input.samples[1].accel};
+			struct xrt_vec3_i32 raw_gyros[2] = {input.samples[0].gyro, input.samples[1].gyro};
+			struct xrt_vec3 accels[2];
+			struct xrt_vec3 gyros[2];
+			m_imu_pre_filter_data_batch(&psmv->calibration.prefilter, raw_accels, raw_gyros, 2, accels,
+			                            gyros);
+
+			update_fusion(psmv, &accels[0], &gyros[0], now_ns - (delta_ns / 2.0), (delta_ns / 2.0));
+			update_fusion(psmv, &accels[1], &gyros[1], now_ns, (delta_ns / 2.0));
 			psmv->last_timestamp_ns = now_ns;
 		} else if (num == 1) {
 			// ZCM2
-			update_fusion(psmv, &input.sample, now_ns, delta_ns);
+			struct xrt_vec3 accel;
+			struct xrt_vec3 gyro;
+			m_imu_pre_filter_data(&psmv->calibration.prefilter, &input.sample.accel, &input.sample.gyro,
+			                      &accel, &gyro);
+
+			update_fusion(psmv, &accel, &gyro, now_ns, delta_ns);
 			psmv->last_timestamp_ns = now_ns;
 		} else {
 			assert(false);
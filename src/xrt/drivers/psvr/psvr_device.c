@@ -27,6 +27,8 @@
 #include "util/u_distortion_mesh.h"
 
 #include "math/m_imu_3dof.h"
+#include "math/m_clock_offset.h"
+#include "math/m_relation_history.h"
 
 #include "math/m_mathinclude.h"
 
@@ -74,6 +76,15 @@ struct psvr_device
 	//! Only touched from the sensor thread.
 	timepoint_ns last_sensor_time;
 
+	//! Device tick counter extended to 64 bits and in ns, only touched from the sensor thread.
+	timepoint_ns hw_time_ns;
+
+	//! Offset from the device clock to monotonic, only touched from the sensor thread.
+	time_duration_ns hw2mono;
+
+	//! Fused orientations at the time of each IMU sample, used when there is no tracker.
+	struct m_relation_history *relation_hist;
+
 	struct psvr_parsed_sensor last;
 
 	struct
@@ -304,29 +315,46 @@ read_sample_and_apply_calibration(struct psvr_device *psvr,
 }
 
 static void
-update_fusion_locked(struct psvr_device *psvr, struct psvr_parsed_sample *sample, uint64_t timestamp_ns)
+update_fusion_locked(struct psvr_device *psvr, struct psvr_parsed_sample samples[2], const uint64_t timestamps_ns[2])
 {
-	struct xrt_vec3 mag = {0.0f, 0.0f, 0.0f};
-	(void)mag;
+	struct xrt_vec3 accels[2];
+	struct xrt_vec3 gyros[2];
 
-	read_sample_and_apply_calibration(psvr, sample, &psvr->read.accel, &psvr->read.gyro);
+	for (int i = 0; i < 2; i++) {
+		read_sample_and_apply_calibration(psvr, &samples[i], &accels[i], &gyros[i]);
+	}
+
+	psvr->read.accel = accels[1];
+	psvr->read.gyro = gyros[1];
 
 	if (psvr->tracker != NULL) {
-		struct xrt_tracking_sample sample;
-		sample.accel_m_s2 = psvr->read.accel;
-		sample.gyro_rad_secs = psvr->read.gyro;
+		for (int i = 0; i < 2; i++) {
+			struct xrt_tracking_sample sample;
+			sample.accel_m_s2 = accels[i];
+			sample.gyro_rad_secs = gyros[i];
 
-		xrt_tracked_psvr_push_imu(psvr->tracker, timestamp_ns, &sample);
+			xrt_tracked_psvr_push_imu(psvr->tracker, timestamps_ns[i], &sample);
+		}
 	} else {
-		m_imu_3dof_update(&psvr->fusion, timestamp_ns, &psvr->read.accel, &psvr->read.gyro);
+		for (int i = 0; i < 2; i++) {
+			m_imu_3dof_update(&psvr->fusion, timestamps_ns[i], &accels[i], &gyros[i]);
+
+			struct xrt_space_relation relation = XRT_SPACE_RELATION_ZERO;
+			relation.pose.orientation = psvr->fusion.rot;
+			math_quat_rotate_vec3(&psvr->fusion.rot, &gyros[i], &relation.angular_velocity);
+			relation.relation_flags = (enum xrt_space_relation_flags)(
+			    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT |
+			    XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT);
+			m_relation_history_push(psvr->relation_hist, &relation, timestamps_ns[i]);
+		}
 	}
 }
 
 static void
-update_fusion(struct psvr_device *psvr, struct psvr_parsed_sample *sample, uint64_t timestamp_ns)
+update_fusion(struct psvr_device *psvr, struct psvr_parsed_sample samples[2], const uint64_t timestamps_ns[2])
 {
 	os_mutex_lock(&psvr->device_mutex);
-	update_fusion_locked(psvr, sample, timestamp_ns);
+	update_fusion_locked(psvr, samples, timestamps_ns);
 	os_mutex_unlock(&psvr->device_mutex);
 }
 
@@ -400,20 +428,22 @@ handle_tracker_sensor_msg(struct psvr_device *psvr, unsigned char *buffer, int s
 	// If this is larger then one second something bad is going on.
 	assert(inter_sample_duration_ns < U_TIME_1S_IN_NS);
 
-	// Move it back in time.
-	timepoint_ns timestamp_ns = (uint64_t)now_ns - (uint64_t)inter_sample_duration_ns;
-
-	// Make sure timestamps are always after a previous timestamp.
-	timestamp_ns = ensure_forward_progress_timestamps(psvr, timestamp_ns);
+	// Keep time in the device clock, the samples are spaced by their ticks not by when the packets arrived.
+	psvr->hw_time_ns += (time_duration_ns)tick_delta * PSVR_NS_PER_TICK;
+	timepoint_ns hw_sample0_ns = psvr->hw_time_ns;
+	psvr->hw_time_ns += inter_sample_duration_ns;
 
-	// Update the fusion with first sample.
-	update_fusion(psvr, &s->samples[0], timestamp_ns);
+	// The last sample was taken just before the packet arrived.
+	timepoint_ns timestamp_ns =
+	    m_clock_offset_a2b(PSVR_PACKETS_PER_SECOND, psvr->hw_time_ns, now_ns, &psvr->hw2mono);
 
 	// Make sure timestamps are always after a previous timestamp.
-	timestamp_ns = ensure_forward_progress_timestamps(psvr, now_ns);
+	uint64_t timestamps_ns[2];
+	timestamps_ns[0] = ensure_forward_progress_timestamps(psvr, hw_sample0_ns + psvr->hw2mono);
+	timestamps_ns[1] = ensure_forward_progress_timestamps(psvr, timestamp_ns);
 
-	// Update the fusion with second sample.
-	update_fusion(psvr, &s->samples[1], timestamp_ns);
+	// Update the fusion with both samples at once.
+	update_fusion(psvr, s->samples, timestamps_ns);
 }
 
 static void
@@ -931,6 +961,7 @@ teardown(struct psvr_device *psvr)
 
 	// Destroy the fusion.
 	m_imu_3dof_close(&psvr->fusion);
+	m_relation_history_destroy(&psvr->relation_hist);
 
 	os_thread_helper_destroy(&psvr->oth);
 	os_mutex_destroy(&psvr->device_mutex);
@@ -978,10 +1009,14 @@ psvr_device_get_tracked_pose(struct xrt_device *xdev,
 
 	// We have no tracking, don't return a position.
 	if (psvr->tracker == NULL) {
-		out_relation->pose.orientation = psvr->fusion.rot;
+		m_relation_history_get(psvr->relation_hist, at_timestamp_ns, out_relation);
 
-		out_relation->relation_flags = (enum xrt_space_relation_flags)(
-		    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT);
+		// Nothing fused yet, still point forward.
+		if (out_relation->relation_flags == 0) {
+			out_relation->pose.orientation.w = 1.0f;
+			out_relation->relation_flags = (enum xrt_space_relation_flags)(
+			    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT);
+		}
 	} else {
 		xrt_tracked_psvr_get_tracked_pose(psvr->tracker, at_timestamp_ns, out_relation);
 	}
@@ -1072,10 +1107,14 @@ psvr_device_create_auto_prober(struct hid_device_info *sensor_hid_info,
 		struct xrt_hmd_parts *hmd = psvr->base.hmd;
 		hmd->distortion.models = XRT_DISTORTION_MODEL_COMPUTE;
 		hmd->distortion.preferred = XRT_DISTORTION_MODEL_COMPUTE;
+
+		u_distortion_set_analytic_panotools(&psvr->base, 0, &psvr->vals);
+		u_distortion_set_analytic_panotools(&psvr->base, 1, &psvr->vals);
 	}
 
 #if 1
 	m_imu_3dof_init(&psvr->fusion, M_IMU_3DOF_USE_GRAVITY_DUR_20MS);
+	m_relation_history_create(&psvr->relation_hist);
 #else
 	psvr->fusion.rot.w = 1.0f;
 #endif
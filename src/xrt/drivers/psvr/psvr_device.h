@@ -53,6 +53,7 @@ enum psvr_status_bits
 
 #define PSVR_TICKS_PER_SECOND (1000000.0) // 1 MHz ticks
 #define PSVR_NS_PER_TICK (1000)           // Each tick is a microsecond
+#define PSVR_PACKETS_PER_SECOND (1000.0f) // Two samples per packet, about 500 ticks apart
 
 #define PSVR_PKG_STATUS 0xF0
 #define PSVR_PKG_DEVICE_NAME 0x80
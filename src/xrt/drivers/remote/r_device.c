@@ -109,6 +109,18 @@ r_device_get_tracked_pose(struct xrt_device *xdev,
 
 	struct r_remote_controller_data *latest = rd->is_left ? &r->latest.left : &r->latest.right;
 
+	// Samples from UDP have timestamps, so we can interpolate.
+	if (r->udp.enabled) {
+		if (!latest->active) {
+			U_ZERO(out_relation);
+			return;
+		}
+
+		struct m_relation_history *hist = rd->is_left ? r->udp.left : r->udp.right;
+		m_relation_history_get(hist, at_timestamp_ns, out_relation);
+		return;
+	}
+
 	/*
 	 * It's easier to reason about angular velocity if it's controlled in
 	 * body space, but the angular velocity returned in the relation is in
@@ -36,8 +36,14 @@ r_hmd(struct xrt_device *xdev)
 }
 
 static inline void
-copy_head_center_to_relation(struct r_hmd *rh, struct xrt_space_relation *out_relation)
+copy_head_center_to_relation(struct r_hmd *rh, uint64_t at_timestamp_ns, struct xrt_space_relation *out_relation)
 {
+	// Samples from UDP have timestamps, so we can interpolate.
+	if (rh->r->udp.enabled && m_relation_history_get_size(rh->r->udp.head) > 0) {
+		m_relation_history_get(rh->r->udp.head, at_timestamp_ns, out_relation);
+		return;
+	}
+
 	out_relation->pose = rh->r->latest.head.center;
 	out_relation->relation_flags = (enum xrt_space_relation_flags)(
 	    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_POSITION_VALID_BIT |
@@ -76,7 +82,7 @@ r_hmd_get_tracked_pose(struct xrt_device *xdev,
 		return;
 	}
 
-	copy_head_center_to_relation(rh, out_relation);
+	copy_head_center_to_relation(rh, at_timestamp_ns, out_relation);
 }
 
 static void
@@ -120,7 +126,7 @@ r_hmd_get_view_poses(struct xrt_device *xdev,
 		return;
 	}
 
-	copy_head_center_to_relation(rh, out_head_relation);
+	copy_head_center_to_relation(rh, at_timestamp_ns, out_head_relation);
 
 	for (uint32_t i = 0; i < view_count; i++) {
 		out_poses[i] = rh->r->latest.head.views[i].pose;
@@ -7,10 +7,15 @@
  * @ingroup drv_remote
  */
 
+#include "os/os_time.h"
+
 #include "util/u_var.h"
 #include "util/u_misc.h"
 #include "util/u_debug.h"
 
+#include "math/m_api.h"
+#include "math/m_relation_history.h"
+
 #include "r_interface.h"
 #include "r_internal.h"
 
@@ -54,6 +59,13 @@
  */
 
 DEBUG_GET_ONCE_LOG_OPTION(remote_log, "REMOTE_LOG", U_LOGGING_INFO)
+DEBUG_GET_ONCE_BOOL_OPTION(remote_udp, "REMOTE_UDP", false)
+
+/*!
+ * How much the clock offset is allowed to grow per datagram, lets it follow
+ * the sender's clock drifting while mostly tracking the lowest latency seen.
+ */
+#define R_UDP_CLOCK_OFFSET_CREEP_NS (1000)
 
 #define R_TRACE(R, ...) U_LOG_IFL_T((R)->rc.log_level, __VA_ARGS__)
 #define R_DEBUG(R, ...) U_LOG_IFL_D((R)->rc.log_level, __VA_ARGS__)
@@ -89,6 +101,12 @@ socket_create(void)
 	return socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
 }
 
+static SOCKET
+socket_create_udp(void)
+{
+	return socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+}
+
 static int
 socket_set_opt(SOCKET id, int flag)
 {
@@ -120,6 +138,12 @@ socket_create(void)
 	return socket(AF_INET, SOCK_STREAM, 0);
 }
 
+static SOCKET
+socket_create_udp(void)
+{
+	return socket(AF_INET, SOCK_DGRAM, 0);
+}
+
 static int
 socket_set_opt(SOCKET id, int flag)
 {
@@ -194,6 +218,58 @@ cleanup:
 	return ret;
 }
 
+static int
+setup_udp_fd(struct r_hub *r)
+{
+	struct sockaddr_in server_address = {0};
+#if defined(XRT_OS_WINDOWS)
+	// Initialize Winsock.
+	WSADATA wsaData;
+	if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+		int error = WSAGetLastError();
+		R_ERROR(r, "Failed to do WSAStartup %ld", error);
+		return error;
+	}
+#endif
+	SOCKET ret = socket_create_udp();
+	if (ret < 0) {
+		R_ERROR(r, "socket: %i", ret);
+		goto cleanup;
+	}
+
+	r->rc.fd = ret;
+
+	int flag = 1;
+	ret = socket_set_opt(r->rc.fd, flag);
+	if (ret < 0) {
+		R_ERROR(r, "setsockopt: %i", ret);
+		socket_close(r->rc.fd);
+		r->rc.fd = -1;
+		goto cleanup;
+	}
+
+	server_address.sin_family = AF_INET;
+	server_address.sin_addr.s_addr = htonl(INADDR_ANY);
+	server_address.sin_port = htons(r->port);
+
+	ret = bind(r->rc.fd, (struct sockaddr *)&server_address, sizeof(server_address));
+	if (ret < 0) {
+		R_ERROR(r, "bind: %i", ret);
+		socket_close(r->rc.fd);
+		r->rc.fd = -1;
+		goto cleanup;
+	}
+
+	R_INFO(r, "Receiving UDP on address %s port %d", inet_ntoa(server_address.sin_addr), r->port);
+
+	return 0;
+cleanup:
+#if defined(XRT_OS_WINDOWS)
+	WSACleanup();
+#endif
+	return ret;
+}
+
 static bool
 wait_for_read_and_to_continue(struct r_hub *r, SOCKET socket)
 {
@@ -294,12 +370,213 @@ read_one(struct r_hub *r, struct r_remote_data *data)
 	return 0;
 }
 
+
+/*
+ *
+ * UDP functions.
+ *
+ */
+
+static void
+controller_to_relation(const struct r_remote_controller_data *data, struct xrt_space_relation *out_relation)
+{
+	// Angular velocity is sent in body space, the relation has it in the base space.
+	math_quat_rotate_derivative(&data->pose.orientation, &data->angular_velocity, &out_relation->angular_velocity);
+
+	out_relation->pose = data->pose;
+	out_relation->linear_velocity = data->linear_velocity;
+	out_relation->relation_flags = (enum xrt_space_relation_flags)(
+	    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_POSITION_VALID_BIT |
+	    XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT | XRT_SPACE_RELATION_POSITION_TRACKED_BIT |
+	    XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT | XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT);
+}
+
+static void
+push_controller(struct m_relation_history *hist, const struct r_remote_controller_data *data, uint64_t timestamp_ns)
+{
+	if (!data->active) {
+		return;
+	}
+
+	struct xrt_space_relation relation = XRT_SPACE_RELATION_ZERO;
+	controller_to_relation(data, &relation);
+	m_relation_history_push(hist, &relation, timestamp_ns);
+}
+
+static void
+push_head(struct m_relation_history *hist, const struct r_head_data *data, uint64_t timestamp_ns)
+{
+	struct xrt_space_relation relation = XRT_SPACE_RELATION_ZERO;
+	relation.pose = data->center;
+	relation.relation_flags = (enum xrt_space_relation_flags)(
+	    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_POSITION_VALID_BIT |
+	    XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT | XRT_SPACE_RELATION_POSITION_TRACKED_BIT);
+	m_relation_history_push(hist, &relation, timestamp_ns);
+}
+
+static size_t
+sample_bits_size(uint32_t bits)
+{
+	size_t size = sizeof(struct r_remote_udp_sample);
+	if (bits & R_UDP_SAMPLE_HEAD) {
+		size += sizeof(struct r_head_data);
+	}
+	if (bits & R_UDP_SAMPLE_LEFT) {
+		size += sizeof(struct r_remote_controller_data);
+	}
+	if (bits & R_UDP_SAMPLE_RIGHT) {
+		size += sizeof(struct r_remote_controller_data);
+	}
+	return size;
+}
+
+//! Reads the header of the sample at @p ptr and moves it past the sample's blocks, false if truncated.
+static bool
+read_sample(const uint8_t **ptr, const uint8_t *end, struct r_remote_udp_sample *out_sample)
+{
+	if ((size_t)(end - *ptr) < sizeof(*out_sample)) {
+		return false;
+	}
+	memcpy(out_sample, *ptr, sizeof(*out_sample));
+
+	size_t size = sample_bits_size(out_sample->bits);
+	if ((size_t)(end - *ptr) < size) {
+		return false;
+	}
+	*ptr += size;
+
+	return true;
+}
+
+static void
+handle_udp_packet(struct r_hub *r, const uint8_t *buf, size_t size)
+{
+	struct r_remote_udp_packet packet;
+	if (size < sizeof(packet)) {
+		R_WARN(r, "Datagram too small: %zu", size);
+		return;
+	}
+	memcpy(&packet, buf, sizeof(packet));
+
+	if (packet.header != R_UDP_HEADER_VALUE) {
+		R_WARN(r, "Datagram with unknown header");
+		return;
+	}
+
+	if (packet.sequence == 0 || !r->udp.started) {
+		// A new stream, the sender might have a different clock now.
+		R_INFO(r, "New UDP stream");
+		m_relation_history_clear(r->udp.head);
+		m_relation_history_clear(r->udp.left);
+		m_relation_history_clear(r->udp.right);
+		r->udp.clock_offset_ns = INT64_MAX;
+		r->udp.started = true;
+	} else {
+		int32_t diff = (int32_t)(packet.sequence - r->udp.last_sequence);
+		if (diff <= 0) {
+			R_TRACE(r, "Dropping late datagram %u, already got %u", packet.sequence, r->udp.last_sequence);
+			r->udp.lost_count++;
+			return;
+		}
+		r->udp.lost_count += (uint64_t)(diff - 1);
+		r->udp.clock_offset_ns += R_UDP_CLOCK_OFFSET_CREEP_NS;
+	}
+	r->udp.last_sequence = packet.sequence;
+
+	const uint8_t *const start = buf + sizeof(packet);
+	const uint8_t *const end = buf + size;
+	const uint8_t *ptr = start;
+
+	// Check that the samples are all there and find the newest one.
+	struct r_remote_udp_sample sample;
+	for (uint32_t i = 0; i < packet.sample_count; i++) {
+		if (!read_sample(&ptr, end, &sample)) {
+			R_WARN(r, "Datagram %u truncated", packet.sequence);
+			return;
+		}
+	}
+	if (packet.sample_count == 0) {
+		return;
+	}
+
+	// Assume the newest sample of the datagram with the lowest latency so far was sent instantly.
+	int64_t offset_ns = (int64_t)os_monotonic_get_ns() - sample.timestamp_ns;
+	if (offset_ns < r->udp.clock_offset_ns) {
+		r->udp.clock_offset_ns = offset_ns;
+	}
+
+	ptr = start;
+	for (uint32_t i = 0; i < packet.sample_count; i++) {
+		read_sample(&ptr, end, &sample);
+		const uint8_t *block = ptr - sample_bits_size(sample.bits) + sizeof(sample);
+
+		uint64_t timestamp_ns = (uint64_t)(sample.timestamp_ns + r->udp.clock_offset_ns);
+
+		if (sample.bits & R_UDP_SAMPLE_HEAD) {
+			memcpy(&r->latest.head, block, sizeof(r->latest.head));
+			block += sizeof(r->latest.head);
+			push_head(r->udp.head, &r->latest.head, timestamp_ns);
+		}
+		if (sample.bits & R_UDP_SAMPLE_LEFT) {
+			memcpy(&r->latest.left, block, sizeof(r->latest.left));
+			block += sizeof(r->latest.left);
+			push_controller(r->udp.left, &r->latest.left, timestamp_ns);
+		}
+		if (sample.bits & R_UDP_SAMPLE_RIGHT) {
+			memcpy(&r->latest.right, block, sizeof(r->latest.right));
+			block += sizeof(r->latest.right);
+			push_controller(r->udp.right, &r->latest.right, timestamp_ns);
+		}
+	}
+}
+
+static void
+run_udp(struct r_hub *r)
+{
+	uint8_t buf[R_UDP_MAX_PACKET_SIZE * 2];
+
+	while (os_thread_helper_is_running(&r->oth)) {
+		if (!wait_for_read_and_to_continue(r, r->rc.fd)) {
+			break;
+		}
+
+		// Drain everything that is queued before waiting again.
+		while (true) {
+#if defined(XRT_OS_WINDOWS)
+			ssize_t ret = recv(r->rc.fd, (char *)buf, sizeof(buf), 0);
+#else
+			ssize_t ret = recv(r->rc.fd, buf, sizeof(buf), MSG_DONTWAIT);
+#endif
+			if (ret <= 0) {
+				break;
+			}
+
+			handle_udp_packet(r, buf, (size_t)ret);
+
+#if defined(XRT_OS_WINDOWS)
+			// No MSG_DONTWAIT, only read what select said was there.
+			break;
+#endif
+		}
+	}
+}
+
 static void *
 run_thread(void *ptr)
 {
 	struct r_hub *r = (struct r_hub *)ptr;
 	int ret;
 
+	if (r->udp.enabled) {
+		ret = setup_udp_fd(r);
+		if (ret == 0) {
+			run_udp(r);
+		}
+
+		R_INFO(r, "Leaving thread");
+		return NULL;
+	}
+
 	ret = setup_accept_fd(r);
 	if (ret < 0) {
 		R_INFO(r, "Leaving thread");
@@ -361,6 +638,10 @@ r_hub_system_devices_destroy(struct xrt_system_devices *xsysd)
 		r->rc.fd = -1;
 	}
 
+	m_relation_history_destroy(&r->udp.head);
+	m_relation_history_destroy(&r->udp.left);
+	m_relation_history_destroy(&r->udp.right);
+
 	free(r);
 
 #if defined(XRT_OS_WINDOWS)
@@ -408,6 +689,10 @@ r_create_devices(uint16_t port, struct xrt_system_devices **out_xsysd)
 	r->port = port;
 	r->accept_fd = -1;
 	r->rc.fd = -1;
+	r->udp.enabled = debug_get_bool_option_remote_udp();
+	m_relation_history_create(&r->udp.head);
+	m_relation_history_create(&r->udp.left);
+	m_relation_history_create(&r->udp.right);
 
 	snprintf(r->origin.name, sizeof(r->origin.name), "Remote Simulator");
 
@@ -458,6 +743,9 @@ r_create_devices(uint16_t port, struct xrt_system_devices **out_xsysd)
 	// u_var_add_gui_header(r, &r->gui.right, "Right");
 	u_var_add_bool(r, &r->latest.right.active, "right.active");
 	u_var_add_pose(r, &r->latest.right.pose, "right.pose");
+	if (r->udp.enabled) {
+		u_var_add_ro_u64(r, &r->udp.lost_count, "udp.lost_count");
+	}
 
 	/*
 	 * Done now.
@@ -475,6 +763,29 @@ r_create_devices(uint16_t port, struct xrt_system_devices **out_xsysd)
  *
  */
 
+static int
+connection_fill_address(struct r_remote_connection *rc, const char *ip_addr, uint16_t port, struct sockaddr_in *addr)
+{
+	int ret;
+
+	// Address
+	addr->sin_family = AF_INET;
+	addr->sin_port = htons(port);
+
+	// inet_pton/InetPton resolves "localhost" as 0.0.0.0 or 255.255.255.255, and it causes connection error. To
+	// avoid this issue, the following logic converts "localhost" to "127.0.0.1" first.
+	if (strcmp("localhost", ip_addr) == 0) {
+		ret = inet_pton(AF_INET, "127.0.0.1", &addr->sin_addr);
+	} else {
+		ret = inet_pton(AF_INET, ip_addr, &addr->sin_addr);
+	}
+	if (ret < 0) {
+		RC_ERROR(rc, "Failed to do inet pton for %s: %i", ip_addr, ret);
+	}
+
+	return ret;
+}
+
 int
 r_remote_connection_init(struct r_remote_connection *rc, const char *ip_addr, uint16_t port)
 {
@@ -495,19 +806,8 @@ r_remote_connection_init(struct r_remote_connection *rc, const char *ip_addr, ui
 	}
 #endif
 
-	// Address
-	addr.sin_family = AF_INET;
-	addr.sin_port = htons(port);
-
-	// inet_pton/InetPton resolves "localhost" as 0.0.0.0 or 255.255.255.255, and it causes connection error. To
-	// avoid this issue, the following logic converts "localhost" to "127.0.0.1" first.
-	if (strcmp("localhost", ip_addr) == 0) {
-		ret = inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
-	} else {
-		ret = inet_pton(AF_INET, ip_addr, &addr.sin_addr);
-	}
+	ret = connection_fill_address(rc, ip_addr, port, &addr);
 	if (ret < 0) {
-		RC_ERROR(rc, "Failed to do inet pton for %s: %i", ip_addr, ret);
 		goto cleanup;
 	}
 
@@ -556,6 +856,63 @@ cleanup:
 	return ret;
 }
 
+int
+r_remote_connection_init_udp(struct r_remote_connection *rc, const char *ip_addr, uint16_t port)
+{
+	struct sockaddr_in addr = {0};
+	int conn_fd;
+	int ret;
+
+	// Set log level.
+	rc->log_level = debug_get_log_option_remote_log();
+
+#if defined(XRT_OS_WINDOWS)
+	// Initialize Winsock.
+	WSADATA wsaData;
+	ret = WSAStartup(MAKEWORD(2, 2), &wsaData);
+	if (ret != 0) {
+		RC_ERROR(rc, "Failed to do WSAStartup %ld", WSAGetLastError());
+		return ret;
+	}
+#endif
+
+	ret = connection_fill_address(rc, ip_addr, port, &addr);
+	if (ret < 0) {
+		goto cleanup;
+	}
+
+	ret = socket_create_udp();
+	if (ret < 0) {
+		RC_ERROR(rc, "Failed to create socket: %i", ret);
+		goto cleanup;
+	}
+
+	conn_fd = ret;
+
+	// Only sets the default destination, nothing is sent.
+	ret = connect(conn_fd, (struct sockaddr *)&addr, sizeof(addr));
+	if (ret != 0) {
+		RC_ERROR(rc, "Failed to connect id %d and addr %s with failure %d", conn_fd, inet_ntoa(addr.sin_addr),
+		         ret);
+		socket_close(conn_fd);
+		goto cleanup;
+	}
+
+	rc->fd = conn_fd;
+	rc->udp = true;
+	rc->sequence = 0;
+	rc->since_key = 0;
+	U_ZERO(&rc->sent);
+
+	return 0;
+
+cleanup:
+#if defined(XRT_OS_WINDOWS)
+	WSACleanup();
+#endif
+	return ret;
+}
+
 int
 r_remote_connection_read_one(struct r_remote_connection *rc, struct r_remote_data *data)
 {
@@ -604,3 +961,107 @@ r_remote_connection_write_one(struct r_remote_connection *rc, const struct r_rem
 
 	return 0;
 }
+
+static void
+connection_send_packet(struct r_remote_connection *rc, uint8_t *buf, size_t size, uint32_t sample_count)
+{
+	struct r_remote_udp_packet packet = {
+	    .header = R_UDP_HEADER_VALUE,
+	    .sequence = rc->sequence++,
+	    .sample_count = sample_count,
+	};
+	memcpy(buf, &packet, sizeof(packet));
+
+#if defined(XRT_OS_WINDOWS)
+	ssize_t ret = send(rc->fd, (const char *)buf, (int)size, 0);
+#else
+	ssize_t ret = send(rc->fd, buf, size, 0);
+#endif
+	if (ret < 0) {
+		// Nobody listening yet is not an error for UDP, keep going.
+		RC_DEBUG(rc, "send: %zi", ret);
+	}
+
+	rc->since_key++;
+}
+
+int
+r_remote_connection_write_samples(struct r_remote_connection *rc,
+                                  const struct r_remote_data *samples,
+                                  const int64_t *timestamps_ns,
+                                  uint32_t count)
+{
+	if (!rc->udp) {
+		RC_ERROR(rc, "Samples can only be written to UDP connections");
+		return -1;
+	}
+
+	uint8_t buf[R_UDP_MAX_PACKET_SIZE];
+	size_t used = sizeof(struct r_remote_udp_packet);
+	uint32_t sample_count = 0;
+
+	const uint32_t all_bits = R_UDP_SAMPLE_HEAD | R_UDP_SAMPLE_LEFT | R_UDP_SAMPLE_RIGHT;
+
+	for (uint32_t i = 0; i < count; i++) {
+		const struct r_remote_data *data = &samples[i];
+
+		// Make sure the sample fits, whatever changed.
+		if (used + sample_bits_size(all_bits) > sizeof(buf)) {
+			connection_send_packet(rc, buf, used, sample_count);
+			used = sizeof(struct r_remote_udp_packet);
+			sample_count = 0;
+		}
+
+		// The first sample of a key datagram carries everything.
+		bool key = sample_count == 0 && (rc->sequence == 0 || rc->since_key >= R_UDP_KEY_INTERVAL);
+
+		uint32_t bits = 0;
+		if (key || memcmp(&data->head, &rc->sent.head, sizeof(data->head)) != 0) {
+			bits |= R_UDP_SAMPLE_HEAD;
+		}
+		if (key || memcmp(&data->left, &rc->sent.left, sizeof(data->left)) != 0) {
+			bits |= R_UDP_SAMPLE_LEFT;
+		}
+		if (key || memcmp(&data->right, &rc->sent.right, sizeof(data->right)) != 0) {
+			bits |= R_UDP_SAMPLE_RIGHT;
+		}
+
+		if (bits == 0) {
+			// Nothing changed, nothing new for the other side.
+			continue;
+		}
+
+		if (key) {
+			rc->since_key = 0;
+		}
+
+		struct r_remote_udp_sample sample = {
+		    .timestamp_ns = timestamps_ns[i],
+		    .bits = bits,
+		};
+		memcpy(buf + used, &sample, sizeof(sample));
+		used += sizeof(sample);
+
+		if (bits & R_UDP_SAMPLE_HEAD) {
+			memcpy(buf + used, &data->head, sizeof(data->head));
+			used += sizeof(data->head);
+		}
+		if (bits & R_UDP_SAMPLE_LEFT) {
+			memcpy(buf + used, &data->left, sizeof(data->left));
+			used += sizeof(data->left);
+		}
+		if (bits & R_UDP_SAMPLE_RIGHT) {
+			memcpy(buf + used, &data->right, sizeof(data->right));
+			used += sizeof(data->right);
+		}
+
+		rc->sent = *data;
+		sample_count++;
+	}
+
+	if (sample_count > 0) {
+		connection_send_packet(rc, buf, used, sample_count);
+	}
+
+	return 0;
+}
@@ -116,6 +116,77 @@ struct r_remote_data
 	struct r_remote_controller_data left, right;
 };
 
+/*!
+ * Header value to be set in UDP datagrams, see @ref r_remote_udp_packet.
+ *
+ * @ingroup drv_remote
+ */
+#define R_UDP_HEADER_VALUE (*(uint64_t *)"mndrmu1\0")
+
+/*!
+ * Largest datagram that is sent, keeps them under a typical MTU.
+ *
+ * @ingroup drv_remote
+ */
+#define R_UDP_MAX_PACKET_SIZE 1400
+
+/*!
+ * Every this many datagrams the first sample carries all of the blocks,
+ * so state lost with a datagram is restored soon even if it doesn't change.
+ *
+ * @ingroup drv_remote
+ */
+#define R_UDP_KEY_INTERVAL 30
+
+/*!
+ * Which blocks of @ref r_remote_data follow a @ref r_remote_udp_sample.
+ *
+ * @ingroup drv_remote
+ */
+enum r_remote_udp_sample_bits
+{
+	R_UDP_SAMPLE_HEAD = 1u << 0,
+	R_UDP_SAMPLE_LEFT = 1u << 1,
+	R_UDP_SAMPLE_RIGHT = 1u << 2,
+};
+
+/*!
+ * Start of a UDP datagram, followed by @ref r_remote_udp_packet::sample_count samples.
+ *
+ * Each sample is a @ref r_remote_udp_sample followed by the
+ * @ref r_head_data and @ref r_remote_controller_data blocks named in its
+ * bits, in that order. A block is only sent when it has changed since the
+ * last sample, or in the first sample of every @ref R_UDP_KEY_INTERVAL
+ * datagram.
+ *
+ * @ingroup drv_remote
+ */
+struct r_remote_udp_packet
+{
+	uint64_t header;
+
+	//! Increases by one per datagram, zero starts a new stream.
+	uint32_t sequence;
+
+	uint32_t sample_count;
+};
+
+/*!
+ * A single sample in a @ref r_remote_udp_packet.
+ *
+ * @ingroup drv_remote
+ */
+struct r_remote_udp_sample
+{
+	//! When the sample was taken, in the monotonic clock of the sender.
+	int64_t timestamp_ns;
+
+	//! @ref r_remote_udp_sample_bits
+	uint32_t bits;
+
+	uint32_t _pad;
+};
+
 /*!
  * Shared connection.
  *
@@ -128,6 +199,18 @@ struct r_remote_connection
 
 	//! Socket.
 	int fd;
+
+	//! Is this a UDP connection, only samples can be written then.
+	bool udp;
+
+	//! Sequence number of the next datagram.
+	uint32_t sequence;
+
+	//! Datagrams sent since the last one that carried all blocks.
+	uint32_t since_key;
+
+	//! The last state sent, only changed blocks are sent.
+	struct r_remote_data sent;
 };
 
 /*!
@@ -146,12 +229,34 @@ r_create_devices(uint16_t port, struct xrt_system_devices **out_xsysd);
 int
 r_remote_connection_init(struct r_remote_connection *rc, const char *addr, uint16_t port);
 
+/*!
+ * Initializes the connection to send samples as UDP datagrams, the hub must
+ * have been started with `REMOTE_UDP` set.
+ *
+ * @ingroup drv_remote
+ */
+int
+r_remote_connection_init_udp(struct r_remote_connection *rc, const char *addr, uint16_t port);
+
 int
 r_remote_connection_read_one(struct r_remote_connection *rc, struct r_remote_data *data);
 
 int
 r_remote_connection_write_one(struct r_remote_connection *rc, const struct r_remote_data *data);
 
+/*!
+ * Sends @p count samples, taken at the given monotonic timestamps which must
+ * be increasing, over a UDP connection. As many samples as fit are packed
+ * into each datagram and only the parts that changed are sent.
+ *
+ * @ingroup drv_remote
+ */
+int
+r_remote_connection_write_samples(struct r_remote_connection *rc,
+                                  const struct r_remote_data *samples,
+                                  const int64_t *timestamps_ns,
+                                  uint32_t count);
+
 
 #ifdef __cplusplus
 }
@@ -15,6 +15,8 @@
 
 #include "os/os_threading.h"
 
+#include "math/m_relation_history.h"
+
 #include "util/u_hand_tracking.h"
 
 #include "r_interface.h"
@@ -58,6 +60,27 @@ struct r_hub
 	{
 		bool hmd, left, right;
 	} gui;
+
+	//! State of receiving samples over UDP.
+	struct
+	{
+		//! Receiving over UDP, poses are then interpolated from the histories.
+		bool enabled;
+
+		//! Has a datagram of the current stream been received.
+		bool started;
+
+		//! Sequence number of the last datagram accepted.
+		uint32_t last_sequence;
+
+		//! Datagrams that never arrived, or arrived too late.
+		uint64_t lost_count;
+
+		//! Added to the sender's timestamps to get ours, tracks the lowest latency seen.
+		int64_t clock_offset_ns;
+
+		struct m_relation_history *head, *left, *right;
+	} udp;
 };
 
 /*!
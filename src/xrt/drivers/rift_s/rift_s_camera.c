@@ -33,6 +33,7 @@
 #include "util/u_var.h"
 #include "util/u_sink.h"
 #include "util/u_frame.h"
+#include "util/u_passthrough.h"
 #include "util/u_trace_marker.h"
 
 #define DEFAULT_EXPOSURE 6000
@@ -223,7 +224,7 @@ rift_s_camera_create(struct xrt_prober *xp,
 			break;
 		}
 		if (modes[selected_mode].format == XRT_FORMAT_MJPEG) {
-			u_sink_create_format_converter(xfctx, XRT_FORMAT_L8, tmp, &tmp);
+			u_sink_create_mjpeg_decoder(xfctx, XRT_FORMAT_L8, 1, tmp, &tmp);
 			found_mode = true;
 			break;
 		}
@@ -375,6 +376,8 @@ receive_cam_frame(struct xrt_frame_sink *sink, struct xrt_frame *xf)
 
 	if (!parse_frame_data(xf, &row_data)) {
 		RIFT_S_TRACE("Invalid frame top-row data. Skipping");
+		if (release_xf)
+			xrt_frame_reference(&xf, NULL);
 		return;
 	}
 
@@ -390,13 +393,15 @@ receive_cam_frame(struct xrt_frame_sink *sink, struct xrt_frame *xf)
 
 	// If the top left pixel is > 128, send as SLAM frame else controller
 	if (row_data.data.frame_type & 0x80) {
-		int y_offset = get_y_offset(cam, 0, &row_data);
-		struct xrt_rect roi = {.offset = {0, y_offset}, .extent = {.w = xf->width, .h = 480}};
-
-		struct xrt_frame *xf_crop = NULL;
-		u_frame_create_roi(xf, roi, &xf_crop);
-		u_sink_debug_push_frame(&cam->debug_sinks[0], xf_crop);
-		xrt_frame_reference(&xf_crop, NULL);
+		if (u_sink_debug_is_active(&cam->debug_sinks[0])) {
+			int y_offset = get_y_offset(cam, 0, &row_data);
+			struct xrt_rect roi = {.offset = {0, y_offset}, .extent = {.w = xf->width, .h = 480}};
+
+			struct xrt_frame *xf_crop = NULL;
+			u_frame_create_roi(xf, roi, &xf_crop);
+			u_sink_debug_push_frame(&cam->debug_sinks[0], xf_crop);
+			xrt_frame_reference(&xf_crop, NULL);
+		}
 
 		/* Extract camera frames and push to the tracker */
 		struct xrt_frame *frames[RIFT_S_CAMERA_COUNT] = {0};
@@ -411,10 +416,16 @@ receive_cam_frame(struct xrt_frame_sink *sink, struct xrt_frame *xf)
 		uint64_t frame_ts_ns = (uint64_t)__le64_to_cpu(row_data.data.frame_ts) * OS_NS_PER_USEC;
 		rift_s_tracker_push_slam_frames(cam->tracker, frame_ts_ns, frames);
 
+		// The first two are the front facing cameras.
+		if (u_passthrough_is_active()) {
+			u_passthrough_push_frame(0, frames[0]);
+			u_passthrough_push_frame(1, frames[1]);
+		}
+
 		for (int i = 0; i < RIFT_S_CAMERA_COUNT; i++) {
 			xrt_frame_reference(&frames[i], NULL);
 		}
-	} else {
+	} else if (u_sink_debug_is_active(&cam->debug_sinks[1])) {
 		struct xrt_rect roi = {.offset = {0, 40}, .extent = {.w = xf->width, .h = 480}};
 		struct xrt_frame *xf_crop = NULL;
 
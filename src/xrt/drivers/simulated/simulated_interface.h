@@ -43,6 +43,18 @@ enum simulated_movement
 	SIMULATED_MOVEMENT_STATIONARY,
 };
 
+/*!
+ * What kind of load generating device to create.
+ *
+ * @ingroup drv_simulated
+ */
+enum simulated_load_kind
+{
+	SIMULATED_LOAD_TRACKER,
+	SIMULATED_LOAD_CONTROLLER,
+	SIMULATED_LOAD_HAND,
+};
+
 /*!
  * Return the logging level that we want for the simulated related code.
  *
@@ -88,6 +100,22 @@ simulated_create_controller(enum xrt_device_name name,
                             const struct xrt_pose *center,
                             struct xrt_tracking_origin *origin);
 
+/*!
+ * Create a device that generates load, for testing how the service scales with
+ * many devices. Its own thread pushes noisy poses at @p rate_hz, like a real
+ * driver, and its inputs change every frame. The @p index is used to tell the
+ * devices apart and vary their movement, hands alternate between left and
+ * right.
+ *
+ * @ingroup drv_simulated
+ */
+struct xrt_device *
+simulated_create_load_device(enum simulated_load_kind kind,
+                             uint32_t index,
+                             float rate_hz,
+                             const struct xrt_pose *center,
+                             struct xrt_tracking_origin *origin);
+
 
 #ifdef __cplusplus
 }
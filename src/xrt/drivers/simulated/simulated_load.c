@@ -0,0 +1,432 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Simulated devices that generate load, for scale testing.
+ * @ingroup drv_simulated
+ */
+
+#include "xrt/xrt_device.h"
+
+#include "os/os_time.h"
+#include "os/os_threading.h"
+
+#include "math/m_api.h"
+#include "math/m_vec3.h"
+#include "math/m_mathinclude.h"
+
+#include "util/u_var.h"
+#include "util/u_misc.h"
+#include "util/u_time.h"
+#include "util/u_device.h"
+#include "util/u_device_poses.h"
+#include "util/u_logging.h"
+#include "util/u_hand_simulation.h"
+
+#include "simulated_interface.h"
+
+#include <stdio.h>
+#include <assert.h>
+
+
+/*
+ *
+ * Structs and defines.
+ *
+ */
+
+/*!
+ * A device whose pose is pushed into a pose history by its own thread at
+ * a fixed rate, like a real driver, with noise on top of a slow movement. The
+ * inputs change on every update, so they are copied out every frame.
+ */
+struct simulated_load_device
+{
+	struct xrt_device base;
+
+	//! Poses are pushed by the thread and read by get_tracked_pose.
+	struct u_device_poses poses;
+
+	struct os_thread_helper oth;
+
+	struct xrt_pose center;
+
+	//! Rate the thread pushes poses at.
+	float rate_hz;
+
+	//! Standard deviation of the noise added to each pose.
+	float position_noise_m;
+	float orientation_noise_rad;
+
+	//! Speed of the movement, so that the devices don't move in lockstep.
+	float speed;
+
+	//! Noise generator state, only used by the thread.
+	uint32_t rng;
+
+	//! Only set for hand devices.
+	enum xrt_hand hand;
+};
+
+
+/*
+ *
+ * Helper functions.
+ *
+ */
+
+static inline struct simulated_load_device *
+simulated_load_device(struct xrt_device *xdev)
+{
+	return (struct simulated_load_device *)xdev;
+}
+
+static float
+next_uniform(uint32_t *state)
+{
+	// xorshift32, good enough for noise.
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+
+	return (float)(x >> 8) / (float)(1 << 24);
+}
+
+//! Roughly normal with a standard deviation of one, sum of uniform samples.
+static float
+next_normal(uint32_t *state)
+{
+	float sum = 0.0f;
+	for (int i = 0; i < 12; i++) {
+		sum += next_uniform(state);
+	}
+	return sum - 6.0f;
+}
+
+static void
+calc_relation(struct simulated_load_device *sld, uint64_t now_ns, struct xrt_space_relation *out_relation)
+{
+	const float radius = 0.05f;
+
+	float t = (float)time_ns_to_s(now_ns) * sld->speed;
+	float s = sinf(t);
+	float c = cosf(t);
+
+	struct xrt_space_relation rel = XRT_SPACE_RELATION_ZERO;
+	rel.pose = sld->center;
+	rel.pose.position.x += radius * c + sld->position_noise_m * next_normal(&sld->rng);
+	rel.pose.position.y += radius * s + sld->position_noise_m * next_normal(&sld->rng);
+	rel.pose.position.z += sld->position_noise_m * next_normal(&sld->rng);
+	rel.linear_velocity = (struct xrt_vec3){-radius * s * sld->speed, radius * c * sld->speed, 0.0f};
+
+	struct xrt_vec3 rot = {
+	    sld->orientation_noise_rad * next_normal(&sld->rng),
+	    0.5f * s + sld->orientation_noise_rad * next_normal(&sld->rng),
+	    sld->orientation_noise_rad * next_normal(&sld->rng),
+	};
+	struct xrt_quat q;
+	math_quat_from_angle_vector(m_vec3_len(rot), &rot, &q);
+	if (!math_quat_validate(&q)) {
+		q = (struct xrt_quat)XRT_QUAT_IDENTITY;
+	}
+	math_quat_rotate(&sld->center.orientation, &q, &rel.pose.orientation);
+	rel.angular_velocity = (struct xrt_vec3){0.0f, 0.5f * c * sld->speed, 0.0f};
+
+	rel.relation_flags = (enum xrt_space_relation_flags)(
+	    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_POSITION_VALID_BIT |
+	    XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT | XRT_SPACE_RELATION_POSITION_TRACKED_BIT |
+	    XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT | XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT);
+
+	*out_relation = rel;
+}
+
+static void *
+run_thread(void *ptr)
+{
+	struct simulated_load_device *sld = (struct simulated_load_device *)ptr;
+
+	os_thread_helper_name(&sld->oth, "Simulated load");
+
+	struct os_precise_sleeper sleeper;
+	os_precise_sleeper_init(&sleeper);
+
+	uint64_t period_ns = (uint64_t)(U_TIME_1S_IN_NS / sld->rate_hz);
+	uint64_t next_ns = os_monotonic_get_ns();
+
+	os_thread_helper_lock(&sld->oth);
+	while (os_thread_helper_is_running_locked(&sld->oth)) {
+		os_thread_helper_unlock(&sld->oth);
+
+		uint64_t now_ns = os_monotonic_get_ns();
+
+		struct xrt_space_relation rel;
+		calc_relation(sld, now_ns, &rel);
+		for (uint32_t i = 0; i < sld->base.input_count; i++) {
+			u_device_poses_push(&sld->poses, sld->base.inputs[i].name, &rel, now_ns);
+		}
+
+		// Don't try to catch up if we fell behind.
+		next_ns += period_ns;
+		if (next_ns < now_ns) {
+			next_ns = now_ns + period_ns;
+		}
+		os_precise_sleeper_wait_until(&sleeper, next_ns);
+
+		os_thread_helper_lock(&sld->oth);
+	}
+	os_thread_helper_unlock(&sld->oth);
+
+	os_precise_sleeper_deinit(&sleeper);
+
+	return NULL;
+}
+
+
+/*
+ *
+ * Member functions.
+ *
+ */
+
+static void
+simulated_load_destroy(struct xrt_device *xdev)
+{
+	struct simulated_load_device *sld = simulated_load_device(xdev);
+
+	// Stop the thread before anything it uses goes away.
+	os_thread_helper_destroy(&sld->oth);
+
+	u_var_remove_root(sld);
+
+	u_device_poses_fini(&sld->poses);
+
+	u_device_free(&sld->base);
+}
+
+static void
+simulated_load_update_inputs(struct xrt_device *xdev)
+{
+	uint64_t now = os_monotonic_get_ns();
+
+	// Something changes every frame, so the service has to copy it out.
+	float t = (float)time_ns_to_s(now);
+	bool pressed = ((now / (250 * U_TIME_1MS_IN_NS)) % 2) == 0;
+
+	for (uint32_t i = 0; i < xdev->input_count; i++) {
+		struct xrt_input *input = &xdev->inputs[i];
+		input->active = true;
+		input->timestamp = now;
+
+		switch (XRT_GET_INPUT_TYPE(input->name)) {
+		case XRT_INPUT_TYPE_BOOLEAN: input->value.boolean = pressed; break;
+		case XRT_INPUT_TYPE_VEC1_ZERO_TO_ONE: input->value.vec1.x = 0.5f + 0.5f * sinf(t + (float)i); break;
+		case XRT_INPUT_TYPE_VEC2_MINUS_ONE_TO_ONE:
+			input->value.vec2.x = sinf(t + (float)i);
+			input->value.vec2.y = cosf(t + (float)i);
+			break;
+		default: break;
+		}
+	}
+}
+
+static void
+simulated_load_get_tracked_pose(struct xrt_device *xdev,
+                                enum xrt_input_name name,
+                                uint64_t at_timestamp_ns,
+                                struct xrt_space_relation *out_relation)
+{
+	struct simulated_load_device *sld = simulated_load_device(xdev);
+
+	if (XRT_GET_INPUT_TYPE(name) != XRT_INPUT_TYPE_POSE) {
+		U_LOG_E("Unknown input name: 0x%0x", name);
+		return;
+	}
+
+	u_device_poses_get(&sld->poses, name, at_timestamp_ns, out_relation);
+}
+
+static void
+simulated_load_get_hand_tracking(struct xrt_device *xdev,
+                                 enum xrt_input_name name,
+                                 uint64_t requested_timestamp_ns,
+                                 struct xrt_hand_joint_set *out_value,
+                                 uint64_t *out_timestamp_ns)
+{
+	struct simulated_load_device *sld = simulated_load_device(xdev);
+
+	struct xrt_space_relation root;
+	u_device_poses_get(&sld->poses, name, requested_timestamp_ns, &root);
+
+	// Open and close the hand about once a second.
+	float curl = 0.5f + 0.5f * sinf((float)time_ns_to_s(requested_timestamp_ns) * 6.0f * sld->speed);
+	struct u_hand_tracking_curl_values values = {
+	    .little = curl,
+	    .ring = curl,
+	    .middle = curl,
+	    .index = curl,
+	    .thumb = curl * 0.5f,
+	};
+
+	u_hand_sim_simulate_for_valve_index_knuckles(&values, sld->hand, &root, out_value);
+
+	*out_timestamp_ns = requested_timestamp_ns;
+	out_value->is_active = true;
+}
+
+static void
+simulated_load_get_view_poses(struct xrt_device *xdev,
+                              const struct xrt_vec3 *default_eye_relation,
+                              uint64_t at_timestamp_ns,
+                              uint32_t view_count,
+                              struct xrt_space_relation *out_head_relation,
+                              struct xrt_fov *out_fovs,
+                              struct xrt_pose *out_poses)
+{
+	assert(false);
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+static enum xrt_input_name tracker_inputs_array[] = {
+    XRT_INPUT_GENERIC_TRACKER_POSE,
+};
+
+static enum xrt_input_name controller_inputs_array[] = {
+    XRT_INPUT_SIMPLE_SELECT_CLICK,
+    XRT_INPUT_SIMPLE_MENU_CLICK,
+    XRT_INPUT_SIMPLE_GRIP_POSE,
+    XRT_INPUT_SIMPLE_AIM_POSE,
+};
+
+struct xrt_device *
+simulated_create_load_device(enum simulated_load_kind kind,
+                             uint32_t index,
+                             float rate_hz,
+                             const struct xrt_pose *center,
+                             struct xrt_tracking_origin *origin)
+{
+	const enum u_device_alloc_flags flags = U_DEVICE_ALLOC_TRACKING_NONE;
+	enum xrt_input_name left_hand = XRT_INPUT_GENERIC_HAND_TRACKING_LEFT;
+	enum xrt_input_name right_hand = XRT_INPUT_GENERIC_HAND_TRACKING_RIGHT;
+	enum xrt_input_name *inputs = NULL;
+	uint32_t input_count = 0;
+	const char *kind_str = NULL;
+	bool is_right = (index % 2) != 0;
+
+	switch (kind) {
+	case SIMULATED_LOAD_TRACKER:
+		kind_str = "Tracker";
+		inputs = tracker_inputs_array;
+		input_count = ARRAY_SIZE(tracker_inputs_array);
+		break;
+	case SIMULATED_LOAD_CONTROLLER:
+		kind_str = "Controller";
+		inputs = controller_inputs_array;
+		input_count = ARRAY_SIZE(controller_inputs_array);
+		break;
+	case SIMULATED_LOAD_HAND:
+		kind_str = "Hand";
+		inputs = is_right ? &right_hand : &left_hand;
+		input_count = 1;
+		break;
+	default: assert(false); return NULL;
+	}
+
+	if (rate_hz <= 0.0f) {
+		rate_hz = 1000.0f;
+	}
+
+	struct simulated_load_device *sld = U_DEVICE_ALLOCATE(struct simulated_load_device, flags, input_count, 0);
+	sld->base.update_inputs = simulated_load_update_inputs;
+	sld->base.get_tracked_pose = simulated_load_get_tracked_pose;
+	sld->base.get_hand_tracking = simulated_load_get_hand_tracking;
+	sld->base.get_view_poses = simulated_load_get_view_poses;
+	sld->base.destroy = simulated_load_destroy;
+	sld->base.tracking_origin = origin;
+	sld->base.orientation_tracking_supported = true;
+	sld->base.position_tracking_supported = true;
+
+	switch (kind) {
+	case SIMULATED_LOAD_TRACKER:
+		sld->base.name = XRT_DEVICE_VIVE_TRACKER;
+		sld->base.device_type = XRT_DEVICE_TYPE_GENERIC_TRACKER;
+		break;
+	case SIMULATED_LOAD_CONTROLLER:
+		sld->base.name = XRT_DEVICE_SIMPLE_CONTROLLER;
+		sld->base.device_type = XRT_DEVICE_TYPE_ANY_HAND_CONTROLLER;
+		break;
+	case SIMULATED_LOAD_HAND:
+		sld->base.name = XRT_DEVICE_HAND_TRACKER;
+		sld->base.device_type = XRT_DEVICE_TYPE_HAND_TRACKER;
+		sld->base.hand_tracking_supported = true;
+		sld->hand = is_right ? XRT_HAND_RIGHT : XRT_HAND_LEFT;
+		break;
+	}
+
+	snprintf(sld->base.str, sizeof(sld->base.str), "Load %s %u (Simulated)", kind_str, index);
+	snprintf(sld->base.serial, sizeof(sld->base.serial), "Load %s %u (Simulated)", kind_str, index);
+
+	for (uint32_t i = 0; i < input_count; i++) {
+		sld->base.inputs[i].active = true;
+		sld->base.inputs[i].name = inputs[i];
+	}
+
+	sld->center = *center;
+	sld->rate_hz = rate_hz;
+	sld->position_noise_m = 0.0005f;
+	sld->orientation_noise_rad = 0.002f;
+	sld->speed = 1.0f + 0.1f * (float)(index % 10);
+	sld->rng = 0x9e3779b9u ^ (index * 0x85ebca6bu);
+	if (sld->rng == 0) {
+		sld->rng = 1;
+	}
+
+	// Hands keep the root pose under their hand tracking input.
+	enum xrt_input_name pose_names[ARRAY_SIZE(controller_inputs_array)];
+	uint32_t pose_count = 0;
+	for (uint32_t i = 0; i < input_count; i++) {
+		enum xrt_input_type input_type = XRT_GET_INPUT_TYPE(inputs[i]);
+		if (input_type == XRT_INPUT_TYPE_POSE || input_type == XRT_INPUT_TYPE_HAND_TRACKING) {
+			pose_names[pose_count++] = inputs[i];
+		}
+	}
+
+	const struct u_device_poses_config poses_config = {
+	    .model = U_DEVICE_POSES_MODEL_CONSTANT_VELOCITY,
+	    .max_prediction_ns = 100 * U_TIME_1MS_IN_NS,
+	};
+	u_device_poses_init(&sld->poses, &poses_config, pose_names, pose_count);
+
+	// Something valid to return before the thread has pushed anything.
+	uint64_t now_ns = os_monotonic_get_ns();
+	struct xrt_space_relation rel;
+	calc_relation(sld, now_ns, &rel);
+	for (uint32_t i = 0; i < pose_count; i++) {
+		u_device_poses_push(&sld->poses, pose_names[i], &rel, now_ns);
+	}
+
+	int ret = os_thread_helper_init(&sld->oth);
+	if (ret == 0) {
+		ret = os_thread_helper_start(&sld->oth, run_thread, sld);
+	}
+	if (ret != 0) {
+		U_LOG_E("Failed to start the thread of '%s'", sld->base.str);
+		simulated_load_destroy(&sld->base);
+		return NULL;
+	}
+
+	u_var_add_root(sld, sld->base.str, true);
+	u_var_add_pose(sld, &sld->center, "center");
+	u_var_add_f32(sld, &sld->position_noise_m, "position_noise_m");
+	u_var_add_f32(sld, &sld->orientation_noise_rad, "orientation_noise_rad");
+	u_device_poses_add_vars(&sld->poses, sld);
+
+	return &sld->base;
+}
@@ -208,7 +208,7 @@ Device::Device(const DeviceBuilder &builder) : xrt_device({}), ctx(builder.ctx),
 
 	this->xrt_device::destroy = [](xrt_device *xdev) {
 		auto *dev = static_cast<Device *>(xdev);
-		dev->driver->Deactivate();
+		dev->ctx->remove_device(dev);
 		delete dev;
 	};
 
@@ -244,6 +244,10 @@ Device::set_input_class(const InputClass *input_class)
 	this->input_count = inputs_vec.size();
 }
 
+const std::vector<std::string_view> FACE_BUTTONS = {
+    "/input/system/touch", "/input/a/touch", "/input/b/touch", "/input/thumbstick/touch", "/input/trackpad/touch",
+};
+
 void
 ControllerDevice::set_input_class(const InputClass *input_class)
 {
@@ -264,6 +268,12 @@ ControllerDevice::set_input_class(const InputClass *input_class)
 	inputs_map.insert({std::string_view("HAND"), &inputs_vec.back()});
 	this->inputs = inputs_vec.data();
 	this->input_count = inputs_vec.size();
+
+	for (std::string_view name : FACE_BUTTONS) {
+		if (auto input = inputs_map.find(name); input != inputs_map.end()) {
+			thumb_inputs.push_back(input->second);
+		}
+	}
 }
 
 xrt_hand
@@ -280,53 +290,95 @@ ControllerDevice::get_xrt_hand()
 	}
 }
 
-const std::vector<std::string> FACE_BUTTONS = {
-    "/input/system/touch", "/input/a/touch", "/input/b/touch", "/input/thumbstick/touch", "/input/trackpad/touch",
-};
-
-void
-ControllerDevice::update_hand_tracking(struct xrt_hand_joint_set *out)
+u_hand_tracking_curl_values
+ControllerDevice::get_curl_values(uint64_t *out_timestamp_ns)
 {
-	if (!has_index_hand_tracking)
-		return;
-	float index = 0.f;
-	float middle = 0.f;
-	float ring = 0.f;
-	float pinky = 0.f;
-	float thumb = 0.f;
-	for (auto fi : finger_inputs_vec) {
+	u_hand_tracking_curl_values curls{};
+	uint64_t timestamp_ns = 0;
+
+	for (const IndexFingerInput &fi : finger_inputs_vec) {
 		switch (fi.finger) {
-		case IndexFinger::Index: index = fi.value; break;
-		case IndexFinger::Middle: middle = fi.value; break;
-		case IndexFinger::Ring: ring = fi.value; break;
-		case IndexFinger::Pinky: pinky = fi.value; break;
+		case IndexFinger::Index: curls.index = fi.value; break;
+		case IndexFinger::Middle: curls.middle = fi.value; break;
+		case IndexFinger::Ring: curls.ring = fi.value; break;
+		case IndexFinger::Pinky: curls.little = fi.value; break;
 		default: break;
 		}
+		timestamp_ns = std::max(timestamp_ns, static_cast<uint64_t>(fi.timestamp));
 	}
-	for (const auto &name : FACE_BUTTONS) {
-		auto *input = get_input_from_name(name);
-		if (input && input->value.boolean) {
-			thumb = 1.f;
+	for (const xrt_input *input : thumb_inputs) {
+		if (input->value.boolean) {
+			curls.thumb = 1.f;
 			break;
 		}
 	}
-	auto curl_values = u_hand_tracking_curl_values{pinky, ring, middle, index, thumb};
 
-	struct xrt_space_relation hand_relation = {};
-	uint64_t last_ns{0}; // Not used.
-	// Currently we only return the latest pose.
-	m_relation_history_get_latest(relation_hist, &last_ns, &hand_relation);
+	*out_timestamp_ns = timestamp_ns;
+	return curls;
+}
 
-	u_hand_sim_simulate_for_valve_index_knuckles(&curl_values, get_xrt_hand(), &hand_relation, out);
+void
+ControllerDevice::simulate_hand(const u_hand_tracking_curl_values &curls, xrt_hand_joint_set *out)
+{
+	// The joints are relative to the hand pose, simulate at the origin and place the hand when asked.
+	xrt_space_relation origin = XRT_SPACE_RELATION_ZERO;
+	origin.pose = XRT_POSE_IDENTITY;
+	u_hand_sim_simulate_for_valve_index_knuckles(&curls, get_xrt_hand(), &origin, out);
+}
 
-	struct xrt_relation_chain chain = {};
+void
+ControllerDevice::after_frame()
+{
+	if (!has_index_hand_tracking)
+		return;
 
-	struct xrt_pose pose_offset = XRT_POSE_IDENTITY;
-	vive_poses_get_pose_offset(name, device_type, inputs_map["HAND"]->name, &pose_offset);
+	uint64_t timestamp_ns = 0;
+	u_hand_tracking_curl_values curls = get_curl_values(&timestamp_ns);
 
-	m_relation_chain_push_pose(&chain, &pose_offset);
-	m_relation_chain_push_relation(&chain, &hand_relation);
-	m_relation_chain_resolve(&chain, &out->hand_pose);
+	int latest = hand_slot_latest.load(std::memory_order_relaxed);
+	if (latest >= 0 && std::memcmp(&curls, &last_curls, sizeof(curls)) == 0) {
+		return;
+	}
+	last_curls = curls;
+
+	int next = latest == 0 ? 1 : 0;
+	HandSlot &slot = hand_slots[next];
+
+	uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+	slot.seq.store(seq + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	simulate_hand(curls, &slot.joints);
+	slot.timestamp_ns = timestamp_ns;
+
+	slot.seq.store(seq + 2, std::memory_order_release);
+	hand_slot_latest.store(next, std::memory_order_release);
+}
+
+bool
+ControllerDevice::read_hand_slot(xrt_hand_joint_set *out)
+{
+	for (int attempt = 0; attempt < 4; attempt++) {
+		int latest = hand_slot_latest.load(std::memory_order_acquire);
+		if (latest < 0) {
+			return false;
+		}
+
+		const HandSlot &slot = hand_slots[latest];
+		uint32_t seq = slot.seq.load(std::memory_order_acquire);
+		if ((seq & 1) != 0) {
+			continue;
+		}
+
+		*out = slot.joints;
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.seq.load(std::memory_order_relaxed) == seq) {
+			return true;
+		}
+	}
+
+	return false;
 }
 
 xrt_input *
@@ -370,7 +422,13 @@ ControllerDevice::set_haptic_handle(vr::VRInputComponentHandle_t handle)
 void
 Device::update_inputs()
 {
-	ctx->maybe_run_frame(++current_frame);
+	// The driver updates the inputs from the context's frame thread and its own threads.
+}
+
+void
+Device::deactivate()
+{
+	driver->Deactivate();
 }
 
 IndexFingerInput *
@@ -392,10 +450,26 @@ ControllerDevice::get_hand_tracking(enum xrt_input_name name,
 {
 	if (!has_index_hand_tracking)
 		return;
-	update_hand_tracking(out_value);
+
+	// Simulated on the frame thread whenever the curls change, only before the first frame do it here.
+	if (!read_hand_slot(out_value)) {
+		uint64_t timestamp_ns = 0;
+		simulate_hand(get_curl_values(&timestamp_ns), out_value);
+	}
+
+	xrt_space_relation hand_relation = {};
+	Device::get_pose(desired_timestamp_ns, &hand_relation);
+
+	xrt_pose pose_offset = XRT_POSE_IDENTITY;
+	vive_poses_get_pose_offset(xrt_device::name, device_type, inputs_map["HAND"]->name, &pose_offset);
+
+	xrt_relation_chain chain = {};
+	m_relation_chain_push_pose(&chain, &pose_offset);
+	m_relation_chain_push_relation(&chain, &hand_relation);
+	m_relation_chain_resolve(&chain, &out_value->hand_pose);
+
 	out_value->is_active = true;
-	hand_tracking_timestamp = desired_timestamp_ns;
-	*out_timestamp_ns = hand_tracking_timestamp;
+	*out_timestamp_ns = desired_timestamp_ns;
 }
 
 void
@@ -423,7 +497,7 @@ ControllerDevice::get_tracked_pose(xrt_input_name name, uint64_t at_timestamp_ns
 	Device::get_pose(at_timestamp_ns, &rel);
 
 	xrt_pose pose_offset = XRT_POSE_IDENTITY;
-	vive_poses_get_pose_offset(input_class->name, device_type, name, &pose_offset);
+	vive_poses_get_pose_offset(xrt_device::name, device_type, name, &pose_offset);
 
 	xrt_relation_chain relchain = {};
 
@@ -646,11 +720,11 @@ Device::update_pose(const vr::DriverPose_t &newPose)
 		relation.relation_flags = XRT_SPACE_RELATION_BITMASK_NONE;
 	}
 
-	uint64_t ts = chrono_timestamp_ns();
-	uint64_t ts_offset = static_cast<uint64_t>(newPose.poseTimeOffset * 1000000.0);
-	ts += ts_offset;
+	// The offset is in seconds and usually negative, the pose is from the past.
+	int64_t ts = static_cast<int64_t>(chrono_timestamp_ns());
+	ts += static_cast<int64_t>(newPose.poseTimeOffset * static_cast<double>(U_TIME_1S_IN_NS));
 
-	m_relation_history_push(relation_hist, &relation, ts);
+	m_relation_history_push(relation_hist, &relation, static_cast<uint64_t>(ts));
 }
 
 void
@@ -12,11 +12,13 @@
 #include <memory>
 #include <unordered_map>
 
+#include <atomic>
 #include <condition_variable>
 #include <mutex>
 
 #include "interfaces/context.hpp"
 #include "math/m_relation_history.h"
+#include "util/u_hand_tracking.h"
 #include "xrt/xrt_device.h"
 #include "openvr_driver.h"
 
@@ -60,6 +62,15 @@ public:
 	void
 	handle_properties(const vr::PropertyWrite_t *batch, uint32_t count);
 
+	//! Deactivates the driver side of this device.
+	void
+	deactivate();
+
+	//! Called on the context's frame thread after every frame, with the inputs of that frame.
+	virtual void
+	after_frame()
+	{}
+
 	//! Maps to @ref xrt_device::get_track_pose.
 	virtual void
 	get_tracked_pose(xrt_input_name name, uint64_t at_timestamp_ns, xrt_space_relation *out_relation) = 0;
@@ -85,7 +96,6 @@ protected:
 private:
 	vr::ITrackedDeviceServerDriver *driver;
 	std::vector<xrt_binding_profile> binding_profiles_vec;
-	uint64_t current_frame{0};
 
 	void
 	init_chaperone(const std::string &steam_install);
@@ -175,16 +185,51 @@ public:
 	xrt_hand
 	get_xrt_hand();
 
+	//! Simulates the hand from the new finger curls, if they changed.
 	void
-	update_hand_tracking(struct xrt_hand_joint_set *out);
+	after_frame() override;
 
 private:
+	/*!
+	 * A simulated hand, joints are relative to the hand pose so they don't
+	 * depend on where the controller is.
+	 */
+	struct HandSlot
+	{
+		//! Odd while being written.
+		std::atomic<uint32_t> seq{0};
+		xrt_hand_joint_set joints;
+		uint64_t timestamp_ns;
+	};
+
 	vr::VRInputComponentHandle_t haptic_handle{0};
 	std::unique_ptr<xrt_output> output{nullptr};
 	bool has_index_hand_tracking{false};
 	std::vector<IndexFingerInput> finger_inputs_vec;
 	std::unordered_map<std::string_view, IndexFingerInput *> finger_inputs_map;
-	uint64_t hand_tracking_timestamp;
+
+	//! Inputs touched by the thumb, they curl it.
+	std::vector<xrt_input *> thumb_inputs;
+
+	/*!
+	 * Double buffered, written only by the frame thread which alternates
+	 * between them so readers rarely see the one they copy being written.
+	 */
+	HandSlot hand_slots[2];
+
+	//! Index of the newest slot, -1 before the first one.
+	std::atomic<int> hand_slot_latest{-1};
+
+	u_hand_tracking_curl_values last_curls{};
+
+	u_hand_tracking_curl_values
+	get_curl_values(uint64_t *out_timestamp_ns);
+
+	void
+	simulate_hand(const u_hand_tracking_curl_values &curls, xrt_hand_joint_set *out);
+
+	bool
+	read_hand_slot(xrt_hand_joint_set *out);
 
 	void
 	set_hand_tracking_hand(xrt_input_name name);
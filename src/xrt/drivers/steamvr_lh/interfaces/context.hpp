@@ -15,6 +15,8 @@
 #include <chrono>
 #include <deque>
 #include <mutex>
+#include <atomic>
+#include <thread>
 
 #include "openvr_driver.h"
 
@@ -63,18 +65,60 @@ class Context final : public xrt_tracking_origin,
 	BlockQueue blockqueue;
 	Paths paths;
 
-	uint64_t current_frame{0};
+	/*!
+	 * Runs @ref vr::IServerTrackedDeviceProvider::RunFrame at a fixed rate,
+	 * independent of how often apps poll the devices.
+	 */
+	std::thread frame_thread;
+	std::atomic_bool frame_thread_running{false};
+	uint32_t frame_rate_hz{0};
 
-	std::vector<vr::VRInputComponentHandle_t> handles;
-	std::unordered_map<vr::VRInputComponentHandle_t, xrt_input *> handle_to_input;
-	std::unordered_map<vr::VRInputComponentHandle_t, IndexFingerInput *> handle_to_finger;
-	struct Vec2Components
+	//! Held while running a frame, so devices aren't removed in the middle of one.
+	std::mutex frame_mut;
+
+	/*!
+	 * Protects @ref devices, the driver pushes poses from threads of its own.
+	 * Never held while calling into the driver.
+	 */
+	std::mutex devices_mut;
+
+	//! Indexed by tracked device index, the HMD is always index 0.
+	Device *devices[vr::k_unMaxTrackedDeviceCount]{};
+
+	void
+	run_frame_thread();
+
+	//! What an input component handle updates, filled in when the component is created.
+	struct Component
 	{
-		vr::VRInputComponentHandle_t x;
-		vr::VRInputComponentHandle_t y;
+		enum class Axis : uint8_t
+		{
+			None,
+			X,
+			Y,
+		};
+
+		xrt_input *input{nullptr};
+		IndexFingerInput *finger{nullptr};
+
+		//! For the x/y halves of a vec2 input.
+		Axis axis{Axis::None};
 	};
-	std::unordered_map<vr::VRInputComponentHandle_t, Vec2Components *> vec2_inputs;
-	std::unordered_map<xrt_input *, std::unique_ptr<Vec2Components>> vec2_input_to_components;
+
+	//! Upper bound on the number of input components of all devices.
+	static constexpr size_t max_components{4096};
+
+	/*!
+	 * Indexed by handle minus one, handles are handed out in order. Never
+	 * reallocated, so updates from the driver's threads can read it while
+	 * new components are created; an entry is written before
+	 * @ref component_count is increased to publish it.
+	 */
+	std::unique_ptr<Component[]> components{new Component[max_components]};
+	std::atomic<size_t> component_count{0};
+
+	//! Only serialises creating components, updates never take it.
+	std::mutex component_create_mut;
 
 	struct Event
 	{
@@ -92,8 +136,22 @@ class Context final : public xrt_tracking_origin,
 	                        const char *name,
 	                        vr::VRInputComponentHandle_t *handle);
 
+	inline const Component *
+	get_component(vr::VRInputComponentHandle_t handle) const
+	{
+		if (handle == vr::k_ulInvalidInputComponentHandle ||
+		    handle > component_count.load(std::memory_order_acquire)) {
+			return nullptr;
+		}
+		return &components[handle - 1];
+	}
+
+	//! Adds a component and returns its handle, or the invalid handle if there is no room.
+	vr::VRInputComponentHandle_t
+	add_component(const Component &component);
+
 	xrt_input *
-	update_component_common(vr::VRInputComponentHandle_t handle,
+	update_component_common(const Component *component,
 	                        double offset,
 	                        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
 
@@ -101,24 +159,15 @@ class Context final : public xrt_tracking_origin,
 	setup_hmd(const char *serial, vr::ITrackedDeviceServerDriver *driver);
 
 	bool
-	setup_controller(const char *serial, vr::ITrackedDeviceServerDriver *driver);
+	setup_controller(const char *serial, vr::ITrackedDeviceServerDriver *driver, bool is_tracker);
 	vr::IServerTrackedDeviceProvider *provider;
 
-	inline vr::VRInputComponentHandle_t
-	new_handle()
-	{
-		vr::VRInputComponentHandle_t h = handles.size() + 1;
-		handles.push_back(h);
-		return h;
-	}
-
 protected:
 	Context(const std::string &steam_install, const std::string &steamvr_install, u_logging_level level);
 
 public:
 	// These are owned by monado, context is destroyed when these are destroyed
 	class HmdDevice *hmd{nullptr};
-	class ControllerDevice *controller[2]{nullptr, nullptr};
 	const u_logging_level log_level;
 
 	~Context();
@@ -128,8 +177,17 @@ public:
 	       const std::string &steamvr_install,
 	       vr::IServerTrackedDeviceProvider *p);
 
+	//! Starts running frames on a thread of our own, call once all devices have been found.
+	void
+	start_frame_thread();
+
+	//! Copies out up to @p max devices, in tracked device index order.
+	int
+	get_devices(xrt_device **out_xdevs, int max);
+
+	//! Stops sending poses and inputs to @p dev and deactivates it, called as it is destroyed.
 	void
-	maybe_run_frame(uint64_t new_frame);
+	remove_device(Device *dev);
 
 	void
 	add_haptic_event(vr::VREvent_HapticVibration_t event);
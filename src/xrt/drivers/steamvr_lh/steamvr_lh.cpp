@@ -7,6 +7,7 @@
  * @ingroup drv_steamvr_lh
  */
 
+#include <algorithm>
 #include <cstring>
 #include <dlfcn.h>
 #include <memory>
@@ -21,11 +22,15 @@
 #include "steamvr_lh_interface.h"
 #include "interfaces/context.hpp"
 #include "device.hpp"
+#include "os/os_time.h"
 #include "util/u_device.h"
+#include "util/u_linux.h"
+#include "xrt/xrt_system.h"
 
 namespace {
 
 DEBUG_GET_ONCE_LOG_OPTION(lh_log, "LIGHTHOUSE_LOG", U_LOGGING_INFO)
+DEBUG_GET_ONCE_NUM_OPTION(lh_frame_rate, "LH_FRAME_RATE", 250)
 
 // ~/.steam/root is a symlink to where the Steam root is
 const std::string STEAM_INSTALL_DIR = std::string(getenv("HOME")) + "/.steam/root";
@@ -84,9 +89,105 @@ Context::Context(const std::string &steam_install, const std::string &steamvr_in
 
 Context::~Context()
 {
+	if (frame_thread.joinable()) {
+		frame_thread_running = false;
+		frame_thread.join();
+	}
+
 	provider->Cleanup();
 }
 
+void
+Context::start_frame_thread()
+{
+	int64_t rate = debug_get_num_option_lh_frame_rate();
+	frame_rate_hz = rate > 0 ? static_cast<uint32_t>(rate) : 250;
+
+	frame_thread_running = true;
+	frame_thread = std::thread(&Context::run_frame_thread, this);
+}
+
+void
+Context::run_frame_thread()
+{
+	u_linux_try_to_set_realtime_priority_on_thread(log_level, "SteamVR Lighthouse: RunFrame");
+
+	const uint64_t interval_ns = U_TIME_1S_IN_NS / frame_rate_hz;
+	uint64_t next_ns = os_monotonic_get_ns();
+
+	struct os_precise_sleeper sleeper = {};
+	os_precise_sleeper_init(&sleeper);
+
+	while (frame_thread_running) {
+		{
+			std::lock_guard lk(frame_mut);
+			provider->RunFrame();
+
+			// Devices are only removed while holding frame_mut, so the copy stays valid.
+			Device *frame_devices[vr::k_unMaxTrackedDeviceCount];
+			{
+				std::lock_guard devices_lk(devices_mut);
+				std::copy(std::begin(devices), std::end(devices), std::begin(frame_devices));
+			}
+			for (Device *dev : frame_devices) {
+				if (dev != nullptr) {
+					dev->after_frame();
+				}
+			}
+		}
+
+		next_ns += interval_ns;
+		uint64_t now_ns = os_monotonic_get_ns();
+		if (next_ns <= now_ns) {
+			// Fell behind, don't try to catch up with a burst of frames.
+			next_ns = now_ns;
+			continue;
+		}
+		os_precise_sleeper_nanosleep(&sleeper, static_cast<int32_t>(next_ns - now_ns));
+	}
+
+	os_precise_sleeper_deinit(&sleeper);
+}
+
+int
+Context::get_devices(xrt_device **out_xdevs, int max)
+{
+	std::lock_guard lk(devices_mut);
+
+	int count = 0;
+	for (Device *dev : devices) {
+		if (dev == nullptr) {
+			continue;
+		}
+		if (count >= max) {
+			CTX_WARN("Too many devices, only using the first %d", max);
+			break;
+		}
+		out_xdevs[count++] = dev;
+	}
+	return count;
+}
+
+void
+Context::remove_device(Device *dev)
+{
+	std::lock_guard frame_lk(frame_mut);
+
+	{
+		std::lock_guard lk(devices_mut);
+		for (Device *&d : devices) {
+			if (d == dev) {
+				d = nullptr;
+			}
+		}
+		if (hmd == dev) {
+			hmd = nullptr;
+		}
+	}
+
+	dev->deactivate();
+}
+
 /***** IVRDriverContext methods *****/
 
 void *
@@ -127,10 +228,23 @@ Context::GetDriverHandle()
 bool
 Context::setup_hmd(const char *serial, vr::ITrackedDeviceServerDriver *driver)
 {
+	if (this->hmd) {
+		CTX_WARN("Attempted to activate a second HMD - this is unsupported");
+		return false;
+	}
+
 	this->hmd = new HmdDevice(DeviceBuilder{this->shared_from_this(), driver, serial, STEAM_INSTALL_DIR});
+	{
+		std::lock_guard lk(devices_mut);
+		devices[0] = this->hmd;
+	}
 #define VERIFY(expr, msg)                                                                                              \
 	if (!(expr)) {                                                                                                 \
 		CTX_ERR("Activating HMD failed: %s", msg);                                                             \
+		{                                                                                                      \
+			std::lock_guard lk(devices_mut);                                                               \
+			devices[0] = nullptr;                                                                          \
+		}                                                                                                      \
 		delete this->hmd;                                                                                      \
 		this->hmd = nullptr;                                                                                   \
 		return false;                                                                                          \
@@ -183,34 +297,47 @@ Context::setup_hmd(const char *serial, vr::ITrackedDeviceServerDriver *driver)
 }
 
 bool
-Context::setup_controller(const char *serial, vr::ITrackedDeviceServerDriver *driver)
+Context::setup_controller(const char *serial, vr::ITrackedDeviceServerDriver *driver, bool is_tracker)
 {
-	if (controller[0] && controller[1]) {
-		CTX_WARN("Attempted to activate more than two controllers - this is unsupported");
-		return false;
+	// Index 0 is reserved for the HMD, container handles are the device index plus one.
+	uint32_t device_idx = 0;
+	ControllerDevice *dev = nullptr;
+	{
+		std::lock_guard lk(devices_mut);
+		for (uint32_t i = 1; i < vr::k_unMaxTrackedDeviceCount; i++) {
+			if (devices[i] == nullptr) {
+				device_idx = i;
+				break;
+			}
+		}
+		if (device_idx == 0) {
+			CTX_WARN("Attempted to activate more than %u devices - this is unsupported",
+			         vr::k_unMaxTrackedDeviceCount);
+			return false;
+		}
+
+		dev = new ControllerDevice(device_idx + 1,
+		                           DeviceBuilder{this->shared_from_this(), driver, serial, STEAM_INSTALL_DIR});
+		if (is_tracker) {
+			dev->device_type = XRT_DEVICE_TYPE_GENERIC_TRACKER;
+		}
+		devices[device_idx] = dev;
 	}
-	size_t device_idx = (controller[0]) ? 2 : 1;
-	auto &dev = controller[device_idx - 1];
-	dev = new ControllerDevice(device_idx + 1,
-	                           DeviceBuilder{this->shared_from_this(), driver, serial, STEAM_INSTALL_DIR});
 
+	// Not holding the lock, the driver writes properties while activating.
 	vr::EVRInitError err = driver->Activate(device_idx);
 	if (err != vr::VRInitError_None) {
-		CTX_ERR("Activating controller failed: error %u", err);
+		CTX_ERR("Activating %s failed: error %u", is_tracker ? "tracker" : "controller", err);
+		{
+			std::lock_guard lk(devices_mut);
+			devices[device_idx] = nullptr;
+		}
+		delete dev;
 		return false;
 	}
 
 	return true;
 }
-
-void
-Context::maybe_run_frame(uint64_t new_frame)
-{
-	if (new_frame > current_frame) {
-		++current_frame;
-		provider->RunFrame();
-	}
-}
 // NOLINTBEGIN(bugprone-easily-swappable-parameters)
 bool
 Context::TrackedDeviceAdded(const char *pchDeviceSerialNumber,
@@ -224,7 +351,11 @@ Context::TrackedDeviceAdded(const char *pchDeviceSerialNumber,
 		break;
 	}
 	case vr::TrackedDeviceClass_Controller: {
-		return setup_controller(pchDeviceSerialNumber, pDriver);
+		return setup_controller(pchDeviceSerialNumber, pDriver, false);
+		break;
+	}
+	case vr::TrackedDeviceClass_GenericTracker: {
+		return setup_controller(pchDeviceSerialNumber, pDriver, true);
 		break;
 	}
 	case vr::TrackedDeviceClass_TrackingReference: {
@@ -242,12 +373,15 @@ void
 Context::TrackedDevicePoseUpdated(uint32_t unWhichDevice, const vr::DriverPose_t &newPose, uint32_t unPoseStructSize)
 {
 	assert(sizeof(newPose) == unPoseStructSize);
-	if (unWhichDevice > 2)
+	if (unWhichDevice >= vr::k_unMaxTrackedDeviceCount)
 		return;
-	Device *dev = (unWhichDevice == 0) ? static_cast<Device *>(this->hmd)
-	                                   : static_cast<Device *>(this->controller[unWhichDevice - 1]);
-	assert(dev);
-	dev->update_pose(newPose);
+
+	// Called from the driver's own threads too, hold the lock so the device isn't removed meanwhile.
+	std::lock_guard lk(devices_mut);
+	Device *dev = devices[unWhichDevice];
+	if (dev) {
+		dev->update_pose(newPose);
+	}
 }
 
 void
@@ -338,6 +472,22 @@ Context::SetRecommendedRenderTargetSize(uint32_t unWhichDevice, uint32_t nWidth,
 
 /***** IVRDriverInput methods *****/
 
+vr::VRInputComponentHandle_t
+Context::add_component(const Component &component)
+{
+	std::lock_guard lk(component_create_mut);
+
+	size_t count = component_count.load(std::memory_order_relaxed);
+	if (count >= max_components) {
+		CTX_ERR("Out of input components, max is %zu", max_components);
+		return vr::k_ulInvalidInputComponentHandle;
+	}
+
+	components[count] = component;
+	component_count.store(count + 1, std::memory_order_release);
+
+	return count + 1;
+}
 
 vr::EVRInputError
 Context::create_component_common(vr::PropertyContainerHandle_t container,
@@ -351,29 +501,29 @@ Context::create_component_common(vr::PropertyContainerHandle_t container,
 	}
 	if (xrt_input *input = device->get_input_from_name(name); input) {
 		CTX_DEBUG("creating component %s", name);
-		vr::VRInputComponentHandle_t handle = new_handle();
-		handle_to_input[handle] = input;
-		*pHandle = handle;
+		Component component{};
+		component.input = input;
+		*pHandle = add_component(component);
 	} else if (device != hmd) {
 		auto *controller = static_cast<ControllerDevice *>(device);
 		if (IndexFingerInput *finger = controller->get_finger_from_name(name); finger) {
 			CTX_DEBUG("creating finger component %s", name);
-			vr::VRInputComponentHandle_t handle = new_handle();
-			handle_to_finger[handle] = finger;
-			*pHandle = handle;
+			Component component{};
+			component.finger = finger;
+			*pHandle = add_component(component);
 		}
 	}
 	return vr::VRInputError_None;
 }
 
 xrt_input *
-Context::update_component_common(vr::VRInputComponentHandle_t handle,
+Context::update_component_common(const Component *component,
                                  double offset,
                                  std::chrono::steady_clock::time_point now)
 {
 	xrt_input *input{nullptr};
-	if (handle != vr::k_ulInvalidInputComponentHandle) {
-		input = handle_to_input[handle];
+	if (component != nullptr && component->input != nullptr) {
+		input = component->input;
 		std::chrono::duration<double, std::chrono::seconds::period> offset_dur(offset);
 		std::chrono::duration offset = (now + offset_dur).time_since_epoch();
 		int64_t timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(offset).count();
@@ -394,7 +544,7 @@ Context::CreateBooleanComponent(vr::PropertyContainerHandle_t ulContainer,
 vr::EVRInputError
 Context::UpdateBooleanComponent(vr::VRInputComponentHandle_t ulComponent, bool bNewValue, double fTimeOffset)
 {
-	xrt_input *input = update_component_common(ulComponent, fTimeOffset);
+	xrt_input *input = update_component_common(get_component(ulComponent), fTimeOffset);
 	if (input) {
 		input->value.boolean = bNewValue;
 	}
@@ -426,18 +576,10 @@ Context::CreateScalarComponent(vr::PropertyContainerHandle_t ulContainer,
 			return vr::VRInputError_None;
 		}
 
-		// Create the component mapping if it hasn't been created yet
-		Vec2Components *components =
-		    vec2_input_to_components.try_emplace(input, new Vec2Components).first->second.get();
-
-		vr::VRInputComponentHandle_t new_handle = this->new_handle();
-		if (x)
-			components->x = new_handle;
-		else
-			components->y = new_handle;
-
-		handle_to_input[new_handle] = input;
-		*pHandle = new_handle;
+		Component component{};
+		component.input = input;
+		component.axis = x ? Component::Axis::X : Component::Axis::Y;
+		*pHandle = add_component(component);
 		return vr::VRInputError_None;
 	}
 	return create_component_common(ulContainer, pchName, pHandle);
@@ -446,40 +588,27 @@ Context::CreateScalarComponent(vr::PropertyContainerHandle_t ulContainer,
 vr::EVRInputError
 Context::UpdateScalarComponent(vr::VRInputComponentHandle_t ulComponent, float fNewValue, double fTimeOffset)
 {
-	if (auto h = handle_to_input.find(ulComponent); h != handle_to_input.end() && h->second) {
-		xrt_input *input = update_component_common(ulComponent, fTimeOffset);
-		if (XRT_GET_INPUT_TYPE(input->name) == XRT_INPUT_TYPE_VEC2_MINUS_ONE_TO_ONE) {
-			std::unique_ptr<Vec2Components> &components = vec2_input_to_components.at(input);
-			if (components->x == ulComponent) {
-				input->value.vec2.x = fNewValue;
-			} else if (components->y == ulComponent) {
-				input->value.vec2.y = fNewValue;
-			} else {
-				CTX_WARN(
-				    "Attempted to update component with handle %lu"
-				    " but it was neither the x nor y "
-				    "component of its associated input",
-				    ulComponent);
-			}
-
-		} else {
-			input->value.vec1.x = fNewValue;
-		}
-	} else {
+	const Component *component = get_component(ulComponent);
+	if (component == nullptr) {
 		if (ulComponent != vr::k_ulInvalidInputComponentHandle) {
-			if (auto finger_input = handle_to_finger.find(ulComponent);
-			    finger_input != handle_to_finger.end() && finger_input->second) {
-				auto now = std::chrono::steady_clock::now();
-				std::chrono::duration<double, std::chrono::seconds::period> offset_dur(fTimeOffset);
-				std::chrono::duration offset = (now + offset_dur).time_since_epoch();
-				int64_t timestamp =
-				    std::chrono::duration_cast<std::chrono::nanoseconds>(offset).count();
-				finger_input->second->timestamp = timestamp;
-				finger_input->second->value = fNewValue;
-			} else {
-				CTX_WARN("Unmapped component %lu", ulComponent);
-			}
+			CTX_WARN("Unmapped component %lu", ulComponent);
+		}
+		return vr::VRInputError_None;
+	}
+
+	if (xrt_input *input = update_component_common(component, fTimeOffset); input) {
+		switch (component->axis) {
+		case Component::Axis::X: input->value.vec2.x = fNewValue; break;
+		case Component::Axis::Y: input->value.vec2.y = fNewValue; break;
+		case Component::Axis::None: input->value.vec1.x = fNewValue; break;
 		}
+	} else if (component->finger != nullptr) {
+		auto now = std::chrono::steady_clock::now();
+		std::chrono::duration<double, std::chrono::seconds::period> offset_dur(fTimeOffset);
+		std::chrono::duration offset = (now + offset_dur).time_since_epoch();
+		int64_t timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(offset).count();
+		component->finger->timestamp = timestamp;
+		component->finger->value = fNewValue;
 	}
 	return vr::VRInputError_None;
 }
@@ -503,8 +632,10 @@ Context::CreateHapticComponent(vr::PropertyContainerHandle_t ulContainer,
 	}
 
 	auto *device = static_cast<ControllerDevice *>(d);
-	vr::VRInputComponentHandle_t handle = new_handle();
-	handle_to_input[handle] = nullptr;
+	vr::VRInputComponentHandle_t handle = add_component(Component{});
+	if (handle == vr::k_ulInvalidInputComponentHandle) {
+		return vr::VRInputError_MaxCapacityReached;
+	}
 	device->set_haptic_handle(handle);
 	*pHandle = handle;
 
@@ -566,30 +697,24 @@ Context::GetPropErrorNameFromEnum(vr::ETrackedPropertyError error)
 Device *
 Context::prop_container_to_device(vr::PropertyContainerHandle_t handle)
 {
-	switch (handle) {
-	case 1: {
-		return hmd;
-		break;
-	}
-	case 2:
-	case 3: {
-		return controller[handle - 2];
-		break;
-	}
-	default: {
+	if (handle == 0 || handle > vr::k_unMaxTrackedDeviceCount) {
 		return nullptr;
 	}
-	}
+
+	std::lock_guard lk(devices_mut);
+	return devices[handle - 1];
 }
 
 vr::PropertyContainerHandle_t
 Context::TrackedDeviceToPropertyContainer(vr::TrackedDeviceIndex_t nDevice)
 {
-	size_t container = nDevice + 1;
-	if (nDevice == 0 && this->hmd)
-		return container;
-	if ((nDevice == 1 || nDevice == 2) && this->controller[nDevice - 1]) {
-		return container;
+	if (nDevice >= vr::k_unMaxTrackedDeviceCount) {
+		return vr::k_ulInvalidPropertyContainer;
+	}
+
+	std::lock_guard lk(devices_mut);
+	if (devices[nDevice]) {
+		return nDevice + 1;
 	}
 
 	return vr::k_ulInvalidPropertyContainer;
@@ -664,12 +789,10 @@ steamvr_lh_get_devices(struct xrt_device **out_xdevs)
 	}
 	U_LOG_IFL_I(level, "Device search time complete.");
 
-	int devices = 0;
-	Device *devs[] = {ctx->hmd, ctx->controller[0], ctx->controller[1]};
-	for (Device *dev : devs) {
-		if (dev) {
-			out_xdevs[devices++] = dev;
-		}
-	}
+	int devices = ctx->get_devices(out_xdevs, XRT_SYSTEM_MAX_DEVICES);
+
+	// From now on frames run on their own, poses no longer wait for apps to poll inputs.
+	ctx->start_frame_thread();
+
 	return devices;
 }
@@ -65,6 +65,9 @@
 //! excl HMD we support 16 devices (controllers, trackers, ...)
 #define MAX_TRACKED_DEVICE_COUNT 16
 
+//! Most events handled at once by the event thread, after waiting for the first one
+#define MAX_EVENT_BATCH 64
+
 DEBUG_GET_ONCE_BOOL_OPTION(survive_disable_hand_emulation, "SURVIVE_DISABLE_HAND_EMULATION", false)
 DEBUG_GET_ONCE_BOOL_OPTION(survive_default_ipd, "SURVIVE_DEFAULT_IPD", false)
 DEBUG_GET_ONCE_FLOAT_OPTION(survive_timecode_offset_ms, "SURVIVE_TIMECODE_OFFSET_MS", 0.0)
@@ -173,6 +176,9 @@ struct survive_system
 	float wait_timeout;
 	struct u_var_draggable_f32 timecode_offset_ms;
 
+	//! Monotonic minus libsurvive clock, sampled once per batch of events.
+	int64_t timecode_to_monotonic_ns;
+
 	struct os_thread_helper event_thread;
 	struct os_mutex lock;
 };
@@ -240,16 +246,23 @@ survive_timecode_now_s(void)
 	return ((double)tv.tv_usec) / 1000000. + (tv.tv_sec);
 }
 
+static void
+survive_sample_timecode_clock(struct survive_system *ss)
+{
+	timepoint_ns survive_now_ns = time_s_to_ns(survive_timecode_now_s());
+	timepoint_ns now = os_monotonic_get_ns();
+
+	ss->timecode_to_monotonic_ns = now - survive_now_ns;
+}
+
+//! Uses the clock offset from the last @ref survive_sample_timecode_clock call.
 static timepoint_ns
 survive_timecode_to_monotonic(struct survive_device *survive, double timecode)
 {
 	timepoint_ns timecode_ns = time_s_to_ns(timecode);
-	timepoint_ns survive_now_ns = time_s_to_ns(survive_timecode_now_s());
 
-	timepoint_ns timecode_age_ns = survive_now_ns - timecode_ns;
-
-	timepoint_ns now = os_monotonic_get_ns();
-	timepoint_ns timestamp = now - timecode_age_ns + (uint64_t)(survive->sys->timecode_offset_ms.val * 1000000.0);
+	timepoint_ns timestamp = timecode_ns + survive->sys->timecode_to_monotonic_ns +
+	                         (int64_t)(survive->sys->timecode_offset_ms.val * 1000000.0);
 
 	return timestamp;
 }
@@ -961,6 +974,12 @@ _create_hmd_device(struct survive_system *sys, const struct SurviveSimpleObject
 	survive->base.hmd->distortion.preferred = XRT_DISTORTION_MODEL_COMPUTE;
 	survive->base.compute_distortion = compute_distortion;
 
+	// The Pro 2 flips the result, which the analytic model doesn't.
+	if (survive->hmd.config.variant != VIVE_VARIANT_PRO2) {
+		u_distortion_set_analytic_vive(&survive->base, 0, &survive->hmd.config.distortion.values[0]);
+		u_distortion_set_analytic_vive(&survive->base, 1, &survive->hmd.config.distortion.values[1]);
+	}
+
 	survive->base.orientation_tracking_supported = true;
 	survive->base.position_tracking_supported = true;
 	survive->base.device_type = XRT_DEVICE_TYPE_HMD;
@@ -1286,12 +1305,30 @@ run_event_thread(void *ptr)
 		os_thread_helper_unlock(&ss->event_thread);
 
 		// one event queue for all devices. _process_events() updates all devices
-		struct SurviveSimpleEvent event = {0};
-		survive_simple_wait_for_event(ss->ctx, &event);
+		struct SurviveSimpleEvent events[MAX_EVENT_BATCH] = {0};
+		survive_simple_wait_for_event(ss->ctx, &events[0]);
+
+		// Drain whatever else is queued, so a busy queue costs one wakeup and lock per batch.
+		int event_count = 1;
+		while (event_count < MAX_EVENT_BATCH &&
+		       survive_simple_next_event(ss->ctx, &events[event_count]) != SurviveSimpleEventType_None) {
+			event_count++;
+		}
+
+		survive_sample_timecode_clock(ss);
 
-		os_mutex_lock(&ss->lock);
-		_process_event(ss, &event);
-		os_mutex_unlock(&ss->lock);
+		// Poses go into the thread safe relation histories, only inputs need the lock.
+		bool locked = false;
+		for (int i = 0; i < event_count; i++) {
+			if (!locked && events[i].event_type != SurviveSimpleEventType_PoseUpdateEvent) {
+				os_mutex_lock(&ss->lock);
+				locked = true;
+			}
+			_process_event(ss, &events[i]);
+		}
+		if (locked) {
+			os_mutex_unlock(&ss->lock);
+		}
 
 		// Just keep swimming.
 		os_thread_helper_lock(&ss->event_thread);
@@ -44,6 +44,9 @@
 #define SLAM_ERROR(d, ...) U_LOG_IFL_E(d->log_level, __VA_ARGS__)
 
 DEBUG_GET_ONCE_LOG_OPTION(slam_log, "SLAM_LOG", U_LOGGING_INFO)
+DEBUG_GET_ONCE_BOOL_OPTION(slam_queue_frames, "TWRAP_SLAM_QUEUE_FRAMES", true)
+DEBUG_GET_ONCE_NUM_OPTION(slam_queue_size, "TWRAP_SLAM_QUEUE_SIZE", 4)
+DEBUG_GET_ONCE_BOOL_OPTION(slam_queue_drop_oldest, "TWRAP_SLAM_QUEUE_DROP_OLDEST", true)
 
 struct slam_device
 {
@@ -208,14 +211,41 @@ twrap_slam_create_device(struct xrt_frame_context *xfctx,
 		return XRT_ERROR_DEVICE_CREATION_FAILED;
 	}
 
+	// Put each camera on its own queue, so a SLAM system that falls behind never stalls the camera callback.
+	if (debug_get_bool_option_slam_queue_frames()) {
+		enum u_sink_queue_policy policy = debug_get_bool_option_slam_queue_drop_oldest()
+		                                      ? U_SINK_QUEUE_DROP_OLDEST
+		                                      : U_SINK_QUEUE_DROP_NEWEST;
+		uint64_t queue_size = (uint64_t)debug_get_num_option_slam_queue_size();
+
+		for (int i = 0; i < (*out_sinks)->cam_count; i++) {
+			struct xrt_frame_sink *queue = NULL;
+			char prefix[16];
+
+			if (!u_sink_queue_create_with_policy(xfctx, queue_size, policy, (*out_sinks)->cams[i], &queue)) {
+				SLAM_WARN(dx, "Failed to create queue for camera %i, pushing to SLAM synchronously", i);
+				continue;
+			}
+
+			snprintf(prefix, sizeof(prefix), "Camera %i", i);
+			u_sink_queue_add_vars(queue, dx, prefix);
+			(*out_sinks)->cams[i] = queue;
+		}
+	}
+
 	// Create a split sink at out_sink that pushes to the SLAM IMU sink as well as the 3dof IMU sink, then replace
-	// out_sinks's imu sink with the split sink.
+	// out_sinks's imu sink with the split sink. SLAM gets its samples queued so the driver thread doesn't wait on it.
 
 	struct xrt_imu_sink *sink_slam = (*out_sinks)->imu;
 
 	struct xrt_imu_sink *tmp = NULL;
 
-	u_imu_sink_split_create(xfctx, &dx->dof3->sink, sink_slam, &tmp);
+	if (u_imu_sink_split_create_queued(xfctx, &dx->dof3->sink, sink_slam, &tmp)) {
+		u_imu_sink_split_add_vars(tmp, dx, "IMU");
+	} else {
+		U_LOG_W("Failed to create queued IMU split, pushing to SLAM synchronously");
+		u_imu_sink_split_create(xfctx, &dx->dof3->sink, sink_slam, &tmp);
+	}
 	u_imu_sink_force_monotonic_create(xfctx, tmp, &tmp);
 
 	(*out_sinks)->imu = tmp;
@@ -15,6 +15,8 @@
 #include "util/u_debug.h"
 #include "math/m_space.h"
 #include "math/m_api.h"
+#include "math/m_clock_offset.h"
+#include "math/m_hand_joint_history.h"
 #include "util/u_time.h"
 #include "os/os_time.h"
 #include "os/os_threading.h"
@@ -23,6 +25,9 @@
 
 DEBUG_GET_ONCE_LOG_OPTION(ulv2_log, "ULV2_LOG", U_LOGGING_INFO)
 
+//! How many Leap frames to keep per hand, a bit more than half a second.
+#define ULV2_HISTORY_CAPACITY 64
+
 #define ULV2_TRACE(ulv2d, ...) U_LOG_XDEV_IFL_T(&ulv2d->base, ulv2d->log_level, __VA_ARGS__)
 #define ULV2_DEBUG(ulv2d, ...) U_LOG_XDEV_IFL_D(&ulv2d->base, ulv2d->log_level, __VA_ARGS__)
 #define ULV2_INFO(ulv2d, ...) U_LOG_XDEV_IFL_I(&ulv2d->base, ulv2d->log_level, __VA_ARGS__)
@@ -63,10 +68,14 @@ struct ulv2_device
 
 	struct xrt_hand_joint_set joints_write_in[2];
 
-	// Only read/write these last two if you have the mutex
-	struct xrt_hand_joint_set joints_read_out[2];
+	//! Written by the Leap thread, read lock-free from any thread.
+	struct m_hand_joint_history *history[2];
+
+	//! Offset from the Leap clock to monotonic time, only touched by the Leap thread.
+	time_duration_ns leap2mono;
 
-	bool hand_exists[2];
+	//! Id of the last Leap frame pushed, to not push the same frame twice.
+	int64_t last_frame_id;
 };
 
 inline struct ulv2_device *
@@ -283,6 +292,19 @@ leap_input_loop(void *ptr_to_xdev)
 		error_time = 100; // if there's an error next time, the modulo will return 0.
 
 		Leap::Frame frame = LeapController.frame();
+		if (!frame.isValid() || frame.id() == ulv2d->last_frame_id) {
+			// No new frame yet, the service runs at most at the camera rate.
+			os_nanosleep(U_TIME_1MS_IN_NS);
+			continue;
+		}
+		ulv2d->last_frame_id = frame.id();
+
+		// Leap timestamps are in microseconds on its own clock.
+		timepoint_ns now_mono = os_monotonic_get_ns();
+		timepoint_ns now_leap = LeapController.now() * 1000;
+		m_clock_offset_a2b(110.0f, now_leap, now_mono, &ulv2d->leap2mono);
+		timepoint_ns frame_ts = frame.timestamp() * 1000 + ulv2d->leap2mono;
+
 		Leap::HandList hands = frame.hands();
 		bool leftbeendone = false;
 		bool rightbeendone = false;
@@ -307,13 +329,18 @@ leap_input_loop(void *ptr_to_xdev)
 
 			ulv2_process_hand(hand, &ulv2d->joints_write_in[hi], hi);
 		}
-		os_thread_helper_lock(&ulv2d->leap_loop_oth);
-		memcpy(&ulv2d->joints_read_out, &ulv2d->joints_write_in, sizeof(struct xrt_hand_joint_set) * 2);
-		//! @todo (Moses Turner) Could be using LeapController.now() to try to emulate our own pose prediction,
-		//! but I ain't got time for that
-		ulv2d->hand_exists[0] = leftbeendone;
-		ulv2d->hand_exists[1] = rightbeendone;
-		os_thread_helper_unlock(&ulv2d->leap_loop_oth);
+
+		bool hand_done[2] = {leftbeendone, rightbeendone};
+		for (int hi = 0; hi < 2; hi++) {
+			struct xrt_hand_joint_set *set = &ulv2d->joints_write_in[hi];
+
+			// An inactive set clears the history, a lost hand is not interpolated.
+			m_space_relation_ident(&set->hand_pose);
+			set->hand_pose.relation_flags = valid_flags;
+			set->is_active = hand_done[hi];
+
+			m_hand_joint_history_push(ulv2d->history[hi], set, (uint64_t)frame_ts);
+		}
 	}
 
 cleanup_leap_loop:
@@ -345,21 +372,9 @@ ulv2_device_get_hand_tracking(struct xrt_device *xdev,
 
 	bool hand_index = (name == XRT_INPUT_GENERIC_HAND_TRACKING_RIGHT); // 0 if left, 1 if right.
 
-	bool hand_valid = ulv2d->hand_exists[hand_index];
-
-	os_thread_helper_lock(&ulv2d->leap_loop_oth);
-	memcpy(out_value, &ulv2d->joints_read_out[hand_index], sizeof(struct xrt_hand_joint_set));
-	hand_valid = ulv2d->hand_exists[hand_index];
-	os_thread_helper_unlock(&ulv2d->leap_loop_oth);
-	m_space_relation_ident(&out_value->hand_pose);
+	// Interpolated between Leap frames or predicted past the newest one.
+	m_hand_joint_history_get(ulv2d->history[hand_index], at_timestamp_ns, out_value);
 
-	if (hand_valid) {
-		out_value->is_active = true;
-		out_value->hand_pose.relation_flags = valid_flags;
-	} else {
-		out_value->is_active = false;
-	}
-	// This is a lie - this driver does no pose-prediction or history. Patches welcome.
 	*out_timestamp_ns = at_timestamp_ns;
 }
 
@@ -373,6 +388,9 @@ ulv2_device_destroy(struct xrt_device *xdev)
 	// Destroy also stops the thread.
 	os_thread_helper_destroy(&ulv2d->leap_loop_oth);
 
+	m_hand_joint_history_destroy(&ulv2d->history[0]);
+	m_hand_joint_history_destroy(&ulv2d->history[1]);
+
 	// Remove the variable tracking.
 	u_var_remove_root(ulv2d);
 
@@ -388,6 +406,11 @@ ulv2_create_device(struct xrt_device **out_xdev)
 
 	struct ulv2_device *ulv2d = U_DEVICE_ALLOCATE(struct ulv2_device, flags, num_hands, 0);
 
+	// Must exist before the thread starts pushing into them.
+	m_hand_joint_history_create(&ulv2d->history[0], ULV2_HISTORY_CAPACITY);
+	m_hand_joint_history_create(&ulv2d->history[1], ULV2_HISTORY_CAPACITY);
+	ulv2d->last_frame_id = -1;
+
 	os_thread_helper_init(&ulv2d->leap_loop_oth);
 	os_thread_helper_start(&ulv2d->leap_loop_oth, (&leap_input_loop), (void *)&ulv2d->base);
 
@@ -415,6 +438,7 @@ ulv2_create_device(struct xrt_device **out_xdev)
 
 	u_var_add_root(ulv2d, "Leap Motion v2 driver", true);
 	u_var_add_ro_text(ulv2d, ulv2d->base.str, "Name");
+	u_var_add_ro_i64(ulv2d, &ulv2d->leap2mono, "Leap to monotonic offset (ns)");
 
 
 
@@ -58,6 +58,7 @@
 
 DEBUG_GET_ONCE_LOG_OPTION(v4l2_log, "V4L2_LOG", U_LOGGING_WARN)
 DEBUG_GET_ONCE_NUM_OPTION(v4l2_exposure_absolute, "V4L2_EXPOSURE_ABSOLUTE", 10)
+DEBUG_GET_ONCE_BOOL_OPTION(v4l2_dmabuf, "V4L2_DMABUF", false)
 
 /*!
  * Streaming thread entrypoint
@@ -300,6 +301,28 @@ v4l2_setup_mmap_buffer(struct v4l2_fs *vid, struct v4l2_frame *vf, struct v4l2_b
 	return 0;
 }
 
+static void
+v4l2_export_dmabuf(struct v4l2_fs *vid, struct v4l2_frame *vf, uint32_t index)
+{
+	// From a previous stream.
+	if (vf->dmabuf_fd >= 0) {
+		close(vf->dmabuf_fd);
+		vf->dmabuf_fd = -1;
+	}
+
+	struct v4l2_exportbuffer expbuf = {0};
+	expbuf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	expbuf.index = index;
+	expbuf.flags = O_RDONLY | O_CLOEXEC;
+
+	if (ioctl(vid->fd, VIDIOC_EXPBUF, &expbuf) < 0) {
+		V4L2_DEBUG(vid, "info: Driver can not export buffer %u as DMA-BUF.", index);
+		return;
+	}
+
+	vf->dmabuf_fd = expbuf.fd;
+}
+
 static int
 v4l2_setup_userptr_buffer(struct v4l2_fs *vid, struct v4l2_frame *vf, struct v4l2_buffer *v_buf)
 {
@@ -643,6 +666,13 @@ v4l2_fs_destroy(struct v4l2_fs *vid)
 		}
 	}
 
+	for (uint32_t i = 0; i < NUM_V4L2_BUFFERS; i++) {
+		if (vid->frames[i].dmabuf_fd >= 0) {
+			close(vid->frames[i].dmabuf_fd);
+			vid->frames[i].dmabuf_fd = -1;
+		}
+	}
+
 	if (vid->fd >= 0) {
 		close(vid->fd);
 		vid->fd = -1;
@@ -682,6 +712,10 @@ v4l2_fs_create(struct xrt_frame_context *xfctx,
 	vid->node.destroy = v4l2_fs_node_destroy;
 	vid->log_level = debug_get_log_option_v4l2_log();
 	vid->fd = -1;
+	vid->capture.dmabuf = debug_get_bool_option_v4l2_dmabuf();
+	for (uint32_t i = 0; i < NUM_V4L2_BUFFERS; i++) {
+		vid->frames[i].dmabuf_fd = -1;
+	}
 
 	snprintf(vid->base.product, sizeof(vid->base.product), "%s", product);
 	snprintf(vid->base.manufacturer, sizeof(vid->base.manufacturer), "%s", manufacturer);
@@ -746,7 +780,13 @@ v4l2_fs_mainloop(void *ptr)
 	v_bufrequest.count = NUM_V4L2_BUFFERS;
 	v_bufrequest.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
 
-	if (v4l2_try_userptr(vid, &v_bufrequest) != 0 && v4l2_try_mmap(vid, &v_bufrequest) != 0) {
+	// Only kernel allocated buffers can be exported.
+	if (vid->capture.dmabuf) {
+		if (v4l2_try_mmap(vid, &v_bufrequest) != 0 && v4l2_try_userptr(vid, &v_bufrequest) != 0) {
+			V4L2_ERROR(vid, "error: Driver does not support mmap or userptr.");
+			return NULL;
+		}
+	} else if (v4l2_try_userptr(vid, &v_bufrequest) != 0 && v4l2_try_mmap(vid, &v_bufrequest) != 0) {
 		V4L2_ERROR(vid, "error: Driver does not support mmap or userptr.");
 		return NULL;
 	}
@@ -775,8 +815,14 @@ v4l2_fs_mainloop(void *ptr)
 			return NULL;
 		}
 
-		// Silence valgrind.
-		memset(vf->mem, 0, v_buf->length);
+		if (vid->capture.mmap && vid->capture.dmabuf) {
+			v4l2_export_dmabuf(vid, vf, i);
+		}
+
+		// Silence valgrind, mmap buffers are read only and zeroed by the kernel.
+		if (vid->capture.userptr) {
+			memset(vf->mem, 0, v_buf->length);
+		}
 
 		// Queue this buffer
 		if (ioctl(vid->fd, VIDIOC_QBUF, v_buf) < 0) {
@@ -836,6 +882,12 @@ v4l2_fs_mainloop(void *ptr)
 		xf->source_id = vid->base.source_id;
 		xf->source_sequence = v_buf.sequence;
 
+#ifdef XRT_GRAPHICS_BUFFER_HANDLE_IS_FD
+		xf->has_buffer_handle = vf->dmabuf_fd >= 0;
+		xf->buffer_handle = vf->dmabuf_fd;
+		xf->buffer_offset = desc->offset;
+#endif
+
 		if ((v_buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC) != 0) {
 			xf->timestamp = os_timeval_to_ns(&v_buf.timestamp);
 			xf->source_timestamp = xf->timestamp;
@@ -46,6 +46,8 @@ struct v4l2_frame
 
 	void *mem; //!< Data might be at an offset, so we need base memory.
 
+	int dmabuf_fd; //!< Buffer exported with VIDIOC_EXPBUF, -1 if not exported.
+
 	struct v4l2_buffer v_buf;
 };
 
@@ -108,6 +110,8 @@ struct v4l2_fs
 	{
 		bool mmap;
 		bool userptr;
+		//! Export the mmap buffers as DMA-BUFs and attach them to the frames.
+		bool dmabuf;
 	} capture;
 
 	struct xrt_frame_sink *sink;
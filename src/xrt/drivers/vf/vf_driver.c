@@ -9,6 +9,8 @@
  * @ingroup drv_vf
  */
 
+#include "xrt/xrt_handles.h"
+
 #include "os/os_time.h"
 #include "os/os_threading.h"
 
@@ -24,6 +26,7 @@
 #include "vf_interface.h"
 
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
 
 #include <glib.h>
@@ -31,6 +34,10 @@
 #include <gst/app/gstappsink.h>
 #include <gst/video/video-frame.h>
 
+#ifdef XRT_GRAPHICS_BUFFER_HANDLE_IS_FD
+#include <gst/allocators/gstdmabuf.h>
+#endif
+
 
 /*
  *
@@ -51,6 +58,30 @@
 #define VF_ERROR(d, ...) U_LOG_IFL_E(d->log_level, __VA_ARGS__)
 
 DEBUG_GET_ONCE_LOG_OPTION(vf_log, "VF_LOG", U_LOGGING_WARN)
+DEBUG_GET_ONCE_OPTION(vf_format, "VF_FORMAT", "YUY2")
+DEBUG_GET_ONCE_BOOL_OPTION(vf_sync, "VF_SYNC", true)
+
+/*!
+ * A GStreamer format the appsink can ask for and what it becomes.
+ */
+struct vf_format_desc
+{
+	const char *gst_format;
+	enum xrt_format format;
+};
+
+/*!
+ * Formats video files can be played back in, ask for the one the trackers
+ * consume so no converter is needed in between.
+ */
+static const struct vf_format_desc vf_formats[] = {
+    {"YUY2", XRT_FORMAT_YUYV422},
+    {"UYVY", XRT_FORMAT_UYVY422},
+    {"RGB", XRT_FORMAT_R8G8B8},
+    {"GRAY8", XRT_FORMAT_L8},
+    // Only the luma plane is used, what many decoders output without a conversion.
+    {"NV12", XRT_FORMAT_L8},
+};
 
 /*!
  * A frame server operating on a video file.
@@ -209,9 +240,19 @@ vf_fs_frame(struct vf_fs *vid, GstSample *sample)
 	xf->stride = info.stride[plane];
 	xf->data = vff->frame.data[plane];
 	xf->stereo_format = vid->stereo_format;
-	xf->size = info.size;
+	xf->size = GST_VIDEO_INFO_N_PLANES(&info) > 1 ? xf->stride * info.height : info.size;
 	xf->source_id = vid->base.source_id;
 
+#ifdef XRT_GRAPHICS_BUFFER_HANDLE_IS_FD
+	// Let consumers import the decoder's buffer, only possible if it is a single DMA-BUF.
+	GstMemory *mem = gst_buffer_n_memory(buffer) == 1 ? gst_buffer_peek_memory(buffer, 0) : NULL;
+	if (mem != NULL && gst_is_dmabuf_memory(mem)) {
+		xf->has_buffer_handle = true;
+		xf->buffer_handle = gst_dmabuf_memory_get_fd(mem);
+		xf->buffer_offset = mem->offset + GST_VIDEO_FRAME_PLANE_OFFSET(&vff->frame, plane);
+	}
+#endif
+
 	//! @todo Proper sequence number and timestamp.
 	xf->source_sequence = seq;
 	xf->timestamp = os_monotonic_get_ns();
@@ -470,7 +511,9 @@ alloc_and_init_common(struct xrt_frame_context *xfctx,      //
 	}
 
 	vid->testsink = gst_bin_get_by_name(GST_BIN(vid->source), "testsink");
-	g_object_set(G_OBJECT(vid->testsink), "emit-signals", TRUE, "sync", TRUE, NULL);
+	// Not syncing to the clock plays files back as fast as they can be decoded.
+	gboolean sync = debug_get_bool_option_vf_sync();
+	g_object_set(G_OBJECT(vid->testsink), "emit-signals", TRUE, "sync", sync, NULL);
 	g_signal_connect(vid->testsink, "new-sample", G_CALLBACK(on_new_sample_from_sink), vid);
 
 	bus = gst_element_get_bus(vid->source);
@@ -551,33 +594,36 @@ vf_fs_open_file(struct xrt_frame_context *xfctx, const char *path)
 		return NULL;
 	}
 
-#if 0
-	const gchar *caps = "video/x-raw,format=RGB";
-	enum xrt_format format = XRT_FORMAT_R8G8B8;
-	enum xrt_stereo_format stereo_format = XRT_STEREO_FORMAT_NONE;
-#endif
+	const char *gst_format = debug_get_option_vf_format();
+	const struct vf_format_desc *desc = NULL;
+	for (size_t i = 0; i < ARRAY_SIZE(vf_formats); i++) {
+		if (strcmp(vf_formats[i].gst_format, gst_format) == 0) {
+			desc = &vf_formats[i];
+			break;
+		}
+	}
 
-#if 0
-	// For hand tracking
-	const gchar *caps = "video/x-raw,format=RGB";
-	enum xrt_format format = XRT_FORMAT_R8G8B8;
-	enum xrt_stereo_format stereo_format = XRT_STEREO_FORMAT_SBS;
-#endif
+	if (desc == NULL) {
+		U_LOG_E("Unsupported VF_FORMAT '%s'", gst_format);
+		return NULL;
+	}
 
-#if 1
-	const gchar *caps = "video/x-raw,format=YUY2";
-	enum xrt_format format = XRT_FORMAT_YUYV422;
+	enum xrt_format format = desc->format;
 	enum xrt_stereo_format stereo_format = XRT_STEREO_FORMAT_SBS;
-#endif
 
 	gchar *loop = "false";
 
+	/*
+	 * DMA-BUF memory is preferred, so decoders that output the asked for
+	 * format hand their buffers straight through, videoconvert is then in
+	 * passthrough and nothing is copied.
+	 */
 	gchar *pipeline_string = g_strdup_printf(
 	    "multifilesrc location=\"%s\" loop=%s ! "
 	    "decodebin ! "
 	    "videoconvert ! "
-	    "appsink caps=\"%s\" name=testsink",
-	    path, loop, caps);
+	    "appsink caps=\"video/x-raw(memory:DMABuf),format=%s;video/x-raw,format=%s\" name=testsink",
+	    path, loop, desc->gst_format, desc->gst_format);
 
 	return alloc_and_init_common(xfctx, format, stereo_format, pipeline_string);
 }
@@ -9,6 +9,7 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
 #include <math.h>
 #include <zlib.h>
@@ -18,6 +19,7 @@
 #include "util/u_var.h"
 #include "util/u_time.h"
 #include "util/u_trace_marker.h"
+#include "util/u_calibration_cache.h"
 
 #ifdef XRT_OS_LINUX
 #include "util/u_linux.h"
@@ -36,6 +38,9 @@
 #include "xrt/xrt_tracking.h"
 
 
+//! How many HID reports are read at most per wakeup of the reading threads.
+#define VIVE_HID_READ_BATCH 16
+
 static bool
 vive_mainboard_power_off(struct vive_device *d);
 
@@ -59,6 +64,8 @@ vive_device_destroy(struct xrt_device *xdev)
 	os_thread_helper_destroy(&d->watchman_thread);
 	os_thread_helper_destroy(&d->mainboard_thread);
 
+	lighthouse_watchman_destroy(&d->watchman);
+
 	// Now that the thread is not running we can destroy the lock.
 
 	m_imu_3dof_close(&d->fusion.i3dof);
@@ -468,20 +475,8 @@ drain_imu(struct vive_device *d, const void *buffer)
  */
 
 static bool
-vive_mainboard_read_one_msg(struct vive_device *d)
+vive_mainboard_handle_msg(struct vive_device *d, const uint8_t *buffer, int ret)
 {
-	uint8_t buffer[64];
-
-	int ret = os_hid_read(d->mainboard_dev, buffer, sizeof(buffer), 1000);
-	if (ret == 0) {
-		// Time out
-		return true;
-	}
-	if (ret < 0) {
-		VIVE_ERROR(d, "Failed to read device '%i'!", ret);
-		return false;
-	}
-
 	DRV_TRACE_IDENT(packet);
 
 	switch (buffer[0]) {
@@ -498,6 +493,32 @@ vive_mainboard_read_one_msg(struct vive_device *d)
 	return true;
 }
 
+static bool
+vive_mainboard_read_msgs(struct vive_device *d)
+{
+	uint8_t buffers[VIVE_HID_READ_BATCH][64];
+	size_t sizes[VIVE_HID_READ_BATCH];
+
+	int count =
+	    os_hid_read_batch(d->mainboard_dev, buffers[0], sizeof(buffers[0]), sizes, VIVE_HID_READ_BATCH, 1000);
+	if (count == 0) {
+		// Time out
+		return true;
+	}
+	if (count < 0) {
+		VIVE_ERROR(d, "Failed to read device '%i'!", count);
+		return false;
+	}
+
+	for (int i = 0; i < count; i++) {
+		if (!vive_mainboard_handle_msg(d, buffers[i], (int)sizes[i])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
 static void *
 vive_mainboard_run_thread(void *ptr)
 {
@@ -509,7 +530,7 @@ vive_mainboard_run_thread(void *ptr)
 	while (os_thread_helper_is_running_locked(&d->mainboard_thread)) {
 		os_thread_helper_unlock(&d->mainboard_thread);
 
-		if (!vive_mainboard_read_one_msg(d)) {
+		if (!vive_mainboard_read_msgs(d)) {
 			return NULL;
 		}
 
@@ -631,37 +652,43 @@ _is_report_size_valid(struct vive_device *d, int size, int report_size, int repo
 }
 
 static bool
-vive_sensors_read_one_msg(struct vive_device *d,
-                          struct os_hid_device *dev,
-                          uint32_t report_id,
-                          int report_size,
-                          void (*process_cb)(struct vive_device *d, const void *buffer))
+vive_sensors_read_msgs(struct vive_device *d,
+                       struct os_hid_device *dev,
+                       uint32_t report_id,
+                       int report_size,
+                       void (*process_cb)(struct vive_device *d, const void *buffer))
 {
-	uint8_t buffer[64];
+	uint8_t buffers[VIVE_HID_READ_BATCH][64];
+	size_t sizes[VIVE_HID_READ_BATCH];
 
-	int ret = os_hid_read(dev, buffer, sizeof(buffer), 1000);
-	if (ret == 0) {
+	int count = os_hid_read_batch(dev, buffers[0], sizeof(buffers[0]), sizes, VIVE_HID_READ_BATCH, 1000);
+	if (count == 0) {
 		VIVE_ERROR(d, "Device %p timeout.", (void *)dev);
 		// Time out
 		return true;
 	}
-	if (ret < 0) {
-		VIVE_ERROR(d, "Failed to read device %p: %i.", (void *)dev, ret);
+	if (count < 0) {
+		VIVE_ERROR(d, "Failed to read device %p: %i.", (void *)dev, count);
 		return false;
 	}
 
-	DRV_TRACE_IDENT(packet);
+	for (int i = 0; i < count; i++) {
+		const uint8_t *buffer = buffers[i];
+		int ret = (int)sizes[i];
 
-	if (buffer[0] == report_id) {
-		if (!_is_report_size_valid(d, ret, report_size, report_id))
-			return false;
+		DRV_TRACE_IDENT(packet);
 
-		process_cb(d, buffer);
+		if (buffer[0] == report_id) {
+			if (!_is_report_size_valid(d, ret, report_size, report_id))
+				return false;
 
-	} else {
-		VIVE_ERROR(d, "Unexpected sensor report type %s (0x%x).", _sensors_get_report_string(buffer[0]),
-		           buffer[0]);
-		VIVE_ERROR(d, "Expected %s (0x%x).", _sensors_get_report_string(report_id), report_id);
+			process_cb(d, buffer);
+
+		} else {
+			VIVE_ERROR(d, "Unexpected sensor report type %s (0x%x).", _sensors_get_report_string(buffer[0]),
+			           buffer[0]);
+			VIVE_ERROR(d, "Expected %s (0x%x).", _sensors_get_report_string(report_id), report_id);
+		}
 	}
 
 	return true;
@@ -722,20 +749,8 @@ _print_pulse_report_v2(struct vive_device *d, const void *buffer)
 }
 
 static bool
-vive_sensors_read_lighthouse_msg(struct vive_device *d)
+vive_sensors_handle_lighthouse_msg(struct vive_device *d, const uint8_t *buffer, int ret)
 {
-	uint8_t buffer[64];
-
-	int ret = os_hid_read(d->watchman_dev, buffer, sizeof(buffer), 1000);
-	if (ret == 0) {
-		// basestations not present/powered off
-		VIVE_TRACE(d, "Watchman device timed out.");
-		return true;
-	}
-	if (ret < 0) {
-		VIVE_ERROR(d, "Failed to read Watchman device: %i.", ret);
-		return false;
-	}
 	if (ret > 64) {
 		VIVE_ERROR(d,
 		           "Buffer too big from Watchman device: %i."
@@ -779,6 +794,33 @@ vive_sensors_read_lighthouse_msg(struct vive_device *d)
 	return true;
 }
 
+static bool
+vive_sensors_read_lighthouse_msgs(struct vive_device *d)
+{
+	uint8_t buffers[VIVE_HID_READ_BATCH][64];
+	size_t sizes[VIVE_HID_READ_BATCH];
+
+	int count =
+	    os_hid_read_batch(d->watchman_dev, buffers[0], sizeof(buffers[0]), sizes, VIVE_HID_READ_BATCH, 1000);
+	if (count == 0) {
+		// basestations not present/powered off
+		VIVE_TRACE(d, "Watchman device timed out.");
+		return true;
+	}
+	if (count < 0) {
+		VIVE_ERROR(d, "Failed to read Watchman device: %i.", count);
+		return false;
+	}
+
+	for (int i = 0; i < count; i++) {
+		if (!vive_sensors_handle_lighthouse_msg(d, buffers[i], (int)sizes[i])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
 static void *
 vive_watchman_run_thread(void *ptr)
 {
@@ -791,7 +833,7 @@ vive_watchman_run_thread(void *ptr)
 		os_thread_helper_unlock(&d->watchman_thread);
 
 		if (d->watchman_dev)
-			if (!vive_sensors_read_lighthouse_msg(d))
+			if (!vive_sensors_read_lighthouse_msgs(d))
 				return NULL;
 
 		// Just keep swimming.
@@ -824,7 +866,7 @@ vive_sensors_run_thread(void *ptr)
 
 	while (future_50ms_ns > os_monotonic_get_ns() && os_thread_helper_is_running(&d->sensors_thread)) {
 		// Lock not held.
-		if (!vive_sensors_read_one_msg(d, d->sensors_dev, VIVE_IMU_REPORT_ID, 52, drain_imu)) {
+		if (!vive_sensors_read_msgs(d, d->sensors_dev, VIVE_IMU_REPORT_ID, 52, drain_imu)) {
 			return NULL;
 		}
 	}
@@ -836,7 +878,7 @@ vive_sensors_run_thread(void *ptr)
 
 	while (os_thread_helper_is_running(&d->sensors_thread)) {
 		// Lock not held.
-		if (!vive_sensors_read_one_msg(d, d->sensors_dev, VIVE_IMU_REPORT_ID, 52, update_imu)) {
+		if (!vive_sensors_read_msgs(d, d->sensors_dev, VIVE_IMU_REPORT_ID, 52, update_imu)) {
 			return NULL;
 		}
 	}
@@ -892,6 +934,9 @@ vive_device_setup_ui(struct vive_device *d)
 	u_var_add_ro_text(d, d->gui.slam_status, "Tracker status");
 	u_var_add_bool(d, &d->tracking.imu2me, "Correct IMU pose to middle of eyes");
 
+	u_var_add_gui_header(d, NULL, "Lighthouse");
+	u_var_add_ro_u64(d, &d->watchman.sweeps_dropped, "Sweeps dropped");
+
 	u_var_add_gui_header(d, NULL, "Hand Tracking");
 	u_var_add_ro_text(d, d->gui.hand_status, "Tracker status");
 }
@@ -989,11 +1034,41 @@ precompute_sensor_transforms(struct vive_device *d)
 	d->P_imu_me = P_imuxr_me;
 }
 
+/*!
+ * The config is downloaded over HID a few bytes at a time, which takes a while,
+ * so it is cached by serial number and firmware version.
+ */
+static char *
+read_config_cached(struct vive_device *d, const char *serial)
+{
+	char key[128];
+	bool use_cache = serial != NULL && serial[0] != '\0';
+	if (use_cache) {
+		snprintf(key, sizeof(key), "vive_%s_%u_%u", serial, d->config.firmware.firmware_version,
+		         d->config.firmware.hardware_revision);
+
+		size_t size = 0;
+		char *config = (char *)u_calibration_cache_load(key, &size);
+		if (config != NULL) {
+			VIVE_DEBUG(d, "Using cached config '%s'", key);
+			return config;
+		}
+	}
+
+	char *config = vive_read_config(d->sensors_dev);
+	if (config != NULL && use_cache) {
+		u_calibration_cache_store(key, (const uint8_t *)config, strlen(config));
+	}
+
+	return config;
+}
+
 struct vive_device *
 vive_device_create(struct os_hid_device *mainboard_dev,
                    struct os_hid_device *sensors_dev,
                    struct os_hid_device *watchman_dev,
                    enum VIVE_VARIANT variant,
+                   const char *serial,
                    struct vive_tracking_status tstatus,
                    struct vive_source *vs)
 {
@@ -1053,7 +1128,7 @@ vive_device_create(struct os_hid_device *mainboard_dev,
 	VIVE_INFO(d, "Vive gyroscope range     %f", d->config.imu.gyro_range);
 	VIVE_INFO(d, "Vive accelerometer range %f", d->config.imu.acc_range);
 
-	char *config = vive_read_config(d->sensors_dev);
+	char *config = read_config_cached(d, serial);
 
 	d->config.log_level = d->log_level;
 	// usb connected HMD variant is known because of USB id, config parsing relies on it.
@@ -1066,6 +1141,12 @@ vive_device_create(struct os_hid_device *mainboard_dev,
 	d->base.hmd->distortion.fov[0] = d->config.distortion.fov[0];
 	d->base.hmd->distortion.fov[1] = d->config.distortion.fov[1];
 
+	// The Pro 2 flips the result, which the analytic model doesn't.
+	if (d->config.variant != VIVE_VARIANT_PRO2) {
+		u_distortion_set_analytic_vive(&d->base, 0, &d->config.distortion.values[0]);
+		u_distortion_set_analytic_vive(&d->base, 1, &d->config.distortion.values[1]);
+	}
+
 	// Per-view size.
 	uint32_t w_pixels = d->config.display.eye_target_width_in_pixels;
 	uint32_t h_pixels = d->config.display.eye_target_height_in_pixels;
@@ -152,11 +152,16 @@ struct vive_tracking_status
 void
 vive_set_trackers_status(struct vive_device *d, struct vive_tracking_status status);
 
+/*!
+ * The @p serial is the USB serial number of the headset, if not NULL or empty
+ * it is used to cache the config read from the device.
+ */
 struct vive_device *
 vive_device_create(struct os_hid_device *mainboard_dev,
                    struct os_hid_device *sensors_dev,
                    struct os_hid_device *watchman_dev,
                    enum VIVE_VARIANT variant,
+                   const char *serial,
                    struct vive_tracking_status tstatus,
                    struct vive_source *vs);
 
@@ -15,6 +15,7 @@
 #include <stdio.h>
 
 #include "math/m_api.h"
+#include "util/u_misc.h"
 #include "util/u_debug.h"
 #include "util/u_logging.h"
 
@@ -30,6 +31,16 @@ static enum u_logging_level log_level;
 
 DEBUG_GET_ONCE_LOG_OPTION(vive_log, "VIVE_LOG", U_LOGGING_WARN)
 
+//! About a quarter of a second of sweeps from two bases.
+#define SWEEP_QUEUE_SIZE (64)
+
+/*
+ * A rotor turns 180° in 400000 ticks of the 48 MHz clock, the optical axis of
+ * the base is hit halfway through.
+ */
+#define SWEEP_CENTER_TICKS (200000.0f)
+#define SWEEP_RADIANS_PER_TICK ((float)M_PI / 400000.0f)
+
 struct lighthouse_ootx_report
 {
 	__le16 version;
@@ -295,6 +306,48 @@ lighthouse_base_handle_ootx_data_bit(struct lighthouse_watchman *watchman, struc
 	}
 }
 
+static void
+lighthouse_base_publish_frame(struct lighthouse_watchman *watchman,
+                              struct lighthouse_base *base,
+                              struct lighthouse_frame *frame)
+{
+	uint32_t ticket;
+
+	if (watchman->sweeps == NULL)
+		return;
+
+	if (!u_mpsc_ring_claim(&watchman->sweep_ring, &ticket)) {
+		watchman->sweeps_dropped++;
+		return;
+	}
+
+	struct lighthouse_sweep *sweep = &watchman->sweeps[u_mpsc_ring_slot(&watchman->sweep_ring, ticket)];
+	uint32_t count = 0;
+
+	sweep->base_serial = base->serial;
+	sweep->channel = base->channel;
+	sweep->rotor = (uint8_t)base->active_rotor;
+	sweep->sync_timestamp = frame->sync_timestamp;
+
+	/* Pack the hit sensors first, so the conversion is a branchless loop */
+	for (uint32_t id = 0; id < LIGHTHOUSE_MAX_SENSORS; id++) {
+		if (!(frame->sweep_ids & (1u << id)))
+			continue;
+
+		sweep->ids[count] = (uint8_t)id;
+		sweep->durations[count] = frame->sweep_duration[id];
+		sweep->ticks[count] = frame->sweep_offset[id] + frame->sweep_duration[id] / 2;
+		count++;
+	}
+	sweep->count = count;
+
+	for (uint32_t i = 0; i < count; i++) {
+		sweep->angles[i] = ((float)sweep->ticks[i] - SWEEP_CENTER_TICKS) * SWEEP_RADIANS_PER_TICK;
+	}
+
+	u_mpsc_ring_publish(&watchman->sweep_ring, ticket);
+}
+
 static void
 lighthouse_base_handle_frame(struct lighthouse_watchman *watchman,
                              struct lighthouse_base *base,
@@ -302,8 +355,6 @@ lighthouse_base_handle_frame(struct lighthouse_watchman *watchman,
 {
 	struct lighthouse_frame *frame = &base->frame[base->active_rotor];
 
-	(void)watchman;
-
 	if (!frame->sweep_ids)
 		return;
 
@@ -316,7 +367,7 @@ lighthouse_base_handle_frame(struct lighthouse_watchman *watchman,
 	if (frame->frame_duration > 1000000)
 		return;
 
-	// telemetry_send_lighthouse_frame(watchman->id, frame);
+	lighthouse_base_publish_frame(watchman, base, frame);
 }
 
 /*
@@ -539,4 +590,30 @@ lighthouse_watchman_init(struct lighthouse_watchman *watchman, const char *name)
 	watchman->last_sync.timestamp = 0;
 	watchman->last_sync.duration = 0;
 	log_level = debug_get_log_option_vive_log();
+
+	u_mpsc_ring_init(&watchman->sweep_ring, SWEEP_QUEUE_SIZE);
+	watchman->sweeps = U_TYPED_ARRAY_CALLOC(struct lighthouse_sweep, u_mpsc_ring_size(&watchman->sweep_ring));
+	watchman->sweeps_dropped = 0;
+}
+
+bool
+lighthouse_watchman_pop_sweep(struct lighthouse_watchman *watchman, struct lighthouse_sweep *out_sweep)
+{
+	uint32_t slot;
+
+	if (watchman->sweeps == NULL || !u_mpsc_ring_peek(&watchman->sweep_ring, &slot))
+		return false;
+
+	*out_sweep = watchman->sweeps[slot];
+	u_mpsc_ring_release(&watchman->sweep_ring);
+
+	return true;
+}
+
+void
+lighthouse_watchman_destroy(struct lighthouse_watchman *watchman)
+{
+	u_mpsc_ring_fini(&watchman->sweep_ring);
+	free(watchman->sweeps);
+	watchman->sweeps = NULL;
 }
@@ -19,6 +19,11 @@
 
 #include "xrt/xrt_defines.h"
 
+#include "util/u_mpsc_ring.h"
+
+//! Number of sensor ids a watchman can report, they are bits in a mask.
+#define LIGHTHOUSE_MAX_SENSORS (32)
+
 struct lighthouse_rotor_calibration
 {
 	float tilt;
@@ -39,8 +44,8 @@ struct lighthouse_frame
 	uint32_t sync_duration;
 	uint32_t sync_ids;
 	uint32_t sweep_ids;
-	uint32_t sweep_offset[32];
-	uint16_t sweep_duration[32];
+	uint32_t sweep_offset[LIGHTHOUSE_MAX_SENSORS];
+	uint16_t sweep_duration[LIGHTHOUSE_MAX_SENSORS];
 	uint32_t frame_duration;
 };
 
@@ -65,6 +70,36 @@ struct lighthouse_base
 	struct lighthouse_frame frame[2];
 };
 
+/*!
+ * All hits of one sweep of a base station rotor, the sensors that were hit
+ * are packed at the front of the arrays so they can be processed in plain
+ * loops.
+ */
+struct lighthouse_sweep
+{
+	//! Zero until the OOTX frame of the base has been received.
+	uint32_t base_serial;
+	char channel;
+
+	//! 0 for the horizontal J axis, 1 for the vertical K axis.
+	uint8_t rotor;
+
+	uint32_t sync_timestamp;
+	uint32_t count;
+
+	uint8_t ids[LIGHTHOUSE_MAX_SENSORS];
+	uint16_t durations[LIGHTHOUSE_MAX_SENSORS];
+
+	//! Ticks from the sync pulse to the middle of the hit.
+	uint32_t ticks[LIGHTHOUSE_MAX_SENSORS];
+
+	/*!
+	 * Angle from the optical axis of the base in radians, without the
+	 * rotor calibration of the base applied.
+	 */
+	float angles[LIGHTHOUSE_MAX_SENSORS];
+};
+
 struct lighthouse_pulse
 {
 	uint32_t timestamp;
@@ -95,9 +130,16 @@ struct lighthouse_watchman
 	struct lighthouse_base *active_base;
 	uint32_t seen_by;
 	uint32_t last_timestamp;
-	struct lighthouse_sensor sensor[32];
+	struct lighthouse_sensor sensor[LIGHTHOUSE_MAX_SENSORS];
 	struct lighthouse_pulse last_sync;
 	bool sync_lock;
+
+	//! Completed sweeps, written by the pulse handling and read by a solver.
+	struct u_mpsc_ring sweep_ring;
+	struct lighthouse_sweep *sweeps;
+
+	//! Sweeps dropped because the solver did not keep up.
+	uint64_t sweeps_dropped;
 };
 
 void
@@ -107,3 +149,14 @@ lighthouse_watchman_handle_pulse(struct lighthouse_watchman *watchman,
                                  uint32_t timestamp);
 void
 lighthouse_watchman_init(struct lighthouse_watchman *watchman, const char *name);
+
+/*!
+ * Gets the oldest completed sweep, only call from one thread.
+ *
+ * @return false if there is no new sweep.
+ */
+bool
+lighthouse_watchman_pop_sweep(struct lighthouse_watchman *watchman, struct lighthouse_sweep *out_sweep);
+
+void
+lighthouse_watchman_destroy(struct lighthouse_watchman *watchman);
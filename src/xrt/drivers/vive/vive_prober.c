@@ -8,6 +8,7 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 
 
 #include "util/u_debug.h"
@@ -62,6 +63,21 @@ log_vive_device(enum u_logging_level log_level, struct xrt_prober *xp, struct xr
 	log_vive_string(xp, dev, XRT_PROBER_STRING_SERIAL_NUMBER);
 }
 
+/*!
+ * The USB serial number of @p dev, empty if it doesn't have one.
+ */
+static void
+get_vive_serial(struct xrt_prober *xp, struct xrt_prober_device *dev, char *out_serial, size_t serial_size)
+{
+	memset(out_serial, 0, serial_size);
+
+	unsigned char *buf = (unsigned char *)out_serial;
+	int len = xrt_prober_get_string_descriptor(xp, dev, XRT_PROBER_STRING_SERIAL_NUMBER, buf, serial_size - 1);
+	if (len <= 0) {
+		out_serial[0] = '\0';
+	}
+}
+
 static void
 init_vive1(struct xrt_prober *xp,
            struct xrt_prober_device *dev,
@@ -123,8 +139,11 @@ init_vive1(struct xrt_prober *xp,
 		free(sensors_dev);
 		return;
 	}
+	char serial[256];
+	get_vive_serial(xp, dev, serial, sizeof(serial));
+
 	struct vive_device *d =
-	    vive_device_create(mainboard_dev, sensors_dev, watchman_dev, VIVE_VARIANT_VIVE, tstatus, vs);
+	    vive_device_create(mainboard_dev, sensors_dev, watchman_dev, VIVE_VARIANT_VIVE, serial, tstatus, vs);
 	if (d == NULL) {
 		free(sensors_dev);
 		free(mainboard_dev);
@@ -200,8 +219,11 @@ init_vive_pro(struct xrt_prober *xp,
 		free(sensors_dev);
 		return;
 	}
+	char serial[256];
+	get_vive_serial(xp, dev, serial, sizeof(serial));
+
 	struct vive_device *d =
-	    vive_device_create(mainboard_dev, sensors_dev, watchman_dev, VIVE_VARIANT_PRO, tstatus, vs);
+	    vive_device_create(mainboard_dev, sensors_dev, watchman_dev, VIVE_VARIANT_PRO, serial, tstatus, vs);
 	if (d == NULL) {
 		free(sensors_dev);
 		free(mainboard_dev);
@@ -277,8 +299,11 @@ init_vive_pro2(struct xrt_prober *xp,
 		free(sensors_dev);
 		return;
 	}
+	char serial[256];
+	get_vive_serial(xp, dev, serial, sizeof(serial));
+
 	struct vive_device *d =
-	    vive_device_create(mainboard_dev, sensors_dev, watchman_dev, VIVE_VARIANT_PRO, tstatus, vs);
+	    vive_device_create(mainboard_dev, sensors_dev, watchman_dev, VIVE_VARIANT_PRO, serial, tstatus, vs);
 	if (d == NULL) {
 		free(sensors_dev);
 		free(mainboard_dev);
@@ -336,7 +361,11 @@ init_valve_index(struct xrt_prober *xp,
 		return;
 	}
 
-	struct vive_device *d = vive_device_create(NULL, sensors_dev, watchman_dev, VIVE_VARIANT_INDEX, tstatus, vs);
+	char serial[256];
+	get_vive_serial(xp, dev, serial, sizeof(serial));
+
+	struct vive_device *d =
+	    vive_device_create(NULL, sensors_dev, watchman_dev, VIVE_VARIANT_INDEX, serial, tstatus, vs);
 	if (d == NULL) {
 		return;
 	}
@@ -123,6 +123,8 @@ struct wmr_camera
 
 	struct xrt_frame_sink *cam_sinks[WMR_MAX_CAMERAS]; //!< Downstream sinks to push tracking frames to
 
+	struct u_frame_pool *frame_pool; //!< Frames are recycled instead of allocated for each transfer
+
 	enum u_logging_level log_level;
 };
 
@@ -300,7 +302,7 @@ img_xfer_cb(struct libusb_transfer *xfer)
 	struct xrt_frame *xf = NULL;
 
 	/* There's always one extra line of pixels with exposure info */
-	u_frame_create_one_off(XRT_FORMAT_L8, cam->frame_width, cam->frame_height + 1, &xf);
+	u_frame_pool_create_frame(cam->frame_pool, XRT_FORMAT_L8, cam->frame_width, cam->frame_height + 1, &xf);
 
 	const uint8_t *src = xfer->buffer;
 
@@ -351,6 +353,11 @@ img_xfer_cb(struct libusb_transfer *xfer)
 	/* frametype 0 is SLAM, frametype 2 is controller tracking */
 	bool slam_tracking_frame = (frametype == WMR_FRAMETYPE_SLAM);
 
+	/* Everything needed has been copied out of the transfer, give it back to
+	 * libusb now instead of after the sinks have run so the next frame can
+	 * land while this one is being processed. */
+	libusb_submit_transfer(xfer);
+
 	WMR_CAM_TRACE(cam,
 	              "Frame start TS %" PRIu64 " (%" PRIi64 " since last) end %" PRIu64 " dt %" PRIi64
 	              " unknown %u %u frame type %u",
@@ -403,6 +410,7 @@ img_xfer_cb(struct libusb_transfer *xfer)
 	}
 
 	xrt_frame_reference(&xf, NULL);
+	return;
 
 out:
 	libusb_submit_transfer(xfer);
@@ -427,6 +435,7 @@ wmr_camera_open(struct wmr_camera_open_config *config)
 	cam->tcam_count = config->tcam_count;
 	cam->slam_cam_count = config->slam_cam_count;
 	cam->log_level = config->log_level;
+	cam->frame_pool = u_frame_pool_create(NUM_XFERS);
 
 	for (int i = 0; i < cam->tcam_count; i++) {
 		cam->tcam_confs[i] = *config->tcam_confs[i];
@@ -571,6 +580,9 @@ wmr_camera_free(struct wmr_camera *cam)
 	u_sink_debug_destroy(&cam->debug_sinks[WMR_DEBUG_SINK_SLAM]);
 	u_sink_debug_destroy(&cam->debug_sinks[WMR_DEBUG_SINK_CONTROLLER]);
 
+	// Frames still out keep the pool alive.
+	u_frame_pool_reference(&cam->frame_pool, NULL);
+
 	free(cam);
 }
 
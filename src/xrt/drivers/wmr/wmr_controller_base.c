@@ -236,10 +236,7 @@ wmr_read_fw_block(struct wmr_controller_base *d, uint8_t blk_id, uint8_t **out_d
  *
  */
 static bool
-read_controller_fw_info(struct wmr_controller_base *wcb,
-                        uint32_t *fw_revision,
-                        uint16_t *calibration_size,
-                        char serial_no[16])
+read_controller_fw_revision(struct wmr_controller_base *wcb, uint32_t *fw_revision, uint16_t *calibration_size)
 {
 	uint8_t *data = NULL;
 	size_t data_size;
@@ -265,6 +262,15 @@ read_controller_fw_info(struct wmr_controller_base *wcb,
 	*calibration_size = read16(&tmp);
 
 	free(data);
+	return true;
+}
+
+static bool
+read_controller_serial(struct wmr_controller_base *wcb, char serial_no[16])
+{
+	uint8_t *data = NULL;
+	size_t data_size;
+	int ret;
 
 	/* FW block 3 contains the controller serial number at offset
 	 * 0x84, size 16 bytes */
@@ -381,12 +387,15 @@ read_controller_config(struct wmr_controller_base *wcb)
 	uint16_t calibration_size;
 	char serial_no[16 + 1];
 
-	if (!read_controller_fw_info(wcb, &fw_revision, &calibration_size, serial_no)) {
+	/*
+	 * The serial is all that is needed to find the cached config, every
+	 * block read is a number of round trips over the link, so the other
+	 * blocks are only read when the config has to be downloaded.
+	 */
+	if (!read_controller_serial(wcb, serial_no)) {
 		return false;
 	}
 
-	WMR_INFO(wcb, "Reading configuration for controller serial %s. FW revision %x", serial_no, fw_revision);
-
 #if 0
   /* WMR also reads block 0x14, which seems to have some FW revision info,
    * but we don't use it */
@@ -398,10 +407,6 @@ read_controller_config(struct wmr_controller_base *wcb)
 	data = NULL;
 #endif
 
-	// Read config block
-	WMR_INFO(wcb, "Reading %s controller config",
-	         wcb->base.device_type == XRT_DEVICE_TYPE_LEFT_HAND_CONTROLLER ? "left" : "right");
-
 	// Check if we have it cached already
 	char *cache_filename = build_cache_filename(serial_no);
 
@@ -409,6 +414,17 @@ read_controller_config(struct wmr_controller_base *wcb)
 		unsigned char *data = NULL;
 		size_t data_size;
 
+		if (!read_controller_fw_revision(wcb, &fw_revision, &calibration_size)) {
+			free(cache_filename);
+			return false;
+		}
+
+		WMR_INFO(wcb, "Reading configuration for controller serial %s. FW revision %x", serial_no, fw_revision);
+
+		// Read config block
+		WMR_INFO(wcb, "Reading %s controller config",
+		         wcb->base.device_type == XRT_DEVICE_TYPE_LEFT_HAND_CONTROLLER ? "left" : "right");
+
 		ret = wmr_read_fw_block(wcb, 0x02, &data, &data_size);
 		if (ret < 0 || data == NULL || data_size < 2) {
 			free(cache_filename);
@@ -431,9 +447,9 @@ read_controller_config(struct wmr_controller_base *wcb)
 		write_calibration_cache(wcb, cache_filename, config_json_block, data_size - sizeof(uint16_t));
 		free(data);
 	} else {
-		WMR_DEBUG(wcb, "Read %s controller config from cache %s",
-		          wcb->base.device_type == XRT_DEVICE_TYPE_LEFT_HAND_CONTROLLER ? "left" : "right",
-		          cache_filename);
+		WMR_INFO(wcb, "Read %s controller config for serial %s from cache %s",
+		         wcb->base.device_type == XRT_DEVICE_TYPE_LEFT_HAND_CONTROLLER ? "left" : "right", serial_no,
+		         cache_filename);
 	}
 	free(cache_filename);
 
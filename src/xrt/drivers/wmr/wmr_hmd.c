@@ -37,6 +37,7 @@
 #include "util/u_trace_marker.h"
 #include "util/u_distortion_mesh.h"
 #include "util/u_sink.h"
+#include "util/u_calibration_cache.h"
 
 #ifdef XRT_OS_LINUX
 #include "util/u_linux.h"
@@ -445,15 +446,14 @@ hololens_handle_sensors_all(struct wmr_hmd *wh, const unsigned char *buffer, int
 		math_quat_rotate_vec3(&wh->config.sensors.transforms.P_oxr_acc.orientation, ca, ca);
 	}
 
-	// Fusion tracking
-	os_mutex_lock(&wh->fusion.mutex);
+	uint64_t timestamps_ns[IMU_SAMPLES_PER_PACKET];
 	for (int i = 0; i < IMU_SAMPLES_PER_PACKET; i++) {
-		m_imu_3dof_update(                                              //
-		    &wh->fusion.i3dof,                                          //
-		    wh->packet.gyro_timestamp[i] * WMR_MS_HOLOLENS_NS_PER_TICK, //
-		    &calib_accel[i],                                            //
-		    &calib_gyro[i]);                                            //
+		timestamps_ns[i] = wh->packet.gyro_timestamp[i] * WMR_MS_HOLOLENS_NS_PER_TICK;
 	}
+
+	// Fusion tracking
+	os_mutex_lock(&wh->fusion.mutex);
+	m_imu_3dof_update_batch(&wh->fusion.i3dof, timestamps_ns, calib_accel, calib_gyro, IMU_SAMPLES_PER_PACKET);
 	wh->fusion.last_imu_timestamp_ns = now_ns;
 	wh->fusion.last_angular_velocity = calib_gyro[3];
 	os_mutex_unlock(&wh->fusion.mutex);
@@ -964,7 +964,7 @@ wmr_read_config_part(struct wmr_hmd *wh, unsigned char type, unsigned char *data
 }
 
 XRT_MAYBE_UNUSED static int
-wmr_read_config_raw(struct wmr_hmd *wh, uint8_t **out_data, size_t *out_size)
+wmr_read_config_raw(struct wmr_hmd *wh, const char *serial, uint8_t **out_data, size_t *out_size)
 {
 	DRV_TRACE_MARKER();
 
@@ -985,6 +985,27 @@ wmr_read_config_raw(struct wmr_hmd *wh, uint8_t **out_data, size_t *out_size)
 	 * seem to be little endian size of the data store.
 	 */
 	data_size = meta[0] | (meta[1] << 8);
+
+	/*
+	 * The data is read 30 bytes per command, which takes seconds, the
+	 * calibration is fixed at the factory so cache it per headset.
+	 */
+	char key[128];
+	bool use_cache = serial != NULL && serial[0] != '\0';
+	if (use_cache) {
+		snprintf(key, sizeof(key), "wmr_%s_%d", serial, data_size);
+
+		size_t cached_size = 0;
+		data = u_calibration_cache_load(key, &cached_size);
+		if (data != NULL && cached_size == (size_t)data_size) {
+			WMR_DEBUG(wh, "Using cached config '%s'", key);
+			*out_data = data;
+			*out_size = cached_size;
+			return 0;
+		}
+		free(data);
+	}
+
 	data = calloc(1, data_size + 1);
 	if (!data) {
 		return -1;
@@ -1000,6 +1021,10 @@ wmr_read_config_raw(struct wmr_hmd *wh, uint8_t **out_data, size_t *out_size)
 
 	WMR_DEBUG(wh, "Read %d-byte config data", data_size);
 
+	if (use_cache && size == data_size) {
+		u_calibration_cache_store(key, data, (size_t)size);
+	}
+
 	*out_data = data;
 	*out_size = size;
 
@@ -1007,7 +1032,7 @@ wmr_read_config_raw(struct wmr_hmd *wh, uint8_t **out_data, size_t *out_size)
 }
 
 static int
-wmr_read_config(struct wmr_hmd *wh)
+wmr_read_config(struct wmr_hmd *wh, const char *serial)
 {
 	DRV_TRACE_MARKER();
 
@@ -1017,7 +1042,7 @@ wmr_read_config(struct wmr_hmd *wh)
 	int ret;
 
 	// Read config
-	ret = wmr_read_config_raw(wh, &data, &data_size);
+	ret = wmr_read_config_raw(wh, serial, &data, &data_size);
 	if (ret < 0)
 		return ret;
 
@@ -1875,6 +1900,7 @@ wmr_hmd_create(enum wmr_headset_type hmd_type,
                struct os_hid_device *hid_holo,
                struct os_hid_device *hid_ctrl,
                struct xrt_prober_device *dev_holo,
+               const char *serial,
                enum u_logging_level log_level,
                struct xrt_device **out_hmd,
                struct xrt_device **out_handtracker,
@@ -1952,7 +1978,7 @@ wmr_hmd_create(enum wmr_headset_type hmd_type,
 	wh->base.inputs[0].name = XRT_INPUT_GENERIC_HEAD_POSE;
 
 	// Read config file from HMD
-	if (wmr_read_config(wh) < 0) {
+	if (wmr_read_config(wh, serial) < 0) {
 		WMR_ERROR(wh, "Failed to load headset configuration!");
 		wmr_hmd_destroy(&wh->base);
 		wh = NULL;
@@ -2048,7 +2074,7 @@ wmr_hmd_create(enum wmr_headset_type hmd_type,
 	hololens_sensors_enable_imu(wh);
 
 	// Switch on data streams on the HMD (only cameras for now as IMU is not yet integrated into wmr_source)
-	wh->tracking.source = wmr_source_create(&wh->tracking.xfctx, dev_holo, wh->config);
+	wh->tracking.source = wmr_source_create(&wh->tracking.xfctx, dev_holo, serial, wh->config);
 
 	struct xrt_slam_sinks sinks = {0};
 	struct xrt_device *hand_device = NULL;
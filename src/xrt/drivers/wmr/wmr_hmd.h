@@ -202,11 +202,16 @@ wmr_hmd(struct xrt_device *p)
 	return (struct wmr_hmd *)p;
 }
 
+/*!
+ * The @p serial is the USB serial number of the HoloLens Sensors device, if
+ * not NULL or empty it is used to cache the config read from the headset.
+ */
 void
 wmr_hmd_create(enum wmr_headset_type hmd_type,
                struct os_hid_device *hid_holo,
                struct os_hid_device *hid_ctrl,
                struct xrt_prober_device *dev_holo,
+               const char *serial,
                enum u_logging_level log_level,
                struct xrt_device **out_hmd,
                struct xrt_device **out_handtracker,
@@ -151,6 +151,21 @@ wmr_create_bt_controller(struct xrt_prober *xp,
                          enum u_logging_level log_level,
                          struct xrt_device **out_xdev);
 
+/*!
+ * Creates a pair of WMR BT controller devices, either may be NULL. Both are
+ * brought up at the same time, so connecting takes as long as the slowest of
+ * them instead of both one after the other. On failure no device is returned.
+ *
+ * @ingroup drv_wmr
+ */
+xrt_result_t
+wmr_create_bt_controller_pair(struct xrt_prober *xp,
+                              struct xrt_prober_device *left_xpdev,
+                              struct xrt_prober_device *right_xpdev,
+                              enum u_logging_level log_level,
+                              struct xrt_device **out_left,
+                              struct xrt_device **out_right);
+
 
 #ifdef __cplusplus
 }
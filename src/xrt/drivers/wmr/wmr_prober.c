@@ -14,6 +14,7 @@
 #include "xrt/xrt_prober.h"
 
 #include "os/os_hid.h"
+#include "os/os_threading.h"
 
 #include "util/u_misc.h"
 #include "util/u_debug.h"
@@ -54,6 +55,98 @@ is_right(const char *product_name, size_t size)
 	return strncmp(product_name, WMR_CONTROLLER_RIGHT_PRODUCT_STRING, size) == 0;
 }
 
+/*!
+ * A Bluetooth controller that has been opened, but not yet brought up.
+ */
+struct bt_controller_job
+{
+	struct os_hid_device *hid;
+	enum xrt_device_type type;
+	uint16_t vid;
+	uint16_t pid;
+	enum u_logging_level log_level;
+
+	//! Set by @ref run_bt_controller_job, NULL on failure.
+	struct xrt_device *xdev;
+};
+
+/*!
+ * Does the prober work for a Bluetooth controller, which has to happen on the
+ * thread that holds the prober list.
+ */
+static xrt_result_t
+open_bt_controller(struct xrt_prober *xp, struct xrt_prober_device *xpdev, struct bt_controller_job *job)
+{
+	enum u_logging_level log_level = job->log_level;
+
+	// Only handle Bluetooth connected controllers here.
+	if (xpdev->bus != XRT_BUS_TYPE_BLUETOOTH) {
+		U_LOG_IFL_E(log_level, "Got a non Bluetooth device!");
+		return XRT_ERROR_DEVICE_CREATION_FAILED;
+	}
+
+	char product_name[256] = {0};
+	int ret = xrt_prober_get_string_descriptor( //
+	    xp,                                     //
+	    xpdev,                                  //
+	    XRT_PROBER_STRING_PRODUCT,              //
+	    (uint8_t *)product_name,                //
+	    sizeof(product_name));                  //
+
+	enum xrt_device_type controller_type = XRT_DEVICE_TYPE_UNKNOWN;
+	const int interface_controller = 0;
+
+	switch (xpdev->product_id) {
+	case WMR_CONTROLLER_PID:
+	case ODYSSEY_CONTROLLER_PID:
+	case REVERB_G2_CONTROLLER_PID:
+		if (is_left(product_name, sizeof(product_name))) {
+			controller_type = XRT_DEVICE_TYPE_LEFT_HAND_CONTROLLER;
+			break;
+		} else if (is_right(product_name, sizeof(product_name))) {
+			controller_type = XRT_DEVICE_TYPE_RIGHT_HAND_CONTROLLER;
+			break;
+		}
+	// else fall through
+	default:
+		U_LOG_IFL_E(log_level,
+		            "Unsupported controller device (Bluetooth): vid: 0x%04X, pid: 0x%04X, Product Name: '%s'",
+		            xpdev->vendor_id, xpdev->product_id, product_name);
+		return XRT_ERROR_DEVICE_CREATION_FAILED;
+	}
+
+	ret = xrt_prober_open_hid_interface(xp, xpdev, interface_controller, &job->hid);
+	if (ret != 0) {
+		U_LOG_IFL_E(log_level, "Failed to open WMR Bluetooth controller's HID interface");
+		return XRT_ERROR_DEVICE_CREATION_FAILED;
+	}
+
+	job->type = controller_type;
+	job->vid = xpdev->vendor_id;
+	job->pid = xpdev->product_id;
+
+	return XRT_SUCCESS;
+}
+
+/*!
+ * Brings up the controller, this talks to it over Bluetooth and is the slow
+ * part, it doesn't touch the prober so it can run on any thread.
+ */
+static void
+run_bt_controller_job(struct bt_controller_job *job)
+{
+	// Takes ownership of the hid device, even on failure
+	job->xdev = wmr_bt_controller_create(job->hid, job->type, job->vid, job->pid, job->log_level);
+	job->hid = NULL;
+}
+
+static void *
+bt_controller_job_func(void *ptr)
+{
+	run_bt_controller_job((struct bt_controller_job *)ptr);
+	return NULL;
+}
+
 static void
 classify_and_assign_controller(struct xrt_prober *xp,
                                struct xrt_prober_device *xpd,
@@ -346,8 +439,17 @@ wmr_create_headset(struct xrt_prober *xp,
 	struct xrt_device *ht = NULL;
 	struct xrt_device *two_hands[2] = {NULL, NULL}; // Must initialize, always returned.
 	struct xrt_device *hmd_left_ctrl = NULL, *hmd_right_ctrl = NULL;
-	wmr_hmd_create(type, hid_holo, hid_companion, xpdev_holo, log_level, &hmd, &ht, &hmd_left_ctrl,
-	               &hmd_right_ctrl);
+
+	// Keys the config cache, not all headsets have one.
+	unsigned char serial[256] = {0};
+	ret = xrt_prober_get_string_descriptor(xp, xpdev_holo, XRT_PROBER_STRING_SERIAL_NUMBER, serial,
+	                                       sizeof(serial) - 1);
+	if (ret <= 0) {
+		serial[0] = '\0';
+	}
+
+	wmr_hmd_create(type, hid_holo, hid_companion, xpdev_holo, (const char *)serial, log_level, &hmd, &ht,
+	               &hmd_left_ctrl, &hmd_right_ctrl);
 
 	if (hmd == NULL) {
 		U_LOG_IFL_E(log_level, "Failed to create WMR HMD device.");
@@ -387,59 +489,80 @@ wmr_create_bt_controller(struct xrt_prober *xp,
 
 	U_LOG_IFL_D(log_level, "Creating Bluetooth controller.");
 
-	struct os_hid_device *hid_controller = NULL;
+	struct bt_controller_job job = {.log_level = log_level};
+	xrt_result_t xret = open_bt_controller(xp, xpdev, &job);
+	if (xret != XRT_SUCCESS) {
+		return xret;
+	}
 
-	// Only handle Bluetooth connected controllers here.
-	if (xpdev->bus != XRT_BUS_TYPE_BLUETOOTH) {
-		U_LOG_IFL_E(log_level, "Got a non Bluetooth device!");
+	run_bt_controller_job(&job);
+	if (job.xdev == NULL) {
+		U_LOG_IFL_E(log_level, "Failed to create WMR controller (Bluetooth)");
 		return XRT_ERROR_DEVICE_CREATION_FAILED;
 	}
 
-	char product_name[256] = {0};
-	int ret = xrt_prober_get_string_descriptor( //
-	    xp,                                     //
-	    xpdev,                                  //
-	    XRT_PROBER_STRING_PRODUCT,              //
-	    (uint8_t *)product_name,                //
-	    sizeof(product_name));                  //
+	*out_xdev = job.xdev;
 
-	enum xrt_device_type controller_type = XRT_DEVICE_TYPE_UNKNOWN;
-	const int interface_controller = 0;
+	return XRT_SUCCESS;
+}
 
-	switch (xpdev->product_id) {
-	case WMR_CONTROLLER_PID:
-	case ODYSSEY_CONTROLLER_PID:
-	case REVERB_G2_CONTROLLER_PID:
-		if (is_left(product_name, sizeof(product_name))) {
-			controller_type = XRT_DEVICE_TYPE_LEFT_HAND_CONTROLLER;
-			break;
-		} else if (is_right(product_name, sizeof(product_name))) {
-			controller_type = XRT_DEVICE_TYPE_RIGHT_HAND_CONTROLLER;
-			break;
-		}
-	// else fall through
-	default:
-		U_LOG_IFL_E(log_level,
-		            "Unsupported controller device (Bluetooth): vid: 0x%04X, pid: 0x%04X, Product Name: '%s'",
-		            xpdev->vendor_id, xpdev->product_id, product_name);
-		return XRT_ERROR_DEVICE_CREATION_FAILED;
+xrt_result_t
+wmr_create_bt_controller_pair(struct xrt_prober *xp,
+                              struct xrt_prober_device *left_xpdev,
+                              struct xrt_prober_device *right_xpdev,
+                              enum u_logging_level log_level,
+                              struct xrt_device **out_left,
+                              struct xrt_device **out_right)
+{
+	DRV_TRACE_MARKER();
+
+	if (left_xpdev == NULL && right_xpdev == NULL) {
+		return XRT_SUCCESS;
+	}
+	if (left_xpdev == NULL) {
+		return wmr_create_bt_controller(xp, right_xpdev, log_level, out_right);
+	}
+	if (right_xpdev == NULL) {
+		return wmr_create_bt_controller(xp, left_xpdev, log_level, out_left);
 	}
 
-	ret = xrt_prober_open_hid_interface(xp, xpdev, interface_controller, &hid_controller);
-	if (ret != 0) {
-		U_LOG_IFL_E(log_level, "Failed to open WMR Bluetooth controller's HID interface");
-		return XRT_ERROR_DEVICE_CREATION_FAILED;
+	U_LOG_IFL_D(log_level, "Creating Bluetooth controller pair.");
+
+	// The prober is only used from this thread, just the slow bring-up runs in parallel.
+	struct bt_controller_job left = {.log_level = log_level};
+	struct bt_controller_job right = {.log_level = log_level};
+	xrt_result_t xret = open_bt_controller(xp, left_xpdev, &left);
+	if (xret != XRT_SUCCESS) {
+		return xret;
+	}
+	xret = open_bt_controller(xp, right_xpdev, &right);
+	if (xret != XRT_SUCCESS) {
+		os_hid_destroy(left.hid);
+		return xret;
 	}
 
-	// Takes ownership of the hid_controller, even on failure
-	struct xrt_device *xdev =
-	    wmr_bt_controller_create(hid_controller, controller_type, xpdev->vendor_id, xpdev->product_id, log_level);
-	if (xdev == NULL) {
-		U_LOG_IFL_E(log_level, "Failed to create WMR controller (Bluetooth)");
+	struct os_thread thread = {0};
+	bool threaded = os_thread_init(&thread) == 0 && os_thread_start(&thread, bt_controller_job_func, &left) == 0;
+	if (!threaded) {
+		run_bt_controller_job(&left);
+	}
+
+	run_bt_controller_job(&right);
+
+	if (threaded) {
+		os_thread_join(&thread);
+	}
+	os_thread_destroy(&thread);
+
+	if (left.xdev == NULL || right.xdev == NULL) {
+		U_LOG_IFL_E(log_level, "Failed to create WMR controller pair (Bluetooth)");
+		xrt_device_destroy(&left.xdev);
+		xrt_device_destroy(&right.xdev);
 		return XRT_ERROR_DEVICE_CREATION_FAILED;
 	}
 
-	*out_xdev = xdev;
+	*out_left = left.xdev;
+	*out_right = right.xdev;
 
 	return XRT_SUCCESS;
 }
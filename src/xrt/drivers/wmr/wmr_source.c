@@ -12,9 +12,10 @@
 #include "wmr_protocol.h"
 
 #include "math/m_api.h"
-#include "math/m_clock_offset.h"
+#include "math/m_clock_domain.h"
 #include "math/m_filter_fifo.h"
 #include "util/u_debug.h"
+#include "util/u_passthrough.h"
 #include "util/u_sink.h"
 #include "util/u_var.h"
 #include "util/u_trace_marker.h"
@@ -75,8 +76,8 @@ struct wmr_source
 	bool is_running;              //!< Whether the device is streaming
 	bool first_imu_received;      //!< Don't send frames until first IMU sample
 	timepoint_ns last_imu_ns;     //!< Last timepoint received.
-	time_duration_ns hw2mono;     //!< Estimated offset from IMU to monotonic clock
-	time_duration_ns cam_hw2mono; //!< Caches hw2mono for use in the full frame bundle
+	struct m_clock_domain *clock; //!< Clock of the headset, estimates the IMU to monotonic offset
+	time_duration_ns cam_hw2mono; //!< Caches the clock offset for use in the full frame bundle
 };
 
 /*
@@ -90,12 +91,15 @@ struct wmr_source
 	{                                                                                                              \
 		struct wmr_source *ws = container_of(sink, struct wmr_source, cam_sinks[cam_id]);                      \
 		if (cam_id == 0) {                                                                                     \
-			ws->cam_hw2mono = ws->hw2mono;                                                                 \
+			ws->cam_hw2mono = m_clock_domain_get_offset(ws->clock);                                        \
 		}                                                                                                      \
 		xf->timestamp += ws->cam_hw2mono;                                                                      \
 		WMR_TRACE(ws, "cam" #cam_id " img t=%" PRId64 " source_t=%" PRId64, xf->timestamp,                     \
 		          xf->source_timestamp);                                                                       \
 		u_sink_debug_push_frame(&ws->ui_cam_sinks[cam_id], xf);                                                \
+		if (cam_id < 2) {                                                                                      \
+			u_passthrough_push_frame(cam_id, xf); /* Front facing cameras. */                              \
+		}                                                                                                      \
 		if (ws->out_sinks.cams[cam_id] && ws->first_imu_received) {                                            \
 			xrt_sink_push_frame(ws->out_sinks.cams[cam_id], xf);                                           \
 		}                                                                                                      \
@@ -119,12 +123,11 @@ receive_imu_sample(struct xrt_imu_sink *sink, struct xrt_imu_sample *s)
 {
 	struct wmr_source *ws = container_of(sink, struct wmr_source, imu_sink);
 
-	// Convert hardware timestamp into monotonic clock. Update offset estimate hw2mono.
+	// Convert hardware timestamp into monotonic clock. Update the offset estimate of the clock.
 	// Note this is only done with IMU samples as they have the smallest USB transmission time.
-	const float IMU_FREQ = 250.f; //!< @todo use 1000 if "average_imus" is false
 	timepoint_ns now_hw = s->timestamp_ns;
 	timepoint_ns now_mono = (timepoint_ns)os_monotonic_get_ns();
-	timepoint_ns ts = m_clock_offset_a2b(IMU_FREQ, now_hw, now_mono, &ws->hw2mono);
+	timepoint_ns ts = m_clock_domain_update(ws->clock, now_hw, now_mono);
 
 	/*
 	 * Check if the timepoint does time travel, we get one or two
@@ -283,6 +286,7 @@ wmr_source_node_destroy(struct xrt_frame_node *node)
 	if (ws->camera != NULL) { // It could be null if XRT_HAVE_LIBUSB is not defined
 		wmr_camera_free(ws->camera);
 	}
+	m_clock_domain_release(&ws->clock);
 	free(ws);
 }
 
@@ -295,13 +299,21 @@ wmr_source_node_destroy(struct xrt_frame_node *node)
 
 //! Create and open the frame server for IMU/camera streaming.
 struct xrt_fs *
-wmr_source_create(struct xrt_frame_context *xfctx, struct xrt_prober_device *dev_holo, struct wmr_hmd_config cfg)
+wmr_source_create(struct xrt_frame_context *xfctx,
+                  struct xrt_prober_device *dev_holo,
+                  const char *serial,
+                  struct wmr_hmd_config cfg)
 {
 	DRV_TRACE_MARKER();
 
 	struct wmr_source *ws = U_TYPED_CALLOC(struct wmr_source);
 	ws->log_level = debug_get_log_option_wmr_log();
 
+	// Shared with anything else that gets timestamps from this headset.
+	char clock_name[64];
+	(void)snprintf(clock_name, sizeof(clock_name), "wmr_%s", serial != NULL ? serial : "");
+	m_clock_domain_get(clock_name, 250.f, &ws->clock); //!< @todo use 1000 if "average_imus" is false
+
 	// Setup xrt_fs
 	struct xrt_fs *xfs = &ws->xfs;
 	xfs->enumerate_modes = wmr_source_enumerate_modes;
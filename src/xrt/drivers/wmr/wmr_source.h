@@ -26,9 +26,15 @@
 extern "C" {
 #endif
 
-//! Create and return the data source as a @ref xrt_fs ready for data streaming.
+/*!
+ * Create and return the data source as a @ref xrt_fs ready for data streaming.
+ * The @p serial names the clock domain of the headset, see @ref m_clock_domain.
+ */
 struct xrt_fs *
-wmr_source_create(struct xrt_frame_context *xfctx, struct xrt_prober_device *dev_holo, struct wmr_hmd_config cfg);
+wmr_source_create(struct xrt_frame_context *xfctx,
+                  struct xrt_prober_device *dev_holo,
+                  const char *serial,
+                  struct wmr_hmd_config cfg);
 
 //! @todo IMU data should be generated from within the data source, but right
 //! now we need this function because it is being generated from wmr_hmd
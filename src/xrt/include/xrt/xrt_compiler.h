@@ -81,6 +81,18 @@
 #endif
 
 
+/*
+ * Alignment of a struct member, put it in front of the type.
+ */
+#if defined(__cplusplus)
+#define XRT_ALIGNAS(N) alignas(N)
+#elif defined(_MSC_VER)
+#define XRT_ALIGNAS(N) __declspec(align(N))
+#else
+#define XRT_ALIGNAS(N) _Alignas(N)
+#endif
+
+
 #ifdef XRT_DOXYGEN
 /*!
  * To trigger a trap/break in the debugger.
@@ -134,6 +146,22 @@ xrt_atomic_s32_cmpxchg(xrt_atomic_s32_t *p, int32_t old_, int32_t new_)
 #endif
 }
 
+/*!
+ * Full memory barrier, orders all loads and stores around it, also against
+ * other processes sharing the same memory.
+ */
+static inline void
+xrt_atomic_thread_fence(void)
+{
+#if defined(__GNUC__)
+	__sync_synchronize();
+#elif defined(_MSC_VER)
+	MemoryBarrier();
+#else
+#error "compiler not supported"
+#endif
+}
+
 #ifdef _MSC_VER
 typedef intptr_t ssize_t;
 #define _SSIZE_T_
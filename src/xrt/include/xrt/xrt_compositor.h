@@ -346,6 +346,57 @@ struct xrt_layer_frame_data
 	enum xrt_blend_mode env_blend_mode;
 };
 
+/*!
+ * Measured timings of the frames of a session and of the compositor, filtered
+ * over the last few frames, see @ref xrt_compositor::get_frame_stats.
+ */
+struct xrt_compositor_frame_stats
+{
+	//! CPU time of the app, from waking up until the frame was committed.
+	uint64_t app_cpu_time_ns;
+
+	//! GPU time of the app, from the frame being committed until its GPU work completed.
+	uint64_t app_gpu_time_ns;
+
+	//! Time from the app waking up until the frame is to be displayed.
+	uint64_t app_latency_ns;
+
+	//! Frames committed or discarded since the session was created.
+	uint64_t app_frame_count;
+
+	//! Of @ref app_frame_count, frames discarded or completed too late.
+	uint64_t app_missed_frame_count;
+
+	//! Predicted GPU time of the compositor's own rendering.
+	uint64_t compositor_gpu_time_ns;
+
+	//! Display period the compositor is running at.
+	uint64_t display_period_ns;
+
+	//! The session is paced at every this many display periods.
+	uint32_t rate_divisor;
+
+	/*!
+	 * Scale of the recommended view size the session should render at to
+	 * keep its frame rate, from the GPU headroom left over by the
+	 * compositor, 1.0 when there is enough headroom.
+	 */
+	float recommended_render_scale;
+};
+
+/*!
+ * GPU memory of the compositor's device, see
+ * @ref xrt_compositor::get_memory_budget.
+ */
+struct xrt_compositor_memory_budget
+{
+	//! How much device local memory can be used before the driver starts evicting.
+	uint64_t budget_bytes;
+
+	//! How much device local memory is in use, including swapchain images of all sessions.
+	uint64_t usage_bytes;
+};
+
 
 /*
  *
@@ -456,6 +507,29 @@ struct xrt_swapchain
 	 */
 	xrt_result_t (*wait_image)(struct xrt_swapchain *xsc, uint64_t timeout_ns, uint32_t index);
 
+	/*!
+	 * Optional, may be NULL. Get the timeline semaphore that the compositor
+	 * signals as it finishes reading images of this swapchain, so the
+	 * application can wait for images on the GPU instead of in
+	 * @ref wait_image. The handle is owned by the swapchain, dup it to keep
+	 * it, just like the one from @ref xrt_comp_create_semaphore.
+	 *
+	 * @param xsc             Self pointer
+	 * @param[out] out_handle Native handle of the timeline semaphore.
+	 */
+	xrt_result_t (*get_release_semaphore)(struct xrt_swapchain *xsc, xrt_graphics_sync_handle_t *out_handle);
+
+	/*!
+	 * Optional, set if @ref get_release_semaphore is. Doesn't block, gets
+	 * the value the release semaphore reaches once the compositor is done
+	 * reading image @p index, waiting for it replaces @ref wait_image.
+	 *
+	 * @param xsc            Self pointer
+	 * @param index          Image index to wait for.
+	 * @param[out] out_value Value to wait for, zero if the image has never been read.
+	 */
+	xrt_result_t (*get_release_value)(struct xrt_swapchain *xsc, uint32_t index, uint64_t *out_value);
+
 	/*!
 	 * Do any barrier transitions to and from the application.
 	 *
@@ -556,6 +630,32 @@ xrt_swapchain_wait_image(struct xrt_swapchain *xsc, uint64_t timeout_ns, uint32_
 	return xsc->wait_image(xsc, timeout_ns, index);
 }
 
+/*!
+ * @copydoc xrt_swapchain::get_release_semaphore
+ *
+ * Helper for calling through the function pointer.
+ *
+ * @public @memberof xrt_swapchain
+ */
+static inline xrt_result_t
+xrt_swapchain_get_release_semaphore(struct xrt_swapchain *xsc, xrt_graphics_sync_handle_t *out_handle)
+{
+	return xsc->get_release_semaphore(xsc, out_handle);
+}
+
+/*!
+ * @copydoc xrt_swapchain::get_release_value
+ *
+ * Helper for calling through the function pointer.
+ *
+ * @public @memberof xrt_swapchain
+ */
+static inline xrt_result_t
+xrt_swapchain_get_release_value(struct xrt_swapchain *xsc, uint32_t index, uint64_t *out_value)
+{
+	return xsc->get_release_value(xsc, index, out_value);
+}
+
 /*!
  * @copydoc xrt_swapchain::barrier_image
  *
@@ -1080,6 +1180,22 @@ struct xrt_compositor
 	 */
 	xrt_result_t (*layer_begin)(struct xrt_compositor *xc, const struct xrt_layer_frame_data *data);
 
+	/*!
+	 * @brief Get storage for the data of the next layer, optional.
+	 *
+	 * The returned memory is owned by the compositor, for instance the
+	 * IPC client hands out the entry in the shared memory slot. If it is
+	 * filled in and passed as the @p data argument of the next `layer_*`
+	 * call the compositor uses it in place instead of copying it. Valid
+	 * until that call, or until xrt_compositor::layer_commit.
+	 *
+	 * Returns NULL if not implemented or there is no room left, the caller
+	 * then uses its own storage.
+	 *
+	 * @param xc          Self pointer
+	 */
+	struct xrt_layer_data *(*layer_reserve)(struct xrt_compositor *xc);
+
 	/*!
 	 * @brief Adds a stereo projection layer for submissions.
 	 *
@@ -1228,6 +1344,32 @@ struct xrt_compositor
 
 	/*! @} */
 
+	/*!
+	 * Get the measured timings of the frames of this session and of the
+	 * compositor, so that the app can adapt its rendering to them. Can be
+	 * called from any thread.
+	 *
+	 * Optional, @ref XRT_ERROR_COMPOSITOR_FUNCTION_NOT_IMPLEMENTED if not
+	 * implemented.
+	 *
+	 * @param xc             Self pointer
+	 * @param[out] out_stats Measured timings.
+	 */
+	xrt_result_t (*get_frame_stats)(struct xrt_compositor *xc, struct xrt_compositor_frame_stats *out_stats);
+
+	/*!
+	 * Get the memory budget of the device the compositor allocates the
+	 * swapchain images on, so that allocations can be refused before the
+	 * driver starts evicting memory. Can be called from any thread.
+	 *
+	 * Optional, @ref XRT_ERROR_COMPOSITOR_FUNCTION_NOT_IMPLEMENTED if not
+	 * implemented or the device can't tell.
+	 *
+	 * @param xc              Self pointer
+	 * @param[out] out_budget Budget and current usage.
+	 */
+	xrt_result_t (*get_memory_budget)(struct xrt_compositor *xc, struct xrt_compositor_memory_budget *out_budget);
+
 	/*!
 	 * Teardown the compositor.
 	 *
@@ -1482,6 +1624,24 @@ xrt_comp_layer_begin(struct xrt_compositor *xc, const struct xrt_layer_frame_dat
 	return xc->layer_begin(xc, data);
 }
 
+/*!
+ * @copydoc xrt_compositor::layer_reserve
+ *
+ * Helper for calling through the function pointer, returns NULL if the
+ * compositor does not implement it.
+ *
+ * @public @memberof xrt_compositor
+ */
+static inline struct xrt_layer_data *
+xrt_comp_layer_reserve(struct xrt_compositor *xc)
+{
+	if (xc->layer_reserve == NULL) {
+		return NULL;
+	}
+
+	return xc->layer_reserve(xc);
+}
+
 /*!
  * @copydoc xrt_compositor::layer_stereo_projection
  *
@@ -1627,6 +1787,44 @@ xrt_comp_layer_commit_with_semaphore(struct xrt_compositor *xc, struct xrt_compo
 
 /*! @} */
 
+/*!
+ * @copydoc xrt_compositor::get_frame_stats
+ *
+ * Helper for calling through the function pointer, returns
+ * @ref XRT_ERROR_COMPOSITOR_FUNCTION_NOT_IMPLEMENTED if the compositor does not
+ * implement it.
+ *
+ * @public @memberof xrt_compositor
+ */
+static inline xrt_result_t
+xrt_comp_get_frame_stats(struct xrt_compositor *xc, struct xrt_compositor_frame_stats *out_stats)
+{
+	if (xc->get_frame_stats == NULL) {
+		return XRT_ERROR_COMPOSITOR_FUNCTION_NOT_IMPLEMENTED;
+	}
+
+	return xc->get_frame_stats(xc, out_stats);
+}
+
+/*!
+ * @copydoc xrt_compositor::get_memory_budget
+ *
+ * Helper for calling through the function pointer, returns
+ * @ref XRT_ERROR_COMPOSITOR_FUNCTION_NOT_IMPLEMENTED if the compositor does not
+ * implement it.
+ *
+ * @public @memberof xrt_compositor
+ */
+static inline xrt_result_t
+xrt_comp_get_memory_budget(struct xrt_compositor *xc, struct xrt_compositor_memory_budget *out_budget)
+{
+	if (xc->get_memory_budget == NULL) {
+		return XRT_ERROR_COMPOSITOR_FUNCTION_NOT_IMPLEMENTED;
+	}
+
+	return xc->get_memory_budget(xc, out_budget);
+}
+
 /*!
  * @copydoc xrt_compositor::destroy
  *
@@ -2076,6 +2274,15 @@ struct xrt_multi_compositor_control
 	 */
 	xrt_result_t (*set_z_order)(struct xrt_system_compositor *xsc, struct xrt_compositor *xc, int64_t z_order);
 
+	/*!
+	 * Limit the rate the client is paced at to every @p rate_divisor
+	 * display period, one (or zero) is the full display rate. The
+	 * compositor may lower the rate further if the GPU is over budget.
+	 */
+	xrt_result_t (*set_rate_divisor)(struct xrt_system_compositor *xsc,
+	                                 struct xrt_compositor *xc,
+	                                 uint32_t rate_divisor);
+
 	/*!
 	 * Tell this client/session if the main application is visible or not.
 	 */
@@ -2186,6 +2393,26 @@ xrt_syscomp_set_z_order(struct xrt_system_compositor *xsc, struct xrt_compositor
 	return xsc->xmcc->set_z_order(xsc, xc, z_order);
 }
 
+/*!
+ * @copydoc xrt_multi_compositor_control::set_rate_divisor
+ *
+ * Helper for calling through the function pointer.
+ *
+ * If the system compositor @p xsc does not implement @ref xrt_multi_composition_control,
+ * this returns @ref XRT_ERROR_MULTI_SESSION_NOT_IMPLEMENTED.
+ *
+ * @public @memberof xrt_system_compositor
+ */
+static inline xrt_result_t
+xrt_syscomp_set_rate_divisor(struct xrt_system_compositor *xsc, struct xrt_compositor *xc, uint32_t rate_divisor)
+{
+	if (xsc->xmcc == NULL) {
+		return XRT_ERROR_MULTI_SESSION_NOT_IMPLEMENTED;
+	}
+
+	return xsc->xmcc->set_rate_divisor(xsc, xc, rate_divisor);
+}
+
 
 /*!
  * @copydoc xrt_multi_compositor_control::set_main_app_visibility
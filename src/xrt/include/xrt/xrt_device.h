@@ -77,6 +77,100 @@ struct xrt_view
 	struct xrt_matrix_2x2 rot;
 };
 
+/*!
+ * One view of an ellipsoidal reflector optical model, like the North Star
+ * 3D one: a ray from the eye bounces off the inside of an ellipsoid onto a
+ * flat screen. Matrices are column major like the rest of Monado and are
+ * applied to column vectors.
+ *
+ * @ingroup xrt_iface
+ */
+struct xrt_distortion_ellipsoid
+{
+	//! Position of the eye in world space.
+	struct xrt_vec3 eye_position;
+
+	//! A point on the screen plane and its normal, in world space.
+	struct xrt_vec3 screen_position;
+	struct xrt_vec3 screen_forward;
+
+	//! Axes of the ellipsoid, the minor one is used for x and y.
+	float minor_axis;
+	float major_axis;
+
+	//! From clip space of the render to world space, does a perspective divide.
+	struct xrt_matrix_4x4 clip_to_world;
+
+	//! From world space to where the ellipsoid is a sphere of radius 0.5 and back.
+	struct xrt_matrix_4x4 world_to_sphere;
+	struct xrt_matrix_4x4 sphere_to_world;
+
+	//! From world space to screen space, screen uv are x and y offset by 0.5.
+	struct xrt_matrix_4x4 world_to_screen;
+};
+
+/*!
+ * Distortion models simple enough for the compositor to evaluate per pixel
+ * in its shaders, see @ref xrt_distortion_analytic_view.
+ *
+ * @ingroup xrt_iface
+ */
+enum xrt_distortion_analytic_model
+{
+	//! No analytic description, only @ref xrt_device::compute_distortion.
+	XRT_DISTORTION_ANALYTIC_MODEL_NONE = 0,
+	//! No distortion, all channels get the same uv.
+	XRT_DISTORTION_ANALYTIC_MODEL_IDENTITY = 1,
+	//! Panotools universal distortion with per channel scales.
+	XRT_DISTORTION_ANALYTIC_MODEL_PANOTOOLS = 2,
+	//! The polynomial of the Vive, Vive Pro and Index configs.
+	XRT_DISTORTION_ANALYTIC_MODEL_VIVE = 3,
+};
+
+/*!
+ * Parameters of one view for @ref XRT_DISTORTION_ANALYTIC_MODEL_PANOTOOLS,
+ * the same as the ones of `u_compute_distortion_panotools`.
+ *
+ * @ingroup xrt_iface
+ */
+struct xrt_distortion_panotools
+{
+	float distortion_k[5];
+	//! Post distortion scale, r/g/b.
+	float aberration_k[3];
+	float scale;
+	struct xrt_vec2 lens_center;
+	struct xrt_vec2 viewport_size;
+};
+
+/*!
+ * Parameters of one view for @ref XRT_DISTORTION_ANALYTIC_MODEL_VIVE, the
+ * same as the ones of `u_compute_distortion_vive`.
+ *
+ * @ingroup xrt_iface
+ */
+struct xrt_distortion_vive
+{
+	float aspect_x_over_y;
+	float grow_for_undistort;
+
+	//! r/g/b
+	struct xrt_vec2 center[3];
+
+	//! r/g/b, a/b/c/d
+	float coefficients[3][4];
+};
+
+/*!
+ * Parameters of one view of an analytic distortion model.
+ *
+ * @ingroup xrt_iface
+ */
+union xrt_distortion_analytic_view {
+	struct xrt_distortion_panotools panotools;
+	struct xrt_distortion_vive vive;
+};
+
 /*!
  * All of the device components that deals with interfacing to a users head.
  *
@@ -144,9 +238,64 @@ struct xrt_hmd_parts
 			uint32_t index_count_total;
 		} mesh;
 
+		/*!
+		 * All colour channels are distorted the same, so there is no
+		 * chromatic aberration to correct and the compositor can sample
+		 * the source once per pixel instead of once per channel. Set
+		 * when the mesh is generated from
+		 * @ref xrt_device::compute_distortion.
+		 */
+		bool single_channel;
+
 		//! distortion is subject to the field of view
 		struct xrt_fov fov[2];
+
+		/*!
+		 * Optional description of the optics that the compositor can
+		 * evaluate on the GPU, instead of calling
+		 * @ref xrt_device::compute_distortion for every texel. Must
+		 * give the same results as that function, only used if
+		 * @p valid is set. Bump @p generation when the values change,
+		 * like after adjusting the eye positions, and the compositor
+		 * regenerates its distortion.
+		 */
+		struct
+		{
+			bool valid;
+			uint32_t generation;
+			struct xrt_distortion_ellipsoid views[2];
+		} ellipsoid;
+
+		/*!
+		 * Optional analytic description of
+		 * @ref xrt_device::compute_distortion, the compute compositor
+		 * then evaluates it per pixel instead of sampling distortion
+		 * images. Must give the same results as that function, drivers
+		 * that replace the function must reset @p model.
+		 */
+		struct
+		{
+			enum xrt_distortion_analytic_model model;
+			union xrt_distortion_analytic_view views[2];
+		} analytic;
 	} distortion;
+
+	/*!
+	 * Fixed foveation of the compute compositor, the periphery of the
+	 * views is composited and distorted at a reduced rate. Disabled if
+	 * @p outer_radius is zero, which it is unless a driver sets it.
+	 */
+	struct
+	{
+		//! Centre of the full rate region per view, in view uv [0 .. 1].
+		struct xrt_vec2 centers[2];
+
+		//! Radius in view uv of the full rate region.
+		float inner_radius;
+
+		//! Radius in view uv of the half rate region, outside it is a quarter rate.
+		float outer_radius;
+	} foveation;
 };
 
 /*!
@@ -396,6 +545,24 @@ struct xrt_device
 	bool (*compute_distortion)(
 	    struct xrt_device *xdev, uint32_t view, float u, float v, struct xrt_uv_triplet *out_result);
 
+	/*!
+	 * Compute the distortion at a number of points of the same view, the
+	 * result is the same as calling @ref compute_distortion for each of
+	 * them, but implementations can do it much more efficiently, for
+	 * instance over IPC this is a single round trip. Optional, may be NULL.
+	 *
+	 * @param xdev             the device
+	 * @param view             the view index
+	 * @param count            number of points
+	 * @param uvs              array of @p count u,v texture coordinates
+	 * @param[out] out_results array of @p count u,v pairs for all three color channels.
+	 */
+	bool (*compute_distortion_batch)(struct xrt_device *xdev,
+	                                 uint32_t view,
+	                                 uint32_t count,
+	                                 const struct xrt_vec2 *uvs,
+	                                 struct xrt_uv_triplet *out_results);
+
 	/*!
 	 * Destroy device.
 	 */
@@ -506,6 +673,35 @@ xrt_device_compute_distortion(
 	return xdev->compute_distortion(xdev, view, u, v, out_result);
 }
 
+/*!
+ * Helper function for @ref xrt_device::compute_distortion_batch, falls back to
+ * calling @ref xrt_device::compute_distortion for each point if not
+ * implemented.
+ *
+ * @copydoc xrt_device::compute_distortion_batch
+ *
+ * @public @memberof xrt_device
+ */
+static inline bool
+xrt_device_compute_distortion_batch(struct xrt_device *xdev,
+                                    uint32_t view,
+                                    uint32_t count,
+                                    const struct xrt_vec2 *uvs,
+                                    struct xrt_uv_triplet *out_results)
+{
+	if (xdev->compute_distortion_batch != NULL) {
+		return xdev->compute_distortion_batch(xdev, view, count, uvs, out_results);
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		if (!xdev->compute_distortion(xdev, view, uvs[i].x, uvs[i].y, &out_results[i])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
 /*!
  * Helper function for @ref xrt_device::destroy.
  *
@@ -10,6 +10,7 @@
 #pragma once
 
 #include "xrt/xrt_defines.h"
+#include "xrt/xrt_handles.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -40,6 +41,25 @@ struct xrt_frame
 	uint64_t source_timestamp;
 	uint64_t source_sequence; //!< sequence id
 	uint64_t source_id;       //!< Which @ref xrt_fs this frame originated from.
+
+	/*!
+	 * Optional native buffer that @ref data lives in, like a DMA-BUF
+	 * exported by a camera driver, so GPU consumers can import the frame
+	 * without a copy. Only valid if @ref has_buffer_handle is set. Still
+	 * owned by the producer, importers must duplicate it and not use it
+	 * after releasing their reference to the frame.
+	 */
+	xrt_graphics_buffer_handle_t buffer_handle;
+	size_t buffer_offset; //!< Offset in bytes of @ref data in @ref buffer_handle.
+	bool has_buffer_handle;
+
+	/*!
+	 * Optional references to the left and right frames a stereo frame was
+	 * made from, consumers that want the views separately can use these
+	 * instead of splitting @ref data. Owned by the frame and released with
+	 * it, see @ref u_frame_create_stereo_pair.
+	 */
+	struct xrt_frame *views[2];
 };
 
 
@@ -169,6 +169,28 @@ struct xrt_prober
 	 */
 	xrt_result_t (*unlock_list)(struct xrt_prober *xp, struct xrt_prober_device ***devices);
 
+	/*!
+	 * Optional, checks without blocking if devices have been plugged in or
+	 * removed since the last call. If so the list of devices is updated
+	 * and only the newly arrived devices are opened, by the prober entries
+	 * matching them, devices that were already there are left alone. Like
+	 * @ref xrt_prober::probe it cannot be called with the list locked.
+	 *
+	 * No HMDs are returned, the system already has one.
+	 *
+	 * @param[in]  xp             Prober self parameter.
+	 * @param[out] out_xdevs      Array of @p xdev_capacity to return the opened devices in, ownership is
+	 *                            transferred to the caller.
+	 * @param[in]  xdev_capacity  Capacity of @p out_xdevs.
+	 * @param[out] out_xdev_count Number of devices opened, zero if nothing changed.
+	 *
+	 * @note Code consuming this interface should use xrt_prober_poll_hotplug()
+	 */
+	xrt_result_t (*poll_hotplug)(struct xrt_prober *xp,
+	                             struct xrt_device **out_xdevs,
+	                             uint32_t xdev_capacity,
+	                             uint32_t *out_xdev_count);
+
 	/*!
 	 * Dump a listing of all devices found on the system to platform
 	 * dependent output (stdout).
@@ -347,6 +369,28 @@ xrt_prober_unlock_list(struct xrt_prober *xp, struct xrt_prober_device ***device
 	return xp->unlock_list(xp, devices);
 }
 
+/*!
+ * @copydoc xrt_prober::poll_hotplug
+ *
+ * Helper function for @ref xrt_prober::poll_hotplug, returns no devices if the
+ * prober doesn't support hotplug.
+ *
+ * @public @memberof xrt_prober
+ */
+static inline xrt_result_t
+xrt_prober_poll_hotplug(struct xrt_prober *xp,
+                        struct xrt_device **out_xdevs,
+                        uint32_t xdev_capacity,
+                        uint32_t *out_xdev_count)
+{
+	if (xp->poll_hotplug == NULL) {
+		*out_xdev_count = 0;
+		return XRT_SUCCESS;
+	}
+
+	return xp->poll_hotplug(xp, out_xdevs, xdev_capacity, out_xdev_count);
+}
+
 /*!
  * @copydoc xrt_prober::dump
  *
@@ -158,4 +158,8 @@ typedef enum xrt_result
 	 * Some D3D12 error
 	 */
 	XRT_ERROR_D3D12 = -25,
+	/*!
+	 * The compositor does not implement this optional function.
+	 */
+	XRT_ERROR_COMPOSITOR_FUNCTION_NOT_IMPLEMENTED = -26,
 } xrt_result_t;
@@ -158,6 +158,30 @@ struct xrt_space_overseer
 	                             const struct xrt_pose *offset,
 	                             struct xrt_space_relation *out_relation);
 
+	/*!
+	 * Locate a number of spaces in the same base space at the same time,
+	 * the result is the same as calling @ref locate_space for each of
+	 * them, but implementations can do it much more efficiently, for
+	 * instance over IPC this is a single round trip.
+	 *
+	 * @param[in] xso             Owning space overseer.
+	 * @param[in] base_space      The space that we want the poses in.
+	 * @param[in] base_offset     Offset if any to the base space.
+	 * @param[in] at_timestamp_ns At which time.
+	 * @param[in] spaces          Array of spaces to be located.
+	 * @param[in] space_count     Number of spaces.
+	 * @param[in] offsets         Array of offsets for each located space, may be NULL for no offsets.
+	 * @param[out] out_relations  Array of resulting poses, one per space.
+	 */
+	xrt_result_t (*locate_spaces)(struct xrt_space_overseer *xso,
+	                              struct xrt_space *base_space,
+	                              const struct xrt_pose *base_offset,
+	                              uint64_t at_timestamp_ns,
+	                              struct xrt_space **spaces,
+	                              uint32_t space_count,
+	                              const struct xrt_pose *offsets,
+	                              struct xrt_space_relation *out_relations);
+
 	/*!
 	 * Locate a the origin of the tracking space of a device, this is not
 	 * the same as the device position. In other words, what is the position
@@ -181,6 +205,15 @@ struct xrt_space_overseer
 	                              struct xrt_device *xdev,
 	                              struct xrt_space_relation *out_relation);
 
+	/*!
+	 * Optional, attach a device created after the space overseer, like
+	 * one that was hotplugged, to the space of its tracking origin.
+	 *
+	 * @param[in] xso  Owning space overseer.
+	 * @param[in] xdev Device to add, must outlive the space overseer.
+	 */
+	xrt_result_t (*add_device)(struct xrt_space_overseer *xso, struct xrt_device *xdev);
+
 	/*!
 	 * Destroy function.
 	 *
@@ -240,6 +273,42 @@ xrt_space_overseer_locate_space(struct xrt_space_overseer *xso,
 	return xso->locate_space(xso, base_space, base_offset, at_timestamp_ns, space, offset, out_relation);
 }
 
+/*!
+ * @copydoc xrt_space_overseer::locate_spaces
+ *
+ * Helper for calling through the function pointer, falls back to calling
+ * @ref xrt_space_overseer::locate_space for each space if not implemented.
+ *
+ * @public @memberof xrt_space_overseer
+ */
+static inline xrt_result_t
+xrt_space_overseer_locate_spaces(struct xrt_space_overseer *xso,
+                                 struct xrt_space *base_space,
+                                 const struct xrt_pose *base_offset,
+                                 uint64_t at_timestamp_ns,
+                                 struct xrt_space **spaces,
+                                 uint32_t space_count,
+                                 const struct xrt_pose *offsets,
+                                 struct xrt_space_relation *out_relations)
+{
+	if (xso->locate_spaces != NULL) {
+		return xso->locate_spaces(xso, base_space, base_offset, at_timestamp_ns, spaces, space_count, offsets,
+		                          out_relations);
+	}
+
+	const struct xrt_pose identity = XRT_POSE_IDENTITY;
+	for (uint32_t i = 0; i < space_count; i++) {
+		const struct xrt_pose *offset = offsets != NULL ? &offsets[i] : &identity;
+		xrt_result_t xret = xso->locate_space(xso, base_space, base_offset, at_timestamp_ns, spaces[i], offset,
+		                                      &out_relations[i]);
+		if (xret != XRT_SUCCESS) {
+			return xret;
+		}
+	}
+
+	return XRT_SUCCESS;
+}
+
 /*!
  * @copydoc xrt_space_overseer::locate_device
  *
@@ -258,6 +327,24 @@ xrt_space_overseer_locate_device(struct xrt_space_overseer *xso,
 	return xso->locate_device(xso, base_space, base_offset, at_timestamp_ns, xdev, out_relation);
 }
 
+/*!
+ * @copydoc xrt_space_overseer::add_device
+ *
+ * Helper for calling through the function pointer, fails if the space overseer
+ * can't have devices added.
+ *
+ * @public @memberof xrt_space_overseer
+ */
+static inline xrt_result_t
+xrt_space_overseer_add_device(struct xrt_space_overseer *xso, struct xrt_device *xdev)
+{
+	if (xso->add_device == NULL) {
+		return XRT_ERROR_DEVICE_CREATION_FAILED;
+	}
+
+	return xso->add_device(xso, xdev);
+}
+
 /*!
  * Helper for calling through the function pointer: does a null check and sets
  * xc_ptr to null if freed.
@@ -11,6 +11,7 @@
 
 #include "xrt/xrt_compiler.h"
 #include "xrt/xrt_defines.h"
+#include "xrt/xrt_results.h"
 
 
 #define XRT_SYSTEM_MAX_DEVICES (32)
@@ -41,6 +42,16 @@ struct xrt_system_devices
 	} roles;
 
 
+	/*!
+	 * Optional, update the inputs of all devices at once. Implementations
+	 * where each @ref xrt_device::update_inputs call is expensive, like
+	 * out of process, can batch the updates here. If NULL the caller has to
+	 * update each device on its own.
+	 *
+	 * Code consuming this interface should use xrt_system_devices_update_inputs.
+	 */
+	xrt_result_t (*update_inputs)(struct xrt_system_devices *xsysd);
+
 	/*!
 	 * Destroy all the devices that are owned by this system devices.
 	 *
@@ -50,6 +61,21 @@ struct xrt_system_devices
 };
 
 
+/*!
+ * @copydoc xrt_system_devices::update_inputs
+ *
+ * Helper for calling through the function pointer, the caller must check
+ * that it's not NULL.
+ *
+ * @public @memberof xrt_system_devices
+ */
+static inline xrt_result_t
+xrt_system_devices_update_inputs(struct xrt_system_devices *xsysd)
+{
+	return xsysd->update_inputs(xsysd);
+}
+
+
 /*!
  * Destroy an xrt_system_devices and owned devices - helper function.
  *
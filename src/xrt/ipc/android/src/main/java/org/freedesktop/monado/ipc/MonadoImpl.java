@@ -89,6 +89,11 @@ public class MonadoImpl extends IMonado.Stub {
         nativeShutdownServer();
     }
 
+    public void trimMemory(int level) {
+        Log.i(TAG, "trimMemory: " + level);
+        nativeTrimMemory(level);
+    }
+
     /**
      * Native method that starts server.
      *
@@ -135,4 +140,15 @@ public class MonadoImpl extends IMonado.Stub {
      */
     @SuppressWarnings("JavaJniMissingFunction")
     private native int nativeShutdownServer();
+
+    /**
+     * Native handling of memory pressure: frees some or all of the pooled graphics buffers.
+     *
+     * <p>Ignore warnings that this function is missing: it is not, it is just in a different
+     * module. See `src/xrt/targets/service-lib/service_target.cpp` for the implementation.
+     *
+     * @param level The level passed to onTrimMemory.
+     */
+    @SuppressWarnings("JavaJniMissingFunction")
+    private native void nativeTrimMemory(int level);
 }
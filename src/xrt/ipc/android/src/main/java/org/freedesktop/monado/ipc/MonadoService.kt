@@ -59,6 +59,13 @@ class MonadoService : Service(), Watchdog.ShutdownListener {
         watchdog.stopMonitor()
     }
 
+    override fun onTrimMemory(level: Int) {
+        super.onTrimMemory(level)
+        Log.d(TAG, "onTrimMemory $level")
+
+        binder.trimMemory(level)
+    }
+
     override fun onStartCommand(intent: Intent?, flags: Int, startId: Int): Int {
         Log.d(TAG, "onStartCommand")
         // if this isn't a restart
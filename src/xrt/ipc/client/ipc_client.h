@@ -55,6 +55,19 @@ struct ipc_connection
 
 	struct os_mutex mutex;
 
+	/*!
+	 * One-way messages waiting to be sent together with the next call,
+	 * protected by @ref mutex.
+	 */
+	struct
+	{
+		uint8_t data[IPC_BUF_SIZE];
+		uint32_t size;
+	} queued;
+
+	//! Command channel in shared memory, NULL if not enabled.
+	struct ipc_shared_channel *channel;
+
 #ifdef XRT_OS_ANDROID
 	struct ipc_client_android *ica;
 #endif // XRT_OS_ANDROID
@@ -75,6 +88,9 @@ struct ipc_client_xdev
 	struct ipc_connection *ipc_c;
 
 	uint32_t device_id;
+
+	//! The device reports joint velocities, get full hand joint sets instead of compact ones.
+	bool hand_tracking_full;
 };
 
 
@@ -110,6 +126,46 @@ ipc_client_create_system_compositor(struct ipc_connection *ipc_c,
                                     struct xrt_device *xdev,
                                     struct xrt_system_compositor **out_xcs);
 
+/*!
+ * Send a message to the service, along with any queued one-way messages in
+ * the same system call. Must be called with @ref ipc_connection::mutex held.
+ *
+ * @ingroup ipc_client
+ */
+xrt_result_t
+ipc_client_send_locked(struct ipc_connection *ipc_c, const void *data, size_t size);
+
+/*!
+ * Queue a one-way message, it is sent with the next call or when the queue is
+ * full. Must be called with @ref ipc_connection::mutex held.
+ *
+ * @ingroup ipc_client
+ */
+xrt_result_t
+ipc_client_queue_locked(struct ipc_connection *ipc_c, const void *data, size_t size);
+
+/*!
+ * Get the outputs the service wrote to shared memory for a call with
+ * `"shm": true` outputs, NULL if @p ref doesn't point at a current scratch
+ * area. Must be called with @ref ipc_connection::mutex held, the data is
+ * only valid until the next call.
+ *
+ * @ingroup ipc_client
+ */
+const void *
+ipc_client_scratch_locked(struct ipc_connection *ipc_c, const struct ipc_shm_ref *ref, size_t size);
+
+/*!
+ * Make a call marked `"channel": true`, over the shared memory channel if it
+ * is enabled and no one-way messages are queued, otherwise over the socket.
+ * Must be called with @ref ipc_connection::mutex held.
+ *
+ * @ingroup ipc_client
+ */
+xrt_result_t
+ipc_client_channel_call_locked(
+    struct ipc_connection *ipc_c, const void *msg, size_t msg_size, void *out_reply, size_t reply_size);
+
 struct xrt_device *
 ipc_client_hmd_create(struct ipc_connection *ipc_c, struct xrt_tracking_origin *xtrack, uint32_t device_id);
 
@@ -118,3 +174,20 @@ ipc_client_device_create(struct ipc_connection *ipc_c, struct xrt_tracking_origi
 
 struct xrt_space_overseer *
 ipc_client_space_overseer_create(struct ipc_connection *ipc_c);
+
+/*!
+ * Try to get the relation of a pose input from the poses the service publishes
+ * in shared memory, interpolating or predicting from the stored samples. Only
+ * works for timestamps close to now and when the service publishes poses.
+ *
+ * @return true if @p out_relation was filled in, false if the caller should
+ *         ask the service instead.
+ *
+ * @ingroup ipc_client
+ */
+bool
+ipc_client_get_shared_pose(struct ipc_connection *ipc_c,
+                           uint32_t device_id,
+                           enum xrt_input_name name,
+                           uint64_t at_timestamp_ns,
+                           struct xrt_space_relation *out_relation);
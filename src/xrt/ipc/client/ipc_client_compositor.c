@@ -15,9 +15,11 @@
 
 
 #include "os/os_time.h"
+#include "os/os_threading.h"
 
 #include "util/u_misc.h"
 #include "util/u_wait.h"
+#include "util/u_debug.h"
 #include "util/u_handles.h"
 #include "util/u_trace_marker.h"
 
@@ -26,6 +28,7 @@
 #include "ipc_client_generated.h"
 
 #include <string.h>
+#include <inttypes.h>
 #include <stdio.h>
 #if !defined(XRT_OS_WINDOWS)
 #include <unistd.h>
@@ -49,6 +52,11 @@
 //! Define to test the loopback allocator.
 #undef IPC_USE_LOOPBACK_IMAGE_ALLOCATOR
 
+DEBUG_GET_ONCE_BOOL_OPTION(combined_predict, "IPC_COMBINED_PREDICT", true)
+
+//! How many times to retry reading the frame stats while the service writes them.
+#define IPC_CLIENT_FRAME_STATS_READ_ATTEMPTS (16)
+
 /*!
  * Client proxy for an xrt_compositor_native implementation over IPC.
  * @implements xrt_compositor_native
@@ -76,9 +84,31 @@ struct ipc_client_compositor
 	//! Has the native compositor been created, only supports one for now.
 	bool compositor_created;
 
+	//! Index of our @ref ipc_shared_frame_stats, returned when creating the session.
+	uint32_t frame_stats_index;
+
 	//! To get better wake up in wait frame.
 	struct os_precise_sleeper sleeper;
 
+	/*!
+	 * Prediction for the next frame that the service sent back with the
+	 * layer commit, used by the next wait frame instead of asking again.
+	 */
+	struct
+	{
+		//! Protects the fields below, wait and commit can be on different threads.
+		struct os_mutex mutex;
+
+		//! Ask for a prediction together with the layer commit.
+		bool enabled;
+
+		bool valid;
+		int64_t frame_id;
+		uint64_t wake_up_time_ns;
+		uint64_t predicted_display_time_ns;
+		uint64_t predicted_display_period_ns;
+	} next_frame;
+
 #ifdef IPC_USE_LOOPBACK_IMAGE_ALLOCATOR
 	//! To test image allocator.
 	struct xrt_image_native_allocator loopback_xina;
@@ -96,6 +126,12 @@ struct ipc_client_swapchain
 	struct ipc_client_compositor *icc;
 
 	uint32_t id;
+
+	//! Index FIFO and image ownership, in shared memory so acquire and release are local.
+	struct ipc_shared_swapchain *shared;
+
+	//! Release semaphore, fetched on first use and owned by this swapchain.
+	xrt_graphics_sync_handle_t release_handle;
 };
 
 /*!
@@ -109,6 +145,9 @@ struct ipc_client_compositor_semaphore
 	struct ipc_client_compositor *icc;
 
 	uint32_t id;
+
+	//! Index FIFO and image ownership, in shared memory so acquire and release are local.
+	struct ipc_shared_swapchain *shared;
 };
 
 
@@ -137,6 +176,91 @@ ipc_client_compositor_semaphore(struct xrt_compositor_semaphore *xcsem)
 }
 
 
+/*!
+ * Should the next layer commit also ask for a prediction, only if the last one
+ * has been used by wait frame.
+ */
+static bool
+want_next_frame_prediction(struct ipc_client_compositor *icc)
+{
+	if (!icc->next_frame.enabled) {
+		return false;
+	}
+
+	os_mutex_lock(&icc->next_frame.mutex);
+	bool want = !icc->next_frame.valid;
+	os_mutex_unlock(&icc->next_frame.mutex);
+
+	return want;
+}
+
+static void
+store_next_frame_prediction(struct ipc_client_compositor *icc,
+                            int64_t frame_id,
+                            uint64_t wake_up_time_ns,
+                            uint64_t predicted_display_time_ns,
+                            uint64_t predicted_display_period_ns)
+{
+	os_mutex_lock(&icc->next_frame.mutex);
+	icc->next_frame.valid = true;
+	icc->next_frame.frame_id = frame_id;
+	icc->next_frame.wake_up_time_ns = wake_up_time_ns;
+	icc->next_frame.predicted_display_time_ns = predicted_display_time_ns;
+	icc->next_frame.predicted_display_period_ns = predicted_display_period_ns;
+	os_mutex_unlock(&icc->next_frame.mutex);
+}
+
+/*!
+ * Take the prediction that came with the last layer commit, if any. If the app
+ * took too long to call wait frame the frame is discarded and false returned,
+ * the caller then asks the service for a fresh prediction.
+ */
+static bool
+take_next_frame_prediction(struct ipc_client_compositor *icc,
+                           int64_t *out_frame_id,
+                           uint64_t *out_wake_up_time_ns,
+                           uint64_t *out_predicted_display_time_ns,
+                           uint64_t *out_predicted_display_period_ns)
+{
+	os_mutex_lock(&icc->next_frame.mutex);
+	bool valid = icc->next_frame.valid;
+	int64_t frame_id = icc->next_frame.frame_id;
+	uint64_t wake_up_time_ns = icc->next_frame.wake_up_time_ns;
+	uint64_t predicted_display_time_ns = icc->next_frame.predicted_display_time_ns;
+	uint64_t predicted_display_period_ns = icc->next_frame.predicted_display_period_ns;
+	icc->next_frame.valid = false;
+	os_mutex_unlock(&icc->next_frame.mutex);
+
+	if (!valid) {
+		return false;
+	}
+
+	// More than a period past the wake up time, the prediction is stale.
+	if (os_monotonic_get_ns() > wake_up_time_ns + predicted_display_period_ns) {
+		xrt_result_t xret = ipc_call_compositor_discard_frame(icc->ipc_c, frame_id);
+		if (xret != XRT_SUCCESS) {
+			IPC_ERROR(icc->ipc_c, "Failed to discard stale frame %" PRId64 "!", frame_id);
+		}
+		return false;
+	}
+
+	*out_frame_id = frame_id;
+	*out_wake_up_time_ns = wake_up_time_ns;
+	*out_predicted_display_time_ns = predicted_display_time_ns;
+	*out_predicted_display_period_ns = predicted_display_period_ns;
+
+	return true;
+}
+
+static void
+clear_next_frame_prediction(struct ipc_client_compositor *icc)
+{
+	os_mutex_lock(&icc->next_frame.mutex);
+	icc->next_frame.valid = false;
+	os_mutex_unlock(&icc->next_frame.mutex);
+}
+
+
 /*
  *
  * Misc functions
@@ -188,6 +312,8 @@ ipc_compositor_swapchain_destroy(struct xrt_swapchain *xsc)
 
 	IPC_CALL_CHK(ipc_call_swapchain_destroy(icc->ipc_c, ics->id));
 
+	u_graphics_sync_unref(&ics->release_handle);
+
 	free(xsc);
 }
 
@@ -203,27 +329,83 @@ ipc_compositor_swapchain_wait_image(struct xrt_swapchain *xsc, uint64_t timeout_
 }
 
 static xrt_result_t
-ipc_compositor_swapchain_acquire_image(struct xrt_swapchain *xsc, uint32_t *out_index)
+ipc_compositor_swapchain_get_release_semaphore(struct xrt_swapchain *xsc, xrt_graphics_sync_handle_t *out_handle)
 {
 	struct ipc_client_swapchain *ics = ipc_client_swapchain(xsc);
 	struct ipc_client_compositor *icc = ics->icc;
 
-	IPC_CALL_CHK(ipc_call_swapchain_acquire_image(icc->ipc_c, ics->id, out_index));
+	if (!xrt_graphics_sync_handle_is_valid(ics->release_handle)) {
+		IPC_CALL_CHK(ipc_call_swapchain_get_release_semaphore(icc->ipc_c, ics->id, &ics->release_handle, 1));
+		if (res != XRT_SUCCESS) {
+			ics->release_handle = XRT_GRAPHICS_SYNC_HANDLE_INVALID;
+			return res;
+		}
+	}
 
-	return res;
+	*out_handle = ics->release_handle;
+
+	return XRT_SUCCESS;
 }
 
 static xrt_result_t
-ipc_compositor_swapchain_release_image(struct xrt_swapchain *xsc, uint32_t index)
+ipc_compositor_swapchain_get_release_value(struct xrt_swapchain *xsc, uint32_t index, uint64_t *out_value)
 {
 	struct ipc_client_swapchain *ics = ipc_client_swapchain(xsc);
 	struct ipc_client_compositor *icc = ics->icc;
 
-	IPC_CALL_CHK(ipc_call_swapchain_release_image(icc->ipc_c, ics->id, index));
+	IPC_CALL_CHK(ipc_call_swapchain_get_release_value(icc->ipc_c, ics->id, index, out_value));
 
 	return res;
 }
 
+static xrt_result_t
+ipc_compositor_swapchain_acquire_image(struct xrt_swapchain *xsc, uint32_t *out_index)
+{
+	struct ipc_client_swapchain *ics = ipc_client_swapchain(xsc);
+	struct ipc_shared_swapchain *iss = ics->shared;
+
+	// Only this thread writes the state, the application must synchronize swapchain calls.
+	uint32_t acquired = (uint32_t)iss->acquired;
+	if (acquired >= iss->image_count) {
+		return XRT_ERROR_NO_IMAGE_AVAILABLE;
+	}
+
+	uint32_t index = iss->fifo[iss->head];
+	iss->head = (iss->head + 1) % iss->image_count;
+	iss->image_states[index] = IPC_SHARED_IMAGE_ACQUIRED;
+
+	xrt_atomic_thread_fence();
+	iss->acquired = (int32_t)(acquired + 1);
+
+	*out_index = index;
+
+	return XRT_SUCCESS;
+}
+
+static xrt_result_t
+ipc_compositor_swapchain_release_image(struct xrt_swapchain *xsc, uint32_t index)
+{
+	struct ipc_client_swapchain *ics = ipc_client_swapchain(xsc);
+	struct ipc_shared_swapchain *iss = ics->shared;
+
+	if (index >= iss->image_count || iss->image_states[index] != IPC_SHARED_IMAGE_ACQUIRED) {
+		IPC_ERROR(ics->icc->ipc_c, "Releasing image %u that is not acquired!", index);
+		return XRT_ERROR_NO_IMAGE_AVAILABLE;
+	}
+
+	// Put it back at the end of the available images.
+	uint32_t acquired = (uint32_t)iss->acquired;
+	uint32_t tail = (iss->head + iss->image_count - acquired) % iss->image_count;
+	iss->fifo[tail] = index;
+	iss->image_states[index] = IPC_SHARED_IMAGE_AVAILABLE;
+
+	// The service reads the release count when layers are committed.
+	xrt_atomic_thread_fence();
+	iss->acquired = (int32_t)(acquired - 1);
+	iss->release_count++;
+
+	return XRT_SUCCESS;
+}
 
 /*
  *
@@ -280,6 +462,7 @@ swapchain_server_create(struct ipc_client_compositor *icc,
 	xrt_graphics_buffer_handle_t remote_handles[XRT_MAX_SWAPCHAIN_IMAGES] = {0};
 	xrt_result_t r = XRT_SUCCESS;
 	uint32_t handle;
+	uint32_t shared_index;
 	uint32_t image_count;
 	uint64_t size;
 	bool use_dedicated_allocation;
@@ -287,6 +470,7 @@ swapchain_server_create(struct ipc_client_compositor *icc,
 	r = ipc_call_swapchain_create(icc->ipc_c,                // connection
 	                              info,                      // in
 	                              &handle,                   // out
+	                              &shared_index,             // out
 	                              &image_count,              // out
 	                              &size,                     // out
 	                              &use_dedicated_allocation, // out
@@ -299,12 +483,16 @@ swapchain_server_create(struct ipc_client_compositor *icc,
 	struct ipc_client_swapchain *ics = U_TYPED_CALLOC(struct ipc_client_swapchain);
 	ics->base.base.image_count = image_count;
 	ics->base.base.wait_image = ipc_compositor_swapchain_wait_image;
+	ics->base.base.get_release_semaphore = ipc_compositor_swapchain_get_release_semaphore;
+	ics->base.base.get_release_value = ipc_compositor_swapchain_get_release_value;
 	ics->base.base.acquire_image = ipc_compositor_swapchain_acquire_image;
 	ics->base.base.release_image = ipc_compositor_swapchain_release_image;
 	ics->base.base.destroy = ipc_compositor_swapchain_destroy;
 	ics->base.base.reference.count = 1;
 	ics->icc = icc;
 	ics->id = handle;
+	ics->shared = &icc->ipc_c->ism->swapchains[shared_index];
+	ics->release_handle = XRT_GRAPHICS_SYNC_HANDLE_INVALID;
 
 	for (uint32_t i = 0; i < image_count; i++) {
 		ics->base.images[i].handle = remote_handles[i];
@@ -328,6 +516,7 @@ swapchain_server_import(struct ipc_client_compositor *icc,
 	xrt_graphics_buffer_handle_t handles[XRT_MAX_SWAPCHAIN_IMAGES] = {0};
 	xrt_result_t r = XRT_SUCCESS;
 	uint32_t id = 0;
+	uint32_t shared_index = 0;
 
 	for (uint32_t i = 0; i < image_count; i++) {
 		handles[i] = native_images[i].handle;
@@ -343,12 +532,13 @@ swapchain_server_import(struct ipc_client_compositor *icc,
 	}
 
 	// This does not consume the handles, it copies them.
-	r = ipc_call_swapchain_import(icc->ipc_c,  // connection
-	                              info,        // in
-	                              &args,       // in
-	                              handles,     // handles
-	                              image_count, // handles
-	                              &id);        // out
+	r = ipc_call_swapchain_import(icc->ipc_c,     // connection
+	                              info,           // in
+	                              &args,          // in
+	                              handles,        // handles
+	                              image_count,    // handles
+	                              &id,            // out
+	                              &shared_index); // out
 	if (r != XRT_SUCCESS) {
 		return r;
 	}
@@ -356,12 +546,16 @@ swapchain_server_import(struct ipc_client_compositor *icc,
 	struct ipc_client_swapchain *ics = U_TYPED_CALLOC(struct ipc_client_swapchain);
 	ics->base.base.image_count = image_count;
 	ics->base.base.wait_image = ipc_compositor_swapchain_wait_image;
+	ics->base.base.get_release_semaphore = ipc_compositor_swapchain_get_release_semaphore;
+	ics->base.base.get_release_value = ipc_compositor_swapchain_get_release_value;
 	ics->base.base.acquire_image = ipc_compositor_swapchain_acquire_image;
 	ics->base.base.release_image = ipc_compositor_swapchain_release_image;
 	ics->base.base.destroy = ipc_compositor_swapchain_destroy;
 	ics->base.base.reference.count = 1;
 	ics->icc = icc;
 	ics->id = id;
+	ics->shared = &icc->ipc_c->ism->swapchains[shared_index];
+	ics->release_handle = XRT_GRAPHICS_SYNC_HANDLE_INVALID;
 
 	// The handles were copied in the IPC call so we can reuse them here.
 	for (uint32_t i = 0; i < image_count; i++) {
@@ -482,6 +676,50 @@ ipc_compositor_poll_events(struct xrt_compositor *xc, union xrt_compositor_event
 	return res;
 }
 
+static xrt_result_t
+ipc_compositor_get_frame_stats(struct xrt_compositor *xc, struct xrt_compositor_frame_stats *out_stats)
+{
+	struct ipc_client_compositor *icc = ipc_client_compositor(xc);
+
+	if (icc->frame_stats_index >= IPC_MAX_CLIENTS) {
+		return XRT_ERROR_COMPOSITOR_FUNCTION_NOT_IMPLEMENTED;
+	}
+
+	struct ipc_shared_frame_stats *isfs = &icc->ipc_c->ism->frame_stats[icc->frame_stats_index];
+	struct xrt_compositor_frame_stats stats = {0};
+	bool valid = false;
+
+	for (uint32_t attempt = 0; attempt < IPC_CLIENT_FRAME_STATS_READ_ATTEMPTS; attempt++) {
+		int32_t sequence = isfs->sequence;
+		if ((sequence & 1) != 0) {
+			// The service is writing.
+			continue;
+		}
+
+		xrt_atomic_thread_fence();
+
+		valid = isfs->valid;
+		stats = isfs->stats;
+
+		xrt_atomic_thread_fence();
+
+		if (sequence != isfs->sequence) {
+			continue;
+		}
+
+		// Zeroed until the service has measured any frames.
+		if (!valid) {
+			U_ZERO(&stats);
+			stats.recommended_render_scale = 1.0f;
+		}
+
+		*out_stats = stats;
+		return XRT_SUCCESS;
+	}
+
+	return XRT_ERROR_IPC_FAILURE;
+}
+
 static xrt_result_t
 ipc_compositor_begin_session(struct xrt_compositor *xc, const struct xrt_begin_session_info *info)
 {
@@ -489,6 +727,8 @@ ipc_compositor_begin_session(struct xrt_compositor *xc, const struct xrt_begin_s
 
 	IPC_TRACE(icc->ipc_c, "Compositor begin session.");
 
+	clear_next_frame_prediction(icc);
+
 	IPC_CALL_CHK(ipc_call_session_begin(icc->ipc_c));
 
 	return res;
@@ -503,6 +743,9 @@ ipc_compositor_end_session(struct xrt_compositor *xc)
 
 	IPC_TRACE(icc->ipc_c, "Compositor end session.");
 
+	// The service drops any outstanding frames when the session ends.
+	clear_next_frame_prediction(icc);
+
 	IPC_CALL_CHK(ipc_call_session_end(icc->ipc_c));
 
 	return res;
@@ -522,12 +765,19 @@ ipc_compositor_wait_frame(struct xrt_compositor *xc,
 	uint64_t predicted_display_time = 0;
 	uint64_t predicted_display_period = 0;
 
-	IPC_CALL_CHK(ipc_call_compositor_predict_frame( //
-	    icc->ipc_c,                                 // Connection
-	    &frame_id,                                  // Frame id
-	    &wake_up_time_ns,                           // When we should wake up
-	    &predicted_display_time,                    // Display time
-	    &predicted_display_period));                // Current period
+	xrt_result_t res = XRT_SUCCESS;
+	if (!take_next_frame_prediction(icc, &frame_id, &wake_up_time_ns, &predicted_display_time,
+	                                &predicted_display_period)) {
+		res = ipc_call_compositor_predict_frame( //
+		    icc->ipc_c,                          //
+		    &frame_id,                           //
+		    &wake_up_time_ns,                    //
+		    &predicted_display_time,             //
+		    &predicted_display_period);          //
+		if (res != XRT_SUCCESS) {
+			IPC_ERROR(icc->ipc_c, "Call error '%i'!", res);
+		}
+	}
 
 	// Wait until the given wake up time.
 	u_wait_until(&icc->sleeper, wake_up_time_ns);
@@ -566,6 +816,22 @@ ipc_compositor_layer_begin(struct xrt_compositor *xc, const struct xrt_layer_fra
 	return XRT_SUCCESS;
 }
 
+static struct xrt_layer_data *
+ipc_compositor_layer_reserve(struct xrt_compositor *xc)
+{
+	struct ipc_client_compositor *icc = ipc_client_compositor(xc);
+
+	if (icc->layers.layer_count >= IPC_MAX_LAYERS) {
+		return NULL;
+	}
+
+	struct ipc_shared_memory *ism = icc->ipc_c->ism;
+	struct ipc_layer_slot *slot = &ism->slots[icc->layers.slot_id];
+
+	// The caller fills this in directly, the layer call then skips the copy.
+	return &slot->layers[icc->layers.layer_count].data;
+}
+
 static xrt_result_t
 ipc_compositor_layer_stereo_projection(struct xrt_compositor *xc,
                                        struct xrt_device *xdev,
@@ -588,7 +854,9 @@ ipc_compositor_layer_stereo_projection(struct xrt_compositor *xc,
 	layer->swapchain_ids[1] = r->id;
 	layer->swapchain_ids[2] = -1;
 	layer->swapchain_ids[3] = -1;
-	layer->data = *data;
+	if (data != &layer->data) {
+		layer->data = *data;
+	}
 
 	// Increment the number of layers.
 	icc->layers.layer_count++;
@@ -622,7 +890,9 @@ ipc_compositor_layer_stereo_projection_depth(struct xrt_compositor *xc,
 	layer->swapchain_ids[1] = r->id;
 	layer->swapchain_ids[2] = l_d->id;
 	layer->swapchain_ids[3] = r_d->id;
-	layer->data = *data;
+	if (data != &layer->data) {
+		layer->data = *data;
+	}
 
 	// Increment the number of layers.
 	icc->layers.layer_count++;
@@ -651,7 +921,9 @@ handle_layer(struct xrt_compositor *xc,
 	layer->swapchain_ids[1] = -1;
 	layer->swapchain_ids[2] = -1;
 	layer->swapchain_ids[3] = -1;
-	layer->data = *data;
+	if (data != &layer->data) {
+		layer->data = *data;
+	}
 
 	// Increment the number of layers.
 	icc->layers.layer_count++;
@@ -717,12 +989,39 @@ ipc_compositor_layer_commit(struct xrt_compositor *xc, xrt_graphics_sync_handle_
 	// Last bit of data to put in the shared memory area.
 	slot->layer_count = icc->layers.layer_count;
 
-	IPC_CALL_CHK(ipc_call_compositor_layer_sync( //
-	    icc->ipc_c,                              //
-	    icc->layers.slot_id,                     //
-	    &sync_handle,                            //
-	    valid_sync ? 1 : 0,                      //
-	    &icc->layers.slot_id));                  //
+	xrt_result_t res;
+	if (want_next_frame_prediction(icc)) {
+		int64_t frame_id = -1;
+		uint64_t wake_up_time_ns = 0;
+		uint64_t predicted_display_time = 0;
+		uint64_t predicted_display_period = 0;
+
+		res = ipc_call_compositor_layer_sync_and_predict( //
+		    icc->ipc_c,                                   //
+		    icc->layers.slot_id,                          //
+		    &sync_handle,                                 //
+		    valid_sync ? 1 : 0,                           //
+		    &icc->layers.slot_id,                         //
+		    &frame_id,                                    //
+		    &wake_up_time_ns,                             //
+		    &predicted_display_time,                      //
+		    &predicted_display_period);                   //
+
+		if (res == XRT_SUCCESS) {
+			store_next_frame_prediction(icc, frame_id, wake_up_time_ns, predicted_display_time,
+			                            predicted_display_period);
+		}
+	} else {
+		res = ipc_call_compositor_layer_sync( //
+		    icc->ipc_c,                       //
+		    icc->layers.slot_id,              //
+		    &sync_handle,                     //
+		    valid_sync ? 1 : 0,               //
+		    &icc->layers.slot_id);            //
+	}
+	if (res != XRT_SUCCESS) {
+		IPC_ERROR(icc->ipc_c, "Call error '%i'!", res);
+	}
 
 	// Reset.
 	icc->layers.layer_count = 0;
@@ -749,12 +1048,39 @@ ipc_compositor_layer_commit_with_semaphore(struct xrt_compositor *xc,
 	// Last bit of data to put in the shared memory area.
 	slot->layer_count = icc->layers.layer_count;
 
-	IPC_CALL_CHK(ipc_call_compositor_layer_sync_with_semaphore( //
-	    icc->ipc_c,                                             //
-	    icc->layers.slot_id,                                    //
-	    iccs->id,                                               //
-	    value,                                                  //
-	    &icc->layers.slot_id));                                 //
+	xrt_result_t res;
+	if (want_next_frame_prediction(icc)) {
+		int64_t frame_id = -1;
+		uint64_t wake_up_time_ns = 0;
+		uint64_t predicted_display_time = 0;
+		uint64_t predicted_display_period = 0;
+
+		res = ipc_call_compositor_layer_sync_with_semaphore_and_predict( //
+		    icc->ipc_c,                                                  //
+		    icc->layers.slot_id,                                         //
+		    iccs->id,                                                    //
+		    value,                                                       //
+		    &icc->layers.slot_id,                                        //
+		    &frame_id,                                                   //
+		    &wake_up_time_ns,                                            //
+		    &predicted_display_time,                                     //
+		    &predicted_display_period);                                  //
+
+		if (res == XRT_SUCCESS) {
+			store_next_frame_prediction(icc, frame_id, wake_up_time_ns, predicted_display_time,
+			                            predicted_display_period);
+		}
+	} else {
+		res = ipc_call_compositor_layer_sync_with_semaphore( //
+		    icc->ipc_c,                                      //
+		    icc->layers.slot_id,                             //
+		    iccs->id,                                        //
+		    value,                                           //
+		    &icc->layers.slot_id);                           //
+	}
+	if (res != XRT_SUCCESS) {
+		IPC_ERROR(icc->ipc_c, "Call error '%i'!", res);
+	}
 
 	// Reset.
 	icc->layers.layer_count = 0;
@@ -783,6 +1109,8 @@ ipc_compositor_destroy(struct xrt_compositor *xc)
 
 	os_precise_sleeper_deinit(&icc->sleeper);
 
+	os_mutex_destroy(&icc->next_frame.mutex);
+
 	icc->compositor_created = false;
 }
 
@@ -799,6 +1127,7 @@ ipc_compositor_init(struct ipc_client_compositor *icc, struct xrt_compositor_nat
 	icc->base.base.begin_frame = ipc_compositor_begin_frame;
 	icc->base.base.discard_frame = ipc_compositor_discard_frame;
 	icc->base.base.layer_begin = ipc_compositor_layer_begin;
+	icc->base.base.layer_reserve = ipc_compositor_layer_reserve;
 	icc->base.base.layer_stereo_projection = ipc_compositor_layer_stereo_projection;
 	icc->base.base.layer_stereo_projection_depth = ipc_compositor_layer_stereo_projection_depth;
 	icc->base.base.layer_quad = ipc_compositor_layer_quad;
@@ -810,10 +1139,16 @@ ipc_compositor_init(struct ipc_client_compositor *icc, struct xrt_compositor_nat
 	icc->base.base.layer_commit_with_semaphore = ipc_compositor_layer_commit_with_semaphore;
 	icc->base.base.destroy = ipc_compositor_destroy;
 	icc->base.base.poll_events = ipc_compositor_poll_events;
+	icc->base.base.get_frame_stats = ipc_compositor_get_frame_stats;
 
 	// Using in wait frame.
 	os_precise_sleeper_init(&icc->sleeper);
 
+	// Prediction returned with the layer commit.
+	os_mutex_init(&icc->next_frame.mutex);
+	icc->next_frame.enabled = debug_get_bool_option_combined_predict();
+	icc->next_frame.valid = false;
+
 	// Fetch info from the compositor, among it the format format list.
 	get_info(&(icc->base.base), &icc->base.base.info);
 
@@ -947,7 +1282,7 @@ ipc_syscomp_create_native_compositor(struct xrt_system_compositor *xsc,
 	}
 
 	// Needs to be done before init.
-	IPC_CALL_CHK(ipc_call_session_create(icc->ipc_c, xsi));
+	IPC_CALL_CHK(ipc_call_session_create(icc->ipc_c, xsi, &icc->frame_stats_index));
 
 	if (res != XRT_SUCCESS) {
 		return res;
@@ -9,6 +9,7 @@
  */
 
 #include "os/os_threading.h"
+#include "os/os_time.h"
 #include "xrt/xrt_results.h"
 #if defined(_MSC_VER) && !defined(_CRT_SECURE_NO_WARNINGS)
 #define _CRT_SECURE_NO_WARNINGS
@@ -32,7 +33,9 @@
 #include "ipc_client_generated.h"
 
 
+#include <stddef.h>
 #include <stdio.h>
+#include <string.h>
 #if !defined(XRT_OS_WINDOWS)
 #include <sys/socket.h>
 #include <sys/un.h>
@@ -43,6 +46,9 @@
 #include <fcntl.h>
 #include <unistd.h>
 #endif
+#ifdef XRT_OS_LINUX
+#include <poll.h>
+#endif
 #include <limits.h>
 
 #ifdef XRT_GRAPHICS_BUFFER_HANDLE_IS_AHARDWAREBUFFER
@@ -54,7 +60,14 @@
 #include "android/ipc_client_android.h"
 #endif // XRT_OS_ANDROID
 
+//! How long to spin for a reply on the channel before sleeping on the futex.
+#define CHANNEL_SPIN_NS (20 * U_TIME_1US_IN_NS)
+
+//! How often to check that the service is still there while waiting on the channel.
+#define CHANNEL_CHECK_NS (100 * U_TIME_1MS_IN_NS)
+
 DEBUG_GET_ONCE_BOOL_OPTION(ipc_ignore_version, "IPC_IGNORE_VERSION", false)
+DEBUG_GET_ONCE_BOOL_OPTION(ipc_shm_channel, "IPC_SHM_CHANNEL", false)
 
 #ifdef XRT_OS_ANDROID
 
@@ -318,6 +331,17 @@ ipc_client_connection_init(struct ipc_connection *ipc_c,
 		return XRT_ERROR_IPC_FAILURE;
 	}
 
+	// Can't be ignored, the rest of the shared memory would be misread.
+	if (ipc_c->ism->layout_version != IPC_SHARED_MEMORY_LAYOUT_VERSION ||
+	    ipc_c->ism->layout_size < sizeof(struct ipc_shared_memory)) {
+		IPC_ERROR(ipc_c, "Shared memory layout %u (%u bytes) of the service is not compatible with %u (%u bytes)",
+		          ipc_c->ism->layout_version, ipc_c->ism->layout_size, IPC_SHARED_MEMORY_LAYOUT_VERSION,
+		          (uint32_t)sizeof(struct ipc_shared_memory));
+		ipc_client_connection_fini(ipc_c);
+
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
 	if (strncmp(u_git_tag, ipc_c->ism->u_git_tag, IPC_VERSION_NAME_LEN) != 0) {
 		IPC_ERROR(ipc_c, "Monado client library version %s does not match service version %s", u_git_tag,
 		          ipc_c->ism->u_git_tag);
@@ -327,9 +351,161 @@ ipc_client_connection_init(struct ipc_connection *ipc_c,
 			return XRT_ERROR_IPC_FAILURE;
 		}
 	}
+
+#ifdef XRT_OS_LINUX
+	if (debug_get_bool_option_ipc_shm_channel()) {
+		uint32_t channel_id = 0;
+		xret = ipc_call_instance_enable_channel(ipc_c, &channel_id);
+		if (xret == XRT_SUCCESS && channel_id < IPC_MAX_CLIENTS) {
+			ipc_c->channel = &ipc_c->ism->channels[channel_id];
+		} else {
+			IPC_WARN(ipc_c, "Failed to enable the shared memory channel, using the socket only");
+		}
+	}
+#endif
+
 	return XRT_SUCCESS;
 }
 
+xrt_result_t
+ipc_client_send_locked(struct ipc_connection *ipc_c, const void *data, size_t size)
+{
+#ifdef XRT_OS_WINDOWS
+	return ipc_send(&ipc_c->imc, data, size);
+#else
+	xrt_result_t xret = ipc_send_batch(&ipc_c->imc, ipc_c->queued.data, ipc_c->queued.size, data, size);
+
+	// On failure the connection is broken, no point in keeping them around.
+	ipc_c->queued.size = 0;
+
+#ifdef XRT_OS_LINUX
+	// The service sleeps on the doorbell instead of the socket once the channel is enabled.
+	if (ipc_c->channel != NULL) {
+		xrt_atomic_s32_inc_return(&ipc_c->channel->doorbell);
+		ipc_futex_wake(&ipc_c->channel->doorbell);
+	}
+#endif
+
+	return xret;
+#endif
+}
+
+xrt_result_t
+ipc_client_queue_locked(struct ipc_connection *ipc_c, const void *data, size_t size)
+{
+#ifdef XRT_OS_WINDOWS
+	// Message mode pipes, the service reads one message per read.
+	return ipc_send(&ipc_c->imc, data, size);
+#else
+	if (ipc_c->queued.size + size > sizeof(ipc_c->queued.data)) {
+		// Full, send everything we have right away.
+		return ipc_client_send_locked(ipc_c, data, size);
+	}
+
+	memcpy(ipc_c->queued.data + ipc_c->queued.size, data, size);
+	ipc_c->queued.size += (uint32_t)size;
+
+	return XRT_SUCCESS;
+#endif
+}
+
+const void *
+ipc_client_scratch_locked(struct ipc_connection *ipc_c, const struct ipc_shm_ref *ref, size_t size)
+{
+	const size_t first = offsetof(struct ipc_shared_memory, scratch) + offsetof(struct ipc_shared_scratch, data);
+	const size_t stride = sizeof(struct ipc_shared_scratch);
+
+	// Must be the start of the data of one of the scratch areas.
+	if (ref->offset < first || (ref->offset - first) % stride != 0 || size > IPC_SHARED_SCRATCH_SIZE ||
+	    (ref->offset - first) / stride >= IPC_MAX_CLIENTS) {
+		IPC_ERROR(ipc_c, "Invalid shared memory reply offset %u", ref->offset);
+		return NULL;
+	}
+
+	const struct ipc_shared_scratch *iss = &ipc_c->ism->scratch[(ref->offset - first) / stride];
+	if ((uint32_t)iss->generation != ref->generation) {
+		IPC_ERROR(ipc_c, "Stale shared memory reply, generation %u instead of %u", (uint32_t)iss->generation,
+		          ref->generation);
+		return NULL;
+	}
+
+	return iss->data;
+}
+
+#ifdef XRT_OS_LINUX
+static bool
+service_hung_up(struct ipc_connection *ipc_c)
+{
+	struct pollfd pfd = {
+	    .fd = ipc_c->imc.ipc_handle,
+	    .events = POLLRDHUP,
+	};
+
+	int ret = poll(&pfd, 1, 0);
+
+	return ret < 0 || (pfd.revents & (POLLRDHUP | POLLHUP | POLLERR | POLLNVAL)) != 0;
+}
+
+static xrt_result_t
+channel_call(struct ipc_connection *ipc_c, const void *msg, size_t msg_size, void *out_reply, size_t reply_size)
+{
+	struct ipc_shared_channel *ch = ipc_c->channel;
+
+	// We are the only writer of the request.
+	int32_t seq = ch->request_seq + 1;
+	memcpy(ch->request, msg, msg_size);
+	ch->request_size = (uint32_t)msg_size;
+
+	// The request must be complete before the service can see the new sequence number.
+	xrt_atomic_thread_fence();
+	ch->request_seq = seq;
+	xrt_atomic_s32_inc_return(&ch->doorbell);
+	ipc_futex_wake(&ch->doorbell);
+
+	// The reply often comes quickly, spin a little before sleeping.
+	uint64_t spin_until_ns = os_monotonic_get_ns() + CHANNEL_SPIN_NS;
+	int32_t replied = ch->reply_seq;
+	while (replied != seq) {
+		if (os_monotonic_get_ns() < spin_until_ns) {
+			os_cpu_relax();
+		} else if (!ipc_futex_wait(&ch->reply_seq, replied, CHANNEL_CHECK_NS) && service_hung_up(ipc_c)) {
+			IPC_ERROR(ipc_c, "Service went away while waiting on the channel!");
+			return XRT_ERROR_IPC_FAILURE;
+		}
+		replied = ch->reply_seq;
+	}
+
+	xrt_atomic_thread_fence();
+	if (ch->reply_size != reply_size) {
+		IPC_ERROR(ipc_c, "Channel reply has size %u instead of %u", ch->reply_size, (uint32_t)reply_size);
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	memcpy(out_reply, ch->reply, reply_size);
+
+	return XRT_SUCCESS;
+}
+#endif
+
+xrt_result_t
+ipc_client_channel_call_locked(
+    struct ipc_connection *ipc_c, const void *msg, size_t msg_size, void *out_reply, size_t reply_size)
+{
+#ifdef XRT_OS_LINUX
+	// Queued one-way messages go over the socket, and must be handled first.
+	if (ipc_c->channel != NULL && ipc_c->queued.size == 0) {
+		return channel_call(ipc_c, msg, msg_size, out_reply, reply_size);
+	}
+#endif
+
+	xrt_result_t xret = ipc_client_send_locked(ipc_c, msg, msg_size);
+	if (xret != XRT_SUCCESS) {
+		return xret;
+	}
+
+	return ipc_receive(&ipc_c->imc, out_reply, reply_size);
+}
+
 void
 ipc_client_connection_fini(struct ipc_connection *ipc_c)
 {
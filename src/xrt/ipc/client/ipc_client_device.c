@@ -12,12 +12,17 @@
 #include "os/os_time.h"
 
 #include "math/m_api.h"
+#include "math/m_space.h"
+#include "math/m_predict.h"
 
 #include "util/u_var.h"
 #include "util/u_misc.h"
 #include "util/u_debug.h"
+#include "util/u_time.h"
 #include "util/u_device.h"
 
+#include "shared/ipc_hand_joints.h"
+
 #include "client/ipc_client.h"
 #include "ipc_client_generated.h"
 
@@ -34,6 +39,21 @@
  *
  */
 
+/*!
+ * How far past the newest published sample we are willing to predict locally,
+ * further out than this we ask the service which may know better.
+ */
+#define IPC_CLIENT_SHARED_POSE_MAX_PREDICTION_NS (50 * U_TIME_1MS_IN_NS)
+
+/*!
+ * The published poses are considered stale if the newest sample is older than
+ * this many publishing intervals, the service might have stalled.
+ */
+#define IPC_CLIENT_SHARED_POSE_STALE_INTERVALS (4)
+
+//! Number of times we try to get a consistent copy before giving up.
+#define IPC_CLIENT_SHARED_POSE_READ_ATTEMPTS (16)
+
 /*!
  * An IPC client proxy for an controller or other non-MHD @ref xrt_device and
  * @ref ipc_client_xdev. Using a typedef reduce impact of refactor change.
@@ -44,6 +64,110 @@
 typedef struct ipc_client_xdev ipc_client_device_t;
 
 
+/*
+ *
+ * Shared memory pose functions.
+ *
+ */
+
+static struct ipc_shared_pose_history *
+find_shared_pose(struct ipc_shared_memory *ism, uint32_t device_id, enum xrt_input_name name)
+{
+	for (uint32_t i = 0; i < ism->pose_count; i++) {
+		struct ipc_shared_pose_history *isph = &ism->poses[i];
+		if (isph->device_id == device_id && isph->name == name) {
+			return isph;
+		}
+	}
+
+	return NULL;
+}
+
+bool
+ipc_client_get_shared_pose(struct ipc_connection *ipc_c,
+                           uint32_t device_id,
+                           enum xrt_input_name name,
+                           uint64_t at_timestamp_ns,
+                           struct xrt_space_relation *out_relation)
+{
+	struct ipc_shared_memory *ism = ipc_c->ism;
+	const uint64_t interval_ns = ism->pose_publish_interval_ns;
+	if (interval_ns == 0) {
+		return false;
+	}
+
+	struct ipc_shared_pose_history *isph = find_shared_pose(ism, device_id, name);
+	if (isph == NULL) {
+		return false;
+	}
+
+	uint64_t timestamps_ns[IPC_SHARED_POSE_HISTORY];
+	struct xrt_space_relation relations[IPC_SHARED_POSE_HISTORY];
+	uint32_t sample_count = 0;
+	uint32_t write_count = 0;
+	bool consistent = false;
+
+	for (uint32_t attempt = 0; attempt < IPC_CLIENT_SHARED_POSE_READ_ATTEMPTS && !consistent; attempt++) {
+		int32_t sequence = isph->sequence;
+		if ((sequence & 1) != 0) {
+			// The service is writing.
+			continue;
+		}
+
+		xrt_atomic_thread_fence();
+
+		sample_count = isph->sample_count;
+		write_count = isph->write_count;
+		memcpy(timestamps_ns, isph->timestamps_ns, sizeof(timestamps_ns));
+		memcpy(relations, isph->relations, sizeof(relations));
+
+		xrt_atomic_thread_fence();
+
+		consistent = sequence == isph->sequence;
+	}
+
+	if (!consistent || sample_count == 0 || sample_count > IPC_SHARED_POSE_HISTORY) {
+		return false;
+	}
+
+	uint32_t newest = (write_count - 1) % IPC_SHARED_POSE_HISTORY;
+	uint64_t newest_ns = timestamps_ns[newest];
+
+	if (os_monotonic_get_ns() > newest_ns + interval_ns * IPC_CLIENT_SHARED_POSE_STALE_INTERVALS) {
+		return false;
+	}
+
+	if (at_timestamp_ns >= newest_ns) {
+		uint64_t delta_ns = at_timestamp_ns - newest_ns;
+		if (delta_ns > IPC_CLIENT_SHARED_POSE_MAX_PREDICTION_NS) {
+			return false;
+		}
+
+		m_predict_relation(&relations[newest], time_ns_to_s((int64_t)delta_ns), out_relation);
+		return true;
+	}
+
+	// Walk backwards to find the two samples around the timestamp.
+	for (uint32_t i = 1; i < sample_count; i++) {
+		uint32_t older = (write_count - 1 - i) % IPC_SHARED_POSE_HISTORY;
+		uint32_t newer = (write_count - i) % IPC_SHARED_POSE_HISTORY;
+		if (timestamps_ns[older] > at_timestamp_ns) {
+			continue;
+		}
+
+		uint64_t range_ns = timestamps_ns[newer] - timestamps_ns[older];
+		float t = range_ns == 0 ? 0.0f : (float)(at_timestamp_ns - timestamps_ns[older]) / (float)range_ns;
+		enum xrt_space_relation_flags flags = relations[older].relation_flags & relations[newer].relation_flags;
+
+		m_space_relation_interpolate(&relations[older], &relations[newer], t, flags, out_relation);
+		return true;
+	}
+
+	// Older than what we have, let the service look it up.
+	return false;
+}
+
+
 /*
  *
  * Functions
@@ -91,6 +215,10 @@ ipc_client_device_get_tracked_pose(struct xrt_device *xdev,
 {
 	ipc_client_device_t *icd = ipc_client_device(xdev);
 
+	if (ipc_client_get_shared_pose(icd->ipc_c, icd->device_id, name, at_timestamp_ns, out_relation)) {
+		return;
+	}
+
 	xrt_result_t r =
 	    ipc_call_device_get_tracked_pose(icd->ipc_c, icd->device_id, name, at_timestamp_ns, out_relation);
 	if (r != XRT_SUCCESS) {
@@ -106,11 +234,30 @@ ipc_client_device_get_hand_tracking(struct xrt_device *xdev,
                                     uint64_t *out_timestamp_ns)
 {
 	ipc_client_device_t *icd = ipc_client_device(xdev);
+	xrt_result_t r;
+
+	if (icd->hand_tracking_full) {
+		r = ipc_call_device_get_hand_tracking(icd->ipc_c, icd->device_id, name, at_timestamp_ns, out_value,
+		                                      out_timestamp_ns);
+		if (r != XRT_SUCCESS) {
+			IPC_ERROR(icd->ipc_c, "Error sending input update!");
+		}
+		return;
+	}
 
-	xrt_result_t r = ipc_call_device_get_hand_tracking(icd->ipc_c, icd->device_id, name, at_timestamp_ns, out_value,
-	                                                   out_timestamp_ns);
+	struct ipc_hand_joint_set_compact compact;
+	r = ipc_call_device_get_hand_tracking_compact(icd->ipc_c, icd->device_id, name, at_timestamp_ns, &compact,
+	                                              out_timestamp_ns);
 	if (r != XRT_SUCCESS) {
 		IPC_ERROR(icd->ipc_c, "Error sending input update!");
+		return;
+	}
+
+	ipc_hand_joint_set_unpack(&compact, out_value);
+
+	// Velocities were dropped, from now on ask for the full joint sets.
+	if (compact.had_velocities) {
+		icd->hand_tracking_full = true;
 	}
 }
 
@@ -148,9 +295,13 @@ ipc_client_device_create(struct ipc_connection *ipc_c, struct xrt_tracking_origi
 	struct ipc_shared_memory *ism = ipc_c->ism;
 	struct ipc_shared_device *isdev = &ism->isdevs[device_id];
 
-	// Allocate and setup the basics.
+	/*
+	 * Allocate and setup the basics, the binding profiles are placed right
+	 * after the device in the same allocation and freed along with it.
+	 */
 	enum u_device_alloc_flags flags = (enum u_device_alloc_flags)(U_DEVICE_ALLOC_HMD);
-	ipc_client_device_t *icd = U_DEVICE_ALLOCATE(ipc_client_device_t, flags, 0, 0);
+	size_t size = sizeof(ipc_client_device_t) + sizeof(struct xrt_binding_profile) * isdev->binding_profile_count;
+	ipc_client_device_t *icd = (ipc_client_device_t *)u_device_allocate(flags, size, 0, 0);
 	icd->ipc_c = ipc_c;
 	icd->base.update_inputs = ipc_client_device_update_inputs;
 	icd->base.get_tracked_pose = ipc_client_device_get_tracked_pose;
@@ -182,8 +333,7 @@ ipc_client_device_create(struct ipc_connection *ipc_c, struct xrt_tracking_origi
 	}
 
 	if (isdev->binding_profile_count > 0) {
-		icd->base.binding_profiles =
-		    U_TYPED_ARRAY_CALLOC(struct xrt_binding_profile, isdev->binding_profile_count);
+		icd->base.binding_profiles = (struct xrt_binding_profile *)(icd + 1);
 		icd->base.binding_profile_count = isdev->binding_profile_count;
 	}
 
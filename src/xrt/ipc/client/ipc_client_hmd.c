@@ -93,6 +93,10 @@ ipc_client_hmd_get_tracked_pose(struct xrt_device *xdev,
 {
 	ipc_client_hmd_t *ich = ipc_client_hmd(xdev);
 
+	if (ipc_client_get_shared_pose(ich->ipc_c, ich->device_id, name, at_timestamp_ns, out_relation)) {
+		return;
+	}
+
 	xrt_result_t r =
 	    ipc_call_device_get_tracked_pose(ich->ipc_c, ich->device_id, name, at_timestamp_ns, out_relation);
 	if (r != XRT_SUCCESS) {
@@ -158,6 +162,45 @@ ipc_client_hmd_compute_distortion(
 	return ret;
 }
 
+static bool
+ipc_client_hmd_compute_distortion_batch(struct xrt_device *xdev,
+                                        uint32_t view,
+                                        uint32_t count,
+                                        const struct xrt_vec2 *uvs,
+                                        struct xrt_uv_triplet *out_results)
+{
+	ipc_client_hmd_t *ich = ipc_client_hmd(xdev);
+
+	struct ipc_arg_distortion_triplets triplets;
+	struct ipc_arg_distortion_uvs args;
+
+	// One round trip per IPC_MAX_DISTORTION_POINTS points.
+	for (uint32_t first = 0; first < count; first += IPC_MAX_DISTORTION_POINTS) {
+		args.count = MIN(count - first, IPC_MAX_DISTORTION_POINTS);
+		memcpy(args.uvs, &uvs[first], sizeof(*uvs) * args.count);
+
+		bool ret;
+		xrt_result_t xret = ipc_call_device_compute_distortion_batch( //
+		    ich->ipc_c,                                               //
+		    ich->device_id,                                           //
+		    view,                                                     //
+		    &args,                                                    //
+		    &ret,                                                     //
+		    &triplets);                                               //
+		if (xret != XRT_SUCCESS) {
+			IPC_ERROR(ich->ipc_c, "Error calling compute distortion batch!");
+			return false;
+		}
+		if (!ret) {
+			return false;
+		}
+
+		memcpy(&out_results[first], triplets.triplets, sizeof(*out_results) * args.count);
+	}
+
+	return true;
+}
+
 static bool
 ipc_client_hmd_is_form_factor_available(struct xrt_device *xdev, enum xrt_form_factor form_factor)
 {
@@ -189,6 +232,7 @@ ipc_client_hmd_create(struct ipc_connection *ipc_c, struct xrt_tracking_origin *
 	ich->base.get_tracked_pose = ipc_client_hmd_get_tracked_pose;
 	ich->base.get_view_poses = ipc_client_hmd_get_view_poses;
 	ich->base.compute_distortion = ipc_client_hmd_compute_distortion;
+	ich->base.compute_distortion_batch = ipc_client_hmd_compute_distortion_batch;
 	ich->base.destroy = ipc_client_hmd_destroy;
 	ich->base.is_form_factor_available = ipc_client_hmd_is_form_factor_available;
 
@@ -85,6 +85,54 @@ ipc_client_instance(struct xrt_instance *xinst)
 	return (struct ipc_client_instance *)xinst;
 }
 
+/*!
+ * Adds batched input updates to @ref u_system_devices.
+ *
+ * @implements xrt_system_devices
+ */
+struct ipc_client_system_devices
+{
+	//! @public Base
+	struct u_system_devices base;
+
+	//! Connection, owned by the instance which outlives this.
+	struct ipc_connection *ipc_c;
+};
+
+static inline struct ipc_client_system_devices *
+ipc_client_system_devices(struct xrt_system_devices *xsysd)
+{
+	return (struct ipc_client_system_devices *)xsysd;
+}
+
+static xrt_result_t
+ipc_client_system_devices_update_inputs(struct xrt_system_devices *xsysd)
+{
+	struct ipc_client_system_devices *icsd = ipc_client_system_devices(xsysd);
+
+	// One round trip for all devices, the inputs point into the shared memory.
+	xrt_result_t xret = ipc_call_system_update_inputs(icsd->ipc_c);
+	if (xret != XRT_SUCCESS) {
+		IPC_ERROR(icsd->ipc_c, "Error calling system input update!");
+	}
+
+	return xret;
+}
+
+static void
+ipc_client_system_devices_destroy(struct xrt_system_devices *xsysd)
+{
+	struct ipc_client_system_devices *icsd = ipc_client_system_devices(xsysd);
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(icsd->base.base.xdevs); i++) {
+		xrt_device_destroy(&icsd->base.base.xdevs[i]);
+	}
+
+	xrt_frame_context_destroy_nodes(&icsd->base.xfctx);
+
+	free(icsd);
+}
+
 static xrt_result_t
 create_system_compositor(struct ipc_client_instance *ii,
                          struct xrt_device *xdev,
@@ -129,8 +177,13 @@ ipc_client_instance_create_system(struct xrt_instance *xinst,
 	assert(*out_xsysd == NULL);
 	assert(out_xsysc == NULL || *out_xsysc == NULL);
 
-	// Allocate a helper u_system_devices struct.
-	struct u_system_devices *usysd = u_system_devices_allocate();
+	// Allocate a u_system_devices struct that can batch input updates.
+	struct ipc_client_system_devices *icsd = U_TYPED_CALLOC(struct ipc_client_system_devices);
+	icsd->base.base.update_inputs = ipc_client_system_devices_update_inputs;
+	icsd->base.base.destroy = ipc_client_system_devices_destroy;
+	icsd->ipc_c = &ii->ipc_c;
+
+	struct u_system_devices *usysd = &icsd->base;
 
 	// Take the devices from this instance.
 	for (uint32_t i = 0; i < ii->xdev_count; i++) {
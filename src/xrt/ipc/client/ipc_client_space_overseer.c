@@ -9,6 +9,8 @@
 
 #include "xrt/xrt_space.h"
 
+#include "math/m_space.h"
+
 #include "ipc_client_generated.h"
 
 
@@ -149,6 +151,58 @@ locate_space(struct xrt_space_overseer *xso,
 	    out_relation);                  //
 }
 
+static xrt_result_t
+locate_spaces(struct xrt_space_overseer *xso,
+              struct xrt_space *base_space,
+              const struct xrt_pose *base_offset,
+              uint64_t at_timestamp_ns,
+              struct xrt_space **spaces,
+              uint32_t space_count,
+              const struct xrt_pose *offsets,
+              struct xrt_space_relation *out_relations)
+{
+	struct ipc_client_space_overseer *icspo = ipc_client_space_overseer(xso);
+
+	struct ipc_client_space *icsp_base_space = ipc_client_space(base_space);
+	struct ipc_arg_space_relations relations;
+	struct ipc_arg_space_ids ids;
+	xrt_result_t xret;
+
+	// One round trip per IPC_MAX_LOCATE_SPACES spaces.
+	for (uint32_t first = 0; first < space_count; first += IPC_MAX_LOCATE_SPACES) {
+		ids.count = MIN(space_count - first, IPC_MAX_LOCATE_SPACES);
+		for (uint32_t i = 0; i < ids.count; i++) {
+			ids.ids[i] = ipc_client_space(spaces[first + i])->id;
+		}
+
+		xret = ipc_call_space_locate_spaces( //
+		    icspo->ipc_c,                    //
+		    icsp_base_space->id,             //
+		    base_offset,                     //
+		    at_timestamp_ns,                 //
+		    &ids,                            //
+		    &relations);                     //
+		if (xret != XRT_SUCCESS) {
+			return xret;
+		}
+
+		for (uint32_t i = 0; i < ids.count; i++) {
+			// The server doesn't apply the per space offsets, saves on message size.
+			if (offsets == NULL || m_pose_is_identity(&offsets[first + i])) {
+				out_relations[first + i] = relations.relations[i];
+				continue;
+			}
+
+			struct xrt_relation_chain xrc = {0};
+			m_relation_chain_push_pose(&xrc, &offsets[first + i]);
+			m_relation_chain_push_relation(&xrc, &relations.relations[i]);
+			m_relation_chain_resolve(&xrc, &out_relations[first + i]);
+		}
+	}
+
+	return XRT_SUCCESS;
+}
+
 static xrt_result_t
 locate_device(struct xrt_space_overseer *xso,
               struct xrt_space *base_space,
@@ -199,6 +253,7 @@ ipc_client_space_overseer_create(struct ipc_connection *ipc_c)
 	icspo->base.create_offset_space = create_offset_space;
 	icspo->base.create_pose_space = create_pose_space;
 	icspo->base.locate_space = locate_space;
+	icspo->base.locate_spaces = locate_spaces;
 	icspo->base.locate_device = locate_device;
 	icspo->base.destroy = destroy;
 	icspo->ipc_c = ipc_c;
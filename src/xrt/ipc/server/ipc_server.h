@@ -47,7 +47,7 @@ extern "C" {
  */
 
 #define IPC_MAX_CLIENT_SEMAPHORES 8
-#define IPC_MAX_CLIENT_SWAPCHAINS 32
+#define IPC_MAX_CLIENT_SWAPCHAIN_CACHE 4
 #define IPC_MAX_CLIENT_SPACES 128
 //#define IPC_MAX_CLIENTS 8
 
@@ -68,9 +68,37 @@ struct ipc_swapchain_data
 	uint64_t format;
 	uint32_t image_count;
 
+	//! Full create info, compared against when reusing swapchains.
+	struct xrt_swapchain_create_info info;
+
+	//! Release count of the shared swapchain state when last passed on to the compositor.
+	uint32_t release_count;
+
+	//! Created by the compositor, not imported, so can be reused.
+	bool cacheable;
+
+	//! GPU memory of all of the images.
+	uint64_t memory_size;
+
 	bool active;
 };
 
+/*!
+ * A swapchain destroyed by the client that is kept around, so that creating a
+ * new swapchain with the same create info doesn't reallocate the images.
+ *
+ * @ingroup ipc_server
+ */
+struct ipc_swapchain_cache_entry
+{
+	struct xrt_swapchain_create_info info;
+
+	struct xrt_swapchain *xsc;
+
+	//! GPU memory of all of the images.
+	uint64_t memory_size;
+};
+
 /*!
  * Holds the state for a single client.
  *
@@ -96,6 +124,9 @@ struct ipc_client_state
 	//! Data for the swapchains.
 	struct ipc_swapchain_data swapchain_data[IPC_MAX_CLIENT_SWAPCHAINS];
 
+	//! Recently destroyed swapchains, oldest first, holds a reference.
+	struct ipc_swapchain_cache_entry swapchain_cache[IPC_MAX_CLIENT_SWAPCHAIN_CACHE];
+
 	//! Number of compositor semaphores in use by client
 	uint32_t compositor_semaphore_count;
 
@@ -122,6 +153,12 @@ struct ipc_client_state
 	struct ipc_app_state client_state;
 
 	int server_thread_index;
+
+	//! The client makes channel calls over @ref ipc_shared_channel instead of the socket.
+	bool channel_enabled;
+
+	//! The call being dispatched came from the channel, so the reply goes there too.
+	bool channel_dispatching;
 };
 
 enum ipc_thread_state
@@ -299,6 +336,76 @@ ipc_server_mainloop_init(struct ipc_server_mainloop *ml);
 void
 ipc_server_mainloop_poll(struct ipc_server *vs, struct ipc_server_mainloop *ml);
 
+/*!
+ * Max number of threads in @ref ipc_server_worker_pool.
+ */
+#define IPC_SERVER_MAX_WORKERS 8
+
+/*!
+ * A small fixed pool of threads servicing all client sockets through a single
+ * epoll, used instead of one thread per client when enabled. Each socket is
+ * armed one-shot, so only one worker at a time handles any given client and
+ * its messages are still dispatched in order.
+ *
+ * @ingroup ipc_server
+ */
+struct ipc_server_worker_pool
+{
+	//! Is the pool used instead of per client threads.
+	bool enabled;
+
+	//! Should the workers keep running.
+	volatile bool running;
+
+	//! Epoll fd with all client sockets registered.
+	int epoll_fd;
+
+	//! Number of started threads.
+	uint32_t thread_count;
+
+	struct os_thread threads[IPC_SERVER_MAX_WORKERS];
+
+	/*!
+	 * Partially received messages, indexed like @ref ipc_server::threads.
+	 * Owned by the worker currently servicing that client.
+	 */
+	struct
+	{
+		uint8_t data[IPC_BUF_SIZE];
+		size_t filled;
+	} buffers[IPC_MAX_CLIENTS];
+};
+
+#if (defined(XRT_OS_LINUX) && !defined(XRT_OS_ANDROID)) || defined(XRT_DOXYGEN)
+/*!
+ * Create the epoll and start @p worker_count threads.
+ *
+ * @return <0 on error.
+ * @public @memberof ipc_server_worker_pool
+ */
+int
+ipc_server_worker_pool_init(struct ipc_server *s, uint32_t worker_count);
+
+/*!
+ * Stop and join all threads, then tear down any clients still connected.
+ * Safe to call if the pool was never initialized.
+ *
+ * @public @memberof ipc_server_worker_pool
+ */
+void
+ipc_server_worker_pool_fini(struct ipc_server *s);
+
+/*!
+ * Hand the client in slot @p client_index over to the pool, its state must
+ * already be set up. Called with the global state lock held.
+ *
+ * @return <0 on error.
+ * @public @memberof ipc_server_worker_pool
+ */
+int
+ipc_server_worker_pool_add_client(struct ipc_server *s, uint32_t client_index);
+#endif
+
 /*!
  * Main IPC object for the server.
  *
@@ -328,14 +435,56 @@ struct ipc_server
 	struct ipc_shared_memory *ism;
 	xrt_shmem_handle_t ism_handle;
 
+	/*!
+	 * Next free entries of the arrays in the shared memory, devices
+	 * hotplugged after startup are added after the others.
+	 */
+	struct
+	{
+		uint32_t input;
+		uint32_t output;
+		uint32_t binding;
+		uint32_t input_pair;
+		uint32_t output_pair;
+	} shm_next;
+
+	/*!
+	 * The binding table each shared device got its bindings from. Drivers
+	 * share static tables between devices of the same kind, those are only
+	 * copied into the shared memory once and the devices share the entries.
+	 */
+	struct xrt_binding_profile *shm_binding_sources[XRT_SYSTEM_MAX_DEVICES];
+
+	//! Publishes device poses into shared memory, only started if enabled.
+	struct os_thread_helper pose_publisher;
+
 	struct ipc_server_mainloop ml;
 
+	//! Services clients when enabled, instead of one thread each.
+	struct ipc_server_worker_pool pool;
+
 	// Is the mainloop supposed to run.
 	volatile bool running;
 
 	// Should we exit when a client disconnects.
 	bool exit_on_disconnect;
 
+	//! Should devices plugged in while running be added.
+	bool hotplug;
+
+	//! Limits on the GPU memory used by the swapchain images of clients.
+	struct
+	{
+		//! Memory each client may have in swapchain images, zero for no limit.
+		uint64_t client_max_size;
+
+		//! Fraction of the device's memory budget above which new swapchains are refused.
+		double budget_fraction;
+	} swapchain_memory;
+
+	//! Layers a client that isn't the primary application may submit, zero for no limit.
+	uint32_t client_max_layers;
+
 	enum u_logging_level log_level;
 
 	struct ipc_thread threads[IPC_MAX_CLIENTS];
@@ -436,6 +585,38 @@ ipc_server_update_state(struct ipc_server *s);
 void *
 ipc_server_client_thread(void *_ics);
 
+#ifndef XRT_OS_WINDOWS
+/*!
+ * Receive whatever is waiting on the client socket and dispatch all complete
+ * messages. @p buf holds any partial message between calls, and must be
+ * @ref IPC_BUF_SIZE big.
+ *
+ * @return false if the client should be disconnected.
+ *
+ * @ingroup ipc_server
+ */
+bool
+ipc_server_client_receive(volatile struct ipc_client_state *ics, uint8_t *buf, size_t *inout_filled);
+#endif
+
+/*!
+ * Send the reply of a call marked `"channel": true`, on the shared memory
+ * channel if that's where the call came from, otherwise on the socket.
+ *
+ * @ingroup ipc_server
+ */
+xrt_result_t
+ipc_server_reply(volatile struct ipc_client_state *ics, const void *data, size_t size);
+
+/*!
+ * Tear down all client state after it has disconnected, closes the channel and
+ * frees the client slot.
+ *
+ * @ingroup ipc_server
+ */
+void
+ipc_server_client_disconnected(volatile struct ipc_client_state *ics);
+
 /*!
  * This destroys the native compositor for this client and any extra objects
  * created from it, like all of the swapchains.
@@ -502,6 +683,52 @@ get_idev(volatile struct ipc_client_state *ics, uint32_t device_id)
 	return &ics->server->idevs[device_id];
 }
 
+/*!
+ * Index of the swapchain's state in @ref ipc_shared_memory::swapchains.
+ */
+static inline uint32_t
+ipc_server_shared_swapchain_index(volatile struct ipc_client_state *ics, uint32_t id)
+{
+	return (uint32_t)ics->server_thread_index * IPC_MAX_CLIENT_SWAPCHAINS + id;
+}
+
+/*!
+ * Get the shared memory state of a swapchain, where the client keeps its index
+ * FIFO and image ownership.
+ */
+static inline struct ipc_shared_swapchain *
+ipc_server_get_shared_swapchain(volatile struct ipc_client_state *ics, uint32_t id)
+{
+	return &ics->server->ism->swapchains[ipc_server_shared_swapchain_index(ics, id)];
+}
+
+/*!
+ * Get the shared memory scratch area of the client, where the generated
+ * dispatch code has the handler write its `"shm": true` outputs.
+ */
+static inline void *
+ipc_server_scratch_begin(volatile struct ipc_client_state *ics)
+{
+	return ics->server->ism->scratch[ics->server_thread_index].data;
+}
+
+/*!
+ * Publish the data written to the scratch area, fills in the reference that
+ * is sent back to the client in place of the data.
+ */
+static inline void
+ipc_server_scratch_end(volatile struct ipc_client_state *ics, struct ipc_shm_ref *out_ref)
+{
+	struct ipc_shared_memory *ism = ics->server->ism;
+	struct ipc_shared_scratch *iss = &ism->scratch[ics->server_thread_index];
+
+	uint32_t generation = (uint32_t)iss->generation + 1;
+	iss->generation = generation;
+
+	out_ref->offset = (uint32_t)((uint8_t *)iss->data - (uint8_t *)ism);
+	out_ref->generation = generation;
+}
+
 
 #ifdef __cplusplus
 }
@@ -10,9 +10,12 @@
  */
 
 #include "util/u_misc.h"
+#include "util/u_pacing.h"
 #include "util/u_handles.h"
 #include "util/u_trace_marker.h"
 
+#include "shared/ipc_hand_joints.h"
+
 #include "server/ipc_server.h"
 #include "ipc_server_generated.h"
 
@@ -20,6 +23,8 @@
 #include <unistd.h>
 #endif
 
+#include <inttypes.h>
+
 
 /*
  *
@@ -46,6 +51,57 @@ validate_device_id(volatile struct ipc_client_state *ics, int64_t device_id, str
 	return XRT_SUCCESS;
 }
 
+/*!
+ * Update the inputs of a device and copy them into the shared memory,
+ * returns true if the data in the shared memory changed.
+ */
+static bool
+update_device_inputs(volatile struct ipc_client_state *ics, uint32_t device_id)
+{
+	struct ipc_shared_memory *ism = ics->server->ism;
+	struct ipc_device *idev = get_idev(ics, device_id);
+	struct xrt_device *xdev = idev->xdev;
+	struct ipc_shared_device *isdev = &ism->isdevs[device_id];
+
+	// Update inputs.
+	xrt_device_update_inputs(xdev);
+
+	// Copy data into the shared memory.
+	struct xrt_input *src = xdev->inputs;
+	struct xrt_input *dst = &ism->inputs[isdev->first_input_index];
+	size_t size = sizeof(struct xrt_input) * isdev->input_count;
+
+	bool io_active = ics->io_active && idev->io_active;
+	if (io_active) {
+		if (memcmp(dst, src, size) == 0) {
+			return false;
+		}
+
+		memcpy(dst, src, size);
+
+		return true;
+	}
+
+	bool changed = false;
+	for (uint32_t i = 0; i < isdev->input_count; i++) {
+		struct xrt_input value;
+		U_ZERO(&value);
+		value.name = src[i].name;
+
+		// Special case the rotation of the head.
+		if (value.name == XRT_INPUT_GENERIC_HEAD_POSE) {
+			value.active = src[i].active;
+		}
+
+		if (memcmp(&dst[i], &value, sizeof(value)) != 0) {
+			dst[i] = value;
+			changed = true;
+		}
+	}
+
+	return changed;
+}
+
 static xrt_result_t
 validate_swapchain_state(volatile struct ipc_client_state *ics, uint32_t *out_index)
 {
@@ -67,6 +123,19 @@ validate_swapchain_state(volatile struct ipc_client_state *ics, uint32_t *out_in
 	return XRT_SUCCESS;
 }
 
+static uint64_t
+get_swapchain_memory_size(struct xrt_swapchain *xsc)
+{
+	struct xrt_swapchain_native *xscn = (struct xrt_swapchain_native *)xsc;
+
+	uint64_t size = 0;
+	for (uint32_t i = 0; i < xsc->image_count; i++) {
+		size += xscn->images[i].size;
+	}
+
+	return size;
+}
+
 static void
 set_swapchain_info(volatile struct ipc_client_state *ics,
                    uint32_t index,
@@ -79,6 +148,259 @@ set_swapchain_info(volatile struct ipc_client_state *ics,
 	ics->swapchain_data[index].height = info->height;
 	ics->swapchain_data[index].format = info->format;
 	ics->swapchain_data[index].image_count = xsc->image_count;
+	ics->swapchain_data[index].info = *info;
+	ics->swapchain_data[index].release_count = 0;
+	ics->swapchain_data[index].cacheable = false;
+	ics->swapchain_data[index].memory_size = get_swapchain_memory_size(xsc);
+
+	// All images start out available, in order, like in the compositor's swapchain.
+	struct ipc_shared_swapchain *iss = ipc_server_get_shared_swapchain(ics, index);
+	U_ZERO(iss);
+	iss->image_count = xsc->image_count;
+	for (uint32_t i = 0; i < xsc->image_count; i++) {
+		iss->fifo[i] = i;
+	}
+}
+
+/*!
+ * Acquiring and releasing images is done by the client in shared memory, let
+ * the compositor's swapchains know about new releases so that it can tell that
+ * their content has changed.
+ */
+static void
+sync_swapchain_releases(volatile struct ipc_client_state *ics)
+{
+	for (uint32_t i = 0; i < IPC_MAX_CLIENT_SWAPCHAINS; i++) {
+		volatile struct ipc_swapchain_data *data = &ics->swapchain_data[i];
+		if (!data->active) {
+			continue;
+		}
+
+		uint32_t release_count = (uint32_t)ipc_server_get_shared_swapchain(ics, i)->release_count;
+		if (release_count == data->release_count) {
+			continue;
+		}
+
+		data->release_count = release_count;
+
+		// Nothing else takes images from the compositor's swapchain, so a release always fits.
+		uint32_t index = 0;
+		if (xrt_swapchain_acquire_image(ics->xscs[i], &index) == XRT_SUCCESS) {
+			xrt_swapchain_release_image(ics->xscs[i], index);
+		}
+	}
+}
+
+/*!
+ * Copy the latest frame timings of the client's session to its area of the
+ * shared memory, readers retry while the sequence is odd or changed.
+ */
+static void
+publish_frame_stats(volatile struct ipc_client_state *ics)
+{
+	struct xrt_compositor_frame_stats stats = {0};
+	if (xrt_comp_get_frame_stats(ics->xc, &stats) != XRT_SUCCESS) {
+		return;
+	}
+
+	struct ipc_shared_frame_stats *isfs = &ics->server->ism->frame_stats[ics->server_thread_index];
+
+	// Odd sequence, readers will retry until we are done. Full barrier.
+	xrt_atomic_s32_inc_return(&isfs->sequence);
+
+	isfs->stats = stats;
+	isfs->valid = true;
+
+	// Even again, also a full barrier.
+	xrt_atomic_s32_inc_return(&isfs->sequence);
+}
+
+static bool
+swapchain_create_info_equal(const struct xrt_swapchain_create_info *a, const struct xrt_swapchain_create_info *b)
+{
+	return a->create == b->create &&             //
+	       a->bits == b->bits &&                 //
+	       a->format == b->format &&             //
+	       a->sample_count == b->sample_count && //
+	       a->width == b->width &&               //
+	       a->height == b->height &&             //
+	       a->face_count == b->face_count &&     //
+	       a->array_size == b->array_size &&     //
+	       a->mip_count == b->mip_count;         //
+}
+
+/*!
+ * Take a swapchain matching the create info out of the cache, the reference
+ * is transferred to the caller, returns NULL if there is none.
+ */
+static struct xrt_swapchain *
+take_cached_swapchain(volatile struct ipc_client_state *ics, const struct xrt_swapchain_create_info *info)
+{
+	// Cast away volatile.
+	struct ipc_swapchain_cache_entry *cache = (struct ipc_swapchain_cache_entry *)ics->swapchain_cache;
+
+	// Newest first.
+	for (uint32_t i = IPC_MAX_CLIENT_SWAPCHAIN_CACHE; i > 0; i--) {
+		struct ipc_swapchain_cache_entry *entry = &cache[i - 1];
+
+		if (entry->xsc == NULL || !swapchain_create_info_equal(&entry->info, info)) {
+			continue;
+		}
+
+		struct xrt_swapchain *xsc = entry->xsc;
+		entry->xsc = NULL;
+
+		return xsc;
+	}
+
+	return NULL;
+}
+
+/*!
+ * Move the reference of a destroyed swapchain into the cache, the oldest entry
+ * is dropped if the cache is full.
+ */
+static void
+cache_swapchain(volatile struct ipc_client_state *ics,
+                const struct xrt_swapchain_create_info *info,
+                struct xrt_swapchain **xsc_ptr)
+{
+	// Cast away volatile.
+	struct ipc_swapchain_cache_entry *cache = (struct ipc_swapchain_cache_entry *)ics->swapchain_cache;
+
+	// Compact the entries, so that the free ones are at the end.
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < IPC_MAX_CLIENT_SWAPCHAIN_CACHE; i++) {
+		if (cache[i].xsc == NULL) {
+			continue;
+		}
+		if (count != i) {
+			cache[count] = cache[i];
+			cache[i].xsc = NULL;
+		}
+		count++;
+	}
+
+	if (count >= IPC_MAX_CLIENT_SWAPCHAIN_CACHE) {
+		xrt_swapchain_reference(&cache[0].xsc, NULL);
+
+		for (uint32_t i = 1; i < IPC_MAX_CLIENT_SWAPCHAIN_CACHE; i++) {
+			cache[i - 1] = cache[i];
+		}
+		count = IPC_MAX_CLIENT_SWAPCHAIN_CACHE - 1;
+	}
+
+	cache[count].info = *info;
+	cache[count].xsc = *xsc_ptr;
+	cache[count].memory_size = get_swapchain_memory_size(*xsc_ptr);
+	*xsc_ptr = NULL;
+}
+
+/*!
+ * Sum up the GPU memory of the client's swapchains, the cached ones still hold
+ * on to their images so are included, and publish it in the app state.
+ */
+static uint64_t
+update_swapchain_memory(volatile struct ipc_client_state *ics)
+{
+	uint64_t size = 0;
+
+	for (uint32_t i = 0; i < IPC_MAX_CLIENT_SWAPCHAINS; i++) {
+		if (ics->swapchain_data[i].active) {
+			size += ics->swapchain_data[i].memory_size;
+		}
+	}
+
+	for (uint32_t i = 0; i < IPC_MAX_CLIENT_SWAPCHAIN_CACHE; i++) {
+		if (ics->swapchain_cache[i].xsc != NULL) {
+			size += ics->swapchain_cache[i].memory_size;
+		}
+	}
+
+	// Read by other threads for monado-ctl.
+	os_mutex_lock(&ics->server->global_state.lock);
+	ics->client_state.swapchain_memory = size;
+	os_mutex_unlock(&ics->server->global_state.lock);
+
+	return size;
+}
+
+static void
+drop_cached_swapchains(volatile struct ipc_client_state *ics)
+{
+	for (uint32_t i = 0; i < IPC_MAX_CLIENT_SWAPCHAIN_CACHE; i++) {
+		// Drop our reference, does NULL checking. Cast away volatile.
+		xrt_swapchain_reference((struct xrt_swapchain **)&ics->swapchain_cache[i].xsc, NULL);
+	}
+
+	update_swapchain_memory(ics);
+}
+
+/*!
+ * Refuse new swapchains when the device is close to its memory budget, so
+ * that a single client can't push the memory of the compositor and the other
+ * clients into eviction. The client's cached swapchains are freed first.
+ */
+static xrt_result_t
+check_memory_budget(volatile struct ipc_client_state *ics)
+{
+	double fraction = ics->server->swapchain_memory.budget_fraction;
+	if (fraction <= 0.0) {
+		return XRT_SUCCESS;
+	}
+
+	struct xrt_compositor_memory_budget budget = {0};
+	xrt_result_t xret = xrt_comp_get_memory_budget(ics->xc, &budget);
+	if (xret != XRT_SUCCESS || budget.budget_bytes == 0) {
+		// Nothing to go on, leave it to the allocation.
+		return XRT_SUCCESS;
+	}
+
+	uint64_t limit = (uint64_t)((double)budget.budget_bytes * fraction);
+	if (budget.usage_bytes < limit) {
+		return XRT_SUCCESS;
+	}
+
+	drop_cached_swapchains(ics);
+
+	xret = xrt_comp_get_memory_budget(ics->xc, &budget);
+	if (xret == XRT_SUCCESS && budget.usage_bytes < limit) {
+		return XRT_SUCCESS;
+	}
+
+	IPC_WARN(ics->server, "Refusing swapchain for client %u, GPU memory use %" PRIu64 " of %" PRIu64 " MiB budget",
+	         ics->client_state.id, budget.usage_bytes / (1024 * 1024), budget.budget_bytes / (1024 * 1024));
+
+	return XRT_ERROR_ALLOCATION;
+}
+
+/*!
+ * Check that a new swapchain of @p new_size keeps the client within its
+ * configured limit, dropping its cached swapchains if that makes it fit.
+ */
+static xrt_result_t
+check_client_memory_limit(volatile struct ipc_client_state *ics, uint64_t new_size)
+{
+	uint64_t max_size = ics->server->swapchain_memory.client_max_size;
+	if (max_size == 0) {
+		return XRT_SUCCESS;
+	}
+
+	if (update_swapchain_memory(ics) + new_size <= max_size) {
+		return XRT_SUCCESS;
+	}
+
+	drop_cached_swapchains(ics);
+
+	uint64_t size = update_swapchain_memory(ics);
+	if (size + new_size <= max_size) {
+		return XRT_SUCCESS;
+	}
+
+	IPC_WARN(ics->server, "Refusing swapchain for client %u, %" PRIu64 " MiB used of its %" PRIu64 " MiB limit",
+	         ics->client_state.id, size / (1024 * 1024), max_size / (1024 * 1024));
+
+	return XRT_ERROR_ALLOCATION;
 }
 
 static xrt_result_t
@@ -180,6 +502,28 @@ ipc_handle_instance_describe_client(volatile struct ipc_client_state *ics,
 	return XRT_SUCCESS;
 }
 
+xrt_result_t
+ipc_handle_instance_enable_channel(volatile struct ipc_client_state *ics, uint32_t *out_channel_id)
+{
+#ifdef XRT_OS_LINUX
+	struct ipc_shared_channel *ch = &ics->server->ism->channels[ics->server_thread_index];
+
+	// Left over from a previous client in this slot.
+	U_ZERO(ch);
+
+	// The client thread switches over once this reply has been sent.
+	ics->channel_enabled = true;
+	*out_channel_id = (uint32_t)ics->server_thread_index;
+
+	IPC_INFO(ics->server, "Client %u enabled the shared memory channel", ics->client_state.id);
+
+	return XRT_SUCCESS;
+#else
+	// No futex, so nothing to wait on.
+	return XRT_ERROR_IPC_FAILURE;
+#endif
+}
+
 xrt_result_t
 ipc_handle_system_compositor_get_info(volatile struct ipc_client_state *ics,
                                       struct xrt_system_compositor_info *out_info)
@@ -192,7 +536,34 @@ ipc_handle_system_compositor_get_info(volatile struct ipc_client_state *ics,
 }
 
 xrt_result_t
-ipc_handle_session_create(volatile struct ipc_client_state *ics, const struct xrt_session_info *xsi)
+ipc_handle_system_compositor_get_frame_records(volatile struct ipc_client_state *ics,
+                                               uint32_t next,
+                                               struct ipc_arg_frame_records *out_records)
+{
+	IPC_TRACE_MARKER();
+
+	uint32_t count = u_pc_frame_records_read(&next, out_records->records, ARRAY_SIZE(out_records->records));
+
+	out_records->next = next;
+	out_records->record_count = count;
+
+	return XRT_SUCCESS;
+}
+
+xrt_result_t
+ipc_handle_system_compositor_set_perf_overlay(volatile struct ipc_client_state *ics, bool enabled)
+{
+	IPC_TRACE_MARKER();
+
+	u_pc_overlay_set_enabled(enabled);
+
+	return XRT_SUCCESS;
+}
+
+xrt_result_t
+ipc_handle_session_create(volatile struct ipc_client_state *ics,
+                          const struct xrt_session_info *xsi,
+                          uint32_t *out_frame_stats_index)
 {
 	IPC_TRACE_MARKER();
 
@@ -215,6 +586,11 @@ ipc_handle_session_create(volatile struct ipc_client_state *ics, const struct xr
 	xrt_syscomp_set_state(ics->server->xsysc, ics->xc, ics->client_state.session_visible,
 	                      ics->client_state.session_focused);
 	xrt_syscomp_set_z_order(ics->server->xsysc, ics->xc, ics->client_state.z_order);
+	xrt_syscomp_set_rate_divisor(ics->server->xsysc, ics->xc, ics->client_state.rate_divisor);
+
+	// Nothing written yet, the previous client of this thread might have left stats behind.
+	ics->server->ism->frame_stats[ics->server_thread_index].valid = false;
+	*out_frame_stats_index = ics->server_thread_index;
 
 	return XRT_SUCCESS;
 }
@@ -416,6 +792,52 @@ ipc_handle_space_locate_space(volatile struct ipc_client_state *ics,
 	    out_relation);                      //
 }
 
+xrt_result_t
+ipc_handle_space_locate_spaces(volatile struct ipc_client_state *ics,
+                               uint32_t base_space_id,
+                               const struct xrt_pose *base_offset,
+                               uint64_t at_timestamp,
+                               const struct ipc_arg_space_ids *spaces,
+                               struct ipc_arg_space_relations *out_relations)
+{
+	IPC_TRACE_MARKER();
+
+	struct xrt_space_overseer *xso = ics->server->xso;
+	struct xrt_space *base_space = NULL;
+	struct xrt_space *xspaces[IPC_MAX_LOCATE_SPACES] = {0};
+	xrt_result_t xret;
+
+	if (spaces->count > IPC_MAX_LOCATE_SPACES) {
+		U_LOG_E("Too many spaces %u > %u!", spaces->count, IPC_MAX_LOCATE_SPACES);
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	xret = validate_space_id(ics, base_space_id, &base_space);
+	if (xret != XRT_SUCCESS) {
+		U_LOG_E("Invalid base_space_id!");
+		return xret;
+	}
+
+	for (uint32_t i = 0; i < spaces->count; i++) {
+		xret = validate_space_id(ics, spaces->ids[i], &xspaces[i]);
+		if (xret != XRT_SUCCESS) {
+			U_LOG_E("Invalid space_id!");
+			return xret;
+		}
+	}
+
+	// The client applies the per space offsets itself.
+	return xrt_space_overseer_locate_spaces( //
+	    xso,                                 //
+	    base_space,                          //
+	    base_offset,                         //
+	    at_timestamp,                        //
+	    xspaces,                             //
+	    spaces->count,                       //
+	    NULL,                                //
+	    out_relations->relations);           //
+}
+
 xrt_result_t
 ipc_handle_space_locate_device(volatile struct ipc_client_state *ics,
                                uint32_t base_space_id,
@@ -811,6 +1233,54 @@ _update_layers(volatile struct ipc_client_state *ics, struct xrt_compositor *xc,
 	return true;
 }
 
+/*!
+ * Clients other than the primary application may only submit a limited number
+ * of layers, the topmost ones past the limit are dropped. While over the limit
+ * the client is also paced at half its rate, so a misbehaving overlay can't
+ * take compositor time away from the primary application.
+ */
+static void
+apply_layer_quota(volatile struct ipc_client_state *ics, struct ipc_layer_slot *slot)
+{
+	struct ipc_server *s = ics->server;
+	uint32_t max_layers = s->client_max_layers;
+	if (max_layers == 0 || ics->client_state.priority == IPC_CLIENT_PRIORITY_HIGH) {
+		return;
+	}
+
+	uint32_t layer_count = slot->layer_count;
+	bool over = layer_count > max_layers;
+	if (over) {
+		slot->layer_count = max_layers;
+	}
+
+	if (over == ics->client_state.over_quota) {
+		return;
+	}
+
+	os_mutex_lock(&s->global_state.lock);
+
+	// The priority might have changed since, that also resets the quota state.
+	if (ics->client_state.priority != IPC_CLIENT_PRIORITY_HIGH && over != ics->client_state.over_quota) {
+		uint32_t rate_divisor = ics->client_state.rate_divisor;
+		rate_divisor = over ? rate_divisor * 2 : rate_divisor / 2;
+		if (rate_divisor < 1) {
+			rate_divisor = 1;
+		}
+
+		if (over) {
+			IPC_WARN(s, "Client %u submitted %u layers, over its limit of %u, dropping the rest",
+			         ics->client_state.id, layer_count, max_layers);
+		}
+
+		ics->client_state.over_quota = over;
+		ics->client_state.rate_divisor = rate_divisor;
+		xrt_syscomp_set_rate_divisor(s->xsysc, ics->xc, rate_divisor);
+	}
+
+	os_mutex_unlock(&s->global_state.lock);
+}
+
 xrt_result_t
 ipc_handle_compositor_layer_sync(volatile struct ipc_client_state *ics,
                                  uint32_t slot_id,
@@ -843,6 +1313,10 @@ ipc_handle_compositor_layer_sync(volatile struct ipc_client_state *ics,
 	// Copy current slot data.
 	struct ipc_layer_slot copy = *slot;
 
+	sync_swapchain_releases(ics);
+
+	apply_layer_quota(ics, &copy);
+
 
 	/*
 	 * Transfer data to underlying compositor.
@@ -854,6 +1328,8 @@ ipc_handle_compositor_layer_sync(volatile struct ipc_client_state *ics,
 
 	xrt_comp_layer_commit(ics->xc, sync_handle);
 
+	publish_frame_stats(ics);
+
 
 	/*
 	 * Manage shared state.
@@ -898,6 +1374,10 @@ ipc_handle_compositor_layer_sync_with_semaphore(volatile struct ipc_client_state
 	// Copy current slot data.
 	struct ipc_layer_slot copy = *slot;
 
+	sync_swapchain_releases(ics);
+
+	apply_layer_quota(ics, &copy);
+
 
 
 	/*
@@ -910,6 +1390,8 @@ ipc_handle_compositor_layer_sync_with_semaphore(volatile struct ipc_client_state
 
 	xrt_comp_layer_commit_with_semaphore(ics->xc, xcsem, semaphore_value);
 
+	publish_frame_stats(ics);
+
 
 	/*
 	 * Manage shared state.
@@ -925,6 +1407,65 @@ ipc_handle_compositor_layer_sync_with_semaphore(volatile struct ipc_client_state
 	return XRT_SUCCESS;
 }
 
+xrt_result_t
+ipc_handle_compositor_layer_sync_and_predict(volatile struct ipc_client_state *ics,
+                                             uint32_t slot_id,
+                                             uint32_t *out_free_slot_id,
+                                             int64_t *out_frame_id,
+                                             uint64_t *out_wake_up_time_ns,
+                                             uint64_t *out_predicted_display_time_ns,
+                                             uint64_t *out_predicted_display_period_ns,
+                                             const xrt_graphics_sync_handle_t *handles,
+                                             const uint32_t handle_count)
+{
+	IPC_TRACE_MARKER();
+
+	xrt_result_t xret = ipc_handle_compositor_layer_sync(ics, slot_id, out_free_slot_id, handles, handle_count);
+	if (xret != XRT_SUCCESS) {
+		return xret;
+	}
+
+	// Predict the next frame right away, saves the client a round trip.
+	return ipc_handle_compositor_predict_frame( //
+	    ics,                                    //
+	    out_frame_id,                           //
+	    out_wake_up_time_ns,                    //
+	    out_predicted_display_time_ns,          //
+	    out_predicted_display_period_ns);       //
+}
+
+xrt_result_t
+ipc_handle_compositor_layer_sync_with_semaphore_and_predict(volatile struct ipc_client_state *ics,
+                                                            uint32_t slot_id,
+                                                            uint32_t semaphore_id,
+                                                            uint64_t semaphore_value,
+                                                            uint32_t *out_free_slot_id,
+                                                            int64_t *out_frame_id,
+                                                            uint64_t *out_wake_up_time_ns,
+                                                            uint64_t *out_predicted_display_time_ns,
+                                                            uint64_t *out_predicted_display_period_ns)
+{
+	IPC_TRACE_MARKER();
+
+	xrt_result_t xret = ipc_handle_compositor_layer_sync_with_semaphore( //
+	    ics,                                                             //
+	    slot_id,                                                         //
+	    semaphore_id,                                                    //
+	    semaphore_value,                                                 //
+	    out_free_slot_id);                                               //
+	if (xret != XRT_SUCCESS) {
+		return xret;
+	}
+
+	// Predict the next frame right away, saves the client a round trip.
+	return ipc_handle_compositor_predict_frame( //
+	    ics,                                    //
+	    out_frame_id,                           //
+	    out_wake_up_time_ns,                    //
+	    out_predicted_display_time_ns,          //
+	    out_predicted_display_period_ns);       //
+}
+
 xrt_result_t
 ipc_handle_compositor_poll_events(volatile struct ipc_client_state *ics, union xrt_compositor_event *out_xce)
 {
@@ -1007,7 +1548,7 @@ ipc_handle_system_toggle_io_client(volatile struct ipc_client_state *_ics, uint3
 xrt_result_t
 ipc_handle_system_toggle_io_device(volatile struct ipc_client_state *ics, uint32_t device_id)
 {
-	if (device_id >= IPC_MAX_DEVICES) {
+	if (device_id >= XRT_SYSTEM_MAX_DEVICES) {
 		return XRT_ERROR_IPC_FAILURE;
 	}
 
@@ -1018,6 +1559,28 @@ ipc_handle_system_toggle_io_device(volatile struct ipc_client_state *ics, uint32
 	return XRT_SUCCESS;
 }
 
+xrt_result_t
+ipc_handle_system_update_inputs(volatile struct ipc_client_state *ics)
+{
+	struct ipc_shared_memory *ism = ics->server->ism;
+
+	bool changed = false;
+	for (uint32_t i = 0; i < ism->isdev_count; i++) {
+		if (ics->server->idevs[i].xdev == NULL) {
+			continue;
+		}
+
+		changed |= update_device_inputs(ics, i);
+	}
+
+	// Only bump once for the whole update.
+	if (changed) {
+		xrt_atomic_s32_inc_return(&ism->input_generation);
+	}
+
+	return XRT_SUCCESS;
+}
+
 xrt_result_t
 ipc_handle_swapchain_get_properties(volatile struct ipc_client_state *ics,
                                     const struct xrt_swapchain_create_info *info,
@@ -1036,6 +1599,7 @@ xrt_result_t
 ipc_handle_swapchain_create(volatile struct ipc_client_state *ics,
                             const struct xrt_swapchain_create_info *info,
                             uint32_t *out_id,
+                            uint32_t *out_shared_index,
                             uint32_t *out_image_count,
                             uint64_t *out_size,
                             bool *out_use_dedicated_allocation,
@@ -1053,17 +1617,33 @@ ipc_handle_swapchain_create(volatile struct ipc_client_state *ics,
 		return xret;
 	}
 
-	// Create the swapchain
-	struct xrt_swapchain *xsc = NULL; // Has to be NULL.
-	xret = xrt_comp_create_swapchain(ics->xc, info, &xsc);
-	if (xret != XRT_SUCCESS) {
-		if (xret == XRT_ERROR_SWAPCHAIN_FLAG_VALID_BUT_UNSUPPORTED) {
-			IPC_WARN(ics->server,
-			         "xrt_comp_create_swapchain: Attempted to create valid, but unsupported swapchain");
-		} else {
-			IPC_ERROR(ics->server, "Error xrt_comp_create_swapchain failed!");
+	// Reuse a recently destroyed swapchain, its images are already allocated.
+	struct xrt_swapchain *xsc = take_cached_swapchain(ics, info);
+	if (xsc != NULL) {
+		IPC_TRACE(ics->server, "Reusing cached swapchain for %d.", index);
+	} else {
+		xret = check_memory_budget(ics);
+		if (xret != XRT_SUCCESS) {
+			return xret;
+		}
+
+		// Create the swapchain
+		xret = xrt_comp_create_swapchain(ics->xc, info, &xsc);
+		if (xret != XRT_SUCCESS) {
+			if (xret == XRT_ERROR_SWAPCHAIN_FLAG_VALID_BUT_UNSUPPORTED) {
+				IPC_WARN(ics->server,
+				         "xrt_comp_create_swapchain: Attempted to create valid, but unsupported swapchain");
+			} else {
+				IPC_ERROR(ics->server, "Error xrt_comp_create_swapchain failed!");
+			}
+			return xret;
+		}
+
+		xret = check_client_memory_limit(ics, get_swapchain_memory_size(xsc));
+		if (xret != XRT_SUCCESS) {
+			xrt_swapchain_reference(&xsc, NULL);
+			return xret;
 		}
-		return xret;
 	}
 
 	// It's now safe to increment the number of swapchains.
@@ -1072,6 +1652,8 @@ ipc_handle_swapchain_create(volatile struct ipc_client_state *ics,
 	IPC_TRACE(ics->server, "Created swapchain %d.", index);
 
 	set_swapchain_info(ics, index, info, xsc);
+	ics->swapchain_data[index].cacheable = true;
+	update_swapchain_memory(ics);
 
 	// return our result to the caller.
 	struct xrt_swapchain_native *xscn = (struct xrt_swapchain_native *)xsc;
@@ -1089,6 +1671,7 @@ ipc_handle_swapchain_create(volatile struct ipc_client_state *ics,
 	*out_size = xscn->images[0].size;
 	*out_use_dedicated_allocation = xscn->images[0].use_dedicated_allocation;
 	*out_id = index;
+	*out_shared_index = ipc_server_shared_swapchain_index(ics, index);
 	*out_image_count = xsc->image_count;
 
 	// Setup the fds.
@@ -1105,6 +1688,7 @@ ipc_handle_swapchain_import(volatile struct ipc_client_state *ics,
                             const struct xrt_swapchain_create_info *info,
                             const struct ipc_arg_swapchain_from_native *args,
                             uint32_t *out_id,
+                            uint32_t *out_shared_index,
                             const xrt_graphics_buffer_handle_t *handles,
                             uint32_t handle_count)
 {
@@ -1145,7 +1729,9 @@ ipc_handle_swapchain_import(volatile struct ipc_client_state *ics,
 	IPC_TRACE(ics->server, "Created swapchain %d.", index);
 
 	set_swapchain_info(ics, index, info, xsc);
+	update_swapchain_memory(ics);
 	*out_id = index;
+	*out_shared_index = ipc_server_shared_swapchain_index(ics, index);
 
 	return XRT_SUCCESS;
 }
@@ -1167,35 +1753,50 @@ ipc_handle_swapchain_wait_image(volatile struct ipc_client_state *ics, uint32_t
 }
 
 xrt_result_t
-ipc_handle_swapchain_acquire_image(volatile struct ipc_client_state *ics, uint32_t id, uint32_t *out_index)
+ipc_handle_swapchain_get_release_semaphore(volatile struct ipc_client_state *ics,
+                                           uint32_t id,
+                                           uint32_t max_handle_count,
+                                           xrt_graphics_sync_handle_t *out_handles,
+                                           uint32_t *out_handle_count)
 {
 	if (ics->xc == NULL) {
 		return XRT_ERROR_IPC_SESSION_NOT_CREATED;
 	}
 
-	//! @todo Look up the index.
-	uint32_t sc_index = id;
-	struct xrt_swapchain *xsc = ics->xscs[sc_index];
+	struct xrt_swapchain *xsc = ics->xscs[id];
+	if (xsc == NULL || xsc->get_release_semaphore == NULL || max_handle_count < 1) {
+		return XRT_ERROR_IPC_FAILURE;
+	}
 
-	xrt_swapchain_acquire_image(xsc, out_index);
+	// Owned by the swapchain, not consumed by sending it.
+	xrt_graphics_sync_handle_t handle = XRT_GRAPHICS_SYNC_HANDLE_INVALID;
+	xrt_result_t xret = xrt_swapchain_get_release_semaphore(xsc, &handle);
+	if (xret != XRT_SUCCESS) {
+		return xret;
+	}
+
+	out_handles[0] = handle;
+	*out_handle_count = 1;
 
 	return XRT_SUCCESS;
 }
 
 xrt_result_t
-ipc_handle_swapchain_release_image(volatile struct ipc_client_state *ics, uint32_t id, uint32_t index)
+ipc_handle_swapchain_get_release_value(volatile struct ipc_client_state *ics,
+                                       uint32_t id,
+                                       uint32_t index,
+                                       uint64_t *out_value)
 {
 	if (ics->xc == NULL) {
 		return XRT_ERROR_IPC_SESSION_NOT_CREATED;
 	}
 
-	//! @todo Look up the index.
-	uint32_t sc_index = id;
-	struct xrt_swapchain *xsc = ics->xscs[sc_index];
-
-	xrt_swapchain_release_image(xsc, index);
+	struct xrt_swapchain *xsc = ics->xscs[id];
+	if (xsc == NULL || xsc->get_release_value == NULL || index >= xsc->image_count) {
+		return XRT_ERROR_IPC_FAILURE;
+	}
 
-	return XRT_SUCCESS;
+	return xrt_swapchain_get_release_value(xsc, index, out_value);
 }
 
 xrt_result_t
@@ -1207,10 +1808,22 @@ ipc_handle_swapchain_destroy(volatile struct ipc_client_state *ics, uint32_t id)
 
 	ics->swapchain_count--;
 
+	/*
+	 * Only swapchains with all images released can be reused, they are then
+	 * all back in the swapchain's queue in the state a new one would be in.
+	 */
+	if (ics->swapchain_data[id].cacheable && ipc_server_get_shared_swapchain(ics, id)->acquired == 0) {
+		// Cast away volatile.
+		cache_swapchain(ics, (struct xrt_swapchain_create_info *)&ics->swapchain_data[id].info,
+		                (struct xrt_swapchain **)&ics->xscs[id]);
+	}
+
 	// Drop our reference, does NULL checking. Cast away volatile.
 	xrt_swapchain_reference((struct xrt_swapchain **)&ics->xscs[id], NULL);
 	ics->swapchain_data[id].active = false;
 
+	update_swapchain_memory(ics);
+
 	return XRT_SUCCESS;
 }
 
@@ -1296,35 +1909,8 @@ ipc_handle_compositor_semaphore_destroy(volatile struct ipc_client_state *ics, u
 xrt_result_t
 ipc_handle_device_update_input(volatile struct ipc_client_state *ics, uint32_t id)
 {
-	// To make the code a bit more readable.
-	uint32_t device_id = id;
-	struct ipc_shared_memory *ism = ics->server->ism;
-	struct ipc_device *idev = get_idev(ics, device_id);
-	struct xrt_device *xdev = idev->xdev;
-	struct ipc_shared_device *isdev = &ism->isdevs[device_id];
-
-	// Update inputs.
-	xrt_device_update_inputs(xdev);
-
-	// Copy data into the shared memory.
-	struct xrt_input *src = xdev->inputs;
-	struct xrt_input *dst = &ism->inputs[isdev->first_input_index];
-	size_t size = sizeof(struct xrt_input) * isdev->input_count;
-
-	bool io_active = ics->io_active && idev->io_active;
-	if (io_active) {
-		memcpy(dst, src, size);
-	} else {
-		memset(dst, 0, size);
-
-		for (uint32_t i = 0; i < isdev->input_count; i++) {
-			dst[i].name = src[i].name;
-
-			// Special case the rotation of the head.
-			if (dst[i].name == XRT_INPUT_GENERIC_HEAD_POSE) {
-				dst[i].active = src[i].active;
-			}
-		}
+	if (update_device_inputs(ics, id)) {
+		xrt_atomic_s32_inc_return(&ics->server->ism->input_generation);
 	}
 
 	// Reply.
@@ -1404,6 +1990,26 @@ ipc_handle_device_get_hand_tracking(volatile struct ipc_client_state *ics,
 	return XRT_SUCCESS;
 }
 
+xrt_result_t
+ipc_handle_device_get_hand_tracking_compact(volatile struct ipc_client_state *ics,
+                                            uint32_t id,
+                                            enum xrt_input_name name,
+                                            uint64_t at_timestamp,
+                                            struct ipc_hand_joint_set_compact *out_value,
+                                            uint64_t *out_timestamp)
+{
+	// To make the code a bit more readable.
+	uint32_t device_id = id;
+	struct xrt_device *xdev = get_xdev(ics, device_id);
+
+	struct xrt_hand_joint_set value;
+	xrt_device_get_hand_tracking(xdev, name, at_timestamp, &value, out_timestamp);
+
+	ipc_hand_joint_set_pack(&value, out_value);
+
+	return XRT_SUCCESS;
+}
+
 xrt_result_t
 ipc_handle_device_get_view_poses_2(volatile struct ipc_client_state *ics,
                                    uint32_t id,
@@ -1446,6 +2052,29 @@ ipc_handle_device_compute_distortion(volatile struct ipc_client_state *ics,
 	return XRT_SUCCESS;
 }
 
+xrt_result_t
+ipc_handle_device_compute_distortion_batch(volatile struct ipc_client_state *ics,
+                                           uint32_t id,
+                                           uint32_t view,
+                                           const struct ipc_arg_distortion_uvs *uvs,
+                                           bool *out_ret,
+                                           struct ipc_arg_distortion_triplets *out_triplets)
+{
+	// To make the code a bit more readable.
+	uint32_t device_id = id;
+	struct xrt_device *xdev = get_xdev(ics, device_id);
+
+	if (uvs->count > IPC_MAX_DISTORTION_POINTS) {
+		U_LOG_E("Too many points %u > %u!", uvs->count, IPC_MAX_DISTORTION_POINTS);
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	bool ret = xrt_device_compute_distortion_batch(xdev, view, uvs->count, uvs->uvs, out_triplets->triplets);
+	*out_ret = ret;
+
+	return XRT_SUCCESS;
+}
+
 xrt_result_t
 ipc_handle_device_set_output(volatile struct ipc_client_state *ics,
                              uint32_t id,
@@ -8,6 +8,8 @@
  * @ingroup ipc_server
  */
 
+#include "os/os_time.h"
+
 #include "util/u_misc.h"
 #include "util/u_trace_marker.h"
 
@@ -20,11 +22,15 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <stdio.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/epoll.h>
 #include <sys/socket.h>
 
+//! How long to spin for the next request on the channel before sleeping on the doorbell.
+#define CHANNEL_SPIN_NS (50 * U_TIME_1US_IN_NS)
+
 
 /*
  *
@@ -59,6 +65,141 @@ setup_epoll(volatile struct ipc_client_state *ics)
 }
 
 
+/*!
+ * Dispatch all complete messages in @p buf, moving any trailing partial
+ * message to the front. Returns false if the client should be disconnected.
+ */
+static bool
+dispatch_buffered(volatile struct ipc_client_state *ics, uint8_t *buf, size_t *inout_filled)
+{
+	size_t filled = *inout_filled;
+
+	while (filled >= sizeof(ipc_command_t)) {
+		// Check the first 4 bytes of the message and dispatch.
+		ipc_command_t *ipc_command = (ipc_command_t *)buf;
+
+		size_t size = ipc_cmd_msg_size(*ipc_command);
+		if (size == 0 || size > IPC_BUF_SIZE) {
+			IPC_ERROR(ics->server, "Invalid packet received, disconnecting client.");
+			return false;
+		}
+
+		if (filled < size) {
+			// Wait for the rest of the message.
+			break;
+		}
+
+		IPC_TRACE_BEGIN(ipc_dispatch);
+		xrt_result_t result = ipc_dispatch(ics, ipc_command);
+		IPC_TRACE_END(ipc_dispatch);
+
+		if (result != XRT_SUCCESS) {
+			IPC_ERROR(ics->server, "During packet handling, disconnecting client.");
+			return false;
+		}
+
+		// Keep the next message at the start of the buffer so it stays aligned.
+		filled -= size;
+		memmove(buf, buf + size, filled);
+	}
+
+	*inout_filled = filled;
+
+	return true;
+}
+
+#ifdef XRT_OS_LINUX
+/*!
+ * Dispatch the request waiting on the channel, the reply is written back by
+ * @ref ipc_server_reply. Returns false if the client should be disconnected.
+ */
+static bool
+dispatch_channel(volatile struct ipc_client_state *ics, struct ipc_shared_channel *ch)
+{
+	// Copy the request out first so that the client can't change it under us.
+	uint64_t msg[IPC_SHARED_CHANNEL_MSG_SIZE / sizeof(uint64_t)];
+	uint32_t size = ch->request_size;
+
+	xrt_atomic_thread_fence();
+	if (size < sizeof(ipc_command_t) || size > sizeof(msg)) {
+		IPC_ERROR(ics->server, "Invalid channel request size %u, disconnecting client.", size);
+		return false;
+	}
+
+	memcpy(msg, ch->request, size);
+
+	ipc_command_t *ipc_command = (ipc_command_t *)msg;
+	if (!ipc_cmd_is_channel(*ipc_command) || ipc_cmd_msg_size(*ipc_command) != size) {
+		IPC_ERROR(ics->server, "Invalid channel request %u, disconnecting client.", (uint32_t)*ipc_command);
+		return false;
+	}
+
+	ics->channel_dispatching = true;
+
+	IPC_TRACE_BEGIN(ipc_dispatch);
+	xrt_result_t result = ipc_dispatch(ics, ipc_command);
+	IPC_TRACE_END(ipc_dispatch);
+
+	ics->channel_dispatching = false;
+
+	if (result != XRT_SUCCESS) {
+		IPC_ERROR(ics->server, "During channel request handling, disconnecting client.");
+		return false;
+	}
+
+	return true;
+}
+
+/*!
+ * Serves both the channel and the socket once the client has enabled the
+ * channel, sleeping on the doorbell which the client rings for both.
+ */
+static void
+channel_loop(volatile struct ipc_client_state *ics, int epoll_fd, uint8_t *buf, size_t *inout_filled)
+{
+	struct ipc_shared_channel *ch = &ics->server->ism->channels[ics->server_thread_index];
+
+	while (ics->server->running) {
+		const uint64_t half_a_second_ns = 500 * U_TIME_1MS_IN_NS;
+
+		// Read before checking for work, so a ring after the checks is never missed.
+		int32_t doorbell = ch->doorbell;
+		xrt_atomic_thread_fence();
+
+		if (ch->request_seq != ch->reply_seq && !dispatch_channel(ics, ch)) {
+			break;
+		}
+
+		// Socket messages, and the client hanging up.
+		struct epoll_event event = XRT_STRUCT_INIT;
+		int ret = epoll_wait(epoll_fd, &event, 1, 0);
+		if (ret < 0) {
+			IPC_ERROR(ics->server, "Failed epoll_wait '%i', disconnecting client.", ret);
+			break;
+		}
+
+		if (ret > 0 && (event.events & EPOLLHUP) != 0) {
+			IPC_INFO(ics->server, "Client disconnected.");
+			break;
+		}
+
+		if (ret > 0 && !ipc_server_client_receive(ics, buf, inout_filled)) {
+			break;
+		}
+
+		// Calls often come in bursts, spin a little before sleeping.
+		uint64_t spin_until_ns = os_monotonic_get_ns() + CHANNEL_SPIN_NS;
+		while (ch->doorbell == doorbell && os_monotonic_get_ns() < spin_until_ns) {
+			os_cpu_relax();
+		}
+
+		// Times out so that we notice the server stopping.
+		ipc_futex_wait(&ch->doorbell, doorbell, half_a_second_ns);
+	}
+}
+#endif
+
+
 /*
  *
  * Client loop.
@@ -80,6 +221,9 @@ client_loop(volatile struct ipc_client_state *ics)
 
 	uint8_t buf[IPC_BUF_SIZE] = {0};
 
+	// Clients may pipeline one-way calls, so a read can hold several messages or only part of one.
+	size_t buf_filled = 0;
+
 	while (ics->server->running) {
 		const int half_a_second_ms = 500;
 		struct epoll_event event = XRT_STRUCT_INIT;
@@ -103,54 +247,23 @@ client_loop(volatile struct ipc_client_state *ics)
 		}
 
 		// Finally get the data that is waiting for us.
-		//! @todo replace this call
-		ssize_t len = recv(ics->imc.ipc_handle, &buf, IPC_BUF_SIZE, 0);
-		if (len < 4) {
-			IPC_ERROR(ics->server, "Invalid packet received, disconnecting client.");
+		if (!ipc_server_client_receive(ics, buf, &buf_filled)) {
 			break;
 		}
 
-		// Check the first 4 bytes of the message and dispatch.
-		ipc_command_t *ipc_command = (ipc_command_t *)buf;
-
-		IPC_TRACE_BEGIN(ipc_dispatch);
-		xrt_result_t result = ipc_dispatch(ics, ipc_command);
-		IPC_TRACE_END(ipc_dispatch);
-
-		if (result != XRT_SUCCESS) {
-			IPC_ERROR(ics->server, "During packet handling, disconnecting client.");
+#ifdef XRT_OS_LINUX
+		// From now on the client rings the doorbell for everything.
+		if (ics->channel_enabled) {
+			channel_loop(ics, epoll_fd, buf, &buf_filled);
 			break;
 		}
+#endif
 	}
 
 	close(epoll_fd);
 	epoll_fd = -1;
 
-	// Multiple threads might be looking at these fields.
-	os_mutex_lock(&ics->server->global_state.lock);
-
-	ipc_message_channel_close((struct ipc_message_channel *)&ics->imc);
-
-	ics->server->threads[ics->server_thread_index].state = IPC_THREAD_STOPPING;
-	ics->server_thread_index = -1;
-	memset((void *)&ics->client_state, 0, sizeof(struct ipc_app_state));
-
-	os_mutex_unlock(&ics->server->global_state.lock);
-
-	ipc_server_client_destroy_compositor(ics);
-
-	// Make sure undestroyed spaces are unreferenced
-	for (uint32_t i = 0; i < IPC_MAX_CLIENT_SPACES; i++) {
-		// Cast away volatile.
-		xrt_space_reference((struct xrt_space **)&ics->xspcs[i], NULL);
-	}
-
-	// Should we stop the server when a client disconnects?
-	if (ics->server->exit_on_disconnect) {
-		ics->server->running = false;
-	}
-
-	ipc_server_deactivate_session(ics);
+	ipc_server_client_disconnected(ics);
 }
 
 #else // XRT_OS_WINDOWS
@@ -193,6 +306,61 @@ client_loop(volatile struct ipc_client_state *ics)
 		}
 	}
 
+	ipc_server_client_disconnected(ics);
+}
+
+#endif // XRT_OS_WINDOWS
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+xrt_result_t
+ipc_server_reply(volatile struct ipc_client_state *ics, const void *data, size_t size)
+{
+#ifdef XRT_OS_LINUX
+	if (ics->channel_dispatching) {
+		struct ipc_shared_channel *ch = &ics->server->ism->channels[ics->server_thread_index];
+
+		// Size checked against IPC_SHARED_CHANNEL_MSG_SIZE by the generated code.
+		memcpy(ch->reply, data, size);
+		ch->reply_size = (uint32_t)size;
+
+		// The reply must be complete before the client can see the new sequence number.
+		xrt_atomic_thread_fence();
+		ch->reply_seq = ch->request_seq;
+		ipc_futex_wake(&ch->reply_seq);
+
+		return XRT_SUCCESS;
+	}
+#endif
+
+	return ipc_send((struct ipc_message_channel *)&ics->imc, data, size);
+}
+
+#ifndef XRT_OS_WINDOWS
+bool
+ipc_server_client_receive(volatile struct ipc_client_state *ics, uint8_t *buf, size_t *inout_filled)
+{
+	size_t filled = *inout_filled;
+
+	ssize_t len = recv(ics->imc.ipc_handle, buf + filled, IPC_BUF_SIZE - filled, 0);
+	if (len <= 0) {
+		IPC_ERROR(ics->server, "Invalid packet received, disconnecting client.");
+		return false;
+	}
+
+	*inout_filled = filled + (size_t)len;
+
+	return dispatch_buffered(ics, buf, inout_filled);
+}
+#endif // !XRT_OS_WINDOWS
+
+void
+ipc_server_client_disconnected(volatile struct ipc_client_state *ics)
+{
 	// Multiple threads might be looking at these fields.
 	os_mutex_lock(&ics->server->global_state.lock);
 
@@ -200,6 +368,7 @@ client_loop(volatile struct ipc_client_state *ics)
 
 	ics->server->threads[ics->server_thread_index].state = IPC_THREAD_STOPPING;
 	ics->server_thread_index = -1;
+	ics->channel_enabled = false;
 	memset((void *)&ics->client_state, 0, sizeof(struct ipc_app_state));
 
 	os_mutex_unlock(&ics->server->global_state.lock);
@@ -220,14 +389,6 @@ client_loop(volatile struct ipc_client_state *ics)
 	ipc_server_deactivate_session(ics);
 }
 
-#endif // XRT_OS_WINDOWS
-
-/*
- *
- * 'Exported' functions.
- *
- */
-
 void
 ipc_server_client_destroy_compositor(volatile struct ipc_client_state *ics)
 {
@@ -244,6 +405,11 @@ ipc_server_client_destroy_compositor(volatile struct ipc_client_state *ics)
 		IPC_TRACE(ics->server, "Destroyed swapchain %d.", j);
 	}
 
+	for (uint32_t j = 0; j < IPC_MAX_CLIENT_SWAPCHAIN_CACHE; j++) {
+		// Drop our reference, does NULL checking. Cast away volatile.
+		xrt_swapchain_reference((struct xrt_swapchain **)&ics->swapchain_cache[j].xsc, NULL);
+	}
+
 	for (uint32_t j = 0; j < IPC_MAX_CLIENT_SEMAPHORES; j++) {
 		// Drop our reference, does NULL checking. Cast away volatile.
 		xrt_compositor_semaphore_reference((struct xrt_compositor_semaphore **)&ics->xcsems[j], NULL);
@@ -12,6 +12,7 @@
 #include "xrt/xrt_device.h"
 #include "xrt/xrt_system.h"
 #include "xrt/xrt_instance.h"
+#include "xrt/xrt_prober.h"
 #include "xrt/xrt_compositor.h"
 #include "xrt/xrt_config_have.h"
 #include "xrt/xrt_config_os.h"
@@ -50,6 +51,13 @@
 
 DEBUG_GET_ONCE_BOOL_OPTION(exit_on_disconnect, "IPC_EXIT_ON_DISCONNECT", false)
 DEBUG_GET_ONCE_LOG_OPTION(ipc_log, "IPC_LOG", U_LOGGING_WARN)
+DEBUG_GET_ONCE_NUM_OPTION(pose_publish_hz, "IPC_POSE_PUBLISH_HZ", 0)
+DEBUG_GET_ONCE_NUM_OPTION(worker_threads, "IPC_WORKER_THREADS", 0)
+DEBUG_GET_ONCE_NUM_OPTION(hidden_rate_divisor, "IPC_HIDDEN_CLIENT_RATE_DIVISOR", 4)
+DEBUG_GET_ONCE_BOOL_OPTION(hotplug, "IPC_HOTPLUG", true)
+DEBUG_GET_ONCE_NUM_OPTION(client_swapchain_memory_mb, "IPC_CLIENT_SWAPCHAIN_MEMORY_MB", 0)
+DEBUG_GET_ONCE_NUM_OPTION(swapchain_memory_budget_percent, "IPC_SWAPCHAIN_MEMORY_BUDGET_PERCENT", 95)
+DEBUG_GET_ONCE_NUM_OPTION(client_max_layers, "IPC_CLIENT_MAX_LAYERS", 0)
 
 
 /*
@@ -117,6 +125,114 @@ teardown_idevs(struct ipc_server *s)
 }
 
 
+/*
+ *
+ * Pose publishing functions.
+ *
+ */
+
+static void
+publish_pose(struct ipc_server *s, struct ipc_shared_pose_history *isph)
+{
+	struct xrt_device *xdev = s->idevs[isph->device_id].xdev;
+	struct xrt_space_relation relation = XRT_SPACE_RELATION_ZERO;
+	uint64_t now_ns = os_monotonic_get_ns();
+
+	xrt_device_get_tracked_pose(xdev, isph->name, now_ns, &relation);
+
+	uint32_t index = isph->write_count % IPC_SHARED_POSE_HISTORY;
+
+	// Odd sequence, readers will retry until we are done. Full barrier.
+	xrt_atomic_s32_inc_return(&isph->sequence);
+
+	isph->timestamps_ns[index] = now_ns;
+	isph->relations[index] = relation;
+	isph->write_count++;
+	if (isph->sample_count < IPC_SHARED_POSE_HISTORY) {
+		isph->sample_count++;
+	}
+
+	// Even again, also a full barrier.
+	xrt_atomic_s32_inc_return(&isph->sequence);
+}
+
+static void *
+pose_publisher_thread(void *ptr)
+{
+	U_TRACE_SET_THREAD_NAME("IPC Pose Publisher");
+
+	struct ipc_server *s = (struct ipc_server *)ptr;
+	struct ipc_shared_memory *ism = s->ism;
+	const uint64_t interval_ns = ism->pose_publish_interval_ns;
+	uint64_t next_ns = os_monotonic_get_ns();
+
+	os_thread_helper_lock(&s->pose_publisher);
+	while (os_thread_helper_is_running_locked(&s->pose_publisher)) {
+		os_thread_helper_unlock(&s->pose_publisher);
+
+		for (uint32_t i = 0; i < ism->pose_count; i++) {
+			publish_pose(s, &ism->poses[i]);
+		}
+
+		// Keep a steady rate, but don't try to catch up if we fell behind.
+		next_ns += interval_ns;
+		uint64_t now_ns = os_monotonic_get_ns();
+		if (next_ns > now_ns) {
+			os_nanosleep((int64_t)(next_ns - now_ns));
+		} else {
+			next_ns = now_ns;
+		}
+
+		os_thread_helper_lock(&s->pose_publisher);
+	}
+	os_thread_helper_unlock(&s->pose_publisher);
+
+	return NULL;
+}
+
+static void
+init_shm_poses(struct ipc_server *s, uint32_t device_id, struct xrt_device *xdev)
+{
+	struct ipc_shared_memory *ism = s->ism;
+
+	for (uint32_t k = 0; k < xdev->input_count; k++) {
+		enum xrt_input_name name = xdev->inputs[k].name;
+		if (XRT_GET_INPUT_TYPE(name) != XRT_INPUT_TYPE_POSE) {
+			continue;
+		}
+
+		if (ism->pose_count >= IPC_SHARED_MAX_POSES) {
+			IPC_WARN(s, "Too many pose inputs, not publishing %s:%u in shared memory", xdev->str, k);
+			return;
+		}
+
+		struct ipc_shared_pose_history *isph = &ism->poses[ism->pose_count++];
+		isph->device_id = device_id;
+		isph->name = name;
+	}
+}
+
+static int
+init_pose_publisher(struct ipc_server *s)
+{
+	int64_t hz = debug_get_num_option_pose_publish_hz();
+	if (hz <= 0 || s->ism->pose_count == 0) {
+		// Disabled, clients will always ask the service.
+		s->ism->pose_publish_interval_ns = 0;
+		return 0;
+	}
+
+	s->ism->pose_publish_interval_ns = U_TIME_1S_IN_NS / (uint64_t)hz;
+
+	int ret = os_thread_helper_init(&s->pose_publisher);
+	if (ret < 0) {
+		return ret;
+	}
+
+	return os_thread_helper_start(&s->pose_publisher, pose_publisher_thread, s);
+}
+
+
 /*
  *
  * Static functions.
@@ -128,6 +244,16 @@ teardown_all(struct ipc_server *s)
 {
 	u_var_remove_root(s);
 
+	// Stop touching the devices before they go away.
+	if (s->pose_publisher.initialized) {
+		os_thread_helper_destroy(&s->pose_publisher);
+	}
+
+#if defined(XRT_OS_LINUX) && !defined(XRT_OS_ANDROID)
+	// Also tears down any clients still connected.
+	ipc_server_worker_pool_fini(s);
+#endif
+
 	xrt_syscomp_destroy(&s->xsysc);
 
 	teardown_idevs(s);
@@ -213,6 +339,124 @@ handle_binding(struct ipc_shared_memory *ism,
 	*output_pair_index_ptr = output_pair_index;
 }
 
+/*!
+ * Returns the shared device that already has the binding table of @p xdev in
+ * the shared memory, or -1 if it needs to be copied.
+ */
+static int32_t
+find_shared_bindings(struct ipc_server *s, uint32_t device_id, struct xrt_device *xdev)
+{
+	if (xdev->binding_profile_count == 0) {
+		return -1;
+	}
+
+	for (uint32_t k = 0; k < device_id; k++) {
+		if (s->shm_binding_sources[k] == xdev->binding_profiles &&
+		    s->ism->isdevs[k].binding_profile_count == xdev->binding_profile_count) {
+			return (int32_t)k;
+		}
+	}
+
+	return -1;
+}
+
+static void
+init_shm_device(struct ipc_server *s, uint32_t device_id, struct xrt_device *xdev)
+{
+	struct ipc_shared_memory *ism = s->ism;
+	struct ipc_shared_device *isdev = &ism->isdevs[device_id];
+
+	isdev->name = xdev->name;
+	memcpy(isdev->str, xdev->str, sizeof(isdev->str));
+	memcpy(isdev->serial, xdev->serial, sizeof(isdev->serial));
+
+	isdev->orientation_tracking_supported = xdev->orientation_tracking_supported;
+	isdev->position_tracking_supported = xdev->position_tracking_supported;
+	isdev->device_type = xdev->device_type;
+	isdev->hand_tracking_supported = xdev->hand_tracking_supported;
+	isdev->force_feedback_supported = xdev->force_feedback_supported;
+	isdev->form_factor_check_supported = xdev->form_factor_check_supported;
+	isdev->eye_gaze_supported = xdev->eye_gaze_supported;
+
+	// Is this a HMD?
+	if (xdev->hmd != NULL) {
+		ism->hmd.views[0].display.w_pixels = xdev->hmd->views[0].display.w_pixels;
+		ism->hmd.views[0].display.h_pixels = xdev->hmd->views[0].display.h_pixels;
+		ism->hmd.views[1].display.w_pixels = xdev->hmd->views[1].display.w_pixels;
+		ism->hmd.views[1].display.h_pixels = xdev->hmd->views[1].display.h_pixels;
+
+		for (size_t i = 0; i < xdev->hmd->blend_mode_count; i++) {
+			// Not super necessary, we also do this assert in oxr_system.c
+			assert(u_verify_blend_mode_valid(xdev->hmd->blend_modes[i]));
+			ism->hmd.blend_modes[i] = xdev->hmd->blend_modes[i];
+		}
+		ism->hmd.blend_mode_count = xdev->hmd->blend_mode_count;
+	}
+
+	// Setup the tracking origin.
+	isdev->tracking_origin_index = (uint32_t)-1;
+	for (uint32_t k = 0; k < XRT_SYSTEM_MAX_DEVICES; k++) {
+		if (xdev->tracking_origin != s->xtracks[k]) {
+			continue;
+		}
+
+		isdev->tracking_origin_index = k;
+		break;
+	}
+
+	assert(isdev->tracking_origin_index != (uint32_t)-1);
+
+	// Initial update.
+	xrt_device_update_inputs(xdev);
+
+	// Bindings, reuse the entries of a device with the same table.
+	s->shm_binding_sources[device_id] = xdev->binding_profiles;
+	int32_t shared = find_shared_bindings(s, device_id, xdev);
+	if (shared >= 0) {
+		isdev->binding_profile_count = ism->isdevs[shared].binding_profile_count;
+		isdev->first_binding_profile_index = ism->isdevs[shared].first_binding_profile_index;
+	}
+
+	uint32_t binding_start = s->shm_next.binding;
+	for (size_t k = 0; shared < 0 && k < xdev->binding_profile_count; k++) {
+		handle_binding(ism, &xdev->binding_profiles[k], &ism->binding_profiles[s->shm_next.binding++],
+		               &s->shm_next.input_pair, &s->shm_next.output_pair);
+	}
+
+	// Setup the 'offsets' and number of bindings.
+	if (binding_start != s->shm_next.binding) {
+		isdev->binding_profile_count = s->shm_next.binding - binding_start;
+		isdev->first_binding_profile_index = binding_start;
+	}
+
+	// Copy the initial state and also count the number in inputs.
+	uint32_t input_start = s->shm_next.input;
+	for (size_t k = 0; k < xdev->input_count; k++) {
+		ism->inputs[s->shm_next.input++] = xdev->inputs[k];
+	}
+
+	// Setup the 'offsets' and number of inputs.
+	if (input_start != s->shm_next.input) {
+		isdev->input_count = s->shm_next.input - input_start;
+		isdev->first_input_index = input_start;
+	}
+
+	// Pose inputs that may be published in shared memory.
+	init_shm_poses(s, device_id, xdev);
+
+	// Copy the initial state and also count the number in outputs.
+	uint32_t output_start = s->shm_next.output;
+	for (size_t k = 0; k < xdev->output_count; k++) {
+		ism->outputs[s->shm_next.output++] = xdev->outputs[k];
+	}
+
+	// Setup the 'offsets' and number of outputs.
+	if (output_start != s->shm_next.output) {
+		isdev->output_count = s->shm_next.output - output_start;
+		isdev->first_output_index = output_start;
+	}
+}
+
 static int
 init_shm(struct ipc_server *s)
 {
@@ -259,99 +503,13 @@ init_shm(struct ipc_server *s)
 	ism->itrack_count = count;
 
 	count = 0;
-	uint32_t input_index = 0;
-	uint32_t output_index = 0;
-	uint32_t binding_index = 0;
-	uint32_t input_pair_index = 0;
-	uint32_t output_pair_index = 0;
-
 	for (size_t i = 0; i < XRT_SYSTEM_MAX_DEVICES; i++) {
 		struct xrt_device *xdev = s->idevs[i].xdev;
 		if (xdev == NULL) {
 			continue;
 		}
 
-		struct ipc_shared_device *isdev = &ism->isdevs[count++];
-
-		isdev->name = xdev->name;
-		memcpy(isdev->str, xdev->str, sizeof(isdev->str));
-		memcpy(isdev->serial, xdev->serial, sizeof(isdev->serial));
-
-		isdev->orientation_tracking_supported = xdev->orientation_tracking_supported;
-		isdev->position_tracking_supported = xdev->position_tracking_supported;
-		isdev->device_type = xdev->device_type;
-		isdev->hand_tracking_supported = xdev->hand_tracking_supported;
-		isdev->force_feedback_supported = xdev->force_feedback_supported;
-		isdev->form_factor_check_supported = xdev->form_factor_check_supported;
-		isdev->eye_gaze_supported = xdev->eye_gaze_supported;
-
-		// Is this a HMD?
-		if (xdev->hmd != NULL) {
-			ism->hmd.views[0].display.w_pixels = xdev->hmd->views[0].display.w_pixels;
-			ism->hmd.views[0].display.h_pixels = xdev->hmd->views[0].display.h_pixels;
-			ism->hmd.views[1].display.w_pixels = xdev->hmd->views[1].display.w_pixels;
-			ism->hmd.views[1].display.h_pixels = xdev->hmd->views[1].display.h_pixels;
-
-			for (size_t i = 0; i < xdev->hmd->blend_mode_count; i++) {
-				// Not super necessary, we also do this assert in oxr_system.c
-				assert(u_verify_blend_mode_valid(xdev->hmd->blend_modes[i]));
-				ism->hmd.blend_modes[i] = xdev->hmd->blend_modes[i];
-			}
-			ism->hmd.blend_mode_count = xdev->hmd->blend_mode_count;
-		}
-
-		// Setup the tracking origin.
-		isdev->tracking_origin_index = (uint32_t)-1;
-		for (uint32_t k = 0; k < XRT_SYSTEM_MAX_DEVICES; k++) {
-			if (xdev->tracking_origin != s->xtracks[k]) {
-				continue;
-			}
-
-			isdev->tracking_origin_index = k;
-			break;
-		}
-
-		assert(isdev->tracking_origin_index != (uint32_t)-1);
-
-		// Initial update.
-		xrt_device_update_inputs(xdev);
-
-		// Bindings
-		uint32_t binding_start = binding_index;
-		for (size_t k = 0; k < xdev->binding_profile_count; k++) {
-			handle_binding(ism, &xdev->binding_profiles[k], &ism->binding_profiles[binding_index++],
-			               &input_pair_index, &output_pair_index);
-		}
-
-		// Setup the 'offsets' and number of bindings.
-		if (binding_start != binding_index) {
-			isdev->binding_profile_count = binding_index - binding_start;
-			isdev->first_binding_profile_index = binding_start;
-		}
-
-		// Copy the initial state and also count the number in inputs.
-		uint32_t input_start = input_index;
-		for (size_t k = 0; k < xdev->input_count; k++) {
-			ism->inputs[input_index++] = xdev->inputs[k];
-		}
-
-		// Setup the 'offsets' and number of inputs.
-		if (input_start != input_index) {
-			isdev->input_count = input_index - input_start;
-			isdev->first_input_index = input_start;
-		}
-
-		// Copy the initial state and also count the number in outputs.
-		uint32_t output_start = output_index;
-		for (size_t k = 0; k < xdev->output_count; k++) {
-			ism->outputs[output_index++] = xdev->outputs[k];
-		}
-
-		// Setup the 'offsets' and number of outputs.
-		if (output_start != output_index) {
-			isdev->output_count = output_index - output_start;
-			isdev->first_output_index = output_start;
-		}
+		init_shm_device(s, count++, xdev);
 	}
 
 	// Finally tell the client how many devices we have.
@@ -369,6 +527,12 @@ init_shm(struct ipc_server *s)
 	// Fill out git version info.
 	snprintf(s->ism->u_git_tag, IPC_VERSION_NAME_LEN, "%s", u_git_tag);
 
+	// Clients check these before touching anything else.
+	static_assert(offsetof(struct ipc_shared_memory, layout_version) == IPC_VERSION_NAME_LEN,
+	              "The header of ipc_shared_memory must not move");
+	ism->layout_version = IPC_SHARED_MEMORY_LAYOUT_VERSION;
+	ism->layout_size = (uint32_t)sizeof(struct ipc_shared_memory);
+
 	return 0;
 }
 
@@ -425,7 +589,8 @@ ipc_server_handle_client_connected(struct ipc_server *vs, xrt_ipc_handle_t ipc_h
 		return;
 	}
 
-	if (it->state != IPC_THREAD_READY) {
+	// Pool clients never had a thread started for them.
+	if (it->state != IPC_THREAD_READY && !vs->pool.enabled) {
 		os_thread_join(&it->thread);
 		os_thread_destroy(&it->thread);
 		it->state = IPC_THREAD_READY;
@@ -447,12 +612,167 @@ ipc_server_handle_client_connected(struct ipc_server *vs, xrt_ipc_handle_t ipc_h
 	ics->server_thread_index = cs_index;
 	ics->io_active = true;
 
+	// Matches the core class the thread starts with.
+	ics->client_state.priority = IPC_CLIENT_PRIORITY_NORMAL;
+
+#if defined(XRT_OS_LINUX) && !defined(XRT_OS_ANDROID)
+	if (vs->pool.enabled) {
+		it->state = IPC_THREAD_RUNNING;
+
+		if (ipc_server_worker_pool_add_client(vs, cs_index) < 0) {
+			xrt_ipc_handle_close(ipc_handle);
+			ics->server_thread_index = -1;
+			it->state = IPC_THREAD_READY;
+		}
+
+		// Unlock when we are done.
+		os_mutex_unlock(&vs->global_state.lock);
+		return;
+	}
+#endif
+
 	os_thread_start(&it->thread, ipc_server_client_thread, (void *)ics);
 
 	// Unlock when we are done.
 	os_mutex_unlock(&vs->global_state.lock);
 }
 
+/*
+ *
+ * Hotplug functions.
+ *
+ */
+
+static bool
+can_add_device(struct ipc_server *s, struct xrt_device *xdev)
+{
+	// Clients use the same index for the shared device and system device.
+	uint32_t device_id = s->ism->isdev_count;
+	if (device_id >= XRT_SYSTEM_MAX_DEVICES || s->xsysd->xdev_count != device_id) {
+		return false;
+	}
+
+	bool have_origin = false;
+	for (size_t i = 0; i < XRT_SYSTEM_MAX_DEVICES; i++) {
+		if (s->xtracks[i] == NULL || s->xtracks[i] == xdev->tracking_origin) {
+			have_origin = true;
+			break;
+		}
+	}
+
+	// Shared binding tables don't take up any more room.
+	size_t binding_profile_count = 0;
+	uint32_t input_pairs = 0;
+	uint32_t output_pairs = 0;
+	if (find_shared_bindings(s, device_id, xdev) < 0) {
+		binding_profile_count = xdev->binding_profile_count;
+		for (size_t k = 0; k < xdev->binding_profile_count; k++) {
+			input_pairs += (uint32_t)xdev->binding_profiles[k].input_count;
+			output_pairs += (uint32_t)xdev->binding_profiles[k].output_count;
+		}
+	}
+
+	if (!have_origin) {
+		return false;
+	}
+
+	return s->shm_next.input + xdev->input_count <= IPC_SHARED_MAX_INPUTS &&
+	       s->shm_next.output + xdev->output_count <= IPC_SHARED_MAX_OUTPUTS &&
+	       s->shm_next.binding + binding_profile_count <= IPC_SHARED_MAX_BINDINGS &&
+	       s->shm_next.input_pair + input_pairs <= IPC_SHARED_MAX_INPUTS &&
+	       s->shm_next.output_pair + output_pairs <= IPC_SHARED_MAX_OUTPUTS;
+}
+
+static void
+add_tracking_origin(struct ipc_server *s, struct xrt_tracking_origin *xtrack)
+{
+	struct ipc_shared_memory *ism = s->ism;
+
+	for (uint32_t i = 0; i < XRT_SYSTEM_MAX_DEVICES; i++) {
+		if (s->xtracks[i] == xtrack) {
+			return;
+		}
+		if (s->xtracks[i] != NULL) {
+			continue;
+		}
+
+		s->xtracks[i] = xtrack;
+
+		struct ipc_shared_tracking_origin *itrack = &ism->itracks[i];
+		memcpy(itrack->name, xtrack->name, sizeof(itrack->name));
+		itrack->type = xtrack->type;
+		itrack->offset = xtrack->offset;
+		ism->itrack_count = i + 1;
+		return;
+	}
+}
+
+static void
+add_hotplugged_device(struct ipc_server *s, struct xrt_device *xdev)
+{
+	struct ipc_shared_memory *ism = s->ism;
+	xrt_result_t xret;
+
+	if (!can_add_device(s, xdev)) {
+		IPC_WARN(s, "No room for hotplugged device '%s', closing it", xdev->str);
+		xrt_device_destroy(&xdev);
+		return;
+	}
+
+	xret = xrt_space_overseer_add_device(s->xso, xdev);
+	if (xret != XRT_SUCCESS) {
+		IPC_WARN(s, "Could not add hotplugged device '%s' to the space overseer, closing it", xdev->str);
+		xrt_device_destroy(&xdev);
+		return;
+	}
+
+	// Client threads look at the devices, add it while they are held off.
+	os_mutex_lock(&s->global_state.lock);
+
+	uint32_t device_id = ism->isdev_count;
+
+	// Now owned by the system devices.
+	s->xsysd->xdevs[s->xsysd->xdev_count++] = xdev;
+
+	init_idev(&s->idevs[device_id], xdev);
+	add_tracking_origin(s, xdev->tracking_origin);
+	init_shm_device(s, device_id, xdev);
+
+	// Clients only look at devices below the count, so bump it last.
+	ism->isdev_count = device_id + 1;
+
+	os_mutex_unlock(&s->global_state.lock);
+
+	IPC_INFO(s, "Added hotplugged device '%s', visible to clients connecting from now on", xdev->str);
+}
+
+static void
+poll_hotplug(struct ipc_server *s)
+{
+	struct xrt_prober *xp = NULL;
+	xrt_result_t xret;
+
+	xret = xrt_instance_get_prober(s->xinst, &xp);
+	if (xret != XRT_SUCCESS || xp == NULL) {
+		// No prober, nothing to ever hotplug.
+		s->hotplug = false;
+		return;
+	}
+
+	struct xrt_device *xdevs[XRT_SYSTEM_MAX_DEVICES];
+	uint32_t xdev_count = 0;
+
+	xret = xrt_prober_poll_hotplug(xp, xdevs, ARRAY_SIZE(xdevs), &xdev_count);
+	if (xret != XRT_SUCCESS) {
+		IPC_DEBUG(s, "Polling for hotplugged devices failed: %d", xret);
+		return;
+	}
+
+	for (uint32_t i = 0; i < xdev_count; i++) {
+		add_hotplugged_device(s, xdevs[i]);
+	}
+}
+
 static int
 init_all(struct ipc_server *s)
 {
@@ -477,8 +797,17 @@ init_all(struct ipc_server *s)
 	// Yes we should be running.
 	s->running = true;
 	s->exit_on_disconnect = debug_get_bool_option_exit_on_disconnect();
+	s->hotplug = debug_get_bool_option_hotplug();
 	s->log_level = debug_get_log_option_ipc_log();
 
+	int64_t client_mb = debug_get_num_option_client_swapchain_memory_mb();
+	int64_t budget_percent = debug_get_num_option_swapchain_memory_budget_percent();
+	s->swapchain_memory.client_max_size = client_mb > 0 ? (uint64_t)client_mb * 1024 * 1024 : 0;
+	s->swapchain_memory.budget_fraction = budget_percent > 0 ? (double)budget_percent / 100.0 : 0.0;
+
+	int64_t max_layers = debug_get_num_option_client_max_layers();
+	s->client_max_layers = max_layers > 0 && max_layers < IPC_MAX_LAYERS ? (uint32_t)max_layers : 0;
+
 	xret = xrt_instance_create(NULL, &s->xinst);
 	if (xret != XRT_SUCCESS) {
 		IPC_ERROR(s, "Failed to create instance!");
@@ -514,6 +843,25 @@ init_all(struct ipc_server *s)
 		return ret;
 	}
 
+#if defined(XRT_OS_LINUX) && !defined(XRT_OS_ANDROID)
+	int64_t worker_threads = debug_get_num_option_worker_threads();
+	if (worker_threads > 0) {
+		ret = ipc_server_worker_pool_init(s, (uint32_t)worker_threads);
+		if (ret < 0) {
+			IPC_ERROR(s, "Failed to start worker pool!");
+			teardown_all(s);
+			return ret;
+		}
+	}
+#endif
+
+	ret = init_pose_publisher(s);
+	if (ret < 0) {
+		IPC_ERROR(s, "Failed to start pose publisher thread!");
+		teardown_all(s);
+		return ret;
+	}
+
 	ret = ipc_server_mainloop_init(&s->ml);
 	if (ret < 0) {
 		IPC_ERROR(s, "Failed to init ipc main loop!");
@@ -524,6 +872,7 @@ init_all(struct ipc_server *s)
 	u_var_add_root(s, "IPC Server", false);
 	u_var_add_log_level(s, &s->log_level, "Log level");
 	u_var_add_bool(s, &s->exit_on_disconnect, "exit_on_disconnect");
+	u_var_add_bool(s, &s->hotplug, "hotplug");
 	u_var_add_bool(s, (bool *)&s->running, "running");
 
 	return 0;
@@ -537,6 +886,10 @@ main_loop(struct ipc_server *s)
 
 		// Check polling.
 		ipc_server_mainloop_poll(s, &s->ml);
+
+		if (s->hotplug) {
+			poll_hotplug(s);
+		}
 	}
 
 	return 0;
@@ -595,6 +948,33 @@ handle_overlay_client_events(volatile struct ipc_client_state *ics, int active_i
 	}
 }
 
+/*!
+ * Move the thread of the client to the cores matching its priority, so that
+ * busy overlays and hidden clients don't compete with the primary application
+ * for the fast cores. Clients served by the worker pool share its threads.
+ */
+static void
+set_client_thread_priority(volatile struct ipc_client_state *ics, enum ipc_client_priority priority)
+{
+	struct ipc_server *s = ics->server;
+
+	if (s->pool.enabled || ics->server_thread_index < 0) {
+		return;
+	}
+
+	enum os_thread_core_class core_class = OS_THREAD_CORE_CLASS_ANY;
+	switch (priority) {
+	case IPC_CLIENT_PRIORITY_HIGH: core_class = OS_THREAD_CORE_CLASS_PERFORMANCE; break;
+	case IPC_CLIENT_PRIORITY_LOW: core_class = OS_THREAD_CORE_CLASS_EFFICIENCY; break;
+	default: break;
+	}
+
+	int ret = os_thread_set_core_class(&s->threads[ics->server_thread_index].thread, core_class);
+	if (ret < 0) {
+		IPC_WARN(s, "Failed to set core class of client %u: %i", ics->client_state.id, ret);
+	}
+}
+
 static void
 handle_focused_client_events(volatile struct ipc_client_state *ics, int active_id, int prev_active_id)
 {
@@ -619,13 +999,45 @@ handle_focused_client_events(volatile struct ipc_client_state *ics, int active_i
 		z_order = ics->client_state.z_order;
 	}
 
+	/*
+	 * Hidden clients aren't shown so only need to keep their frame loop
+	 * ticking, visible but unfocused ones only run at half rate.
+	 */
+	uint32_t rate_divisor = 1;
+	if (!visible && debug_get_num_option_hidden_rate_divisor() > 1) {
+		rate_divisor = (uint32_t)debug_get_num_option_hidden_rate_divisor();
+	} else if (visible && !focused) {
+		rate_divisor = 2;
+	}
+
+	enum ipc_client_priority priority = IPC_CLIENT_PRIORITY_LOW;
+	if (ics->server_thread_index == active_id) {
+		priority = IPC_CLIENT_PRIORITY_HIGH;
+	} else if (visible) {
+		priority = IPC_CLIENT_PRIORITY_NORMAL;
+	}
+
+	// Only clients that can't hurt the primary application are held to the quotas.
+	if (priority == IPC_CLIENT_PRIORITY_HIGH) {
+		ics->client_state.over_quota = false;
+	} else if (ics->client_state.over_quota) {
+		rate_divisor *= 2;
+	}
+
+	if (ics->client_state.priority != priority) {
+		set_client_thread_priority(ics, priority);
+	}
+
 	ics->client_state.session_visible = visible;
 	ics->client_state.session_focused = focused;
 	ics->client_state.z_order = z_order;
+	ics->client_state.rate_divisor = rate_divisor;
+	ics->client_state.priority = priority;
 
 	if (ics->xc != NULL) {
 		xrt_syscomp_set_state(ics->server->xsysc, ics->xc, visible, focused);
 		xrt_syscomp_set_z_order(ics->server->xsysc, ics->xc, z_order);
+		xrt_syscomp_set_rate_divisor(ics->server->xsysc, ics->xc, rate_divisor);
 	}
 }
 
@@ -0,0 +1,199 @@
+// Copyright 2020-2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Fixed pool of threads servicing all client sockets with epoll.
+ * @ingroup ipc_server
+ */
+
+#include "util/u_misc.h"
+#include "util/u_trace_marker.h"
+
+#include "server/ipc_server.h"
+
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+
+
+/*
+ *
+ * Helper functions.
+ *
+ */
+
+static int
+arm_client(struct ipc_server_worker_pool *pool, int op, int fd, uint32_t client_index)
+{
+	struct epoll_event ev = XRT_STRUCT_INIT;
+
+	// One-shot, so only a single worker picks up a client until it is re-armed.
+	ev.events = EPOLLIN | EPOLLONESHOT;
+	ev.data.u32 = client_index;
+
+	return epoll_ctl(pool->epoll_fd, op, fd, &ev);
+}
+
+static void
+drop_client(struct ipc_server *s, uint32_t client_index)
+{
+	struct ipc_server_worker_pool *pool = &s->pool;
+	volatile struct ipc_client_state *ics = &s->threads[client_index].ics;
+
+	epoll_ctl(pool->epoll_fd, EPOLL_CTL_DEL, ics->imc.ipc_handle, NULL);
+
+	ipc_server_client_disconnected(ics);
+}
+
+static void *
+worker_thread(void *ptr)
+{
+	U_TRACE_SET_THREAD_NAME("IPC Worker");
+
+	struct ipc_server *s = (struct ipc_server *)ptr;
+	struct ipc_server_worker_pool *pool = &s->pool;
+
+	while (pool->running) {
+		const int half_a_second_ms = 500;
+		struct epoll_event event = XRT_STRUCT_INIT;
+
+		// Timeout so that we notice when to stop.
+		int ret = epoll_wait(pool->epoll_fd, &event, 1, half_a_second_ms);
+		if (ret < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			IPC_ERROR(s, "Failed epoll_wait '%i', stopping worker.", errno);
+			break;
+		}
+
+		// Timed out, loop again.
+		if (ret == 0) {
+			continue;
+		}
+
+		uint32_t client_index = event.data.u32;
+		volatile struct ipc_client_state *ics = &s->threads[client_index].ics;
+
+		// Detect clients disconnecting gracefully.
+		if ((event.events & (EPOLLHUP | EPOLLERR)) != 0) {
+			IPC_INFO(s, "Client %u disconnected.", ics->client_state.id);
+			drop_client(s, client_index);
+			continue;
+		}
+
+		uint8_t *buf = pool->buffers[client_index].data;
+		size_t *filled = &pool->buffers[client_index].filled;
+
+		if (!ipc_server_client_receive(ics, buf, filled)) {
+			drop_client(s, client_index);
+			continue;
+		}
+
+		ret = arm_client(pool, EPOLL_CTL_MOD, ics->imc.ipc_handle, client_index);
+		if (ret < 0) {
+			IPC_ERROR(s, "Error epoll_ctl(client_socket) failed '%i', disconnecting client.", errno);
+			drop_client(s, client_index);
+		}
+	}
+
+	return NULL;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+int
+ipc_server_worker_pool_init(struct ipc_server *s, uint32_t worker_count)
+{
+	struct ipc_server_worker_pool *pool = &s->pool;
+
+	if (worker_count > IPC_SERVER_MAX_WORKERS) {
+		IPC_WARN(s, "Clamping worker count %u to %u", worker_count, IPC_SERVER_MAX_WORKERS);
+		worker_count = IPC_SERVER_MAX_WORKERS;
+	}
+
+	int ret = epoll_create1(EPOLL_CLOEXEC);
+	if (ret < 0) {
+		return ret;
+	}
+
+	pool->epoll_fd = ret;
+	pool->running = true;
+	pool->enabled = true;
+
+	for (uint32_t i = 0; i < worker_count; i++) {
+		ret = os_thread_init(&pool->threads[i]);
+		if (ret < 0) {
+			return ret;
+		}
+
+		ret = os_thread_start(&pool->threads[i], worker_thread, s);
+		if (ret < 0) {
+			os_thread_destroy(&pool->threads[i]);
+			return ret;
+		}
+
+		pool->thread_count++;
+	}
+
+	IPC_INFO(s, "Servicing clients with %u worker threads", pool->thread_count);
+
+	return 0;
+}
+
+void
+ipc_server_worker_pool_fini(struct ipc_server *s)
+{
+	struct ipc_server_worker_pool *pool = &s->pool;
+
+	if (!pool->enabled) {
+		return;
+	}
+
+	pool->running = false;
+
+	for (uint32_t i = 0; i < pool->thread_count; i++) {
+		os_thread_join(&pool->threads[i]);
+		os_thread_destroy(&pool->threads[i]);
+	}
+	pool->thread_count = 0;
+
+	// No workers left, safe to tear down the remaining clients from here.
+	for (uint32_t i = 0; i < IPC_MAX_CLIENTS; i++) {
+		volatile struct ipc_client_state *ics = &s->threads[i].ics;
+		if (ics->server == NULL || ics->server_thread_index < 0) {
+			continue;
+		}
+
+		drop_client(s, i);
+	}
+
+	close(pool->epoll_fd);
+	pool->epoll_fd = -1;
+	pool->enabled = false;
+}
+
+int
+ipc_server_worker_pool_add_client(struct ipc_server *s, uint32_t client_index)
+{
+	struct ipc_server_worker_pool *pool = &s->pool;
+	volatile struct ipc_client_state *ics = &s->threads[client_index].ics;
+
+	pool->buffers[client_index].filled = 0;
+
+	int ret = arm_client(pool, EPOLL_CTL_ADD, ics->imc.ipc_handle, client_index);
+	if (ret < 0) {
+		IPC_ERROR(s, "Error epoll_ctl(client_socket) failed '%i'.", errno);
+		return ret;
+	}
+
+	IPC_INFO(s, "Client %u connected", ics->client_state.id);
+
+	return 0;
+}
@@ -0,0 +1,115 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Packing of hand joint sets into the compact IPC format.
+ * @ingroup ipc_shared
+ */
+
+#include "shared/ipc_hand_joints.h"
+
+#include <math.h>
+#include <string.h>
+
+
+#define KEPT_JOINT_FLAGS                                                                                               \
+	(XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_POSITION_VALID_BIT |                            \
+	 XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT | XRT_SPACE_RELATION_POSITION_TRACKED_BIT)
+
+#define VELOCITY_FLAGS (XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT | XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT)
+
+
+static inline int16_t
+quantise_unit(float v)
+{
+	if (v > 1.0f) {
+		v = 1.0f;
+	} else if (v < -1.0f) {
+		v = -1.0f;
+	}
+	return (int16_t)lroundf(v * (float)INT16_MAX);
+}
+
+static inline uint16_t
+quantise_radius(float radius)
+{
+	float r = radius / IPC_HAND_JOINT_RADIUS_UNIT_M;
+	if (!(r > 0.0f)) {
+		return 0;
+	}
+	if (r > (float)UINT16_MAX) {
+		return UINT16_MAX;
+	}
+	return (uint16_t)lroundf(r);
+}
+
+void
+ipc_hand_joint_set_pack(const struct xrt_hand_joint_set *set, struct ipc_hand_joint_set_compact *out_compact)
+{
+	memset(out_compact, 0, sizeof(*out_compact));
+
+	out_compact->hand_pose = set->hand_pose;
+	out_compact->is_active = set->is_active;
+
+	for (uint32_t i = 0; i < XRT_HAND_JOINT_COUNT; i++) {
+		const struct xrt_hand_joint_value *v = &set->values.hand_joint_set_default[i];
+		struct ipc_hand_joint_compact *j = &out_compact->joints[i];
+
+		// Both halves of the quaternion double cover are the same rotation, keep w positive.
+		struct xrt_quat q = v->relation.pose.orientation;
+		if (q.w < 0.0f) {
+			q.x = -q.x;
+			q.y = -q.y;
+			q.z = -q.z;
+			q.w = -q.w;
+		}
+
+		j->position = v->relation.pose.position;
+		j->orientation[0] = quantise_unit(q.x);
+		j->orientation[1] = quantise_unit(q.y);
+		j->orientation[2] = quantise_unit(q.z);
+		j->orientation[3] = quantise_unit(q.w);
+		j->radius = quantise_radius(v->radius);
+		j->flags = (uint8_t)(v->relation.relation_flags & KEPT_JOINT_FLAGS);
+
+		if ((v->relation.relation_flags & VELOCITY_FLAGS) != 0) {
+			out_compact->had_velocities = true;
+		}
+	}
+}
+
+void
+ipc_hand_joint_set_unpack(const struct ipc_hand_joint_set_compact *compact, struct xrt_hand_joint_set *out_set)
+{
+	memset(out_set, 0, sizeof(*out_set));
+
+	out_set->hand_pose = compact->hand_pose;
+	out_set->is_active = compact->is_active;
+
+	for (uint32_t i = 0; i < XRT_HAND_JOINT_COUNT; i++) {
+		const struct ipc_hand_joint_compact *j = &compact->joints[i];
+		struct xrt_hand_joint_value *v = &out_set->values.hand_joint_set_default[i];
+
+		struct xrt_quat q = {
+		    .x = (float)j->orientation[0] / (float)INT16_MAX,
+		    .y = (float)j->orientation[1] / (float)INT16_MAX,
+		    .z = (float)j->orientation[2] / (float)INT16_MAX,
+		    .w = (float)j->orientation[3] / (float)INT16_MAX,
+		};
+
+		float len = sqrtf(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+		if (len > 0.0f) {
+			q.x /= len;
+			q.y /= len;
+			q.z /= len;
+			q.w /= len;
+		} else {
+			q.w = 1.0f;
+		}
+
+		v->relation.pose.position = j->position;
+		v->relation.pose.orientation = q;
+		v->relation.relation_flags = (enum xrt_space_relation_flags)j->flags;
+		v->radius = (float)j->radius * IPC_HAND_JOINT_RADIUS_UNIT_M;
+	}
+}
@@ -0,0 +1,39 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Packing of hand joint sets into the compact IPC format.
+ * @ingroup ipc_shared
+ */
+
+#pragma once
+
+#include "shared/ipc_protocol.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * Packs @p set into @p out_compact, dropping joint velocities and quantising
+ * the joint orientations and radii.
+ *
+ * @ingroup ipc_shared
+ */
+void
+ipc_hand_joint_set_pack(const struct xrt_hand_joint_set *set, struct ipc_hand_joint_set_compact *out_compact);
+
+/*!
+ * Unpacks @p compact into @p out_set, joint orientations are renormalised and
+ * joint velocities are zero and flagged as not valid.
+ *
+ * @ingroup ipc_shared
+ */
+void
+ipc_hand_joint_set_unpack(const struct ipc_hand_joint_set_compact *compact, struct xrt_hand_joint_set *out_set);
+
+
+#ifdef __cplusplus
+}
+#endif
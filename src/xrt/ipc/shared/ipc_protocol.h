@@ -22,6 +22,8 @@
 #include "xrt/xrt_tracking.h"
 #include "xrt/xrt_config_build.h"
 
+#include "util/u_pacing.h"
+
 #include <sys/types.h>
 
 
@@ -30,14 +32,30 @@
 #define IPC_MAX_VIEWS 8    // max views we will return configs for
 #define IPC_MAX_FORMATS 32 // max formats our server-side compositor supports
 #define IPC_MAX_DEVICES 8  // max number of devices we will map using shared mem
-#define IPC_MAX_LAYERS 16
+#define IPC_MAX_LAYERS 64
 #define IPC_MAX_SLOTS 128
 #define IPC_MAX_CLIENTS 8
+#define IPC_MAX_CLIENT_SWAPCHAINS 32
 #define IPC_EVENT_QUEUE_SIZE 32
+#define IPC_MAX_LOCATE_SPACES 64 // max spaces per space_locate_spaces call, message must fit in IPC_BUF_SIZE
+#define IPC_MAX_FRAME_RECORDS 32 // max compositor frame timing records per call
+#define IPC_MAX_DISTORTION_POINTS 48 // max points per device_compute_distortion_batch call, must fit in IPC_BUF_SIZE
 
 #define IPC_SHARED_MAX_INPUTS 1024
 #define IPC_SHARED_MAX_OUTPUTS 128
 #define IPC_SHARED_MAX_BINDINGS 64
+#define IPC_SHARED_MAX_POSES 32 // max number of pose inputs published in shared memory
+#define IPC_SHARED_POSE_HISTORY 8 // number of samples kept per published pose, power of two
+#define IPC_SHARED_SCRATCH_SIZE 4096 // per client shared memory for large replies, see ipc_shared_scratch
+#define IPC_SHARED_CHANNEL_MSG_SIZE 64 // max message and reply size of calls on the ipc_shared_channel
+#define IPC_SHARED_CACHE_LINE_SIZE 64 // hot shared memory is aligned to this to avoid false sharing
+
+/*!
+ * Version of the layout of @ref ipc_shared_memory, bump it for any change that
+ * moves or resizes existing fields. Fields appended at the end only grow
+ * @ref ipc_shared_memory::layout_size and need no bump.
+ */
+#define IPC_SHARED_MEMORY_LAYOUT_VERSION 2
 
 // example: v21.0.0-560-g586d33b5
 #define IPC_VERSION_NAME_LEN 64
@@ -165,11 +183,177 @@ struct ipc_layer_entry
  */
 struct ipc_layer_slot
 {
-	struct xrt_layer_frame_data data;
+	//! Slots are filled in by different clients, keep them on separate cache lines.
+	XRT_ALIGNAS(IPC_SHARED_CACHE_LINE_SIZE) struct xrt_layer_frame_data data;
 	uint32_t layer_count;
 	struct ipc_layer_entry layers[IPC_MAX_LAYERS];
 };
 
+/*!
+ * A short history of relations for a single pose input on a device, written by
+ * the service and read by clients without a round trip to the service.
+ *
+ * Protected by a sequence lock: the writer increments @ref sequence before and
+ * after updating the samples, so an odd value means an update is in progress.
+ * Readers copy the data out and retry if the sequence changed while copying.
+ *
+ * @ingroup ipc
+ */
+struct ipc_shared_pose_history
+{
+	//! Sequence counter, odd while the service is writing.
+	XRT_ALIGNAS(IPC_SHARED_CACHE_LINE_SIZE) xrt_atomic_s32_t sequence;
+
+	//! Index of the device in @ref ipc_shared_memory::isdevs.
+	uint32_t device_id;
+
+	//! Which pose input on the device.
+	enum xrt_input_name name;
+
+	//! Number of valid samples, at most @ref IPC_SHARED_POSE_HISTORY.
+	uint32_t sample_count;
+
+	//! Total number of samples written, the newest is at (write_count - 1) % IPC_SHARED_POSE_HISTORY.
+	uint32_t write_count;
+
+	uint64_t timestamps_ns[IPC_SHARED_POSE_HISTORY];
+	struct xrt_space_relation relations[IPC_SHARED_POSE_HISTORY];
+};
+
+/*!
+ * Per client area of shared memory that the service writes the outputs of
+ * calls marked `"shm": true` in `proto.json` into, instead of sending them
+ * over the socket. The reply only carries an @ref ipc_shm_ref to the data,
+ * which the client copies out before making its next call.
+ *
+ * @ingroup ipc
+ */
+struct ipc_shared_scratch
+{
+	//! Bumped by the service every time it writes the data.
+	XRT_ALIGNAS(IPC_SHARED_CACHE_LINE_SIZE) uint64_t generation;
+
+	//! 64 bit elements so that any reply struct is aligned.
+	uint64_t data[IPC_SHARED_SCRATCH_SIZE / sizeof(uint64_t)];
+};
+
+/*!
+ * Where in shared memory the service put the outputs of a call, replaces
+ * them in the reply of calls with `"shm": true` outputs.
+ *
+ * @ingroup ipc
+ */
+struct ipc_shm_ref
+{
+	//! Byte offset of the data from the start of @ref ipc_shared_memory.
+	uint32_t offset;
+
+	//! Must match @ref ipc_shared_scratch::generation, or the data is stale.
+	uint32_t generation;
+};
+
+/*!
+ * Image ownership of a swapchain in @ref ipc_shared_swapchain.
+ *
+ * @ingroup ipc
+ */
+enum ipc_shared_image_state
+{
+	IPC_SHARED_IMAGE_AVAILABLE = 0,
+	IPC_SHARED_IMAGE_ACQUIRED = 1,
+};
+
+/*!
+ * Index FIFO and image ownership of a swapchain, only written by the client so
+ * that acquiring and releasing images doesn't need a call to the service, only
+ * waiting on an image does. It is set up by the service when the
+ * swapchain is created, and read by it to see which images have been released
+ * when layers are committed.
+ *
+ * @ingroup ipc
+ */
+struct ipc_shared_swapchain
+{
+	XRT_ALIGNAS(IPC_SHARED_CACHE_LINE_SIZE) uint32_t image_count;
+
+	//! Position in @ref fifo of the next image to acquire.
+	uint32_t head;
+
+	//! Images currently acquired, the other ones are in @ref fifo starting at @ref head.
+	xrt_atomic_s32_t acquired;
+
+	//! Images released ever, wraps around.
+	xrt_atomic_s32_t release_count;
+
+	//! Ring of image indices in the order they are to be acquired.
+	uint32_t fifo[XRT_MAX_SWAPCHAIN_IMAGES];
+
+	//! One of @ref ipc_shared_image_state per image.
+	xrt_atomic_s32_t image_states[XRT_MAX_SWAPCHAIN_IMAGES];
+};
+
+/*!
+ * Measured frame timings of a client's session, written by the service after
+ * every layer commit so the client can read them without a round trip.
+ *
+ * Protected by a sequence lock the same way as @ref ipc_shared_pose_history.
+ *
+ * @ingroup ipc
+ */
+struct ipc_shared_frame_stats
+{
+	//! Sequence counter, odd while the service is writing.
+	XRT_ALIGNAS(IPC_SHARED_CACHE_LINE_SIZE) xrt_atomic_s32_t sequence;
+
+	//! False until the service has written any stats.
+	bool valid;
+
+	struct xrt_compositor_frame_stats stats;
+};
+
+/*!
+ * Per client command channel in shared memory, used for the calls marked
+ * `"channel": true` in `proto.json` once the client has enabled it with
+ * @ref ipc_call_instance_enable_channel. Each connection only ever has one
+ * call in flight so a single request and reply slot is enough.
+ *
+ * Both sides wait on the sequence numbers with a futex instead of a socket,
+ * the socket is still used for all other calls, handles and to detect that
+ * the client has gone away.
+ *
+ * @ingroup ipc
+ */
+struct ipc_shared_channel
+{
+	/*
+	 * Written by the client.
+	 */
+
+	//! Bumped by the client for every request and socket message, the service sleeps on it.
+	XRT_ALIGNAS(IPC_SHARED_CACHE_LINE_SIZE) xrt_atomic_s32_t doorbell;
+
+	//! Sequence number of the latest request, written by the client.
+	xrt_atomic_s32_t request_seq;
+
+	uint32_t request_size;
+
+	//! 64 bit elements so that any message struct is aligned.
+	uint64_t request[IPC_SHARED_CHANNEL_MSG_SIZE / sizeof(uint64_t)];
+
+
+	/*
+	 * Written by the service.
+	 */
+
+	//! Sequence number of the latest request replied to, written by the service.
+	XRT_ALIGNAS(IPC_SHARED_CACHE_LINE_SIZE) xrt_atomic_s32_t reply_seq;
+
+	uint32_t reply_size;
+
+	//! 64 bit elements so that any reply struct is aligned.
+	uint64_t reply[IPC_SHARED_CHANNEL_MSG_SIZE / sizeof(uint64_t)];
+};
+
 /*!
  * A big struct that contains all data that is shared to a client, no pointers
  * allowed in this. To get the inputs of a device you go:
@@ -183,15 +367,37 @@ struct ipc_layer_slot
  * }
  * ```
  *
+ * The fields are grouped into a fixed header, cold data written once at
+ * startup, hot data the service keeps updating and per client areas. The hot
+ * and per client parts are cache line aligned so that the service writing
+ * inputs doesn't stall clients reading their slots and the other way around.
+ *
  * @ingroup ipc
  */
 struct ipc_shared_memory
 {
+	/*
+	 * Header, these fields never move so that any client can check them.
+	 */
+
 	/*!
 	 * The git revision of the service, used by clients to detect version mismatches.
 	 */
 	char u_git_tag[IPC_VERSION_NAME_LEN];
 
+	//! @ref IPC_SHARED_MEMORY_LAYOUT_VERSION of the service.
+	uint32_t layout_version;
+
+	//! Size of this struct in the service, at least as large as what the client knows about.
+	uint32_t layout_size;
+
+
+	/*
+	 * Cold, written once by the service at startup.
+	 */
+
+	uint64_t startup_timestamp;
+
 	/*!
 	 * Number of elements in @ref itracks that are populated/valid.
 	 */
@@ -261,17 +467,58 @@ struct ipc_shared_memory
 		uint32_t blend_mode_count;
 	} hmd;
 
-	struct xrt_input inputs[IPC_SHARED_MAX_INPUTS];
-
-	struct xrt_output outputs[IPC_SHARED_MAX_OUTPUTS];
-
 	struct ipc_shared_binding_profile binding_profiles[IPC_SHARED_MAX_BINDINGS];
 	struct xrt_binding_input_pair input_pairs[IPC_SHARED_MAX_INPUTS];
 	struct xrt_binding_output_pair output_pairs[IPC_SHARED_MAX_OUTPUTS];
 
+	/*!
+	 * Nominal interval between published pose samples, zero when the
+	 * service does not publish poses in shared memory.
+	 */
+	uint64_t pose_publish_interval_ns;
+
+	//! Number of elements in @ref poses that are populated/valid.
+	uint32_t pose_count;
+
+
+	/*
+	 * Hot, written by the service while running, each section starts on
+	 * its own cache line and the per pose, slot and client elements are
+	 * cache line aligned as well.
+	 */
+
+	/*!
+	 * Incremented by the service every time it writes changed data to
+	 * @ref inputs, clients can compare it with the value from their last
+	 * update to know if any input changed.
+	 */
+	XRT_ALIGNAS(IPC_SHARED_CACHE_LINE_SIZE) xrt_atomic_s32_t input_generation;
+
+	struct xrt_input inputs[IPC_SHARED_MAX_INPUTS];
+
+	XRT_ALIGNAS(IPC_SHARED_CACHE_LINE_SIZE) struct xrt_output outputs[IPC_SHARED_MAX_OUTPUTS];
+
+	//! Latest relations of pose inputs, see @ref ipc_shared_pose_history.
+	struct ipc_shared_pose_history poses[IPC_SHARED_MAX_POSES];
+
 	struct ipc_layer_slot slots[IPC_MAX_SLOTS];
 
-	uint64_t startup_timestamp;
+
+	/*
+	 * Per client, indexed by the client's server thread.
+	 */
+
+	//! Scratch areas for large replies.
+	struct ipc_shared_scratch scratch[IPC_MAX_CLIENTS];
+
+	//! Command channels.
+	struct ipc_shared_channel channels[IPC_MAX_CLIENTS];
+
+	//! Swapchain state, indexed by the client and then the swapchain id.
+	struct ipc_shared_swapchain swapchains[IPC_MAX_CLIENTS * IPC_MAX_CLIENT_SWAPCHAINS];
+
+	//! Frame timings of the client's session.
+	struct ipc_shared_frame_stats frame_stats[IPC_MAX_CLIENTS];
 };
 
 /*!
@@ -289,6 +536,22 @@ struct ipc_client_list
 	uint32_t id_count;
 };
 
+/*!
+ * Scheduling priority of a client, derived from which client is the primary
+ * application and which are overlays.
+ *
+ * @ingroup ipc
+ */
+enum ipc_client_priority
+{
+	//! Hidden clients, only need to keep their frame loop ticking.
+	IPC_CLIENT_PRIORITY_LOW = 0,
+	//! Visible overlays, subject to the per client quotas.
+	IPC_CLIENT_PRIORITY_NORMAL = 1,
+	//! The primary application, never limited by the quotas.
+	IPC_CLIENT_PRIORITY_HIGH = 2,
+};
+
 /*!
  * State for a connected application.
  *
@@ -306,6 +569,14 @@ struct ipc_app_state
 	bool session_overlay;
 	bool io_active;
 	uint32_t z_order;
+	//! The client is paced at every this many display periods.
+	uint32_t rate_divisor;
+	//! Decides the core class of its thread and if the quotas apply.
+	enum ipc_client_priority priority;
+	//! The client submitted more layers than allowed and is paced slower.
+	bool over_quota;
+	//! GPU memory of the swapchain images of the client, including ones kept for reuse.
+	uint64_t swapchain_memory;
 	pid_t pid;
 	struct xrt_instance_info info;
 };
@@ -328,3 +599,87 @@ struct ipc_info_get_view_poses_2
 	struct xrt_pose poses[2];
 	struct xrt_space_relation head_relation;
 };
+
+/*!
+ * Arguments for @ref xrt_space_overseer::locate_spaces, the spaces to locate.
+ */
+struct ipc_arg_space_ids
+{
+	uint32_t count;
+	uint32_t ids[IPC_MAX_LOCATE_SPACES];
+};
+
+/*!
+ * Reply for @ref xrt_space_overseer::locate_spaces, one relation per space.
+ */
+struct ipc_arg_space_relations
+{
+	struct xrt_space_relation relations[IPC_MAX_LOCATE_SPACES];
+};
+
+/*!
+ * Points to compute the distortion at for @ref xrt_device::compute_distortion_batch.
+ */
+struct ipc_arg_distortion_uvs
+{
+	uint32_t count;
+	struct xrt_vec2 uvs[IPC_MAX_DISTORTION_POINTS];
+};
+
+/*!
+ * Reply for @ref xrt_device::compute_distortion_batch, one triplet per point.
+ */
+struct ipc_arg_distortion_triplets
+{
+	struct xrt_uv_triplet triplets[IPC_MAX_DISTORTION_POINTS];
+};
+
+/*!
+ * One joint of a @ref ipc_hand_joint_set_compact, 24 bytes instead of the 60
+ * of a @ref xrt_hand_joint_value.
+ */
+struct ipc_hand_joint_compact
+{
+	struct xrt_vec3 position;
+
+	//! Orientation x, y, z and w, scaled by INT16_MAX.
+	int16_t orientation[4];
+
+	//! Radius in units of @ref IPC_HAND_JOINT_RADIUS_UNIT_M.
+	uint16_t radius;
+
+	//! Valid and tracked bits of the joint's relation flags, no velocity bits.
+	uint8_t flags;
+
+	uint8_t _pad;
+};
+
+#define IPC_HAND_JOINT_RADIUS_UNIT_M (0.00001f)
+
+/*!
+ * Reply for a @ref xrt_device::get_hand_tracking call, a @ref
+ * xrt_hand_joint_set without joint velocities and with quantised joint
+ * orientations, a bit over 40% the size.
+ */
+struct ipc_hand_joint_set_compact
+{
+	struct xrt_space_relation hand_pose;
+	struct ipc_hand_joint_compact joints[XRT_HAND_JOINT_COUNT];
+
+	bool is_active;
+
+	//! The device reported joint velocities, these were dropped.
+	bool had_velocities;
+};
+
+/*!
+ * Reply for @ref u_pc_frame_records_read, records of the compositor frames.
+ */
+struct ipc_arg_frame_records
+{
+	//! Sequence number to pass to the next call to continue after these records.
+	uint32_t next;
+
+	uint32_t record_count;
+	struct u_pc_frame_record records[IPC_MAX_FRAME_RECORDS];
+};
@@ -20,6 +20,12 @@
 #include <unistd.h>
 #endif
 
+#if defined(XRT_OS_LINUX)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
@@ -76,6 +82,66 @@ ipc_send(struct ipc_message_channel *imc, const void *data, size_t size)
 	return XRT_SUCCESS;
 }
 
+xrt_result_t
+ipc_send_batch(struct ipc_message_channel *imc,
+               const void *queued_data,
+               size_t queued_size,
+               const void *data,
+               size_t size)
+{
+	struct msghdr msg = {0};
+	struct iovec iov[2] = {0};
+	size_t iov_count = 0;
+
+	if (queued_size > 0) {
+		iov[iov_count].iov_base = (void *)queued_data;
+		iov[iov_count].iov_len = queued_size;
+		iov_count++;
+	}
+
+	iov[iov_count].iov_base = (void *)data;
+	iov[iov_count].iov_len = size;
+	iov_count++;
+
+	msg.msg_name = NULL;
+	msg.msg_namelen = 0;
+	msg.msg_iov = iov;
+	msg.msg_iovlen = iov_count;
+	msg.msg_flags = 0;
+
+	ssize_t ret = sendmsg(imc->ipc_handle, &msg, MSG_NOSIGNAL);
+	if (ret < 0) {
+		int code = errno;
+		IPC_ERROR(imc, "ERROR: Sending batched messages on socket %d failed with error: '%i' '%s'!",
+		          (int)imc->ipc_handle, code, strerror(code));
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	return XRT_SUCCESS;
+}
+
+#if defined(XRT_OS_LINUX)
+bool
+ipc_futex_wait(xrt_atomic_s32_t *word, int32_t expected, uint64_t timeout_ns)
+{
+	struct timespec timeout = {
+	    .tv_sec = (time_t)(timeout_ns / 1000000000),
+	    .tv_nsec = (long)(timeout_ns % 1000000000),
+	};
+
+	// Not FUTEX_PRIVATE_FLAG, the word is shared between processes.
+	long ret = syscall(SYS_futex, word, FUTEX_WAIT, expected, &timeout, NULL, 0);
+
+	return ret == 0 || errno != ETIMEDOUT;
+}
+
+void
+ipc_futex_wake(xrt_atomic_s32_t *word)
+{
+	syscall(SYS_futex, word, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+}
+#endif
+
 xrt_result_t
 ipc_receive(struct ipc_message_channel *imc, void *out_data, size_t size)
 {
@@ -9,6 +9,7 @@
 
 #pragma once
 
+#include <xrt/xrt_compiler.h>
 #include <xrt/xrt_handles.h>
 #include <xrt/xrt_results.h>
 
@@ -69,6 +70,47 @@ ipc_send(struct ipc_message_channel *imc, const void *data, size_t size);
 xrt_result_t
 ipc_receive(struct ipc_message_channel *imc, void *out_data, size_t size);
 
+#ifndef XRT_OS_WINDOWS
+/*!
+ * Send previously queued messages followed by one more message over the IPC
+ * channel, using a single system call. The receiver sees them as if they were
+ * sent one after another with @ref ipc_send.
+ *
+ * @param imc Message channel to use
+ * @param[in] queued_data Already packed messages to send first, may be null
+ * if @p queued_size is 0.
+ * @param[in] queued_size Size of data pointed-to by @p queued_data.
+ * @param[in] data Pointer to the final message to send. Must not be null.
+ * @param[in] size Size of data pointed-to by @p data, must be greater than 0
+ *
+ * @public @memberof ipc_message_channel
+ */
+xrt_result_t
+ipc_send_batch(struct ipc_message_channel *imc,
+               const void *queued_data,
+               size_t queued_size,
+               const void *data,
+               size_t size);
+#endif // !XRT_OS_WINDOWS
+
+#if defined(XRT_OS_LINUX) || defined(XRT_DOXYGEN)
+/*!
+ * Sleep until @p word is woken by @ref ipc_futex_wake, or @p timeout_ns has
+ * passed, returns straight away if @p word doesn't hold @p expected. The word
+ * may be in memory shared with other processes.
+ *
+ * @return false on timeout.
+ */
+bool
+ipc_futex_wait(xrt_atomic_s32_t *word, int32_t expected, uint64_t timeout_ns);
+
+/*!
+ * Wake all threads, in any process, sleeping in @ref ipc_futex_wait on @p word.
+ */
+void
+ipc_futex_wake(xrt_atomic_s32_t *word);
+#endif // XRT_OS_LINUX
+
 /*!
  * @name File Descriptor utilities
  * @brief These are typically called from within the send/receive_handles
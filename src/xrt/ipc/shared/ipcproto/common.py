@@ -104,6 +104,7 @@ class Arg:
         """Construct an argument."""
         self.name = data['name']
         self.typename = data['type']
+        self.is_shm = bool(data.get('shm', False))
         self.is_standard_scalar = False
         self.is_aggregate = False
         self.is_enum = False
@@ -229,6 +230,16 @@ class Call:
         """Decide whether this call needs a msg struct."""
         return self.in_args or self.in_handles
 
+    @property
+    def reply_out_args(self):
+        """Get the outputs sent in the reply over the socket."""
+        return [arg for arg in self.out_args if not arg.is_shm]
+
+    @property
+    def shm_out_args(self):
+        """Get the outputs written to the client's shared memory scratch area."""
+        return [arg for arg in self.out_args if arg.is_shm]
+
     def __init__(self, name, data):
         """Construct a call from call name and call data dictionary."""
         self.id = None
@@ -237,6 +248,8 @@ class Call:
         self.out_args = []
         self.in_handles = None
         self.out_handles = None
+        self.oneway = False
+        self.channel = False
         for key, val in data.items():
             if key == 'id':
                 self.id = val
@@ -248,10 +261,25 @@ class Call:
                 self.out_handles = HandleType(val)
             elif key == 'in_handles':
                 self.in_handles = HandleType(val)
+            elif key == 'oneway':
+                self.oneway = bool(val)
+            elif key == 'channel':
+                self.channel = bool(val)
             else:
                 raise RuntimeError("Unrecognized key")
         if not self.id:
             self.id = "IPC_" + name.upper()
+        if self.oneway and (self.out_args or self.in_handles or
+                            self.out_handles):
+            raise RuntimeError("One-way call " + name +
+                               " can not have outputs or handles")
+        if self.channel and (self.oneway or self.in_handles or
+                             self.out_handles or self.shm_out_args):
+            raise RuntimeError("Channel call " + name +
+                               " can not be one-way, have handles or shm outputs")
+        if any(arg.is_shm for arg in self.in_args):
+            raise RuntimeError("Call " + name +
+                               " can only have shm outputs, not inputs")
 
 
 class Proto:
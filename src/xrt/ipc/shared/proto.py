@@ -67,7 +67,17 @@ ipc_cmd_to_str(ipc_command_t id)
     f.write("\n\tdefault: return \"IPC_UNKNOWN\";")
     f.write("\n\t}\n}\n")
 
-    f.write("#pragma pack (push, 1)")
+    # Outputs written to shared memory, naturally aligned like any other
+    # struct in it, so not packed.
+    for call in p.calls:
+        if call.shm_out_args:
+            f.write("\nstruct ipc_" + call.name + "_shm\n")
+            f.write("{\n")
+            for arg in call.shm_out_args:
+                f.write("\t" + arg.get_struct_field() + ";\n")
+            f.write("};\n")
+
+    f.write("\n#pragma pack (push, 1)")
 
     for call in p.calls:
         # Should we emit a msg struct.
@@ -86,12 +96,40 @@ ipc_cmd_to_str(ipc_command_t id)
             f.write("\nstruct ipc_" + call.name + "_reply\n")
             f.write("{\n")
             f.write("\txrt_result_t result;\n")
-            for arg in call.out_args:
+            for arg in call.reply_out_args:
                 f.write("\t" + arg.get_struct_field() + ";\n")
+            if call.shm_out_args:
+                f.write("\tstruct ipc_shm_ref shm;\n")
             f.write("};\n")
 
     f.write("#pragma pack (pop)\n")
 
+    f.write('''
+static inline size_t
+ipc_cmd_msg_size(ipc_command_t id)
+{
+\tswitch (id) {''')
+    for call in p.calls:
+        if call.needs_msg_struct:
+            size = "sizeof(struct ipc_" + call.name + "_msg)"
+        else:
+            size = "sizeof(struct ipc_command_msg)"
+        f.write("\n\tcase " + call.id + ": return " + size + ";")
+    f.write("\n\tdefault: return 0;")
+    f.write("\n\t}\n}\n")
+
+    f.write('''
+static inline bool
+ipc_cmd_is_channel(ipc_command_t id)
+{
+\tswitch (id) {''')
+    for call in p.calls:
+        if call.channel:
+            f.write("\n\tcase " + call.id + ":")
+    f.write("\n\t\treturn true;")
+    f.write("\n\tdefault: return false;")
+    f.write("\n\t}\n}\n")
+
     f.close()
 
 
@@ -129,6 +167,18 @@ def generate_client_c(file, p):
                     " = " + call.in_handles.count_arg_name + ",\n")
         f.write("\t};\n")
 
+        if call.oneway:
+            f.write("""
+\t// One-way call, queued and sent along with the next call
+\tos_mutex_lock(&ipc_c->mutex);
+\txrt_result_t ret = ipc_client_queue_locked(ipc_c, &_msg, sizeof(_msg));
+\tos_mutex_unlock(&ipc_c->mutex);
+
+\treturn ret;
+}
+""")
+            continue
+
         # Reply struct
         if call.out_args:
             f.write("\tstruct ipc_" + call.name + "_reply _reply;\n")
@@ -143,9 +193,24 @@ def generate_client_c(file, p):
 """)
         cleanup = "os_mutex_unlock(&ipc_c->mutex);"
 
-        # Prepare initial sending
-        func = 'ipc_send'
-        args = ['&ipc_c->imc', '&_msg', 'sizeof(_msg)']
+        if call.channel:
+            # Goes over the shared memory channel if enabled.
+            f.write("\n\t// Send our request and await the reply")
+            write_invocation(f, 'xrt_result_t ret', 'ipc_client_channel_call_locked',
+                             ['ipc_c', '&_msg', 'sizeof(_msg)', '&_reply', 'sizeof(_reply)'],
+                             indent="\t")
+            f.write(';')
+            write_result_handler(f, 'ret', cleanup, indent="\t")
+
+            for arg in call.out_args:
+                f.write("\t*out_" + arg.name + " = _reply." + arg.name + ";\n")
+            f.write("\n\t" + cleanup)
+            f.write("\n\treturn _reply.result;\n}\n")
+            continue
+
+        # Prepare initial sending, also flushes queued one-way calls
+        func = 'ipc_client_send_locked'
+        args = ['ipc_c', '&_msg', 'sizeof(_msg)']
         f.write("\n\t// Send our request")
         write_invocation(f, 'xrt_result_t ret', func, args, indent="\t")
         f.write(';')
@@ -201,8 +266,17 @@ def generate_client_c(file, p):
         f.write(';')
         write_result_handler(f, 'ret', cleanup, indent="\t")
 
+        if call.shm_out_args:
+            f.write("\n\t// The big outputs are in shared memory, copy them out before unlocking\n")
+            f.write("\tconst struct ipc_%s_shm *_shm = ipc_client_scratch_locked(ipc_c, &_reply.shm, sizeof(*_shm));\n" % call.name)
+            f.write("\tif (_shm == NULL) {\n")
+            f.write("\t\t" + cleanup + "\n")
+            f.write("\t\treturn XRT_ERROR_IPC_FAILURE;\n")
+            f.write("\t}\n\n")
+
         for arg in call.out_args:
-            f.write("\t*out_" + arg.name + " = _reply." + arg.name + ";\n")
+            src = "_shm->" if arg.is_shm else "_reply."
+            f.write("\t*out_" + arg.name + " = " + src + arg.name + ";\n")
         f.write("\n\t" + cleanup)
         f.write("\n\treturn _reply.result;\n}\n")
     f.close()
@@ -249,8 +323,21 @@ def generate_server_c(file, p):
 
 #include "ipc_server_generated.h"
 
+#include <assert.h>
+
 ''')
 
+    for call in p.calls:
+        if call.shm_out_args:
+            f.write("static_assert(sizeof(struct ipc_%s_shm) <= IPC_SHARED_SCRATCH_SIZE, "
+                    "\"Outputs of %s don't fit in the scratch area\");\n" % (call.name, call.name))
+        if call.channel:
+            msg = "ipc_%s_msg" % call.name if call.needs_msg_struct else "ipc_command_msg"
+            reply = "ipc_%s_reply" % call.name if call.out_args else "ipc_result_reply"
+            f.write("static_assert(sizeof(struct %s) <= IPC_SHARED_CHANNEL_MSG_SIZE && "
+                    "sizeof(struct %s) <= IPC_SHARED_CHANNEL_MSG_SIZE, "
+                    "\"Messages of %s don't fit in the channel\");\n" % (msg, reply, call.name))
+
     f.write('''
 xrt_result_t
 ipc_dispatch(volatile struct ipc_client_state *ics, ipc_command_t *ipc_command)
@@ -278,6 +365,8 @@ ipc_dispatch(volatile struct ipc_client_state *ics, ipc_command_t *ipc_command)
             f.write("\t\t%s in_%s[XRT_MAX_IPC_HANDLES] = {0};\n" % (
                 call.in_handles.typename, call.in_handles.arg_name))
             f.write("\t\tstruct ipc_command_msg _handle_msg = {0};\n")
+        if call.shm_out_args:
+            f.write("\t\tstruct ipc_%s_shm *shm = ipc_server_scratch_begin(ics);\n" % call.name)
         if call.out_handles:
             f.write("\t\t%s %s[XRT_MAX_IPC_HANDLES] = {0};\n" % (
                 call.out_handles.typename, call.out_handles.arg_name))
@@ -333,7 +422,8 @@ ipc_dispatch(volatile struct ipc_client_state *ics, ipc_command_t *ipc_command)
             args.append(("&msg->" + arg.name)
                         if arg.is_aggregate
                         else ("msg->" + arg.name))
-        args.extend("&reply." + arg.name for arg in call.out_args)
+        args.extend(("&shm->" if arg.is_shm else "&reply.") + arg.name
+                    for arg in call.out_args)
         if call.out_handles:
             args.extend(("XRT_MAX_IPC_HANDLES",
                          call.out_handles.arg_name,
@@ -346,9 +436,31 @@ ipc_dispatch(volatile struct ipc_client_state *ics, ipc_command_t *ipc_command)
                          call.name, args, indent="\t\t")
         f.write(";\n")
 
+        if call.shm_out_args:
+            f.write("\t\tipc_server_scratch_end(ics, &reply.shm);\n")
+
+        if call.oneway:
+            # The client does not wait for a reply, just log any errors.
+            f.write("\t\tif (reply.result != XRT_SUCCESS) {\n")
+            f.write("\t\t\tIPC_WARN(ics->server, \"One-way call " + call.name +
+                    " failed: %d\", reply.result);\n")
+            f.write("\t\t}\n")
+            f.write("\t\treturn XRT_SUCCESS;\n")
+            f.write("\t}\n")
+            continue
+
         # TODO do we check reply.result and
         # error out before replying if it's not success?
 
+        if call.channel:
+            # Replies on the channel if that's where the call came from.
+            write_invocation(f, 'xrt_result_t ret', 'ipc_server_reply',
+                             ["ics", "&reply", "sizeof(reply)"], indent="\t\t")
+            f.write(";")
+            f.write("\n\t\treturn ret;\n")
+            f.write("\t}\n")
+            continue
+
         func = 'ipc_send'
         args = ["(struct ipc_message_channel *)&ics->imc",
                 "&reply",
@@ -186,6 +186,9 @@ render_progress(struct calibration_scene *cs)
 	float capture_completion = ((float)cs->status.num_collected) / (float)cs->params.num_collect_total;
 	igText("Overall progress: %i of %i frames captured", cs->status.num_collected, cs->params.num_collect_total);
 	igProgressBar(capture_completion, progress_dims, NULL);
+	if (cs->status.rp_error > 0.0f) {
+		igText("Reprojection error so far: %f", cs->status.rp_error);
+	}
 
 #else
 	// Unused
@@ -454,7 +454,18 @@ on_histogram_f32_var(const char *name, void *ptr)
 {
 	struct u_var_histogram_f32 *h = (struct u_var_histogram_f32 *)ptr;
 	ImVec2 zero = {h->width, h->height};
-	igPlotHistogramFloatPtr(name, h->values, h->count, 0, NULL, FLT_MAX, FLT_MAX, zero, sizeof(float));
+
+	const float *values = h->values;
+	int count = h->count;
+
+	// Only ever drawn from the GUI thread.
+	static float copy[1024];
+	if (h->block != NULL) {
+		count = u_var_f32_block_read(h->block, copy, (int)ARRAY_SIZE(copy));
+		values = copy;
+	}
+
+	igPlotHistogramFloatPtr(name, values, count, 0, NULL, FLT_MAX, FLT_MAX, zero, sizeof(float));
 }
 
 static void
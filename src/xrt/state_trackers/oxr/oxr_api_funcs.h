@@ -564,6 +564,29 @@ oxr_xrGetDisplayRefreshRateFB(XrSession session, float *displayRefreshRate);
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrRequestDisplayRefreshRateFB(XrSession session, float displayRefreshRate);
 
+#ifdef OXR_HAVE_META_performance_metrics
+//! OpenXR API function @ep{xrEnumeratePerformanceMetricsCounterPathsMETA}
+XRAPI_ATTR XrResult XRAPI_CALL
+oxr_xrEnumeratePerformanceMetricsCounterPathsMETA(XrInstance instance,
+                                                  uint32_t counterPathCapacityInput,
+                                                  uint32_t *counterPathCountOutput,
+                                                  XrPath *counterPaths);
+
+//! OpenXR API function @ep{xrSetPerformanceMetricsStateMETA}
+XRAPI_ATTR XrResult XRAPI_CALL
+oxr_xrSetPerformanceMetricsStateMETA(XrSession session, const XrPerformanceMetricsStateMETA *state);
+
+//! OpenXR API function @ep{xrGetPerformanceMetricsStateMETA}
+XRAPI_ATTR XrResult XRAPI_CALL
+oxr_xrGetPerformanceMetricsStateMETA(XrSession session, XrPerformanceMetricsStateMETA *state);
+
+//! OpenXR API function @ep{xrQueryPerformanceMetricsCounterMETA}
+XRAPI_ATTR XrResult XRAPI_CALL
+oxr_xrQueryPerformanceMetricsCounterMETA(XrSession session,
+                                         XrPath counterPath,
+                                         XrPerformanceMetricsCounterMETA *counter);
+#endif // OXR_HAVE_META_performance_metrics
+
 /*!
  * @}
  */
@@ -242,6 +242,13 @@ handle_non_null(struct oxr_instance *inst, struct oxr_logger *log, const char *n
 	ENTRY_IF_EXT(xrRequestDisplayRefreshRateFB, FB_display_refresh_rate);
 #endif
 
+#ifdef OXR_HAVE_META_performance_metrics
+	ENTRY_IF_EXT(xrEnumeratePerformanceMetricsCounterPathsMETA, META_performance_metrics);
+	ENTRY_IF_EXT(xrSetPerformanceMetricsStateMETA, META_performance_metrics);
+	ENTRY_IF_EXT(xrGetPerformanceMetricsStateMETA, META_performance_metrics);
+	ENTRY_IF_EXT(xrQueryPerformanceMetricsCounterMETA, META_performance_metrics);
+#endif
+
 #ifdef OXR_HAVE_EXT_debug_utils
 	ENTRY_IF_EXT(xrSetDebugUtilsObjectNameEXT, EXT_debug_utils);
 	ENTRY_IF_EXT(xrCreateDebugUtilsMessengerEXT, EXT_debug_utils);
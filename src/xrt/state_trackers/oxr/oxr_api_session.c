@@ -11,9 +11,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <inttypes.h>
+#include <assert.h>
 
 #include "xrt/xrt_compiler.h"
 
+#include "util/u_time.h"
 #include "util/u_debug.h"
 #include "util/u_trace_marker.h"
 
@@ -294,8 +296,25 @@ oxr_xrPerfSettingsSetPerformanceLevelEXT(XrSession session,
 	struct oxr_logger log;
 	OXR_VERIFY_SESSION_AND_INIT_LOG(&log, session, sess, "xrPerfSettingsSetPerformanceLevelEXT");
 	OXR_VERIFY_SESSION_NOT_LOST(&log, sess);
+	OXR_VERIFY_EXTENSION(&log, sess->sys->inst, EXT_performance_settings);
 
-	return oxr_error(&log, XR_ERROR_HANDLE_INVALID, "Not implemented");
+	if (domain != XR_PERF_SETTINGS_DOMAIN_CPU_EXT && domain != XR_PERF_SETTINGS_DOMAIN_GPU_EXT) {
+		return oxr_error(&log, XR_ERROR_VALIDATION_FAILURE, "(domain == 0x%08x) is not a valid domain",
+		                 (uint32_t)domain);
+	}
+
+	switch (level) {
+	case XR_PERF_SETTINGS_LEVEL_POWER_SAVINGS_EXT:
+	case XR_PERF_SETTINGS_LEVEL_SUSTAINED_LOW_EXT:
+	case XR_PERF_SETTINGS_LEVEL_SUSTAINED_HIGH_EXT:
+	case XR_PERF_SETTINGS_LEVEL_BOOST_EXT: break;
+	default:
+		return oxr_error(&log, XR_ERROR_VALIDATION_FAILURE, "(level == 0x%08x) is not a valid level",
+		                 (uint32_t)level);
+	}
+
+	// The clocks are not ours to change, the level is only a hint.
+	return XR_SUCCESS;
 }
 
 #endif
@@ -341,6 +360,7 @@ oxr_hand_tracker_destroy_cb(struct oxr_logger *log, struct oxr_handle_base *hb)
 {
 	struct oxr_hand_tracker *hand_tracker = (struct oxr_hand_tracker *)hb;
 
+	os_mutex_destroy(&hand_tracker->cache.mutex);
 	free(hand_tracker);
 
 	return XR_SUCCESS;
@@ -363,6 +383,7 @@ oxr_hand_tracker_create(struct oxr_logger *log,
 	hand_tracker->sess = sess;
 	hand_tracker->hand = createInfo->hand;
 	hand_tracker->hand_joint_set = createInfo->handJointSet;
+	os_mutex_init(&hand_tracker->cache.mutex);
 
 	// Find the assigned device.
 	struct xrt_device *xdev = NULL;
@@ -583,3 +604,188 @@ oxr_xrRequestDisplayRefreshRateFB(XrSession session, float displayRefreshRate)
 }
 
 #endif
+
+
+/*
+ *
+ * XR_META_performance_metrics
+ *
+ */
+
+#ifdef OXR_HAVE_META_performance_metrics
+
+enum oxr_performance_metrics_counter
+{
+	OXR_PERFORMANCE_METRICS_APP_CPU_FRAMETIME,
+	OXR_PERFORMANCE_METRICS_APP_GPU_FRAMETIME,
+	OXR_PERFORMANCE_METRICS_APP_MOTION_TO_PHOTON_LATENCY,
+	OXR_PERFORMANCE_METRICS_COMPOSITOR_GPU_FRAMETIME,
+	OXR_PERFORMANCE_METRICS_COMPOSITOR_DROPPED_FRAME_COUNT,
+	OXR_PERFORMANCE_METRICS_COUNTER_COUNT,
+};
+
+static const char *performance_metrics_counter_paths[OXR_PERFORMANCE_METRICS_COUNTER_COUNT] = {
+    "/perfmetrics_meta/app/cpu_frametime",
+    "/perfmetrics_meta/app/gpu_frametime",
+    "/perfmetrics_meta/app/motion_to_photon_latency",
+    "/perfmetrics_meta/compositor/gpu_frametime",
+    "/perfmetrics_meta/compositor/dropped_frame_count",
+};
+
+static XrResult
+get_performance_metrics_counter_paths(struct oxr_logger *log, struct oxr_instance *inst, XrPath *out_paths)
+{
+	for (uint32_t i = 0; i < OXR_PERFORMANCE_METRICS_COUNTER_COUNT; i++) {
+		const char *str = performance_metrics_counter_paths[i];
+		XrResult ret = oxr_path_get_or_create(log, inst, str, strlen(str), &out_paths[i]);
+		if (ret != XR_SUCCESS) {
+			return ret;
+		}
+	}
+
+	return XR_SUCCESS;
+}
+
+static void
+fill_in_counter_ms(XrPerformanceMetricsCounterMETA *counter, bool valid, uint64_t value_ns)
+{
+	counter->counterUnit = XR_PERFORMANCE_METRICS_COUNTER_UNIT_MILLISECONDS_META;
+	counter->counterFlags = 0;
+	counter->uintValue = 0;
+	counter->floatValue = 0.0f;
+
+	if (valid) {
+		counter->counterFlags = XR_PERFORMANCE_METRICS_COUNTER_ANY_VALUE_VALID_BIT_META |
+		                        XR_PERFORMANCE_METRICS_COUNTER_FLOAT_VALUE_VALID_BIT_META;
+		counter->floatValue = time_ns_to_ms_f((time_duration_ns)value_ns);
+	}
+}
+
+static void
+fill_in_counter_count(XrPerformanceMetricsCounterMETA *counter, bool valid, uint64_t value)
+{
+	counter->counterUnit = XR_PERFORMANCE_METRICS_COUNTER_UNIT_GENERIC_META;
+	counter->counterFlags = 0;
+	counter->uintValue = 0;
+	counter->floatValue = 0.0f;
+
+	if (valid) {
+		counter->counterFlags = XR_PERFORMANCE_METRICS_COUNTER_ANY_VALUE_VALID_BIT_META |
+		                        XR_PERFORMANCE_METRICS_COUNTER_UINT_VALUE_VALID_BIT_META;
+		counter->uintValue = value > UINT32_MAX ? UINT32_MAX : (uint32_t)value;
+	}
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL
+oxr_xrEnumeratePerformanceMetricsCounterPathsMETA(XrInstance instance,
+                                                  uint32_t counterPathCapacityInput,
+                                                  uint32_t *counterPathCountOutput,
+                                                  XrPath *counterPaths)
+{
+	OXR_TRACE_MARKER();
+
+	struct oxr_instance *inst;
+	struct oxr_logger log;
+	OXR_VERIFY_INSTANCE_AND_INIT_LOG(&log, instance, inst, "xrEnumeratePerformanceMetricsCounterPathsMETA");
+
+	XrPath paths[OXR_PERFORMANCE_METRICS_COUNTER_COUNT];
+	XrResult ret = get_performance_metrics_counter_paths(&log, inst, paths);
+	if (ret != XR_SUCCESS) {
+		return ret;
+	}
+
+	OXR_TWO_CALL_HELPER(&log, counterPathCapacityInput, counterPathCountOutput, counterPaths,
+	                    OXR_PERFORMANCE_METRICS_COUNTER_COUNT, paths, XR_SUCCESS);
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL
+oxr_xrSetPerformanceMetricsStateMETA(XrSession session, const XrPerformanceMetricsStateMETA *state)
+{
+	OXR_TRACE_MARKER();
+
+	struct oxr_session *sess;
+	struct oxr_logger log;
+	OXR_VERIFY_SESSION_AND_INIT_LOG(&log, session, sess, "xrSetPerformanceMetricsStateMETA");
+	OXR_VERIFY_SESSION_NOT_LOST(&log, sess);
+	OXR_VERIFY_ARG_TYPE_AND_NOT_NULL(&log, state, XR_TYPE_PERFORMANCE_METRICS_STATE_META);
+
+	sess->performance_metrics_enabled = state->enabled == XR_TRUE;
+
+	return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL
+oxr_xrGetPerformanceMetricsStateMETA(XrSession session, XrPerformanceMetricsStateMETA *state)
+{
+	OXR_TRACE_MARKER();
+
+	struct oxr_session *sess;
+	struct oxr_logger log;
+	OXR_VERIFY_SESSION_AND_INIT_LOG(&log, session, sess, "xrGetPerformanceMetricsStateMETA");
+	OXR_VERIFY_SESSION_NOT_LOST(&log, sess);
+	OXR_VERIFY_ARG_TYPE_AND_NOT_NULL(&log, state, XR_TYPE_PERFORMANCE_METRICS_STATE_META);
+
+	state->enabled = sess->performance_metrics_enabled ? XR_TRUE : XR_FALSE;
+
+	return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL
+oxr_xrQueryPerformanceMetricsCounterMETA(XrSession session,
+                                         XrPath counterPath,
+                                         XrPerformanceMetricsCounterMETA *counter)
+{
+	OXR_TRACE_MARKER();
+
+	struct oxr_session *sess;
+	struct oxr_logger log;
+	OXR_VERIFY_SESSION_AND_INIT_LOG(&log, session, sess, "xrQueryPerformanceMetricsCounterMETA");
+	OXR_VERIFY_SESSION_NOT_LOST(&log, sess);
+	OXR_VERIFY_ARG_TYPE_AND_NOT_NULL(&log, counter, XR_TYPE_PERFORMANCE_METRICS_COUNTER_META);
+
+	if (!sess->performance_metrics_enabled) {
+		return oxr_error(&log, XR_ERROR_VALIDATION_FAILURE, "Performance metrics have not been enabled");
+	}
+
+	XrPath paths[OXR_PERFORMANCE_METRICS_COUNTER_COUNT];
+	XrResult ret = get_performance_metrics_counter_paths(&log, sess->sys->inst, paths);
+	if (ret != XR_SUCCESS) {
+		return ret;
+	}
+
+	uint32_t index = 0;
+	while (index < OXR_PERFORMANCE_METRICS_COUNTER_COUNT && paths[index] != counterPath) {
+		index++;
+	}
+	if (index == OXR_PERFORMANCE_METRICS_COUNTER_COUNT) {
+		return oxr_error(&log, XR_ERROR_PATH_UNSUPPORTED, "(counterPath) not a supported counter");
+	}
+
+	// Headless sessions and compositors without stats report no valid values.
+	struct xrt_compositor_frame_stats stats = {0};
+	bool valid = sess->compositor != NULL && xrt_comp_get_frame_stats(sess->compositor, &stats) == XRT_SUCCESS &&
+	             stats.app_frame_count > 0;
+
+	switch ((enum oxr_performance_metrics_counter)index) {
+	case OXR_PERFORMANCE_METRICS_APP_CPU_FRAMETIME:
+		fill_in_counter_ms(counter, valid, stats.app_cpu_time_ns);
+		break;
+	case OXR_PERFORMANCE_METRICS_APP_GPU_FRAMETIME:
+		fill_in_counter_ms(counter, valid, stats.app_gpu_time_ns);
+		break;
+	case OXR_PERFORMANCE_METRICS_APP_MOTION_TO_PHOTON_LATENCY:
+		fill_in_counter_ms(counter, valid, stats.app_latency_ns);
+		break;
+	case OXR_PERFORMANCE_METRICS_COMPOSITOR_GPU_FRAMETIME:
+		fill_in_counter_ms(counter, valid, stats.compositor_gpu_time_ns);
+		break;
+	case OXR_PERFORMANCE_METRICS_COMPOSITOR_DROPPED_FRAME_COUNT:
+		fill_in_counter_count(counter, valid, stats.app_missed_frame_count);
+		break;
+	default: assert(false); break;
+	}
+
+	return XR_SUCCESS;
+}
+
+#endif // OXR_HAVE_META_performance_metrics
@@ -9,6 +9,8 @@
 
 #pragma once
 
+#include <inttypes.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -31,6 +33,35 @@ extern "C" {
 		oxr_log_set_instance(log, lookup);                                                                     \
 	} while (0)
 
+/*!
+ * Like OXR_VERIFY_AND_SET_AND_INIT but for handles from a @ref oxr_handle_table,
+ * @p from_openxr looks the handle up and returns NULL if it is not valid.
+ */
+#define OXR_VERIFY_TABLE_AND_SET_AND_INIT(log, thing, new_thing, from_openxr, name, lookup)                            \
+	do {                                                                                                           \
+		oxr_log_init(log, name);                                                                               \
+		if (thing == XR_NULL_HANDLE) {                                                                         \
+			return oxr_error(log, XR_ERROR_HANDLE_INVALID, "(" #thing " == NULL)");                        \
+		}                                                                                                      \
+		new_thing = from_openxr(thing);                                                                        \
+		if (new_thing == NULL) {                                                                               \
+			return oxr_error(log, XR_ERROR_HANDLE_INVALID, "(" #thing " == 0x%" PRIx64 ")",                \
+			                 (uint64_t)thing);                                                             \
+		}                                                                                                      \
+		oxr_log_set_instance(log, lookup);                                                                     \
+	} while (0)
+
+#define OXR_VERIFY_TABLE_SET(log, arg, new_arg, from_openxr)                                                           \
+	do {                                                                                                           \
+		if (arg == XR_NULL_HANDLE) {                                                                           \
+			return oxr_error(log, XR_ERROR_HANDLE_INVALID, "(" #arg " == NULL)");                          \
+		}                                                                                                      \
+		new_arg = from_openxr(arg);                                                                            \
+		if (new_arg == NULL) {                                                                                 \
+			return oxr_error(log, XR_ERROR_HANDLE_INVALID, "(" #arg " == 0x%" PRIx64 ")", (uint64_t)arg);  \
+		}                                                                                                      \
+	} while (0)
+
 #define OXR_VERIFY_SET(log, arg, new_arg, oxr_thing, THING)                                                            \
 	do {                                                                                                           \
 		if (arg == XR_NULL_HANDLE) {                                                                           \
@@ -56,7 +87,7 @@ extern "C" {
 #define OXR_VERIFY_SESSION_AND_INIT_LOG(log, thing, new_thing, name) \
 	OXR_VERIFY_AND_SET_AND_INIT(log, thing, new_thing, oxr_session, SESSION, name, new_thing->sys->inst)
 #define OXR_VERIFY_SPACE_AND_INIT_LOG(log, thing, new_thing, name) \
-	OXR_VERIFY_AND_SET_AND_INIT(log, thing, new_thing, oxr_space, SPACE, name, new_thing->sess->sys->inst)
+	OXR_VERIFY_TABLE_AND_SET_AND_INIT(log, thing, new_thing, oxr_space_from_openxr, name, new_thing->sess->sys->inst)
 #define OXR_VERIFY_ACTION_AND_INIT_LOG(log, thing, new_thing, name) \
 	OXR_VERIFY_AND_SET_AND_INIT(log, thing, new_thing, oxr_action, ACTION, name, new_thing->act_set->inst)
 #define OXR_VERIFY_SWAPCHAIN_AND_INIT_LOG(log, thing, new_thing, name) \
@@ -72,7 +103,7 @@ extern "C" {
 #define OXR_VERIFY_INSTANCE_NOT_NULL(log, arg, new_arg) OXR_VERIFY_SET(log, arg, new_arg, oxr_instance, INSTANCE);
 #define OXR_VERIFY_MESSENGER_NOT_NULL(log, arg, new_arg) OXR_VERIFY_SET(log, arg, new_arg, oxr_messenger, MESSENGER);
 #define OXR_VERIFY_SESSION_NOT_NULL(log, arg, new_arg) OXR_VERIFY_SET(log, arg, new_arg, oxr_session, SESSION);
-#define OXR_VERIFY_SPACE_NOT_NULL(log, arg, new_arg) OXR_VERIFY_SET(log, arg, new_arg, oxr_space, SPACE);
+#define OXR_VERIFY_SPACE_NOT_NULL(log, arg, new_arg) OXR_VERIFY_TABLE_SET(log, arg, new_arg, oxr_space_from_openxr);
 #define OXR_VERIFY_ACTION_NOT_NULL(log, arg, new_arg) OXR_VERIFY_SET(log, arg, new_arg, oxr_action, ACTION);
 #define OXR_VERIFY_SWAPCHAIN_NOT_NULL(log, arg, new_arg) OXR_VERIFY_SET(log, arg, new_arg, oxr_swapchain, SWAPCHAIN);
 #define OXR_VERIFY_ACTIONSET_NOT_NULL(log, arg, new_arg) OXR_VERIFY_SET(log, arg, new_arg, oxr_action_set, ACTIONSET);
@@ -19,6 +19,7 @@
 #include "oxr_subaction.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 
 
 static void
@@ -44,6 +45,144 @@ setup_paths(struct oxr_logger *log,
 	}
 }
 
+static int
+compare_path_entry(const void *a_ptr, const void *b_ptr)
+{
+	const struct oxr_binding_path_entry *a = (const struct oxr_binding_path_entry *)a_ptr;
+	const struct oxr_binding_path_entry *b = (const struct oxr_binding_path_entry *)b_ptr;
+
+	if (a->path != b->path) {
+		return a->path < b->path ? -1 : 1;
+	}
+	if (a->binding_index != b->binding_index) {
+		return a->binding_index < b->binding_index ? -1 : 1;
+	}
+	if (a->path_index != b->path_index) {
+		return a->path_index < b->path_index ? -1 : 1;
+	}
+	return 0;
+}
+
+static int
+compare_key_entry(const void *a_ptr, const void *b_ptr)
+{
+	const struct oxr_binding_key_entry *a = (const struct oxr_binding_key_entry *)a_ptr;
+	const struct oxr_binding_key_entry *b = (const struct oxr_binding_key_entry *)b_ptr;
+
+	if (a->key != b->key) {
+		return a->key < b->key ? -1 : 1;
+	}
+	if (a->binding_index != b->binding_index) {
+		return a->binding_index < b->binding_index ? -1 : 1;
+	}
+	return 0;
+}
+
+/*!
+ * Index of the first entry in @ref oxr_interaction_profile::path_index with
+ * a path not less than @p path.
+ */
+static size_t
+path_index_lower_bound(const struct oxr_interaction_profile *p, XrPath path)
+{
+	size_t low = 0;
+	size_t high = p->path_index_count;
+
+	while (low < high) {
+		size_t mid = low + (high - low) / 2;
+		if (p->path_index[mid].path < path) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+
+	return low;
+}
+
+/*!
+ * Index of the first entry in @ref oxr_interaction_profile::key_index with a
+ * key not less than @p key.
+ */
+static size_t
+key_index_lower_bound(const struct oxr_interaction_profile *p, uint32_t key)
+{
+	size_t low = 0;
+	size_t high = p->key_index_count;
+
+	while (low < high) {
+		size_t mid = low + (high - low) / 2;
+		if (p->key_index[mid].key < key) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+
+	return low;
+}
+
+static void
+build_path_index(struct oxr_interaction_profile *p)
+{
+	size_t count = 0;
+	for (size_t x = 0; x < p->binding_count; x++) {
+		count += p->bindings[x].path_count;
+	}
+
+	p->path_index = U_TYPED_ARRAY_CALLOC(struct oxr_binding_path_entry, count);
+	p->path_index_count = count;
+
+	size_t index = 0;
+	for (size_t x = 0; x < p->binding_count; x++) {
+		struct oxr_binding *b = &p->bindings[x];
+
+		for (uint32_t y = 0; y < b->path_count; y++) {
+			p->path_index[index].path = b->paths[y];
+			p->path_index[index].binding_index = (uint32_t)x;
+			p->path_index[index].path_index = y;
+			index++;
+		}
+	}
+
+	if (count > 0) {
+		qsort(p->path_index, count, sizeof(*p->path_index), compare_path_entry);
+	}
+}
+
+static void
+build_key_index(struct oxr_interaction_profile *p)
+{
+	free(p->key_index);
+	p->key_index = NULL;
+	p->key_index_count = 0;
+
+	size_t count = 0;
+	for (size_t x = 0; x < p->binding_count; x++) {
+		count += p->bindings[x].key_count;
+	}
+
+	if (count == 0) {
+		return;
+	}
+
+	p->key_index = U_TYPED_ARRAY_CALLOC(struct oxr_binding_key_entry, count);
+	p->key_index_count = count;
+
+	size_t index = 0;
+	for (size_t x = 0; x < p->binding_count; x++) {
+		struct oxr_binding *b = &p->bindings[x];
+
+		for (uint32_t y = 0; y < b->key_count; y++) {
+			p->key_index[index].key = b->keys[y];
+			p->key_index[index].binding_index = (uint32_t)x;
+			index++;
+		}
+	}
+
+	qsort(p->key_index, count, sizeof(*p->key_index), compare_key_entry);
+}
+
 static bool
 interaction_profile_find(struct oxr_logger *log,
                          struct oxr_instance *inst,
@@ -81,12 +220,18 @@ interaction_profile_find_or_create(struct oxr_logger *log,
 
 	struct profile_template *templ = NULL;
 
-	for (size_t x = 0; x < NUM_PROFILE_TEMPLATES; x++) {
-		XrPath t_path = XR_NULL_PATH;
+	// Intern the template paths once, then it's just comparing integers.
+	if (inst->profile_template_paths == NULL) {
+		inst->profile_template_paths = U_TYPED_ARRAY_CALLOC(XrPath, NUM_PROFILE_TEMPLATES);
+
+		for (size_t x = 0; x < NUM_PROFILE_TEMPLATES; x++) {
+			oxr_path_get_or_create(log, inst, profile_templates[x].path, strlen(profile_templates[x].path),
+			                       &inst->profile_template_paths[x]);
+		}
+	}
 
-		oxr_path_get_or_create(log, inst, profile_templates[x].path, strlen(profile_templates[x].path),
-		                       &t_path);
-		if (t_path == path) {
+	for (size_t x = 0; x < NUM_PROFILE_TEMPLATES; x++) {
+		if (inst->profile_template_paths[x] == path) {
 			templ = &profile_templates[x];
 			break;
 		}
@@ -149,6 +294,8 @@ interaction_profile_find_or_create(struct oxr_logger *log,
 		d->activate = t->activate;
 	}
 
+	build_path_index(p);
+
 	// Add to the list of currently created interaction profiles.
 	U_ARRAY_REALLOC_OR_FREE(inst->profiles, struct oxr_interaction_profile *, (inst->profile_count + 1));
 	inst->profiles[inst->profile_count++] = p;
@@ -177,24 +324,24 @@ reset_all_keys(struct oxr_binding *bindings, size_t binding_count)
 }
 
 static void
-add_key_to_matching_bindings(struct oxr_binding *bindings, size_t binding_count, XrPath path, uint32_t key)
+add_key_to_matching_bindings(struct oxr_interaction_profile *p, XrPath path, uint32_t key)
 {
-	for (size_t x = 0; x < binding_count; x++) {
-		struct oxr_binding *b = &bindings[x];
+	uint32_t last_binding_index = UINT32_MAX;
 
-		bool found = false;
-		uint32_t preferred_path_index;
-		for (uint32_t y = 0; y < b->path_count; y++) {
-			if (b->paths[y] == path) {
-				found = true;
-				preferred_path_index = y;
-				break;
-			}
+	// Sorted by binding then path index, so the first entry per binding is the first matching path.
+	for (size_t x = path_index_lower_bound(p, path); x < p->path_index_count; x++) {
+		const struct oxr_binding_path_entry *entry = &p->path_index[x];
+		if (entry->path != path) {
+			break;
 		}
 
-		if (!found) {
+		if (entry->binding_index == last_binding_index) {
 			continue;
 		}
+		last_binding_index = entry->binding_index;
+
+		struct oxr_binding *b = &p->bindings[entry->binding_index];
+		uint32_t preferred_path_index = entry->path_index;
 
 		U_ARRAY_REALLOC_OR_FREE(b->keys, uint32_t, (b->key_count + 1));
 		U_ARRAY_REALLOC_OR_FREE(b->preferred_binding_path_index, uint32_t, (b->key_count + 1));
@@ -295,17 +442,10 @@ get_identifier_str_in_profile(struct oxr_logger *log,
 		return NULL;
 	}
 
-	for (size_t i = 0; i < oip->binding_count; i++) {
-		struct oxr_binding *binding = &oip->bindings[i];
-
-		for (size_t k = 0; k < binding->path_count; k++) {
-			if (binding->paths[k] != path) {
-				continue;
-			}
-			str = binding->localized_name;
-			i = oip->binding_count; // Break the outer loop as well.
-			break;
-		}
+	// The first entry is from the first binding with this path.
+	size_t x = path_index_lower_bound(oip, path);
+	if (x < oip->path_index_count && oip->path_index[x].path == path) {
+		str = oip->bindings[oip->path_index[x].binding_index].localized_name;
 	}
 
 	return str;
@@ -403,22 +543,26 @@ oxr_binding_find_bindings_from_key(struct oxr_logger *log,
 	}
 
 	//! @todo This function should be a two call function, or handle more
-	//! then 32 bindings.
+	//! then OXR_MAX_BINDINGS_PER_ACTION bindings.
 	size_t num = 0;
+	uint32_t last_binding_index = UINT32_MAX;
 
-	for (size_t y = 0; y < p->binding_count; y++) {
-		struct oxr_binding *b = &p->bindings[y];
+	// Sorted by binding index within a key, so same order as the bindings.
+	for (size_t x = key_index_lower_bound(p, key); x < p->key_index_count; x++) {
+		const struct oxr_binding_key_entry *entry = &p->key_index[x];
+		if (entry->key != key) {
+			break;
+		}
 
-		for (size_t z = 0; z < b->key_count; z++) {
-			if (b->keys[z] == key) {
-				bindings[num++] = b;
-				break;
-			}
+		if (entry->binding_index == last_binding_index) {
+			continue;
 		}
+		last_binding_index = entry->binding_index;
 
-		if (num >= 32) {
-			*binding_count = num;
-			return;
+		bindings[num++] = &p->bindings[entry->binding_index];
+
+		if (num >= OXR_MAX_BINDINGS_PER_ACTION) {
+			break;
 		}
 	}
 
@@ -446,6 +590,14 @@ oxr_binding_destroy_all(struct oxr_logger *log, struct oxr_instance *inst)
 		p->bindings = NULL;
 		p->binding_count = 0;
 
+		free(p->path_index);
+		p->path_index = NULL;
+		p->path_index_count = 0;
+
+		free(p->key_index);
+		p->key_index = NULL;
+		p->key_index_count = 0;
+
 		oxr_dpad_state_deinit(&p->dpad_state);
 
 		free(p);
@@ -454,6 +606,9 @@ oxr_binding_destroy_all(struct oxr_logger *log, struct oxr_instance *inst)
 	free(inst->profiles);
 	inst->profiles = NULL;
 	inst->profile_count = 0;
+
+	free(inst->profile_template_paths);
+	inst->profile_template_paths = NULL;
 }
 
 
@@ -480,11 +635,8 @@ oxr_action_suggest_interaction_profile_bindings(struct oxr_logger *log,
 		goto out;
 	}
 
-	struct oxr_binding *bindings = p->bindings;
-	size_t binding_count = p->binding_count;
-
 	// Everything is now valid, reset the keys.
-	reset_all_keys(bindings, binding_count);
+	reset_all_keys(p->bindings, p->binding_count);
 	// Transfer ownership of dpad state to profile
 	oxr_dpad_state_deinit(&p->dpad_state);
 	p->dpad_state = *dpad_state;
@@ -494,9 +646,11 @@ oxr_action_suggest_interaction_profile_bindings(struct oxr_logger *log,
 		const XrActionSuggestedBinding *s = &suggestedBindings->suggestedBindings[i];
 		struct oxr_action *act = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_action *, s->action);
 
-		add_key_to_matching_bindings(bindings, binding_count, s->binding, act->act_key);
+		add_key_to_matching_bindings(p, s->binding, act->act_key);
 	}
 
+	build_key_index(p);
+
 out:
 	oxr_dpad_state_deinit(dpad_state); // if it hasn't been moved
 
@@ -19,117 +19,85 @@
 #include <stdlib.h>
 
 
-/*
- *
- * Struct and defines.
- *
- */
-
-struct oxr_event
-{
-	struct oxr_event *next;
-	size_t length;
-	XrResult result;
-};
-
-
 /*
  *
  * Internal helpers.
  *
  */
 
-void
+static void
 lock(struct oxr_instance *inst)
 {
 	os_mutex_lock(&inst->event.mutex);
 }
 
-void
+static void
 unlock(struct oxr_instance *inst)
 {
 	os_mutex_unlock(&inst->event.mutex);
 }
 
-void *
-oxr_event_extra(struct oxr_event *event)
+static inline struct oxr_event *
+get_event(struct oxr_instance *inst, uint32_t index)
 {
-	return &event[1];
+	return &inst->event.ring[(inst->event.head + index) % OXR_MAX_EVENT_COUNT];
 }
 
-struct oxr_event *
-pop(struct oxr_instance *inst)
+/*!
+ * Get the next free slot in the ring, returns NULL and counts the event as
+ * lost if the ring is full. Must be called with the lock held, the event is
+ * queued with @ref push.
+ */
+static struct oxr_event *
+reserve(struct oxr_instance *inst, size_t length)
 {
-	struct oxr_event *ret = inst->event.next;
-	if (ret == NULL) {
+	uint32_t count = (uint32_t)inst->event.count;
+	if (count >= OXR_MAX_EVENT_COUNT) {
+		xrt_atomic_s32_inc_return(&inst->event.lost_count);
 		return NULL;
 	}
 
-	inst->event.next = ret->next;
-	ret->next = NULL;
-
-	if (ret == inst->event.last) {
-		inst->event.last = NULL;
-	}
+	struct oxr_event *event = get_event(inst, count);
+	U_ZERO(event);
+	event->result = XR_SUCCESS;
+	event->length = length;
 
-	return ret;
+	return event;
 }
 
-void
-push(struct oxr_instance *inst, struct oxr_event *event)
+/*!
+ * Queue the event gotten from @ref reserve, must be called with the lock held.
+ */
+static void
+push(struct oxr_instance *inst)
 {
-	struct oxr_event *last = inst->event.last;
-	if (last != NULL) {
-		last->next = event;
-	}
-	inst->event.last = event;
-
-	if (inst->event.next == NULL) {
-		inst->event.next = event;
-	}
+	xrt_atomic_s32_inc_return(&inst->event.count);
 }
 
-#define ALLOC(log, inst, event, extra)                                                                                 \
-	do {                                                                                                           \
-		XrResult ret = oxr_event_alloc(log, inst, sizeof(**extra), event);                                     \
-		if (ret != XR_SUCCESS) {                                                                               \
-			return ret;                                                                                    \
-		}                                                                                                      \
-		*((void **)extra) = oxr_event_extra(*event);                                                           \
-	} while (false)
-
-static XrResult
-oxr_event_alloc(struct oxr_logger *log, struct oxr_instance *inst, size_t size, struct oxr_event **out_event)
+/*!
+ * Copy out and remove the oldest event, must be called with the lock held.
+ */
+static bool
+pop(struct oxr_instance *inst, struct oxr_event *out_event)
 {
-	struct oxr_event *event = U_CALLOC_WITH_CAST(struct oxr_event, sizeof(struct oxr_event) + size);
-
-	if (event == NULL) {
-		return oxr_error(log, XR_ERROR_RUNTIME_FAILURE, "Out of memory");
+	if (inst->event.count == 0) {
+		return false;
 	}
 
-	event->next = NULL;
-	event->length = size;
-	event->result = XR_SUCCESS;
-
-	*out_event = event;
+	*out_event = *get_event(inst, 0);
+	inst->event.head = (inst->event.head + 1) % OXR_MAX_EVENT_COUNT;
+	xrt_atomic_s32_dec_return(&inst->event.count);
 
-	return XR_SUCCESS;
+	return true;
 }
 
 static bool
 is_session_link_to_event(struct oxr_event *event, XrSession session)
 {
-	XrStructureType *type = oxr_event_extra(event);
-
-	switch (*type) {
-	case XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED: {
-		XrEventDataSessionStateChanged *changed = (XrEventDataSessionStateChanged *)type;
-		return changed->session == session;
-	}
-	case XR_TYPE_EVENT_DATA_INTERACTION_PROFILE_CHANGED: {
-		XrEventDataInteractionProfileChanged *changed = (XrEventDataInteractionProfileChanged *)type;
-		return changed->session == session;
-	}
+	switch (event->data.type) {
+	case XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED: return event->data.session_state_changed.session == session;
+	case XR_TYPE_EVENT_DATA_INTERACTION_PROFILE_CHANGED:
+		return event->data.interaction_profile_changed.session == session;
 	default: return false;
 	}
 }
@@ -147,20 +115,20 @@ oxr_event_push_XrEventDataSessionStateChanged(struct oxr_logger *log,
                                               XrTime time)
 {
 	struct oxr_instance *inst = sess->sys->inst;
-	XrEventDataSessionStateChanged *changed;
-	struct oxr_event *event = NULL;
 
-	ALLOC(log, inst, &event, &changed);
+	lock(inst);
 
-	changed->type = XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED;
-	changed->session = oxr_session_to_openxr(sess);
-	changed->state = state;
-	changed->time = time;
+	struct oxr_event *event = reserve(inst, sizeof(XrEventDataSessionStateChanged));
+	if (event != NULL) {
+		XrEventDataSessionStateChanged *changed = &event->data.session_state_changed;
+		changed->type = XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED;
+		changed->session = oxr_session_to_openxr(sess);
+		changed->state = state;
+		changed->time = time;
 
-	event->result = XR_SUCCESS;
+		push(inst);
+	}
 
-	lock(inst);
-	push(inst, event);
 	unlock(inst);
 
 	return XR_SUCCESS;
@@ -171,16 +139,18 @@ XrResult
 oxr_event_push_XrEventDataInteractionProfileChanged(struct oxr_logger *log, struct oxr_session *sess)
 {
 	struct oxr_instance *inst = sess->sys->inst;
-	XrEventDataSessionStateChanged *changed;
-	struct oxr_event *event = NULL;
 
-	ALLOC(log, inst, &event, &changed);
+	lock(inst);
+
+	struct oxr_event *event = reserve(inst, sizeof(XrEventDataInteractionProfileChanged));
+	if (event != NULL) {
+		XrEventDataInteractionProfileChanged *changed = &event->data.interaction_profile_changed;
+		changed->type = XR_TYPE_EVENT_DATA_INTERACTION_PROFILE_CHANGED;
+		changed->session = oxr_session_to_openxr(sess);
 
-	changed->type = XR_TYPE_EVENT_DATA_INTERACTION_PROFILE_CHANGED;
-	changed->session = oxr_session_to_openxr(sess);
+		push(inst);
+	}
 
-	lock(inst);
-	push(inst, event);
 	unlock(inst);
 
 	return XR_SUCCESS;
@@ -192,21 +162,55 @@ oxr_event_push_XrEventDataMainSessionVisibilityChangedEXTX(struct oxr_logger *lo
                                                            bool visible)
 {
 	struct oxr_instance *inst = sess->sys->inst;
-	XrEventDataMainSessionVisibilityChangedEXTX *changed;
-	struct oxr_event *event = NULL;
 
-	ALLOC(log, inst, &event, &changed);
-	changed->type = XR_TYPE_EVENT_DATA_MAIN_SESSION_VISIBILITY_CHANGED_EXTX;
-	changed->flags = 0;
-	changed->visible = visible;
-	event->result = XR_SUCCESS;
 	lock(inst);
-	push(inst, event);
+
+	struct oxr_event *event = reserve(inst, sizeof(XrEventDataMainSessionVisibilityChangedEXTX));
+	if (event != NULL) {
+		XrEventDataMainSessionVisibilityChangedEXTX *changed = &event->data.main_session_visibility_changed;
+		changed->type = XR_TYPE_EVENT_DATA_MAIN_SESSION_VISIBILITY_CHANGED_EXTX;
+		changed->flags = 0;
+		changed->visible = visible;
+
+		push(inst);
+	}
+
 	unlock(inst);
 
 	return XR_SUCCESS;
 }
 
+#ifdef OXR_HAVE_EXT_performance_settings
+XrResult
+oxr_event_push_XrEventDataPerfSettingsEXT(struct oxr_logger *log,
+                                          struct oxr_session *sess,
+                                          XrPerfSettingsDomainEXT domain,
+                                          XrPerfSettingsSubDomainEXT sub_domain,
+                                          XrPerfSettingsNotificationLevelEXT from_level,
+                                          XrPerfSettingsNotificationLevelEXT to_level)
+{
+	struct oxr_instance *inst = sess->sys->inst;
+
+	lock(inst);
+
+	struct oxr_event *event = reserve(inst, sizeof(XrEventDataPerfSettingsEXT));
+	if (event != NULL) {
+		XrEventDataPerfSettingsEXT *changed = &event->data.perf_settings;
+		changed->type = XR_TYPE_EVENT_DATA_PERF_SETTINGS_EXT;
+		changed->domain = domain;
+		changed->subDomain = sub_domain;
+		changed->fromLevel = from_level;
+		changed->toLevel = to_level;
+
+		push(inst);
+	}
+
+	unlock(inst);
+
+	return XR_SUCCESS;
+}
+#endif
+
 XrResult
 oxr_event_remove_session_events(struct oxr_logger *log, struct oxr_session *sess)
 {
@@ -215,23 +219,23 @@ oxr_event_remove_session_events(struct oxr_logger *log, struct oxr_session *sess
 
 	lock(inst);
 
-	struct oxr_event *e = inst->event.next;
-	while (e != NULL) {
-		struct oxr_event *cur = e;
-		e = e->next;
-
-		if (!is_session_link_to_event(cur, session)) {
+	// Compact the ring in place, keeping the order of the remaining events.
+	uint32_t count = (uint32_t)inst->event.count;
+	uint32_t kept = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		struct oxr_event *event = get_event(inst, i);
+		if (is_session_link_to_event(event, session)) {
 			continue;
 		}
 
-		if (cur == inst->event.next) {
-			inst->event.next = cur->next;
+		if (kept != i) {
+			*get_event(inst, kept) = *event;
 		}
+		kept++;
+	}
 
-		if (cur == inst->event.last) {
-			inst->event.last = NULL;
-		}
-		free(cur);
+	for (uint32_t i = kept; i < count; i++) {
+		xrt_atomic_s32_dec_return(&inst->event.count);
 	}
 
 	unlock(inst);
@@ -248,17 +252,39 @@ oxr_poll_event(struct oxr_logger *log, struct oxr_instance *inst, XrEventDataBuf
 		sess = sess->next;
 	}
 
+	// Fast path, nothing queued so no need to take the lock.
+	if (inst->event.count == 0 && inst->event.lost_count == 0) {
+		return XR_EVENT_UNAVAILABLE;
+	}
+
+	struct oxr_event event;
+	bool have_event = false;
+	int32_t lost_count = 0;
+
 	lock(inst);
-	struct oxr_event *event = pop(inst);
+	lost_count = inst->event.lost_count;
+	if (lost_count > 0) {
+		inst->event.lost_count = 0;
+	} else {
+		have_event = pop(inst, &event);
+	}
 	unlock(inst);
 
-	if (event == NULL) {
+	// Report dropped events first, the app sees them before anything newer.
+	if (lost_count > 0) {
+		XrEventDataEventsLost *lost = (XrEventDataEventsLost *)eventData;
+		lost->type = XR_TYPE_EVENT_DATA_EVENTS_LOST;
+		lost->next = NULL;
+		lost->lostEventCount = (uint32_t)lost_count;
+
+		return XR_SUCCESS;
+	}
+
+	if (!have_event) {
 		return XR_EVENT_UNAVAILABLE;
 	}
 
-	XrResult ret = event->result;
-	memcpy(eventData, oxr_event_extra(event), event->length);
-	free(event);
+	memcpy(eventData, &event.data, event.length);
 
-	return ret;
+	return event.result;
 }
@@ -302,6 +302,17 @@
 #endif
 
 
+/*
+ * XR_EXT_performance_settings
+ */
+#if defined(XR_EXT_performance_settings)
+#define OXR_HAVE_EXT_performance_settings
+#define OXR_EXTENSION_SUPPORT_EXT_performance_settings(_) _(EXT_performance_settings, EXT_PERFORMANCE_SETTINGS)
+#else
+#define OXR_EXTENSION_SUPPORT_EXT_performance_settings(_)
+#endif
+
+
 /*
  * XR_EXT_samsung_odyssey_controller
  */
@@ -325,6 +336,17 @@
 #endif
 
 
+/*
+ * XR_META_performance_metrics
+ */
+#if defined(XR_META_performance_metrics)
+#define OXR_HAVE_META_performance_metrics
+#define OXR_EXTENSION_SUPPORT_META_performance_metrics(_) _(META_performance_metrics, META_PERFORMANCE_METRICS)
+#else
+#define OXR_EXTENSION_SUPPORT_META_performance_metrics(_)
+#endif
+
+
 /*
  * XR_ML_ml2_controller_interaction
  */
@@ -509,8 +531,10 @@
     OXR_EXTENSION_SUPPORT_EXT_hand_tracking(_) \
     OXR_EXTENSION_SUPPORT_EXT_hp_mixed_reality_controller(_) \
     OXR_EXTENSION_SUPPORT_EXT_palm_pose(_) \
+    OXR_EXTENSION_SUPPORT_EXT_performance_settings(_) \
     OXR_EXTENSION_SUPPORT_EXT_samsung_odyssey_controller(_) \
     OXR_EXTENSION_SUPPORT_FB_display_refresh_rate(_) \
+    OXR_EXTENSION_SUPPORT_META_performance_metrics(_) \
     OXR_EXTENSION_SUPPORT_ML_ml2_controller_interaction(_) \
     OXR_EXTENSION_SUPPORT_MND_headless(_) \
     OXR_EXTENSION_SUPPORT_MND_swapchain_usage_input_attachment_bit(_) \
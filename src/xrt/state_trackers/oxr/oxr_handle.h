@@ -90,6 +90,47 @@ oxr_handle_allocate_and_init(struct oxr_logger *log,
 		}                                                                                                      \
 	} while (0)
 
+/*!
+ * Take a slot from @p table, reusing a freed one if there is any, and
+ * initialize it as a handle. The destroy function of the handle must give it
+ * back with @ref oxr_handle_table_free instead of freeing it.
+ *
+ * Mainly for internal use - use OXR_ALLOCATE_HANDLE_FROM_TABLE_OR_RETURN
+ * instead which wraps this.
+ *
+ * @public @memberof oxr_handle_table
+ */
+XrResult
+oxr_handle_table_allocate_and_init(struct oxr_logger *log,
+                                   struct oxr_handle_table *table,
+                                   uint64_t debug,
+                                   oxr_handle_destroyer destroy,
+                                   struct oxr_handle_base *parent,
+                                   void **out);
+
+/*!
+ * Give a handle back to @p table, any OpenXR handle value referring to it
+ * stops being valid.
+ *
+ * @public @memberof oxr_handle_table
+ */
+void
+oxr_handle_table_free(struct oxr_handle_table *table, struct oxr_handle_base *hb);
+
+/*!
+ * Like OXR_ALLOCATE_HANDLE_OR_RETURN but takes the handle from @p TABLE.
+ *
+ * @relates oxr_handle_table
+ */
+#define OXR_ALLOCATE_HANDLE_FROM_TABLE_OR_RETURN(LOG, OUT, TABLE, DEBUG, DESTROY, PARENT)                              \
+	do {                                                                                                           \
+		XrResult allocResult =                                                                                 \
+		    oxr_handle_table_allocate_and_init(LOG, TABLE, DEBUG, DESTROY, PARENT, (void **)&OUT);             \
+		if (allocResult != XR_SUCCESS) {                                                                       \
+			return allocResult;                                                                            \
+		}                                                                                                      \
+	} while (0)
+
 #ifdef __cplusplus
 }
 #endif
@@ -8,6 +8,8 @@
 
 #include "oxr_handle.h"
 
+#include "os/os_threading.h"
+
 #include "util/u_debug.h"
 #include "util/u_misc.h"
 
@@ -38,6 +40,80 @@
 	}
 
 
+//! Protects the free lists and growing of all handle tables.
+static struct os_mutex g_table_mutex;
+static pthread_once_t g_table_once = PTHREAD_ONCE_INIT;
+
+
+/*
+ *
+ * Helper functions.
+ *
+ */
+
+static void
+init_table_mutex(void)
+{
+	os_mutex_init(&g_table_mutex);
+}
+
+static struct oxr_handle_base *
+table_slot(struct oxr_handle_table *table, uint32_t index)
+{
+	uint8_t *chunk = table->chunks[index / OXR_HANDLE_TABLE_CHUNK_SIZE];
+	return (struct oxr_handle_base *)(chunk + (index % OXR_HANDLE_TABLE_CHUNK_SIZE) * table->size);
+}
+
+/*!
+ * Takes a slot off the free list, or a new one growing the table if needed,
+ * must be called with @ref g_table_mutex held. Returns NULL if full.
+ */
+static struct oxr_handle_base *
+table_take_slot_locked(struct oxr_handle_table *table)
+{
+	if (table->free_head != 0) {
+		struct oxr_handle_base *hb = table_slot(table, table->free_head - 1);
+		table->free_head = hb->table_next_free;
+		return hb;
+	}
+
+	uint32_t index = table->slot_count;
+	uint32_t chunk = index / OXR_HANDLE_TABLE_CHUNK_SIZE;
+	if (chunk >= OXR_HANDLE_TABLE_MAX_CHUNKS) {
+		return NULL;
+	}
+
+	if (table->chunks[chunk] == NULL) {
+		table->chunks[chunk] = U_TYPED_ARRAY_CALLOC(uint8_t, table->size * OXR_HANDLE_TABLE_CHUNK_SIZE);
+	}
+	table->slot_count++;
+
+	struct oxr_handle_base *hb = table_slot(table, index);
+	hb->table_index = index;
+	hb->table_generation = 1;
+
+	return hb;
+}
+
+static void
+table_put_slot_locked(struct oxr_handle_table *table, struct oxr_handle_base *hb)
+{
+	// Any value given out for this slot is now stale, zero is never used.
+	if (++hb->table_generation == 0) {
+		hb->table_generation = 1;
+	}
+
+	hb->table_next_free = table->free_head;
+	table->free_head = hb->table_index + 1;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
 const char *
 oxr_handle_state_to_string(enum oxr_handle_state state)
 {
@@ -82,6 +158,7 @@ oxr_handle_init(struct oxr_logger *log,
 				                     "child slot %d in parent",
 				                     (void *)hb, i);
 				parent->children[i] = hb;
+				parent->child_count++;
 				placed = true;
 				break;
 			}
@@ -122,6 +199,78 @@ oxr_handle_allocate_and_init(struct oxr_logger *log,
 	return result;
 }
 
+XrResult
+oxr_handle_table_allocate_and_init(struct oxr_logger *log,
+                                   struct oxr_handle_table *table,
+                                   uint64_t debug,
+                                   oxr_handle_destroyer destroy,
+                                   struct oxr_handle_base *parent,
+                                   void **out)
+{
+	pthread_once(&g_table_once, init_table_mutex);
+
+	os_mutex_lock(&g_table_mutex);
+	struct oxr_handle_base *hb = table_take_slot_locked(table);
+	os_mutex_unlock(&g_table_mutex);
+
+	if (hb == NULL) {
+		return oxr_error(log, XR_ERROR_LIMIT_REACHED, "No more room in the handle table");
+	}
+
+	// Clears the whole handle, keep the slot fields.
+	uint32_t index = hb->table_index;
+	uint32_t generation = hb->table_generation;
+	memset(hb, 0, table->size);
+
+	XrResult result = oxr_handle_init(log, hb, debug, destroy, parent);
+
+	hb->table_index = index;
+	hb->table_generation = generation;
+
+	if (result != XR_SUCCESS) {
+		oxr_handle_table_free(table, hb);
+		return result;
+	}
+
+	*out = (void *)hb;
+	return result;
+}
+
+void
+oxr_handle_table_free(struct oxr_handle_table *table, struct oxr_handle_base *hb)
+{
+	hb->state = OXR_HANDLE_STATE_DESTROYED;
+
+	os_mutex_lock(&g_table_mutex);
+	table_put_slot_locked(table, hb);
+	os_mutex_unlock(&g_table_mutex);
+}
+
+struct oxr_handle_base *
+oxr_handle_table_lookup(struct oxr_handle_table *table, uint64_t value)
+{
+	uint32_t index = (uint32_t)value - 1;
+	uint32_t generation = (uint32_t)(value >> 32);
+
+	if ((uint32_t)value == 0 || index / OXR_HANDLE_TABLE_CHUNK_SIZE >= OXR_HANDLE_TABLE_MAX_CHUNKS ||
+	    table->chunks[index / OXR_HANDLE_TABLE_CHUNK_SIZE] == NULL) {
+		return NULL;
+	}
+
+	struct oxr_handle_base *hb = table_slot(table, index);
+	if (hb->table_generation != generation || hb->state != OXR_HANDLE_STATE_LIVE) {
+		return NULL;
+	}
+
+	return hb;
+}
+
+uint64_t
+oxr_handle_table_value(const struct oxr_handle_base *hb)
+{
+	return ((uint64_t)hb->table_generation << 32) | ((uint64_t)hb->table_index + 1);
+}
+
 /*!
  * This is the actual recursive call that destroys handles.
  *
@@ -151,6 +300,7 @@ oxr_handle_do_destroy(struct oxr_logger *log, struct oxr_handle_base *hb, int le
 				                     level, (void *)hb, i, (void *)hb->parent);
 
 				parent->children[i] = NULL;
+				parent->child_count--;
 				found = true;
 				break;
 			}
@@ -163,8 +313,8 @@ oxr_handle_do_destroy(struct oxr_logger *log, struct oxr_handle_base *hb, int le
 		hb->parent = NULL;
 	}
 
-	/* Destroy child handles */
-	for (size_t i = 0; i < XRT_MAX_HANDLE_CHILDREN; ++i) {
+	/* Destroy child handles, most handles have none so skip the walk */
+	for (size_t i = 0; i < XRT_MAX_HANDLE_CHILDREN && hb->child_count > 0; ++i) {
 		struct oxr_handle_base *child = hb->children[i];
 
 		if (child != NULL) {
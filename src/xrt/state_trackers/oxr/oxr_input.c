@@ -835,38 +835,104 @@ oxr_input_is_bound_in_act_set(struct oxr_action_input *action_input, struct oxr_
 	return false;
 }
 
-static bool
-oxr_input_supressed(struct oxr_session *sess,
-                    uint32_t countActionSets,
-                    const XrActiveActionSet *actionSets,
-                    struct oxr_subaction_paths *subaction_path,
-                    struct oxr_action_attachment *act_attached,
-                    struct oxr_action_input *action_input)
+/*!
+ * For each input in @p cache find the action set attachments with a higher
+ * priority than @p set_index that bind the same source, writing their indices
+ * into @p table at @p total if not NULL. Returns the new total.
+ */
+static uint32_t
+oxr_action_cache_fill_suppressing_sets(struct oxr_session *sess,
+                                       size_t set_index,
+                                       struct oxr_action_cache *cache,
+                                       uint32_t *table,
+                                       uint32_t total)
 {
-	struct oxr_action_set_ref *act_set_ref = act_attached->act_set_attached->act_set_ref;
-	uint32_t priority = act_set_ref->priority;
+	uint32_t priority = sess->act_set_attachments[set_index].act_set_ref->priority;
 
-	// find sources that are bound to an action in a set with higher prio
-	for (uint32_t i = 0; i < countActionSets; i++) {
-		XrActionSet set = actionSets[i].actionSet;
+	for (size_t i = 0; i < cache->input_count; i++) {
+		struct oxr_action_input *action_input = &cache->inputs[i];
+		action_input->suppressing_first = total;
+		action_input->suppressing_count = 0;
 
-		struct oxr_action_set *other_act_set = NULL;
-		struct oxr_action_set_attachment *other_act_set_attached = NULL;
-		oxr_session_get_action_set_attachment(sess, set, &other_act_set_attached, &other_act_set);
+		for (size_t k = 0; k < sess->action_set_attachment_count; k++) {
+			struct oxr_action_set_attachment *other_act_set_attached = &sess->act_set_attachments[k];
 
-		if (other_act_set_attached == NULL) {
-			continue;
-		}
+			/* skip the action set the input is in and ones with lower prio */
+			if (k == set_index || other_act_set_attached->act_set_ref->priority <= priority) {
+				continue;
+			}
 
-		/* skip the action set that the current action is in */
-		if (other_act_set_attached->act_set_ref == act_set_ref) {
-			continue;
+			if (!oxr_input_is_bound_in_act_set(action_input, other_act_set_attached)) {
+				continue;
+			}
+
+			if (table != NULL) {
+				table[total] = (uint32_t)k;
+			}
+			action_input->suppressing_count++;
+			total++;
 		}
+	}
 
-		/* input may be suppressed by action set with higher prio */
-		if (other_act_set_attached->act_set_ref->priority <= priority) {
-			continue;
+	return total;
+}
+
+/*!
+ * Walks all inputs of all attached actions, see
+ * @ref oxr_action_cache_fill_suppressing_sets. Returns the total number of
+ * entries.
+ */
+static uint32_t
+oxr_session_fill_suppressing_sets(struct oxr_session *sess, uint32_t *table)
+{
+	uint32_t total = 0;
+
+	for (size_t i = 0; i < sess->action_set_attachment_count; i++) {
+		struct oxr_action_set_attachment *act_set_attached = &sess->act_set_attachments[i];
+
+		for (size_t k = 0; k < act_set_attached->action_attachment_count; k++) {
+			struct oxr_action_attachment *act_attached = &act_set_attached->act_attachments[k];
+
+#define FILL_CACHE(X) total = oxr_action_cache_fill_suppressing_sets(sess, i, &act_attached->X, table, total);
+			OXR_FOR_EACH_SUBACTION_PATH(FILL_CACHE)
+#undef FILL_CACHE
 		}
+	}
+
+	return total;
+}
+
+/*!
+ * Compile the table used by @ref oxr_input_supressed, the bindings and
+ * priorities never change once the action sets are attached, so this turns
+ * the per sync search through all actions into a lookup.
+ *
+ * @private @memberof oxr_session
+ */
+static void
+oxr_session_compile_suppressing_sets(struct oxr_session *sess)
+{
+	free(sess->suppressing_sets);
+	sess->suppressing_sets = NULL;
+
+	sess->suppressing_set_count = oxr_session_fill_suppressing_sets(sess, NULL);
+	if (sess->suppressing_set_count == 0) {
+		return;
+	}
+
+	sess->suppressing_sets = U_TYPED_ARRAY_CALLOC(uint32_t, sess->suppressing_set_count);
+	oxr_session_fill_suppressing_sets(sess, sess->suppressing_sets);
+}
+
+static bool
+oxr_input_supressed(struct oxr_session *sess,
+                    struct oxr_subaction_paths *subaction_path,
+                    struct oxr_action_input *action_input)
+{
+	// Only sets with higher priority that bind this source are in the table.
+	for (uint32_t i = 0; i < action_input->suppressing_count; i++) {
+		uint32_t index = sess->suppressing_sets[action_input->suppressing_first + i];
+		struct oxr_action_set_attachment *other_act_set_attached = &sess->act_set_attachments[index];
 
 		/* Currently updated input source with subactionpath X can be
 		 * suppressed, if input source also occurs in action set with
@@ -882,11 +948,11 @@ oxr_input_supressed(struct oxr_session *sess,
 		OXR_FOR_EACH_SUBACTION_PATH(ACCUMULATE_PATHS)
 #undef ACCUMULATE_PATHS
 
-		if (!relevant_subactionpath) {
-			continue;
-		}
-
-		if (oxr_input_is_bound_in_act_set(action_input, other_act_set_attached)) {
+		/*
+		 * Sets not synced this time have no requested sub-action paths,
+		 * they were reset at the start of the sync.
+		 */
+		if (relevant_subactionpath) {
 			return true;
 		}
 	}
@@ -896,9 +962,6 @@ oxr_input_supressed(struct oxr_session *sess,
 
 static bool
 oxr_input_combine_input(struct oxr_session *sess,
-                        uint32_t countActionSets,
-                        const XrActiveActionSet *actionSets,
-                        struct oxr_action_attachment *act_attached,
                         struct oxr_subaction_paths *subaction_path,
                         struct oxr_action_cache *cache,
                         struct oxr_input_value_tagged *out_input,
@@ -923,8 +986,7 @@ oxr_input_combine_input(struct oxr_session *sess,
 
 		// suppress input if it is also bound to action in set with
 		// higher priority
-		if (oxr_input_supressed(sess, countActionSets, actionSets, subaction_path, act_attached,
-		                        action_input)) {
+		if (oxr_input_supressed(sess, subaction_path, action_input)) {
 			continue;
 		}
 
@@ -1001,6 +1063,60 @@ oxr_input_combine_input(struct oxr_session *sess,
 	return true;
 }
 
+/*!
+ * Have none of the inputs of this cache changed since the last sync, then the
+ * combined value is the same and the transforms don't need to run again.
+ *
+ * Inputs that can be suppressed depend on what other action sets are synced,
+ * and dpad inputs read a second input, those are always evaluated.
+ *
+ * @private @memberof oxr_action_cache
+ */
+static bool
+oxr_action_cache_inputs_unchanged(struct oxr_action_cache *cache)
+{
+	if (!cache->inputs_synced) {
+		return false;
+	}
+
+	for (size_t i = 0; i < cache->input_count; i++) {
+		struct oxr_action_input *action_input = &cache->inputs[i];
+		struct xrt_input *input = action_input->input;
+
+		if (action_input->suppressing_count > 0 || action_input->dpad_activate != NULL) {
+			return false;
+		}
+
+		if (input->timestamp != action_input->synced_timestamp || input->active != action_input->synced_active ||
+		    memcmp(&input->value, &action_input->synced_value, sizeof(input->value)) != 0) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*!
+ * Remember the state of the inputs that @ref oxr_action_cache::current was
+ * evaluated from.
+ *
+ * @private @memberof oxr_action_cache
+ */
+static void
+oxr_action_cache_mark_inputs_synced(struct oxr_action_cache *cache)
+{
+	for (size_t i = 0; i < cache->input_count; i++) {
+		struct oxr_action_input *action_input = &cache->inputs[i];
+		struct xrt_input *input = action_input->input;
+
+		action_input->synced_timestamp = input->timestamp;
+		action_input->synced_value = input->value;
+		action_input->synced_active = input->active;
+	}
+
+	cache->inputs_synced = true;
+}
+
 /*!
  * Called during xrSyncActions.
  *
@@ -1024,6 +1140,7 @@ oxr_action_cache_update(struct oxr_logger *log,
 			oxr_action_cache_stop_output(log, sess, cache);
 		}
 		U_ZERO(&cache->current);
+		cache->inputs_synced = false;
 		return;
 	}
 
@@ -1039,12 +1156,24 @@ oxr_action_cache_update(struct oxr_logger *log,
 		}
 	} else if (cache->input_count > 0) {
 
-		if (!oxr_input_combine_input(sess, countActionSets, actionSets, act_attached, subaction_path, cache,
-		                             &combined, &timestamp, &is_active)) {
+		/*
+		 * Same inputs as the last sync gives the same value and
+		 * timestamp, only that it is no longer changed since last sync.
+		 */
+		if (oxr_action_cache_inputs_unchanged(cache)) {
+			cache->current.changed = false;
+			return;
+		}
+
+		cache->inputs_synced = false;
+
+		if (!oxr_input_combine_input(sess, subaction_path, cache, &combined, &timestamp, &is_active)) {
 			oxr_log(log, "Failed to get/combine input values '%s'", act_attached->act_ref->name);
 			return;
 		}
 
+		oxr_action_cache_mark_inputs_synced(cache);
+
 		// If the input is not active signal that.
 		if (!is_active) {
 			// Reset all state.
@@ -1540,6 +1669,8 @@ oxr_session_attach_action_sets(struct oxr_logger *log,
 		}
 	}
 
+	oxr_session_compile_suppressing_sets(sess);
+
 #define POPULATE_PROFILE(X)                                                                                            \
 	if (profiles.X != NULL) {                                                                                      \
 		sess->X = profiles.X->path;                                                                            \
@@ -1573,9 +1704,17 @@ oxr_action_sync_data(struct oxr_logger *log,
 	// Synchronize outputs to this time.
 	int64_t now = time_state_get_now(sess->sys->inst->timekeeping);
 
-	// Loop over all xdev devices.
-	for (size_t i = 0; i < sess->sys->xsysd->xdev_count; i++) {
-		oxr_xdev_update(sess->sys->xsysd->xdevs[i]);
+	// Update all devices at once if possible, otherwise loop over all xdev devices.
+	struct xrt_system_devices *xsysd = sess->sys->xsysd;
+	if (xsysd->update_inputs != NULL) {
+		xrt_result_t xret = xrt_system_devices_update_inputs(xsysd);
+		if (xret != XRT_SUCCESS) {
+			oxr_warn(log, "Failed to update inputs: %d", xret);
+		}
+	} else {
+		for (size_t i = 0; i < xsysd->xdev_count; i++) {
+			oxr_xdev_update(xsysd->xdevs[i]);
+		}
 	}
 
 	// Reset all action set attachments.
@@ -109,6 +109,7 @@ struct oxr_action_set;
 struct oxr_action;
 struct oxr_debug_messenger;
 struct oxr_handle_base;
+struct oxr_handle_table;
 struct oxr_subaction_paths;
 struct oxr_action_attachment;
 struct oxr_action_set_attachment;
@@ -122,7 +123,11 @@ struct oxr_action_ref;
 struct oxr_hand_tracker;
 
 #define XRT_MAX_HANDLE_CHILDREN 256
+#define OXR_HANDLE_TABLE_CHUNK_SIZE 64
+#define OXR_HANDLE_TABLE_MAX_CHUNKS 256
 #define OXR_MAX_BINDINGS_PER_ACTION 16
+#define OXR_MAX_EVENT_COUNT 64
+#define OXR_VIEW_CACHE_SPACE_COUNT 8
 
 struct time_state;
 
@@ -190,6 +195,23 @@ oxr_handle_destroy(struct oxr_logger *log, struct oxr_handle_base *hb);
 const char *
 oxr_handle_state_to_string(enum oxr_handle_state state);
 
+/*!
+ * Looks up the handle with the OpenXR handle @p value in @p table, returns
+ * NULL if the value doesn't refer to a handle currently in the table.
+ *
+ * @public @memberof oxr_handle_table
+ */
+struct oxr_handle_base *
+oxr_handle_table_lookup(struct oxr_handle_table *table, uint64_t value);
+
+/*!
+ * The OpenXR handle value of a handle from a @ref oxr_handle_table, never zero.
+ *
+ * @public @memberof oxr_handle_table
+ */
+uint64_t
+oxr_handle_table_value(const struct oxr_handle_base *hb);
+
 /*!
  *
  * @name oxr_instance.c
@@ -708,6 +730,28 @@ oxr_session_request_exit(struct oxr_logger *log, struct oxr_session *sess);
 void
 oxr_session_poll(struct oxr_logger *log, struct oxr_session *sess);
 
+/*!
+ * Locate the head device in the given space, answered from a per frame cache
+ * if the same time and space has already been located, see
+ * @ref oxr_session::view_cache.
+ *
+ * @public @memberof oxr_session
+ */
+XrResult
+oxr_session_locate_head_cached(struct oxr_logger *log,
+                               struct oxr_session *sess,
+                               struct oxr_space *spc,
+                               XrTime time,
+                               struct xrt_space_relation *out_relation);
+
+/*!
+ * Drop any cached locations for the given space, or all if NULL.
+ *
+ * @public @memberof oxr_session
+ */
+void
+oxr_session_view_cache_invalidate(struct oxr_session *sess, struct oxr_space *spc);
+
 XrResult
 oxr_session_locate_views(struct oxr_logger *log,
                          struct oxr_session *sess,
@@ -743,13 +787,28 @@ oxr_session_apply_force_feedback(struct oxr_logger *log,
  *
  */
 
+/*!
+ * All spaces live in this table, their OpenXR handles are indices into it.
+ */
+extern struct oxr_handle_table oxr_space_table;
+
 /*!
  * To go back to a OpenXR object.
  */
 static inline XrSpace
 oxr_space_to_openxr(struct oxr_space *spc)
 {
-	return XRT_CAST_PTR_TO_OXR_HANDLE(XrSpace, spc);
+	return (XrSpace)oxr_handle_table_value((struct oxr_handle_base *)spc);
+}
+
+/*!
+ * Looks up the space an OpenXR handle refers to, returns NULL if it doesn't
+ * refer to a space, including one that has been destroyed.
+ */
+static inline struct oxr_space *
+oxr_space_from_openxr(XrSpace space)
+{
+	return (struct oxr_space *)oxr_handle_table_lookup(&oxr_space_table, (uint64_t)space);
 }
 
 XrResult
@@ -918,6 +977,16 @@ oxr_event_push_XrEventDataMainSessionVisibilityChangedEXTX(struct oxr_logger *lo
 XrResult
 oxr_event_push_XrEventDataInteractionProfileChanged(struct oxr_logger *log, struct oxr_session *sess);
 
+#ifdef OXR_HAVE_EXT_performance_settings
+XrResult
+oxr_event_push_XrEventDataPerfSettingsEXT(struct oxr_logger *log,
+                                          struct oxr_session *sess,
+                                          XrPerfSettingsDomainEXT domain,
+                                          XrPerfSettingsSubDomainEXT sub_domain,
+                                          XrPerfSettingsNotificationLevelEXT from_level,
+                                          XrPerfSettingsNotificationLevelEXT to_level);
+#endif
+
 /*!
  * This clears all pending events refers to the given session.
  */
@@ -1215,8 +1284,54 @@ struct oxr_handle_base
 	 * Destroy the object this handle refers to.
 	 */
 	oxr_handle_destroyer destroy;
+
+	//! Number of non-NULL entries in @ref children.
+	uint32_t child_count;
+
+	/*!
+	 * For handles from a @ref oxr_handle_table, the slot this handle is in
+	 * and how many times the slot has been reused. Both make up the OpenXR
+	 * handle value, so a stale handle to a reused slot is caught.
+	 */
+	uint32_t table_index;
+	uint32_t table_generation;
+
+	//! Next free slot, plus one, while on the free list of the table.
+	uint32_t table_next_free;
+};
+
+/*!
+ * Typed slab of handles of one size, handed out with generation checked
+ * indices as their OpenXR handle values instead of pointers.
+ *
+ * Validating a handle is an index and a compare, and freed handles are kept
+ * for reuse, so creating and destroying handles doesn't touch the heap once
+ * warmed up. Chunks are never moved or freed, lookups don't need a lock.
+ *
+ * @see OXR_HANDLE_TABLE_INIT
+ */
+struct oxr_handle_table
+{
+	//! Size of the handle objects.
+	size_t size;
+
+	//! Slots, @ref OXR_HANDLE_TABLE_CHUNK_SIZE per chunk.
+	uint8_t *chunks[OXR_HANDLE_TABLE_MAX_CHUNKS];
+
+	//! Number of slots handed out at least once.
+	uint32_t slot_count;
+
+	//! First free slot, plus one, zero if empty.
+	uint32_t free_head;
 };
 
+/*!
+ * Static initializer for a @ref oxr_handle_table of @p TYPE handles.
+ *
+ * @relates oxr_handle_table
+ */
+#define OXR_HANDLE_TABLE_INIT(TYPE) {.size = sizeof(TYPE)}
+
 /*!
  * Single or multiple devices grouped together to form a system that sessions
  * can be created from. Might need to open devices to get all
@@ -1289,6 +1404,26 @@ struct oxr_extension_status
 };
 #undef MAKE_EXT_STATUS
 
+/*!
+ * A queued event, stored in place in the ring in @ref oxr_instance so pushing
+ * never allocates.
+ */
+struct oxr_event
+{
+	XrResult result;
+
+	//! Size of the event struct in @ref data.
+	size_t length;
+
+	union {
+		XrStructureType type;
+		XrEventDataSessionStateChanged session_state_changed;
+		XrEventDataInteractionProfileChanged interaction_profile_changed;
+		XrEventDataMainSessionVisibilityChangedEXTX main_session_visibility_changed;
+		XrEventDataPerfSettingsEXT perf_settings;
+	} data;
+};
+
 /*!
  * Main object that ties everything together.
  *
@@ -1320,8 +1455,12 @@ struct oxr_instance
 		struct u_hashset *loc_store;
 	} action_sets;
 
-	//! Path store, for looking up paths.
-	struct u_hashset *path_store;
+	//! Path store, open addressing table for looking up paths by string.
+	struct oxr_path **path_table;
+	//! Number of slots in @ref path_table, always a power of two.
+	size_t path_table_size;
+	//! Blocks that the paths are allocated from.
+	struct oxr_path_arena_block *path_arena;
 	//! Mapping from ID to path.
 	struct oxr_path **path_array;
 	//! Total length of path array.
@@ -1332,15 +1471,29 @@ struct oxr_instance
 	// Event queue.
 	struct
 	{
+		//! Protects the ring, not taken when polling an empty queue.
 		struct os_mutex mutex;
-		struct oxr_event *last;
-		struct oxr_event *next;
+
+		//! Fixed size ring of queued events.
+		struct oxr_event ring[OXR_MAX_EVENT_COUNT];
+
+		//! Index in @ref ring of the oldest event.
+		uint32_t head;
+
+		//! Number of queued events, changed with the mutex held.
+		xrt_atomic_s32_t count;
+
+		//! Events dropped since the ring was full, reported as XrEventDataEventsLost.
+		xrt_atomic_s32_t lost_count;
 	} event;
 
 	//! Interaction profile bindings that have been suggested by the client.
 	struct oxr_interaction_profile **profiles;
 	size_t profile_count;
 
+	//! Interned paths of the generated profile templates, same order.
+	XrPath *profile_template_paths;
+
 	struct oxr_session *sessions;
 
 	struct
@@ -1452,6 +1605,37 @@ struct oxr_session
 		int64_t begun;
 	} frame_id;
 
+	/*!
+	 * Engines call xrLocateViews several times per frame for the same time,
+	 * and xrEndFrame locates the head again for each layer, each of which
+	 * can be a round trip to the service. Cleared on xrWaitFrame.
+	 */
+	struct
+	{
+		struct os_mutex mutex;
+
+		//! Result of xrt_device_get_view_poses for @ref time_ns and @ref eye_relation.
+		struct
+		{
+			bool valid;
+			uint64_t time_ns;
+			struct xrt_vec3 eye_relation;
+			struct xrt_space_relation T_xdev_head;
+			struct xrt_fov fovs[2];
+			struct xrt_pose poses[2];
+		} views;
+
+		//! Head device located in a space, replaced round robin.
+		struct
+		{
+			struct oxr_space *spc;
+			XrTime time;
+			struct xrt_space_relation T_space_xdev;
+		} heads[OXR_VIEW_CACHE_SPACE_COUNT];
+
+		uint32_t next_head;
+	} view_cache;
+
 	struct os_semaphore sem;
 
 	/*!
@@ -1493,6 +1677,22 @@ struct oxr_session
 	 */
 	struct u_hashmap_int *act_attachments_by_key;
 
+	/*!
+	 * Flat table of indices into @ref oxr_session::act_set_attachments,
+	 * for each @ref oxr_action_input the action set attachments that can
+	 * suppress it, see @ref oxr_action_input::suppressing_first.
+	 */
+	uint32_t *suppressing_sets;
+
+	//! Length of @ref oxr_session::suppressing_sets.
+	uint32_t suppressing_set_count;
+
+	//! Has the app enabled XR_META_performance_metrics counters.
+	bool performance_metrics_enabled;
+
+	//! Last GPU level sent with XR_EXT_performance_settings, from the recommended render scale.
+	XrPerfSettingsNotificationLevelEXT gpu_notification_level;
+
 
 	/*!
 	 * Currently bound interaction profile.
@@ -1625,6 +1825,28 @@ struct oxr_dpad_emulation
 	enum xrt_input_name activate; // Can be zero
 };
 
+/*!
+ * Entry in @ref oxr_interaction_profile::path_index, a binding path together
+ * with the binding that it belongs to.
+ */
+struct oxr_binding_path_entry
+{
+	XrPath path;
+	uint32_t binding_index;
+	//! Index into oxr_binding::paths.
+	uint32_t path_index;
+};
+
+/*!
+ * Entry in @ref oxr_interaction_profile::key_index, an action key together
+ * with a binding that it has been suggested for.
+ */
+struct oxr_binding_key_entry
+{
+	uint32_t key;
+	uint32_t binding_index;
+};
+
 /*!
  * A single interaction profile.
  */
@@ -1645,6 +1867,14 @@ struct oxr_interaction_profile
 	size_t dpad_count;
 
 	struct oxr_dpad_state dpad_state;
+
+	//! All paths of all bindings sorted by path then binding, built on creation.
+	struct oxr_binding_path_entry *path_index;
+	size_t path_index_count;
+
+	//! All suggested keys sorted by key then binding, rebuilt on suggestion.
+	struct oxr_binding_key_entry *key_index;
+	size_t key_index_count;
 };
 
 /*!
@@ -1803,6 +2033,24 @@ struct oxr_action_input
 	struct oxr_input_transform *transforms;
 	size_t transform_count;
 	XrPath bound_path;
+
+	/*!
+	 * Range in @ref oxr_session::suppressing_sets of the action set
+	 * attachments with higher priority that also bind @ref bound_path,
+	 * compiled when the action sets are attached.
+	 */
+	uint32_t suppressing_first;
+	uint32_t suppressing_count;
+
+	/*!
+	 * State of @ref input at the last sync that evaluated it, used to skip
+	 * evaluating caches whose inputs have not changed.
+	 * @{
+	 */
+	int64_t synced_timestamp;
+	union xrt_input_value synced_value;
+	bool synced_active;
+	//! @}
 };
 
 /*!
@@ -1837,6 +2085,12 @@ struct oxr_action_cache
 {
 	struct oxr_action_state current;
 
+	/*!
+	 * Was @ref current evaluated from the inputs on the last sync, so the
+	 * oxr_action_input::synced_timestamp and friends are valid.
+	 */
+	bool inputs_synced;
+
 	size_t input_count;
 	struct oxr_action_input *inputs;
 
@@ -2247,6 +2501,26 @@ struct oxr_hand_tracker
 
 	XrHandEXT hand;
 	XrHandJointSetEXT hand_joint_set;
+
+	/*!
+	 * The last joint set queried from @ref xdev, apps often locate the
+	 * same hand several times a frame against different base spaces.
+	 */
+	struct
+	{
+		//! Protects the whole cache.
+		struct os_mutex mutex;
+
+		bool valid;
+
+		//! Session waited frame id the value was queried in.
+		int64_t frame_id;
+
+		//! Time the value was queried for.
+		XrTime time;
+
+		struct xrt_hand_joint_set value;
+	} cache;
 };
 
 /*!
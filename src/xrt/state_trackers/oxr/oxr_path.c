@@ -11,16 +11,22 @@
 #include <string.h>
 #include <stdlib.h>
 
-#include "math/m_api.h"
 #include "util/u_misc.h"
 
 #include "oxr_objects.h"
 #include "oxr_logger.h"
 
 
+//! Size of each block in the path arena, fits a few hundred paths.
+#define OXR_PATH_ARENA_BLOCK_SIZE (64 * 1024)
+
+//! Initial number of slots in the path table, must be a power of two.
+#define OXR_PATH_TABLE_INITIAL_SIZE (4096)
+
 /*!
- * Internal representation of a path, item follows this struct in memory and
- * that in turn is followed by the string.
+ * Internal representation of a path, the string follows this struct in
+ * memory. Allocated from the @ref oxr_path_arena_block list and never freed
+ * on its own.
  *
  * @ingroup oxr_main
  */
@@ -29,6 +35,29 @@ struct oxr_path
 	uint64_t debug;
 	XrPath id;
 	void *attached;
+
+	//! Hash of the string, also used to skip string compares in lookups.
+	uint64_t hash;
+
+	//! Length of the string, not counting the null terminator.
+	size_t length;
+
+	char str[];
+};
+
+/*!
+ * A block of memory that paths are bump allocated from, freed all at once
+ * when the instance is destroyed.
+ *
+ * @ingroup oxr_main
+ */
+struct oxr_path_arena_block
+{
+	struct oxr_path_arena_block *next;
+	size_t used;
+	size_t size;
+
+	uint8_t data[];
 };
 
 
@@ -44,16 +73,50 @@ to_xr_path(struct oxr_path *path)
 	return path->id;
 }
 
-static inline struct u_hashset_item *
-get_item(struct oxr_path *path)
+/*!
+ * 64-bit FNV-1a, the strings are short and this is a lot cheaper than going
+ * through std::hash and a std::string copy.
+ */
+static inline uint64_t
+hash_path_string(const char *str, size_t length)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	for (size_t i = 0; i < length; i++) {
+		hash ^= (uint8_t)str[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+static struct oxr_path *
+find_path(const struct oxr_instance *inst, const char *str, size_t length, uint64_t hash)
 {
-	return (struct u_hashset_item *)&path[1];
+	size_t mask = inst->path_table_size - 1;
+
+	// Linear probing, the table is never more then half full.
+	for (size_t i = hash & mask;; i = (i + 1) & mask) {
+		struct oxr_path *path = inst->path_table[i];
+		if (path == NULL) {
+			return NULL;
+		}
+
+		if (path->hash == hash && path->length == length && memcmp(path->str, str, length) == 0) {
+			return path;
+		}
+	}
 }
 
-static inline struct oxr_path *
-from_item(struct u_hashset_item *item)
+static void
+insert_path(struct oxr_path **table, size_t table_size, struct oxr_path *path)
 {
-	return &((struct oxr_path *)item)[-1];
+	size_t mask = table_size - 1;
+	size_t i = path->hash & mask;
+
+	while (table[i] != NULL) {
+		i = (i + 1) & mask;
+	}
+
+	table[i] = path;
 }
 
 
@@ -75,10 +138,13 @@ oxr_ensure_array_length(struct oxr_logger *log, struct oxr_instance *inst, XrPat
 
 	size_t new_size = inst->path_array_length;
 	while (new_size < num) {
-		new_size += 64;
+		new_size *= 2;
 	}
 
 	U_ARRAY_REALLOC_OR_FREE(inst->path_array, struct oxr_path *, new_size);
+	if (inst->path_array == NULL) {
+		return oxr_error(log, XR_ERROR_RUNTIME_FAILURE, "Failed to grow path array");
+	}
 	inst->path_array_length = new_size;
 
 	*out_id = inst->path_num++;
@@ -87,46 +153,97 @@ oxr_ensure_array_length(struct oxr_logger *log, struct oxr_instance *inst, XrPat
 }
 
 static XrResult
-oxr_allocate_path(
-    struct oxr_logger *log, struct oxr_instance *inst, const char *str, size_t length, struct oxr_path **out_path)
+oxr_ensure_table_size(struct oxr_logger *log, struct oxr_instance *inst)
+{
+	// Keep the load factor at most a half, path_num includes XR_NULL_PATH.
+	if (inst->path_num * 2 < inst->path_table_size) {
+		return XR_SUCCESS;
+	}
+
+	size_t new_size = inst->path_table_size * 2;
+	struct oxr_path **new_table = U_TYPED_ARRAY_CALLOC(struct oxr_path *, new_size);
+	if (new_table == NULL) {
+		return oxr_error(log, XR_ERROR_RUNTIME_FAILURE, "Failed to grow path table");
+	}
+
+	for (size_t i = 0; i < inst->path_table_size; i++) {
+		if (inst->path_table[i] != NULL) {
+			insert_path(new_table, new_size, inst->path_table[i]);
+		}
+	}
+
+	free(inst->path_table);
+	inst->path_table = new_table;
+	inst->path_table_size = new_size;
+
+	return XR_SUCCESS;
+}
+
+static void *
+oxr_path_arena_alloc(struct oxr_instance *inst, size_t size)
+{
+	// Keep the paths aligned.
+	size = (size + 7) & ~(size_t)7;
+
+	struct oxr_path_arena_block *block = inst->path_arena;
+	if (block == NULL || block->size - block->used < size) {
+		size_t block_size = size > OXR_PATH_ARENA_BLOCK_SIZE ? size : OXR_PATH_ARENA_BLOCK_SIZE;
+
+		block = U_CALLOC_WITH_CAST(struct oxr_path_arena_block, sizeof(*block) + block_size);
+		if (block == NULL) {
+			return NULL;
+		}
+
+		block->size = block_size;
+		block->next = inst->path_arena;
+		inst->path_arena = block;
+	}
+
+	void *ptr = &block->data[block->used];
+	block->used += size;
+
+	return ptr;
+}
+
+static XrResult
+oxr_allocate_path(struct oxr_logger *log,
+                  struct oxr_instance *inst,
+                  const char *str,
+                  size_t length,
+                  uint64_t hash,
+                  struct oxr_path **out_path)
 {
-	struct u_hashset_item *item = NULL;
 	struct oxr_path *path = NULL;
 	size_t size = 0;
-	int ret;
+	XrResult ret;
+
+	size += sizeof(struct oxr_path); // Main path object.
+	size += length;                  // String.
+	size += 1;                       // Null terminate it.
 
-	size += sizeof(struct oxr_path);       // Main path object.
-	size += sizeof(struct u_hashset_item); // Embedded hashset item.
-	size += length;                        // String.
-	size += 1;                             // Null terminate it.
+	ret = oxr_ensure_table_size(log, inst);
+	if (ret != XR_SUCCESS) {
+		return ret;
+	}
 
-	// Now allocate and setup the path.
-	path = U_CALLOC_WITH_CAST(struct oxr_path, size);
+	// Now allocate and setup the path, the arena memory is zeroed.
+	path = (struct oxr_path *)oxr_path_arena_alloc(inst, size);
 	if (path == NULL) {
 		return oxr_error(log, XR_ERROR_RUNTIME_FAILURE, "Failed to allocate path");
 	}
 	path->debug = OXR_XR_DEBUG_PATH;
+	path->hash = hash;
+	path->length = length;
+	memcpy(path->str, str, length);
+	path->str[length] = '\0';
 
-	// Setup the item.
-	item = get_item(path);
-	item->hash = math_hash_string(str, length);
-	item->length = length;
-
-	// Yes a const cast! D:
-	char *store = (char *)item->c_str;
-	for (size_t i = 0; i < length; i++) {
-		store[i] = str[i];
+	ret = oxr_ensure_array_length(log, inst, &path->id);
+	if (ret != XR_SUCCESS) {
+		return ret;
 	}
-	store[length] = '\0';
 
 	// Insert and return.
-	ret = u_hashset_insert_item(inst->path_store, item);
-	if (ret) {
-		free(path);
-		return oxr_error(log, XR_ERROR_RUNTIME_FAILURE, "Failed to insert item");
-	}
-
-	oxr_ensure_array_length(log, inst, &path->id);
+	insert_path(inst->path_table, inst->path_table_size, path);
 	inst->path_array[path->id] = path;
 
 	*out_path = path;
@@ -137,7 +254,7 @@ oxr_allocate_path(
 struct oxr_path *
 get_path_or_null(struct oxr_logger *log, const struct oxr_instance *inst, XrPath xr_path)
 {
-	if (xr_path >= inst->path_array_length) {
+	if (xr_path >= inst->path_num) {
 		return NULL;
 	}
 
@@ -172,20 +289,19 @@ XrResult
 oxr_path_get_or_create(
     struct oxr_logger *log, struct oxr_instance *inst, const char *str, size_t length, XrPath *out_path)
 {
-	struct u_hashset_item *item;
+	uint64_t hash = hash_path_string(str, length);
 	struct oxr_path *path = NULL;
 	XrResult ret;
-	int h_ret;
 
 	// Look it up the instance path store.
-	h_ret = u_hashset_find_str(inst->path_store, str, length, &item);
-	if (h_ret == 0) {
-		*out_path = to_xr_path(from_item(item));
+	path = find_path(inst, str, length, hash);
+	if (path != NULL) {
+		*out_path = to_xr_path(path);
 		return XR_SUCCESS;
 	}
 
 	// Create the path since it was not found.
-	ret = oxr_allocate_path(log, inst, str, length, &path);
+	ret = oxr_allocate_path(log, inst, str, length, hash, &path);
 	if (ret != XR_SUCCESS) {
 		return ret;
 	}
@@ -198,13 +314,10 @@ oxr_path_get_or_create(
 XrResult
 oxr_path_only_get(struct oxr_logger *log, struct oxr_instance *inst, const char *str, size_t length, XrPath *out_path)
 {
-	struct u_hashset_item *item;
-	int h_ret;
-
 	// Look it up the instance path store.
-	h_ret = u_hashset_find_str(inst->path_store, str, length, &item);
-	if (h_ret == 0) {
-		*out_path = to_xr_path(from_item(item));
+	struct oxr_path *path = find_path(inst, str, length, hash_path_string(str, length));
+	if (path != NULL) {
+		*out_path = to_xr_path(path);
 		return XR_SUCCESS;
 	}
 
@@ -221,30 +334,30 @@ oxr_path_get_string(
 		return XR_ERROR_PATH_INVALID;
 	}
 
-	*out_str = get_item(path)->c_str;
-	*out_length = get_item(path)->length;
+	*out_str = path->str;
+	*out_length = path->length;
 
 	return XR_SUCCESS;
 }
 
-void
-destroy_callback(struct u_hashset_item *item, void *priv)
-{
-	struct oxr_path *path = from_item(item);
-
-	free(path);
-}
-
 XrResult
 oxr_path_init(struct oxr_logger *log, struct oxr_instance *inst)
 {
-	int h_ret = u_hashset_create(&inst->path_store);
-	if (h_ret != 0) {
-		return oxr_error(log, XR_ERROR_RUNTIME_FAILURE, "Failed to create hashset");
+	inst->path_table_size = OXR_PATH_TABLE_INITIAL_SIZE;
+	inst->path_table = U_TYPED_ARRAY_CALLOC(struct oxr_path *, inst->path_table_size);
+	if (inst->path_table == NULL) {
+		return oxr_error(log, XR_ERROR_RUNTIME_FAILURE, "Failed to create path table");
 	}
 
-	size_t new_size = 64;
-	U_ARRAY_REALLOC_OR_FREE(inst->path_array, struct oxr_path *, new_size);
+	/*
+	 * Half the table size is the most paths it holds before growing, the
+	 * array never needs to be larger than that until then.
+	 */
+	size_t new_size = OXR_PATH_TABLE_INITIAL_SIZE / 2;
+	inst->path_array = U_TYPED_ARRAY_CALLOC(struct oxr_path *, new_size);
+	if (inst->path_array == NULL) {
+		return oxr_error(log, XR_ERROR_RUNTIME_FAILURE, "Failed to create path array");
+	}
 	inst->path_array_length = new_size;
 	inst->path_num = 1; // Reserve space for XR_NULL_PATH
 
@@ -262,10 +375,14 @@ oxr_path_destroy(struct oxr_logger *log, struct oxr_instance *inst)
 	inst->path_num = 0;
 	inst->path_array_length = 0;
 
-	if (inst->path_store == NULL) {
-		return;
-	}
+	free(inst->path_table);
+	inst->path_table = NULL;
+	inst->path_table_size = 0;
 
-	u_hashset_clear_and_call_for_each(inst->path_store, destroy_callback, inst);
-	u_hashset_destroy(&inst->path_store);
+	// The paths are owned by the arena.
+	while (inst->path_arena != NULL) {
+		struct oxr_path_arena_block *block = inst->path_arena;
+		inst->path_arena = block->next;
+		free(block);
+	}
 }
@@ -219,6 +219,61 @@ oxr_session_request_exit(struct oxr_logger *log, struct oxr_session *sess)
 	return oxr_session_success_result(sess);
 }
 
+#ifdef OXR_HAVE_EXT_performance_settings
+/*!
+ * Below this render scale the GPU is reported as under pressure, the apps are
+ * expected to lower their resolution, and at this scale as impaired. Leaving
+ * impaired needs a bit more headroom so that the level doesn't flip flop.
+ */
+#define RENDER_SCALE_WARNING (0.9f)
+#define RENDER_SCALE_IMPAIRED (0.6f)
+#define RENDER_SCALE_IMPAIRED_EXIT (0.7f)
+
+/*!
+ * Sends the render scale the compositor recommends for the session as GPU
+ * notification level changes of XR_EXT_performance_settings.
+ */
+static void
+update_gpu_notification_level(struct oxr_logger *log, struct oxr_session *sess)
+{
+	if (!sess->sys->inst->extensions.EXT_performance_settings) {
+		return;
+	}
+
+	struct xrt_compositor_frame_stats stats = {0};
+	if (xrt_comp_get_frame_stats(sess->compositor, &stats) != XRT_SUCCESS) {
+		return;
+	}
+
+	float scale = stats.recommended_render_scale;
+	XrPerfSettingsNotificationLevelEXT from = sess->gpu_notification_level;
+	XrPerfSettingsNotificationLevelEXT to = from;
+
+	if (scale >= 1.0f) {
+		to = XR_PERF_SETTINGS_NOTIF_LEVEL_NORMAL_EXT;
+	} else if (scale <= RENDER_SCALE_IMPAIRED) {
+		to = XR_PERF_SETTINGS_NOTIF_LEVEL_IMPAIRED_EXT;
+	} else if (from == XR_PERF_SETTINGS_NOTIF_LEVEL_NORMAL_EXT && scale < RENDER_SCALE_WARNING) {
+		to = XR_PERF_SETTINGS_NOTIF_LEVEL_WARNING_EXT;
+	} else if (from == XR_PERF_SETTINGS_NOTIF_LEVEL_IMPAIRED_EXT && scale > RENDER_SCALE_IMPAIRED_EXIT) {
+		to = XR_PERF_SETTINGS_NOTIF_LEVEL_WARNING_EXT;
+	}
+
+	if (to == from) {
+		return;
+	}
+
+	sess->gpu_notification_level = to;
+	oxr_event_push_XrEventDataPerfSettingsEXT(     //
+	    log,                                       //
+	    sess,                                      //
+	    XR_PERF_SETTINGS_DOMAIN_GPU_EXT,           //
+	    XR_PERF_SETTINGS_SUB_DOMAIN_RENDERING_EXT, //
+	    from,                                      //
+	    to);                                       //
+}
+#endif
+
 void
 oxr_session_poll(struct oxr_logger *log, struct oxr_session *sess)
 {
@@ -255,6 +310,10 @@ oxr_session_poll(struct oxr_logger *log, struct oxr_session *sess)
 		}
 	}
 
+#ifdef OXR_HAVE_EXT_performance_settings
+	update_gpu_notification_level(log, sess);
+#endif
+
 	if (sess->state == XR_SESSION_STATE_SYNCHRONIZED && sess->compositor_visible) {
 		oxr_session_change_state(log, sess, XR_SESSION_STATE_VISIBLE, 0);
 	}
@@ -291,6 +350,64 @@ xrt_to_view_state_flags(enum xrt_space_relation_flags flags)
 	return res;
 }
 
+XrResult
+oxr_session_locate_head_cached(struct oxr_logger *log,
+                               struct oxr_session *sess,
+                               struct oxr_space *spc,
+                               XrTime time,
+                               struct xrt_space_relation *out_relation)
+{
+	struct xrt_device *xdev = GET_XDEV_BY_ROLE(sess->sys, head);
+
+	os_mutex_lock(&sess->view_cache.mutex);
+	for (uint32_t i = 0; i < OXR_VIEW_CACHE_SPACE_COUNT; i++) {
+		if (sess->view_cache.heads[i].spc != spc || sess->view_cache.heads[i].time != time) {
+			continue;
+		}
+
+		*out_relation = sess->view_cache.heads[i].T_space_xdev;
+		os_mutex_unlock(&sess->view_cache.mutex);
+
+		return XR_SUCCESS;
+	}
+	os_mutex_unlock(&sess->view_cache.mutex);
+
+	XrResult ret = oxr_space_locate_device(log, xdev, spc, time, out_relation);
+	if (ret != XR_SUCCESS) {
+		return ret;
+	}
+
+	os_mutex_lock(&sess->view_cache.mutex);
+	uint32_t index = sess->view_cache.next_head;
+	sess->view_cache.next_head = (index + 1) % OXR_VIEW_CACHE_SPACE_COUNT;
+	sess->view_cache.heads[index].spc = spc;
+	sess->view_cache.heads[index].time = time;
+	sess->view_cache.heads[index].T_space_xdev = *out_relation;
+	os_mutex_unlock(&sess->view_cache.mutex);
+
+	return XR_SUCCESS;
+}
+
+void
+oxr_session_view_cache_invalidate(struct oxr_session *sess, struct oxr_space *spc)
+{
+	os_mutex_lock(&sess->view_cache.mutex);
+
+	if (spc == NULL) {
+		U_ZERO(&sess->view_cache.views);
+		U_ZERO_ARRAY(sess->view_cache.heads);
+		sess->view_cache.next_head = 0;
+	}
+
+	for (uint32_t i = 0; i < OXR_VIEW_CACHE_SPACE_COUNT; i++) {
+		if (spc != NULL && sess->view_cache.heads[i].spc == spc) {
+			U_ZERO(&sess->view_cache.heads[i]);
+		}
+	}
+
+	os_mutex_unlock(&sess->view_cache.mutex);
+}
+
 XrResult
 oxr_session_locate_views(struct oxr_logger *log,
                          struct oxr_session *sess,
@@ -343,23 +460,45 @@ oxr_session_locate_views(struct oxr_logger *log,
 	struct xrt_fov fovs[2] = {0};
 	struct xrt_pose poses[2] = {0};
 
-	xrt_device_get_view_poses( //
-	    xdev,                  //
-	    &default_eye_relation, //
-	    xdisplay_time,         //
-	    2,                     //
-	    &T_xdev_head,          //
-	    fovs,                  //
-	    poses);
+	os_mutex_lock(&sess->view_cache.mutex);
+	bool cached = sess->view_cache.views.valid && sess->view_cache.views.time_ns == xdisplay_time &&
+	              memcmp(&sess->view_cache.views.eye_relation, &default_eye_relation,
+	                     sizeof(default_eye_relation)) == 0;
+	if (cached) {
+		T_xdev_head = sess->view_cache.views.T_xdev_head;
+		memcpy(fovs, sess->view_cache.views.fovs, sizeof(fovs));
+		memcpy(poses, sess->view_cache.views.poses, sizeof(poses));
+	}
+	os_mutex_unlock(&sess->view_cache.mutex);
+
+	if (!cached) {
+		xrt_device_get_view_poses( //
+		    xdev,                  //
+		    &default_eye_relation, //
+		    xdisplay_time,         //
+		    2,                     //
+		    &T_xdev_head,          //
+		    fovs,                  //
+		    poses);
+
+		os_mutex_lock(&sess->view_cache.mutex);
+		sess->view_cache.views.valid = true;
+		sess->view_cache.views.time_ns = xdisplay_time;
+		sess->view_cache.views.eye_relation = default_eye_relation;
+		sess->view_cache.views.T_xdev_head = T_xdev_head;
+		memcpy(sess->view_cache.views.fovs, fovs, sizeof(fovs));
+		memcpy(sess->view_cache.views.poses, poses, sizeof(poses));
+		os_mutex_unlock(&sess->view_cache.mutex);
+	}
 
 	// The xdev pose in the base space.
 	struct xrt_space_relation T_base_xdev = XRT_SPACE_RELATION_ZERO;
-	XrResult ret = oxr_space_locate_device( //
-	    log,                                //
-	    xdev,                               //
-	    baseSpc,                            //
-	    viewLocateInfo->displayTime,        //
-	    &T_base_xdev);                      //
+	XrResult ret = oxr_session_locate_head_cached( //
+	    log,                                       //
+	    sess,                                      //
+	    baseSpc,                                   //
+	    viewLocateInfo->displayTime,               //
+	    &T_base_xdev);                             //
 	if (ret != XR_SUCCESS || T_base_xdev.relation_flags == 0) {
 		if (print) {
 			oxr_slog(&slog, "\n\tReturning invalid poses");
@@ -576,6 +715,9 @@ oxr_session_frame_wait(struct oxr_logger *log, struct oxr_session *sess, XrFrame
 	sess->frame_id.waited = frame_id;
 	os_mutex_unlock(&sess->active_wait_frames_lock);
 
+	// New frame, so new poses for the display times the app will use.
+	oxr_session_view_cache_invalidate(sess, NULL);
+
 	frameState->shouldRender = should_render(sess->state);
 	frameState->predictedDisplayPeriod = predicted_display_period;
 	frameState->predictedDisplayTime = converted_time;
@@ -658,6 +800,10 @@ oxr_session_destroy(struct oxr_logger *log, struct oxr_handle_base *hb)
 	sess->act_set_attachments = NULL;
 	sess->action_set_attachment_count = 0;
 
+	free(sess->suppressing_sets);
+	sess->suppressing_sets = NULL;
+	sess->suppressing_set_count = 0;
+
 	// If we tore everything down correctly, these are empty now.
 	assert(sess->act_sets_attachments_by_key == NULL || u_hashmap_int_empty(sess->act_sets_attachments_by_key));
 	assert(sess->act_attachments_by_key == NULL || u_hashmap_int_empty(sess->act_attachments_by_key));
@@ -671,6 +817,7 @@ oxr_session_destroy(struct oxr_logger *log, struct oxr_handle_base *hb)
 	os_precise_sleeper_deinit(&sess->sleeper);
 	os_semaphore_destroy(&sess->sem);
 	os_mutex_destroy(&sess->active_wait_frames_lock);
+	os_mutex_destroy(&sess->view_cache.mutex);
 
 	free(sess);
 
@@ -694,6 +841,7 @@ oxr_session_allocate_and_init(struct oxr_logger *log, struct oxr_system *sys, st
 
 	sess->active_wait_frames = 0;
 	os_mutex_init(&sess->active_wait_frames_lock);
+	os_mutex_init(&sess->view_cache.mutex);
 
 	// Debug and user options.
 	sess->ipd_meters = debug_get_num_option_ipd() / 1000.0f;
@@ -984,6 +1132,84 @@ xrt_to_xr_pose(struct xrt_pose *xrt_pose, XrPosef *xr_pose)
 	xr_pose->position.z = xrt_pose->position.z;
 }
 
+/*!
+ * Get the joint set of the hand tracker, only queries the device once per
+ * waited frame and time.
+ */
+static void
+get_hand_tracking_cached(struct oxr_logger *log,
+                         struct oxr_hand_tracker *hand_tracker,
+                         XrTime at_time,
+                         struct xrt_hand_joint_set *out_value)
+{
+	struct oxr_session *sess = hand_tracker->sess;
+
+	os_mutex_lock(&hand_tracker->cache.mutex);
+
+	if (!hand_tracker->cache.valid || hand_tracker->cache.time != at_time ||
+	    hand_tracker->cache.frame_id != sess->frame_id.waited) {
+		oxr_xdev_get_hand_tracking_at(log, sess->sys->inst, hand_tracker->xdev, hand_tracker->input_name,
+		                              at_time, &hand_tracker->cache.value);
+
+		hand_tracker->cache.valid = true;
+		hand_tracker->cache.time = at_time;
+		hand_tracker->cache.frame_id = sess->frame_id.waited;
+	}
+
+	*out_value = hand_tracker->cache.value;
+
+	os_mutex_unlock(&hand_tracker->cache.mutex);
+}
+
+/*!
+ * Transform all joint poses into the base space in one batch, this gives the
+ * same poses as resolving a relation chain per joint but skips the velocity
+ * math, only use it when no velocities are requested.
+ */
+static void
+locate_hand_joints_batched(const struct xrt_space_relation *T_base_hand,
+                           const struct xrt_hand_joint_set *value,
+                           XrHandJointLocationsEXT *locations)
+{
+	const enum xrt_space_relation_flags pose_flags =
+	    XRT_SPACE_RELATION_POSITION_VALID_BIT | XRT_SPACE_RELATION_ORIENTATION_VALID_BIT;
+
+	struct xrt_pose poses[XRT_HAND_JOINT_COUNT];
+	uint32_t count = locations->jointCount;
+	assert(count <= XRT_HAND_JOINT_COUNT);
+
+	// Same upgrading of half valid poses as the relation chain does.
+	for (uint32_t i = 0; i < count; i++) {
+		const struct xrt_space_relation *r = &value->values.hand_joint_set_default[i].relation;
+
+		poses[i] = (struct xrt_pose)XRT_POSE_IDENTITY;
+		if ((r->relation_flags & XRT_SPACE_RELATION_ORIENTATION_VALID_BIT) != 0) {
+			poses[i].orientation = r->pose.orientation;
+		}
+		if ((r->relation_flags & XRT_SPACE_RELATION_POSITION_VALID_BIT) != 0) {
+			poses[i].position = r->pose.position;
+		}
+	}
+
+	math_pose_transform_many(&T_base_hand->pose, poses, poses, count);
+
+	for (uint32_t i = 0; i < count; i++) {
+		const struct xrt_hand_joint_value *joint = &value->values.hand_joint_set_default[i];
+
+		locations->jointLocations[i].locationFlags = xrt_to_xr_space_location_flags(joint->relation.relation_flags);
+		locations->jointLocations[i].radius = joint->radius;
+
+		// A chain with a step without any pose resolves to the zero relation.
+		if ((joint->relation.relation_flags & pose_flags) == 0) {
+			poses[i] = (struct xrt_pose)XRT_POSE_IDENTITY;
+		} else {
+			math_quat_normalize(&poses[i].orientation);
+		}
+
+		xrt_to_xr_pose(&poses[i], &locations->jointLocations[i].pose);
+	}
+}
+
 XrResult
 oxr_session_hand_joints(struct oxr_logger *log,
                         struct oxr_hand_tracker *hand_tracker,
@@ -992,8 +1218,6 @@ oxr_session_hand_joints(struct oxr_logger *log,
 {
 	struct oxr_space *baseSpc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_space *, locateInfo->baseSpace);
 
-	struct oxr_session *sess = hand_tracker->sess;
-
 	XrHandJointVelocitiesEXT *vel =
 	    OXR_GET_OUTPUT_FROM_CHAIN(locations, XR_TYPE_HAND_JOINT_VELOCITIES_EXT, XrHandJointVelocitiesEXT);
 
@@ -1003,12 +1227,11 @@ oxr_session_hand_joints(struct oxr_logger *log,
 	}
 
 	struct xrt_device *xdev = hand_tracker->xdev;
-	enum xrt_input_name name = hand_tracker->input_name;
 
 	XrTime at_time = locateInfo->time;
 	struct xrt_hand_joint_set value;
 
-	oxr_xdev_get_hand_tracking_at(log, sess->sys->inst, xdev, name, at_time, &value);
+	get_hand_tracking_cached(log, hand_tracker, at_time, &value);
 
 	// The hand pose is returned in the xdev's space.
 	struct xrt_space_relation T_xdev_hand = value.hand_pose;
@@ -1052,6 +1275,12 @@ oxr_session_hand_joints(struct oxr_logger *log,
 	// We know we are active.
 	locations->isActive = true;
 
+	// Velocities need the full relation chain per joint.
+	if (vel == NULL) {
+		locate_hand_joints_batched(&T_base_hand, &value, locations);
+		return XR_SUCCESS;
+	}
+
 	for (uint32_t i = 0; i < locations->jointCount; i++) {
 		locations->jointLocations[i].locationFlags =
 		    xrt_to_xr_space_location_flags(value.values.hand_joint_set_default[i].relation.relation_flags);
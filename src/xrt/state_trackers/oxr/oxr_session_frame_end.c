@@ -162,6 +162,11 @@ verify_space(struct oxr_logger *log, uint32_t layer_index, XrSpace space)
 		    layer_index);
 	}
 
+	if (oxr_space_from_openxr(space) == NULL) {
+		return oxr_error(log, XR_ERROR_HANDLE_INVALID, "(frameEndInfo->layers[%u]->space == 0x%" PRIx64 ")",
+		                 layer_index, (uint64_t)space);
+	}
+
 	return XR_SUCCESS;
 }
 
@@ -870,10 +875,9 @@ handle_space(struct oxr_logger *log,
 	}
 
 	// The compositor doesn't know about spaces, so we want the space in the xdev's "space".
-	struct xrt_device *head_xdev = GET_XDEV_BY_ROLE(sess->sys, head);
 	struct xrt_space_relation T_space_xdev = XRT_SPACE_RELATION_ZERO;
 
-	XrResult ret = oxr_space_locate_device(log, head_xdev, spc, timestamp, &T_space_xdev);
+	XrResult ret = oxr_session_locate_head_cached(log, sess, spc, timestamp, &T_space_xdev);
 	if (ret != XR_SUCCESS) {
 		return false;
 	}
@@ -892,6 +896,24 @@ handle_space(struct oxr_logger *log,
 	return true;
 }
 
+/*!
+ * Get the storage to convert a layer into, this is memory of the compositor if
+ * it supports it, for instance the shared memory slot of the IPC client, so
+ * the layer call doesn't need to copy it again.
+ */
+static struct xrt_layer_data *
+reserve_layer_data(struct xrt_compositor *xc, struct xrt_layer_data *storage)
+{
+	struct xrt_layer_data *data = xrt_comp_layer_reserve(xc);
+	if (data == NULL) {
+		data = storage;
+	}
+
+	U_ZERO(data);
+
+	return data;
+}
+
 static XrResult
 submit_quad_layer(struct oxr_session *sess,
                   struct xrt_compositor *xc,
@@ -903,7 +925,7 @@ submit_quad_layer(struct oxr_session *sess,
                   uint64_t xrt_timestamp)
 {
 	struct oxr_swapchain *sc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_swapchain *, quad->subImage.swapchain);
-	struct oxr_space *spc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_space *, quad->space);
+	struct oxr_space *spc = oxr_space_from_openxr(quad->space);
 
 	enum xrt_layer_composition_flags flags = convert_layer_flags(quad->layerFlags);
 
@@ -918,21 +940,21 @@ submit_quad_layer(struct oxr_session *sess,
 		flags |= XRT_LAYER_COMPOSITION_VIEW_SPACE_BIT;
 	}
 
-	struct xrt_layer_data data;
-	U_ZERO(&data);
-	data.type = XRT_LAYER_QUAD;
-	data.name = XRT_INPUT_GENERIC_HEAD_POSE;
-	data.timestamp = xrt_timestamp;
-	data.flags = flags;
+	struct xrt_layer_data storage;
+	struct xrt_layer_data *data = reserve_layer_data(xc, &storage);
+	data->type = XRT_LAYER_QUAD;
+	data->name = XRT_INPUT_GENERIC_HEAD_POSE;
+	data->timestamp = xrt_timestamp;
+	data->flags = flags;
 
 	struct xrt_vec2 *size = (struct xrt_vec2 *)&quad->size;
 
-	data.quad.visibility = convert_eye_visibility(quad->eyeVisibility);
-	data.quad.pose = pose;
-	data.quad.size = *size;
-	fill_in_sub_image(sc, &quad->subImage, &data.quad.sub);
+	data->quad.visibility = convert_eye_visibility(quad->eyeVisibility);
+	data->quad.pose = pose;
+	data->quad.size = *size;
+	fill_in_sub_image(sc, &quad->subImage, &data->quad.sub);
 
-	xrt_result_t xret = xrt_comp_layer_quad(xc, head, sc->swapchain, &data);
+	xrt_result_t xret = xrt_comp_layer_quad(xc, head, sc->swapchain, data);
 	OXR_CHECK_XRET(log, sess, xret, xrt_comp_layer_quad);
 
 	return XR_SUCCESS;
@@ -948,7 +970,7 @@ submit_projection_layer(struct oxr_session *sess,
                         uint64_t oxr_timestamp,
                         uint64_t xrt_timestamp)
 {
-	struct oxr_space *spc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_space *, proj->space);
+	struct oxr_space *spc = oxr_space_from_openxr(proj->space);
 	struct oxr_swapchain *d_scs[2] = {NULL, NULL};
 	struct oxr_swapchain *scs[2];
 	struct xrt_pose *pose_ptr;
@@ -973,31 +995,31 @@ submit_projection_layer(struct oxr_session *sess,
 	struct xrt_fov *l_fov = (struct xrt_fov *)&proj->views[0].fov;
 	struct xrt_fov *r_fov = (struct xrt_fov *)&proj->views[1].fov;
 
-	struct xrt_layer_data data;
-	U_ZERO(&data);
-	data.type = XRT_LAYER_STEREO_PROJECTION;
-	data.name = XRT_INPUT_GENERIC_HEAD_POSE;
-	data.timestamp = xrt_timestamp;
-	data.flags = flags;
-	data.stereo.l.fov = *l_fov;
-	data.stereo.l.pose = pose[0];
-	data.stereo.r.fov = *r_fov;
-	data.stereo.r.pose = pose[1];
-	fill_in_sub_image(scs[0], &proj->views[0].subImage, &data.stereo.l.sub);
-	fill_in_sub_image(scs[1], &proj->views[1].subImage, &data.stereo.r.sub);
+	struct xrt_layer_data storage;
+	struct xrt_layer_data *data = reserve_layer_data(xc, &storage);
+	data->type = XRT_LAYER_STEREO_PROJECTION;
+	data->name = XRT_INPUT_GENERIC_HEAD_POSE;
+	data->timestamp = xrt_timestamp;
+	data->flags = flags;
+	data->stereo.l.fov = *l_fov;
+	data->stereo.l.pose = pose[0];
+	data->stereo.r.fov = *r_fov;
+	data->stereo.r.pose = pose[1];
+	fill_in_sub_image(scs[0], &proj->views[0].subImage, &data->stereo.l.sub);
+	fill_in_sub_image(scs[1], &proj->views[1].subImage, &data->stereo.r.sub);
 
 #ifdef XRT_FEATURE_OPENXR_LAYER_DEPTH
 	const XrCompositionLayerDepthInfoKHR *d_l = OXR_GET_INPUT_FROM_CHAIN(
 	    &proj->views[0], XR_TYPE_COMPOSITION_LAYER_DEPTH_INFO_KHR, XrCompositionLayerDepthInfoKHR);
 	if (d_l) {
-		data.stereo_depth.l_d.far_z = d_l->farZ;
-		data.stereo_depth.l_d.near_z = d_l->nearZ;
-		data.stereo_depth.l_d.max_depth = d_l->maxDepth;
-		data.stereo_depth.l_d.min_depth = d_l->minDepth;
+		data->stereo_depth.l_d.far_z = d_l->farZ;
+		data->stereo_depth.l_d.near_z = d_l->nearZ;
+		data->stereo_depth.l_d.max_depth = d_l->maxDepth;
+		data->stereo_depth.l_d.min_depth = d_l->minDepth;
 
 		struct oxr_swapchain *sc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_swapchain *, d_l->subImage.swapchain);
 
-		fill_in_sub_image(sc, &d_l->subImage, &data.stereo_depth.l_d.sub);
+		fill_in_sub_image(sc, &d_l->subImage, &data->stereo_depth.l_d.sub);
 
 		// Need to pass this in.
 		d_scs[0] = sc;
@@ -1007,14 +1029,14 @@ submit_projection_layer(struct oxr_session *sess,
 	    &proj->views[1], XR_TYPE_COMPOSITION_LAYER_DEPTH_INFO_KHR, XrCompositionLayerDepthInfoKHR);
 
 	if (d_r) {
-		data.stereo_depth.r_d.far_z = d_r->farZ;
-		data.stereo_depth.r_d.near_z = d_r->nearZ;
-		data.stereo_depth.r_d.max_depth = d_r->maxDepth;
-		data.stereo_depth.r_d.min_depth = d_r->minDepth;
+		data->stereo_depth.r_d.far_z = d_r->farZ;
+		data->stereo_depth.r_d.near_z = d_r->nearZ;
+		data->stereo_depth.r_d.max_depth = d_r->maxDepth;
+		data->stereo_depth.r_d.min_depth = d_r->minDepth;
 
 		struct oxr_swapchain *sc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_swapchain *, d_r->subImage.swapchain);
 
-		fill_in_sub_image(sc, &d_r->subImage, &data.stereo_depth.r_d.sub);
+		fill_in_sub_image(sc, &d_r->subImage, &data->stereo_depth.r_d.sub);
 
 		// Need to pass this in.
 		d_scs[1] = sc;
@@ -1023,7 +1045,7 @@ submit_projection_layer(struct oxr_session *sess,
 
 	if (d_scs[0] != NULL && d_scs[1] != NULL) {
 #ifdef XRT_FEATURE_OPENXR_LAYER_DEPTH
-		data.type = XRT_LAYER_STEREO_PROJECTION_DEPTH;
+		data->type = XRT_LAYER_STEREO_PROJECTION_DEPTH;
 		xrt_result_t xret = xrt_comp_layer_stereo_projection_depth( //
 		    xc,                                                     // compositor
 		    head,                                                   // xdev
@@ -1031,7 +1053,7 @@ submit_projection_layer(struct oxr_session *sess,
 		    scs[1]->swapchain,                                      // right
 		    d_scs[0]->swapchain,                                    // left
 		    d_scs[1]->swapchain,                                    // right
-		    &data);                                                 // data
+		    data);                                                  // data
 		OXR_CHECK_XRET(log, sess, xret, xrt_comp_layer_stereo_projection_depth);
 #else
 		assert(false && "Should not get here");
@@ -1042,7 +1064,7 @@ submit_projection_layer(struct oxr_session *sess,
 		    head,                                             // xdev
 		    scs[0]->swapchain,                                // left
 		    scs[1]->swapchain,                                // right
-		    &data);                                           // data
+		    data);                                            // data
 		OXR_CHECK_XRET(log, sess, xret, xrt_comp_layer_stereo_projection);
 	}
 
@@ -1060,23 +1082,24 @@ submit_cube_layer(struct oxr_session *sess,
                   uint64_t xrt_timestamp)
 {
 	struct oxr_swapchain *sc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_swapchain *, cube->swapchain);
-	struct oxr_space *spc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_space *, cube->space);
+	struct oxr_space *spc = oxr_space_from_openxr(cube->space);
 
-	struct xrt_layer_data data = {0};
+	struct xrt_layer_data storage;
+	struct xrt_layer_data *data = reserve_layer_data(xc, &storage);
 
-	data.type = XRT_LAYER_CUBE;
-	data.name = XRT_INPUT_GENERIC_HEAD_POSE;
-	data.timestamp = xrt_timestamp;
-	data.flags = convert_layer_flags(cube->layerFlags);
+	data->type = XRT_LAYER_CUBE;
+	data->name = XRT_INPUT_GENERIC_HEAD_POSE;
+	data->timestamp = xrt_timestamp;
+	data->flags = convert_layer_flags(cube->layerFlags);
 
 	if (spc->space_type == OXR_SPACE_TYPE_REFERENCE_VIEW) {
-		data.flags |= XRT_LAYER_COMPOSITION_VIEW_SPACE_BIT;
+		data->flags |= XRT_LAYER_COMPOSITION_VIEW_SPACE_BIT;
 	}
 
-	data.cube.visibility = convert_eye_visibility(cube->eyeVisibility);
+	data->cube.visibility = convert_eye_visibility(cube->eyeVisibility);
 
-	data.cube.sub.image_index = sc->released.index;
-	data.cube.sub.array_index = cube->imageArrayIndex;
+	data->cube.sub.image_index = sc->released.index;
+	data->cube.sub.array_index = cube->imageArrayIndex;
 
 	struct xrt_pose pose = {
 	    .orientation =
@@ -1089,11 +1112,11 @@ submit_cube_layer(struct oxr_session *sess,
 	    .position = XRT_VEC3_ZERO,
 	};
 
-	if (!handle_space(log, sess, spc, &pose, inv_offset, oxr_timestamp, &data.cube.pose)) {
+	if (!handle_space(log, sess, spc, &pose, inv_offset, oxr_timestamp, &data->cube.pose)) {
 		return XR_SUCCESS;
 	}
 
-	xrt_result_t xret = xrt_comp_layer_cube(xc, head, sc->swapchain, &data);
+	xrt_result_t xret = xrt_comp_layer_cube(xc, head, sc->swapchain, data);
 	OXR_CHECK_XRET(log, sess, xret, xrt_comp_layer_cube);
 
 	return XR_SUCCESS;
@@ -1110,7 +1133,7 @@ submit_cylinder_layer(struct oxr_session *sess,
                       uint64_t xrt_timestamp)
 {
 	struct oxr_swapchain *sc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_swapchain *, cylinder->subImage.swapchain);
-	struct oxr_space *spc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_space *, cylinder->space);
+	struct oxr_space *spc = oxr_space_from_openxr(cylinder->space);
 
 	enum xrt_layer_composition_flags flags = convert_layer_flags(cylinder->layerFlags);
 	enum xrt_layer_eye_visibility visibility = convert_eye_visibility(cylinder->eyeVisibility);
@@ -1126,21 +1149,21 @@ submit_cylinder_layer(struct oxr_session *sess,
 		flags |= XRT_LAYER_COMPOSITION_VIEW_SPACE_BIT;
 	}
 
-	struct xrt_layer_data data;
-	U_ZERO(&data);
-	data.type = XRT_LAYER_CYLINDER;
-	data.name = XRT_INPUT_GENERIC_HEAD_POSE;
-	data.timestamp = xrt_timestamp;
-	data.flags = flags;
+	struct xrt_layer_data storage;
+	struct xrt_layer_data *data = reserve_layer_data(xc, &storage);
+	data->type = XRT_LAYER_CYLINDER;
+	data->name = XRT_INPUT_GENERIC_HEAD_POSE;
+	data->timestamp = xrt_timestamp;
+	data->flags = flags;
 
-	data.cylinder.visibility = visibility;
-	data.cylinder.pose = pose;
-	data.cylinder.radius = cylinder->radius;
-	data.cylinder.central_angle = cylinder->centralAngle;
-	data.cylinder.aspect_ratio = cylinder->aspectRatio;
-	fill_in_sub_image(sc, &cylinder->subImage, &data.cylinder.sub);
+	data->cylinder.visibility = visibility;
+	data->cylinder.pose = pose;
+	data->cylinder.radius = cylinder->radius;
+	data->cylinder.central_angle = cylinder->centralAngle;
+	data->cylinder.aspect_ratio = cylinder->aspectRatio;
+	fill_in_sub_image(sc, &cylinder->subImage, &data->cylinder.sub);
 
-	xrt_result_t xret = xrt_comp_layer_cylinder(xc, head, sc->swapchain, &data);
+	xrt_result_t xret = xrt_comp_layer_cylinder(xc, head, sc->swapchain, data);
 	OXR_CHECK_XRET(log, sess, xret, xrt_comp_layer_cylinder);
 
 	return XR_SUCCESS;
@@ -1157,7 +1180,7 @@ submit_equirect1_layer(struct oxr_session *sess,
                        uint64_t xrt_timestamp)
 {
 	struct oxr_swapchain *sc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_swapchain *, equirect->subImage.swapchain);
-	struct oxr_space *spc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_space *, equirect->space);
+	struct oxr_space *spc = oxr_space_from_openxr(equirect->space);
 
 	enum xrt_layer_composition_flags flags = convert_layer_flags(equirect->layerFlags);
 
@@ -1172,25 +1195,25 @@ submit_equirect1_layer(struct oxr_session *sess,
 		flags |= XRT_LAYER_COMPOSITION_VIEW_SPACE_BIT;
 	}
 
-	struct xrt_layer_data data;
-	U_ZERO(&data);
-	data.type = XRT_LAYER_EQUIRECT1;
-	data.name = XRT_INPUT_GENERIC_HEAD_POSE;
-	data.timestamp = xrt_timestamp;
-	data.flags = flags;
-	data.equirect1.visibility = convert_eye_visibility(equirect->eyeVisibility);
-	data.equirect1.pose = pose;
-	data.equirect1.radius = equirect->radius;
-	fill_in_sub_image(sc, &equirect->subImage, &data.equirect1.sub);
+	struct xrt_layer_data storage;
+	struct xrt_layer_data *data = reserve_layer_data(xc, &storage);
+	data->type = XRT_LAYER_EQUIRECT1;
+	data->name = XRT_INPUT_GENERIC_HEAD_POSE;
+	data->timestamp = xrt_timestamp;
+	data->flags = flags;
+	data->equirect1.visibility = convert_eye_visibility(equirect->eyeVisibility);
+	data->equirect1.pose = pose;
+	data->equirect1.radius = equirect->radius;
+	fill_in_sub_image(sc, &equirect->subImage, &data->equirect1.sub);
 
 
 	struct xrt_vec2 *scale = (struct xrt_vec2 *)&equirect->scale;
 	struct xrt_vec2 *bias = (struct xrt_vec2 *)&equirect->bias;
 
-	data.equirect1.scale = *scale;
-	data.equirect1.bias = *bias;
+	data->equirect1.scale = *scale;
+	data->equirect1.bias = *bias;
 
-	xrt_result_t xret = xrt_comp_layer_equirect1(xc, head, sc->swapchain, &data);
+	xrt_result_t xret = xrt_comp_layer_equirect1(xc, head, sc->swapchain, data);
 	OXR_CHECK_XRET(log, sess, xret, xrt_comp_layer_equirect1);
 
 	return XR_SUCCESS;
@@ -1216,7 +1239,7 @@ submit_equirect2_layer(struct oxr_session *sess,
                        uint64_t xrt_timestamp)
 {
 	struct oxr_swapchain *sc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_swapchain *, equirect->subImage.swapchain);
-	struct oxr_space *spc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_space *, equirect->space);
+	struct oxr_space *spc = oxr_space_from_openxr(equirect->space);
 
 	enum xrt_layer_composition_flags flags = convert_layer_flags(equirect->layerFlags);
 
@@ -1231,21 +1254,21 @@ submit_equirect2_layer(struct oxr_session *sess,
 		flags |= XRT_LAYER_COMPOSITION_VIEW_SPACE_BIT;
 	}
 
-	struct xrt_layer_data data;
-	U_ZERO(&data);
-	data.type = XRT_LAYER_EQUIRECT2;
-	data.name = XRT_INPUT_GENERIC_HEAD_POSE;
-	data.timestamp = xrt_timestamp;
-	data.flags = flags;
-	data.equirect2.visibility = convert_eye_visibility(equirect->eyeVisibility);
-	data.equirect2.pose = pose;
-	data.equirect2.radius = equirect->radius;
-	data.equirect2.central_horizontal_angle = equirect->centralHorizontalAngle;
-	data.equirect2.upper_vertical_angle = equirect->upperVerticalAngle;
-	data.equirect2.lower_vertical_angle = equirect->lowerVerticalAngle;
-	fill_in_sub_image(sc, &equirect->subImage, &data.equirect2.sub);
-
-	xrt_result_t xret = xrt_comp_layer_equirect2(xc, head, sc->swapchain, &data);
+	struct xrt_layer_data storage;
+	struct xrt_layer_data *data = reserve_layer_data(xc, &storage);
+	data->type = XRT_LAYER_EQUIRECT2;
+	data->name = XRT_INPUT_GENERIC_HEAD_POSE;
+	data->timestamp = xrt_timestamp;
+	data->flags = flags;
+	data->equirect2.visibility = convert_eye_visibility(equirect->eyeVisibility);
+	data->equirect2.pose = pose;
+	data->equirect2.radius = equirect->radius;
+	data->equirect2.central_horizontal_angle = equirect->centralHorizontalAngle;
+	data->equirect2.upper_vertical_angle = equirect->upperVerticalAngle;
+	data->equirect2.lower_vertical_angle = equirect->lowerVerticalAngle;
+	fill_in_sub_image(sc, &equirect->subImage, &data->equirect2.sub);
+
+	xrt_result_t xret = xrt_comp_layer_equirect2(xc, head, sc->swapchain, data);
 	OXR_CHECK_XRET(log, sess, xret, xrt_comp_layer_equirect2);
 
 	return XR_SUCCESS;
@@ -29,6 +29,9 @@
 #include <string.h>
 
 
+struct oxr_handle_table oxr_space_table = OXR_HANDLE_TABLE_INIT(struct oxr_space);
+
+
 /*
  *
  * Helper functions.
@@ -146,11 +149,14 @@ oxr_space_destroy(struct oxr_logger *log, struct oxr_handle_base *hb)
 {
 	struct oxr_space *spc = (struct oxr_space *)hb;
 
+	// Don't let a new space at the same address hit the cache.
+	oxr_session_view_cache_invalidate(spc->sess, spc);
+
 	xrt_space_reference(&spc->action.xs, NULL);
 	spc->action.xdev = NULL;
 	spc->action.name = 0;
 
-	free(spc);
+	oxr_handle_table_free(&oxr_space_table, hb);
 
 	return XR_SUCCESS;
 }
@@ -166,7 +172,8 @@ oxr_space_action_create(struct oxr_logger *log,
 	struct oxr_subaction_paths subaction_paths = {0};
 
 	struct oxr_space *spc = NULL;
-	OXR_ALLOCATE_HANDLE_OR_RETURN(log, spc, OXR_XR_DEBUG_SPACE, oxr_space_destroy, &sess->handle);
+	OXR_ALLOCATE_HANDLE_FROM_TABLE_OR_RETURN(log, spc, &oxr_space_table, OXR_XR_DEBUG_SPACE, oxr_space_destroy,
+	                                         &sess->handle);
 
 	oxr_classify_subaction_paths(log, inst, 1, &createInfo->subactionPath, &subaction_paths);
 
@@ -199,7 +206,8 @@ oxr_space_reference_create(struct oxr_logger *log,
 	}
 
 	struct oxr_space *spc = NULL;
-	OXR_ALLOCATE_HANDLE_OR_RETURN(log, spc, OXR_XR_DEBUG_SPACE, oxr_space_destroy, &sess->handle);
+	OXR_ALLOCATE_HANDLE_FROM_TABLE_OR_RETURN(log, spc, &oxr_space_table, OXR_XR_DEBUG_SPACE, oxr_space_destroy,
+	                                         &sess->handle);
 	spc->sess = sess;
 	spc->space_type = xr_ref_space_to_oxr(createInfo->referenceSpaceType);
 	memcpy(&spc->pose, &createInfo->poseInReferenceSpace, sizeof(spc->pose));
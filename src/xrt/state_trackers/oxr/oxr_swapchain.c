@@ -298,6 +298,9 @@ oxr_swapchain_common_create(struct oxr_logger *log,
 		return oxr_error(log, XR_ERROR_SWAPCHAIN_FORMAT_UNSUPPORTED,
 		                 "Specified swapchain format is not supported");
 	}
+	if (xret == XRT_ERROR_ALLOCATION) {
+		return oxr_error(log, XR_ERROR_OUT_OF_MEMORY, "Not enough GPU memory for the swapchain");
+	}
 	if (xret != XRT_SUCCESS) {
 		return oxr_error(log, XR_ERROR_RUNTIME_FAILURE, "Failed to create swapchain");
 	}
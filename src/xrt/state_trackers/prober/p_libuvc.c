@@ -63,9 +63,21 @@ p_libuvc_probe(struct prober *p)
 		struct uvc_device_descriptor *desc;
 		struct prober_device *pdev = NULL;
 
-		uvc_get_device_descriptor(device, &desc);
 		uint8_t bus = uvc_get_bus_number(device);
 		uint8_t addr = uvc_get_device_address(device);
+
+		/*
+		 * Getting the descriptor opens the device to read the strings,
+		 * the libusb probe has normally already found it so skip that.
+		 */
+		pdev = p_dev_find_usb_dev(p, bus, addr);
+		if (pdev != NULL) {
+			P_TRACE(p, "libuvc\n\t\tptr:        %p (already probed)", (void *)pdev);
+			pdev->uvc.dev = device;
+			continue;
+		}
+
+		uvc_get_device_descriptor(device, &desc);
 		uint16_t vendor = desc->idVendor;
 		uint16_t product = desc->idProduct;
 
@@ -17,8 +17,10 @@
 #include "util/u_debug.h"
 #include "util/u_pretty_print.h"
 #include "util/u_trace_marker.h"
+#include "util/u_time.h"
 
 #include "os/os_hid.h"
+#include "os/os_time.h"
 #include "p_prober.h"
 
 #ifdef XRT_HAVE_V4L2
@@ -40,6 +42,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
+#include <inttypes.h>
 
 #include "multi_wrapper/multi.h"
 
@@ -56,6 +59,44 @@ DEBUG_GET_ONCE_BOOL_OPTION(qwerty_combine, "QWERTY_COMBINE", false)
 DEBUG_GET_ONCE_OPTION(vf_path, "VF_PATH", NULL)
 DEBUG_GET_ONCE_OPTION(euroc_path, "EUROC_PATH", NULL)
 DEBUG_GET_ONCE_NUM_OPTION(rs_source_index, "RS_SOURCE_INDEX", -1)
+DEBUG_GET_ONCE_BOOL_OPTION(parallel_probe, "PROBER_PARALLEL", true)
+DEBUG_GET_ONCE_NUM_OPTION(probe_timeout_ms, "PROBER_TIMEOUT_MS", 10000)
+DEBUG_GET_ONCE_BOOL_OPTION(hotplug, "PROBER_HOTPLUG", true)
+DEBUG_GET_ONCE_NUM_OPTION(hotplug_settle_ms, "PROBER_HOTPLUG_SETTLE_MS", 1000)
+
+
+/*
+ *
+ * Structs.
+ *
+ */
+
+/*!
+ * A builder estimate or auto prober run on its own thread.
+ */
+struct p_job
+{
+	struct prober *p;
+	struct os_thread thread;
+
+	//! Is running on @ref thread, which needs to be joined.
+	bool threaded;
+
+	//! Set when the job has run, protected by the jobs mutex.
+	bool done;
+
+	//! Set when the job timed out and its results should be thrown away.
+	bool abandoned;
+
+	//! Either estimate @ref xb, or run @ref xap.
+	struct xrt_builder *xb;
+	struct xrt_builder_estimate estimate;
+
+	struct xrt_auto_prober *xap;
+	bool no_hmds;
+	int num_found;
+	struct xrt_device *xdevs[XRT_MAX_DEVICES_PER_PROBE];
+};
 
 
 /*
@@ -73,6 +114,9 @@ initialize(struct prober *p, struct xrt_prober_entry_lists *lists);
 static void
 teardown_devices(struct prober *p);
 
+static void
+teardown_jobs(struct prober *p);
+
 static void
 teardown(struct prober *p);
 
@@ -85,6 +129,9 @@ p_lock_list(struct xrt_prober *xp, struct xrt_prober_device ***out_devices, size
 static xrt_result_t
 p_unlock_list(struct xrt_prober *xp, struct xrt_prober_device ***devices);
 
+static xrt_result_t
+p_poll_hotplug(struct xrt_prober *xp, struct xrt_device **out_xdevs, uint32_t xdev_capacity, uint32_t *out_xdev_count);
+
 static int
 p_dump(struct xrt_prober *xp);
 
@@ -193,6 +240,20 @@ p_dev_get_usb_dev(struct prober *p,
 	return 0;
 }
 
+struct prober_device *
+p_dev_find_usb_dev(struct prober *p, uint16_t bus, uint16_t addr)
+{
+	for (size_t i = 0; i < p->device_count; i++) {
+		struct prober_device *pdev = &p->devices[i];
+
+		if (pdev->base.bus == XRT_BUS_TYPE_USB && pdev->usb.bus == bus && pdev->usb.addr == addr) {
+			return pdev;
+		}
+	}
+
+	return NULL;
+}
+
 int
 p_dev_get_bluetooth_dev(struct prober *p,
                         uint64_t id,
@@ -433,6 +494,7 @@ initialize(struct prober *p, struct xrt_prober_entry_lists *lists)
 	p->base.probe = p_probe;
 	p->base.lock_list = p_lock_list;
 	p->base.unlock_list = p_unlock_list;
+	p->base.poll_hotplug = p_poll_hotplug;
 	p->base.dump = p_dump;
 	p->base.create_system = p_create_system;
 	p->base.select = p_select_device;
@@ -449,10 +511,14 @@ initialize(struct prober *p, struct xrt_prober_entry_lists *lists)
 	p->json.file_loaded = false;
 	p->json.root = NULL;
 
+	os_mutex_init(&p->jobs.mutex);
+	os_semaphore_init(&p->jobs.done_sem, 0);
+
 	u_var_add_root((void *)p, "Prober", true);
 	u_var_add_log_level(p, &p->log_level, "Log level");
 
 	int ret;
+	uint64_t start_ns = os_monotonic_get_ns();
 
 	u_config_json_open_or_create_main_file(&p->json);
 
@@ -478,6 +544,13 @@ initialize(struct prober *p, struct xrt_prober_entry_lists *lists)
 	}
 #endif
 
+#ifdef XRT_HAVE_LIBUDEV
+	if (debug_get_bool_option_hotplug()) {
+		// Not fatal, devices plugged in later just won't be seen.
+		p_udev_monitor_init(p);
+	}
+#endif
+
 	ret = p_tracking_init(p);
 	if (ret != 0) {
 		teardown(p);
@@ -493,6 +566,8 @@ initialize(struct prober *p, struct xrt_prober_entry_lists *lists)
 	parse_disabled_drivers(p);
 	disable_drivers_from_conflicts(p);
 
+	p->timing.init_ns = os_monotonic_get_ns() - start_ns;
+
 	return 0;
 }
 
@@ -581,6 +656,9 @@ teardown(struct prober *p)
 	// First remove the variable tracking.
 	u_var_remove_root((void *)p);
 
+	// Jobs that timed out may still be using the builders and auto probers.
+	teardown_jobs(p);
+
 	// Clean up all setter uppers.
 	for (size_t i = 0; i < p->builder_count; i++) {
 		xrt_builder_destroy(&p->builders[i]);
@@ -607,6 +685,10 @@ teardown(struct prober *p)
 
 	teardown_devices(p);
 
+#ifdef XRT_HAVE_LIBUDEV
+	p_udev_monitor_teardown(p);
+#endif
+
 #ifdef XRT_HAVE_LIBUVC
 	p_libuvc_teardown(p);
 #endif
@@ -618,6 +700,54 @@ teardown(struct prober *p)
 	u_config_json_close(&p->json);
 
 	free(p->disabled_drivers);
+
+	os_semaphore_destroy(&p->jobs.done_sem);
+	os_mutex_destroy(&p->jobs.mutex);
+}
+
+/*!
+ * What identifies a @ref prober_device across probes, used to tell which
+ * devices are new after a hotplug event.
+ */
+struct p_device_key
+{
+	enum xrt_bus_type bus;
+	uint16_t vendor_id;
+	uint16_t product_id;
+	uint16_t usb_bus;
+	uint16_t usb_addr;
+	uint64_t bluetooth_id;
+};
+
+static void
+get_device_key(const struct prober_device *pdev, struct p_device_key *out_key)
+{
+	U_ZERO(out_key);
+	out_key->bus = pdev->base.bus;
+	out_key->vendor_id = pdev->base.vendor_id;
+	out_key->product_id = pdev->base.product_id;
+
+	if (pdev->base.bus == XRT_BUS_TYPE_BLUETOOTH) {
+		out_key->bluetooth_id = pdev->bluetooth.id;
+	} else {
+		out_key->usb_bus = pdev->usb.bus;
+		out_key->usb_addr = pdev->usb.addr;
+	}
+}
+
+static bool
+has_device_key(const struct p_device_key *keys, size_t key_count, const struct prober_device *pdev)
+{
+	struct p_device_key key;
+	get_device_key(pdev, &key);
+
+	for (size_t i = 0; i < key_count; i++) {
+		if (memcmp(&keys[i], &key, sizeof(key)) == 0) {
+			return true;
+		}
+	}
+
+	return false;
 }
 
 static void
@@ -651,60 +781,227 @@ handle_found_device(
 	xdevs[i] = xdev;
 }
 
+/*
+ *
+ * Jobs.
+ *
+ */
+
 static void
-add_from_devices(struct prober *p, struct xrt_device **xdevs, size_t xdev_count, bool *have_hmd)
+job_run(struct p_job *job)
 {
-	struct xrt_prober_device **dev_list = NULL;
-	size_t dev_count = 0;
-	xrt_result_t xret;
+	struct prober *p = job->p;
 
-	xret = xrt_prober_lock_list(&p->base, &dev_list, &dev_count);
-	if (xret != XRT_SUCCESS) {
-		P_ERROR(p, "Failed to lock list!");
+	if (job->xb != NULL) {
+		xrt_builder_estimate_system(job->xb, p->json.root, &p->base, &job->estimate);
+	} else {
+		job->num_found = job->xap->lelo_dallas_autoprobe(job->xap, NULL, job->no_hmds, &p->base, job->xdevs);
+	}
+}
+
+static void
+job_destroy_devices(struct p_job *job)
+{
+	for (int i = 0; i < job->num_found && i < XRT_MAX_DEVICES_PER_PROBE; i++) {
+		xrt_device_destroy(&job->xdevs[i]);
+	}
+	job->num_found = 0;
+}
+
+static void *
+job_thread(void *ptr)
+{
+	struct p_job *job = (struct p_job *)ptr;
+	struct prober *p = job->p;
+
+	os_thread_name(&job->thread, "Prober job");
+
+	job_run(job);
+
+	os_mutex_lock(&p->jobs.mutex);
+	job->done = true;
+	if (job->abandoned) {
+		// Nobody is going to look at these.
+		job_destroy_devices(job);
+	}
+	os_mutex_unlock(&p->jobs.mutex);
+
+	os_semaphore_release(&p->jobs.done_sem);
+
+	return NULL;
+}
+
+/*!
+ * Runs all jobs at the same time and waits for them up to the timeout, jobs
+ * that are not done by then are marked as abandoned and kept until teardown.
+ * Returns with the jobs that finished still in @p jobs, in the same order so
+ * the results can be merged the same way every time.
+ */
+static void
+run_jobs(struct prober *p, struct p_job **jobs, size_t job_count)
+{
+	XRT_TRACE_MARKER();
+
+	if (!debug_get_bool_option_parallel_probe()) {
+		for (size_t i = 0; i < job_count; i++) {
+			job_run(jobs[i]);
+			jobs[i]->done = true;
+		}
 		return;
 	}
 
-	// Loop over all devices and entries that might match them.
-	for (size_t i = 0; i < p->device_count; i++) {
-		struct prober_device *pdev = &p->devices[i];
+	size_t started = 0;
+	for (size_t i = 0; i < job_count; i++) {
+		os_thread_init(&jobs[i]->thread);
+		if (os_thread_start(&jobs[i]->thread, job_thread, jobs[i]) != 0) {
+			// Run it here instead.
+			os_thread_destroy(&jobs[i]->thread);
+			job_run(jobs[i]);
+			jobs[i]->done = true;
+			continue;
+		}
+		jobs[i]->threaded = true;
+		started++;
+	}
 
-		for (size_t k = 0; k < p->num_entries; k++) {
-			struct xrt_prober_entry *entry = p->entries[k];
-			if (pdev->base.vendor_id != entry->vendor_id || pdev->base.product_id != entry->product_id) {
-				continue;
-			}
+	uint64_t timeout_ns = (uint64_t)debug_get_num_option_probe_timeout_ms() * U_TIME_1MS_IN_NS;
+	uint64_t deadline_ns = os_monotonic_get_ns() + timeout_ns;
 
-			bool skip = false;
-			for (size_t disabled = 0; disabled < p->num_disabled_drivers; disabled++) {
-				if (strcmp(entry->driver_name, p->disabled_drivers[disabled]) == 0) {
-					P_INFO(p, "Skipping disabled driver %s", entry->driver_name);
-					skip = true;
-					break;
-				}
-			}
-			if (skip) {
-				continue;
+	/*
+	 * Every job releases the semaphore when done, jobs abandoned by an
+	 * earlier call might too so check what is actually done each time.
+	 */
+	while (started > 0) {
+		bool all_done = true;
+		os_mutex_lock(&p->jobs.mutex);
+		for (size_t i = 0; i < job_count; i++) {
+			all_done = all_done && jobs[i]->done;
+		}
+		os_mutex_unlock(&p->jobs.mutex);
+
+		uint64_t now_ns = os_monotonic_get_ns();
+		if (all_done || now_ns >= deadline_ns) {
+			break;
+		}
+
+		os_semaphore_wait(&p->jobs.done_sem, deadline_ns - now_ns);
+	}
+
+	os_mutex_lock(&p->jobs.mutex);
+	for (size_t i = 0; i < job_count; i++) {
+		struct p_job *job = jobs[i];
+		if (job->done) {
+			continue;
+		}
+
+		P_WARN(p, "'%s' did not finish within %" PRIu64 "ms, ignoring it",
+		       job->xb != NULL ? job->xb->identifier : job->xap->name, timeout_ns / U_TIME_1MS_IN_NS);
+
+		job->abandoned = true;
+		U_ARRAY_REALLOC_OR_FREE(p->jobs.abandoned, struct p_job *, p->jobs.abandoned_count + 1);
+		p->jobs.abandoned[p->jobs.abandoned_count++] = job;
+		jobs[i] = NULL;
+	}
+	os_mutex_unlock(&p->jobs.mutex);
+
+	// The finished ones have returned or are about to.
+	for (size_t i = 0; i < job_count; i++) {
+		if (jobs[i] != NULL && jobs[i]->threaded) {
+			os_thread_join(&jobs[i]->thread);
+			os_thread_destroy(&jobs[i]->thread);
+		}
+	}
+}
+
+static void
+teardown_jobs(struct prober *p)
+{
+	for (size_t i = 0; i < p->jobs.abandoned_count; i++) {
+		struct p_job *job = p->jobs.abandoned[i];
+
+		P_WARN(p, "Waiting for '%s' to finish", job->xb != NULL ? job->xb->identifier : job->xap->name);
+		os_thread_join(&job->thread);
+		os_thread_destroy(&job->thread);
+		free(job);
+	}
+
+	free(p->jobs.abandoned);
+	p->jobs.abandoned = NULL;
+	p->jobs.abandoned_count = 0;
+}
+
+
+/*
+ *
+ * Device adding.
+ *
+ */
+
+static void
+add_from_device(struct prober *p,
+                struct xrt_prober_device **dev_list,
+                size_t index,
+                struct xrt_device **xdevs,
+                size_t xdev_count,
+                bool *have_hmd)
+{
+	struct prober_device *pdev = &p->devices[index];
+
+	// Loop over all entries that might match the device.
+	for (size_t k = 0; k < p->num_entries; k++) {
+		struct xrt_prober_entry *entry = p->entries[k];
+		if (pdev->base.vendor_id != entry->vendor_id || pdev->base.product_id != entry->product_id) {
+			continue;
+		}
+
+		bool skip = false;
+		for (size_t disabled = 0; disabled < p->num_disabled_drivers; disabled++) {
+			if (strcmp(entry->driver_name, p->disabled_drivers[disabled]) == 0) {
+				P_INFO(p, "Skipping disabled driver %s", entry->driver_name);
+				skip = true;
+				break;
 			}
+		}
+		if (skip) {
+			continue;
+		}
 
-			struct xrt_device *new_xdevs[XRT_MAX_DEVICES_PER_PROBE] = {NULL};
-			int num_found = entry->found(&p->base, dev_list, p->device_count, i, NULL, &(new_xdevs[0]));
+		struct xrt_device *new_xdevs[XRT_MAX_DEVICES_PER_PROBE] = {NULL};
+		int num_found = entry->found(&p->base, dev_list, p->device_count, index, NULL, &(new_xdevs[0]));
 
-			if (num_found <= 0) {
+		if (num_found <= 0) {
+			continue;
+		}
+		for (int created_idx = 0; created_idx < num_found; ++created_idx) {
+			if (new_xdevs[created_idx] == NULL) {
+				P_DEBUG(p,
+				        "Leaving device creation loop "
+				        "early: found function reported %i "
+				        "created, but only %i non-null",
+				        num_found, created_idx);
 				continue;
 			}
-			for (int created_idx = 0; created_idx < num_found; ++created_idx) {
-				if (new_xdevs[created_idx] == NULL) {
-					P_DEBUG(p,
-					        "Leaving device creation loop "
-					        "early: found function reported %i "
-					        "created, but only %i non-null",
-					        num_found, created_idx);
-					continue;
-				}
-				handle_found_device(p, xdevs, xdev_count, have_hmd, new_xdevs[created_idx]);
-			}
+			handle_found_device(p, xdevs, xdev_count, have_hmd, new_xdevs[created_idx]);
 		}
 	}
+}
+
+static void
+add_from_devices(struct prober *p, struct xrt_device **xdevs, size_t xdev_count, bool *have_hmd)
+{
+	struct xrt_prober_device **dev_list = NULL;
+	size_t dev_count = 0;
+	xrt_result_t xret;
+
+	xret = xrt_prober_lock_list(&p->base, &dev_list, &dev_count);
+	if (xret != XRT_SUCCESS) {
+		P_ERROR(p, "Failed to lock list!");
+		return;
+	}
+
+	for (size_t i = 0; i < p->device_count; i++) {
+		add_from_device(p, dev_list, i, xdevs, xdev_count, have_hmd);
+	}
 
 	xret = xrt_prober_unlock_list(&p->base, &dev_list);
 	if (xret != XRT_SUCCESS) {
@@ -715,6 +1012,17 @@ add_from_devices(struct prober *p, struct xrt_device **xdevs, size_t xdev_count,
 static void
 add_from_auto_probers(struct prober *p, struct xrt_device **xdevs, size_t xdev_count, bool *have_hmd)
 {
+	struct p_job *jobs[XRT_MAX_AUTO_PROBERS] = {NULL};
+	size_t job_count = 0;
+
+	/*
+	 * If we have found a HMD, tell the auto probers not to open
+	 * any more HMDs. This is mostly to stop OpenHMD and Monado
+	 * fighting over devices. They all run at the same time, so an
+	 * HMD found by one of them is only caught when merging below.
+	 */
+	bool no_hmds = *have_hmd;
+
 	for (int i = 0; i < XRT_MAX_AUTO_PROBERS && p->auto_probers[i]; i++) {
 
 		bool skip = false;
@@ -729,31 +1037,36 @@ add_from_auto_probers(struct prober *p, struct xrt_device **xdevs, size_t xdev_c
 			continue;
 		}
 
-		/*
-		 * If we have found a HMD, tell the auto probers not to open
-		 * any more HMDs. This is mostly to stop OpenHMD and Monado
-		 * fighting over devices.
-		 */
-		bool no_hmds = *have_hmd;
+		struct p_job *job = U_TYPED_CALLOC(struct p_job);
+		job->p = p;
+		job->xap = p->auto_probers[i];
+		job->no_hmds = no_hmds;
+		jobs[job_count++] = job;
+	}
 
-		struct xrt_device *new_xdevs[XRT_MAX_DEVICES_PER_PROBE] = {NULL};
-		int num_found =
-		    p->auto_probers[i]->lelo_dallas_autoprobe(p->auto_probers[i], NULL, no_hmds, &p->base, new_xdevs);
+	run_jobs(p, jobs, job_count);
 
-		if (num_found <= 0) {
-			continue;
+	// Merged in auto prober order, whichever finished first.
+	for (size_t i = 0; i < job_count; i++) {
+		struct p_job *job = jobs[i];
+		if (job == NULL) {
+			continue; // Timed out.
 		}
 
+		int num_found = job->num_found;
+
 		for (int created_idx = 0; created_idx < num_found; ++created_idx) {
-			if (new_xdevs[created_idx] == NULL) {
+			if (job->xdevs[created_idx] == NULL) {
 				P_DEBUG(p,
 				        "Leaving device creation loop early: %s autoprobe function reported %i "
 				        "created, but only %i non-null",
-				        p->auto_probers[i]->name, num_found, created_idx);
+				        job->xap->name, num_found, created_idx);
 				continue;
 			}
-			handle_found_device(p, xdevs, xdev_count, have_hmd, new_xdevs[created_idx]);
+			handle_found_device(p, xdevs, xdev_count, have_hmd, job->xdevs[created_idx]);
 		}
+
+		free(job);
 	}
 }
 
@@ -869,19 +1182,32 @@ p_probe(struct xrt_prober *xp)
 	struct prober *p = (struct prober *)xp;
 	XRT_MAYBE_UNUSED int ret = 0;
 
-	if (p->list_locked) {
+	os_mutex_lock(&p->jobs.mutex);
+	bool locked = p->list_lock_count > 0;
+	os_mutex_unlock(&p->jobs.mutex);
+
+	if (locked) {
 		return XRT_ERROR_PROBER_LIST_LOCKED;
 	}
 
 	// Free old list first.
 	teardown_devices(p);
 
+	XRT_MAYBE_UNUSED uint64_t now_ns = os_monotonic_get_ns();
+	XRT_MAYBE_UNUSED uint64_t then_ns = now_ns;
+
+	p->timing.probe_count++;
+
 #ifdef XRT_HAVE_LIBUDEV
 	ret = p_udev_probe(p);
 	if (ret != 0) {
 		P_ERROR(p, "Failed to enumerate udev devices\n");
 		return XRT_ERROR_PROBING_FAILED;
 	}
+
+	then_ns = now_ns;
+	now_ns = os_monotonic_get_ns();
+	p->timing.udev_ns = now_ns - then_ns;
 #endif
 
 #ifdef XRT_HAVE_LIBUSB
@@ -890,14 +1216,23 @@ p_probe(struct xrt_prober *xp)
 		P_ERROR(p, "Failed to enumerate libusb devices\n");
 		return XRT_ERROR_PROBING_FAILED;
 	}
+
+	then_ns = now_ns;
+	now_ns = os_monotonic_get_ns();
+	p->timing.libusb_ns = now_ns - then_ns;
 #endif
 
 #ifdef XRT_HAVE_LIBUVC
+	// Must be after libusb, reuses the devices it found.
 	ret = p_libuvc_probe(p);
 	if (ret != 0) {
 		P_ERROR(p, "Failed to enumerate libuvc devices\n");
 		return XRT_ERROR_PROBING_FAILED;
 	}
+
+	then_ns = now_ns;
+	now_ns = os_monotonic_get_ns();
+	p->timing.libuvc_ns = now_ns - then_ns;
 #endif
 
 	return XRT_SUCCESS;
@@ -908,10 +1243,6 @@ p_lock_list(struct xrt_prober *xp, struct xrt_prober_device ***out_devices, size
 {
 	struct prober *p = (struct prober *)xp;
 
-	if (p->list_locked) {
-		return XRT_ERROR_PROBER_LIST_LOCKED;
-	}
-
 	assert(out_devices != NULL);
 	assert(*out_devices == NULL);
 
@@ -921,7 +1252,10 @@ p_lock_list(struct xrt_prober *xp, struct xrt_prober_device ***out_devices, size
 		dev_list[i] = &p->devices[i].base;
 	}
 
-	p->list_locked = true;
+	// Builders estimating in parallel may all hold it at the same time.
+	os_mutex_lock(&p->jobs.mutex);
+	p->list_lock_count++;
+	os_mutex_unlock(&p->jobs.mutex);
 
 	*out_devices = dev_list;
 	*out_device_count = p->device_count;
@@ -934,19 +1268,110 @@ p_unlock_list(struct xrt_prober *xp, struct xrt_prober_device ***devices)
 {
 	struct prober *p = (struct prober *)xp;
 
-	if (!p->list_locked) {
+	os_mutex_lock(&p->jobs.mutex);
+	bool locked = p->list_lock_count > 0;
+	if (locked) {
+		p->list_lock_count--;
+	}
+	os_mutex_unlock(&p->jobs.mutex);
+
+	if (!locked) {
 		return XRT_ERROR_PROBER_LIST_NOT_LOCKED;
 	}
 
 	assert(devices != NULL);
 
-	p->list_locked = false;
 	free(*devices);
 	*devices = NULL;
 
 	return XRT_SUCCESS;
 }
 
+static xrt_result_t
+p_poll_hotplug(struct xrt_prober *xp, struct xrt_device **out_xdevs, uint32_t xdev_capacity, uint32_t *out_xdev_count)
+{
+	XRT_TRACE_MARKER();
+
+	struct prober *p = (struct prober *)xp;
+	uint64_t now_ns = os_monotonic_get_ns();
+
+	*out_xdev_count = 0;
+	for (uint32_t i = 0; i < xdev_capacity; i++) {
+		out_xdevs[i] = NULL;
+	}
+
+#ifdef XRT_HAVE_LIBUDEV
+	if (p_udev_monitor_poll(p)) {
+		p->hotplug.pending = true;
+		p->hotplug.last_event_ns = now_ns;
+	}
+#endif
+
+	if (!p->hotplug.pending) {
+		return XRT_SUCCESS;
+	}
+
+	/*
+	 * A device shows up as several events, one for each of its hidraw
+	 * and v4l interfaces, wait for them to stop before updating the list.
+	 */
+	uint64_t settle_ns = (uint64_t)debug_get_num_option_hotplug_settle_ms() * U_TIME_1MS_IN_NS;
+	if (now_ns - p->hotplug.last_event_ns < settle_ns) {
+		return XRT_SUCCESS;
+	}
+
+	// Remember what was there before, so only the new devices are opened.
+	size_t old_count = p->device_count;
+	struct p_device_key *old_keys = U_TYPED_ARRAY_CALLOC(struct p_device_key, old_count);
+	for (size_t i = 0; i < old_count; i++) {
+		get_device_key(&p->devices[i], &old_keys[i]);
+	}
+
+	// Stays pending if the list is locked, tried again on the next poll.
+	xrt_result_t xret = p_probe(xp);
+	if (xret != XRT_SUCCESS) {
+		free(old_keys);
+		return xret;
+	}
+
+	p->hotplug.pending = false;
+
+	struct xrt_prober_device **dev_list = NULL;
+	size_t dev_count = 0;
+
+	xret = xrt_prober_lock_list(xp, &dev_list, &dev_count);
+	if (xret != XRT_SUCCESS) {
+		free(old_keys);
+		return xret;
+	}
+
+	// The system already has a HMD, any new ones are closed.
+	bool have_hmd = true;
+
+	for (size_t i = 0; i < p->device_count; i++) {
+		if (has_device_key(old_keys, old_count, &p->devices[i])) {
+			continue;
+		}
+
+		P_INFO(p, "New device %04x:%04x", p->devices[i].base.vendor_id, p->devices[i].base.product_id);
+		add_from_device(p, dev_list, i, out_xdevs, xdev_capacity, &have_hmd);
+	}
+
+	xrt_prober_unlock_list(xp, &dev_list);
+	free(old_keys);
+
+	uint32_t count = 0;
+	while (count < xdev_capacity && out_xdevs[count] != NULL) {
+		count++;
+	}
+
+	P_DEBUG(p, "Hotplug: %zu devices before, %zu now, opened %u", old_count, p->device_count, count);
+
+	*out_xdev_count = count;
+
+	return XRT_SUCCESS;
+}
+
 static int
 p_dump(struct xrt_prober *xp)
 {
@@ -1012,8 +1437,19 @@ p_create_system(struct xrt_prober *xp, struct xrt_system_devices **out_xsysd, st
 	 * Estimate.
 	 */
 
-	//! @todo Improve estimation selection logic.
-	if (select == NULL) {
+	uint64_t estimate_start_ns = os_monotonic_get_ns();
+
+	/*
+	 * Estimating can touch the hardware, for instance to read string
+	 * descriptors, so only do it once per builder for both passes below.
+	 */
+	struct xrt_builder_estimate *estimates = NULL;
+	if (select == NULL && p->builder_count > 0) {
+		estimates = U_TYPED_ARRAY_CALLOC(struct xrt_builder_estimate, p->builder_count);
+		struct p_job **jobs = U_TYPED_ARRAY_CALLOC(struct p_job *, p->builder_count);
+		size_t *job_builder = U_TYPED_ARRAY_CALLOC(size_t, p->builder_count);
+		size_t job_count = 0;
+
 		for (size_t i = 0; i < p->builder_count; i++) {
 			struct xrt_builder *xb = p->builders[i];
 
@@ -1021,11 +1457,34 @@ p_create_system(struct xrt_prober *xp, struct xrt_system_devices **out_xsysd, st
 				continue;
 			}
 
-			struct xrt_builder_estimate estimate = {0};
-			xrt_builder_estimate_system(xb, p->json.root, xp, &estimate);
+			struct p_job *job = U_TYPED_CALLOC(struct p_job);
+			job->p = p;
+			job->xb = xb;
+			job_builder[job_count] = i;
+			jobs[job_count++] = job;
+		}
+
+		// All builders estimate at the same time, ones that time out are left as not able to do anything.
+		run_jobs(p, jobs, job_count);
+
+		for (size_t i = 0; i < job_count; i++) {
+			if (jobs[i] != NULL) {
+				estimates[job_builder[i]] = jobs[i]->estimate;
+				free(jobs[i]);
+			}
+		}
+
+		free(job_builder);
+		free(jobs);
+	}
 
-			if (estimate.certain.head) {
-				select = xb;
+	uint64_t estimate_ns = os_monotonic_get_ns() - estimate_start_ns;
+
+	//! @todo Improve estimation selection logic.
+	if (select == NULL) {
+		for (size_t i = 0; i < p->builder_count; i++) {
+			if (estimates[i].certain.head) {
+				select = p->builders[i];
 				break;
 			}
 		}
@@ -1039,17 +1498,8 @@ p_create_system(struct xrt_prober *xp, struct xrt_system_devices **out_xsysd, st
 
 	if (select == NULL) {
 		for (size_t i = 0; i < p->builder_count; i++) {
-			struct xrt_builder *xb = p->builders[i];
-
-			if (xb->exclude_from_automatic_discovery) {
-				continue;
-			}
-
-			struct xrt_builder_estimate estimate = {0};
-			xrt_builder_estimate_system(xb, p->json.root, xp, &estimate);
-
-			if (estimate.maybe.head) {
-				select = xb;
+			if (estimates[i].maybe.head) {
+				select = p->builders[i];
 				break;
 			}
 		}
@@ -1061,9 +1511,16 @@ p_create_system(struct xrt_prober *xp, struct xrt_system_devices **out_xsysd, st
 		}
 	}
 
+	free(estimates);
+	estimates = NULL;
+
+	uint64_t open_ns = 0;
 	if (select != NULL) {
 		u_pp(dg, "\n\tUsing builder %s: %s", select->identifier, select->name);
+
+		uint64_t open_start_ns = os_monotonic_get_ns();
 		xret = xrt_builder_open_system(select, p->json.root, xp, out_xsysd, out_xso);
+		open_ns = os_monotonic_get_ns() - open_start_ns;
 
 		if (xret == XRT_SUCCESS) {
 			print_system_devices(dg, *out_xsysd);
@@ -1073,6 +1530,26 @@ p_create_system(struct xrt_prober *xp, struct xrt_system_devices **out_xsysd, st
 		u_pp_xrt_result(dg, xret);
 	}
 
+
+	/*
+	 * Timing.
+	 */
+
+	u_pp(dg, "\n\tTiming:");
+	u_pp(dg, "\n\t\tinit: %.2fms", time_ns_to_ms_f(p->timing.init_ns));
+	u_pp(dg, "\n\t\tprobes: %u", p->timing.probe_count);
+#ifdef XRT_HAVE_LIBUDEV
+	u_pp(dg, "\n\t\tudev: %.2fms", time_ns_to_ms_f(p->timing.udev_ns));
+#endif
+#ifdef XRT_HAVE_LIBUSB
+	u_pp(dg, "\n\t\tlibusb: %.2fms", time_ns_to_ms_f(p->timing.libusb_ns));
+#endif
+#ifdef XRT_HAVE_LIBUVC
+	u_pp(dg, "\n\t\tlibuvc: %.2fms", time_ns_to_ms_f(p->timing.libuvc_ns));
+#endif
+	u_pp(dg, "\n\t\testimate: %.2fms", time_ns_to_ms_f(estimate_ns));
+	u_pp(dg, "\n\t\topen: %.2fms", time_ns_to_ms_f(open_ns));
+
 	P_INFO(p, "%s", sink.buffer);
 
 	return xret;
@@ -15,6 +15,8 @@
 #include "xrt/xrt_prober.h"
 #include "xrt/xrt_settings.h"
 
+#include "os/os_threading.h"
+
 #include "util/u_logging.h"
 #include "util/u_config_json.h"
 
@@ -22,6 +24,11 @@
 #include <libusb.h>
 #endif
 
+#ifdef XRT_HAVE_LIBUDEV
+struct udev;
+struct udev_monitor;
+#endif
+
 #ifdef XRT_HAVE_LIBUVC
 #include <libuvc/libuvc.h>
 #endif
@@ -139,9 +146,27 @@ struct prober
 	size_t builder_count;
 
 	/*!
-	 * Has the list been locked.
+	 * How many times the list is locked, builders estimating in parallel
+	 * lock it at the same time. Protected by the jobs mutex.
 	 */
-	bool list_locked;
+	uint32_t list_lock_count;
+
+	/*!
+	 * Builder estimates and auto probers run on threads of their own, so
+	 * ones blocking on hardware don't hold up the others.
+	 */
+	struct
+	{
+		//! Protects the state of the jobs and @ref list_lock_count.
+		struct os_mutex mutex;
+
+		//! Released by every job as it finishes.
+		struct os_semaphore done_sem;
+
+		//! Jobs that timed out, joined and freed on teardown.
+		struct p_job **abandoned;
+		size_t abandoned_count;
+	} jobs;
 
 #ifdef XRT_HAVE_LIBUSB
 	struct
@@ -161,6 +186,29 @@ struct prober
 	} uvc;
 #endif
 
+#ifdef XRT_HAVE_LIBUDEV
+	struct
+	{
+		struct udev *ctx;
+
+		//! Hotplug events of the subsystems we enumerate, NULL if disabled.
+		struct udev_monitor *monitor;
+	} udev;
+#endif
+
+	/*!
+	 * State for xrt_prober::poll_hotplug, only touched by the thread
+	 * polling for hotplug events.
+	 */
+	struct
+	{
+		//! Devices were added or removed since the list was last updated.
+		bool pending;
+
+		//! When the last event was seen, the list is updated once they settle.
+		uint64_t last_event_ns;
+	} hotplug;
+
 
 	struct xrt_auto_prober *auto_probers[XRT_MAX_AUTO_PROBERS];
 
@@ -174,6 +222,21 @@ struct prober
 	size_t num_disabled_drivers;
 	char **disabled_drivers;
 
+	/*!
+	 * Time spent in the startup stages, the probe stages are from the
+	 * last call to xrt_prober::probe. Printed with the system creation.
+	 */
+	struct
+	{
+		uint64_t init_ns;
+		uint64_t udev_ns;
+		uint64_t libusb_ns;
+		uint64_t libuvc_ns;
+
+		//! Number of times xrt_prober::probe has been called.
+		uint32_t probe_count;
+	} timing;
+
 	enum u_logging_level log_level;
 };
 
@@ -205,6 +268,14 @@ p_dev_get_usb_dev(struct prober *p,
                   uint16_t product_id,
                   struct prober_device **out_pdev);
 
+/*!
+ * Find an already probed USB @ref prober_device, returns NULL if not found.
+ *
+ * @public @memberof prober
+ */
+struct prober_device *
+p_dev_find_usb_dev(struct prober *p, uint16_t bus, uint16_t addr);
+
 /*!
  * Get or create a @ref prober_device from the device.
  *
@@ -326,6 +397,29 @@ p_libuvc_probe(struct prober *p);
  */
 int
 p_udev_probe(struct prober *p);
+
+/*!
+ * Starts listening for hotplug events of the devices @ref p_udev_probe finds.
+ *
+ * @private @memberof prober
+ */
+int
+p_udev_monitor_init(struct prober *p);
+
+/*!
+ * @private @memberof prober
+ */
+void
+p_udev_monitor_teardown(struct prober *p);
+
+/*!
+ * Drains the queued hotplug events without blocking, returns true if any
+ * device was added or removed.
+ *
+ * @private @memberof prober
+ */
+bool
+p_udev_monitor_poll(struct prober *p);
 /*!
  * @}
  */
@@ -17,6 +17,8 @@
 
 #ifdef XRT_HAVE_OPENCV
 #include "tracking/t_tracking.h"
+#include "util/u_debug.h"
+DEBUG_GET_ONCE_BOOL_OPTION(psmv_hsv_blobs, "PSMV_HSV_BLOBS", false)
 #endif
 
 #include "util/u_var.h"
@@ -168,12 +170,19 @@ p_factory_ensure_frameserver(struct p_factory *fact)
 
 	struct xrt_frame_sink *xsink = NULL;
 	struct xrt_frame_sink *xsinks[4] = {0};
+	struct t_hsv_blob_sink *blob_sinks[4] = {0};
 
 	// We create the two psmv trackers up front, but don't start them.
 #if defined(XRT_BUILD_DRIVER_PSMV)
 	struct xrt_colour_rgb_f32 rgb[2] = {{1.f, 0.f, 0.f}, {1.f, 0.f, 1.f}};
-	t_psmv_create(&fact->xfctx, &rgb[0], fact->data, &fact->xtmv[0], &xsinks[0]);
-	t_psmv_create(&fact->xfctx, &rgb[1], fact->data, &fact->xtmv[1], &xsinks[1]);
+
+	if (debug_get_bool_option_psmv_hsv_blobs()) {
+		// Let the filter find the blobs, one tracker handles both controllers.
+		t_psmv_create_multi(&fact->xfctx, rgb, 2, fact->data, fact->xtmv, blob_sinks);
+	} else {
+		t_psmv_create(&fact->xfctx, &rgb[0], fact->data, &fact->xtmv[0], &xsinks[0]);
+		t_psmv_create(&fact->xfctx, &rgb[1], fact->data, &fact->xtmv[1], &xsinks[1]);
+	}
 #endif
 #if defined(XRT_BUILD_DRIVER_PSVR)
 	t_psvr_create(&fact->xfctx, fact->data, &fact->xtvr, &xsinks[2]);
@@ -186,7 +195,7 @@ p_factory_ensure_frameserver(struct p_factory *fact)
 
 	// We create the default multi-channel hsv filter.
 	struct t_hsv_filter_params params = T_HSV_DEFAULT_PARAMS();
-	t_hsv_filter_create(&fact->xfctx, &params, xsinks, &xsink);
+	t_hsv_filter_create_with_blobs(&fact->xfctx, &params, xsinks, blob_sinks, &xsink);
 
 	// The filter only supports yuv or yuyv formats.
 	u_sink_create_to_yuv_or_yuyv(&fact->xfctx, xsink, &xsink);
@@ -138,6 +138,76 @@ p_udev_probe(struct prober *p)
 	return 0;
 }
 
+int
+p_udev_monitor_init(struct prober *p)
+{
+	p->udev.ctx = udev_new();
+	if (p->udev.ctx == NULL) {
+		P_ERROR(p, "Can't create udev");
+		return -1;
+	}
+
+	p->udev.monitor = udev_monitor_new_from_netlink(p->udev.ctx, "udev");
+	if (p->udev.monitor == NULL) {
+		P_ERROR(p, "Can't create udev monitor");
+		p_udev_monitor_teardown(p);
+		return -1;
+	}
+
+	// The same subsystems as we enumerate.
+	udev_monitor_filter_add_match_subsystem_devtype(p->udev.monitor, "usb", "usb_device");
+	udev_monitor_filter_add_match_subsystem_devtype(p->udev.monitor, "video4linux", NULL);
+	udev_monitor_filter_add_match_subsystem_devtype(p->udev.monitor, "hidraw", NULL);
+
+	if (udev_monitor_enable_receiving(p->udev.monitor) < 0) {
+		P_ERROR(p, "Can't enable receiving on udev monitor");
+		p_udev_monitor_teardown(p);
+		return -1;
+	}
+
+	return 0;
+}
+
+void
+p_udev_monitor_teardown(struct prober *p)
+{
+	if (p->udev.monitor != NULL) {
+		udev_monitor_unref(p->udev.monitor);
+		p->udev.monitor = NULL;
+	}
+
+	if (p->udev.ctx != NULL) {
+		udev_unref(p->udev.ctx);
+		p->udev.ctx = NULL;
+	}
+}
+
+bool
+p_udev_monitor_poll(struct prober *p)
+{
+	struct udev_device *raw_dev = NULL;
+	bool changed = false;
+
+	if (p->udev.monitor == NULL) {
+		return false;
+	}
+
+	// The monitor socket is non-blocking, returns NULL once drained.
+	while ((raw_dev = udev_monitor_receive_device(p->udev.monitor)) != NULL) {
+		const char *action = udev_device_get_action(raw_dev);
+
+		P_DEBUG(p, "hotplug: %s '%s'", action, udev_device_get_syspath(raw_dev));
+
+		if (action != NULL && (strcmp(action, "add") == 0 || strcmp(action, "remove") == 0)) {
+			changed = true;
+		}
+
+		udev_device_unref(raw_dev);
+	}
+
+	return changed;
+}
+
 
 /*
  *
@@ -11,6 +11,7 @@
  * @ingroup st_ovrd
  */
 
+#include <atomic>
 #include <cstring>
 #include <thread>
 
@@ -52,6 +53,12 @@ DEBUG_GET_ONCE_BOOL_OPTION(emulate_index_controller, "STEAMVR_EMULATE_INDEX_CONT
 
 DEBUG_GET_ONCE_NUM_OPTION(scale_percentage, "XRT_COMPOSITOR_SCALE_PERCENTAGE", 140)
 
+//! How often the poses of all devices are sent to SteamVR.
+DEBUG_GET_ONCE_NUM_OPTION(pose_update_hz, "STEAMVR_POSE_UPDATE_HZ", 1000)
+
+//! How far ahead of the sample time poses are predicted, SteamVR extrapolates the rest to its photon time.
+DEBUG_GET_ONCE_NUM_OPTION(pose_prediction_ms, "STEAMVR_POSE_PREDICTION_MS", 11)
+
 #define MODELNUM_LEN (XRT_DEVICE_NAME_LEN + 9) // "[Monado] "
 
 #define OPENVR_BONE_COUNT 31
@@ -705,22 +712,16 @@ public:
 		}
 	}
 
+	//! Called by the pose publisher thread, see CServerDriver_Monado::PosePublisherThreadFunction.
 	void
-	PoseUpdateThreadFunction()
+	PublishPose(timepoint_ns at_ns, double time_offset_s)
 	{
-		ovrd_log("Starting controller pose update thread for %s\n", m_xdev->str);
-
-		while (m_poseUpdating) {
-			//! @todo figure out the best pose update rate
-			std::this_thread::sleep_for(std::chrono::milliseconds(1));
-
-			if (m_unObjectId != vr::k_unTrackedDeviceIndexInvalid) {
-				vr::VRServerDriverHost()->TrackedDevicePoseUpdated(m_unObjectId, GetPose(),
-				                                                   sizeof(vr::DriverPose_t));
-			}
+		if (!m_poseActive) {
+			return;
 		}
 
-		ovrd_log("Stopping controller pose update thread for %s\n", m_xdev->str);
+		vr::VRServerDriverHost()->TrackedDevicePoseUpdated(m_unObjectId, GetPoseAt(at_ns, time_offset_s),
+		                                                   sizeof(vr::DriverPose_t));
 	}
 
 	vr::EVRInitError
@@ -800,11 +801,7 @@ public:
 
 		ovrd_log("Controller %d activated\n", m_unObjectId);
 
-		m_poseUpdateThread = new std::thread(&CDeviceDriver_Monado_Controller::PoseUpdateThreadFunction, this);
-		if (!m_poseUpdateThread) {
-			ovrd_log("Unable to create pose updated thread for %s\n", m_xdev->str);
-			return vr::VRInitError_Driver_Failed;
-		}
+		m_poseActive = true;
 
 		return vr::VRInitError_None;
 	}
@@ -813,8 +810,7 @@ public:
 	Deactivate()
 	{
 		ovrd_log("deactivate controller\n");
-		m_poseUpdating = false;
-		m_poseUpdateThread->join();
+		m_poseActive = false;
 		m_unObjectId = vr::k_unTrackedDeviceIndexInvalid;
 	}
 
@@ -845,7 +841,14 @@ public:
 	GetPose()
 	{
 		// monado predicts pose "now", see xrt_device_get_tracked_pose
-		m_pose.poseTimeOffset = 0;
+		return GetPoseAt(os_monotonic_get_ns(), 0);
+	}
+
+	//! Pose predicted to @p at_ns, which is @p time_offset_s seconds from now.
+	vr::DriverPose_t
+	GetPoseAt(timepoint_ns at_ns, double time_offset_s)
+	{
+		m_pose.poseTimeOffset = time_offset_s;
 
 		m_pose.poseIsValid = true;
 		m_pose.result = vr::TrackingResult_Running_OK;
@@ -873,10 +876,8 @@ public:
 			grip_name = XRT_INPUT_GENERIC_HEAD_POSE; // ???
 		}
 
-		timepoint_ns now_ns = os_monotonic_get_ns();
-
 		struct xrt_space_relation rel;
-		xrt_device_get_tracked_pose(m_xdev, grip_name, now_ns, &rel);
+		xrt_device_get_tracked_pose(m_xdev, grip_name, at_ns, &rel);
 
 		struct xrt_pose *offset = &m_xdev->tracking_origin->offset;
 
@@ -1041,8 +1042,8 @@ private:
 
 	std::string m_input_profile;
 
-	bool m_poseUpdating = true;
-	std::thread *m_poseUpdateThread = NULL;
+	//! Set between Activate and Deactivate, read by the pose publisher thread.
+	std::atomic<bool> m_poseActive{false};
 };
 
 /*
@@ -1100,6 +1101,10 @@ public:
 	virtual void DebugRequest(const char *pchRequest, char *pchResponseBuffer, uint32_t unResponseBufferSize);
 	virtual vr::DriverPose_t GetPose();
 
+	// Pose publishing, see CServerDriver_Monado::PosePublisherThreadFunction.
+	void PublishPose(timepoint_ns at_ns, double time_offset_s);
+	vr::DriverPose_t GetPoseAt(timepoint_ns at_ns, double time_offset_s);
+
 	// IVRDisplayComponent
 	virtual void GetWindowBounds(int32_t *pnX, int32_t *pnY, uint32_t *pnWidth, uint32_t *pnHeight);
 	virtual bool IsDisplayOnDesktop();
@@ -1126,9 +1131,8 @@ private:
 	struct xrt_fov m_fovs[2];
 	struct xrt_pose m_view_pose[2];
 
-	bool m_poseUpdating = true;
-	std::thread *m_poseUpdateThread = NULL;
-	virtual void PoseUpdateThreadFunction();
+	//! Set between Activate and Deactivate, read by the pose publisher thread.
+	std::atomic<bool> m_poseActive{false};
 
 	// clang-format on
 };
@@ -1153,17 +1157,14 @@ create_translation_rotation_matrix(struct xrt_pose *pose, struct vr::HmdMatrix34
 }
 
 void
-CDeviceDriver_Monado::PoseUpdateThreadFunction()
+CDeviceDriver_Monado::PublishPose(timepoint_ns at_ns, double time_offset_s)
 {
-	ovrd_log("Starting HMD pose update thread\n");
-
-	while (m_poseUpdating) {
-		//! @todo figure out the best pose update rate
-		std::this_thread::sleep_for(std::chrono::milliseconds(1));
-		vr::VRServerDriverHost()->TrackedDevicePoseUpdated(m_trackedDeviceIndex, GetPose(),
-		                                                   sizeof(vr::DriverPose_t));
+	if (!m_poseActive) {
+		return;
 	}
-	ovrd_log("Stopping HMD pose update thread\n");
+
+	vr::VRServerDriverHost()->TrackedDevicePoseUpdated(m_trackedDeviceIndex, GetPoseAt(at_ns, time_offset_s),
+	                                                   sizeof(vr::DriverPose_t));
 }
 
 vr::EVRInitError
@@ -1200,12 +1201,7 @@ CDeviceDriver_Monado::Activate(vr::TrackedDeviceIndex_t unObjectId)
 
 	vr::VRServerDriverHost()->SetDisplayEyeToHead(m_trackedDeviceIndex, left, right);
 
-
-	m_poseUpdateThread = new std::thread(&CDeviceDriver_Monado::PoseUpdateThreadFunction, this);
-	if (!m_poseUpdateThread) {
-		ovrd_log("Unable to create pose updated thread for %s\n", m_xdev->str);
-		return vr::VRInitError_Driver_Failed;
-	}
+	m_poseActive = true;
 
 	return vr::VRInitError_None;
 }
@@ -1213,8 +1209,7 @@ CDeviceDriver_Monado::Activate(vr::TrackedDeviceIndex_t unObjectId)
 void
 CDeviceDriver_Monado::Deactivate()
 {
-	m_poseUpdating = false;
-	m_poseUpdateThread->join();
+	m_poseActive = false;
 	ovrd_log("Deactivate\n");
 }
 
@@ -1256,10 +1251,15 @@ HmdQuaternion_Init(double w, double x, double y, double z)
 vr::DriverPose_t
 CDeviceDriver_Monado::GetPose()
 {
+	// monado predicts pose "now", see xrt_device_get_tracked_pose
+	return GetPoseAt(os_monotonic_get_ns(), 0);
+}
 
-	timepoint_ns now_ns = os_monotonic_get_ns();
+vr::DriverPose_t
+CDeviceDriver_Monado::GetPoseAt(timepoint_ns at_ns, double time_offset_s)
+{
 	struct xrt_space_relation rel;
-	xrt_device_get_tracked_pose(m_xdev, XRT_INPUT_GENERIC_HEAD_POSE, now_ns, &rel);
+	xrt_device_get_tracked_pose(m_xdev, XRT_INPUT_GENERIC_HEAD_POSE, at_ns, &rel);
 
 	struct xrt_pose *offset = &m_xdev->tracking_origin->offset;
 
@@ -1270,9 +1270,7 @@ CDeviceDriver_Monado::GetPose()
 
 	vr::DriverPose_t t = {};
 
-
-	// monado predicts pose "now", see xrt_device_get_tracked_pose
-	t.poseTimeOffset = 0;
+	t.poseTimeOffset = time_offset_s;
 
 	//! @todo: Monado head model?
 	t.shouldApplyHeadModel = !m_xdev->position_tracking_supported;
@@ -1438,6 +1436,9 @@ public:
 	// clang-format on
 
 private:
+	void
+	PosePublisherThreadFunction();
+
 	struct xrt_instance *m_xinst = NULL;
 	struct xrt_system_devices *m_xsysd = NULL;
 	struct xrt_space_overseer *m_xso = NULL;
@@ -1446,6 +1447,10 @@ private:
 	CDeviceDriver_Monado *m_MonadoDeviceDriver = NULL;
 	CDeviceDriver_Monado_Controller *m_left = NULL;
 	CDeviceDriver_Monado_Controller *m_right = NULL;
+
+	//! Sends the poses of all devices to SteamVR, one thread for all of them.
+	std::thread m_posePublisherThread;
+	std::atomic<bool> m_posePublishing{false};
 };
 
 CServerDriver_Monado g_serverDriverMonado;
@@ -1507,12 +1512,67 @@ CServerDriver_Monado::Init(vr::IVRDriverContext *pDriverContext)
 		ovrd_log("Added right Controller: %s\n", right_xdev->str);
 	}
 
+	m_posePublishing = true;
+	m_posePublisherThread = std::thread(&CServerDriver_Monado::PosePublisherThreadFunction, this);
+
 	return vr::VRInitError_None;
 }
 
+/*!
+ * All devices are sampled at the same time, predicted a little ahead, and sent
+ * to SteamVR at a fixed rate. The deadlines are absolute so the rate doesn't
+ * drift, and the hybrid sleeper keeps the wake-ups close to them.
+ */
+void
+CServerDriver_Monado::PosePublisherThreadFunction()
+{
+	ovrd_log("Starting pose publisher thread\n");
+
+	int64_t hz = debug_get_num_option_pose_update_hz();
+	timepoint_ns period_ns = U_TIME_1S_IN_NS / (hz > 0 ? hz : 1000);
+	timepoint_ns prediction_ns = debug_get_num_option_pose_prediction_ms() * U_TIME_1MS_IN_NS;
+	double prediction_s = time_ns_to_s(prediction_ns);
+
+	struct os_precise_sleeper sleeper = {};
+	os_precise_sleeper_init_hybrid(&sleeper);
+
+	uint64_t next_ns = os_monotonic_get_ns();
+
+	while (m_posePublishing) {
+		timepoint_ns at_ns = (timepoint_ns)os_monotonic_get_ns() + prediction_ns;
+
+		m_MonadoDeviceDriver->PublishPose(at_ns, prediction_s);
+		if (m_left) {
+			m_left->PublishPose(at_ns, prediction_s);
+		}
+		if (m_right) {
+			m_right->PublishPose(at_ns, prediction_s);
+		}
+
+		next_ns += period_ns;
+
+		// Don't try to catch up after a stall, just continue from now.
+		uint64_t now_ns = os_monotonic_get_ns();
+		if (next_ns < now_ns) {
+			next_ns = now_ns + period_ns;
+		}
+
+		os_precise_sleeper_wait_until(&sleeper, next_ns);
+	}
+
+	os_precise_sleeper_deinit(&sleeper);
+
+	ovrd_log("Stopping pose publisher thread\n");
+}
+
 void
 CServerDriver_Monado::Cleanup()
 {
+	m_posePublishing = false;
+	if (m_posePublisherThread.joinable()) {
+		m_posePublisherThread.join();
+	}
+
 	if (m_MonadoDeviceDriver != NULL) {
 		delete m_MonadoDeviceDriver;
 		m_MonadoDeviceDriver = NULL;
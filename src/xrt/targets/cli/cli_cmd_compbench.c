@@ -0,0 +1,579 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Drives the main compositor headless with synthetic clients and reports frame timings.
+ */
+
+#include "cli_common.h"
+
+#include "xrt/xrt_config_build.h"
+#include "xrt/xrt_config_drivers.h"
+
+#if defined(XRT_MODULE_COMPOSITOR_MAIN) && defined(XRT_BUILD_DRIVER_SIMULATED)
+
+#include "xrt/xrt_compositor.h"
+#include "xrt/xrt_device.h"
+
+#include "os/os_threading.h"
+#include "os/os_time.h"
+
+#include "math/m_api.h"
+
+#include "util/u_misc.h"
+#include "util/u_pacing.h"
+#include "util/u_time.h"
+
+#include "main/comp_main_interface.h"
+
+#include "simulated/simulated_interface.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define P(...) fprintf(stderr, __VA_ARGS__)
+
+//! Layers per client, one stereo projection and the rest quads.
+#define MAX_LAYERS (16)
+
+#define MAX_CLIENTS (8)
+
+
+//! One submitted frame of a client, for the pose-to-render latency.
+struct client_sample
+{
+	//! When the view poses were sampled.
+	uint64_t pose_ns;
+
+	//! When the layers were committed.
+	uint64_t commit_ns;
+};
+
+struct client
+{
+	struct os_thread thread;
+
+	struct xrt_device *xdev;
+	struct xrt_compositor_native *xcn;
+
+	//! Index 0 and 1 are the projection views, the rest are quads.
+	struct xrt_swapchain *xscs[MAX_LAYERS + 1];
+	uint32_t swapchain_count;
+	uint32_t layer_count;
+
+	volatile bool running;
+
+	struct client_sample *samples;
+	uint32_t sample_count;
+	uint32_t max_samples;
+
+	uint64_t frames;
+	uint64_t misses;
+	uint64_t wait_ns_sum;
+	uint64_t wait_ns_max;
+	uint64_t submit_ns_sum;
+	uint64_t submit_ns_max;
+	bool failed;
+};
+
+//! Running sum and maximum of one timing.
+struct timing_stat
+{
+	uint64_t sum_ns;
+	uint64_t max_ns;
+	uint64_t count;
+};
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static void
+stat_add(struct timing_stat *s, uint64_t ns)
+{
+	s->sum_ns += ns;
+	s->max_ns = MAX(s->max_ns, ns);
+	s->count++;
+}
+
+static void
+stat_print(const char *name, const struct timing_stat *s)
+{
+	double mean_ms = s->count > 0 ? time_ns_to_ms_f((int64_t)(s->sum_ns / s->count)) : 0.0;
+	double max_ms = time_ns_to_ms_f((int64_t)s->max_ns);
+
+	P("  %-22s mean %7.3f ms  max %7.3f ms  (%" PRIu64 " samples)\n", name, mean_ms, max_ms, s->count);
+}
+
+static int
+print_help(const char *argv0)
+{
+	P("Usage: %s compbench [clients] [layers] [seconds]\n", argv0);
+	P("\n");
+	P("Runs the main compositor on the offscreen target with a simulated HMD\n");
+	P("wobbling around, and 'clients' native clients (default 1, max %i) each\n", MAX_CLIENTS);
+	P("submitting a stereo projection plus 'layers - 1' quads (default 4, max %i)\n", MAX_LAYERS);
+	P("every frame for 'seconds' (default 10). Then prints the compositor CPU,\n");
+	P("GPU and present timings, the miss rate and the pose-to-render latency.\n");
+	return 1;
+}
+
+static xrt_result_t
+create_swapchain(struct xrt_compositor *xc, uint32_t width, uint32_t height, struct xrt_swapchain **out_xsc)
+{
+	struct xrt_swapchain_create_info info = {
+	    .bits = XRT_SWAPCHAIN_USAGE_COLOR | XRT_SWAPCHAIN_USAGE_SAMPLED,
+	    .format = xc->info.formats[0],
+	    .sample_count = 1,
+	    .width = width,
+	    .height = height,
+	    .face_count = 1,
+	    .array_size = 1,
+	    .mip_count = 1,
+	};
+
+	return xrt_comp_create_swapchain(xc, &info, out_xsc);
+}
+
+static struct xrt_sub_image
+whole_image(struct xrt_swapchain *xsc, uint32_t index, uint32_t width, uint32_t height)
+{
+	struct xrt_sub_image sub = {
+	    .image_index = index,
+	    .rect = {.extent = {.w = (int)width, .h = (int)height}},
+	    .norm_rect = {.w = 1.0f, .h = 1.0f},
+	};
+
+	return sub;
+}
+
+
+/*
+ *
+ * Client.
+ *
+ */
+
+static bool
+client_frame(struct client *c, uint64_t *inout_last_display_ns)
+{
+	struct xrt_compositor *xc = &c->xcn->base;
+	struct xrt_device *xdev = c->xdev;
+	xrt_result_t xret;
+
+	int64_t frame_id = -1;
+	uint64_t display_ns = 0;
+	uint64_t period_ns = 0;
+
+	uint64_t wait_start_ns = os_monotonic_get_ns();
+	xret = xrt_comp_wait_frame(xc, &frame_id, &display_ns, &period_ns);
+	if (xret != XRT_SUCCESS) {
+		return false;
+	}
+	uint64_t begin_ns = os_monotonic_get_ns();
+
+	// A predicted display time that skipped a period means a frame was lost.
+	uint64_t last_display_ns = *inout_last_display_ns;
+	if (last_display_ns != 0 && display_ns > last_display_ns + period_ns + period_ns / 2) {
+		c->misses++;
+	}
+	*inout_last_display_ns = display_ns;
+
+	xret = xrt_comp_begin_frame(xc, frame_id);
+	if (xret != XRT_SUCCESS) {
+		return false;
+	}
+
+	struct xrt_space_relation head_relation;
+	struct xrt_fov fovs[2];
+	struct xrt_pose poses[2];
+	struct xrt_vec3 eye_relation = {0.063f, 0.0f, 0.0f};
+	uint64_t pose_ns = os_monotonic_get_ns();
+	xrt_device_get_view_poses(xdev, &eye_relation, display_ns, 2, &head_relation, fovs, poses);
+
+	uint32_t indices[MAX_LAYERS + 1];
+	for (uint32_t i = 0; i < c->swapchain_count; i++) {
+		xret = xrt_swapchain_acquire_image(c->xscs[i], &indices[i]);
+		if (xret == XRT_SUCCESS) {
+			xret = xrt_swapchain_wait_image(c->xscs[i], U_TIME_1S_IN_NS, indices[i]);
+		}
+		if (xret == XRT_SUCCESS) {
+			xret = xrt_swapchain_release_image(c->xscs[i], indices[i]);
+		}
+		if (xret != XRT_SUCCESS) {
+			return false;
+		}
+	}
+
+	struct xrt_layer_frame_data frame_data = {
+	    .frame_id = frame_id,
+	    .display_time_ns = display_ns,
+	    .env_blend_mode = XRT_BLEND_MODE_OPAQUE,
+	};
+	xrt_comp_layer_begin(xc, &frame_data);
+
+	uint32_t w = xdev->hmd->views[0].display.w_pixels;
+	uint32_t h = xdev->hmd->views[0].display.h_pixels;
+
+	struct xrt_layer_data stereo = {
+	    .type = XRT_LAYER_STEREO_PROJECTION,
+	    .name = XRT_INPUT_GENERIC_HEAD_POSE,
+	    .timestamp = display_ns,
+	    .flags = XRT_LAYER_COMPOSITION_BLEND_TEXTURE_SOURCE_ALPHA_BIT,
+	    .stereo =
+	        {
+	            .l = {.sub = whole_image(c->xscs[0], indices[0], w, h), .fov = fovs[0], .pose = poses[0]},
+	            .r = {.sub = whole_image(c->xscs[1], indices[1], w, h), .fov = fovs[1], .pose = poses[1]},
+	        },
+	};
+	xrt_comp_layer_stereo_projection(xc, xdev, c->xscs[0], c->xscs[1], &stereo);
+
+	// Spread the quads out in front of the user, each a little further away.
+	for (uint32_t i = 2; i < c->swapchain_count; i++) {
+		float n = (float)(i - 2);
+		struct xrt_layer_data quad = {
+		    .type = XRT_LAYER_QUAD,
+		    .name = XRT_INPUT_GENERIC_HEAD_POSE,
+		    .timestamp = display_ns,
+		    .flags = XRT_LAYER_COMPOSITION_BLEND_TEXTURE_SOURCE_ALPHA_BIT,
+		    .quad =
+		        {
+		            .visibility = XRT_LAYER_EYE_VISIBILITY_BOTH,
+		            .sub = whole_image(c->xscs[i], indices[i], 512, 512),
+		            .pose = {.orientation = {0.0f, 0.0f, 0.0f, 1.0f},
+		                     .position = {-0.6f + 0.2f * n, 0.0f, -1.0f - 0.1f * n}},
+		            .size = {0.3f, 0.3f},
+		        },
+		};
+		xrt_comp_layer_quad(xc, xdev, c->xscs[i], &quad);
+	}
+
+	xret = xrt_comp_layer_commit(xc, XRT_GRAPHICS_SYNC_HANDLE_INVALID);
+	if (xret != XRT_SUCCESS) {
+		return false;
+	}
+
+	uint64_t commit_ns = os_monotonic_get_ns();
+
+	c->frames++;
+	c->wait_ns_sum += begin_ns - wait_start_ns;
+	c->wait_ns_max = MAX(c->wait_ns_max, begin_ns - wait_start_ns);
+	c->submit_ns_sum += commit_ns - begin_ns;
+	c->submit_ns_max = MAX(c->submit_ns_max, commit_ns - begin_ns);
+
+	if (c->sample_count < c->max_samples) {
+		c->samples[c->sample_count++] = (struct client_sample){pose_ns, commit_ns};
+	}
+
+	return true;
+}
+
+static void *
+client_thread(void *ptr)
+{
+	struct client *c = (struct client *)ptr;
+	uint64_t last_display_ns = 0;
+
+	while (c->running) {
+		if (!client_frame(c, &last_display_ns)) {
+			c->failed = true;
+			break;
+		}
+
+		// Nothing reacts to the events, just keep the queue from growing.
+		union xrt_compositor_event xce = {0};
+		do {
+			xce.type = XRT_COMPOSITOR_EVENT_NONE;
+			xrt_comp_poll_events(&c->xcn->base, &xce);
+		} while (xce.type != XRT_COMPOSITOR_EVENT_NONE);
+	}
+
+	return NULL;
+}
+
+static xrt_result_t
+client_init(struct client *c,
+            struct xrt_system_compositor *xsysc,
+            struct xrt_device *xdev,
+            uint32_t index,
+            uint32_t layer_count,
+            uint32_t max_samples)
+{
+	xrt_result_t xret;
+
+	c->xdev = xdev;
+	c->layer_count = layer_count;
+	c->swapchain_count = layer_count + 1;
+	c->max_samples = max_samples;
+	c->samples = U_TYPED_ARRAY_CALLOC(struct client_sample, max_samples);
+
+	struct xrt_session_info xsi = {
+	    .is_overlay = index > 0,
+	    .z_order = index,
+	};
+
+	xret = xrt_syscomp_create_native_compositor(xsysc, &xsi, &c->xcn);
+	if (xret != XRT_SUCCESS) {
+		P("Failed to create native compositor %u!\n", index);
+		return xret;
+	}
+
+	struct xrt_compositor *xc = &c->xcn->base;
+
+	uint32_t w = xdev->hmd->views[0].display.w_pixels;
+	uint32_t h = xdev->hmd->views[0].display.h_pixels;
+
+	for (uint32_t i = 0; i < c->swapchain_count && xret == XRT_SUCCESS; i++) {
+		bool view = i < 2;
+		xret = create_swapchain(xc, view ? w : 512, view ? h : 512, &c->xscs[i]);
+	}
+	if (xret != XRT_SUCCESS) {
+		P("Failed to create swapchains for client %u!\n", index);
+		return xret;
+	}
+
+	struct xrt_begin_session_info begin_info = {
+	    .view_type = XRT_VIEW_TYPE_STEREO,
+	};
+
+	xret = xrt_comp_begin_session(xc, &begin_info);
+	if (xret != XRT_SUCCESS) {
+		P("Failed to begin session %u!\n", index);
+		return xret;
+	}
+
+	xrt_syscomp_set_state(xsysc, xc, true, true);
+	xrt_syscomp_set_z_order(xsysc, xc, (int64_t)index);
+
+	return XRT_SUCCESS;
+}
+
+static void
+client_fini(struct client *c)
+{
+	if (c->xcn != NULL) {
+		xrt_comp_end_session(&c->xcn->base);
+	}
+
+	for (uint32_t i = 0; i < c->swapchain_count; i++) {
+		xrt_swapchain_reference(&c->xscs[i], NULL);
+	}
+
+	xrt_comp_native_destroy(&c->xcn);
+	free(c->samples);
+}
+
+
+/*
+ *
+ * Compositor records.
+ *
+ */
+
+//! First record whose CPU work started at or after @p ns, or @p count if none.
+static uint32_t
+find_record(const struct u_pc_frame_record *records, uint32_t count, uint64_t ns)
+{
+	uint32_t lo = 0;
+	uint32_t hi = count;
+
+	while (lo < hi) {
+		uint32_t mid = lo + (hi - lo) / 2;
+		if (records[mid].cpu_begin_ns < ns) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+static uint64_t
+record_done_ns(const struct u_pc_frame_record *r)
+{
+	return (r->flags & U_PC_FRAME_RECORD_GPU_BIT) != 0 ? r->gpu_end_ns : r->cpu_end_ns;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+int
+cli_cmd_compbench(int argc, const char **argv)
+{
+	if (argc > 2 && (strcmp(argv[2], "-h") == 0 || strcmp(argv[2], "--help") == 0)) {
+		return print_help(argv[0]);
+	}
+
+	uint32_t client_count = argc > 2 ? (uint32_t)atoi(argv[2]) : 1;
+	uint32_t layer_count = argc > 3 ? (uint32_t)atoi(argv[3]) : 4;
+	uint32_t seconds = argc > 4 ? (uint32_t)atoi(argv[4]) : 10;
+
+	if (client_count < 1 || client_count > MAX_CLIENTS || layer_count < 1 || layer_count > MAX_LAYERS ||
+	    seconds < 1) {
+		return print_help(argv[0]);
+	}
+
+	// Generous, the fake pacer doesn't go above 144Hz.
+	uint32_t max_frames = seconds * 240;
+
+	struct xrt_pose center = XRT_POSE_IDENTITY;
+	struct xrt_device *xdev = simulated_hmd_create(SIMULATED_MOVEMENT_WOBBLE, &center);
+	if (xdev == NULL) {
+		P("Failed to create the simulated HMD!\n");
+		return 1;
+	}
+
+	// Headless, no display or window system needed.
+	setenv("XRT_COMPOSITOR_FORCE_OFFSCREEN", "true", 0);
+
+	struct xrt_system_compositor *xsysc = NULL;
+	xrt_result_t xret = comp_main_create_system_compositor(xdev, NULL, NULL, &xsysc);
+	if (xret != XRT_SUCCESS) {
+		P("Failed to create the main compositor, is there a usable Vulkan device?\n");
+		xrt_device_destroy(&xdev);
+		return 1;
+	}
+
+	struct client clients[MAX_CLIENTS] = {0};
+	for (uint32_t i = 0; i < client_count && xret == XRT_SUCCESS; i++) {
+		xret = client_init(&clients[i], xsysc, xdev, i, layer_count, max_frames);
+	}
+
+	struct u_pc_frame_record *records = U_TYPED_ARRAY_CALLOC(struct u_pc_frame_record, max_frames);
+	uint32_t record_count = 0;
+
+	if (xret == XRT_SUCCESS) {
+		P("Running %u client(s) with %u layer(s) each for %us.\n", client_count, layer_count, seconds);
+
+		// Skip the records from before the clients started.
+		uint32_t next = 0;
+		struct u_pc_frame_record scratch[U_PC_FRAME_RECORD_COUNT];
+		while (u_pc_frame_records_read(&next, scratch, ARRAY_SIZE(scratch)) > 0) {
+		}
+
+		for (uint32_t i = 0; i < client_count; i++) {
+			clients[i].running = true;
+			os_thread_init(&clients[i].thread);
+			os_thread_start(&clients[i].thread, client_thread, &clients[i]);
+		}
+
+		// The record ring only holds a second or so, keep draining it.
+		uint64_t end_ns = os_monotonic_get_ns() + seconds * U_TIME_1S_IN_NS;
+		while (os_monotonic_get_ns() < end_ns) {
+			os_nanosleep(100 * U_TIME_1MS_IN_NS);
+			record_count += u_pc_frame_records_read(&next, records + record_count, max_frames - record_count);
+		}
+
+		for (uint32_t i = 0; i < client_count; i++) {
+			clients[i].running = false;
+			os_thread_join(&clients[i].thread);
+			os_thread_destroy(&clients[i].thread);
+		}
+	}
+
+	struct timing_stat cpu = {0};
+	struct timing_stat gpu = {0};
+	struct timing_stat present = {0};
+	uint64_t comp_misses = 0;
+
+	for (uint32_t i = 0; i < record_count; i++) {
+		const struct u_pc_frame_record *r = &records[i];
+
+		if ((r->flags & U_PC_FRAME_RECORD_CPU_BIT) != 0) {
+			stat_add(&cpu, r->cpu_end_ns - r->cpu_begin_ns);
+		}
+		if ((r->flags & U_PC_FRAME_RECORD_GPU_BIT) != 0) {
+			stat_add(&gpu, r->gpu_end_ns - r->gpu_start_ns);
+		}
+
+		// How late the work finished compared to the present time it aimed for.
+		uint64_t done_ns = record_done_ns(r);
+		stat_add(&present, done_ns > r->desired_present_time_ns ? done_ns - r->desired_present_time_ns : 0);
+
+		if ((r->flags & U_PC_FRAME_RECORD_MISSED_BIT) != 0) {
+			comp_misses++;
+		}
+	}
+
+	struct timing_stat latency = {0};
+	struct timing_stat wait = {0};
+	struct timing_stat submit = {0};
+	uint64_t client_frames = 0;
+	uint64_t client_misses = 0;
+
+	for (uint32_t i = 0; i < client_count; i++) {
+		struct client *c = &clients[i];
+
+		for (uint32_t k = 0; k < c->sample_count; k++) {
+			uint32_t index = find_record(records, record_count, c->samples[k].commit_ns);
+			if (index < record_count) {
+				stat_add(&latency, record_done_ns(&records[index]) - c->samples[k].pose_ns);
+			}
+		}
+
+		if (c->frames > 0) {
+			wait.sum_ns += c->wait_ns_sum;
+			wait.max_ns = MAX(wait.max_ns, c->wait_ns_max);
+			wait.count += c->frames;
+			submit.sum_ns += c->submit_ns_sum;
+			submit.max_ns = MAX(submit.max_ns, c->submit_ns_max);
+			submit.count += c->frames;
+		}
+
+		client_frames += c->frames;
+		client_misses += c->misses;
+
+		if (c->failed) {
+			P("Client %u stopped early on an error!\n", i);
+		}
+	}
+
+	if (xret == XRT_SUCCESS) {
+		P("Compositor, %u frames, %.1f fps:\n", record_count, (double)record_count / seconds);
+		stat_print("CPU", &cpu);
+		stat_print("GPU", &gpu);
+		stat_print("Late to present", &present);
+		P("  %-22s %" PRIu64 " (%.2f%%)\n", "Missed", comp_misses,
+		  record_count > 0 ? 100.0 * (double)comp_misses / record_count : 0.0);
+
+		P("Clients, %" PRIu64 " frames:\n", client_frames);
+		stat_print("Wait frame", &wait);
+		stat_print("Submit", &submit);
+		P("  %-22s %" PRIu64 " (%.2f%%)\n", "Skipped", client_misses,
+		  client_frames > 0 ? 100.0 * (double)client_misses / client_frames : 0.0);
+		stat_print("Pose to render", &latency);
+	}
+
+	for (uint32_t i = 0; i < client_count; i++) {
+		client_fini(&clients[i]);
+	}
+
+	free(records);
+	xrt_syscomp_destroy(&xsysc);
+	xrt_device_destroy(&xdev);
+
+	return xret == XRT_SUCCESS ? 0 : 1;
+}
+
+#else
+
+#include <stdio.h>
+
+int
+cli_cmd_compbench(int argc, const char **argv)
+{
+	fprintf(stderr, "Not compiled with the main compositor and the simulated driver!\n");
+	return 1;
+}
+
+#endif
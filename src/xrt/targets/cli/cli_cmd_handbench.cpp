@@ -0,0 +1,346 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Replays a recorded dataset through the Mercury hand tracker and reports timings and accuracy.
+ */
+
+#include "cli_common.h"
+
+#include "xrt/xrt_config_build.h"
+#include "xrt/xrt_config_os.h"
+
+#if defined(XRT_MODULE_MERCURY_HANDTRACKING) && !defined(XRT_OS_WINDOWS)
+
+#include "os/os_time.h"
+#include "util/u_frame.h"
+#include "util/u_logging.h"
+#include "math/m_vec3.h"
+#include "tracking/t_dataset_container.h"
+#include "tracking/t_hand_tracking.h"
+#include "tracking/t_tracking.h"
+
+#include "hg_interface.h"
+#include "hg_debug_instrumentation.hpp"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define P(...) fprintf(stderr, __VA_ARGS__)
+#define W(...) U_LOG(U_LOGGING_WARN, __VA_ARGS__)
+
+using xrt::tracking::hand::mercury::hg_frame_timings;
+using xrt::tracking::hand::mercury::t_hand_tracking_sync_mercury_get_last_frame_timings;
+
+
+//! Labelled joint positions of one hand at one timestamp, same space as the tracker output.
+struct hand_label
+{
+	xrt_vec3 joints[XRT_HAND_JOINT_COUNT];
+};
+
+using label_key = std::pair<int64_t, int>;
+
+//! Running sum and maximum of one stage.
+struct stage_stats
+{
+	uint64_t sum_ns = 0;
+	uint64_t max_ns = 0;
+	uint64_t count = 0;
+
+	void
+	add(uint64_t ns)
+	{
+		sum_ns += ns;
+		max_ns = ns > max_ns ? ns : max_ns;
+		count++;
+	}
+
+	void
+	print(const char *name) const
+	{
+		double mean_ms = count > 0 ? (double)sum_ns / (double)count / (double)U_TIME_1MS_IN_NS : 0.0;
+		double max_ms = (double)max_ns / (double)U_TIME_1MS_IN_NS;
+		P("  %-12s mean %8.3f ms  max %8.3f ms  (%" PRIu64 " frames)\n", name, mean_ms, max_ms, count);
+	}
+};
+
+struct hand_stats
+{
+	uint64_t tracked_frames = 0;
+	uint64_t labelled_frames = 0;
+	uint64_t compared_frames = 0;
+	double error_sum_m = 0.0;
+};
+
+/*!
+ * Labels are a CSV file with one hand per line:
+ * `timestamp_ns,hand,x0,y0,z0,...` with hand 0 for left and 1 for right and
+ * the positions of all @ref XRT_HAND_JOINT_COUNT joints in metres. Lines
+ * starting with `#` are skipped.
+ */
+static bool
+load_labels(const char *path, std::map<label_key, hand_label> &out_labels)
+{
+	std::ifstream file(path);
+	if (!file.is_open()) {
+		W("Unable to open labels '%s'", path);
+		return false;
+	}
+
+	std::string line;
+	size_t line_number = 0;
+	while (std::getline(file, line)) {
+		line_number++;
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+
+		std::istringstream ss(line);
+		std::string field;
+		std::vector<std::string> fields;
+		while (std::getline(ss, field, ',')) {
+			fields.push_back(field);
+		}
+
+		if (fields.size() != 2 + XRT_HAND_JOINT_COUNT * 3) {
+			W("Labels '%s' line %zu has %zu fields, expected %d", path, line_number, fields.size(),
+			  2 + XRT_HAND_JOINT_COUNT * 3);
+			return false;
+		}
+
+		int64_t timestamp = strtoll(fields[0].c_str(), nullptr, 10);
+		int hand = atoi(fields[1].c_str());
+		if (hand != 0 && hand != 1) {
+			W("Labels '%s' line %zu has hand %d, expected 0 or 1", path, line_number, hand);
+			return false;
+		}
+
+		hand_label label = {};
+		for (int j = 0; j < XRT_HAND_JOINT_COUNT; j++) {
+			label.joints[j].x = strtof(fields[2 + j * 3 + 0].c_str(), nullptr);
+			label.joints[j].y = strtof(fields[2 + j * 3 + 1].c_str(), nullptr);
+			label.joints[j].z = strtof(fields[2 + j * 3 + 2].c_str(), nullptr);
+		}
+
+		out_labels[label_key(timestamp, hand)] = label;
+	}
+
+	return true;
+}
+
+//! Copies a mapped frame into a frame the tracker may keep references to.
+static bool
+make_frame(const struct t_dataset_frame *df, struct xrt_frame **out_frame)
+{
+	if (df->format != XRT_FORMAT_L8) {
+		W("Only L8 frames are supported, dataset has format %d", df->format);
+		return false;
+	}
+
+	struct xrt_frame *xf = NULL;
+	u_frame_create_one_off(XRT_FORMAT_L8, df->width, df->height, &xf);
+	if (xf == NULL) {
+		return false;
+	}
+
+	for (uint32_t y = 0; y < df->height; y++) {
+		memcpy(xf->data + y * xf->stride, df->data + y * df->stride, df->width);
+	}
+	xf->timestamp = df->timestamp_ns;
+	xf->source_timestamp = df->timestamp_ns;
+
+	*out_frame = xf;
+	return true;
+}
+
+static double
+joint_error(const struct xrt_hand_joint_set *set, const hand_label &label)
+{
+	double sum = 0.0;
+	for (int j = 0; j < XRT_HAND_JOINT_COUNT; j++) {
+		struct xrt_vec3 pos = set->values.hand_joint_set_default[j].relation.pose.position;
+		sum += m_vec3_len(pos - label.joints[j]);
+	}
+	return sum / XRT_HAND_JOINT_COUNT;
+}
+
+static int
+print_help(const char *argv0)
+{
+	P("Usage: %s handbench <dataset" T_DATASET_CONTAINER_EXTENSION "> <calibration.json> <models folder> [labels.csv]\n",
+	  argv0);
+	P("\n");
+	P("Replays the first two cameras of a dataset container through the Mercury\n");
+	P("hand tracker as fast as it can, then prints per-stage timings, throughput\n");
+	P("and, if labels are given, the mean joint error. Tracker options such as\n");
+	P("MERCURY_EXECUTION_PROVIDER are read from the environment as usual.\n");
+	return 1;
+}
+
+int
+cli_cmd_handbench(int argc, const char **argv)
+{
+	if (argc < 5) {
+		return print_help(argv[0]);
+	}
+
+	const char *dataset_path = argv[2];
+	const char *calib_path = argv[3];
+	const char *models_folder = argv[4];
+	const char *labels_path = argc >= 6 ? argv[5] : NULL;
+
+	std::map<label_key, hand_label> labels;
+	if (labels_path != NULL && !load_labels(labels_path, labels)) {
+		return 1;
+	}
+
+	struct t_dataset_reader *reader = NULL;
+	if (!t_dataset_reader_open(dataset_path, &reader)) {
+		W("Unable to open dataset '%s'", dataset_path);
+		return 1;
+	}
+
+	if (t_dataset_reader_get_cam_count(reader) < 2) {
+		W("Dataset '%s' needs two cameras", dataset_path);
+		t_dataset_reader_destroy(&reader);
+		return 1;
+	}
+
+	struct t_stereo_camera_calibration *calib = NULL;
+	if (!t_stereo_camera_calibration_load(calib_path, &calib)) {
+		W("Unable to load calibration '%s'", calib_path);
+		t_dataset_reader_destroy(&reader);
+		return 1;
+	}
+
+	struct t_camera_extra_info extra_camera_info = {};
+	for (int i = 0; i < 2; i++) {
+		extra_camera_info.views[i].boundary_type = HT_IMAGE_BOUNDARY_NONE;
+		extra_camera_info.views[i].camera_orientation = CAMERA_ORIENTATION_0;
+	}
+
+	struct t_hand_tracking_sync *sync =
+	    t_hand_tracking_sync_mercury_create(calib, extra_camera_info, models_folder);
+	t_stereo_camera_calibration_reference(&calib, NULL);
+	if (sync == NULL) {
+		W("Unable to create the hand tracker");
+		t_dataset_reader_destroy(&reader);
+		return 1;
+	}
+
+	size_t frame_count = t_dataset_reader_get_frame_count(reader, 0);
+	size_t right_count = t_dataset_reader_get_frame_count(reader, 1);
+	frame_count = right_count < frame_count ? right_count : frame_count;
+
+	stage_stats detection = {};
+	stage_stats keypoint = {};
+	stage_stats optimizer = {};
+	stage_stats total = {};
+	hand_stats hands[2] = {};
+
+	uint64_t start_ns = os_monotonic_get_ns();
+	size_t processed = 0;
+
+	for (size_t i = 0; i < frame_count; i++) {
+		struct t_dataset_frame left = {};
+		struct t_dataset_frame right = {};
+		if (!t_dataset_reader_get_frame(reader, 0, i, &left) ||
+		    !t_dataset_reader_get_frame(reader, 1, i, &right)) {
+			W("Unable to read frame pair %zu", i);
+			break;
+		}
+
+		struct xrt_frame *frames[2] = {NULL, NULL};
+		if (!make_frame(&left, &frames[0]) || !make_frame(&right, &frames[1])) {
+			xrt_frame_reference(&frames[0], NULL);
+			xrt_frame_reference(&frames[1], NULL);
+			break;
+		}
+
+		struct xrt_hand_joint_set out_hands[2] = {};
+		uint64_t timestamp_ns = 0;
+		t_ht_sync_process(sync, frames[0], frames[1], &out_hands[0], &out_hands[1], &timestamp_ns);
+
+		xrt_frame_reference(&frames[0], NULL);
+		xrt_frame_reference(&frames[1], NULL);
+
+		struct hg_frame_timings timings = {};
+		t_hand_tracking_sync_mercury_get_last_frame_timings(sync, &timings);
+
+		if (timings.ran_detection) {
+			detection.add(timings.detection_ns);
+		}
+		keypoint.add(timings.keypoint_ns);
+		optimizer.add(timings.optimizer_ns);
+		total.add(timings.total_ns);
+		processed++;
+
+		for (int h = 0; h < 2; h++) {
+			auto it = labels.find(label_key(left.timestamp_ns, h));
+			bool labelled = it != labels.end();
+
+			hands[h].tracked_frames += out_hands[h].is_active ? 1 : 0;
+			hands[h].labelled_frames += labelled ? 1 : 0;
+
+			if (labelled && out_hands[h].is_active) {
+				hands[h].error_sum_m += joint_error(&out_hands[h], it->second);
+				hands[h].compared_frames++;
+			}
+		}
+	}
+
+	uint64_t wall_ns = os_monotonic_get_ns() - start_ns;
+
+	t_ht_sync_destroy(&sync);
+	t_dataset_reader_destroy(&reader);
+
+	const char *provider = getenv("MERCURY_EXECUTION_PROVIDER");
+	double wall_s = (double)wall_ns / (double)U_TIME_1S_IN_NS;
+
+	P("Dataset: %s\n", dataset_path);
+	P("Execution provider: %s\n", provider != NULL ? provider : "cpu");
+	P("Frame pairs: %zu in %.3f s, %.2f pairs/s\n", processed, wall_s,
+	  wall_s > 0.0 ? (double)processed / wall_s : 0.0);
+	P("Stages:\n");
+	detection.print("detection");
+	keypoint.print("keypoint");
+	optimizer.print("optimizer");
+	total.print("total");
+
+	const char *hand_names[2] = {"left", "right"};
+	P("Hands:\n");
+	for (int h = 0; h < 2; h++) {
+		P("  %-6s tracked %" PRIu64 " of %zu frames", hand_names[h], hands[h].tracked_frames, processed);
+		if (hands[h].labelled_frames > 0) {
+			double mean_mm =
+			    hands[h].compared_frames > 0 ? hands[h].error_sum_m / hands[h].compared_frames * 1000.0 : 0.0;
+			P(", labelled %" PRIu64 ", mean joint error %.2f mm over %" PRIu64 " frames",
+			  hands[h].labelled_frames, mean_mm, hands[h].compared_frames);
+		}
+		P("\n");
+	}
+
+	return 0;
+}
+
+#else
+
+#include <stdio.h>
+
+int
+cli_cmd_handbench(int argc, const char **argv)
+{
+	fprintf(stderr, "Not compiled with Mercury hand tracking, or not supported on this platform!\n");
+	return 1;
+}
+
+#endif
@@ -8,20 +8,58 @@
 
 #include "euroc/euroc_interface.h"
 #include "os/os_threading.h"
+#include "os/os_time.h"
 #include "util/u_logging.h"
+#include "util/u_misc.h"
 #include "xrt/xrt_config_build.h"
 #include "xrt/xrt_config_have.h"
 #include "xrt/xrt_config_drivers.h"
+#include "xrt/xrt_config_os.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef XRT_OS_WINDOWS
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 #define P(...) fprintf(stderr, __VA_ARGS__)
 #define I(...) U_LOG(U_LOGGING_INFO, __VA_ARGS__)
+#define W(...) U_LOG(U_LOGGING_WARN, __VA_ARGS__)
 
 #if defined(XRT_FEATURE_SLAM) && defined(XRT_BUILD_DRIVER_EUROC)
 
 static bool should_exit = false;
 
+enum run_status
+{
+	RUN_PENDING = 0,
+	RUN_OK,
+	RUN_INTERRUPTED,
+	RUN_FAILED,
+};
+
+static const char *run_status_str[] = {"pending", "ok", "interrupted", "failed"};
+
+//! A dataset to run and its outcome
+struct run
+{
+	const char *dataset_path;
+	const char *slam_config;
+	const char *output_path;
+	enum run_status status;
+	struct euroc_run_result result;
+
+#ifndef XRT_OS_WINDOWS
+	pid_t pid; //!< Worker process running this dataset
+	int fd;    //!< Read end of the pipe the worker sends its result through
+#endif
+};
+
 static void *
 wait_for_exit_key(void *ptr)
 {
@@ -29,6 +67,210 @@ wait_for_exit_key(void *ptr)
 	should_exit = true;
 	return NULL;
 }
+
+static void
+run_dataset(struct run *r)
+{
+	euroc_run_dataset(r->dataset_path, r->slam_config, r->output_path, &should_exit, &r->result);
+	r->status = r->result.completed ? RUN_OK : RUN_INTERRUPTED;
+}
+
+static void
+run_serial(struct run *runs, int run_count)
+{
+	for (int i = 0; i < run_count && !should_exit; i++) {
+		struct run *r = &runs[i];
+
+		I("Running dataset %d out of %d", i + 1, run_count);
+		I("Dataset path: %s", r->dataset_path);
+		I("SLAM config path: %s", r->slam_config);
+		I("Output path: %s", r->output_path);
+
+		run_dataset(r);
+	}
+}
+
+#ifndef XRT_OS_WINDOWS
+
+//! Runs @p r in a forked worker so that a crashing dataset can't take the batch down with it.
+static bool
+run_start_worker(struct run *r)
+{
+	int fds[2];
+	if (pipe(fds) != 0) {
+		W("Unable to create pipe for dataset %s", r->dataset_path);
+		return false;
+	}
+
+	fflush(stdout);
+	fflush(stderr);
+
+	pid_t pid = fork();
+	if (pid < 0) {
+		W("Unable to fork worker for dataset %s", r->dataset_path);
+		close(fds[0]);
+		close(fds[1]);
+		return false;
+	}
+
+	if (pid == 0) { // Worker
+		close(fds[0]);
+		run_dataset(r);
+		ssize_t n = write(fds[1], &r->result, sizeof(r->result));
+		close(fds[1]);
+		_exit(n == sizeof(r->result) ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
+	close(fds[1]);
+	r->pid = pid;
+	r->fd = fds[0];
+	return true;
+}
+
+static void
+run_reap_worker(struct run *r, int wstatus)
+{
+	bool exited = WIFEXITED(wstatus) && WEXITSTATUS(wstatus) == EXIT_SUCCESS;
+	ssize_t n = read(r->fd, &r->result, sizeof(r->result));
+	close(r->fd);
+	r->pid = 0;
+
+	if (should_exit && WIFSIGNALED(wstatus) && WTERMSIG(wstatus) == SIGTERM) {
+		r->status = RUN_INTERRUPTED;
+		return;
+	}
+	if (!exited || n != sizeof(r->result)) {
+		W("Worker for dataset %s failed", r->dataset_path);
+		r->status = RUN_FAILED;
+		return;
+	}
+	r->status = r->result.completed ? RUN_OK : RUN_INTERRUPTED;
+}
+
+static void
+run_parallel(struct run *runs, int run_count, int jobs)
+{
+	int next = 0;
+	int running = 0;
+	bool killed = false;
+
+	while (next < run_count || running > 0) {
+		// Start as many workers as allowed
+		while (!should_exit && running < jobs && next < run_count) {
+			struct run *r = &runs[next++];
+			I("Starting dataset %d out of %d: %s", next, run_count, r->dataset_path);
+			if (run_start_worker(r)) {
+				running++;
+			} else {
+				r->status = RUN_FAILED;
+			}
+		}
+
+		if (should_exit && !killed) {
+			for (int i = 0; i < run_count; i++) {
+				if (runs[i].pid > 0) {
+					kill(runs[i].pid, SIGTERM);
+				}
+			}
+			next = run_count;
+			killed = true;
+		}
+
+		if (running == 0) {
+			break;
+		}
+
+		// Poll so that the exit key is noticed while workers run
+		int wstatus = 0;
+		pid_t pid = waitpid(-1, &wstatus, WNOHANG);
+		if (pid <= 0) {
+			os_nanosleep(U_TIME_1MS_IN_NS * 100);
+			continue;
+		}
+
+		for (int i = 0; i < run_count; i++) {
+			if (runs[i].pid == pid) {
+				run_reap_worker(&runs[i], wstatus);
+				running--;
+				I("Finished dataset %s (%s)", runs[i].dataset_path, run_status_str[runs[i].status]);
+				break;
+			}
+		}
+	}
+}
+
+#endif // !XRT_OS_WINDOWS
+
+static void
+print_json_string(FILE *f, const char *str)
+{
+	fputc('"', f);
+	for (const char *c = str; *c != '\0'; c++) {
+		if (*c == '"' || *c == '\\') {
+			fputc('\\', f);
+		}
+		fputc(*c, f);
+	}
+	fputc('"', f);
+}
+
+//! Writes a machine readable JSON report of all runs
+static bool
+write_report(const char *path, struct run *runs, int run_count, int jobs, double duration_s)
+{
+	FILE *f = fopen(path, "w");
+	if (f == NULL) {
+		W("Unable to open report file %s", path);
+		return false;
+	}
+
+	fprintf(f, "{\n");
+	fprintf(f, "\t\"jobs\": %d,\n", jobs);
+	fprintf(f, "\t\"duration_s\": %f,\n", duration_s);
+	fprintf(f, "\t\"datasets\": [");
+	for (int i = 0; i < run_count; i++) {
+		const struct run *r = &runs[i];
+		const struct t_slam_metrics *m = &r->result.metrics;
+
+		fprintf(f, "%s\n\t\t{\n", i == 0 ? "" : ",");
+		fprintf(f, "\t\t\t\"dataset\": ");
+		print_json_string(f, r->dataset_path);
+		fprintf(f, ",\n\t\t\t\"slam_config\": ");
+		print_json_string(f, r->slam_config);
+		fprintf(f, ",\n\t\t\t\"output\": ");
+		print_json_string(f, r->output_path);
+		fprintf(f, ",\n");
+		fprintf(f, "\t\t\t\"status\": \"%s\",\n", run_status_str[r->status]);
+		fprintf(f, "\t\t\t\"duration_s\": %f,\n", r->result.duration_s);
+		fprintf(f, "\t\t\t\"pose_count\": %u,\n", m->pose_count);
+		fprintf(f, "\t\t\t\"gt_count\": %u,\n", m->gt_count);
+		fprintf(f, "\t\t\t\"ate_rmse_m\": %f,\n", m->ate_rmse_m);
+		fprintf(f, "\t\t\t\"rpe_rmse_m\": %f,\n", m->rpe_rmse_m);
+		fprintf(f, "\t\t\t\"rpe_delta_s\": %f,\n", m->rpe_delta_s);
+		fprintf(f, "\t\t\t\"latency_count\": %u,\n", m->latency_count);
+		fprintf(f, "\t\t\t\"latency_avg_ms\": %f,\n", m->latency_avg_ms);
+		fprintf(f, "\t\t\t\"latency_max_ms\": %f\n", m->latency_max_ms);
+		fprintf(f, "\t\t}");
+	}
+	fprintf(f, "\n\t]\n}\n");
+
+	fclose(f);
+	return true;
+}
+
+static void
+print_summary(struct run *runs, int run_count)
+{
+	printf("%-12s %10s %8s %10s %10s %12s  %s\n", "status", "time (s)", "poses", "ATE (m)", "RPE (m)",
+	       "latency (ms)", "dataset");
+	for (int i = 0; i < run_count; i++) {
+		const struct run *r = &runs[i];
+		const struct t_slam_metrics *m = &r->result.metrics;
+		printf("%-12s %10.2f %8u %10.4f %10.4f %12.2f  %s\n", run_status_str[r->status], r->result.duration_s,
+		       m->pose_count, m->ate_rmse_m, m->rpe_rmse_m, m->latency_avg_ms, r->dataset_path);
+	}
+}
+
 #endif
 
 int
@@ -46,31 +288,71 @@ cli_cmd_slambatch(int argc, const char **argv)
 	int nof_args = argc - 2;
 	const char **args = &argv[2];
 
-	if (nof_args == 0 || nof_args % 3 != 0) {
+	// Conversion between EuRoC directories and single file containers
+	if (nof_args == 3 && strcmp(args[0], "--to-container") == 0) {
+		return euroc_convert_to_container(args[1], args[2]) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+	if (nof_args == 3 && strcmp(args[0], "--to-euroc") == 0) {
+		return euroc_convert_from_container(args[1], args[2]) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	// Options
+	int jobs = 1;
+	const char *report_path = NULL;
+	while (nof_args >= 2 && strncmp(args[0], "--", 2) == 0) {
+		if (strcmp(args[0], "--jobs") == 0) {
+			jobs = atoi(args[1]);
+		} else if (strcmp(args[0], "--report") == 0) {
+			report_path = args[1];
+		} else {
+			break;
+		}
+		nof_args -= 2;
+		args += 2;
+	}
+
+	if (nof_args == 0 || nof_args % 3 != 0 || jobs < 1) {
 		P("Batch evaluator of SLAM datasets.\n");
-		P("Usage: %s %s [<euroc_path> <slam_config> <output_path>]...\n", argv[0], argv[1]);
+		P("Usage: %s %s [--jobs <n>] [--report <report_path>] [<euroc_path> <slam_config> <output_path>]...\n",
+		  argv[0], argv[1]);
+		P("       %s %s --to-container <euroc_path> <container_path>\n", argv[0], argv[1]);
+		P("       %s %s --to-euroc <container_path> <euroc_path>\n", argv[0], argv[1]);
+		P("A euroc_path to play can also be a container, which avoids decoding images on playback.\n");
+		P("--jobs runs up to <n> datasets at once, each one in its own worker process.\n");
+		P("--report writes timing and groundtruth accuracy of every dataset as JSON.\n");
 		return EXIT_FAILURE;
 	}
 
+#ifdef XRT_OS_WINDOWS
+	if (jobs > 1) {
+		W("Parallel runs are not supported on this platform, running datasets one at a time");
+		jobs = 1;
+	}
+#endif
+
+	int run_count = nof_args / 3;
+	struct run *runs = U_TYPED_ARRAY_CALLOC(struct run, run_count);
+	for (int i = 0; i < run_count; i++) {
+		runs[i].dataset_path = args[i * 3];
+		runs[i].slam_config = args[i * 3 + 1];
+		runs[i].output_path = args[i * 3 + 2];
+	}
+
 	// Allow pressing enter to quit the program by launching a new thread
 	struct os_thread_helper wfk_thread;
 	os_thread_helper_init(&wfk_thread);
 	os_thread_helper_start(&wfk_thread, wait_for_exit_key, NULL);
 
 	timepoint_ns start_time = os_monotonic_get_ns();
-	int nof_datasets = nof_args / 3;
-	for (int i = 0; i < nof_datasets && !should_exit; i++) {
-		const char *dataset_path = args[i * 3];
-		const char *slam_config = args[i * 3 + 1];
-		const char *output_path = args[i * 3 + 2];
-
-		I("Running dataset %d out of %d", i + 1, nof_datasets);
-		I("Dataset path: %s", dataset_path);
-		I("SLAM config path: %s", slam_config);
-		I("Output path: %s", output_path);
-
-		euroc_run_dataset(dataset_path, slam_config, output_path, &should_exit);
+#ifndef XRT_OS_WINDOWS
+	if (jobs > 1) {
+		run_parallel(runs, run_count, jobs);
+	} else {
+		run_serial(runs, run_count);
 	}
+#else
+	run_serial(runs, run_count);
+#endif
 	timepoint_ns end_time = os_monotonic_get_ns();
 
 	pthread_cancel(wfk_thread.thread);
@@ -78,7 +360,19 @@ cli_cmd_slambatch(int argc, const char **argv)
 	// Destroy also stops the thread.
 	os_thread_helper_destroy(&wfk_thread);
 
-	printf("Done in %.2fs.\n", (double)(end_time - start_time) / U_TIME_1S_IN_NS);
+	double duration_s = (double)(end_time - start_time) / U_TIME_1S_IN_NS;
+	print_summary(runs, run_count);
+	printf("Done in %.2fs.\n", duration_s);
+
+	bool ok = true;
+	for (int i = 0; i < run_count; i++) {
+		ok = ok && runs[i].status == RUN_OK;
+	}
+	if (report_path != NULL) {
+		ok = write_report(report_path, runs, run_count, jobs, duration_s) && ok;
+	}
+
+	free(runs);
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
 #endif
-	return EXIT_SUCCESS;
 }
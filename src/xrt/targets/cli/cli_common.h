@@ -20,6 +20,12 @@ cli_cmd_calibrate(int argc, const char **argv);
 int
 cli_cmd_calibration_dump(int argc, const char **argv);
 
+int
+cli_cmd_compbench(int argc, const char **argv);
+
+int
+cli_cmd_handbench(int argc, const char **argv);
+
 int
 cli_cmd_lighthouse(int argc, const char **argv);
 
@@ -33,6 +33,8 @@ cli_print_help(int argc, const char **argv)
 	P("  calibrate  - Calibrate a camera and save config (not implemented yet).\n");
 	P("  calib-dumb - Load and dump a calibration to stdout.\n");
 	P("  slambatch  - Runs a sequence of EuRoC datasets with the SLAM tracker.\n");
+	P("  handbench  - Replays a dataset through the hand tracker and reports timings.\n");
+	P("  compbench  - Runs the compositor headless with synthetic clients and reports timings.\n");
 
 	return 1;
 }
@@ -64,5 +66,11 @@ main(int argc, const char **argv)
 	if (strcmp(argv[1], "slambatch") == 0) {
 		return cli_cmd_slambatch(argc, argv);
 	}
+	if (strcmp(argv[1], "handbench") == 0) {
+		return cli_cmd_handbench(argc, argv);
+	}
+	if (strcmp(argv[1], "compbench") == 0) {
+		return cli_cmd_compbench(argc, argv);
+	}
 	return cli_print_help(argc, argv);
 }
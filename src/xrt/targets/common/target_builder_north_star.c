@@ -346,6 +346,7 @@ ns_setup_depthai_device(struct ns_builder *nsb,
 #endif
 
 	entry_sinks = (struct xrt_slam_sinks){
+	    .cam_count = 2,
 	    .cams[0] = entry_left_sink,
 	    .cams[1] = entry_right_sink,
 	    .imu = slam_sinks->imu,
@@ -353,10 +354,8 @@ ns_setup_depthai_device(struct ns_builder *nsb,
 	};
 
 	struct xrt_slam_sinks dummy_slam_sinks = {0};
-	dummy_slam_sinks.imu = entry_sinks.imu;
-
-	u_sink_force_genlock_create(&usysd->xfctx, entry_sinks.cams[0], entry_sinks.cams[1], &dummy_slam_sinks.cams[0],
-	                            &dummy_slam_sinks.cams[1]);
+	u_sink_force_genlock_create_slam(&usysd->xfctx, U_SINK_FORCE_GENLOCK_DEFAULT_TOLERANCE_NS, &entry_sinks,
+	                                 &dummy_slam_sinks);
 
 	xrt_fs_slam_stream_start(the_fs, &dummy_slam_sinks);
 
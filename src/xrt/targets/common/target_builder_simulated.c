@@ -30,6 +30,8 @@
 DEBUG_GET_ONCE_BOOL_OPTION(simulated_enabled, "SIMULATED_ENABLE", false)
 DEBUG_GET_ONCE_OPTION(simulated_left, "SIMULATED_LEFT", NULL)
 DEBUG_GET_ONCE_OPTION(simulated_right, "SIMULATED_RIGHT", NULL)
+DEBUG_GET_ONCE_NUM_OPTION(simulated_load_devices, "SIMULATED_LOAD_DEVICES", 0)
+DEBUG_GET_ONCE_FLOAT_OPTION(simulated_load_rate, "SIMULATED_LOAD_RATE", 1000)
 
 
 /*
@@ -68,6 +70,44 @@ create_controller(const char *str,
 	return simulated_create_controller(name, type, center, origin);
 }
 
+/*!
+ * Adds the load generating devices asked for with SIMULATED_LOAD_DEVICES,
+ * cycling through trackers, controllers and hands, spread out in front of the
+ * user.
+ */
+static void
+add_load_devices(struct u_system_devices *usysd, struct xrt_tracking_origin *origin)
+{
+	const enum simulated_load_kind kinds[] = {
+	    SIMULATED_LOAD_TRACKER,
+	    SIMULATED_LOAD_CONTROLLER,
+	    SIMULATED_LOAD_HAND,
+	};
+
+	uint32_t count = (uint32_t)debug_get_num_option_simulated_load_devices();
+	float rate_hz = debug_get_float_option_simulated_load_rate();
+
+	for (uint32_t i = 0; i < count; i++) {
+		if (usysd->base.xdev_count >= ARRAY_SIZE(usysd->base.xdevs)) {
+			U_LOG_W("Only created %u of %u load devices, too many devices", i, count);
+			break;
+		}
+
+		const struct xrt_pose center = {
+		    XRT_QUAT_IDENTITY,
+		    {-0.5f + 0.1f * (float)(i % 11), 0.8f + 0.1f * (float)((i / 11) % 10), -1.0f},
+		};
+
+		struct xrt_device *xdev =
+		    simulated_create_load_device(kinds[i % ARRAY_SIZE(kinds)], i, rate_hz, &center, origin);
+		if (xdev == NULL) {
+			break;
+		}
+
+		usysd->base.xdevs[usysd->base.xdev_count++] = xdev;
+	}
+}
+
 
 /*
  *
@@ -132,6 +172,8 @@ simulated_open_system(struct xrt_builder *xb,
 		usysd->base.xdevs[usysd->base.xdev_count++] = right;
 	}
 
+	add_load_devices(usysd, head->tracking_origin);
+
 	*out_xsysd = &usysd->base;
 	u_builder_create_space_overseer(&usysd->base, out_xso);
 
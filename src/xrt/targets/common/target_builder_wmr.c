@@ -248,18 +248,16 @@ wmr_open_system(struct xrt_builder *xb,
 		goto error;
 	}
 
-	if (left == NULL && ctrls.left != NULL) {
-		xret = wmr_create_bt_controller(xp, ctrls.left, log_level, &left);
-		if (xret != XRT_SUCCESS) {
-			goto error;
-		}
-	}
-
-	if (right == NULL && ctrls.right != NULL) {
-		xret = wmr_create_bt_controller(xp, ctrls.right, log_level, &right);
-		if (xret != XRT_SUCCESS) {
-			goto error;
-		}
+	// Brought up in parallel, only the ones the headset didn't provide.
+	xret = wmr_create_bt_controller_pair(   //
+	    xp,                                 //
+	    left == NULL ? ctrls.left : NULL,   //
+	    right == NULL ? ctrls.right : NULL, //
+	    log_level,                          //
+	    &left,                              //
+	    &right);                            //
+	if (xret != XRT_SUCCESS) {
+		goto error;
 	}
 
 
@@ -0,0 +1,401 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Measures the round trip time of IPC calls against a running service.
+ * @ingroup ipc
+ */
+
+#include "xrt/xrt_handles.h"
+
+#include "os/os_threading.h"
+#include "os/os_time.h"
+
+#include "util/u_handles.h"
+#include "util/u_misc.h"
+#include "util/u_time.h"
+
+#include "client/ipc_client.h"
+#include "client/ipc_client_connection.h"
+
+#include "ipc_client_generated.h"
+
+#include "ctl_bench.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+#define P(...) fprintf(stdout, __VA_ARGS__)
+#define PE(...) fprintf(stderr, __VA_ARGS__)
+
+#define MAX_CLIENTS (16)
+
+enum bench_op
+{
+	OP_SYSTEM_COMPOSITOR_GET_INFO,
+	OP_SPACE_LOCATE_SPACE,
+	OP_DEVICE_GET_TRACKED_POSE,
+	OP_SWAPCHAIN_WAIT_IMAGE,
+	OP_COMPOSITOR_LAYER_SYNC,
+	OP_COUNT,
+};
+
+static const char *op_names[OP_COUNT] = {
+    "system_compositor_get_info", //
+    "space_locate_space",         //
+    "device_get_tracked_pose",    //
+    "swapchain_wait_image",       //
+    "compositor_layer_sync",      //
+};
+
+/*!
+ * One connection to the service, run on its own thread so that several can
+ * hammer the service at the same time.
+ */
+struct bench_client
+{
+	struct os_thread thread;
+	struct ipc_connection ipc_c;
+
+	uint32_t iterations;
+
+	//! Round trip time of every call, per op.
+	uint64_t *samples[OP_COUNT];
+	uint32_t sample_count[OP_COUNT];
+
+	//! Sum of the round trip times, per op.
+	uint64_t total_ns[OP_COUNT];
+
+	bool failed;
+};
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+#define TIME_CALL(BC, OP, CALL)                                                                                        \
+	do {                                                                                                           \
+		uint64_t _start_ns = os_monotonic_get_ns();                                                            \
+		xrt_result_t _xret = CALL;                                                                             \
+		uint64_t _end_ns = os_monotonic_get_ns();                                                              \
+		if (_xret != XRT_SUCCESS) {                                                                            \
+			PE("%s failed: %i\n", op_names[OP], _xret);                                                    \
+			(BC)->failed = true;                                                                           \
+			return;                                                                                        \
+		}                                                                                                      \
+		(BC)->samples[OP][(BC)->sample_count[OP]++] = _end_ns - _start_ns;                                     \
+		(BC)->total_ns[OP] += _end_ns - _start_ns;                                                             \
+	} while (false)
+
+static int
+compare_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a;
+	uint64_t y = *(const uint64_t *)b;
+
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static double
+ns_to_us(uint64_t ns)
+{
+	return (double)ns / 1000.0;
+}
+
+static uint64_t
+percentile(const uint64_t *sorted, uint32_t count, uint32_t percent)
+{
+	uint32_t index = (uint32_t)(((uint64_t)count * percent) / 100);
+
+	return sorted[index < count ? index : count - 1];
+}
+
+
+/*
+ *
+ * Benchmarks.
+ *
+ */
+
+static void
+bench_stateless(struct bench_client *bc)
+{
+	struct ipc_connection *ipc_c = &bc->ipc_c;
+
+	for (uint32_t i = 0; i < bc->iterations; i++) {
+		struct xrt_system_compositor_info info;
+		TIME_CALL(bc, OP_SYSTEM_COMPOSITOR_GET_INFO, ipc_call_system_compositor_get_info(ipc_c, &info));
+	}
+
+	uint32_t root_id, view_id, local_id, stage_id, unbounded_id;
+	xrt_result_t xret =
+	    ipc_call_space_create_semantic_ids(ipc_c, &root_id, &view_id, &local_id, &stage_id, &unbounded_id);
+	if (xret != XRT_SUCCESS) {
+		PE("space_create_semantic_ids failed: %i\n", xret);
+		bc->failed = true;
+		return;
+	}
+
+	// Not every system has a local space, the root always exists.
+	uint32_t base_id = local_id != UINT32_MAX ? local_id : root_id;
+	struct xrt_pose identity = XRT_POSE_IDENTITY;
+
+	for (uint32_t i = 0; i < bc->iterations; i++) {
+		struct xrt_space_relation relation;
+		TIME_CALL(bc, OP_SPACE_LOCATE_SPACE,
+		          ipc_call_space_locate_space(ipc_c, base_id, &identity, os_monotonic_get_ns(), view_id,
+		                                      &identity, &relation));
+	}
+
+	int32_t head_id = ipc_c->ism->roles.head;
+	if (head_id < 0) {
+		return;
+	}
+
+	for (uint32_t i = 0; i < bc->iterations; i++) {
+		struct xrt_space_relation relation;
+		TIME_CALL(bc, OP_DEVICE_GET_TRACKED_POSE,
+		          ipc_call_device_get_tracked_pose(ipc_c, (uint32_t)head_id, XRT_INPUT_GENERIC_HEAD_POSE,
+		                                           os_monotonic_get_ns(), &relation));
+	}
+}
+
+static void
+bench_swapchain(struct bench_client *bc, uint32_t id, uint32_t image_count)
+{
+	struct ipc_connection *ipc_c = &bc->ipc_c;
+
+	// Acquire and release are done in shared memory, only waiting is a call.
+	for (uint32_t i = 0; i < bc->iterations; i++) {
+		uint32_t index = i % image_count;
+		TIME_CALL(bc, OP_SWAPCHAIN_WAIT_IMAGE, ipc_call_swapchain_wait_image(ipc_c, id, U_TIME_1S_IN_NS, index));
+	}
+}
+
+static void
+bench_layer_sync(struct bench_client *bc)
+{
+	struct ipc_connection *ipc_c = &bc->ipc_c;
+	uint32_t slot_id = 0;
+
+	for (uint32_t i = 0; i < bc->iterations; i++) {
+		int64_t frame_id = -1;
+		uint64_t wake_up_time_ns = 0;
+		uint64_t display_time_ns = 0;
+		uint64_t display_period_ns = 0;
+
+		// Don't sleep until the wake up time, only the IPC cost is of interest.
+		xrt_result_t xret = ipc_call_compositor_predict_frame(ipc_c, &frame_id, &wake_up_time_ns,
+		                                                      &display_time_ns, &display_period_ns);
+		if (xret == XRT_SUCCESS) {
+			xret = ipc_call_compositor_wait_woke(ipc_c, frame_id);
+		}
+		if (xret == XRT_SUCCESS) {
+			xret = ipc_call_compositor_begin_frame(ipc_c, frame_id);
+		}
+		if (xret != XRT_SUCCESS) {
+			PE("Failed to start frame: %i\n", xret);
+			bc->failed = true;
+			return;
+		}
+
+		// An empty frame, what is measured is the call and the hand over to the compositor.
+		struct ipc_layer_slot *slot = &ipc_c->ism->slots[slot_id];
+		slot->data.frame_id = frame_id;
+		slot->data.display_time_ns = display_time_ns;
+		slot->data.env_blend_mode = XRT_BLEND_MODE_OPAQUE;
+		slot->layer_count = 0;
+
+		TIME_CALL(bc, OP_COMPOSITOR_LAYER_SYNC, ipc_call_compositor_layer_sync(ipc_c, slot_id, NULL, 0, &slot_id));
+	}
+}
+
+static void
+bench_session(struct bench_client *bc)
+{
+	struct ipc_connection *ipc_c = &bc->ipc_c;
+	xrt_result_t xret;
+
+	struct xrt_session_info xsi = {0};
+	uint32_t frame_stats_index = 0;
+	xret = ipc_call_session_create(ipc_c, &xsi, &frame_stats_index);
+	if (xret != XRT_SUCCESS) {
+		PE("session_create failed: %i, skipping swapchain and layer benchmarks\n", xret);
+		return;
+	}
+
+	struct xrt_compositor_info info;
+	xret = ipc_call_compositor_get_info(ipc_c, &info);
+	if (xret != XRT_SUCCESS || info.format_count == 0) {
+		PE("compositor_get_info failed: %i\n", xret);
+		bc->failed = true;
+		goto out_session;
+	}
+
+	struct xrt_swapchain_create_info create_info = {
+	    .bits = XRT_SWAPCHAIN_USAGE_COLOR | XRT_SWAPCHAIN_USAGE_SAMPLED,
+	    .format = info.formats[0],
+	    .sample_count = 1,
+	    .width = 256,
+	    .height = 256,
+	    .face_count = 1,
+	    .array_size = 1,
+	    .mip_count = 1,
+	};
+
+	xrt_graphics_buffer_handle_t handles[XRT_MAX_SWAPCHAIN_IMAGES];
+	uint32_t id = 0;
+	uint32_t shared_index = 0;
+	uint32_t image_count = 0;
+	uint64_t size = 0;
+	bool use_dedicated_allocation = false;
+
+	xret = ipc_call_swapchain_create(ipc_c, &create_info, &id, &shared_index, &image_count, &size,
+	                                 &use_dedicated_allocation, handles, XRT_MAX_SWAPCHAIN_IMAGES);
+	if (xret != XRT_SUCCESS) {
+		PE("swapchain_create failed: %i\n", xret);
+		bc->failed = true;
+		goto out_session;
+	}
+
+	// The images are never touched here.
+	for (uint32_t i = 0; i < image_count; i++) {
+		u_graphics_buffer_unref(&handles[i]);
+	}
+
+	bench_swapchain(bc, id, image_count);
+
+	if (!bc->failed) {
+		xret = ipc_call_session_begin(ipc_c);
+		if (xret == XRT_SUCCESS) {
+			bench_layer_sync(bc);
+			ipc_call_session_end(ipc_c);
+		} else {
+			PE("session_begin failed: %i\n", xret);
+			bc->failed = true;
+		}
+	}
+
+	ipc_call_swapchain_destroy(ipc_c, id);
+
+out_session:
+	ipc_call_session_destroy(ipc_c);
+}
+
+static void *
+bench_thread(void *ptr)
+{
+	struct bench_client *bc = (struct bench_client *)ptr;
+
+	bench_stateless(bc);
+	if (!bc->failed) {
+		bench_session(bc);
+	}
+
+	return NULL;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+int
+ctl_bench(uint32_t iterations, uint32_t client_count)
+{
+	if (iterations == 0 || client_count == 0 || client_count > MAX_CLIENTS) {
+		PE("Need at least one iteration and between 1 and %i clients.\n", MAX_CLIENTS);
+		return 1;
+	}
+
+	struct bench_client *clients = U_TYPED_ARRAY_CALLOC(struct bench_client, client_count);
+	uint32_t connected = 0;
+	int ret = 0;
+
+	for (; connected < client_count; connected++) {
+		struct bench_client *bc = &clients[connected];
+
+		struct xrt_instance_info info = {0};
+		snprintf(info.application_name, sizeof(info.application_name), "monado-ctl bench %u", connected);
+
+		xrt_result_t xret = ipc_client_connection_init(&bc->ipc_c, U_LOGGING_WARN, &info);
+		if (xret != XRT_SUCCESS) {
+			PE("Failed to connect client %u: %i\n", connected, xret);
+			ret = 1;
+			break;
+		}
+
+		bc->iterations = iterations;
+		for (uint32_t op = 0; op < OP_COUNT; op++) {
+			bc->samples[op] = U_TYPED_ARRAY_CALLOC(uint64_t, iterations);
+		}
+	}
+
+	for (uint32_t i = 0; i < connected && ret == 0; i++) {
+		os_thread_init(&clients[i].thread);
+		os_thread_start(&clients[i].thread, bench_thread, &clients[i]);
+	}
+
+	for (uint32_t i = 0; i < connected && ret == 0; i++) {
+		os_thread_join(&clients[i].thread);
+		os_thread_destroy(&clients[i].thread);
+		if (clients[i].failed) {
+			ret = 1;
+		}
+	}
+
+	if (ret == 0) {
+		P("%u client(s), %u calls each:\n", connected, iterations);
+		P("\t%-28s %8s %10s %10s %10s %10s %12s\n", "call", "count", "p50(us)", "p90(us)", "p99(us)", "max(us)",
+		  "calls/s");
+	}
+
+	uint64_t *merged = U_TYPED_ARRAY_CALLOC(uint64_t, (size_t)iterations * client_count);
+
+	for (uint32_t op = 0; op < OP_COUNT && ret == 0; op++) {
+		uint32_t count = 0;
+		double throughput = 0.0;
+
+		for (uint32_t i = 0; i < connected; i++) {
+			struct bench_client *bc = &clients[i];
+			for (uint32_t k = 0; k < bc->sample_count[op]; k++) {
+				merged[count++] = bc->samples[op][k];
+			}
+
+			// The clients run at the same time, so their rates add up.
+			if (bc->total_ns[op] > 0) {
+				throughput += (double)bc->sample_count[op] * U_TIME_1S_IN_NS / (double)bc->total_ns[op];
+			}
+		}
+
+		if (count == 0) {
+			P("\t%-28s %8s\n", op_names[op], "skipped");
+			continue;
+		}
+
+		qsort(merged, count, sizeof(uint64_t), compare_u64);
+
+		P("\t%-28s %8u %10.1f %10.1f %10.1f %10.1f %12.0f\n", op_names[op], count,
+		  ns_to_us(percentile(merged, count, 50)), ns_to_us(percentile(merged, count, 90)),
+		  ns_to_us(percentile(merged, count, 99)), ns_to_us(merged[count - 1]), throughput);
+	}
+
+	free(merged);
+
+	for (uint32_t i = 0; i < connected; i++) {
+		ipc_client_connection_fini(&clients[i].ipc_c);
+		for (uint32_t op = 0; op < OP_COUNT; op++) {
+			free(clients[i].samples[op]);
+		}
+	}
+	free(clients);
+
+	return ret;
+}
@@ -0,0 +1,22 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  IPC call benchmark of monado-ctl.
+ * @ingroup ipc
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+
+/*!
+ * Connects @p client_count clients to the running service, each on its own
+ * thread, and has every one make @p iterations calls of each benchmarked IPC
+ * command. Prints the latency percentiles and throughput per command.
+ *
+ * @ingroup ipc
+ */
+int
+ctl_bench(uint32_t iterations, uint32_t client_count);
@@ -8,13 +8,17 @@
  */
 
 #include "util/u_file.h"
+#include "util/u_pacing.h"
 
 #include "client/ipc_client.h"
 #include "client/ipc_client_connection.h"
 
 #include "ipc_client_generated.h"
 
+#include "ctl_bench.h"
+
 #include <ctype.h>
+#include <inttypes.h>
 
 
 #define P(...) fprintf(stdout, __VA_ARGS__)
@@ -26,6 +30,9 @@ typedef enum op_mode
 	MODE_SET_PRIMARY,
 	MODE_SET_FOCUSED,
 	MODE_TOGGLE_IO,
+	MODE_GET_FRAME_TIMINGS,
+	MODE_SET_PERF_OVERLAY,
+	MODE_BENCHMARK,
 } op_mode_t;
 
 
@@ -53,6 +60,8 @@ get_mode(struct ipc_connection *ipc_c)
 			return 1;
 		}
 
+		uint64_t mem_mib = cs.swapchain_memory / (1024 * 1024);
+
 		P("\tid: %d"
 		  "\tact: %d"
 		  "\tdisp: %d"
@@ -60,6 +69,10 @@ get_mode(struct ipc_connection *ipc_c)
 		  "\tio: %d"
 		  "\tovly: %d"
 		  "\tz: %d"
+		  "\trate: 1/%u"
+		  "\tprio: %d"
+		  "\tquota: %d"
+		  "\tmem: %" PRIu64 "MiB"
 		  "\tpid: %d"
 		  "\t%s\n",
 		  clients.ids[i],     //
@@ -69,6 +82,10 @@ get_mode(struct ipc_connection *ipc_c)
 		  cs.io_active,       //
 		  cs.session_overlay, //
 		  cs.z_order,         //
+		  cs.rate_divisor,    //
+		  (int)cs.priority,   //
+		  cs.over_quota,      //
+		  mem_mib,            //
 		  cs.pid,             //
 		  cs.info.application_name);
 	}
@@ -129,6 +146,81 @@ toggle_io(struct ipc_connection *ipc_c, int client_id)
 	return 0;
 }
 
+static double
+ns_to_ms(int64_t t)
+{
+	return (double)(t / 1000) / 1000.0;
+}
+
+static int64_t
+duration_ns(uint64_t start_ns, uint64_t end_ns)
+{
+	return (int64_t)end_ns - (int64_t)start_ns;
+}
+
+int
+get_frame_timings(struct ipc_connection *ipc_c)
+{
+	struct ipc_arg_frame_records records;
+	uint32_t next = 0;
+	xrt_result_t r;
+
+	P("Frames:\n");
+	P("\tframe_id\tcpu(ms)\tgpu(ms)\tgpu_end_to_present(ms)\tvblank_error(ms)\tmissed\n");
+
+	do {
+		r = ipc_call_system_compositor_get_frame_records(ipc_c, next, &records);
+		if (r != XRT_SUCCESS) {
+			PE("Failed to get frame records.\n");
+			return 1;
+		}
+
+		for (uint32_t i = 0; i < records.record_count; i++) {
+			const struct u_pc_frame_record *rec = &records.records[i];
+			bool has_cpu = (rec->flags & U_PC_FRAME_RECORD_CPU_BIT) != 0;
+			bool has_gpu = (rec->flags & U_PC_FRAME_RECORD_GPU_BIT) != 0;
+			bool has_vblank = (rec->flags & U_PC_FRAME_RECORD_VBLANK_BIT) != 0;
+
+			P("\t%" PRIi64, rec->frame_id);
+			if (has_cpu) {
+				P("\t%.2f", ns_to_ms(duration_ns(rec->cpu_begin_ns, rec->cpu_end_ns)));
+			} else {
+				P("\t-");
+			}
+			if (has_gpu) {
+				P("\t%.2f", ns_to_ms(duration_ns(rec->gpu_start_ns, rec->gpu_end_ns)));
+				P("\t%.2f", ns_to_ms(duration_ns(rec->gpu_end_ns, rec->desired_present_time_ns)));
+			} else {
+				P("\t-\t-");
+			}
+			if (has_vblank) {
+				P("\t%.2f", ns_to_ms(duration_ns(rec->desired_present_time_ns, rec->actual_vblank_ns)));
+			} else {
+				P("\t-");
+			}
+			P("\t%s\n", (rec->flags & U_PC_FRAME_RECORD_MISSED_BIT) != 0 ? "yes" : "no");
+		}
+
+		next = records.next;
+	} while (records.record_count == ARRAY_SIZE(records.records));
+
+	return 0;
+}
+
+int
+set_perf_overlay(struct ipc_connection *ipc_c, bool enabled)
+{
+	xrt_result_t r;
+
+	r = ipc_call_system_compositor_set_perf_overlay(ipc_c, enabled);
+	if (r != XRT_SUCCESS) {
+		PE("Failed to %s the performance overlay.\n", enabled ? "show" : "hide");
+		return 1;
+	}
+
+	return 0;
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -137,9 +229,10 @@ main(int argc, char *argv[])
 	// parse arguments
 	int c;
 	int s_val = 0;
+	int bench_clients = 1;
 
 	opterr = 0;
-	while ((c = getopt(argc, argv, "p:f:i:")) != -1) {
+	while ((c = getopt(argc, argv, "p:f:i:to:b:j:")) != -1) {
 		switch (c) {
 		case 'p':
 			s_val = atoi(optarg);
@@ -153,6 +246,16 @@ main(int argc, char *argv[])
 			s_val = atoi(optarg);
 			op_mode = MODE_TOGGLE_IO;
 			break;
+		case 't': op_mode = MODE_GET_FRAME_TIMINGS; break;
+		case 'o':
+			s_val = atoi(optarg);
+			op_mode = MODE_SET_PERF_OVERLAY;
+			break;
+		case 'b':
+			s_val = atoi(optarg);
+			op_mode = MODE_BENCHMARK;
+			break;
+		case 'j': bench_clients = atoi(optarg); break;
 		case '?':
 			if (optopt == 's') {
 				PE("Option -s requires an id to set.\n");
@@ -161,6 +264,10 @@ main(int argc, char *argv[])
 				PE("    -f <id>: Set focused client\n");
 				PE("    -p <id>: Set primary client\n");
 				PE("    -i <id>: Toggle whether client receives input\n");
+				PE("    -t: Print the timings of the latest compositor frames\n");
+				PE("    -o <0|1>: Hide or show the frame timing overlay in the headset\n");
+				PE("    -b <n>: Benchmark IPC calls, <n> calls of each\n");
+				PE("    -j <n>: Number of concurrent clients for -b, default 1\n");
 			} else {
 				PE("Option `\\x%x' unknown.\n", optopt);
 			}
@@ -169,6 +276,11 @@ main(int argc, char *argv[])
 		}
 	}
 
+	// Makes its own connections.
+	if (op_mode == MODE_BENCHMARK) {
+		exit(ctl_bench(s_val > 0 ? (uint32_t)s_val : 0, bench_clients > 0 ? (uint32_t)bench_clients : 0));
+	}
+
 	// Connection struct on the stack, super simple.
 	struct ipc_connection ipc_c = {0};
 
@@ -187,6 +299,8 @@ main(int argc, char *argv[])
 	case MODE_SET_PRIMARY: exit(set_primary(&ipc_c, s_val)); break;
 	case MODE_SET_FOCUSED: exit(set_focused(&ipc_c, s_val)); break;
 	case MODE_TOGGLE_IO: exit(toggle_io(&ipc_c, s_val)); break;
+	case MODE_GET_FRAME_TIMINGS: exit(get_frame_timings(&ipc_c)); break;
+	case MODE_SET_PERF_OVERLAY: exit(set_perf_overlay(&ipc_c, s_val != 0)); break;
 	default: P("Unrecognised operation mode.\n"); exit(1);
 	}
 
@@ -20,6 +20,7 @@
 #include <android/native_window_jni.h>
 
 #include "android/android_globals.h"
+#include "android/android_ahardwarebuffer_allocator.h"
 
 #include <chrono>
 #include <memory>
@@ -181,3 +182,15 @@ Java_org_freedesktop_monado_ipc_MonadoImpl_nativeShutdownServer(JNIEnv *env, job
 
 	return IpcServerHelper::instance().shutdownServer();
 }
+
+extern "C" JNIEXPORT void JNICALL
+Java_org_freedesktop_monado_ipc_MonadoImpl_nativeTrimMemory(JNIEnv *env, jobject thiz, jint level)
+{
+	jni::init(env);
+	jni::Object monadoImpl(thiz);
+	U_LOG_D("service: Called nativeTrimMemory with level %d", (int)level);
+
+	// Values of ComponentCallbacks2.TRIM_MEMORY_RUNNING_CRITICAL and TRIM_MEMORY_BACKGROUND.
+	bool release_all = level == 15 || level >= 40;
+	android_ahardwarebuffer_pool_trim(release_all);
+}
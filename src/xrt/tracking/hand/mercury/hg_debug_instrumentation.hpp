@@ -33,6 +33,10 @@ struct hg_tuneable_values
 	struct u_var_draggable_f32 max_reprojection_error;
 	struct u_var_draggable_f32 opt_smooth_factor;
 	struct u_var_draggable_f32 max_hand_dist;
+	//! Tracking confidence above which detection only runs every @ref detection_interval frames.
+	struct u_var_draggable_f32 confident_tracking;
+	//! How much to grow pose-predicted regions of interest by the predicted motion.
+	struct u_var_draggable_f32 roi_uncertainty_fac;
 	bool scribble_predictions_into_next_frame = false;
 	bool scribble_keypoint_model_outputs = false;
 	bool scribble_optimizer_outputs = true;
@@ -42,14 +46,36 @@ struct hg_tuneable_values
 	size_t num_frames_before_display = 10;
 	bool enable_pose_predicted_input = true;
 	bool enable_framerate_based_smoothing = false;
+	//! Frames between detections while all tracked hands are tracked confidently, 1 runs it every frame.
+	int detection_interval = 1;
 
 	// Stuff that's only really useful for dataset playback:
 	bool detection_model_in_both_views = false;
 };
 
+/*!
+ * Where the time of the last processed frame went, for benchmarking.
+ */
+struct hg_frame_timings
+{
+	//! Hand detection, zero if it was skipped this frame.
+	uint64_t detection_ns;
+	//! Keypoint estimation for all hands and views.
+	uint64_t keypoint_ns;
+	//! Kinematic optimizers for all hands.
+	uint64_t optimizer_ns;
+	//! The whole frame, including the above.
+	uint64_t total_ns;
+	bool ran_detection;
+};
+
 struct hg_tuneable_values *
 t_hand_tracking_sync_mercury_get_tuneable_values_pointer(struct t_hand_tracking_sync *ht_sync);
 
+void
+t_hand_tracking_sync_mercury_get_last_frame_timings(struct t_hand_tracking_sync *ht_sync,
+                                                    struct hg_frame_timings *out_timings);
+
 #ifdef __cplusplus
 }
 } // namespace xrt::tracking::hand::mercury
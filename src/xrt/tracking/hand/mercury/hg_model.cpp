@@ -16,9 +16,27 @@
 
 #include <filesystem>
 #include <array>
+#include <string>
+#include <vector>
+
+#if defined(XRT_OS_ANDROID) && __has_include(<nnapi_provider_factory.h>)
+#include <nnapi_provider_factory.h>
+#define HG_HAVE_NNAPI_PROVIDER
+#endif
 
 namespace xrt::tracking::hand::mercury {
 
+/*!
+ * Which ONNX Runtime execution provider to run the models on, one of "cpu",
+ * "cuda", "tensorrt", "openvino", "xnnpack", "qnn" or "nnapi". Falls back to
+ * the CPU if the provider isn't built into the runtime.
+ */
+DEBUG_GET_ONCE_OPTION(mercury_execution_provider, "MERCURY_EXECUTION_PROVIDER", "cpu")
+//! Threads ONNX Runtime uses within one model run on the CPU.
+DEBUG_GET_ONCE_NUM_OPTION(mercury_intra_op_threads, "MERCURY_INTRA_OP_THREADS", 1)
+//! Use the box filter for the detection input when the scale allows it, instead of warpAffine.
+DEBUG_GET_ONCE_BOOL_OPTION(mercury_box_blackbar, "MERCURY_BOX_BLACKBAR", true)
+
 #define ORT(expr)                                                                                                      \
 	do {                                                                                                           \
 		OrtStatus *status = wrap->api->expr;                                                                   \
@@ -30,14 +48,302 @@ namespace xrt::tracking::hand::mercury {
 		}                                                                                                      \
 	} while (0)
 
+/*!
+ * Like @ref ORT but returns false instead of asserting, for optional things.
+ */
+static bool
+ort_try(HandTracking *hgt, onnx_wrap *wrap, OrtStatus *status, const char *what)
+{
+	if (status == nullptr) {
+		return true;
+	}
+
+	HG_WARN(hgt, "%s: %s", what, wrap->api->GetErrorMessage(status));
+	wrap->api->ReleaseStatus(status);
+	return false;
+}
+
+static bool
+append_generic_provider(HandTracking *hgt,
+                        onnx_wrap *wrap,
+                        OrtSessionOptions *opts,
+                        const char *name,
+                        const std::vector<const char *> &keys,
+                        const std::vector<const char *> &values)
+{
+#if ORT_API_VERSION >= 12
+	OrtStatus *status =
+	    wrap->api->SessionOptionsAppendExecutionProvider(opts, name, keys.data(), values.data(), keys.size());
+	return ort_try(hgt, wrap, status, name);
+#else
+	HG_WARN(hgt, "%s: needs ONNX Runtime API version 12, have %d", name, ORT_API_VERSION);
+	return false;
+#endif
+}
+
+static bool
+append_cuda_provider(HandTracking *hgt, onnx_wrap *wrap, OrtSessionOptions *opts)
+{
+#if ORT_API_VERSION >= 11
+	OrtCUDAProviderOptionsV2 *cuda = nullptr;
+	if (!ort_try(hgt, wrap, wrap->api->CreateCUDAProviderOptions(&cuda), "CUDA")) {
+		return false;
+	}
+
+	OrtStatus *status = wrap->api->SessionOptionsAppendExecutionProvider_CUDA_V2(opts, cuda);
+	wrap->api->ReleaseCUDAProviderOptions(cuda);
+	return ort_try(hgt, wrap, status, "CUDA");
+#else
+	HG_WARN(hgt, "CUDA: needs ONNX Runtime API version 11, have %d", ORT_API_VERSION);
+	return false;
+#endif
+}
+
+static bool
+append_tensorrt_provider(HandTracking *hgt, onnx_wrap *wrap, OrtSessionOptions *opts)
+{
+#if ORT_API_VERSION >= 11
+	OrtTensorRTProviderOptionsV2 *trt = nullptr;
+	if (!ort_try(hgt, wrap, wrap->api->CreateTensorRTProviderOptions(&trt), "TensorRT")) {
+		return false;
+	}
+
+	// Building engines is slow, keep them around for the next start.
+	const char *keys[] = {"trt_fp16_enable", "trt_engine_cache_enable"};
+	const char *values[] = {"1", "1"};
+	OrtStatus *status = wrap->api->UpdateTensorRTProviderOptions(trt, keys, values, ARRAY_SIZE(keys));
+	if (ort_try(hgt, wrap, status, "TensorRT")) {
+		status = wrap->api->SessionOptionsAppendExecutionProvider_TensorRT_V2(opts, trt);
+	}
+	wrap->api->ReleaseTensorRTProviderOptions(trt);
+	if (!ort_try(hgt, wrap, status, "TensorRT")) {
+		return false;
+	}
+
+	// Nodes TensorRT can't take go to CUDA rather than the CPU.
+	append_cuda_provider(hgt, wrap, opts);
+	return true;
+#else
+	HG_WARN(hgt, "TensorRT: needs ONNX Runtime API version 11, have %d", ORT_API_VERSION);
+	return false;
+#endif
+}
+
+static bool
+append_openvino_provider(HandTracking *hgt, onnx_wrap *wrap, OrtSessionOptions *opts)
+{
+	// Defaults to the device OpenVINO was built for.
+	OrtOpenVINOProviderOptions ov = {};
+
+	OrtStatus *status = wrap->api->SessionOptionsAppendExecutionProvider_OpenVINO(opts, &ov);
+	return ort_try(hgt, wrap, status, "OpenVINO");
+}
+
+static bool
+append_nnapi_provider(HandTracking *hgt, onnx_wrap *wrap, OrtSessionOptions *opts)
+{
+#ifdef HG_HAVE_NNAPI_PROVIDER
+	OrtStatus *status = OrtSessionOptionsAppendExecutionProvider_Nnapi(opts, NNAPI_FLAG_USE_FP16);
+	return ort_try(hgt, wrap, status, "NNAPI");
+#else
+	HG_WARN(hgt, "NNAPI: only available on Android with nnapi_provider_factory.h");
+	return false;
+#endif
+}
+
+/*!
+ * Adds the execution provider picked with MERCURY_EXECUTION_PROVIDER, anything
+ * a provider can't run, or all of it if the provider isn't available, is left
+ * to the CPU provider that is always there.
+ */
+static void
+append_execution_provider(HandTracking *hgt, onnx_wrap *wrap, OrtSessionOptions *opts)
+{
+	std::string name = debug_get_option_mercury_execution_provider();
+	int threads = (int)debug_get_num_option_mercury_intra_op_threads();
+
+	bool ok = true;
+	if (name == "cpu") {
+		// Nothing to add.
+	} else if (name == "cuda") {
+		ok = append_cuda_provider(hgt, wrap, opts);
+	} else if (name == "tensorrt") {
+		ok = append_tensorrt_provider(hgt, wrap, opts);
+	} else if (name == "openvino") {
+		ok = append_openvino_provider(hgt, wrap, opts);
+	} else if (name == "nnapi") {
+		ok = append_nnapi_provider(hgt, wrap, opts);
+	} else if (name == "xnnpack") {
+		// XNNPACK has its own thread pool, keep ONNX Runtime's to one thread.
+		std::string threads_str = std::to_string(threads);
+		ok = append_generic_provider(hgt, wrap, opts, "XNNPACK", {"intra_op_num_threads"},
+		                             {threads_str.c_str()});
+		threads = 1;
+	} else if (name == "qnn") {
+		ok = append_generic_provider(hgt, wrap, opts, "QNN", {"backend_path"}, {"libQnnHtp.so"});
+	} else {
+		HG_WARN(hgt, "Unknown execution provider '%s'", name.c_str());
+		ok = false;
+	}
+
+	if (!ok) {
+		HG_WARN(hgt, "Could not use execution provider '%s', running on the CPU", name.c_str());
+	}
+
+	ORT(SetIntraOpNumThreads(opts, threads));
+}
+
+/*!
+ * Session options shared by all of the models.
+ */
+static OrtSessionOptions *
+create_session_options(HandTracking *hgt, onnx_wrap *wrap)
+{
+	OrtSessionOptions *opts = nullptr;
+	ORT(CreateSessionOptions(&opts));
+
+	ORT(SetSessionGraphOptimizationLevel(opts, ORT_ENABLE_ALL));
+	append_execution_provider(hgt, wrap, opts);
+
+	return opts;
+}
+
+/*!
+ * Averages every @p k by @p k block of @p in into one pixel of @p out, which
+ * must be exactly @p k times smaller. Sums whole rows first so the bulk of the
+ * work is plain loops over contiguous memory that the compiler vectorises.
+ */
+static void
+box_downscale(const cv::Mat &in, cv::Mat &out, int k)
+{
+	// 16 rows of 255 still fit in 16 bits.
+	assert(k >= 1 && k <= 16);
+
+	const int in_w = in.cols;
+	const int out_w = out.cols;
+	const uint32_t kk = k * k;
+
+	// Fixed point reciprocal, exact for power of two block sizes.
+	const uint32_t recip = ((1u << 16) + kk / 2) / kk;
+
+	std::vector<uint16_t> row_sum(in_w);
+	uint16_t *sums = row_sum.data();
+
+	for (int y = 0; y < out.rows; y++) {
+		const uint8_t *src = in.ptr<uint8_t>(y * k);
+		for (int x = 0; x < in_w; x++) {
+			sums[x] = src[x];
+		}
+
+		for (int r = 1; r < k; r++) {
+			src = in.ptr<uint8_t>(y * k + r);
+			for (int x = 0; x < in_w; x++) {
+				sums[x] += src[x];
+			}
+		}
+
+		uint8_t *dst = out.ptr<uint8_t>(y);
+		for (int x = 0; x < out_w; x++) {
+			uint32_t sum = 0;
+			for (int i = 0; i < k; i++) {
+				sum += sums[x * k + i];
+			}
+			dst[x] = (uint8_t)((sum * recip + (1u << 15)) >> 16);
+		}
+	}
+}
+
+/*!
+ * Fast path of @ref blackbar for when the image scales down by a whole number:
+ * box filter, rotate by swapping rows and columns and copy into the middle of
+ * the black image. On success @p go is set to the transform actually applied,
+ * which samples the centre of each box rather than its corner.
+ */
+static bool
+blackbar_box(const cv::Mat &in,
+             enum t_camera_orientation rot,
+             cv::Mat &out,
+             xrt_size out_size,
+             float scale_down,
+             cv::Matx23f &go)
+{
+	if (in.type() != CV_8UC1) {
+		return false;
+	}
+
+	float inv_scale = 1.0f / scale_down;
+	int k = (int)lroundf(inv_scale);
+	if (k < 1 || k > 16 || fabsf(inv_scale - (float)k) > 1e-3f || (in.cols % k) != 0 || (in.rows % k) != 0) {
+		return false;
+	}
+
+	int down_w = in.cols / k;
+	int down_h = in.rows / k;
+
+	cv::Mat down(down_h, down_w, CV_8UC1);
+	box_downscale(in, down, k);
+
+	cv::Mat rotated;
+	switch (rot) {
+	case CAMERA_ORIENTATION_0: rotated = down; break;
+	case CAMERA_ORIENTATION_90: cv::rotate(down, rotated, cv::ROTATE_90_COUNTERCLOCKWISE); break;
+	case CAMERA_ORIENTATION_180: cv::rotate(down, rotated, cv::ROTATE_180); break;
+	case CAMERA_ORIENTATION_270: cv::rotate(down, rotated, cv::ROTATE_90_CLOCKWISE); break;
+	default: return false;
+	}
+
+	int off_x = (out_size.w - rotated.cols) / 2;
+	int off_y = (out_size.h - rotated.rows) / 2;
+	if (off_x < 0 || off_y < 0) {
+		return false;
+	}
+
+	out = cv::Mat::zeros(out_size.h, out_size.w, CV_8UC1);
+	rotated.copyTo(out(cv::Rect(off_x, off_y, rotated.cols, rotated.rows)));
+
+	// Source pixel p lands at s * (p + 0.5) - 0.5 in the downscaled image.
+	float s = scale_down;
+	float c = 0.5f * s - 0.5f;
+	float max_x = (float)(down_w - 1);
+	float max_y = (float)(down_h - 1);
+
+	switch (rot) {
+	case CAMERA_ORIENTATION_0:
+		// clang-format off
+			go(0,0) = s;     go(0,1) = 0.0f;  go(0,2) = c + off_x;
+			go(1,0) = 0.0f;  go(1,1) = s;     go(1,2) = c + off_y;
+		// clang-format on
+		break;
+	case CAMERA_ORIENTATION_90:
+		// clang-format off
+			go(0,0) = 0.0f;  go(0,1) = s;     go(0,2) = c + off_x;
+			go(1,0) = -s;    go(1,1) = 0.0f;  go(1,2) = -c + max_x + off_y;
+		// clang-format on
+		break;
+	case CAMERA_ORIENTATION_180:
+		// clang-format off
+			go(0,0) = -s;    go(0,1) = 0.0f;  go(0,2) = -c + max_x + off_x;
+			go(1,0) = 0.0f;  go(1,1) = -s;    go(1,2) = -c + max_y + off_y;
+		// clang-format on
+		break;
+	case CAMERA_ORIENTATION_270:
+		// clang-format off
+			go(0,0) = 0.0f;  go(0,1) = -s;    go(0,2) = -c + max_y + off_x;
+			go(1,0) = s;     go(1,1) = 0.0f;  go(1,2) = c + off_y;
+		// clang-format on
+		break;
+	default: return false;
+	}
+
+	return true;
+}
+
 static cv::Matx23f
 blackbar(const cv::Mat &in, enum t_camera_orientation rot, cv::Mat &out, xrt_size out_size)
 {
-	// Easy to think about, always right, but pretty slow:
 	// Get a matrix from the original to the scaled down / blackbar'd image, then get one that goes back.
-	// Then just warpAffine() it.
-	// Easy in programmer time - never have to worry about off by one, special cases. We can come back and optimize
-	// later.
+	// Whole number scales, which is what our cameras give, take the box filter path; anything else just
+	// gets warpAffine()'d, never have to worry about off by one or special cases there.
 	bool swapped_wh = false;
 	float in_w, in_h;
 
@@ -105,7 +411,9 @@ blackbar(const cv::Mat &in, enum t_camera_orientation rot, cv::Mat &out, xrt_siz
 		break;
 	}
 
-	cv::warpAffine(in, out, go, cv::Size(out_size.w, out_size.h));
+	if (!debug_get_bool_option_mercury_box_blackbar() || !blackbar_box(in, rot, out, out_size, scale_down, go)) {
+		cv::warpAffine(in, out, go, cv::Size(out_size.w, out_size.h));
+	}
 
 	// Return the inverse affine transform by passing
 	// through a 3x3 rotation matrix
@@ -240,39 +548,137 @@ refine_center_of_distribution(struct HandTracking *hgt, //
 	return true;
 }
 
+/*!
+ * Converts to float, scales to a standard deviation of 0.25 and moves the mean
+ * to 0.5. The statistics are summed over the bytes, then the float image is
+ * written once, straight into the bound model input.
+ */
 static bool
 normalizeGrayscaleImage(cv::Mat &data_in, cv::Mat &data_out)
 {
-	data_in.convertTo(data_out, CV_32FC1, 1 / 255.0);
+	assert(data_in.type() == CV_8UC1);
+	assert(data_out.type() == CV_32FC1);
+	assert(data_in.size() == data_out.size());
+
+	uint64_t sum = 0;
+	uint64_t sum_sq = 0;
+	for (int y = 0; y < data_in.rows; y++) {
+		const uint8_t *row = data_in.ptr<uint8_t>(y);
+
+		uint32_t row_sum = 0;
+		uint32_t row_sum_sq = 0;
+		for (int x = 0; x < data_in.cols; x++) {
+			uint32_t v = row[x];
+			row_sum += v;
+			row_sum_sq += v * v;
+		}
 
-	cv::Mat mean;
-	cv::Mat stddev;
-	cv::meanStdDev(data_out, mean, stddev);
+		sum += row_sum;
+		sum_sq += row_sum_sq;
+	}
+
+	double n = (double)data_in.total();
+	double mean = (double)sum / n;
+	double variance = (double)sum_sq / n - mean * mean;
 
-	if (stddev.at<double>(0, 0) == 0) {
+	if (variance <= 0) {
 		U_LOG_W("Got image with zero standard deviation!");
 		return false;
 	}
 
-	data_out *= 0.25 / stddev.at<double>(0, 0);
+	// In 0-255 units, the 1/255 of the float conversion cancels out.
+	double scale = 0.25 / sqrt(variance);
+	float mul = (float)scale;
+	float add = (float)(0.5 - mean * scale);
+
+	for (int y = 0; y < data_in.rows; y++) {
+		const uint8_t *in = data_in.ptr<uint8_t>(y);
+		float *out = data_out.ptr<float>(y);
+
+		for (int x = 0; x < data_in.cols; x++) {
+			out[x] = (float)in[x] * mul + add;
+		}
+	}
 
-	// Calculate it again; mean has changed. Yes we don't need to but it's easy
-	//! @todo optimize
-	cv::meanStdDev(data_out, mean, stddev);
-	data_out += (0.5 - mean.at<double>(0, 0));
 	return true;
 }
 
+/*!
+ * Binds the inputs of @p wrap and preallocated tensors for the outputs named
+ * @p output_names, so runs don't create or free any tensors. Dynamic output
+ * dimensions are taken as 1, the batch size of these sessions.
+ */
+static void
+setup_io_binding(HandTracking *hgt, onnx_wrap *wrap, const char *const *output_names, size_t output_count)
+{
+	ORT(CreateIoBinding(wrap->session, &wrap->binding));
+
+	for (model_input_wrap &in : wrap->wraps) {
+		ORT(BindInput(wrap->binding, in.name, in.tensor));
+	}
+
+	OrtAllocator *allocator = nullptr;
+	ORT(GetAllocatorWithDefaultOptions(&allocator));
+
+	size_t count = 0;
+	ORT(SessionGetOutputCount(wrap->session, &count));
+
+	for (size_t o = 0; o < output_count; o++) {
+		model_input_wrap out = {};
+		out.name = output_names[o];
+
+		// Find the output by name to get its shape.
+		bool found = false;
+		for (size_t i = 0; i < count && !found; i++) {
+			char *name = nullptr;
+			ORT(SessionGetOutputName(wrap->session, i, allocator, &name));
+			found = strcmp(name, out.name) == 0;
+			ORT(AllocatorFree(allocator, name));
+
+			if (!found) {
+				continue;
+			}
+
+			OrtTypeInfo *type_info = nullptr;
+			const OrtTensorTypeAndShapeInfo *tensor_info = nullptr;
+			ORT(SessionGetOutputTypeInfo(wrap->session, i, &type_info));
+			ORT(CastTypeInfoToTensorInfo(type_info, &tensor_info));
+			ORT(GetDimensionsCount(tensor_info, &out.num_dimensions));
+			assert(out.num_dimensions <= ARRAY_SIZE(out.dimensions));
+			ORT(GetDimensions(tensor_info, out.dimensions, out.num_dimensions));
+			wrap->api->ReleaseTypeInfo(type_info);
+		}
+		assert(found);
+
+		size_t elements = 1;
+		for (size_t d = 0; d < out.num_dimensions; d++) {
+			if (out.dimensions[d] < 0) {
+				out.dimensions[d] = 1;
+			}
+			elements *= out.dimensions[d];
+		}
+
+		out.data = (float *)malloc(elements * sizeof(float));
+
+		ORT(CreateTensorWithDataAsOrtValue(wrap->meminfo,                       //
+		                                   out.data,                            //
+		                                   elements * sizeof(float),            //
+		                                   out.dimensions,                      //
+		                                   out.num_dimensions,                  //
+		                                   ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, //
+		                                   &out.tensor));
+
+		ORT(BindOutput(wrap->binding, out.name, out.tensor));
+
+		wrap->outputs.push_back(out);
+	}
+}
+
 void
 setup_ort_api(HandTracking *hgt, onnx_wrap *wrap, std::filesystem::path path)
 {
 	wrap->api = OrtGetApiBase()->GetApi(ORT_API_VERSION);
-	OrtSessionOptions *opts = nullptr;
-
-	ORT(CreateSessionOptions(&opts));
-
-	ORT(SetSessionGraphOptimizationLevel(opts, ORT_ENABLE_ALL));
-	ORT(SetIntraOpNumThreads(opts, 1));
+	OrtSessionOptions *opts = create_session_options(hgt, wrap);
 
 	ORT(CreateEnv(ORT_LOGGING_LEVEL_FATAL, "monado_ht", &wrap->env));
 
@@ -324,6 +730,9 @@ init_hand_detection(HandTracking *hgt, onnx_wrap *wrap)
 	setup_ort_api(hgt, wrap, path);
 
 	setup_model_image_input(hgt, wrap, "inputImg", kDetectionInputSize, kDetectionInputSize);
+
+	const char *output_names[] = {"hand_exists", "cx", "cy", "size"};
+	setup_io_binding(hgt, wrap, output_names, ARRAY_SIZE(output_names));
 }
 
 
@@ -354,29 +763,16 @@ run_hand_detection(void *ptr)
 
 	normalizeGrayscaleImage(binned_uint8, binned_float_wrapper_mat);
 
-	const OrtValue *inputs[] = {wrap->wraps[0].tensor};
-	const char *input_names[] = {wrap->wraps[0].name};
-
-	OrtValue *output_tensors[] = {nullptr, nullptr, nullptr, nullptr};
-	const char *output_names[] = {"hand_exists", "cx", "cy", "size"};
-
 	{
 		XRT_TRACE_IDENT(model);
-		static_assert(ARRAY_SIZE(input_names) == ARRAY_SIZE(inputs));
-		static_assert(ARRAY_SIZE(output_names) == ARRAY_SIZE(output_tensors));
-		ORT(Run(wrap->session, nullptr, input_names, inputs, ARRAY_SIZE(input_names), output_names,
-		        ARRAY_SIZE(output_names), output_tensors));
+		ORT(RunWithBinding(wrap->session, nullptr, wrap->binding));
 	}
 
-	float *hand_exists = nullptr;
-	float *cx = nullptr;
-	float *cy = nullptr;
-	float *sizee = nullptr;
-
-	ORT(GetTensorMutableData(output_tensors[0], (void **)&hand_exists));
-	ORT(GetTensorMutableData(output_tensors[1], (void **)&cx));
-	ORT(GetTensorMutableData(output_tensors[2], (void **)&cy));
-	ORT(GetTensorMutableData(output_tensors[3], (void **)&sizee));
+	// Bound in setup_io_binding, same order as the names there.
+	float *hand_exists = wrap->outputs[0].data;
+	float *cx = wrap->outputs[1].data;
+	float *cy = wrap->outputs[2].data;
+	float *sizee = wrap->outputs[3].data;
 
 
 
@@ -423,14 +819,45 @@ run_hand_detection(void *ptr)
 			binned_uint8.copyTo(hgt->visualizers.mat(p));
 		}
 	}
+}
 
-	for (size_t i = 0; i < ARRAY_SIZE(output_tensors); i++) {
-		wrap->api->ReleaseValue(output_tensors[i]);
+/*!
+ * Checks that every input of the model takes a batch of @p batch, either
+ * because the batch dimension is dynamic or happens to be that size.
+ */
+static bool
+model_takes_batch(HandTracking *hgt, onnx_wrap *wrap, int64_t batch)
+{
+	size_t count = 0;
+	ORT(SessionGetInputCount(wrap->session, &count));
+
+	bool ok = true;
+	for (size_t i = 0; i < count && ok; i++) {
+		OrtTypeInfo *type_info = nullptr;
+		ORT(SessionGetInputTypeInfo(wrap->session, i, &type_info));
+
+		const OrtTensorTypeAndShapeInfo *tensor_info = nullptr;
+		ORT(CastTypeInfoToTensorInfo(type_info, &tensor_info));
+
+		size_t num_dims = 0;
+		ORT(GetDimensionsCount(tensor_info, &num_dims));
+
+		int64_t dim0 = 0;
+		if (num_dims > 0) {
+			ORT(GetDimensions(tensor_info, &dim0, 1));
+		}
+
+		// Dynamic dimensions are negative.
+		ok = num_dims > 0 && (dim0 < 0 || dim0 == batch);
+
+		wrap->api->ReleaseTypeInfo(type_info);
 	}
+
+	return ok;
 }
 
-void
-init_keypoint_estimation(HandTracking *hgt, onnx_wrap *wrap)
+static bool
+init_keypoint_estimation_impl(HandTracking *hgt, onnx_wrap *wrap, int64_t batch)
 {
 
 	std::filesystem::path path = hgt->models_folder;
@@ -443,12 +870,7 @@ init_keypoint_estimation(HandTracking *hgt, onnx_wrap *wrap)
 	wrap->api = OrtGetApiBase()->GetApi(ORT_API_VERSION);
 
 
-	OrtSessionOptions *opts = nullptr;
-	ORT(CreateSessionOptions(&opts));
-
-	// TODO review options, config for threads?
-	ORT(SetSessionGraphOptimizationLevel(opts, ORT_ENABLE_ALL));
-	ORT(SetIntraOpNumThreads(opts, 1));
+	OrtSessionOptions *opts = create_session_options(hgt, wrap);
 
 
 	ORT(CreateEnv(ORT_LOGGING_LEVEL_FATAL, "monado_ht", &wrap->env));
@@ -459,6 +881,11 @@ init_keypoint_estimation(HandTracking *hgt, onnx_wrap *wrap)
 	ORT(CreateSession(wrap->env, path.c_str(), opts, &wrap->session));
 	assert(wrap->session != NULL);
 
+	if (batch > 1 && !model_takes_batch(hgt, wrap, batch)) {
+		wrap->api->ReleaseSessionOptions(opts);
+		return false;
+	}
+
 	// size_t input_size = wrap->input_shape[0] * wrap->input_shape[1] * wrap->input_shape[2] *
 	// wrap->input_shape[3];
 
@@ -466,19 +893,19 @@ init_keypoint_estimation(HandTracking *hgt, onnx_wrap *wrap)
 	{
 		model_input_wrap inputimg = {};
 		inputimg.name = "inputImg";
-		inputimg.dimensions[0] = 1;
+		inputimg.dimensions[0] = batch;
 		inputimg.dimensions[1] = 1;
 		inputimg.dimensions[2] = 128;
 		inputimg.dimensions[3] = 128;
 		inputimg.num_dimensions = 4;
 
-		inputimg.data = (float *)malloc(128 * 128 * sizeof(float)); // SORRY IM BUSY
+		inputimg.data = (float *)malloc(batch * 128 * 128 * sizeof(float)); // SORRY IM BUSY
 
 
 
 		ORT(CreateTensorWithDataAsOrtValue(wrap->meminfo,                       //
 		                                   inputimg.data,                       //
-		                                   128 * 128 * sizeof(float),           //
+		                                   batch * 128 * 128 * sizeof(float),   //
 		                                   inputimg.dimensions,                 //
 		                                   inputimg.num_dimensions,             //
 		                                   ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, //
@@ -495,17 +922,17 @@ init_keypoint_estimation(HandTracking *hgt, onnx_wrap *wrap)
 	{
 		model_input_wrap inputimg = {};
 		inputimg.name = "lastKeypoints";
-		inputimg.dimensions[0] = 1;
+		inputimg.dimensions[0] = batch;
 		inputimg.dimensions[1] = 42;
 		inputimg.num_dimensions = 2;
 
-		inputimg.data = (float *)malloc(1 * 42 * sizeof(float)); // SORRY IM BUSY
+		inputimg.data = (float *)malloc(batch * 42 * sizeof(float)); // SORRY IM BUSY
 
 
 
 		ORT(CreateTensorWithDataAsOrtValue(wrap->meminfo,                       //
 		                                   inputimg.data,                       //
-		                                   1 * 42 * sizeof(float),              //
+		                                   batch * 42 * sizeof(float),          //
 		                                   inputimg.dimensions,                 //
 		                                   inputimg.num_dimensions,             //
 		                                   ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, //
@@ -521,16 +948,16 @@ init_keypoint_estimation(HandTracking *hgt, onnx_wrap *wrap)
 	{
 		model_input_wrap inputimg = {};
 		inputimg.name = "useLastKeypoints";
-		inputimg.dimensions[0] = 1;
+		inputimg.dimensions[0] = batch;
 		inputimg.num_dimensions = 1;
 
-		inputimg.data = (float *)malloc(1 * sizeof(float)); // SORRY IM BUSY
+		inputimg.data = (float *)malloc(batch * sizeof(float)); // SORRY IM BUSY
 
 
 
 		ORT(CreateTensorWithDataAsOrtValue(wrap->meminfo,                       //
 		                                   inputimg.data,                       //
-		                                   1 * sizeof(float),                   //
+		                                   batch * sizeof(float),               //
 		                                   inputimg.dimensions,                 //
 		                                   inputimg.num_dimensions,             //
 		                                   ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, //
@@ -545,6 +972,31 @@ init_keypoint_estimation(HandTracking *hgt, onnx_wrap *wrap)
 
 
 	wrap->api->ReleaseSessionOptions(opts);
+
+	return true;
+}
+
+static const char *const keypoint_output_names[] = {"heatmap_xy", "heatmap_depth", "scalar_extras", "curls"};
+
+void
+init_keypoint_estimation(HandTracking *hgt, onnx_wrap *wrap)
+{
+	init_keypoint_estimation_impl(hgt, wrap, 1);
+
+	setup_io_binding(hgt, wrap, keypoint_output_names, ARRAY_SIZE(keypoint_output_names));
+}
+
+bool
+init_keypoint_estimation_batched(HandTracking *hgt, onnx_wrap *wrap)
+{
+	if (init_keypoint_estimation_impl(hgt, wrap, HG_KEYPOINT_MAX_BATCH)) {
+		return true;
+	}
+
+	HG_WARN(hgt, "Keypoint model has a fixed batch size, not batching.");
+	release_onnx_wrap(wrap);
+	*wrap = {};
+	return false;
 }
 
 enum xrt_hand_joint joints_ml_to_xr[21]{
@@ -633,24 +1085,24 @@ set_predicted_zero(float *data)
 	}
 }
 
-void
-run_keypoint_estimation(void *ptr)
+/*!
+ * Projects the hand region of @p info into the model input buffers it points
+ * at, first half of a keypoint estimation.
+ */
+static void
+keypoint_estimation_prepare(keypoint_estimation_run_info &info)
 {
 	XRT_TRACE_MARKER();
-	keypoint_estimation_run_info info = *(keypoint_estimation_run_info *)ptr;
 
-	onnx_wrap *wrap = &info.view->keypoint[info.hand_idx];
 	struct HandTracking *hgt = info.view->hgt;
 
 	int view_idx = info.view->view;
 	int hand_idx = info.hand_idx;
 	one_frame_one_view &this_output = hgt->keypoint_outputs[hand_idx].views[view_idx];
-	MLOutput2D &px_coord = this_output.keypoints_in_scaled_stereographic;
-	// Factor out starting here
 
 	hand_region_of_interest &output = info.view->regions_of_interest_this_frame[hand_idx];
 
-	cv::Mat data_128x128_uint8;
+	cv::Mat &data_128x128_uint8 = info.data_128x128_uint8;
 
 	projection_instructions instr(info.view->hgdist);
 	instr.rot_quat = Eigen::Quaternionf::Identity();
@@ -709,8 +1161,8 @@ run_keypoint_estimation(void *ptr)
 		make_projection_instructions_angular(center, hand_idx, angle,
 		                                     hgt->tuneable_values.after_detection_fac.val, twist, instr);
 
-		wrap->wraps[2].data[0] = 0.0f;
-		set_predicted_zero(wrap->wraps[1].data);
+		info.in_use_last[0] = 0.0f;
+		set_predicted_zero(info.in_last_kps);
 	} else {
 		Eigen::Array<float, 3, 21> keypoints_in_camera;
 
@@ -736,17 +1188,17 @@ run_keypoint_estimation(void *ptr)
 
 		if (hgt->tuneable_values.enable_pose_predicted_input) {
 			for (int ml_joint_idx = 0; ml_joint_idx < 21; ml_joint_idx++) {
-				float *data = wrap->wraps[1].data;
+				float *data = info.in_last_kps;
 				data[(ml_joint_idx * 2) + 0] = bleh[ml_joint_idx].pos_2d.x;
 				data[(ml_joint_idx * 2) + 1] = bleh[ml_joint_idx].pos_2d.y;
 				// data[(ml_joint_idx * 2) + 2] = bleh[ml_joint_idx].depth_relative_to_midpxm;
 			}
 
 
-			wrap->wraps[2].data[0] = 1.0f;
+			info.in_use_last[0] = 1.0f;
 		} else {
-			wrap->wraps[2].data[0] = 0.0f;
-			set_predicted_zero(wrap->wraps[1].data);
+			info.in_use_last[0] = 0.0f;
+			set_predicted_zero(info.in_last_kps);
 		}
 	}
 
@@ -764,38 +1216,34 @@ run_keypoint_estimation(void *ptr)
 		XRT_TRACE_IDENT(convert_format);
 
 		// here!
-		cv::Mat data_128x128_float(cv::Size(128, 128), CV_32FC1, wrap->wraps[0].data, 128 * sizeof(float));
+		cv::Mat data_128x128_float(cv::Size(128, 128), CV_32FC1, info.in_img, 128 * sizeof(float));
 
 		is_hand = is_hand && normalizeGrayscaleImage(data_128x128_uint8, data_128x128_float);
 	}
 
+	info.is_hand = is_hand;
+}
 
-	// Ending here
-
-
-	const OrtValue *inputs[] = {wrap->wraps[0].tensor, wrap->wraps[1].tensor, wrap->wraps[2].tensor};
-	const char *input_names[] = {wrap->wraps[0].name, wrap->wraps[1].name, wrap->wraps[2].name};
-
-	OrtValue *output_tensors[] = {nullptr, nullptr, nullptr, nullptr};
-	const char *output_names[] = {"heatmap_xy", "heatmap_depth", "scalar_extras", "curls"};
-
-	{
-		XRT_TRACE_IDENT(model);
-		assert(ARRAY_SIZE(input_names) == ARRAY_SIZE(inputs));
-		assert(ARRAY_SIZE(output_names) == ARRAY_SIZE(output_tensors));
-		ORT(Run(wrap->session, nullptr, input_names, inputs, ARRAY_SIZE(input_names), output_names,
-		        ARRAY_SIZE(output_names), output_tensors));
-	}
-
-	// To here
-
-	// Interpret model outputs!
 
+/*!
+ * Reads the model outputs @p info points at, second half of a keypoint
+ * estimation.
+ */
+static void
+keypoint_estimation_interpret(keypoint_estimation_run_info &info)
+{
+	XRT_TRACE_MARKER();
 
-	float *out_data = nullptr;
+	struct HandTracking *hgt = info.view->hgt;
 
+	int view_idx = info.view->view;
+	int hand_idx = info.hand_idx;
+	one_frame_one_view &this_output = hgt->keypoint_outputs[hand_idx].views[view_idx];
+	MLOutput2D &px_coord = this_output.keypoints_in_scaled_stereographic;
+	cv::Mat &data_128x128_uint8 = info.data_128x128_uint8;
+	bool is_hand = info.is_hand;
 
-	ORT(GetTensorMutableData(output_tensors[0], (void **)&out_data));
+	float *out_data = info.out_xy;
 
 	// I don't know why this was added
 	// float *confidences = info.view->keypoint_outputs.views[hand_idx].confidences;
@@ -839,8 +1287,7 @@ run_keypoint_estimation(void *ptr)
 	}
 
 
-	float *out_data_depth = nullptr;
-	ORT(GetTensorMutableData(output_tensors[1], (void **)&out_data_depth));
+	float *out_data_depth = info.out_depth;
 
 	for (int joint_idx = 0; joint_idx < 21; joint_idx++) {
 		float *p_ptr = &out_data_depth[(joint_idx * 22)];
@@ -860,8 +1307,7 @@ run_keypoint_estimation(void *ptr)
 		}
 	}
 
-	float *out_data_extras = nullptr;
-	ORT(GetTensorMutableData(output_tensors[2], (void **)&out_data_extras));
+	float *out_data_extras = info.out_extras;
 
 	float is_hand_explicit = out_data_extras[0];
 
@@ -878,8 +1324,7 @@ run_keypoint_estimation(void *ptr)
 	this_output.active = is_hand;
 
 
-	float *out_data_curls = nullptr;
-	ORT(GetTensorMutableData(output_tensors[3], (void **)&out_data_curls));
+	float *out_data_curls = info.out_curls;
 
 	for (int i = 0; i < 5; i++) {
 		float curl = out_data_curls[i];
@@ -965,15 +1410,143 @@ run_keypoint_estimation(void *ptr)
 			cv::line(hgt->visualizers.mat, center, pt2, {0}, 1);
 		}
 	}
+}
+
+
+void
+run_keypoint_estimation(void *ptr)
+{
+	XRT_TRACE_MARKER();
+	keypoint_estimation_run_info &info = *(keypoint_estimation_run_info *)ptr;
+
+	onnx_wrap *wrap = &info.view->keypoint[info.hand_idx];
+	struct HandTracking *hgt = info.view->hgt;
+
+	info.in_img = wrap->wraps[0].data;
+	info.in_last_kps = wrap->wraps[1].data;
+	info.in_use_last = wrap->wraps[2].data;
+
+	keypoint_estimation_prepare(info);
+
+	{
+		XRT_TRACE_IDENT(model);
+		ORT(RunWithBinding(wrap->session, nullptr, wrap->binding));
+	}
+
+	// Interpret model outputs, bound in the order of keypoint_output_names.
+	info.out_xy = wrap->outputs[0].data;
+	info.out_depth = wrap->outputs[1].data;
+	info.out_extras = wrap->outputs[2].data;
+	info.out_curls = wrap->outputs[3].data;
+
+	keypoint_estimation_interpret(info);
+}
+
+static void
+keypoint_estimation_prepare_task(void *ptr)
+{
+	keypoint_estimation_prepare(*(keypoint_estimation_run_info *)ptr);
+}
+
+static void
+keypoint_estimation_interpret_task(void *ptr)
+{
+	keypoint_estimation_interpret(*(keypoint_estimation_run_info *)ptr);
+}
+
+void
+run_keypoint_estimation_batched(HandTracking *hgt, keypoint_estimation_run_info **infos, int count)
+{
+	XRT_TRACE_MARKER();
+
+	assert(count > 0 && count <= HG_KEYPOINT_MAX_BATCH);
+
+	onnx_wrap *wrap = &hgt->keypoint_batched;
+
+	// Each crop fills its slice of the stacked input buffers.
+	for (int i = 0; i < count; i++) {
+		infos[i]->in_img = wrap->wraps[0].data + (i * 128 * 128);
+		infos[i]->in_last_kps = wrap->wraps[1].data + (i * 42);
+		infos[i]->in_use_last = wrap->wraps[2].data + i;
+		u_worker_group_push(hgt->group, keypoint_estimation_prepare_task, infos[i]);
+	}
+	u_worker_group_wait_all(hgt->group);
+
+	// Tensors over just the crops we have this frame, the buffers fit the most.
+	OrtValue *inputs[3] = {};
+	const char *input_names[3] = {};
+	for (size_t i = 0; i < ARRAY_SIZE(inputs); i++) {
+		model_input_wrap &in = wrap->wraps[i];
+
+		int64_t dimensions[4];
+		memcpy(dimensions, in.dimensions, sizeof(dimensions));
+		dimensions[0] = count;
+
+		size_t elements = 1;
+		for (size_t d = 0; d < in.num_dimensions; d++) {
+			elements *= dimensions[d];
+		}
+
+		ORT(CreateTensorWithDataAsOrtValue(wrap->meminfo,                       //
+		                                   in.data,                             //
+		                                   elements * sizeof(float),            //
+		                                   dimensions,                          //
+		                                   in.num_dimensions,                   //
+		                                   ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, //
+		                                   &inputs[i]));
+		input_names[i] = in.name;
+	}
+
+	OrtValue *output_tensors[] = {nullptr, nullptr, nullptr, nullptr};
+	float *outputs[ARRAY_SIZE(output_tensors)] = {};
+	size_t strides[ARRAY_SIZE(output_tensors)] = {};
+	const char *const *output_names = keypoint_output_names;
+
+	{
+		XRT_TRACE_IDENT(model);
+		ORT(Run(wrap->session, nullptr, input_names, inputs, ARRAY_SIZE(input_names), output_names,
+		        ARRAY_SIZE(output_tensors), output_tensors));
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(output_tensors); i++) {
+		ORT(GetTensorMutableData(output_tensors[i], (void **)&outputs[i]));
+
+		OrtTensorTypeAndShapeInfo *shape = nullptr;
+		size_t elements = 0;
+		ORT(GetTensorTypeAndShape(output_tensors[i], &shape));
+		ORT(GetTensorShapeElementCount(shape, &elements));
+		wrap->api->ReleaseTensorTypeAndShapeInfo(shape);
+
+		strides[i] = elements / count;
+	}
+
+	for (int i = 0; i < count; i++) {
+		infos[i]->out_xy = outputs[0] + (i * strides[0]);
+		infos[i]->out_depth = outputs[1] + (i * strides[1]);
+		infos[i]->out_extras = outputs[2] + (i * strides[2]);
+		infos[i]->out_curls = outputs[3] + (i * strides[3]);
+		u_worker_group_push(hgt->group, keypoint_estimation_interpret_task, infos[i]);
+	}
+	u_worker_group_wait_all(hgt->group);
 
 	for (size_t i = 0; i < ARRAY_SIZE(output_tensors); i++) {
 		wrap->api->ReleaseValue(output_tensors[i]);
 	}
+	for (size_t i = 0; i < ARRAY_SIZE(inputs); i++) {
+		wrap->api->ReleaseValue(inputs[i]);
+	}
 }
 
 void
 release_onnx_wrap(onnx_wrap *wrap)
 {
+	if (wrap->binding != nullptr) {
+		wrap->api->ReleaseIoBinding(wrap->binding);
+	}
+	for (model_input_wrap &a : wrap->outputs) {
+		wrap->api->ReleaseValue(a.tensor);
+		free(a.data);
+	}
 	wrap->api->ReleaseMemoryInfo(wrap->meminfo);
 	wrap->api->ReleaseSession(wrap->session);
 	for (model_input_wrap &a : wrap->wraps) {
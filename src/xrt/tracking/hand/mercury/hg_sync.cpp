@@ -15,9 +15,11 @@
 #include "util/u_hand_tracking.h"
 #include "math/m_vec2.h"
 #include "util/u_misc.h"
+#include "os/os_time.h"
 #include "xrt/xrt_frame.h"
 
 
+#include <algorithm>
 #include <numeric>
 
 
@@ -26,6 +28,8 @@ namespace xrt::tracking::hand::mercury {
 
 DEBUG_GET_ONCE_LOG_OPTION(mercury_log, "MERCURY_LOG", U_LOGGING_WARN)
 DEBUG_GET_ONCE_BOOL_OPTION(mercury_optimize_hand_size, "MERCURY_optimize_hand_size", true)
+DEBUG_GET_ONCE_BOOL_OPTION(mercury_batch_keypoints, "MERCURY_BATCH_KEYPOINTS", false)
+DEBUG_GET_ONCE_NUM_OPTION(mercury_detection_interval, "MERCURY_DETECTION_INTERVAL", 4)
 
 // Flags to tell state tracker that these are indeed valid joints
 static const enum xrt_space_relation_flags valid_flags_ht = (enum xrt_space_relation_flags)(
@@ -487,6 +491,49 @@ dispatch_and_process_hand_detections(struct HandTracking *hgt)
 	}
 }
 
+// Detection is the only way to pick up a new hand, but while the hands we do track are tracked well it mostly
+// finds nothing: only look every few frames then.
+static bool
+should_run_detection(struct HandTracking *hgt)
+{
+	if (hgt->tuneable_values.always_run_detection_model || hgt->refinement.optimizing) {
+		return true;
+	}
+
+	if (!hgt->last_frame_hand_detected[0] && !hgt->last_frame_hand_detected[1]) {
+		return true;
+	}
+
+	for (int hand_idx = 0; hand_idx < 2; hand_idx++) {
+		if (hgt->last_frame_hand_detected[hand_idx] &&
+		    hgt->tracking_confidence[hand_idx] < hgt->tuneable_values.confident_tracking.val) {
+			return true;
+		}
+	}
+
+	return hgt->frames_since_detection + 1 >= hgt->tuneable_values.detection_interval;
+}
+
+static void
+run_optimizer_job(void *ptr)
+{
+	optimizer_job &job = *(optimizer_job *)ptr;
+	HandTracking *hgt = job.hgt;
+	int hand_idx = job.hand_idx;
+
+	lm::optimizer_run(hgt->kinematic_hands[hand_idx],                  //
+	                  hgt->keypoint_outputs[hand_idx],                 //
+	                  !hgt->last_frame_hand_detected[hand_idx],        //
+	                  job.smoothing_factor,                            //
+	                  job.optimize_hand_size,                          //
+	                  hgt->target_hand_size,                           //
+	                  hgt->refinement.hand_size_refinement_schedule_y, //
+	                  hgt->tuneable_values.amt_use_depth.val,          //
+	                  *job.out_set,                                    //
+	                  job.out_hand_size,                               //
+	                  job.out_reprojection_error);
+}
+
 void
 hand_joint_set_to_eigen_21(const xrt_hand_joint_set &set, Eigen::Array<float, 3, 21> &out)
 {
@@ -550,12 +597,24 @@ predict_new_regions_of_interest(struct HandTracking *hgt)
 		hgt->pose_predicted_keypoints[hand_idx] = n_minus_one + add;
 
 
+		hand_region_of_interest last_rois[2] = {hgt->views[0].regions_of_interest_this_frame[hand_idx],
+		                                        hgt->views[1].regions_of_interest_this_frame[hand_idx]};
+
 		int num_outside[2];
 		back_project(hgt, hgt->pose_predicted_keypoints[hand_idx], hand_idx,
 		             hgt->tuneable_values.scribble_predictions_into_next_frame && hgt->debug_scribble,
 		             num_outside);
 
+		// Constant velocity is least sure about fast moving and poorly tracked hands, give those more room.
+		float unsure = 1.0f - std::clamp(hgt->tracking_confidence[hand_idx], 0.0f, 1.0f);
+
 		for (int view_idx = 0; view_idx < 2; view_idx++) {
+			hand_region_of_interest &roi = hgt->views[view_idx].regions_of_interest_this_frame[hand_idx];
+			if (last_rois[view_idx].found) {
+				float moved = m_vec2_len(roi.center_px - last_rois[view_idx].center_px);
+				roi.size_px += moved * hgt->tuneable_values.roi_uncertainty_fac.val * (1.0f + unsure);
+			}
+
 			if (num_outside[view_idx] < hgt->tuneable_values.max_num_outside_view) {
 				hgt->views[view_idx].regions_of_interest_this_frame[hand_idx].provenance =
 				    ROIProvenance::POSE_PREDICTION;
@@ -665,6 +724,10 @@ HandTracking::~HandTracking()
 	release_onnx_wrap(&this->views[1].keypoint[1]);
 	release_onnx_wrap(&this->views[1].detection);
 
+	if (this->keypoint_batching) {
+		release_onnx_wrap(&this->keypoint_batched);
+	}
+
 	u_worker_group_reference(&this->group, NULL);
 
 	t_stereo_camera_calibration_reference(&this->calib, NULL);
@@ -688,6 +751,9 @@ HandTracking::cCallbackProcess(struct t_hand_tracking_sync *ht_sync,
 
 	HandTracking *hgt = (struct HandTracking *)ht_sync;
 
+	struct hg_frame_timings timings = {};
+	uint64_t frame_start_ns = os_monotonic_get_ns();
+
 	hgt->current_frame_timestamp = left_frame->timestamp;
 
 	struct xrt_hand_joint_set *out_xrt_hands[2] = {out_left_hand, out_right_hand};
@@ -783,8 +849,14 @@ HandTracking::cCallbackProcess(struct t_hand_tracking_sync *ht_sync,
 
 	// Every now and then if we're not already tracking both hands, try to detect new hands.
 	bool saw_both_hands_last_frame = hgt->last_frame_hand_detected[0] && hgt->last_frame_hand_detected[1];
-	if (!saw_both_hands_last_frame) {
+	if (!saw_both_hands_last_frame && should_run_detection(hgt)) {
+		uint64_t detection_start_ns = os_monotonic_get_ns();
 		dispatch_and_process_hand_detections(hgt);
+		timings.detection_ns = os_monotonic_get_ns() - detection_start_ns;
+		timings.ran_detection = true;
+		hgt->frames_since_detection = 0;
+	} else {
+		hgt->frames_since_detection++;
 	}
 
 	stop_everything_if_hands_are_overlapping(hgt);
@@ -801,6 +873,10 @@ HandTracking::cCallbackProcess(struct t_hand_tracking_sync *ht_sync,
 
 
 	// Dispatch keypoint estimator neural nets
+	uint64_t keypoint_start_ns = os_monotonic_get_ns();
+	struct keypoint_estimation_run_info *batch[HG_KEYPOINT_MAX_BATCH];
+	int batch_count = 0;
+
 	for (int hand_idx = 0; hand_idx < 2; hand_idx++) {
 		for (int view_idx = 0; view_idx < 2; view_idx++) {
 			if (!hgt->views[view_idx].regions_of_interest_this_frame[hand_idx].found) {
@@ -810,11 +886,22 @@ HandTracking::cCallbackProcess(struct t_hand_tracking_sync *ht_sync,
 			struct keypoint_estimation_run_info &inf = hgt->views[view_idx].run_info[hand_idx];
 			inf.view = &hgt->views[view_idx];
 			inf.hand_idx = hand_idx;
+
+			if (hgt->keypoint_batching) {
+				batch[batch_count++] = &inf;
+				continue;
+			}
+
 			u_worker_group_push(hgt->group, hgt->keypoint_estimation_run_func,
 			                    &hgt->views[view_idx].run_info[hand_idx]);
 		}
 	}
+
+	if (batch_count > 0) {
+		run_keypoint_estimation_batched(hgt, batch, batch_count);
+	}
 	u_worker_group_wait_all(hgt->group);
+	timings.keypoint_ns = os_monotonic_get_ns() - keypoint_start_ns;
 
 	// Spaghetti logic for optimizing hand size
 	bool any_hands_are_only_visible_in_one_view = false;
@@ -859,9 +946,12 @@ HandTracking::cCallbackProcess(struct t_hand_tracking_sync *ht_sync,
 	int num_hands = 0;
 	float avg_hand_size = 0;
 
+	optimizer_job jobs[2] = {};
+	int num_jobs = 0;
+
 	// Dispatch the optimizers!
 	for (int hand_idx = 0; hand_idx < 2; hand_idx++) {
-
+		hgt->tracking_confidence[hand_idx] = 0.0f;
 
 		for (int view_idx = 0; view_idx < 2; view_idx++) {
 			if (!hgt->views[view_idx].regions_of_interest_this_frame[hand_idx].found) {
@@ -898,11 +988,6 @@ HandTracking::cCallbackProcess(struct t_hand_tracking_sync *ht_sync,
 			}
 		}
 
-		struct xrt_hand_joint_set *put_in_set = out_xrt_hands[hand_idx];
-
-		lm::KinematicHandLM *hand = hgt->kinematic_hands[hand_idx];
-
-		float reprojection_error_threshold = hgt->tuneable_values.max_reprojection_error.val;
 		float smoothing_factor = hgt->tuneable_values.opt_smooth_factor.val;
 
 		if (hgt->last_frame_hand_detected[hand_idx]) {
@@ -914,29 +999,33 @@ HandTracking::cCallbackProcess(struct t_hand_tracking_sync *ht_sync,
 				double diff_d = time_ns_to_s(diff);
 				smoothing_factor = hgt->tuneable_values.opt_smooth_factor.val * (1 / 60.0f) / diff_d;
 			}
-		} else {
-			reprojection_error_threshold = hgt->tuneable_values.max_reprojection_error.val;
 		}
 
+		optimizer_job &job = jobs[num_jobs++];
+		job.hgt = hgt;
+		job.hand_idx = hand_idx;
+		job.optimize_hand_size = optimize_hand_size;
+		job.smoothing_factor = smoothing_factor;
+		job.out_set = out_xrt_hands[hand_idx];
+	}
 
+	// The two hands have their own optimizers, solve them side by side.
+	uint64_t optimizer_start_ns = os_monotonic_get_ns();
+	for (int i = 1; i < num_jobs; i++) {
+		u_worker_group_push(hgt->group, run_optimizer_job, &jobs[i]);
+	}
+	if (num_jobs > 0) {
+		run_optimizer_job(&jobs[0]);
+	}
+	u_worker_group_wait_all(hgt->group);
+	timings.optimizer_ns = os_monotonic_get_ns() - optimizer_start_ns;
 
-		float out_hand_size;
-
-		//!@todo optimize: We can have one of these on each thread
-		float reprojection_error;
-		lm::optimizer_run(hand,                                     //
-		                  hgt->keypoint_outputs[hand_idx],          //
-		                  !hgt->last_frame_hand_detected[hand_idx], //
-		                  smoothing_factor,
-		                  optimize_hand_size,                              //
-		                  hgt->target_hand_size,                           //
-		                  hgt->refinement.hand_size_refinement_schedule_y, //
-		                  hgt->tuneable_values.amt_use_depth.val,
-		                  *put_in_set,   //
-		                  out_hand_size, //
-		                  reprojection_error);
-
-
+	for (int i = 0; i < num_jobs; i++) {
+		int hand_idx = jobs[i].hand_idx;
+		struct xrt_hand_joint_set *put_in_set = jobs[i].out_set;
+		float out_hand_size = jobs[i].out_hand_size;
+		float reprojection_error = jobs[i].out_reprojection_error;
+		float reprojection_error_threshold = hgt->tuneable_values.max_reprojection_error.val;
 
 		if (reprojection_error > reprojection_error_threshold) {
 			HG_DEBUG(hgt, "Reprojection error above threshold!");
@@ -954,9 +1043,11 @@ HandTracking::cCallbackProcess(struct t_hand_tracking_sync *ht_sync,
 		avg_hand_size += out_hand_size;
 		num_hands++;
 
+		float confidence = hand_confidence_value(reprojection_error, hgt->keypoint_outputs[hand_idx]);
+		hgt->tracking_confidence[hand_idx] = confidence;
+
 		if (!any_hands_are_only_visible_in_one_view) {
-			hgt->refinement.hand_size_refinement_schedule_x +=
-			    hand_confidence_value(reprojection_error, hgt->keypoint_outputs[hand_idx]);
+			hgt->refinement.hand_size_refinement_schedule_x += confidence;
 		}
 
 		u_hand_joints_apply_joint_width(put_in_set);
@@ -1033,6 +1124,9 @@ HandTracking::cCallbackProcess(struct t_hand_tracking_sync *ht_sync,
 	// If the debug UI is active, push to the frame-timing widget
 	u_frame_times_widget_push_sample(&hgt->ft_widget, hgt->current_frame_timestamp);
 
+	timings.total_ns = os_monotonic_get_ns() - frame_start_ns;
+	hgt->last_frame_timings = timings;
+
 	// If the debug UI is active, push our debug frame
 	if (hgt->debug_scribble) {
 		u_sink_debug_push_frame(&hgt->debug_sink_ann, debug_frame);
@@ -1107,11 +1201,16 @@ t_hand_tracking_sync_mercury_create(struct t_stereo_camera_calibration *calib,
 	init_keypoint_estimation(hgt, &hgt->views[1].keypoint[1]);
 	hgt->keypoint_estimation_run_func = xrt::tracking::hand::mercury::run_keypoint_estimation;
 
+	if (debug_get_bool_option_mercury_batch_keypoints()) {
+		hgt->keypoint_batching = init_keypoint_estimation_batched(hgt, &hgt->keypoint_batched);
+	}
+
 	hgt->views[0].view = 0;
 	hgt->views[1].view = 1;
 
 	int num_threads = 4;
-	hgt->pool = u_worker_thread_pool_create(num_threads - 1, num_threads, "Hand Tracking");
+	hgt->pool = u_worker_thread_pool_create(num_threads - 1, num_threads, "Hand Tracking",
+	                                        OS_THREAD_CORE_CLASS_PERFORMANCE);
 	hgt->group = u_worker_group_create(hgt->pool);
 
 	lm::optimizer_create(hgt->left_in_right, false, hgt->log_level, &hgt->kinematic_hands[0]);
@@ -1192,6 +1291,18 @@ t_hand_tracking_sync_mercury_create(struct t_stereo_camera_calibration *calib,
 	hgt->tuneable_values.max_hand_dist.step = 0.05f;
 	hgt->tuneable_values.max_hand_dist.val = 1.7f;
 
+	hgt->tuneable_values.confident_tracking.max = 1.0f;
+	hgt->tuneable_values.confident_tracking.min = 0.0f;
+	hgt->tuneable_values.confident_tracking.step = 0.01f;
+	hgt->tuneable_values.confident_tracking.val = 0.4f;
+
+	hgt->tuneable_values.roi_uncertainty_fac.max = 4.0f;
+	hgt->tuneable_values.roi_uncertainty_fac.min = 0.0f;
+	hgt->tuneable_values.roi_uncertainty_fac.step = 0.01f;
+	hgt->tuneable_values.roi_uncertainty_fac.val = 0.5f;
+
+	hgt->tuneable_values.detection_interval = std::max((int)debug_get_num_option_mercury_detection_interval(), 1);
+
 	u_var_add_draggable_f32(hgt, &hgt->tuneable_values.amt_use_depth, "Amount to use depth prediction");
 
 
@@ -1207,6 +1318,12 @@ t_hand_tracking_sync_mercury_create(struct t_stereo_camera_calibration *calib,
 	u_var_add_draggable_f32(hgt, &hgt->tuneable_values.max_reprojection_error, "Max reprojection error");
 	u_var_add_draggable_f32(hgt, &hgt->tuneable_values.opt_smooth_factor, "Optimizer smoothing factor");
 	u_var_add_draggable_f32(hgt, &hgt->tuneable_values.max_hand_dist, "Max hand distance");
+	u_var_add_draggable_f32(hgt, &hgt->tuneable_values.confident_tracking,
+	                        "Min tracking confidence to run detection less often");
+	u_var_add_draggable_f32(hgt, &hgt->tuneable_values.roi_uncertainty_fac,
+	                        "Grow predicted regions of interest by predicted motion");
+	u_var_add_i32(hgt, &hgt->tuneable_values.detection_interval,
+	              "Frames between detections while tracking confidently");
 
 	u_var_add_i32(hgt, &hgt->tuneable_values.max_num_outside_view,
 	              "max allowed number of hand joints outside view");
@@ -1236,3 +1353,11 @@ t_hand_tracking_sync_mercury_create(struct t_stereo_camera_calibration *calib,
 
 	return &hgt->base;
 }
+
+extern "C" void
+t_hand_tracking_sync_mercury_get_last_frame_timings(struct t_hand_tracking_sync *ht_sync, hg_frame_timings *out_timings)
+{
+	HandTracking &hgt = HandTracking::fromC(ht_sync);
+
+	*out_timings = hgt.last_frame_timings;
+}
@@ -160,6 +160,10 @@ struct onnx_wrap
 	OrtSession *session = nullptr;
 
 	std::vector<model_input_wrap> wraps = {};
+
+	//! Inputs and preallocated outputs bound once, for sessions run with a fixed batch.
+	OrtIoBinding *binding = nullptr;
+	std::vector<model_input_wrap> outputs = {};
 };
 
 // Multipurpose.
@@ -190,10 +194,38 @@ struct hand_detection_run_info
 };
 
 
+// One hand's kinematic optimizer run, the two hands are solved in parallel.
+struct optimizer_job
+{
+	struct HandTracking *hgt;
+	int hand_idx;
+	bool optimize_hand_size;
+	float smoothing_factor;
+
+	struct xrt_hand_joint_set *out_set;
+	float out_hand_size;
+	float out_reprojection_error;
+};
+
 struct keypoint_estimation_run_info
 {
 	ht_view *view;
 	bool hand_idx;
+
+	// Model inputs to fill, slices of one batch or a single run's own buffers.
+	float *in_img;
+	float *in_last_kps;
+	float *in_use_last;
+
+	// Model outputs for this hand and view.
+	float *out_xy;
+	float *out_depth;
+	float *out_extras;
+	float *out_curls;
+
+	// Kept from preparing the inputs to interpreting the outputs.
+	cv::Mat data_128x128_uint8;
+	bool is_hand;
 };
 
 struct ht_view
@@ -272,6 +304,10 @@ public:
 
 	u_worker_group *group;
 
+	//! Runs the keypoint model on every view and hand at once, if enabled and the model takes a batch.
+	bool keypoint_batching = false;
+	onnx_wrap keypoint_batched = {};
+
 
 	float baseline = {};
 	xrt_pose hand_pose_camera_offset = {};
@@ -319,6 +355,14 @@ public:
 
 	int detection_counter = 0;
 
+	// Frames the detection model has been skipped for, see should_run_detection.
+	int frames_since_detection = 0;
+
+	// hand_confidence_value of each hand last frame, zero if it wasn't tracked.
+	float tracking_confidence[2] = {0.0f, 0.0f};
+
+	struct hg_frame_timings last_frame_timings = {};
+
 	struct hand_size_refinement refinement = {};
 	float target_hand_size = STANDARD_HAND_SIZE;
 
@@ -372,6 +416,23 @@ init_keypoint_estimation(HandTracking *hgt, onnx_wrap *wrap);
 void
 run_keypoint_estimation(void *ptr);
 
+//! Both views times both hands.
+#define HG_KEYPOINT_MAX_BATCH (4)
+
+/*!
+ * Sets up @p wrap to run the keypoint model on up to @ref HG_KEYPOINT_MAX_BATCH
+ * crops in one go, fails if the model has a fixed batch size.
+ */
+bool
+init_keypoint_estimation_batched(HandTracking *hgt, onnx_wrap *wrap);
+
+/*!
+ * Prepares the crops of @p infos in parallel, stacks them into one batch for a
+ * single model run and then reads out the results in parallel.
+ */
+void
+run_keypoint_estimation_batched(HandTracking *hgt, keypoint_estimation_run_info **infos, int count);
+
 void
 release_onnx_wrap(onnx_wrap *wrap);
 
@@ -524,6 +524,8 @@ template <typename T> struct ResidualTracker
 };
 
 
+template <bool optimize_hand_size> struct OptimizerWorkspace;
+
 struct KinematicHandLM
 {
 	bool first_frame = true;
@@ -558,6 +560,11 @@ struct KinematicHandLM
 	Quat<HandScalar> left_in_right_orientation = {};
 
 	Eigen::Matrix<HandScalar, calc_input_size(true), 1> TinyOptimizerInput = {};
+
+	// Solvers with their jets and Jacobians, made the first time each residual layout is used and reused after
+	// that so no frame allocates. Indexed by use_stability, then by num_observation_views.
+	OptimizerWorkspace<true> *workspaces_hand_size[2][3] = {};
+	OptimizerWorkspace<false> *workspaces[2][3] = {};
 };
 
 template <typename T> struct Translations55
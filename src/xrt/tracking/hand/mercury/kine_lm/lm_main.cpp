@@ -840,6 +840,51 @@ eval_to_viz_hand(KinematicHandLM &state,
 	out_viz_hand.is_active = true;
 }
 
+/*!
+ * Everything one solve needs that would otherwise be allocated on every frame: the autodiff function's residual jets
+ * and the solver's Jacobian and residual vectors are all sized by the number of residuals.
+ */
+template <bool optimize_hand_size> struct OptimizerWorkspace
+{
+	using AutoDiffCostFunctor = ceres::TinySolverAutoDiffFunction<CostFunctor<optimize_hand_size>,
+	                                                              Eigen::Dynamic,
+	                                                              calc_input_size(optimize_hand_size),
+	                                                              HandScalar>;
+
+	CostFunctor<optimize_hand_size> cf;
+	AutoDiffCostFunctor f;
+	ceres::TinySolver<AutoDiffCostFunctor> solver = {};
+
+	OptimizerWorkspace(KinematicHandLM &state, size_t residual_size) : cf(state, residual_size), f(cf)
+	{
+		solver.options.max_num_iterations = 30;
+
+		//!@todo We don't yet know what "good" termination conditions are.
+		// Instead of trying to guess without good offline datasets, just disable _all_ termination conditions
+		// and have it run for 30 iterations no matter what.
+		solver.options.gradient_tolerance = 0;
+		solver.options.function_tolerance = 0;
+		solver.options.parameter_tolerance = 0;
+
+		//!@todo We need to do a parameter sweep on initial_trust_region_radius.
+	}
+};
+
+template <bool optimize_hand_size>
+static OptimizerWorkspace<optimize_hand_size> *&
+get_workspace_slot(KinematicHandLM &state)
+{
+	int stability_idx = state.use_stability ? 1 : 0;
+	int views_idx = state.num_observation_views;
+	assert(views_idx >= 0 && views_idx <= 2);
+
+	if constexpr (optimize_hand_size) {
+		return state.workspaces_hand_size[stability_idx][views_idx];
+	} else {
+		return state.workspaces[stability_idx][views_idx];
+	}
+}
+
 template <bool optimize_hand_size>
 inline float
 opt_run(KinematicHandLM &state, one_frame_input &observation, xrt_hand_joint_set &out_viz_hand)
@@ -851,24 +896,14 @@ opt_run(KinematicHandLM &state, one_frame_input &observation, xrt_hand_joint_set
 	LM_DEBUG(state, "Running with %zu inputs and %zu residuals, viewed in %d cameras", input_size, residual_size,
 	         state.num_observation_views);
 
-	CostFunctor<optimize_hand_size> cf(state, residual_size);
-
-	using AutoDiffCostFunctor =
-	    ceres::TinySolverAutoDiffFunction<CostFunctor<optimize_hand_size>, Eigen::Dynamic, input_size, HandScalar>;
-
-	AutoDiffCostFunctor f(cf);
-
-	ceres::TinySolver<AutoDiffCostFunctor> solver = {};
-	solver.options.max_num_iterations = 30;
-
-	//!@todo We don't yet know what "good" termination conditions are.
-	// Instead of trying to guess without good offline datasets, just disable _all_ termination conditions and have
-	// it run for 30 iterations no matter what.
-	solver.options.gradient_tolerance = 0;
-	solver.options.function_tolerance = 0;
-	solver.options.parameter_tolerance = 0;
+	OptimizerWorkspace<optimize_hand_size> *&workspace = get_workspace_slot<optimize_hand_size>(state);
+	if (workspace == nullptr) {
+		workspace = new OptimizerWorkspace<optimize_hand_size>(state, residual_size);
+	}
+	assert(workspace->cf.NumResiduals() == residual_size);
 
-	//!@todo We need to do a parameter sweep on initial_trust_region_radius.
+	auto &f = workspace->f;
+	auto &solver = workspace->solver;
 
 	Eigen::Matrix<HandScalar, input_size, 1> inp = state.TinyOptimizerInput.head<input_size>();
 
@@ -1121,6 +1156,13 @@ optimizer_create(xrt_pose left_in_right, bool is_right, u_logging_level log_leve
 void
 optimizer_destroy(KinematicHandLM **hand)
 {
+	for (int i = 0; i < 2; i++) {
+		for (int j = 0; j < 3; j++) {
+			delete (*hand)->workspaces_hand_size[i][j];
+			delete (*hand)->workspaces[i][j];
+		}
+	}
+
 	delete *hand;
 	hand = NULL;
 }
@@ -9,8 +9,7 @@
 
 #include "os/os_threading.h"
 
-#include "math/m_space.h"
-#include "math/m_relation_history.h"
+#include "math/m_hand_joint_history.h"
 
 #include "util/u_var.h"
 #include "util/u_misc.h"
@@ -36,7 +35,19 @@ struct ht_async_impl
 
 	struct t_hand_tracking_sync *provider;
 
-	struct xrt_frame *frames[2];
+	//! Left frame waiting for its right frame, only touched by the sink push functions.
+	struct xrt_frame *receiving_left;
+
+	/*!
+	 * Latest complete stereo pair the mainloop hasn't started on yet,
+	 * protected by the mainloop lock. A newer pair replaces it, so when the
+	 * tracker finishes a frame it can start on the next one right away
+	 * instead of waiting for the camera.
+	 */
+	struct xrt_frame *pending[2];
+
+	//! Pairs replaced before the mainloop got to them, protected by the mainloop lock.
+	uint64_t pairs_dropped;
 
 	bool use_prediction;
 	struct u_var_draggable_f32 prediction_offset_ms;
@@ -51,7 +62,7 @@ struct ht_async_impl
 	{
 		struct os_mutex mutex;
 		struct xrt_hand_joint_set hands[2];
-		struct m_relation_history *relation_hist[2];
+		struct m_hand_joint_history *joint_hist[2];
 		uint64_t timestamp;
 	} present;
 
@@ -60,8 +71,6 @@ struct ht_async_impl
 	// cond is so that we can wake up the mainloop at certain times;
 	// running is so we can stop the thread when Monado exits
 	struct os_thread_helper mainloop;
-
-	volatile bool hand_tracking_work_active;
 };
 
 
@@ -77,6 +86,23 @@ ht_async_impl(struct t_hand_tracking_async *base)
 	return (struct ht_async_impl *)base;
 }
 
+static void
+ht_async_present(struct ht_async_impl *hta)
+{
+	os_mutex_lock(&hta->present.mutex);
+
+	hta->present.timestamp = hta->working.timestamp;
+
+	for (int i = 0; i < 2; i++) {
+		hta->present.hands[i] = hta->working.hands[i];
+
+		// A lost hand clears its history, the gap is never interpolated or predicted across.
+		m_hand_joint_history_push(hta->present.joint_hist[i], &hta->working.hands[i], hta->working.timestamp);
+	}
+
+	os_mutex_unlock(&hta->present.mutex);
+}
+
 static void *
 ht_async_mainloop(void *ptr)
 {
@@ -89,7 +115,7 @@ ht_async_mainloop(void *ptr)
 	while (os_thread_helper_is_running_locked(&hta->mainloop)) {
 
 		// No new frame, wait.
-		if (hta->frames[0] == NULL && hta->frames[1] == NULL) {
+		if (hta->pending[0] == NULL) {
 			os_thread_helper_wait_locked(&hta->mainloop);
 
 			/*
@@ -100,6 +126,11 @@ ht_async_mainloop(void *ptr)
 			continue;
 		}
 
+		// Take over the references, the sinks can queue up the next pair while we work.
+		struct xrt_frame *frames[2] = {hta->pending[0], hta->pending[1]};
+		hta->pending[0] = NULL;
+		hta->pending[1] = NULL;
+
 		os_thread_helper_unlock(&hta->mainloop);
 
 
@@ -109,45 +140,21 @@ ht_async_mainloop(void *ptr)
 
 		t_ht_sync_process(            //
 		    hta->provider,            //
-		    hta->frames[0],           //
-		    hta->frames[1],           //
+		    frames[0],                //
+		    frames[1],                //
 		    &hta->working.hands[0],   //
 		    &hta->working.hands[1],   //
 		    &hta->working.timestamp); //
 
-		xrt_frame_reference(&hta->frames[0], NULL);
-		xrt_frame_reference(&hta->frames[1], NULL);
+		xrt_frame_reference(&frames[0], NULL);
+		xrt_frame_reference(&frames[1], NULL);
 
 
 		/*
 		 * Post process.
 		 */
 
-		os_mutex_lock(&hta->present.mutex);
-
-		hta->present.timestamp = hta->working.timestamp;
-
-		for (int i = 0; i < 2; i++) {
-			hta->present.hands[i] = hta->working.hands[i];
-
-			struct xrt_space_relation wrist_rel =
-			    hta->working.hands[i].values.hand_joint_set_default[XRT_HAND_JOINT_WRIST].relation;
-
-			m_relation_history_estimate_motion( //
-			    hta->present.relation_hist[i],  //
-			    &wrist_rel,                     //
-			    hta->working.timestamp,         //
-			    &wrist_rel);                    //
-
-			m_relation_history_push(           //
-			    hta->present.relation_hist[i], //
-			    &wrist_rel,                    //
-			    hta->working.timestamp);       //
-		}
-
-		os_mutex_unlock(&hta->present.mutex);
-
-		hta->hand_tracking_work_active = false;
+		ht_async_present(hta);
 
 		// Have to lock it again.
 		os_thread_helper_lock(&hta->mainloop);
@@ -170,17 +177,8 @@ ht_async_receive_left(struct xrt_frame_sink *sink, struct xrt_frame *frame)
 {
 	struct ht_async_impl *hta = ht_async_impl(container_of(sink, struct t_hand_tracking_async, left));
 
-	// See comment in ht_async_receive_right.
-	if (hta->hand_tracking_work_active) {
-		// Throw away this frame
-		return;
-	}
-
-	// Ensure a strict left then right order of frames.
-	assert(hta->frames[0] == NULL);
-
-	// Keep onto this frame.
-	xrt_frame_reference(&hta->frames[0], frame);
+	// A left frame that never got its right frame is replaced.
+	xrt_frame_reference(&hta->receiving_left, frame);
 }
 
 static void
@@ -188,28 +186,24 @@ ht_async_receive_right(struct xrt_frame_sink *sink, struct xrt_frame *frame)
 {
 	struct ht_async_impl *hta = ht_async_impl(container_of(sink, struct t_hand_tracking_async, right));
 
-	/*
-	 * Throw away this frame - either the hand tracking work is running now,
-	 * or it was a very short time ago, and ht_async_receive_left threw away
-	 * its frame or there's some other bug where left isn't pushed before
-	 * right.
-	 */
-	if (hta->hand_tracking_work_active || hta->frames[0] == NULL) {
+	// Left is always pushed before right, without it this isn't a pair.
+	if (hta->receiving_left == NULL) {
 		return;
 	}
 
-	// Just to sanity check the above.
-	assert(hta->frames[0] != NULL);
-	assert(hta->frames[1] == NULL);
+	os_thread_helper_lock(&hta->mainloop);
 
-	// Keep onto this frame.
-	xrt_frame_reference(&hta->frames[1], frame);
+	if (hta->pending[0] != NULL) {
+		hta->pairs_dropped++;
+	}
 
-	// We have both frames, now work is active.
-	hta->hand_tracking_work_active = true;
+	// Hand over the left reference, replacing any older pair.
+	xrt_frame_reference(&hta->pending[0], NULL);
+	hta->pending[0] = hta->receiving_left;
+	hta->receiving_left = NULL;
+	xrt_frame_reference(&hta->pending[1], frame);
 
 	// Wake up the worker thread.
-	os_thread_helper_lock(&hta->mainloop);
 	os_thread_helper_signal_locked(&hta->mainloop);
 	os_thread_helper_unlock(&hta->mainloop);
 }
@@ -238,10 +232,14 @@ ht_async_destroy(struct xrt_frame_node *node)
 	os_thread_helper_destroy(&hta->mainloop);
 	os_mutex_destroy(&hta->present.mutex);
 
+	xrt_frame_reference(&hta->receiving_left, NULL);
+	xrt_frame_reference(&hta->pending[0], NULL);
+	xrt_frame_reference(&hta->pending[1], NULL);
+
 	t_ht_sync_destroy(&hta->provider);
 
 	for (int i = 0; i < 2; i++) {
-		m_relation_history_destroy(&hta->present.relation_hist[i]);
+		m_hand_joint_history_destroy(&hta->present.joint_hist[i]);
 	}
 
 	free(hta);
@@ -284,28 +282,21 @@ ht_async_get_hand(struct t_hand_tracking_async *ht_async,
 
 	desired_timestamp_ns += (uint64_t)prediction_offset_ns;
 
-	struct xrt_space_relation predicted_wrist;
-	m_relation_history_get(hta->present.relation_hist[idx], desired_timestamp_ns, &predicted_wrist);
+	struct xrt_hand_joint_set predicted_hand;
+	enum m_relation_history_result result =
+	    m_hand_joint_history_get(hta->present.joint_hist[idx], desired_timestamp_ns, &predicted_hand);
 
-	os_mutex_unlock(&hta->present.mutex);
-
-	struct xrt_space_relation latest_wrist =
-	    latest_hand.values.hand_joint_set_default[XRT_HAND_JOINT_WRIST].relation;
-
-	*out_value = latest_hand;
-
-	// apply the pose change from the latest wrist to the predicted wrist
-	// to all the joints on the hand.
-
-	//! @todo We could slightly reduce the total number of transforms by putting some of this in ht_async_mainloop
-	for (int i = 0; i < XRT_HAND_JOINT_COUNT; i++) {
-		struct xrt_relation_chain xrc = {0};
-		m_relation_chain_push_relation(&xrc, &latest_hand.values.hand_joint_set_default[i].relation);
-		m_relation_chain_push_inverted_relation(&xrc, &latest_wrist);
-		m_relation_chain_push_relation(&xrc, &predicted_wrist);
-		m_relation_chain_resolve(&xrc, &out_value->values.hand_joint_set_default[i].relation);
+	// Nothing to predict from, the hand was lost.
+	if (result == M_RELATION_HISTORY_RESULT_INVALID) {
+		*out_value = latest_hand;
+		*out_timestamp_ns = hta->present.timestamp;
+		os_mutex_unlock(&hta->present.mutex);
+		return;
 	}
 
+	os_mutex_unlock(&hta->present.mutex);
+
+	*out_value = predicted_hand;
 	*out_timestamp_ns = desired_timestamp_ns;
 }
 
@@ -330,8 +321,9 @@ t_hand_tracking_async_default_create(struct xrt_frame_context *xfctx, struct t_h
 	hta->base.get_hand = ht_async_get_hand;
 	hta->provider = sync;
 
+	// Camera rate, a few seconds of history is plenty.
 	for (int i = 0; i < 2; i++) {
-		m_relation_history_create(&hta->present.relation_hist[i]);
+		m_hand_joint_history_create(&hta->present.joint_hist[i], 256);
 	}
 
 	/*!
@@ -365,8 +357,9 @@ t_hand_tracking_async_default_create(struct xrt_frame_context *xfctx, struct t_h
 
 	// Now that everything initialised add to u_var.
 	u_var_add_root(hta, "Hand-tracking async shim!", 0);
-	u_var_add_bool(hta, &hta->use_prediction, "Predict wrist movement");
+	u_var_add_bool(hta, &hta->use_prediction, "Interpolate and predict hands");
 	u_var_add_draggable_f32(hta, &hta->prediction_offset_ms, "Amount to time-travel (ms)");
+	u_var_add_ro_u64(hta, &hta->pairs_dropped, "Frame pairs dropped while busy");
 
 	return &hta->base;
 }
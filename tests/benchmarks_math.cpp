@@ -0,0 +1,163 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Benchmarks of the math and relation history hot paths.
+ */
+
+#include <math/m_api.h>
+#include <math/m_predict.h>
+#include <math/m_relation_history.h>
+#include <math/m_space.h>
+
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "catch/catch.hpp"
+
+#include <atomic>
+#include <thread>
+
+
+static struct xrt_space_relation
+make_relation(float t)
+{
+	struct xrt_space_relation rel = XRT_SPACE_RELATION_ZERO;
+	rel.relation_flags = (enum xrt_space_relation_flags)(
+	    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_POSITION_VALID_BIT |
+	    XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT | XRT_SPACE_RELATION_POSITION_TRACKED_BIT |
+	    XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT | XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT);
+
+	struct xrt_vec3 axis = {0.3f, 1.0f, 0.1f};
+	math_vec3_normalize(&axis);
+	math_quat_from_angle_vector(t, &axis, &rel.pose.orientation);
+	rel.pose.position = {t, 1.6f, -t};
+	rel.linear_velocity = {0.5f, 0.0f, -0.5f};
+	rel.angular_velocity = {0.1f, 2.0f, 0.3f};
+
+	return rel;
+}
+
+TEST_CASE("math_pose")
+{
+	struct xrt_pose a = make_relation(0.3f).pose;
+	struct xrt_pose b = make_relation(1.1f).pose;
+	struct xrt_pose out;
+
+	BENCHMARK("math_pose_transform")
+	{
+		math_pose_transform(&a, &b, &out);
+		return out;
+	};
+
+	BENCHMARK("math_pose_invert")
+	{
+		math_pose_invert(&a, &out);
+		return out;
+	};
+
+	BENCHMARK("math_pose_interpolate")
+	{
+		math_pose_interpolate(&a, &b, 0.25f, &out);
+		return out;
+	};
+
+	struct xrt_vec3 point = {1.0f, 2.0f, 3.0f};
+	struct xrt_vec3 out_point;
+	BENCHMARK("math_pose_transform_point")
+	{
+		math_pose_transform_point(&a, &point, &out_point);
+		return out_point;
+	};
+}
+
+TEST_CASE("m_predict_relation")
+{
+	struct xrt_space_relation rel = make_relation(0.7f);
+	struct xrt_space_relation out;
+
+	BENCHMARK("11ms ahead")
+	{
+		m_predict_relation(&rel, 0.011, &out);
+		return out;
+	};
+}
+
+TEST_CASE("m_relation_chain")
+{
+	struct xrt_space_relation rel = make_relation(0.7f);
+	struct xrt_pose offset = make_relation(0.2f).pose;
+
+	BENCHMARK("Resolve a device, offset and tracking origin")
+	{
+		struct xrt_relation_chain xrc = {};
+		m_relation_chain_push_pose(&xrc, &offset);
+		m_relation_chain_push_relation(&xrc, &rel);
+		m_relation_chain_push_pose(&xrc, &offset);
+
+		struct xrt_space_relation out;
+		m_relation_chain_resolve(&xrc, &out);
+		return out;
+	};
+}
+
+TEST_CASE("m_relation_history")
+{
+	constexpr uint64_t kStepNs = 1000 * 1000;
+
+	struct m_relation_history *rh = nullptr;
+	m_relation_history_create(&rh);
+
+	uint64_t ts = kStepNs;
+	for (uint32_t i = 0; i < m_relation_history_get_capacity(rh); i++, ts += kStepNs) {
+		struct xrt_space_relation rel = make_relation((float)i * 0.01f);
+		m_relation_history_push(rh, &rel, ts);
+	}
+
+	BENCHMARK("push")
+	{
+		struct xrt_space_relation rel = make_relation(0.5f);
+		ts += kStepNs;
+		return m_relation_history_push(rh, &rel, ts);
+	};
+
+	BENCHMARK("get, interpolated")
+	{
+		struct xrt_space_relation out;
+		return m_relation_history_get(rh, ts - 10 * kStepNs - kStepNs / 3, &out);
+	};
+
+	BENCHMARK("get, extrapolated")
+	{
+		struct xrt_space_relation out;
+		return m_relation_history_get(rh, ts + 11 * kStepNs, &out);
+	};
+
+	// A tracker thread pushing at a high rate while the benchmark reads.
+	std::atomic<bool> running{true};
+	std::atomic<uint64_t> latest_ts{ts};
+	std::thread writer([&] {
+		uint64_t t = latest_ts;
+		while (running) {
+			struct xrt_space_relation rel = make_relation((float)(t % 1000) * 0.001f);
+			t += kStepNs;
+			m_relation_history_push(rh, &rel, t);
+			latest_ts = t;
+		}
+	});
+
+	BENCHMARK("get, interpolated, under contention")
+	{
+		struct xrt_space_relation out;
+		return m_relation_history_get(rh, latest_ts - 10 * kStepNs - kStepNs / 3, &out);
+	};
+
+	BENCHMARK("get, extrapolated, under contention")
+	{
+		struct xrt_space_relation out;
+		return m_relation_history_get(rh, latest_ts + 11 * kStepNs, &out);
+	};
+
+	running = false;
+	writer.join();
+
+	m_relation_history_destroy(&rh);
+}
@@ -0,0 +1,162 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Benchmarks of the space overseer, worker pool and sink queue.
+ */
+
+#include <xrt/xrt_frame.h>
+#include <xrt/xrt_space.h>
+
+#include <os/os_threading.h>
+#include <util/u_frame.h>
+#include <util/u_sink.h>
+#include <util/u_space_overseer.h>
+#include <util/u_worker.h>
+
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "catch/catch.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+TEST_CASE("u_space_overseer")
+{
+	struct u_space_overseer *uso = u_space_overseer_create();
+	struct xrt_space_overseer *xso = (struct xrt_space_overseer *)uso;
+
+	// A chain of offset spaces, deeper than any real graph.
+	std::vector<struct xrt_space *> spaces;
+	struct xrt_space *parent = xso->semantic.root;
+	for (int i = 0; i < 16; i++) {
+		struct xrt_pose offset = XRT_POSE_IDENTITY;
+		offset.position.y = 0.1f;
+
+		struct xrt_space *xs = nullptr;
+		REQUIRE(u_space_overseer_create_offset_space(uso, parent, &offset, &xs) == XRT_SUCCESS);
+		spaces.push_back(xs);
+		parent = xs;
+	}
+
+	struct xrt_pose identity = XRT_POSE_IDENTITY;
+
+	BENCHMARK("locate 1 deep")
+	{
+		struct xrt_space_relation rel;
+		return xrt_space_overseer_locate_space(xso, xso->semantic.root, &identity, 0, spaces[0], &identity,
+		                                       &rel);
+	};
+
+	BENCHMARK("locate 16 deep")
+	{
+		struct xrt_space_relation rel;
+		return xrt_space_overseer_locate_space(xso, xso->semantic.root, &identity, 0, spaces.back(), &identity,
+		                                       &rel);
+	};
+
+	BENCHMARK("locate between two 16 deep branches")
+	{
+		struct xrt_space_relation rel;
+		return xrt_space_overseer_locate_space(xso, spaces[7], &identity, 0, spaces.back(), &identity, &rel);
+	};
+
+	for (struct xrt_space *&xs : spaces) {
+		xrt_space_reference(&xs, nullptr);
+	}
+	xrt_space_overseer_destroy(&xso);
+}
+
+static void
+count_task(void *ptr)
+{
+	((std::atomic<uint32_t> *)ptr)->fetch_add(1, std::memory_order_relaxed);
+}
+
+static void
+count_range(void *ptr, uint32_t begin, uint32_t end)
+{
+	((std::atomic<uint32_t> *)ptr)->fetch_add(end - begin, std::memory_order_relaxed);
+}
+
+TEST_CASE("u_worker")
+{
+	struct u_worker_thread_pool *uwtp = u_worker_thread_pool_create(2, 4, "Bench", OS_THREAD_CORE_CLASS_ANY);
+	struct u_worker_group *uwg = u_worker_group_create(uwtp);
+
+	std::atomic<uint32_t> counter{0};
+
+	BENCHMARK("push and wait for 64 tasks")
+	{
+		for (int i = 0; i < 64; i++) {
+			u_worker_group_push(uwg, count_task, &counter);
+		}
+		u_worker_group_wait_all(uwg);
+		return counter.load();
+	};
+
+	BENCHMARK("parallel_for over 4096 items")
+	{
+		u_worker_group_parallel_for(uwg, 4096, 64, count_range, &counter);
+		return counter.load();
+	};
+
+	u_worker_group_reference(&uwg, nullptr);
+	u_worker_thread_pool_reference(&uwtp, nullptr);
+}
+
+namespace {
+
+struct CountingSink
+{
+	struct xrt_frame_sink base;
+	std::atomic<uint64_t> count{0};
+};
+
+} // namespace
+
+static void
+counting_sink_push_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
+{
+	((CountingSink *)xfs)->count.fetch_add(1, std::memory_order_release);
+}
+
+TEST_CASE("u_sink_queue")
+{
+	struct xrt_frame_context xfctx = {};
+
+	CountingSink downstream = {};
+	downstream.base.push_frame = counting_sink_push_frame;
+
+	struct xrt_frame_sink *queue = nullptr;
+	REQUIRE(u_sink_queue_create(&xfctx, 64, &downstream.base, &queue));
+
+	struct xrt_frame *xf = nullptr;
+	u_frame_create_one_off(XRT_FORMAT_L8, 64, 64, &xf);
+	REQUIRE(xf != nullptr);
+
+	// Less than the queue size so that no frames are dropped.
+	BENCHMARK("push 32 and wait until delivered")
+	{
+		uint64_t wanted = downstream.count.load(std::memory_order_acquire) + 32;
+		for (int i = 0; i < 32; i++) {
+			xrt_sink_push_frame(queue, xf);
+		}
+		while (downstream.count.load(std::memory_order_acquire) < wanted) {
+			std::this_thread::yield();
+		}
+	};
+
+	BENCHMARK("push and wait until delivered")
+	{
+		uint64_t wanted = downstream.count.load(std::memory_order_acquire) + 1;
+		xrt_sink_push_frame(queue, xf);
+		while (downstream.count.load(std::memory_order_acquire) < wanted) {
+			std::this_thread::yield();
+		}
+	};
+
+	xrt_frame_reference(&xf, nullptr);
+	xrt_frame_context_destroy_nodes(&xfctx);
+}
@@ -56,4 +56,42 @@ TEST_CASE("u_deque")
 		u_deque_timepoint_ns_destroy(&dt);
 		CHECK(dt.ptr == NULL);
 	}
+
+	SECTION("Bulk operations across the wrap around and growth")
+	{
+		struct u_deque_timepoint_ns dt = u_deque_timepoint_ns_create();
+
+		timepoint_ns in[40];
+		for (int i = 0; i < 40; i++) {
+			in[i] = i;
+		}
+
+		timepoint_ns out[40];
+
+		// Keep the size below the inline storage while the head goes around it.
+		for (int round = 0; round < 10; round++) {
+			u_deque_timepoint_ns_push_back_n(dt, in, 10);
+			CHECK(u_deque_timepoint_ns_pop_front_n(dt, out, 10) == 10);
+			CHECK(out[0] == 0);
+			CHECK(out[9] == 9);
+		}
+
+		// Grows past the inline storage while wrapped.
+		u_deque_timepoint_ns_push_back_n(dt, in, 12);
+		CHECK(u_deque_timepoint_ns_pop_front_n(dt, out, 10) == 10);
+		u_deque_timepoint_ns_push_back_n(dt, in, 40);
+		CHECK(u_deque_timepoint_ns_size(dt) == 42);
+		CHECK(u_deque_timepoint_ns_at(dt, 0) == 10);
+		CHECK(u_deque_timepoint_ns_at(dt, 1) == 11);
+		CHECK(u_deque_timepoint_ns_at(dt, 2) == 0);
+		CHECK(u_deque_timepoint_ns_at(dt, 41) == 39);
+
+		CHECK(u_deque_timepoint_ns_pop_front_n(dt, out, 40) == 40);
+		CHECK(out[39] == 37);
+		CHECK(u_deque_timepoint_ns_pop_front_n(dt, out, 40) == 2);
+		CHECK(out[1] == 39);
+		CHECK(u_deque_timepoint_ns_size(dt) == 0);
+
+		u_deque_timepoint_ns_destroy(&dt);
+	}
 }
@@ -0,0 +1,116 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Pixel format conversion kernel tests.
+ */
+
+#include <util/u_format_convert.h>
+
+#include "catch/catch.hpp"
+
+#include <random>
+#include <vector>
+
+
+using RowFunc = void (*)(const uint8_t *, uint8_t *, uint32_t);
+
+static void
+checkRowFunc(RowFunc func, uint32_t src_bytes_per_pixel, uint32_t dst_bytes_per_pixel)
+{
+	std::mt19937 rng{1337};
+	std::uniform_int_distribution<int> dist{0, 255};
+
+	// Covers the SIMD bodies, the scalar tails and odd widths.
+	const uint32_t widths[] = {1, 2, 7, 8, 15, 16, 17, 31, 32, 33, 640};
+
+	const enum u_format_convert_impl impls[] = {
+	    U_FORMAT_CONVERT_IMPL_SSSE3,
+	    U_FORMAT_CONVERT_IMPL_AVX2,
+	    U_FORMAT_CONVERT_IMPL_NEON,
+	};
+
+	for (uint32_t width : widths) {
+		// Packed 422 always has whole blocks in the source.
+		std::vector<uint8_t> src((width + 1) * src_bytes_per_pixel);
+		for (auto &b : src) {
+			b = (uint8_t)dist(rng);
+		}
+
+		std::vector<uint8_t> expected(width * dst_bytes_per_pixel);
+		REQUIRE(u_format_convert_set_impl(U_FORMAT_CONVERT_IMPL_SCALAR));
+		func(src.data(), expected.data(), width);
+
+		for (auto impl : impls) {
+			if (!u_format_convert_set_impl(impl)) {
+				continue;
+			}
+
+			INFO("impl: " << u_format_convert_impl_str(impl) << " width: " << width);
+
+			// Guard byte to catch writes past the end of the row.
+			std::vector<uint8_t> got(width * dst_bytes_per_pixel + 1, 0xAB);
+			func(src.data(), got.data(), width);
+
+			CHECK(got.back() == 0xAB);
+			got.pop_back();
+			CHECK(got == expected);
+		}
+	}
+
+	u_format_convert_set_impl(U_FORMAT_CONVERT_IMPL_SCALAR);
+}
+
+TEST_CASE("FormatConvertYuvMath")
+{
+	uint8_t rgb[3];
+
+	// Black and white in studio swing.
+	u_format_convert_yuv_to_rgb(16, 128, 128, rgb);
+	CHECK(rgb[0] == 0);
+	CHECK(rgb[1] == 0);
+	CHECK(rgb[2] == 0);
+
+	u_format_convert_yuv_to_rgb(235, 128, 128, rgb);
+	CHECK(rgb[0] == 255);
+	CHECK(rgb[1] == 255);
+	CHECK(rgb[2] == 255);
+
+	// Out of range values are clamped.
+	u_format_convert_yuv_to_rgb(255, 255, 255, rgb);
+	CHECK(rgb[0] == 255);
+	CHECK(rgb[2] == 255);
+	u_format_convert_yuv_to_rgb(0, 0, 0, rgb);
+	CHECK(rgb[0] == 0);
+	CHECK(rgb[2] == 0);
+}
+
+TEST_CASE("FormatConvertScalarAlwaysSupported")
+{
+	CHECK(u_format_convert_impl_is_supported(U_FORMAT_CONVERT_IMPL_SCALAR));
+	CHECK(u_format_convert_impl_is_supported(u_format_convert_get_impl()));
+}
+
+TEST_CASE("FormatConvertRowsMatchScalar")
+{
+	SECTION("YUYV422 to R8G8B8")
+	{
+		checkRowFunc(u_format_convert_row_yuyv422_to_r8g8b8, 2, 3);
+	}
+	SECTION("UYVY422 to R8G8B8")
+	{
+		checkRowFunc(u_format_convert_row_uyvy422_to_r8g8b8, 2, 3);
+	}
+	SECTION("YUV888 to R8G8B8")
+	{
+		checkRowFunc(u_format_convert_row_yuv888_to_r8g8b8, 3, 3);
+	}
+	SECTION("YUYV422 to L8")
+	{
+		checkRowFunc(u_format_convert_row_yuyv422_to_l8, 2, 1);
+	}
+	SECTION("L8 to R8G8B8")
+	{
+		checkRowFunc(u_format_convert_row_l8_to_r8g8b8, 1, 3);
+	}
+}
@@ -0,0 +1,79 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Frame arena tests.
+ */
+
+#include <util/u_frame_arena.h>
+
+#include "catch/catch.hpp"
+
+#include <cstdint>
+
+
+TEST_CASE("u_frame_arena")
+{
+	struct u_frame_arena arena;
+	u_frame_arena_init(&arena, 64);
+
+	SECTION("Allocations are zeroed, aligned and don't overlap")
+	{
+		uint8_t *a = (uint8_t *)u_frame_arena_alloc(&arena, 3, 1);
+		uint32_t *b = U_FRAME_ARENA_ALLOC_ARRAY(&arena, uint32_t, 4);
+		REQUIRE(a != nullptr);
+		REQUIRE(b != nullptr);
+
+		CHECK(((uintptr_t)b % U_FRAME_ARENA_DEFAULT_ALIGNMENT) == 0);
+		CHECK((uint8_t *)b >= a + 3);
+
+		for (int i = 0; i < 4; i++) {
+			CHECK(b[i] == 0);
+		}
+
+		a[0] = a[1] = a[2] = 0xff;
+		CHECK(b[0] == 0);
+	}
+
+	SECTION("Frames that don't fit chain blocks, the next frame gets one block")
+	{
+		void *ptrs[16];
+		for (int i = 0; i < 16; i++) {
+			ptrs[i] = u_frame_arena_alloc(&arena, 48, 16);
+			REQUIRE(ptrs[i] != nullptr);
+			*(uint64_t *)ptrs[i] = i;
+		}
+
+		// All still valid after more blocks were added.
+		for (int i = 0; i < 16; i++) {
+			CHECK(*(uint64_t *)ptrs[i] == (uint64_t)i);
+		}
+
+		u_frame_arena_reset(&arena);
+		CHECK(arena.block_size >= 16 * 48);
+
+		// The same frame again fits in one block, so is contiguous.
+		uint8_t *first = (uint8_t *)u_frame_arena_alloc(&arena, 48, 16);
+		for (int i = 1; i < 16; i++) {
+			uint8_t *ptr = (uint8_t *)u_frame_arena_alloc(&arena, 48, 16);
+			CHECK(ptr == first + i * 48);
+		}
+	}
+
+	SECTION("Reset reuses the memory")
+	{
+		void *first = u_frame_arena_alloc(&arena, 32, 8);
+		u_frame_arena_reset(&arena);
+		CHECK(u_frame_arena_alloc(&arena, 32, 8) == first);
+	}
+
+	SECTION("Allocations bigger than a block")
+	{
+		uint8_t *big = (uint8_t *)u_frame_arena_alloc(&arena, 1000, 16);
+		REQUIRE(big != nullptr);
+		big[999] = 1;
+		CHECK(u_frame_arena_alloc(&arena, 8, 8) != nullptr);
+	}
+
+	u_frame_arena_fini(&arena);
+}
@@ -0,0 +1,170 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Hand joint history tests.
+ */
+
+#include <math/m_hand_joint_history.h>
+#include <math/m_api.h>
+#include <util/u_time.h>
+
+#include "catch/catch.hpp"
+
+#include <atomic>
+#include <thread>
+
+
+static xrt_hand_joint_set
+make_set(float x)
+{
+	xrt_hand_joint_set set = {};
+	set.is_active = true;
+	set.hand_pose.pose.orientation.w = 1.f;
+	set.hand_pose.relation_flags = (xrt_space_relation_flags)(XRT_SPACE_RELATION_POSITION_VALID_BIT |
+	                                                          XRT_SPACE_RELATION_ORIENTATION_VALID_BIT);
+
+	for (int j = 0; j < XRT_HAND_JOINT_COUNT; j++) {
+		xrt_hand_joint_value &v = set.values.hand_joint_set_default[j];
+		v.relation.pose.position = {x, (float)j * 0.01f, 0.f};
+		v.relation.pose.orientation.w = 1.f;
+		v.relation.relation_flags = (xrt_space_relation_flags)(
+		    XRT_SPACE_RELATION_POSITION_VALID_BIT | XRT_SPACE_RELATION_ORIENTATION_VALID_BIT |
+		    XRT_SPACE_RELATION_POSITION_TRACKED_BIT | XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT |
+		    XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT);
+		v.radius = 0.01f;
+	}
+	return set;
+}
+
+TEST_CASE("m_hand_joint_history")
+{
+	m_hand_joint_history *hjh = nullptr;
+	m_hand_joint_history_create(&hjh, 8);
+
+	constexpr auto T0 = 20 * (uint64_t)U_TIME_1S_IN_NS;
+	constexpr auto T1 = T0 + (uint64_t)U_TIME_1S_IN_NS;
+	constexpr auto T2 = T1 + (uint64_t)U_TIME_1S_IN_NS;
+
+	xrt_hand_joint_set out = {};
+
+	SECTION("empty history")
+	{
+		CHECK(m_hand_joint_history_get(hjh, 0, &out) == M_RELATION_HISTORY_RESULT_INVALID);
+		CHECK(m_hand_joint_history_get(hjh, T0, &out) == M_RELATION_HISTORY_RESULT_INVALID);
+		CHECK_FALSE(out.is_active);
+		uint64_t ts = 0;
+		CHECK_FALSE(m_hand_joint_history_get_latest(hjh, &ts, &out));
+	}
+
+	SECTION("populated history")
+	{
+		xrt_hand_joint_set a = make_set(0.f);
+		xrt_hand_joint_set b = make_set(1.f);
+		CHECK(m_hand_joint_history_push(hjh, &a, T0));
+		CHECK(m_hand_joint_history_push(hjh, &b, T1));
+
+		// Not newer than the newest, ignored.
+		CHECK_FALSE(m_hand_joint_history_push(hjh, &a, T1));
+
+		CHECK(m_hand_joint_history_get(hjh, T0, &out) == M_RELATION_HISTORY_RESULT_EXACT);
+		CHECK(out.is_active);
+		CHECK(out.values.hand_joint_set_default[3].relation.pose.position.x == 0.f);
+
+		// Velocity flags are not kept.
+		CHECK((out.values.hand_joint_set_default[3].relation.relation_flags &
+		       XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT) == 0);
+
+		CHECK(m_hand_joint_history_get(hjh, T0 - U_TIME_1MS_IN_NS, &out) ==
+		      M_RELATION_HISTORY_RESULT_REVERSE_PREDICTED);
+		CHECK(out.values.hand_joint_set_default[3].relation.pose.position.x == 0.f);
+
+		CHECK(m_hand_joint_history_get(hjh, (T0 + T1) / 2, &out) == M_RELATION_HISTORY_RESULT_INTERPOLATED);
+		for (int j = 0; j < XRT_HAND_JOINT_COUNT; j++) {
+			const xrt_hand_joint_value &v = out.values.hand_joint_set_default[j];
+			CHECK(v.relation.pose.position.x == Approx(0.5f));
+			CHECK(v.relation.pose.position.y == Approx((float)j * 0.01f));
+			CHECK(v.radius == Approx(0.01f));
+		}
+
+		// The whole hand keeps moving with the wrist.
+		CHECK(m_hand_joint_history_get(hjh, T2, &out) == M_RELATION_HISTORY_RESULT_PREDICTED);
+		for (int j = 0; j < XRT_HAND_JOINT_COUNT; j++) {
+			const xrt_hand_joint_value &v = out.values.hand_joint_set_default[j];
+			CHECK(v.relation.pose.position.x == Approx(2.f));
+			CHECK(v.relation.pose.position.y == Approx((float)j * 0.01f).margin(0.0001));
+		}
+
+		uint64_t ts = 0;
+		CHECK(m_hand_joint_history_get_latest(hjh, &ts, &out));
+		CHECK(ts == T1);
+		CHECK(out.values.hand_joint_set_default[0].relation.pose.position.x == 1.f);
+	}
+
+	SECTION("lost hand clears the history")
+	{
+		xrt_hand_joint_set a = make_set(0.f);
+		xrt_hand_joint_set lost = {};
+		CHECK(m_hand_joint_history_push(hjh, &a, T0));
+		CHECK_FALSE(m_hand_joint_history_push(hjh, &lost, T1));
+		CHECK(m_hand_joint_history_get(hjh, T1, &out) == M_RELATION_HISTORY_RESULT_INVALID);
+	}
+
+	SECTION("oldest sets are dropped")
+	{
+		for (uint64_t i = 0; i < 10; i++) {
+			xrt_hand_joint_set s = make_set((float)i);
+			CHECK(m_hand_joint_history_push(hjh, &s, T0 + i * U_TIME_1MS_IN_NS));
+		}
+
+		CHECK(m_hand_joint_history_get(hjh, T0, &out) == M_RELATION_HISTORY_RESULT_REVERSE_PREDICTED);
+		CHECK(out.values.hand_joint_set_default[0].relation.pose.position.x == 2.f);
+	}
+
+	m_hand_joint_history_destroy(&hjh);
+	CHECK(hjh == nullptr);
+}
+
+TEST_CASE("m_hand_joint_history concurrent readers")
+{
+	m_hand_joint_history *hjh = nullptr;
+	m_hand_joint_history_create(&hjh, 4);
+
+	constexpr auto T0 = 20 * (uint64_t)U_TIME_1S_IN_NS;
+	constexpr uint64_t kSets = 20000;
+
+	std::atomic<bool> done{false};
+	std::thread writer([&] {
+		for (uint64_t i = 1; i <= kSets; i++) {
+			xrt_hand_joint_set s = make_set((float)i);
+			m_hand_joint_history_push(hjh, &s, T0 + i * U_TIME_1MS_IN_NS);
+		}
+		done = true;
+	});
+
+	// Every joint of a set has the same x, a torn read would mix sets.
+	uint64_t torn = 0;
+	while (!done) {
+		xrt_hand_joint_set out = {};
+		uint64_t ts = 0;
+		if (!m_hand_joint_history_get_latest(hjh, &ts, &out)) {
+			continue;
+		}
+
+		float x = out.values.hand_joint_set_default[0].relation.pose.position.x;
+		for (int j = 1; j < XRT_HAND_JOINT_COUNT; j++) {
+			if (out.values.hand_joint_set_default[j].relation.pose.position.x != x) {
+				torn++;
+				break;
+			}
+		}
+		if (ts != T0 + (uint64_t)x * U_TIME_1MS_IN_NS) {
+			torn++;
+		}
+	}
+
+	writer.join();
+	CHECK(torn == 0);
+
+	m_hand_joint_history_destroy(&hjh);
+}
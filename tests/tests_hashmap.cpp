@@ -0,0 +1,127 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Hashmap and hashset tests.
+ */
+
+#include <util/u_hashmap.h>
+#include <util/u_hashset.h>
+
+#include "catch/catch.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+TEST_CASE("u_hashmap_int")
+{
+	struct u_hashmap_int *hmi = nullptr;
+	REQUIRE(u_hashmap_int_create(&hmi) == 0);
+	CHECK(u_hashmap_int_empty(hmi));
+
+	void *item = nullptr;
+	CHECK(u_hashmap_int_find(hmi, 42, &item) < 0);
+
+	SECTION("Matches std::unordered_map for random operations")
+	{
+		std::unordered_map<uint64_t, void *> reference;
+		std::mt19937_64 rng{1234};
+
+		for (int i = 0; i < 20000; i++) {
+			// Few keys, so there are lots of hits, collisions and erases.
+			uint64_t key = (rng() % 512) << 4;
+			void *value = (void *)(uintptr_t)rng();
+
+			switch (rng() % 3) {
+			case 0:
+				u_hashmap_int_insert(hmi, key, value);
+				reference[key] = value;
+				break;
+			case 1:
+				u_hashmap_int_erase(hmi, key);
+				reference.erase(key);
+				break;
+			default: break;
+			}
+
+			uint64_t probe = (rng() % 512) << 4;
+			auto search = reference.find(probe);
+			bool found = u_hashmap_int_find(hmi, probe, &item) == 0;
+			REQUIRE(found == (search != reference.end()));
+			if (found) {
+				REQUIRE(item == search->second);
+			}
+		}
+
+		CHECK(u_hashmap_int_empty(hmi) == reference.empty());
+	}
+
+	SECTION("Clearing calls for every item")
+	{
+		int values[100] = {};
+		for (int i = 0; i < 100; i++) {
+			u_hashmap_int_insert(hmi, (uint64_t)i, &values[i]);
+		}
+
+		u_hashmap_int_clear_and_call_for_each(
+		    hmi, [](void *ptr, void * /*priv*/) { (*(int *)ptr)++; }, nullptr);
+
+		for (int v : values) {
+			CHECK(v == 1);
+		}
+		CHECK(u_hashmap_int_empty(hmi));
+	}
+
+	u_hashmap_int_destroy(&hmi);
+	CHECK(hmi == nullptr);
+}
+
+TEST_CASE("u_hashset")
+{
+	struct u_hashset *hs = nullptr;
+	REQUIRE(u_hashset_create(&hs) == 0);
+
+	std::vector<struct u_hashset_item *> items;
+	for (int i = 0; i < 1000; i++) {
+		std::string str = "/user/hand/left/input/" + std::to_string(i);
+
+		struct u_hashset_item *item = nullptr;
+		REQUIRE(u_hashset_create_and_insert_str_c(hs, str.c_str(), &item) == 0);
+		items.push_back(item);
+	}
+
+	// Already in the set.
+	struct u_hashset_item *item = nullptr;
+	CHECK(u_hashset_create_and_insert_str_c(hs, "/user/hand/left/input/7", &item) < 0);
+
+	// Not null terminated lookups.
+	const char *str = "/user/hand/left/input/123/click";
+	REQUIRE(u_hashset_find_str(hs, str, strlen("/user/hand/left/input/123"), &item) == 0);
+	CHECK(item == items[123]);
+	CHECK(u_hashset_find_str(hs, str, strlen(str), &item) < 0);
+
+	for (int i = 0; i < 1000; i += 2) {
+		u_hashset_erase_item(hs, items[i]);
+	}
+
+	for (int i = 0; i < 1000; i++) {
+		bool found = u_hashset_find_c_str(hs, items[i]->c_str(), &item) == 0;
+		CHECK(found == (i % 2 == 1));
+	}
+
+	int count = 0;
+	u_hashset_clear_and_call_for_each(
+	    hs, [](struct u_hashset_item * /*item*/, void *priv) { (*(int *)priv)++; }, &count);
+	CHECK(count == 500);
+
+	u_hashset_destroy(&hs);
+
+	for (struct u_hashset_item *i : items) {
+		free(i);
+	}
+}
@@ -10,6 +10,10 @@
 #include <util/u_time.h>
 #include <util/u_template_historybuf.hpp>
 #include <iostream>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
 
 
 using xrt::auxiliary::util::HistoryBuffer;
@@ -115,6 +119,26 @@ TEST_CASE("m_relation_history")
 		CHECK(m_relation_history_get(rh, T2 + (uint64_t)U_TIME_1S_IN_NS, &out_relation) ==
 		      M_RELATION_HISTORY_RESULT_PREDICTED);
 		CHECK(out_relation.pose.position.x > 2.f);
+
+		// Batched lookups should match single lookups, sorted or not.
+		const uint64_t sorted[] = {
+		    T0 - (uint64_t)U_TIME_1S_IN_NS, T0, (T0 + T1) / 2, T1, (T1 + T2) / 2, T2, T2 + (uint64_t)U_TIME_1S_IN_NS,
+		};
+		const uint64_t unsorted[] = {T2, 0, (T0 + T1) / 2, T2 + (uint64_t)U_TIME_1S_IN_NS, T0, (T1 + T2) / 2};
+
+		for (const auto &timestamps : {std::vector<uint64_t>(std::begin(sorted), std::end(sorted)),
+		                               std::vector<uint64_t>(std::begin(unsorted), std::end(unsorted))}) {
+			std::vector<xrt_space_relation> many(timestamps.size());
+			std::vector<m_relation_history_result> results(timestamps.size());
+			m_relation_history_get_many(rh, timestamps.data(), (uint32_t)timestamps.size(), many.data(),
+			                            results.data());
+
+			for (size_t i = 0; i < timestamps.size(); i++) {
+				CAPTURE(i);
+				CHECK(m_relation_history_get(rh, timestamps[i], &out_relation) == results[i]);
+				CHECK(out_relation.pose.position.x == many[i].pose.position.x);
+			}
+		}
 	}
 
 
@@ -210,6 +234,96 @@ TEST_CASE("RelationHistory")
 	}
 }
 
+TEST_CASE("m_relation_history capacity")
+{
+	m_relation_history *rh = nullptr;
+	m_relation_history_create_with_capacity(&rh, 4);
+	CHECK(m_relation_history_get_capacity(rh) == 4);
+
+	constexpr auto T0 = 20 * (uint64_t)U_TIME_1S_IN_NS;
+	constexpr auto Step = (uint64_t)U_TIME_1MS_IN_NS;
+
+	xrt_space_relation relation = XRT_SPACE_RELATION_ZERO;
+	relation.relation_flags = XRT_SPACE_RELATION_POSITION_VALID_BIT;
+	for (int i = 0; i < 10; i++) {
+		relation.pose.position.x = (float)i;
+		CHECK(m_relation_history_push(rh, &relation, T0 + i * Step));
+		CHECK(m_relation_history_get_size(rh) == (uint32_t)std::min(i + 1, 4));
+	}
+
+	// Only the last four are left.
+	xrt_space_relation out_relation = XRT_SPACE_RELATION_ZERO;
+	CHECK(m_relation_history_get(rh, T0 + 5 * Step, &out_relation) == M_RELATION_HISTORY_RESULT_REVERSE_PREDICTED);
+	CHECK(m_relation_history_get(rh, T0 + 6 * Step, &out_relation) == M_RELATION_HISTORY_RESULT_EXACT);
+	CHECK(out_relation.pose.position.x == 6.f);
+	CHECK(m_relation_history_get(rh, T0 + 9 * Step, &out_relation) == M_RELATION_HISTORY_RESULT_EXACT);
+	CHECK(out_relation.pose.position.x == 9.f);
+	CHECK(m_relation_history_get(rh, T0 + 8 * Step + Step / 2, &out_relation) ==
+	      M_RELATION_HISTORY_RESULT_INTERPOLATED);
+	CHECK(out_relation.pose.position.x > 8.f);
+	CHECK(out_relation.pose.position.x < 9.f);
+
+	m_relation_history_clear(rh);
+	CHECK(m_relation_history_get_size(rh) == 0);
+	CHECK(m_relation_history_get_capacity(rh) == 4);
+
+	m_relation_history_destroy(&rh);
+}
+
+TEST_CASE("m_relation_history concurrent")
+{
+	m_relation_history *rh = nullptr;
+	m_relation_history_create(&rh);
+
+	constexpr auto T0 = 20 * (uint64_t)U_TIME_1S_IN_NS;
+	constexpr auto Step = (uint64_t)U_TIME_1MS_IN_NS;
+	// Enough pushes to wrap around the buffer a few times.
+	constexpr int Count = 20000;
+
+	std::atomic<bool> done{false};
+	std::atomic<int> bad_reads{0};
+	std::atomic<int> good_reads{0};
+
+	// Catch isn't thread safe, so the reader only counts and we check afterwards.
+	std::thread reader([&] {
+		while (!done.load()) {
+			uint64_t latest_ns = 0;
+			xrt_space_relation latest = XRT_SPACE_RELATION_ZERO;
+			if (!m_relation_history_get_latest(rh, &latest_ns, &latest)) {
+				continue;
+			}
+			if (latest.pose.position.x != (float)((latest_ns - T0) / Step)) {
+				bad_reads++;
+			}
+
+			xrt_space_relation out = XRT_SPACE_RELATION_ZERO;
+			auto result = m_relation_history_get(rh, latest_ns - Step / 2, &out);
+			if (result == M_RELATION_HISTORY_RESULT_INTERPOLATED) {
+				float expected = (float)((latest_ns - T0) / Step) - 0.5f;
+				if (out.pose.position.x < expected - 0.01f || out.pose.position.x > expected + 0.01f) {
+					bad_reads++;
+				}
+			}
+			good_reads++;
+		}
+	});
+
+	xrt_space_relation relation = XRT_SPACE_RELATION_ZERO;
+	relation.relation_flags = (xrt_space_relation_flags)(XRT_SPACE_RELATION_POSITION_VALID_BIT |
+	                                                     XRT_SPACE_RELATION_ORIENTATION_VALID_BIT);
+	for (int i = 0; i < Count; i++) {
+		relation.pose.position.x = (float)i;
+		m_relation_history_push(rh, &relation, T0 + i * Step);
+	}
+	done = true;
+	reader.join();
+
+	CHECK(bad_reads.load() == 0);
+	CHECK(m_relation_history_get_size(rh) > 0);
+
+	m_relation_history_destroy(&rh);
+}
+
 TEST_CASE("u_template_historybuf")
 {
 	HistoryBuffer<int, 4> buffer;
@@ -392,6 +506,24 @@ TEST_CASE("u_template_historybuf")
 
 		CHECK(++(buffer.begin()) == std::lower_bound(buffer.begin(), buffer.end(), 1));
 	}
+
+	SECTION("spans when wrapped around")
+	{
+		for (int i = 0; i < 6; i++) {
+			buffer.push_back(i);
+		}
+
+		const int *first = nullptr;
+		const int *second = nullptr;
+		size_t first_size = 0;
+		size_t second_size = 0;
+		buffer.get_spans(first, first_size, second, second_size);
+		REQUIRE(first_size + second_size == buffer.size());
+
+		std::vector<int> joined(first, first + first_size);
+		joined.insert(joined.end(), second, second + second_size);
+		CHECK(std::equal(joined.begin(), joined.end(), buffer.begin(), buffer.end()));
+	}
 }
 
 TEST_CASE("IteratorBase")
@@ -0,0 +1,70 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief m_imu_3dof batched update tests.
+ */
+
+#include <math/m_imu_3dof.h>
+
+#include "catch/catch.hpp"
+
+#include <cmath>
+#include <vector>
+
+
+static constexpr uint64_t kStepNs = 1000 * 1000; // 1kHz
+
+static void
+make_samples(uint32_t count, std::vector<uint64_t> &ts, std::vector<xrt_vec3> &accel, std::vector<xrt_vec3> &gyro)
+{
+	for (uint32_t i = 0; i < count; i++) {
+		float t = (float)i / 1000.0f;
+		ts.push_back(1000 + i * kStepNs);
+		accel.push_back({0.3f * std::sin(t), 9.81f, 0.2f * std::cos(t)});
+		gyro.push_back({0.5f * std::sin(3.0f * t), 1.0f, -0.25f * std::cos(2.0f * t)});
+	}
+}
+
+TEST_CASE("m_imu_3dof_update_batch")
+{
+	// Odd count so the last block is a partial one.
+	const uint32_t count = 1001;
+
+	std::vector<uint64_t> ts;
+	std::vector<xrt_vec3> accel;
+	std::vector<xrt_vec3> gyro;
+	make_samples(count, ts, accel, gyro);
+
+	m_imu_3dof single{};
+	m_imu_3dof batch{};
+	m_imu_3dof_init(&single, M_IMU_3DOF_USE_GRAVITY_DUR_20MS);
+	m_imu_3dof_init(&batch, M_IMU_3DOF_USE_GRAVITY_DUR_20MS);
+
+	for (uint32_t i = 0; i < count; i++) {
+		m_imu_3dof_update(&single, ts[i], &accel[i], &gyro[i]);
+	}
+
+	SECTION("one call")
+	{
+		m_imu_3dof_update_batch(&batch, ts.data(), accel.data(), gyro.data(), count);
+	}
+
+	SECTION("packets of three")
+	{
+		for (uint32_t i = 0; i < count; i += 3) {
+			uint32_t n = std::min(3u, count - i);
+			m_imu_3dof_update_batch(&batch, &ts[i], &accel[i], &gyro[i], n);
+		}
+	}
+
+	CHECK(batch.last.timestamp_ns == single.last.timestamp_ns);
+	CHECK(batch.rot.x == Approx(single.rot.x).margin(1e-4));
+	CHECK(batch.rot.y == Approx(single.rot.y).margin(1e-4));
+	CHECK(batch.rot.z == Approx(single.rot.z).margin(1e-4));
+	CHECK(batch.rot.w == Approx(single.rot.w).margin(1e-4));
+	CHECK(batch.last.gyro_biased_length == Approx(single.last.gyro_biased_length));
+
+	m_imu_3dof_close(&single);
+	m_imu_3dof_close(&batch);
+}
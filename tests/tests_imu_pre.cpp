@@ -0,0 +1,110 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief m_imu_pre batch conversion tests.
+ */
+
+#include <math/m_imu_pre.h>
+
+#include "catch/catch.hpp"
+
+#include <cstdint>
+#include <vector>
+
+
+static void
+make_filter(m_imu_pre_filter &imu)
+{
+	m_imu_pre_filter_init(&imu, 1.0f / 8192.0f, 1.0f / 1024.0f);
+	m_imu_pre_filter_set_switch_x_and_y(&imu);
+
+	imu.accel.bias = {0.01f, -0.02f, 0.03f};
+	imu.accel.gain = {1.01f, 0.99f, 1.02f};
+	imu.gyro.bias = {-0.005f, 0.004f, 0.001f};
+	imu.gyro.gain = {0.98f, 1.03f, 1.0f};
+}
+
+static void
+make_samples(uint32_t count, std::vector<xrt_vec3_i32> &accels, std::vector<xrt_vec3_i32> &gyros)
+{
+	for (uint32_t i = 0; i < count; i++) {
+		int32_t v = (int32_t)(i * 7919) % 65536 - 32768;
+		accels.push_back({v, -v / 2, (v * 3) % 32768});
+		// Keep everything in int16 range, -v - 1 because -INT16_MIN does not fit.
+		gyros.push_back({-v - 1, v / 3, 32767 - (int32_t)i});
+	}
+}
+
+static void
+check_close(const xrt_vec3 &a, const xrt_vec3 &b)
+{
+	CHECK(a.x == Approx(b.x).margin(1e-5));
+	CHECK(a.y == Approx(b.y).margin(1e-5));
+	CHECK(a.z == Approx(b.z).margin(1e-5));
+}
+
+TEST_CASE("m_imu_pre_filter_data_batch")
+{
+	// Not a multiple of the block size so the last block is a partial one.
+	const uint32_t count = 37;
+
+	m_imu_pre_filter imu{};
+	make_filter(imu);
+
+	std::vector<xrt_vec3_i32> accels;
+	std::vector<xrt_vec3_i32> gyros;
+	make_samples(count, accels, gyros);
+
+	std::vector<xrt_vec3> batch_accels(count);
+	std::vector<xrt_vec3> batch_gyros(count);
+	m_imu_pre_filter_data_batch(&imu, accels.data(), gyros.data(), count, batch_accels.data(),
+	                            batch_gyros.data());
+
+	for (uint32_t i = 0; i < count; i++) {
+		xrt_vec3 accel;
+		xrt_vec3 gyro;
+		m_imu_pre_filter_data(&imu, &accels[i], &gyros[i], &accel, &gyro);
+
+		check_close(batch_accels[i], accel);
+		check_close(batch_gyros[i], gyro);
+	}
+}
+
+TEST_CASE("m_imu_pre_filter_data_le16")
+{
+	const uint32_t count = 5;
+	// Odd stride so samples are not aligned, like in a packed packet.
+	const size_t stride = 13;
+
+	m_imu_pre_filter imu{};
+	make_filter(imu);
+
+	std::vector<xrt_vec3_i32> accels;
+	std::vector<xrt_vec3_i32> gyros;
+	make_samples(count, accels, gyros);
+
+	std::vector<uint8_t> packet(1 + count * stride);
+	for (uint32_t i = 0; i < count; i++) {
+		int32_t values[6] = {accels[i].x, accels[i].y, accels[i].z, gyros[i].x, gyros[i].y, gyros[i].z};
+		uint8_t *sample = &packet[1 + i * stride];
+		for (int k = 0; k < 6; k++) {
+			uint16_t raw = (uint16_t)(int16_t)values[k];
+			sample[k * 2 + 0] = (uint8_t)(raw & 0xff);
+			sample[k * 2 + 1] = (uint8_t)(raw >> 8);
+		}
+	}
+
+	std::vector<xrt_vec3> out_accels(count);
+	std::vector<xrt_vec3> out_gyros(count);
+	m_imu_pre_filter_data_le16(&imu, &packet[1], stride, count, out_accels.data(), out_gyros.data());
+
+	for (uint32_t i = 0; i < count; i++) {
+		xrt_vec3 accel;
+		xrt_vec3 gyro;
+		m_imu_pre_filter_data(&imu, &accels[i], &gyros[i], &accel, &gyro);
+
+		check_close(out_accels[i], accel);
+		check_close(out_gyros[i], gyro);
+	}
+}
@@ -0,0 +1,82 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief u_imu_ring tests.
+ */
+
+#include <util/u_imu_ring.h>
+
+#include "catch/catch.hpp"
+
+
+static xrt_imu_sample
+make_sample(int64_t ts)
+{
+	xrt_imu_sample s{};
+	s.timestamp_ns = ts;
+	s.accel_m_s2.x = (double)ts;
+	return s;
+}
+
+TEST_CASE("u_imu_ring")
+{
+	u_imu_ring ring{};
+	u_imu_ring_init(&ring, 3); // Rounded up to 4
+	REQUIRE(ring.mask == 3);
+
+	xrt_imu_sample out[8]{};
+
+	SECTION("empty")
+	{
+		CHECK(u_imu_ring_drain(&ring, out, 8) == 0);
+	}
+
+	SECTION("drains in push order and in batches")
+	{
+		for (int64_t i = 0; i < 3; i++) {
+			xrt_imu_sample s = make_sample(i);
+			u_imu_ring_push(&ring, &s);
+		}
+
+		REQUIRE(u_imu_ring_drain(&ring, out, 2) == 2);
+		CHECK(out[0].timestamp_ns == 0);
+		CHECK(out[1].timestamp_ns == 1);
+
+		REQUIRE(u_imu_ring_drain(&ring, out, 8) == 1);
+		CHECK(out[0].timestamp_ns == 2);
+		CHECK(out[0].accel_m_s2.x == 2.0);
+
+		CHECK(u_imu_ring_drain(&ring, out, 8) == 0);
+	}
+
+	SECTION("overwrites the oldest samples when full")
+	{
+		for (int64_t i = 0; i < 10; i++) {
+			xrt_imu_sample s = make_sample(i);
+			u_imu_ring_push(&ring, &s);
+		}
+
+		REQUIRE(u_imu_ring_drain(&ring, out, 8) == 4);
+		for (int64_t i = 0; i < 4; i++) {
+			CHECK(out[i].timestamp_ns == 6 + i);
+		}
+		CHECK(ring.dropped == 6);
+	}
+
+	SECTION("positions wrap around")
+	{
+		ring.head = INT32_MAX - 1;
+		ring.reserve = INT32_MAX - 1;
+		ring.tail = INT32_MAX - 1;
+		for (int64_t i = 0; i < 3; i++) {
+			xrt_imu_sample s = make_sample(i);
+			u_imu_ring_push(&ring, &s);
+		}
+
+		REQUIRE(u_imu_ring_drain(&ring, out, 8) == 3);
+		CHECK(out[2].timestamp_ns == 2);
+	}
+
+	u_imu_ring_fini(&ring);
+}
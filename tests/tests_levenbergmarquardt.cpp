@@ -84,3 +84,63 @@ TEST_CASE("LevenbergMarquardt")
 	CHECK(std::isfinite(out_reprojection_error));
 	CHECK(std::isfinite(out_hand_size));
 }
+
+TEST_CASE("LevenbergMarquardtReusesSolvers")
+{
+	// Runs one optimizer over frames with changing residual layouts, each layout gets its own solver that is
+	// reused on the next frame with that layout.
+	struct one_frame_input input = {};
+
+	for (int view = 0; view < 2; view++) {
+		input.views[view].stereographic_radius = 0.5;
+		input.views[view].look_dir = XRT_QUAT_IDENTITY;
+		for (int i = 0; i < 5; i++) {
+			input.views[view].curls[i].value = -0.5f;
+			input.views[view].curls[i].variance = 1.0f;
+		}
+		for (int i = 0; i < 21; i++) {
+			xrt_vec2 dir = {sinf(i), cosf(i)};
+			m_vec2_normalize(&dir);
+
+			input.views[view].keypoints_in_scaled_stereographic[i].pos_2d = dir;
+			input.views[view].keypoints_in_scaled_stereographic[i].depth_relative_to_midpxm =
+			    (i / 21.0f) - 0.5;
+			input.views[view].keypoints_in_scaled_stereographic[i].confidence_depth = 1.0f;
+			input.views[view].keypoints_in_scaled_stereographic[i].confidence_xy = 1.0f;
+		}
+	}
+
+	lm::KinematicHandLM *hand;
+
+	xrt_pose left_in_right = XRT_POSE_IDENTITY;
+	left_in_right.position.x = 1;
+
+	lm::optimizer_create(left_in_right, false, U_LOGGING_WARN, &hand);
+
+	for (int frame = 0; frame < 8; frame++) {
+		// The optimizer mutates the observation, give it a fresh copy.
+		struct one_frame_input frame_input = input;
+		frame_input.views[0].active = true;
+		frame_input.views[1].active = (frame % 3) != 1;
+
+		xrt_hand_joint_set out = {};
+		float out_hand_size = 0.0f;
+		float out_reprojection_error = 0.0f;
+		lm::optimizer_run(hand,                   //
+		                  frame_input,            //
+		                  frame == 0,             //
+		                  2.0f,                   //
+		                  (frame % 2) == 0,       //
+		                  0.09,                   //
+		                  0.5,                    //
+		                  0.5f,                   //
+		                  out,                    //
+		                  out_hand_size,          //
+		                  out_reprojection_error);
+
+		CHECK(std::isfinite(out_reprojection_error));
+		CHECK(std::isfinite(out_hand_size));
+	}
+
+	lm::optimizer_destroy(&hand);
+}
@@ -0,0 +1,87 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Path store tests.
+ */
+
+#include "catch/catch.hpp"
+
+#include <xrt/xrt_defines.h>
+
+#include <oxr/oxr_objects.h>
+#include <oxr/oxr_logger.h>
+
+#include <memory>
+#include <string>
+#include <cstring>
+
+
+TEST_CASE("oxr_path")
+{
+	struct oxr_logger log;
+	oxr_log_init(&log, "test");
+
+	// Value initialised, so zeroed.
+	std::unique_ptr<oxr_instance> inst{new oxr_instance()};
+	REQUIRE(oxr_path_init(&log, inst.get()) == XR_SUCCESS);
+
+	SECTION("Get or create is stable")
+	{
+		XrPath a = XR_NULL_PATH;
+		XrPath b = XR_NULL_PATH;
+		XrPath c = XR_NULL_PATH;
+
+		CHECK(oxr_path_get_or_create(&log, inst.get(), "/user/hand/left", 15, &a) == XR_SUCCESS);
+		CHECK(oxr_path_get_or_create(&log, inst.get(), "/user/hand/right", 16, &b) == XR_SUCCESS);
+		CHECK(oxr_path_get_or_create(&log, inst.get(), "/user/hand/left", 15, &c) == XR_SUCCESS);
+
+		CHECK(a != XR_NULL_PATH);
+		CHECK(b != XR_NULL_PATH);
+		CHECK(a != b);
+		CHECK(a == c);
+
+		const char *str = nullptr;
+		size_t length = 0;
+		CHECK(oxr_path_get_string(&log, inst.get(), b, &str, &length) == XR_SUCCESS);
+		CHECK(length == 16);
+		CHECK(std::strcmp(str, "/user/hand/right") == 0);
+	}
+
+	SECTION("Only get does not create")
+	{
+		XrPath path = 1;
+		CHECK(oxr_path_only_get(&log, inst.get(), "/user/head", 10, &path) == XR_SUCCESS);
+		CHECK(path == XR_NULL_PATH);
+		CHECK_FALSE(oxr_path_is_valid(&log, inst.get(), 1));
+		CHECK_FALSE(oxr_path_is_valid(&log, inst.get(), XR_NULL_PATH));
+	}
+
+	SECTION("Many paths survive growing")
+	{
+		// More then the initial table size to force rehashing.
+		constexpr int count = 10000;
+		std::unique_ptr<XrPath[]> paths{new XrPath[count]};
+
+		for (int i = 0; i < count; i++) {
+			std::string str = "/interaction_profiles/test/path_" + std::to_string(i);
+			REQUIRE(oxr_path_get_or_create(&log, inst.get(), str.c_str(), str.size(), &paths[i]) ==
+			        XR_SUCCESS);
+		}
+
+		for (int i = 0; i < count; i++) {
+			std::string str = "/interaction_profiles/test/path_" + std::to_string(i);
+
+			XrPath path = XR_NULL_PATH;
+			CHECK(oxr_path_only_get(&log, inst.get(), str.c_str(), str.size(), &path) == XR_SUCCESS);
+			CHECK(path == paths[i]);
+
+			const char *out_str = nullptr;
+			size_t length = 0;
+			CHECK(oxr_path_get_string(&log, inst.get(), path, &out_str, &length) == XR_SUCCESS);
+			CHECK(std::string(out_str, length) == str);
+		}
+	}
+
+	oxr_path_destroy(&log, inst.get());
+}
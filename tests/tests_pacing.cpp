@@ -322,6 +322,34 @@ TEST_CASE("u_pacing_compositor_display_timing")
 		      unanoseconds(longBeginDelay + longSubmitDelay + longGpuTime));
 	}
 
+	SECTION("bursty gpu")
+	{
+		// Every eighth frame takes three times as long on the GPU.
+		for (int i = 0; i < 100; ++i) {
+			CompositorPredictions loopPred;
+			u_pc_predict(upc, clock.now(), &loopPred.frame_id, &loopPred.wake_up_time_ns,
+			             &loopPred.desired_present_time_ns, &loopPred.present_slop_ns,
+			             &loopPred.predicted_display_time_ns, &loopPred.predicted_display_period_ns,
+			             &loopPred.min_display_period_ns);
+			INFO(loopPred.frame_id);
+			INFO(clock.now());
+			basicPredictionConsistencyChecks(clock.now(), loopPred);
+			auto gpuTime = (i % 8) == 7 ? shortGpuTime * 3 : shortGpuTime;
+			doFrame(queue, upc, clock, loopPred.wake_up_time_ns, loopPred.desired_present_time_ns,
+			        loopPred.frame_id, wakeDelay, shortBeginDelay, shortSubmitDelay, gpuTime);
+		}
+
+		// The budget should cover the bursts, not just the common case.
+		CompositorPredictions newPred;
+		u_pc_predict(upc, clock.now(), &newPred.frame_id, &newPred.wake_up_time_ns,
+		             &newPred.desired_present_time_ns, &newPred.present_slop_ns,
+		             &newPred.predicted_display_time_ns, &newPred.predicted_display_period_ns,
+		             &newPred.min_display_period_ns);
+		basicPredictionConsistencyChecks(clock.now(), newPred);
+		CHECK(unanoseconds(newPred.desired_present_time_ns - newPred.wake_up_time_ns) >
+		      unanoseconds(shortBeginDelay + shortSubmitDelay + shortGpuTime * 3));
+	}
+
 	u_pc_destroy(&upc);
 }
 
@@ -386,3 +414,174 @@ TEST_CASE("u_pacing_compositor_fake")
 	}
 	u_pc_destroy(&upc);
 }
+
+static uint32_t
+drainFrameRecords()
+{
+	uint32_t next = 0;
+	u_pc_frame_record records[16];
+	while (u_pc_frame_records_read(&next, records, ARRAY_SIZE(records)) > 0) {
+	}
+	return next;
+}
+
+TEST_CASE("u_pacing_compositor_frame_records")
+{
+	// The ring is process wide, start after anything other tests pushed.
+	uint32_t next = drainFrameRecords();
+	u_pc_frame_record records[U_PC_FRAME_RECORD_COUNT];
+
+	SECTION("In order")
+	{
+		for (int64_t i = 0; i < 10; i++) {
+			u_pc_frame_record record = {};
+			record.frame_id = i;
+			u_pc_frame_records_push(&record);
+		}
+
+		CHECK(u_pc_frame_records_read(&next, records, 4) == 4);
+		CHECK(records[0].frame_id == 0);
+		CHECK(records[3].frame_id == 3);
+
+		CHECK(u_pc_frame_records_read(&next, records, ARRAY_SIZE(records)) == 6);
+		CHECK(records[0].frame_id == 4);
+		CHECK(records[5].frame_id == 9);
+
+		CHECK(u_pc_frame_records_read(&next, records, ARRAY_SIZE(records)) == 0);
+	}
+
+	SECTION("Fallen behind")
+	{
+		for (int64_t i = 0; i < U_PC_FRAME_RECORD_COUNT + 10; i++) {
+			u_pc_frame_record record = {};
+			record.frame_id = i;
+			u_pc_frame_records_push(&record);
+		}
+
+		// The oldest records are lost, continues from the oldest available.
+		CHECK(u_pc_frame_records_read(&next, records, ARRAY_SIZE(records)) == U_PC_FRAME_RECORD_COUNT);
+		CHECK(records[0].frame_id == 10);
+		CHECK(records[U_PC_FRAME_RECORD_COUNT - 1].frame_id == U_PC_FRAME_RECORD_COUNT + 9);
+	}
+
+	SECTION("Fake pacer")
+	{
+		MockClock clock;
+		u_pacing_compositor *upc = nullptr;
+		REQUIRE(XRT_SUCCESS == u_pc_fake_create(frame_interval_ns.count(), clock.now(), &upc));
+
+		CompositorPredictions predictions;
+		u_pc_predict(upc, clock.now(), &predictions.frame_id, &predictions.wake_up_time_ns,
+		             &predictions.desired_present_time_ns, &predictions.present_slop_ns,
+		             &predictions.predicted_display_time_ns, &predictions.predicted_display_period_ns,
+		             &predictions.min_display_period_ns);
+
+		clock.advance_to(predictions.wake_up_time_ns);
+		u_pc_mark_point(upc, U_TIMING_POINT_WAKE_UP, predictions.frame_id, clock.now());
+		uint64_t begin_ns = clock.now();
+		u_pc_mark_point(upc, U_TIMING_POINT_BEGIN, predictions.frame_id, begin_ns);
+		clock.advance(shortSubmitDelay);
+		uint64_t submit_ns = clock.now();
+		u_pc_mark_point(upc, U_TIMING_POINT_SUBMIT, predictions.frame_id, submit_ns);
+		clock.advance(shortGpuTime);
+		u_pc_info_gpu(upc, predictions.frame_id, submit_ns, clock.now(), clock.now());
+
+		REQUIRE(u_pc_frame_records_read(&next, records, ARRAY_SIZE(records)) == 1);
+		CHECK(records[0].frame_id == predictions.frame_id);
+		CHECK(records[0].cpu_begin_ns == begin_ns);
+		CHECK(records[0].cpu_end_ns == submit_ns);
+		CHECK(records[0].gpu_end_ns == clock.now());
+		CHECK((records[0].flags & U_PC_FRAME_RECORD_GPU_BIT) != 0);
+		CHECK((records[0].flags & U_PC_FRAME_RECORD_MISSED_BIT) == 0);
+
+		u_pc_destroy(&upc);
+	}
+}
+
+TEST_CASE("u_pacing_app_arbitration")
+{
+	MockClock clock;
+	u_pacing_app_factory *upaf = nullptr;
+	REQUIRE(XRT_SUCCESS == u_pa_factory_create(&upaf));
+
+	u_pacing_app *upa = nullptr;
+	u_paf_create(upaf, &upa);
+	REQUIRE(upa != nullptr);
+
+	uint64_t display_time_ns = clock.now() + frame_interval_ns.count() * 2;
+	uint64_t extra_ns = unanoseconds(5ms).count();
+	u_pa_info(upa, display_time_ns, frame_interval_ns.count(), extra_ns);
+
+	int64_t frame_id = -1;
+	uint64_t wake_up_time_ns = 0;
+	uint64_t predicted_display_time_ns = 0;
+	uint64_t predicted_display_period_ns = 0;
+
+	SECTION("Half rate")
+	{
+		u_pa_set_rate_divisor(upa, 2);
+		u_pa_predict(upa, clock.now(), &frame_id, &wake_up_time_ns, &predicted_display_time_ns,
+		             &predicted_display_period_ns);
+		CHECK(predicted_display_period_ns == frame_interval_ns.count() * 2);
+
+		uint64_t first_display_time_ns = predicted_display_time_ns;
+		u_pa_predict(upa, clock.now(), &frame_id, &wake_up_time_ns, &predicted_display_time_ns,
+		             &predicted_display_period_ns);
+		CHECK(predicted_display_time_ns - first_display_time_ns == frame_interval_ns.count() * 2);
+
+		// Back to full rate.
+		u_pa_set_rate_divisor(upa, 1);
+		u_pa_predict(upa, clock.now(), &frame_id, &wake_up_time_ns, &predicted_display_time_ns,
+		             &predicted_display_period_ns);
+		CHECK(predicted_display_period_ns == frame_interval_ns.count());
+	}
+
+	SECTION("Staggered")
+	{
+		u_pacing_app *other = nullptr;
+		u_paf_create(upaf, &other);
+		REQUIRE(other != nullptr);
+
+		// The other app goes before this one and has to wake up earlier.
+		uint64_t offset_ns = unanoseconds(4ms).count();
+		u_pa_info(other, display_time_ns, frame_interval_ns.count(), extra_ns + offset_ns);
+
+		u_pa_predict(upa, clock.now(), &frame_id, &wake_up_time_ns, &predicted_display_time_ns,
+		             &predicted_display_period_ns);
+
+		int64_t other_frame_id = -1;
+		uint64_t other_wake_up_time_ns = 0;
+		uint64_t other_predicted_display_time_ns = 0;
+		u_pa_predict(other, clock.now(), &other_frame_id, &other_wake_up_time_ns,
+		             &other_predicted_display_time_ns, &predicted_display_period_ns);
+
+		CHECK(other_predicted_display_time_ns == predicted_display_time_ns);
+		CHECK(wake_up_time_ns - other_wake_up_time_ns == offset_ns);
+
+		u_pa_destroy(&other);
+	}
+
+	SECTION("GPU time")
+	{
+		uint64_t gpu_time_ns = 1;
+		u_pa_get_gpu_time(upa, &gpu_time_ns);
+		CHECK(gpu_time_ns == 0);
+
+		u_pa_predict(upa, clock.now(), &frame_id, &wake_up_time_ns, &predicted_display_time_ns,
+		             &predicted_display_period_ns);
+		clock.advance_to(wake_up_time_ns);
+		u_pa_mark_point(upa, frame_id, U_TIMING_POINT_WAKE_UP, clock.now());
+		u_pa_mark_point(upa, frame_id, U_TIMING_POINT_BEGIN, clock.now());
+		clock.advance(1ms);
+		u_pa_mark_delivered(upa, frame_id, clock.now(), predicted_display_time_ns);
+		clock.advance(3ms);
+		u_pa_mark_gpu_done(upa, frame_id, clock.now());
+
+		u_pa_get_gpu_time(upa, &gpu_time_ns);
+		CHECK(gpu_time_ns > 0);
+		CHECK(gpu_time_ns <= (uint64_t)unanoseconds(3ms).count());
+	}
+
+	u_pa_destroy(&upa);
+	u_paf_destroy(&upaf);
+}
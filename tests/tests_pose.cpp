@@ -66,3 +66,64 @@ TEST_CASE("Pose interpolation works")
 	CHECK(res.orientation.y == Approx(0).margin(e));
 	CHECK(res.orientation.w == Approx(1).margin(e));
 }
+
+TEST_CASE("Batched pose transforms match single transforms")
+{
+	struct xrt_pose transform = {};
+	transform.position = {0.5f, -1.f, 2.f};
+	transform.orientation = {-0.439f, -0.561f, 0.072f, -0.698f};
+	math_quat_normalize(&transform.orientation);
+
+	// Not a multiple of the chunk size, to exercise the tail.
+	constexpr uint32_t count = 37;
+	struct xrt_pose poses[count];
+	struct xrt_vec3 points[count];
+	for (uint32_t i = 0; i < count; i++) {
+		float f = (float)i;
+		poses[i].position = {f, f * 0.5f, -f};
+		poses[i].orientation = {f, 1.f, -2.f, 3.f + f};
+		math_quat_normalize(&poses[i].orientation);
+		points[i] = {-f, 2.f * f, 1.f};
+	}
+
+	struct xrt_pose out_poses[count];
+	struct xrt_vec3 out_points[count];
+	struct xrt_vec3 out_rotated[count];
+	math_pose_transform_many(&transform, poses, out_poses, count);
+	math_pose_transform_point_many(&transform, points, out_points, count);
+	math_quat_rotate_vec3_many(&transform.orientation, points, out_rotated, count);
+
+	constexpr float e = 0.0001f;
+	for (uint32_t i = 0; i < count; i++) {
+		CAPTURE(i);
+		struct xrt_pose expected_pose;
+		math_pose_transform(&transform, &poses[i], &expected_pose);
+		CHECK(out_poses[i].position.x == Approx(expected_pose.position.x).margin(e));
+		CHECK(out_poses[i].position.y == Approx(expected_pose.position.y).margin(e));
+		CHECK(out_poses[i].position.z == Approx(expected_pose.position.z).margin(e));
+		CHECK(out_poses[i].orientation.x == Approx(expected_pose.orientation.x).margin(e));
+		CHECK(out_poses[i].orientation.y == Approx(expected_pose.orientation.y).margin(e));
+		CHECK(out_poses[i].orientation.z == Approx(expected_pose.orientation.z).margin(e));
+		CHECK(out_poses[i].orientation.w == Approx(expected_pose.orientation.w).margin(e));
+
+		struct xrt_vec3 expected_point;
+		math_pose_transform_point(&transform, &points[i], &expected_point);
+		CHECK(out_points[i].x == Approx(expected_point.x).margin(e));
+		CHECK(out_points[i].y == Approx(expected_point.y).margin(e));
+		CHECK(out_points[i].z == Approx(expected_point.z).margin(e));
+
+		struct xrt_vec3 expected_rotated;
+		math_quat_rotate_vec3(&transform.orientation, &points[i], &expected_rotated);
+		CHECK(out_rotated[i].x == Approx(expected_rotated.x).margin(e));
+		CHECK(out_rotated[i].y == Approx(expected_rotated.y).margin(e));
+		CHECK(out_rotated[i].z == Approx(expected_rotated.z).margin(e));
+	}
+
+	// In place is allowed.
+	math_pose_transform_many(&transform, poses, poses, count);
+	for (uint32_t i = 0; i < count; i++) {
+		CAPTURE(i);
+		CHECK(poses[i].position.x == Approx(out_poses[i].position.x).margin(e));
+		CHECK(poses[i].orientation.w == Approx(out_poses[i].orientation.w).margin(e));
+	}
+}
@@ -0,0 +1,180 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Variable tracking tests.
+ */
+
+#include <util/u_var.h>
+
+#include "catch/catch.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <string>
+
+
+namespace {
+
+struct Visited
+{
+	std::vector<std::string> roots;
+	std::vector<std::string> vars;
+};
+
+void
+on_enter(struct u_var_root_info *info, void *priv)
+{
+	static_cast<Visited *>(priv)->roots.push_back(info->name);
+}
+
+void
+on_exit(struct u_var_root_info *info, void *priv)
+{
+	(void)info;
+	(void)priv;
+}
+
+void
+on_elem(struct u_var_info *info, void *priv)
+{
+	static_cast<Visited *>(priv)->vars.push_back(info->name);
+}
+
+void
+on_elem_check(struct u_var_info *info, void *priv)
+{
+	(void)priv;
+	// The owner zeroes the value before freeing it, after the root is removed.
+	if (*static_cast<volatile int32_t *>(info->ptr) != 42) {
+		FAIL("Visited a variable of a removed root");
+	}
+}
+
+void
+on_nothing(struct u_var_root_info *info, void *priv)
+{
+	(void)info;
+	(void)priv;
+}
+
+} // namespace
+
+TEST_CASE("u_var_registry")
+{
+	u_var_force_on();
+
+	int32_t a = 0;
+	int32_t b = 0;
+
+	u_var_add_root(&a, "Root A", false);
+	u_var_add_i32(&a, &a, "a");
+	u_var_add_root(&b, "Root B", false);
+	u_var_add_i32(&b, &b, "b");
+
+	// Not added to any root.
+	static int32_t not_a_root = 0;
+	u_var_add_i32(&not_a_root, &b, "orphan");
+
+	{
+		Visited visited;
+		u_var_visit(on_enter, on_exit, on_elem, &visited);
+		CHECK(visited.roots == std::vector<std::string>{"Root A", "Root B"});
+		CHECK(visited.vars == std::vector<std::string>{"a", "b"});
+	}
+
+	u_var_remove_root(&a);
+
+	{
+		Visited visited;
+		u_var_visit(on_enter, on_exit, on_elem, &visited);
+		CHECK(visited.roots == std::vector<std::string>{"Root B"});
+		CHECK(visited.vars == std::vector<std::string>{"b"});
+	}
+
+	u_var_remove_root(&b);
+}
+
+TEST_CASE("u_var_remove_while_visiting")
+{
+	u_var_force_on();
+
+	std::atomic<bool> stop{false};
+	std::thread gui([&] {
+		while (!stop) {
+			u_var_visit(on_nothing, on_nothing, on_elem_check, nullptr);
+		}
+	});
+
+	for (int i = 0; i < 1000; i++) {
+		auto *values = new int32_t[4]{42, 42, 42, 42};
+
+		u_var_add_root(values, "Object", true);
+		for (int k = 0; k < 4; k++) {
+			u_var_add_ro_i32(values, &values[k], "value");
+		}
+
+		u_var_remove_root(values);
+		for (int k = 0; k < 4; k++) {
+			values[k] = 0;
+		}
+		delete[] values;
+	}
+
+	stop = true;
+	gui.join();
+}
+
+TEST_CASE("u_var_f32_block")
+{
+	float buffers[2][8] = {};
+	struct u_var_f32_block block = {};
+	block.buffers[0] = buffers[0];
+	block.buffers[1] = buffers[1];
+	block.count = 8;
+
+	float out[16] = {};
+
+	SECTION("Reads the last published values")
+	{
+		float *back = u_var_f32_block_back(&block);
+		for (int i = 0; i < 8; i++) {
+			back[i] = (float)i;
+		}
+
+		// Not published yet.
+		CHECK(u_var_f32_block_read(&block, out, 16) == 8);
+		CHECK(out[7] == 0.0f);
+
+		u_var_f32_block_publish(&block);
+		CHECK(u_var_f32_block_read(&block, out, 4) == 4);
+		CHECK(out[3] == 3.0f);
+	}
+
+	SECTION("Never reads a half written block")
+	{
+		std::atomic<bool> done{false};
+		std::thread writer([&] {
+			for (int i = 1; i < 100000; i++) {
+				float *back = u_var_f32_block_back(&block);
+				for (int k = 0; k < 8; k++) {
+					back[k] = (float)i;
+				}
+				u_var_f32_block_publish(&block);
+			}
+			done = true;
+		});
+
+		int torn = 0;
+		while (!done) {
+			u_var_f32_block_read(&block, out, 8);
+			if (out[0] != out[7]) {
+				torn++;
+			}
+		}
+		writer.join();
+
+		CHECK(torn == 0);
+	}
+}
@@ -35,4 +35,35 @@ TEST_CASE("u_vector")
 		u_vector_float_destroy(&vf);
 		CHECK(vf.ptr == NULL);
 	}
+
+	SECTION("Bulk operations and clearing")
+	{
+		struct u_vector_int vi = u_vector_int_create();
+
+		int in[100];
+		for (int i = 0; i < 100; i++) {
+			in[i] = i;
+		}
+
+		u_vector_int_push_back_n(vi, in, 10);
+		u_vector_int_push_back_n(vi, in, 100);
+		CHECK(u_vector_int_size(vi) == 110);
+		CHECK(u_vector_int_at(vi, 9) == 9);
+		CHECK(u_vector_int_at(vi, 10) == 0);
+		CHECK(u_vector_int_data(vi)[109] == 99);
+
+		int e = 0;
+		CHECK(u_vector_int_pop_back(vi, &e));
+		CHECK(e == 99);
+
+		// Keeps the storage.
+		int *data = u_vector_int_data(vi);
+		u_vector_int_clear(vi);
+		CHECK(u_vector_int_size(vi) == 0);
+		CHECK(!u_vector_int_pop_back(vi, &e));
+		u_vector_int_push_back_n(vi, in, 100);
+		CHECK(u_vector_int_data(vi) == data);
+
+		u_vector_int_destroy(&vi);
+	}
 }
@@ -10,6 +10,7 @@
 
 #include "catch/catch.hpp"
 
+#include <atomic>
 #include <thread>
 #include <chrono>
 
@@ -130,3 +131,40 @@ TEST_CASE("TaskCollection")
 		CHECK(calledA[2]);
 	}
 }
+
+TEST_CASE("ParallelFor")
+{
+	SharedThreadPool pool{2, 3, "Test"};
+	SharedThreadGroup group{pool};
+
+	std::vector<int> hits(1000, 0);
+
+	SECTION("Every index once")
+	{
+		uint32_t grain = GENERATE(0u, 1u, 7u, 1000u, 5000u);
+
+		// Catch isn't thread safe, only check from the test thread.
+		std::atomic<bool> bad_range{false};
+		group.parallelFor(static_cast<uint32_t>(hits.size()), grain, [&](uint32_t begin, uint32_t end) {
+			if (begin >= end || end > hits.size()) {
+				bad_range = true;
+				return;
+			}
+			for (uint32_t i = begin; i < end; i++) {
+				hits[i]++;
+			}
+		});
+
+		CHECK(!bad_range);
+		for (int hit : hits) {
+			CHECK(hit == 1);
+		}
+	}
+
+	SECTION("Empty range")
+	{
+		bool called = false;
+		group.parallelFor(0, 4, [&](uint32_t, uint32_t) { called = true; });
+		CHECK(!called);
+	}
+}